@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <sstream>
+
+#include "jni.h"
+
+#include "base/time_utils.h"
+#include "gc/collector/garbage_collector.h"
+#include "gc/heap.h"
+#include "runtime.h"
+
+namespace art {
+namespace {
+
+extern "C" JNIEXPORT void JNICALL Java_GcWorkloadsBenchmark_resetGcStatistics(JNIEnv*, jclass) {
+  Runtime::Current()->GetHeap()->ResetGcPerformanceInfo();
+}
+
+// Returns a line per collector that ran since the last reset: its iterations, total and paused
+// times, pause percentiles and throughput.
+extern "C" JNIEXPORT jstring JNICALL Java_GcWorkloadsBenchmark_getGcStatistics(JNIEnv* env,
+                                                                               jclass) {
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  std::ostringstream os;
+  os << "collector=" << heap->CurrentCollectorType() << "\n";
+  for (gc::collector::GarbageCollector* collector : heap->GetGarbageCollectors()) {
+    const size_t iterations = collector->NumberOfIterations();
+    if (iterations == 0) {
+      continue;
+    }
+    const uint64_t total_ns = collector->GetCumulativeTimings().GetTotalNs();
+    os << collector->GetName()
+       << " iterations=" << iterations
+       << " total_ms=" << NsToMs(total_ns)
+       << " paused_ms=" << NsToMs(collector->GetTotalPausedTimeNs())
+       << " p50_us=" << collector->GetPausePercentileNs(0.5) / 1000
+       << " p90_us=" << collector->GetPausePercentileNs(0.9) / 1000
+       << " p99_us=" << collector->GetPausePercentileNs(0.99) / 1000
+       << " max_us=" << collector->GetMaxPauseNs() / 1000
+       << " freed_bytes=" << collector->GetTotalFreedBytes()
+       << " throughput_bytes_per_s=" << collector->GetEstimatedMeanThroughput()
+       << "\n";
+  }
+  return env->NewStringUTF(os.str().c_str());
+}
+
+}  // namespace
+}  // namespace art
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+import java.io.BufferedReader;
+import java.io.FileReader;
+import java.io.IOException;
+import java.lang.ref.WeakReference;
+import java.util.ArrayList;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * Allocation workloads stressing different parts of the garbage collectors. Run it with each
+ * -Xgc: collector to compare; main() prints the pauses and throughput of each workload.
+ */
+public class GcWorkloadsBenchmark {
+  private static final int CACHE_SIZE = 64 * 1024;
+  private static final int LARGE_ARRAY_SIZE = 256 * 1024;
+  private static final int NUM_THREADS = 8;
+
+  static class Node {
+    Node next;
+    int value;
+    Node(Node next, int value) {
+      this.next = next;
+      this.value = value;
+    }
+  }
+
+  // The cache keeps its entries for a while, they survive the young collections.
+  static class Cache extends LinkedHashMap<Integer, Object> {
+    Cache() {
+      super(CACHE_SIZE, 0.75f, true);
+    }
+
+    @Override
+    protected boolean removeEldestEntry(Map.Entry<Integer, Object> eldest) {
+      return size() > CACHE_SIZE;
+    }
+  }
+
+  private final Cache cache = new Cache();
+  private int result;
+
+  static native void resetGcStatistics();
+  static native String getGcStatistics();
+
+  public GcWorkloadsBenchmark() {
+    System.loadLibrary("artbenchmark");
+  }
+
+  // Objects dying right after their allocation.
+  public void timeYoungDie(int count) {
+    int sum = 0;
+    for (int i = 0; i < count; i++) {
+      Node list = null;
+      for (int j = 0; j < 100; j++) {
+        list = new Node(list, j);
+      }
+      sum += list.value;
+    }
+    result = sum;
+  }
+
+  // Objects living as long as they stay in the cache.
+  public void timeMediumLivedCache(int count) {
+    Cache c = cache;
+    for (int i = 0; i < count; i++) {
+      c.put(i, new int[16]);
+      // Some entries are used again and live longer.
+      c.get(i / 2);
+    }
+    result = c.size();
+  }
+
+  // Arrays going to the large object space.
+  public void timeLargeArrays(int count) {
+    int sum = 0;
+    for (int i = 0; i < count; i++) {
+      int[] array = new int[LARGE_ARRAY_SIZE];
+      array[i % LARGE_ARRAY_SIZE] = i;
+      sum += array.length;
+    }
+    result = sum;
+  }
+
+  // Weak references to objects dying at different ages, for the reference processing.
+  public void timeWeakReferences(int count) {
+    List<WeakReference<Object>> references = new ArrayList<WeakReference<Object>>();
+    Object[] strong = new Object[1024];
+    for (int i = 0; i < count; i++) {
+      Object obj = new Object();
+      strong[i % strong.length] = obj;
+      references.add(new WeakReference<Object>(obj));
+      if (references.size() == 16 * 1024) {
+        references.clear();
+      }
+    }
+    result = references.size();
+  }
+
+  // Threads allocating short-lived objects together, each in its own allocation buffer.
+  public void timeManyThreads(final int count) throws InterruptedException {
+    Thread[] threads = new Thread[NUM_THREADS];
+    for (int t = 0; t < NUM_THREADS; t++) {
+      threads[t] = new Thread() {
+        @Override
+        public void run() {
+          Node list = null;
+          for (int i = 0; i < count / NUM_THREADS; i++) {
+            list = new Node((i % 1000) == 0 ? null : list, i);
+          }
+        }
+      };
+      threads[t].start();
+    }
+    for (Thread thread : threads) {
+      thread.join();
+    }
+  }
+
+  private static long getRssKb() throws IOException {
+    try (BufferedReader reader = new BufferedReader(new FileReader("/proc/self/status"))) {
+      String line;
+      while ((line = reader.readLine()) != null) {
+        if (line.startsWith("VmRSS:")) {
+          return Long.parseLong(line.substring("VmRSS:".length()).trim().split("\\s+")[0]);
+        }
+      }
+    }
+    return -1;
+  }
+
+  private static void report(String workload, long startNs) throws IOException {
+    long elapsedMs = (System.nanoTime() - startNs) / 1000000;
+    System.out.println(workload + ": time_ms=" + elapsedMs + " rss_kb=" + getRssKb());
+    System.out.print(getGcStatistics());
+  }
+
+  public static void main(String[] args) throws Exception {
+    GcWorkloadsBenchmark benchmark = new GcWorkloadsBenchmark();
+    final int count = (args.length > 0) ? Integer.parseInt(args[0]) : 1000000;
+
+    resetGcStatistics();
+    long start = System.nanoTime();
+    benchmark.timeYoungDie(count);
+    report("YoungDie", start);
+
+    resetGcStatistics();
+    start = System.nanoTime();
+    benchmark.timeMediumLivedCache(count);
+    report("MediumLivedCache", start);
+
+    resetGcStatistics();
+    start = System.nanoTime();
+    benchmark.timeLargeArrays(count / 1000);
+    report("LargeArrays", start);
+
+    resetGcStatistics();
+    start = System.nanoTime();
+    benchmark.timeWeakReferences(count);
+    report("WeakReferences", start);
+
+    resetGcStatistics();
+    start = System.nanoTime();
+    benchmark.timeManyThreads(count * 10);
+    report("ManyThreads", start);
+  }
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+
+#include "jni.h"
+
+#include "art_method-inl.h"
+#include "base/time_utils.h"
+#include "jni_internal.h"
+#include "modifiers.h"
+
+namespace art {
+
+namespace {
+
+// How long to wait for the automatic fast JNI detection of a method.
+static constexpr uint64_t kDetectionTimeoutNs = MsToNs(100);
+static constexpr useconds_t kDetectionPollIntervalUs = 50;
+
+// The arguments of the methods, of mixed types.
+#define JNI_PARAMS_0
+#define JNI_PARAMS_1 , jint i0
+#define JNI_PARAMS_2 , jint i0, jlong j0
+#define JNI_PARAMS_4 , jint i0, jlong j0, jfloat f0, jdouble d0
+#define JNI_PARAMS_8 , jint i0, jlong j0, jfloat f0, jdouble d0, \
+                       jint i1, jlong j1, jfloat f1, jdouble d1
+
+#define CRITICAL_PARAMS_0
+#define CRITICAL_PARAMS_1 jint i0
+#define CRITICAL_PARAMS_2 jint i0, jlong j0
+#define CRITICAL_PARAMS_4 jint i0, jlong j0, jfloat f0, jdouble d0
+#define CRITICAL_PARAMS_8 jint i0, jlong j0, jfloat f0, jdouble d0, \
+                          jint i1, jlong j1, jfloat f1, jdouble d1
+
+// The body shared by all the variants of a method.
+#define BODY_0 0
+#define BODY_1 i0
+#define BODY_2 i0 + j0
+#define BODY_4 i0 + j0 + static_cast<jlong>(f0) + static_cast<jlong>(d0)
+#define BODY_8 BODY_4 + i1 + j1 + static_cast<jlong>(f1) + static_cast<jlong>(d1)
+
+#define DEFINE_JNI_TRANSITION_METHODS(n)                                                   \
+  extern "C" JNIEXPORT jlong JNICALL Java_JniTransitionBenchmark_regular##n(               \
+      JNIEnv*, jclass JNI_PARAMS_##n) {                                                    \
+    return BODY_##n;                                                                       \
+  }                                                                                        \
+  extern "C" JNIEXPORT jlong JNICALL Java_JniTransitionBenchmark_fast##n(                  \
+      JNIEnv*, jclass JNI_PARAMS_##n) {                                                    \
+    return BODY_##n;                                                                       \
+  }                                                                                        \
+  extern "C" JNIEXPORT jlong JNICALL Java_JniTransitionBenchmark_critical##n(              \
+      CRITICAL_PARAMS_##n) {                                                               \
+    return BODY_##n;                                                                       \
+  }                                                                                        \
+  extern "C" JNIEXPORT jlong JNICALL Java_JniTransitionBenchmark_autofast##n(              \
+      JNIEnv*, jclass JNI_PARAMS_##n) {                                                    \
+    return BODY_##n;                                                                       \
+  }
+
+DEFINE_JNI_TRANSITION_METHODS(0)
+DEFINE_JNI_TRANSITION_METHODS(1)
+DEFINE_JNI_TRANSITION_METHODS(2)
+DEFINE_JNI_TRANSITION_METHODS(4)
+DEFINE_JNI_TRANSITION_METHODS(8)
+
+#undef DEFINE_JNI_TRANSITION_METHODS
+
+extern "C" JNIEXPORT jlong JNICALL Java_JniTransitionBenchmark_timeToFastTarget(
+    JNIEnv*, jclass JNI_PARAMS_4) {
+  return BODY_4;
+}
+
+// Wait for the automatic fast JNI detection to find a method fast.
+static bool WaitForFastNative(ArtMethod* method) {
+  uint64_t deadline = NanoTime() + kDetectionTimeoutNs;
+  while (!method->IsFastNative()) {
+    if (NanoTime() > deadline) {
+      return false;
+    }
+    usleep(kDetectionPollIntervalUs);
+  }
+  return true;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_JniTransitionBenchmark_useRegularTransitions(
+    JNIEnv* env, jclass klass, jstring name, jstring signature) {
+  const char* name_chars = env->GetStringUTFChars(name, nullptr);
+  const char* signature_chars = env->GetStringUTFChars(signature, nullptr);
+  jmethodID method_id = env->GetStaticMethodID(klass, name_chars, signature_chars);
+  env->ReleaseStringUTFChars(signature, signature_chars);
+  env->ReleaseStringUTFChars(name, name_chars);
+  if (method_id == nullptr) {
+    return;
+  }
+  // Let a pending detection finish first, so that it does not set the flag afterwards.
+  ArtMethod* method = jni::DecodeArtMethod(method_id);
+  WaitForFastNative(method);
+  method->ClearAccessFlags(kAccFastNative);
+}
+
+extern "C" JNIEXPORT jint JNICALL Java_JniTransitionBenchmark_registerAndWaitForFast(
+    JNIEnv* env, jclass klass, jint reps) {
+  static const JNINativeMethod kTarget = {
+      "timeToFastTarget",
+      "(IJFD)J",
+      reinterpret_cast<void*>(Java_JniTransitionBenchmark_timeToFastTarget) };
+  jmethodID method_id = env->GetStaticMethodID(klass, kTarget.name, kTarget.signature);
+  if (method_id == nullptr) {
+    return 0;
+  }
+  ArtMethod* method = jni::DecodeArtMethod(method_id);
+  jint fast_count = 0;
+  for (jint i = 0; i < reps; ++i) {
+    method->ClearAccessFlags(kAccFastNative);
+    if (env->RegisterNatives(klass, &kTarget, 1) != JNI_OK) {
+      return fast_count;
+    }
+    if (WaitForFastNative(method)) {
+      ++fast_count;
+    }
+  }
+  return fast_count;
+}
+
+}  // namespace
+
+}  // namespace art
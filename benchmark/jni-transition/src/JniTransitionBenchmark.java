@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import dalvik.annotation.optimization.CriticalNative;
+import dalvik.annotation.optimization.FastNative;
+
+/**
+ * The same native body is called through the regular JNI transitions, @FastNative,
+ * @CriticalNative and the automatic fast JNI detection. The regular methods are kept
+ * on the regular transitions even when the detection finds them fast.
+ */
+public class JniTransitionBenchmark {
+  static native long regular0();
+  static native long regular1(int i0);
+  static native long regular2(int i0, long j0);
+  static native long regular4(int i0, long j0, float f0, double d0);
+  static native long regular8(int i0, long j0, float f0, double d0,
+                              int i1, long j1, float f1, double d1);
+
+  @FastNative static native long fast0();
+  @FastNative static native long fast1(int i0);
+  @FastNative static native long fast2(int i0, long j0);
+  @FastNative static native long fast4(int i0, long j0, float f0, double d0);
+  @FastNative static native long fast8(int i0, long j0, float f0, double d0,
+                                       int i1, long j1, float f1, double d1);
+
+  @CriticalNative static native long critical0();
+  @CriticalNative static native long critical1(int i0);
+  @CriticalNative static native long critical2(int i0, long j0);
+  @CriticalNative static native long critical4(int i0, long j0, float f0, double d0);
+  @CriticalNative static native long critical8(int i0, long j0, float f0, double d0,
+                                               int i1, long j1, float f1, double d1);
+
+  static native long autofast0();
+  static native long autofast1(int i0);
+  static native long autofast2(int i0, long j0);
+  static native long autofast4(int i0, long j0, float f0, double d0);
+  static native long autofast8(int i0, long j0, float f0, double d0,
+                               int i1, long j1, float f1, double d1);
+
+  static native long timeToFastTarget(int i0, long j0, float f0, double d0);
+
+  // Make a method use the regular JNI transitions, once its detection is done.
+  static native void useRegularTransitions(String name, String signature);
+
+  // Register timeToFastTarget() `reps` times, each time waiting for it to be found fast.
+  // Return how many times it was found fast.
+  static native int registerAndWaitForFast(int reps);
+
+  public void timeRegular0(int N) {
+    for (int i = 0; i < N; i++) {
+      regular0();
+    }
+  }
+
+  public void timeRegular1(int N) {
+    for (int i = 0; i < N; i++) {
+      regular1(i);
+    }
+  }
+
+  public void timeRegular2(int N) {
+    for (int i = 0; i < N; i++) {
+      regular2(i, i);
+    }
+  }
+
+  public void timeRegular4(int N) {
+    for (int i = 0; i < N; i++) {
+      regular4(i, i, 1.0f, 2.0);
+    }
+  }
+
+  public void timeRegular8(int N) {
+    for (int i = 0; i < N; i++) {
+      regular8(i, i, 1.0f, 2.0, i, i, 3.0f, 4.0);
+    }
+  }
+
+  public void timeFast0(int N) {
+    for (int i = 0; i < N; i++) {
+      fast0();
+    }
+  }
+
+  public void timeFast1(int N) {
+    for (int i = 0; i < N; i++) {
+      fast1(i);
+    }
+  }
+
+  public void timeFast2(int N) {
+    for (int i = 0; i < N; i++) {
+      fast2(i, i);
+    }
+  }
+
+  public void timeFast4(int N) {
+    for (int i = 0; i < N; i++) {
+      fast4(i, i, 1.0f, 2.0);
+    }
+  }
+
+  public void timeFast8(int N) {
+    for (int i = 0; i < N; i++) {
+      fast8(i, i, 1.0f, 2.0, i, i, 3.0f, 4.0);
+    }
+  }
+
+  public void timeCritical0(int N) {
+    for (int i = 0; i < N; i++) {
+      critical0();
+    }
+  }
+
+  public void timeCritical1(int N) {
+    for (int i = 0; i < N; i++) {
+      critical1(i);
+    }
+  }
+
+  public void timeCritical2(int N) {
+    for (int i = 0; i < N; i++) {
+      critical2(i, i);
+    }
+  }
+
+  public void timeCritical4(int N) {
+    for (int i = 0; i < N; i++) {
+      critical4(i, i, 1.0f, 2.0);
+    }
+  }
+
+  public void timeCritical8(int N) {
+    for (int i = 0; i < N; i++) {
+      critical8(i, i, 1.0f, 2.0, i, i, 3.0f, 4.0);
+    }
+  }
+
+  public void timeAutofast0(int N) {
+    for (int i = 0; i < N; i++) {
+      autofast0();
+    }
+  }
+
+  public void timeAutofast1(int N) {
+    for (int i = 0; i < N; i++) {
+      autofast1(i);
+    }
+  }
+
+  public void timeAutofast2(int N) {
+    for (int i = 0; i < N; i++) {
+      autofast2(i, i);
+    }
+  }
+
+  public void timeAutofast4(int N) {
+    for (int i = 0; i < N; i++) {
+      autofast4(i, i, 1.0f, 2.0);
+    }
+  }
+
+  public void timeAutofast8(int N) {
+    for (int i = 0; i < N; i++) {
+      autofast8(i, i, 1.0f, 2.0, i, i, 3.0f, 4.0);
+    }
+  }
+
+  public void timeTimeToFast(int N) {
+    registerAndWaitForFast(N);
+  }
+
+  static {
+    System.loadLibrary("artbenchmark");
+    // Bind the methods, which starts their detection.
+    int i = 0;
+    regular0();
+    regular1(i);
+    regular2(i, i);
+    regular4(i, i, 1.0f, 2.0);
+    regular8(i, i, 1.0f, 2.0, i, i, 3.0f, 4.0);
+    autofast0();
+    autofast1(i);
+    autofast2(i, i);
+    autofast4(i, i, 1.0f, 2.0);
+    autofast8(i, i, 1.0f, 2.0, i, i, 3.0f, 4.0);
+    useRegularTransitions("regular0", "()J");
+    useRegularTransitions("regular1", "(I)J");
+    useRegularTransitions("regular2", "(IJ)J");
+    useRegularTransitions("regular4", "(IJFD)J");
+    useRegularTransitions("regular8", "(IJFDIJFD)J");
+  }
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Each timeXxx() method runs a loop the given pass transforms, in a $noinline$ method so that
+ * the loop is compiled the same whatever the caller. The results are accumulated in a field
+ * for the loops not to be removed as dead code.
+ */
+public class LoopOptsBenchmark {
+  // Larger than the last level caches, for the non-temporal moves to matter.
+  private static final int LARGE_SIZE = 4 * 1024 * 1024;
+  private static final int SMALL_SIZE = 1024;
+
+  static class Holder {
+    int sum;
+    int count;
+  }
+
+  private final int[] small = new int[SMALL_SIZE];
+  private final int[] largeSrc = new int[LARGE_SIZE];
+  private final int[] largeDst = new int[LARGE_SIZE];
+  private final Holder holder = new Holder();
+  private int result;
+
+  public LoopOptsBenchmark() {
+    for (int i = 0; i < SMALL_SIZE; i++) {
+      small[i] = i * 7 + 3;
+    }
+    for (int i = 0; i < LARGE_SIZE; i++) {
+      largeSrc[i] = i;
+    }
+  }
+
+  // loop_full_unrolling: a loop with a small constant trip count.
+  private static int $noinline$fullUnrolling(int[] a, int base) {
+    int sum = 0;
+    for (int i = 0; i < 4; i++) {
+      sum += a[base + i] * (i + 1);
+    }
+    return sum;
+  }
+
+  public void timeFullUnrolling(int count) {
+    int[] a = small;
+    int sum = 0;
+    for (int i = 0; i < count; i++) {
+      sum += $noinline$fullUnrolling(a, i & (SMALL_SIZE - 8));
+    }
+    result = sum;
+  }
+
+  // loop_partial_unrolling: a small body run many times.
+  private static int $noinline$partialUnrolling(int[] a) {
+    int sum = 0;
+    for (int i = 0; i < a.length; i++) {
+      sum += a[i] ^ i;
+    }
+    return sum;
+  }
+
+  public void timePartialUnrolling(int count) {
+    int[] a = small;
+    int sum = 0;
+    for (int i = 0; i < count; i++) {
+      sum += $noinline$partialUnrolling(a);
+    }
+    result = sum;
+  }
+
+  // loop_peeling: the field load and the null and bounds checks of the array are loop
+  // invariant, peeling the first iteration lets GVN remove them from the loop.
+  private static int $noinline$peeling(LoopOptsBenchmark b, int n) {
+    int sum = 0;
+    for (int i = 0; i < n; i++) {
+      sum += b.small[i & (SMALL_SIZE - 1)] + b.small.length;
+    }
+    return sum;
+  }
+
+  public void timePeeling(int count) {
+    int sum = 0;
+    for (int i = 0; i < count; i++) {
+      sum += $noinline$peeling(this, SMALL_SIZE);
+    }
+    result = sum;
+  }
+
+  // non_temporal_move: a large array copy whose destination is not read again soon.
+  private static void $noinline$nonTemporalMove(int[] src, int[] dst) {
+    for (int i = 0; i < dst.length; i++) {
+      dst[i] = src[i];
+    }
+  }
+
+  public void timeNonTemporalMove(int count) {
+    int[] src = largeSrc;
+    int[] dst = largeDst;
+    for (int i = 0; i < count; i++) {
+      $noinline$nonTemporalMove(src, dst);
+    }
+    result = dst[LARGE_SIZE - 1];
+  }
+
+  // constant_calculation_sinking: the loop only computes a value used after it.
+  private static int $noinline$constantCalculationSinking(int n) {
+    int x = 0;
+    for (int i = 0; i < n; i++) {
+      x += 5;
+    }
+    return x;
+  }
+
+  public void timeConstantCalculationSinking(int count) {
+    int sum = 0;
+    for (int i = 0; i < count; i++) {
+      sum += $noinline$constantCalculationSinking(SMALL_SIZE + (i & 1));
+    }
+    result = sum;
+  }
+
+  // loadhoist_storesink: the fields of an object are read and written on each iteration.
+  private static void $noinline$loadHoistStoreSink(Holder h, int[] a) {
+    for (int i = 0; i < a.length; i++) {
+      h.sum += a[i];
+      h.count++;
+    }
+  }
+
+  public void timeLoadHoistStoreSink(int count) {
+    Holder h = holder;
+    int[] a = small;
+    for (int i = 0; i < count; i++) {
+      $noinline$loadHoistStoreSink(h, a);
+    }
+    result = h.sum + h.count;
+  }
+
+  // trivial_loop_evaluator: a loop with constant bounds over constants only.
+  private static int $noinline$trivialLoopEvaluation() {
+    int x = 1;
+    for (int i = 0; i < 100; i++) {
+      x = x * 3 + i;
+    }
+    return x;
+  }
+
+  public void timeTrivialLoopEvaluation(int count) {
+    int sum = 0;
+    for (int i = 0; i < count; i++) {
+      sum += $noinline$trivialLoopEvaluation();
+    }
+    result = sum;
+  }
+
+  // remove_loop_suspend_checks: a short loop without calls, whose suspend check costs as
+  // much as its body.
+  private static int $noinline$removeSuspend(int[] a) {
+    int max = Integer.MIN_VALUE;
+    for (int i = 0; i < a.length; i++) {
+      if (a[i] > max) {
+        max = a[i];
+      }
+    }
+    return max;
+  }
+
+  public void timeRemoveSuspend(int count) {
+    int[] a = small;
+    int sum = 0;
+    for (int i = 0; i < count; i++) {
+      sum += $noinline$removeSuspend(a);
+    }
+    result = sum;
+  }
+}
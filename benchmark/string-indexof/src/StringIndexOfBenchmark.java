@@ -113,10 +113,68 @@ public class StringIndexOfBenchmark {
         }
     }
 
+    public void timeIndexOfString01(int count) {
+        final String sub = "01";
+        String s = string36;
+        for (int i = 0; i < count; ++i) {
+            $noinline$indexOf(s, sub);
+        }
+    }
+
+    public void timeIndexOfStringFG(int count) {
+        final String sub = "FG";
+        String s = string36;
+        for (int i = 0; i < count; ++i) {
+            $noinline$indexOf(s, sub);
+        }
+    }
+
+    public void timeIndexOfStringOPQRSTUV(int count) {
+        final String sub = "OPQRSTUV";
+        String s = string36;
+        for (int i = 0; i < count; ++i) {
+            $noinline$indexOf(s, sub);
+        }
+    }
+
+    public void timeIndexOfStringXYZ(int count) {
+        final String sub = "XYZ";
+        String s = string36;
+        for (int i = 0; i < count; ++i) {
+            $noinline$indexOf(s, sub);
+        }
+    }
+
+    public void timeIndexOfString__(int count) {
+        final String sub = "__";
+        String s = string36;
+        for (int i = 0; i < count; ++i) {
+            $noinline$indexOf(s, sub);
+        }
+    }
+
+    public void timeIndexOfStringAfter(int count) {
+        final String sub = "01";
+        String s = string36 + string36;
+        for (int i = 0; i < count; ++i) {
+            $noinline$indexOf(s, sub, 1);
+        }
+    }
+
     static int $noinline$indexOf(String s, char c) {
         if (doThrow) { throw new Error(); }
         return s.indexOf(c);
     }
 
+    static int $noinline$indexOf(String s, String sub) {
+        if (doThrow) { throw new Error(); }
+        return s.indexOf(sub);
+    }
+
+    static int $noinline$indexOf(String s, String sub, int fromIndex) {
+        if (doThrow) { throw new Error(); }
+        return s.indexOf(sub, fromIndex);
+    }
+
     public static boolean doThrow = false;
 }
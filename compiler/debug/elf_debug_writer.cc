@@ -94,19 +94,22 @@ std::vector<uint8_t> MakeMiniDebugInfo(
     const InstructionSetFeatures* features,
     size_t rodata_size,
     size_t text_size,
-    const ArrayRef<const MethodDebugInfo>& method_infos) {
+    const ArrayRef<const MethodDebugInfo>& method_infos,
+    size_t thread_count) {
   if (Is64BitInstructionSet(isa)) {
     return MakeMiniDebugInfoInternal<ElfTypes64>(isa,
                                                  features,
                                                  rodata_size,
                                                  text_size,
-                                                 method_infos);
+                                                 method_infos,
+                                                 thread_count);
   } else {
     return MakeMiniDebugInfoInternal<ElfTypes32>(isa,
                                                  features,
                                                  rodata_size,
                                                  text_size,
-                                                 method_infos);
+                                                 method_infos,
+                                                 thread_count);
   }
 }
 
@@ -45,7 +45,8 @@ std::vector<uint8_t> MakeMiniDebugInfo(
     const InstructionSetFeatures* features,
     size_t rodata_section_size,
     size_t text_section_size,
-    const ArrayRef<const MethodDebugInfo>& method_infos);
+    const ArrayRef<const MethodDebugInfo>& method_infos,
+    size_t thread_count);
 
 std::vector<uint8_t> WriteDebugElfFileForMethods(
     InstructionSet isa,
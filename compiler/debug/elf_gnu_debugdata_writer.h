@@ -17,37 +17,77 @@
 #ifndef ART_COMPILER_DEBUG_ELF_GNU_DEBUGDATA_WRITER_H_
 #define ART_COMPILER_DEBUG_ELF_GNU_DEBUGDATA_WRITER_H_
 
+#include <memory>
 #include <vector>
 
 #include "arch/instruction_set.h"
+#include "base/bit_utils.h"
 #include "elf_builder.h"
 #include "linker/vector_output_stream.h"
+#include "thread-current-inl.h"
+#include "thread_pool.h"
 
 // liblzma.
 #include "7zCrc.h"
-#include "XzCrc64.h"
-#include "XzEnc.h"
+#include "Lzma2Enc.h"
 
 namespace art {
 namespace debug {
 
-static void XzCompress(const std::vector<uint8_t>* src, std::vector<uint8_t>* dst) {
+// The mini-debug-info is compressed as an XZ stream of independent blocks of this size. The
+// blocks are compressed in parallel, and the debuggers can decompress them separately. The
+// block size, and so the output, does not depend on the number of threads. The blocks are much
+// larger than the dictionary of the fast compression level, so they cost little in size.
+static constexpr size_t kXzBlockSize = 1 * MB;
+
+// Constants of the .xz file format.
+static constexpr uint8_t kXzHeaderMagic[] = { 0xFD, '7', 'z', 'X', 'Z', 0x00 };
+static constexpr uint8_t kXzFooterMagic[] = { 'Y', 'Z' };
+static constexpr uint8_t kXzStreamFlags[] = { 0x00, 0x01 /* CRC32 check */ };
+static constexpr uint8_t kXzFilterLzma2 = 0x21;
+
+static void XzWriteVarInt(uint64_t value, std::vector<uint8_t>* dst) {
+  while (value >= 0x80u) {
+    dst->push_back(static_cast<uint8_t>(value) | 0x80u);
+    value >>= 7;
+  }
+  dst->push_back(static_cast<uint8_t>(value));
+}
+
+static void XzWriteUint32(uint32_t value, std::vector<uint8_t>* dst) {
+  for (size_t i = 0; i != sizeof(uint32_t); ++i) {
+    dst->push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+// Pad dst with zeros so that the bytes written since begin are a multiple of four.
+static void XzWritePadding(size_t begin, std::vector<uint8_t>* dst) {
+  while (!IsAligned<4u>(dst->size() - begin)) {
+    dst->push_back(0u);
+  }
+}
+
+// A block of the XZ stream: the range of the source it compresses, and its encoding.
+struct XzBlock {
+  const uint8_t* src;
+  size_t src_size;
+  std::vector<uint8_t> data;
+  // The size of the block without its padding, as recorded by the index.
+  size_t unpadded_size;
+};
+
+static void XzCompressBlock(XzBlock* block) {
   // Configure the compression library.
-  CrcGenerateTable();
-  Crc64GenerateTable();
   CLzma2EncProps lzma2Props;
   Lzma2EncProps_Init(&lzma2Props);
   lzma2Props.lzmaProps.level = 1;  // Fast compression.
   Lzma2EncProps_Normalize(&lzma2Props);
-  CXzProps props;
-  XzProps_Init(&props);
-  props.lzma2Props = &lzma2Props;
   // Implement the required interface for communication (written in C so no virtual methods).
   struct XzCallbacks : public ISeqInStream, public ISeqOutStream, public ICompressProgress {
     static SRes ReadImpl(void* p, void* buf, size_t* size) {
       auto* ctx = static_cast<XzCallbacks*>(reinterpret_cast<ISeqInStream*>(p));
-      *size = std::min(*size, ctx->src_->size() - ctx->src_pos_);
-      memcpy(buf, ctx->src_->data() + ctx->src_pos_, *size);
+      *size = std::min(*size, ctx->src_size_ - ctx->src_pos_);
+      memcpy(buf, ctx->src_ + ctx->src_pos_, *size);
       ctx->src_pos_ += *size;
       return SZ_OK;
     }
@@ -60,20 +100,119 @@ static void XzCompress(const std::vector<uint8_t>* src, std::vector<uint8_t>* ds
     static SRes ProgressImpl(void* , UInt64, UInt64) {
       return SZ_OK;
     }
+    static void* AllocImpl(void*, size_t size) {
+      return malloc(size);
+    }
+    static void FreeImpl(void*, void* address) {
+      free(address);
+    }
     size_t src_pos_;
-    const std::vector<uint8_t>* src_;
+    const uint8_t* src_;
+    size_t src_size_;
     std::vector<uint8_t>* dst_;
   };
+  ISzAlloc alloc = { XzCallbacks::AllocImpl, XzCallbacks::FreeImpl };
+  CLzma2EncHandle encoder = Lzma2Enc_Create(&alloc, &alloc);
+  CHECK(encoder != nullptr);
+  CHECK_EQ(Lzma2Enc_SetProps(encoder, &lzma2Props), SZ_OK);
+
+  // The block header: its size, flags for a single filter and no sizes, the LZMA2 filter with
+  // its dictionary size, padding and the CRC32 of the header.
+  std::vector<uint8_t>* dst = &block->data;
+  dst->push_back(0u);
+  dst->push_back(0u);
+  XzWriteVarInt(kXzFilterLzma2, dst);
+  XzWriteVarInt(1u, dst);
+  dst->push_back(Lzma2Enc_WriteProperties(encoder));
+  XzWritePadding(0u, dst);
+  (*dst)[0] = static_cast<uint8_t>((dst->size() + sizeof(uint32_t)) / 4u - 1u);
+  XzWriteUint32(CrcCalc(dst->data(), dst->size()), dst);
+
+  // The compressed data, padding and the CRC32 of the uncompressed data.
   XzCallbacks callbacks;
   callbacks.Read = XzCallbacks::ReadImpl;
   callbacks.Write = XzCallbacks::WriteImpl;
   callbacks.Progress = XzCallbacks::ProgressImpl;
   callbacks.src_pos_ = 0;
-  callbacks.src_ = src;
+  callbacks.src_ = block->src;
+  callbacks.src_size_ = block->src_size;
   callbacks.dst_ = dst;
-  // Compress.
-  SRes res = Xz_Encode(&callbacks, &callbacks, &props, &callbacks);
+  SRes res = Lzma2Enc_Encode(encoder, &callbacks, &callbacks, &callbacks);
   CHECK_EQ(res, SZ_OK);
+  Lzma2Enc_Destroy(encoder);
+  block->unpadded_size = dst->size() + sizeof(uint32_t);
+  XzWritePadding(0u, dst);
+  XzWriteUint32(CrcCalc(block->src, block->src_size), dst);
+}
+
+class XzCompressBlockTask : public Task {
+ public:
+  explicit XzCompressBlockTask(XzBlock* block) : block_(block) {}
+
+  void Run(Thread*) OVERRIDE {
+    XzCompressBlock(block_);
+  }
+
+ private:
+  XzBlock* const block_;
+};
+
+// Compress src into dst, on up to thread_count threads including the calling one.
+static void XzCompress(const std::vector<uint8_t>* src,
+                       std::vector<uint8_t>* dst,
+                       size_t thread_count) {
+  CrcGenerateTable();
+  std::vector<XzBlock> blocks(RoundUp(src->size(), kXzBlockSize) / kXzBlockSize);
+  for (size_t i = 0; i != blocks.size(); ++i) {
+    blocks[i].src = src->data() + i * kXzBlockSize;
+    blocks[i].src_size = std::min(kXzBlockSize, src->size() - i * kXzBlockSize);
+  }
+  size_t num_threads = std::min(thread_count, blocks.size());
+  if (num_threads > 1u) {
+    Thread* self = Thread::Current();
+    ThreadPool thread_pool("Mini-debug-info compressor", num_threads - 1u);
+    std::vector<std::unique_ptr<XzCompressBlockTask>> tasks;
+    for (XzBlock& block : blocks) {
+      tasks.emplace_back(new XzCompressBlockTask(&block));
+      thread_pool.AddTask(self, tasks.back().get());
+    }
+    thread_pool.StartWorkers(self);
+    thread_pool.Wait(self, /* do_work */ true, /* may_hold_locks */ false);
+  } else {
+    for (XzBlock& block : blocks) {
+      XzCompressBlock(&block);
+    }
+  }
+
+  // The stream header.
+  dst->insert(dst->end(), std::begin(kXzHeaderMagic), std::end(kXzHeaderMagic));
+  dst->insert(dst->end(), std::begin(kXzStreamFlags), std::end(kXzStreamFlags));
+  XzWriteUint32(CrcCalc(kXzStreamFlags, sizeof(kXzStreamFlags)), dst);
+
+  // The blocks, in order.
+  for (const XzBlock& block : blocks) {
+    dst->insert(dst->end(), block.data.begin(), block.data.end());
+  }
+
+  // The index, with the sizes of the blocks.
+  size_t index_begin = dst->size();
+  dst->push_back(0u);
+  XzWriteVarInt(blocks.size(), dst);
+  for (const XzBlock& block : blocks) {
+    XzWriteVarInt(block.unpadded_size, dst);
+    XzWriteVarInt(block.src_size, dst);
+  }
+  XzWritePadding(index_begin, dst);
+  XzWriteUint32(CrcCalc(dst->data() + index_begin, dst->size() - index_begin), dst);
+  size_t index_size = dst->size() - index_begin;
+
+  // The stream footer: its CRC32, the size of the index and the stream flags again.
+  std::vector<uint8_t> footer;
+  XzWriteUint32(static_cast<uint32_t>(index_size / 4u - 1u), &footer);
+  footer.insert(footer.end(), std::begin(kXzStreamFlags), std::end(kXzStreamFlags));
+  XzWriteUint32(CrcCalc(footer.data(), footer.size()), dst);
+  dst->insert(dst->end(), footer.begin(), footer.end());
+  dst->insert(dst->end(), std::begin(kXzFooterMagic), std::end(kXzFooterMagic));
 }
 
 template <typename ElfTypes>
@@ -82,7 +221,8 @@ static std::vector<uint8_t> MakeMiniDebugInfoInternal(
     const InstructionSetFeatures* features,
     size_t rodata_section_size,
     size_t text_section_size,
-    const ArrayRef<const MethodDebugInfo>& method_infos) {
+    const ArrayRef<const MethodDebugInfo>& method_infos,
+    size_t thread_count) {
   std::vector<uint8_t> buffer;
   buffer.reserve(KB);
   VectorOutputStream out("Mini-debug-info ELF file", &buffer);
@@ -101,7 +241,7 @@ static std::vector<uint8_t> MakeMiniDebugInfoInternal(
   CHECK(builder->Good());
   std::vector<uint8_t> compressed_buffer;
   compressed_buffer.reserve(buffer.size() / 4);
-  XzCompress(&buffer, &compressed_buffer);
+  XzCompress(&buffer, &compressed_buffer, thread_count);
   return compressed_buffer;
 }
 
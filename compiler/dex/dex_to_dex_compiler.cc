@@ -41,6 +41,8 @@ using android::base::StringPrintf;
 const bool kEnableQuickening = true;
 // Control check-cast elision.
 const bool kEnableCheckCastEllision = true;
+// Controls the fusion of instruction pairs into superinstructions.
+const bool kEnableSuperinstructions = true;
 
 struct QuickenedInfo {
   QuickenedInfo(uint32_t pc, uint16_t index) : dex_pc(pc), dex_member_index(index) {}
@@ -89,6 +91,12 @@ class DexCompiler {
   void CompileInstanceFieldAccess(Instruction* inst, uint32_t dex_pc,
                                   Instruction::Code new_opcode, bool is_put);
 
+  // Compiles an IGET-OBJECT-QUICK followed by an IF-EQZ or IF-NEZ on the loaded reference into
+  // an IGET-OBJECT-QUICK-IF-EQZ or IGET-OBJECT-QUICK-IF-NEZ, which the interpreter executes
+  // together with the branch in one dispatch. The branch is left in place, the fused opcode
+  // only tells the interpreter what follows.
+  void CompileNullCheckBranch(Instruction* inst, uint32_t dex_pc);
+
   // Compiles a virtual method invocation into a quick virtual method invocation.
   // The method index is replaced by the vtable index where the corresponding
   // Executable can be found. Therefore, this does not involve any resolution
@@ -139,6 +147,7 @@ void DexCompiler::Compile() {
 
       case Instruction::IGET_OBJECT:
         CompileInstanceFieldAccess(inst, dex_pc, Instruction::IGET_OBJECT_QUICK, false);
+        CompileNullCheckBranch(inst, dex_pc);
         break;
 
       case Instruction::IGET_BOOLEAN:
@@ -282,6 +291,38 @@ void DexCompiler::CompileInstanceFieldAccess(Instruction* inst,
   }
 }
 
+void DexCompiler::CompileNullCheckBranch(Instruction* inst, uint32_t dex_pc) {
+  if (!kEnableSuperinstructions || inst->Opcode() != Instruction::IGET_OBJECT_QUICK) {
+    return;
+  }
+  // Only the x86 and x86-64 interpreters have handlers for the fused opcodes, the others would
+  // go through the slower switch interpreter for them.
+  InstructionSet instruction_set = driver_.GetInstructionSet();
+  if (instruction_set != kX86 && instruction_set != kX86_64) {
+    return;
+  }
+  // A verified method cannot flow off its end, the field access is followed by an instruction.
+  const Instruction* next = inst->Next();
+  Instruction::Code new_opcode;
+  if (next->Opcode() == Instruction::IF_EQZ) {
+    new_opcode = Instruction::IGET_OBJECT_QUICK_IF_EQZ;
+  } else if (next->Opcode() == Instruction::IF_NEZ) {
+    new_opcode = Instruction::IGET_OBJECT_QUICK_IF_NEZ;
+  } else {
+    return;
+  }
+  if (next->VRegA_21t() != inst->VRegA_22c()) {
+    return;
+  }
+  VLOG(compiler) << "Fusing " << Instruction::Name(inst->Opcode())
+                 << " and " << Instruction::Name(next->Opcode())
+                 << " to " << Instruction::Name(new_opcode)
+                 << " at dex pc " << StringPrintf("0x%x", dex_pc) << " in method "
+                 << GetDexFile().PrettyMethod(unit_.GetDexMethodIndex(), true);
+  // The operands and the quickening info entry are the ones of IGET-OBJECT-QUICK.
+  inst->SetOpcode(new_opcode);
+}
+
 void DexCompiler::CompileInvokeVirtual(Instruction* inst, uint32_t dex_pc,
                                        Instruction::Code new_opcode, bool is_range) {
   if (!kEnableQuickening) {
@@ -16,6 +16,8 @@
 
 #include "compiler_driver.h"
 
+#include <algorithm>
+#include <map>
 #include <unordered_set>
 #include <vector>
 #include <unistd.h>
@@ -36,6 +38,7 @@
 #include "base/systrace.h"
 #include "base/time_utils.h"
 #include "base/timing_logger.h"
+#include "bytecode_utils.h"
 #include "class_linker-inl.h"
 #include "compiled_method.h"
 #include "compiler.h"
@@ -303,12 +306,20 @@ CompilerDriver::CompilerDriver(
       timings_logger_(timer),
       compiler_context_(nullptr),
       support_boot_image_fixup_(true),
+      reference_verifier_deps_(nullptr),
       compiled_method_storage_(swap_fd),
       profile_compilation_info_(profile_compilation_info),
       max_arena_alloc_(0),
       dex_to_dex_references_lock_("dex-to-dex references lock"),
       dex_to_dex_references_(),
-      current_dex_to_dex_methods_(nullptr) {
+      current_dex_to_dex_methods_(nullptr),
+      jni_stubs_lock_("JNI stubs lock"),
+      jni_stubs_(),
+      non_inlinable_methods_lock_("non-inlinable methods lock"),
+      non_inlinable_methods_(),
+      memory_budget_lock_("memory budget lock"),
+      memory_budget_cond_("memory budget condition", memory_budget_lock_),
+      compilations_in_flight_(0u) {
   DCHECK(compiler_options_ != nullptr);
 
   compiler_->Init();
@@ -385,6 +396,17 @@ static void SetupIntrinsic(Thread* self,
   method->SetIntrinsic(static_cast<uint32_t>(intrinsic));
 }
 
+// The ordinal of an intrinsic is stored in the access flags of its method, see
+// ArtMethod::SetIntrinsic(). A longer list needs more bits there.
+#define CHECK_INTRINSIC_ORDINAL(Name, InvokeType, NeedsEnvironmentOrCache, SideEffects, \
+                                Exceptions, ClassName, MethodName, Signature) \
+  static_assert(static_cast<uint32_t>(Intrinsics::k##Name) <= kAccMaxIntrinsic, \
+                "Intrinsic " #Name " overflows the intrinsic bits of the access flags");
+#include "intrinsics_list.h"
+INTRINSICS_LIST(CHECK_INTRINSIC_ORDINAL)
+#undef INTRINSICS_LIST
+#undef CHECK_INTRINSIC_ORDINAL
+
 void CompilerDriver::CompileAll(jobject class_loader,
                                 const std::vector<const DexFile*>& dex_files,
                                 TimingLogger* timings) {
@@ -488,6 +510,29 @@ static bool InstructionSetHasGenericJniStub(InstructionSet isa) {
   }
 }
 
+// Return the key of the JNI stubs shared by the native methods with the same shorty, static
+// and synchronized modifiers, and optimization flags. This matches JitCodeCache::GetJniStubKey.
+static std::string GetJniStubKey(const DexFile& dex_file,
+                                 uint32_t method_idx,
+                                 uint32_t access_flags,
+                                 Compiler::JniOptimizationFlags optimization_flags) {
+  std::string key(dex_file.GetMethodShorty(dex_file.GetMethodId(method_idx)));
+  key += ((access_flags & kAccStatic) != 0) ? 'S' : 'V';
+  key += ((access_flags & kAccSynchronized) != 0) ? 'Y' : 'N';
+  switch (optimization_flags) {
+    case Compiler::kFastNative:
+      key += 'F';
+      break;
+    case Compiler::kCriticalNative:
+      key += 'C';
+      break;
+    default:
+      key += 'R';
+      break;
+  }
+  return key;
+}
+
 static void CompileMethod(Thread* self,
                           CompilerDriver* driver,
                           const DexFile::CodeItem* code_item,
@@ -564,11 +609,16 @@ static void CompileMethod(Thread* self,
         optimization_flags = Compiler::kCriticalNative;
       }
 
-      compiled_method = driver->GetCompiler()->JniCompile(access_flags,
-                                                          method_idx,
-                                                          dex_file,
-                                                          optimization_flags);
-      CHECK(compiled_method != nullptr);
+      std::string key = GetJniStubKey(dex_file, method_idx, access_flags, optimization_flags);
+      compiled_method = driver->GetCachedJniStub(self, key);
+      if (compiled_method == nullptr) {
+        compiled_method = driver->GetCompiler()->JniCompile(access_flags,
+                                                            method_idx,
+                                                            dex_file,
+                                                            optimization_flags);
+        CHECK(compiled_method != nullptr);
+        driver->CacheJniStub(self, key, compiled_method);
+      }
     }
   } else if ((access_flags & kAccAbstract) != 0) {
     // Abstract methods don't have code.
@@ -1359,6 +1409,37 @@ void CompilerDriver::MarkForDexToDexCompilation(Thread* self, const MethodRefere
   dex_to_dex_references_.back().GetMethodIndexes().SetBit(method_ref.dex_method_index);
 }
 
+CompiledMethod* CompilerDriver::GetCachedJniStub(Thread* self, const std::string& key) {
+  const CompiledMethod* stub = nullptr;
+  {
+    MutexLock lock(self, jni_stubs_lock_);
+    auto it = jni_stubs_.find(key);
+    if (it == jni_stubs_.end()) {
+      return nullptr;
+    }
+    stub = it->second;
+  }
+  // The stub is never modified or freed while compiling, and its arrays are deduplicated:
+  // the copy only takes a new CompiledMethod.
+  return CompiledMethod::SwapAllocCompiledMethod(this,
+                                                 stub->GetInstructionSet(),
+                                                 stub->GetQuickCode(),
+                                                 stub->GetFrameSizeInBytes(),
+                                                 stub->GetCoreSpillMask(),
+                                                 stub->GetFpSpillMask(),
+                                                 stub->GetMethodInfo(),
+                                                 stub->GetVmapTable(),
+                                                 stub->GetCFIInfo(),
+                                                 stub->GetPatches());
+}
+
+void CompilerDriver::CacheJniStub(Thread* self,
+                                  const std::string& key,
+                                  const CompiledMethod* stub) {
+  MutexLock lock(self, jni_stubs_lock_);
+  jni_stubs_.FindOrAdd(key, stub);
+}
+
 bool CompilerDriver::CanAccessTypeWithoutChecks(ObjPtr<mirror::Class> referrer_class,
                                                 ObjPtr<mirror::Class> resolved_class) {
   if (resolved_class == nullptr) {
@@ -1974,6 +2055,50 @@ bool CompilerDriver::FastVerify(jobject jclass_loader,
   return true;
 }
 
+bool CompilerDriver::ReuseUnchangedClasses(jobject jclass_loader, TimingLogger* timings) {
+  if (reference_verifier_deps_ == nullptr) {
+    return false;
+  }
+  TimingLogger::ScopedTiming t("Reuse Unchanged Classes", timings);
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<1> hs(soa.Self());
+  Handle<mirror::ClassLoader> class_loader(
+      hs.NewHandle(soa.Decode<mirror::ClassLoader>(jclass_loader)));
+  std::vector<std::map<uint32_t, bool>> unchanged_classes;
+  if (!reference_verifier_deps_->FindUnchangedClasses(class_loader,
+                                                      reference_dex_files_,
+                                                      dex_files_for_oat_file_,
+                                                      &unchanged_classes,
+                                                      soa.Self())) {
+    VLOG(compiler) << "Reference VerifierDeps do not hold, verifying all the classes";
+    return false;
+  }
+
+  // The classes are verified again, without running the verifier for those updated here,
+  // so that the status of all of them is recorded in the VerifierDeps the same way.
+  size_t num_unchanged_classes = 0u;
+  for (size_t i = 0; i != dex_files_for_oat_file_.size(); ++i) {
+    const DexFile& dex_file = *dex_files_for_oat_file_[i];
+    for (const auto& entry : unchanged_classes[i]) {
+      const DexFile::ClassDef& class_def = dex_file.GetClassDef(entry.first);
+      if (entry.second) {
+        LoadAndUpdateStatus(
+            dex_file, class_def, mirror::Class::kStatusVerified, class_loader, soa.Self());
+        PopulateVerifiedMethods(dex_file, entry.first, verification_results_);
+      } else {
+        LoadAndUpdateStatus(dex_file,
+                            class_def,
+                            mirror::Class::kStatusRetryVerificationAtRuntime,
+                            class_loader,
+                            soa.Self());
+      }
+      ++num_unchanged_classes;
+    }
+  }
+  VLOG(compiler) << "Reused the verification of " << num_unchanged_classes << " classes";
+  return num_unchanged_classes != 0u;
+}
+
 void CompilerDriver::Verify(jobject jclass_loader,
                             const std::vector<const DexFile*>& dex_files,
                             TimingLogger* timings) {
@@ -1985,6 +2110,7 @@ void CompilerDriver::Verify(jobject jclass_loader,
   // the existing `verifier_deps` is not valid anymore, create a new one for
   // non boot image compilation. The verifier will need it to record the new dependencies.
   // Then dex2oat can update the vdex file with these new dependencies.
+  bool reused_classes = false;
   if (!GetCompilerOptions().IsBootImage()) {
     // Dex2oat creates the verifier deps.
     // Create the main VerifierDeps, and set it to this thread.
@@ -1997,6 +2123,7 @@ void CompilerDriver::Verify(jobject jclass_loader,
     for (ThreadPoolWorker* worker : parallel_thread_pool_->GetWorkers()) {
       worker->GetThread()->SetVerifierDeps(new verifier::VerifierDeps(dex_files_for_oat_file_));
     }
+    reused_classes = ReuseUnchangedClasses(jclass_loader, timings);
   }
 
   // Verification updates VerifierDeps and needs to run single-threaded to be deterministic.
@@ -2023,6 +2150,11 @@ void CompilerDriver::Verify(jobject jclass_loader,
       verifier_deps->MergeWith(*thread_deps, dex_files_for_oat_file_);
       delete thread_deps;
     }
+    if (reused_classes) {
+      verifier_deps->MergeUnchangedDependencies(
+          *reference_verifier_deps_, reference_dex_files_, dex_files_for_oat_file_);
+    }
+    verifier_deps->RecordClassFingerprints(dex_files_for_oat_file_);
     Thread::Current()->SetVerifierDeps(nullptr);
   }
 }
@@ -2215,7 +2347,12 @@ void CompilerDriver::SetVerifiedDexFile(jobject class_loader,
 
 class InitializeClassVisitor : public CompilationVisitor {
  public:
-  explicit InitializeClassVisitor(const ParallelCompilationManager* manager) : manager_(manager) {}
+  // With `trivial_only`, only initialize the classes which do not need to run any code,
+  // without recording their status. This does not need a transaction, and can run in
+  // parallel even for images.
+  explicit InitializeClassVisitor(const ParallelCompilationManager* manager,
+                                  bool trivial_only = false)
+      : manager_(manager), trivial_only_(trivial_only) {}
 
   void Visit(size_t class_def_index) OVERRIDE {
     ATRACE_CALL();
@@ -2233,12 +2370,25 @@ class InitializeClassVisitor : public CompilationVisitor {
         hs.NewHandle(manager_->GetClassLinker()->FindClass(soa.Self(), descriptor, class_loader)));
 
     if (klass != nullptr && !SkipClass(manager_->GetClassLoader(), dex_file, klass.Get())) {
-      TryInitializeClass(klass, class_loader);
+      if (trivial_only_) {
+        TryInitializeClassTrivially(klass);
+      } else {
+        TryInitializeClass(klass, class_loader);
+      }
     }
     // Clear any class not found or verification exceptions.
     soa.Self()->ClearException();
   }
 
+  // Initialize klass if it needs neither its super-classes nor its static fields initialized.
+  void TryInitializeClassTrivially(Handle<mirror::Class> klass)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    const bool is_app_image = manager_->GetCompiler()->GetCompilerOptions().IsAppImage();
+    if (klass->IsVerified() && !(is_app_image && klass->IsBootStrapClassLoaded())) {
+      manager_->GetClassLinker()->EnsureInitialized(Thread::Current(), klass, false, false);
+    }
+  }
+
   // A helper function for initializing klass.
   void TryInitializeClass(Handle<mirror::Class> klass, Handle<mirror::ClassLoader>& class_loader)
       REQUIRES_SHARED(Locks::mutator_lock_) {
@@ -2573,6 +2723,7 @@ class InitializeClassVisitor : public CompilationVisitor {
   }
 
   const ParallelCompilationManager* const manager_;
+  const bool trivial_only_;
 };
 
 void CompilerDriver::InitializeClasses(jobject jni_class_loader,
@@ -2593,6 +2744,13 @@ void CompilerDriver::InitializeClasses(jobject jni_class_loader,
                                      init_thread_pool);
 
   if (GetCompilerOptions().IsBootImage() || GetCompilerOptions().IsAppImage()) {
+    if (init_thread_count > 1U) {
+      // First initialize in parallel the classes which do not need a transaction, so that
+      // the single-threaded pass below only has to deal with the others.
+      TimingLogger::ScopedTiming t2("InitializeTrivial", timings);
+      InitializeClassVisitor trivial_visitor(&context, /* trivial_only */ true);
+      context.ForAll(0, dex_file.NumClassDefs(), &trivial_visitor, init_thread_count);
+    }
     // Set the concurrency thread to 1 to support initialization for App Images since transaction
     // doesn't support multithreading now.
     // TODO: remove this when transactional mode supports multithreading.
@@ -2731,9 +2889,43 @@ void CompilerDriver::Compile(jobject class_loader,
   VLOG(compiler) << "Compile: " << GetMemoryUsageString(false);
 }
 
-class CompileClassVisitor : public CompilationVisitor {
+// A method to compile, with the state of its class needed by CompileMethod.
+struct MethodToCompile {
+  const DexFile::CodeItem* code_item;
+  uint32_t access_flags;
+  InvokeType invoke_type;
+  uint16_t class_def_index;
+  uint32_t method_idx;
+  optimizer::DexToDexCompilationLevel dex_to_dex_compilation_level;
+  bool compilation_enabled;
+  // The estimated compilation time, see EstimateCompilationCost.
+  size_t cost;
+};
+
+// Estimate the compilation time of a method from the size of its code, scaled by its number
+// of loops as the loop optimizations visit the loop bodies again.
+static size_t EstimateCompilationCost(const DexFile::CodeItem* code_item) {
+  if (code_item == nullptr) {
+    // Native and abstract methods.
+    return 0u;
+  }
+  size_t number_of_loops = 0u;
+  for (CodeItemIterator it(*code_item); !it.Done(); it.Advance()) {
+    // Every loop has at least one backward branch.
+    const Instruction& instruction = it.CurrentInstruction();
+    if (instruction.IsBranch() && instruction.GetTargetOffset() <= 0) {
+      ++number_of_loops;
+    }
+  }
+  return code_item->insns_size_in_code_units_ * (1u + number_of_loops);
+}
+
+// Collects the methods to compile of each class.
+class CollectMethodsToCompileVisitor : public CompilationVisitor {
  public:
-  explicit CompileClassVisitor(const ParallelCompilationManager* manager) : manager_(manager) {}
+  CollectMethodsToCompileVisitor(const ParallelCompilationManager* manager,
+                                 std::vector<std::vector<MethodToCompile>>* methods_per_class)
+      : manager_(manager), methods_per_class_(methods_per_class) {}
 
   virtual void Visit(size_t class_def_index) REQUIRES(!Locks::mutator_lock_) OVERRIDE {
     ATRACE_CALL();
@@ -2749,20 +2941,16 @@ class CompileClassVisitor : public CompilationVisitor {
     // Use a scoped object access to perform to the quick SkipClass check.
     const char* descriptor = dex_file.GetClassDescriptor(class_def);
     ScopedObjectAccess soa(Thread::Current());
-    StackHandleScope<3> hs(soa.Self());
+    StackHandleScope<2> hs(soa.Self());
     Handle<mirror::ClassLoader> class_loader(
         hs.NewHandle(soa.Decode<mirror::ClassLoader>(jclass_loader)));
     Handle<mirror::Class> klass(
         hs.NewHandle(class_linker->FindClass(soa.Self(), descriptor, class_loader)));
-    Handle<mirror::DexCache> dex_cache;
     if (klass == nullptr) {
       soa.Self()->AssertPendingException();
       soa.Self()->ClearException();
-      dex_cache = hs.NewHandle(class_linker->FindDexCache(soa.Self(), dex_file));
     } else if (SkipClass(jclass_loader, dex_file, klass.Get())) {
       return;
-    } else {
-      dex_cache = hs.NewHandle(klass->GetDexCache());
     }
 
     const uint8_t* class_data = dex_file.GetClassData(class_def);
@@ -2771,7 +2959,7 @@ class CompileClassVisitor : public CompilationVisitor {
       return;
     }
 
-    // Go to native so that we don't block GC during compilation.
+    // Go to native so that we don't block GC while reading the methods.
     ScopedThreadSuspension sts(soa.Self(), kNative);
 
     CompilerDriver* const driver = manager_->GetCompiler();
@@ -2786,7 +2974,21 @@ class CompileClassVisitor : public CompilationVisitor {
     bool compilation_enabled = driver->IsClassToCompile(
         dex_file.StringByTypeIdx(class_def.class_idx_));
 
-    // Compile direct methods
+    std::vector<MethodToCompile>* methods = &(*methods_per_class_)[class_def_index];
+    auto add_method = [&]() {
+      const DexFile::CodeItem* code_item = it.GetMethodCodeItem();
+      methods->push_back(MethodToCompile {
+          code_item,
+          it.GetMethodAccessFlags(),
+          it.GetMethodInvokeType(class_def),
+          static_cast<uint16_t>(class_def_index),
+          it.GetMemberIndex(),
+          dex_to_dex_compilation_level,
+          compilation_enabled,
+          EstimateCompilationCost(code_item) });
+    };
+
+    // Direct methods
     int64_t previous_direct_method_idx = -1;
     while (it.HasNextDirectMethod()) {
       uint32_t method_idx = it.GetMemberIndex();
@@ -2797,21 +2999,10 @@ class CompileClassVisitor : public CompilationVisitor {
         continue;
       }
       previous_direct_method_idx = method_idx;
-      CompileMethod(soa.Self(),
-                    driver,
-                    it.GetMethodCodeItem(),
-                    it.GetMethodAccessFlags(),
-                    it.GetMethodInvokeType(class_def),
-                    class_def_index,
-                    method_idx,
-                    class_loader,
-                    dex_file,
-                    dex_to_dex_compilation_level,
-                    compilation_enabled,
-                    dex_cache);
+      add_method();
       it.Next();
     }
-    // Compile virtual methods
+    // Virtual methods
     int64_t previous_virtual_method_idx = -1;
     while (it.HasNextVirtualMethod()) {
       uint32_t method_idx = it.GetMemberIndex();
@@ -2822,17 +3013,7 @@ class CompileClassVisitor : public CompilationVisitor {
         continue;
       }
       previous_virtual_method_idx = method_idx;
-      CompileMethod(soa.Self(),
-                    driver, it.GetMethodCodeItem(),
-                    it.GetMethodAccessFlags(),
-                    it.GetMethodInvokeType(class_def),
-                    class_def_index,
-                    method_idx,
-                    class_loader,
-                    dex_file,
-                    dex_to_dex_compilation_level,
-                    compilation_enabled,
-                    dex_cache);
+      add_method();
       it.Next();
     }
     DCHECK(!it.HasNext());
@@ -2840,6 +3021,50 @@ class CompileClassVisitor : public CompilationVisitor {
 
  private:
   const ParallelCompilationManager* const manager_;
+  std::vector<std::vector<MethodToCompile>>* const methods_per_class_;
+};
+
+class CompileMethodVisitor : public CompilationVisitor {
+ public:
+  CompileMethodVisitor(const ParallelCompilationManager* manager,
+                       const std::vector<MethodToCompile>* methods)
+      : manager_(manager), methods_(methods) {}
+
+  virtual void Visit(size_t index) REQUIRES(!Locks::mutator_lock_) OVERRIDE {
+    ATRACE_CALL();
+    const MethodToCompile& method = (*methods_)[index];
+    const DexFile& dex_file = *manager_->GetDexFile();
+    ScopedObjectAccess soa(Thread::Current());
+    StackHandleScope<2> hs(soa.Self());
+    Handle<mirror::ClassLoader> class_loader(
+        hs.NewHandle(soa.Decode<mirror::ClassLoader>(manager_->GetClassLoader())));
+    // The classes that were not skipped are all defined by this dex file.
+    Handle<mirror::DexCache> dex_cache(
+        hs.NewHandle(manager_->GetClassLinker()->FindDexCache(soa.Self(), dex_file)));
+
+    // Go to native so that we don't block GC during compilation.
+    ScopedThreadSuspension sts(soa.Self(), kNative);
+
+    CompilerDriver* driver = manager_->GetCompiler();
+    driver->StartCompilationInMemoryBudget(soa.Self());
+    CompileMethod(soa.Self(),
+                  manager_->GetCompiler(),
+                  method.code_item,
+                  method.access_flags,
+                  method.invoke_type,
+                  method.class_def_index,
+                  method.method_idx,
+                  class_loader,
+                  dex_file,
+                  method.dex_to_dex_compilation_level,
+                  method.compilation_enabled,
+                  dex_cache);
+    driver->FinishCompilationInMemoryBudget(soa.Self());
+  }
+
+ private:
+  const ParallelCompilationManager* const manager_;
+  const std::vector<MethodToCompile>* const methods_;
 };
 
 void CompilerDriver::CompileDexFile(jobject class_loader,
@@ -2851,8 +3076,25 @@ void CompilerDriver::CompileDexFile(jobject class_loader,
   TimingLogger::ScopedTiming t("Compile Dex File", timings);
   ParallelCompilationManager context(Runtime::Current()->GetClassLinker(), class_loader, this,
                                      &dex_file, dex_files, thread_pool);
-  CompileClassVisitor visitor(&context);
-  context.ForAll(0, dex_file.NumClassDefs(), &visitor, thread_count);
+  std::vector<std::vector<MethodToCompile>> methods_per_class(dex_file.NumClassDefs());
+  CollectMethodsToCompileVisitor collect_visitor(&context, &methods_per_class);
+  context.ForAll(0, dex_file.NumClassDefs(), &collect_visitor, thread_count);
+
+  // Hand out the methods one at a time, the most expensive first, so that no thread is left
+  // compiling a big method, or a big class, while the others wait for it.
+  std::vector<MethodToCompile> methods;
+  for (std::vector<MethodToCompile>& class_methods : methods_per_class) {
+    methods.insert(methods.end(), class_methods.begin(), class_methods.end());
+    class_methods.clear();
+    class_methods.shrink_to_fit();
+  }
+  std::stable_sort(methods.begin(),
+                   methods.end(),
+                   [](const MethodToCompile& lhs, const MethodToCompile& rhs) {
+                     return lhs.cost > rhs.cost;
+                   });
+  CompileMethodVisitor compile_visitor(&context, &methods);
+  context.ForAll(0, methods.size(), &compile_visitor, thread_count);
 }
 
 void CompilerDriver::AddCompiledMethod(const MethodReference& method_ref,
@@ -2984,6 +3226,55 @@ bool CompilerDriver::RequiresConstructorBarrier(Thread* self,
   return requires;
 }
 
+void CompilerDriver::MarkNonInlinableMethod(Thread* self, const MethodReference& method_ref) {
+  WriterMutexLock mu(self, non_inlinable_methods_lock_);
+  non_inlinable_methods_.insert(method_ref);
+}
+
+bool CompilerDriver::IsNonInlinableMethod(Thread* self, const MethodReference& method_ref) const {
+  ReaderMutexLock mu(self, non_inlinable_methods_lock_);
+  return non_inlinable_methods_.find(method_ref) != non_inlinable_methods_.end();
+}
+
+// Returns the resident set size of the process in bytes, or 0 if it cannot be read.
+static size_t GetResidentSetSize() {
+  FILE* statm = fopen("/proc/self/statm", "re");
+  if (statm == nullptr) {
+    return 0u;
+  }
+  size_t size;
+  size_t resident;
+  int fields = fscanf(statm, "%zu %zu", &size, &resident);
+  fclose(statm);
+  return (fields == 2) ? resident * kPageSize : 0u;
+}
+
+void CompilerDriver::StartCompilationInMemoryBudget(Thread* self) {
+  const size_t memory_budget = compiler_options_->GetMemoryBudget();
+  if (memory_budget == 0u) {
+    return;
+  }
+  if (GetResidentSetSize() > memory_budget) {
+    // Give back the arenas of the finished compilations before waiting for the others.
+    Runtime::Current()->ReclaimArenaPoolMemory();
+  }
+  MutexLock mu(self, memory_budget_lock_);
+  while (compilations_in_flight_ != 0u && GetResidentSetSize() > memory_budget) {
+    memory_budget_cond_.Wait(self);
+  }
+  ++compilations_in_flight_;
+}
+
+void CompilerDriver::FinishCompilationInMemoryBudget(Thread* self) {
+  if (compiler_options_->GetMemoryBudget() == 0u) {
+    return;
+  }
+  MutexLock mu(self, memory_budget_lock_);
+  DCHECK_NE(compilations_in_flight_, 0u);
+  --compilations_in_flight_;
+  memory_budget_cond_.Broadcast(self);
+}
+
 std::string CompilerDriver::GetMemoryUsageString(bool extended) const {
   std::ostringstream oss;
   const gc::Heap* const heap = Runtime::Current()->GetHeap();
@@ -50,6 +50,7 @@ class DexCache;
 
 namespace verifier {
 class MethodVerifier;
+class VerifierDeps;
 class VerifierDepsTest;
 }  // namespace verifier
 
@@ -110,6 +111,15 @@ class CompilerDriver {
     return ArrayRef<const DexFile* const>(dex_files_for_oat_file_);
   }
 
+  // Set the dependencies recorded for a previous version of the dex files for the oat file,
+  // decoded for `dex_files`, the previous dex files. Verification then reuses the outcome
+  // recorded for the classes that did not change.
+  void SetReferenceVerifierDeps(const verifier::VerifierDeps* verifier_deps,
+                                const std::vector<const DexFile*>& dex_files) {
+    reference_verifier_deps_ = verifier_deps;
+    reference_dex_files_ = dex_files;
+  }
+
   void CompileAll(jobject class_loader,
                   const std::vector<const DexFile*>& dex_files,
                   TimingLogger* timings)
@@ -369,6 +379,31 @@ class CompilerDriver {
   void MarkForDexToDexCompilation(Thread* self, const MethodReference& method_ref)
       REQUIRES(!dex_to_dex_references_lock_);
 
+  // Return a copy of the JNI stub compiled for the native methods with key `key` (see
+  // GetJniStubKey() in compiler_driver.cc), or null if there is none yet.
+  CompiledMethod* GetCachedJniStub(Thread* self, const std::string& key)
+      REQUIRES(!jni_stubs_lock_);
+
+  // Remember `stub` as the JNI stub of the native methods with key `key`, unless another
+  // thread already did. The stub must be owned by the compiled methods of this driver.
+  void CacheJniStub(Thread* self, const std::string& key, const CompiledMethod* stub)
+      REQUIRES(!jni_stubs_lock_);
+
+  // Remember that the method `method_ref` cannot be inlined whatever its caller, for the
+  // inliner to reject its other call sites without building its graph again.
+  void MarkNonInlinableMethod(Thread* self, const MethodReference& method_ref)
+      REQUIRES(!non_inlinable_methods_lock_);
+
+  // Was the method `method_ref` found not inlinable whatever its caller?
+  bool IsNonInlinableMethod(Thread* self, const MethodReference& method_ref) const
+      REQUIRES(!non_inlinable_methods_lock_);
+
+  // Wait until the compilation of a method fits in the memory budget of the compiler options,
+  // and count it as running until FinishCompilationInMemoryBudget(). Above the budget, the
+  // methods are compiled one at a time.
+  void StartCompilationInMemoryBudget(Thread* self) REQUIRES(!memory_budget_lock_);
+  void FinishCompilationInMemoryBudget(Thread* self) REQUIRES(!memory_budget_lock_);
+
   const BitVector* GetCurrentDexToDexMethods() const {
     return current_dex_to_dex_methods_;
   }
@@ -408,6 +443,10 @@ class CompilerDriver {
                   const std::vector<const DexFile*>& dex_files,
                   TimingLogger* timings);
 
+  // Set the status recorded in the reference VerifierDeps for the classes of the dex files
+  // for the oat file that did not change since. Return whether any class was reused.
+  bool ReuseUnchangedClasses(jobject class_loader, TimingLogger* timings);
+
   void Verify(jobject class_loader,
               const std::vector<const DexFile*>& dex_files,
               TimingLogger* timings);
@@ -532,6 +571,11 @@ class CompilerDriver {
   // List of dex files that will be stored in the oat file.
   std::vector<const DexFile*> dex_files_for_oat_file_;
 
+  // The dependencies of the previous version of the dex files for the oat file, and these dex
+  // files, if any.
+  const verifier::VerifierDeps* reference_verifier_deps_;
+  std::vector<const DexFile*> reference_dex_files_;
+
   CompiledMethodStorage compiled_method_storage_;
 
   // Info for profile guided compilation.
@@ -548,7 +592,24 @@ class CompilerDriver {
   // indexes for dex-to-dex compilation in the current dex file.
   const BitVector* current_dex_to_dex_methods_;
 
-  friend class CompileClassVisitor;
+  // The JNI stubs compiled so far, by the key of the native methods sharing them. The stubs
+  // only depend on their key, the other native methods with the same key reuse them.
+  Mutex jni_stubs_lock_;
+  SafeMap<std::string, const CompiledMethod*> jni_stubs_ GUARDED_BY(jni_stubs_lock_);
+
+  // The methods whose graph failed to build or to allocate registers for as callees. The
+  // failure does not depend on the caller, so it is shared by the compilations of the driver,
+  // be it AOT or JIT.
+  mutable ReaderWriterMutex non_inlinable_methods_lock_;
+  std::set<MethodReference, MethodReferenceComparator> non_inlinable_methods_
+      GUARDED_BY(non_inlinable_methods_lock_);
+
+  // The number of methods being compiled, when the compiler options set a memory budget.
+  Mutex memory_budget_lock_;
+  ConditionVariable memory_budget_cond_ GUARDED_BY(memory_budget_lock_);
+  size_t compilations_in_flight_ GUARDED_BY(memory_budget_lock_);
+
+  friend class CollectMethodsToCompileVisitor;
   friend class DexToDexDecompilerTest;
   friend class verifier::VerifierDepsTest;
   DISALLOW_COPY_AND_ASSIGN(CompilerDriver);
@@ -16,6 +16,7 @@
 
 #include "compiler_options.h"
 #include "dex/pass_manager.h"
+#include "pass_pipeline.h"
 
 #include <fstream>
 
@@ -29,6 +30,7 @@ CompilerOptions::CompilerOptions()
       tiny_method_threshold_(kDefaultTinyMethodThreshold),
       num_dex_methods_threshold_(kDefaultNumDexMethodsThreshold),
       inline_max_code_units_(kUnsetInlineMaxCodeUnits),
+      memory_budget_(0u),
       no_inline_from_(nullptr),
       boot_image_(false),
       app_image_(false),
@@ -47,8 +49,9 @@ CompilerOptions::CompilerOptions()
       dump_cfg_file_name_(""),
       dump_cfg_append_(false),
       force_determinism_(false),
-      register_allocation_strategy_(RegisterAllocator::kRegisterAllocatorDefault),
-      passes_to_run_(nullptr) {
+      register_allocation_strategy_(RegisterAllocator::kRegisterAllocatorTiered),
+      passes_to_run_(nullptr),
+      pass_pipeline_(nullptr) {
 }
 
 CompilerOptions::~CompilerOptions() {
@@ -80,6 +83,10 @@ void CompilerOptions::ParseInlineMaxCodeUnits(const StringPiece& option, UsageFn
   ParseUintOption(option, "--inline-max-code-units", &inline_max_code_units_, Usage);
 }
 
+void CompilerOptions::ParseMemoryBudget(const StringPiece& option, UsageFn Usage) {
+  ParseUintOption(option, "--memory-budget", &memory_budget_, Usage);
+}
+
 void CompilerOptions::ParseDisablePasses(const StringPiece& option,
                                          UsageFn Usage ATTRIBUTE_UNUSED) {
     DCHECK(option.starts_with("--disable-passes="));
@@ -108,6 +115,32 @@ void CompilerOptions::ParsePassOptions(const StringPiece& option,
         pass_manager_options_.SetOverriddenPassOptions(pass_options);
 }
 
+void CompilerOptions::AddPassPipeline(const std::string& description, UsageFn Usage) {
+  if (pass_pipeline_ == nullptr) {
+    pass_pipeline_.reset(new HPassPipeline());
+  }
+  std::string error_msg;
+  if (!pass_pipeline_->Parse(description, &error_msg)) {
+    Usage("%s", error_msg.c_str());
+  }
+}
+
+void CompilerOptions::ParsePassPipeline(const StringPiece& option, UsageFn Usage) {
+  DCHECK(option.starts_with("--pass-pipeline="));
+  const std::string description = option.substr(strlen("--pass-pipeline=")).data();
+  AddPassPipeline(description, Usage);
+}
+
+void CompilerOptions::ParsePassPipelineFile(const StringPiece& option, UsageFn Usage) {
+  DCHECK(option.starts_with("--pass-pipeline-file="));
+  const std::string file_name = option.substr(strlen("--pass-pipeline-file=")).data();
+  std::string description;
+  if (!ReadFileToString(file_name, &description)) {
+    Usage("Failed to read pass pipeline file %s", file_name.c_str());
+  }
+  AddPassPipeline(description, Usage);
+}
+
 void CompilerOptions::ParseDumpInitFailures(const StringPiece& option,
                                             UsageFn Usage ATTRIBUTE_UNUSED) {
   DCHECK(option.starts_with("--dump-init-failures="));
@@ -130,8 +163,10 @@ void CompilerOptions::ParseRegisterAllocationStrategy(const StringPiece& option,
     register_allocation_strategy_ = RegisterAllocator::Strategy::kRegisterAllocatorLinearScan;
   } else if (choice == "graph-color") {
     register_allocation_strategy_ = RegisterAllocator::Strategy::kRegisterAllocatorGraphColor;
+  } else if (choice == "tiered") {
+    register_allocation_strategy_ = RegisterAllocator::Strategy::kRegisterAllocatorTiered;
   } else {
-    Usage("Unrecognized register allocation strategy. Try linear-scan, or graph-color.");
+    Usage("Unrecognized register allocation strategy. Try linear-scan, graph-color, or tiered.");
   }
 }
 
@@ -155,6 +190,8 @@ bool CompilerOptions::ParseCompilerOption(const StringPiece& option, UsageFn Usa
     ParseNumDexMethods(option, Usage);
   } else if (option.starts_with("--inline-max-code-units=")) {
     ParseInlineMaxCodeUnits(option, Usage);
+  } else if (option.starts_with("--memory-budget=")) {
+    ParseMemoryBudget(option, Usage);
   } else if (option == "--generate-debug-info" || option == "-g") {
     generate_debug_info_ = true;
   } else if (option == "--no-generate-debug-info") {
@@ -177,6 +214,10 @@ bool CompilerOptions::ParseCompilerOption(const StringPiece& option, UsageFn Usa
     pass_manager_options_.SetPrintPassNames(true);
   } else if (option.starts_with("--disable-passes=")) {
     ParseDisablePasses(option, Usage);
+  } else if (option.starts_with("--pass-pipeline=")) {
+    ParsePassPipeline(option, Usage);
+  } else if (option.starts_with("--pass-pipeline-file=")) {
+    ParsePassPipelineFile(option, Usage);
   } else if (option.starts_with("--print-passes=")) {
     ParsePrintPasses(option, Usage);
   } else if (option == "--print-all-passes") {
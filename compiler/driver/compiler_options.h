@@ -35,6 +35,7 @@ namespace verifier {
 }  // namespace verifier
 
 class DexFile;
+class HPassPipeline;
 
 class CompilerOptions FINAL {
  public:
@@ -132,6 +133,12 @@ class CompilerOptions FINAL {
     inline_max_code_units_ = units;
   }
 
+  // The resident set size, in bytes, above which the driver compiles one method at a time.
+  // Zero if the memory used by the compilation is not bounded.
+  size_t GetMemoryBudget() const {
+    return memory_budget_;
+  }
+
   double GetTopKProfileThreshold() const {
     return top_k_profile_threshold_;
   }
@@ -250,14 +257,23 @@ class CompilerOptions FINAL {
     return passes_to_run_;
   }
 
+  // Returns the pipeline changes requested by --pass-pipeline(-file), or null if none.
+  const HPassPipeline* GetPassPipeline() const {
+    return pass_pipeline_.get();
+  }
+
  private:
   void ParseDumpInitFailures(const StringPiece& option, UsageFn Usage);
   void ParsePassOptions(const StringPiece& option, UsageFn Usage);
   void ParseDumpCfgPasses(const StringPiece& option, UsageFn Usage);
   void ParsePrintPasses(const StringPiece& option, UsageFn Usage);
   void ParseDisablePasses(const StringPiece& option, UsageFn Usage);
+  void ParsePassPipeline(const StringPiece& option, UsageFn Usage);
+  void ParsePassPipelineFile(const StringPiece& option, UsageFn Usage);
+  void AddPassPipeline(const std::string& description, UsageFn Usage);
   void ParseInlineMaxCodeUnits(const StringPiece& option, UsageFn Usage);
   void ParseNumDexMethods(const StringPiece& option, UsageFn Usage);
+  void ParseMemoryBudget(const StringPiece& option, UsageFn Usage);
   void ParseTinyMethodMax(const StringPiece& option, UsageFn Usage);
   void ParseSmallMethodMax(const StringPiece& option, UsageFn Usage);
   void ParseLargeMethodMax(const StringPiece& option, UsageFn Usage);
@@ -271,6 +287,7 @@ class CompilerOptions FINAL {
   size_t tiny_method_threshold_;
   size_t num_dex_methods_threshold_;
   size_t inline_max_code_units_;
+  size_t memory_budget_;
 
   // Dex files from which we should not inline code.
   // This is usually a very short list (i.e. a single dex file), so we
@@ -319,6 +336,9 @@ class CompilerOptions FINAL {
   // compiler-dependant behavior.
   const std::vector<std::string>* passes_to_run_;
 
+  // Per-method/class/mode changes to the optimization pass pipeline.
+  std::unique_ptr<HPassPipeline> pass_pipeline_;
+
   friend class Dex2Oat;
   friend class DexToDexDecompilerTest;
   friend class CommonCompilerTest;
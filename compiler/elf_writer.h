@@ -57,7 +57,10 @@ class ElfWriter {
                                      size_t bss_size,
                                      size_t bss_methods_offset,
                                      size_t bss_roots_offset) = 0;
-  virtual void PrepareDebugInfo(const ArrayRef<const debug::MethodDebugInfo>& method_infos) = 0;
+  // Start preparing the mini-debug-info in the background, compressed on up to thread_count
+  // threads.
+  virtual void PrepareDebugInfo(const ArrayRef<const debug::MethodDebugInfo>& method_infos,
+                                size_t thread_count) = 0;
   virtual OutputStream* StartRoData() = 0;
   virtual void EndRoData(OutputStream* rodata) = 0;
   virtual OutputStream* StartText() = 0;
@@ -31,7 +31,7 @@
 #include "elf_utils.h"
 #include "globals.h"
 #include "leb128.h"
-#include "linker/buffered_output_stream.h"
+#include "linker/async_buffered_output_stream.h"
 #include "linker/file_output_stream.h"
 #include "thread-current-inl.h"
 #include "thread_pool.h"
@@ -54,12 +54,14 @@ class DebugInfoTask : public Task {
                 const InstructionSetFeatures* features,
                 size_t rodata_section_size,
                 size_t text_section_size,
-                const ArrayRef<const debug::MethodDebugInfo>& method_infos)
+                const ArrayRef<const debug::MethodDebugInfo>& method_infos,
+                size_t thread_count)
       : isa_(isa),
         instruction_set_features_(features),
         rodata_section_size_(rodata_section_size),
         text_section_size_(text_section_size),
-        method_infos_(method_infos) {
+        method_infos_(method_infos),
+        thread_count_(thread_count) {
   }
 
   void Run(Thread*) {
@@ -67,7 +69,8 @@ class DebugInfoTask : public Task {
                                        instruction_set_features_,
                                        rodata_section_size_,
                                        text_section_size_,
-                                       method_infos_);
+                                       method_infos_,
+                                       thread_count_);
   }
 
   std::vector<uint8_t>* GetResult() {
@@ -80,6 +83,7 @@ class DebugInfoTask : public Task {
   size_t rodata_section_size_;
   size_t text_section_size_;
   const ArrayRef<const debug::MethodDebugInfo> method_infos_;
+  const size_t thread_count_;
   std::vector<uint8_t> result_;
 };
 
@@ -98,7 +102,8 @@ class ElfWriterQuick FINAL : public ElfWriter {
                              size_t bss_size,
                              size_t bss_methods_offset,
                              size_t bss_roots_offset) OVERRIDE;
-  void PrepareDebugInfo(const ArrayRef<const debug::MethodDebugInfo>& method_infos) OVERRIDE;
+  void PrepareDebugInfo(const ArrayRef<const debug::MethodDebugInfo>& method_infos,
+                        size_t thread_count) OVERRIDE;
   OutputStream* StartRoData() OVERRIDE;
   void EndRoData(OutputStream* rodata) OVERRIDE;
   OutputStream* StartText() OVERRIDE;
@@ -121,7 +126,7 @@ class ElfWriterQuick FINAL : public ElfWriter {
   size_t rodata_size_;
   size_t text_size_;
   size_t bss_size_;
-  std::unique_ptr<BufferedOutputStream> output_stream_;
+  std::unique_ptr<AsyncBufferedOutputStream> output_stream_;
   std::unique_ptr<ElfBuilder<ElfTypes>> builder_;
   std::unique_ptr<DebugInfoTask> debug_info_task_;
   std::unique_ptr<ThreadPool> debug_info_thread_pool_;
@@ -160,8 +165,8 @@ ElfWriterQuick<ElfTypes>::ElfWriterQuick(InstructionSet instruction_set,
       rodata_size_(0u),
       text_size_(0u),
       bss_size_(0u),
-      output_stream_(
-          std::make_unique<BufferedOutputStream>(std::make_unique<FileOutputStream>(elf_file))),
+      output_stream_(std::make_unique<AsyncBufferedOutputStream>(
+          std::make_unique<FileOutputStream>(elf_file))),
       builder_(new ElfBuilder<ElfTypes>(instruction_set, features, output_stream_.get())) {}
 
 template <typename ElfTypes>
@@ -234,7 +239,8 @@ void ElfWriterQuick<ElfTypes>::WriteDynamicSection() {
 
 template <typename ElfTypes>
 void ElfWriterQuick<ElfTypes>::PrepareDebugInfo(
-    const ArrayRef<const debug::MethodDebugInfo>& method_infos) {
+    const ArrayRef<const debug::MethodDebugInfo>& method_infos,
+    size_t thread_count) {
   if (!method_infos.empty() && compiler_options_->GetGenerateMiniDebugInfo()) {
     // Prepare the mini-debug-info in background while we do other I/O.
     Thread* self = Thread::Current();
@@ -243,7 +249,8 @@ void ElfWriterQuick<ElfTypes>::PrepareDebugInfo(
                           instruction_set_features_,
                           rodata_size_,
                           text_size_,
-                          method_infos));
+                          method_infos,
+                          thread_count));
     debug_info_thread_pool_ = std::unique_ptr<ThreadPool>(
         new ThreadPool("Mini-debug-info writer", 1));
     debug_info_thread_pool_->AddTask(self, debug_info_task_.get());
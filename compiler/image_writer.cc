@@ -27,6 +27,7 @@
 
 #include "art_field-inl.h"
 #include "art_method-inl.h"
+#include "base/array_ref.h"
 #include "base/callee_save_type.h"
 #include "base/enums.h"
 #include "base/logging.h"
@@ -72,6 +73,7 @@
 #include "oat_file_manager.h"
 #include "runtime.h"
 #include "scoped_thread_state_change-inl.h"
+#include "thread_pool.h"
 #include "utils/dex_cache_arrays_layout-inl.h"
 
 using ::art::mirror::Class;
@@ -85,6 +87,9 @@ namespace art {
 // Separate objects into multiple bins to optimize dirty memory use.
 static constexpr bool kBinObjects = true;
 
+// The objects are copied and fixed up in parallel by tasks of this many objects.
+static constexpr size_t kCopyAndFixupObjectsPerTask = 4096u;
+
 // Return true if an object is already in an image space.
 bool ImageWriter::IsInBootImage(const void* obj) const {
   gc::Heap* const heap = Runtime::Current()->GetHeap();
@@ -192,8 +197,8 @@ bool ImageWriter::Write(int image_fd,
     // TODO: heap validation can't handle these fix up passes.
     ScopedObjectAccess soa(Thread::Current());
     Runtime::Current()->GetHeap()->DisableObjectValidation();
-    CopyAndFixupObjects();
   }
+  CopyAndFixupObjects();
 
   for (size_t i = 0; i < image_filenames.size(); ++i) {
     const char* image_filename = image_filenames[i];
@@ -2151,13 +2156,65 @@ void ImageWriter::CopyAndFixupNativeData(size_t oat_index) {
   }
 }
 
+// Copies and fixes up a range of the objects.
+class ImageWriter::CopyAndFixupObjectsTask FINAL : public Task {
+ public:
+  CopyAndFixupObjectsTask(ImageWriter* image_writer, ArrayRef<Object* const> objects)
+      : image_writer_(image_writer), objects_(objects) {}
+
+  void Run(Thread* self) OVERRIDE {
+    ScopedObjectAccess soa(self);
+    ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
+    for (Object* obj : objects_) {
+      image_writer_->CopyAndFixupObject(obj);
+    }
+  }
+
+ private:
+  ImageWriter* const image_writer_;
+  const ArrayRef<Object* const> objects_;
+};
+
 void ImageWriter::CopyAndFixupObjects() {
-  auto visitor = [&](Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
-    DCHECK(obj != nullptr);
-    CopyAndFixupObject(obj);
-  };
-  Runtime::Current()->GetHeap()->VisitObjects(visitor);
+  Thread* self = Thread::Current();
+  std::vector<Object*> objects;
+  {
+    ScopedObjectAccess soa(self);
+    auto visitor = [&](Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
+      DCHECK(obj != nullptr);
+      if (!IsInBootImage(obj)) {
+        objects.push_back(obj);
+      }
+    };
+    Runtime::Current()->GetHeap()->VisitObjects(visitor);
+  }
+
+  // Every object is copied to its own slot, and the fixup only reads the originals and the
+  // relocations, so the objects are copied and fixed up in parallel.
+  std::vector<std::unique_ptr<CopyAndFixupObjectsTask>> tasks;
+  for (size_t begin = 0; begin < objects.size(); begin += kCopyAndFixupObjectsPerTask) {
+    size_t count = std::min(kCopyAndFixupObjectsPerTask, objects.size() - begin);
+    tasks.emplace_back(
+        new CopyAndFixupObjectsTask(this, ArrayRef<Object* const>(objects).SubArray(begin, count)));
+  }
+  size_t thread_count = compiler_driver_.GetThreadCount();
+  if (thread_count > 1u && tasks.size() > 1u) {
+    ThreadPool thread_pool("Image writer thread pool", thread_count - 1u);
+    for (const std::unique_ptr<CopyAndFixupObjectsTask>& task : tasks) {
+      thread_pool.AddTask(self, task.get());
+    }
+    thread_pool.StartWorkers(self);
+    // The tasks run with the mutator lock, this thread must not hold it while it waits.
+    CHECK_NE(self->GetState(), kRunnable);
+    thread_pool.Wait(self, /* do_work */ true, /* may_hold_locks */ false);
+  } else {
+    for (const std::unique_ptr<CopyAndFixupObjectsTask>& task : tasks) {
+      task->Run(self);
+    }
+  }
+
   // Fix up the object previously had hash codes.
+  ScopedObjectAccess soa(self);
   for (const auto& hash_pair : saved_hashcode_map_) {
     Object* obj = hash_pair.first;
     DCHECK_EQ(obj->GetLockWord<kVerifyNone>(false).ReadBarrierState(), 0U);
@@ -2211,7 +2268,8 @@ void ImageWriter::CopyAndFixupObject(Object* obj) {
   DCHECK_LT(offset, image_info.image_end_);
   const auto* src = reinterpret_cast<const uint8_t*>(obj);
 
-  image_info.image_bitmap_->Set(dst);  // Mark the obj as live.
+  // Mark the obj as live. The objects are copied in parallel, some share a word of the bitmap.
+  image_info.image_bitmap_->AtomicTestAndSet(dst);
 
   const size_t n = obj->SizeOf();
   DCHECK_LE(offset + n, image_info.image_->Size());
@@ -2365,9 +2423,9 @@ void ImageWriter::FixupObject(Object* orig, Object* copy) {
     // Is this a native pointer array?
     auto it = pointer_arrays_.find(down_cast<mirror::PointerArray*>(orig));
     if (it != pointer_arrays_.end()) {
-      // Should only need to fixup every pointer array exactly once.
+      // Every object is fixed up exactly once, as is every pointer array. The map is shared by
+      // the threads fixing up the objects, it is only read.
       FixupPointerArray(copy, down_cast<mirror::PointerArray*>(orig), klass, it->second);
-      pointer_arrays_.erase(it);
       return;
     }
   }
@@ -416,7 +416,7 @@ class ImageWriter FINAL {
 
   // Creates the contiguous image in memory and adjusts pointers.
   void CopyAndFixupNativeData(size_t oat_index) REQUIRES_SHARED(Locks::mutator_lock_);
-  void CopyAndFixupObjects() REQUIRES_SHARED(Locks::mutator_lock_);
+  void CopyAndFixupObjects() REQUIRES(!Locks::mutator_lock_);
   void CopyAndFixupObject(mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_);
   void CopyAndFixupMethod(ArtMethod* orig, ArtMethod* copy, const ImageInfo& image_info)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -605,6 +605,7 @@ class ImageWriter FINAL {
   const std::unordered_set<std::string>* dirty_image_objects_;
 
   class ComputeLazyFieldsForClassesVisitor;
+  class CopyAndFixupObjectsTask;
   class FixupClassVisitor;
   class FixupRootVisitor;
   class FixupVisitor;
@@ -59,11 +59,11 @@ extern "C" void jit_unload(void* handle) {
 }
 
 extern "C" bool jit_compile_method(
-    void* handle, ArtMethod* method, Thread* self, bool osr)
+    void* handle, ArtMethod* method, Thread* self, bool osr, bool baseline)
     REQUIRES_SHARED(Locks::mutator_lock_) {
   auto* jit_compiler = reinterpret_cast<JitCompiler*>(handle);
   DCHECK(jit_compiler != nullptr);
-  return jit_compiler->CompileMethod(self, method, osr);
+  return jit_compiler->CompileMethod(self, method, osr, baseline);
 }
 
 extern "C" void jit_types_loaded(void* handle, mirror::Class** types, size_t count)
@@ -133,6 +133,16 @@ JitCompiler::JitCompiler() {
       }
     }
   }
+  if (instruction_set == kX86 || instruction_set == kX86_64) {
+    // Compile for the features of the running CPU when it has at least the ones asked
+    // for, e.g. AVX2 vector loops on the CPUs of a fleet with it.
+    std::unique_ptr<const InstructionSetFeatures> cpu_features =
+        InstructionSetFeatures::FromCpuInfo();
+    if (instruction_set_features_ == nullptr ||
+        cpu_features->HasAtLeast(instruction_set_features_.get())) {
+      instruction_set_features_ = std::move(cpu_features);
+    }
+  }
   if (instruction_set_features_ == nullptr) {
     instruction_set_features_ = InstructionSetFeatures::FromCppDefines();
   }
@@ -160,18 +170,21 @@ JitCompiler::JitCompiler() {
   if (compiler_options_->GetGenerateDebugInfo()) {
     DCHECK_EQ(thread_count, 1u)
         << "Generating debug info only works with one compiler thread";
+  }
+  if (compiler_options_->GetGenerateDebugInfo() ||
+      Runtime::Current()->GetJITOptions()->UsePerfDump()) {
     jit_logger_.reset(new JitLogger());
     jit_logger_->OpenLog();
   }
 }
 
 JitCompiler::~JitCompiler() {
-  if (compiler_options_->GetGenerateDebugInfo()) {
+  if (jit_logger_ != nullptr) {
     jit_logger_->CloseLog();
   }
 }
 
-bool JitCompiler::CompileMethod(Thread* self, ArtMethod* method, bool osr) {
+bool JitCompiler::CompileMethod(Thread* self, ArtMethod* method, bool osr, bool baseline) {
   DCHECK(!method->IsProxyMethod());
   DCHECK(method->GetDeclaringClass()->IsResolved());
 
@@ -185,7 +198,7 @@ bool JitCompiler::CompileMethod(Thread* self, ArtMethod* method, bool osr) {
     TimingLogger::ScopedTiming t2("Compiling", &logger);
     JitCodeCache* const code_cache = runtime->GetJit()->GetCodeCache();
     success = compiler_driver_->GetCompiler()->JitCompile(
-        self, code_cache, method, osr, jit_logger_.get());
+        self, code_cache, method, osr, baseline, jit_logger_.get());
   }
 
   // Trim maps to reduce memory usage.
@@ -35,8 +35,9 @@ class JitCompiler {
   static JitCompiler* Create();
   virtual ~JitCompiler();
 
-  // Compilation entrypoint. Returns whether the compilation succeeded.
-  bool CompileMethod(Thread* self, ArtMethod* method, bool osr)
+  // Compilation entrypoint. Returns whether the compilation succeeded. Baseline compilations
+  // skip the optimizations that are the most expensive to run.
+  bool CompileMethod(Thread* self, ArtMethod* method, bool osr, bool baseline)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   CompilerOptions* GetCompilerOptions() const {
@@ -24,6 +24,7 @@
 #include "jit/jit.h"
 #include "jit/jit_code_cache.h"
 #include "oat_file-inl.h"
+#include "thread-current-inl.h"
 
 namespace art {
 namespace jit {
@@ -50,25 +51,31 @@ void JitLogger::OpenPerfMapLog() {
   }
 }
 
-void JitLogger::WritePerfMapLog(const void* ptr, size_t code_size, ArtMethod* method) {
-  if (perf_file_ != nullptr) {
-    std::string method_name = method->PrettyMethod();
+std::string JitLogger::GetSymbolName(ArtMethod* method, bool osr, bool baseline) {
+  std::string symbol = method->PrettyMethod();
+  if (osr) {
+    symbol += " [osr]";
+  } else if (baseline) {
+    symbol += " [baseline]";
+  }
+  return symbol;
+}
 
+void JitLogger::WritePerfMapLog(const void* ptr, size_t code_size, const std::string& symbol) {
+  if (perf_file_ != nullptr) {
     std::ostringstream stream;
     stream << std::hex
            << reinterpret_cast<uintptr_t>(ptr)
            << " "
            << code_size
            << " "
-           << method_name
+           << symbol
            << std::endl;
     std::string str = stream.str();
     bool res = perf_file_->WriteFully(str.c_str(), str.size());
     if (!res) {
       LOG(WARNING) << "Failed to write jitted method info in log: write failure.";
     }
-  } else {
-    LOG(WARNING) << "Failed to write jitted method info in log: log file doesn't exist.";
   }
 }
 
@@ -267,14 +274,12 @@ void JitLogger::OpenJitDumpLog() {
   WriteJitDumpHeader();
 }
 
-void JitLogger::WriteJitDumpLog(const void* ptr, size_t code_size, ArtMethod* method) {
+void JitLogger::WriteJitDumpLog(const void* ptr, size_t code_size, const std::string& symbol) {
   if (jit_dump_file_ != nullptr) {
-    std::string method_name = method->PrettyMethod();
-
     PerfJitCodeLoad jit_code;
     std::memset(&jit_code, 0, sizeof(jit_code));
     jit_code.event_ = PerfJitCodeLoad::kLoad;
-    jit_code.size_ = sizeof(jit_code) + method_name.size() + 1 + code_size;
+    jit_code.size_ = sizeof(jit_code) + symbol.size() + 1 + code_size;
     jit_code.time_stamp_ = art::NanoTime();    // CLOCK_MONOTONIC clock is required.
     jit_code.process_id_ = static_cast<uint32_t>(getpid());
     jit_code.thread_id_ = static_cast<uint32_t>(art::GetTid());
@@ -290,20 +295,48 @@ void JitLogger::WriteJitDumpLog(const void* ptr, size_t code_size, ArtMethod* me
     //
     // Use UNUSED() here to avoid compiler warnings.
     UNUSED(jit_dump_file_->WriteFully(reinterpret_cast<const char*>(&jit_code), sizeof(jit_code)));
-    UNUSED(jit_dump_file_->WriteFully(method_name.c_str(), method_name.size() + 1));
+    UNUSED(jit_dump_file_->WriteFully(symbol.c_str(), symbol.size() + 1));
     UNUSED(jit_dump_file_->WriteFully(ptr, code_size));
 
     WriteJitDumpDebugInfo();
   }
 }
 
+void JitLogger::WriteJitDumpClose() {
+  PerfJitBase close;
+  std::memset(&close, 0, sizeof(close));
+  close.event_ = PerfJitBase::kClose;
+  close.size_ = sizeof(close);
+  close.time_stamp_ = art::NanoTime();  // CLOCK_MONOTONIC clock is required.
+  UNUSED(jit_dump_file_->WriteFully(reinterpret_cast<const char*>(&close), sizeof(close)));
+}
+
 void JitLogger::CloseJitDumpLog() {
   if (jit_dump_file_ != nullptr) {
+    // Tell the readers that no other method will be logged.
+    WriteJitDumpClose();
     CloseMarkerFile();
     UNUSED(jit_dump_file_->Flush());
     UNUSED(jit_dump_file_->Close());
   }
 }
 
+void JitLogger::WriteLog(const void* ptr,
+                         size_t code_size,
+                         ArtMethod* method,
+                         bool osr,
+                         bool baseline) {
+  std::string symbol = GetSymbolName(method, osr, baseline);
+  MutexLock mu(Thread::Current(), lock_);
+  WritePerfMapLog(ptr, code_size, symbol);
+  WriteJitDumpLog(ptr, code_size, symbol);
+}
+
+void JitLogger::CloseLog() {
+  MutexLock mu(Thread::Current(), lock_);
+  ClosePerfMapLog();
+  CloseJitDumpLog();
+}
+
 }  // namespace jit
 }  // namespace art
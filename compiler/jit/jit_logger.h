@@ -37,7 +37,7 @@ namespace jit {
 //     and allows perf to map samples in jit-code-cache to jitted method symbols.
 //
 //     Command line Example:
-//       $ perf record dalvikvm -Xcompiler-option --generate-debug-info -cp <classpath> Test
+//       $ perf record dalvikvm -Xjitperfdump -cp <classpath> Test
 //       $ perf report
 //     NOTE:
 //       - Make sure that the perf-PID.map file is available for 'perf report' tool to access,
@@ -51,7 +51,7 @@ namespace jit {
 //     for example instruction level profiling.
 //
 //     Command line Example:
-//       $ perf record -k mono dalvikvm -Xcompiler-option --generate-debug-info -cp <classpath> Test
+//       $ perf record -k mono dalvikvm -Xjitperfdump -cp <classpath> Test
 //       $ perf inject -i perf.data -o perf.data.jitted
 //       $ perf report -i perf.data.jitted
 //       $ perf annotate -i perf.data.jitted
@@ -85,48 +85,52 @@ namespace jit {
 //       - Make sure above small ELF files are available for 'perf annotate' tool to access,
 //         so that jitted code can be displayed in assembly view.
 //
+// Both logs are written with -Xjitperfdump, or with --generate-debug-info which also
+// registers debug ELF files for gdb. The compiler threads write them concurrently.
+// The symbol of a method compiled for OSR or by the baseline tier is suffixed with
+// " [osr]" or " [baseline]", so that the tiers are told apart in the reports.
+//
 class JitLogger {
   public:
-    JitLogger() : code_index_(0), marker_address_(nullptr) {}
+    JitLogger() : code_index_(0), marker_address_(nullptr), lock_("JIT logger lock") {}
 
     void OpenLog() {
       OpenPerfMapLog();
       OpenJitDumpLog();
     }
 
-    void WriteLog(const void* ptr, size_t code_size, ArtMethod* method)
-        REQUIRES_SHARED(Locks::mutator_lock_) {
-      WritePerfMapLog(ptr, code_size, method);
-      WriteJitDumpLog(ptr, code_size, method);
-    }
+    void WriteLog(const void* ptr, size_t code_size, ArtMethod* method, bool osr, bool baseline)
+        REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!lock_);
 
-    void CloseLog() {
-      ClosePerfMapLog();
-      CloseJitDumpLog();
-    }
+    void CloseLog() REQUIRES(!lock_);
 
   private:
+    static std::string GetSymbolName(ArtMethod* method, bool osr, bool baseline)
+        REQUIRES_SHARED(Locks::mutator_lock_);
+
     // For perf-map profiling
     void OpenPerfMapLog();
-    void WritePerfMapLog(const void* ptr, size_t code_size, ArtMethod* method)
-        REQUIRES_SHARED(Locks::mutator_lock_);
-    void ClosePerfMapLog();
+    void WritePerfMapLog(const void* ptr, size_t code_size, const std::string& symbol)
+        REQUIRES(lock_);
+    void ClosePerfMapLog() REQUIRES(lock_);
 
     // For perf-inject profiling
     void OpenJitDumpLog();
-    void WriteJitDumpLog(const void* ptr, size_t code_size, ArtMethod* method)
-        REQUIRES_SHARED(Locks::mutator_lock_);
-    void CloseJitDumpLog();
+    void WriteJitDumpLog(const void* ptr, size_t code_size, const std::string& symbol)
+        REQUIRES(lock_);
+    void CloseJitDumpLog() REQUIRES(lock_);
 
     void OpenMarkerFile();
     void CloseMarkerFile();
     void WriteJitDumpHeader();
     void WriteJitDumpDebugInfo();
+    void WriteJitDumpClose() REQUIRES(lock_);
 
     std::unique_ptr<File> perf_file_;
     std::unique_ptr<File> jit_dump_file_;
-    uint64_t code_index_;
+    uint64_t code_index_ GUARDED_BY(lock_);
     void* marker_address_;
+    Mutex lock_;
 
     DISALLOW_COPY_AND_ASSIGN(JitLogger);
 };
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "async_buffered_output_stream.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "thread-current-inl.h"
+#include "thread_pool.h"
+
+namespace art {
+
+class AsyncBufferedOutputStream::WriteTask FINAL : public Task {
+ public:
+  explicit WriteTask(OutputStream* out)
+      : out_(out), data_(nullptr), size_(0u), success_(true), error_(0) {}
+
+  void Set(const uint8_t* data, size_t size) {
+    data_ = data;
+    size_ = size;
+  }
+
+  void Run(Thread* self ATTRIBUTE_UNUSED) OVERRIDE {
+    if (!out_->WriteFully(data_, size_)) {
+      success_ = false;
+      error_ = errno;
+    }
+  }
+
+  // Return false, with errno set, if a write failed.
+  bool GetResult() const {
+    if (!success_) {
+      errno = error_;
+    }
+    return success_;
+  }
+
+ private:
+  OutputStream* const out_;
+  const uint8_t* data_;
+  size_t size_;
+  bool success_;
+  int error_;
+};
+
+AsyncBufferedOutputStream::AsyncBufferedOutputStream(std::unique_ptr<OutputStream> out)
+    : OutputStream(out->GetLocation()),  // Before out is moved to out_.
+      out_(std::move(out)),
+      current_buffer_(0u),
+      used_(0u),
+      write_task_(new WriteTask(out_.get())),
+      thread_pool_(nullptr),
+      write_in_flight_(false) {
+  buffers_[0].reset(new uint8_t[kBufferSize]);
+  buffers_[1].reset(new uint8_t[kBufferSize]);
+  Thread* self = Thread::Current();
+  if (self != nullptr) {
+    thread_pool_.reset(new ThreadPool("Output stream writer", 1));
+    thread_pool_->StartWorkers(self);
+  }
+}
+
+AsyncBufferedOutputStream::~AsyncBufferedOutputStream() {
+  FlushBuffer();
+  if (thread_pool_ != nullptr) {
+    thread_pool_->StopWorkers(Thread::Current());
+  }
+}
+
+bool AsyncBufferedOutputStream::WriteFully(const void* buffer, size_t byte_count) {
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(buffer);
+  while (byte_count != 0u) {
+    if (used_ == kBufferSize && !StartWriteBuffer()) {
+      return false;
+    }
+    size_t size = std::min(byte_count, kBufferSize - used_);
+    memcpy(&buffers_[current_buffer_][used_], src, size);
+    used_ += size;
+    src += size;
+    byte_count -= size;
+  }
+  return true;
+}
+
+bool AsyncBufferedOutputStream::Flush() {
+  return FlushBuffer() && out_->Flush();
+}
+
+off_t AsyncBufferedOutputStream::Seek(off_t offset, Whence whence) {
+  if (!FlushBuffer()) {
+    return -1;
+  }
+  return out_->Seek(offset, whence);
+}
+
+bool AsyncBufferedOutputStream::StartWriteBuffer() {
+  // The other buffer is free once its write completes.
+  if (!WaitForWrite()) {
+    return false;
+  }
+  if (used_ == 0u) {
+    return true;
+  }
+  write_task_->Set(buffers_[current_buffer_].get(), used_);
+  used_ = 0u;
+  if (thread_pool_ == nullptr) {
+    write_task_->Run(nullptr);
+    return write_task_->GetResult();
+  }
+  thread_pool_->AddTask(Thread::Current(), write_task_.get());
+  write_in_flight_ = true;
+  current_buffer_ ^= 1u;
+  return true;
+}
+
+bool AsyncBufferedOutputStream::FlushBuffer() {
+  return StartWriteBuffer() && WaitForWrite();
+}
+
+bool AsyncBufferedOutputStream::WaitForWrite() {
+  if (write_in_flight_) {
+    // The caller may hold the mutator lock, the worker never takes it.
+    thread_pool_->Wait(Thread::Current(), /* do_work */ false, /* may_hold_locks */ true);
+    write_in_flight_ = false;
+  }
+  return write_task_->GetResult();
+}
+
+}  // namespace art
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_LINKER_ASYNC_BUFFERED_OUTPUT_STREAM_H_
+#define ART_COMPILER_LINKER_ASYNC_BUFFERED_OUTPUT_STREAM_H_
+
+#include <memory>
+
+#include "output_stream.h"
+
+#include "globals.h"
+
+namespace art {
+
+class ThreadPool;
+
+// A buffered output stream writing its full buffers to the underlying stream from a worker
+// thread, while the caller fills the other buffer. There is at most one write in flight, so
+// the underlying stream sees the same writes, in the same order, as from the caller.
+// An error of the worker thread is returned by the next call, with its errno.
+//
+// Without a runtime thread to start the worker from, the buffers are written synchronously.
+class AsyncBufferedOutputStream FINAL : public OutputStream {
+ public:
+  explicit AsyncBufferedOutputStream(std::unique_ptr<OutputStream> out);
+
+  ~AsyncBufferedOutputStream() OVERRIDE;
+
+  bool WriteFully(const void* buffer, size_t byte_count) OVERRIDE;
+
+  off_t Seek(off_t offset, Whence whence) OVERRIDE;
+
+  bool Flush() OVERRIDE;
+
+ private:
+  class WriteTask;
+
+  static constexpr size_t kBufferSize = 256 * KB;
+
+  // Hand the current buffer to the worker thread, and switch to the other buffer.
+  bool StartWriteBuffer();
+
+  // Start writing the current buffer, and wait for all the writes to finish.
+  bool FlushBuffer();
+
+  // Wait for the write in flight, if any, and return false if it failed.
+  bool WaitForWrite();
+
+  std::unique_ptr<OutputStream> const out_;
+  std::unique_ptr<uint8_t[]> buffers_[2];
+  size_t current_buffer_;
+  size_t used_;
+  std::unique_ptr<WriteTask> write_task_;
+  std::unique_ptr<ThreadPool> thread_pool_;
+  bool write_in_flight_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncBufferedOutputStream);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_LINKER_ASYNC_BUFFERED_OUTPUT_STREAM_H_
@@ -14,9 +14,12 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "file_output_stream.h"
 #include "vector_output_stream.h"
 
+#include "async_buffered_output_stream.h"
 #include "base/unix_file/fd_file.h"
 #include "base/logging.h"
 #include "buffered_output_stream.h"
@@ -90,6 +93,44 @@ TEST_F(OutputStreamTest, Buffered) {
   CheckTestOutput(actual);
 }
 
+TEST_F(OutputStreamTest, AsyncBuffered) {
+  ScratchFile tmp;
+  {
+    AsyncBufferedOutputStream async_output_stream(
+        std::make_unique<FileOutputStream>(tmp.GetFile()));
+    SetOutputStream(async_output_stream);
+    GenerateTestOutput();
+  }
+  std::unique_ptr<File> in(OS::OpenFileForReading(tmp.GetFilename().c_str()));
+  EXPECT_TRUE(in.get() != nullptr);
+  std::vector<uint8_t> actual(in->GetLength());
+  bool readSuccess = in->ReadFully(&actual[0], actual.size());
+  EXPECT_TRUE(readSuccess);
+  CheckTestOutput(actual);
+}
+
+TEST_F(OutputStreamTest, AsyncBufferedLargeWrites) {
+  // Larger than the buffers, and written in pieces that do not fill them evenly.
+  std::vector<uint8_t> expected(3 * MB + 1);
+  for (size_t i = 0; i != expected.size(); ++i) {
+    expected[i] = static_cast<uint8_t>(i * 7);
+  }
+  std::vector<uint8_t> output;
+  {
+    AsyncBufferedOutputStream async_output_stream(
+        std::make_unique<VectorOutputStream>("test vector output", &output));
+    size_t offset = 0u;
+    for (size_t size = 1u; offset != expected.size(); size = size * 3u + 1u) {
+      size = std::min(size, expected.size() - offset);
+      ASSERT_TRUE(async_output_stream.WriteFully(&expected[offset], size));
+      offset += size;
+    }
+    EXPECT_EQ(static_cast<off_t>(expected.size()), async_output_stream.Seek(0, kSeekCurrent));
+    EXPECT_TRUE(async_output_stream.Flush());
+  }
+  EXPECT_TRUE(output == expected);
+}
+
 TEST_F(OutputStreamTest, Vector) {
   std::vector<uint8_t> output;
   VectorOutputStream output_stream("test vector output", &output);
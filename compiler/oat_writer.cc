@@ -16,6 +16,8 @@
 
 #include "oat_writer.h"
 
+#include <algorithm>
+
 #include <unistd.h>
 #include <zlib.h>
 
@@ -740,6 +742,164 @@ static bool HasQuickeningInfo(const CompiledMethod* method) {
   return method != nullptr && method->GetQuickCode().empty() && !method->GetVmapTable().empty();
 }
 
+// A method with compiled code, and where it is in the dex files and the oat classes.
+struct OatWriter::OrderedMethodData {
+  // The methods are laid out by increasing category, see LayoutCodeMethodVisitor.
+  uint32_t layout_category;
+  const DexFile* dex_file;
+  size_t class_def_index;
+  size_t oat_class_index;
+  size_t class_def_method_index;
+  size_t method_offsets_index;
+  uint32_t method_idx;
+  uint32_t access_flags;
+  const DexFile::CodeItem* code_item;
+};
+
+class OatWriter::OrderedMethodVisitor {
+ public:
+  OrderedMethodVisitor(OatWriter* writer, size_t offset)
+      : writer_(writer),
+        offset_(offset) {}
+
+  virtual bool VisitMethod(const OrderedMethodData& method) = 0;
+
+  // Called after the last method.
+  virtual bool VisitComplete() = 0;
+
+  size_t GetOffset() const {
+    return offset_;
+  }
+
+ protected:
+  virtual ~OrderedMethodVisitor() { }
+
+  OatWriter* const writer_;
+
+  // The offset is usually advanced for each visited method by the derived class.
+  size_t offset_;
+};
+
+// Collects the methods with compiled code in OatWriter::ordered_methods_, and sorts them by
+// their profile flags: the startup methods first, so that they share as few pages as
+// possible, then the hot methods and the post-startup methods, and the cold methods last.
+// The methods keep their dex order within a category, and without a profile, except that
+// the startup and hot methods are followed by the methods of the same category they call.
+class OatWriter::LayoutCodeMethodVisitor : public OatDexMethodVisitor {
+ public:
+  explicit LayoutCodeMethodVisitor(OatWriter* writer)
+      : OatDexMethodVisitor(writer, /* offset */ 0u),
+        profile_compilation_info_(writer->GetCompilerDriver()->GetProfileCompilationInfo()) {}
+
+  bool VisitMethod(size_t class_def_method_index, const ClassDataItemIterator& it) OVERRIDE {
+    OatClass* oat_class = &writer_->oat_classes_[oat_class_index_];
+    const CompiledMethod* compiled_method = oat_class->GetCompiledMethod(class_def_method_index);
+    if (HasCompiledCode(compiled_method)) {
+      uint32_t method_idx = it.GetMemberIndex();
+      writer_->ordered_methods_.push_back(OrderedMethodData {
+          GetLayoutCategory(MethodReference(dex_file_, method_idx)),
+          dex_file_,
+          class_def_index_,
+          oat_class_index_,
+          class_def_method_index,
+          method_offsets_index_,
+          method_idx,
+          it.GetMethodAccessFlags(),
+          it.GetMethodCodeItem() });
+      ++method_offsets_index_;
+    }
+    return true;
+  }
+
+  void SortOrderedMethods() {
+    std::stable_sort(writer_->ordered_methods_.begin(),
+                     writer_->ordered_methods_.end(),
+                     [](const OrderedMethodData& lhs, const OrderedMethodData& rhs) {
+                       return lhs.layout_category < rhs.layout_category;
+                     });
+    auto begin = writer_->ordered_methods_.begin();
+    auto end = writer_->ordered_methods_.end();
+    while (begin != end && begin->layout_category <= kLayoutCategoryHot) {
+      auto category_end = std::find_if(begin, end, [begin](const OrderedMethodData& method) {
+        return method.layout_category != begin->layout_category;
+      });
+      PlaceCalleesAfterCallers(begin, category_end);
+      begin = category_end;
+    }
+  }
+
+ private:
+  // Reorders the methods in [begin, end) in depth-first order of the relative calls between
+  // them, starting from the methods in their current order: each method is followed by the
+  // first method it calls that is not placed yet, so that the most frequent calls of the hot
+  // code stay within a page or a few cache lines.
+  void PlaceCalleesAfterCallers(dchecked_vector<OrderedMethodData>::iterator begin,
+                                dchecked_vector<OrderedMethodData>::iterator end) {
+    size_t size = std::distance(begin, end);
+    SafeMap<MethodReference, size_t, MethodReferenceComparator> method_indexes;
+    for (size_t i = 0; i != size; ++i) {
+      method_indexes.Put(MethodReference(begin[i].dex_file, begin[i].method_idx), i);
+    }
+    std::vector<OrderedMethodData> ordered;
+    ordered.reserve(size);
+    std::vector<bool> placed(size, false);
+    std::vector<size_t> worklist;
+    for (size_t i = 0; i != size; ++i) {
+      worklist.push_back(i);
+      while (!worklist.empty()) {
+        size_t index = worklist.back();
+        worklist.pop_back();
+        if (placed[index]) {
+          continue;
+        }
+        placed[index] = true;
+        const OrderedMethodData& method = begin[index];
+        ordered.push_back(method);
+        const CompiledMethod* compiled_method =
+            writer_->oat_classes_[method.oat_class_index].GetCompiledMethod(
+                method.class_def_method_index);
+        ArrayRef<const LinkerPatch> patches = compiled_method->GetPatches();
+        // Push the callees in reverse, to place them in the order of their calls.
+        for (auto it = patches.rbegin(); it != patches.rend(); ++it) {
+          if (it->GetType() == LinkerPatch::Type::kCallRelative) {
+            auto callee = method_indexes.find(it->TargetMethod());
+            if (callee != method_indexes.end() && !placed[callee->second]) {
+              worklist.push_back(callee->second);
+            }
+          }
+        }
+      }
+    }
+    DCHECK_EQ(ordered.size(), size);
+    std::copy(ordered.begin(), ordered.end(), begin);
+  }
+
+  enum LayoutCategory : uint32_t {
+    kLayoutCategoryStartup,
+    kLayoutCategoryHot,
+    kLayoutCategoryPostStartup,
+    kLayoutCategoryCold,
+  };
+
+  uint32_t GetLayoutCategory(const MethodReference& method_ref) const {
+    if (profile_compilation_info_ == nullptr) {
+      return kLayoutCategoryCold;
+    }
+    ProfileCompilationInfo::MethodHotness hotness =
+        profile_compilation_info_->GetMethodHotness(method_ref);
+    if (hotness.IsStartup()) {
+      return kLayoutCategoryStartup;
+    } else if (hotness.IsHot()) {
+      return kLayoutCategoryHot;
+    } else if (hotness.IsPostStartup()) {
+      return kLayoutCategoryPostStartup;
+    }
+    return kLayoutCategoryCold;
+  }
+
+  const ProfileCompilationInfo* const profile_compilation_info_;
+};
+
 class OatWriter::InitBssLayoutMethodVisitor : public DexMethodVisitor {
  public:
   explicit InitBssLayoutMethodVisitor(OatWriter* writer)
@@ -859,150 +1019,145 @@ class OatWriter::InitOatClassesMethodVisitor : public DexMethodVisitor {
   size_t compiled_methods_with_code_;
 };
 
-class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
+class OatWriter::InitCodeMethodVisitor : public OrderedMethodVisitor {
  public:
   InitCodeMethodVisitor(OatWriter* writer, size_t offset)
-      : OatDexMethodVisitor(writer, offset),
+      : OrderedMethodVisitor(writer, offset),
         debuggable_(writer->GetCompilerDriver()->GetCompilerOptions().GetDebuggable()) {
     writer_->absolute_patch_locations_.reserve(
         writer_->compiler_driver_->GetNonRelativeLinkerPatchCount());
   }
 
-  bool EndClass() OVERRIDE {
-    OatDexMethodVisitor::EndClass();
-    if (oat_class_index_ == writer_->oat_classes_.size()) {
-      offset_ = writer_->relative_patcher_->ReserveSpaceEnd(offset_);
-    }
+  bool VisitComplete() OVERRIDE {
+    offset_ = writer_->relative_patcher_->ReserveSpaceEnd(offset_);
     return true;
   }
 
-  bool VisitMethod(size_t class_def_method_index, const ClassDataItemIterator& it) OVERRIDE
+  bool VisitMethod(const OrderedMethodData& method) OVERRIDE
       REQUIRES_SHARED(Locks::mutator_lock_) {
-    OatClass* oat_class = &writer_->oat_classes_[oat_class_index_];
-    CompiledMethod* compiled_method = oat_class->GetCompiledMethod(class_def_method_index);
-
-    if (HasCompiledCode(compiled_method)) {
-      // Derived from CompiledMethod.
-      uint32_t quick_code_offset = 0;
-
-      ArrayRef<const uint8_t> quick_code = compiled_method->GetQuickCode();
-      uint32_t code_size = quick_code.size() * sizeof(uint8_t);
-      uint32_t thumb_offset = compiled_method->CodeDelta();
-
-      // Deduplicate code arrays if we are not producing debuggable code.
-      bool deduped = true;
-      MethodReference method_ref(dex_file_, it.GetMemberIndex());
-      if (debuggable_) {
-        quick_code_offset = writer_->relative_patcher_->GetOffset(method_ref);
-        if (quick_code_offset != 0u) {
-          // Duplicate methods, we want the same code for both of them so that the oat writer puts
-          // the same code in both ArtMethods so that we do not get different oat code at runtime.
-        } else {
-          quick_code_offset = NewQuickCodeOffset(compiled_method, it, thumb_offset);
-          deduped = false;
-        }
+    OatClass* oat_class = &writer_->oat_classes_[method.oat_class_index];
+    CompiledMethod* compiled_method = oat_class->GetCompiledMethod(method.class_def_method_index);
+
+    DCHECK(HasCompiledCode(compiled_method));
+    // Derived from CompiledMethod.
+    uint32_t quick_code_offset = 0;
+
+    ArrayRef<const uint8_t> quick_code = compiled_method->GetQuickCode();
+    uint32_t code_size = quick_code.size() * sizeof(uint8_t);
+    uint32_t thumb_offset = compiled_method->CodeDelta();
+
+    // Deduplicate code arrays if we are not producing debuggable code.
+    bool deduped = true;
+    MethodReference method_ref(method.dex_file, method.method_idx);
+    if (debuggable_) {
+      quick_code_offset = writer_->relative_patcher_->GetOffset(method_ref);
+      if (quick_code_offset != 0u) {
+        // Duplicate methods, we want the same code for both of them so that the oat writer puts
+        // the same code in both ArtMethods so that we do not get different oat code at runtime.
       } else {
-        quick_code_offset = dedupe_map_.GetOrCreate(
-            compiled_method,
-            [this, &deduped, compiled_method, &it, thumb_offset]() {
-              deduped = false;
-              return NewQuickCodeOffset(compiled_method, it, thumb_offset);
-            });
+        quick_code_offset = NewQuickCodeOffset(compiled_method, method_ref, thumb_offset);
+        deduped = false;
       }
-
-      if (code_size != 0) {
-        if (writer_->relative_patcher_->GetOffset(method_ref) != 0u) {
-          // TODO: Should this be a hard failure?
-          LOG(WARNING) << "Multiple definitions of "
-              << method_ref.dex_file->PrettyMethod(method_ref.dex_method_index)
-              << " offsets " << writer_->relative_patcher_->GetOffset(method_ref)
-              << " " << quick_code_offset;
-        } else {
-          writer_->relative_patcher_->SetOffset(method_ref, quick_code_offset);
-        }
+    } else {
+      quick_code_offset = dedupe_map_.GetOrCreate(
+          compiled_method,
+          [this, &deduped, compiled_method, &method_ref, thumb_offset]() {
+            deduped = false;
+            return NewQuickCodeOffset(compiled_method, method_ref, thumb_offset);
+          });
+    }
+
+    if (code_size != 0) {
+      if (writer_->relative_patcher_->GetOffset(method_ref) != 0u) {
+        // TODO: Should this be a hard failure?
+        LOG(WARNING) << "Multiple definitions of "
+            << method_ref.dex_file->PrettyMethod(method_ref.dex_method_index)
+            << " offsets " << writer_->relative_patcher_->GetOffset(method_ref)
+            << " " << quick_code_offset;
+      } else {
+        writer_->relative_patcher_->SetOffset(method_ref, quick_code_offset);
       }
+    }
 
-      // Update quick method header.
-      DCHECK_LT(method_offsets_index_, oat_class->method_headers_.size());
-      OatQuickMethodHeader* method_header = &oat_class->method_headers_[method_offsets_index_];
-      uint32_t vmap_table_offset = method_header->GetVmapTableOffset();
-      uint32_t method_info_offset = method_header->GetMethodInfoOffset();
-      // The code offset was 0 when the mapping/vmap table offset was set, so it's set
-      // to 0-offset and we need to adjust it by code_offset.
-      uint32_t code_offset = quick_code_offset - thumb_offset;
-      if (!compiled_method->GetQuickCode().empty()) {
-        // If the code is compiled, we write the offset of the stack map relative
-        // to the code,
-        if (vmap_table_offset != 0u) {
-          vmap_table_offset += code_offset;
-          DCHECK_LT(vmap_table_offset, code_offset);
-        }
-        if (method_info_offset != 0u) {
-          method_info_offset += code_offset;
-          DCHECK_LT(method_info_offset, code_offset);
-        }
-      } else {
-        CHECK(!kIsVdexEnabled);
-        // We write the offset of the quickening info relative to the code.
+    // Update quick method header.
+    DCHECK_LT(method.method_offsets_index, oat_class->method_headers_.size());
+    OatQuickMethodHeader* method_header =
+        &oat_class->method_headers_[method.method_offsets_index];
+    uint32_t vmap_table_offset = method_header->GetVmapTableOffset();
+    uint32_t method_info_offset = method_header->GetMethodInfoOffset();
+    // The code offset was 0 when the mapping/vmap table offset was set, so it's set
+    // to 0-offset and we need to adjust it by code_offset.
+    uint32_t code_offset = quick_code_offset - thumb_offset;
+    if (!compiled_method->GetQuickCode().empty()) {
+      // If the code is compiled, we write the offset of the stack map relative
+      // to the code,
+      if (vmap_table_offset != 0u) {
         vmap_table_offset += code_offset;
         DCHECK_LT(vmap_table_offset, code_offset);
       }
-      uint32_t frame_size_in_bytes = compiled_method->GetFrameSizeInBytes();
-      uint32_t core_spill_mask = compiled_method->GetCoreSpillMask();
-      uint32_t fp_spill_mask = compiled_method->GetFpSpillMask();
-      *method_header = OatQuickMethodHeader(vmap_table_offset,
-                                            method_info_offset,
-                                            frame_size_in_bytes,
-                                            core_spill_mask,
-                                            fp_spill_mask,
-                                            code_size);
-
-      if (!deduped) {
-        // Update offsets. (Checksum is updated when writing.)
-        offset_ += sizeof(*method_header);  // Method header is prepended before code.
-        offset_ += code_size;
-        // Record absolute patch locations.
-        if (!compiled_method->GetPatches().empty()) {
-          uintptr_t base_loc = offset_ - code_size - writer_->oat_header_->GetExecutableOffset();
-          for (const LinkerPatch& patch : compiled_method->GetPatches()) {
-            if (!patch.IsPcRelative()) {
-              writer_->absolute_patch_locations_.push_back(base_loc + patch.LiteralOffset());
-            }
+      if (method_info_offset != 0u) {
+        method_info_offset += code_offset;
+        DCHECK_LT(method_info_offset, code_offset);
+      }
+    } else {
+      CHECK(!kIsVdexEnabled);
+      // We write the offset of the quickening info relative to the code.
+      vmap_table_offset += code_offset;
+      DCHECK_LT(vmap_table_offset, code_offset);
+    }
+    uint32_t frame_size_in_bytes = compiled_method->GetFrameSizeInBytes();
+    uint32_t core_spill_mask = compiled_method->GetCoreSpillMask();
+    uint32_t fp_spill_mask = compiled_method->GetFpSpillMask();
+    *method_header = OatQuickMethodHeader(vmap_table_offset,
+                                          method_info_offset,
+                                          frame_size_in_bytes,
+                                          core_spill_mask,
+                                          fp_spill_mask,
+                                          code_size);
+
+    if (!deduped) {
+      // Update offsets. (Checksum is updated when writing.)
+      offset_ += sizeof(*method_header);  // Method header is prepended before code.
+      offset_ += code_size;
+      // Record absolute patch locations.
+      if (!compiled_method->GetPatches().empty()) {
+        uintptr_t base_loc = offset_ - code_size - writer_->oat_header_->GetExecutableOffset();
+        for (const LinkerPatch& patch : compiled_method->GetPatches()) {
+          if (!patch.IsPcRelative()) {
+            writer_->absolute_patch_locations_.push_back(base_loc + patch.LiteralOffset());
           }
         }
       }
-
-      const CompilerOptions& compiler_options = writer_->compiler_driver_->GetCompilerOptions();
-      // Exclude quickened dex methods (code_size == 0) since they have no native code.
-      if (compiler_options.GenerateAnyDebugInfo() && code_size != 0) {
-        bool has_code_info = method_header->IsOptimized();
-        // Record debug information for this function if we are doing that.
-        debug::MethodDebugInfo info = debug::MethodDebugInfo();
-        info.trampoline_name = nullptr;
-        info.dex_file = dex_file_;
-        info.class_def_index = class_def_index_;
-        info.dex_method_index = it.GetMemberIndex();
-        info.access_flags = it.GetMethodAccessFlags();
-        info.code_item = it.GetMethodCodeItem();
-        info.isa = compiled_method->GetInstructionSet();
-        info.deduped = deduped;
-        info.is_native_debuggable = compiler_options.GetNativeDebuggable();
-        info.is_optimized = method_header->IsOptimized();
-        info.is_code_address_text_relative = true;
-        info.code_address = code_offset - writer_->oat_header_->GetExecutableOffset();
-        info.code_size = code_size;
-        info.frame_size_in_bytes = compiled_method->GetFrameSizeInBytes();
-        info.code_info = has_code_info ? compiled_method->GetVmapTable().data() : nullptr;
-        info.cfi = compiled_method->GetCFIInfo();
-        writer_->method_info_.push_back(info);
-      }
-
-      DCHECK_LT(method_offsets_index_, oat_class->method_offsets_.size());
-      OatMethodOffsets* offsets = &oat_class->method_offsets_[method_offsets_index_];
-      offsets->code_offset_ = quick_code_offset;
-      ++method_offsets_index_;
     }
 
+    const CompilerOptions& compiler_options = writer_->compiler_driver_->GetCompilerOptions();
+    // Exclude quickened dex methods (code_size == 0) since they have no native code.
+    if (compiler_options.GenerateAnyDebugInfo() && code_size != 0) {
+      bool has_code_info = method_header->IsOptimized();
+      // Record debug information for this function if we are doing that.
+      debug::MethodDebugInfo info = debug::MethodDebugInfo();
+      info.trampoline_name = nullptr;
+      info.dex_file = method.dex_file;
+      info.class_def_index = method.class_def_index;
+      info.dex_method_index = method.method_idx;
+      info.access_flags = method.access_flags;
+      info.code_item = method.code_item;
+      info.isa = compiled_method->GetInstructionSet();
+      info.deduped = deduped;
+      info.is_native_debuggable = compiler_options.GetNativeDebuggable();
+      info.is_optimized = method_header->IsOptimized();
+      info.is_code_address_text_relative = true;
+      info.code_address = code_offset - writer_->oat_header_->GetExecutableOffset();
+      info.code_size = code_size;
+      info.frame_size_in_bytes = compiled_method->GetFrameSizeInBytes();
+      info.code_info = has_code_info ? compiled_method->GetVmapTable().data() : nullptr;
+      info.cfi = compiled_method->GetCFIInfo();
+      writer_->method_info_.push_back(info);
+    }
+
+    DCHECK_LT(method.method_offsets_index, oat_class->method_offsets_.size());
+    OatMethodOffsets* offsets = &oat_class->method_offsets_[method.method_offsets_index];
+    offsets->code_offset_ = quick_code_offset;
     return true;
   }
 
@@ -1028,10 +1183,9 @@ class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
   };
 
   uint32_t NewQuickCodeOffset(CompiledMethod* compiled_method,
-                              const ClassDataItemIterator& it,
+                              const MethodReference& method_ref,
                               uint32_t thumb_offset) {
-    offset_ = writer_->relative_patcher_->ReserveSpace(
-        offset_, compiled_method, MethodReference(dex_file_, it.GetMemberIndex()));
+    offset_ = writer_->relative_patcher_->ReserveSpace(offset_, compiled_method, method_ref);
     offset_ += CodeAlignmentSize(offset_, *compiled_method);
     DCHECK_ALIGNED_PARAM(offset_ + sizeof(OatQuickMethodHeader),
                          GetInstructionSetAlignment(compiled_method->GetInstructionSet()));
@@ -1271,11 +1425,11 @@ class OatWriter::InitImageMethodVisitor : public OatDexMethodVisitor {
   std::vector<std::pair<ArtMethod*, ArtMethod*>> methods_to_process_;
 };
 
-class OatWriter::WriteCodeMethodVisitor : public OatDexMethodVisitor {
+class OatWriter::WriteCodeMethodVisitor : public OrderedMethodVisitor {
  public:
   WriteCodeMethodVisitor(OatWriter* writer, OutputStream* out, const size_t file_offset,
                          size_t relative_offset) SHARED_LOCK_FUNCTION(Locks::mutator_lock_)
-      : OatDexMethodVisitor(writer, relative_offset),
+      : OrderedMethodVisitor(writer, relative_offset),
         pointer_size_(GetInstructionSetPointerSize(writer_->compiler_driver_->GetInstructionSet())),
         class_loader_(writer->HasImage() ? writer->image_writer_->GetClassLoader() : nullptr),
         out_(out),
@@ -1283,6 +1437,7 @@ class OatWriter::WriteCodeMethodVisitor : public OatDexMethodVisitor {
         soa_(Thread::Current()),
         no_thread_suspension_("OatWriter patching"),
         class_linker_(Runtime::Current()->GetClassLinker()),
+        dex_file_(nullptr),
         dex_cache_(nullptr) {
     patched_code_.reserve(16 * KB);
     if (writer_->HasBootImage()) {
@@ -1294,175 +1449,165 @@ class OatWriter::WriteCodeMethodVisitor : public OatDexMethodVisitor {
   ~WriteCodeMethodVisitor() UNLOCK_FUNCTION(Locks::mutator_lock_) {
   }
 
-  bool StartClass(const DexFile* dex_file, size_t class_def_index) OVERRIDE
-      REQUIRES_SHARED(Locks::mutator_lock_) {
-    OatDexMethodVisitor::StartClass(dex_file, class_def_index);
-    if (writer_->GetCompilerDriver()->GetCompilerOptions().IsAotCompilationEnabled()) {
-      // Only need to set the dex cache if we have compilation. Other modes might have unloaded it.
-      if (dex_cache_ == nullptr || dex_cache_->GetDexFile() != dex_file) {
-        dex_cache_ = class_linker_->FindDexCache(Thread::Current(), *dex_file);
-        DCHECK(dex_cache_ != nullptr);
-      }
+  bool VisitComplete() OVERRIDE {
+    offset_ = writer_->relative_patcher_->WriteThunks(out_, offset_);
+    if (UNLIKELY(offset_ == 0u)) {
+      PLOG(ERROR) << "Failed to write final relative call thunks";
+      return false;
     }
     return true;
   }
 
-  bool EndClass() OVERRIDE REQUIRES_SHARED(Locks::mutator_lock_) {
-    bool result = OatDexMethodVisitor::EndClass();
-    if (oat_class_index_ == writer_->oat_classes_.size()) {
-      DCHECK(result);  // OatDexMethodVisitor::EndClass() never fails.
-      offset_ = writer_->relative_patcher_->WriteThunks(out_, offset_);
-      if (UNLIKELY(offset_ == 0u)) {
-        PLOG(ERROR) << "Failed to write final relative call thunks";
-        result = false;
+  bool VisitMethod(const OrderedMethodData& method) OVERRIDE
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    dex_file_ = method.dex_file;
+    if (writer_->GetCompilerDriver()->GetCompilerOptions().IsAotCompilationEnabled()) {
+      // Only need to set the dex cache if we have compilation. Other modes might have unloaded it.
+      if (dex_cache_ == nullptr || dex_cache_->GetDexFile() != dex_file_) {
+        dex_cache_ = class_linker_->FindDexCache(Thread::Current(), *dex_file_);
+        DCHECK(dex_cache_ != nullptr);
       }
     }
-    return result;
-  }
-
-  bool VisitMethod(size_t class_def_method_index, const ClassDataItemIterator& it) OVERRIDE
-      REQUIRES_SHARED(Locks::mutator_lock_) {
-    OatClass* oat_class = &writer_->oat_classes_[oat_class_index_];
-    const CompiledMethod* compiled_method = oat_class->GetCompiledMethod(class_def_method_index);
+    OatClass* oat_class = &writer_->oat_classes_[method.oat_class_index];
+    const CompiledMethod* compiled_method =
+        oat_class->GetCompiledMethod(method.class_def_method_index);
 
     // No thread suspension since dex_cache_ that may get invalidated if that occurs.
     ScopedAssertNoThreadSuspension tsc(__FUNCTION__);
-    if (HasCompiledCode(compiled_method)) {
-      size_t file_offset = file_offset_;
-      OutputStream* out = out_;
-
-      ArrayRef<const uint8_t> quick_code = compiled_method->GetQuickCode();
-      uint32_t code_size = quick_code.size() * sizeof(uint8_t);
-
-      // Deduplicate code arrays.
-      const OatMethodOffsets& method_offsets = oat_class->method_offsets_[method_offsets_index_];
-      if (method_offsets.code_offset_ > offset_) {
-        offset_ = writer_->relative_patcher_->WriteThunks(out, offset_);
-        if (offset_ == 0u) {
-          ReportWriteFailure("relative call thunk", it);
-          return false;
-        }
-        uint32_t alignment_size = CodeAlignmentSize(offset_, *compiled_method);
-        if (alignment_size != 0) {
-          if (!writer_->WriteCodeAlignment(out, alignment_size)) {
-            ReportWriteFailure("code alignment padding", it);
-            return false;
-          }
-          offset_ += alignment_size;
-          DCHECK_OFFSET_();
-        }
-        DCHECK_ALIGNED_PARAM(offset_ + sizeof(OatQuickMethodHeader),
-                             GetInstructionSetAlignment(compiled_method->GetInstructionSet()));
-        DCHECK_EQ(method_offsets.code_offset_,
-                  offset_ + sizeof(OatQuickMethodHeader) + compiled_method->CodeDelta())
-            << dex_file_->PrettyMethod(it.GetMemberIndex());
-        const OatQuickMethodHeader& method_header =
-            oat_class->method_headers_[method_offsets_index_];
-        if (!out->WriteFully(&method_header, sizeof(method_header))) {
-          ReportWriteFailure("method header", it);
+    DCHECK(HasCompiledCode(compiled_method));
+    size_t file_offset = file_offset_;
+    OutputStream* out = out_;
+
+    ArrayRef<const uint8_t> quick_code = compiled_method->GetQuickCode();
+    uint32_t code_size = quick_code.size() * sizeof(uint8_t);
+
+    // Deduplicate code arrays.
+    const OatMethodOffsets& method_offsets =
+        oat_class->method_offsets_[method.method_offsets_index];
+    if (method_offsets.code_offset_ > offset_) {
+      offset_ = writer_->relative_patcher_->WriteThunks(out, offset_);
+      if (offset_ == 0u) {
+        ReportWriteFailure("relative call thunk", method);
+        return false;
+      }
+      uint32_t alignment_size = CodeAlignmentSize(offset_, *compiled_method);
+      if (alignment_size != 0) {
+        if (!writer_->WriteCodeAlignment(out, alignment_size)) {
+          ReportWriteFailure("code alignment padding", method);
           return false;
         }
-        writer_->size_method_header_ += sizeof(method_header);
-        offset_ += sizeof(method_header);
+        offset_ += alignment_size;
         DCHECK_OFFSET_();
+      }
+      DCHECK_ALIGNED_PARAM(offset_ + sizeof(OatQuickMethodHeader),
+                           GetInstructionSetAlignment(compiled_method->GetInstructionSet()));
+      DCHECK_EQ(method_offsets.code_offset_,
+                offset_ + sizeof(OatQuickMethodHeader) + compiled_method->CodeDelta())
+          << dex_file_->PrettyMethod(method.method_idx);
+      const OatQuickMethodHeader& method_header =
+          oat_class->method_headers_[method.method_offsets_index];
+      if (!out->WriteFully(&method_header, sizeof(method_header))) {
+        ReportWriteFailure("method header", method);
+        return false;
+      }
+      writer_->size_method_header_ += sizeof(method_header);
+      offset_ += sizeof(method_header);
+      DCHECK_OFFSET_();
 
-        if (!compiled_method->GetPatches().empty()) {
-          patched_code_.assign(quick_code.begin(), quick_code.end());
-          quick_code = ArrayRef<const uint8_t>(patched_code_);
-          for (const LinkerPatch& patch : compiled_method->GetPatches()) {
-            uint32_t literal_offset = patch.LiteralOffset();
-            switch (patch.GetType()) {
-              case LinkerPatch::Type::kMethodBssEntry: {
-                uint32_t target_offset =
-                    writer_->bss_start_ + writer_->bss_method_entries_.Get(patch.TargetMethod());
-                writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
-                                                                     patch,
-                                                                     offset_ + literal_offset,
-                                                                     target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kCallRelative: {
-                // NOTE: Relative calls across oat files are not supported.
-                uint32_t target_offset = GetTargetOffset(patch);
-                writer_->relative_patcher_->PatchCall(&patched_code_,
-                                                      literal_offset,
-                                                      offset_ + literal_offset,
-                                                      target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kStringRelative: {
-                uint32_t target_offset = GetTargetObjectOffset(GetTargetString(patch));
-                writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
-                                                                     patch,
-                                                                     offset_ + literal_offset,
-                                                                     target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kStringBssEntry: {
-                StringReference ref(patch.TargetStringDexFile(), patch.TargetStringIndex());
-                uint32_t target_offset =
-                    writer_->bss_start_ + writer_->bss_string_entries_.Get(ref);
-                writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
-                                                                     patch,
-                                                                     offset_ + literal_offset,
-                                                                     target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kTypeRelative: {
-                uint32_t target_offset = GetTargetObjectOffset(GetTargetType(patch));
-                writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
-                                                                     patch,
-                                                                     offset_ + literal_offset,
-                                                                     target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kTypeBssEntry: {
-                TypeReference ref(patch.TargetTypeDexFile(), patch.TargetTypeIndex());
-                uint32_t target_offset = writer_->bss_start_ + writer_->bss_type_entries_.Get(ref);
-                writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
-                                                                     patch,
-                                                                     offset_ + literal_offset,
-                                                                     target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kCall: {
-                uint32_t target_offset = GetTargetOffset(patch);
-                PatchCodeAddress(&patched_code_, literal_offset, target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kMethodRelative: {
-                uint32_t target_offset = GetTargetMethodOffset(GetTargetMethod(patch));
-                writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
-                                                                     patch,
-                                                                     offset_ + literal_offset,
-                                                                     target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kBakerReadBarrierBranch: {
-                writer_->relative_patcher_->PatchBakerReadBarrierBranch(&patched_code_,
-                                                                        patch,
-                                                                        offset_ + literal_offset);
-                break;
-              }
-              default: {
-                DCHECK(false) << "Unexpected linker patch type: " << patch.GetType();
-                break;
-              }
+      if (!compiled_method->GetPatches().empty()) {
+        patched_code_.assign(quick_code.begin(), quick_code.end());
+        quick_code = ArrayRef<const uint8_t>(patched_code_);
+        for (const LinkerPatch& patch : compiled_method->GetPatches()) {
+          uint32_t literal_offset = patch.LiteralOffset();
+          switch (patch.GetType()) {
+            case LinkerPatch::Type::kMethodBssEntry: {
+              uint32_t target_offset =
+                  writer_->bss_start_ + writer_->bss_method_entries_.Get(patch.TargetMethod());
+              writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
+                                                                   patch,
+                                                                   offset_ + literal_offset,
+                                                                   target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kCallRelative: {
+              // NOTE: Relative calls across oat files are not supported.
+              uint32_t target_offset = GetTargetOffset(patch);
+              writer_->relative_patcher_->PatchCall(&patched_code_,
+                                                    literal_offset,
+                                                    offset_ + literal_offset,
+                                                    target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kStringRelative: {
+              uint32_t target_offset = GetTargetObjectOffset(GetTargetString(patch));
+              writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
+                                                                   patch,
+                                                                   offset_ + literal_offset,
+                                                                   target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kStringBssEntry: {
+              StringReference ref(patch.TargetStringDexFile(), patch.TargetStringIndex());
+              uint32_t target_offset =
+                  writer_->bss_start_ + writer_->bss_string_entries_.Get(ref);
+              writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
+                                                                   patch,
+                                                                   offset_ + literal_offset,
+                                                                   target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kTypeRelative: {
+              uint32_t target_offset = GetTargetObjectOffset(GetTargetType(patch));
+              writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
+                                                                   patch,
+                                                                   offset_ + literal_offset,
+                                                                   target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kTypeBssEntry: {
+              TypeReference ref(patch.TargetTypeDexFile(), patch.TargetTypeIndex());
+              uint32_t target_offset = writer_->bss_start_ + writer_->bss_type_entries_.Get(ref);
+              writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
+                                                                   patch,
+                                                                   offset_ + literal_offset,
+                                                                   target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kCall: {
+              uint32_t target_offset = GetTargetOffset(patch);
+              PatchCodeAddress(&patched_code_, literal_offset, target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kMethodRelative: {
+              uint32_t target_offset = GetTargetMethodOffset(GetTargetMethod(patch));
+              writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
+                                                                   patch,
+                                                                   offset_ + literal_offset,
+                                                                   target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kBakerReadBarrierBranch: {
+              writer_->relative_patcher_->PatchBakerReadBarrierBranch(&patched_code_,
+                                                                      patch,
+                                                                      offset_ + literal_offset);
+              break;
+            }
+            default: {
+              DCHECK(false) << "Unexpected linker patch type: " << patch.GetType();
+              break;
             }
           }
         }
+      }
 
-        if (!out->WriteFully(quick_code.data(), code_size)) {
-          ReportWriteFailure("method code", it);
-          return false;
-        }
-        writer_->size_code_ += code_size;
-        offset_ += code_size;
+      if (!out->WriteFully(quick_code.data(), code_size)) {
+        ReportWriteFailure("method code", method);
+        return false;
       }
-      DCHECK_OFFSET_();
-      ++method_offsets_index_;
+      writer_->size_code_ += code_size;
+      offset_ += code_size;
     }
-
+    DCHECK_OFFSET_();
     return true;
   }
 
@@ -1474,12 +1619,13 @@ class OatWriter::WriteCodeMethodVisitor : public OatDexMethodVisitor {
   const ScopedObjectAccess soa_;
   const ScopedAssertNoThreadSuspension no_thread_suspension_;
   ClassLinker* const class_linker_;
+  const DexFile* dex_file_;
   ObjPtr<mirror::DexCache> dex_cache_;
   std::vector<uint8_t> patched_code_;
 
-  void ReportWriteFailure(const char* what, const ClassDataItemIterator& it) {
+  void ReportWriteFailure(const char* what, const OrderedMethodData& method) {
     PLOG(ERROR) << "Failed to write " << what << " for "
-        << dex_file_->PrettyMethod(it.GetMemberIndex()) << " to " << out_->GetLocation();
+        << method.dex_file->PrettyMethod(method.method_idx) << " to " << out_->GetLocation();
   }
 
   ArtMethod* GetTargetMethod(const LinkerPatch& patch)
@@ -1763,6 +1909,19 @@ bool OatWriter::VisitDexMethods(DexMethodVisitor* visitor) {
   return true;
 }
 
+bool OatWriter::VisitOrderedMethods(OrderedMethodVisitor* visitor) {
+  for (const OrderedMethodData& method : ordered_methods_) {
+    if (UNLIKELY(!visitor->VisitMethod(method))) {
+      return false;
+    }
+  }
+  // There are no oat classes if there aren't any compiled methods.
+  if (!oat_classes_.empty() && UNLIKELY(!visitor->VisitComplete())) {
+    return false;
+  }
+  return true;
+}
+
 size_t OatWriter::InitOatHeader(InstructionSet instruction_set,
                                 const InstructionSetFeatures* instruction_set_features,
                                 uint32_t num_dex_files,
@@ -1917,8 +2076,16 @@ size_t OatWriter::InitOatCodeDexFiles(size_t offset) {
   if (!compiler_driver_->GetCompilerOptions().IsAnyCompilationEnabled()) {
     return offset;
   }
+  {
+    TimingLogger::ScopedTiming split("LayoutCode", timings_);
+    LayoutCodeMethodVisitor layout_visitor(this);
+    bool success = VisitDexMethods(&layout_visitor);
+    DCHECK(success);
+    layout_visitor.SortOrderedMethods();
+  }
+
   InitCodeMethodVisitor code_visitor(this, offset);
-  bool success = VisitDexMethods(&code_visitor);
+  bool success = VisitOrderedMethods(&code_visitor);
   DCHECK(success);
   offset = code_visitor.GetOffset();
 
@@ -2108,6 +2275,9 @@ class OatWriter::WriteQuickeningIndicesMethodVisitor {
       // Record the offset for this current dex file. It will be written in the vdex file
       // later.
       dex_files_offset_->push_back(indices_offset_ + GetNumberOfWrittenBytes());
+      // Pairs of code item offset and quickening info offset, sorted by code item offset and
+      // written once per code item, for the runtime to binary search them.
+      std::vector<std::pair<uint32_t, uint32_t>> entries;
       const size_t class_def_count = dex_file->NumClassDefs();
       for (size_t class_def_index = 0; class_def_index != class_def_count; ++class_def_index) {
         const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
@@ -2127,17 +2297,27 @@ class OatWriter::WriteQuickeningIndicesMethodVisitor {
           if (HasQuickeningInfo(compiled_method)) {
             uint32_t code_item_offset = class_it.GetMethodCodeItemOffset();
             uint32_t offset = offset_map_.Get(compiled_method->GetVmapTable().data());
-            if (!out_->WriteFully(&code_item_offset, sizeof(code_item_offset)) ||
-                !out_->WriteFully(&offset, sizeof(offset))) {
-              PLOG(ERROR) << "Failed to write quickening info for "
-                          << dex_file->PrettyMethod(method_idx) << " to "
-                          << out_->GetLocation();
-              return false;
-            }
-            written_bytes_ += sizeof(code_item_offset) + sizeof(offset);
+            entries.emplace_back(code_item_offset, offset);
           }
         }
       }
+      std::sort(entries.begin(), entries.end());
+      auto last = std::unique(entries.begin(),
+                              entries.end(),
+                              [](const std::pair<uint32_t, uint32_t>& lhs,
+                                 const std::pair<uint32_t, uint32_t>& rhs) {
+                                return lhs.first == rhs.first;
+                              });
+      entries.erase(last, entries.end());
+      for (const std::pair<uint32_t, uint32_t>& entry : entries) {
+        if (!out_->WriteFully(&entry.first, sizeof(entry.first)) ||
+            !out_->WriteFully(&entry.second, sizeof(entry.second))) {
+          PLOG(ERROR) << "Failed to write quickening info indices for "
+                      << dex_file->GetLocation() << " to " << out_->GetLocation();
+          return false;
+        }
+        written_bytes_ += sizeof(entry.first) + sizeof(entry.second);
+      }
     }
     return true;
   }
@@ -2599,7 +2779,7 @@ size_t OatWriter::WriteCodeDexFiles(OutputStream* out,
   #define VISIT(VisitorType)                                              \
     do {                                                                  \
       VisitorType visitor(this, out, file_offset, relative_offset);       \
-      if (UNLIKELY(!VisitDexMethods(&visitor))) {                         \
+      if (UNLIKELY(!VisitOrderedMethods(&visitor))) {                     \
         return 0;                                                         \
       }                                                                   \
       relative_offset = visitor.GetOffset();                              \
@@ -2817,6 +2997,7 @@ bool OatWriter::LayoutAndWriteDexFile(OutputStream* out, OatDexFile* oat_dex_fil
   }
   Options options;
   options.output_to_memmap_ = true;
+  options.dedupe_debug_info_ = true;
   DexLayout dex_layout(options, profile_compilation_info_, nullptr);
   dex_layout.ProcessDexFile(location.c_str(), dex_file.get(), 0);
   std::unique_ptr<MemMap> mem_map(dex_layout.GetAndReleaseMemMap());
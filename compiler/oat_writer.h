@@ -268,10 +268,19 @@ class OatWriter {
   class WriteQuickeningInfoMethodVisitor;
   class WriteQuickeningIndicesMethodVisitor;
 
+  // The code of the methods is laid out and written in the order of ordered_methods_,
+  // by the OrderedMethodVisitor classes.
+  struct OrderedMethodData;
+  class OrderedMethodVisitor;
+  class LayoutCodeMethodVisitor;
+
   // Visit all the methods in all the compiled dex files in their definition order
   // with a given DexMethodVisitor.
   bool VisitDexMethods(DexMethodVisitor* visitor);
 
+  // Visit the methods with compiled code in the order of their code in the oat file.
+  bool VisitOrderedMethods(OrderedMethodVisitor* visitor);
+
   // If `update_input_vdex` is true, then this method won't actually write the dex files,
   // and the compiler will just re-use the existing vdex file.
   bool WriteDexFiles(OutputStream* out, File* file, bool update_input_vdex);
@@ -355,6 +364,9 @@ class OatWriter {
 
   dchecked_vector<debug::MethodDebugInfo> method_info_;
 
+  // The methods with compiled code, startup methods first and cold methods last.
+  dchecked_vector<OrderedMethodData> ordered_methods_;
+
   const CompilerDriver* compiler_driver_;
   ImageWriter* image_writer_;
   const bool compiling_boot_image_;
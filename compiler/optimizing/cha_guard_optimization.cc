@@ -176,13 +176,19 @@ bool CHAGuardVisitor::HoistGuard(HShouldDeoptimizeFlag* flag,
   // If receiver is loop invariant, we can hoist the guard out of the
   // loop since passing a guard before entering the loop guarantees that
   // receiver conforms to all the CHA devirtualization assumptions.
-  // We only hoist guards out of the inner loop since that offers most of the
-  // benefit and it might help remove other guards in the inner loop.
+  // The guard goes out of as many enclosing loops as receiver is invariant
+  // in, so that it is only checked when entering the loop nest: the inner
+  // loops are then left without guards for the loop optimizations to handle.
   HBasicBlock* block = flag->GetBlock();
   HLoopInformation* loop_info = block->GetLoopInformation();
   if (loop_info != nullptr &&
       !loop_info->IsIrreducible() &&
       loop_info->IsDefinedOutOfTheLoop(receiver)) {
+    for (HLoopInformation* outer = loop_info->GetPreHeader()->GetLoopInformation();
+         outer != nullptr && !outer->IsIrreducible() && outer->IsDefinedOutOfTheLoop(receiver);
+         outer = outer->GetPreHeader()->GetLoopInformation()) {
+      loop_info = outer;
+    }
     HInstruction* compare = flag->GetNext();
     DCHECK(compare->IsNotEqual());
     HInstruction* deopt = compare->GetNext();
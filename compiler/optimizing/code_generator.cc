@@ -731,7 +731,8 @@ static void CheckLoopEntriesCanBeUsedForOsr(const HGraph& graph,
     //neeraj - resolve dex2oat crash by checking "SuspendCheck" in "LoopInformation"
     if (block->IsLoopHeader() && block->GetLoopInformation()->HasSuspendCheck()) {
       HSuspendCheck* suspend_check = block->GetLoopInformation()->GetSuspendCheck();
-      if (!suspend_check->GetEnvironment()->IsFromInlinedInvoke()) {
+      if (!suspend_check->GetEnvironment()->IsFromInlinedInvoke() &&
+          suspend_check->CanBeOsrEntry()) {
         loop_headers.push_back(suspend_check);
       }
     }
@@ -867,6 +868,7 @@ void CodeGenerator::RecordPcInfo(HInstruction* instruction,
 
   HLoopInformation* info = instruction->GetBlock()->GetLoopInformation();
   if (instruction->IsSuspendCheck() &&
+      instruction->AsSuspendCheck()->CanBeOsrEntry() &&
       (info != nullptr) &&
       graph_->IsCompilingOsr() &&
       (inlining_depth == 0)) {
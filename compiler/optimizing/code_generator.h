@@ -417,6 +417,21 @@ class CodeGenerator : public DeletableArenaObject<kArenaAllocCodeGenerator> {
     return type == Primitive::kPrimNot && !value->IsNullConstant();
   }
 
+  // Like StoreNeedsWriteBarrier(), for an instance or static field store, which may not
+  // need a card mark when storing into a new object.
+  // Was the read barrier of the reference load `load` elided, the GC not marking where it
+  // runs? Only instance field and array loads are considered.
+  static bool IsReadBarrierElided(HInstruction* load) {
+    return (load->IsInstanceFieldGet() && load->AsInstanceFieldGet()->IsReadBarrierElided()) ||
+        (load->IsArrayGet() && load->AsArrayGet()->IsReadBarrierElided());
+  }
+
+  static bool FieldStoreNeedsWriteBarrier(HInstruction* field_set, Primitive::Type type) {
+    return StoreNeedsWriteBarrier(type, field_set->InputAt(1)) &&
+        !(field_set->IsInstanceFieldSet() &&
+          field_set->AsInstanceFieldSet()->IsWriteBarrierElided());
+  }
+
 
   // Performs checks pertaining to an InvokeRuntime call.
   void ValidateInvokeRuntime(QuickEntrypointEnum entrypoint,
@@ -23,6 +23,12 @@ namespace x86 {
 // NOLINT on __ macro to suppress wrong warning/fix (misc-macro-parentheses) from clang-tidy.
 #define __ down_cast<X86Assembler*>(GetAssembler())->  // NOLINT
 
+// Whether the vector operation uses the 256-bit YMM registers of AVX2. The 128-bit
+// code below keeps using the legacy SSE encodings.
+static bool Is256BitVector(HVecOperation* instruction) {
+  return instruction->GetVectorNumberOfBytes() == 32u;
+}
+
 void LocationsBuilderX86::VisitVecReplicateScalar(HVecReplicateScalar* instruction) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
   switch (instruction->GetPackedType()) {
@@ -52,6 +58,49 @@ void LocationsBuilderX86::VisitVecReplicateScalar(HVecReplicateScalar* instructi
 void InstructionCodeGeneratorX86::VisitVecReplicateScalar(HVecReplicateScalar* instruction) {
   LocationSummary* locations = instruction->GetLocations();
   XmmRegister reg = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+        DCHECK_EQ(32u, instruction->GetVectorLength());
+        __ vmovd(reg, locations->InAt(0).AsRegister<Register>());
+        __ vpbroadcastb(reg, reg);
+        return;
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+        DCHECK_EQ(16u, instruction->GetVectorLength());
+        __ vmovd(reg, locations->InAt(0).AsRegister<Register>());
+        __ vpbroadcastw(reg, reg);
+        return;
+      case Primitive::kPrimInt:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vmovd(reg, locations->InAt(0).AsRegister<Register>());
+        __ vpbroadcastd(reg, reg);
+        return;
+      case Primitive::kPrimLong: {
+        XmmRegister tmp = locations->GetTemp(0).AsFpuRegister<XmmRegister>();
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vmovd(reg, locations->InAt(0).AsRegisterPairLow<Register>());
+        __ vmovd(tmp, locations->InAt(0).AsRegisterPairHigh<Register>());
+        __ punpckldq(reg, tmp);
+        __ vpbroadcastq(reg, reg);
+        return;
+      }
+      case Primitive::kPrimFloat:
+        DCHECK(locations->InAt(0).Equals(locations->Out()));
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vbroadcastss(reg, reg);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK(locations->InAt(0).Equals(locations->Out()));
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vbroadcastsd(reg, reg);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
@@ -99,19 +148,139 @@ void InstructionCodeGeneratorX86::VisitVecReplicateScalar(HVecReplicateScalar* i
 }
 
 void LocationsBuilderX86::VisitVecSetScalars(HVecSetScalars* instruction) {
-  LOG(FATAL) << "No SIMD for " << instruction->GetId();
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  DCHECK_EQ(1u, instruction->InputCount());  // only one input currently implemented
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimLong:
+      // Long needs extra temporary to load the register pair.
+      locations->AddTemp(Location::RequiresFpuRegister());
+      FALLTHROUGH_INTENDED;
+    case Primitive::kPrimInt:
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetOut(Location::RequiresFpuRegister());
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type";
+      UNREACHABLE();
+  }
 }
 
 void InstructionCodeGeneratorX86::VisitVecSetScalars(HVecSetScalars* instruction) {
-  LOG(FATAL) << "No SIMD for " << instruction->GetId();
+  LocationSummary* locations = instruction->GetLocations();
+  XmmRegister reg = locations->Out().AsFpuRegister<XmmRegister>();
+  DCHECK_EQ(1u, instruction->InputCount());  // only one input currently implemented
+  // Set the first lane, zeroing all the others (the VEX form also zeroes the upper 128 bits).
+  bool is_256 = Is256BitVector(instruction);
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimInt:
+      DCHECK_EQ(is_256 ? 8u : 4u, instruction->GetVectorLength());
+      if (is_256) {
+        __ vmovd(reg, locations->InAt(0).AsRegister<Register>());
+      } else {
+        __ movd(reg, locations->InAt(0).AsRegister<Register>());
+      }
+      break;
+    case Primitive::kPrimLong: {
+      XmmRegister tmp = locations->GetTemp(0).AsFpuRegister<XmmRegister>();
+      DCHECK_EQ(is_256 ? 4u : 2u, instruction->GetVectorLength());
+      if (is_256) {
+        __ vmovd(reg, locations->InAt(0).AsRegisterPairLow<Register>());
+        __ vmovd(tmp, locations->InAt(0).AsRegisterPairHigh<Register>());
+      } else {
+        __ movd(reg, locations->InAt(0).AsRegisterPairLow<Register>());
+        __ movd(tmp, locations->InAt(0).AsRegisterPairHigh<Register>());
+      }
+      __ punpckldq(reg, tmp);
+      break;
+    }
+    default:
+      LOG(FATAL) << "Unsupported SIMD type";
+      UNREACHABLE();
+  }
 }
 
-void LocationsBuilderX86::VisitVecSumReduce(HVecSumReduce* instruction) {
-  LOG(FATAL) << "No SIMD for " << instruction->GetId();
+void LocationsBuilderX86::VisitVecReduce(HVecReduce* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+      locations->SetInAt(0, Location::RequiresFpuRegister());
+      locations->AddTemp(Location::RequiresFpuRegister());
+      locations->AddTemp(Location::RequiresFpuRegister());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type";
+      UNREACHABLE();
+  }
+}
+
+// Helper to combine the lanes of src into the lanes of dst, for a reduction step.
+static void GenerateReduceLanes(X86Assembler* assembler,
+                                HVecReduce* instruction,
+                                XmmRegister dst,
+                                XmmRegister src) {
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimInt:
+      switch (instruction->GetKind()) {
+        case HVecReduce::kSum:
+          assembler->paddd(dst, src);
+          return;
+        case HVecReduce::kMin:
+          assembler->pminsd(dst, src);
+          return;
+        case HVecReduce::kMax:
+          assembler->pmaxsd(dst, src);
+          return;
+      }
+      break;
+    case Primitive::kPrimLong:
+      if (instruction->GetKind() == HVecReduce::kSum) {
+        assembler->paddq(dst, src);
+        return;
+      }
+      break;
+    default:
+      break;
+  }
+  LOG(FATAL) << "Unsupported SIMD reduction";
+  UNREACHABLE();
 }
 
-void InstructionCodeGeneratorX86::VisitVecSumReduce(HVecSumReduce* instruction) {
-  LOG(FATAL) << "No SIMD for " << instruction->GetId();
+void InstructionCodeGeneratorX86::VisitVecReduce(HVecReduce* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  XmmRegister src = locations->InAt(0).AsFpuRegister<XmmRegister>();
+  XmmRegister tmp = locations->GetTemp(0).AsFpuRegister<XmmRegister>();
+  XmmRegister tmp2 = locations->GetTemp(1).AsFpuRegister<XmmRegister>();
+  X86Assembler* assembler = down_cast<X86Assembler*>(GetAssembler());
+  // Fold the upper half of the lanes onto the lower half until a single lane is
+  // left in tmp: the upper 128 bits first for YMM, then 64 bits, then 32 bits.
+  if (Is256BitVector(instruction)) {
+    __ vextracti128(tmp, src, Immediate(1));
+    GenerateReduceLanes(assembler, instruction, tmp, src);
+    __ pshufd(tmp2, tmp, Immediate(0x4E));
+    GenerateReduceLanes(assembler, instruction, tmp, tmp2);
+  } else {
+    __ pshufd(tmp, src, Immediate(0x4E));
+    GenerateReduceLanes(assembler, instruction, tmp, src);
+  }
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimInt:
+      DCHECK_EQ(Is256BitVector(instruction) ? 8u : 4u, instruction->GetVectorLength());
+      __ pshufd(tmp2, tmp, Immediate(0xB1));
+      GenerateReduceLanes(assembler, instruction, tmp, tmp2);
+      __ movd(locations->Out().AsRegister<Register>(), tmp);
+      break;
+    case Primitive::kPrimLong:
+      DCHECK_EQ(Is256BitVector(instruction) ? 4u : 2u, instruction->GetVectorLength());
+      __ movd(locations->Out().AsRegisterPairLow<Register>(), tmp);
+      __ psrlq(tmp, Immediate(32));
+      __ movd(locations->Out().AsRegisterPairHigh<Register>(), tmp);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type";
+      UNREACHABLE();
+  }
 }
 
 // Helper to set up locations for vector unary operations.
@@ -146,8 +315,13 @@ void InstructionCodeGeneratorX86::VisitVecCnv(HVecCnv* instruction) {
   Primitive::Type from = instruction->GetInputType();
   Primitive::Type to = instruction->GetResultType();
   if (from == Primitive::kPrimInt && to == Primitive::kPrimFloat) {
-    DCHECK_EQ(4u, instruction->GetVectorLength());
-    __ cvtdq2ps(dst, src);
+    if (Is256BitVector(instruction)) {
+      DCHECK_EQ(8u, instruction->GetVectorLength());
+      __ vcvtdq2ps(dst, src);
+    } else {
+      DCHECK_EQ(4u, instruction->GetVectorLength());
+      __ cvtdq2ps(dst, src);
+    }
   } else {
     LOG(FATAL) << "Unsupported SIMD type";
   }
@@ -161,6 +335,44 @@ void InstructionCodeGeneratorX86::VisitVecNeg(HVecNeg* instruction) {
   LocationSummary* locations = instruction->GetLocations();
   XmmRegister src = locations->InAt(0).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimByte:
+        DCHECK_EQ(32u, instruction->GetVectorLength());
+        __ vpxor(dst, dst, dst);
+        __ vpsubb(dst, dst, src);
+        return;
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+        DCHECK_EQ(16u, instruction->GetVectorLength());
+        __ vpxor(dst, dst, dst);
+        __ vpsubw(dst, dst, src);
+        return;
+      case Primitive::kPrimInt:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vpxor(dst, dst, dst);
+        __ vpsubd(dst, dst, src);
+        return;
+      case Primitive::kPrimLong:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vpxor(dst, dst, dst);
+        __ vpsubq(dst, dst, src);
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vxorps(dst, dst, dst);
+        __ vsubps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vxorpd(dst, dst, dst);
+        __ vsubpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimByte:
       DCHECK_EQ(16u, instruction->GetVectorLength());
@@ -211,6 +423,29 @@ void InstructionCodeGeneratorX86::VisitVecAbs(HVecAbs* instruction) {
   LocationSummary* locations = instruction->GetLocations();
   XmmRegister src = locations->InAt(0).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimInt:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vpabsd(dst, src);
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vpcmpeqb(dst, dst, dst);  // all ones
+        __ vpsrld(dst, dst, Immediate(1));
+        __ vandps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vpcmpeqb(dst, dst, dst);  // all ones
+        __ vpsrlq(dst, dst, Immediate(1));
+        __ vandpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimInt: {
       DCHECK_EQ(4u, instruction->GetVectorLength());
@@ -252,6 +487,42 @@ void InstructionCodeGeneratorX86::VisitVecNot(HVecNot* instruction) {
   LocationSummary* locations = instruction->GetLocations();
   XmmRegister src = locations->InAt(0).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimBoolean: {  // special case boolean-not
+        DCHECK_EQ(32u, instruction->GetVectorLength());
+        XmmRegister tmp = locations->GetTemp(0).AsFpuRegister<XmmRegister>();
+        __ vpxor(dst, dst, dst);
+        __ vpcmpeqb(tmp, tmp, tmp);  // all ones
+        __ vpsubb(dst, dst, tmp);  // 32 x one
+        __ vpxor(dst, dst, src);
+        return;
+      }
+      case Primitive::kPrimByte:
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimLong:
+        DCHECK_LE(4u, instruction->GetVectorLength());
+        DCHECK_LE(instruction->GetVectorLength(), 32u);
+        __ vpcmpeqb(dst, dst, dst);  // all ones
+        __ vpxor(dst, dst, src);
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vpcmpeqb(dst, dst, dst);  // all ones
+        __ vxorps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vpcmpeqb(dst, dst, dst);  // all ones
+        __ vxorpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimBoolean: {  // special case boolean-not
       DCHECK_EQ(16u, instruction->GetVectorLength());
@@ -319,6 +590,38 @@ void InstructionCodeGeneratorX86::VisitVecAdd(HVecAdd* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimByte:
+        DCHECK_EQ(32u, instruction->GetVectorLength());
+        __ vpaddb(dst, dst, src);
+        return;
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+        DCHECK_EQ(16u, instruction->GetVectorLength());
+        __ vpaddw(dst, dst, src);
+        return;
+      case Primitive::kPrimInt:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vpaddd(dst, dst, src);
+        return;
+      case Primitive::kPrimLong:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vpaddq(dst, dst, src);
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vaddps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vaddpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimByte:
       DCHECK_EQ(16u, instruction->GetVectorLength());
@@ -364,6 +667,22 @@ void InstructionCodeGeneratorX86::VisitVecHalvingAdd(HVecHalvingAdd* instruction
   DCHECK(instruction->IsRounded());
   DCHECK(instruction->IsUnsigned());
 
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimByte:
+        DCHECK_EQ(32u, instruction->GetVectorLength());
+        __ vpavgb(dst, dst, src);
+        return;
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+        DCHECK_EQ(16u, instruction->GetVectorLength());
+        __ vpavgw(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimByte:
       DCHECK_EQ(16u, instruction->GetVectorLength());
@@ -389,6 +708,38 @@ void InstructionCodeGeneratorX86::VisitVecSub(HVecSub* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimByte:
+        DCHECK_EQ(32u, instruction->GetVectorLength());
+        __ vpsubb(dst, dst, src);
+        return;
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+        DCHECK_EQ(16u, instruction->GetVectorLength());
+        __ vpsubw(dst, dst, src);
+        return;
+      case Primitive::kPrimInt:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vpsubd(dst, dst, src);
+        return;
+      case Primitive::kPrimLong:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vpsubq(dst, dst, src);
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vsubps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vsubpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimByte:
       DCHECK_EQ(16u, instruction->GetVectorLength());
@@ -430,6 +781,30 @@ void InstructionCodeGeneratorX86::VisitVecMul(HVecMul* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+        DCHECK_EQ(16u, instruction->GetVectorLength());
+        __ vpmullw(dst, dst, src);
+        return;
+      case Primitive::kPrimInt:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vpmulld(dst, dst, src);
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vmulps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vmulpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
@@ -463,6 +838,21 @@ void InstructionCodeGeneratorX86::VisitVecDiv(HVecDiv* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vdivps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vdivpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimFloat:
       DCHECK_EQ(4u, instruction->GetVectorLength());
@@ -487,6 +877,48 @@ void InstructionCodeGeneratorX86::VisitVecMin(HVecMin* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimByte:
+        DCHECK_EQ(32u, instruction->GetVectorLength());
+        if (instruction->IsUnsigned()) {
+          __ vpminub(dst, dst, src);
+        } else {
+          __ vpminsb(dst, dst, src);
+        }
+        return;
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+        DCHECK_EQ(16u, instruction->GetVectorLength());
+        if (instruction->IsUnsigned()) {
+          __ vpminuw(dst, dst, src);
+        } else {
+          __ vpminsw(dst, dst, src);
+        }
+        return;
+      case Primitive::kPrimInt:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        if (instruction->IsUnsigned()) {
+          __ vpminud(dst, dst, src);
+        } else {
+          __ vpminsd(dst, dst, src);
+        }
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        DCHECK(!instruction->IsUnsigned());
+        __ vminps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        DCHECK(!instruction->IsUnsigned());
+        __ vminpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimByte:
       DCHECK_EQ(16u, instruction->GetVectorLength());
@@ -539,6 +971,48 @@ void InstructionCodeGeneratorX86::VisitVecMax(HVecMax* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimByte:
+        DCHECK_EQ(32u, instruction->GetVectorLength());
+        if (instruction->IsUnsigned()) {
+          __ vpmaxub(dst, dst, src);
+        } else {
+          __ vpmaxsb(dst, dst, src);
+        }
+        return;
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+        DCHECK_EQ(16u, instruction->GetVectorLength());
+        if (instruction->IsUnsigned()) {
+          __ vpmaxuw(dst, dst, src);
+        } else {
+          __ vpmaxsw(dst, dst, src);
+        }
+        return;
+      case Primitive::kPrimInt:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        if (instruction->IsUnsigned()) {
+          __ vpmaxud(dst, dst, src);
+        } else {
+          __ vpmaxsd(dst, dst, src);
+        }
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        DCHECK(!instruction->IsUnsigned());
+        __ vmaxps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        DCHECK(!instruction->IsUnsigned());
+        __ vmaxpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimByte:
       DCHECK_EQ(16u, instruction->GetVectorLength());
@@ -591,6 +1065,31 @@ void InstructionCodeGeneratorX86::VisitVecAnd(HVecAnd* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimLong:
+        DCHECK_LE(4u, instruction->GetVectorLength());
+        DCHECK_LE(instruction->GetVectorLength(), 32u);
+        __ vpand(dst, dst, src);
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vandps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vandpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
@@ -625,6 +1124,31 @@ void InstructionCodeGeneratorX86::VisitVecAndNot(HVecAndNot* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimLong:
+        DCHECK_LE(4u, instruction->GetVectorLength());
+        DCHECK_LE(instruction->GetVectorLength(), 32u);
+        __ vpandn(dst, dst, src);
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vandnps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vandnpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
@@ -659,6 +1183,31 @@ void InstructionCodeGeneratorX86::VisitVecOr(HVecOr* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimLong:
+        DCHECK_LE(4u, instruction->GetVectorLength());
+        DCHECK_LE(instruction->GetVectorLength(), 32u);
+        __ vpor(dst, dst, src);
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vorps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vorpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
@@ -693,6 +1242,31 @@ void InstructionCodeGeneratorX86::VisitVecXor(HVecXor* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimLong:
+        DCHECK_LE(4u, instruction->GetVectorLength());
+        DCHECK_LE(instruction->GetVectorLength(), 32u);
+        __ vpxor(dst, dst, src);
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vxorps(dst, dst, src);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vxorpd(dst, dst, src);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
@@ -745,6 +1319,26 @@ void InstructionCodeGeneratorX86::VisitVecShl(HVecShl* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   int32_t value = locations->InAt(1).GetConstant()->AsIntConstant()->GetValue();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+        DCHECK_EQ(16u, instruction->GetVectorLength());
+        __ vpsllw(dst, dst, Immediate(static_cast<uint8_t>(value)));
+        return;
+      case Primitive::kPrimInt:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vpslld(dst, dst, Immediate(static_cast<uint8_t>(value)));
+        return;
+      case Primitive::kPrimLong:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vpsllq(dst, dst, Immediate(static_cast<uint8_t>(value)));
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
@@ -774,6 +1368,22 @@ void InstructionCodeGeneratorX86::VisitVecShr(HVecShr* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   int32_t value = locations->InAt(1).GetConstant()->AsIntConstant()->GetValue();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+        DCHECK_EQ(16u, instruction->GetVectorLength());
+        __ vpsraw(dst, dst, Immediate(static_cast<uint8_t>(value)));
+        return;
+      case Primitive::kPrimInt:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vpsrad(dst, dst, Immediate(static_cast<uint8_t>(value)));
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
@@ -799,6 +1409,26 @@ void InstructionCodeGeneratorX86::VisitVecUShr(HVecUShr* instruction) {
   DCHECK(locations->InAt(0).Equals(locations->Out()));
   int32_t value = locations->InAt(1).GetConstant()->AsIntConstant()->GetValue();
   XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  if (Is256BitVector(instruction)) {
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+        DCHECK_EQ(16u, instruction->GetVectorLength());
+        __ vpsrlw(dst, dst, Immediate(static_cast<uint8_t>(value)));
+        return;
+      case Primitive::kPrimInt:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        __ vpsrld(dst, dst, Immediate(static_cast<uint8_t>(value)));
+        return;
+      case Primitive::kPrimLong:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        __ vpsrlq(dst, dst, Immediate(static_cast<uint8_t>(value)));
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
@@ -886,6 +1516,49 @@ void InstructionCodeGeneratorX86::VisitVecLoad(HVecLoad* instruction) {
   Address address = VecAddress(locations, size, instruction->IsStringCharAt());
   XmmRegister reg = locations->Out().AsFpuRegister<XmmRegister>();
   bool is_aligned16 = instruction->GetAlignment().IsAlignedAt(16);
+  if (Is256BitVector(instruction)) {
+    bool is_aligned32 = instruction->GetAlignment().IsAlignedAt(32);
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimChar:
+        DCHECK_EQ(16u, instruction->GetVectorLength());
+        if (mirror::kUseStringCompression && instruction->IsStringCharAt()) {
+          NearLabel done, not_compressed;
+          uint32_t count_offset = mirror::String::CountOffset().Uint32Value();
+          __ testb(Address(locations->InAt(0).AsRegister<Register>(), count_offset),
+                   Immediate(1));
+          __ j(kNotZero, &not_compressed);
+          // Zero extend 16 compressed bytes into 16 chars.
+          __ vpmovzxbw(reg, VecAddress(locations, 1, /*is_string_char_at*/ true));
+          __ jmp(&done);
+          // Load 16 direct uncompressed chars.
+          __ Bind(&not_compressed);
+          is_aligned32 ? __ vmovdqa(reg, address) : __ vmovdqu(reg, address);
+          __ Bind(&done);
+          return;
+        }
+        FALLTHROUGH_INTENDED;
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimLong:
+        DCHECK_LE(4u, instruction->GetVectorLength());
+        DCHECK_LE(instruction->GetVectorLength(), 32u);
+        is_aligned32 ? __ vmovdqa(reg, address) : __ vmovdqu(reg, address);
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        is_aligned32 ? __ vmovaps(reg, address) : __ vmovups(reg, address);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        is_aligned32 ? __ vmovapd(reg, address) : __ vmovupd(reg, address);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimChar:
       DCHECK_EQ(8u, instruction->GetVectorLength());
@@ -944,6 +1617,32 @@ void InstructionCodeGeneratorX86::VisitVecStore(HVecStore* instruction) {
   Address address = VecAddress(locations, size, /*is_string_char_at*/ false);
   XmmRegister reg = locations->InAt(2).AsFpuRegister<XmmRegister>();
   bool is_aligned16 = instruction->GetAlignment().IsAlignedAt(16);
+  if (Is256BitVector(instruction)) {
+    bool is_aligned32 = instruction->GetAlignment().IsAlignedAt(32);
+    switch (instruction->GetPackedType()) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimLong:
+        DCHECK_LE(4u, instruction->GetVectorLength());
+        DCHECK_LE(instruction->GetVectorLength(), 32u);
+        is_aligned32 ? __ vmovdqa(address, reg) : __ vmovdqu(address, reg);
+        return;
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(8u, instruction->GetVectorLength());
+        is_aligned32 ? __ vmovaps(address, reg) : __ vmovups(address, reg);
+        return;
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(4u, instruction->GetVectorLength());
+        is_aligned32 ? __ vmovapd(address, reg) : __ vmovupd(address, reg);
+        return;
+      default:
+        LOG(FATAL) << "Unsupported SIMD type";
+        UNREACHABLE();
+    }
+  }
   switch (instruction->GetPackedType()) {
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
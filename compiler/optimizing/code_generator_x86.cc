@@ -1028,7 +1028,9 @@ size_t CodeGeneratorX86::RestoreCoreRegister(size_t stack_index, uint32_t reg_id
 }
 
 size_t CodeGeneratorX86::SaveFloatingPointRegister(size_t stack_index, uint32_t reg_id) {
-  if (GetGraph()->HasSIMD()) {
+  if (HasAVX2Vectors()) {
+    __ vmovups(Address(ESP, stack_index), XmmRegister(reg_id));
+  } else if (GetGraph()->HasSIMD()) {
     __ movups(Address(ESP, stack_index), XmmRegister(reg_id));
   } else {
     __ movsd(Address(ESP, stack_index), XmmRegister(reg_id));
@@ -1037,7 +1039,9 @@ size_t CodeGeneratorX86::SaveFloatingPointRegister(size_t stack_index, uint32_t
 }
 
 size_t CodeGeneratorX86::RestoreFloatingPointRegister(size_t stack_index, uint32_t reg_id) {
-  if (GetGraph()->HasSIMD()) {
+  if (HasAVX2Vectors()) {
+    __ vmovups(XmmRegister(reg_id), Address(ESP, stack_index));
+  } else if (GetGraph()->HasSIMD()) {
     __ movups(XmmRegister(reg_id), Address(ESP, stack_index));
   } else {
     __ movsd(XmmRegister(reg_id), Address(ESP, stack_index));
@@ -1045,6 +1049,13 @@ size_t CodeGeneratorX86::RestoreFloatingPointRegister(size_t stack_index, uint32
   return GetFloatingPointSpillSlotSize();
 }
 
+void CodeGeneratorX86::MaybeGenerateVZeroUpper() {
+  // The callee and the caller may run SSE code, which is slow while the upper halves are dirty.
+  if (HasAVX2Vectors()) {
+    __ vzeroupper();
+  }
+}
+
 void CodeGeneratorX86::InvokeRuntime(QuickEntrypointEnum entrypoint,
                                      HInstruction* instruction,
                                      uint32_t dex_pc,
@@ -1173,6 +1184,7 @@ void CodeGeneratorX86::GenerateFrameExit() {
       }
     }
   }
+  MaybeGenerateVZeroUpper();
   __ ret();
   __ cfi().RestoreState();
   __ cfi().DefCFAOffset(GetFrameSize());
@@ -1636,6 +1648,42 @@ void InstructionCodeGeneratorX86::GenerateCompareTestAndBranch(HCondition* condi
   }
 }
 
+// Whether X86MemoryOperandGeneration folded `instruction` into the compare using it,
+// in which case the load has no location and the compare reads the memory.
+static bool IsLoadFoldedIntoCompare(HInstruction* instruction) {
+  return instruction->IsEmittedAtUseSite() &&
+         (instruction->IsArrayGet() ||
+          instruction->IsInstanceFieldGet() ||
+          instruction->IsStaticFieldGet());
+}
+
+static Address FoldedLoadAddress(HInstruction* load) {
+  DCHECK(IsLoadFoldedIntoCompare(load));
+  DCHECK_EQ(load->GetType(), Primitive::kPrimInt);
+  LocationSummary* locations = load->GetLocations();
+  Register base = locations->InAt(0).AsRegister<Register>();
+  if (load->IsArrayGet()) {
+    uint32_t data_offset = CodeGenerator::GetArrayDataOffset(load->AsArrayGet());
+    return CodeGeneratorX86::ArrayAddress(base, locations->InAt(1), TIMES_4, data_offset);
+  }
+  const FieldInfo& field_info = load->IsInstanceFieldGet() ?
+      load->AsInstanceFieldGet()->GetFieldInfo() :
+      load->AsStaticFieldGet()->GetFieldInfo();
+  return Address(base, field_info.GetFieldOffset().Uint32Value());
+}
+
+void InstructionCodeGeneratorX86::GenerateConditionIntCompare(HCondition* condition) {
+  LocationSummary* locations = condition->GetLocations();
+  HInstruction* rhs = condition->InputAt(1);
+  if (IsLoadFoldedIntoCompare(rhs)) {
+    __ cmpl(locations->InAt(0).AsRegister<Register>(), FoldedLoadAddress(rhs));
+    // The load is just before the condition, the compare can do its null check.
+    codegen_->MaybeRecordImplicitNullCheck(rhs);
+  } else {
+    codegen_->GenerateIntCompare(locations->InAt(0), locations->InAt(1));
+  }
+}
+
 static bool AreEflagsSetFrom(HInstruction* cond, HInstruction* branch) {
   // Moves may affect the eflags register (move zero uses xorl), so the EFLAGS
   // are set only strictly before `branch`. We can't use the eflags on long/FP
@@ -1713,10 +1761,8 @@ void InstructionCodeGeneratorX86::GenerateTestAndBranch(HInstruction* instructio
       return;
     }
 
-    Location lhs = condition->GetLocations()->InAt(0);
-    Location rhs = condition->GetLocations()->InAt(1);
     // LHS is guaranteed to be in a register (see LocationsBuilderX86::HandleCondition).
-    codegen_->GenerateIntCompare(lhs, rhs);
+    GenerateConditionIntCompare(condition);
     if (true_target == nullptr) {
       __ j(X86Condition(condition->GetOppositeCondition()), false_target);
     } else {
@@ -1852,8 +1898,7 @@ void InstructionCodeGeneratorX86::VisitSelect(HSelect* select) {
         // We can't handle FP or long here.
         DCHECK_NE(condition->InputAt(0)->GetType(), Primitive::kPrimLong);
         DCHECK(!Primitive::IsFloatingPointType(condition->InputAt(0)->GetType()));
-        LocationSummary* cond_locations = condition->GetLocations();
-        codegen_->GenerateIntCompare(cond_locations->InAt(0), cond_locations->InAt(1));
+        GenerateConditionIntCompare(condition);
         cond = X86Condition(condition->GetCondition());
       }
     } else {
@@ -1936,7 +1981,9 @@ void LocationsBuilderX86::HandleCondition(HCondition* cond) {
     }
     default:
       locations->SetInAt(0, Location::RequiresRegister());
-      locations->SetInAt(1, Location::Any());
+      if (!IsLoadFoldedIntoCompare(cond->InputAt(1))) {
+        locations->SetInAt(1, Location::Any());
+      }
       if (!cond->IsEmittedAtUseSite()) {
         // We need a byte register.
         locations->SetOut(Location::RegisterLocation(ECX));
@@ -1962,7 +2009,7 @@ void InstructionCodeGeneratorX86::HandleCondition(HCondition* cond) {
 
       // Clear output register: setb only sets the low byte.
       __ xorl(reg, reg);
-      codegen_->GenerateIntCompare(lhs, rhs);
+      GenerateConditionIntCompare(cond);
       __ setb(X86Condition(cond->GetCondition()), reg);
       return;
     }
@@ -2331,6 +2378,7 @@ void InstructionCodeGeneratorX86::VisitInvokeInterface(HInvokeInterface* invoke)
   uint32_t method_offset = static_cast<uint32_t>(ImTable::OffsetOfElement(
       invoke->GetImtIndex(), kX86PointerSize));
   __ movl(temp, Address(temp, method_offset));
+  codegen_->MaybeGenerateVZeroUpper();
   // call temp->GetEntryPoint();
   __ call(Address(temp,
                   ArtMethod::EntryPointFromQuickCompiledCodeOffset(kX86PointerSize).Int32Value()));
@@ -4624,6 +4672,7 @@ void CodeGeneratorX86::GenerateStaticOrDirectCall(
     }
   }
 
+  MaybeGenerateVZeroUpper();
   switch (invoke->GetCodePtrLocation()) {
     case HInvokeStaticOrDirect::CodePtrLocation::kCallSelf:
       __ call(GetFrameEntryLabel());
@@ -4666,6 +4715,7 @@ void CodeGeneratorX86::GenerateVirtualCall(
   __ MaybeUnpoisonHeapReference(temp);
   // temp = temp->GetMethodAt(method_offset);
   __ movl(temp, Address(temp, method_offset));
+  MaybeGenerateVZeroUpper();
   // call temp->GetEntryPoint();
   __ call(Address(
       temp, ArtMethod::EntryPointFromQuickCompiledCodeOffset(kX86PointerSize).Int32Value()));
@@ -4792,7 +4842,9 @@ void LocationsBuilderX86::HandleFieldGet(HInstruction* instruction, const FieldI
   DCHECK(instruction->IsInstanceFieldGet() || instruction->IsStaticFieldGet());
 
   bool object_field_get_with_read_barrier =
-      kEmitCompilerReadBarrier && (instruction->GetType() == Primitive::kPrimNot);
+      kEmitCompilerReadBarrier &&
+      (instruction->GetType() == Primitive::kPrimNot) &&
+      !CodeGenerator::IsReadBarrierElided(instruction);
   LocationSummary* locations =
       new (GetGraph()->GetArena()) LocationSummary(instruction,
                                                    kEmitCompilerReadBarrier ?
@@ -4802,6 +4854,10 @@ void LocationsBuilderX86::HandleFieldGet(HInstruction* instruction, const FieldI
     locations->SetCustomSlowPathCallerSaves(RegisterSet::Empty());  // No caller-save registers.
   }
   locations->SetInAt(0, Location::RequiresRegister());
+  if (instruction->IsEmittedAtUseSite()) {
+    // The load is folded into the compare using it.
+    return;
+  }
 
   if (Primitive::IsFloatingPointType(instruction->GetType())) {
     locations->SetOut(Location::RequiresFpuRegister());
@@ -4830,6 +4886,9 @@ void LocationsBuilderX86::HandleFieldGet(HInstruction* instruction, const FieldI
 void InstructionCodeGeneratorX86::HandleFieldGet(HInstruction* instruction,
                                                  const FieldInfo& field_info) {
   DCHECK(instruction->IsInstanceFieldGet() || instruction->IsStaticFieldGet());
+  if (instruction->IsEmittedAtUseSite()) {
+    return;
+  }
 
   LocationSummary* locations = instruction->GetLocations();
   Location base_loc = locations->InAt(0);
@@ -4866,7 +4925,9 @@ void InstructionCodeGeneratorX86::HandleFieldGet(HInstruction* instruction,
 
     case Primitive::kPrimNot: {
       // /* HeapReference<Object> */ out = *(base + offset)
-      if (kEmitCompilerReadBarrier && kUseBakerReadBarrier) {
+      if (kEmitCompilerReadBarrier &&
+          kUseBakerReadBarrier &&
+          !CodeGenerator::IsReadBarrierElided(instruction)) {
         // Note that a potential implicit null check is handled in this
         // CodeGeneratorX86::GenerateFieldLoadWithBakerReadBarrier call.
         codegen_->GenerateFieldLoadWithBakerReadBarrier(
@@ -4880,10 +4941,15 @@ void InstructionCodeGeneratorX86::HandleFieldGet(HInstruction* instruction,
         if (is_volatile) {
           codegen_->GenerateMemoryBarrier(MemBarrierKind::kLoadAny);
         }
-        // If read barriers are enabled, emit read barriers other than
-        // Baker's using a slow path (and also unpoison the loaded
-        // reference, if heap poisoning is enabled).
-        codegen_->MaybeGenerateReadBarrierSlow(instruction, out, out, base_loc, offset);
+        if (CodeGenerator::IsReadBarrierElided(instruction)) {
+          // The GC is not marking, the reference only needs unpoisoning.
+          __ MaybeUnpoisonHeapReference(out.AsRegister<Register>());
+        } else {
+          // If read barriers are enabled, emit read barriers other than
+          // Baker's using a slow path (and also unpoison the loaded
+          // reference, if heap poisoning is enabled).
+          codegen_->MaybeGenerateReadBarrierSlow(instruction, out, out, base_loc, offset);
+        }
       }
       break;
     }
@@ -4952,7 +5018,7 @@ void LocationsBuilderX86::HandleFieldSet(HInstruction* instruction, const FieldI
   // inputs that die at entry with one in a specific register.
   if (is_byte_type) {
     // Ensure the value is in a byte register.
-    locations->SetInAt(1, Location::RegisterLocation(EAX));
+    locations->SetInAt(1, Location::ByteRegisterOrConstant(EAX, instruction->InputAt(1)));
   } else if (Primitive::IsFloatingPointType(field_type)) {
     if (is_volatile && field_type == Primitive::kPrimDouble) {
       // In order to satisfy the semantics of volatile, this must be a single instruction store.
@@ -4974,11 +5040,15 @@ void LocationsBuilderX86::HandleFieldSet(HInstruction* instruction, const FieldI
   } else {
     locations->SetInAt(1, Location::RegisterOrConstant(instruction->InputAt(1)));
 
-    if (CodeGenerator::StoreNeedsWriteBarrier(field_type, instruction->InputAt(1))) {
+    if (CodeGenerator::FieldStoreNeedsWriteBarrier(instruction, field_type)) {
       // Temporary registers for the write barrier.
       locations->AddTemp(Location::RequiresRegister());  // May be used for reference poisoning too.
       // Ensure the card is in a byte register.
       locations->AddTemp(Location::RegisterLocation(ECX));
+    } else if (kPoisonHeapReferences &&
+               CodeGenerator::StoreNeedsWriteBarrier(field_type, instruction->InputAt(1))) {
+      // Temporary register for the reference poisoning, the card mark being elided.
+      locations->AddTemp(Location::RequiresRegister());
     }
   }
 }
@@ -5006,7 +5076,12 @@ void InstructionCodeGeneratorX86::HandleFieldSet(HInstruction* instruction,
   switch (field_type) {
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte: {
-      __ movb(Address(base, offset), value.AsRegister<ByteRegister>());
+      if (value.IsConstant()) {
+        int8_t v = CodeGenerator::GetInt32ValueOf(value.GetConstant());
+        __ movb(Address(base, offset), Immediate(v));
+      } else {
+        __ movb(Address(base, offset), value.AsRegister<ByteRegister>());
+      }
       break;
     }
 
@@ -5097,7 +5172,7 @@ void InstructionCodeGeneratorX86::HandleFieldSet(HInstruction* instruction,
     codegen_->MaybeRecordImplicitNullCheck(instruction);
   }
 
-  if (needs_write_barrier) {
+  if (CodeGenerator::FieldStoreNeedsWriteBarrier(instruction, field_type)) {
     Register temp = locations->GetTemp(0).AsRegister<Register>();
     Register card = locations->GetTemp(1).AsRegister<Register>();
     codegen_->MarkGCCard(temp, card, base, value.AsRegister<Register>(), value_can_be_null);
@@ -5253,7 +5328,9 @@ void InstructionCodeGeneratorX86::VisitNullCheck(HNullCheck* instruction) {
 
 void LocationsBuilderX86::VisitArrayGet(HArrayGet* instruction) {
   bool object_array_get_with_read_barrier =
-      kEmitCompilerReadBarrier && (instruction->GetType() == Primitive::kPrimNot);
+      kEmitCompilerReadBarrier &&
+      (instruction->GetType() == Primitive::kPrimNot) &&
+      !CodeGenerator::IsReadBarrierElided(instruction);
   LocationSummary* locations =
       new (GetGraph()->GetArena()) LocationSummary(instruction,
                                                    object_array_get_with_read_barrier ?
@@ -5264,6 +5341,10 @@ void LocationsBuilderX86::VisitArrayGet(HArrayGet* instruction) {
   }
   locations->SetInAt(0, Location::RequiresRegister());
   locations->SetInAt(1, Location::RegisterOrConstant(instruction->InputAt(1)));
+  if (instruction->IsEmittedAtUseSite()) {
+    // The load is folded into the compare using it.
+    return;
+  }
   if (Primitive::IsFloatingPointType(instruction->GetType())) {
     locations->SetOut(Location::RequiresFpuRegister(), Location::kNoOutputOverlap);
   } else {
@@ -5281,6 +5362,10 @@ void LocationsBuilderX86::VisitArrayGet(HArrayGet* instruction) {
 }
 
 void InstructionCodeGeneratorX86::VisitArrayGet(HArrayGet* instruction) {
+  if (instruction->IsEmittedAtUseSite()) {
+    return;
+  }
+
   LocationSummary* locations = instruction->GetLocations();
   Location obj_loc = locations->InAt(0);
   Register obj = obj_loc.AsRegister<Register>();
@@ -5344,7 +5429,9 @@ void InstructionCodeGeneratorX86::VisitArrayGet(HArrayGet* instruction) {
           "art::mirror::HeapReference<art::mirror::Object> and int32_t have different sizes.");
       // /* HeapReference<Object> */ out =
       //     *(obj + data_offset + index * sizeof(HeapReference<Object>))
-      if (kEmitCompilerReadBarrier && kUseBakerReadBarrier) {
+      if (kEmitCompilerReadBarrier &&
+          kUseBakerReadBarrier &&
+          !CodeGenerator::IsReadBarrierElided(instruction)) {
         // Note that a potential implicit null check is handled in this
         // CodeGeneratorX86::GenerateArrayLoadWithBakerReadBarrier call.
         codegen_->GenerateArrayLoadWithBakerReadBarrier(
@@ -5356,7 +5443,10 @@ void InstructionCodeGeneratorX86::VisitArrayGet(HArrayGet* instruction) {
         // If read barriers are enabled, emit read barriers other than
         // Baker's using a slow path (and also unpoison the loaded
         // reference, if heap poisoning is enabled).
-        if (index.IsConstant()) {
+        if (CodeGenerator::IsReadBarrierElided(instruction)) {
+          // The GC is not marking, the reference only needs unpoisoning.
+          __ MaybeUnpoisonHeapReference(out);
+        } else if (index.IsConstant()) {
           uint32_t offset =
               (index.GetConstant()->AsIntConstant()->GetValue() << TIMES_4) + data_offset;
           codegen_->MaybeGenerateReadBarrierSlow(instruction, out_loc, out_loc, obj_loc, offset);
@@ -5825,6 +5915,176 @@ void InstructionCodeGeneratorX86::VisitX86BoundsCheckMemory(HX86BoundsCheckMemor
   __ j(kBelowEqual, slow_path->GetEntryLabel());
 }
 
+void LocationsBuilderX86::VisitX86ArrayAlignmentPeeling(
+    HX86ArrayAlignmentPeeling* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kNoCall);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RegisterOrConstant(instruction->InputAt(1)));
+  locations->SetOut(Location::RequiresRegister(), Location::kNoOutputOverlap);
+}
+
+void InstructionCodeGeneratorX86::VisitX86ArrayAlignmentPeeling(
+    HX86ArrayAlignmentPeeling* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register array = locations->InAt(0).AsRegister<Register>();
+  Register out = locations->Out().AsRegister<Register>();
+  size_t component_size = Primitive::ComponentSize(instruction->GetComponentType());
+  uint32_t data_offset = mirror::Array::DataOffset(component_size).Uint32Value();
+  ScaleFactor scale = static_cast<ScaleFactor>(WhichPowerOf2(component_size));
+
+  // out = (-&array[index] & (alignment - 1)) / component_size, on the low 32 bits
+  // of the address which are enough to tell the alignment.
+  __ leal(out, CodeGeneratorX86::ArrayAddress(array, locations->InAt(1), scale, data_offset));
+  __ negl(out);
+  __ andl(out, Immediate(static_cast<int32_t>(instruction->GetAlignment()) - 1));
+  if (scale != TIMES_1) {
+    __ shrl(out, Immediate(scale));
+  }
+}
+
+void LocationsBuilderX86::VisitX86Prefetch(HX86Prefetch* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kNoCall);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RegisterOrConstant(instruction->GetIndex()));
+  if (instruction->IsIndirect()) {
+    locations->AddTemp(Location::RequiresRegister());
+  }
+}
+
+void InstructionCodeGeneratorX86::VisitX86Prefetch(HX86Prefetch* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register array = locations->InAt(0).AsRegister<Register>();
+  Location index = locations->InAt(1);
+  size_t component_size = Primitive::ComponentSize(instruction->GetComponentType());
+  uint32_t data_offset = mirror::Array::DataOffset(component_size).Uint32Value();
+  ScaleFactor scale = static_cast<ScaleFactor>(WhichPowerOf2(component_size));
+  int32_t distance = instruction->GetDistance();
+  auto prefetch = [&](const Address& address) {
+    if (instruction->GetHint() == HX86Prefetch::kPrefetchNTA) {
+      __ prefetchnta(address);
+    } else {
+      __ prefetcht0(address);
+    }
+  };
+
+  if (!instruction->IsIndirect()) {
+    // A prefetch past the bounds of the array is harmless, it does not fault.
+    int32_t offset =
+        static_cast<int32_t>(data_offset) + distance * static_cast<int32_t>(component_size);
+    prefetch(CodeGeneratorX86::ArrayAddress(array, index, scale, static_cast<uint32_t>(offset)));
+    return;
+  }
+
+  // Load array[index + distance] when it is in the bounds, the unsigned comparison also
+  // rejecting the negative elements. The reference is read without barrier: the prefetch
+  // only needs an address close to the object.
+  Register element = locations->GetTemp(0).AsRegister<Register>();
+  NearLabel done;
+  if (index.IsConstant()) {
+    uint32_t value = static_cast<uint32_t>(CodeGenerator::GetInt32ValueOf(index.GetConstant()));
+    __ movl(element, Immediate(static_cast<int32_t>(value + static_cast<uint32_t>(distance))));
+  } else {
+    __ leal(element, Address(index.AsRegister<Register>(), distance));
+  }
+  __ cmpl(element, Address(array, mirror::Array::LengthOffset().Uint32Value()));
+  __ j(kAboveEqual, &done);
+  __ movl(element, Address(array, element, TIMES_4, data_offset));
+  __ MaybeUnpoisonHeapReference(element);
+  prefetch(Address(element, instruction->GetFieldOffset()));
+  __ Bind(&done);
+}
+
+void LocationsBuilderX86::VisitX86IncrementCounter(HX86IncrementCounter* instruction) {
+  new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kNoCall);
+}
+
+void InstructionCodeGeneratorX86::VisitX86IncrementCounter(HX86IncrementCounter* instruction) {
+  uintptr_t counter = reinterpret_cast<uintptr_t>(instruction->GetCounter());
+  __ addl(Address::Absolute(counter), Immediate(1));
+  __ adcl(Address::Absolute(counter + sizeof(uint32_t)), Immediate(0));
+}
+
+void LocationsBuilderX86::VisitX86IsGcMarking(HX86IsGcMarking* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kNoCall);
+  locations->SetOut(Location::RequiresRegister());
+}
+
+void InstructionCodeGeneratorX86::VisitX86IsGcMarking(HX86IsGcMarking* instruction) {
+  Register out = instruction->GetLocations()->Out().AsRegister<Register>();
+  __ fs()->movl(out,
+                Address::Absolute(Thread::IsGcMarkingOffset<kX86PointerSize>().Int32Value()));
+}
+
+void LocationsBuilderX86::VisitX86ReadModifyWriteMemory(
+    HX86ReadModifyWriteMemory* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kNoCall);
+  locations->SetInAt(0, Location::RegisterOrConstant(instruction->GetValue()));
+  locations->SetInAt(1, Location::RequiresRegister());
+  if (instruction->GetIndex() != nullptr) {
+    locations->SetInAt(2, Location::RegisterOrConstant(instruction->GetIndex()));
+  }
+}
+
+void InstructionCodeGeneratorX86::VisitX86ReadModifyWriteMemory(
+    HX86ReadModifyWriteMemory* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Location value = locations->InAt(0);
+  Register base = locations->InAt(1).AsRegister<Register>();
+  size_t offset = instruction->GetOffset();
+  Address address = (instruction->GetIndex() == nullptr) ?
+      Address(base, offset) :
+      CodeGeneratorX86::ArrayAddress(base, locations->InAt(2), TIMES_4, offset);
+
+  if (value.IsConstant()) {
+    Immediate imm(CodeGenerator::GetInt32ValueOf(value.GetConstant()));
+    switch (instruction->GetOpKind()) {
+      case HInstruction::kAdd:
+        __ addl(address, imm);
+        break;
+      case HInstruction::kSub:
+        __ subl(address, imm);
+        break;
+      case HInstruction::kAnd:
+        __ andl(address, imm);
+        break;
+      case HInstruction::kOr:
+        __ orl(address, imm);
+        break;
+      case HInstruction::kXor:
+        __ xorl(address, imm);
+        break;
+      default:
+        LOG(FATAL) << "Unexpected read-modify-write operation " << instruction->GetOpKind();
+    }
+  } else {
+    Register reg = value.AsRegister<Register>();
+    switch (instruction->GetOpKind()) {
+      case HInstruction::kAdd:
+        __ addl(address, reg);
+        break;
+      case HInstruction::kSub:
+        __ subl(address, reg);
+        break;
+      case HInstruction::kAnd:
+        __ andl(address, reg);
+        break;
+      case HInstruction::kOr:
+        __ orl(address, reg);
+        break;
+      case HInstruction::kXor:
+        __ xorl(address, reg);
+        break;
+      default:
+        LOG(FATAL) << "Unexpected read-modify-write operation " << instruction->GetOpKind();
+    }
+  }
+  codegen_->MaybeRecordImplicitNullCheck(instruction);
+}
+
 void LocationsBuilderX86::VisitParallelMove(HParallelMove* instruction ATTRIBUTE_UNUSED) {
   LOG(FATAL) << "Unreachable";
 }
@@ -5982,7 +6242,11 @@ void ParallelMoveResolverX86::EmitMove(size_t index) {
     if (destination.IsRegister()) {
       __ movd(destination.AsRegister<Register>(), source.AsFpuRegister<XmmRegister>());
     } else if (destination.IsFpuRegister()) {
-      __ movaps(destination.AsFpuRegister<XmmRegister>(), source.AsFpuRegister<XmmRegister>());
+      if (codegen_->HasAVX2Vectors()) {
+        __ vmovaps(destination.AsFpuRegister<XmmRegister>(), source.AsFpuRegister<XmmRegister>());
+      } else {
+        __ movaps(destination.AsFpuRegister<XmmRegister>(), source.AsFpuRegister<XmmRegister>());
+      }
     } else if (destination.IsRegisterPair()) {
       XmmRegister src_reg = source.AsFpuRegister<XmmRegister>();
       __ movd(destination.AsRegisterPairLow<Register>(), src_reg);
@@ -5994,7 +6258,11 @@ void ParallelMoveResolverX86::EmitMove(size_t index) {
       __ movsd(Address(ESP, destination.GetStackIndex()), source.AsFpuRegister<XmmRegister>());
     } else {
       DCHECK(destination.IsSIMDStackSlot());
-      __ movups(Address(ESP, destination.GetStackIndex()), source.AsFpuRegister<XmmRegister>());
+      if (codegen_->HasAVX2Vectors()) {
+        __ vmovups(Address(ESP, destination.GetStackIndex()), source.AsFpuRegister<XmmRegister>());
+      } else {
+        __ movups(Address(ESP, destination.GetStackIndex()), source.AsFpuRegister<XmmRegister>());
+      }
     }
   } else if (source.IsStackSlot()) {
     if (destination.IsRegister()) {
@@ -6018,7 +6286,11 @@ void ParallelMoveResolverX86::EmitMove(size_t index) {
     }
   } else if (source.IsSIMDStackSlot()) {
     DCHECK(destination.IsFpuRegister());
-    __ movups(destination.AsFpuRegister<XmmRegister>(), Address(ESP, source.GetStackIndex()));
+    if (codegen_->HasAVX2Vectors()) {
+      __ vmovups(destination.AsFpuRegister<XmmRegister>(), Address(ESP, source.GetStackIndex()));
+    } else {
+      __ movups(destination.AsFpuRegister<XmmRegister>(), Address(ESP, source.GetStackIndex()));
+    }
   } else if (source.IsConstant()) {
     HConstant* constant = source.GetConstant();
     if (constant->IsIntConstant() || constant->IsNullConstant()) {
@@ -6154,9 +6426,18 @@ void ParallelMoveResolverX86::EmitSwap(size_t index) {
   } else if (source.IsFpuRegister() && destination.IsFpuRegister()) {
     // Use XOR Swap algorithm to avoid a temporary.
     DCHECK_NE(source.reg(), destination.reg());
-    __ xorpd(destination.AsFpuRegister<XmmRegister>(), source.AsFpuRegister<XmmRegister>());
-    __ xorpd(source.AsFpuRegister<XmmRegister>(), destination.AsFpuRegister<XmmRegister>());
-    __ xorpd(destination.AsFpuRegister<XmmRegister>(), source.AsFpuRegister<XmmRegister>());
+    XmmRegister src_reg = source.AsFpuRegister<XmmRegister>();
+    XmmRegister dst_reg = destination.AsFpuRegister<XmmRegister>();
+    if (codegen_->HasAVX2Vectors()) {
+      // The whole YMM registers are swapped.
+      __ vxorpd(dst_reg, dst_reg, src_reg);
+      __ vxorpd(src_reg, src_reg, dst_reg);
+      __ vxorpd(dst_reg, dst_reg, src_reg);
+    } else {
+      __ xorpd(dst_reg, src_reg);
+      __ xorpd(src_reg, dst_reg);
+      __ xorpd(dst_reg, src_reg);
+    }
   } else if (source.IsFpuRegister() && destination.IsStackSlot()) {
     Exchange32(source.AsFpuRegister<XmmRegister>(), destination.GetStackIndex());
   } else if (destination.IsFpuRegister() && source.IsStackSlot()) {
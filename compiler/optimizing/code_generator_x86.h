@@ -278,6 +278,9 @@ class InstructionCodeGeneratorX86 : public InstructionCodeGenerator {
   void PushOntoFPStack(Location source, uint32_t temp_offset,
                        uint32_t stack_adjustment, bool is_fp, bool is_wide);
 
+  // Compare the int inputs of a condition, the right one possibly being a load
+  // folded into the compare by X86MemoryOperandGeneration.
+  void GenerateConditionIntCompare(HCondition* condition);
   template<class LabelType>
   void GenerateTestAndBranch(HInstruction* instruction,
                              size_t condition_input_index,
@@ -350,11 +353,22 @@ class CodeGeneratorX86 : public CodeGenerator {
   }
 
   size_t GetFloatingPointSpillSlotSize() const OVERRIDE {
-    return GetGraph()->HasSIMD()
-        ? 4 * kX86WordSize   // 16 bytes == 4 words for each spill
-        : 2 * kX86WordSize;  //  8 bytes == 2 words for each spill
+    if (GetGraph()->HasSIMD()) {
+      return HasAVX2Vectors()
+          ? 8 * kX86WordSize   // 32 bytes == 8 words for each spill
+          : 4 * kX86WordSize;  // 16 bytes == 4 words for each spill
+    }
+    return 2 * kX86WordSize;  //  8 bytes == 2 words for each spill
+  }
+
+  // Whether the vector code of the graph uses the 256-bit YMM registers.
+  bool HasAVX2Vectors() const {
+    return GetGraph()->HasSIMD() && isa_features_.HasAVX2();
   }
 
+  // Clear the upper halves of the YMM registers before leaving for SSE code.
+  void MaybeGenerateVZeroUpper();
+
   HGraphVisitor* GetLocationBuilder() OVERRIDE {
     return &location_builder_;
   }
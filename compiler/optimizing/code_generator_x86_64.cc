@@ -52,6 +52,10 @@ static constexpr FloatRegister kFpuCalleeSaves[] = { XMM12, XMM13, XMM14, XMM15
 
 static constexpr int kC2ConditionMask = 0x400;
 
+// Whether the allocations bump the TLAB of the thread inline, only calling the entrypoint when the
+// TLAB is exhausted or the class is not ready for the fast path.
+static constexpr bool kInlineTlabAllocation = true;
+
 // NOLINT on __ macro to suppress wrong warning/fix (misc-macro-parentheses) from clang-tidy.
 #define __ down_cast<X86_64Assembler*>(codegen->GetAssembler())->  // NOLINT
 #define QUICK_ENTRY_POINT(x) QUICK_ENTRYPOINT_OFFSET(kX86_64PointerSize, x).Int32Value()
@@ -1075,6 +1079,7 @@ void CodeGeneratorX86_64::GenerateStaticOrDirectCall(
     }
   }
 
+  MaybeGenerateVZeroUpper();
   switch (invoke->GetCodePtrLocation()) {
     case HInvokeStaticOrDirect::CodePtrLocation::kCallSelf:
       __ call(&frame_entry_label_);
@@ -1118,6 +1123,7 @@ void CodeGeneratorX86_64::GenerateVirtualCall(
   __ MaybeUnpoisonHeapReference(temp);
   // temp = temp->GetMethodAt(method_offset);
   __ movq(temp, Address(temp, method_offset));
+  MaybeGenerateVZeroUpper();
   // call temp->GetEntryPoint();
   __ call(Address(temp, ArtMethod::EntryPointFromQuickCompiledCodeOffset(
       kX86_64PointerSize).SizeValue()));
@@ -1220,7 +1226,9 @@ size_t CodeGeneratorX86_64::RestoreCoreRegister(size_t stack_index, uint32_t reg
 }
 
 size_t CodeGeneratorX86_64::SaveFloatingPointRegister(size_t stack_index, uint32_t reg_id) {
-  if (GetGraph()->HasSIMD()) {
+  if (HasAVX2Vectors()) {
+    __ vmovups(Address(CpuRegister(RSP), stack_index), XmmRegister(reg_id));
+  } else if (GetGraph()->HasSIMD()) {
     __ movups(Address(CpuRegister(RSP), stack_index), XmmRegister(reg_id));
   } else {
     __ movsd(Address(CpuRegister(RSP), stack_index), XmmRegister(reg_id));
@@ -1229,7 +1237,9 @@ size_t CodeGeneratorX86_64::SaveFloatingPointRegister(size_t stack_index, uint32
 }
 
 size_t CodeGeneratorX86_64::RestoreFloatingPointRegister(size_t stack_index, uint32_t reg_id) {
-  if (GetGraph()->HasSIMD()) {
+  if (HasAVX2Vectors()) {
+    __ vmovups(XmmRegister(reg_id), Address(CpuRegister(RSP), stack_index));
+  } else if (GetGraph()->HasSIMD()) {
     __ movups(XmmRegister(reg_id), Address(CpuRegister(RSP), stack_index));
   } else {
     __ movsd(XmmRegister(reg_id), Address(CpuRegister(RSP), stack_index));
@@ -1237,6 +1247,13 @@ size_t CodeGeneratorX86_64::RestoreFloatingPointRegister(size_t stack_index, uin
   return GetFloatingPointSpillSlotSize();
 }
 
+void CodeGeneratorX86_64::MaybeGenerateVZeroUpper() {
+  // The callee and the caller may run SSE code, which is slow while the upper halves are dirty.
+  if (HasAVX2Vectors()) {
+    __ vzeroupper();
+  }
+}
+
 void CodeGeneratorX86_64::InvokeRuntime(QuickEntrypointEnum entrypoint,
                                         HInstruction* instruction,
                                         uint32_t dex_pc,
@@ -1284,6 +1301,7 @@ CodeGeneratorX86_64::CodeGeneratorX86_64(HGraph* graph,
         assembler_(graph->GetArena()),
         isa_features_(isa_features),
         constant_area_start_(0),
+        align_loop_headers_(false),
         boot_image_method_patches_(graph->GetArena()->Adapter(kArenaAllocCodeGenerator)),
         method_bss_entry_patches_(graph->GetArena()->Adapter(kArenaAllocCodeGenerator)),
         boot_image_type_patches_(graph->GetArena()->Adapter(kArenaAllocCodeGenerator)),
@@ -1397,12 +1415,33 @@ void CodeGeneratorX86_64::GenerateFrameExit() {
       }
     }
   }
+  MaybeGenerateVZeroUpper();
   __ ret();
   __ cfi().RestoreState();
   __ cfi().DefCFAOffset(GetFrameSize());
 }
 
+static bool IsInnermostLoopHeader(HBasicBlock* block) {
+  if (!block->IsLoopHeader() || block->GetLoopInformation()->IsIrreducible()) {
+    return false;
+  }
+  for (HBlocksInLoopIterator it(*block->GetLoopInformation()); !it.Done(); it.Advance()) {
+    if (it.Current() != block && it.Current()->IsLoopHeader()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void CodeGeneratorX86_64::Bind(HBasicBlock* block) {
+  if (align_loop_headers_ && IsInnermostLoopHeader(block)) {
+    // The padding only runs when falling into the loop, the back edges jump past it. The
+    // native pcs of the stack maps are recorded as the code is emitted, after the padding.
+    size_t padding = __ AlignWithNops(assembler_.PreferredLoopAlignment());
+    if (padding != 0u) {
+      MaybeRecordStat(MethodCompilationStat::kIntelLoopAlignmentPadding, padding);
+    }
+  }
   __ Bind(GetLabelOf(block));
 }
 
@@ -1562,6 +1601,42 @@ void InstructionCodeGeneratorX86_64::GenerateFPJumps(HCondition* cond,
   __ j(X86_64FPCondition(cond->GetCondition()), true_label);
 }
 
+// Whether X86MemoryOperandGeneration folded `instruction` into the compare using it,
+// in which case the load has no location and the compare reads the memory.
+static bool IsLoadFoldedIntoCompare(HInstruction* instruction) {
+  return instruction->IsEmittedAtUseSite() &&
+         (instruction->IsArrayGet() ||
+          instruction->IsInstanceFieldGet() ||
+          instruction->IsStaticFieldGet());
+}
+
+static Address FoldedLoadAddress(HInstruction* load) {
+  DCHECK(IsLoadFoldedIntoCompare(load));
+  DCHECK_EQ(load->GetType(), Primitive::kPrimInt);
+  LocationSummary* locations = load->GetLocations();
+  CpuRegister base = locations->InAt(0).AsRegister<CpuRegister>();
+  if (load->IsArrayGet()) {
+    uint32_t data_offset = CodeGenerator::GetArrayDataOffset(load->AsArrayGet());
+    return CodeGeneratorX86_64::ArrayAddress(base, locations->InAt(1), TIMES_4, data_offset);
+  }
+  const FieldInfo& field_info = load->IsInstanceFieldGet() ?
+      load->AsInstanceFieldGet()->GetFieldInfo() :
+      load->AsStaticFieldGet()->GetFieldInfo();
+  return Address(base, field_info.GetFieldOffset().Uint32Value());
+}
+
+void InstructionCodeGeneratorX86_64::GenerateConditionIntCompare(HCondition* condition) {
+  LocationSummary* locations = condition->GetLocations();
+  HInstruction* rhs = condition->InputAt(1);
+  if (IsLoadFoldedIntoCompare(rhs)) {
+    __ cmpl(locations->InAt(0).AsRegister<CpuRegister>(), FoldedLoadAddress(rhs));
+    // The load is just before the condition, the compare can do its null check.
+    codegen_->MaybeRecordImplicitNullCheck(rhs);
+  } else {
+    codegen_->GenerateIntCompare(locations->InAt(0), locations->InAt(1));
+  }
+}
+
 void InstructionCodeGeneratorX86_64::GenerateCompareTest(HCondition* condition) {
   LocationSummary* locations = condition->GetLocations();
 
@@ -1575,7 +1650,7 @@ void InstructionCodeGeneratorX86_64::GenerateCompareTest(HCondition* condition)
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot: {
-      codegen_->GenerateIntCompare(left, right);
+      GenerateConditionIntCompare(condition);
       break;
     }
     case Primitive::kPrimLong: {
@@ -1732,9 +1807,7 @@ void InstructionCodeGeneratorX86_64::GenerateTestAndBranch(HInstruction* instruc
       return;
     }
 
-    Location lhs = condition->GetLocations()->InAt(0);
-    Location rhs = condition->GetLocations()->InAt(1);
-    codegen_->GenerateIntCompare(lhs, rhs);
+    GenerateConditionIntCompare(condition);
       if (true_target == nullptr) {
       __ j(X86_64IntegerCondition(condition->GetOppositeCondition()), false_target);
     } else {
@@ -1922,7 +1995,9 @@ void LocationsBuilderX86_64::HandleCondition(HCondition* cond) {
       break;
     default:
       locations->SetInAt(0, Location::RequiresRegister());
-      locations->SetInAt(1, Location::Any());
+      if (!IsLoadFoldedIntoCompare(cond->InputAt(1))) {
+        locations->SetInAt(1, Location::Any());
+      }
       break;
   }
   if (!cond->IsEmittedAtUseSite()) {
@@ -1948,7 +2023,7 @@ void InstructionCodeGeneratorX86_64::HandleCondition(HCondition* cond) {
       // Clear output register: setcc only sets the low byte.
       __ xorl(reg, reg);
 
-      codegen_->GenerateIntCompare(lhs, rhs);
+      GenerateConditionIntCompare(cond);
       __ setcc(X86_64IntegerCondition(cond->GetCondition()), reg);
       return;
     case Primitive::kPrimLong:
@@ -2498,6 +2573,7 @@ void InstructionCodeGeneratorX86_64::VisitInvokeInterface(HInvokeInterface* invo
       invoke->GetImtIndex(), kX86_64PointerSize));
   // temp = temp->GetImtEntryAt(method_offset);
   __ movq(temp, Address(temp, method_offset));
+  codegen_->MaybeGenerateVZeroUpper();
   // call temp->GetEntryPoint();
   __ call(Address(
       temp, ArtMethod::EntryPointFromQuickCompiledCodeOffset(kX86_64PointerSize).SizeValue()));
@@ -4121,6 +4197,15 @@ void InstructionCodeGeneratorX86_64::VisitUShr(HUShr* ushr) {
   HandleShift(ushr);
 }
 
+// The entrypoints with checks may have to throw for the class, the others leave the class checks
+// to its object size for the fast path, which is only valid for initialized non-finalizable
+// classes.
+static bool CanInlineTlabAllocation(HNewInstance* instruction) {
+  return kInlineTlabAllocation &&
+      !instruction->IsStringAlloc() &&
+      instruction->GetEntrypoint() != kQuickAllocObjectWithChecks;
+}
+
 void LocationsBuilderX86_64::VisitNewInstance(HNewInstance* instruction) {
   LocationSummary* locations =
       new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCallOnMainOnly);
@@ -4129,10 +4214,41 @@ void LocationsBuilderX86_64::VisitNewInstance(HNewInstance* instruction) {
     locations->AddTemp(Location::RegisterLocation(kMethodRegisterArgument));
   } else {
     locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+    if (CanInlineTlabAllocation(instruction)) {
+      locations->AddTemp(Location::RegisterLocation(RCX));
+    }
   }
   locations->SetOut(Location::RegisterLocation(RAX));
 }
 
+void InstructionCodeGeneratorX86_64::GenerateTlabAllocation(CpuRegister klass,
+                                                            CpuRegister size,
+                                                            CpuRegister out,
+                                                            NearLabel* slow_path) {
+  // Same as the TLAB fast path of the allocation entrypoints, which the instrumented entrypoints
+  // replace, e.g. for the allocation tracking.
+  __ gs()->cmpq(Address::Absolute(Thread::InlineAllocDisabledOffset<kX86_64PointerSize>(),
+                                  /* no_rip */ true),
+                Immediate(0));
+  __ j(kNotEqual, slow_path);
+  __ gs()->movq(out, Address::Absolute(Thread::ThreadLocalPosOffset<kX86_64PointerSize>(),
+                                       /* no_rip */ true));
+  // The size fits 35 bits, adding it to the position cannot wrap around.
+  __ addq(size, out);
+  __ gs()->cmpq(size, Address::Absolute(Thread::ThreadLocalEndOffset<kX86_64PointerSize>(),
+                                        /* no_rip */ true));
+  __ j(kAbove, slow_path);
+  __ gs()->movq(Address::Absolute(Thread::ThreadLocalPosOffset<kX86_64PointerSize>(),
+                                  /* no_rip */ true),
+                size);
+  __ gs()->addq(Address::Absolute(Thread::ThreadLocalObjectsOffset<kX86_64PointerSize>(),
+                                  /* no_rip */ true),
+                Immediate(1));
+  // The TLAB is zeroed, only the class is stored. No fence needed for x86-64.
+  __ MaybePoisonHeapReference(klass);
+  __ movl(Address(out, mirror::Object::ClassOffset()), klass);
+}
+
 void InstructionCodeGeneratorX86_64::VisitNewInstance(HNewInstance* instruction) {
   // Note: if heap poisoning is enabled, the entry point takes cares
   // of poisoning the reference.
@@ -4143,6 +4259,23 @@ void InstructionCodeGeneratorX86_64::VisitNewInstance(HNewInstance* instruction)
     __ gs()->movq(temp, Address::Absolute(QUICK_ENTRY_POINT(pNewEmptyString), /* no_rip */ true));
     __ call(Address(temp, code_offset.SizeValue()));
     codegen_->RecordPcInfo(instruction, instruction->GetDexPc());
+  } else if (CanInlineTlabAllocation(instruction)) {
+    LocationSummary* locations = instruction->GetLocations();
+    CpuRegister klass = locations->InAt(0).AsRegister<CpuRegister>();
+    CpuRegister size = locations->GetTemp(0).AsRegister<CpuRegister>();
+    CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+    NearLabel slow_path;
+    NearLabel done;
+    // The object size for the fast path is the maximum size unless the class is initialized and
+    // not finalizable, which never fits the TLAB.
+    __ movl(size, Address(klass, mirror::Class::ObjectSizeAllocFastPathOffset().Int32Value()));
+    GenerateTlabAllocation(klass, size, out, &slow_path);
+    __ jmp(&done);
+    __ Bind(&slow_path);
+    codegen_->InvokeRuntime(instruction->GetEntrypoint(), instruction, instruction->GetDexPc());
+    CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
+    __ Bind(&done);
+    DCHECK(!codegen_->IsLeafMethod());
   } else {
     codegen_->InvokeRuntime(instruction->GetEntrypoint(), instruction, instruction->GetDexPc());
     CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
@@ -4157,6 +4290,9 @@ void LocationsBuilderX86_64::VisitNewArray(HNewArray* instruction) {
   locations->SetOut(Location::RegisterLocation(RAX));
   locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
   locations->SetInAt(1, Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+  if (kInlineTlabAllocation) {
+    locations->AddTemp(Location::RegisterLocation(RCX));
+  }
 }
 
 void InstructionCodeGeneratorX86_64::VisitNewArray(HNewArray* instruction) {
@@ -4164,8 +4300,41 @@ void InstructionCodeGeneratorX86_64::VisitNewArray(HNewArray* instruction) {
   // of poisoning the reference.
   QuickEntrypointEnum entrypoint =
       CodeGenerator::GetArrayAllocationEntrypoint(instruction->GetLoadClass()->GetClass());
+  size_t component_size_shift;
+  switch (entrypoint) {
+    case kQuickAllocArrayResolved8: component_size_shift = 0; break;
+    case kQuickAllocArrayResolved16: component_size_shift = 1; break;
+    case kQuickAllocArrayResolved32: component_size_shift = 2; break;
+    case kQuickAllocArrayResolved64: component_size_shift = 3; break;
+    default:
+      LOG(FATAL) << "Unexpected array allocation entrypoint " << entrypoint;
+      UNREACHABLE();
+  }
+  NearLabel slow_path;
+  NearLabel done;
+  if (kInlineTlabAllocation) {
+    LocationSummary* locations = instruction->GetLocations();
+    CpuRegister klass = locations->InAt(0).AsRegister<CpuRegister>();
+    CpuRegister length = locations->InAt(1).AsRegister<CpuRegister>();
+    CpuRegister size = locations->GetTemp(0).AsRegister<CpuRegister>();
+    CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+    // A negative length is zero extended to a size that never fits the TLAB.
+    int32_t data_offset = mirror::Array::DataOffset(1u << component_size_shift).Int32Value();
+    int32_t alignment = static_cast<int32_t>(kObjectAlignment);
+    __ movl(size, length);
+    if (component_size_shift != 0) {
+      __ shlq(size, Immediate(component_size_shift));
+    }
+    __ addq(size, Immediate(data_offset + alignment - 1));
+    __ andq(size, Immediate(-alignment));
+    GenerateTlabAllocation(klass, size, out, &slow_path);
+    __ movl(Address(out, mirror::Array::LengthOffset().Int32Value()), length);
+    __ jmp(&done);
+    __ Bind(&slow_path);
+  }
   codegen_->InvokeRuntime(entrypoint, instruction, instruction->GetDexPc());
   CheckEntrypointTypes<kQuickAllocArrayResolved, void*, mirror::Class*, int32_t>();
+  __ Bind(&done);
   DCHECK(!codegen_->IsLeafMethod());
 }
 
@@ -4304,7 +4473,9 @@ void LocationsBuilderX86_64::HandleFieldGet(HInstruction* instruction) {
   DCHECK(instruction->IsInstanceFieldGet() || instruction->IsStaticFieldGet());
 
   bool object_field_get_with_read_barrier =
-      kEmitCompilerReadBarrier && (instruction->GetType() == Primitive::kPrimNot);
+      kEmitCompilerReadBarrier &&
+      (instruction->GetType() == Primitive::kPrimNot) &&
+      !CodeGenerator::IsReadBarrierElided(instruction);
   LocationSummary* locations =
       new (GetGraph()->GetArena()) LocationSummary(instruction,
                                                    object_field_get_with_read_barrier ?
@@ -4314,6 +4485,10 @@ void LocationsBuilderX86_64::HandleFieldGet(HInstruction* instruction) {
     locations->SetCustomSlowPathCallerSaves(RegisterSet::Empty());  // No caller-save registers.
   }
   locations->SetInAt(0, Location::RequiresRegister());
+  if (instruction->IsEmittedAtUseSite()) {
+    // The load is folded into the compare using it.
+    return;
+  }
   if (Primitive::IsFloatingPointType(instruction->GetType())) {
     locations->SetOut(Location::RequiresFpuRegister());
   } else {
@@ -4329,6 +4504,9 @@ void LocationsBuilderX86_64::HandleFieldGet(HInstruction* instruction) {
 void InstructionCodeGeneratorX86_64::HandleFieldGet(HInstruction* instruction,
                                                     const FieldInfo& field_info) {
   DCHECK(instruction->IsInstanceFieldGet() || instruction->IsStaticFieldGet());
+  if (instruction->IsEmittedAtUseSite()) {
+    return;
+  }
 
   LocationSummary* locations = instruction->GetLocations();
   Location base_loc = locations->InAt(0);
@@ -4366,7 +4544,9 @@ void InstructionCodeGeneratorX86_64::HandleFieldGet(HInstruction* instruction,
 
     case Primitive::kPrimNot: {
       // /* HeapReference<Object> */ out = *(base + offset)
-      if (kEmitCompilerReadBarrier && kUseBakerReadBarrier) {
+      if (kEmitCompilerReadBarrier &&
+          kUseBakerReadBarrier &&
+          !CodeGenerator::IsReadBarrierElided(instruction)) {
         // Note that a potential implicit null check is handled in this
         // CodeGeneratorX86_64::GenerateFieldLoadWithBakerReadBarrier call.
         codegen_->GenerateFieldLoadWithBakerReadBarrier(
@@ -4380,10 +4560,15 @@ void InstructionCodeGeneratorX86_64::HandleFieldGet(HInstruction* instruction,
         if (is_volatile) {
           codegen_->GenerateMemoryBarrier(MemBarrierKind::kLoadAny);
         }
-        // If read barriers are enabled, emit read barriers other than
-        // Baker's using a slow path (and also unpoison the loaded
-        // reference, if heap poisoning is enabled).
-        codegen_->MaybeGenerateReadBarrierSlow(instruction, out, out, base_loc, offset);
+        if (CodeGenerator::IsReadBarrierElided(instruction)) {
+          // The GC is not marking, the reference only needs unpoisoning.
+          __ MaybeUnpoisonHeapReference(out.AsRegister<CpuRegister>());
+        } else {
+          // If read barriers are enabled, emit read barriers other than
+          // Baker's using a slow path (and also unpoison the loaded
+          // reference, if heap poisoning is enabled).
+          codegen_->MaybeGenerateReadBarrierSlow(instruction, out, out, base_loc, offset);
+        }
       }
       break;
     }
@@ -4434,7 +4619,7 @@ void LocationsBuilderX86_64::HandleFieldSet(HInstruction* instruction,
   Primitive::Type field_type = field_info.GetFieldType();
   bool is_volatile = field_info.IsVolatile();
   bool needs_write_barrier =
-      CodeGenerator::StoreNeedsWriteBarrier(field_type, instruction->InputAt(1));
+      CodeGenerator::FieldStoreNeedsWriteBarrier(instruction, field_type);
 
   locations->SetInAt(0, Location::RequiresRegister());
   if (Primitive::IsFloatingPointType(instruction->InputAt(1)->GetType())) {
@@ -4574,7 +4759,7 @@ void InstructionCodeGeneratorX86_64::HandleFieldSet(HInstruction* instruction,
     codegen_->MaybeRecordImplicitNullCheck(instruction);
   }
 
-  if (CodeGenerator::StoreNeedsWriteBarrier(field_type, instruction->InputAt(1))) {
+  if (CodeGenerator::FieldStoreNeedsWriteBarrier(instruction, field_type)) {
     CpuRegister temp = locations->GetTemp(0).AsRegister<CpuRegister>();
     CpuRegister card = locations->GetTemp(1).AsRegister<CpuRegister>();
     codegen_->MarkGCCard(temp, card, base, value.AsRegister<CpuRegister>(), value_can_be_null);
@@ -4730,7 +4915,9 @@ void InstructionCodeGeneratorX86_64::VisitNullCheck(HNullCheck* instruction) {
 
 void LocationsBuilderX86_64::VisitArrayGet(HArrayGet* instruction) {
   bool object_array_get_with_read_barrier =
-      kEmitCompilerReadBarrier && (instruction->GetType() == Primitive::kPrimNot);
+      kEmitCompilerReadBarrier &&
+      (instruction->GetType() == Primitive::kPrimNot) &&
+      !CodeGenerator::IsReadBarrierElided(instruction);
   LocationSummary* locations =
       new (GetGraph()->GetArena()) LocationSummary(instruction,
                                                    object_array_get_with_read_barrier ?
@@ -4741,6 +4928,10 @@ void LocationsBuilderX86_64::VisitArrayGet(HArrayGet* instruction) {
   }
   locations->SetInAt(0, Location::RequiresRegister());
   locations->SetInAt(1, Location::RegisterOrConstant(instruction->InputAt(1)));
+  if (instruction->IsEmittedAtUseSite()) {
+    // The load is folded into the compare using it.
+    return;
+  }
   if (Primitive::IsFloatingPointType(instruction->GetType())) {
     locations->SetOut(Location::RequiresFpuRegister(), Location::kNoOutputOverlap);
   } else {
@@ -4754,6 +4945,10 @@ void LocationsBuilderX86_64::VisitArrayGet(HArrayGet* instruction) {
 }
 
 void InstructionCodeGeneratorX86_64::VisitArrayGet(HArrayGet* instruction) {
+  if (instruction->IsEmittedAtUseSite()) {
+    return;
+  }
+
   LocationSummary* locations = instruction->GetLocations();
   Location obj_loc = locations->InAt(0);
   CpuRegister obj = obj_loc.AsRegister<CpuRegister>();
@@ -4815,7 +5010,9 @@ void InstructionCodeGeneratorX86_64::VisitArrayGet(HArrayGet* instruction) {
           "art::mirror::HeapReference<art::mirror::Object> and int32_t have different sizes.");
       // /* HeapReference<Object> */ out =
       //     *(obj + data_offset + index * sizeof(HeapReference<Object>))
-      if (kEmitCompilerReadBarrier && kUseBakerReadBarrier) {
+      if (kEmitCompilerReadBarrier &&
+          kUseBakerReadBarrier &&
+          !CodeGenerator::IsReadBarrierElided(instruction)) {
         // Note that a potential implicit null check is handled in this
         // CodeGeneratorX86_64::GenerateArrayLoadWithBakerReadBarrier call.
         codegen_->GenerateArrayLoadWithBakerReadBarrier(
@@ -4827,7 +5024,10 @@ void InstructionCodeGeneratorX86_64::VisitArrayGet(HArrayGet* instruction) {
         // If read barriers are enabled, emit read barriers other than
         // Baker's using a slow path (and also unpoison the loaded
         // reference, if heap poisoning is enabled).
-        if (index.IsConstant()) {
+        if (CodeGenerator::IsReadBarrierElided(instruction)) {
+          // The GC is not marking, the reference only needs unpoisoning.
+          __ MaybeUnpoisonHeapReference(out);
+        } else if (index.IsConstant()) {
           uint32_t offset =
               (index.GetConstant()->AsIntConstant()->GetValue() << TIMES_4) + data_offset;
           codegen_->MaybeGenerateReadBarrierSlow(instruction, out_loc, out_loc, obj_loc, offset);
@@ -5269,6 +5469,180 @@ void InstructionCodeGeneratorX86_64::VisitX86BoundsCheckMemory(HX86BoundsCheckMe
   __ j(kBelowEqual, slow_path->GetEntryLabel());
 }
 
+void LocationsBuilderX86_64::VisitX86ArrayAlignmentPeeling(
+    HX86ArrayAlignmentPeeling* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kNoCall);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RegisterOrConstant(instruction->InputAt(1)));
+  locations->SetOut(Location::RequiresRegister(), Location::kNoOutputOverlap);
+}
+
+void InstructionCodeGeneratorX86_64::VisitX86ArrayAlignmentPeeling(
+    HX86ArrayAlignmentPeeling* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  CpuRegister array = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+  size_t component_size = Primitive::ComponentSize(instruction->GetComponentType());
+  uint32_t data_offset = mirror::Array::DataOffset(component_size).Uint32Value();
+  ScaleFactor scale = static_cast<ScaleFactor>(WhichPowerOf2(component_size));
+
+  // out = (-&array[index] & (alignment - 1)) / component_size, on the low 32 bits
+  // of the address which are enough to tell the alignment.
+  __ leal(out, CodeGeneratorX86_64::ArrayAddress(array, locations->InAt(1), scale, data_offset));
+  __ negl(out);
+  __ andl(out, Immediate(static_cast<int32_t>(instruction->GetAlignment()) - 1));
+  if (scale != TIMES_1) {
+    __ shrl(out, Immediate(scale));
+  }
+}
+
+void LocationsBuilderX86_64::VisitX86Prefetch(HX86Prefetch* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kNoCall);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RegisterOrConstant(instruction->GetIndex()));
+  if (instruction->IsIndirect()) {
+    locations->AddTemp(Location::RequiresRegister());
+  }
+}
+
+void InstructionCodeGeneratorX86_64::VisitX86Prefetch(HX86Prefetch* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  CpuRegister array = locations->InAt(0).AsRegister<CpuRegister>();
+  Location index = locations->InAt(1);
+  size_t component_size = Primitive::ComponentSize(instruction->GetComponentType());
+  uint32_t data_offset = mirror::Array::DataOffset(component_size).Uint32Value();
+  ScaleFactor scale = static_cast<ScaleFactor>(WhichPowerOf2(component_size));
+  int32_t distance = instruction->GetDistance();
+  auto prefetch = [&](const Address& address) {
+    if (instruction->GetHint() == HX86Prefetch::kPrefetchNTA) {
+      __ prefetchnta(address);
+    } else {
+      __ prefetcht0(address);
+    }
+  };
+
+  if (!instruction->IsIndirect()) {
+    // A prefetch past the bounds of the array is harmless, it does not fault.
+    int32_t offset =
+        static_cast<int32_t>(data_offset) + distance * static_cast<int32_t>(component_size);
+    prefetch(CodeGeneratorX86_64::ArrayAddress(array, index, scale, static_cast<uint32_t>(offset)));
+    return;
+  }
+
+  // Load array[index + distance] when it is in the bounds, the unsigned comparison also
+  // rejecting the negative elements. The reference is read without barrier: the prefetch
+  // only needs an address close to the object.
+  CpuRegister element = locations->GetTemp(0).AsRegister<CpuRegister>();
+  NearLabel done;
+  if (index.IsConstant()) {
+    uint32_t value = static_cast<uint32_t>(CodeGenerator::GetInt32ValueOf(index.GetConstant()));
+    __ movl(element, Immediate(static_cast<int32_t>(value + static_cast<uint32_t>(distance))));
+  } else {
+    __ leal(element, Address(index.AsRegister<CpuRegister>(), distance));
+  }
+  __ cmpl(element, Address(array, mirror::Array::LengthOffset().Uint32Value()));
+  __ j(kAboveEqual, &done);
+  __ movl(element, Address(array, element, TIMES_4, data_offset));
+  __ MaybeUnpoisonHeapReference(element);
+  prefetch(Address(element, instruction->GetFieldOffset()));
+  __ Bind(&done);
+}
+
+void LocationsBuilderX86_64::VisitX86IncrementCounter(HX86IncrementCounter* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kNoCall);
+  locations->AddTemp(Location::RequiresRegister());
+}
+
+void InstructionCodeGeneratorX86_64::VisitX86IncrementCounter(HX86IncrementCounter* instruction) {
+  CpuRegister address = instruction->GetLocations()->GetTemp(0).AsRegister<CpuRegister>();
+  // The counter is not in the code cache, it may be out of the reach of RIP-relative addresses.
+  codegen_->Load64BitValue(address, reinterpret_cast<intptr_t>(instruction->GetCounter()));
+  __ addq(Address(address, 0), Immediate(1));
+}
+
+void LocationsBuilderX86_64::VisitX86IsGcMarking(HX86IsGcMarking* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kNoCall);
+  locations->SetOut(Location::RequiresRegister());
+}
+
+void InstructionCodeGeneratorX86_64::VisitX86IsGcMarking(HX86IsGcMarking* instruction) {
+  CpuRegister out = instruction->GetLocations()->Out().AsRegister<CpuRegister>();
+  __ gs()->movl(out,
+                Address::Absolute(Thread::IsGcMarkingOffset<kX86_64PointerSize>().Int32Value(),
+                                  /* no_rip */ true));
+}
+
+void LocationsBuilderX86_64::VisitX86ReadModifyWriteMemory(
+    HX86ReadModifyWriteMemory* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kNoCall);
+  locations->SetInAt(0, Location::RegisterOrConstant(instruction->GetValue()));
+  locations->SetInAt(1, Location::RequiresRegister());
+  if (instruction->GetIndex() != nullptr) {
+    locations->SetInAt(2, Location::RegisterOrConstant(instruction->GetIndex()));
+  }
+}
+
+void InstructionCodeGeneratorX86_64::VisitX86ReadModifyWriteMemory(
+    HX86ReadModifyWriteMemory* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Location value = locations->InAt(0);
+  CpuRegister base = locations->InAt(1).AsRegister<CpuRegister>();
+  size_t offset = instruction->GetOffset();
+  Address address = (instruction->GetIndex() == nullptr) ?
+      Address(base, offset) :
+      CodeGeneratorX86_64::ArrayAddress(base, locations->InAt(2), TIMES_4, offset);
+
+  if (value.IsConstant()) {
+    Immediate imm(CodeGenerator::GetInt32ValueOf(value.GetConstant()));
+    switch (instruction->GetOpKind()) {
+      case HInstruction::kAdd:
+        __ addl(address, imm);
+        break;
+      case HInstruction::kSub:
+        __ subl(address, imm);
+        break;
+      case HInstruction::kAnd:
+        __ andl(address, imm);
+        break;
+      case HInstruction::kOr:
+        __ orl(address, imm);
+        break;
+      case HInstruction::kXor:
+        __ xorl(address, imm);
+        break;
+      default:
+        LOG(FATAL) << "Unexpected read-modify-write operation " << instruction->GetOpKind();
+    }
+  } else {
+    CpuRegister reg = value.AsRegister<CpuRegister>();
+    switch (instruction->GetOpKind()) {
+      case HInstruction::kAdd:
+        __ addl(address, reg);
+        break;
+      case HInstruction::kSub:
+        __ subl(address, reg);
+        break;
+      case HInstruction::kAnd:
+        __ andl(address, reg);
+        break;
+      case HInstruction::kOr:
+        __ orl(address, reg);
+        break;
+      case HInstruction::kXor:
+        __ xorl(address, reg);
+        break;
+      default:
+        LOG(FATAL) << "Unexpected read-modify-write operation " << instruction->GetOpKind();
+    }
+  }
+  codegen_->MaybeRecordImplicitNullCheck(instruction);
+}
+
 void CodeGeneratorX86_64::MarkGCCard(CpuRegister temp,
                                      CpuRegister card,
                                      CpuRegister object,
@@ -5446,8 +5820,13 @@ void ParallelMoveResolverX86_64::EmitMove(size_t index) {
     }
   } else if (source.IsSIMDStackSlot()) {
     DCHECK(destination.IsFpuRegister());
-    __ movups(destination.AsFpuRegister<XmmRegister>(),
-              Address(CpuRegister(RSP), source.GetStackIndex()));
+    if (codegen_->HasAVX2Vectors()) {
+      __ vmovups(destination.AsFpuRegister<XmmRegister>(),
+                 Address(CpuRegister(RSP), source.GetStackIndex()));
+    } else {
+      __ movups(destination.AsFpuRegister<XmmRegister>(),
+                Address(CpuRegister(RSP), source.GetStackIndex()));
+    }
   } else if (source.IsConstant()) {
     HConstant* constant = source.GetConstant();
     if (constant->IsIntConstant() || constant->IsNullConstant()) {
@@ -5494,7 +5873,11 @@ void ParallelMoveResolverX86_64::EmitMove(size_t index) {
     }
   } else if (source.IsFpuRegister()) {
     if (destination.IsFpuRegister()) {
-      __ movaps(destination.AsFpuRegister<XmmRegister>(), source.AsFpuRegister<XmmRegister>());
+      if (codegen_->HasAVX2Vectors()) {
+        __ vmovaps(destination.AsFpuRegister<XmmRegister>(), source.AsFpuRegister<XmmRegister>());
+      } else {
+        __ movaps(destination.AsFpuRegister<XmmRegister>(), source.AsFpuRegister<XmmRegister>());
+      }
     } else if (destination.IsStackSlot()) {
       __ movss(Address(CpuRegister(RSP), destination.GetStackIndex()),
                source.AsFpuRegister<XmmRegister>());
@@ -5503,8 +5886,13 @@ void ParallelMoveResolverX86_64::EmitMove(size_t index) {
                source.AsFpuRegister<XmmRegister>());
     } else {
        DCHECK(destination.IsSIMDStackSlot());
-      __ movups(Address(CpuRegister(RSP), destination.GetStackIndex()),
-                source.AsFpuRegister<XmmRegister>());
+      if (codegen_->HasAVX2Vectors()) {
+        __ vmovups(Address(CpuRegister(RSP), destination.GetStackIndex()),
+                   source.AsFpuRegister<XmmRegister>());
+      } else {
+        __ movups(Address(CpuRegister(RSP), destination.GetStackIndex()),
+                  source.AsFpuRegister<XmmRegister>());
+      }
     }
   }
 }
@@ -5584,6 +5972,15 @@ void ParallelMoveResolverX86_64::EmitSwap(size_t index) {
     Exchange64(destination.AsRegister<CpuRegister>(), source.GetStackIndex());
   } else if (source.IsDoubleStackSlot() && destination.IsDoubleStackSlot()) {
     Exchange64(destination.GetStackIndex(), source.GetStackIndex());
+  } else if (source.IsFpuRegister() && destination.IsFpuRegister() &&
+             codegen_->HasAVX2Vectors()) {
+    // Use XOR Swap algorithm to swap the whole YMM registers without a temporary.
+    DCHECK_NE(source.reg(), destination.reg());
+    XmmRegister src_reg = source.AsFpuRegister<XmmRegister>();
+    XmmRegister dst_reg = destination.AsFpuRegister<XmmRegister>();
+    __ vxorpd(dst_reg, dst_reg, src_reg);
+    __ vxorpd(src_reg, src_reg, dst_reg);
+    __ vxorpd(dst_reg, dst_reg, src_reg);
   } else if (source.IsFpuRegister() && destination.IsFpuRegister()) {
     __ movd(CpuRegister(TMP), source.AsFpuRegister<XmmRegister>());
     __ movaps(source.AsFpuRegister<XmmRegister>(), destination.AsFpuRegister<XmmRegister>());
@@ -209,6 +209,12 @@ class InstructionCodeGeneratorX86_64 : public InstructionCodeGenerator {
   // the suspend call.
   void GenerateSuspendCheck(HSuspendCheck* instruction, HBasicBlock* successor);
   void GenerateClassInitializationCheck(SlowPathCode* slow_path, CpuRegister class_reg);
+  // Allocate `size` bytes from the TLAB of the thread for an object of the class `klass`, or
+  // jump to `slow_path`. Clobbers `size` and, with heap poisoning, `klass`.
+  void GenerateTlabAllocation(CpuRegister klass,
+                              CpuRegister size,
+                              CpuRegister out,
+                              NearLabel* slow_path);
   void HandleBitwiseOperation(HBinaryOperation* operation);
   void GenerateRemFP(HRem* rem);
   void DivRemOneOrMinusOne(HBinaryOperation* instruction);
@@ -266,6 +272,9 @@ class InstructionCodeGeneratorX86_64 : public InstructionCodeGenerator {
   void PushOntoFPStack(Location source, uint32_t temp_offset,
                        uint32_t stack_adjustment, bool is_float);
   void GenerateCompareTest(HCondition* condition);
+  // Compare the int inputs of a condition, the right one possibly being a load
+  // folded into the compare by X86MemoryOperandGeneration.
+  void GenerateConditionIntCompare(HCondition* condition);
   template<class LabelType>
   void GenerateTestAndBranch(HInstruction* instruction,
                              size_t condition_input_index,
@@ -328,11 +337,22 @@ class CodeGeneratorX86_64 : public CodeGenerator {
   }
 
   size_t GetFloatingPointSpillSlotSize() const OVERRIDE {
-    return GetGraph()->HasSIMD()
-        ? 2 * kX86_64WordSize   // 16 bytes == 2 x86_64 words for each spill
-        : 1 * kX86_64WordSize;  //  8 bytes == 1 x86_64 words for each spill
+    if (GetGraph()->HasSIMD()) {
+      return HasAVX2Vectors()
+          ? 4 * kX86_64WordSize   // 32 bytes == 4 x86_64 words for each spill
+          : 2 * kX86_64WordSize;  // 16 bytes == 2 x86_64 words for each spill
+    }
+    return 1 * kX86_64WordSize;  //  8 bytes == 1 x86_64 words for each spill
+  }
+
+  // Whether the vector code of the graph uses the 256-bit YMM registers.
+  bool HasAVX2Vectors() const {
+    return GetGraph()->HasSIMD() && isa_features_.HasAVX2();
   }
 
+  // Clear the upper halves of the YMM registers before leaving for SSE code.
+  void MaybeGenerateVZeroUpper();
+
   HGraphVisitor* GetLocationBuilder() OVERRIDE {
     return &location_builder_;
   }
@@ -579,6 +599,11 @@ class CodeGeneratorX86_64 : public CodeGenerator {
     }
   }
 
+  // Align the headers of the innermost loops, for the hot methods: a small loop crossing a
+  // 16-byte boundary needs more fetches per iteration, and Atom cores do not stream it from
+  // their loop buffer.
+  void SetAlignLoopHeaders(bool value) { align_loop_headers_ = value; }
+
   void GenerateNop() OVERRIDE;
   void GenerateImplicitNullCheck(HNullCheck* instruction) OVERRIDE;
   void GenerateExplicitNullCheck(HNullCheck* instruction) OVERRIDE;
@@ -605,6 +630,8 @@ class CodeGeneratorX86_64 : public CodeGenerator {
   // Used for fixups to the constant area.
   int constant_area_start_;
 
+  bool align_loop_headers_;
+
   // PC-relative method patch info for kBootImageLinkTimePcRelative.
   ArenaDeque<PatchInfo<Label>> boot_image_method_patches_;
   // PC-relative method patch info for kBssEntry.
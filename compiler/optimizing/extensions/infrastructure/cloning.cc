@@ -1148,6 +1148,9 @@ void HInstructionCloner::VisitSuspend(HSuspend* instr) {
 void HInstructionCloner::VisitSuspendCheck(HSuspendCheck* instr) {
   if (cloning_enabled_) {
     HSuspendCheck* clone = new (arena_) HSuspendCheck(instr->GetDexPc());
+    if (!instr->CanBeOsrEntry()) {
+      clone->DisableOsrEntry();
+    }
     CloneEnvironment(instr, clone);
     CommitClone(instr, clone);
   }
@@ -1336,4 +1339,14 @@ void HInstructionCloner::VisitX86BoundsCheckMemory(HX86BoundsCheckMemory* instr)
   }
 }
 
+void HInstructionCloner::VisitX86ArrayAlignmentPeeling(HX86ArrayAlignmentPeeling* instr) {
+  if (cloning_enabled_) {
+    HInstruction* array, *index;
+    GetInputsForBinary(instr, &array, &index);
+    HX86ArrayAlignmentPeeling* clone = new (arena_) HX86ArrayAlignmentPeeling(
+        array, index, instr->GetComponentType(), instr->GetAlignment(), instr->GetDexPc());
+    CommitClone(instr, clone);
+  }
+}
+
 }  // namespace art
@@ -246,6 +246,11 @@ class HInstructionCloner : public HGraphVisitor {
   void VisitX86FPNeg(HX86FPNeg* instr) OVERRIDE;
   void VisitX86PackedSwitch(HX86PackedSwitch* instr) OVERRIDE;
   void VisitX86BoundsCheckMemory(HX86BoundsCheckMemory* instr) OVERRIDE;
+  void VisitX86ArrayAlignmentPeeling(HX86ArrayAlignmentPeeling* instr) OVERRIDE;
+  void VisitX86ReadModifyWriteMemory(HX86ReadModifyWriteMemory* instr) OVERRIDE {
+    // Like the HInstructionRHSMemory family, only generated by the backend.
+    UnsupportedInstruction(instr);
+  }
 
  private:
   void GetInputsForUnary(HInstruction* instr, HInstruction** input_ptr) const;
@@ -21,6 +21,7 @@
  */
 
 #include "ext_alias.h"
+#include "graph_x86.h"
 
 namespace art {
 
@@ -241,6 +242,15 @@ AliasCheck::AliasKind AliasCheck::Array_alias(HInstruction* x, HInstruction* y)
     return Array_index_alias(x->InputAt(1), y->InputAt(1));
   }
 
+  // A runtime check, for instance from loop versioning, may have proven the bases different.
+  if (x->GetBlock() != nullptr && y->GetBlock() != nullptr) {
+    HGraph_X86* graph = GRAPH_TO_GRAPH_X86(x->GetBlock()->GetGraph());
+    if (graph->AreArraysDisjoint(x->InputAt(0), y->InputAt(0), x->GetBlock()) &&
+        graph->AreArraysDisjoint(x->InputAt(0), y->InputAt(0), y->GetBlock())) {
+      return kNoAlias;
+    }
+  }
+
   // Look at the type after looking at the base, as there are some cases where
   // the ArraySet is a long and the ArrayGet is a double.  This may be fixed in
   // a later AOSP.
@@ -124,4 +124,69 @@ void HGraph_X86::MovePhi(HPhi* phi, HBasicBlock* to_block) {
   }
 }
 
+void HGraph_X86::LinkClonedBlocks(const SafeMap<HBasicBlock*, HBasicBlock*>& old_to_new,
+                                  HBasicBlock* old_entry_pred,
+                                  HBasicBlock* new_entry_pred) {
+  for (const auto& it : old_to_new) {
+    HBasicBlock* original = it.first;
+    HBasicBlock* copy = it.second;
+    DCHECK(copy->GetSuccessors().empty());
+    DCHECK(copy->GetPredecessors().empty());
+
+    for (HBasicBlock* successor : original->GetSuccessors()) {
+      auto successor_it = old_to_new.find(successor);
+      if (successor_it != old_to_new.end()) {
+        // The copy of successor records this edge when its predecessors are processed.
+        copy->successors_.push_back(successor_it->second);
+      } else {
+        copy->successors_.push_back(successor);
+        successor->predecessors_.push_back(copy);
+      }
+    }
+
+    for (HBasicBlock* predecessor : original->GetPredecessors()) {
+      auto predecessor_it = old_to_new.find(predecessor);
+      if (predecessor_it != old_to_new.end()) {
+        copy->predecessors_.push_back(predecessor_it->second);
+      } else {
+        DCHECK_EQ(predecessor, old_entry_pred);
+        copy->predecessors_.push_back(new_entry_pred);
+        new_entry_pred->successors_.push_back(copy);
+      }
+    }
+  }
+}
+
+static HInstruction* SkipNullCheck(HInstruction* insn) {
+  return insn->IsNullCheck() ? insn->InputAt(0) : insn;
+}
+
+void HGraph_X86::AddDisjointArrays(HBasicBlock* guard,
+                                   HInstruction* array1,
+                                   HInstruction* array2) {
+  disjoint_arrays_.push_back({ guard, SkipNullCheck(array1), SkipNullCheck(array2) });
+}
+
+bool HGraph_X86::AreArraysDisjoint(HInstruction* array1,
+                                   HInstruction* array2,
+                                   HBasicBlock* block) const {
+  array1 = SkipNullCheck(array1);
+  array2 = SkipNullCheck(array2);
+  for (const DisjointArrays& fact : disjoint_arrays_) {
+    // The guard may have been removed or merged by a later pass.
+    HBasicBlock* guard = fact.guard;
+    if (guard->GetBlockId() < 0 ||
+        static_cast<size_t>(guard->GetBlockId()) >= blocks_.size() ||
+        blocks_[guard->GetBlockId()] != guard) {
+      continue;
+    }
+    bool same_pair = (fact.array1 == array1 && fact.array2 == array2) ||
+                     (fact.array1 == array2 && fact.array2 == array1);
+    if (same_pair && guard->Dominates(block)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace art
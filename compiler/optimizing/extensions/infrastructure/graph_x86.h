@@ -22,6 +22,8 @@
 #ifndef ART_OPT_INFRASTRUCTURE_GRAPH_X86_H_
 #define ART_OPT_INFRASTRUCTURE_GRAPH_X86_H_
 
+#include <algorithm>
+
 #include "nodes.h"
 #include "loop_information.h"
 #include "optimizing_compiler_stats.h"
@@ -35,6 +37,19 @@ namespace art {
 #define GRAPH_TO_GRAPH_X86(X) static_cast<HGraph_X86*>(X)
 #endif
 
+/**
+ * @brief The analyses cached by HGraph_X86 across extension passes.
+ * @details A pass declares which of them it invalidates, see
+ *          HOptimization_X86::GetInvalidatedAnalyses.
+ */
+enum HAnalysisKind : uint32_t {
+  kAnalysisNone = 0u,
+  kAnalysisLoopHierarchy = 1u << 0,        /**!< HLoopInformation_X86 nesting. */
+  kAnalysisInductionVariables = 1u << 1,   /**!< HInductionVariable sets of the loops. */
+  kAnalysisLoopBounds = 1u << 2,           /**!< HLoopBoundInformation of the loops. */
+  kAnalysisAll = kAnalysisLoopHierarchy | kAnalysisInductionVariables | kAnalysisLoopBounds,
+};
+
 class HGraph_X86 : public HGraph {
  public:
   //neeraj - resolve build errors
@@ -43,7 +58,11 @@ class HGraph_X86 : public HGraph {
       bool debuggable = false, bool osr = false, int start_instruction_id = 0) :
           HGraph(arena, dex_file, method_idx, instruction_set, invoke_type,
             debuggable, osr, start_instruction_id),
-          loop_information_(nullptr) {
+          loop_information_(nullptr),
+          valid_analyses_(kAnalysisNone),
+          disjoint_arrays_(arena->Adapter(kArenaAllocMisc)),
+          boosted_inlining_headers_(arena->Adapter(kArenaAllocMisc)),
+          counted_loops_(arena->Adapter(kArenaAllocMisc)) {
 #ifndef NDEBUG
         down_cast_checker_ = GRAPH_MAGIC;
 #endif
@@ -66,6 +85,36 @@ class HGraph_X86 : public HGraph {
    */
   void ClearLoopInformation() {
     loop_information_ = nullptr;
+    InvalidateAnalyses(kAnalysisAll);
+  }
+
+  /**
+   * @brief Are the cached analyses still up to date?
+   * @param analyses a mask of HAnalysisKind.
+   * @return true if all analyses of the mask are valid.
+   */
+  bool AreAnalysesValid(uint32_t analyses) const {
+    return (valid_analyses_ & analyses) == analyses;
+  }
+
+  /**
+   * @brief Mark analyses as up to date, once they have been computed.
+   * @param analyses a mask of HAnalysisKind.
+   */
+  void MarkAnalysesValid(uint32_t analyses) {
+    valid_analyses_ |= analyses;
+  }
+
+  /**
+   * @brief Mark analyses as stale, they will be recomputed on next request.
+   * @param analyses a mask of HAnalysisKind.
+   */
+  void InvalidateAnalyses(uint32_t analyses) {
+    // The IVs and bounds are attached to the loop hierarchy.
+    if ((analyses & kAnalysisLoopHierarchy) != 0) {
+      analyses = kAnalysisAll;
+    }
+    valid_analyses_ &= ~analyses;
   }
 
   /**
@@ -110,11 +159,17 @@ class HGraph_X86 : public HGraph {
   /**
    * @brief Used to create a new basic that is added to graph.
    * @param dex_pc The dex pc of this block (optional).
+   * @param same_try_as A block the new block is placed next to (optional): if it is
+   * covered by a try, so is the new block.
    * @return Returns the newly created block.
    */
-  HBasicBlock* CreateNewBasicBlock(uint32_t dex_pc = kNoDexPc) {
+  HBasicBlock* CreateNewBasicBlock(uint32_t dex_pc = kNoDexPc,
+                                   HBasicBlock* same_try_as = nullptr) {
     HBasicBlock* new_block = new (arena_) HBasicBlock(this, dex_pc);
     AddBlock(new_block);
+    if (same_try_as != nullptr && same_try_as->IsTryBlock()) {
+      new_block->SetTryCatchInformation(same_try_as->GetTryCatchInformation());
+    }
     return new_block;
   }
 
@@ -140,12 +195,96 @@ class HGraph_X86 : public HGraph {
    */
   void MovePhi(HPhi* phi, HBasicBlock* to_block);
 
+  /**
+   * @brief Link copies of blocks the same way their originals are linked.
+   * @details Successor and predecessor orders are preserved, so that cloned
+   * branches and phis keep their meaning. Edges leaving the copied region go to
+   * the original targets, and the single edge entering it comes from new_entry_pred.
+   * @param old_to_new Mapping from the original blocks to their copies.
+   * @param old_entry_pred The predecessor of the region outside it.
+   * @param new_entry_pred The block from which the copied region is entered.
+   */
+  void LinkClonedBlocks(const SafeMap<HBasicBlock*, HBasicBlock*>& old_to_new,
+                        HBasicBlock* old_entry_pred,
+                        HBasicBlock* new_entry_pred);
+
+  /**
+   * @brief Record that two arrays are different objects wherever guard dominates.
+   * @details This comes from a runtime check, typically emitted by loop versioning.
+   */
+  void AddDisjointArrays(HBasicBlock* guard, HInstruction* array1, HInstruction* array2);
+
+  /**
+   * @brief Are the two arrays known to be different objects at block?
+   */
+  bool AreArraysDisjoint(HInstruction* array1, HInstruction* array2, HBasicBlock* block) const;
+
+  /**
+   * @brief Record that the inliner raised its budget for a call site of the loop of header.
+   */
+  void AddBoostedInliningLoop(HBasicBlock* header) {
+    if (std::find(boosted_inlining_headers_.begin(), boosted_inlining_headers_.end(), header) ==
+        boosted_inlining_headers_.end()) {
+      boosted_inlining_headers_.push_back(header);
+    }
+  }
+
+  /**
+   * @brief Does loop contain a call site inlined thanks to a raised budget?
+   * @details The headers recorded by the inliner may have been moved inside the loop
+   * since, by peeling or bottom testing, so any recorded block of the loop counts.
+   */
+  bool HasBoostedInlining(HLoopInformation_X86* loop) const {
+    for (HBasicBlock* header : boosted_inlining_headers_) {
+      if (loop->Contains(*header)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  struct CountedLoop {
+    HBasicBlock* header;
+    const char* pass_name;
+  };
+
+  /**
+   * @brief Record that pass transformed the loop of header, for HLoopCounters to count it.
+   * @details The header may be removed from the graph by later passes, the records are
+   * checked against the graph when the counters are inserted.
+   */
+  void AddCountedLoop(HBasicBlock* header, const char* pass_name) {
+    counted_loops_.push_back({header, pass_name});
+  }
+
+  const ArenaVector<CountedLoop>& GetCountedLoops() const {
+    return counted_loops_;
+  }
+
  protected:
 #ifndef NDEBUG
   uint32_t down_cast_checker_;
 #endif
 
   HLoopInformation_X86* loop_information_;
+
+  // Mask of HAnalysisKind that are up to date.
+  uint32_t valid_analyses_;
+
+  struct DisjointArrays {
+    HBasicBlock* guard;
+    HInstruction* array1;
+    HInstruction* array2;
+  };
+
+  // Array pairs proven different by a runtime check, see AddDisjointArrays.
+  ArenaVector<DisjointArrays> disjoint_arrays_;
+
+  // Headers of the loops whose call sites got a raised inlining budget.
+  ArenaVector<HBasicBlock*> boosted_inlining_headers_;
+
+  // Loops transformed by the extension passes, see AddCountedLoop.
+  ArenaVector<CountedLoop> counted_loops_;
 };
 
 /**
@@ -307,6 +307,19 @@ bool HLoopInformation_X86::ComputeBoundInformation() {
           end_value -= 1;
         }
         bound_info_.comparison_condition_ = kCondGT;
+      } else if (bound_info_.comparison_condition_ == kCondNE) {
+        // i != 15 is i < 15 counting up from below, or i > 15 counting down from above,
+        // when the IV reaches the bound exactly. Otherwise it wraps around, or never stops.
+        uint64_t distance = (start_value < end_value) ?
+            static_cast<uint64_t>(end_value) - static_cast<uint64_t>(start_value) :
+            static_cast<uint64_t>(start_value) - static_cast<uint64_t>(end_value);
+        uint64_t step = (increment < 0) ?
+            0u - static_cast<uint64_t>(increment) :
+            static_cast<uint64_t>(increment);
+        if (distance % step != 0u) {
+          return false;
+        }
+        bound_info_.comparison_condition_ = bound_info_.is_simple_count_up_ ? kCondLT : kCondGT;
       }
 
       if (bound_info_.is_simple_count_up_) {
@@ -347,11 +360,22 @@ bool HLoopInformation_X86::ComputeBoundInformation() {
         return false;
       }
 
-      int64_t num_iterations = (end_value - start_value) / increment;
-      if (((end_value - start_value) % increment) != 0) {
+      // Count in unsigned magnitudes: the distance between two longs may not fit a long.
+      uint64_t distance = bound_info_.is_simple_count_up_ ?
+          static_cast<uint64_t>(end_value) - static_cast<uint64_t>(start_value) :
+          static_cast<uint64_t>(start_value) - static_cast<uint64_t>(end_value);
+      uint64_t step = bound_info_.is_simple_count_up_ ?
+          static_cast<uint64_t>(increment) :
+          0u - static_cast<uint64_t>(increment);
+      uint64_t iterations = distance / step;
+      if ((distance % step) != 0u) {
         // If the mod is non-zero, then we will execute this one more iteration.
-        num_iterations++;
+        iterations++;
+      }
+      if (iterations > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        return false;
       }
+      int64_t num_iterations = static_cast<int64_t>(iterations);
 
       // Fill the structure.
       bound_info_.biv_start_value_ = start_value;
@@ -667,7 +691,7 @@ size_t HLoopInformation_X86::GetLoopExitCount() const {
   return count;
 }
 
-bool HLoopInformation_X86::CanSideExit(bool ignore_suspends) const {
+bool HLoopInformation_X86::CanSideExit(bool ignore_suspends, bool ignore_cha_guards) const {
   for (HBlocksInLoopIterator bb_it(*this); !bb_it.Done(); bb_it.Advance()) {
     HBasicBlock* bb = bb_it.Current();
     for (HInstructionIterator insn_it(bb->GetInstructions()); !insn_it.Done(); insn_it.Advance()) {
@@ -676,6 +700,11 @@ bool HLoopInformation_X86::CanSideExit(bool ignore_suspends) const {
         if (ignore_suspends && (insn->IsSuspendCheck() || insn->IsSuspend())) {
           continue;
         }
+        if (ignore_cha_guards &&
+            insn->IsDeoptimize() &&
+            insn->AsDeoptimize()->GetDeoptimizationKind() == DeoptimizationKind::kCHA) {
+          continue;
+        }
         return true;
       }
     }
@@ -1189,10 +1218,8 @@ bool HLoopInformation_X86::PeelHelperHead() {
 
   for (HBlocksInLoopIterator it_loop(*this); !it_loop.Done(); it_loop.Advance()) {
     HBasicBlock* original = it_loop.Current();
-    HBasicBlock* copy = graph->CreateNewBasicBlock(original->GetDexPc());
+    HBasicBlock* copy = graph->CreateNewBasicBlock(original->GetDexPc(), original);
     DCHECK(copy != nullptr);
-    if(this->GetPreHeader()->IsTryBlock())
-    copy->SetTryCatchInformation(this->GetPreHeader()->GetTryCatchInformation());
     old_to_new_bbs.Put(original, copy);
     peeled_blocks_.push_back(copy->GetBlockId());
   }
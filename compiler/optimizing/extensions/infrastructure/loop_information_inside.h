@@ -440,9 +440,10 @@ class HLoopInformation_X86 : public HLoopInformation {
   /**
    * @brief Determines whether the loop contains opcodes that can exit the block unexpectedly.
    * @param ignore_suspends Should HSuspendCheck and HSuspend be ignored during the check?
+   * @param ignore_cha_guards Should the HDeoptimize of the CHA guards be ignored during the check?
    * @return 'true' if any instruction in the loop has an environment.
    */
-  bool CanSideExit(bool ignore_suspends = true) const;
+  bool CanSideExit(bool ignore_suspends = true, bool ignore_cha_guards = false) const;
 
   /**
    * @brief Estimate the number of cycles for one loop execution.
@@ -487,12 +487,12 @@ bool HLoopPartialUnrolling::UnrollBody(uint64_t num_iterations, uint64_t unrolli
   return true;
 }
 
-bool HLoopPartialUnrolling::PartialUnroll() {
+bool HLoopPartialUnrolling::PartialUnroll(uint64_t unroll_factor) {
 
   uint64_t num_iterations = loop_->GetNumIterations(loop_->GetHeader());
 
   // Unroll the loop body.
-  if (!UnrollBody(num_iterations,2)) {
+  if (!UnrollBody(num_iterations, unroll_factor)) {
     return false;
   }
 
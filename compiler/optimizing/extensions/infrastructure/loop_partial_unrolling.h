@@ -35,10 +35,11 @@ class HLoopPartialUnrolling {
   /**
    * @brief Partially unrolls the loop by the provided factor if possible. The user
    * must check the feasability of the unrolling before with a call to Gate().
+   * @param unroll_factor The unrolling factor, which must be the one given to Gate().
    * @return Returns true if the unrolling was successful, or false otherwise.
    * @sa Gate.
    */
-  bool PartialUnroll();
+  bool PartialUnroll(uint64_t unroll_factor);
   /**
    * @brief Makes sure the provided loop complies with the restrictions of loop unrolling.
    * @param max_unrolled_instructions The maximum amount of instructions tolerated for unrolling.
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loop_unroll_cost_model.h"
+
+#include <limits>
+#include <set>
+
+#include "arch/instruction_set_features.h"
+#include "arch/x86/instruction_set_features_x86.h"
+#include "loop_information.h"
+
+namespace art {
+
+// Indexed by CoreKind.
+const HLoopUnrollCostModel::TargetParameters HLoopUnrollCostModel::kTargetParameters[] = {
+  // Generic: the thresholds used before the cost model existed.
+  { 2u, 120u, 60u, std::numeric_limits<uint64_t>::max() },
+  // Atom: the loop stream detector holds few micro-ops, but the in-order
+  // leaning pipeline benefits a lot from independent copies of short bodies.
+  { 4u, 64u, 40u, 32u },
+  // Big core: large decoded micro-op cache and out-of-order window.
+  { 8u, 160u, 100u, 64u },
+};
+
+// Registers left to the allocator once the stack pointer and reserved registers are removed.
+static constexpr uint64_t kX86CoreRegisters = 6u;
+static constexpr uint64_t kX86FpRegisters = 8u;
+static constexpr uint64_t kX86_64CoreRegisters = 13u;
+static constexpr uint64_t kX86_64FpRegisters = 16u;
+
+HLoopUnrollCostModel::HLoopUnrollCostModel(const InstructionSetFeatures* features)
+    : core_kind_(kCoreGeneric),
+      // Only the register files of the x86 targets are modeled, the others are not limited.
+      num_core_registers_(std::numeric_limits<uint64_t>::max()),
+      num_fp_registers_(std::numeric_limits<uint64_t>::max()) {
+  if (features == nullptr) {
+    return;
+  }
+  InstructionSet isa = features->GetInstructionSet();
+  if (isa != kX86 && isa != kX86_64) {
+    return;
+  }
+  if (isa == kX86) {
+    num_core_registers_ = kX86CoreRegisters;
+    num_fp_registers_ = kX86FpRegisters;
+  } else {
+    num_core_registers_ = kX86_64CoreRegisters;
+    num_fp_registers_ = kX86_64FpRegisters;
+  }
+  const X86InstructionSetFeatures* x86_features = features->AsX86InstructionSetFeatures();
+  if (x86_features->HasAVX2()) {
+    core_kind_ = kCoreBig;
+  } else if (x86_features->HasSSE4_2()) {
+    core_kind_ = kCoreAtom;
+  }
+}
+
+uint64_t HLoopUnrollCostModel::GetMaxFullyUnrolledInstructions() const {
+  return GetParameters().max_fully_unrolled_instructions;
+}
+
+uint64_t HLoopUnrollCostModel::GetMaxPartiallyUnrolledInstructions() const {
+  return GetParameters().max_partially_unrolled_instructions;
+}
+
+static bool IsOfRegisterClass(Primitive::Type type, bool is_fp) {
+  if (type == Primitive::kPrimVoid) {
+    return false;
+  }
+  return Primitive::IsFloatingPointType(type) == is_fp;
+}
+
+uint64_t HLoopUnrollCostModel::EstimateRegisterPressure(HLoopInformation_X86* loop,
+                                                        uint64_t factor,
+                                                        bool is_fp) {
+  std::set<HInstruction*> invariants;
+  uint64_t carried = 0;
+  uint64_t per_copy = 0;
+
+  for (HInstructionIterator it(loop->GetHeader()->GetPhis()); !it.Done(); it.Advance()) {
+    if (IsOfRegisterClass(it.Current()->GetType(), is_fp)) {
+      carried++;
+    }
+  }
+
+  for (HBlocksInLoopIterator bb_it(*loop); !bb_it.Done(); bb_it.Advance()) {
+    HBasicBlock* block = bb_it.Current();
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* insn = it.Current();
+      for (size_t i = 0, e = insn->InputCount(); i < e; ++i) {
+        HInstruction* input = insn->InputAt(i);
+        // Constants are mostly encoded as immediates.
+        if (!input->IsConstant() &&
+            !loop->Contains(*input->GetBlock()) &&
+            IsOfRegisterClass(input->GetType(), is_fp)) {
+          invariants.insert(input);
+        }
+      }
+      // A value consumed right away by the next instruction does not stay live.
+      if (IsOfRegisterClass(insn->GetType(), is_fp) && insn->HasNonEnvironmentUses()) {
+        bool consumed_by_next = insn->HasOnlyOneNonEnvironmentUse() &&
+                                insn->GetUses().front().GetUser() == insn->GetNext();
+        if (!consumed_by_next) {
+          per_copy++;
+        }
+      }
+    }
+  }
+
+  return invariants.size() + carried + factor * per_copy;
+}
+
+uint64_t HLoopUnrollCostModel::ChoosePartialUnrollFactor(HLoopInformation_X86* loop) const {
+  const TargetParameters& params = GetParameters();
+
+  if (!loop->HasKnownNumIterations()) {
+    return 1u;
+  }
+
+  uint64_t body_cost = 0;
+  if (!loop->GetLoopCost(&body_cost) || body_cost > params.max_body_cost) {
+    return 1u;
+  }
+
+  uint64_t num_iterations = loop->GetNumIterations(loop->GetHeader());
+  uint64_t body_iterations = num_iterations;
+  if (!loop->IsBottomTested()) {
+    body_iterations = (num_iterations == 0u) ? 0u : num_iterations - 1;
+  }
+  uint64_t body_size = loop->CountInstructionsInBody(true);
+
+  for (uint64_t factor = params.max_unroll_factor; factor >= 2u; factor /= 2u) {
+    if (body_iterations < factor || body_iterations % factor != 0) {
+      continue;
+    }
+    if (factor * body_size > params.max_partially_unrolled_instructions) {
+      continue;
+    }
+    if (EstimateRegisterPressure(loop, factor, false) > num_core_registers_ ||
+        EstimateRegisterPressure(loop, factor, true) > num_fp_registers_) {
+      continue;
+    }
+    return factor;
+  }
+
+  return 1u;
+}
+
+std::ostream& operator<<(std::ostream& os, const HLoopUnrollCostModel::CoreKind& kind) {
+  switch (kind) {
+    case HLoopUnrollCostModel::kCoreGeneric:
+      return os << "generic";
+    case HLoopUnrollCostModel::kCoreAtom:
+      return os << "atom";
+    case HLoopUnrollCostModel::kCoreBig:
+      return os << "big-core";
+  }
+  return os << "unknown";
+}
+
+}  // namespace art
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_OPT_INFRASTRUCTURE_LOOP_UNROLL_COST_MODEL_H_
+#define ART_OPT_INFRASTRUCTURE_LOOP_UNROLL_COST_MODEL_H_
+
+#include "nodes.h"
+
+namespace art {
+
+// Forward declarations.
+class HLoopInformation_X86;
+class InstructionSetFeatures;
+
+/**
+ * @brief Per-target cost model deciding how much a loop can be unrolled.
+ * @details The target is classified from its X86InstructionSetFeatures: AVX2
+ * identifies a big core (Haswell/Skylake), SSE4.2 without AVX2 an Atom core
+ * (Silvermont/Goldmont). Each class has its own front-end budget and maximum
+ * factor, from which the factor of a given loop is derived using its trip count
+ * and body cost. The estimated register pressure must also fit the register file
+ * on x86 and x86-64; the other targets keep the legacy thresholds only.
+ */
+class HLoopUnrollCostModel {
+ public:
+  enum CoreKind {
+    kCoreGeneric,  // Unknown target: keeps the legacy fixed thresholds.
+    kCoreAtom,     // Silvermont, Goldmont.
+    kCoreBig,      // Haswell, Skylake.
+  };
+
+  explicit HLoopUnrollCostModel(const InstructionSetFeatures* features);
+
+  CoreKind GetCoreKind() const {
+    return core_kind_;
+  }
+
+  /**
+   * @brief Get the maximum number of instructions a loop may have once fully unrolled.
+   */
+  uint64_t GetMaxFullyUnrolledInstructions() const;
+
+  /**
+   * @brief Get the maximum number of instructions a loop body may have once partially unrolled.
+   */
+  uint64_t GetMaxPartiallyUnrolledInstructions() const;
+
+  /**
+   * @brief Choose the partial unrolling factor of the loop.
+   * @details The factor is the largest power of two allowed by the target such that
+   * the body trip count is a multiple of it, the unrolled body fits the front-end
+   * budget, and the estimated register pressure fits the register file.
+   * @param loop The loop to unroll, with its bounds computed.
+   * @return The unroll factor, 1 when unrolling is not profitable.
+   */
+  uint64_t ChoosePartialUnrollFactor(HLoopInformation_X86* loop) const;
+
+  /**
+   * @brief Estimate the number of registers needed by the loop unrolled by factor.
+   * @details Loop invariants and loop carried values are live through the whole
+   * body, while each copy adds the values it keeps alive across other instructions.
+   * @param loop The loop to consider.
+   * @param factor The unrolling factor.
+   * @param is_fp Whether to count the floating point registers instead of the core ones.
+   */
+  static uint64_t EstimateRegisterPressure(HLoopInformation_X86* loop,
+                                           uint64_t factor,
+                                           bool is_fp);
+
+ private:
+  struct TargetParameters {
+    uint64_t max_unroll_factor;
+    uint64_t max_partially_unrolled_instructions;
+    uint64_t max_fully_unrolled_instructions;
+    // Unrolling a body above this cost does not pay for the code growth.
+    uint64_t max_body_cost;
+  };
+
+  static const TargetParameters kTargetParameters[];
+
+  const TargetParameters& GetParameters() const {
+    return kTargetParameters[core_kind_];
+  }
+
+  CoreKind core_kind_;
+  uint64_t num_core_registers_;
+  uint64_t num_fp_registers_;
+};
+
+std::ostream& operator<<(std::ostream& os, const HLoopUnrollCostModel::CoreKind& kind);
+
+}  // namespace art
+
+#endif  // ART_OPT_INFRASTRUCTURE_LOOP_UNROLL_COST_MODEL_H_
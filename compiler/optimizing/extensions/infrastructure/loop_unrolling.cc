@@ -60,11 +60,8 @@ void HLoopUnrolling::CreateBasicBlocks(LoopBody& dst_body, uint64_t iteration_co
     }
 
     // Create a new basic block.
-    HBasicBlock* bb_copy = graph_->CreateNewBasicBlock(src_bb->GetDexPc());
+    HBasicBlock* bb_copy = graph_->CreateNewBasicBlock(src_bb->GetDexPc(), src_bb);
     DCHECK(bb_copy != nullptr);
-    if(loop_->GetHeader()->IsTryBlock()){
-      bb_copy->SetTryCatchInformation(loop_->GetHeader()->GetTryCatchInformation());
-      }
      // Add it to the old to copy basic block map.
     if (old_to_new_bbs_.find(src_bb) != old_to_new_bbs_.end()) {
       old_to_new_bbs_.Overwrite(src_bb, bb_copy);
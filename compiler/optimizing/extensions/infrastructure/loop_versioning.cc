@@ -0,0 +1,511 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cloning.h"
+#include "ext_utility.h"
+#include "graph_x86.h"
+#include "loop_information.h"
+#include "loop_versioning.h"
+#include "mirror/object.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+HLoopVersioning::HLoopVersioning(HLoopInformation_X86* loop, HOptimization_X86* optim)
+    : loop_(loop),
+      graph_(GRAPH_TO_GRAPH_X86(loop->GetGraph())),
+      optim_(optim),
+      checks_(graph_->GetArena()->Adapter(kArenaAllocMisc)) {}
+
+static HInstruction* SkipNullCheck(HInstruction* insn) {
+  return insn->IsNullCheck() ? insn->InputAt(0) : insn;
+}
+
+void HLoopVersioning::AddCheck(const Check& check) {
+  for (const Check& other : checks_) {
+    if (other.kind == check.kind &&
+        other.first == check.first &&
+        other.second == check.second &&
+        other.start == check.start &&
+        other.min_length == check.min_length &&
+        other.min_iterations == check.min_iterations &&
+        (other.get_class == nullptr) == (check.get_class == nullptr)) {
+      return;
+    }
+  }
+  checks_.push_back(check);
+}
+
+void HLoopVersioning::AddArrayIdentityCheck(HInstruction* array1, HInstruction* array2) {
+  array1 = SkipNullCheck(array1);
+  array2 = SkipNullCheck(array2);
+  if (array1->GetId() > array2->GetId()) {
+    std::swap(array1, array2);
+  }
+  AddCheck({ kCheckIdentity, array1, array2, nullptr, nullptr,
+             ReferenceTypeInfo::CreateInvalid(), 0 , nullptr });
+}
+
+void HLoopVersioning::AddMinimumIterationsCheck(HInstruction* start,
+                                                HInstruction* end,
+                                                int64_t min_iterations) {
+  DCHECK_EQ(start->GetType(), end->GetType());
+  DCHECK(Primitive::IsIntOrLongType(start->GetType()));
+  AddCheck({ kCheckIterations, start, end, nullptr, nullptr,
+             ReferenceTypeInfo::CreateInvalid(), min_iterations , nullptr });
+}
+
+void HLoopVersioning::AddNotNullCheck(HInstruction* value) {
+  DCHECK_EQ(value->GetType(), Primitive::kPrimNot);
+  AddCheck({ kCheckNotNull, SkipNullCheck(value), nullptr, nullptr, nullptr,
+             ReferenceTypeInfo::CreateInvalid(), 0 , nullptr });
+}
+
+void HLoopVersioning::AddArrayLengthCheck(HInstruction* array, HInstruction* end) {
+  DCHECK_EQ(end->GetType(), Primitive::kPrimInt);
+  AddCheck({ kCheckArrayLength, SkipNullCheck(array), end, nullptr, nullptr,
+             ReferenceTypeInfo::CreateInvalid(), 0 , nullptr });
+}
+
+void HLoopVersioning::AddArrayRowsCheck(HInstruction* row,
+                                        HInstruction* start,
+                                        HInstruction* end,
+                                        HInstruction* min_length) {
+  DCHECK(row->IsArrayGet());
+  DCHECK_EQ(row->GetType(), Primitive::kPrimNot);
+  AddCheck({ kCheckArrayRows, SkipNullCheck(row->InputAt(0)), end, start, min_length,
+             row->GetReferenceTypeInfo(), 0 , nullptr });
+}
+
+void HLoopVersioning::AddClassCheck(HInstanceFieldGet* get_class,
+                                    HInstruction* value,
+                                    HLoadClass* klass) {
+  DCHECK_EQ(value->GetType(), Primitive::kPrimNot);
+  AddCheck({ kCheckClass, SkipNullCheck(value), klass, nullptr, nullptr,
+             ReferenceTypeInfo::CreateInvalid(), 0, get_class });
+}
+
+void HLoopVersioning::AddNotGcMarkingCheck() {
+  AddCheck({ kCheckNotGcMarking, nullptr, nullptr, nullptr, nullptr,
+             ReferenceTypeInfo::CreateInvalid(), 0, nullptr });
+}
+
+bool HLoopVersioning::GetTypeGuard(HInstruction* condition,
+                                   HInstanceFieldGet** get_class,
+                                   HInstruction** value,
+                                   HLoadClass** klass) {
+  if (!condition->IsNotEqual()) {
+    return false;
+  }
+  HInstruction* left = condition->InputAt(0);
+  HInstruction* right = condition->InputAt(1);
+  if (!left->IsLoadClass()) {
+    std::swap(left, right);
+  }
+  // The inliner loads the class of the receiver from its shadow$_klass_ field.
+  if (!left->IsLoadClass() ||
+      !right->IsInstanceFieldGet() ||
+      right->AsInstanceFieldGet()->GetFieldOffset().Uint32Value() !=
+          mirror::Object::ClassOffset().Uint32Value()) {
+    return false;
+  }
+  *get_class = right->AsInstanceFieldGet();
+  *value = SkipNullCheck(right->InputAt(0));
+  *klass = left->AsLoadClass();
+  return true;
+}
+
+bool HLoopVersioning::Gate(uint64_t max_instructions) const {
+  if (checks_.empty()) {
+    PRINT_PASS_OSTREAM_MESSAGE(optim_, "Versioning failed because there is nothing to check.");
+    return false;
+  }
+
+  if (loop_->IsOrHasIrreducibleLoop()) {
+    PRINT_PASS_OSTREAM_MESSAGE(optim_, "Versioning failed because the loop is irreducible.");
+    return false;
+  }
+
+  if (loop_->HasTryCatchHandler()) {
+    PRINT_PASS_OSTREAM_MESSAGE(optim_, "Versioning failed because the loop has a catch handler.");
+    return false;
+  }
+
+  HBasicBlock* pre_header = loop_->GetPreHeader();
+  if (pre_header == nullptr ||
+      pre_header->GetSuccessors().size() != 1u ||
+      !pre_header->GetLastInstruction()->IsGoto()) {
+    PRINT_PASS_OSTREAM_MESSAGE(optim_, "Versioning failed because of the pre-header shape.");
+    return false;
+  }
+
+  // Both versions join at the exit, where the phis merging their values are created. A loop
+  // inside a try is versioned like any other, but not one leaving it: its exit block holds
+  // the TryBoundary and is not a place for phis.
+  if (!loop_->HasOneExitEdge()) {
+    PRINT_PASS_OSTREAM_MESSAGE(optim_, "Versioning failed because the loop has multiple exits.");
+    return false;
+  }
+  HBasicBlock* exit_block = loop_->GetExitBlock();
+  if (exit_block->GetPredecessors().size() != 1u ||
+      !exit_block->GetPhis().IsEmpty() ||
+      exit_block->EndsWithTryBoundary()) {
+    PRINT_PASS_OSTREAM_MESSAGE(optim_, "Versioning failed because of the exit block shape.");
+    return false;
+  }
+
+  if (loop_->CountInstructionsInBody(true) > max_instructions) {
+    PRINT_PASS_OSTREAM_MESSAGE(optim_, "Versioning failed because the loop is too big.");
+    return false;
+  }
+
+  // The checks are emitted in the pre-header, so everything they use must be available there.
+  for (const Check& check : checks_) {
+    HInstruction* values[] = { check.first, check.second, check.start, check.min_length };
+    bool is_in_loop = false;
+    for (HInstruction* value : values) {
+      is_in_loop |= (value != nullptr && loop_->Contains(*value->GetBlock()));
+    }
+    if (is_in_loop) {
+      PRINT_PASS_OSTREAM_MESSAGE(optim_, "Versioning failed because a checked value is "
+                                         "defined in the loop.");
+      return false;
+    }
+  }
+
+  constexpr bool enable_cloning = false;
+  HInstructionCloner cloner(graph_, enable_cloning);
+  for (HBlocksInLoopIterator it_loop(*loop_); !it_loop.Done(); it_loop.Advance()) {
+    HBasicBlock* block = it_loop.Current();
+    cloner.VisitBasicBlock(block);
+    if (cloner.AllOkay() == false) {
+      PRINT_PASS_OSTREAM_MESSAGE(optim_,
+        "Versioning failed because found instruction which cannot be cloned: " <<
+            cloner.GetDebugNameForFailedClone());
+      return false;
+    }
+  }
+
+  return true;
+}
+
+HInstruction* HLoopVersioning::AddCondition(HBasicBlock* guard, const Check& check) {
+  ArenaAllocator* arena = graph_->GetArena();
+  uint32_t dex_pc = guard->GetLastInstruction()->GetDexPc();
+  HInstruction* cursor = guard->GetLastInstruction();
+  HInstruction* condition = nullptr;
+
+  switch (check.kind) {
+    case kCheckIdentity:
+      condition = new (arena) HNotEqual(check.first, check.second, dex_pc);
+      break;
+    case kCheckIterations: {
+      Primitive::Type type = check.first->GetType();
+      HInstruction* iterations = new (arena) HSub(type, check.second, check.first, dex_pc);
+      guard->InsertInstructionBefore(iterations, cursor);
+      condition = new (arena) HGreaterThanOrEqual(
+          iterations, graph_->GetConstant(type, check.min_iterations), dex_pc);
+      break;
+    }
+    case kCheckNotNull:
+      condition = new (arena) HNotEqual(check.first, graph_->GetNullConstant(dex_pc), dex_pc);
+      break;
+    case kCheckArrayLength: {
+      HInstruction* length = new (arena) HArrayLength(check.first, dex_pc);
+      guard->InsertInstructionBefore(length, cursor);
+      condition = new (arena) HGreaterThanOrEqual(length, check.second, dex_pc);
+      break;
+    }
+    case kCheckClass: {
+      const FieldInfo& field_info = check.get_class->GetFieldInfo();
+      HInstanceFieldGet* get_class = new (arena) HInstanceFieldGet(
+          check.first,
+          field_info.GetField(),
+          Primitive::kPrimNot,
+          field_info.GetFieldOffset(),
+          field_info.IsVolatile(),
+          field_info.GetFieldIndex(),
+          field_info.GetDeclaringClassDefIndex(),
+          field_info.GetDexFile(),
+          dex_pc);
+      // Like the type guards, the class of an object does not depend on memory.
+      get_class->SetSideEffects(SideEffects::None());
+      guard->InsertInstructionBefore(get_class, cursor);
+      condition = new (arena) HEqual(get_class, check.second, dex_pc);
+      break;
+    }
+    case kCheckNotGcMarking: {
+      HInstruction* is_marking = new (arena) HX86IsGcMarking(dex_pc);
+      guard->InsertInstructionBefore(is_marking, cursor);
+      condition = new (arena) HEqual(is_marking, graph_->GetIntConstant(0), dex_pc);
+      break;
+    }
+    default:
+      LOG(FATAL) << "Unexpected check kind " << static_cast<int>(check.kind);
+      UNREACHABLE();
+  }
+
+  guard->InsertInstructionBefore(condition, cursor);
+  return condition;
+}
+
+void HLoopVersioning::AddRowsGuard(HBasicBlock* guard,
+                                   HBasicBlock* next,
+                                   HBasicBlock* slow_pre_header,
+                                   const Check& check) {
+  ArenaAllocator* arena = graph_->GetArena();
+  uint32_t dex_pc = guard->GetLastInstruction()->GetDexPc();
+  DCHECK(guard->GetLastInstruction()->IsGoto());
+
+  // for (k = start; k < end; k++) {
+  //   if (array[k] == null || array[k].length < min_length) goto slow;
+  // }
+  HBasicBlock* header = graph_->CreateNewBasicBlock(dex_pc, guard);
+  HBasicBlock* body = graph_->CreateNewBasicBlock(dex_pc, guard);
+  HBasicBlock* latch = graph_->CreateNewBasicBlock(dex_pc, guard);
+  guard->ReplaceSuccessor(slow_pre_header, header);
+
+  HPhi* index = new (arena) HPhi(arena, kNoRegNumber, 0, Primitive::kPrimInt);
+  header->AddPhi(index);
+  HInstruction* in_range = new (arena) HLessThan(index, check.second, dex_pc);
+  header->AddInstruction(in_range);
+  header->AddInstruction(new (arena) HIf(in_range, dex_pc));
+  header->AddSuccessor(body);
+  header->AddSuccessor(next);
+
+  HInstruction* row = new (arena) HArrayGet(check.first, index, Primitive::kPrimNot, dex_pc);
+  row->SetReferenceTypeInfo(check.row_type);
+  body->AddInstruction(row);
+  HInstruction* not_null = new (arena) HNotEqual(row, graph_->GetNullConstant(dex_pc), dex_pc);
+  body->AddInstruction(not_null);
+  body->AddInstruction(new (arena) HIf(not_null, dex_pc));
+  body->AddSuccessor(latch);
+  body->AddSuccessor(slow_pre_header);
+
+  HInstruction* length = new (arena) HArrayLength(row, dex_pc);
+  latch->AddInstruction(length);
+  HInstruction* long_enough = new (arena) HGreaterThanOrEqual(length, check.min_length, dex_pc);
+  latch->AddInstruction(long_enough);
+  HInstruction* next_index = new (arena) HAdd(Primitive::kPrimInt, index,
+                                              graph_->GetIntConstant(1), dex_pc);
+  latch->AddInstruction(next_index);
+  latch->AddInstruction(new (arena) HIf(long_enough, dex_pc));
+  latch->AddSuccessor(header);
+  latch->AddSuccessor(slow_pre_header);
+
+  // The header is entered from guard first, then from the latch.
+  index->AddInput(check.start);
+  index->AddInput(next_index);
+}
+
+void HLoopVersioning::AddGuards(HBasicBlock* slow_pre_header, HBasicBlock* fast_pre_header) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HBasicBlock* guard = loop_->GetPreHeader();
+  DCHECK_EQ(guard->GetSingleSuccessor(), slow_pre_header);
+
+  for (size_t i = 0, e = checks_.size(); i < e; ++i) {
+    const Check& check = checks_[i];
+    uint32_t dex_pc = guard->GetLastInstruction()->GetDexPc();
+
+    // The last guard leads to the fast version, the others to the next guard.
+    HBasicBlock* next = fast_pre_header;
+    if (i + 1 != e) {
+      next = graph_->CreateNewBasicBlock(dex_pc, guard);
+      next->AddInstruction(new (arena) HGoto(dex_pc));
+      // Placeholder replaced by the next guard, to keep the loop uniform.
+      next->AddSuccessor(slow_pre_header);
+    }
+
+    if (check.kind == kCheckArrayRows) {
+      AddRowsGuard(guard, next, slow_pre_header, check);
+    } else {
+      HInstruction* condition = AddCondition(guard, check);
+      guard->ReplaceAndRemoveInstructionWith(guard->GetLastInstruction(),
+                                             new (arena) HIf(condition, dex_pc));
+
+      // The true successor must come first.
+      guard->ReplaceSuccessor(slow_pre_header, next);
+      guard->AddSuccessor(slow_pre_header);
+    }
+    guard = next;
+  }
+}
+
+void HLoopVersioning::CloneInstructions(const SafeMap<HBasicBlock*, HBasicBlock*>& old_to_new) {
+  HInstructionCloner cloner(graph_);
+  HBasicBlock* exit_block = loop_->GetExitBlock();
+
+  // Walk in reverse post-order so that cloning works correctly in using cloned inputs.
+  for (HBlocksInLoopReversePostOrderIterator block_it(*loop_); !block_it.Done(); block_it.Advance()) {
+    HBasicBlock* original_bb = block_it.Current();
+    for (HInstructionIterator it(original_bb->GetPhis()); !it.Done(); it.Advance()) {
+      it.Current()->Accept(&cloner);
+    }
+    for (HInstructionIterator it(original_bb->GetInstructions()); !it.Done(); it.Advance()) {
+      it.Current()->Accept(&cloner);
+    }
+  }
+  DCHECK(cloner.AllOkay());
+
+  for (HBlocksInLoopReversePostOrderIterator block_it(*loop_); !block_it.Done(); block_it.Advance()) {
+    HBasicBlock* original_bb = block_it.Current();
+    HBasicBlock* copy_bb = old_to_new.Get(original_bb);
+    for (HInstructionIterator it(original_bb->GetPhis()); !it.Done(); it.Advance()) {
+      copy_bb->AddPhi(cloner.GetClone(it.Current())->AsPhi());
+    }
+    for (HInstructionIterator it(original_bb->GetInstructions()); !it.Done(); it.Advance()) {
+      copy_bb->AddInstruction(cloner.GetClone(it.Current()));
+    }
+  }
+
+  // Phis may use values defined later in the loop, which were not cloned yet when
+  // the phi was: switch them to the clones now.
+  for (HBlocksInLoopIterator block_it(*loop_); !block_it.Done(); block_it.Advance()) {
+    for (HInstructionIterator it(block_it.Current()->GetPhis()); !it.Done(); it.Advance()) {
+      HInstruction* phi = it.Current();
+      HInstruction* phi_clone = cloner.GetClone(phi);
+      for (size_t i = 0, e = phi->InputCount(); i < e; ++i) {
+        HInstruction* input_clone = cloner.GetClone(phi->InputAt(i));
+        if (input_clone != nullptr && phi_clone->InputAt(i) != input_clone) {
+          phi_clone->ReplaceInput(input_clone, i);
+        }
+      }
+    }
+  }
+
+  // Finally merge the values used after the loop.
+  for (HBlocksInLoopIterator block_it(*loop_); !block_it.Done(); block_it.Advance()) {
+    HBasicBlock* original_bb = block_it.Current();
+    for (HInstructionIterator it(original_bb->GetPhis()); !it.Done(); it.Advance()) {
+      AddExitPhis(exit_block, it.Current(), cloner.GetClone(it.Current()));
+    }
+    for (HInstructionIterator it(original_bb->GetInstructions()); !it.Done(); it.Advance()) {
+      AddExitPhis(exit_block, it.Current(), cloner.GetClone(it.Current()));
+    }
+  }
+}
+
+void HLoopVersioning::AddExitPhis(HBasicBlock* exit_block,
+                                  HInstruction* orig,
+                                  HInstruction* clone) {
+  HPhi* new_phi = nullptr;
+  for (HAllUseIterator use_it(orig); !use_it.Done(); use_it.Advance()) {
+    HInstruction* user = use_it.Current();
+    // The copy only uses clones, and the users in the loop keep the original.
+    if (!loop_->Contains(*user->GetBlock()) && user != new_phi) {
+      if (new_phi == nullptr) {
+        uint32_t reg_number = orig->IsPhi() ? orig->AsPhi()->GetRegNumber() : kNoRegNumber;
+        new_phi = new (graph_->GetArena()) HPhi(graph_->GetArena(), reg_number,
+            0, HPhi::ToPhiType(orig->GetType()));
+        exit_block->AddPhi(new_phi);
+        // The exit block is reached from the slow version first, then from the fast one.
+        new_phi->AddInput(orig);
+        new_phi->AddInput(clone);
+        if (orig->GetType() == Primitive::kPrimNot) {
+          new_phi->SetReferenceTypeInfo(orig->GetReferenceTypeInfo());
+        }
+      }
+      use_it.ReplaceInput(new_phi);
+    }
+  }
+}
+
+void HLoopVersioning::FoldTypeGuards(const SafeMap<HBasicBlock*, HBasicBlock*>& old_to_new) {
+  for (const auto& entry : old_to_new) {
+    HBasicBlock* copy_bb = entry.second;
+    for (HInstructionIterator it(copy_bb->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* insn = it.Current();
+      if (!insn->IsIf() && !(insn->IsDeoptimize() && insn->AsDeoptimize()->GuardsAnInput())) {
+        continue;
+      }
+      HInstanceFieldGet* get_class = nullptr;
+      HInstruction* value = nullptr;
+      HLoadClass* klass = nullptr;
+      if (!GetTypeGuard(insn->InputAt(0), &get_class, &value, &klass)) {
+        continue;
+      }
+      for (const Check& check : checks_) {
+        if (check.kind != kCheckClass ||
+            check.first != value ||
+            !check.second->AsLoadClass()->InstructionDataEquals(klass)) {
+          continue;
+        }
+        if (insn->IsIf()) {
+          // The guard fails, the other branch leading to the invoke is now dead.
+          insn->ReplaceInput(graph_->GetIntConstant(0), 0);
+        } else {
+          // The guarded value is the object, of the expected class.
+          insn->ReplaceWith(insn->AsDeoptimize()->GuardedInput());
+          copy_bb->RemoveInstruction(insn);
+        }
+        break;
+      }
+    }
+  }
+}
+
+HBasicBlock* HLoopVersioning::Version() {
+  HBasicBlock* header = loop_->GetHeader();
+  HBasicBlock* pre_header = loop_->GetPreHeader();
+  HBasicBlock* exit_block = loop_->GetExitBlock();
+  DCHECK(exit_block != nullptr);
+
+  // Make a copy of each block.
+  SafeMap<HBasicBlock*, HBasicBlock*> old_to_new_bbs;
+  for (HBlocksInLoopIterator it_loop(*loop_); !it_loop.Done(); it_loop.Advance()) {
+    HBasicBlock* original = it_loop.Current();
+    HBasicBlock* copy = graph_->CreateNewBasicBlock(original->GetDexPc(), original);
+    old_to_new_bbs.Put(original, copy);
+  }
+
+  // The original loop becomes the slow version, entered when a check fails.
+  HBasicBlock* slow_pre_header = graph_->CreateNewBasicBlock(header->GetDexPc(), pre_header);
+  slow_pre_header->InsertBetween(pre_header, header);
+  slow_pre_header->AddInstruction(new (graph_->GetArena()) HGoto(header->GetDexPc()));
+
+  HBasicBlock* fast_pre_header = graph_->CreateNewBasicBlock(header->GetDexPc(), pre_header);
+  fast_pre_header->AddInstruction(new (graph_->GetArena()) HGoto(header->GetDexPc()));
+  AddGuards(slow_pre_header, fast_pre_header);
+
+  // Link the copy, entered from the fast pre-header and leaving to the same exit.
+  graph_->LinkClonedBlocks(old_to_new_bbs, slow_pre_header, fast_pre_header);
+  DCHECK_EQ(exit_block->GetPredecessors().size(), 2u);
+
+  CloneInstructions(old_to_new_bbs);
+
+  // Everything the fast pre-header dominates runs with the checks succeeded.
+  for (const Check& check : checks_) {
+    if (check.kind == kCheckIdentity) {
+      graph_->AddDisjointArrays(fast_pre_header, check.first, check.second);
+    }
+  }
+  FoldTypeGuards(old_to_new_bbs);
+
+  HBasicBlock* fast_header = old_to_new_bbs.Get(header);
+
+  // Rebuild the dominator tree and the loops, as the dead code elimination does. Exit
+  // edges from the two versions are critical, they get split here.
+  graph_->HGraph::ClearLoopInformation();
+  graph_->ClearDominanceInformation();
+  GraphAnalysisResult result = graph_->BuildDominatorTree();
+  DCHECK_EQ(result, kAnalysisSuccess);
+  UNUSED(result);
+  graph_->ClearLoopInformation();
+
+  return fast_header;
+}
+
+}  // namespace art
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_OPT_INFRASTRUCTURE_LOOP_VERSIONING_H_
+#define ART_OPT_INFRASTRUCTURE_LOOP_VERSIONING_H_
+
+#include "graph_x86.h"
+#include "loop_iterators.h"
+#include "nodes.h"
+
+namespace art {
+
+// Forward declarations.
+class HOptimization_X86;
+
+/**
+ * @brief Duplicate a loop behind runtime checks.
+ * @details The copy, the fast version, only runs when all checks succeed and the
+ * facts they establish are recorded in the graph, so that later passes can rely on
+ * them there. The original loop is kept unchanged as the slow version.
+ * Array identity checks need no range: Java arrays are either the same object
+ * or fully disjoint, so this also covers the overlap of any index ranges.
+ * Null, length and rows checks let the fast version drop the NullCheck and
+ * BoundsCheck instructions they cover. Class checks remove the type guards they
+ * cover from the fast version. The GC marking check lets the fast version load
+ * references without read barrier.
+ */
+class HLoopVersioning {
+ public:
+  // Code duplication is only worth it for small loops.
+  static constexpr uint64_t kDefaultMaxInstructions = 64;
+
+  HLoopVersioning(HLoopInformation_X86* loop, HOptimization_X86* optim);
+
+  /**
+   * @brief Collect the headers of the loops of graph, visited by LoopIterator, that
+   * filter accepts.
+   * @details Versioning rebuilds the loop information, so the passes only remember
+   * the headers of the loops they version.
+   */
+  template <typename LoopIterator, typename Filter>
+  static ArenaVector<HBasicBlock*> CollectHeaders(HGraph_X86* graph, Filter filter) {
+    ArenaVector<HBasicBlock*> headers(graph->GetArena()->Adapter(kArenaAllocMisc));
+    for (LoopIterator it(graph->GetLoopInformation()); !it.Done(); it.Advance()) {
+      if (filter(it.Current())) {
+        headers.push_back(it.Current()->GetHeader());
+      }
+    }
+    return headers;
+  }
+
+  /**
+   * @brief Version each inner loop of graph for which collect_checks adds the checks.
+   * @details The loop hierarchy must be formed. It is invalidated once any loop is
+   * versioned, the caller forms it again.
+   * @param collect_checks Called with each loop and its HLoopVersioning, returns true
+   * if the loop should be versioned.
+   * @param max_instructions The maximum number of instructions of a versioned loop.
+   * @return The headers of the fast versions.
+   */
+  template <typename CollectChecks>
+  static ArenaVector<HBasicBlock*> VersionInnerLoops(
+      HGraph_X86* graph,
+      HOptimization_X86* optim,
+      CollectChecks collect_checks,
+      uint64_t max_instructions = kDefaultMaxInstructions) {
+    ArenaVector<HBasicBlock*> headers = CollectHeaders<HOnlyInnerLoopIterator>(
+        graph, [](HLoopInformation_X86* loop ATTRIBUTE_UNUSED) { return true; });
+    ArenaVector<HBasicBlock*> fast_headers(graph->GetArena()->Adapter(kArenaAllocMisc));
+    for (HBasicBlock* header : headers) {
+      HLoopInformation_X86* loop = LOOPINFO_TO_LOOPINFO_X86(header->GetLoopInformation());
+      HLoopVersioning versioning(loop, optim);
+      if (collect_checks(loop, &versioning) && versioning.Gate(max_instructions)) {
+        fast_headers.push_back(versioning.Version());
+      }
+    }
+    return fast_headers;
+  }
+
+  /**
+   * @brief Require array1 and array2 to be different objects in the fast version.
+   * @details Both must be defined outside of the loop. A NullCheck is seen through.
+   */
+  void AddArrayIdentityCheck(HInstruction* array1, HInstruction* array2);
+
+  /**
+   * @brief Require end - start >= min_iterations in the fast version.
+   * @details Used to select a version by trip count. The subtraction may wrap,
+   * which only selects the other, equivalent, version.
+   */
+  void AddMinimumIterationsCheck(HInstruction* start, HInstruction* end, int64_t min_iterations);
+
+  /**
+   * @brief Require value to be non-null in the fast version.
+   */
+  void AddNotNullCheck(HInstruction* value);
+
+  /**
+   * @brief Require array.length >= end in the fast version.
+   * @details array must be known non-null when the check runs, for instance from
+   * an earlier AddNotNullCheck.
+   */
+  void AddArrayLengthCheck(HInstruction* array, HInstruction* end);
+
+  /**
+   * @brief Require the rows of an array of arrays in [start, end) to be non-null and
+   * at least min_length long in the fast version.
+   * @details row is a load of a row in the loop, its array must be known non-null and
+   * at least end long when the check runs, and start must be non-negative. The check
+   * is a loop over the rows.
+   */
+  void AddArrayRowsCheck(HInstruction* row,
+                         HInstruction* start,
+                         HInstruction* end,
+                         HInstruction* min_length);
+
+  /**
+   * @brief Require the class of value to be klass in the fast version.
+   * @details value must be known non-null when the check runs, for instance from an
+   * earlier AddNotNullCheck. The type guards of the inliner comparing the class of
+   * value with klass are folded in the fast version, see GetTypeGuard.
+   * @param get_class a load of the class of value, copied by the check.
+   */
+  void AddClassCheck(HInstanceFieldGet* get_class, HInstruction* value, HLoadClass* klass);
+
+  /**
+   * @brief Require the GC not to be marking when the fast version is entered.
+   * @details The flag may change at the GC points of the fast version, the caller must
+   * check it again after them.
+   */
+  void AddNotGcMarkingCheck();
+
+  /**
+   * @brief Match a type guard of the inliner: a comparison of the class of an object
+   * with a loaded class, true when they differ.
+   * @param condition the condition of an If or a Deoptimize.
+   * @param get_class set to the load of the class of the object.
+   * @param value set to the object, seen through a NullCheck.
+   * @param klass set to the loaded class.
+   * @return Returns true if condition is a type guard.
+   */
+  static bool GetTypeGuard(HInstruction* condition,
+                           HInstanceFieldGet** get_class,
+                           HInstruction** value,
+                           HLoadClass** klass);
+
+  /**
+   * @brief Was any check added?
+   */
+  bool HasChecks() const {
+    return !checks_.empty();
+  }
+
+  /**
+   * @brief Makes sure the loop and the checks can be versioned.
+   * @param max_instructions The maximum number of instructions the loop may have.
+   * @return Returns true if Version() can be called.
+   */
+  bool Gate(uint64_t max_instructions = kDefaultMaxInstructions) const;
+
+  /**
+   * @brief Perform the versioning. Gate must have returned true before.
+   * @details The dominator tree and the loop information of blocks are rebuilt,
+   * the loop hierarchy and the analyses of the graph are invalidated.
+   * @return The header of the fast version.
+   */
+  HBasicBlock* Version();
+
+ private:
+  enum CheckKind {
+    kCheckIdentity,       // first != second.
+    kCheckIterations,     // second - first >= min_iterations.
+    kCheckNotNull,        // first != null.
+    kCheckArrayLength,    // first.length >= second.
+    kCheckArrayRows,      // first[k] != null && first[k].length >= min_length, k in [start, second).
+    kCheckClass,          // first.klass == second.
+    kCheckNotGcMarking,   // !Thread::Current()->GetIsGcMarking().
+  };
+
+  struct Check {
+    CheckKind kind;
+    HInstruction* first;
+    HInstruction* second;
+    // Only for rows checks.
+    HInstruction* start;
+    HInstruction* min_length;
+    ReferenceTypeInfo row_type;
+    // Only for iteration checks.
+    int64_t min_iterations;
+    // Only for class checks.
+    HInstanceFieldGet* get_class;
+  };
+
+  /**
+   * @brief Add check, unless the same check was already added.
+   */
+  void AddCheck(const Check& check);
+
+  /**
+   * @brief Emit the condition of a check in guard.
+   * @return The condition, true when the check succeeds.
+   */
+  HInstruction* AddCondition(HBasicBlock* guard, const Check& check);
+
+  /**
+   * @brief Emit the loop of a rows check between guard and next.
+   * @details guard must end with a Goto to slow_pre_header, which is replaced with
+   * the entry of the loop.
+   */
+  void AddRowsGuard(HBasicBlock* guard,
+                    HBasicBlock* next,
+                    HBasicBlock* slow_pre_header,
+                    const Check& check);
+
+  /**
+   * @brief Emit the checks at the end of the pre-header.
+   * @param slow_pre_header The pre-header of the slow version.
+   * @param fast_pre_header The pre-header of the fast version.
+   */
+  void AddGuards(HBasicBlock* slow_pre_header, HBasicBlock* fast_pre_header);
+
+  /**
+   * @brief Copy the instructions of the loop into the copied blocks.
+   */
+  void CloneInstructions(const SafeMap<HBasicBlock*, HBasicBlock*>& old_to_new);
+
+  /**
+   * @brief Merge the values of both versions used after the loop.
+   * @param exit_block The single exit block of the loop, now reached by both versions.
+   */
+  void AddExitPhis(HBasicBlock* exit_block, HInstruction* orig, HInstruction* clone);
+
+  /**
+   * @brief Fold the type guards the class checks cover in the copied blocks.
+   */
+  void FoldTypeGuards(const SafeMap<HBasicBlock*, HBasicBlock*>& old_to_new);
+
+  HLoopInformation_X86* loop_;
+  HGraph_X86* graph_;
+  HOptimization_X86* optim_;
+  ArenaVector<Check> checks_;
+
+  DISALLOW_COPY_AND_ASSIGN(HLoopVersioning);
+};
+
+}  // namespace art
+
+#endif  // ART_OPT_INFRASTRUCTURE_LOOP_VERSIONING_H_
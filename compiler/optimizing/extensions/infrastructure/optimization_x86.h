@@ -22,6 +22,7 @@
 #ifndef ART_OPT_INFRASTRUCTURE_OPTIMIZATION_X86_H_
 #define ART_OPT_INFRASTRUCTURE_OPTIMIZATION_X86_H_
 
+#include "graph_x86.h"
 #include "optimization.h"
 
 namespace art {
@@ -54,6 +55,27 @@ class HOptimization_X86 : public HOptimization {
     verbose_ = verbose;
   }
 
+  /**
+   * @brief Which cached analyses does this pass invalidate?
+   * @details Passes that keep the loops, IVs and bounds intact override
+   *          this to let the following passes reuse them.
+   * @return a mask of HAnalysisKind.
+   */
+  virtual uint32_t GetInvalidatedAnalyses() const {
+    return kAnalysisAll;
+  }
+
+  /**
+   * @brief Record that transforming loop was made possible by the inliner.
+   * @details Counts the transformations of loops where the inliner raised its budget
+   * for a call site, to tune that budget against the passes it benefits.
+   */
+  void MaybeRecordLoopInliningBenefit(HLoopInformation_X86* loop) const {
+    if (GRAPH_TO_GRAPH_X86(graph_)->HasBoostedInlining(loop)) {
+      MaybeRecordStat(MethodCompilationStat::kIntelLoopInliningUnlocked);
+    }
+  }
+
  private:
   bool verbose_;
 };
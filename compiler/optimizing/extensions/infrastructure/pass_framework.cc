@@ -20,9 +20,14 @@
  */
 
 #include "base/dumpable.h"
+#include "array_alias_versioning.h"
+#include "art_method-inl.h"
 #include "base/timing_logger.h"
 #include "bb_simplifier.h"
 #include "code_generator.h"
+#ifdef ART_ENABLE_CODEGEN_x86_64
+#include "code_generator_x86_64.h"
+#endif
 #include "constant_calculation_sinking.h"
 #include "constant_folding_x86.h"
 #include "ext_utility.h"
@@ -31,25 +36,41 @@
 #include "form_bottom_loops.h"
 #include "find_ivs.h"
 #include "graph_visualizer.h"
-#include "gvn_after_fbl.h"
+#include "graph_x86.h"
+#include "jit/profile_compilation_info.h"
 #include "loadhoist_storesink.h"
 #include "loop_formation.h"
 #include "loop_full_unrolling.h"
+#include "loop_fusion.h"
+#include "loop_if_conversion.h"
+#include "loop_bounds_check_elimination.h"
+#include "loop_counters.h"
+#include "loop_interchange.h"
+#include "loop_strength_reduction.h"
+#include "loop_unroll_and_jam.h"
 #include "loop_unroll_by_factor.h"
 #ifndef SOFIA
 #include "non_temporal_move.h"
 #endif
 #include "optimization.h"
+#include "partial_redundancy_elimination.h"
 #include "pass_framework.h"
+#include "pass_pipeline.h"
 #include "peeling.h"
-#include "gvn_after_peeling.h"
 #include "phi_cleanup.h"
+#include "read_barrier_elimination.h"
 #include "remove_suspend.h"
 #include "remove_unused_loops.h"
+#include "runtime.h"
+#include "scalar_replacement.h"
+#include "select_osr_entries.h"
+#include "software_prefetch.h"
+#include "speculate_trip_count.h"
 //#include "scoped_thread_state_change.h"
 #include "scoped_thread_state_change-inl.h"
 #include "thread.h"
 #include "trivial_loop_evaluator.h"
+#include "type_guard_unswitching.h"
 
 
 namespace art {
@@ -75,8 +96,10 @@ struct HCustomPassPlacement {
  */
 static HCustomPassPlacement kPassCustomPlacement[] = {
   { "loop_formation", "instruction_simplifier$after_bce", kPassInsertAfter },
+  { "type_guard_unswitching", "loop_formation", kPassInsertBefore },
   { "find_ivs", "loop_formation", kPassInsertAfter },
   { "loop_full_unrolling", "find_ivs", kPassInsertAfter},
+  { "speculate_trip_count", "find_ivs", kPassInsertAfter },
   { "remove_loop_suspend_checks", "phi_cleanup", kPassInsertAfter},
   { "loadhoist_storesink", "remove_loop_suspend_checks", kPassInsertAfter},
   { "remove_unused_loops", "remove_loop_suspend_checks", kPassInsertAfter },
@@ -84,18 +107,31 @@ static HCustomPassPlacement kPassCustomPlacement[] = {
   { "loop_partial_unrolling", "constant_calculation_sinking", kPassInsertAfter},
   { "formation_before_unroll","loop_partial_unrolling", kPassInsertBefore},
   { "find_ivs_before_unroll", "formation_before_unroll", kPassInsertAfter},
+  { "loop_unroll_and_jam", "loop_partial_unrolling", kPassInsertBefore},
+  { "find_ivs_after_unroll_and_jam", "loop_unroll_and_jam", kPassInsertAfter},
   { "constant_folding_after_unroll", "loop_partial_unrolling", kPassInsertAfter},
   { "form_bottom_loops", "load_store_elimination", kPassInsertAfter },
   { "phi_cleanup", "form_bottom_loops", kPassInsertAfter },
   { "constant_folding_after_phi_cleanup", "phi_cleanup", kPassInsertAfter },
   { "loop_formation_before_bottom_loops", "form_bottom_loops", kPassInsertBefore },
+  { "select_osr_entries", "loop_formation_before_bottom_loops", kPassInsertBefore },
+  { "scalar_replacement", "select_osr_entries", kPassInsertBefore },
   { "loop_peeling", "remove_unused_loops", kPassInsertBefore},
-  { "GVN_after_peeling", "loop_peeling", kPassInsertAfter},
+  { "partial_redundancy_elimination", "loop_peeling", kPassInsertAfter},
   { "loop_formation_before_peeling", "loop_peeling", kPassInsertBefore},
   { "non_temporal_move", "trivial_loop_evaluator", kPassInsertAfter},
   { "trivial_loop_evaluator", "loadhoist_storesink", kPassInsertAfter},
   { "find_ivs_before_suspend_check", "remove_loop_suspend_checks", kPassInsertBefore},
   { "bb_simplifier", "remove_unused_loops", kPassInsertBefore },
+  { "array_alias_versioning", "find_ivs_before_suspend_check", kPassInsertBefore },
+  { "loop_fusion", "loop_full_unrolling", kPassInsertAfter },
+  { "loop_interchange", "loop_fusion", kPassInsertAfter },
+  { "loop_bounds_check_elimination", "constant_folding_after_unroll", kPassInsertAfter },
+  { "loop_strength_reduction", "loop_bounds_check_elimination", kPassInsertAfter },
+  { "loop_if_conversion", "select_generator", kPassInsertAfter },
+  { "software_prefetch", "instruction_simplifier$before_codegen", kPassInsertAfter },
+  { "read_barrier_elimination", "software_prefetch", kPassInsertBefore },
+  { "loop_counters", "software_prefetch", kPassInsertAfter },
 };
 
 /**
@@ -107,6 +143,42 @@ static const char* kPassRemoval[] = {
   nullptr,
 };
 
+// The passes growing the code of loops, removed in methods without hotness.
+static const char* kPassColdRemoval[] = {
+  "array_alias_versioning",
+  "form_bottom_loops",
+  "loop_full_unrolling",
+  "loop_interchange",
+  "loop_partial_unrolling",
+  "loop_peeling",
+  "loop_unroll_and_jam",
+  "read_barrier_elimination",
+  "software_prefetch",
+  "type_guard_unswitching",
+};
+
+/**
+ * @brief Is the method hot enough to trade code size for speed?
+ * @details The JIT only profiles methods once they are warm, so a method without
+ *          ProfilingInfo has not run much, OSR excepted. AOT methods are hot when the
+ *          profile says so. Without any profile, we cannot tell and favor speed.
+ */
+static bool IsHotMethod(HGraph* graph, CompilerDriver* driver) {
+  if (!Runtime::Current()->IsAotCompiler()) {
+    ArtMethod* method = graph->GetArtMethod();
+    return graph->IsCompilingOsr() ||
+           method == nullptr ||
+           method->GetProfilingInfo(kRuntimePointerSize) != nullptr;
+  }
+
+  const ProfileCompilationInfo* profile = driver->GetProfileCompilationInfo();
+  if (profile == nullptr) {
+    return true;
+  }
+  MethodReference method_ref(&graph->GetDexFile(), graph->GetMethodIdx());
+  return profile->GetMethodHotness(method_ref).IsHot();
+}
+
 static void AddX86Optimization(HOptimization* optimization,
                                ArenaVector<HOptimization*>& list,
                                ArenaSafeMap<const char*, HCustomPassPlacement*> &placements) {
@@ -183,6 +255,30 @@ static void FillOptimizationList(HGraph* graph,
   }
 }
 
+/**
+ * @brief Invalidate the analyses cached in the graph once a pass has run.
+ * @param graph the HGraph_X86.
+ * @param opt the pass that has just run.
+ * @param opts_x86 the extension passes.
+ * @param opts_x86_length the length of opts_x86.
+ */
+static void InvalidateAnalysesAfterPass(HGraph_X86* graph,
+                                        HOptimization* opt,
+                                        HOptimization_X86* opts_x86[],
+                                        size_t opts_x86_length) {
+  // Passes from common code do not declare what they preserve.
+  uint32_t invalidated = kAnalysisAll;
+
+  for (size_t i = 0; i < opts_x86_length; i++) {
+    if (opts_x86[i] == opt) {
+      invalidated = opts_x86[i]->GetInvalidatedAnalyses();
+      break;
+    }
+  }
+
+  graph->InvalidateAnalyses(invalidated);
+}
+
 /**
  * @brief Apply the post optimization passes.
  * @param post_opt_list post-optimization list.
@@ -206,7 +302,8 @@ static void ApplyPostOpts(const ArenaVector<HOptimization*>& post_opt_list,
  */
 static void RemoveOptimizations(ArenaVector<HOptimization*>& opts,
                                 ArenaVector<HOptimization*>& post_opts,
-                                CompilerDriver* driver) {
+                                CompilerDriver* driver,
+                                bool is_hot) {
   std::unordered_set<std::string> disabled_passes;
 
   SplitStringIntoSet(driver->GetCompilerOptions().
@@ -221,6 +318,13 @@ static void RemoveOptimizations(ArenaVector<HOptimization*>& opts,
     }
   }
 
+  // Cold methods get a pipeline optimized for size.
+  if (!is_hot) {
+    for (size_t i = 0, len = arraysize(kPassColdRemoval); i < len; i++) {
+      disabled_passes.insert(std::string(kPassColdRemoval[i]));
+    }
+  }
+
   // If there are no disabled passes, bail.
   if (disabled_passes.empty()) {
     return;
@@ -232,7 +336,7 @@ static void RemoveOptimizations(ArenaVector<HOptimization*>& opts,
   //   This is cheaper than rearranging the vectors.
   for (size_t opts_idx = 0; opts_idx < opts_len; opts_idx++) {
     HOptimization* opt = opts[opts_idx];
-    if (disabled_passes.find(opt->GetPassName()) != disabled_passes.end()) {
+    if (opt != nullptr && disabled_passes.find(opt->GetPassName()) != disabled_passes.end()) {
       opts[opts_idx] = nullptr;
     }
   }
@@ -241,7 +345,8 @@ static void RemoveOptimizations(ArenaVector<HOptimization*>& opts,
 
   for (size_t post_opts_idx = 0; post_opts_idx < post_opts_len; post_opts_idx++) {
     HOptimization* post_opt = post_opts[post_opts_idx];
-    if (disabled_passes.find(post_opt->GetPassName()) != disabled_passes.end()) {
+    if (post_opt != nullptr &&
+        disabled_passes.find(post_opt->GetPassName()) != disabled_passes.end()) {
       post_opts[post_opts_idx] = nullptr;
     }
   }
@@ -388,43 +493,63 @@ void RunOptimizationsX86(HGraph* graph,
                          PassObserver* pass_observer,
                          VariableSizedHandleScope* handles) {
 
-  UNUSED(codegen);
   // We want our own list of passes with our own vector.
   ArenaVector<HOptimization*> post_opt_list(graph->GetArena()->Adapter(kArenaAllocMisc));
   ArenaSet<const char*> post_opt_request(graph->GetArena()->Adapter(kArenaAllocMisc));
 
   // Create the array for the opts.
   HLoopFormation loop_formation(graph);
+  HTypeGuardUnswitching type_guard_unswitching(graph, stats);
   HFindInductionVariables find_ivs(graph, "find_ivs", stats);
   HFindInductionVariables find_ivs_before_unroll(graph,"find_ivs_before_unroll",stats);
   HRemoveLoopSuspendChecks remove_suspends(graph, stats);
+  HArrayAliasVersioning array_alias_versioning(graph, stats);
   HRemoveUnusedLoops remove_unused_loops(graph, stats);
   TrivialLoopEvaluator tle(graph, stats);
   HConstantCalculationSinking ccs(graph, stats);
 #ifndef SOFIA
-  HNonTemporalMove non_temporal_move(graph, stats);
+  HNonTemporalMove non_temporal_move(graph, driver->GetInstructionSetFeatures(), stats);
 #endif
   LoadHoistStoreSink lhss(graph, stats);
   HLoopFormation formation_before_peeling(graph, "loop_formation_before_peeling");
   HLoopPeeling peeling(graph, stats);
-  GVNAfterPeeling gvn_after_peeling(graph);
-  HLoopFullUnrolling loop_full_unrolling(graph, stats);
+  HPartialRedundancyElimination pre(graph, stats);
+  HLoopFullUnrolling loop_full_unrolling(graph, driver->GetInstructionSetFeatures(), stats);
+  HSpeculateTripCount speculate_trip_count(graph, stats);
+  HLoopFusion loop_fusion(graph, stats);
+  HLoopInterchange loop_interchange(graph, stats);
   HLoopFormation formation_before_bottom_loops(graph, "loop_formation_before_bottom_loops");
   HFormBottomLoops form_bottom_loops(graph, dex_compilation_unit, handles, stats);
+  HSelectOsrEntries select_osr_entries(graph, stats);
+  HScalarReplacement scalar_replacement(graph, stats);
   HPhiCleanup phi_cleanup(graph, stats);
   HBBSimplifier bb_simplifier(graph, stats);
   HConstantFolding_X86 constant_folding(graph, stats, "constant_folding_after_phi_cleanup");
   HFindInductionVariables find_ivs_before_suspend_check(graph, "find_ivs_before_suspend_check", stats);
   HLoopFormation formation_before_unroll(graph, "formation_before_unroll");
-  HLoopUnrollByFactor unroll_by_factor(graph,stats);
+  HLoopUnrollByFactor unroll_by_factor(graph, driver->GetInstructionSetFeatures(), stats);
+  HLoopUnrollAndJam unroll_and_jam(graph, stats);
+  // Unroll-and-jam scales the outer IVs, the partial unrolling needs them recomputed.
+  HFindInductionVariables find_ivs_after_unroll_and_jam(graph, "find_ivs_after_unroll_and_jam",
+                                                        stats);
   HConstantFolding_X86 constant_folding_after_unroll(graph, stats, "constant_folding_after_unroll");
+  HLoopBoundsCheckElimination loop_bce(graph, stats);
+  HLoopStrengthReduction strength_reduction(graph, stats);
+  HLoopIfConversion loop_if_conversion(graph, driver->GetInstructionSet(), stats);
+  HSoftwarePrefetch software_prefetch(graph, driver->GetInstructionSetFeatures(), stats);
+  HReadBarrierElimination read_barrier_elimination(graph, stats);
+  HLoopCounters loop_counters(graph, stats);
 
   HOptimization_X86* opt_array[] = {
     &form_bottom_loops,
     &formation_before_bottom_loops,
+    &select_osr_entries,
+    &scalar_replacement,
     &phi_cleanup,
     &loop_formation,
+    &type_guard_unswitching,
     &find_ivs,
+    &array_alias_versioning,
     &remove_suspends,
     &remove_unused_loops,
     &lhss,
@@ -432,7 +557,12 @@ void RunOptimizationsX86(HGraph* graph,
     &unroll_by_factor,
     &formation_before_unroll,
     &find_ivs_before_unroll,
+    &unroll_and_jam,
+    &find_ivs_after_unroll_and_jam,
     &constant_folding_after_unroll,
+    &loop_bce,
+    &strength_reduction,
+    &loop_if_conversion,
     &tle,
     &find_ivs_before_suspend_check,
 #ifndef SOFIA
@@ -440,10 +570,16 @@ void RunOptimizationsX86(HGraph* graph,
 #endif
     &bb_simplifier,
     &loop_full_unrolling,
+    &speculate_trip_count,
+    &loop_fusion,
+    &loop_interchange,
     &peeling,
     &formation_before_peeling,
-    &gvn_after_peeling,
-    &constant_folding
+    &pre,
+    &constant_folding,
+    &software_prefetch,
+    &read_barrier_elimination,
+    &loop_counters
   };
 
   // Create the array for the post-opts.
@@ -462,13 +598,33 @@ void RunOptimizationsX86(HGraph* graph,
   // Create the vector for the post opts.
   FillPassList(post_opt_array, arraysize(post_opt_array), post_opt_list);
 
+  // Apply the per-method pipeline changes, if any.
+  const HPassPipeline* pipeline = driver->GetCompilerOptions().GetPassPipeline();
+  if (pipeline != nullptr) {
+    pipeline->Apply(graph->GetDexFile(),
+                    graph->GetMethodIdx(),
+                    !Runtime::Current()->IsAotCompiler(),
+                    opt_list);
+  }
+
   // Finish by removing the ones we do not want.
-  RemoveOptimizations(opt_list, post_opt_list, driver);
+  bool is_hot = IsHotMethod(graph, driver);
+  RemoveOptimizations(opt_list, post_opt_list, driver, is_hot);
+
+#ifdef ART_ENABLE_CODEGEN_x86_64
+  // The code layout of the hot methods favors the loops over the code size.
+  if (is_hot && driver->GetInstructionSet() == kX86_64) {
+    down_cast<x86_64::CodeGeneratorX86_64*>(codegen)->SetAlignLoopHeaders(true);
+  }
+#else
+  UNUSED(codegen);
+#endif
 
   // Print the pass list, if needed.
   PrintPassesOnlyOnce(opt_list, post_opt_list, driver);
 
   // Now execute the optimizations.
+  HGraph_X86* graph_x86 = GRAPH_TO_GRAPH_X86(graph);
   for (auto optimization : opt_list) {
     if (optimization != nullptr) {
       {
@@ -477,10 +633,14 @@ void RunOptimizationsX86(HGraph* graph,
         RunOptWithPassScope scope(optimization, pass_observer);
         scope.Run();
       }
+      InvalidateAnalysesAfterPass(graph_x86, optimization, opt_array, arraysize(opt_array));
 
       // Apply post opts: for optimizing compiler, we assume the post-opts
       //   know when to run or not to limit compile time.
-      ApplyPostOpts(post_opt_list, pass_observer);
+      if (!post_opt_list.empty()) {
+        ApplyPostOpts(post_opt_list, pass_observer);
+        graph_x86->InvalidateAnalyses(kAnalysisAll);
+      }
     }
   }
 }
@@ -0,0 +1,216 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2017, Intel Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to the
+ * source code ("Material") are owned by Intel Corporation or its suppliers or
+ * licensors. Title to the Material remains with Intel Corporation or its suppliers
+ * and licensors. The Material contains trade secrets and proprietary and
+ * confidential information of Intel or its suppliers and licensors. The Material
+ * is protected by worldwide copyright and trade secret laws and treaty provisions.
+ * No part of the Material may be used, copied, reproduced, modified, published,
+ * uploaded, posted, transmitted, distributed, or disclosed in any way without
+ * Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery of
+ * the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be express
+ * and approved by Intel in writing.
+ */
+
+#include "pass_pipeline.h"
+
+#include <unordered_set>
+
+#include "android-base/strings.h"
+#include "dex_file.h"
+#include "optimization.h"
+#include "utils.h"
+
+namespace art {
+
+bool HPassPipeline::MatchesPattern(const char* pattern, const char* str) {
+  // Iterative wildcard matching: remember the last '*' to backtrack onto.
+  const char* star = nullptr;
+  const char* star_str = nullptr;
+
+  while (*str != '\0') {
+    if (*pattern == '*') {
+      star = pattern++;
+      star_str = str;
+    } else if (*pattern == *str) {
+      pattern++;
+      str++;
+    } else if (star != nullptr) {
+      pattern = star + 1;
+      str = ++star_str;
+    } else {
+      return false;
+    }
+  }
+
+  while (*pattern == '*') {
+    pattern++;
+  }
+  return *pattern == '\0';
+}
+
+bool HPassPipeline::ParseRule(const std::string& rule, std::string* error_msg) {
+  std::vector<std::string> fields;
+  Split(rule, ':', &fields);
+
+  if (fields.size() != 4 && fields.size() != 5) {
+    *error_msg = "Malformed pass pipeline rule '" + rule + "'";
+    return false;
+  }
+
+  Rule result;
+  const std::string& mode = fields[0];
+  if (mode == "all") {
+    result.mode = kModeAll;
+  } else if (mode == "aot") {
+    result.mode = kModeAot;
+  } else if (mode == "jit") {
+    result.mode = kModeJit;
+  } else {
+    *error_msg = "Unknown mode '" + mode + "' in pass pipeline rule '" + rule + "'";
+    return false;
+  }
+
+  result.method_pattern = fields[1];
+
+  const std::string& action = fields[2];
+  bool needs_relative = false;
+  if (action == "disable") {
+    result.action = kActionDisable;
+  } else if (action == "enable") {
+    result.action = kActionEnable;
+  } else if (action == "before") {
+    result.action = kActionMoveBefore;
+    needs_relative = true;
+  } else if (action == "after") {
+    result.action = kActionMoveAfter;
+    needs_relative = true;
+  } else {
+    *error_msg = "Unknown action '" + action + "' in pass pipeline rule '" + rule + "'";
+    return false;
+  }
+
+  if (needs_relative != (fields.size() == 5)) {
+    *error_msg = "Action '" + action + (needs_relative ? "' needs" : "' does not take") +
+                 " a relative pass in pass pipeline rule '" + rule + "'";
+    return false;
+  }
+
+  result.pass = fields[3];
+  if (needs_relative) {
+    result.relative_pass = fields[4];
+  }
+
+  rules_.push_back(result);
+  return true;
+}
+
+bool HPassPipeline::Parse(const std::string& description, std::string* error_msg) {
+  std::vector<std::string> lines;
+  Split(description, '\n', &lines);
+
+  for (const std::string& line : lines) {
+    // Drop the comments.
+    std::string content = line.substr(0, line.find('#'));
+
+    std::vector<std::string> rules;
+    Split(content, ',', &rules);
+    for (const std::string& rule : rules) {
+      std::string trimmed = android::base::Trim(rule);
+      if (trimmed.empty()) {
+        continue;
+      }
+      if (!ParseRule(trimmed, error_msg)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief Find the index of a pass in the optimization list.
+ * @param opts the optimization list.
+ * @param name the name of the pass.
+ * @return the index of the pass, or opts.size() if it is not in the list.
+ */
+static size_t FindPass(const ArenaVector<HOptimization*>& opts, const std::string& name) {
+  size_t len = opts.size();
+  for (size_t idx = 0; idx < len; idx++) {
+    if (opts[idx] != nullptr && name == opts[idx]->GetPassName()) {
+      return idx;
+    }
+  }
+  return len;
+}
+
+void HPassPipeline::Apply(const DexFile& dex_file,
+                          uint32_t method_idx,
+                          bool is_jit,
+                          ArenaVector<HOptimization*>& opts) const {
+  // PrettyMethod() is expensive, so we delay calling it until a rule needs it.
+  std::string method_name;
+  std::unordered_set<std::string> disabled_passes;
+
+  for (const Rule& rule : rules_) {
+    if ((rule.mode == kModeAot && is_jit) || (rule.mode == kModeJit && !is_jit)) {
+      continue;
+    }
+
+    if (rule.method_pattern != "*") {
+      if (method_name.empty()) {
+        method_name = dex_file.PrettyMethod(method_idx, /* with_signature */ false);
+      }
+      if (!MatchesPattern(rule.method_pattern.c_str(), method_name.c_str())) {
+        continue;
+      }
+    }
+
+    switch (rule.action) {
+      case kActionDisable:
+        disabled_passes.insert(rule.pass);
+        break;
+      case kActionEnable:
+        disabled_passes.erase(rule.pass);
+        break;
+      case kActionMoveBefore:
+      case kActionMoveAfter: {
+        size_t from = FindPass(opts, rule.pass);
+        if (from == opts.size() || FindPass(opts, rule.relative_pass) == opts.size()) {
+          // Either pass is not part of this pipeline, nothing to move.
+          break;
+        }
+        HOptimization* opt = opts[from];
+        opts.erase(opts.begin() + from);
+        size_t to = FindPass(opts, rule.relative_pass);
+        if (rule.action == kActionMoveAfter) {
+          to++;
+        }
+        opts.insert(opts.begin() + to, opt);
+        break;
+      }
+    }
+  }
+
+  if (disabled_passes.empty()) {
+    return;
+  }
+
+  // We replace the opts with nullptr, like RemoveOptimizations does.
+  for (size_t idx = 0, len = opts.size(); idx < len; idx++) {
+    HOptimization* opt = opts[idx];
+    if (opt != nullptr && disabled_passes.find(opt->GetPassName()) != disabled_passes.end()) {
+      opts[idx] = nullptr;
+    }
+  }
+}
+
+}  // namespace art
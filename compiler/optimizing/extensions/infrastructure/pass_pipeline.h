@@ -0,0 +1,127 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2017, Intel Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to the
+ * source code ("Material") are owned by Intel Corporation or its suppliers or
+ * licensors. Title to the Material remains with Intel Corporation or its suppliers
+ * and licensors. The Material contains trade secrets and proprietary and
+ * confidential information of Intel or its suppliers and licensors. The Material
+ * is protected by worldwide copyright and trade secret laws and treaty provisions.
+ * No part of the Material may be used, copied, reproduced, modified, published,
+ * uploaded, posted, transmitted, distributed, or disclosed in any way without
+ * Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery of
+ * the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be express
+ * and approved by Intel in writing.
+ */
+
+#ifndef ART_OPT_INFRASTRUCTURE_PASS_PIPELINE_H_
+#define ART_OPT_INFRASTRUCTURE_PASS_PIPELINE_H_
+
+#include <string>
+#include <vector>
+
+#include "base/arena_containers.h"
+
+namespace art {
+
+// Forward declarations.
+class DexFile;
+class HOptimization;
+
+/**
+ * @class HPassPipeline
+ * @brief Runtime-loadable description of changes to the optimization pipeline.
+ * @details The description is a list of rules separated by ',' or new lines.
+ *          Each rule has the format:
+ *            <mode>:<method-pattern>:<action>:<pass>[:<relative-pass>]
+ *          - mode is one of "all", "aot" or "jit".
+ *          - method-pattern is matched against the method name without
+ *            signature, e.g. "com.foo.Bar.baz". '*' matches any sequence of
+ *            characters, so "*" is global and "com.foo.*" selects a package.
+ *          - action is one of "disable", "enable", "before" or "after".
+ *            "before" and "after" move <pass> relative to <relative-pass>.
+ *          Everything after a '#' up to the end of the line is a comment.
+ *          Rules are applied in order, so a later rule overrides an earlier one.
+ */
+class HPassPipeline {
+ public:
+  enum Mode {
+    kModeAll,
+    kModeAot,
+    kModeJit,
+  };
+
+  enum Action {
+    kActionDisable,
+    kActionEnable,
+    kActionMoveBefore,
+    kActionMoveAfter,
+  };
+
+  struct Rule {
+    Mode mode;
+    std::string method_pattern;
+    Action action;
+    std::string pass;
+    std::string relative_pass;
+  };
+
+  HPassPipeline() {}
+
+  /**
+   * @brief Parse a pipeline description and append its rules.
+   * @param description the pipeline description.
+   * @param error_msg the error message, set if the parsing failed.
+   * @return true if the whole description was parsed successfully.
+   */
+  bool Parse(const std::string& description, std::string* error_msg);
+
+  /**
+   * @brief Is the pipeline free of any rule?
+   * @return true if there is nothing to apply.
+   */
+  bool IsEmpty() const {
+    return rules_.empty();
+  }
+
+  const std::vector<Rule>& GetRules() const {
+    return rules_;
+  }
+
+  /**
+   * @brief Apply the rules matching a method to the optimization list.
+   * @details Disabled passes are replaced by nullptr in the list.
+   * @param dex_file the dex file of the compiled method.
+   * @param method_idx the index of the compiled method.
+   * @param is_jit whether we are compiling for the JIT.
+   * @param opts the optimization list.
+   */
+  void Apply(const DexFile& dex_file,
+             uint32_t method_idx,
+             bool is_jit,
+             ArenaVector<HOptimization*>& opts) const;
+
+  /**
+   * @brief Match a string against a pattern where '*' matches any sequence.
+   * @param pattern the pattern.
+   * @param str the string to match.
+   * @return true if the whole string matches the pattern.
+   */
+  static bool MatchesPattern(const char* pattern, const char* str);
+
+ private:
+  bool ParseRule(const std::string& rule, std::string* error_msg);
+
+  std::vector<Rule> rules_;
+
+  DISALLOW_COPY_AND_ASSIGN(HPassPipeline);
+};
+
+}  // namespace art
+
+#endif  // ART_OPT_INFRASTRUCTURE_PASS_PIPELINE_H_
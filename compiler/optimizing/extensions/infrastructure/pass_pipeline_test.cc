@@ -0,0 +1,131 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2017, Intel Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to the
+ * source code ("Material") are owned by Intel Corporation or its suppliers or
+ * licensors. Title to the Material remains with Intel Corporation or its suppliers
+ * and licensors. The Material contains trade secrets and proprietary and
+ * confidential information of Intel or its suppliers and licensors. The Material
+ * is protected by worldwide copyright and trade secret laws and treaty provisions.
+ * No part of the Material may be used, copied, reproduced, modified, published,
+ * uploaded, posted, transmitted, distributed, or disclosed in any way without
+ * Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery of
+ * the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be express
+ * and approved by Intel in writing.
+ */
+
+#include "base/arena_allocator.h"
+#include "graph_x86.h"
+#include "optimization.h"
+#include "pass_pipeline.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+/**
+ * @brief A pass doing nothing, only its name matters for the pipeline.
+ */
+class HNopOptimization : public HOptimization {
+ public:
+  HNopOptimization(HGraph* graph, const char* name) : HOptimization(graph, name) {}
+
+  void Run() OVERRIDE {}
+};
+
+class PassPipelineTest : public testing::Test {
+ public:
+  PassPipelineTest()
+      : pool_(),
+        allocator_(&pool_),
+        graph_(CreateGraph_X86_for_test(&allocator_)),
+        opts_(allocator_.Adapter(kArenaAllocMisc)) {
+    static const char* const kNames[] = { "a", "b", "c", "d" };
+    for (const char* name : kNames) {
+      opts_.push_back(new (&allocator_) HNopOptimization(graph_, name));
+    }
+  }
+
+  std::string PassList() const {
+    std::string result;
+    for (HOptimization* opt : opts_) {
+      result += (opt == nullptr) ? "-" : opt->GetPassName();
+    }
+    return result;
+  }
+
+  void Apply(const HPassPipeline& pipeline, bool is_jit) {
+    pipeline.Apply(graph_->GetDexFile(), graph_->GetMethodIdx(), is_jit, opts_);
+  }
+
+ protected:
+  ArenaPool pool_;
+  ArenaAllocator allocator_;
+  HGraph_X86* graph_;
+  ArenaVector<HOptimization*> opts_;
+};
+
+TEST_F(PassPipelineTest, MatchesPattern) {
+  EXPECT_TRUE(HPassPipeline::MatchesPattern("*", "com.foo.Bar.baz"));
+  EXPECT_TRUE(HPassPipeline::MatchesPattern("com.foo.*", "com.foo.Bar.baz"));
+  EXPECT_TRUE(HPassPipeline::MatchesPattern("*.baz", "com.foo.Bar.baz"));
+  EXPECT_TRUE(HPassPipeline::MatchesPattern("com.*.Bar.*", "com.foo.Bar.baz"));
+  EXPECT_TRUE(HPassPipeline::MatchesPattern("com.foo.Bar.baz", "com.foo.Bar.baz"));
+  EXPECT_FALSE(HPassPipeline::MatchesPattern("com.foo.Bar", "com.foo.Bar.baz"));
+  EXPECT_FALSE(HPassPipeline::MatchesPattern("org.*", "com.foo.Bar.baz"));
+  EXPECT_FALSE(HPassPipeline::MatchesPattern("*.qux", "com.foo.Bar.baz"));
+}
+
+TEST_F(PassPipelineTest, Parse) {
+  HPassPipeline pipeline;
+  std::string error_msg;
+  EXPECT_TRUE(pipeline.Parse("all:*:disable:a, jit:com.*:after:b:c\n"
+                             "# A comment line.\n"
+                             "aot:*:enable:a  # A trailing comment.\n",
+                             &error_msg)) << error_msg;
+  ASSERT_EQ(3u, pipeline.GetRules().size());
+  EXPECT_EQ(HPassPipeline::kModeJit, pipeline.GetRules()[1].mode);
+  EXPECT_EQ(HPassPipeline::kActionMoveAfter, pipeline.GetRules()[1].action);
+  EXPECT_EQ("com.*", pipeline.GetRules()[1].method_pattern);
+  EXPECT_EQ("c", pipeline.GetRules()[1].relative_pass);
+
+  EXPECT_FALSE(pipeline.Parse("all:*:disable", &error_msg));
+  EXPECT_FALSE(pipeline.Parse("some:*:disable:a", &error_msg));
+  EXPECT_FALSE(pipeline.Parse("all:*:remove:a", &error_msg));
+  EXPECT_FALSE(pipeline.Parse("all:*:before:a", &error_msg));
+  EXPECT_FALSE(pipeline.Parse("all:*:disable:a:b", &error_msg));
+}
+
+TEST_F(PassPipelineTest, DisableAndEnable) {
+  HPassPipeline pipeline;
+  std::string error_msg;
+  ASSERT_TRUE(pipeline.Parse("all:*:disable:b,all:*:disable:c,aot:*:enable:c", &error_msg));
+
+  Apply(pipeline, /* is_jit */ true);
+  EXPECT_EQ("a--d", PassList());
+}
+
+TEST_F(PassPipelineTest, DisableAot) {
+  HPassPipeline pipeline;
+  std::string error_msg;
+  ASSERT_TRUE(pipeline.Parse("all:*:disable:b,all:*:disable:c,aot:*:enable:c", &error_msg));
+
+  Apply(pipeline, /* is_jit */ false);
+  EXPECT_EQ("a-cd", PassList());
+}
+
+TEST_F(PassPipelineTest, Reorder) {
+  HPassPipeline pipeline;
+  std::string error_msg;
+  ASSERT_TRUE(pipeline.Parse("all:*:after:a:c,all:*:before:d:b,all:*:after:x:a", &error_msg));
+
+  Apply(pipeline, /* is_jit */ false);
+  EXPECT_EQ("dbca", PassList());
+}
+
+}  // namespace art
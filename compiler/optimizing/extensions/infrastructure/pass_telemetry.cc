@@ -0,0 +1,117 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2017, Intel Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to the
+ * source code ("Material") are owned by Intel Corporation or its suppliers or
+ * licensors. Title to the Material remains with Intel Corporation or its suppliers
+ * and licensors. The Material contains trade secrets and proprietary and
+ * confidential information of Intel or its suppliers and licensors. The Material
+ * is protected by worldwide copyright and trade secret laws and treaty provisions.
+ * No part of the Material may be used, copied, reproduced, modified, published,
+ * uploaded, posted, transmitted, distributed, or disclosed in any way without
+ * Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery of
+ * the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be express
+ * and approved by Intel in writing.
+ */
+
+#include "pass_telemetry.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#include "base/time_utils.h"
+#include "nodes.h"
+#include "thread.h"
+
+namespace art {
+
+HPassTelemetry::Snapshot HPassTelemetry::TakeSnapshot(HGraph* graph) {
+  Snapshot snapshot = { 0u, 0u, 0u };
+
+  for (HBasicBlock* block : graph->GetBlocks()) {
+    // Removed blocks leave a hole in the block list.
+    if (block == nullptr) {
+      continue;
+    }
+    snapshot.blocks++;
+    if (block->IsLoopHeader()) {
+      snapshot.loops++;
+    }
+    for (HInstructionIterator it(block->GetPhis()); !it.Done(); it.Advance()) {
+      snapshot.instructions++;
+    }
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      snapshot.instructions++;
+    }
+  }
+
+  return snapshot;
+}
+
+// Add the difference between two counters to the right accumulator.
+static void AccumulateDelta(size_t before, size_t after, uint64_t* added, uint64_t* removed) {
+  if (after > before) {
+    *added += after - before;
+  } else {
+    *removed += before - after;
+  }
+}
+
+void HPassTelemetry::Record(const char* pass_name,
+                            const Snapshot& before,
+                            const Snapshot& after,
+                            uint64_t ns) {
+  MutexLock mu(Thread::Current(), lock_);
+  Entry& entry = entries_[pass_name];
+
+  entry.runs++;
+  entry.ns += ns;
+  if (before.instructions != after.instructions ||
+      before.blocks != after.blocks ||
+      before.loops != after.loops) {
+    entry.runs_changed++;
+  }
+  AccumulateDelta(before.instructions, after.instructions,
+                  &entry.instructions_added, &entry.instructions_removed);
+  AccumulateDelta(before.blocks, after.blocks, &entry.blocks_added, &entry.blocks_removed);
+  AccumulateDelta(before.loops, after.loops, &entry.loops_added, &entry.loops_removed);
+}
+
+void HPassTelemetry::Dump(std::ostream& os) const {
+  MutexLock mu(Thread::Current(), lock_);
+
+  std::vector<const std::pair<const std::string, Entry>*> sorted;
+  uint64_t total_ns = 0;
+  for (const auto& it : entries_) {
+    sorted.push_back(&it);
+    total_ns += it.second.ns;
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const std::pair<const std::string, Entry>* lhs,
+               const std::pair<const std::string, Entry>* rhs) {
+    return lhs->second.ns > rhs->second.ns;
+  });
+
+  os << "Pass telemetry (" << PrettyDuration(total_ns) << " total):\n";
+  os << "  pass: runs changed time% time insns(+/-) blocks(+/-) loops(+/-)\n";
+  for (const auto* it : sorted) {
+    const Entry& entry = it->second;
+    float percent = total_ns == 0 ? 0.0f : entry.ns * 100.0f / total_ns;
+    os << "  " << it->first << ": "
+       << entry.runs << " "
+       << entry.runs_changed << " "
+       << std::fixed << std::setprecision(2) << percent << "% "
+       << PrettyDuration(entry.ns) << " "
+       << "+" << entry.instructions_added << "/-" << entry.instructions_removed << " "
+       << "+" << entry.blocks_added << "/-" << entry.blocks_removed << " "
+       << "+" << entry.loops_added << "/-" << entry.loops_removed << "\n";
+  }
+}
+
+}  // namespace art
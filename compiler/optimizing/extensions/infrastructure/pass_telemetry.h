@@ -0,0 +1,100 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2017, Intel Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to the
+ * source code ("Material") are owned by Intel Corporation or its suppliers or
+ * licensors. Title to the Material remains with Intel Corporation or its suppliers
+ * and licensors. The Material contains trade secrets and proprietary and
+ * confidential information of Intel or its suppliers and licensors. The Material
+ * is protected by worldwide copyright and trade secret laws and treaty provisions.
+ * No part of the Material may be used, copied, reproduced, modified, published,
+ * uploaded, posted, transmitted, distributed, or disclosed in any way without
+ * Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery of
+ * the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be express
+ * and approved by Intel in writing.
+ */
+
+#ifndef ART_OPT_INFRASTRUCTURE_PASS_TELEMETRY_H_
+#define ART_OPT_INFRASTRUCTURE_PASS_TELEMETRY_H_
+
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "base/mutex.h"
+
+namespace art {
+
+// Forward declarations.
+class HGraph;
+
+/**
+ * @brief Accumulates per-pass compile time and IR deltas.
+ * @details One instance is shared by all compiler worker threads, each
+ *          RunOptWithPassScope records into it once per pass execution.
+ */
+class HPassTelemetry {
+ public:
+  /**
+   * @brief The IR shape of a graph at a given point in time.
+   */
+  struct Snapshot {
+    size_t instructions;  /**!< Number of instructions and phis. */
+    size_t blocks;        /**!< Number of live basic blocks. */
+    size_t loops;         /**!< Number of loop headers. */
+  };
+
+  HPassTelemetry() : lock_("Pass telemetry lock") {}
+
+  /**
+   * @brief Take a snapshot of the graph shape.
+   * @param graph the HGraph.
+   * @return the snapshot.
+   */
+  static Snapshot TakeSnapshot(HGraph* graph);
+
+  /**
+   * @brief Record the execution of a pass.
+   * @param pass_name the name of the pass.
+   * @param before the graph shape before the pass.
+   * @param after the graph shape after the pass.
+   * @param ns the time spent in the pass, in nanoseconds.
+   */
+  void Record(const char* pass_name,
+              const Snapshot& before,
+              const Snapshot& after,
+              uint64_t ns) REQUIRES(!lock_);
+
+  /**
+   * @brief Dump the accumulated data, most expensive passes first.
+   * @param os the output stream.
+   */
+  void Dump(std::ostream& os) const REQUIRES(!lock_);
+
+ private:
+  struct Entry {
+    uint64_t runs = 0;
+    uint64_t runs_changed = 0;
+    uint64_t ns = 0;
+    uint64_t instructions_added = 0;
+    uint64_t instructions_removed = 0;
+    uint64_t blocks_added = 0;
+    uint64_t blocks_removed = 0;
+    uint64_t loops_added = 0;
+    uint64_t loops_removed = 0;
+  };
+
+  mutable Mutex lock_;
+  std::map<std::string, Entry> entries_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(HPassTelemetry);
+};
+
+}  // namespace art
+
+#endif  // ART_OPT_INFRASTRUCTURE_PASS_TELEMETRY_H_
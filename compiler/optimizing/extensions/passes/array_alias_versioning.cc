@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "array_alias_versioning.h"
+
+#include <set>
+
+#include "ext_utility.h"
+#include "find_ivs.h"
+#include "graph_x86.h"
+#include "loop_formation.h"
+#include "loop_iterators.h"
+#include "loop_versioning.h"
+
+namespace art {
+
+static HInstruction* GetArrayBase(HInstruction* access) {
+  HInstruction* base = access->InputAt(0);
+  return base->IsNullCheck() ? base->InputAt(0) : base;
+}
+
+bool HArrayAliasVersioning::CollectChecks(HLoopInformation_X86* loop,
+                                          HLoopVersioning* versioning) {
+  ArenaVector<HInstruction*> accesses(graph_->GetArena()->Adapter(kArenaAllocMisc));
+  bool has_write = false;
+  for (HBlocksInLoopIterator it_loop(*loop); !it_loop.Done(); it_loop.Advance()) {
+    for (HInstructionIterator it(it_loop.Current()->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* insn = it.Current();
+      if (insn->IsArrayGet() || insn->IsArraySet()) {
+        accesses.push_back(insn);
+        has_write |= insn->IsArraySet();
+      } else if (insn->IsInvoke()) {
+        // The callee may write any array, there is nothing to gain.
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Loop contains a call: " << insn->DebugName());
+        return false;
+      }
+    }
+  }
+  if (!has_write) {
+    return false;
+  }
+
+  std::set<std::pair<HInstruction*, HInstruction*>> bases;
+  for (size_t i = 0, e = accesses.size(); i < e; ++i) {
+    for (size_t j = i + 1; j < e; ++j) {
+      HInstruction* x = accesses[i];
+      HInstruction* y = accesses[j];
+      if (!x->IsArraySet() && !y->IsArraySet()) {
+        continue;
+      }
+      if (alias_.Alias(x, y) != AliasCheck::kMayAlias) {
+        continue;
+      }
+      HInstruction* x_base = GetArrayBase(x);
+      HInstruction* y_base = GetArrayBase(y);
+      if (x_base == y_base ||
+          loop->Contains(*x_base->GetBlock()) ||
+          loop->Contains(*y_base->GetBlock())) {
+        // The accesses would still alias in the fast version.
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Cannot check the aliasing of " << x->GetId()
+                                         << " and " << y->GetId());
+        return false;
+      }
+      if (x_base->GetId() > y_base->GetId()) {
+        std::swap(x_base, y_base);
+      }
+      bases.insert(std::make_pair(x_base, y_base));
+    }
+  }
+
+  if (bases.empty() || bases.size() > kMaxIdentityChecks) {
+    return false;
+  }
+
+  for (const auto& pair : bases) {
+    versioning->AddArrayIdentityCheck(pair.first, pair.second);
+  }
+  return true;
+}
+
+void HArrayAliasVersioning::Run() {
+  PRINT_PASS_MESSAGE(this, "start");
+
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  HLoopFormation formation(graph_);
+  formation.Run();
+
+  ArenaVector<HBasicBlock*> fast_headers = HLoopVersioning::VersionInnerLoops(
+      graph, this, [this](HLoopInformation_X86* loop, HLoopVersioning* versioning) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Visit loop " << loop->GetHeader()->GetBlockId());
+        return CollectChecks(loop, versioning);
+      });
+  for (HBasicBlock* fast_header : fast_headers) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Versioned loop, fast version " << fast_header->GetBlockId()
+                                     << " of " << GetMethodName(graph_));
+    MaybeRecordStat(MethodCompilationStat::kIntelLoopVersioned);
+  }
+
+  if (!fast_headers.empty()) {
+    // Later passes expect the loop hierarchy and induction variables to be up to date.
+    HLoopFormation form_loops(graph_);
+    form_loops.Run();
+    HFindInductionVariables find_ivs(graph_, "find_ivs_after_versioning", stats_);
+    find_ivs.Run();
+  }
+  PRINT_PASS_MESSAGE(this, "end");
+}
+
+}  // namespace art
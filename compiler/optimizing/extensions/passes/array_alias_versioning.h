@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_ARRAY_ALIAS_VERSIONING_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_ARRAY_ALIAS_VERSIONING_H_
+
+#include "ext_alias.h"
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+// Forward declarations.
+class HLoopInformation_X86;
+class HLoopVersioning;
+
+/**
+ * @brief Version inner loops whose array accesses may alias only because their
+ * bases could be the same array.
+ * @details The fast version runs when the bases are different objects, which the
+ * alias analysis then knows, so that load hoisting/store sinking and the other
+ * memory optimizations apply to it. The original loop is kept for the case where
+ * the arrays are the same.
+ */
+class HArrayAliasVersioning : public HOptimization_X86 {
+ public:
+  explicit HArrayAliasVersioning(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kArrayAliasVersioningPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    // Versioning clears the cached loops. Once all the loops are versioned, the pass
+    // forms them again and finds their IVs.
+    return kAnalysisNone;
+  }
+
+ private:
+  /**
+   * @brief Find the array identity checks removing all the may-alias pairs of loop.
+   * @return Returns true if every may-alias pair of array accesses can be checked.
+   */
+  bool CollectChecks(HLoopInformation_X86* loop, HLoopVersioning* versioning);
+
+  AliasCheck alias_;
+
+  static constexpr const char* kArrayAliasVersioningPassName = "array_alias_versioning";
+  static constexpr size_t kMaxIdentityChecks = 3;
+
+  DISALLOW_COPY_AND_ASSIGN(HArrayAliasVersioning);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_ARRAY_ALIAS_VERSIONING_H_
@@ -203,6 +203,230 @@ void HConstantCalculationSinking::FillAccumulator(HLoopInformation_X86* loop_inf
   }
 }
 
+/*
+ * @brief Compose x -> a * x + b with itself n times, modulo 2^64.
+ * @details The result is x -> res_a * x + res_b, computed by squaring in O(log n).
+ */
+static void ComposeAffine(uint64_t a, uint64_t b, uint64_t n, uint64_t* res_a, uint64_t* res_b) {
+  uint64_t result_a = 1u;
+  uint64_t result_b = 0u;
+  while (n != 0u) {
+    if ((n & 1u) != 0u) {
+      result_b = a * result_b + b;
+      result_a = a * result_a;
+    }
+    b = a * b + b;
+    a = a * a;
+    n >>= 1;
+  }
+  *res_a = result_a;
+  *res_b = result_b;
+}
+
+/*
+ * @brief Get the value of an integer constant, sign extended to 64 bits.
+ */
+static uint64_t GetIntegerValue(HConstant* constant) {
+  return constant->IsIntConstant()
+      ? static_cast<uint64_t>(static_cast<int64_t>(constant->AsIntConstant()->GetValue()))
+      : static_cast<uint64_t>(constant->AsLongConstant()->GetValue());
+}
+
+/*
+ * @brief Get the constant of the given integer type for a value computed modulo 2^64.
+ */
+static HConstant* GetIntegerConstant(HGraph* graph, Primitive::Type type, uint64_t value) {
+  if (type == Primitive::kPrimLong) {
+    return graph->GetLongConstant(static_cast<int64_t>(value));
+  }
+  return graph->GetIntConstant(static_cast<int32_t>(static_cast<uint32_t>(value)));
+}
+
+/**
+ * @brief Is the accumulation x = x * a + b (or x * a - b), with constant a, b and initial x?
+ * @param loop_info loop we're working on.
+ * @param accum_assoc the accumulator, with its phi and update, completed on success.
+ * @return true if the accumulation was evaluated for the trip count of the loop.
+ */
+bool HConstantCalculationSinking::FindAffineRecurrence(HLoopInformation_X86* loop_info,
+        AccumulatorAssociation& accum_assoc) const {
+  HPhi* phi = accum_assoc.phi;
+  HBinaryOperation* update = accum_assoc.linear_instruction->AsBinaryOperation();
+  HConstant* addend = update->GetConstantRight();
+  HInstruction* product = update->GetLeastConstantLeft();
+  if (addend == nullptr || !product->IsMul() || !phi->InputAt(0)->IsConstant()) {
+    return false;
+  }
+
+  // The product must only feed the update, and be of the accumulator itself.
+  HBinaryOperation* mul = product->AsBinaryOperation();
+  HConstant* multiplier = mul->GetConstantRight();
+  if (multiplier == nullptr || mul->GetLeastConstantLeft() != phi ||
+      !mul->HasOnlyOneNonEnvironmentUse() || mul->HasEnvironmentUses()) {
+    return false;
+  }
+
+  // The phi must only feed the product within the loop.
+  for (const HUseListNode<HInstruction*>& use : phi->GetUses()) {
+    HInstruction* user = use.GetUser();
+    if (user != mul && loop_info->Contains(*user->GetBlock())) {
+      return false;
+    }
+  }
+
+  int64_t iterations = loop_info->GetNumIterations(update->GetBlock());
+  if (iterations < 0) {
+    return false;
+  }
+
+  uint64_t b = GetIntegerValue(addend);
+  if (update->IsSub()) {
+    b = -b;
+  }
+  uint64_t res_a;
+  uint64_t res_b;
+  ComposeAffine(GetIntegerValue(multiplier), b, static_cast<uint64_t>(iterations), &res_a, &res_b);
+  uint64_t value = res_a * GetIntegerValue(phi->InputAt(0)->AsConstant()) + res_b;
+
+  accum_assoc.constant = addend;
+  accum_assoc.product = mul;
+  accum_assoc.const_instruction = GetIntegerConstant(graph_, phi->GetType(), value);
+  accum_assoc.finalized_calculation = true;
+  return true;
+}
+
+/**
+ * @brief Is the accumulation s = s + x (or s - x), where x, or its previous value, is
+ *        another accumulator of the loop x = x + c with constant c and initial x?
+ * @param loop_info loop we're working on.
+ * @param accum_assoc the accumulator, with its phi and update, completed on success.
+ * @return true if the accumulation was evaluated for the trip count of the loop.
+ *
+ * @details This is the sum of an arithmetic progression, the common sum += i included:
+ *  for (int i = 0; i < n; i++) {
+ *    sum += i;
+ *  }
+ */
+bool HConstantCalculationSinking::FindAccumulatorSum(HLoopInformation_X86* loop_info,
+        AccumulatorAssociation& accum_assoc) const {
+  HPhi* phi = accum_assoc.phi;
+  HInstruction* update = accum_assoc.linear_instruction;
+  HInstruction* term = nullptr;
+  if (update->InputAt(0) == phi) {
+    term = update->InputAt(1);
+  } else if (update->IsAdd() && update->InputAt(1) == phi) {
+    term = update->InputAt(0);
+  } else {
+    return false;
+  }
+
+  // The phi must only feed the update within the loop.
+  for (const HUseListNode<HInstruction*>& use : phi->GetUses()) {
+    HInstruction* user = use.GetUser();
+    if (user != update && loop_info->Contains(*user->GetBlock())) {
+      return false;
+    }
+  }
+
+  // Is the term the other accumulator or its update?
+  HPhi* other_phi = nullptr;
+  bool term_is_update = false;
+  HBasicBlock* header = loop_info->GetHeader();
+  if (term->IsPhi() && term->GetBlock() == header) {
+    other_phi = term->AsPhi();
+  } else if ((term->IsAdd() || term->IsSub()) && term->InputAt(0)->IsPhi() &&
+             term->InputAt(0)->GetBlock() == header) {
+    other_phi = term->InputAt(0)->AsPhi();
+    term_is_update = true;
+  } else {
+    return false;
+  }
+  if (other_phi == phi || other_phi->InputCount() != 2 ||
+      other_phi->GetType() != phi->GetType() || !other_phi->InputAt(0)->IsConstant()) {
+    return false;
+  }
+  HInstruction* other_update = other_phi->InputAt(1);
+  if ((term_is_update && other_update != term) ||
+      !(other_update->IsAdd() || other_update->IsSub()) ||
+      other_update->InputAt(0) != other_phi ||
+      !other_update->InputAt(1)->IsConstant() ||
+      !loop_info->ExecutedPerIteration(other_update)) {
+    return false;
+  }
+
+  int64_t iterations = loop_info->GetNumIterations(update->GetBlock());
+  if (iterations < 0) {
+    return false;
+  }
+
+  // The k-th accumulation, from 0, adds x0 + k * c, or x0 + (k + 1) * c for the update.
+  uint64_t n = static_cast<uint64_t>(iterations);
+  uint64_t m = term_is_update ? n + 1u : n - 1u;
+  uint64_t triangle = (n % 2u == 0u) ? (n / 2u) * m : n * (m / 2u);
+  uint64_t step = GetIntegerValue(other_update->InputAt(1)->AsConstant());
+  if (other_update->IsSub()) {
+    step = -step;
+  }
+  uint64_t sum = n * GetIntegerValue(other_phi->InputAt(0)->AsConstant()) + step * triangle;
+
+  accum_assoc.constant = other_update->InputAt(1)->AsConstant();
+  accum_assoc.const_instruction = GetIntegerConstant(graph_, phi->GetType(), sum);
+  accum_assoc.finalized_calculation = false;
+  return true;
+}
+
+/**
+ * @brief Fill to_sink with the recurrences evaluated in closed form: the affine recurrences
+ * and the sums of another accumulator, for any trip count.
+ * @param loop_info loop we're working on.
+ * @param choosen_iv the loop's main basic IV, which may be summed but not sunk.
+ * @param to_sink the list of constants to sink from the loop.
+ */
+void HConstantCalculationSinking::FillRecurrences(HLoopInformation_X86* loop_info,
+        HInductionVariable* choosen_iv,
+        std::vector<AccumulatorAssociation>& to_sink) const {
+  HBasicBlock* exit_block = loop_info->GetExitBlock();
+  for (HInstructionIterator it(loop_info->GetHeader()->GetPhis()); !it.Done(); it.Advance()) {
+    HPhi* phi = it.Current()->AsPhi();
+    if (phi->GetId() == choosen_iv->GetSsaId() || phi->InputCount() != 2 ||
+        (phi->GetType() != Primitive::kPrimInt && phi->GetType() != Primitive::kPrimLong)) {
+      continue;
+    }
+
+    HInstruction* update = phi->InputAt(1);
+    if (!(update->IsAdd() || update->IsSub()) ||
+        !loop_info->Contains(*update->GetBlock()) ||
+        !loop_info->ExecutedPerIteration(update) ||
+        !HasNoDependenciesWithinLoop(update, loop_info, phi)) {
+      continue;
+    }
+
+    // As in FillAccumulator, the phi used after the loop must have the value of the update.
+    bool phi_has_outside_loop_uses = false;
+    for (const HUseListNode<HInstruction*>& use : phi->GetUses()) {
+      if (!loop_info->Contains(*use.GetUser()->GetBlock())) {
+        phi_has_outside_loop_uses = true;
+      }
+    }
+    if (phi_has_outside_loop_uses && exit_block != nullptr &&
+        update->GetBlock()->Dominates(exit_block)) {
+      continue;
+    }
+
+    AccumulatorAssociation accum_assoc;
+    accum_assoc.phi = phi;
+    accum_assoc.linear_instruction = update;
+    accum_assoc.initial_constant = phi->InputAt(0);
+    if (FindAffineRecurrence(loop_info, accum_assoc)) {
+      PRINT_PASS_MESSAGE(this, "Affine recurrence of reg %d has been evaluated", phi->GetId());
+      to_sink.push_back(accum_assoc);
+    } else if (FindAccumulatorSum(loop_info, accum_assoc)) {
+      PRINT_PASS_MESSAGE(this, "Sum of reg %d has been evaluated", phi->GetId());
+      to_sink.push_back(accum_assoc);
+    }
+  }
+}
+
 /**
  * @brief Find the original value of a variable before entering a loop.
  * @param accum_assoc the AccumulatorAssociation for the calculation.
@@ -341,6 +565,32 @@ bool HConstantCalculationSinking::EvaluateFloatOperation(
 
   bool overflowed = false;
 
+  if (instruction_kind == HInstruction::kAdd || instruction_kind == HInstruction::kSub) {
+    // If the values are integers and all the partial sums are exactly representable, every
+    // addition is exact: the result is the same for any trip count and evaluation order.
+    const double initial = is_double
+        ? accum_assoc.initial_constant->AsDoubleConstant()->GetValue()
+        : accum_assoc.initial_constant->AsFloatConstant()->GetValue();
+    const double operand = is_double
+        ? accum_assoc.constant->AsDoubleConstant()->GetValue()
+        : accum_assoc.constant->AsFloatConstant()->GetValue();
+    // 2^53 and 2^24, the first integers not followed by a representable one.
+    const double max_exact = is_double ? 9007199254740992.0 : 16777216.0;
+    if (std::trunc(initial) == initial && std::trunc(operand) == operand &&
+        std::fabs(initial) + static_cast<double>(iterations) * std::fabs(operand) < max_exact) {
+      const double total = static_cast<double>(iterations) * operand;
+      const double value = (instruction_kind == HInstruction::kAdd) ? initial + total
+                                                                    : initial - total;
+      accum_assoc.const_instruction = is_double
+          ? static_cast<HInstruction*>(graph_->GetDoubleConstant(value))
+          : static_cast<HInstruction*>(graph_->GetFloatConstant(static_cast<float>(value)));
+      accum_assoc.is_zero = (value == 0.0);
+      accum_assoc.is_inf = false;
+      accum_assoc.finalized_calculation = true;
+      return true;
+    }
+  }
+
   if (is_double) {
     // In double, we need to get the original value as well.
     double value = accum_assoc.initial_constant->AsDoubleConstant()->GetValue();
@@ -963,14 +1213,22 @@ void HConstantCalculationSinking::RemoveDeadCode(
   for (it = to_remove.begin(); it != to_remove.end(); it++) {
     HPhi* phi = (*it).phi;
     DeletePhiAndUsers(phi);
+    if ((*it).product != nullptr) {
+      // The phi feeds the product of an affine recurrence, which feeds the accumulation.
+      HInstruction* insn = (*it).linear_instruction;
+      RemoveAsUser(insn);
+      RemoveFromEnvironmentUsers(insn);
+      insn->GetBlock()->RemoveInstruction(insn, false);
+    }
   }
 }
 
 /**
  * @brief Handle a loop for the sinking of an constant operation.
  * @param loop_info info about the loop we're working on.
+ * @return true if an accumulator was sunk.
  */
-void HConstantCalculationSinking::HandleLoop(HLoopInformation_X86* loop_info) const {
+bool HConstantCalculationSinking::HandleLoop(HLoopInformation_X86* loop_info) const {
   std::vector<AccumulatorAssociation> accumulator_list;
   std::vector<AccumulatorAssociation> to_remove;
   std::vector<AccumulatorAssociation> to_sink;
@@ -979,20 +1237,21 @@ void HConstantCalculationSinking::HandleLoop(HLoopInformation_X86* loop_info) co
   if (!IsLoopGoodForCCS(loop_info)) {
     PRINT_PASS_MESSAGE(this, "Loop with head bb %d is not good for CCS",
                        loop_info->GetHeader()->GetBlockId());
-    return;
+    return false;
   }
 
   // Step 1: Get loop's main IV.
   HInductionVariable* choosen_iv = GetBasicInductionVariable(loop_info);
   if (choosen_iv == nullptr) {
-    return;
+    return false;
   }
 
   // Step 2: Find the accumulators that are eligible.
   FillAccumulator(loop_info, choosen_iv, accumulator_list);
 
-  // Step 3: Do constant calculation on our accumulator.
+  // Step 3: Do constant calculation on our accumulator, and evaluate the recurrences.
   DoConstantCalculation(accumulator_list, loop_info, to_sink);
+  FillRecurrences(loop_info, choosen_iv, to_sink);
 
   // Step 4: Sink the constant operations.
   DoConstantSinking(to_sink, loop_info, to_remove);
@@ -1002,6 +1261,7 @@ void HConstantCalculationSinking::HandleLoop(HLoopInformation_X86* loop_info) co
 
   PRINT_PASS_MESSAGE(this, "Finished to sink constant operation for loop with head bb #%d",
                      loop_info->GetHeader()->GetBlockId());
+  return !to_remove.empty();
 }
 
 void HConstantCalculationSinking::Run() {
@@ -1014,7 +1274,9 @@ void HConstantCalculationSinking::Run() {
   // Walk through all inner loops.
   for (HOnlyInnerLoopIterator it_loop(loop_info); !it_loop.Done(); it_loop.Advance()) {
     HLoopInformation_X86* current = it_loop.Current();
-    HandleLoop(current);
+    // Sinking a sum frees the accumulator it adds up, try again until nothing is sunk.
+    while (HandleLoop(current)) {
+    }
   }
 }
 
@@ -42,7 +42,7 @@ class HConstantCalculationSinking : public HOptimization_X86 {
   struct AccumulatorAssociation {
     AccumulatorAssociation() :
       linear_instruction(nullptr), const_instruction(nullptr),
-      initial_constant(nullptr), phi(nullptr), constant(nullptr),
+      initial_constant(nullptr), phi(nullptr), constant(nullptr), product(nullptr),
       finalized_calculation(false), is_zero(false), is_inf(false) {
     }
 
@@ -51,6 +51,8 @@ class HConstantCalculationSinking : public HOptimization_X86 {
     HInstruction* initial_constant;
     HPhi* phi;
     HConstant* constant;
+    // The multiplication of an affine recurrence, which is removed with the accumulation.
+    HInstruction* product;
     bool finalized_calculation;
     bool is_zero;
     bool is_inf;
@@ -64,6 +66,15 @@ class HConstantCalculationSinking : public HOptimization_X86 {
   void FillAccumulator(HLoopInformation_X86* loop_info, HInductionVariable* choosen_iv,
           std::vector<AccumulatorAssociation>& accumulator_list) const;
 
+  void FillRecurrences(HLoopInformation_X86* loop_info, HInductionVariable* choosen_iv,
+          std::vector<AccumulatorAssociation>& to_sink) const;
+
+  bool FindAffineRecurrence(HLoopInformation_X86* loop_info,
+          AccumulatorAssociation& accum_assoc) const;
+
+  bool FindAccumulatorSum(HLoopInformation_X86* loop_info,
+          AccumulatorAssociation& accum_assoc) const;
+
   bool FindOrigin(AccumulatorAssociation& accum_assoc, bool& seen_base_twice) const;
 
   bool EvaluateFloatOperation(
@@ -98,7 +109,7 @@ class HConstantCalculationSinking : public HOptimization_X86 {
 
   void RemoveDeadCode(const std::vector<AccumulatorAssociation>& to_remove) const;
 
-  void HandleLoop(HLoopInformation_X86* loop_info) const;
+  bool HandleLoop(HLoopInformation_X86* loop_info) const;
 
   // This is 65 because after 65 iterations, we will have overflowed in 64 bits.
   static constexpr int64_t kMaximumEvaluationIterations = 65;
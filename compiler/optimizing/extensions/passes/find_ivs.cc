@@ -223,16 +223,18 @@ void HFindInductionVariables::DetectAndInitializeBasicIV(HLoopInformation_X86* i
   // If we found a candidate, check that it matches criteria for basic IV.
   if (candidate != nullptr) {
     // The type conversions might occur after the add operation, therefore we want to trim it.
+    bool is_narrowed = false;
     if (candidate->IsTypeConversion()) {
       if (IsValidCastForIV(candidate, info)) {
         candidate = candidate->InputAt(0);
+        is_narrowed = true;
       } else {
         return;
       }
     }
-    // We want the right side of the instruction.
-    // Currently we only look at additions, future work consists of handling negative increments.
-    if (candidate->IsAdd()) {
+    // We want the right side of the instruction: either phi + constant, or phi - constant
+    // whose increment is the negated constant.
+    if (candidate->IsAdd() || candidate->IsSub()) {
       HBinaryOperation* binary = candidate->AsBinaryOperation();
 
       if (binary != nullptr) {
@@ -241,32 +243,58 @@ void HFindInductionVariables::DetectAndInitializeBasicIV(HLoopInformation_X86* i
           return;
         }
 
+        // constant - phi flips the sign of the IV at each iteration.
+        if (candidate->IsSub() && binary->GetLeft() != phi) {
+          return;
+        }
+
         // Get constant right is cool because it will look to the right but,
         //  if right is not a constant, will look to the left for a constant.
         HInstruction* right = binary->GetConstantRight();
 
         if (right != nullptr) {
-          bool is_positive_or_zero = false;
+          bool is_accepted = false;
           bool is_wide = false;
           bool is_fp = false;
+          if (candidate->IsSub() && !right->IsIntConstant() && !right->IsLongConstant()) {
+            // The floating-point subtractions would need their own bound computation.
+            return;
+          }
           if (right->IsFloatConstant()) {
-            is_positive_or_zero = right->AsFloatConstant()->GetValue() >= 0.0;
+            is_accepted = right->AsFloatConstant()->GetValue() >= 0.0;
             is_fp = true;
           } else if (right->IsDoubleConstant()) {
             is_wide = true;
             is_fp = true;
-            is_positive_or_zero = right->AsDoubleConstant()->GetValue() >= 0;
+            is_accepted = right->AsDoubleConstant()->GetValue() >= 0;
           } else if (right->IsIntConstant()) {
-            is_positive_or_zero = right->AsIntConstant()->GetValue() >= 0;
+            int32_t value = right->AsIntConstant()->GetValue();
+            if (candidate->IsSub()) {
+              if (value == std::numeric_limits<int32_t>::min()) {
+                return;
+              }
+              value = -value;
+              right = graph_->GetIntConstant(value);
+            }
+            // A narrowed IV is only checked against its bound, keep it counting up.
+            is_accepted = is_narrowed ? (value >= 0) : (value != 0);
           } else if (right->IsLongConstant()) {
             is_wide = true;
-            is_positive_or_zero = right->AsLongConstant()->GetValue() >= 0;
+            int64_t value = right->AsLongConstant()->GetValue();
+            if (candidate->IsSub()) {
+              if (value == std::numeric_limits<int64_t>::min()) {
+                return;
+              }
+              value = -value;
+              right = graph_->GetLongConstant(value);
+            }
+            is_accepted = (value != 0);
           } else {
             return;
           }
 
-          // Only accept this IV if the delta_value is positive for now.
-          if (is_positive_or_zero) {
+          // The integer IVs go either way, the floating-point ones only up for now.
+          if (is_accepted) {
             ArenaAllocator* arena = graph_->GetArena();
             ArenaVector<HInductionVariable*>& iv_list = info->GetInductionVariables();
 
@@ -290,6 +318,13 @@ void HFindInductionVariables::DetectAndInitializeBasicIV(HLoopInformation_X86* i
 void HFindInductionVariables::Run() {
   HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
   HLoopInformation_X86* loop_info = graph->GetLoopInformation();
+
+  // Nothing touched the loops since the IVs were last computed.
+  if (graph->AreAnalysesValid(kAnalysisInductionVariables | kAnalysisLoopBounds)) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Find IVs: Cached " << GetMethodName(graph));
+    return;
+  }
+
   PRINT_PASS_OSTREAM_MESSAGE(this, "Find IVs: Begin " << GetMethodName(graph));
   for (HOutToInLoopIterator loop_iter(loop_info); !loop_iter.Done(); loop_iter.Advance()) {
     HLoopInformation_X86* current = loop_iter.Current();
@@ -298,6 +333,7 @@ void HFindInductionVariables::Run() {
     // And also calculate the loop bounds.
     current->ComputeBoundInformation();
   }
+  graph->MarkAnalysesValid(kAnalysisInductionVariables | kAnalysisLoopBounds);
   PRINT_PASS_OSTREAM_MESSAGE(this, "Find IVs: End " << GetMethodName(graph));
 }
 }  // namespace art
@@ -48,6 +48,10 @@ class HFindInductionVariables : public HOptimization_X86 {
   static constexpr const char* kFindIvsPassName = "find_ivs";
 
   void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    return kAnalysisNone;
+  }
 };
 }  // namespace art
 
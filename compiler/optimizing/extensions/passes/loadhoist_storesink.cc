@@ -27,6 +27,7 @@
 #include "nodes.h"
 
 #include <unordered_set>
+#include <vector>
 
 namespace art {
 
@@ -38,9 +39,10 @@ void LoadHoistStoreSink::Run() {
   }
   HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
   HLoopInformation_X86* loop_start = graph->GetLoopInformation();
-  // For each inner loop in the graph.
-  bool graph_changed = false;
-  for (HOnlyInnerLoopIterator it(loop_start); !it.Done(); it.Advance()) {
+  // For each loop in the graph, inner loops first: the accesses hoisted and sunk out of an
+  // inner loop land in its pre-header and exit block, where the outer loop can move them
+  // out of the whole loop nest.
+  for (HInToOutLoopIterator it(loop_start); !it.Done(); it.Advance()) {
     HLoopInformation_X86* loop = it.Current();
 
     // First, we need to check that the loop respect some criteria.
@@ -60,11 +62,10 @@ void LoadHoistStoreSink::Run() {
                                       << sets_to_sink.size()
                                       << " sets to sink out of the loop.");
 
-    graph_changed |= DoLoadHoistStoreSink(loop, get_to_set, sets_to_sink);
-  }
-
-  if (graph_changed) {
-    graph->RebuildDomination();
+    if (DoLoadHoistStoreSink(loop, get_to_set, sets_to_sink)) {
+      // The outer loops are checked with the dominators, rebuild them now.
+      graph->RebuildDomination();
+    }
   }
 }
 
@@ -255,6 +256,9 @@ bool LoadHoistStoreSink::DoLoadHoistStoreSink(HLoopInformation_X86* loop,
                                       << " successfully!");
   }
   MaybeRecordStat(MethodCompilationStat::kIntelStoreSink, sets_to_sink.size());
+  if (!get_to_set.empty() || !sets_to_sink.empty()) {
+    MaybeRecordLoopInliningBenefit(loop);
+  }
 
   // If we added a suspend block, we need to rebuild the dominators.
   return suspend_block_created;
@@ -277,6 +281,39 @@ static bool IsVolatile(HInstruction* insn) {
   };
 }
 
+/*
+ * @brief Can the invoke be ignored when moving memory accesses out of a loop?
+ * @details An intrinsic that cannot throw does not leave the loop, its side effects are
+ *          then checked against each access with IsTransparentFor.
+ */
+static bool IsTransparentInvoke(HInstruction* insn) {
+  DCHECK(insn != nullptr);
+  return insn->IsInvoke() && insn->AsInvoke()->IsIntrinsic() && !insn->CanThrow();
+}
+
+/*
+ * @brief Does the invoke neither write the location the access reads, nor read the
+ *        location the access writes?
+ */
+static bool IsTransparentFor(HInstruction* invoke, HInstruction* access) {
+  SideEffects invoke_effects = invoke->GetSideEffects();
+  SideEffects access_effects = access->GetSideEffects();
+  return !access_effects.MayDependOn(invoke_effects) &&
+         !invoke_effects.MayDependOn(access_effects);
+}
+
+/*
+ * @brief Are all the given invokes transparent for the access?
+ */
+static bool AreTransparentFor(const std::vector<HInstruction*>& invokes, HInstruction* access) {
+  for (HInstruction* invoke : invokes) {
+    if (!IsTransparentFor(invoke, access)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 static bool LoopHeaderOrInvariant(HLoopInformation_X86* loop, HInstruction* set,
                                   bool check_is_phi) {
   DCHECK(loop != nullptr);
@@ -322,6 +359,8 @@ bool LoadHoistStoreSink::FindLoadStoreCouples(HLoopInformation_X86* loop,
 
   // Container of side effects instructions (include sets) in the loop.
   std::unordered_set<HInstruction*> has_side_effects;
+  // Invokes of the loop that cannot leave it, whose side effects are checked per access.
+  std::vector<HInstruction*> transparent_invokes;
 
   HBasicBlock* exit_block = loop->GetExitBlock();
   CHECK(exit_block != nullptr);  // Paranoid: we made sure there is one in the gate.
@@ -334,6 +373,11 @@ bool LoadHoistStoreSink::FindLoadStoreCouples(HLoopInformation_X86* loop,
       HInstruction* insn = insn_it.Current();
       HInstruction::InstructionKind insn_type = insn->GetKind();
 
+      if (IsTransparentInvoke(insn)) {
+        transparent_invokes.push_back(insn);
+        continue;
+      }
+
       // Is this an instruction that can side exit?
       if (insn->HasEnvironment() && !(insn->IsSuspendCheck() || insn->IsSuspend())) {
         PRINT_PASS_OSTREAM_MESSAGE(this, "Instruction can side exit: " << insn);
@@ -377,6 +421,12 @@ bool LoadHoistStoreSink::FindLoadStoreCouples(HLoopInformation_X86* loop,
           }
         }
 
+        // An access in an inner loop may run any number of times per iteration of this loop,
+        // only the accesses of this loop itself are candidates.
+        if (current_block->GetLoopInformation() != loop) {
+          invariant_address = false;
+        }
+
         // Valid candidates so far are:
         // - Field memory accesses that have an invariant address
         // - Array memory accesses that have an invariant address and an invariant index.
@@ -441,11 +491,14 @@ bool LoadHoistStoreSink::FindLoadStoreCouples(HLoopInformation_X86* loop,
     // 2. Get and set should not be volatile.
     // 3. Get MUST ONLY alias with the set.
     // 4. Get MUST NOT alias with anything other instruction.
-    // 5. Get and Set MUST be in the same basic block.
-    // 6. Get and Set MUST execute every loop iteration. Can test just get since
-    //    they are both in the same block.
+    // 5. Get MUST dominate the Set, they are in the same basic block in an inner loop.
+    //    In an outer loop, the get and set moved out of its inner loops are in their
+    //    pre-header and exit block.
+    // 6. Get and Set MUST execute every loop iteration.
+    // 7. The transparent invokes MUST NOT access the memory of the get and set.
     if (nb_must_alias == 1 && valid_candidate && set_candidate != nullptr) {
       HBasicBlock* get_bb = get->GetBlock();
+      HBasicBlock* set_bb = set_candidate->GetBlock();
       bool ls_couple_is_valid = true;
 
       if (IsVolatile(get)) {
@@ -453,23 +506,24 @@ bool LoadHoistStoreSink::FindLoadStoreCouples(HLoopInformation_X86* loop,
         DCHECK(IsVolatile(set_candidate));  // Paranoid.
         PRINT_PASS_OSTREAM_MESSAGE(this, "Get and set instructions should not be volatile.");
         return false;
-      } else if (get_to_idx[get] > set_to_idx[set_candidate]) {
+      } else if (get_bb == set_bb && get_to_idx[get] > set_to_idx[set_candidate]) {
         // The get instruction must be before the set.
         PRINT_PASS_OSTREAM_MESSAGE(this, "Get instruction must be before the set instruction.");
         ls_couple_is_valid = false;
-      } else if (get_bb != set_candidate->GetBlock()) {
-        // The get and set must be in the same basic block.
+      } else if (get_bb != set_bb && (loop->IsInner() || !get_bb->Dominates(set_bb))) {
+        // The get and set must be in the same basic block, or the get must dominate the set
+        // in an outer loop.
         PRINT_PASS_OSTREAM_MESSAGE(this, get << " and " << set_candidate <<
                                    " are in different blocks");
         ls_couple_is_valid = false;
-      } else if (!loop->ExecutedPerIteration(get)) {
+      } else if (!loop->ExecutedPerIteration(get) || !loop->ExecutedPerIteration(set_candidate)) {
         // Get and set instructions must be executed at every iteration.
         PRINT_PASS_OSTREAM_MESSAGE(this, get << " and " << set_candidate <<
                                    " may not be executed every loop iteration");
         ls_couple_is_valid = false;
-      } else if (!get_bb->Dominates(exit_block)) {
+      } else if (!set_bb->Dominates(exit_block)) {
         // Their basic block must dominate the exit block in order for the set sinking to be valid.
-        PRINT_PASS_OSTREAM_MESSAGE(this, "Block #" << get_bb->GetBlockId() << " does not dominate"
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Block #" << set_bb->GetBlockId() << " does not dominate"
                                          << " exit block #" << exit_block->GetBlockId());
         ls_couple_is_valid = false;
       } else if (has_suspend && get->GetType() == Primitive::kPrimNot) {
@@ -487,6 +541,11 @@ bool LoadHoistStoreSink::FindLoadStoreCouples(HLoopInformation_X86* loop,
                                    << " point, and its input"
                                    << " is neither loop header phi nor invariant.");
         ls_couple_is_valid = false;
+      } else if (!AreTransparentFor(transparent_invokes, get) ||
+                 !AreTransparentFor(transparent_invokes, set_candidate)) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, get << " and " << set_candidate <<
+                                   " may be accessed by an invoke of the loop");
+        ls_couple_is_valid = false;
       }
 
       if (ls_couple_is_valid) {
@@ -565,6 +624,11 @@ bool LoadHoistStoreSink::FindLoadStoreCouples(HLoopInformation_X86* loop,
       }
     }
 
+    if (!AreTransparentFor(transparent_invokes, set)) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Set " << set << " may be read by an invoke of the loop.");
+      continue;
+    }
+
     // If there is any aliasing, we discard the candidate.
     if (set_aliases) {
       DCHECK(alias_insn != nullptr);
@@ -584,9 +648,6 @@ bool LoadHoistStoreSink::FindLoadStoreCouples(HLoopInformation_X86* loop,
 bool LoadHoistStoreSink::LoopGate(HLoopInformation_X86* loop) const {
   DCHECK(loop != nullptr);
 
-  // The loop must be innermost.
-  DCHECK(loop->IsInner());
-
   // Loop should have only one exit block where to sink the stores.
   if (!loop->HasOneExitEdge()) {
     PRINT_PASS_OSTREAM_MESSAGE(this, "Loop #" << loop->GetHeader()->GetBlockId()
@@ -601,13 +662,8 @@ bool LoadHoistStoreSink::LoopGate(HLoopInformation_X86* loop) const {
     return false;
   }
 
-  // We cannot hoist or sink memory accesses if the loop has invokes or can side exit.
-  if (loop->CanSideExit()) {
-    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop #" << loop->GetHeader()->GetBlockId()
-                                      << " can side exit.");
-    return false;
-  }
-
+  // The instructions that can side exit are rejected by FindLoadStoreCouples, which lets
+  // the invokes that cannot leave the loop through.
   return true;
 }
 
@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loop_bounds_check_elimination.h"
+
+#include "ext_utility.h"
+#include "find_ivs.h"
+#include "graph_x86.h"
+#include "induction_variable.h"
+#include "loop_formation.h"
+#include "loop_iterators.h"
+
+namespace art {
+
+bool HLoopBoundsCheckElimination::GetRange(HLoopInformation_X86* loop, LoopRange* range) {
+  HInductionVariable* biv = loop->GetBoundInformation().loop_biv_;
+  if (biv == nullptr || biv->IsFP()) {
+    return false;
+  }
+  HPhi* phi = biv->GetPhiInsn();
+  HInstruction* linear = biv->GetLinearInsn();
+  int64_t increment = biv->GetIncrement();
+  if (phi->GetType() != Primitive::kPrimInt || phi->InputCount() != 2u ||
+      loop->PhiInput(phi, true) != linear || increment <= 0 || increment > kMaxOffset) {
+    return false;
+  }
+
+  // The loop must leave through a single test, done at each iteration.
+  if (!loop->HasOneExitEdge() || loop->GetBackEdges().size() != 1u) {
+    return false;
+  }
+  HBasicBlock* exit_block = loop->GetExitBlock();
+  HBasicBlock* exiting_block = nullptr;
+  for (HBasicBlock* predecessor : exit_block->GetPredecessors()) {
+    if (loop->Contains(*predecessor)) {
+      exiting_block = predecessor;
+    }
+  }
+  if (exiting_block == nullptr || !exiting_block->Dominates(loop->GetBackEdges()[0])) {
+    return false;
+  }
+  HIf* branch = exiting_block->GetLastInstruction()->AsIf();
+  HCondition* condition = (branch == nullptr) ? nullptr : branch->InputAt(0)->AsCondition();
+  if (condition == nullptr) {
+    return false;
+  }
+
+  size_t iv_index = (condition->InputAt(0) == phi || condition->InputAt(0) == linear) ? 0u : 1u;
+  HInstruction* iv_value = condition->InputAt(iv_index);
+  HInstruction* bound = condition->InputAt(1u - iv_index);
+  if ((iv_value != phi && iv_value != linear) || bound->GetType() != Primitive::kPrimInt ||
+      loop->Contains(*bound->GetBlock())) {
+    return false;
+  }
+
+  // Get the condition staying in the loop, with the IV on the left.
+  IfCondition cond = condition->GetCondition();
+  if (iv_index == 1u) {
+    cond = FlipConditionForOperandSwap(cond);
+  }
+  HBasicBlock* body = branch->IfFalseSuccessor();
+  if (branch->IfTrueSuccessor() != exit_block) {
+    body = branch->IfTrueSuccessor();
+  } else {
+    cond = NegateCondition(cond);
+  }
+  if (cond != kCondLT && cond != kCondLE) {
+    return false;
+  }
+
+  range->phi = phi;
+  range->linear = linear;
+  range->increment = increment;
+  range->start = loop->PhiInput(phi, false);
+  range->bound = bound;
+  range->is_inclusive = (cond == kCondLE);
+  range->tested_body = nullptr;
+  if (iv_value == phi) {
+    // The blocks before the test see the phi of the last iteration untested.
+    if (body->GetPredecessors().size() != 1u) {
+      return false;
+    }
+    range->tested_body = body;
+  }
+  return true;
+}
+
+bool HLoopBoundsCheckElimination::GetOffset(HInstruction* index,
+                                            const LoopRange& range,
+                                            int64_t* offset) {
+  int64_t value = 0;
+  for (size_t depth = 0; depth < kMaxOffsetDepth; depth++) {
+    if (index == range.phi) {
+      *offset = value;
+      return true;
+    }
+    if (index == range.linear) {
+      *offset = value + range.increment;
+      return std::abs(*offset) <= kMaxOffset;
+    }
+
+    if (index->IsAdd() && index->InputAt(1)->IsIntConstant()) {
+      value += index->InputAt(1)->AsIntConstant()->GetValue();
+      index = index->InputAt(0);
+    } else if (index->IsAdd() && index->InputAt(0)->IsIntConstant()) {
+      value += index->InputAt(0)->AsIntConstant()->GetValue();
+      index = index->InputAt(1);
+    } else if (index->IsSub() && index->InputAt(1)->IsIntConstant()) {
+      value -= index->InputAt(1)->AsIntConstant()->GetValue();
+      index = index->InputAt(0);
+    } else {
+      return false;
+    }
+    if (std::abs(value) > kMaxOffset) {
+      return false;
+    }
+  }
+  return false;
+}
+
+HBasicBlock* HLoopBoundsCheckElimination::AddTakenTest(HLoopInformation_X86* loop,
+                                                       const LoopRange& range) {
+  // The first test of the phi is start against bound: nothing to guard when it folds to true.
+  if (range.start->IsIntConstant() && range.bound->IsIntConstant()) {
+    int32_t start = range.start->AsIntConstant()->GetValue();
+    int32_t bound = range.bound->AsIntConstant()->GetValue();
+    if (range.is_inclusive ? (start <= bound) : (start < bound)) {
+      return loop->GetPreHeader();
+    }
+  }
+
+  ArenaAllocator* arena = graph_->GetArena();
+  graph_->TransformLoopHeaderForBCE(loop->GetHeader());
+  HBasicBlock* new_pre_header = loop->GetPreHeader();
+  HBasicBlock* if_block = new_pre_header->GetDominator();
+  HBasicBlock* true_block = if_block->GetSuccessors()[0];
+  HBasicBlock* false_block = if_block->GetSuccessors()[1];
+  true_block->AddInstruction(new (arena) HGoto());
+  false_block->AddInstruction(new (arena) HGoto());
+  new_pre_header->AddInstruction(new (arena) HGoto());
+
+  HCondition* taken = range.is_inclusive
+      ? static_cast<HCondition*>(new (arena) HLessThanOrEqual(range.start, range.bound))
+      : static_cast<HCondition*>(new (arena) HLessThan(range.start, range.bound));
+  if_block->AddInstruction(taken);
+  if_block->AddInstruction(new (arena) HIf(taken));
+  return true_block;
+}
+
+void HLoopBoundsCheckElimination::AddDeoptimization(HLoopInformation_X86* loop,
+                                                    HBasicBlock* block,
+                                                    HInstruction* condition,
+                                                    DeoptimizationKind kind,
+                                                    HInstruction* state) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HInstruction* cursor = block->GetLastInstruction();
+  block->InsertInstructionBefore(condition, cursor);
+  HDeoptimize* deoptimize = new (arena) HDeoptimize(arena, condition, kind, state->GetDexPc());
+  block->InsertInstructionBefore(deoptimize, cursor);
+  // Deoptimizing resumes the interpreter at the first iteration.
+  deoptimize->CopyEnvironmentFromWithLoopPhiAdjustment(state->GetEnvironment(), loop->GetHeader());
+}
+
+bool HLoopBoundsCheckElimination::RemoveBoundsChecks(HLoopInformation_X86* loop) {
+  ArenaAllocator* arena = graph_->GetArena();
+  LoopRange range;
+  if (!GetRange(loop, &range)) {
+    return false;
+  }
+
+  // The deoptimizations need the state of the method when entering the loop.
+  HInstruction* state = loop->GetSuspendCheck();
+  if (state == nullptr && loop->HasSuspend()) {
+    state = loop->GetSuspend();
+  }
+  if (state == nullptr || !state->HasEnvironment()) {
+    return false;
+  }
+
+  // Group the bounds checks covered by the range by array.
+  ArenaVector<ArrayChecks> arrays(arena->Adapter(kArenaAllocMisc));
+  for (HBlocksInLoopIterator it_loop(*loop); !it_loop.Done(); it_loop.Advance()) {
+    HBasicBlock* block = it_loop.Current();
+    if (range.tested_body != nullptr && !range.tested_body->Dominates(block)) {
+      continue;
+    }
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      HBoundsCheck* bounds_check = it.Current()->AsBoundsCheck();
+      int64_t offset = 0;
+      if (bounds_check == nullptr || !GetOffset(bounds_check->InputAt(0), range, &offset)) {
+        continue;
+      }
+      HArrayLength* length = bounds_check->InputAt(1)->AsArrayLength();
+      if (length == nullptr || length->IsStringLength()) {
+        continue;
+      }
+      HInstruction* array = length->InputAt(0);
+      if (array->IsNullCheck() && loop->Contains(*array->GetBlock())) {
+        array = array->InputAt(0);
+      }
+      if (loop->Contains(*array->GetBlock())) {
+        continue;
+      }
+
+      auto same_array = [array](const ArrayChecks& checks) { return checks.array == array; };
+      auto checks = std::find_if(arrays.begin(), arrays.end(), same_array);
+      if (checks == arrays.end()) {
+        HInstruction* invariant_length = loop->Contains(*length->GetBlock()) ? nullptr : length;
+        arrays.push_back({ array, invariant_length, offset, offset,
+                           ArenaVector<HBoundsCheck*>(arena->Adapter(kArenaAllocMisc)) });
+        checks = arrays.end() - 1;
+      }
+      checks->min_offset = std::min(checks->min_offset, offset);
+      checks->max_offset = std::max(checks->max_offset, offset);
+      checks->checks.push_back(bounds_check);
+    }
+  }
+
+  // The IV never goes below start, it does not wrap.
+  auto fails_first = [&](const ArrayChecks& checks) {
+    if (range.start->IsIntConstant() &&
+        range.start->AsIntConstant()->GetValue() + checks.min_offset < 0) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "The checks of array " << checks.array->GetId()
+                                       << " fail at the first iteration");
+      return true;
+    }
+    return false;
+  };
+  arrays.erase(std::remove_if(arrays.begin(), arrays.end(), fails_first), arrays.end());
+  if (arrays.empty()) {
+    return false;
+  }
+
+  // A deoptimization invalidates the compiled code: only check the range when the loop
+  // is entered. If the update of the phi is tested, the first iteration always runs.
+  HBasicBlock* guard = (range.tested_body != nullptr) ? AddTakenTest(loop, range)
+                                                      : loop->GetPreHeader();
+  for (ArrayChecks& checks : arrays) {
+    HInstruction* length = checks.length;
+    if (length == nullptr) {
+      if (checks.array->CanBeNull()) {
+        HInstruction* is_null = new (arena) HEqual(checks.array, graph_->GetNullConstant());
+        AddDeoptimization(loop, guard, is_null, DeoptimizationKind::kLoopNullBCE, state);
+      }
+      length = new (arena) HArrayLength(checks.array, state->GetDexPc());
+      guard->InsertInstructionBefore(length, guard->GetLastInstruction());
+    }
+
+    // value + limit must stay below the length. The limit covers the increment as
+    // well, so that the IV cannot wrap around either.
+    int64_t limit = std::max(checks.max_offset, range.increment - 1);
+    auto add_upper_check = [&](HInstruction* value, bool is_inclusive) {
+      int32_t margin = static_cast<int32_t>(limit + (is_inclusive ? 1 : 0));
+      HInstruction* max_value = length;
+      if (margin != 0) {
+        max_value = new (arena) HSub(Primitive::kPrimInt, length, graph_->GetIntConstant(margin));
+        guard->InsertInstructionBefore(max_value, guard->GetLastInstruction());
+      }
+      HInstruction* is_above = new (arena) HGreaterThan(value, max_value);
+      AddDeoptimization(loop, guard, is_above, DeoptimizationKind::kLoopBoundsBCE, state);
+    };
+    add_upper_check(range.bound, range.is_inclusive);
+    if (range.tested_body == nullptr) {
+      // The first iteration runs before the test.
+      add_upper_check(range.start, true);
+    }
+    if (!range.start->IsIntConstant()) {
+      HInstruction* min_start = graph_->GetIntConstant(static_cast<int32_t>(-checks.min_offset));
+      HInstruction* is_below = new (arena) HLessThan(range.start, min_start);
+      AddDeoptimization(loop, guard, is_below, DeoptimizationKind::kLoopBoundsBCE, state);
+    }
+
+    for (HBoundsCheck* bounds_check : checks.checks) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Bounds check " << bounds_check->GetId()
+                                       << " replaced with checks before the loop");
+      bounds_check->ReplaceWith(bounds_check->InputAt(0));
+      bounds_check->GetBlock()->RemoveInstruction(bounds_check);
+      MaybeRecordStat(MethodCompilationStat::kIntelLoopBoundsCheckRemoved);
+    }
+  }
+  return true;
+}
+
+void HLoopBoundsCheckElimination::Run() {
+  PRINT_PASS_MESSAGE(this, "start");
+
+  HLoopFormation formation(graph_);
+  formation.Run();
+  HFindInductionVariables find_ivs(graph_, "find_ivs_for_loop_bce", stats_);
+  find_ivs.Run();
+
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  for (HOutToInLoopIterator it(graph->GetLoopInformation()); !it.Done(); it.Advance()) {
+    HLoopInformation_X86* loop = it.Current();
+    if (loop->IsOrHasIrreducibleLoop() || loop->HasTryCatchHandler() ||
+        loop->GetPreHeader() == nullptr || loop->GetHeader()->IsTryBlock() ||
+        !loop->GetHeader()->IsLoopPreHeaderFirstPredecessor()) {
+      continue;
+    }
+    if (RemoveBoundsChecks(loop)) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Bounds checks of loop " << loop->GetHeader()->GetBlockId()
+                                       << " hoisted before the loop");
+    }
+  }
+
+  PRINT_PASS_MESSAGE(this, "end");
+}
+
+}  // namespace art
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_BOUNDS_CHECK_ELIMINATION_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_BOUNDS_CHECK_ELIMINATION_H_
+
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+// Forward declaration.
+class HLoopInformation_X86;
+
+/**
+ * @brief Bounds check elimination for the loops reshaped by the X86 extensions.
+ * @details The loop must count up a basic IV, by a small constant, while it is below
+ * (or equal to) a loop invariant. The bounds checks of its blocks indexing an invariant
+ * array with the IV plus a constant are then replaced by range checks before the loop,
+ * which deoptimize when any of them would fail. The range checks are skipped when the
+ * loop is not entered. The checks left are dealt with by HX86BoundsCheckMemory as before.
+ */
+class HLoopBoundsCheckElimination : public HOptimization_X86 {
+ public:
+  explicit HLoopBoundsCheckElimination(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kLoopBoundsCheckEliminationPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    // The taken tests only add blocks before the loops, the loops and their IVs are intact.
+    return kAnalysisNone;
+  }
+
+ private:
+  /**
+   * @brief The values taken by the IV of a counted loop.
+   * @details In the blocks it covers, the phi goes from start up to bound, or to
+   * bound - 1 if the test is not inclusive, by increment.
+   */
+  struct LoopRange {
+    HPhi* phi;
+    HInstruction* linear;
+    int64_t increment;
+    HInstruction* start;
+    HInstruction* bound;
+    bool is_inclusive;
+    // If the phi is tested, only the blocks dominated by the loop side of the test
+    // are covered. When the update of the phi is tested, the whole loop is.
+    HBasicBlock* tested_body;
+  };
+
+  /**
+   * @brief The bounds checks of an array in the loop.
+   */
+  struct ArrayChecks {
+    HInstruction* array;
+    // The length if it is computed before the loop, nullptr otherwise.
+    HInstruction* length;
+    int64_t min_offset;
+    int64_t max_offset;
+    ArenaVector<HBoundsCheck*> checks;
+  };
+
+  /**
+   * @brief Fill range with the values taken by the IV of loop, if it is counted.
+   */
+  bool GetRange(HLoopInformation_X86* loop, LoopRange* range);
+
+  /**
+   * @brief Get the constant offset of index from the phi of range.
+   */
+  static bool GetOffset(HInstruction* index, const LoopRange& range, int64_t* offset);
+
+  /**
+   * @brief Branch around a new block before loop when its first test fails.
+   * @return Returns the block only reached when the loop is entered, the pre-header if
+   * the test is known to pass.
+   */
+  HBasicBlock* AddTakenTest(HLoopInformation_X86* loop, const LoopRange& range);
+
+  /**
+   * @brief Add a deoptimization on condition at the end of block, before loop.
+   * @param state The instruction holding the environment at the start of the loop.
+   */
+  void AddDeoptimization(HLoopInformation_X86* loop,
+                         HBasicBlock* block,
+                         HInstruction* condition,
+                         DeoptimizationKind kind,
+                         HInstruction* state);
+
+  /**
+   * @brief Replace the bounds checks of the loop that the range proves.
+   * @return Returns true if any bounds check was removed.
+   */
+  bool RemoveBoundsChecks(HLoopInformation_X86* loop);
+
+  static constexpr const char* kLoopBoundsCheckEliminationPassName =
+      "loop_bounds_check_elimination";
+  // Keep the constants of the range checks far from overflowing.
+  static constexpr int64_t kMaxOffset = 1024;
+  // The number of additions followed from an index to the IV.
+  static constexpr size_t kMaxOffsetDepth = 8;
+
+  DISALLOW_COPY_AND_ASSIGN(HLoopBoundsCheckElimination);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_BOUNDS_CHECK_ELIMINATION_H_
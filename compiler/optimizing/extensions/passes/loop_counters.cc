@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loop_counters.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ext_utility.h"
+#include "graph_x86.h"
+#include "jit/jit.h"
+#include "jit/jit_loop_counters.h"
+#include "runtime.h"
+
+namespace art {
+
+void HLoopCounters::Run() {
+  Runtime* runtime = Runtime::Current();
+  if (runtime == nullptr || runtime->IsAotCompiler()) {
+    return;
+  }
+  jit::Jit* jit = runtime->GetJit();
+  jit::JitLoopCounters* loop_counters = (jit != nullptr) ? jit->GetLoopCounters() : nullptr;
+  if (loop_counters == nullptr) {
+    return;
+  }
+
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  if (graph->GetCountedLoops().empty()) {
+    return;
+  }
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Begin: " << GetMethodName(graph));
+
+  // Group the records of each loop, a loop may be transformed by several passes.
+  struct Loop {
+    HLoopInformation* info;
+    std::string passes;
+  };
+  std::vector<Loop> loops;
+  for (const HGraph_X86::CountedLoop& counted : graph->GetCountedLoops()) {
+    HBasicBlock* header = counted.header;
+    if (graph->GetBlocks()[header->GetBlockId()] != header || !header->IsLoopHeader()) {
+      // The loop was removed, or fully unrolled, since.
+      continue;
+    }
+    HLoopInformation* info = header->GetLoopInformation();
+    if (info->IsIrreducible()) {
+      continue;
+    }
+    auto it = std::find_if(loops.begin(), loops.end(),
+                           [info](const Loop& loop) { return loop.info == info; });
+    if (it == loops.end()) {
+      loops.push_back({info, counted.pass_name});
+    } else if (it->passes.find(counted.pass_name) == std::string::npos) {
+      it->passes += ",";
+      it->passes += counted.pass_name;
+    }
+  }
+
+  const std::string method_name = GetMethodName(graph);
+  ArenaAllocator* arena = graph->GetArena();
+  for (const Loop& loop : loops) {
+    HBasicBlock* header = loop.info->GetHeader();
+    jit::JitLoopCounters::Counters* counters =
+        loop_counters->GetCounters(method_name, header->GetDexPc(), loop.passes);
+
+    // The pre-header runs once per entry of the loop.
+    HBasicBlock* pre_header = loop.info->GetPreHeader();
+    pre_header->InsertInstructionBefore(
+        new (arena) HX86IncrementCounter(&counters->entries, header->GetDexPc()),
+        pre_header->GetLastInstruction());
+
+    // The header runs once per iteration, and its suspend check must stay first.
+    HX86IncrementCounter* iteration =
+        new (arena) HX86IncrementCounter(&counters->iterations, header->GetDexPc());
+    HInstruction* first = header->GetFirstInstruction();
+    if (first == loop.info->GetSuspendCheck()) {
+      header->InsertInstructionAfter(iteration, first);
+    } else {
+      header->InsertInstructionBefore(iteration, first);
+    }
+
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Count loop " << header->GetBlockId()
+                                     << " transformed by " << loop.passes);
+    MaybeRecordStat(MethodCompilationStat::kIntelLoopCounted);
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "End: " << GetMethodName(graph));
+}
+
+}  // namespace art
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_COUNTERS_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_COUNTERS_H_
+
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+/**
+ * @brief With -Xjitcountloops, count the entries and iterations of the loops transformed
+ * by the loop passes, for the JIT to dump them on SIGQUIT.
+ * @details The passes record the headers of the loops they transform in HGraph_X86. Each
+ * loop still in the graph gets an HX86IncrementCounter in its pre-header and one in its
+ * header, on counters of the JitLoopCounters table keyed by method, dex pc of the header
+ * and transforming passes. The pass runs last, as the increments are unused instructions
+ * for the other passes, and only in the JIT, whose code may embed the process addresses.
+ */
+class HLoopCounters : public HOptimization_X86 {
+ public:
+  explicit HLoopCounters(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kLoopCountersPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    // The increments go to the existing pre-headers and headers, they neither branch nor
+    // define a value, and the counters they write are not read by the loops.
+    return kAnalysisNone;
+  }
+
+ private:
+  static constexpr const char* kLoopCountersPassName = "loop_counters";
+
+  DISALLOW_COPY_AND_ASSIGN(HLoopCounters);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_COUNTERS_H_
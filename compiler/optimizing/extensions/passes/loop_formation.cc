@@ -45,7 +45,38 @@ class HCompareLoops {
   }
 };
 
+bool HLoopFormation::IsHierarchyUpToDate() const {
+  HGraph_X86* graph_x86 = GRAPH_TO_GRAPH_X86(graph_);
+  std::set<HLoopInformation_X86*> in_hierarchy;
+
+  for (HOutToInLoopIterator it(graph_x86->GetLoopInformation()); !it.Done(); it.Advance()) {
+    in_hierarchy.insert(it.Current());
+  }
+
+  // Every loop of the graph must be part of the hierarchy, and nothing else.
+  size_t num_loops = 0;
+  for (HBasicBlock* block : graph_->GetBlocks()) {
+    if (block != nullptr && block->IsLoopHeader()) {
+      num_loops++;
+      HLoopInformation_X86* info = LOOPINFO_TO_LOOPINFO_X86(block->GetLoopInformation());
+      if (in_hierarchy.find(info) == in_hierarchy.end()) {
+        return false;
+      }
+    }
+  }
+
+  return num_loops == in_hierarchy.size();
+}
+
 void HLoopFormation::Run() {
+  HGraph_X86* graph_x86 = GRAPH_TO_GRAPH_X86(graph_);
+
+  // Nothing touched the loops since they were last formed: only validate the cache.
+  if (graph_x86->AreAnalysesValid(kAnalysisLoopHierarchy)) {
+    DCHECK(IsHierarchyUpToDate()) << "Stale loop hierarchy before " << GetPassName();
+    return;
+  }
+
   /**
    * The algorithm of this method is to actually create all the LoopInformation for the loops of the method.
    *  Put the loops in a priority queue that will have everything sorted in an inverse way:
@@ -57,7 +88,7 @@ void HLoopFormation::Run() {
   std::set<HLoopInformation_X86*> info_set;
 
   // Post order visit to visit inner loops before outer loops.
-  GRAPH_TO_GRAPH_X86(graph_)->ClearLoopInformation();
+  graph_x86->ClearLoopInformation();
   for (HPostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
     HBasicBlock* block = it.Current();
     if (block->IsLoopHeader()) {
@@ -72,7 +103,6 @@ void HLoopFormation::Run() {
   }
 
   // Now clear data structures to make way for initialization.
-  HGraph_X86* graph_x86 = GRAPH_TO_GRAPH_X86(graph_);
   graph_x86->ClearLoopInformation();
   for (auto loop : info_set) {
     loop->ResetRelationships();
@@ -90,6 +120,8 @@ void HLoopFormation::Run() {
   if (outer != nullptr) {
     outer->SetDepth(0);
   }
+
+  graph_x86->MarkAnalysesValid(kAnalysisLoopHierarchy);
 }
 
 }  // namespace art
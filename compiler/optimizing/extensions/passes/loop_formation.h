@@ -38,6 +38,17 @@ class HLoopFormation : public HOptimization_X86 {
   static constexpr const char* kLoopFormationPassName = "loop_formation";
 
   void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    return kAnalysisNone;
+  }
+
+ private:
+  /**
+   * @brief Does the cached loop hierarchy match the loops of the graph?
+   * @return true if every loop of the graph is in the hierarchy, and only those.
+   */
+  bool IsHierarchyUpToDate() const;
 };
 
 }  // namespace art
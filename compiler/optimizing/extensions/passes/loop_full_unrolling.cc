@@ -46,6 +46,7 @@ void HLoopFullUnrolling::Run() {
     }
 
     MaybeRecordStat(MethodCompilationStat::kIntelLoopFullyUnrolled);
+    MaybeRecordLoopInliningBenefit(loop);
     PRINT_PASS_OSTREAM_MESSAGE(this, "Loop #" << loop_header->GetBlockId()
       << " of method " << GetMethodName(graph)
       << " has been successfully fully unrolled by factor "
@@ -62,7 +63,7 @@ void HLoopFullUnrolling::Run() {
 bool HLoopFullUnrolling::Gate(HLoopUnrolling* loop_unrolling) const {
   DCHECK(loop_unrolling != nullptr);
 
-  if (!loop_unrolling->Gate(kDefaultMaxInstructionsUnrolled)) {
+  if (!loop_unrolling->Gate(cost_model_.GetMaxFullyUnrolledInstructions())) {
     return false;
   }
 
@@ -0,0 +1,425 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loop_fusion.h"
+
+#include "ext_utility.h"
+#include "find_ivs.h"
+#include "graph_x86.h"
+#include "induction_variable.h"
+#include "loop_formation.h"
+#include "loop_iterators.h"
+
+namespace art {
+
+static bool IsSameValue(HInstruction* x, HInstruction* y) {
+  if (x == y) {
+    return true;
+  }
+  if (x->IsIntConstant() && y->IsIntConstant()) {
+    return x->AsIntConstant()->GetValue() == y->AsIntConstant()->GetValue();
+  }
+  if (x->IsLongConstant() && y->IsLongConstant()) {
+    return x->AsLongConstant()->GetValue() == y->AsLongConstant()->GetValue();
+  }
+  return false;
+}
+
+static bool IsMemoryAccess(HInstruction* insn) {
+  switch (insn->GetKind()) {
+    case HInstruction::kArrayGet:
+    case HInstruction::kArraySet:
+    case HInstruction::kInstanceFieldGet:
+    case HInstruction::kInstanceFieldSet:
+    case HInstruction::kStaticFieldGet:
+    case HInstruction::kStaticFieldSet:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool HasInputIn(HInstruction* insn, HLoopInformation* loop) {
+  for (size_t i = 0, e = insn->InputCount(); i < e; ++i) {
+    if (loop->Contains(*insn->InputAt(i)->GetBlock())) {
+      return true;
+    }
+  }
+  for (HEnvironment* env = insn->GetEnvironment(); env != nullptr; env = env->GetParent()) {
+    for (size_t i = 0, e = env->Size(); i < e; ++i) {
+      HInstruction* input = env->GetInstructionAt(i);
+      if (input != nullptr && loop->Contains(*input->GetBlock())) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool HLoopFusion::GetShape(HLoopInformation_X86* loop, LoopShape* shape) {
+  if (!loop->IsInner() ||
+      loop->IsOrHasIrreducibleLoop() ||
+      loop->HasTryCatchHandler() ||
+      loop->NumberOfBlocks() != 2 ||
+      loop->GetBackEdges().size() != 1u) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop " << loop->GetHeader()->GetBlockId()
+                                     << " is not a two-block inner loop");
+    return false;
+  }
+
+  shape->pre_header = loop->GetPreHeader();
+  shape->header = loop->GetHeader();
+  shape->body = loop->GetBackEdges()[0];
+  shape->exit = loop->GetExitBlock();
+  if (shape->pre_header == nullptr ||
+      shape->exit == nullptr ||
+      shape->exit->GetPredecessors().size() != 1u ||
+      shape->body->GetPredecessors().size() != 1u ||
+      shape->body->GetSinglePredecessor() != shape->header) {
+    PRINT_PASS_MESSAGE(this, "Loop is not top tested");
+    return false;
+  }
+
+  // The header only holds the loop control.
+  HInstruction* last = shape->header->GetLastInstruction();
+  if (!last->IsIf() || !last->InputAt(0)->IsCondition()) {
+    PRINT_PASS_MESSAGE(this, "Loop header does not end with a condition");
+    return false;
+  }
+  shape->branch = last->AsIf();
+  shape->condition = last->InputAt(0)->AsCondition();
+  if (!shape->condition->HasOnlyOneNonEnvironmentUse() ||
+      shape->condition->HasEnvironmentUses()) {
+    PRINT_PASS_MESSAGE(this, "Loop condition is used elsewhere");
+    return false;
+  }
+  for (HInstructionIterator it(shape->header->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* insn = it.Current();
+    if (insn != shape->branch && insn != shape->condition && !insn->IsSuspendCheck()) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Loop header contains " << insn->DebugName());
+      return false;
+    }
+  }
+
+  HInductionVariable* iv = loop->GetBoundInformation().loop_biv_;
+  if (iv == nullptr || !iv->IsBasic() || iv->IsFP()) {
+    PRINT_PASS_MESSAGE(this, "Loop has no integer basic IV");
+    return false;
+  }
+  shape->phi = iv->GetPhiInsn();
+  shape->linear = iv->GetLinearInsn();
+  if (shape->phi->GetBlock() != shape->header ||
+      shape->linear->GetBlock() != shape->body ||
+      loop->PhiInput(shape->phi, true) != shape->linear ||
+      (shape->condition->InputAt(0) != shape->phi && shape->condition->InputAt(1) != shape->phi)) {
+    PRINT_PASS_MESSAGE(this, "Loop IV is not tested in the header");
+    return false;
+  }
+
+  // Fusion moves the bodies relative to each other: they must not leave the loop early.
+  for (HBlocksInLoopIterator it_loop(*loop); !it_loop.Done(); it_loop.Advance()) {
+    for (HInstructionIterator it(it_loop.Current()->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* insn = it.Current();
+      if (insn->IsSuspendCheck()) {
+        continue;
+      }
+      if (insn->CanThrow() || insn->HasEnvironment()) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Loop contains " << insn->DebugName()
+                                         << " which may exit the loop");
+        return false;
+      }
+      if ((insn->GetSideEffects().DoesAnyWrite() || insn->GetSideEffects().DoesAnyRead()) &&
+          !IsMemoryAccess(insn)) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Loop contains " << insn->DebugName()
+                                         << " with unknown side effects");
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool HLoopFusion::HaveSameIterations(const LoopShape& first, const LoopShape& second) {
+  HLoopInformation_X86* first_loop = LOOPINFO_TO_LOOPINFO_X86(first.header->GetLoopInformation());
+  HLoopInformation_X86* second_loop =
+      LOOPINFO_TO_LOOPINFO_X86(second.header->GetLoopInformation());
+  HInductionVariable* first_iv = first_loop->GetBoundInformation().loop_biv_;
+  HInductionVariable* second_iv = second_loop->GetBoundInformation().loop_biv_;
+
+  if (first.phi->GetType() != second.phi->GetType() ||
+      first_iv->GetIncrement() != second_iv->GetIncrement() ||
+      !IsSameValue(first_loop->PhiInput(first.phi, false),
+                   second_loop->PhiInput(second.phi, false))) {
+    return false;
+  }
+
+  // Both conditions must compare the IV the same way to the same bound.
+  if (first.condition->GetKind() != second.condition->GetKind()) {
+    return false;
+  }
+  size_t first_iv_index = (first.condition->InputAt(0) == first.phi) ? 0u : 1u;
+  size_t second_iv_index = (second.condition->InputAt(0) == second.phi) ? 0u : 1u;
+  if (first_iv_index != second_iv_index ||
+      !IsSameValue(first.condition->InputAt(1u - first_iv_index),
+                   second.condition->InputAt(1u - second_iv_index))) {
+    return false;
+  }
+
+  // And stay in the loop on the same outcome.
+  bool first_stays_on_true = first.branch->IfTrueSuccessor() == first.body;
+  bool second_stays_on_true = second.branch->IfTrueSuccessor() == second.body;
+  return first_stays_on_true == second_stays_on_true;
+}
+
+bool HLoopFusion::IsSameElement(HInstruction* first_access,
+                                const LoopShape& first,
+                                HInstruction* second_access,
+                                const LoopShape& second) {
+  if (!(first_access->IsArrayGet() || first_access->IsArraySet()) ||
+      !(second_access->IsArrayGet() || second_access->IsArraySet())) {
+    return false;
+  }
+
+  HInstruction* first_base = first_access->InputAt(0);
+  HInstruction* second_base = second_access->InputAt(0);
+  first_base = first_base->IsNullCheck() ? first_base->InputAt(0) : first_base;
+  second_base = second_base->IsNullCheck() ? second_base->InputAt(0) : second_base;
+  if (first_base != second_base) {
+    return false;
+  }
+
+  // The index must be the IV, plus the same constant in both loops.
+  HInstruction* first_index = first_access->InputAt(1);
+  HInstruction* second_index = second_access->InputAt(1);
+  if (first_index == first.phi) {
+    return second_index == second.phi;
+  }
+  if (first_index->IsAdd() && second_index->IsAdd()) {
+    HBinaryOperation* first_add = first_index->AsAdd();
+    HBinaryOperation* second_add = second_index->AsAdd();
+    return first_add->GetLeastConstantLeft() == first.phi &&
+           second_add->GetLeastConstantLeft() == second.phi &&
+           first_add->GetConstantRight() != nullptr &&
+           second_add->GetConstantRight() != nullptr &&
+           IsSameValue(first_add->GetConstantRight(), second_add->GetConstantRight());
+  }
+  return false;
+}
+
+bool HLoopFusion::CheckDependencies(const LoopShape& first, const LoopShape& second) {
+  HLoopInformation* first_loop = first.header->GetLoopInformation();
+  HLoopInformation* second_loop = second.header->GetLoopInformation();
+
+  // The instructions between the loops are moved before the first one.
+  for (HInstructionIterator it(second.pre_header->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* insn = it.Current();
+    if (insn == second.pre_header->GetLastInstruction()) {
+      DCHECK(insn->IsGoto());
+      continue;
+    }
+    if (insn->CanThrow() ||
+        insn->HasEnvironment() ||
+        insn->HasSideEffects() ||
+        insn->GetSideEffects().DoesAnyRead() ||
+        HasInputIn(insn, first_loop)) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Cannot hoist " << insn->DebugName()
+                                       << " from between the loops");
+      return false;
+    }
+  }
+
+  // The second loop must not use what the first one computes.
+  ArenaVector<HInstruction*> first_accesses(graph_->GetArena()->Adapter(kArenaAllocMisc));
+  ArenaVector<HInstruction*> second_accesses(graph_->GetArena()->Adapter(kArenaAllocMisc));
+  for (HBlocksInLoopIterator it_loop(*first_loop); !it_loop.Done(); it_loop.Advance()) {
+    for (HInstructionIterator it(it_loop.Current()->GetInstructions()); !it.Done(); it.Advance()) {
+      if (IsMemoryAccess(it.Current())) {
+        first_accesses.push_back(it.Current());
+      }
+    }
+  }
+  for (HBlocksInLoopIterator it_loop(*second_loop); !it_loop.Done(); it_loop.Advance()) {
+    HBasicBlock* block = it_loop.Current();
+    for (HInstructionIterator it(block->GetPhis()); !it.Done(); it.Advance()) {
+      if (HasInputIn(it.Current(), first_loop)) {
+        PRINT_PASS_MESSAGE(this, "Second loop starts from a value of the first loop");
+        return false;
+      }
+    }
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* insn = it.Current();
+      if (HasInputIn(insn, first_loop)) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, insn->DebugName() << " uses a value of the first loop");
+        return false;
+      }
+      if (IsMemoryAccess(insn)) {
+        second_accesses.push_back(insn);
+      }
+    }
+  }
+
+  // Once fused, iteration i of the second body runs before iterations i + 1... of the first.
+  for (HInstruction* first_access : first_accesses) {
+    for (HInstruction* second_access : second_accesses) {
+      if (!first_access->GetSideEffects().DoesAnyWrite() &&
+          !second_access->GetSideEffects().DoesAnyWrite()) {
+        continue;
+      }
+      if (alias_.Alias(first_access, second_access) == AliasCheck::kNoAlias) {
+        continue;
+      }
+      if (!IsSameElement(first_access, first, second_access, second)) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, first_access->DebugName() << " " << first_access->GetId()
+                                         << " and " << second_access->DebugName() << " "
+                                         << second_access->GetId() << " may depend on each other");
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void HLoopFusion::Fuse(const LoopShape& first, const LoopShape& second) {
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+
+  // Hoist what is between the loops.
+  HInstruction* cursor = first.pre_header->GetLastInstruction();
+  for (HInstruction* insn = second.pre_header->GetFirstInstruction();
+       insn != second.pre_header->GetLastInstruction();) {
+    HInstruction* next = insn->GetNext();
+    insn->MoveBefore(cursor);
+    insn = next;
+  }
+
+  // Drop the control of the second loop: it iterates like the first one.
+  HBasicBlock* header = second.header;
+  header->RemoveInstruction(second.branch);
+  header->RemoveInstruction(second.condition);
+  for (HInstruction* insn = header->GetFirstInstruction(); insn != nullptr;) {
+    HInstruction* next = insn->GetNext();
+    DCHECK(insn->IsSuspendCheck());
+    header->RemoveInstruction(insn);
+    insn = next;
+  }
+  header->AddInstruction(new (graph->GetArena()) HGoto(second.branch->GetDexPc()));
+
+  second.phi->ReplaceWith(first.phi);
+  header->RemovePhi(second.phi);
+  second.linear->ReplaceWith(first.linear);
+  second.body->RemoveInstruction(second.linear);
+
+  // Predecessor orders match, so the phis keep their inputs.
+  for (HInstruction* phi = header->GetFirstPhi(); phi != nullptr;) {
+    HInstruction* next = phi->GetNext();
+    graph->MovePhi(phi->AsPhi(), first.header);
+    phi = next;
+  }
+
+  cursor = first.body->GetLastInstruction();
+  for (HInstruction* insn = second.body->GetFirstInstruction();
+       insn != second.body->GetLastInstruction();) {
+    HInstruction* next = insn->GetNext();
+    insn->MoveBefore(cursor, /* do_checks */ false);
+    insn = next;
+  }
+
+  // The second header now falls through to the exit, and its body is dead.
+  header->RemoveSuccessor(second.body);
+  second.body->RemovePredecessor(header);
+  second.body->RemoveSuccessor(header);
+  header->RemovePredecessor(second.body);
+}
+
+bool HLoopFusion::FuseOnePair() {
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+
+  for (HOnlyInnerLoopIterator it(graph->GetLoopInformation()); !it.Done(); it.Advance()) {
+    HLoopInformation_X86* first_loop = it.Current();
+    LoopShape first;
+    if (!GetShape(first_loop, &first)) {
+      continue;
+    }
+
+    // The exit of the first loop must be the pre-header of the second one.
+    HBasicBlock* next = first.exit->GetSingleSuccessor();
+    if (next == nullptr || !next->IsLoopHeader()) {
+      continue;
+    }
+    HLoopInformation_X86* second_loop = LOOPINFO_TO_LOOPINFO_X86(next->GetLoopInformation());
+    if (second_loop->GetParent() != first_loop->GetParent() ||
+        second_loop->GetPreHeader() != first.exit) {
+      continue;
+    }
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Try to fuse loops " << first.header->GetBlockId()
+                                     << " and " << next->GetBlockId());
+
+    LoopShape second;
+    if (!GetShape(second_loop, &second)) {
+      continue;
+    }
+    if (!HaveSameIterations(first, second)) {
+      PRINT_PASS_MESSAGE(this, "Loops do not iterate the same way");
+      continue;
+    }
+    if (first_loop->CountInstructionsInBody(true) +
+        second_loop->CountInstructionsInBody(true) > kMaxFusedInstructions) {
+      PRINT_PASS_MESSAGE(this, "Fused loop would be too big");
+      continue;
+    }
+    if (!CheckDependencies(first, second)) {
+      continue;
+    }
+
+    Fuse(first, second);
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Fused loops " << first.header->GetBlockId()
+                                     << " and " << second.header->GetBlockId()
+                                     << " of " << GetMethodName(graph_));
+    MaybeRecordStat(MethodCompilationStat::kIntelLoopFused);
+
+    // Rebuild the loops, as the dead code elimination does.
+    graph->HGraph::ClearLoopInformation();
+    graph->ClearDominanceInformation();
+    GraphAnalysisResult result = graph->BuildDominatorTree();
+    DCHECK_EQ(result, kAnalysisSuccess);
+    UNUSED(result);
+    graph->ClearLoopInformation();
+    return true;
+  }
+
+  return false;
+}
+
+void HLoopFusion::Run() {
+  PRINT_PASS_MESSAGE(this, "start");
+
+  // Each fusion changes the loops, so they are formed again before looking for the next.
+  HLoopFormation formation(graph_);
+  formation.Run();
+  HFindInductionVariables find_ivs(graph_, "find_ivs_for_fusion", stats_);
+  find_ivs.Run();
+  while (FuseOnePair()) {
+    HLoopFormation form_loops(graph_);
+    form_loops.Run();
+    HFindInductionVariables find_ivs_after_fusion(graph_, "find_ivs_after_fusion", stats_);
+    find_ivs_after_fusion.Run();
+  }
+
+  PRINT_PASS_MESSAGE(this, "end");
+}
+
+}  // namespace art
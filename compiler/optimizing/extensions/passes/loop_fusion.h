@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_FUSION_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_FUSION_H_
+
+#include "ext_alias.h"
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+// Forward declaration.
+class HLoopInformation_X86;
+
+/**
+ * @brief Loop fusion merges a loop into the sibling loop executed right before it,
+ * when both iterate the same way.
+ * @details Code walking the same arrays several times in sequence then reads each
+ * element once, and pays the loop control once. The loops must be top tested, made of
+ * a header and a single body block, and be separated by nothing but a pre-header
+ * of hoistable instructions. Their bodies must not throw, and each memory access of
+ * the second loop must either not alias those of the first loop, or touch the same
+ * element in the same iteration.
+ */
+class HLoopFusion : public HOptimization_X86 {
+ public:
+  explicit HLoopFusion(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kLoopFusionPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    // Each fusion clears the cached loops. The pass forms them again, with their IVs,
+    // before looking for the next pair, and after the last one.
+    return kAnalysisNone;
+  }
+
+ private:
+  /**
+   * @brief The parts of a loop that fusion deals with.
+   */
+  struct LoopShape {
+    HBasicBlock* pre_header;
+    HBasicBlock* header;
+    HBasicBlock* body;
+    HBasicBlock* exit;
+    HPhi* phi;
+    HInstruction* linear;
+    HCondition* condition;
+    HIf* branch;
+  };
+
+  /**
+   * @brief Fill shape if loop has the form supported by the fusion.
+   * @return Returns true if the loop can be fused.
+   */
+  bool GetShape(HLoopInformation_X86* loop, LoopShape* shape);
+
+  /**
+   * @brief Do both loops go through the same iterations?
+   */
+  bool HaveSameIterations(const LoopShape& first, const LoopShape& second);
+
+  /**
+   * @brief Check that executing both bodies in each iteration does not change the semantics.
+   * @return Returns true if fusion is legal.
+   */
+  bool CheckDependencies(const LoopShape& first, const LoopShape& second);
+
+  /**
+   * @brief Do the array accesses touch the same element in the same iteration?
+   */
+  static bool IsSameElement(HInstruction* first_access,
+                            const LoopShape& first,
+                            HInstruction* second_access,
+                            const LoopShape& second);
+
+  /**
+   * @brief Merge second into first. The shapes must have been checked.
+   */
+  void Fuse(const LoopShape& first, const LoopShape& second);
+
+  /**
+   * @brief Find two adjacent loops and fuse them.
+   * @return Returns true if two loops were fused.
+   */
+  bool FuseOnePair();
+
+  AliasCheck alias_;
+
+  static constexpr const char* kLoopFusionPassName = "loop_fusion";
+  // Keep the fused body within the register file and the loop stream detector.
+  static constexpr uint64_t kMaxFusedInstructions = 120;
+
+  DISALLOW_COPY_AND_ASSIGN(HLoopFusion);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_FUSION_H_
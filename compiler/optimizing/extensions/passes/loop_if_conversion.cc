@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "loop_if_conversion.h"
+
+#include "ext_utility.h"
+
+namespace art {
+
+// Can instruction be executed on the path of the other branch as well?
+static bool IsSpeculatable(HInstruction* instruction) {
+  // The loads are not speculated, the branch may be what keeps them in bounds.
+  return instruction->CanBeMoved() &&
+         !instruction->HasSideEffects() &&
+         !instruction->GetSideEffects().DoesAnyRead() &&
+         !instruction->CanThrow() &&
+         !instruction->HasEnvironment();
+}
+
+// Is block a branch of a diamond whose instructions can all be speculated? If so, cost is
+// set to their number.
+static bool GetSpeculationCost(HBasicBlock* block, /*out*/ size_t* cost) {
+  if (block->GetPredecessors().size() != 1u) {
+    return false;
+  }
+  DCHECK(block->GetPhis().IsEmpty());
+
+  size_t num_instructions = 0u;
+  for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* instruction = it.Current();
+    if (instruction->IsControlFlow()) {
+      *cost = num_instructions;
+      return instruction->IsGoto();
+    } else if (!IsSpeculatable(instruction)) {
+      return false;
+    }
+    num_instructions++;
+  }
+
+  LOG(FATAL) << "Unreachable";
+  UNREACHABLE();
+}
+
+// Does the value of instruction depend on the memory read in the loop, or on a loop phi that
+// is not a basic induction variable, such as a running maximum? The branches on such values
+// are the ones the predictor misses.
+static bool IsDataDependent(HInstruction* instruction, HLoopInformation* loop, size_t depth) {
+  if (!loop->Contains(*instruction->GetBlock())) {
+    // Loop invariant.
+    return false;
+  }
+
+  if (instruction->GetSideEffects().DoesAnyRead() || instruction->IsInvoke()) {
+    return true;
+  }
+
+  if (instruction->IsPhi() && instruction->GetBlock() == loop->GetHeader()) {
+    if (instruction->InputCount() != 2u) {
+      return true;
+    }
+    HInstruction* update = instruction->InputAt(1);
+    bool is_basic_iv = (update->IsAdd() || update->IsSub()) &&
+                       update->InputAt(0) == instruction &&
+                       !loop->Contains(*update->InputAt(1)->GetBlock());
+    return !is_basic_iv;
+  }
+
+  if (depth == 0u) {
+    return false;
+  }
+  for (HInstruction* input : instruction->GetInputs()) {
+    if (IsDataDependent(input, loop, depth - 1u)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HLoopIfConversion::TryConvert(HBasicBlock* block) {
+  HLoopInformation* loop = block->GetLoopInformation();
+  HIf* if_instruction = block->GetLastInstruction()->AsIf();
+  HBasicBlock* true_block = if_instruction->IfTrueSuccessor();
+  HBasicBlock* false_block = if_instruction->IfFalseSuccessor();
+  DCHECK_NE(true_block, false_block);
+
+  // Find the diamond, merging back in the loop body.
+  size_t true_cost = 0u;
+  size_t false_cost = 0u;
+  if (!GetSpeculationCost(true_block, &true_cost) ||
+      !GetSpeculationCost(false_block, &false_cost) ||
+      true_block->GetSingleSuccessor() != false_block->GetSingleSuccessor()) {
+    return false;
+  }
+  HBasicBlock* merge_block = true_block->GetSingleSuccessor();
+  if (merge_block->IsLoopHeader() || merge_block->GetLoopInformation() != loop) {
+    return false;
+  }
+
+  // One select per phi merging different values.
+  size_t predecessor_index_true = merge_block->GetPredecessorIndexOf(true_block);
+  size_t predecessor_index_false = merge_block->GetPredecessorIndexOf(false_block);
+  DCHECK_NE(predecessor_index_true, predecessor_index_false);
+  size_t num_selects = 0u;
+  for (HInstructionIterator it(merge_block->GetPhis()); !it.Done(); it.Advance()) {
+    HPhi* phi = it.Current()->AsPhi();
+    if (phi->InputAt(predecessor_index_true) != phi->InputAt(predecessor_index_false)) {
+      if (Primitive::IsFloatingPointType(phi->GetType())) {
+        // The floating-point selects are compiled to branches.
+        return false;
+      }
+      num_selects++;
+    }
+  }
+  if (num_selects == 0u) {
+    return false;
+  }
+
+  // Without profile, a branch on the data is assumed to mispredict at the rate of a random one.
+  // The speculated instructions and the selects are assumed to cost a cycle each.
+  size_t cost = true_cost + false_cost + num_selects;
+  if (!IsDataDependent(if_instruction->InputAt(0), loop, kMaxDataDependenceDepth)) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Branch of block " << block->GetBlockId()
+                                     << " is predictable");
+    return false;
+  }
+  if (cost * 100u >= kMispredictionPenalty * kDataDependentMispredictionRate) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Branch of block " << block->GetBlockId()
+                                     << " costs " << cost << " to speculate");
+    return false;
+  }
+
+  // Move the instructions of both branches in front of the If.
+  while (!true_block->IsSingleGoto()) {
+    true_block->GetFirstInstruction()->MoveBefore(if_instruction);
+  }
+  while (!false_block->IsSingleGoto()) {
+    false_block->GetFirstInstruction()->MoveBefore(if_instruction);
+  }
+
+  // Select the values of the true branch, the false ones go on flowing through the phis.
+  HInstruction* condition = if_instruction->InputAt(0);
+  for (HInstructionIterator it(merge_block->GetPhis()); !it.Done(); it.Advance()) {
+    HPhi* phi = it.Current()->AsPhi();
+    HInstruction* true_value = phi->InputAt(predecessor_index_true);
+    HInstruction* false_value = phi->InputAt(predecessor_index_false);
+    if (true_value == false_value) {
+      continue;
+    }
+    HSelect* select = new (graph_->GetArena()) HSelect(condition,
+                                                       true_value,
+                                                       false_value,
+                                                       if_instruction->GetDexPc());
+    if (phi->GetType() == Primitive::kPrimNot) {
+      select->SetReferenceTypeInfo(phi->GetReferenceTypeInfo());
+    }
+    block->InsertInstructionBefore(select, if_instruction);
+    phi->ReplaceInput(select, predecessor_index_false);
+  }
+
+  // Remove the true branch, which removes the phis left with a single input.
+  bool only_two_predecessors = (merge_block->GetPredecessors().size() == 2u);
+  true_block->DisconnectAndDelete();
+
+  // Merge the remaining blocks, now connected with Gotos.
+  DCHECK_EQ(block->GetSingleSuccessor(), false_block);
+  block->MergeWith(false_block);
+  if (only_two_predecessors) {
+    DCHECK_EQ(block->GetSingleSuccessor(), merge_block);
+    block->MergeWith(merge_block);
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Converted the branch of block " << block->GetBlockId()
+                                   << " to " << num_selects << " selects");
+  MaybeRecordStat(MethodCompilationStat::kIntelLoopIfConverted);
+  return true;
+}
+
+void HLoopIfConversion::Run() {
+  if (instruction_set_ != kX86 && instruction_set_ != kX86_64) {
+    return;
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Begin: " << GetMethodName(graph_));
+
+  // In post order, the inner diamonds are converted first, which may make the outer ones
+  // simple enough. The blocks merged are successors of the converted one, already visited.
+  ArenaVector<HBasicBlock*> blocks(graph_->GetPostOrder().begin(),
+                                   graph_->GetPostOrder().end(),
+                                   graph_->GetArena()->Adapter(kArenaAllocOptimization));
+  for (HBasicBlock* block : blocks) {
+    if (block->GetGraph() == nullptr ||
+        !block->EndsWithIf() ||
+        !block->IsInLoop() ||
+        block->GetLoopInformation()->IsIrreducible()) {
+      continue;
+    }
+    TryConvert(block);
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "End: " << GetMethodName(graph_));
+}
+
+}  // namespace art
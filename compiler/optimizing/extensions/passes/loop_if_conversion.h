@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_IF_CONVERSION_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_IF_CONVERSION_H_
+
+#include "arch/instruction_set.h"
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+/**
+ * @brief Replace the small diamonds of loop bodies whose condition depends on the data, such
+ * as the min, max and clamping patterns on arrays, by selects.
+ * @details The select generator only converts the diamonds of one instruction per branch
+ * and a single phi. In a loop, a branch on loaded values mispredicts about every other
+ * iteration, which costs more than computing both branches and selecting the result with
+ * cmov. The diamond is converted when the instructions of both branches and the selects cost
+ * less than the expected misprediction penalty. Besides, a loop body without branches can be
+ * vectorized by the loop optimization, which turns the min and max selects into vector
+ * min and max.
+ */
+class HLoopIfConversion : public HOptimization_X86 {
+ public:
+  HLoopIfConversion(HGraph* graph,
+                    InstructionSet instruction_set,
+                    OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kLoopIfConversionPassName, stats),
+      instruction_set_(instruction_set) {}
+
+  void Run() OVERRIDE;
+
+ private:
+  /**
+   * @brief Is the diamond ending block worth converting to selects?
+   * @return true if block was merged with its branches.
+   */
+  bool TryConvert(HBasicBlock* block);
+
+  static constexpr const char* kLoopIfConversionPassName = "loop_if_conversion";
+
+  // The cost of a misprediction on the big x86 cores, in cycles.
+  static constexpr size_t kMispredictionPenalty = 16u;
+
+  // The percentage of mispredictions of a branch on values loaded from memory.
+  static constexpr size_t kDataDependentMispredictionRate = 50u;
+
+  // How far the inputs of a condition are searched for loaded values.
+  static constexpr size_t kMaxDataDependenceDepth = 3u;
+
+  const InstructionSet instruction_set_;
+
+  DISALLOW_COPY_AND_ASSIGN(HLoopIfConversion);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_IF_CONVERSION_H_
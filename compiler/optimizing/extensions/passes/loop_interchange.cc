@@ -0,0 +1,520 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loop_interchange.h"
+
+#include "ext_utility.h"
+#include "find_ivs.h"
+#include "graph_x86.h"
+#include "induction_variable.h"
+#include "loop_formation.h"
+#include "loop_iterators.h"
+#include "loop_versioning.h"
+
+namespace art {
+
+static HInstruction* SkipNullCheck(HInstruction* insn) {
+  return insn->IsNullCheck() ? insn->InputAt(0) : insn;
+}
+
+static HInstruction* SkipBoundsCheck(HInstruction* insn) {
+  return insn->IsBoundsCheck() ? insn->InputAt(0) : insn;
+}
+
+bool HLoopInterchange::GetControl(HLoopInformation_X86* loop,
+                                  HBasicBlock* latch,
+                                  LoopControl* control) {
+  HBasicBlock* header = loop->GetHeader();
+  HInstruction* last = header->GetLastInstruction();
+  if (!last->IsIf() || !last->InputAt(0)->IsCondition()) {
+    PRINT_PASS_MESSAGE(this, "Loop header does not end with a condition");
+    return false;
+  }
+  HIf* branch = last->AsIf();
+  control->condition = last->InputAt(0)->AsCondition();
+  if (!control->condition->HasOnlyOneNonEnvironmentUse() ||
+      control->condition->HasEnvironmentUses()) {
+    PRINT_PASS_MESSAGE(this, "Loop condition is used elsewhere");
+    return false;
+  }
+  for (HInstructionIterator it(header->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* insn = it.Current();
+    if (insn != branch && insn != control->condition && !insn->IsSuspendCheck()) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Loop header contains " << insn->DebugName());
+      return false;
+    }
+  }
+
+  HInductionVariable* iv = loop->GetBoundInformation().loop_biv_;
+  if (iv == nullptr || !iv->IsBasicAndIncrementOf1()) {
+    PRINT_PASS_MESSAGE(this, "Loop has no basic IV incremented by 1");
+    return false;
+  }
+  control->phi = iv->GetPhiInsn();
+  control->linear = iv->GetLinearInsn();
+  if (control->phi->GetType() != Primitive::kPrimInt ||
+      control->phi->GetBlock() != header ||
+      control->linear->GetBlock() != latch ||
+      loop->PhiInput(control->phi, true) != control->linear) {
+    PRINT_PASS_MESSAGE(this, "Loop IV does not have the expected shape");
+    return false;
+  }
+
+  // The other phis would carry values across iterations, whose order changes.
+  if (header->GetFirstPhi() != control->phi || control->phi->GetNext() != nullptr) {
+    PRINT_PASS_MESSAGE(this, "Loop has other phis than its IV");
+    return false;
+  }
+
+  // Interchange moves the start and bound to the other loop: they must not depend on the nest.
+  HInstruction* start = loop->PhiInput(control->phi, false);
+  if (!start->IsIntConstant() || start->AsIntConstant()->GetValue() < 0) {
+    PRINT_PASS_MESSAGE(this, "Loop IV does not start from a non-negative constant");
+    return false;
+  }
+
+  // Only phi < bound is supported, the body being on the true successor.
+  IfCondition cond = control->condition->GetCondition();
+  if (control->condition->InputAt(0) == control->phi) {
+    control->bound_index = 1u;
+  } else if (control->condition->InputAt(1) == control->phi) {
+    control->bound_index = 0u;
+    cond = FlipConditionForOperandSwap(cond);
+  } else {
+    PRINT_PASS_MESSAGE(this, "Loop condition does not test the IV");
+    return false;
+  }
+  if (!loop->Contains(*branch->IfTrueSuccessor())) {
+    cond = NegateCondition(cond);
+  }
+  if (cond != kCondLT ||
+      control->condition->InputAt(control->bound_index)->GetType() != Primitive::kPrimInt) {
+    PRINT_PASS_MESSAGE(this, "Loop condition is not IV < bound");
+    return false;
+  }
+
+  return true;
+}
+
+bool HLoopInterchange::GetNest(HLoopInformation_X86* outer, LoopNest* nest) {
+  HLoopInformation_X86* inner = outer->GetInner();
+  if (inner == nullptr ||
+      inner->GetNextSibling() != nullptr ||
+      !inner->IsInner() ||
+      outer->IsOrHasIrreducibleLoop() ||
+      outer->HasTryCatchHandler() ||
+      outer->NumberOfBlocks() != 5 ||
+      outer->GetBackEdges().size() != 1u ||
+      inner->NumberOfBlocks() != 2 ||
+      inner->GetBackEdges().size() != 1u) {
+    PRINT_PASS_MESSAGE(this, "Loop is not a two-level nest of the right size");
+    return false;
+  }
+  nest->outer = outer;
+  nest->inner = inner;
+  nest->body = inner->GetBackEdges()[0];
+
+  // Perfect nest: the outer loop holds nothing but the inner loop and its own control.
+  HBasicBlock* inner_pre_header = inner->GetPreHeader();
+  HBasicBlock* inner_exit = inner->GetExitBlock();
+  if (nest->body->GetPredecessors().size() != 1u ||
+      nest->body->GetSinglePredecessor() != inner->GetHeader() ||
+      inner_pre_header == nullptr ||
+      inner_pre_header->GetSinglePredecessor() != outer->GetHeader() ||
+      inner_pre_header->GetFirstInstruction() != inner_pre_header->GetLastInstruction() ||
+      inner_exit == nullptr ||
+      inner_exit != outer->GetBackEdges()[0] ||
+      inner_exit->GetPredecessors().size() != 1u ||
+      outer->GetExitBlock() == nullptr) {
+    PRINT_PASS_MESSAGE(this, "Loop nest is not perfect");
+    return false;
+  }
+
+  if (!GetControl(outer, inner_exit, &nest->outer_control) ||
+      !GetControl(inner, nest->body, &nest->inner_control)) {
+    return false;
+  }
+  if (inner_exit->GetFirstInstruction() != nest->outer_control.linear ||
+      nest->outer_control.linear->GetNext() != inner_exit->GetLastInstruction()) {
+    PRINT_PASS_MESSAGE(this, "Loop nest is not perfect");
+    return false;
+  }
+
+  const LoopControl* controls[] = { &nest->outer_control, &nest->inner_control };
+  for (const LoopControl* control : controls) {
+    if (outer->Contains(*control->condition->InputAt(control->bound_index)->GetBlock())) {
+      PRINT_PASS_MESSAGE(this, "Loop bound is defined in the nest");
+      return false;
+    }
+    // The IVs take each other's values, so nobody may see their final value.
+    for (HAllUseIterator use_it(control->phi); !use_it.Done(); use_it.Advance()) {
+      if (!outer->Contains(*use_it.Current()->GetBlock())) {
+        PRINT_PASS_MESSAGE(this, "Loop IV is used after the nest");
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+const HLoopInterchange::LoopControl* HLoopInterchange::GetIndexControl(HInstruction* access,
+                                                                      const LoopNest& nest) {
+  HInstruction* index = SkipBoundsCheck(access->InputAt(1));
+  if (index == nest.outer_control.phi) {
+    return &nest.outer_control;
+  }
+  if (index == nest.inner_control.phi) {
+    return &nest.inner_control;
+  }
+  return nullptr;
+}
+
+bool HLoopInterchange::IsRowLoad(HInstruction* insn, const LoopNest& nest) {
+  return insn->IsArrayGet() &&
+         insn->GetType() == Primitive::kPrimNot &&
+         nest.outer->Contains(*insn->GetBlock()) &&
+         !nest.outer->Contains(*SkipNullCheck(insn->InputAt(0))->GetBlock()) &&
+         GetIndexControl(insn, nest) != nullptr;
+}
+
+bool HLoopInterchange::CollectChecks(const LoopNest& nest, HLoopVersioning* versioning) {
+  // The rows accessed, with the bound of the index used in them, if any.
+  ArenaVector<std::pair<HInstruction*, HInstruction*>> rows(
+      graph_->GetArena()->Adapter(kArenaAllocMisc));
+  auto add_row = [&rows](HInstruction* row, HInstruction* min_length) {
+    for (auto& entry : rows) {
+      if (entry.first == row) {
+        if (entry.second == nullptr) {
+          entry.second = min_length;
+        }
+        return min_length == nullptr || entry.second == min_length;
+      }
+    }
+    rows.push_back(std::make_pair(row, min_length));
+    return true;
+  };
+
+  for (HInstructionIterator it(nest.body->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* insn = it.Current();
+    if (insn->IsNullCheck()) {
+      HInstruction* value = insn->InputAt(0);
+      if (!nest.outer->Contains(*value->GetBlock())) {
+        versioning->AddNotNullCheck(value);
+        continue;
+      }
+      if (IsRowLoad(value, nest) && add_row(value, nullptr)) {
+        continue;
+      }
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Cannot prove NullCheck " << insn->GetId());
+      return false;
+    }
+
+    if (insn->IsBoundsCheck()) {
+      HInstruction* index = insn->InputAt(0);
+      HInstruction* length = insn->InputAt(1);
+      const LoopControl* control = nullptr;
+      if (index == nest.outer_control.phi) {
+        control = &nest.outer_control;
+      } else if (index == nest.inner_control.phi) {
+        control = &nest.inner_control;
+      }
+      if (control != nullptr &&
+          length->IsArrayLength() &&
+          !length->AsArrayLength()->IsStringLength()) {
+        HInstruction* bound = control->condition->InputAt(control->bound_index);
+        HInstruction* array = SkipNullCheck(length->InputAt(0));
+        if (!nest.outer->Contains(*array->GetBlock())) {
+          versioning->AddNotNullCheck(array);
+          versioning->AddArrayLengthCheck(array, bound);
+          continue;
+        }
+        if (IsRowLoad(array, nest) && add_row(array, bound)) {
+          continue;
+        }
+      }
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Cannot prove BoundsCheck " << insn->GetId());
+      return false;
+    }
+
+    // The checks above rely on the arrays of arrays not being modified.
+    if ((insn->IsArrayGet() && insn->GetType() == Primitive::kPrimNot && !IsRowLoad(insn, nest)) ||
+        (insn->IsArraySet() && insn->AsArraySet()->GetComponentType() == Primitive::kPrimNot)) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Unsupported reference array access " << insn->GetId());
+      return false;
+    }
+
+    if (insn->CanThrow() || insn->HasEnvironment()) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Loop contains " << insn->DebugName()
+                                       << " which may throw");
+      return false;
+    }
+
+    bool is_supported_access = insn->IsArrayGet() || insn->IsArraySet() ||
+        (insn->IsInstanceFieldGet() && !insn->AsInstanceFieldGet()->IsVolatile()) ||
+        (insn->IsStaticFieldGet() && !insn->AsStaticFieldGet()->IsVolatile());
+    if ((insn->GetSideEffects().DoesAnyWrite() || insn->GetSideEffects().DoesAnyRead()) &&
+        !is_supported_access) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Loop contains " << insn->DebugName()
+                                       << " with unsupported side effects");
+      return false;
+    }
+  }
+
+  // Each row is checked over the range of its index.
+  for (const auto& entry : rows) {
+    HInstruction* row = entry.first;
+    HInstruction* array = SkipNullCheck(row->InputAt(0));
+    const LoopControl* control = GetIndexControl(row, nest);
+    HLoopInformation_X86* loop = (control == &nest.outer_control) ? nest.outer : nest.inner;
+    HInstruction* start = loop->PhiInput(control->phi, false);
+    HInstruction* end = control->condition->InputAt(control->bound_index);
+    HInstruction* min_length = (entry.second != nullptr) ? entry.second : graph_->GetIntConstant(0);
+    versioning->AddNotNullCheck(array);
+    versioning->AddArrayLengthCheck(array, end);
+    versioning->AddArrayRowsCheck(row, start, end, min_length);
+  }
+
+  return true;
+}
+
+bool HLoopInterchange::CheckDependencies(const LoopNest& nest) {
+  ArenaVector<HInstruction*> accesses(graph_->GetArena()->Adapter(kArenaAllocMisc));
+  for (HInstructionIterator it(nest.body->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* insn = it.Current();
+    if (insn->IsArrayGet() || insn->IsArraySet() ||
+        insn->IsInstanceFieldGet() || insn->IsStaticFieldGet()) {
+      accesses.push_back(insn);
+    }
+  }
+
+  // Iterations touching the same element are ordered by the other IV before and after
+  // interchange, as long as both accesses are indexed by the same IV.
+  for (size_t i = 0, e = accesses.size(); i < e; ++i) {
+    for (size_t j = i; j < e; ++j) {
+      HInstruction* x = accesses[i];
+      HInstruction* y = accesses[j];
+      if (!x->IsArraySet() && !y->IsArraySet()) {
+        continue;
+      }
+      if (x != y && alias_.Alias(x, y) == AliasCheck::kNoAlias) {
+        continue;
+      }
+      bool is_array_pair = (x->IsArrayGet() || x->IsArraySet()) &&
+                           (y->IsArrayGet() || y->IsArraySet());
+      if (!is_array_pair ||
+          GetIndexControl(x, nest) == nullptr ||
+          GetIndexControl(x, nest) != GetIndexControl(y, nest)) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, x->DebugName() << " " << x->GetId() << " and "
+                                         << y->DebugName() << " " << y->GetId()
+                                         << " prevent interchange");
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool HLoopInterchange::IsProfitable(const LoopNest& nest) const {
+  size_t across_rows = 0u;
+  size_t along_rows = 0u;
+  for (HInstructionIterator it(nest.body->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* insn = it.Current();
+    if (!(insn->IsArrayGet() || insn->IsArraySet())) {
+      continue;
+    }
+    HInstruction* base = SkipNullCheck(insn->InputAt(0));
+    if (!IsRowLoad(base, nest)) {
+      continue;
+    }
+    const LoopControl* element_control = GetIndexControl(insn, nest);
+    const LoopControl* row_control = GetIndexControl(base, nest);
+    if (element_control == &nest.outer_control && row_control == &nest.inner_control) {
+      across_rows++;
+    } else if (element_control == &nest.inner_control && row_control == &nest.outer_control) {
+      along_rows++;
+    }
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Accesses across rows: " << across_rows
+                                   << ", along rows: " << along_rows);
+  return across_rows > along_rows;
+}
+
+void HLoopInterchange::Interchange(const LoopNest& nest, bool remove_checks) {
+  const LoopControl& outer = nest.outer_control;
+  const LoopControl& inner = nest.inner_control;
+  HBasicBlock* outer_header = nest.outer->GetHeader();
+  HBasicBlock* inner_header = nest.inner->GetHeader();
+
+  // Remember the uses of the IVs by the body before touching them.
+  ArenaVector<std::pair<HInstruction*, size_t>> outer_uses(
+      graph_->GetArena()->Adapter(kArenaAllocMisc));
+  ArenaVector<std::pair<HInstruction*, size_t>> inner_uses(
+      graph_->GetArena()->Adapter(kArenaAllocMisc));
+  ArenaVector<std::pair<HEnvironment*, size_t>> outer_env_uses(
+      graph_->GetArena()->Adapter(kArenaAllocMisc));
+  ArenaVector<std::pair<HEnvironment*, size_t>> inner_env_uses(
+      graph_->GetArena()->Adapter(kArenaAllocMisc));
+
+  // The outer header cannot describe the inner IV, which it does not see anymore.
+  for (HInstruction* insn = outer_header->GetFirstInstruction(); insn != nullptr;) {
+    HInstruction* next = insn->GetNext();
+    if (insn->IsSuspendCheck()) {
+      outer_header->RemoveInstruction(insn);
+      nest.outer->SetSuspendCheck(nullptr);
+    }
+    insn = next;
+  }
+
+  for (const HUseListNode<HInstruction*>& use : outer.phi->GetUses()) {
+    HInstruction* user = use.GetUser();
+    if (user != outer.linear && user != outer.condition) {
+      outer_uses.push_back(std::make_pair(user, use.GetIndex()));
+    }
+  }
+  for (const HUseListNode<HEnvironment*>& use : outer.phi->GetEnvUses()) {
+    outer_env_uses.push_back(std::make_pair(use.GetUser(), use.GetIndex()));
+  }
+  for (const HUseListNode<HInstruction*>& use : inner.phi->GetUses()) {
+    HInstruction* user = use.GetUser();
+    if (user != inner.linear && user != inner.condition) {
+      inner_uses.push_back(std::make_pair(user, use.GetIndex()));
+    }
+  }
+  for (const HUseListNode<HEnvironment*>& use : inner.phi->GetEnvUses()) {
+    inner_env_uses.push_back(std::make_pair(use.GetUser(), use.GetIndex()));
+  }
+
+  // Exchange the iteration spaces.
+  HInstruction* outer_start = nest.outer->PhiInput(outer.phi, false);
+  HInstruction* inner_start = nest.inner->PhiInput(inner.phi, false);
+  HInstruction* outer_bound = outer.condition->InputAt(outer.bound_index);
+  HInstruction* inner_bound = inner.condition->InputAt(inner.bound_index);
+  outer.phi->ReplaceInput(inner_start,
+                          outer_header->GetPredecessorIndexOf(nest.outer->GetPreHeader()));
+  inner.phi->ReplaceInput(outer_start,
+                          inner_header->GetPredecessorIndexOf(nest.inner->GetPreHeader()));
+  outer.condition->ReplaceInput(inner_bound, outer.bound_index);
+  inner.condition->ReplaceInput(outer_bound, inner.bound_index);
+
+  // And the IVs seen by the body.
+  for (const auto& use : outer_uses) {
+    use.first->ReplaceInput(inner.phi, use.second);
+  }
+  for (const auto& use : inner_uses) {
+    use.first->ReplaceInput(outer.phi, use.second);
+  }
+  for (const auto& use : outer_env_uses) {
+    use.first->RemoveAsUserOfInput(use.second);
+    use.first->SetRawEnvAt(use.second, inner.phi);
+    inner.phi->AddEnvUseAt(use.first, use.second);
+  }
+  for (const auto& use : inner_env_uses) {
+    use.first->RemoveAsUserOfInput(use.second);
+    use.first->SetRawEnvAt(use.second, outer.phi);
+    outer.phi->AddEnvUseAt(use.first, use.second);
+  }
+
+  if (!remove_checks) {
+    return;
+  }
+
+  // The guards of the nest proved that the checks succeed.
+  HBasicBlock* body = nest.body;
+  for (HInstruction* insn = body->GetFirstInstruction(); insn != nullptr;) {
+    HInstruction* next = insn->GetNext();
+    if (insn->IsNullCheck() || insn->IsBoundsCheck()) {
+      insn->ReplaceWith(insn->InputAt(0));
+      body->RemoveInstruction(insn);
+    }
+    insn = next;
+  }
+  for (HInstruction* insn = body->GetFirstInstruction(); insn != nullptr;) {
+    HInstruction* next = insn->GetNext();
+    if (insn->IsArrayLength() && !insn->HasUses()) {
+      body->RemoveInstruction(insn);
+    }
+    insn = next;
+  }
+}
+
+void HLoopInterchange::Run() {
+  PRINT_PASS_MESSAGE(this, "start");
+
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  HLoopFormation formation(graph_);
+  formation.Run();
+  HFindInductionVariables find_ivs(graph_, "find_ivs_for_interchange", stats_);
+  find_ivs.Run();
+
+  // The outer loops of the nests.
+  ArenaVector<HBasicBlock*> headers = HLoopVersioning::CollectHeaders<HOutToInLoopIterator>(
+      graph, [](HLoopInformation_X86* loop) { return loop->GetInner() != nullptr; });
+
+  for (HBasicBlock* header : headers) {
+    HLoopInformation_X86* loop = LOOPINFO_TO_LOOPINFO_X86(header->GetLoopInformation());
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Visit loop " << header->GetBlockId());
+
+    LoopNest nest;
+    HLoopVersioning versioning(loop, this);
+    if (!GetNest(loop, &nest) ||
+        !CollectChecks(nest, &versioning) ||
+        !CheckDependencies(nest) ||
+        !IsProfitable(nest)) {
+      continue;
+    }
+
+    bool remove_checks = versioning.HasChecks();
+    if (remove_checks) {
+      if (!versioning.Gate()) {
+        continue;
+      }
+      // Only the fast version is interchanged, it is found again in the rebuilt loops.
+      HBasicBlock* fast_header = versioning.Version();
+      HLoopFormation form_loops(graph_);
+      form_loops.Run();
+      HFindInductionVariables find_ivs_after_versioning(graph_, "find_ivs_after_versioning",
+                                                        stats_);
+      find_ivs_after_versioning.Run();
+
+      HLoopInformation_X86* fast_loop =
+          LOOPINFO_TO_LOOPINFO_X86(fast_header->GetLoopInformation());
+      HLoopVersioning fast_versioning(fast_loop, this);
+      if (!GetNest(fast_loop, &nest) || !CollectChecks(nest, &fast_versioning)) {
+        PRINT_PASS_MESSAGE(this, "The fast version cannot be interchanged");
+        continue;
+      }
+    }
+
+    Interchange(nest, remove_checks);
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Interchanged loop " << nest.outer->GetHeader()->GetBlockId()
+                                     << " of " << GetMethodName(graph_));
+    MaybeRecordStat(MethodCompilationStat::kIntelLoopInterchanged);
+
+    // The next nests are found in the loops of the interchanged graph.
+    graph->InvalidateAnalyses(kAnalysisAll);
+    HLoopFormation form_loops(graph_);
+    form_loops.Run();
+    HFindInductionVariables find_ivs_after_interchange(graph_, "find_ivs_after_interchange",
+                                                       stats_);
+    find_ivs_after_interchange.Run();
+  }
+  PRINT_PASS_MESSAGE(this, "end");
+}
+
+}  // namespace art
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_INTERCHANGE_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_INTERCHANGE_H_
+
+#include "ext_alias.h"
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+// Forward declarations.
+class HLoopInformation_X86;
+class HLoopVersioning;
+
+/**
+ * @brief Loop interchange swaps a perfect nest of two counted loops when the inner
+ * loop walks the rows of an array of arrays, as in a[j][i] with j inner.
+ * @details Both loops must count up by one from a non-negative constant to a bound
+ * defined before the nest. The loop controls are then exchanged, the body is kept
+ * and sees the same pairs of induction variable values in a different order.
+ * The null and bounds checks of the body would throw in that different order, so
+ * the nest is versioned on checks proving that they all succeed, the rows of the
+ * arrays included, and they are removed from the interchanged version.
+ */
+class HLoopInterchange : public HOptimization_X86 {
+ public:
+  explicit HLoopInterchange(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kLoopInterchangePassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    // The interchange rewires the headers, phis and bounds of the nests.
+    return kAnalysisAll;
+  }
+
+ private:
+  /**
+   * @brief The control of a loop counting up by one: phi < bound.
+   */
+  struct LoopControl {
+    HPhi* phi;
+    HInstruction* linear;
+    HCondition* condition;
+    size_t bound_index;
+  };
+
+  /**
+   * @brief The parts of a perfect nest that interchange deals with.
+   */
+  struct LoopNest {
+    HLoopInformation_X86* outer;
+    HLoopInformation_X86* inner;
+    LoopControl outer_control;
+    LoopControl inner_control;
+    HBasicBlock* body;
+  };
+
+  /**
+   * @brief Get the control of the IV indexing the array access, if any.
+   */
+  static const LoopControl* GetIndexControl(HInstruction* access, const LoopNest& nest);
+
+  /**
+   * @brief Is insn the load of a row of an array of arrays defined before the nest?
+   */
+  static bool IsRowLoad(HInstruction* insn, const LoopNest& nest);
+
+  /**
+   * @brief Fill control if loop is counted as interchange needs it.
+   * @param latch The block expected to hold the increment of the induction variable.
+   */
+  bool GetControl(HLoopInformation_X86* loop, HBasicBlock* latch, LoopControl* control);
+
+  /**
+   * @brief Fill nest if outer is the outer loop of a supported perfect nest.
+   */
+  bool GetNest(HLoopInformation_X86* outer, LoopNest* nest);
+
+  /**
+   * @brief Check the body of the nest, and collect the checks proving that none
+   * of its instructions throws.
+   * @return Returns true if the checks of the body can all be proven.
+   */
+  bool CollectChecks(const LoopNest& nest, HLoopVersioning* versioning);
+
+  /**
+   * @brief Check that the new order of iterations does not change the semantics.
+   */
+  bool CheckDependencies(const LoopNest& nest);
+
+  /**
+   * @brief Does the body access more array elements across rows than along them?
+   */
+  bool IsProfitable(const LoopNest& nest) const;
+
+  /**
+   * @brief Exchange the loop controls of nest, removing its checks if asked to.
+   */
+  void Interchange(const LoopNest& nest, bool remove_checks);
+
+  AliasCheck alias_;
+
+  static constexpr const char* kLoopInterchangePassName = "loop_interchange";
+
+  DISALLOW_COPY_AND_ASSIGN(HLoopInterchange);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_INTERCHANGE_H_
@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loop_strength_reduction.h"
+
+#include "ext_utility.h"
+#include "find_ivs.h"
+#include "graph_x86.h"
+#include "induction_variable.h"
+#include "loop_formation.h"
+#include "loop_iterators.h"
+
+namespace art {
+
+// Is iv a basic IV whose update is the back edge input of its phi?
+static bool IsSupportedIV(HLoopInformation_X86* loop, HInductionVariable* iv) {
+  HPhi* phi = iv->GetPhiInsn();
+  return !iv->IsFP() &&
+         Primitive::IsIntOrLongType(phi->GetType()) &&
+         phi->InputCount() == 2u &&
+         loop->PhiInput(phi, true) == iv->GetLinearInsn();
+}
+
+// Returns x * y, folded if both are constants, emitted before cursor otherwise.
+static HInstruction* MakeProduct(HGraph* graph,
+                                 HInstruction* cursor,
+                                 Primitive::Type type,
+                                 HInstruction* x,
+                                 HInstruction* y) {
+  if (x->IsConstant() && y->IsConstant()) {
+    // The product wraps, as it does at runtime.
+    uint64_t product = static_cast<uint64_t>(Int64FromConstant(x->AsConstant())) *
+                       static_cast<uint64_t>(Int64FromConstant(y->AsConstant()));
+    return (type == Primitive::kPrimLong)
+        ? graph->GetConstant(type, static_cast<int64_t>(product))
+        : graph->GetConstant(type, static_cast<int32_t>(static_cast<uint32_t>(product)));
+  }
+  if (x->IsConstant() && Int64FromConstant(x->AsConstant()) == 1) {
+    return y;
+  }
+  if (y->IsConstant() && Int64FromConstant(y->AsConstant()) == 1) {
+    return x;
+  }
+  HInstruction* product = new (graph->GetArena()) HMul(type, x, y);
+  cursor->GetBlock()->InsertInstructionBefore(product, cursor);
+  return product;
+}
+
+bool HLoopStrengthReduction::MergeRedundantIVs(HLoopInformation_X86* loop) {
+  ArenaVector<HInductionVariable*>& ivs = loop->GetInductionVariables();
+  HInductionVariable* biv = loop->GetBoundInformation().loop_biv_;
+  bool merged_any = false;
+
+  for (size_t i = 0; i < ivs.size(); i++) {
+    for (size_t j = ivs.size() - 1; j > i; j--) {
+      HInductionVariable* kept = ivs[i];
+      HInductionVariable* merged = ivs[j];
+      HPhi* kept_phi = kept->GetPhiInsn();
+      HPhi* merged_phi = merged->GetPhiInsn();
+      if (!IsSupportedIV(loop, kept) || !IsSupportedIV(loop, merged) ||
+          kept_phi->GetType() != merged_phi->GetType() ||
+          kept->GetIncrement() != merged->GetIncrement() ||
+          loop->PhiInput(kept_phi, false) != loop->PhiInput(merged_phi, false)) {
+        continue;
+      }
+      // The IV controlling the loop stays, the bound information refers to it.
+      if (merged == biv) {
+        std::swap(kept, merged);
+      }
+
+      HPhi* phi = merged->GetPhiInsn();
+      HInstruction* linear = merged->GetLinearInsn();
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Phi " << phi->GetId() << " duplicates phi "
+                                       << kept->GetPhiInsn()->GetId());
+      phi->ReplaceWith(kept->GetPhiInsn());
+      phi->GetBlock()->RemovePhi(phi);
+
+      // The update now computes the same value as the kept one, use that one if we can.
+      HInstruction* kept_linear = kept->GetLinearInsn();
+      if (!linear->GetUses().empty() || linear->HasEnvironmentUses()) {
+        if (kept_linear->StrictlyDominates(linear)) {
+          linear->ReplaceWith(kept_linear);
+        }
+      }
+      if (linear->GetUses().empty() && !linear->HasEnvironmentUses()) {
+        linear->GetBlock()->RemoveInstruction(linear);
+      }
+
+      // The merged IV must not be seen again, it is replaced by the kept one.
+      ivs[i] = kept;
+      ivs.erase(ivs.begin() + j);
+      MaybeRecordStat(MethodCompilationStat::kIntelIVEliminated);
+      merged_any = true;
+    }
+  }
+  return merged_any;
+}
+
+HPhi* HLoopStrengthReduction::AddReducedIV(HLoopInformation_X86* loop,
+                                           HInductionVariable* iv,
+                                           HInstruction* factor) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HPhi* phi = iv->GetPhiInsn();
+  HInstruction* linear = iv->GetLinearInsn();
+  Primitive::Type type = phi->GetType();
+  HBasicBlock* header = loop->GetHeader();
+  HInstruction* cursor = loop->GetPreHeader()->GetLastInstruction();
+
+  // The new IV starts at start * factor and goes up by increment * factor.
+  HInstruction* start = loop->PhiInput(phi, false);
+  HInstruction* increment = graph_->GetConstant(type, iv->GetIncrement());
+  HInstruction* init = MakeProduct(graph_, cursor, type, start, factor);
+  HInstruction* stride = MakeProduct(graph_, cursor, type, increment, factor);
+
+  HPhi* reduced = new (arena) HPhi(arena, kNoRegNumber, 0, type);
+  header->AddPhi(reduced);
+  HInstruction* update = new (arena) HAdd(type, reduced, stride);
+  linear->GetBlock()->InsertInstructionAfter(update, linear);
+  for (HBasicBlock* predecessor : header->GetPredecessors()) {
+    reduced->AddInput(loop->Contains(*predecessor) ? update : init);
+  }
+
+  return reduced;
+}
+
+bool HLoopStrengthReduction::ReduceMultiplications(HLoopInformation_X86* loop,
+                                                   HInductionVariable* iv,
+                                                   HPhi** reduced_iv,
+                                                   int64_t* factor_value) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HPhi* phi = iv->GetPhiInsn();
+  HInstruction* linear = iv->GetLinearInsn();
+  Primitive::Type type = phi->GetType();
+
+  // Collect the multiplications first, replacing them changes the uses.
+  ArenaVector<HMul*> muls(arena->Adapter(kArenaAllocMisc));
+  for (HInstruction* value : { static_cast<HInstruction*>(phi), linear }) {
+    for (const HUseListNode<HInstruction*>& use : value->GetUses()) {
+      HInstruction* user = use.GetUser();
+      if (user->IsMul() && user->GetType() == type && loop->Contains(*user->GetBlock()) &&
+          !ContainsElement(muls, user->AsMul())) {
+        muls.push_back(user->AsMul());
+      }
+    }
+  }
+
+  ArenaSafeMap<HInstruction*, HPhi*> reduced_ivs(std::less<HInstruction*>(),
+                                                 arena->Adapter(kArenaAllocMisc));
+  HPhi* best = nullptr;
+  bool reduced_any = false;
+  for (HMul* mul : muls) {
+    bool is_on_phi = mul->InputAt(0) == phi || mul->InputAt(1) == phi;
+    HInstruction* iv_input = is_on_phi ? phi : linear;
+    HInstruction* factor = (mul->InputAt(0) == iv_input) ? mul->InputAt(1) : mul->InputAt(0);
+    if (loop->Contains(*factor->GetBlock())) {
+      continue;
+    }
+
+    HPhi* reduced = nullptr;
+    auto it = reduced_ivs.find(factor);
+    if (it != reduced_ivs.end()) {
+      reduced = it->second;
+    } else if (reduced_ivs.size() < kMaxReducedIVs) {
+      reduced = AddReducedIV(loop, iv, factor);
+      reduced_ivs.Put(factor, reduced);
+      if (factor->IsConstant()) {
+        int64_t value = Int64FromConstant(factor->AsConstant());
+        if (value > 0 && (best == nullptr || value < *factor_value)) {
+          best = reduced;
+          *factor_value = value;
+        }
+      }
+    } else {
+      continue;
+    }
+
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Mul " << mul->GetId() << " replaced with phi "
+                                     << reduced->GetId());
+    mul->ReplaceWith(is_on_phi ? reduced : loop->PhiInput(reduced, true));
+    mul->GetBlock()->RemoveInstruction(mul);
+    MaybeRecordStat(MethodCompilationStat::kIntelStrengthReduced);
+    reduced_any = true;
+  }
+
+  *reduced_iv = best;
+  return reduced_any;
+}
+
+bool HLoopStrengthReduction::ReplaceTest(HLoopInformation_X86* loop,
+                                         HInductionVariable* iv,
+                                         HPhi* reduced,
+                                         int64_t factor) {
+  HPhi* phi = iv->GetPhiInsn();
+  HInstruction* linear = iv->GetLinearInsn();
+  HInstruction* start = loop->PhiInput(phi, false);
+  const HLoopBoundInformation& bound_info = loop->GetBoundInformation();
+  if (phi->GetType() != Primitive::kPrimInt || !start->IsIntConstant() ||
+      !bound_info.is_simple_count_up_ || !loop->HasKnownNumIterations() ||
+      !loop->HasOneExitEdge()) {
+    return false;
+  }
+
+  // Find the test of the loop, comparing the IV to a constant.
+  HBasicBlock* exit_block = loop->GetExitBlock();
+  HBasicBlock* exiting_block = nullptr;
+  for (HBasicBlock* predecessor : exit_block->GetPredecessors()) {
+    if (loop->Contains(*predecessor)) {
+      exiting_block = predecessor;
+    }
+  }
+  HIf* branch = (exiting_block == nullptr) ? nullptr : exiting_block->GetLastInstruction()->AsIf();
+  HCondition* condition = (branch == nullptr) ? nullptr : branch->InputAt(0)->AsCondition();
+  if (condition == nullptr || !condition->HasOnlyOneNonEnvironmentUse() ||
+      condition->HasEnvironmentUses()) {
+    return false;
+  }
+  switch (condition->GetCondition()) {
+    case kCondEQ:
+    case kCondNE:
+    case kCondLT:
+    case kCondLE:
+    case kCondGT:
+    case kCondGE:
+      break;
+    default:
+      // The unsigned comparisons do not survive the multiplication.
+      return false;
+  }
+  size_t iv_index = (condition->InputAt(0) == phi || condition->InputAt(0) == linear) ? 0u : 1u;
+  HInstruction* iv_value = condition->InputAt(iv_index);
+  HInstruction* bound = condition->InputAt(1u - iv_index);
+  if ((iv_value != phi && iv_value != linear) || !bound->IsIntConstant()) {
+    return false;
+  }
+
+  // The IV goes up from start, through num_iterations increments or so, and crosses
+  // the bound. The comparison keeps its meaning if the products of all these values
+  // by the positive factor do not overflow.
+  int64_t increment = iv->GetIncrement();
+  int64_t start_value = start->AsIntConstant()->GetValue();
+  int64_t bound_value = bound->AsIntConstant()->GetValue();
+  int64_t num_iterations = bound_info.num_iterations_;
+  if (factor <= 0 || increment <= 0 || num_iterations > std::numeric_limits<int32_t>::max()) {
+    return false;
+  }
+  int64_t low = std::min(start_value, bound_value);
+  int64_t high = std::max(start_value + increment * (num_iterations + 2), bound_value + increment);
+  if (high > std::numeric_limits<int32_t>::max() ||
+      high * factor > std::numeric_limits<int32_t>::max() ||
+      low * factor < std::numeric_limits<int32_t>::min()) {
+    PRINT_PASS_MESSAGE(this, "The reduced IV may overflow, the test is kept");
+    return false;
+  }
+
+  condition->ReplaceInput(iv_value == phi ? reduced : loop->PhiInput(reduced, true), iv_index);
+  condition->ReplaceInput(graph_->GetIntConstant(static_cast<int32_t>(bound_value * factor)),
+                          1u - iv_index);
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Test " << condition->GetId() << " now uses phi "
+                                   << reduced->GetId());
+
+  // Without other uses, the IV only feeds itself.
+  if (phi->HasEnvironmentUses() || linear->HasEnvironmentUses() ||
+      !phi->HasOnlyOneNonEnvironmentUse() || !linear->HasOnlyOneNonEnvironmentUse()) {
+    return true;
+  }
+  size_t back_edge_index = (phi->InputAt(0) == linear) ? 0u : 1u;
+  phi->ReplaceInput(start, back_edge_index);
+  linear->GetBlock()->RemoveInstruction(linear);
+  phi->GetBlock()->RemovePhi(phi);
+  MaybeRecordStat(MethodCompilationStat::kIntelIVEliminated);
+  return true;
+}
+
+void HLoopStrengthReduction::Run() {
+  PRINT_PASS_MESSAGE(this, "start");
+
+  HLoopFormation formation(graph_);
+  formation.Run();
+  HFindInductionVariables find_ivs(graph_, "find_ivs_for_strength_reduction", stats_);
+  find_ivs.Run();
+
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  bool changed = false;
+  for (HOutToInLoopIterator it(graph->GetLoopInformation()); !it.Done(); it.Advance()) {
+    HLoopInformation_X86* loop = it.Current();
+    if (loop->IsOrHasIrreducibleLoop() || loop->GetBackEdges().size() != 1u ||
+        loop->GetPreHeader() == nullptr) {
+      continue;
+    }
+
+    changed |= MergeRedundantIVs(loop);
+
+    HInductionVariable* biv = loop->GetBoundInformation().loop_biv_;
+    HPhi* biv_reduced = nullptr;
+    int64_t biv_factor = 0;
+    // The list may not be changed while iterating, take a copy.
+    ArenaVector<HInductionVariable*> ivs(loop->GetInductionVariables());
+    for (HInductionVariable* iv : ivs) {
+      if (!IsSupportedIV(loop, iv)) {
+        continue;
+      }
+      int64_t factor = 0;
+      HPhi* reduced = nullptr;
+      changed |= ReduceMultiplications(loop, iv, &reduced, &factor);
+      if (iv == biv) {
+        biv_reduced = reduced;
+        biv_factor = factor;
+      }
+    }
+
+    if (biv_reduced != nullptr) {
+      changed |= ReplaceTest(loop, biv, biv_reduced, biv_factor);
+    }
+  }
+
+  // The IVs and bounds of the loops still refer to the removed phis and updates.
+  if (changed) {
+    graph->InvalidateAnalyses(kAnalysisInductionVariables | kAnalysisLoopBounds);
+    HLoopFormation formation_after(graph_);
+    formation_after.Run();
+    HFindInductionVariables find_ivs_after(graph_, "find_ivs_after_strength_reduction", stats_);
+    find_ivs_after.Run();
+  }
+
+  PRINT_PASS_MESSAGE(this, "end");
+}
+
+}  // namespace art
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_STRENGTH_REDUCTION_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_STRENGTH_REDUCTION_H_
+
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+// Forward declarations.
+class HInductionVariable;
+class HLoopInformation_X86;
+
+/**
+ * @brief Loop strength reduction replaces the multiplications of a basic IV by a
+ * loop invariant, as in a[i * stride + j], with a new IV incremented by the stride.
+ * @details Java arithmetic wraps, so the new IV always equals the product. The loop
+ * test is then rewritten on the new IV when the bounds are known not to overflow,
+ * which lets the original IV go away when it has no other use. Basic IVs going through
+ * the same values, as left by unrolling or written in the source, are merged first.
+ */
+class HLoopStrengthReduction : public HOptimization_X86 {
+ public:
+  explicit HLoopStrengthReduction(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kLoopStrengthReductionPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    // Once the IVs are changed, the pass finds them again.
+    return kAnalysisNone;
+  }
+
+ private:
+  /**
+   * @brief Replace the basic IVs of loop which duplicate another one.
+   * @return Returns true if any IV was merged.
+   */
+  bool MergeRedundantIVs(HLoopInformation_X86* loop);
+
+  /**
+   * @brief Replace the multiplications of the IV by new IVs.
+   * @param reduced_iv Set to the new IV whose factor is the smallest positive constant, if any.
+   * @param factor_value Set to the factor of reduced_iv.
+   * @return Returns true if any multiplication was replaced.
+   */
+  bool ReduceMultiplications(HLoopInformation_X86* loop,
+                             HInductionVariable* iv,
+                             HPhi** reduced_iv,
+                             int64_t* factor_value);
+
+  /**
+   * @brief Create the IV equal to the IV of loop multiplied by factor.
+   */
+  HPhi* AddReducedIV(HLoopInformation_X86* loop, HInductionVariable* iv, HInstruction* factor);
+
+  /**
+   * @brief Rewrite the loop test on reduced, the IV times the positive constant factor,
+   * and remove the IV if nothing else uses it.
+   * @return Returns true if the test was rewritten.
+   */
+  bool ReplaceTest(HLoopInformation_X86* loop,
+                   HInductionVariable* iv,
+                   HPhi* reduced,
+                   int64_t factor);
+
+  static constexpr const char* kLoopStrengthReductionPassName = "loop_strength_reduction";
+  // Each new IV takes a register for the whole loop, so few are added per basic IV.
+  static constexpr size_t kMaxReducedIVs = 4;
+
+  DISALLOW_COPY_AND_ASSIGN(HLoopStrengthReduction);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_STRENGTH_REDUCTION_H_
@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) 2015 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cloning.h"
+#include "ext_utility.h"
+#include "graph_x86.h"
+#include "loop_iterators.h"
+#include "loop_unroll_and_jam.h"
+
+namespace art {
+
+static bool IsLoopExitBlock(HBasicBlock* block, HLoopInformation_X86* loop) {
+  for (HBasicBlock* successor : block->GetSuccessors()) {
+    if (!loop->Contains(*successor)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool HasInputIn(HInstruction* insn, const ArenaSet<HInstruction*>& set) {
+  for (size_t i = 0, e = insn->InputCount(); i < e; ++i) {
+    if (set.count(insn->InputAt(i)) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool AreUsesInLoop(HInstruction* insn, HLoopInformation_X86* loop) {
+  for (const HUseListNode<HInstruction*>& use : insn->GetUses()) {
+    if (!loop->Contains(*use.GetUser()->GetBlock())) {
+      return false;
+    }
+  }
+  for (const HUseListNode<HEnvironment*>& use : insn->GetEnvUses()) {
+    if (!loop->Contains(*use.GetUser()->GetHolder()->GetBlock())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool IsArrayAccessIndexedBy(HInstruction* insn, HPhi* iv) {
+  return (insn->IsArrayGet() || insn->IsArraySet()) && insn->InputAt(1) == iv;
+}
+
+void HLoopUnrollAndJam::Run() {
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  HLoopInformation_X86* loop_start = graph->GetLoopInformation();
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Begin " << GetMethodName(graph));
+
+  // The control flow is not modified, so walking the hierarchy while transforming is fine.
+  for (HOutToInLoopIterator it(loop_start); !it.Done(); it.Advance()) {
+    HLoopInformation_X86* outer = it.Current();
+    ArenaVector<HInstruction*> to_clone(graph->GetArena()->Adapter(kArenaAllocMisc));
+
+    if (!Gate(outer, kDefaultUnrollFactor, &to_clone)) {
+      continue;
+    }
+
+    UnrollAndJam(outer, kDefaultUnrollFactor, to_clone);
+
+    MaybeRecordStat(MethodCompilationStat::kIntelLoopUnrolledAndJammed);
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop #" << outer->GetHeader()->GetBlockId()
+      << " of method " << GetMethodName(graph)
+      << " has been successfully unrolled and jammed by factor "
+      << kDefaultUnrollFactor);
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "End " << GetMethodName(graph));
+}
+
+bool HLoopUnrollAndJam::IsLoopControl(HInstruction* insn, HLoopInformation_X86* loop) {
+  if (insn->IsSuspendCheck() || insn->IsSuspend() || insn->IsTestSuspend() ||
+      insn->IsGoto() || insn->IsIf()) {
+    return true;
+  }
+  if (insn == loop->GetBasicIV()->GetLinearInsn()) {
+    return true;
+  }
+  // The condition of the loop branch.
+  return insn->IsCondition() &&
+         insn->HasOnlyOneNonEnvironmentUse() &&
+         insn->GetUses().front().GetUser()->IsIf();
+}
+
+HInstruction* HLoopUnrollAndJam::GetInsertionPoint(HBasicBlock* block) {
+  HInstruction* last = block->GetLastInstruction();
+  HInstruction* previous = last->GetPrevious();
+  // Keep the condition next to its branch.
+  if (last->IsIf() && previous != nullptr && previous == last->InputAt(0)) {
+    return previous;
+  }
+  return last;
+}
+
+bool HLoopUnrollAndJam::Gate(HLoopInformation_X86* outer,
+                             uint64_t unroll_factor,
+                             ArenaVector<HInstruction*>* to_clone) {
+  HLoopInformation_X86* inner = outer->GetInner();
+
+  if (inner == nullptr || !inner->IsInner() || inner->GetNextSibling() != nullptr) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop must contain exactly one inner loop.");
+    return false;
+  }
+
+  for (HLoopInformation_X86* loop : { outer, inner }) {
+    if (loop->IsOrHasIrreducibleLoop()) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Unroll-and-jam failed because the loop is irreducible.");
+      return false;
+    }
+    if (loop->HasTryCatchHandler()) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Found a try or catch handler inside the loop.");
+      return false;
+    }
+    if (!loop->HasOneExitEdge()) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Loop must have one exit edge.");
+      return false;
+    }
+    if (loop->GetBackEdges().size() > 1u) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Loop must have one back edge.");
+      return false;
+    }
+    // A constant trip count for the inner loop guarantees that the jammed
+    // outer iterations all run the same number of inner iterations.
+    if (!loop->HasKnownNumIterations()) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Loop must have a known number of iterations.");
+      return false;
+    }
+    HInductionVariable* biv = loop->GetBasicIV();
+    if (biv == nullptr || !biv->IsInteger()) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Loop must have an integer basic IV.");
+      return false;
+    }
+    // The only loop carried value must be the basic IV.
+    HBasicBlock* header = loop->GetHeader();
+    if (!header->GetPhis().HasExactlyOneElement() ||
+        header->GetFirstPhi() != biv->GetPhiInsn()) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Loop must have the basic IV as only phi.");
+      return false;
+    }
+  }
+
+  // A header and one body block: each jammed copy goes in the block of its original, in the
+  // straight-line order of the inner body.
+  if (inner->NumberOfBlocks() > 2) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Inner loop must have less than three basic blocks.");
+    return false;
+  }
+
+  HBasicBlock* pre_header = inner->GetPreHeader();
+  if (!outer->Contains(*pre_header) || !pre_header->GetLastInstruction()->IsGoto()) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Inner loop must have a pre-header inside the outer loop.");
+    return false;
+  }
+
+  // The body of the outer loop must run a multiple of unroll_factor times.
+  uint64_t num_iterations = outer->GetNumIterations(outer->GetHeader());
+  if (!outer->IsBottomTested()) {
+    num_iterations = (num_iterations == 0u) ? 0u : num_iterations - 1;
+  }
+  if (num_iterations < unroll_factor || num_iterations % unroll_factor != 0) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Outer loop iteration count (" << num_iterations
+      << ") is not a multiple of unroll factor " << unroll_factor);
+    return false;
+  }
+
+  // The outer IV must be "i = phi + step", where step can be scaled by the unroll factor.
+  HInductionVariable* biv = outer->GetBasicIV();
+  HInstruction* linear = biv->GetLinearInsn();
+  HPhi* phi = biv->GetPhiInsn();
+  int64_t new_step = biv->GetIncrement() * static_cast<int64_t>(unroll_factor);
+  if (!linear->IsAdd() ||
+      linear->GetType() != Primitive::kPrimInt ||
+      outer->PhiInput(phi, true) != linear ||
+      !IsInt<32>(new_step)) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Outer loop IV increment cannot be scaled.");
+    return false;
+  }
+  if (linear->HasEnvironmentUses()) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Outer loop IV increment has environment uses.");
+    return false;
+  }
+  for (const HUseListNode<HInstruction*>& use : linear->GetUses()) {
+    HInstruction* user = use.GetUser();
+    if (user != phi && !(outer->Contains(*user->GetBlock()) && IsLoopControl(user, outer))) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Outer loop IV increment is used by "
+        << user->DebugName());
+      return false;
+    }
+  }
+
+  uint64_t nb_jammed_instructions = unroll_factor * inner->CountInstructionsInBody(true);
+  if (nb_jammed_instructions > kDefaultMaxInstructionsJammed) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Number of jammed instructions ("
+      << nb_jammed_instructions << ") is too large (max: "
+      << kDefaultMaxInstructionsJammed << ")");
+    return false;
+  }
+
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  ArenaVector<HInstruction*> writes(graph->GetArena()->Adapter(kArenaAllocMisc));
+  for (HBlocksInLoopIterator it(*inner); !it.Done(); it.Advance()) {
+    for (HInstructionIterator insn_it(it.Current()->GetInstructions());
+         !insn_it.Done();
+         insn_it.Advance()) {
+      if (insn_it.Current()->DoesAnyWrite()) {
+        writes.push_back(insn_it.Current());
+      }
+    }
+  }
+
+  // Instructions depending on the outer IV, directly or not, differ between outer iterations.
+  ArenaSet<HInstruction*> variant(graph->GetArena()->Adapter(kArenaAllocMisc));
+  variant.insert(phi);
+
+  if (!CheckOuterBody(outer, writes, &variant, to_clone) ||
+      !CheckInnerBody(inner, writes, &variant, to_clone)) {
+    return false;
+  }
+
+  // Verify that the instructions can be all cloned by the instruction cloner.
+  HInstructionCloner instruction_verifier(graph, false);
+  for (HInstruction* insn : *to_clone) {
+    insn->Accept(&instruction_verifier);
+  }
+  if (!instruction_verifier.AllOkay()) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "The loop nest cannot be jammed"
+      " because of instruction: " << instruction_verifier.GetDebugNameForFailedClone());
+    return false;
+  }
+
+  return true;
+}
+
+bool HLoopUnrollAndJam::CheckOuterBody(HLoopInformation_X86* outer,
+                                       const ArenaVector<HInstruction*>& writes,
+                                       ArenaSet<HInstruction*>* variant,
+                                       ArenaVector<HInstruction*>* to_clone) {
+  HLoopInformation_X86* inner = outer->GetInner();
+  HBasicBlock* inner_header = inner->GetHeader();
+
+  for (HBlocksInLoopReversePostOrderIterator it(*outer); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    if (inner->Contains(*block)) {
+      continue;
+    }
+    if (block != outer->GetHeader() && !block->GetPhis().IsEmpty()) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Outer loop body must be straight-line code.");
+      return false;
+    }
+    bool before_inner = block->Dominates(inner_header);
+
+    for (HInstructionIterator insn_it(block->GetInstructions());
+         !insn_it.Done();
+         insn_it.Advance()) {
+      HInstruction* insn = insn_it.Current();
+      if (insn->IsIf() && !IsLoopExitBlock(block, outer)) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Outer loop body must be straight-line code.");
+        return false;
+      }
+      if (IsLoopControl(insn, outer)) {
+        continue;
+      }
+      // Only the code in front of the inner loop can be duplicated
+      // into the pre-header of the inner loop.
+      if (!before_inner) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Outer loop has " << insn->DebugName()
+          << " after the inner loop.");
+        return false;
+      }
+      if (insn->CanThrow() || insn->NeedsEnvironment() || insn->HasEnvironment() ||
+          alias_.HasSideEffects(insn)) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Outer loop instruction " << insn->DebugName()
+          << " cannot be duplicated.");
+        return false;
+      }
+      // The copies are executed before the inner loop of the previous outer
+      // iterations, so they must not read anything that loop writes.
+      for (HInstruction* write : writes) {
+        if (alias_.Alias(insn, write) != AliasCheck::kNoAlias) {
+          PRINT_PASS_OSTREAM_MESSAGE(this, "Outer loop instruction " << insn->DebugName()
+            << " may alias " << write->DebugName() << " of the inner loop.");
+          return false;
+        }
+      }
+      if (!AreUsesInLoop(insn, outer)) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, insn->DebugName() << " is used after the outer loop.");
+        return false;
+      }
+      if (HasInputIn(insn, *variant)) {
+        variant->insert(insn);
+        to_clone->push_back(insn);
+      }
+    }
+  }
+
+  return true;
+}
+
+bool HLoopUnrollAndJam::CheckInnerBody(HLoopInformation_X86* inner,
+                                       const ArenaVector<HInstruction*>& writes,
+                                       ArenaSet<HInstruction*>* variant,
+                                       ArenaVector<HInstruction*>* to_clone) {
+  HPhi* iv = inner->GetBasicIV()->GetPhiInsn();
+
+  for (HBlocksInLoopReversePostOrderIterator it(*inner); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator insn_it(block->GetInstructions());
+         !insn_it.Done();
+         insn_it.Advance()) {
+      HInstruction* insn = insn_it.Current();
+      if (insn->IsIf() && !IsLoopExitBlock(block, inner)) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Inner loop body must be straight-line code.");
+        return false;
+      }
+      if (IsLoopControl(insn, inner)) {
+        continue;
+      }
+      if (insn->CanThrow() || insn->NeedsEnvironment() || insn->HasEnvironment() ||
+          insn->IsMonitorOperation()) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Inner loop instruction " << insn->DebugName()
+          << " cannot be jammed.");
+        return false;
+      }
+      if (!AreUsesInLoop(insn, inner)) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, insn->DebugName() << " is used after the inner loop.");
+        return false;
+      }
+
+      // After jamming, the accesses of iteration j of all jammed outer iterations are
+      // done before iteration j + 1. Two array accesses indexed by the inner IV can only
+      // touch the same element in the same inner iteration, where the original order of
+      // the outer iterations is kept. Any other pair must be proven independent.
+      bool may_see_write = false;
+      if (insn->DoesAnyRead() || insn->DoesAnyWrite()) {
+        for (HInstruction* write : writes) {
+          if (alias_.Alias(insn, write) == AliasCheck::kNoAlias) {
+            continue;
+          }
+          if (!IsArrayAccessIndexedBy(insn, iv) || !IsArrayAccessIndexedBy(write, iv)) {
+            PRINT_PASS_OSTREAM_MESSAGE(this, "Inner loop instruction " << insn->DebugName()
+              << " may conflict with " << write->DebugName() << " across outer iterations.");
+            return false;
+          }
+          may_see_write = true;
+        }
+      }
+
+      // Writes are done once per outer iteration. Reads that may see one of them
+      // and values depending on the outer IV need a copy too. Anything else is
+      // shared between the jammed iterations.
+      if (insn->DoesAnyWrite() || may_see_write || HasInputIn(insn, *variant)) {
+        variant->insert(insn);
+        to_clone->push_back(insn);
+      }
+    }
+  }
+
+  return true;
+}
+
+void HLoopUnrollAndJam::UnrollAndJam(HLoopInformation_X86* outer,
+                                     uint64_t unroll_factor,
+                                     const ArenaVector<HInstruction*>& to_clone) {
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  ArenaAllocator* arena = graph->GetArena();
+  HLoopInformation_X86* inner = outer->GetInner();
+  HBasicBlock* pre_header = inner->GetPreHeader();
+  HInductionVariable* biv = outer->GetBasicIV();
+  HPhi* phi = biv->GetPhiInsn();
+  int32_t step = static_cast<int32_t>(biv->GetIncrement());
+
+  // Every copy is inserted after the previous ones, so iteration order is preserved.
+  for (uint64_t copy = 1; copy < unroll_factor; copy++) {
+    HInstruction* copy_iv = new (arena) HAdd(Primitive::kPrimInt,
+                                             phi,
+                                             graph->GetIntConstant(step * static_cast<int32_t>(copy)));
+    pre_header->InsertInstructionBefore(copy_iv, GetInsertionPoint(pre_header));
+
+    HInstructionCloner cloner(graph);
+    cloner.AddCloneManually(phi, copy_iv);
+
+    for (HInstruction* insn : to_clone) {
+      insn->Accept(&cloner);
+      HInstruction* clone = cloner.GetClone(insn);
+      DCHECK(clone != nullptr);
+      HBasicBlock* block = inner->Contains(*insn->GetBlock()) ? insn->GetBlock() : pre_header;
+      block->InsertInstructionBefore(clone, GetInsertionPoint(block));
+    }
+    DCHECK(cloner.AllOkay());
+  }
+
+  // Step the outer IV over the jammed iterations.
+  HInstruction* linear = biv->GetLinearInsn();
+  HConstant* increment = linear->AsAdd()->GetConstantRight();
+  size_t increment_index = (linear->InputAt(1) == increment) ? 1u : 0u;
+  linear->ReplaceInput(graph->GetIntConstant(step * static_cast<int32_t>(unroll_factor)),
+                       increment_index);
+}
+
+}  // namespace art
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2015 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_UNROLL_AND_JAM_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_UNROLL_AND_JAM_H_
+
+#include "ext_alias.h"
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+// Forward declaration.
+class HLoopInformation_X86;
+
+/**
+ * @brief Unroll-and-jam unrolls the outer loop of a two-level counted nest and fuses
+ * the resulting copies of the inner loop into a single inner loop.
+ * @details Each inner iteration then works on several consecutive outer iterations,
+ * which exposes the reuse of values that only depend on the inner induction variable
+ * (for instance b[j] in "c[i][j] = a[i][j] * b[j]") and gives the scheduler more
+ * independent work. The control flow is not modified: the inner body is duplicated
+ * in place and the outer induction variable is stepped by the unroll factor.
+ */
+class HLoopUnrollAndJam : public HOptimization_X86 {
+ public:
+  HLoopUnrollAndJam(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kHLoopUnrollAndJamPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    // The loop structure is left untouched, only the outer IV step changes.
+    return kAnalysisInductionVariables | kAnalysisLoopBounds;
+  }
+
+ private:
+  /**
+   * @brief Check whether the nest headed by outer can be unrolled and jammed.
+   * @details On success, the instructions that must be duplicated for each additional
+   * outer iteration are listed in to_clone, inputs before users.
+   * @param outer The outer loop of the nest.
+   * @param unroll_factor The number of outer iterations jammed together.
+   * @param to_clone The instructions to duplicate, filled by the method.
+   * @return Returns true if the transformation is legal and profitable.
+   */
+  bool Gate(HLoopInformation_X86* outer,
+            uint64_t unroll_factor,
+            ArenaVector<HInstruction*>* to_clone);
+
+  /**
+   * @brief Check the part of the outer loop that is not in the inner loop.
+   * @details It must only contain the outer loop control and instructions computed
+   * before entering the inner loop. The latter are added to to_clone when they
+   * depend on the outer basic IV.
+   * @return Returns true if the outer body is acceptable.
+   */
+  bool CheckOuterBody(HLoopInformation_X86* outer,
+                      const ArenaVector<HInstruction*>& writes,
+                      ArenaSet<HInstruction*>* variant,
+                      ArenaVector<HInstruction*>* to_clone);
+
+  /**
+   * @brief Check the inner loop body.
+   * @details It must only contain instructions that can be executed for several
+   * outer iterations in lock step. Those needing a copy are added to to_clone.
+   * @return Returns true if the inner body is acceptable.
+   */
+  bool CheckInnerBody(HLoopInformation_X86* inner,
+                      const ArenaVector<HInstruction*>& writes,
+                      ArenaSet<HInstruction*>* variant,
+                      ArenaVector<HInstruction*>* to_clone);
+
+  /**
+   * @brief Perform the transformation. Gate must have returned true before.
+   * @param outer The outer loop of the nest.
+   * @param unroll_factor The number of outer iterations jammed together.
+   * @param to_clone The instructions selected by Gate.
+   */
+  void UnrollAndJam(HLoopInformation_X86* outer,
+                    uint64_t unroll_factor,
+                    const ArenaVector<HInstruction*>& to_clone);
+
+  /**
+   * @brief Is the instruction part of the control of loop?
+   * @details That is the BIV increment, the exit condition, the branches and
+   * the suspend checks, none of which is duplicated.
+   */
+  static bool IsLoopControl(HInstruction* insn, HLoopInformation_X86* loop);
+
+  /**
+   * @brief Get the instruction before which the copies of block's instructions go.
+   */
+  static HInstruction* GetInsertionPoint(HBasicBlock* block);
+
+  AliasCheck alias_;
+
+  static constexpr const char* kHLoopUnrollAndJamPassName = "loop_unroll_and_jam";
+  static constexpr uint64_t kDefaultMaxInstructionsJammed = 120;
+  static constexpr uint64_t kDefaultUnrollFactor = 2;
+
+  DISALLOW_COPY_AND_ASSIGN(HLoopUnrollAndJam);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_UNROLL_AND_JAM_H_
@@ -35,20 +35,28 @@ void HLoopUnrollByFactor::Run() {
 
     HLoopPartialUnrolling loop_partial_unrolling(loop, this);
 
-    if (!Gate(&loop_partial_unrolling)) {
+    uint64_t unroll_factor = cost_model_.ChoosePartialUnrollFactor(loop);
+    if (unroll_factor < 2u) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Cost model (" << cost_model_.GetCoreKind()
+        << ") rejects unrolling of loop #" << loop->GetHeader()->GetBlockId());
       continue;
     }
 
-    if (!loop_partial_unrolling.PartialUnroll()) {
+    if (!Gate(&loop_partial_unrolling, unroll_factor)) {
+      continue;
+    }
+
+    if (!loop_partial_unrolling.PartialUnroll(unroll_factor)) {
       continue;
     }
 
     HBasicBlock* loop_header = loop->GetHeader();
-    MaybeRecordStat(MethodCompilationStat::kIntelLoopFullyUnrolled);
+    graph->AddCountedLoop(loop_header, GetPassName());
+    MaybeRecordStat(MethodCompilationStat::kIntelLoopPartiallyUnrolled);
     PRINT_PASS_OSTREAM_MESSAGE(this, "Loop #" << loop_header->GetBlockId()
       << " of method " << GetMethodName(graph)
       << " has been successfully partially unrolled by factor "
-      << kDefaultUnrollFactor);
+      << unroll_factor);
   }
 
   if (graph_updated) {
@@ -58,10 +66,12 @@ void HLoopUnrollByFactor::Run() {
   PRINT_PASS_OSTREAM_MESSAGE(this, "End " << GetMethodName(graph));
 }
 
-bool HLoopUnrollByFactor::Gate(HLoopPartialUnrolling* loop_partial_unrolling) const {
+bool HLoopUnrollByFactor::Gate(HLoopPartialUnrolling* loop_partial_unrolling,
+                               uint64_t unroll_factor) const {
   DCHECK(loop_partial_unrolling != nullptr);
 
-  if (!loop_partial_unrolling->Gate(kDefaultMaxInstructionsUnrolled, kDefaultUnrollFactor)) {
+  if (!loop_partial_unrolling->Gate(cost_model_.GetMaxPartiallyUnrolledInstructions(),
+                                    unroll_factor)) {
     return false;
   }
 
@@ -17,6 +17,7 @@
 #ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_UNROLL_BY_FACTOR_H_
 #define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_LOOP_UNROLL_BY_FACTOR_H_
 
+#include "loop_unroll_cost_model.h"
 #include "nodes.h"
 #include "optimization_x86.h"
 
@@ -26,27 +27,26 @@ namespace art {
 class HLoopPartialUnrolling;
 
 /**
- * @brief Full Unrolling is an optimization pass which copies the loop body a given amount
- * of times in order to remove the loop. It aims at optimizing the generated code by removing
- * the cost of the loop structure.
+ * @brief Partial Unrolling is an optimization pass which copies the loop body a given amount
+ * of times inside the loop. It aims at optimizing the generated code by reducing the cost
+ * of the loop structure. The factor is chosen per loop by HLoopUnrollCostModel.
  */
 class HLoopUnrollByFactor : public HOptimization_X86 {
  public:
-  HLoopUnrollByFactor(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
-    : HOptimization_X86(graph, kHLoopPartialUnrollingPassName, stats) {
-      // This default value is legacy from L. Is it still the best value now?
-      //DefineOption("MaxInstructionsUnrolled", OptionContent(60));
-      //DefineOption("Enabled", OptionContent(0));
-    }
+  HLoopUnrollByFactor(HGraph* graph,
+                      const InstructionSetFeatures* features,
+                      OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kHLoopPartialUnrollingPassName, stats),
+      cost_model_(features) {}
 
   void Run() OVERRIDE;
 
  private:
-  bool Gate(HLoopPartialUnrolling* loop_partial_unrolling) const;
+  bool Gate(HLoopPartialUnrolling* loop_partial_unrolling, uint64_t unroll_factor) const;
 
   static constexpr const char* kHLoopPartialUnrollingPassName = "loop_partial_unrolling";
-  static constexpr int64_t kDefaultMaxInstructionsUnrolled = 120;
-  static constexpr int64_t kDefaultUnrollFactor=2;
+
+  const HLoopUnrollCostModel cost_model_;
 
   DISALLOW_COPY_AND_ASSIGN(HLoopUnrollByFactor);
 };
@@ -21,18 +21,176 @@
  */
 #include "non_temporal_move.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+#include "arch/instruction_set_features.h"
 #include "ext_utility.h"
+#include "find_ivs.h"
 #include "graph_x86.h"
 #include "induction_variable.h"
 #include "loop_formation.h"
 #include "loop_iterators.h"
+#include "loop_unroll_cost_model.h"
+#include "loop_versioning.h"
+#include "runtime.h"
 
 namespace art {
 
+HNonTemporalMove::HNonTemporalMove(HGraph* graph,
+                                   const InstructionSetFeatures* features,
+                                   OptimizingCompilerStats* stats)
+    : HOptimization_X86(graph, kNonTemporalMovePassName, stats),
+      last_level_cache_size_(GetLastLevelCacheSize(features)) {}
+
+#if defined(__i386__) || defined(__x86_64__)
+// Walk the deterministic cache parameters leaf and return the size of the data or
+// unified cache of the highest level, 0 if this is not supported.
+static size_t ReadLastLevelCacheSize() {
+  constexpr unsigned int kCacheParametersLeaf = 4u;
+  if (__get_cpuid_max(0u, nullptr) < kCacheParametersLeaf) {
+    return 0u;
+  }
+
+  size_t size = 0u;
+  unsigned int max_level = 0u;
+  for (unsigned int subleaf = 0u; ; subleaf++) {
+    unsigned int eax, ebx, ecx, edx;
+    __cpuid_count(kCacheParametersLeaf, subleaf, eax, ebx, ecx, edx);
+    unsigned int type = eax & 0x1fu;
+    if (type == 0u) {
+      // No more caches.
+      break;
+    }
+    unsigned int level = (eax >> 5) & 0x7u;
+    // Skip the instruction caches.
+    if (type == 2u || level < max_level) {
+      continue;
+    }
+    size_t ways = ((ebx >> 22) & 0x3ffu) + 1u;
+    size_t partitions = ((ebx >> 12) & 0x3ffu) + 1u;
+    size_t line_size = (ebx & 0xfffu) + 1u;
+    size_t sets = static_cast<size_t>(ecx) + 1u;
+    size = ways * partitions * line_size * sets;
+    max_level = level;
+  }
+  return size;
+}
+
+// Read the ERMSB bit of the structured extended feature flags leaf.
+static bool ReadEnhancedRepMovsb() {
+  constexpr unsigned int kExtendedFeaturesLeaf = 7u;
+  constexpr unsigned int kErmsbBit = 1u << 9;
+  if (__get_cpuid_max(0u, nullptr) < kExtendedFeaturesLeaf) {
+    return false;
+  }
+  unsigned int eax, ebx, ecx, edx;
+  __cpuid_count(kExtendedFeaturesLeaf, 0u, eax, ebx, ecx, edx);
+  return (ebx & kErmsbBit) != 0u;
+}
+#endif
+
+size_t HNonTemporalMove::GetLastLevelCacheSize(const InstructionSetFeatures* features) {
+  if (features == nullptr) {
+    return kDefaultLastLevelCacheSize;
+  }
+  InstructionSet isa = features->GetInstructionSet();
+  if (isa != kX86 && isa != kX86_64) {
+    return kDefaultLastLevelCacheSize;
+  }
+
+#if defined(__i386__) || defined(__x86_64__)
+  // The JIT compiles for the CPU it runs on.
+  Runtime* runtime = Runtime::Current();
+  if (runtime != nullptr && !runtime->IsAotCompiler() && isa == kRuntimeISA) {
+    size_t size = ReadLastLevelCacheSize();
+    if (size != 0u) {
+      return size;
+    }
+  }
+#endif
+
+  switch (HLoopUnrollCostModel(features).GetCoreKind()) {
+    case HLoopUnrollCostModel::kCoreAtom:
+      return kAtomLastLevelCacheSize;
+    case HLoopUnrollCostModel::kCoreBig:
+      return kBigCoreLastLevelCacheSize;
+    default:
+      return kDefaultLastLevelCacheSize;
+  }
+}
+
+bool HNonTemporalMove::HasEnhancedRepMovsb(const InstructionSetFeatures* features) {
+  if (features == nullptr) {
+    return false;
+  }
+  InstructionSet isa = features->GetInstructionSet();
+  if (isa != kX86 && isa != kX86_64) {
+    return false;
+  }
+
+#if defined(__i386__) || defined(__x86_64__)
+  Runtime* runtime = Runtime::Current();
+  if (runtime != nullptr && !runtime->IsAotCompiler() && isa == kRuntimeISA) {
+    return ReadEnhancedRepMovsb();
+  }
+#endif
+
+  return HLoopUnrollCostModel(features).GetCoreKind() != HLoopUnrollCostModel::kCoreGeneric;
+}
+
+int64_t HNonTemporalMove::GetMinNonTemporalIterations(const ArraySets& array_sets) const {
+  size_t bytes_per_iteration = 0u;
+  for (HArraySet* array_set : array_sets) {
+    bytes_per_iteration += Primitive::ComponentSize(array_set->GetComponentType());
+  }
+  DCHECK_NE(bytes_per_iteration, 0u);
+  return static_cast<int64_t>(last_level_cache_size_ / bytes_per_iteration);
+}
+
+bool HNonTemporalMove::UseNonTemporalMoves(HLoopInformation_X86* loop_info,
+                                           const ArraySets& array_sets) {
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+
+  // Mark all the ArraySets as 'non_temporal_move'.
+  DCHECK_GT(array_sets.size(), 0u);
+  for (auto array_set : array_sets) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Add non-temporal to " << array_set);
+    array_set->SetUseNonTemporalMove();
+  }
+  MaybeRecordStat(MethodCompilationStat::kIntelNonTemporalMove, array_sets.size());
+  graph->AddCountedLoop(loop_info->GetHeader(), GetPassName());
+
+  // Add the needed barrier to the exit.
+  HBasicBlock* exit_block = loop_info->GetExitBlock();
+  CHECK(exit_block);
+  HMemoryBarrier* mb = new (graph->GetArena()) HMemoryBarrier(MemBarrierKind::kAnyAny);
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Add memory barrier to exit block");
+  exit_block->InsertInstructionBefore(mb, exit_block->GetFirstInstruction());
+
+  // Add the needed barrier to suspend block if needed.
+  if (loop_info->HasSuspendCheck() || loop_info->HasTestSuspend()) {
+    mb = new (graph->GetArena()) HMemoryBarrier(MemBarrierKind::kAnyAny);
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Add memory barrier to suspend block");
+    return loop_info->InsertInstructionInSuspendBlock(mb);
+  }
+  return false;
+}
+
 void HNonTemporalMove::Run() {
   HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
   HLoopInformation_X86* graph_loop_info = graph->GetLoopInformation();
-  PRINT_PASS_OSTREAM_MESSAGE(this, "Begin: " << GetMethodName(graph_));
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Begin: " << GetMethodName(graph_)
+                                   << ", LLC size " << last_level_cache_size_);
+
+  struct DynamicCandidate {
+    HBasicBlock* header;
+    HInstruction* start;
+    HInstruction* end;
+    int64_t min_iterations;
+  };
+  std::vector<DynamicCandidate> dynamic_candidates;
 
   // Walk all the inner loops in the graph.
   bool graph_updated = false;
@@ -40,65 +198,140 @@ void HNonTemporalMove::Run() {
     HLoopInformation_X86* loop_info = it.Current();
     PRINT_PASS_OSTREAM_MESSAGE(this, "Visit " << loop_info->GetHeader()->GetBlockId());
     ArraySets array_sets;
-    if (!Gate(loop_info, array_sets)) {
+    HInstruction* start = nullptr;
+    HInstruction* end = nullptr;
+    if (!Gate(loop_info, array_sets, &start, &end)) {
       // Debug message printed in Gate().
       continue;
     }
 
-    // Mark all the ArraySets as 'non_temporal_move'.
-    DCHECK_GT(array_sets.size(), 0u);
-    for (auto array_set : array_sets) {
-      PRINT_PASS_OSTREAM_MESSAGE(this, "Add non-temporal to " << array_set);
-      array_set->SetUseNonTemporalMove();
-    }
-    MaybeRecordStat(MethodCompilationStat::kIntelNonTemporalMove, array_sets.size());
-
-    // Add the needed barrier to the exit.
-    HBasicBlock* exit_block = loop_info->GetExitBlock();
-    CHECK(exit_block);
-    HMemoryBarrier* mb = new (graph->GetArena()) HMemoryBarrier(MemBarrierKind::kAnyAny);
-    PRINT_PASS_OSTREAM_MESSAGE(this, "Add memory barrier to exit block");
-    exit_block->InsertInstructionBefore(mb, exit_block->GetFirstInstruction());
-
-    // Add the needed barrier to suspend block if needed.
-    if (loop_info->HasSuspendCheck() || loop_info->HasTestSuspend()) {
-      mb = new (graph->GetArena()) HMemoryBarrier(MemBarrierKind::kAnyAny);
-      PRINT_PASS_OSTREAM_MESSAGE(this, "Add memory barrier to suspend block");
-      graph_updated |= loop_info->InsertInstructionInSuspendBlock(mb);
+    if (start != nullptr) {
+      // Versioning rebuilds the loops, so it is done once the walk is over.
+      dynamic_candidates.push_back({ loop_info->GetHeader(), start, end,
+                                     GetMinNonTemporalIterations(array_sets) });
+      continue;
     }
+
+    graph_updated |= UseNonTemporalMoves(loop_info, array_sets);
   }
 
   if (graph_updated) {
     // Only rebuild the dominators if we added a new node for a suspend.
     graph->RebuildDomination();
+    graph_updated = false;
+  }
+
+  bool versioned = false;
+  for (const DynamicCandidate& candidate : dynamic_candidates) {
+    HLoopInformation_X86* loop_info =
+        LOOPINFO_TO_LOOPINFO_X86(candidate.header->GetLoopInformation());
+    HLoopVersioning versioning(loop_info, this);
+    versioning.AddMinimumIterationsCheck(candidate.start, candidate.end,
+                                         candidate.min_iterations);
+    if (loop_info->HasTestSuspend() || !versioning.Gate()) {
+      continue;
+    }
+
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Version loop " << candidate.header->GetBlockId()
+                                     << " on at least " << candidate.min_iterations
+                                     << " iterations");
+    HBasicBlock* fast_header = versioning.Version();
+    // The original loop is the slow path, count it to see how often the check fails.
+    graph->AddCountedLoop(candidate.header, kNonTemporalMoveSlowPathName);
+    HLoopInformation_X86* fast_loop =
+        LOOPINFO_TO_LOOPINFO_X86(fast_header->GetLoopInformation());
+
+    // The copy passed the same Gate as the original loop.
+    ArraySets array_sets;
+    for (HBlocksInLoopIterator it_loop(*fast_loop); !it_loop.Done(); it_loop.Advance()) {
+      HBasicBlock* loop_block = it_loop.Current();
+      for (HInstructionIterator inst_it(loop_block->GetInstructions());
+           !inst_it.Done();
+           inst_it.Advance()) {
+        if (inst_it.Current()->IsArraySet()) {
+          array_sets.insert(inst_it.Current()->AsArraySet());
+        }
+      }
+    }
+    graph_updated |= UseNonTemporalMoves(fast_loop, array_sets);
+    MaybeRecordStat(MethodCompilationStat::kIntelLoopVersioned);
+    versioned = true;
+  }
+
+  if (graph_updated) {
+    graph->RebuildDomination();
+  }
+
+  if (versioned) {
+    // Later passes expect the loop hierarchy and induction variables to be up to date.
+    HLoopFormation form_loops(graph_);
+    form_loops.Run();
+    HFindInductionVariables find_ivs(graph_, "find_ivs_after_versioning", stats_);
+    find_ivs.Run();
   }
 }
 
-bool HNonTemporalMove::Gate(HLoopInformation_X86* loop_info, ArraySets& array_sets) {
-  // This must be a countable loop.
-  if (!loop_info->HasKnownNumIterations()) {
-    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop is not countable");
+bool HNonTemporalMove::FindDynamicBounds(HLoopInformation_X86* loop_info,
+                                         HInductionVariable* iv,
+                                         HInstruction** start,
+                                         HInstruction** end) {
+  HBasicBlock* exit_block = loop_info->GetExitBlock();
+  if (exit_block == nullptr) {
     return false;
   }
 
-  // The number of iterations must be large enough.
-  if (loop_info->GetNumIterations(loop_info->GetHeader()) < kMinNonTemporalIterations) {
-    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop has " << loop_info->GetNumIterations(loop_info->GetHeader())
-                                     << " iterations; needs at least "
-                                     << kMinNonTemporalIterations);
+  HInstruction* branch = exit_block->GetPredecessors()[0]->GetLastInstruction();
+  if (!branch->IsIf() || !branch->InputAt(0)->IsCondition()) {
     return false;
   }
+  HCondition* condition = branch->InputAt(0)->AsCondition();
+  IfCondition comparison = condition->GetCondition();
 
-  // The loop must be a simple count up loop.
-  const HLoopBoundInformation& bound_info = loop_info->GetBoundInformation();
-  if (!bound_info.is_simple_count_up_) {
-    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop is not a simple count up loop");
+  // The exit test is either on the phi, or on its increment for bottom tested loops.
+  HInstruction* phi = iv->GetPhiInsn();
+  HInstruction* linear = iv->GetLinearInsn();
+  HInstruction* bound = nullptr;
+  if (condition->InputAt(0) == phi || condition->InputAt(0) == linear) {
+    bound = condition->InputAt(1);
+  } else if (condition->InputAt(1) == phi || condition->InputAt(1) == linear) {
+    bound = condition->InputAt(0);
+    comparison = FlipConditionForOperandSwap(comparison);
+  } else {
     return false;
   }
 
+  if (branch->AsIf()->IfTrueSuccessor() == exit_block) {
+    comparison = NegateCondition(comparison);
+  }
+
+  // An off by one on the trip count does not matter for a threshold.
+  if (comparison != kCondLT && comparison != kCondLE) {
+    return false;
+  }
+
+  HInstruction* entry = loop_info->PhiInput(phi->AsPhi(), false);
+  if (loop_info->Contains(*bound->GetBlock()) ||
+      entry->GetType() != bound->GetType() ||
+      !Primitive::IsIntOrLongType(bound->GetType())) {
+    return false;
+  }
+
+  *start = entry;
+  *end = bound;
+  return true;
+}
+
+bool HNonTemporalMove::Gate(HLoopInformation_X86* loop_info,
+                            ArraySets& array_sets,
+                            HInstruction** start,
+                            HInstruction** end) {
   // The IV increment must be 1.
+  const HLoopBoundInformation& bound_info = loop_info->GetBoundInformation();
   HInductionVariable* iv = bound_info.loop_biv_;
-  DCHECK(iv != nullptr);
+  if (iv == nullptr) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop has no basic IV");
+    return false;
+  }
   if (!iv->IsBasicAndIncrementOf1()) {
     PRINT_PASS_OSTREAM_MESSAGE(this, "Not a basic IV with increment 1");
     return false;
@@ -189,8 +422,37 @@ bool HNonTemporalMove::Gate(HLoopInformation_X86* loop_info, ArraySets& array_se
     }
   }
 
-  // Everything is copacetic.  Was there anything found?
-  return array_sets.size() > 0;
+  // Was there anything found?
+  if (array_sets.empty()) {
+    return false;
+  }
+
+  // The number of iterations must be large enough for the stores to overflow the cache.
+  int64_t min_iterations = GetMinNonTemporalIterations(array_sets);
+  if (loop_info->HasKnownNumIterations()) {
+    // The loop must be a simple count up loop.
+    if (!bound_info.is_simple_count_up_) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Loop is not a simple count up loop");
+      return false;
+    }
+
+    int64_t num_iterations = loop_info->GetNumIterations(loop_info->GetHeader());
+    if (num_iterations < min_iterations) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Loop has " << num_iterations
+                                       << " iterations; needs at least " << min_iterations);
+      return false;
+    }
+    return true;
+  }
+
+  // Otherwise the trip count is checked at runtime.
+  if (!FindDynamicBounds(loop_info, iv, start, end)) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop is not countable");
+    return false;
+  }
+
+  // Everything is copacetic.
+  return true;
 }
 
 }  // namespace art
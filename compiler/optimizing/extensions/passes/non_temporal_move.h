@@ -28,18 +28,54 @@
 namespace art {
 
 class DexCompilationUnit;
+class HInductionVariable;
+class InstructionSetFeatures;
 
+/**
+ * @brief Use non-temporal stores in loops writing more data than the last level cache holds.
+ * @details Such stores would only evict useful lines. Loops with a trip count unknown at
+ * compile time are versioned on it, so that the non-temporal version only runs when
+ * the threshold is reached.
+ */
 class HNonTemporalMove : public HOptimization_X86 {
  public:
-  explicit HNonTemporalMove(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
-      : HOptimization_X86(graph, kNonTemporalMovePassName, stats) {}
+  HNonTemporalMove(HGraph* graph,
+                   const InstructionSetFeatures* features,
+                   OptimizingCompilerStats* stats = nullptr);
 
   void Run() OVERRIDE;
 
-  static constexpr int kMinNonTemporalIterations = 131072;
+  /**
+   * @brief Get the number of iterations from which the loop writes more than the cache holds.
+   * @param array_sets The ArraySets executed once per iteration.
+   */
+  int64_t GetMinNonTemporalIterations(const std::set<HArraySet*>& array_sets) const;
+
+  /**
+   * @brief Get the size of the last level cache of the target, in bytes.
+   * @details When compiling for the running CPU, it is queried with cpuid. Otherwise
+   * it is guessed from the instruction set features.
+   */
+  static size_t GetLastLevelCacheSize(const InstructionSetFeatures* features);
+
+  /**
+   * @brief Does the target have the enhanced rep movsb (ERMSB), faster than the other
+   * sequences for the copies of medium size?
+   * @details Queried with cpuid like the cache size. Otherwise, all the cores known
+   * to the cost model have it.
+   */
+  static bool HasEnhancedRepMovsb(const InstructionSetFeatures* features);
 
  private:
   static constexpr const char* kNonTemporalMovePassName = "non_temporal_move";
+  // Records the slow path of a versioned loop for HLoopCounters.
+  static constexpr const char* kNonTemporalMoveSlowPathName = "non_temporal_move$slow";
+
+  // Used when nothing is known about the target. This keeps the old threshold of
+  // 131072 iterations for the loops storing to one int array.
+  static constexpr size_t kDefaultLastLevelCacheSize = 512 * KB;
+  static constexpr size_t kAtomLastLevelCacheSize = 1 * MB;
+  static constexpr size_t kBigCoreLastLevelCacheSize = 8 * MB;
 
   typedef std::set<HArraySet*> ArraySets;
 
@@ -47,9 +83,32 @@ class HNonTemporalMove : public HOptimization_X86 {
    * @brief Is this loop a candidate for non-temporal-move replacement?
    * @param loop_info Candidate loop information.
    * @param array_sets ArraySet instructions found in the loop are added to array_sets.
+   * @param start Set to the IV start value when the trip count must be checked at runtime.
+   * @param end Set to the IV end value when the trip count must be checked at runtime.
    * @returns 'true' if the loop should use non-temporal moves.
    */
-  bool Gate(HLoopInformation_X86* loop_info, ArraySets& array_sets);
+  bool Gate(HLoopInformation_X86* loop_info,
+            ArraySets& array_sets,
+            HInstruction** start,
+            HInstruction** end);
+
+  /*
+   * @brief Find the values between which the IV of a loop with an unknown trip count goes.
+   * @details Only 'for (i = start; i < end; i++)' loops with end invariant are accepted.
+   * @returns 'true' if start and end were found.
+   */
+  bool FindDynamicBounds(HLoopInformation_X86* loop_info,
+                         HInductionVariable* iv,
+                         HInstruction** start,
+                         HInstruction** end);
+
+  /*
+   * @brief Mark the ArraySets and add the barriers the non-temporal moves need.
+   * @returns 'true' if a block was added for the suspend check.
+   */
+  bool UseNonTemporalMoves(HLoopInformation_X86* loop_info, const ArraySets& array_sets);
+
+  const size_t last_level_cache_size_;
 
   DISALLOW_COPY_AND_ASSIGN(HNonTemporalMove);
 };
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "partial_redundancy_elimination.h"
+
+#include "cloning.h"
+#include "ext_utility.h"
+#include "graph_x86.h"
+#include "gvn.h"
+#include "loop_iterators.h"
+#include "side_effects_analysis.h"
+
+namespace art {
+
+// Can instruction be computed on an edge where it was not, without changing the behavior?
+static bool IsMovableComputation(HInstruction* instruction) {
+  switch (instruction->GetKind()) {
+    case HInstruction::kAdd:
+    case HInstruction::kAnd:
+    case HInstruction::kDiv:
+    case HInstruction::kMul:
+    case HInstruction::kNeg:
+    case HInstruction::kNot:
+    case HInstruction::kOr:
+    case HInstruction::kRem:
+    case HInstruction::kRor:
+    case HInstruction::kShl:
+    case HInstruction::kShr:
+    case HInstruction::kSub:
+    case HInstruction::kTypeConversion:
+    case HInstruction::kUShr:
+    case HInstruction::kXor:
+      break;
+    default:
+      return false;
+  }
+
+  switch (instruction->GetType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      break;
+    default:
+      return false;
+  }
+
+  return !instruction->CanThrow() &&
+         !instruction->HasEnvironment() &&
+         instruction->GetSideEffects().DoesNothing();
+}
+
+// Find an instruction of the graph equal to value, available at the end of block.
+static HInstruction* FindAvailable(HInstruction* value, HBasicBlock* block) {
+  for (HInstruction* input : value->GetInputs()) {
+    if (input->IsConstant()) {
+      continue;
+    }
+    // An instruction equal to value is a user of each of its inputs.
+    for (const HUseListNode<HInstruction*>& use : input->GetUses()) {
+      HInstruction* user = use.GetUser();
+      if (user->GetKind() == value->GetKind() &&
+          user->Equals(value) &&
+          user->GetBlock()->Dominates(block)) {
+        return user;
+      }
+    }
+    return nullptr;
+  }
+  // Constant folding takes care of the computations of constants.
+  return nullptr;
+}
+
+bool HPartialRedundancyElimination::EliminatePartialRedundancy(HInstruction* instruction) {
+  HBasicBlock* block = instruction->GetBlock();
+
+  // The value differs on each edge only through the phis of block. The other inputs are
+  // defined in a dominator of block, available in all the predecessors.
+  bool has_phi_input = false;
+  for (HInstruction* input : instruction->GetInputs()) {
+    if (input->GetBlock() == block) {
+      if (!input->IsPhi()) {
+        return false;
+      }
+      has_phi_input = true;
+    }
+  }
+  if (!has_phi_input) {
+    // Fully redundant or loop invariant, left to value numbering and LICM.
+    return false;
+  }
+
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  ArenaAllocator* arena = graph->GetArena();
+  HLoopInformation* loop = block->IsLoopHeader() ? block->GetLoopInformation() : nullptr;
+  const ArenaVector<HBasicBlock*>& predecessors = block->GetPredecessors();
+  ArenaVector<HInstruction*> values(predecessors.size(),
+                                    nullptr,
+                                    arena->Adapter(kArenaAllocOptimization));
+  size_t num_available = 0u;
+  for (size_t i = 0u; i < predecessors.size(); i++) {
+    HBasicBlock* predecessor = predecessors[i];
+
+    // The value on the edge from predecessor, with the phis translated to their input.
+    HInstructionCloner cloner(graph);
+    for (HInstruction* input : instruction->GetInputs()) {
+      if (input->GetBlock() == block) {
+        cloner.AddOrUpdateCloneManually(input, input->InputAt(i));
+      }
+    }
+    instruction->Accept(&cloner);
+    HInstruction* value = cloner.GetClone(instruction);
+    DCHECK(value != nullptr);
+
+    HInstruction* available = FindAvailable(value, predecessor);
+    if (available == instruction) {
+      // A phi of block merging itself, left to the phi cleanup.
+      return false;
+    } else if (available != nullptr) {
+      values[i] = available;
+      num_available++;
+    } else if (predecessor->GetSuccessors().size() != 1u ||
+               (loop != nullptr && predecessor != loop->GetPreHeader())) {
+      // A copy on a critical edge would also be computed on the other paths, and a copy on
+      // a back edge would still be computed at each iteration.
+      return false;
+    } else {
+      // The value is not in the graph yet, it is inserted on this edge.
+      values[i] = value;
+    }
+  }
+
+  if (num_available == 0u) {
+    // Moving the computation to all the edges only grows the code.
+    return false;
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Replacing " << instruction << " of block "
+                                   << block->GetBlockId() << " by a phi");
+  HPhi* phi = new (arena) HPhi(arena, kNoRegNumber, 0, instruction->GetType());
+  block->AddPhi(phi);
+  for (size_t i = 0u; i < predecessors.size(); i++) {
+    HInstruction* value = values[i];
+    if (value->GetBlock() == nullptr) {
+      HBasicBlock* predecessor = predecessors[i];
+      predecessor->InsertInstructionBefore(value, predecessor->GetLastInstruction());
+    }
+    phi->AddInput(value);
+  }
+  instruction->ReplaceWith(phi);
+  block->RemoveInstruction(instruction);
+  MaybeRecordStat(MethodCompilationStat::kIntelPartialRedundancyEliminated);
+  return true;
+}
+
+void HPartialRedundancyElimination::EliminatePartialRedundancies(HBasicBlock* block) {
+  if (block->GetPredecessors().size() < 2u ||
+      block->IsCatchBlock() ||
+      (block->IsLoopHeader() && block->GetLoopInformation()->IsIrreducible())) {
+    return;
+  }
+
+  for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* instruction = it.Current();
+    if (IsMovableComputation(instruction)) {
+      EliminatePartialRedundancy(instruction);
+    }
+  }
+}
+
+bool HPartialRedundancyElimination::HasDuplicatedLoopCode() const {
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  for (HOutToInLoopIterator it(graph->GetLoopInformation()); !it.Done(); it.Advance()) {
+    HLoopInformation_X86* loop = it.Current();
+    DCHECK(loop != nullptr);  // Paranoid.
+    if (loop->IsBottomTested() || loop->HasBeenPeeled()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void HPartialRedundancyElimination::Run() {
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Begin: " << GetMethodName(graph));
+
+  // The copies of the rotated and peeled loops are fully redundant.
+  if (HasDuplicatedLoopCode()) {
+    SideEffectsAnalysis side_effects(graph_);
+    side_effects.Run();
+    GVNOptimization gvn(graph_, side_effects);
+    gvn.Run();
+  }
+
+  // In reverse post order, an instruction moved to a predecessor already had its own
+  // partial redundancies removed, and a phi created in a block may make the later
+  // instructions of the block partially redundant in turn.
+  for (HBasicBlock* block : graph->GetReversePostOrder()) {
+    EliminatePartialRedundancies(block);
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "End: " << GetMethodName(graph));
+}
+
+}  // namespace art
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_PARTIAL_REDUNDANCY_ELIMINATION_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_PARTIAL_REDUNDANCY_ELIMINATION_H_
+
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+/**
+ * @brief Remove the redundant computations left by the loop transformations duplicating
+ * code, FormBottomLoops and LoopPeeling, in a single pass.
+ * @details The fully redundant computations are removed by value numbering. A computation
+ * of a merge block that is also computed on some of the incoming paths is partially
+ * redundant: it is computed on the other incoming edges instead, and merged by a phi.
+ * The operands of the computation that are phis of the merge block are translated to
+ * their value on each edge. For a loop header, a value computed by the previous
+ * iteration is reused, and the computation is only placed in the pre-header.
+ * Only pure computations are moved, and never onto a path that did not compute them: no
+ * path computes more than before.
+ */
+class HPartialRedundancyElimination : public HOptimization_X86 {
+ public:
+  explicit HPartialRedundancyElimination(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kPartialRedundancyEliminationPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+ private:
+  /**
+   * @brief Did a transformation duplicate code of the loops, which value numbering removes?
+   */
+  bool HasDuplicatedLoopCode() const;
+
+  /**
+   * @brief Remove the partial redundancies of the computations of block.
+   */
+  void EliminatePartialRedundancies(HBasicBlock* block);
+
+  /**
+   * @brief Replace instruction, computed in the predecessors of its block where it is
+   * available, by a phi.
+   * @return true if instruction was replaced.
+   */
+  bool EliminatePartialRedundancy(HInstruction* instruction);
+
+  static constexpr const char* kPartialRedundancyEliminationPassName =
+      "partial_redundancy_elimination";
+
+  DISALLOW_COPY_AND_ASSIGN(HPartialRedundancyElimination);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_PARTIAL_REDUNDANCY_ELIMINATION_H_
@@ -117,6 +117,7 @@ void HLoopPeeling::Run() {
     if (ShouldPeel(inner_loop)) {
       if (inner_loop->IsPeelable(this)) {
         inner_loop->PeelHead(this);
+        GRAPH_TO_GRAPH_X86(graph_)->AddCountedLoop(inner_loop->GetHeader(), GetPassName());
         PRINT_PASS_OSTREAM_MESSAGE(this, "Successfully peeled loop with header block " <<
                                          inner_loop->GetHeader()->GetBlockId() << '.');
         MaybeRecordStat(MethodCompilationStat::kIntelLoopPeeled);
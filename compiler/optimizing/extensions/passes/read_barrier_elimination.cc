@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "read_barrier_elimination.h"
+
+#include "ext_utility.h"
+#include "find_ivs.h"
+#include "graph_x86.h"
+#include "loop_formation.h"
+#include "loop_iterators.h"
+#include "loop_versioning.h"
+
+namespace art {
+
+static bool IsReferenceLoad(HInstruction* insn) {
+  return (insn->IsInstanceFieldGet() || insn->IsArrayGet()) &&
+         insn->GetType() == Primitive::kPrimNot;
+}
+
+// Does insn only call the runtime to leave the method, throwing or deoptimizing?
+static bool LeavesMethodFromRuntime(HInstruction* insn) {
+  return insn->IsNullCheck() ||
+         insn->IsBoundsCheck() ||
+         insn->IsX86BoundsCheckMemory() ||
+         insn->IsDivZeroCheck() ||
+         insn->IsDeoptimize();
+}
+
+bool HReadBarrierElimination::CanVersion(HLoopInformation_X86* loop) const {
+  size_t num_loads = 0;
+  for (HBlocksInLoopIterator it_loop(*loop); !it_loop.Done(); it_loop.Advance()) {
+    HBasicBlock* block = it_loop.Current();
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* insn = it.Current();
+      if (IsReferenceLoad(insn)) {
+        num_loads++;
+      } else if (insn->IsSuspendCheck() || insn->IsSuspend()) {
+        // The fast version deoptimizes there, with the environment of the suspension.
+        if (!insn->HasEnvironment()) {
+          PRINT_PASS_OSTREAM_MESSAGE(this, "Suspend point " << insn->GetId()
+                                           << " has no environment");
+          return false;
+        }
+      } else if (insn->IsInvoke() ||
+                 (insn->GetSideEffects().Includes(SideEffects::CanTriggerGC()) &&
+                  !LeavesMethodFromRuntime(insn))) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Loop " << loop->GetHeader()->GetBlockId()
+                                         << " has the GC point " << insn->DebugName()
+                                         << " " << insn->GetId());
+        return false;
+      }
+    }
+  }
+
+  if (num_loads < kMinReferenceLoads) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop " << loop->GetHeader()->GetBlockId()
+                                     << " only has " << num_loads << " reference loads");
+    return false;
+  }
+  return true;
+}
+
+void HReadBarrierElimination::ElideReadBarriers(HLoopInformation_X86* loop) {
+  ArenaAllocator* arena = graph_->GetArena();
+  for (HBlocksInLoopIterator it_loop(*loop); !it_loop.Done(); it_loop.Advance()) {
+    HBasicBlock* block = it_loop.Current();
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* insn = it.Current();
+      if (IsReferenceLoad(insn)) {
+        if (insn->IsInstanceFieldGet()) {
+          insn->AsInstanceFieldGet()->ElideReadBarrier();
+        } else {
+          insn->AsArrayGet()->ElideReadBarrier();
+        }
+      } else if (insn->IsSuspendCheck() || insn->IsSuspend()) {
+        // The collector may have started marking while the thread was suspended: resume
+        // in the interpreter, at the suspend point.
+        uint32_t dex_pc = insn->GetDexPc();
+        HInstruction* cursor = insn->GetNext();
+        HInstruction* is_marking = new (arena) HX86IsGcMarking(dex_pc);
+        block->InsertInstructionBefore(is_marking, cursor);
+        HInstruction* condition =
+            new (arena) HNotEqual(is_marking, graph_->GetIntConstant(0), dex_pc);
+        block->InsertInstructionBefore(condition, cursor);
+        HDeoptimize* deoptimize = new (arena) HDeoptimize(
+            arena, condition, DeoptimizationKind::kGcMarking, dex_pc);
+        block->InsertInstructionBefore(deoptimize, cursor);
+        deoptimize->CopyEnvironmentFrom(insn->GetEnvironment());
+      }
+    }
+  }
+}
+
+void HReadBarrierElimination::Run() {
+  if (!kEmitCompilerReadBarrier || !kUseBakerReadBarrier || graph_->IsDebuggable()) {
+    // Only the Baker read barriers have a fast path to remove.
+    return;
+  }
+
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Begin: " << GetMethodName(graph));
+
+  HLoopFormation formation(graph_);
+  formation.Run();
+
+  ArenaVector<HBasicBlock*> fast_headers = HLoopVersioning::VersionInnerLoops(
+      graph, this, [this](HLoopInformation_X86* loop, HLoopVersioning* versioning) {
+        if (!CanVersion(loop)) {
+          return false;
+        }
+        versioning->AddNotGcMarkingCheck();
+        return true;
+      });
+  for (HBasicBlock* fast_header : fast_headers) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Versioned loop, fast version " << fast_header->GetBlockId());
+    MaybeRecordStat(MethodCompilationStat::kIntelReadBarrierLoopVersioned);
+  }
+
+  if (!fast_headers.empty()) {
+    // Bring the loops up to date, then find the blocks of the fast versions.
+    formation.Run();
+    for (HBasicBlock* fast_header : fast_headers) {
+      ElideReadBarriers(LOOPINFO_TO_LOOPINFO_X86(fast_header->GetLoopInformation()));
+    }
+    HFindInductionVariables find_ivs(graph_, "find_ivs_after_read_barrier_elimination", stats_);
+    find_ivs.Run();
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "End: " << GetMethodName(graph));
+}
+
+}  // namespace art
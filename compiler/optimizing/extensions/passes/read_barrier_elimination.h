@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_READ_BARRIER_ELIMINATION_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_READ_BARRIER_ELIMINATION_H_
+
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+// Forward declaration.
+class HLoopInformation_X86;
+
+/**
+ * @brief With the concurrent copying collector, version the inner loops loading
+ * references on the GC marking flag of the thread, and load them without read barrier
+ * in the fast version.
+ * @details The Baker read barrier tests the lock word of every object loaded from,
+ * which only matters while the collector marks. The flag of the thread only changes at
+ * its GC points, so the fast version is entered when it is clear, and deoptimizes after
+ * its suspend checks if the collector started marking meanwhile. Loops with any other
+ * GC point, such as an invoke or an allocation, are not versioned.
+ */
+class HReadBarrierElimination : public HOptimization_X86 {
+ public:
+  explicit HReadBarrierElimination(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kReadBarrierEliminationPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    // Versioning clears the cached loops. The pass forms them again to find the fast
+    // versions, and finds their IVs once the read barriers are elided.
+    return kAnalysisNone;
+  }
+
+ private:
+  /**
+   * @brief Is loop worth versioning, and free of GC points besides the suspend checks?
+   */
+  bool CanVersion(HLoopInformation_X86* loop) const;
+
+  /**
+   * @brief Elide the read barriers of the fast version, and deoptimize after its
+   * suspend checks when the collector marks.
+   */
+  void ElideReadBarriers(HLoopInformation_X86* loop);
+
+  static constexpr const char* kReadBarrierEliminationPassName = "read_barrier_elimination";
+  // A single load costs about as much as the check of the flag after the suspend check.
+  static constexpr size_t kMinReferenceLoads = 2;
+
+  DISALLOW_COPY_AND_ASSIGN(HReadBarrierElimination);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_READ_BARRIER_ELIMINATION_H_
@@ -30,10 +30,106 @@ using android::base::StringPrintf;
 
 namespace art {
 
+void HRemoveLoopSuspendChecks::AddCountedPoll(HLoopInformation_X86* loop_info,
+                                              int32_t interval) {
+  HGraph* graph = loop_info->GetGraph();
+  ArenaAllocator* arena = graph->GetArena();
+  HBasicBlock* header = loop_info->GetHeader();
+  HInstruction* interval_value = graph->GetIntConstant(interval);
+
+  // The header now ends with a Goto to the block testing the thread flags.
+  loop_info->SplitSuspendCheck();
+  HBasicBlock* merge = loop_info->GetSuspend()->GetBlock()->GetSingleSuccessor();
+
+  // Count down in the header, and only go to the test when reaching zero.
+  HPhi* counter = new (arena) HPhi(arena, kNoRegNumber, 0, Primitive::kPrimInt);
+  header->AddPhi(counter);
+  HInstruction* goto_test = header->GetLastInstruction();
+  DCHECK(goto_test->IsGoto());
+  header->RemoveInstruction(goto_test);
+  HInstruction* decrement =
+      new (arena) HSub(Primitive::kPrimInt, counter, graph->GetIntConstant(1));
+  HInstruction* is_zero = new (arena) HEqual(decrement, graph->GetIntConstant(0));
+  header->AddInstruction(decrement);
+  header->AddInstruction(is_zero);
+  header->AddInstruction(new (arena) HIf(is_zero));
+
+  // The other iterations skip the test and keep counting.
+  HBasicBlock* skip = new (arena) HBasicBlock(graph, header->GetDexPc());
+  graph->AddBlock(skip);
+  skip->AddInstruction(new (arena) HGoto());
+  if (header->IsTryBlock()) {
+    skip->SetTryCatchInformation(header->GetTryCatchInformation());
+  }
+  header->AddSuccessor(skip);
+  skip->AddSuccessor(merge);
+  loop_info->AddToAll(skip);
+
+  // The counter restarts after each test.
+  HPhi* next = new (arena) HPhi(arena, kNoRegNumber, 0, Primitive::kPrimInt);
+  merge->AddPhi(next);
+  for (HBasicBlock* predecessor : merge->GetPredecessors()) {
+    next->AddInput(predecessor == skip ? decrement : interval_value);
+  }
+  for (HBasicBlock* predecessor : header->GetPredecessors()) {
+    counter->AddInput(loop_info->Contains(*predecessor) ? next : interval_value);
+  }
+}
+
+void HRemoveLoopSuspendChecks::HoistCHAGuards(HLoopInformation_X86* loop_info,
+                                              HSuspendCheck* suspend_check) {
+  // The flag of a CHA guard is only set by a checkpoint, that is at a suspend point of the
+  // thread, and the loop has none left once its suspend check goes: the guards still in
+  // the loop, those of the receivers defined in it, read the same flag at every iteration
+  // as in the pre-header. The classes invalidating the devirtualizations cannot be loaded
+  // until the loop is done either, so the receivers defined in it conform too.
+  if (suspend_check->GetBlock() != loop_info->GetHeader()) {
+    // Its environment would not be the one of the loop entry.
+    return;
+  }
+  HGraph* graph = loop_info->GetGraph();
+  HBasicBlock* pre_header = loop_info->GetPreHeader();
+  for (HBlocksInLoopIterator bb_it(*loop_info); !bb_it.Done(); bb_it.Advance()) {
+    HBasicBlock* bb = bb_it.Current();
+    for (HInstructionIterator insn_it(bb->GetInstructions()); !insn_it.Done(); ) {
+      HInstruction* insn = insn_it.Current();
+      insn_it.Advance();
+      if (!insn->IsDeoptimize() ||
+          insn->AsDeoptimize()->GetDeoptimizationKind() != DeoptimizationKind::kCHA) {
+        continue;
+      }
+      // The guard is a flag, a compare and a deoptimize in a row, as CHA builds it.
+      HInstruction* compare = insn->GetPrevious();
+      HInstruction* flag = compare == nullptr ? nullptr : compare->GetPrevious();
+      if (flag == nullptr ||
+          !flag->IsShouldDeoptimizeFlag() ||
+          !compare->IsNotEqual() ||
+          insn->InputAt(0) != compare ||
+          !compare->HasOnlyOneNonEnvironmentUse() ||
+          !flag->HasOnlyOneNonEnvironmentUse()) {
+        continue;
+      }
+      flag->MoveBefore(pre_header->GetLastInstruction());
+      compare->MoveBefore(pre_header->GetLastInstruction());
+      bb->RemoveInstruction(insn);
+      // The new deoptimize resumes the interpreter at the top of the loop.
+      HDeoptimize* deoptimize = new (graph->GetArena()) HDeoptimize(
+          graph->GetArena(), compare, DeoptimizationKind::kCHA, suspend_check->GetDexPc());
+      pre_header->InsertInstructionBefore(deoptimize, pre_header->GetLastInstruction());
+      deoptimize->CopyEnvironmentFromWithLoopPhiAdjustment(
+          suspend_check->GetEnvironment(), loop_info->GetHeader());
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Hoisted the CHA guard " << flag->GetId()
+                                       << " to the pre-header " << pre_header->GetBlockId());
+      MaybeRecordStat(MethodCompilationStat::kIntelCHAGuardHoisted);
+    }
+  }
+}
+
 void HRemoveLoopSuspendChecks::Run() {
   HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
   HLoopInformation_X86 *graph_loop_info = graph->GetLoopInformation();
   PRINT_PASS_OSTREAM_MESSAGE(this, "Begin: " << GetMethodName(graph));
+  bool graph_changed = false;
 
   // Don't mess with suspend checks if OSR is enabled.
   if (graph_->IsCompilingOsr()) {
@@ -54,12 +150,6 @@ void HRemoveLoopSuspendChecks::Run() {
         continue;
       }
 
-      // This must be a countable loop.
-      if (!loop_info->HasKnownNumIterations()) {
-        PRINT_PASS_MESSAGE(this, "Loop is not countable");
-        continue;
-      }
-
       DCHECK(loop_info->IsInner());
       // This must be a simple loop.
       bool is_simple = true;
@@ -85,12 +175,6 @@ void HRemoveLoopSuspendChecks::Run() {
         continue;
       }
 
-      // There must not be another way to exit the loop.
-      if (loop_info->CanSideExit()) {
-        PRINT_PASS_MESSAGE(this, "Loop can side exit");
-        continue;
-      }
-
       uint64_t cost = 0;
       if (!loop_info->GetLoopCost(&cost) || cost == 0) {
         // We ran into an issue while counting instructions in the loop.
@@ -98,18 +182,46 @@ void HRemoveLoopSuspendChecks::Run() {
         continue;
       }
 
-      // Compute the total cost of the loop.
-      uint64_t num_iterations = loop_info->GetNumIterations(loop_info->GetHeader());
-      if (num_iterations >= (std::numeric_limits<uint64_t>::max() / cost)) {
-        // We would overflow computing the total cost.
-        PRINT_PASS_MESSAGE(this, "cost * num_iterations is too large");
-        continue;
+      // The suspend check can go if the whole loop runs in bounded time, that is
+      // if it is countable, cheap enough, and there is no other way to exit it.
+      // Otherwise, it only has to run once per kMaxSuspendFreeLoopCost cycles.
+      bool is_removable = true;
+      if (!loop_info->HasKnownNumIterations()) {
+        PRINT_PASS_MESSAGE(this, "Loop is not countable");
+        is_removable = false;
+      } else if (loop_info->CanSideExit(/* ignore_suspends */ true,
+                                        /* ignore_cha_guards */ true)) {
+        PRINT_PASS_MESSAGE(this, "Loop can side exit");
+        is_removable = false;
+      } else {
+        // Compute the total cost of the loop.
+        uint64_t num_iterations = loop_info->GetNumIterations(loop_info->GetHeader());
+        if (num_iterations >= (std::numeric_limits<uint64_t>::max() / cost)) {
+          // We would overflow computing the total cost.
+          PRINT_PASS_MESSAGE(this, "cost * num_iterations is too large");
+          is_removable = false;
+        } else if (cost * num_iterations > kMaxSuspendFreeLoopCost) {
+          PRINT_PASS_OSTREAM_MESSAGE(this, "The cost of the loop (" << cost * num_iterations
+                                           << ") exceeds " << kMaxSuspendFreeLoopCost);
+          is_removable = false;
+        }
       }
-      cost *= num_iterations;
 
-      if (cost > kMaxSuspendFreeLoopCost) {
-        PRINT_PASS_OSTREAM_MESSAGE(this, "The cost of the loop (" << cost
-                                         << ") exceeds " << kMaxSuspendFreeLoopCost);
+      if (!is_removable) {
+        uint64_t interval = std::min(static_cast<uint64_t>(kMaxSuspendFreeLoopCost) / cost,
+                                     static_cast<uint64_t>(kMaxCountedPollInterval));
+        if (interval < kMinCountedPollInterval ||
+            suspend_check->GetBlock() != loop_info->GetHeader()) {
+          PRINT_PASS_MESSAGE(this, "The loop keeps a suspend check per iteration");
+          continue;
+        }
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Test suspend every " << interval
+                                         << " iterations of loop "
+                                         << loop_info->GetHeader()->GetBlockId());
+        AddCountedPoll(loop_info, static_cast<int32_t>(interval));
+        graph_changed = true;
+        MaybeRecordStat(MethodCompilationStat::kIntelCountedSuspendCheck);
+        MaybeRecordLoopInliningBenefit(loop_info);
         continue;
       }
 
@@ -117,12 +229,18 @@ void HRemoveLoopSuspendChecks::Run() {
       PRINT_PASS_OSTREAM_MESSAGE(this, "Remove the suspend check from loop "
                                << loop_info->GetHeader()->GetBlockId()
                                << ", preheader = " << pre_header->GetBlockId());
+      HoistCHAGuards(loop_info, suspend_check);
       suspend_check->GetBlock()->RemoveInstruction(suspend_check);
       loop_info->SetSuppressSuspendCheck(true);
       loop_info->SetSuspendCheck(nullptr);
       MaybeRecordStat(MethodCompilationStat::kIntelRemoveSuspendCheck);
+      MaybeRecordLoopInliningBenefit(loop_info);
     }
   }
+
+  if (graph_changed) {
+    graph->RebuildDomination();
+  }
   PRINT_PASS_OSTREAM_MESSAGE(this, "End: " << GetMethodName(graph));
 }
 
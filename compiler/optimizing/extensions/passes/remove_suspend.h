@@ -29,6 +29,14 @@
 
 namespace art {
 
+// Forward declaration.
+class HLoopInformation_X86;
+
+/**
+ * @brief Remove the suspend checks of the inner loops running in bounded time.
+ * @details The loops running for too long keep a down-counter instead, and only test
+ * the thread flags when it reaches zero, at most once per MAX_SUSPEND_TIME_CYCLES.
+ */
 class HRemoveLoopSuspendChecks : public HOptimization_X86 {
  public:
   explicit HRemoveLoopSuspendChecks(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
@@ -36,9 +44,32 @@ class HRemoveLoopSuspendChecks : public HOptimization_X86 {
 
   void Run() OVERRIDE;
 
+  // The counted polls add blocks, a counter phi and an HIf to the loops, and a back edge
+  // to the single block loops.
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    return kAnalysisAll;
+  }
+
   static constexpr int32_t kMaxSuspendFreeLoopCost = MAX_SUSPEND_TIME_CYCLES;
 
  private:
+  /**
+   * @brief Replace the suspend check of the loop with a test of the thread flags
+   * run every interval iterations.
+   */
+  void AddCountedPoll(HLoopInformation_X86* loop_info, int32_t interval);
+
+  /**
+   * @brief Move the CHA guards of the loop to its pre-header, before the removal of its
+   * suspend check, whose environment the guards take to deoptimize.
+   */
+  void HoistCHAGuards(HLoopInformation_X86* loop_info, HSuspendCheck* suspend_check);
+
+  // Below this, counting costs about as much as testing the thread flags.
+  static constexpr uint64_t kMinCountedPollInterval = 8;
+  // Keep the time to suspend short even if the cost of the loop is underestimated.
+  static constexpr uint64_t kMaxCountedPollInterval = 1024;
+
   static constexpr const char* kRemoveLoopSuspendChecks = "remove_loop_suspend_checks";
 
   DISALLOW_COPY_AND_ASSIGN(HRemoveLoopSuspendChecks);
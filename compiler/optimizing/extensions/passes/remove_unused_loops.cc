@@ -93,6 +93,7 @@ void HRemoveUnusedLoops::Run() {
   PRINT_PASS_MESSAGE(this, "end");
   if (changed) {
     // We have to rebuild our loops properly, now that we have removed loops.
+    GRAPH_TO_GRAPH_X86(graph_)->InvalidateAnalyses(kAnalysisAll);
     HLoopFormation form_loops(graph_);
     form_loops.Run();
   }
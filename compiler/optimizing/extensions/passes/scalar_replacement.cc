@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scalar_replacement.h"
+
+#include <algorithm>
+
+#include "escape.h"
+#include "ext_utility.h"
+#include "graph_x86.h"
+#include "loop_formation.h"
+#include "loop_iterators.h"
+
+namespace art {
+
+static bool IsFieldAccessOf(HInstruction* instruction, HInstruction* allocation) {
+  return (instruction->IsInstanceFieldGet() || instruction->IsInstanceFieldSet()) &&
+         instruction->InputAt(0) == allocation;
+}
+
+static const FieldInfo& GetFieldInfoOf(HInstruction* access) {
+  return access->IsInstanceFieldGet() ? access->AsInstanceFieldGet()->GetFieldInfo()
+                                      : access->AsInstanceFieldSet()->GetFieldInfo();
+}
+
+static HInstruction* GetDefaultValue(HGraph* graph, Primitive::Type type) {
+  switch (type) {
+    case Primitive::kPrimNot:
+      return graph->GetNullConstant();
+    case Primitive::kPrimFloat:
+      return graph->GetFloatConstant(0);
+    case Primitive::kPrimDouble:
+      return graph->GetDoubleConstant(0);
+    default:
+      return graph->GetConstant(type, 0);
+  }
+}
+
+bool HScalarReplacement::CanReplace(HNewInstance* allocation,
+                                    ArenaVector<size_t>* offsets,
+                                    ArenaVector<Primitive::Type>* types) const {
+  if (allocation->IsFinalizable() || allocation->NeedsChecks()) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, allocation << " is finalizable or needs checks");
+    return false;
+  }
+
+  bool is_singleton = false;
+  bool is_singleton_and_not_returned = false;
+  bool is_singleton_and_not_deopt_visible = false;
+  CalculateEscape(allocation,
+                  nullptr,
+                  &is_singleton,
+                  &is_singleton_and_not_returned,
+                  &is_singleton_and_not_deopt_visible);
+  if (!is_singleton_and_not_returned || !is_singleton_and_not_deopt_visible) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, allocation << " escapes");
+    return false;
+  }
+
+  // The object must only be used by the accesses to its fields.
+  for (const HUseListNode<HInstruction*>& use : allocation->GetUses()) {
+    HInstruction* user = use.GetUser();
+    if (user->IsConstructorFence()) {
+      continue;
+    }
+    if (!IsFieldAccessOf(user, allocation) || GetFieldInfoOf(user).IsVolatile()) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, allocation << " is used by " << user);
+      return false;
+    }
+    const FieldInfo& field_info = GetFieldInfoOf(user);
+    size_t offset = field_info.GetFieldOffset().SizeValue();
+    auto it = std::find(offsets->begin(), offsets->end(), offset);
+    if (it == offsets->end()) {
+      offsets->push_back(offset);
+      types->push_back(field_info.GetFieldType());
+    } else if ((*types)[it - offsets->begin()] != field_info.GetFieldType()) {
+      return false;
+    }
+  }
+
+  // The values of the fields are only merged at the joins of the blocks dominated by the
+  // allocation, whose predecessors are all dominated by it too. A loop header would also
+  // need the values of its back edges before they are known.
+  HBasicBlock* allocation_block = allocation->GetBlock();
+  for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+    if (block != allocation_block &&
+        allocation_block->Dominates(block) &&
+        block->IsLoopHeader()) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, allocation << " dominates loop "
+                                       << block->GetBlockId());
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void HScalarReplacement::Replace(HNewInstance* allocation,
+                                 const ArenaVector<size_t>& offsets,
+                                 const ArenaVector<Primitive::Type>& types) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HBasicBlock* allocation_block = allocation->GetBlock();
+  const size_t num_fields = offsets.size();
+
+  // A load of each field gives the type of the phis merging its references.
+  ArenaVector<HInstruction*> loads(num_fields, nullptr, arena->Adapter(kArenaAllocMisc));
+  for (const HUseListNode<HInstruction*>& use : allocation->GetUses()) {
+    HInstruction* user = use.GetUser();
+    if (user->IsInstanceFieldGet()) {
+      size_t offset = user->AsInstanceFieldGet()->GetFieldOffset().SizeValue();
+      loads[std::find(offsets.begin(), offsets.end(), offset) - offsets.begin()] = user;
+    }
+  }
+
+  HConstructorFence::RemoveConstructorFences(allocation);
+
+  // The values of the fields at the end of each block.
+  ArenaVector<ArenaVector<HInstruction*>> values(
+      graph_->GetBlocks().size(),
+      ArenaVector<HInstruction*>(arena->Adapter(kArenaAllocMisc)),
+      arena->Adapter(kArenaAllocMisc));
+  ArenaVector<HPhi*> phis(arena->Adapter(kArenaAllocMisc));
+  for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+    if (block != allocation_block && !allocation_block->Dominates(block)) {
+      continue;
+    }
+    ArenaVector<HInstruction*>& current = values[block->GetBlockId()];
+    HInstruction* instruction = nullptr;
+    if (block == allocation_block) {
+      for (Primitive::Type type : types) {
+        current.push_back(GetDefaultValue(graph_, type));
+      }
+      instruction = allocation->GetNext();
+    } else {
+      const ArenaVector<HBasicBlock*>& predecessors = block->GetPredecessors();
+      for (size_t i = 0; i != num_fields; ++i) {
+        HInstruction* value = values[predecessors[0]->GetBlockId()][i];
+        for (HBasicBlock* predecessor : predecessors) {
+          if (values[predecessor->GetBlockId()][i] != value) {
+            value = nullptr;
+            break;
+          }
+        }
+        if (value == nullptr) {
+          HPhi* phi = new (arena) HPhi(arena, kNoRegNumber, 0, HPhi::ToPhiType(types[i]));
+          for (HBasicBlock* predecessor : predecessors) {
+            phi->AddInput(values[predecessor->GetBlockId()][i]);
+          }
+          block->AddPhi(phi);
+          if (types[i] == Primitive::kPrimNot && loads[i] != nullptr) {
+            phi->SetReferenceTypeInfo(loads[i]->GetReferenceTypeInfo());
+          }
+          phis.push_back(phi);
+          value = phi;
+        }
+        current.push_back(value);
+      }
+      instruction = block->GetFirstInstruction();
+    }
+
+    while (instruction != nullptr) {
+      HInstruction* next = instruction->GetNext();
+      if (IsFieldAccessOf(instruction, allocation)) {
+        size_t offset = GetFieldInfoOf(instruction).GetFieldOffset().SizeValue();
+        size_t index = std::find(offsets.begin(), offsets.end(), offset) - offsets.begin();
+        if (instruction->IsInstanceFieldGet()) {
+          instruction->ReplaceWith(current[index]);
+        } else {
+          current[index] = instruction->InputAt(1);
+        }
+        block->RemoveInstruction(instruction);
+      }
+      instruction = next;
+    }
+  }
+
+  allocation->RemoveEnvironmentUsers();
+  allocation_block->RemoveInstruction(allocation);
+
+  // Remove the phis merging values no load reads, the later ones first as they may use
+  // the earlier ones.
+  for (auto it = phis.rbegin(); it != phis.rend(); ++it) {
+    if (!(*it)->HasUses()) {
+      (*it)->GetBlock()->RemovePhi(*it);
+    }
+  }
+}
+
+void HScalarReplacement::Run() {
+  if (graph_->IsDebuggable() || graph_->HasTryCatch()) {
+    return;
+  }
+
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Begin: " << GetMethodName(graph));
+
+  HLoopFormation formation(graph_);
+  formation.Run();
+
+  // Only the allocations executed by the loops, where they pressure the GC.
+  ArenaVector<HNewInstance*> allocations(graph_->GetArena()->Adapter(kArenaAllocMisc));
+  for (HOutToInLoopIterator it(graph->GetLoopInformation()); !it.Done(); it.Advance()) {
+    HLoopInformation_X86* loop = it.Current();
+    for (HBlocksInLoopIterator it_block(*loop); !it_block.Done(); it_block.Advance()) {
+      HBasicBlock* block = it_block.Current();
+      if (block->GetLoopInformation() != loop) {
+        // The block of an inner loop, visited with it.
+        continue;
+      }
+      for (HInstructionIterator it_insn(block->GetInstructions()); !it_insn.Done();
+           it_insn.Advance()) {
+        if (it_insn.Current()->IsNewInstance()) {
+          allocations.push_back(it_insn.Current()->AsNewInstance());
+        }
+      }
+    }
+  }
+
+  ArenaVector<size_t> offsets(graph_->GetArena()->Adapter(kArenaAllocMisc));
+  ArenaVector<Primitive::Type> types(graph_->GetArena()->Adapter(kArenaAllocMisc));
+  for (HNewInstance* allocation : allocations) {
+    offsets.clear();
+    types.clear();
+    if (CanReplace(allocation, &offsets, &types)) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Replacing the fields of " << allocation);
+      Replace(allocation, offsets, types);
+      MaybeRecordStat(MethodCompilationStat::kIntelScalarReplaced);
+    }
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "End: " << GetMethodName(graph));
+}
+
+}  // namespace art
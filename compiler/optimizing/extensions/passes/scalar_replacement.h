@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_SCALAR_REPLACEMENT_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_SCALAR_REPLACEMENT_H_
+
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+/**
+ * @brief Replace the fields of the objects allocated in loops and not escaping the
+ * compiled code by SSA values, and remove the allocations.
+ * @details The load store elimination only removes an allocation when it can remove all
+ * of its loads and stores, which fails as soon as different values of a field merge.
+ * This pass follows the values of the fields from the allocation over the blocks it
+ * dominates, and merges them with new phis. The objects visible to a deoptimization are
+ * kept, as are those whose fields would need to be merged at a loop header.
+ */
+class HScalarReplacement : public HOptimization_X86 {
+ public:
+  explicit HScalarReplacement(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kScalarReplacementPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+ private:
+  /**
+   * @brief Can the fields of allocation be replaced by SSA values?
+   * @param allocation The allocation to replace.
+   * @param offsets The offsets of the fields accessed, filled by the method.
+   * @param types The types of the fields accessed, filled by the method.
+   */
+  bool CanReplace(HNewInstance* allocation,
+                  ArenaVector<size_t>* offsets,
+                  ArenaVector<Primitive::Type>* types) const;
+
+  /**
+   * @brief Replace the accesses to the fields of allocation, and remove it.
+   */
+  void Replace(HNewInstance* allocation,
+               const ArenaVector<size_t>& offsets,
+               const ArenaVector<Primitive::Type>& types);
+
+  static constexpr const char* kScalarReplacementPassName = "scalar_replacement";
+
+  DISALLOW_COPY_AND_ASSIGN(HScalarReplacement);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_SCALAR_REPLACEMENT_H_
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "select_osr_entries.h"
+
+#include "ext_utility.h"
+#include "graph_x86.h"
+#include "loop_formation.h"
+#include "loop_iterators.h"
+
+namespace art {
+
+// Is loop entered from the interpreter in the OSR compiled code?
+static bool IsOsrEntry(HLoopInformation_X86* loop) {
+  HSuspendCheck* suspend_check = loop->GetSuspendCheck();
+  return loop->IsIrreducible() &&
+         suspend_check != nullptr &&
+         suspend_check->CanBeOsrEntry() &&
+         !suspend_check->GetEnvironment()->IsFromInlinedInvoke();
+}
+
+bool HSelectOsrEntries::CanMoveOsrEntry(HLoopInformation_X86* loop) const {
+  if (!IsOsrEntry(loop)) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop " << loop->GetHeader()->GetBlockId()
+                                     << " is not an OSR entry");
+    return false;
+  }
+
+  if (loop->HasBackEdgeNotDominatedByHeader()) {
+    // Irreducible in its own right, it would not be transformed anyway.
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop " << loop->GetHeader()->GetBlockId()
+                                     << " is irreducible");
+    return false;
+  }
+
+  HLoopInformation_X86* outer = loop->GetParent();
+  if (outer == nullptr || !IsOsrEntry(outer)) {
+    // Keep the only entry of the interpreter into this loop nest.
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop " << loop->GetHeader()->GetBlockId()
+                                     << " has no outer OSR entry");
+    return false;
+  }
+
+  return true;
+}
+
+void HSelectOsrEntries::Run() {
+  if (!graph_->IsCompilingOsr()) {
+    return;
+  }
+
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Begin: " << GetMethodName(graph));
+
+  HLoopFormation formation(graph_);
+  formation.Run();
+
+  bool changed = false;
+  for (HOnlyInnerLoopIterator it(graph->GetLoopInformation()); !it.Done(); it.Advance()) {
+    HLoopInformation_X86* loop = it.Current();
+    if (CanMoveOsrEntry(loop)) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Moving the OSR entry of loop "
+                                       << loop->GetHeader()->GetBlockId() << " to loop "
+                                       << loop->GetParent()->GetHeader()->GetBlockId());
+      loop->GetSuspendCheck()->DisableOsrEntry();
+      MaybeRecordStat(MethodCompilationStat::kIntelOsrEntryMoved);
+      changed = true;
+    }
+  }
+
+  if (changed) {
+    // Rebuild the loops, the inner loops are now natural loops.
+    graph->HGraph::ClearLoopInformation();
+    graph->ClearDominanceInformation();
+    GraphAnalysisResult result = graph->BuildDominatorTree();
+    DCHECK_EQ(result, kAnalysisSuccess);
+    UNUSED(result);
+    graph->InvalidateAnalyses(kAnalysisAll);
+    formation.Run();
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "End: " << GetMethodName(graph));
+}
+
+}  // namespace art
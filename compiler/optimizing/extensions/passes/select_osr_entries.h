@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_SELECT_OSR_ENTRIES_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_SELECT_OSR_ENTRIES_H_
+
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+// Forward declaration.
+class HLoopInformation_X86;
+
+/**
+ * @brief When compiling in OSR mode, move the OSR entries of the inner loops to their
+ * outer loop, so that the loop passes can transform the inner loops.
+ * @details In OSR mode, every loop of the method may be entered from the interpreter and
+ * is treated as irreducible, which the loop passes reject. An inner loop giving up its
+ * entry becomes a natural loop again. The interpreter finishes running it, and enters the
+ * compiled code at the next iteration of the outer loop, which keeps its entry: the values
+ * computed for the inner loop stay inside the outer loop, as the OSR entry requires.
+ */
+class HSelectOsrEntries : public HOptimization_X86 {
+ public:
+  explicit HSelectOsrEntries(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kSelectOsrEntriesPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    // The loops are rebuilt by the pass itself when entries are moved.
+    return kAnalysisNone;
+  }
+
+ private:
+  /**
+   * @brief Can the OSR entry of loop be given up in favor of its outer loop?
+   */
+  bool CanMoveOsrEntry(HLoopInformation_X86* loop) const;
+
+  static constexpr const char* kSelectOsrEntriesPassName = "select_osr_entries";
+
+  DISALLOW_COPY_AND_ASSIGN(HSelectOsrEntries);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_SELECT_OSR_ENTRIES_H_
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "software_prefetch.h"
+
+#include <algorithm>
+
+#include "ext_utility.h"
+#include "find_ivs.h"
+#include "graph_x86.h"
+#include "induction_variable.h"
+#include "loop_formation.h"
+#include "loop_iterators.h"
+#include "loop_unroll_cost_model.h"
+#include "non_temporal_move.h"
+
+namespace art {
+
+HSoftwarePrefetch::HSoftwarePrefetch(HGraph* graph,
+                                     const InstructionSetFeatures* features,
+                                     OptimizingCompilerStats* stats)
+    : HOptimization_X86(graph, kSoftwarePrefetchPassName, stats),
+      is_atom_(features != nullptr &&
+               HLoopUnrollCostModel(features).GetCoreKind() == HLoopUnrollCostModel::kCoreAtom),
+      last_level_cache_size_(HNonTemporalMove::GetLastLevelCacheSize(features)) {}
+
+int64_t HSoftwarePrefetch::GetIterationsAhead(int64_t stride) const {
+  int64_t ahead = is_atom_ ? kAtomPrefetchAhead : kPrefetchAhead;
+  return std::max(kMinIterationsAhead, (ahead + stride - 1) / stride);
+}
+
+HInstanceFieldGet* HSoftwarePrefetch::GetDereference(HLoopInformation_X86* loop,
+                                                      HArrayGet* array_get) const {
+  for (const HUseListNode<HInstruction*>& use : array_get->GetUses()) {
+    HInstruction* user = use.GetUser();
+    if (user->IsNullCheck()) {
+      // The field is read from the null checked reference.
+      for (const HUseListNode<HInstruction*>& checked_use : user->GetUses()) {
+        HInstruction* checked_user = checked_use.GetUser();
+        if (checked_user->IsInstanceFieldGet() && loop->Contains(*checked_user->GetBlock())) {
+          return checked_user->AsInstanceFieldGet();
+        }
+      }
+    } else if (user->IsInstanceFieldGet() && loop->Contains(*user->GetBlock())) {
+      return user->AsInstanceFieldGet();
+    }
+  }
+  return nullptr;
+}
+
+size_t HSoftwarePrefetch::AddPrefetches(HLoopInformation_X86* loop) {
+  int64_t num_iterations =
+      loop->HasKnownNumIterations() ? loop->GetBoundInformation().num_iterations_ : -1;
+  if (num_iterations != -1 && num_iterations < kMinIterations) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop " << loop->GetHeader()->GetBlockId()
+                                     << " is too short to prefetch");
+    return 0u;
+  }
+
+  ArenaAllocator* arena = graph_->GetArena();
+  // The arrays prefetched, with the IV walking them.
+  ArenaVector<std::pair<HInstruction*, HInstruction*>> walks(arena->Adapter(kArenaAllocMisc));
+  for (HBlocksInLoopIterator it_loop(*loop); !it_loop.Done(); it_loop.Advance()) {
+    HBasicBlock* block = it_loop.Current();
+    if (!loop->ExecutedPerIteration(block)) {
+      continue;
+    }
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* access = it.Current();
+      Primitive::Type type;
+      if (access->IsArrayGet() && !access->AsArrayGet()->IsStringCharAt()) {
+        type = access->GetType();
+      } else if (access->IsArraySet()) {
+        type = access->AsArraySet()->GetComponentType();
+      } else {
+        continue;
+      }
+      HInstruction* array = access->InputAt(0);
+      HInstruction* index = access->InputAt(1);
+      if (index->IsBoundsCheck()) {
+        index = index->InputAt(0);
+      }
+      HInductionVariable* iv = loop->GetInductionVariable(index);
+      if (iv == nullptr || !iv->IsBasic() || !iv->IsInteger() ||
+          !loop->IsDefinedOutOfTheLoop(array)) {
+        continue;
+      }
+      std::pair<HInstruction*, HInstruction*> walk(array, iv->GetPhiInsn());
+      if (std::find(walks.begin(), walks.end(), walk) != walks.end()) {
+        continue;
+      }
+
+      // The fields of the objects of an Object[] walk, or the elements of the others.
+      HInstanceFieldGet* field_get = nullptr;
+      if (access->IsArrayGet() && type == Primitive::kPrimNot) {
+        field_get = GetDereference(loop, access->AsArrayGet());
+      }
+      int64_t increment = iv->GetIncrement();
+      int64_t stride = ((increment < 0) ? -increment : increment) * Primitive::ComponentSize(type);
+      int64_t iterations_ahead;
+      if (field_get != nullptr) {
+        iterations_ahead = kIndirectIterationsAhead;
+      } else if (stride >= kMinStride || is_atom_) {
+        iterations_ahead = GetIterationsAhead(stride);
+      } else {
+        continue;
+      }
+      if (iterations_ahead * stride > kMaxPrefetchAhead && field_get == nullptr) {
+        iterations_ahead = std::max<int64_t>(1, kMaxPrefetchAhead / stride);
+      }
+      if (num_iterations != -1 && iterations_ahead >= num_iterations) {
+        continue;
+      }
+
+      // Data used once, and not fitting in the last level cache, would only evict the rest.
+      HX86Prefetch::Hint hint = HX86Prefetch::kPrefetchT0;
+      if (field_get == nullptr &&
+          num_iterations != -1 &&
+          static_cast<uint64_t>(num_iterations * stride) > last_level_cache_size_) {
+        hint = HX86Prefetch::kPrefetchNTA;
+      }
+
+      HX86Prefetch* prefetch = new (arena) HX86Prefetch(
+          array,
+          index,
+          type,
+          static_cast<int32_t>(iterations_ahead * increment),
+          hint,
+          (field_get != nullptr) ?
+              field_get->GetFieldOffset().Uint32Value() : HX86Prefetch::kNoFieldOffset,
+          access->GetDexPc());
+      block->InsertInstructionBefore(prefetch, access);
+      walks.push_back(walk);
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Prefetching " << (field_get != nullptr ? "through " : "")
+                                       << access->DebugName() << " " << access->GetId()
+                                       << " " << iterations_ahead
+                                       << " iterations ahead in loop "
+                                       << loop->GetHeader()->GetBlockId());
+      if (walks.size() == kMaxPrefetchesPerLoop) {
+        return walks.size();
+      }
+    }
+  }
+  return walks.size();
+}
+
+void HSoftwarePrefetch::Run() {
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Begin: " << GetMethodName(graph));
+
+  HLoopFormation formation(graph_);
+  formation.Run();
+  HFindInductionVariables find_ivs(graph_, "find_ivs_for_software_prefetch", stats_);
+  find_ivs.Run();
+
+  for (HOnlyInnerLoopIterator it(graph->GetLoopInformation()); !it.Done(); it.Advance()) {
+    HLoopInformation_X86* loop = it.Current();
+    if (loop->IsOrHasIrreducibleLoop() || loop->HasTryCatchHandler() ||
+        loop->GetPreHeader() == nullptr) {
+      continue;
+    }
+    size_t num_prefetches = AddPrefetches(loop);
+    if (num_prefetches != 0u) {
+      MaybeRecordStat(MethodCompilationStat::kIntelPrefetchInserted, num_prefetches);
+    }
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "End: " << GetMethodName(graph));
+}
+
+}  // namespace art
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_SOFTWARE_PREFETCH_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_SOFTWARE_PREFETCH_H_
+
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+// Forward declarations.
+class HInductionVariable;
+class HLoopInformation_X86;
+class InstructionSetFeatures;
+
+/**
+ * @brief Prefetch the data of the array walks of the inner loops some iterations ahead.
+ * @details The primitive arrays walked with a large stride are prefetched with an
+ * HX86Prefetch, on Atom cores whatever the stride, as their hardware prefetchers do not
+ * keep up. The elements of the Object[] walks whose fields are read in the loop are
+ * loaded ahead, and the fields of the objects they reference prefetched. The loops
+ * touching more data than the last level cache holds prefetch with the non-temporal hint.
+ * The pass runs last, as the prefetches are unused instructions for the other passes.
+ */
+class HSoftwarePrefetch : public HOptimization_X86 {
+ public:
+  HSoftwarePrefetch(HGraph* graph,
+                    const InstructionSetFeatures* features,
+                    OptimizingCompilerStats* stats = nullptr);
+
+  void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    // The prefetches only use the array and index of an existing access, in its block.
+    // They define no value the IVs or the bounds could depend on.
+    return kAnalysisNone;
+  }
+
+ private:
+  /**
+   * @brief Insert the prefetches of the array walks of loop.
+   * @return the number of prefetches inserted.
+   */
+  size_t AddPrefetches(HLoopInformation_X86* loop);
+
+  /**
+   * @brief Get the field read in loop from the reference loaded by array_get, if any.
+   */
+  HInstanceFieldGet* GetDereference(HLoopInformation_X86* loop, HArrayGet* array_get) const;
+
+  /**
+   * @brief Get the number of iterations to prefetch ahead of, for a walk of the given stride.
+   */
+  int64_t GetIterationsAhead(int64_t stride) const;
+
+  static constexpr const char* kSoftwarePrefetchPassName = "software_prefetch";
+
+  // Shorter loops do not run long enough for the prefetches to pay off.
+  static constexpr int64_t kMinIterations = 64;
+  // The hardware prefetchers of the big cores follow the shorter strides, in bytes.
+  static constexpr int64_t kMinStride = 16;
+  // How far ahead to prefetch, in bytes, approximating the memory latency by the data
+  // the loop walks meanwhile. Atom cores run fewer instructions per cycle, and need less.
+  static constexpr int64_t kAtomPrefetchAhead = 512;
+  static constexpr int64_t kPrefetchAhead = 1024;
+  static constexpr int64_t kMinIterationsAhead = 4;
+  // The loads of the indirect prefetches also miss, prefetch them further ahead.
+  static constexpr int64_t kIndirectIterationsAhead = 16;
+  // The prefetches crossing pages may be dropped.
+  static constexpr int64_t kMaxPrefetchAhead = 4 * KB;
+  static constexpr size_t kMaxPrefetchesPerLoop = 4;
+
+  const bool is_atom_;
+  const size_t last_level_cache_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(HSoftwarePrefetch);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_SOFTWARE_PREFETCH_H_
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "speculate_trip_count.h"
+
+#include "art_field-inl.h"
+#include "ext_utility.h"
+#include "graph_x86.h"
+#include "induction_variable.h"
+#include "loop_iterators.h"
+#include "mirror/array-inl.h"
+#include "mirror/class-inl.h"
+#include "runtime.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+
+// Get the final static field read by instruction, if its class is initialized.
+static ArtField* GetStableStaticField(HInstruction* instruction)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  if (!instruction->IsStaticFieldGet()) {
+    return nullptr;
+  }
+  const FieldInfo& info = instruction->AsStaticFieldGet()->GetFieldInfo();
+  ArtField* field = info.GetField();
+  if (field == nullptr ||
+      info.IsVolatile() ||
+      !field->IsFinal() ||
+      !field->GetDeclaringClass()->IsInitialized()) {
+    return nullptr;
+  }
+  return field;
+}
+
+bool HSpeculateTripCount::GetStableValue(HInstruction* bound, int32_t* value) const {
+  ScopedObjectAccess soa(Thread::Current());
+  if (bound->IsStaticFieldGet()) {
+    ArtField* field = GetStableStaticField(bound);
+    if (field == nullptr || bound->GetType() != Primitive::kPrimInt) {
+      return false;
+    }
+    *value = field->GetInt(field->GetDeclaringClass());
+    return true;
+  }
+
+  if (bound->IsArrayLength() && !bound->AsArrayLength()->IsStringLength()) {
+    HInstruction* array = bound->InputAt(0);
+    if (array->IsNullCheck()) {
+      array = array->InputAt(0);
+    }
+    ArtField* field = GetStableStaticField(array);
+    if (field == nullptr || array->GetType() != Primitive::kPrimNot) {
+      return false;
+    }
+    ObjPtr<mirror::Object> object = field->GetObject(field->GetDeclaringClass());
+    if (object == nullptr || !object->IsArrayInstance()) {
+      return false;
+    }
+    *value = object->AsArray()->GetLength();
+    return true;
+  }
+
+  return false;
+}
+
+bool HSpeculateTripCount::Speculate(HLoopInformation_X86* loop) {
+  HBasicBlock* exit_block = loop->GetExitBlock();
+  if (exit_block == nullptr) {
+    return false;
+  }
+  HInstruction* branch = exit_block->GetPredecessors()[0]->GetLastInstruction();
+  if (!branch->IsIf() || !branch->InputAt(0)->IsCondition()) {
+    return false;
+  }
+  HInstruction* compare = GetCompareInstruction(branch->InputAt(0));
+
+  // The loop is tested by comparing its basic IV with the bound.
+  size_t bound_index = 1u;
+  HInductionVariable* iv = loop->GetInductionVariable(compare->InputAt(0));
+  if (iv == nullptr) {
+    bound_index = 0u;
+    iv = loop->GetInductionVariable(compare->InputAt(1));
+  }
+  if (iv == nullptr || !iv->IsBasic()) {
+    return false;
+  }
+  HInstruction* bound = compare->InputAt(bound_index);
+  if (bound->GetType() != Primitive::kPrimInt ||
+      bound->IsConstant() ||
+      !loop->IsDefinedOutOfTheLoop(bound)) {
+    return false;
+  }
+
+  int32_t value = 0;
+  if (!GetStableValue(bound, &value)) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop " << loop->GetHeader()->GetBlockId()
+                                     << " has no stable bound");
+    return false;
+  }
+
+  // The deoptimization needs the state of the method when entering the loop.
+  HInstruction* state = loop->GetSuspendCheck();
+  if (state == nullptr && loop->HasSuspend()) {
+    state = loop->GetSuspend();
+  }
+  if (state == nullptr || !state->HasEnvironment()) {
+    return false;
+  }
+
+  ArenaAllocator* arena = graph_->GetArena();
+  HIntConstant* constant = graph_->GetIntConstant(value);
+  HBasicBlock* pre_header = loop->GetPreHeader();
+  HInstruction* cursor = pre_header->GetLastInstruction();
+  HInstruction* condition = new (arena) HNotEqual(bound, constant);
+  pre_header->InsertInstructionBefore(condition, cursor);
+  HDeoptimize* deoptimize = new (arena) HDeoptimize(
+      arena, condition, DeoptimizationKind::kLoopTripCount, state->GetDexPc());
+  pre_header->InsertInstructionBefore(deoptimize, cursor);
+  // Deoptimizing resumes the interpreter at the first iteration.
+  deoptimize->CopyEnvironmentFromWithLoopPhiAdjustment(state->GetEnvironment(), loop->GetHeader());
+  compare->ReplaceInput(constant, bound_index);
+
+  if (!loop->ComputeBoundInformation() || !loop->HasKnownNumIterations()) {
+    // Nothing to gain from the guard, revert.
+    compare->ReplaceInput(bound, bound_index);
+    pre_header->RemoveInstruction(deoptimize);
+    pre_header->RemoveInstruction(condition);
+    loop->ComputeBoundInformation();
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Loop " << loop->GetHeader()->GetBlockId()
+                                     << " has no known number of iterations with bound "
+                                     << value);
+    return false;
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Loop " << loop->GetHeader()->GetBlockId()
+                                   << " speculated to run "
+                                   << loop->GetBoundInformation().num_iterations_ << " iterations");
+  return true;
+}
+
+void HSpeculateTripCount::Run() {
+  if (!Runtime::Current()->UseJitCompilation() || graph_->IsDebuggable()) {
+    // Only the JIT sees the values of the bounds the compiled code runs with.
+    return;
+  }
+
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Begin: " << GetMethodName(graph));
+
+  for (HOnlyInnerLoopIterator it(graph->GetLoopInformation()); !it.Done(); it.Advance()) {
+    HLoopInformation_X86* loop = it.Current();
+    if (!loop->HasKnownNumIterations() && Speculate(loop)) {
+      MaybeRecordStat(MethodCompilationStat::kIntelTripCountSpeculated);
+    }
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "End: " << GetMethodName(graph));
+}
+
+}  // namespace art
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_SPECULATE_TRIP_COUNT_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_SPECULATE_TRIP_COUNT_H_
+
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+// Forward declaration.
+class HLoopInformation_X86;
+
+/**
+ * @brief When JIT compiling, assume that an inner loop bounded by a value loaded from a final
+ * static field keeps the bound observed at compile time, guarded by an HDeoptimize in the
+ * pre-header.
+ * @details The loop test then compares with a constant, so the loop gets a known number of
+ * iterations, which the full unrolling, the trivial loop evaluator and the other passes
+ * requiring it can use. The bound is the current value of a static final int field, or the
+ * length of the array of a static final field, of an initialized class: they do not change
+ * once the class is initialized, so the guard seldom fails.
+ */
+class HSpeculateTripCount : public HOptimization_X86 {
+ public:
+  explicit HSpeculateTripCount(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kSpeculateTripCountPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    // Only the tests of the loops change, the pass computes their bounds again right away.
+    return kAnalysisNone;
+  }
+
+ private:
+  /**
+   * @brief Speculate on the bound of loop, if it is stable.
+   * @return whether loop has a known number of iterations now.
+   */
+  bool Speculate(HLoopInformation_X86* loop);
+
+  /**
+   * @brief Get the current value of bound, if it is a stable one.
+   */
+  bool GetStableValue(HInstruction* bound, int32_t* value) const;
+
+  static constexpr const char* kSpeculateTripCountPassName = "speculate_trip_count";
+
+  DISALLOW_COPY_AND_ASSIGN(HSpeculateTripCount);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_SPECULATE_TRIP_COUNT_H_
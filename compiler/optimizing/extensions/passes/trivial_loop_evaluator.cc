@@ -24,6 +24,7 @@
 #include "android-base/stringprintf.h"
 using android::base::StringPrintf;
 
+#include "escape.h"
 #include "ext_utility.h"
 #include "graph_x86.h"
 #include "loop_iterators.h"
@@ -55,6 +56,7 @@ class TLEVisitor : public HGraphVisitor {
       next_bb_(nullptr),
       values_(std::less<HInstruction*>(), graph->GetArena()->Adapter()),
       phi_values_(std::less<HInstruction*>(), graph->GetArena()->Adapter()),
+      arrays_(graph->GetArena()->Adapter()),
       opt_(opt) {}
 
 #define NOTHING_IF_ERROR if (is_error_) return
@@ -587,6 +589,126 @@ class TLEVisitor : public HGraphVisitor {
       SetError(instr));
   }
 
+  /**
+   * @brief The contents of an array written by the loop.
+   */
+  struct ArrayTable {
+    HInstruction* array;
+    Primitive::Type type;
+    ArenaVector<Value> values;
+    ArenaVector<bool> written;
+  };
+
+  /**
+   * @brief Track array, known to be zero-filled before the loop, in a table.
+   */
+  void AddArray(HInstruction* array, int32_t length, Primitive::Type type) {
+    ArenaAllocator* arena = GetGraph()->GetArena();
+    arrays_.push_back({ array,
+                        type,
+                        ArenaVector<Value>(length, Value(static_cast<int64_t>(0)), arena->Adapter()),
+                        ArenaVector<bool>(length, false, arena->Adapter()) });
+  }
+
+  ArrayTable* FindArray(HInstruction* array) {
+    for (ArrayTable& table : arrays_) {
+      if (table.array == array) {
+        return &table;
+      }
+    }
+    return nullptr;
+  }
+
+  const ArenaVector<ArrayTable>& GetArrays() const {
+    return arrays_;
+  }
+
+  // Returns the element of the array accessed by instr, nullptr if it is not tracked.
+  Value* GetElement(HInstruction* instr, Primitive::Type type) {
+    ArrayTable* table = FindArray(instr->InputAt(0));
+    if (table == nullptr || table->type != type) {
+      SetError(instr);
+      return nullptr;
+    }
+    int32_t index = GetValue(instr->InputAt(1)).i;
+    if (is_error_) {
+      return nullptr;
+    }
+    if (index < 0 || static_cast<size_t>(index) >= table->values.size()) {
+      // The exception is left to the compiled code.
+      SetError(instr);
+      return nullptr;
+    }
+    if (instr->IsArraySet()) {
+      table->written[index] = true;
+    }
+    return &table->values[index];
+  }
+
+  void VisitArrayLength(HArrayLength* instr) OVERRIDE {
+    NOTHING_IF_ERROR;
+    ArrayTable* table = FindArray(instr->InputAt(0));
+    if (table == nullptr) {
+      SetError(instr);
+      return;
+    }
+    values_.Overwrite(instr, Value(static_cast<int32_t>(table->values.size())));
+  }
+
+  void VisitBoundsCheck(HBoundsCheck* instr) OVERRIDE {
+    NOTHING_IF_ERROR;
+    Value index = GetValue(instr->InputAt(0));
+    Value length = GetValue(instr->InputAt(1));
+    NOTHING_IF_ERROR;
+    if (index.i < 0 || index.i >= length.i) {
+      // The exception is left to the compiled code.
+      SetError(instr);
+      return;
+    }
+    values_.Overwrite(instr, index);
+  }
+
+  void VisitArrayGet(HArrayGet* instr) OVERRIDE {
+    NOTHING_IF_ERROR;
+    Value* element = GetElement(instr, instr->GetType());
+    NOTHING_IF_ERROR;
+    values_.Overwrite(instr, *element);
+  }
+
+  void VisitArraySet(HArraySet* instr) OVERRIDE {
+    NOTHING_IF_ERROR;
+    Primitive::Type type = instr->GetComponentType();
+    Value value = GetValue(instr->GetValue());
+    NOTHING_IF_ERROR;
+    Value* element = GetElement(instr, type);
+    NOTHING_IF_ERROR;
+    // The store narrows the value to the component type.
+    switch (type) {
+      case Primitive::kPrimBoolean:
+        *element = Value(static_cast<int32_t>(static_cast<uint8_t>(value.i)));
+        break;
+      case Primitive::kPrimByte:
+        *element = Value(static_cast<int8_t>(value.i));
+        break;
+      case Primitive::kPrimChar:
+        *element = Value(static_cast<int32_t>(static_cast<uint16_t>(value.i)));
+        break;
+      case Primitive::kPrimShort:
+        *element = Value(static_cast<int16_t>(value.i));
+        break;
+      default:
+        *element = value;
+        break;
+    }
+  }
+
+  /**
+   * @brief Record a value computed without visiting the loop.
+   */
+  void SetValue(HInstruction* instr, Value value) {
+    values_.Overwrite(instr, value);
+  }
+
   HBasicBlock* GetNextBasicBlock() { return next_bb_; }
 
   bool IsError() { return is_error_; }
@@ -658,6 +780,7 @@ class TLEVisitor : public HGraphVisitor {
   HBasicBlock* next_bb_;
   ArenaSafeMap<HInstruction*, Value> values_;
   ArenaSafeMap<HInstruction*, Value> phi_values_;
+  ArenaVector<ArrayTable> arrays_;
   HOptimization_X86* opt_;
 };
 
@@ -680,8 +803,13 @@ void TrivialLoopEvaluator::Run() {
     // This container will hold all the evaluated values of the loop.
     TLEVisitor visitor(graph, this);
 
-    // Then, we will evaluate the loop if possible.
-    if (!EvaluateLoop(loop, visitor)) {
+    // Then, we will evaluate the loop if possible. Long loops are only evaluated
+    // when their values have a closed form.
+    if (loop->GetNumIterations(loop->GetHeader()) <= kLoopEvalMaxIter) {
+      if (!CollectArrays(loop, visitor) || !EvaluateLoop(loop, visitor)) {
+        continue;
+      }
+    } else if (!EvaluateClosedForm(loop, visitor)) {
       continue;
     }
 
@@ -742,10 +870,327 @@ bool TrivialLoopEvaluator::EvaluateLoop(HLoopInformation_X86* loop, TLEVisitor&
   return true;
 }
 
+// Users of a fresh array which may make it visible outside of the method.
+static bool IsPublication(HInstruction* reference, HInstruction* user) {
+  return user->IsInvoke() ||
+         (user->IsInstanceFieldSet() && user->InputAt(1) == reference) ||
+         (user->IsStaticFieldSet() && user->InputAt(1) == reference) ||
+         (user->IsArraySet() && user->InputAt(2) == reference);
+}
+
+bool TrivialLoopEvaluator::CollectArrays(HLoopInformation_X86* loop, TLEVisitor& visitor) {
+  HBasicBlock* exit_block = loop->GetExitBlock();
+  DCHECK(exit_block != nullptr);
+
+  for (HBlocksInLoopIterator it_loop(*loop); !it_loop.Done(); it_loop.Advance()) {
+    for (HInstructionIterator it(it_loop.Current()->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* insn = it.Current();
+      if (!insn->IsArrayGet() && !insn->IsArraySet() && !insn->IsArrayLength()) {
+        continue;
+      }
+      HInstruction* array = insn->InputAt(0);
+      if (visitor.FindArray(array) != nullptr) {
+        continue;
+      }
+
+      // Only arrays allocated zero-filled in this method, with a known small size.
+      if (!array->IsNewArray() ||
+          !array->AsNewArray()->GetLength()->IsIntConstant() ||
+          array->AsNewArray()->GetLength()->AsIntConstant()->GetValue() < 0 ||
+          array->AsNewArray()->GetLength()->AsIntConstant()->GetValue() > kLoopEvalMaxArrayLength) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Array " << array->GetId() << " is not a small fresh array.");
+        return false;
+      }
+
+      // The array is only zero-filled at loop entry if it is allocated again before each run of
+      // the loop: every loop around the allocation must also hold the pre-header.
+      HBasicBlock* pre_header = loop->GetPreHeader();
+      for (HLoopInformationOutwardIterator it_outer(*array->GetBlock());
+           !it_outer.Done();
+           it_outer.Advance()) {
+        if (!it_outer.Current()->Contains(*pre_header)) {
+          PRINT_PASS_OSTREAM_MESSAGE(this, "Array " << array->GetId() << " is allocated outside "
+                                           "an enclosing loop.");
+          return false;
+        }
+      }
+
+      // Nobody else may see the array before the loop has filled it.
+      bool is_singleton = false;
+      bool is_singleton_and_not_returned = false;
+      bool is_singleton_and_not_deopt_visible = false;
+      CalculateEscape(array,
+                      IsPublication,
+                      &is_singleton,
+                      &is_singleton_and_not_returned,
+                      &is_singleton_and_not_deopt_visible);
+      if (!is_singleton) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Array " << array->GetId() << " is aliased.");
+        return false;
+      }
+      Primitive::Type type = Primitive::kPrimVoid;
+      for (const HUseListNode<HInstruction*>& use : array->GetUses()) {
+        HInstruction* user = use.GetUser();
+        if (loop->Contains(*user->GetBlock())) {
+          if (use.GetIndex() != 0u ||
+              !(user->IsArrayGet() || user->IsArraySet() || user->IsArrayLength())) {
+            PRINT_PASS_OSTREAM_MESSAGE(this, "Array " << array->GetId() << " is used by "
+                                             << user->DebugName() << " in the loop.");
+            return false;
+          }
+          if (user->IsArraySet() && type == Primitive::kPrimVoid) {
+            type = user->AsArraySet()->GetComponentType();
+          } else if (user->IsArrayGet() && type == Primitive::kPrimVoid) {
+            type = user->GetType();
+          }
+        } else if ((IsPublication(array, user) || (user->IsArraySet() && use.GetIndex() == 0u)) &&
+                   !exit_block->Dominates(user->GetBlock())) {
+          PRINT_PASS_OSTREAM_MESSAGE(this, "Array " << array->GetId() << " is written or "
+                                           "published before the loop.");
+          return false;
+        }
+      }
+      if (type == Primitive::kPrimNot) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Array " << array->GetId() << " holds references.");
+        return false;
+      }
+
+      visitor.AddArray(array, array->AsNewArray()->GetLength()->AsIntConstant()->GetValue(), type);
+    }
+  }
+
+  return true;
+}
+
+// Returns m * (m - 1) / 2 modulo 2^64.
+static uint64_t TriangularNumber(uint64_t m) {
+  return (m % 2u == 0u) ? (m / 2u) * (m - 1u) : m * ((m - 1u) / 2u);
+}
+
+bool TrivialLoopEvaluator::EvaluateClosedForm(HLoopInformation_X86* loop, TLEVisitor& visitor) {
+  // The value of an instruction is a * iv + b, modulo the width of its type.
+  struct Affine {
+    uint64_t a;
+    uint64_t b;
+  };
+  // A phi accumulating delta, or minus delta, at each iteration.
+  struct Reduction {
+    HPhi* phi;
+    HInstruction* update;
+    uint64_t init;
+    Affine delta;
+    bool is_sub;
+    bool is_found;
+  };
+
+  HBasicBlock* header = loop->GetHeader();
+  HInductionVariable* iv = loop->GetBasicIV();
+  if (iv == nullptr || iv->IsFP()) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "No closed form: loop has no integer basic IV.");
+    return false;
+  }
+  HPhi* iv_phi = iv->GetPhiInsn();
+  Primitive::Type type = iv_phi->GetType();
+  HInstruction* start = loop->PhiInput(iv_phi, false);
+  if (!Primitive::IsIntOrLongType(type) || !start->IsConstant()) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "No closed form: IV does not start from a constant.");
+    return false;
+  }
+
+  ArenaAllocator* arena = graph_->GetArena();
+  ArenaSafeMap<HInstruction*, Affine> affine(std::less<HInstruction*>(), arena->Adapter());
+  ArenaVector<Reduction> reductions(arena->Adapter());
+  affine.Put(iv_phi, { 1u, 0u });
+
+  auto get_affine = [&affine, type](HInstruction* insn, Affine* result) {
+    if (insn->GetType() != type) {
+      return false;
+    }
+    if (insn->IsIntConstant() || insn->IsLongConstant()) {
+      *result = { 0u, static_cast<uint64_t>(Int64FromConstant(insn->AsConstant())) };
+      return true;
+    }
+    auto it = affine.find(insn);
+    if (it == affine.end()) {
+      return false;
+    }
+    *result = it->second;
+    return true;
+  };
+
+  // Is user the only user of insn in the loop?
+  auto is_only_user_in_loop = [loop](HInstruction* insn, HInstruction* user) {
+    for (const HUseListNode<HInstruction*>& use : insn->GetUses()) {
+      if (use.GetUser() != user && loop->Contains(*use.GetUser()->GetBlock())) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance()) {
+    HPhi* phi = it.Current()->AsPhi();
+    if (phi == iv_phi) {
+      continue;
+    }
+    HInstruction* init = loop->PhiInput(phi, false);
+    HInstruction* update = loop->PhiInput(phi, true);
+    if (phi->GetType() != type || init->GetType() != type || !init->IsConstant() ||
+        !is_only_user_in_loop(phi, update) || !is_only_user_in_loop(update, phi)) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "No closed form: phi " << phi->GetId()
+                                       << " is not a simple reduction.");
+      return false;
+    }
+    reductions.push_back({ phi, update,
+                           static_cast<uint64_t>(Int64FromConstant(init->AsConstant())),
+                           { 0u, 0u }, false, false });
+  }
+
+  for (HBlocksInLoopReversePostOrderIterator it_loop(*loop); !it_loop.Done(); it_loop.Advance()) {
+    HBasicBlock* block = it_loop.Current();
+    if (block != header && !block->GetPhis().IsEmpty()) {
+      PRINT_PASS_MESSAGE(this, "No closed form: loop has control flow merges.");
+      return false;
+    }
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* insn = it.Current();
+      if (insn->IsSuspendCheck() || insn->IsGoto() || insn->IsIf()) {
+        continue;
+      }
+      if (insn->IsCondition()) {
+        // The loop control, replaced by the number of iterations.
+        if (!insn->HasOnlyOneNonEnvironmentUse() || insn->HasEnvironmentUses() ||
+            !insn->GetUses().front().GetUser()->IsIf()) {
+          return false;
+        }
+        continue;
+      }
+
+      Reduction* reduction = nullptr;
+      for (Reduction& candidate : reductions) {
+        if (candidate.update == insn) {
+          reduction = &candidate;
+        }
+      }
+      if (reduction != nullptr) {
+        HInstruction* delta = nullptr;
+        if (insn->IsAdd() && insn->InputAt(0) == reduction->phi) {
+          delta = insn->InputAt(1);
+        } else if (insn->IsAdd() && insn->InputAt(1) == reduction->phi) {
+          delta = insn->InputAt(0);
+        } else if (insn->IsSub() && insn->InputAt(0) == reduction->phi) {
+          delta = insn->InputAt(1);
+          reduction->is_sub = true;
+        }
+        if (delta == nullptr || !get_affine(delta, &reduction->delta)) {
+          PRINT_PASS_OSTREAM_MESSAGE(this, "No closed form: " << insn->DebugName() << " "
+                                           << insn->GetId() << " is not an affine reduction.");
+          return false;
+        }
+        reduction->is_found = true;
+        continue;
+      }
+
+      Affine x = { 0u, 0u };
+      Affine y = { 0u, 0u };
+      bool is_affine = insn->GetType() == type &&
+                       (insn->IsAdd() || insn->IsSub() || insn->IsMul() || insn->IsShl() ||
+                        insn->IsNeg()) &&
+                       get_affine(insn->InputAt(0), &x);
+      if (is_affine && insn->IsShl()) {
+        is_affine = insn->InputAt(1)->IsIntConstant();
+      } else if (is_affine && !insn->IsNeg()) {
+        is_affine = get_affine(insn->InputAt(1), &y);
+      }
+      if (is_affine && insn->IsMul()) {
+        // One side must be a constant.
+        is_affine = (x.a == 0u || y.a == 0u);
+      }
+      if (!is_affine) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "No closed form: " << insn->DebugName() << " "
+                                         << insn->GetId() << " is not affine.");
+        return false;
+      }
+
+      Affine result;
+      switch (insn->GetKind()) {
+        case HInstruction::kAdd:
+          result = { x.a + y.a, x.b + y.b };
+          break;
+        case HInstruction::kSub:
+          result = { x.a - y.a, x.b - y.b };
+          break;
+        case HInstruction::kNeg:
+          result = { 0u - x.a, 0u - x.b };
+          break;
+        case HInstruction::kMul:
+          result = (x.a == 0u) ? Affine { x.b * y.a, x.b * y.b } : Affine { x.a * y.b, x.b * y.b };
+          break;
+        default: {
+          DCHECK(insn->IsShl());
+          int32_t distance = insn->InputAt(1)->AsIntConstant()->GetValue() &
+              (type == Primitive::kPrimLong ? kMaxLongShiftDistance : kMaxIntShiftDistance);
+          result = { x.a << distance, x.b << distance };
+          break;
+        }
+      }
+      affine.Put(insn, result);
+    }
+  }
+
+  for (const Reduction& reduction : reductions) {
+    if (!reduction.is_found) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "No closed form: phi " << reduction.phi->GetId()
+                                       << " is not updated in the loop.");
+      return false;
+    }
+  }
+
+  // Blocks other than the header run one time less when the loop exits from the header.
+  uint64_t num_iterations = static_cast<uint64_t>(loop->GetNumIterations(header));
+  DCHECK_GT(num_iterations, 1u);
+  HBasicBlock* exit_block = loop->GetExitBlock();
+  bool exits_from_header = ContainsElement(header->GetSuccessors(), exit_block);
+  auto last_execution = [=](HBasicBlock* block) {
+    return (exits_from_header && block != header) ? num_iterations - 2u : num_iterations - 1u;
+  };
+
+  uint64_t iv_start = static_cast<uint64_t>(Int64FromConstant(start->AsConstant()));
+  uint64_t increment = static_cast<uint64_t>(iv->GetIncrement());
+  auto make_value = [type](uint64_t value) {
+    return (type == Primitive::kPrimLong)
+        ? TLEVisitor::Value(static_cast<int64_t>(value))
+        : TLEVisitor::Value(static_cast<int32_t>(static_cast<uint32_t>(value)));
+  };
+
+  for (const auto& entry : affine) {
+    uint64_t k = last_execution(entry.first->GetBlock());
+    uint64_t iv_value = iv_start + increment * k;
+    visitor.SetValue(entry.first, make_value(entry.second.a * iv_value + entry.second.b));
+  }
+
+  // The sum of delta over the first m iterations.
+  auto sum = [=](const Affine& delta, uint64_t m) {
+    return m * (delta.a * iv_start + delta.b) + delta.a * increment * TriangularNumber(m);
+  };
+  for (const Reduction& reduction : reductions) {
+    uint64_t phi_sum = sum(reduction.delta, num_iterations - 1u);
+    uint64_t update_sum = sum(reduction.delta, last_execution(reduction.update->GetBlock()) + 1u);
+    if (reduction.is_sub) {
+      phi_sum = 0u - phi_sum;
+      update_sum = 0u - update_sum;
+    }
+    visitor.SetValue(reduction.phi, make_value(reduction.init + phi_sum));
+    visitor.SetValue(reduction.update, make_value(reduction.init + update_sum));
+  }
+
+  PRINT_PASS_OSTREAM_MESSAGE(this, "Closed form found for " << num_iterations << " iterations.");
+  return true;
+}
+
 void TrivialLoopEvaluator::UpdateRegisters(HLoopInformation_X86* loop,
                                            TLEVisitor& visitor) {
   DCHECK(loop != nullptr);
-  UNUSED(visitor);
 
   // We want to find all the users of the values we need to write back.
   // Then, we replace the corresponding input by the HConstant.
@@ -771,6 +1216,39 @@ void TrivialLoopEvaluator::UpdateRegisters(HLoopInformation_X86* loop,
       it.ReplaceInput(constant_node);
     }
   }
+
+  // The arrays filled by the loop get their final contents before it, as for an array literal.
+  // They were zero-filled, so only the other elements need a store.
+  HBasicBlock* pre_header = loop->GetPreHeader();
+  HInstruction* cursor = pre_header->GetLastInstruction();
+  for (const TLEVisitor::ArrayTable& table : visitor.GetArrays()) {
+    for (size_t i = 0, e = table.values.size(); i < e; ++i) {
+      TLEVisitor::Value value = table.values[i];
+      HConstant* constant = nullptr;
+      switch (table.type) {
+        case Primitive::kPrimLong:
+          constant = (value.l == 0) ? nullptr : graph_->GetLongConstant(value.l);
+          break;
+        case Primitive::kPrimFloat:
+          constant = (value.i == 0) ? nullptr : graph_->GetFloatConstant(value.f);
+          break;
+        case Primitive::kPrimDouble:
+          constant = (value.l == 0) ? nullptr : graph_->GetDoubleConstant(value.d);
+          break;
+        default:
+          constant = (value.i == 0) ? nullptr : graph_->GetIntConstant(value.i);
+          break;
+      }
+      if (!table.written[i] || constant == nullptr) {
+        continue;
+      }
+      HInstruction* index = graph_->GetIntConstant(static_cast<int32_t>(i));
+      pre_header->InsertInstructionBefore(
+          new (graph_->GetArena()) HArraySet(table.array, index, constant, table.type,
+                                             cursor->GetDexPc()),
+          cursor);
+    }
+  }
 }
 
 bool TrivialLoopEvaluator::LoopGate(HLoopInformation_X86* loop) {
@@ -801,14 +1279,6 @@ bool TrivialLoopEvaluator::LoopGate(HLoopInformation_X86* loop) {
     return false;
   }
 
-  // The iteration count must be smaller than the threshold we fixed in order to
-  // prevent increasing compile time too much.
-  if (loop->GetNumIterations(loop->GetHeader()) > kLoopEvalMaxIter) {
-    PRINT_PASS_OSTREAM_MESSAGE(this,
-        "Loop has too many iterations (max supported : " << kLoopEvalMaxIter << ").");
-    return false;
-  }
-
   return true;
 }
 
@@ -66,10 +66,31 @@ class TrivialLoopEvaluator : public HOptimization_X86 {
      */
     bool EvaluateLoop(HLoopInformation_X86* loop, TLEVisitor& visitor);
 
+    /**
+     * @brief Registers in the visitor the arrays the loop accesses, so that their
+     * contents can be evaluated too.
+     * @details Each array must be allocated in the method with a small constant length,
+     * hold primitives, and be neither published nor written before the loop.
+     * @param loop The HLoopInformation_X86 loop accessing the arrays.
+     * @param visitor The structure which will hold the contents of the arrays.
+     * @return True if all the arrays accessed by the loop can be evaluated, or false otherwise.
+     */
+    bool CollectArrays(HLoopInformation_X86* loop, TLEVisitor& visitor);
+
+    /**
+     * @brief Computes the values of a loop too long to be evaluated iteration per iteration.
+     * @details The values must be affine in the basic IV or sums of such values, so
+     * that their final values are polynomials in the number of iterations.
+     * @param loop The HLoopInformation_X86 loop this method will try to evaluate.
+     * @param visitor The structure which will hold the final values. It should be empty.
+     * @return True if TLE found a closed form for all the values, or false otherwise.
+     */
+    bool EvaluateClosedForm(HLoopInformation_X86* loop, TLEVisitor& visitor);
+
     /**
      * @brief This method deletes all the instructions in the loop's only BB,
      * it replaces them by the constant values previously evaluated by TLE, and deletes
-     * the backedge of the given loop.
+     * the backedge of the given loop. The evaluated arrays are filled in the pre-header.
      * @param loop The HLoopInformation_X86 loop previously evaluated successfully by TLE.
      * @param visitor The result structure holding values we need to write back.
      */
@@ -79,6 +100,10 @@ class TrivialLoopEvaluator : public HOptimization_X86 {
      * too costly to be statically evaluated. */
     static constexpr int64_t kLoopEvalMaxIter = 1000;
 
+    /** Maximum length of an array whose contents are evaluated. Each non-zero element
+     * costs a store in the generated code. */
+    static constexpr int32_t kLoopEvalMaxArrayLength = 1024;
+
     /** Copy and assignment are not allowed. */
     DISALLOW_COPY_AND_ASSIGN(TrivialLoopEvaluator);
 };
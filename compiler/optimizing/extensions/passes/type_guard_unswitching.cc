@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "type_guard_unswitching.h"
+
+#include <algorithm>
+
+#include "dead_code_elimination.h"
+#include "ext_utility.h"
+#include "find_ivs.h"
+#include "graph_x86.h"
+#include "loop_formation.h"
+#include "loop_iterators.h"
+#include "loop_versioning.h"
+
+namespace art {
+
+bool HTypeGuardUnswitching::CollectChecks(HLoopInformation_X86* loop,
+                                          HLoopVersioning* versioning) {
+  // The receivers checked, with their first guard.
+  ArenaVector<HInstruction*> values(graph_->GetArena()->Adapter(kArenaAllocMisc));
+  for (HBlocksInLoopIterator it_loop(*loop); !it_loop.Done(); it_loop.Advance()) {
+    HInstruction* insn = it_loop.Current()->GetLastInstruction();
+    // The guards with a deoptimization are hoisted by LICM, only the diamonds are left.
+    if (!insn->IsIf()) {
+      continue;
+    }
+    HInstanceFieldGet* get_class = nullptr;
+    HInstruction* value = nullptr;
+    HLoadClass* klass = nullptr;
+    if (!HLoopVersioning::GetTypeGuard(insn->InputAt(0), &get_class, &value, &klass)) {
+      continue;
+    }
+    if (loop->Contains(*value->GetBlock()) || loop->Contains(*klass->GetBlock())) {
+      PRINT_PASS_OSTREAM_MESSAGE(this, "Type guard " << insn->GetId() << " is not invariant");
+      continue;
+    }
+    if (std::find(values.begin(), values.end(), value) != values.end()) {
+      // Only the class of the first guard is checked, the others stay in the fast version.
+      continue;
+    }
+    if (values.size() == kMaxClassChecks) {
+      break;
+    }
+    values.push_back(value);
+    if (value->CanBeNull()) {
+      versioning->AddNotNullCheck(value);
+    }
+    versioning->AddClassCheck(get_class, value, klass);
+  }
+  return !values.empty();
+}
+
+void HTypeGuardUnswitching::Run() {
+  PRINT_PASS_MESSAGE(this, "start");
+
+  HGraph_X86* graph = GRAPH_TO_GRAPH_X86(graph_);
+  HLoopFormation formation(graph_);
+  formation.Run();
+
+  ArenaVector<HBasicBlock*> fast_headers = HLoopVersioning::VersionInnerLoops(
+      graph, this, [this](HLoopInformation_X86* loop, HLoopVersioning* versioning) {
+        PRINT_PASS_OSTREAM_MESSAGE(this, "Visit loop " << loop->GetHeader()->GetBlockId());
+        return CollectChecks(loop, versioning);
+      }, kMaxInstructionsUnswitched);
+  for (HBasicBlock* fast_header : fast_headers) {
+    PRINT_PASS_OSTREAM_MESSAGE(this, "Unswitched loop, fast version " << fast_header->GetBlockId()
+                                     << " of " << GetMethodName(graph_));
+    MaybeRecordStat(MethodCompilationStat::kIntelTypeGuardUnswitched);
+  }
+
+  if (!fast_headers.empty()) {
+    // Remove the branches of the folded guards, then bring the loops up to date.
+    HDeadCodeElimination dce(graph_, stats_, "dead_code_elimination$after_type_guard_unswitching");
+    dce.Run();
+    HLoopFormation form_loops(graph_);
+    form_loops.Run();
+    HFindInductionVariables find_ivs(graph_, "find_ivs_after_unswitching", stats_);
+    find_ivs.Run();
+  }
+  PRINT_PASS_MESSAGE(this, "end");
+}
+
+}  // namespace art
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_TYPE_GUARD_UNSWITCHING_H_
+#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_TYPE_GUARD_UNSWITCHING_H_
+
+#include "nodes.h"
+#include "optimization_x86.h"
+
+namespace art {
+
+// Forward declarations.
+class HLoopInformation_X86;
+class HLoopVersioning;
+
+/**
+ * @brief Unswitch inner loops on the type guards the inliner emits from the inline
+ * caches, when the guarded receiver is defined outside of the loop.
+ * @details The classes of the receivers are checked once, before the loop. In the
+ * fast version, the guards are folded: the inlined bodies become straight-line code
+ * that the loop passes see through, and the calls of the other branches are removed.
+ * The original loop is kept for the receivers of another class.
+ */
+class HTypeGuardUnswitching : public HOptimization_X86 {
+ public:
+  explicit HTypeGuardUnswitching(HGraph* graph, OptimizingCompilerStats* stats = nullptr)
+    : HOptimization_X86(graph, kTypeGuardUnswitchingPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  uint32_t GetInvalidatedAnalyses() const OVERRIDE {
+    // Unswitching clears the cached loops. The pass forms them again and finds their IVs
+    // after removing the branches of the folded guards.
+    return kAnalysisNone;
+  }
+
+ private:
+  /**
+   * @brief Find the class checks covering the type guards of loop.
+   * @return Returns true if at least one type guard can be folded.
+   */
+  bool CollectChecks(HLoopInformation_X86* loop, HLoopVersioning* versioning);
+
+  static constexpr const char* kTypeGuardUnswitchingPassName = "type_guard_unswitching";
+  // Above the default of HLoopVersioning: the guarded paths of the fast version, inlined
+  // calls included, are removed once their guards are folded.
+  static constexpr uint64_t kMaxInstructionsUnswitched = 96;
+  static constexpr size_t kMaxClassChecks = 2;
+
+  DISALLOW_COPY_AND_ASSIGN(HTypeGuardUnswitching);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_TYPE_GUARD_UNSWITCHING_H_
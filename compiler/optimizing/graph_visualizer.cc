@@ -528,6 +528,12 @@ class HGraphVisualizerPrinter : public HGraphDelegateVisitor {
     StartAttributeStream("kind") << deoptimize->GetKind();
   }
 
+  void VisitVecReduce(HVecReduce* reduce) OVERRIDE {
+    HVecReduce::ReductionKind kind = reduce->GetKind();
+    StartAttributeStream("kind")
+        << (kind == HVecReduce::kSum ? "sum" : (kind == HVecReduce::kMin ? "min" : "max"));
+  }
+
   void VisitVecHalvingAdd(HVecHalvingAdd* hadd) OVERRIDE {
     StartAttributeStream("unsigned") << std::boolalpha << hadd->IsUnsigned() << std::noboolalpha;
     StartAttributeStream("rounded") << std::boolalpha << hadd->IsRounded() << std::noboolalpha;
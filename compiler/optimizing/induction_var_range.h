@@ -143,6 +143,15 @@ class InductionVarRange {
     induction_analysis_->VisitLoop(loop);
   }
 
+  /**
+   * Checks if the given instruction has been classified by the induction analysis
+   * (any SCC with an invariant entry value has a cycle, classified or not).
+   */
+  bool IsClassified(HInstruction* instruction) const {
+    return induction_analysis_->LookupInfo(instruction->GetBlock()->GetLoopInformation(),
+                                           instruction) != nullptr;
+  }
+
   /**
    * Lookup an interesting cycle associated with an entry phi.
    */
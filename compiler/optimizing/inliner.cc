@@ -64,6 +64,11 @@ static constexpr size_t kMaximumNumberOfCumulatedDexRegisters = 32;
 // much inlining compared to code locality.
 static constexpr size_t kMaximumNumberOfRecursiveCalls = 4;
 
+// Factor of the code item size limit for the call sites of loops with a constant trip
+// count: their loop passes (full unrolling, load hoisting, suspend check removal) need
+// the loop body free of invokes.
+static constexpr size_t kCountedLoopInlineMaxCodeUnitsFactor = 2;
+
 // Controls the use of inline caches in AOT mode.
 static constexpr bool kUseAOTInlineCaches = true;
 
@@ -114,6 +119,49 @@ static size_t CountNumberOfInstructions(HGraph* graph) {
   return number_of_instructions;
 }
 
+// Is the input a constant or the phi of an induction variable stepping by a constant?
+static bool IsConstantOrConstantStepPhi(HInstruction* input, HBasicBlock* header) {
+  if (input->IsIntConstant() || input->IsLongConstant()) {
+    return true;
+  }
+  if (!input->IsPhi() || input->GetBlock() != header || input->InputCount() != 2) {
+    return false;
+  }
+  HInstruction* initial = input->InputAt(0);
+  HInstruction* update = input->InputAt(1);
+  if (!initial->IsIntConstant() && !initial->IsLongConstant()) {
+    return false;
+  }
+  if (!update->IsAdd() && !update->IsSub()) {
+    return false;
+  }
+  HBinaryOperation* step = update->AsBinaryOperation();
+  return step->GetLeft() == input && step->GetConstantRight() != nullptr;
+}
+
+// Returns the header of the loop of invoke if its trip count is a constant, nullptr otherwise.
+// The loops are not analyzed yet at inlining time, so only the simple pattern of a header
+// testing a constant step induction variable against a constant is recognized.
+static HBasicBlock* GetCountedLoopHeader(HInvoke* invoke) {
+  HLoopInformation* loop = invoke->GetBlock()->GetLoopInformation();
+  if (loop == nullptr || loop->IsIrreducible() || loop->NumberOfBackEdges() != 1u) {
+    return nullptr;
+  }
+  HBasicBlock* header = loop->GetHeader();
+  HInstruction* last = header->GetLastInstruction();
+  if (!last->IsIf() || !last->InputAt(0)->IsCondition()) {
+    return nullptr;
+  }
+  HCondition* condition = last->InputAt(0)->AsCondition();
+  HInstruction* left = condition->GetLeft();
+  HInstruction* right = condition->GetRight();
+  if (!IsConstantOrConstantStepPhi(left, header) || !IsConstantOrConstantStepPhi(right, header)) {
+    return nullptr;
+  }
+  // One side must be the induction variable.
+  return (left->IsPhi() || right->IsPhi()) ? header : nullptr;
+}
+
 void HInliner::UpdateInliningBudget() {
   if (total_number_of_instructions_ >= kMaximumNumberOfTotalInstructions) {
     // Always try to inline small methods.
@@ -1344,7 +1392,25 @@ bool HInliner::TryBuildAndInline(HInvoke* invoke_instruction,
     return false;
   }
 
+  if (compiler_driver_->IsNonInlinableMethod(
+          Thread::Current(), MethodReference(method->GetDexFile(), method->GetDexMethodIndex()))) {
+    LOG_FAIL(kNotInlinedKnownFailure)
+        << "Method " << method->PrettyMethod()
+        << " is not inlined because it already failed to build as a callee";
+    return false;
+  }
+
   size_t inline_max_code_units = compiler_driver_->GetCompilerOptions().GetInlineMaxCodeUnits();
+  // Only the loops of the outermost graph are kept track of, the ones of the callee
+  // graphs are not known to the loop passes.
+  HBasicBlock* counted_loop_header =
+      (outermost_graph_ == graph_) ? GetCountedLoopHeader(invoke_instruction) : nullptr;
+  bool boosted = false;
+  if (counted_loop_header != nullptr &&
+      code_item->insns_size_in_code_units_ > inline_max_code_units) {
+    inline_max_code_units *= kCountedLoopInlineMaxCodeUnitsFactor;
+    boosted = true;
+  }
   if (code_item->insns_size_in_code_units_ > inline_max_code_units) {
     LOG_FAIL(kNotInlinedCodeItem)
         << "Method " << method->PrettyMethod()
@@ -1396,6 +1462,11 @@ bool HInliner::TryBuildAndInline(HInvoke* invoke_instruction,
 
   LOG_SUCCESS() << method->PrettyMethod();
   MaybeRecordStat(kInlinedInvoke);
+  if (boosted) {
+    // Let the loop passes tell whether raising the budget paid off.
+    MaybeRecordStat(kInlinedInvokeInCountedLoop);
+    GRAPH_TO_GRAPH_X86(outermost_graph_)->AddBoostedInliningLoop(counted_loop_header);
+  }
   return true;
 }
 
@@ -1678,7 +1749,10 @@ bool HInliner::TryBuildAndInlineHelper(HInvoke* invoke_instruction,
                         dex_cache,
                         handles_);
 
+  // The following failures only depend on the callee, its other call sites will not try again.
+  MethodReference method_ref(&callee_dex_file, method_index);
   if (builder.BuildGraph() != kAnalysisSuccess) {
+    compiler_driver_->MarkNonInlinableMethod(soa.Self(), method_ref);
     LOG_FAIL(kNotInlinedCannotBuild)
         << "Method " << callee_dex_file.PrettyMethod(method_index)
         << " could not be built, so cannot be inlined";
@@ -1687,6 +1761,7 @@ bool HInliner::TryBuildAndInlineHelper(HInvoke* invoke_instruction,
 
   if (!RegisterAllocator::CanAllocateRegistersFor(*callee_graph,
                                                   compiler_driver_->GetInstructionSet())) {
+    compiler_driver_->MarkNonInlinableMethod(soa.Self(), method_ref);
     LOG_FAIL(kNotInlinedRegisterAllocator)
         << "Method " << callee_dex_file.PrettyMethod(method_index)
         << " cannot be inlined because of the register allocator";
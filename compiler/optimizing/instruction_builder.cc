@@ -2657,6 +2657,8 @@ bool HInstructionBuilder::ProcessDexInstruction(const Instruction& instruction,
     case Instruction::IGET_WIDE_QUICK:
     case Instruction::IGET_OBJECT:
     case Instruction::IGET_OBJECT_QUICK:
+    case Instruction::IGET_OBJECT_QUICK_IF_EQZ:
+    case Instruction::IGET_OBJECT_QUICK_IF_NEZ:
     case Instruction::IGET_BOOLEAN:
     case Instruction::IGET_BOOLEAN_QUICK:
     case Instruction::IGET_BYTE:
@@ -1902,6 +1902,8 @@ void InstructionSimplifierVisitor::SimplifySystemArrayCopy(HInvoke* instruction)
       // is unlikely that it exists. The most usual situation for such typed
       // arraycopy methods is a direct pointer to the boot image.
       HSharpening::SharpenInvokeStaticOrDirect(invoke, codegen_, compiler_driver_);
+      // The typed methods with an intrinsic are better served by it than by a call.
+      IntrinsicsRecognizer::Recognize(invoke);
     }
   }
 }
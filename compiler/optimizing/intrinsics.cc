@@ -133,30 +133,34 @@ static bool CheckInvokeType(Intrinsics intrinsic, HInvoke* invoke) {
   }
 }
 
+bool IntrinsicsRecognizer::Recognize(HInvoke* invoke) {
+  ArtMethod* art_method = invoke->GetResolvedMethod();
+  if (art_method == nullptr || !art_method->IsIntrinsic()) {
+    return false;
+  }
+  Intrinsics intrinsic = static_cast<Intrinsics>(art_method->GetIntrinsic());
+  if (!CheckInvokeType(intrinsic, invoke)) {
+    LOG(WARNING) << "Found an intrinsic with unexpected invoke type: "
+        << static_cast<uint32_t>(intrinsic) << " for "
+        << art_method->PrettyMethod()
+        << invoke->DebugName();
+    return false;
+  }
+  invoke->SetIntrinsic(intrinsic,
+                       NeedsEnvironmentOrCache(intrinsic),
+                       GetSideEffects(intrinsic),
+                       GetExceptions(intrinsic));
+  return true;
+}
+
 void IntrinsicsRecognizer::Run() {
   ScopedObjectAccess soa(Thread::Current());
   for (HBasicBlock* block : graph_->GetReversePostOrder()) {
     for (HInstructionIterator inst_it(block->GetInstructions()); !inst_it.Done();
          inst_it.Advance()) {
       HInstruction* inst = inst_it.Current();
-      if (inst->IsInvoke()) {
-        HInvoke* invoke = inst->AsInvoke();
-        ArtMethod* art_method = invoke->GetResolvedMethod();
-        if (art_method != nullptr && art_method->IsIntrinsic()) {
-          Intrinsics intrinsic = static_cast<Intrinsics>(art_method->GetIntrinsic());
-          if (!CheckInvokeType(intrinsic, invoke)) {
-            LOG(WARNING) << "Found an intrinsic with unexpected invoke type: "
-                << static_cast<uint32_t>(intrinsic) << " for "
-                << art_method->PrettyMethod()
-                << invoke->DebugName();
-          } else {
-            invoke->SetIntrinsic(intrinsic,
-                                 NeedsEnvironmentOrCache(intrinsic),
-                                 GetSideEffects(intrinsic),
-                                 GetExceptions(intrinsic));
-            MaybeRecordStat(MethodCompilationStat::kIntrinsicRecognized);
-          }
-        }
+      if (inst->IsInvoke() && Recognize(inst->AsInvoke())) {
+        MaybeRecordStat(MethodCompilationStat::kIntrinsicRecognized);
       }
     }
   }
@@ -42,6 +42,10 @@ class IntrinsicsRecognizer : public HOptimization {
 
   void Run() OVERRIDE;
 
+  // Mark `invoke` as the intrinsic of its resolved method, if the method is one.
+  // Returns whether it was marked.
+  static bool Recognize(HInvoke* invoke) REQUIRES_SHARED(Locks::mutator_lock_);
+
   static constexpr const char* kIntrinsicsRecognizerPassName = "intrinsics_recognition";
 
  private:
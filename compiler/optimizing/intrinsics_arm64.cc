@@ -3014,6 +3014,14 @@ UNIMPLEMENTED_INTRINSIC(ARM64, UnsafeGetAndSetInt)
 UNIMPLEMENTED_INTRINSIC(ARM64, UnsafeGetAndSetLong)
 UNIMPLEMENTED_INTRINSIC(ARM64, UnsafeGetAndSetObject)
 
+UNIMPLEMENTED_INTRINSIC(ARM64, ArraysEqualsByte)
+UNIMPLEMENTED_INTRINSIC(ARM64, SystemArrayCopyByte)
+UNIMPLEMENTED_INTRINSIC(ARM64, SystemArrayCopyInt)
+UNIMPLEMENTED_INTRINSIC(ARM64, SystemArrayCopyLong)
+UNIMPLEMENTED_INTRINSIC(ARM64, CRC32Update)
+UNIMPLEMENTED_INTRINSIC(ARM64, CRC32UpdateBytes)
+UNIMPLEMENTED_INTRINSIC(ARM64, SystemIdentityHashCode)
+
 UNREACHABLE_INTRINSICS(ARM64)
 
 #undef __
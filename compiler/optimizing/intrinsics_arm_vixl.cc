@@ -3145,6 +3145,14 @@ UNIMPLEMENTED_INTRINSIC(ARMVIXL, UnsafeGetAndSetInt)
 UNIMPLEMENTED_INTRINSIC(ARMVIXL, UnsafeGetAndSetLong)
 UNIMPLEMENTED_INTRINSIC(ARMVIXL, UnsafeGetAndSetObject)
 
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, ArraysEqualsByte)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, SystemArrayCopyByte)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, SystemArrayCopyInt)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, SystemArrayCopyLong)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, CRC32Update)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, CRC32UpdateBytes)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, SystemIdentityHashCode)
+
 UNREACHABLE_INTRINSICS(ARMVIXL)
 
 #undef __
@@ -3259,6 +3259,13 @@ UNIMPLEMENTED_INTRINSIC(MIPS, UnsafeGetAndSetLong)
 UNIMPLEMENTED_INTRINSIC(MIPS, UnsafeGetAndSetObject)
 
 UNIMPLEMENTED_INTRINSIC(MIPS, ThreadInterrupted)
+UNIMPLEMENTED_INTRINSIC(MIPS, ArraysEqualsByte)
+UNIMPLEMENTED_INTRINSIC(MIPS, SystemArrayCopyByte)
+UNIMPLEMENTED_INTRINSIC(MIPS, SystemArrayCopyInt)
+UNIMPLEMENTED_INTRINSIC(MIPS, SystemArrayCopyLong)
+UNIMPLEMENTED_INTRINSIC(MIPS, CRC32Update)
+UNIMPLEMENTED_INTRINSIC(MIPS, CRC32UpdateBytes)
+UNIMPLEMENTED_INTRINSIC(MIPS, SystemIdentityHashCode)
 
 UNREACHABLE_INTRINSICS(MIPS)
 
@@ -2623,6 +2623,13 @@ UNIMPLEMENTED_INTRINSIC(MIPS64, UnsafeGetAndSetLong)
 UNIMPLEMENTED_INTRINSIC(MIPS64, UnsafeGetAndSetObject)
 
 UNIMPLEMENTED_INTRINSIC(MIPS64, ThreadInterrupted)
+UNIMPLEMENTED_INTRINSIC(MIPS64, ArraysEqualsByte)
+UNIMPLEMENTED_INTRINSIC(MIPS64, SystemArrayCopyByte)
+UNIMPLEMENTED_INTRINSIC(MIPS64, SystemArrayCopyInt)
+UNIMPLEMENTED_INTRINSIC(MIPS64, SystemArrayCopyLong)
+UNIMPLEMENTED_INTRINSIC(MIPS64, CRC32Update)
+UNIMPLEMENTED_INTRINSIC(MIPS64, CRC32UpdateBytes)
+UNIMPLEMENTED_INTRINSIC(MIPS64, SystemIdentityHashCode)
 
 UNREACHABLE_INTRINSICS(MIPS64)
 
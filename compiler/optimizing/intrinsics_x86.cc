@@ -3392,6 +3392,14 @@ UNIMPLEMENTED_INTRINSIC(X86, UnsafeGetAndSetInt)
 UNIMPLEMENTED_INTRINSIC(X86, UnsafeGetAndSetLong)
 UNIMPLEMENTED_INTRINSIC(X86, UnsafeGetAndSetObject)
 
+UNIMPLEMENTED_INTRINSIC(X86, ArraysEqualsByte)
+UNIMPLEMENTED_INTRINSIC(X86, SystemArrayCopyByte)
+UNIMPLEMENTED_INTRINSIC(X86, SystemArrayCopyInt)
+UNIMPLEMENTED_INTRINSIC(X86, SystemArrayCopyLong)
+UNIMPLEMENTED_INTRINSIC(X86, CRC32Update)
+UNIMPLEMENTED_INTRINSIC(X86, CRC32UpdateBytes)
+UNIMPLEMENTED_INTRINSIC(X86, SystemIdentityHashCode)
+
 UNREACHABLE_INTRINSICS(X86)
 
 #undef __
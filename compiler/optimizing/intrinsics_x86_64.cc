@@ -16,8 +16,13 @@
 
 #include "intrinsics_x86_64.h"
 
+#include <algorithm>
 #include <limits>
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
 #include "arch/x86_64/instruction_set_features_x86_64.h"
 #include "art_method.h"
 #include "base/bit_utils.h"
@@ -30,6 +35,7 @@
 #include "mirror/object_array-inl.h"
 #include "mirror/reference.h"
 #include "mirror/string.h"
+#include "non_temporal_move.h"
 #include "scoped_thread_state_change-inl.h"
 #include "thread-current-inl.h"
 #include "utils/x86_64/assembler_x86_64.h"
@@ -925,7 +931,10 @@ void IntrinsicCodeGeneratorX86_64::VisitMathNextAfter(HInvoke* invoke) {
   GenFPToFPCall(invoke, codegen_, kQuickNextAfter);
 }
 
-void IntrinsicLocationsBuilderX86_64::VisitSystemArrayCopyChar(HInvoke* invoke) {
+// Copies of at most this many bytes are inlined as a few vector or scalar moves.
+static constexpr size_t kSystemArrayCopyInlineBytes = 32u;
+
+static void CreateSystemArrayCopyPrimitiveLocations(ArenaAllocator* arena, HInvoke* invoke) {
   // Check to see if we have known failures that will cause us to have to bail out
   // to the runtime, and just generate the runtime call directly.
   HIntConstant* src_pos = invoke->InputAt(1)->AsIntConstant();
@@ -948,9 +957,9 @@ void IntrinsicLocationsBuilderX86_64::VisitSystemArrayCopyChar(HInvoke* invoke)
     }
   }
 
-  LocationSummary* locations = new (arena_) LocationSummary(invoke,
-                                                            LocationSummary::kCallOnSlowPath,
-                                                            kIntrinsified);
+  LocationSummary* locations = new (arena) LocationSummary(invoke,
+                                                           LocationSummary::kCallOnSlowPath,
+                                                           kIntrinsified);
   // arraycopy(Object src, int src_pos, Object dest, int dest_pos, int length).
   locations->SetInAt(0, Location::RequiresRegister());
   locations->SetInAt(1, Location::RegisterOrConstant(invoke->InputAt(1)));
@@ -958,10 +967,29 @@ void IntrinsicLocationsBuilderX86_64::VisitSystemArrayCopyChar(HInvoke* invoke)
   locations->SetInAt(3, Location::RegisterOrConstant(invoke->InputAt(3)));
   locations->SetInAt(4, Location::RegisterOrConstant(invoke->InputAt(4)));
 
-  // And we need some temporaries.  We will use REP MOVSW, so we need fixed registers.
+  // And we need some temporaries.  We will use REP MOVS, so we need fixed registers.
   locations->AddTemp(Location::RegisterLocation(RSI));
   locations->AddTemp(Location::RegisterLocation(RDI));
   locations->AddTemp(Location::RegisterLocation(RCX));
+  // The inline and non-temporal copies move the data through these.
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitSystemArrayCopyChar(HInvoke* invoke) {
+  CreateSystemArrayCopyPrimitiveLocations(arena_, invoke);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitSystemArrayCopyByte(HInvoke* invoke) {
+  CreateSystemArrayCopyPrimitiveLocations(arena_, invoke);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitSystemArrayCopyInt(HInvoke* invoke) {
+  CreateSystemArrayCopyPrimitiveLocations(arena_, invoke);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitSystemArrayCopyLong(HInvoke* invoke) {
+  CreateSystemArrayCopyPrimitiveLocations(arena_, invoke);
 }
 
 static void CheckPosition(X86_64Assembler* assembler,
@@ -1028,8 +1056,98 @@ static void CheckPosition(X86_64Assembler* assembler,
   }
 }
 
-void IntrinsicCodeGeneratorX86_64::VisitSystemArrayCopyChar(HInvoke* invoke) {
-  X86_64Assembler* assembler = GetAssembler();
+// Move size bytes, up to 16, from src to dest, through temp or xmm_temp.
+static void GenerateArrayCopyMove(X86_64Assembler* assembler,
+                                  const Address& dest,
+                                  const Address& src,
+                                  size_t size,
+                                  CpuRegister temp,
+                                  XmmRegister xmm_temp) {
+  switch (size) {
+    case 16:
+      __ movdqu(xmm_temp, src);
+      __ movdqu(dest, xmm_temp);
+      break;
+    case 8:
+      __ movq(temp, src);
+      __ movq(dest, temp);
+      break;
+    case 4:
+      __ movl(temp, src);
+      __ movl(dest, temp);
+      break;
+    case 2:
+      __ movzxw(temp, src);
+      __ movw(dest, temp);
+      break;
+    case 1:
+      __ movzxb(temp, src);
+      __ movb(dest, temp);
+      break;
+    default:
+      LOG(FATAL) << "Unexpected move size " << size;
+      UNREACHABLE();
+  }
+}
+
+// Copy the bytes, at most kSystemArrayCopyInlineBytes, from src_base to dest_base without a
+// loop: a size class moves its first and last size bytes, which may overlap. The bytes are a
+// multiple of element_size, which is the smallest class.
+static void GenerateArrayCopyInline(X86_64Assembler* assembler,
+                                    CpuRegister src_base,
+                                    CpuRegister dest_base,
+                                    CpuRegister bytes,
+                                    size_t element_size,
+                                    CpuRegister temp,
+                                    XmmRegister xmm_temp,
+                                    Label* done) {
+  for (size_t size = 16u; size > element_size; size /= 2u) {
+    NearLabel smaller;
+    __ cmpl(bytes, Immediate(size));
+    __ j(kLess, &smaller);
+    GenerateArrayCopyMove(assembler, Address(dest_base, 0), Address(src_base, 0), size,
+                          temp, xmm_temp);
+    GenerateArrayCopyMove(assembler,
+                          Address(dest_base, bytes, TIMES_1, -static_cast<int32_t>(size)),
+                          Address(src_base, bytes, TIMES_1, -static_cast<int32_t>(size)),
+                          size,
+                          temp,
+                          xmm_temp);
+    __ jmp(done);
+    __ Bind(&smaller);
+  }
+  __ testl(bytes, bytes);
+  __ j(kZero, done);
+  GenerateArrayCopyMove(assembler, Address(dest_base, 0), Address(src_base, 0), element_size,
+                        temp, xmm_temp);
+}
+
+// Copy the constant number of bytes, at most kSystemArrayCopyInlineBytes, from src_base to
+// dest_base: the largest size class that fits moves the first and last bytes.
+static void GenerateArrayCopyInlineConstant(X86_64Assembler* assembler,
+                                            CpuRegister src_base,
+                                            CpuRegister dest_base,
+                                            size_t bytes,
+                                            CpuRegister temp,
+                                            XmmRegister xmm_temp) {
+  if (bytes == 0u) {
+    return;
+  }
+  size_t size = bytes >= 16u ? 16u : HighestOneBitValue(bytes);
+  GenerateArrayCopyMove(assembler, Address(dest_base, 0), Address(src_base, 0), size,
+                        temp, xmm_temp);
+  if (bytes != size) {
+    int32_t last = static_cast<int32_t>(bytes - size);
+    GenerateArrayCopyMove(assembler, Address(dest_base, last), Address(src_base, last), size,
+                          temp, xmm_temp);
+  }
+}
+
+static void GenSystemArrayCopyPrimitive(HInvoke* invoke,
+                                        CodeGeneratorX86_64* codegen,
+                                        ArenaAllocator* allocator,
+                                        Primitive::Type type) {
+  X86_64Assembler* assembler = codegen->GetAssembler();
   LocationSummary* locations = invoke->GetLocations();
 
   CpuRegister src = locations->InAt(0).AsRegister<CpuRegister>();
@@ -1038,16 +1156,18 @@ void IntrinsicCodeGeneratorX86_64::VisitSystemArrayCopyChar(HInvoke* invoke) {
   Location dest_pos = locations->InAt(3);
   Location length = locations->InAt(4);
 
-  // Temporaries that we need for MOVSW.
+  // Temporaries that we need for MOVS.
   CpuRegister src_base = locations->GetTemp(0).AsRegister<CpuRegister>();
   DCHECK_EQ(src_base.AsRegister(), RSI);
   CpuRegister dest_base = locations->GetTemp(1).AsRegister<CpuRegister>();
   DCHECK_EQ(dest_base.AsRegister(), RDI);
   CpuRegister count = locations->GetTemp(2).AsRegister<CpuRegister>();
   DCHECK_EQ(count.AsRegister(), RCX);
+  CpuRegister temp = locations->GetTemp(3).AsRegister<CpuRegister>();
+  XmmRegister xmm_temp = locations->GetTemp(4).AsFpuRegister<XmmRegister>();
 
-  SlowPathCode* slow_path = new (GetAllocator()) IntrinsicSlowPathX86_64(invoke);
-  codegen_->AddSlowPath(slow_path);
+  SlowPathCode* slow_path = new (allocator) IntrinsicSlowPathX86_64(invoke);
+  codegen->AddSlowPath(slow_path);
 
   // Bail out if the source and destination are the same.
   __ cmpl(src, dest);
@@ -1074,41 +1194,143 @@ void IntrinsicCodeGeneratorX86_64::VisitSystemArrayCopyChar(HInvoke* invoke) {
   // Validity checks: dest. Use src_base as a temporary register.
   CheckPosition(assembler, dest_pos, dest, length, slow_path, src_base);
 
-  // We need the count in RCX.
-  if (length.IsConstant()) {
-    __ movl(count, Immediate(length.GetConstant()->AsIntConstant()->GetValue()));
-  } else {
-    __ movl(count, length.AsRegister<CpuRegister>());
-  }
-
   // Okay, everything checks out.  Finally time to do the copy.
-  // Check assumption that sizeof(Char) is 2 (used in scaling below).
-  const size_t char_size = Primitive::ComponentSize(Primitive::kPrimChar);
-  DCHECK_EQ(char_size, 2u);
-
-  const uint32_t data_offset = mirror::Array::DataOffset(char_size).Uint32Value();
+  const size_t element_size = Primitive::ComponentSize(type);
+  const ScaleFactor scale = static_cast<ScaleFactor>(Primitive::ComponentSizeShift(type));
+  const uint32_t data_offset = mirror::Array::DataOffset(element_size).Uint32Value();
 
   if (src_pos.IsConstant()) {
     int32_t src_pos_const = src_pos.GetConstant()->AsIntConstant()->GetValue();
-    __ leal(src_base, Address(src, char_size * src_pos_const + data_offset));
+    __ leal(src_base, Address(src, element_size * src_pos_const + data_offset));
   } else {
-    __ leal(src_base, Address(src, src_pos.AsRegister<CpuRegister>(),
-                              ScaleFactor::TIMES_2, data_offset));
+    __ leal(src_base, Address(src, src_pos.AsRegister<CpuRegister>(), scale, data_offset));
   }
   if (dest_pos.IsConstant()) {
     int32_t dest_pos_const = dest_pos.GetConstant()->AsIntConstant()->GetValue();
-    __ leal(dest_base, Address(dest, char_size * dest_pos_const + data_offset));
+    __ leal(dest_base, Address(dest, element_size * dest_pos_const + data_offset));
   } else {
-    __ leal(dest_base, Address(dest, dest_pos.AsRegister<CpuRegister>(),
-                               ScaleFactor::TIMES_2, data_offset));
+    __ leal(dest_base, Address(dest, dest_pos.AsRegister<CpuRegister>(), scale, data_offset));
   }
 
-  // Do the move.
-  __ rep_movsw();
+  // Pick the copy by the number of bytes. The short ones are done inline, the ones that would
+  // evict a good part of the last level cache bypass it with non-temporal stores, and the rest
+  // use REP MOVS, which is fastest on bytes with the enhanced REP MOVSB of the CPU.
+  const X86_64InstructionSetFeatures& features = codegen->GetInstructionSetFeatures();
+  const int32_t non_temporal_bytes = static_cast<int32_t>(std::min<uint64_t>(
+      HNonTemporalMove::GetLastLevelCacheSize(&features) / 2u,
+      std::numeric_limits<int32_t>::max()));
+  const bool use_movsb = HNonTemporalMove::HasEnhancedRepMovsb(&features);
+  bool inline_copy = true;
+  bool non_temporal_copy = true;
+  bool rep_movs_copy = true;
+  if (length.IsConstant()) {
+    uint64_t bytes = static_cast<uint64_t>(length.GetConstant()->AsIntConstant()->GetValue())
+        << scale;
+    inline_copy = bytes <= kSystemArrayCopyInlineBytes;
+    non_temporal_copy = !inline_copy && bytes > static_cast<uint64_t>(non_temporal_bytes);
+    rep_movs_copy = !inline_copy && !non_temporal_copy;
+    if (inline_copy) {
+      GenerateArrayCopyInlineConstant(assembler, src_base, dest_base, bytes, temp, xmm_temp);
+      __ Bind(slow_path->GetExitLabel());
+      return;
+    }
+    __ movl(count, Immediate(length.GetConstant()->AsIntConstant()->GetValue()));
+  } else {
+    __ movl(count, length.AsRegister<CpuRegister>());
+  }
+
+  // The count of bytes in RCX, shifted in 64 bits as it may not fit in 32.
+  if (scale != TIMES_1) {
+    __ shlq(count, Immediate(scale));
+  }
+
+  Label done;
+  Label non_temporal;
+  if (!length.IsConstant()) {
+    NearLabel not_inline;
+    __ cmpq(count, Immediate(kSystemArrayCopyInlineBytes));
+    __ j(kAbove, &not_inline);
+    GenerateArrayCopyInline(assembler, src_base, dest_base, count, element_size, temp, xmm_temp,
+                            &done);
+    __ jmp(&done);
+    __ Bind(&not_inline);
+    __ cmpq(count, Immediate(non_temporal_bytes));
+    __ j(kAbove, &non_temporal);
+  }
+
+  if (rep_movs_copy) {
+    if (use_movsb || scale == TIMES_1) {
+      __ rep_movsb();
+    } else {
+      __ shrq(count, Immediate(scale));
+      switch (scale) {
+        case TIMES_2:
+          __ rep_movsw();
+          break;
+        case TIMES_4:
+          __ rep_movsl();
+          break;
+        case TIMES_8:
+          __ rep_movsq();
+          break;
+        default:
+          LOG(FATAL) << "Unexpected scale " << scale;
+          UNREACHABLE();
+      }
+    }
+    if (non_temporal_copy) {
+      __ jmp(&done);
+    }
+  }
 
+  if (non_temporal_copy) {
+    // Copy the quadwords with non-temporal stores, then the remaining bytes with REP MOVSB.
+    __ Bind(&non_temporal);
+    NearLabel loop;
+    __ shrq(count, Immediate(3));
+    __ Bind(&loop);
+    __ movq(temp, Address(src_base, 0));
+    __ movntq(Address(dest_base, 0), temp);
+    __ addq(src_base, Immediate(8));
+    __ addq(dest_base, Immediate(8));
+    __ subq(count, Immediate(1));
+    __ j(kNotZero, &loop);
+    if (scale != TIMES_8) {
+      if (length.IsConstant()) {
+        __ movl(count, Immediate(length.GetConstant()->AsIntConstant()->GetValue()));
+      } else {
+        __ movl(count, length.AsRegister<CpuRegister>());
+      }
+      if (scale != TIMES_1) {
+        __ shll(count, Immediate(scale));
+      }
+      __ andl(count, Immediate(7));
+      __ rep_movsb();
+    }
+    // Order the non-temporal stores with the following ones.
+    codegen->MemoryFence(/* non-temporal */ true);
+  }
+
+  __ Bind(&done);
   __ Bind(slow_path->GetExitLabel());
 }
 
+void IntrinsicCodeGeneratorX86_64::VisitSystemArrayCopyChar(HInvoke* invoke) {
+  GenSystemArrayCopyPrimitive(invoke, codegen_, GetAllocator(), Primitive::kPrimChar);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitSystemArrayCopyByte(HInvoke* invoke) {
+  GenSystemArrayCopyPrimitive(invoke, codegen_, GetAllocator(), Primitive::kPrimByte);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitSystemArrayCopyInt(HInvoke* invoke) {
+  GenSystemArrayCopyPrimitive(invoke, codegen_, GetAllocator(), Primitive::kPrimInt);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitSystemArrayCopyLong(HInvoke* invoke) {
+  GenSystemArrayCopyPrimitive(invoke, codegen_, GetAllocator(), Primitive::kPrimLong);
+}
+
 
 void IntrinsicLocationsBuilderX86_64::VisitSystemArrayCopy(HInvoke* invoke) {
   // The only read barrier implementation supporting the
@@ -1505,6 +1727,269 @@ void IntrinsicCodeGeneratorX86_64::VisitSystemArrayCopy(HInvoke* invoke) {
   __ Bind(intrinsic_slow_path->GetExitLabel());
 }
 
+// The size of the blocks compared at a time by the vector loops of String.equals,
+// String.compareTo and Arrays.equals, or 0 when they keep their scalar code.
+static size_t GetCompareBlockSize(CodeGeneratorX86_64* codegen) {
+  const X86_64InstructionSetFeatures& features = codegen->GetInstructionSetFeatures();
+  if (features.HasAVX2()) {
+    return 32u;
+  } else if (features.HasSSE4_1()) {
+    return 16u;
+  }
+  return 0u;
+}
+
+// Clear the upper halves of the YMM registers written by the 32-byte blocks. The graphs with
+// AVX2 vectors keep them dirty and clear them when leaving the method.
+static void MaybeClearUpperHalves(CodeGeneratorX86_64* codegen, size_t block_size) {
+  if (block_size == 32u && !codegen->HasAVX2Vectors()) {
+    codegen->GetAssembler()->vzeroupper();
+  }
+}
+
+static void AddCompareBlockTemps(CodeGeneratorX86_64* codegen, LocationSummary* locations) {
+  if (GetCompareBlockSize(codegen) != 0u) {
+    locations->AddTemp(Location::RequiresFpuRegister());
+    locations->AddTemp(Location::RequiresFpuRegister());
+  }
+}
+
+// Set the zero flag if the blocks at `src1` and `src2` are equal.
+static void GenerateBlockEquals(X86_64Assembler* assembler,
+                                size_t block_size,
+                                const Address& src1,
+                                const Address& src2,
+                                XmmRegister temp1,
+                                XmmRegister temp2) {
+  if (block_size == 32u) {
+    __ vmovdqu(temp1, src1);
+    __ vmovdqu(temp2, src2);
+    __ vpxor(temp1, temp1, temp2);
+    __ vptest(temp1, temp1);
+  } else {
+    DCHECK_EQ(block_size, 16u);
+    __ movdqu(temp1, src1);
+    __ movdqu(temp2, src2);
+    __ pxor(temp1, temp2);
+    __ ptest(temp1, temp1);
+  }
+}
+
+// Set in `mask` one bit for each equal byte of the blocks at `src1` and `src2`.
+static void GenerateBlockMask(X86_64Assembler* assembler,
+                              size_t block_size,
+                              const Address& src1,
+                              const Address& src2,
+                              XmmRegister temp1,
+                              XmmRegister temp2,
+                              CpuRegister mask) {
+  if (block_size == 32u) {
+    __ vmovdqu(temp1, src1);
+    __ vmovdqu(temp2, src2);
+    __ vpcmpeqb(temp1, temp1, temp2);
+    __ vpmovmskb(mask, temp1);
+  } else {
+    DCHECK_EQ(block_size, 16u);
+    __ movdqu(temp1, src1);
+    __ movdqu(temp2, src2);
+    __ pcmpeqb(temp1, temp2);
+    __ pmovmskb(mask, temp1);
+  }
+}
+
+// Compare the `length` bytes at `offset` in `obj1` and `obj2`, and jump to `not_equal` if they
+// differ. `length` must be a non-zero multiple of 8 that the objects are zero padded to.
+// Lengths of at least a block are compared a block at a time, the last block overlapping its
+// predecessor when the length is not a multiple of the block size. Shorter lengths are
+// compared 8 bytes at a time by repe cmpsq, which is why `length`, `rsi` and `rdi` must be
+// RCX, RSI and RDI. All three are clobbered.
+static void GenerateMemoryEquals(CodeGeneratorX86_64* codegen,
+                                 CpuRegister obj1,
+                                 CpuRegister obj2,
+                                 uint32_t offset,
+                                 CpuRegister length,
+                                 CpuRegister rsi,
+                                 CpuRegister rdi,
+                                 LocationSummary* locations,
+                                 size_t first_vector_temp,
+                                 Label* not_equal) {
+  X86_64Assembler* assembler = codegen->GetAssembler();
+  DCHECK_EQ(length.AsRegister(), RCX);
+  DCHECK_EQ(rsi.AsRegister(), RSI);
+  DCHECK_EQ(rdi.AsRegister(), RDI);
+
+  NearLabel done;
+  size_t block_size = GetCompareBlockSize(codegen);
+  if (block_size != 0u) {
+    XmmRegister temp1 = locations->GetTemp(first_vector_temp).AsFpuRegister<XmmRegister>();
+    XmmRegister temp2 = locations->GetTemp(first_vector_temp + 1).AsFpuRegister<XmmRegister>();
+    NearLabel words, loop, loop_test;
+    __ cmpl(length, Immediate(block_size));
+    __ j(kLess, &words);
+    // `length` becomes the position of the last block, and RDI the position of the next one.
+    __ subl(length, Immediate(block_size));
+    __ xorl(rdi, rdi);
+    __ jmp(&loop_test);
+    __ Bind(&loop);
+    GenerateBlockEquals(assembler,
+                        block_size,
+                        Address(obj1, rdi, TIMES_1, offset),
+                        Address(obj2, rdi, TIMES_1, offset),
+                        temp1,
+                        temp2);
+    __ j(kNotZero, not_equal);
+    __ addl(rdi, Immediate(block_size));
+    __ Bind(&loop_test);
+    __ cmpl(rdi, length);
+    __ j(kLess, &loop);
+    GenerateBlockEquals(assembler,
+                        block_size,
+                        Address(obj1, length, TIMES_1, offset),
+                        Address(obj2, length, TIMES_1, offset),
+                        temp1,
+                        temp2);
+    __ j(kNotZero, not_equal);
+    __ jmp(&done);
+    __ Bind(&words);
+  }
+
+  __ shrl(length, Immediate(3));
+  __ leal(rsi, Address(obj1, offset));
+  __ leal(rdi, Address(obj2, offset));
+  // If the memory is not equal, the zero flag will be cleared.
+  __ repe_cmpsq();
+  __ j(kNotEqual, not_equal);
+  __ Bind(&done);
+}
+
+// Compare two strings of the same compression, setting `out` to the difference of their first
+// different characters, or of their lengths if one is a prefix of the other, and jump to `end`.
+// Strings of different compression jump to `call_runtime` instead. The common prefix is
+// compared a block at a time, prefixes shorter than a block a byte at a time.
+static void GenerateStringCompareTo(CodeGeneratorX86_64* codegen,
+                                    LocationSummary* locations,
+                                    Label* call_runtime,
+                                    Label* end) {
+  X86_64Assembler* assembler = codegen->GetAssembler();
+  size_t block_size = GetCompareBlockSize(codegen);
+  DCHECK_NE(block_size, 0u);
+
+  CpuRegister str = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister arg = locations->InAt(1).AsRegister<CpuRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+  CpuRegister length = locations->GetTemp(0).AsRegister<CpuRegister>();
+  CpuRegister offset = locations->GetTemp(1).AsRegister<CpuRegister>();
+  CpuRegister temp1 = locations->GetTemp(2).AsRegister<CpuRegister>();
+  CpuRegister temp2 = locations->GetTemp(3).AsRegister<CpuRegister>();
+  XmmRegister vtemp1 = locations->GetTemp(4).AsFpuRegister<XmmRegister>();
+  XmmRegister vtemp2 = locations->GetTemp(5).AsFpuRegister<XmmRegister>();
+
+  const uint32_t count_offset = mirror::String::CountOffset().Uint32Value();
+  const uint32_t value_offset = mirror::String::ValueOffset().Uint32Value();
+
+  // Same reference, the strings are equal.
+  __ xorl(out, out);
+  __ cmpl(str, arg);
+  __ j(kEqual, end);
+
+  __ movl(length, Address(str, count_offset));
+  __ movl(offset, Address(arg, count_offset));
+  if (mirror::kUseStringCompression) {
+    __ movl(temp1, length);
+    __ xorl(temp1, offset);
+    __ testl(temp1, Immediate(1));
+    __ j(kNotZero, call_runtime);
+    __ shrl(length, Immediate(1));
+    __ shrl(offset, Immediate(1));
+  }
+  // The result if one string is a prefix of the other.
+  __ movl(out, length);
+  __ subl(out, offset);
+  // The number of bytes of the shorter string.
+  __ cmpl(length, offset);
+  __ cmov(kGreater, length, offset, /* is64bit */ false);
+  if (mirror::kUseStringCompression) {
+    NearLabel compressed;
+    __ testb(Address(str, count_offset), Immediate(1));
+    __ j(kZero, &compressed);
+    __ addl(length, length);
+    __ Bind(&compressed);
+  } else {
+    __ addl(length, length);
+  }
+
+  Label bytes, found_block, found_byte;
+  NearLabel loop, loop_test;
+  __ xorl(offset, offset);
+  __ cmpl(length, Immediate(block_size));
+  __ j(kLess, &bytes);
+  // `length` becomes the position of the last block, which may overlap its predecessor:
+  // the bytes before the position reached are known equal, so the first different byte of
+  // the last block is still the first different byte of the strings.
+  __ subl(length, Immediate(block_size));
+  const int32_t all_equal = (block_size == 32u) ? -1 : 0xffff;
+  __ jmp(&loop_test);
+  __ Bind(&loop);
+  GenerateBlockMask(assembler,
+                    block_size,
+                    Address(str, offset, TIMES_1, value_offset),
+                    Address(arg, offset, TIMES_1, value_offset),
+                    vtemp1,
+                    vtemp2,
+                    temp1);
+  __ cmpl(temp1, Immediate(all_equal));
+  __ j(kNotEqual, &found_block);
+  __ addl(offset, Immediate(block_size));
+  __ Bind(&loop_test);
+  __ cmpl(offset, length);
+  __ j(kLess, &loop);
+  __ movl(offset, length);
+  GenerateBlockMask(assembler,
+                    block_size,
+                    Address(str, offset, TIMES_1, value_offset),
+                    Address(arg, offset, TIMES_1, value_offset),
+                    vtemp1,
+                    vtemp2,
+                    temp1);
+  __ cmpl(temp1, Immediate(all_equal));
+  __ j(kEqual, end);
+  __ Bind(&found_block);
+  // The first different byte of the block is the lowest clear bit of the mask.
+  __ notl(temp1);
+  __ bsfl(temp1, temp1);
+  __ addl(offset, temp1);
+  __ jmp(&found_byte);
+
+  // Compare the strings shorter than a block a byte at a time.
+  __ Bind(&bytes);
+  __ cmpl(offset, length);
+  __ j(kGreaterEqual, end);
+  __ movzxb(temp1, Address(str, offset, TIMES_1, value_offset));
+  __ movzxb(temp2, Address(arg, offset, TIMES_1, value_offset));
+  __ cmpl(temp1, temp2);
+  __ j(kNotEqual, &found_byte);
+  __ addl(offset, Immediate(1));
+  __ jmp(&bytes);
+
+  // Subtract the characters holding the first different byte.
+  __ Bind(&found_byte);
+  if (mirror::kUseStringCompression) {
+    NearLabel uncompressed;
+    __ testb(Address(str, count_offset), Immediate(1));
+    __ j(kNotZero, &uncompressed);
+    __ movzxb(out, Address(str, offset, TIMES_1, value_offset));
+    __ movzxb(temp1, Address(arg, offset, TIMES_1, value_offset));
+    __ subl(out, temp1);
+    __ jmp(end);
+    __ Bind(&uncompressed);
+  }
+  __ andl(offset, Immediate(-2));
+  __ movzxw(out, Address(str, offset, TIMES_1, value_offset));
+  __ movzxw(temp1, Address(arg, offset, TIMES_1, value_offset));
+  __ subl(out, temp1);
+  __ jmp(end);
+}
+
 void IntrinsicLocationsBuilderX86_64::VisitStringCompareTo(HInvoke* invoke) {
   LocationSummary* locations = new (arena_) LocationSummary(invoke,
                                                             LocationSummary::kCallOnMainAndSlowPath,
@@ -1513,6 +1998,15 @@ void IntrinsicLocationsBuilderX86_64::VisitStringCompareTo(HInvoke* invoke) {
   locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
   locations->SetInAt(1, Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
   locations->SetOut(Location::RegisterLocation(RAX));
+  if (GetCompareBlockSize(codegen_) != 0u) {
+    // Temporaries of the inline comparison, clobbered by the runtime call anyway.
+    locations->AddTemp(Location::RegisterLocation(RCX));
+    locations->AddTemp(Location::RegisterLocation(RDX));
+    locations->AddTemp(Location::RegisterLocation(R8));
+    locations->AddTemp(Location::RegisterLocation(R9));
+    locations->AddTemp(Location::FpuRegisterLocation(XMM0));
+    locations->AddTemp(Location::FpuRegisterLocation(XMM1));
+  }
 }
 
 void IntrinsicCodeGeneratorX86_64::VisitStringCompareTo(HInvoke* invoke) {
@@ -1528,8 +2022,17 @@ void IntrinsicCodeGeneratorX86_64::VisitStringCompareTo(HInvoke* invoke) {
   codegen_->AddSlowPath(slow_path);
   __ j(kEqual, slow_path->GetEntryLabel());
 
+  size_t block_size = GetCompareBlockSize(codegen_);
+  Label end;
+  if (block_size != 0u) {
+    Label call_runtime;
+    GenerateStringCompareTo(codegen_, locations, &call_runtime, &end);
+    __ Bind(&call_runtime);
+  }
   codegen_->InvokeRuntime(kQuickStringCompareTo, invoke, invoke->GetDexPc(), slow_path);
+  __ Bind(&end);
   __ Bind(slow_path->GetExitLabel());
+  MaybeClearUpperHalves(codegen_, block_size);
 }
 
 void IntrinsicLocationsBuilderX86_64::VisitStringEquals(HInvoke* invoke) {
@@ -1545,6 +2048,7 @@ void IntrinsicLocationsBuilderX86_64::VisitStringEquals(HInvoke* invoke) {
 
   // Set output, RSI needed for repe_cmpsq instruction anyways.
   locations->SetOut(Location::RegisterLocation(RSI), Location::kOutputOverlap);
+  AddCompareBlockTemps(codegen_, locations);
 }
 
 void IntrinsicCodeGeneratorX86_64::VisitStringEquals(HInvoke* invoke) {
@@ -1557,7 +2061,8 @@ void IntrinsicCodeGeneratorX86_64::VisitStringEquals(HInvoke* invoke) {
   CpuRegister rdi = locations->GetTemp(1).AsRegister<CpuRegister>();
   CpuRegister rsi = locations->Out().AsRegister<CpuRegister>();
 
-  NearLabel end, return_true, return_false;
+  NearLabel end;
+  Label return_true, return_false;
 
   // Get offsets of count, value, and class fields within a string object.
   const uint32_t count_offset = mirror::String::CountOffset().Uint32Value();
@@ -1598,7 +2103,8 @@ void IntrinsicCodeGeneratorX86_64::VisitStringEquals(HInvoke* invoke) {
   // Return true if both strings are empty. Even with string compression `count == 0` means empty.
   static_assert(static_cast<uint32_t>(mirror::StringCompressionFlag::kCompressed) == 0u,
                 "Expecting 0=compressed, 1=uncompressed");
-  __ jrcxz(&return_true);
+  __ testl(rcx, rcx);
+  __ j(kZero, &return_true);
 
   if (mirror::kUseStringCompression) {
     NearLabel string_uncompressed;
@@ -1612,23 +2118,27 @@ void IntrinsicCodeGeneratorX86_64::VisitStringEquals(HInvoke* invoke) {
     __ shrl(rcx, Immediate(1));
     __ Bind(&string_uncompressed);
   }
-  // Load starting addresses of string values into RSI/RDI as required for repe_cmpsq instruction.
-  __ leal(rsi, Address(str, value_offset));
-  __ leal(rdi, Address(arg, value_offset));
-
-  // Divide string length by 4 and adjust for lengths not divisible by 4.
+  // Round the string length up to 4 characters, and convert it to bytes.
   __ addl(rcx, Immediate(3));
-  __ shrl(rcx, Immediate(2));
+  __ andl(rcx, Immediate(-4));
+  __ addl(rcx, rcx);
 
   // Assertions that must hold in order to compare strings 4 characters (uncompressed)
   // or 8 characters (compressed) at a time.
   DCHECK_ALIGNED(value_offset, 8);
   static_assert(IsAligned<8>(kObjectAlignment), "String is not zero padded");
 
-  // Loop to compare strings four characters at a time starting at the beginning of the string.
-  __ repe_cmpsq();
-  // If strings are not equal, zero flag will be cleared.
-  __ j(kNotEqual, &return_false);
+  // Compare the strings a block or 8 bytes at a time starting at the beginning of the string.
+  GenerateMemoryEquals(codegen_,
+                       str,
+                       arg,
+                       value_offset,
+                       rcx,
+                       rsi,
+                       rdi,
+                       locations,
+                       /* first_vector_temp */ 2u,
+                       &return_false);
 
   // Return true and exit the function.
   // If loop does not result in returning false, we return true.
@@ -1640,6 +2150,390 @@ void IntrinsicCodeGeneratorX86_64::VisitStringEquals(HInvoke* invoke) {
   __ Bind(&return_false);
   __ xorl(rsi, rsi);
   __ Bind(&end);
+  MaybeClearUpperHalves(codegen_, GetCompareBlockSize(codegen_));
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitArraysEqualsByte(HInvoke* invoke) {
+  LocationSummary* locations = new (arena_) LocationSummary(invoke,
+                                                            LocationSummary::kNoCall,
+                                                            kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+
+  // Request temporary registers, RCX and RDI needed for repe_cmpsq instruction.
+  locations->AddTemp(Location::RegisterLocation(RCX));
+  locations->AddTemp(Location::RegisterLocation(RDI));
+
+  // Set output, RSI needed for repe_cmpsq instruction anyways.
+  locations->SetOut(Location::RegisterLocation(RSI), Location::kOutputOverlap);
+  AddCompareBlockTemps(codegen_, locations);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitArraysEqualsByte(HInvoke* invoke) {
+  X86_64Assembler* assembler = GetAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  CpuRegister array1 = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister array2 = locations->InAt(1).AsRegister<CpuRegister>();
+  CpuRegister rcx = locations->GetTemp(0).AsRegister<CpuRegister>();
+  CpuRegister rdi = locations->GetTemp(1).AsRegister<CpuRegister>();
+  CpuRegister rsi = locations->Out().AsRegister<CpuRegister>();
+
+  NearLabel end;
+  Label return_true, return_false;
+
+  const uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+  const uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint8_t)).Uint32Value();
+
+  // Reference equality check, return true if same reference or both null.
+  __ cmpl(array1, array2);
+  __ j(kEqual, &return_true);
+
+  // Return false if only one of the arrays is null.
+  if (invoke->InputAt(0)->CanBeNull()) {
+    __ testl(array1, array1);
+    __ j(kEqual, &return_false);
+  }
+  if (invoke->InputAt(1)->CanBeNull()) {
+    __ testl(array2, array2);
+    __ j(kEqual, &return_false);
+  }
+
+  // Return false if the lengths differ, true if both arrays are empty.
+  __ movl(rcx, Address(array1, length_offset));
+  __ cmpl(rcx, Address(array2, length_offset));
+  __ j(kNotEqual, &return_false);
+  __ testl(rcx, rcx);
+  __ j(kZero, &return_true);
+
+  // Compare from the length field, known equal, so that the compared bytes start 8 bytes
+  // aligned and end with the zero padding of the arrays, at their 8 byte aligned size.
+  DCHECK_ALIGNED(length_offset, 8);
+  DCHECK_EQ(length_offset + sizeof(int32_t), data_offset);
+  static_assert(IsAligned<8>(kObjectAlignment), "Array is not zero padded");
+  __ addl(rcx, Immediate(sizeof(int32_t) + 7));
+  __ andl(rcx, Immediate(-8));
+  GenerateMemoryEquals(codegen_,
+                       array1,
+                       array2,
+                       length_offset,
+                       rcx,
+                       rsi,
+                       rdi,
+                       locations,
+                       /* first_vector_temp */ 2u,
+                       &return_false);
+
+  __ Bind(&return_true);
+  __ movl(rsi, Immediate(1));
+  __ jmp(&end);
+
+  __ Bind(&return_false);
+  __ xorl(rsi, rsi);
+  __ Bind(&end);
+  MaybeClearUpperHalves(codegen_, GetCompareBlockSize(codegen_));
+}
+
+// Does the target have PCLMULQDQ? The JIT asks the CPU it runs on. The instruction set
+// features do not record it otherwise, but the variants with SSE4.2 all have it.
+static bool HasCarrylessMultiply(CodeGeneratorX86_64* codegen) {
+#if defined(__i386__) || defined(__x86_64__)
+  Runtime* runtime = Runtime::Current();
+  if (runtime != nullptr && !runtime->IsAotCompiler() && kRuntimeISA == kX86_64) {
+    constexpr unsigned int kPclmulqdqBit = 1u << 1;
+    unsigned int eax, ebx, ecx, edx;
+    return __get_cpuid(1u, &eax, &ebx, &ecx, &edx) != 0 && (ecx & kPclmulqdqBit) != 0u;
+  }
+#endif
+  return codegen->GetInstructionSetFeatures().HasSSE4_2();
+}
+
+// The constants folding the bit reflected CRC-32 of java.util.zip with carry-less multiplies,
+// as described in Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ".
+// Each is [x^n mod P(x) << 32]' << 1, a pair of them folds 128 bits over 4 * 128 or 128 bits.
+static constexpr int64_t kCrc32Fold512Low = INT64_C(0x154442bd4);   // n = 4 * 128 + 32.
+static constexpr int64_t kCrc32Fold512High = INT64_C(0x1c6e41596);  // n = 4 * 128 - 32.
+static constexpr int64_t kCrc32Fold128Low = INT64_C(0x1751997d0);   // n = 128 + 32.
+static constexpr int64_t kCrc32Fold128High = INT64_C(0x0ccaa009e);  // n = 128 - 32.
+static constexpr int64_t kCrc32Fold32 = INT64_C(0x163cd6124);       // n = 64.
+// The polynomial P'(x) and the Barrett constant u' = floor(x^64 / P(x))'.
+static constexpr int64_t kCrc32Polynomial = INT64_C(0x1db710641);
+static constexpr int64_t kCrc32BarrettConstant = INT64_C(0x1f7011641);
+
+// Load the 128 bits formed of low and high into dst. Clobbers temp and scratch.
+static void LoadCrc32Constant(X86_64Assembler* assembler,
+                              XmmRegister dst,
+                              int64_t low,
+                              int64_t high,
+                              CpuRegister temp,
+                              XmmRegister scratch) {
+  __ movq(temp, Immediate(low));
+  __ movd(dst, temp);
+  if (high != 0) {
+    __ movq(temp, Immediate(high));
+    __ movd(scratch, temp);
+    __ punpcklqdq(dst, scratch);
+  }
+}
+
+// Reduce the low 64 bits of value, the CRC state followed by 32 zero bits, to the CRC state in
+// its bits 32 to 63, with the Barrett constants of barrett (P' low, u' high).
+static void GenerateCrc32Barrett(X86_64Assembler* assembler,
+                                 XmmRegister value,
+                                 XmmRegister temp,
+                                 XmmRegister barrett) {
+  __ movaps(temp, value);
+  __ psllq(temp, Immediate(32));
+  __ psrlq(temp, Immediate(32));
+  __ pclmulqdq(temp, barrett, Immediate(0x10));
+  __ psllq(temp, Immediate(32));
+  __ psrlq(temp, Immediate(32));
+  __ pclmulqdq(temp, barrett, Immediate(0x00));
+  __ pxor(value, temp);
+}
+
+// Feed the CRC state in state, already xored with the next bytes, up to 4, through the
+// polynomial.
+static void GenerateCrc32Bytes(X86_64Assembler* assembler,
+                               CpuRegister state,
+                               size_t bytes,
+                               XmmRegister value,
+                               XmmRegister temp,
+                               XmmRegister barrett) {
+  DCHECK(bytes == 1u || bytes == 4u);
+  if (bytes != 4u) {
+    __ shlq(state, Immediate(32 - 8 * bytes));
+  }
+  __ movd(value, state);
+  GenerateCrc32Barrett(assembler, value, temp, barrett);
+  __ psrlq(value, Immediate(32));
+  __ movd(state, value, /* is64bit */ false);
+}
+
+// Fold the 128 bits of acc over the next 128 bits of the message, next, with the constants of
+// fold. Clobbers temp.
+static void GenerateCrc32Fold(X86_64Assembler* assembler,
+                              XmmRegister acc,
+                              XmmRegister next,
+                              XmmRegister fold,
+                              XmmRegister temp) {
+  __ movaps(temp, acc);
+  __ pclmulqdq(acc, fold, Immediate(0x00));
+  __ pclmulqdq(temp, fold, Immediate(0x11));
+  __ pxor(acc, temp);
+  __ pxor(acc, next);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitCRC32Update(HInvoke* invoke) {
+  if (!HasCarrylessMultiply(codegen_)) {
+    return;
+  }
+  LocationSummary* locations = new (arena_) LocationSummary(invoke,
+                                                            LocationSummary::kNoCall,
+                                                            kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitCRC32Update(HInvoke* invoke) {
+  X86_64Assembler* assembler = GetAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  CpuRegister crc = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister b = locations->InAt(1).AsRegister<CpuRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+  CpuRegister temp = locations->GetTemp(0).AsRegister<CpuRegister>();
+  XmmRegister value = locations->GetTemp(1).AsFpuRegister<XmmRegister>();
+  XmmRegister xmm_temp = locations->GetTemp(2).AsFpuRegister<XmmRegister>();
+  XmmRegister barrett = locations->GetTemp(3).AsFpuRegister<XmmRegister>();
+
+  // The state is the complement of the CRC, like in zlib.
+  __ movl(out, crc);
+  __ notl(out);
+  __ movzxb(temp, b);
+  __ xorl(out, temp);
+  LoadCrc32Constant(assembler, barrett, kCrc32Polynomial, kCrc32BarrettConstant, temp, xmm_temp);
+  GenerateCrc32Bytes(assembler, out, 1u, value, xmm_temp, barrett);
+  __ notl(out);
+}
+
+// Each fold of the main loop uses a pair of these, and the last one holds the constants.
+static constexpr size_t kCrc32FoldWidth = 4u;
+static constexpr size_t kCrc32VectorTemps = 2u * kCrc32FoldWidth + 1u;
+
+void IntrinsicLocationsBuilderX86_64::VisitCRC32UpdateBytes(HInvoke* invoke) {
+  if (!HasCarrylessMultiply(codegen_)) {
+    return;
+  }
+  LocationSummary* locations = new (arena_) LocationSummary(invoke,
+                                                            LocationSummary::kNoCall,
+                                                            kIntrinsified);
+  // updateBytes(int crc, byte[] b, int off, int len), only called by CRC32 once the array
+  // and its range are checked.
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetInAt(2, Location::RegisterOrConstant(invoke->InputAt(2)));
+  locations->SetInAt(3, Location::RequiresRegister());
+  // The inputs are all read before the output is written.
+  locations->SetOut(Location::RequiresRegister(), Location::kNoOutputOverlap);
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  for (size_t i = 0; i != kCrc32VectorTemps; ++i) {
+    locations->AddTemp(Location::RequiresFpuRegister());
+  }
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitCRC32UpdateBytes(HInvoke* invoke) {
+  X86_64Assembler* assembler = GetAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  CpuRegister crc = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister array = locations->InAt(1).AsRegister<CpuRegister>();
+  Location offset = locations->InAt(2);
+  CpuRegister length = locations->InAt(3).AsRegister<CpuRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+  CpuRegister ptr = locations->GetTemp(0).AsRegister<CpuRegister>();
+  CpuRegister remaining = locations->GetTemp(1).AsRegister<CpuRegister>();
+  CpuRegister temp = locations->GetTemp(2).AsRegister<CpuRegister>();
+  XmmRegister acc[kCrc32FoldWidth];
+  XmmRegister next[kCrc32FoldWidth];
+  for (size_t i = 0; i != kCrc32FoldWidth; ++i) {
+    acc[i] = locations->GetTemp(3u + i).AsFpuRegister<XmmRegister>();
+    next[i] = locations->GetTemp(3u + kCrc32FoldWidth + i).AsFpuRegister<XmmRegister>();
+  }
+  XmmRegister constants =
+      locations->GetTemp(3u + 2u * kCrc32FoldWidth).AsFpuRegister<XmmRegister>();
+
+  const uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint8_t)).Uint32Value();
+  if (offset.IsConstant()) {
+    int32_t offset_const = offset.GetConstant()->AsIntConstant()->GetValue();
+    __ leal(ptr, Address(array, offset_const + data_offset));
+  } else {
+    __ leal(ptr, Address(array, offset.AsRegister<CpuRegister>(), TIMES_1, data_offset));
+  }
+  __ movl(remaining, length);
+  // The state is the complement of the CRC, like in zlib.
+  __ movl(out, crc);
+  __ notl(out);
+
+  // The folds are too long for near jumps.
+  Label short_message, one_block, fold_blocks, words, done;
+  NearLabel last_block;
+  __ cmpl(remaining, Immediate(16));
+  __ j(kLess, &short_message);
+
+  // Fold 4 blocks of 16 bytes at a time into 4 accumulators, the first one starting with
+  // the state, then the accumulators into the first.
+  __ cmpl(remaining, Immediate(kCrc32FoldWidth * 16));
+  __ j(kLess, &one_block);
+  for (size_t i = 0; i != kCrc32FoldWidth; ++i) {
+    __ movdqu(acc[i], Address(ptr, i * 16));
+  }
+  __ movd(constants, out);
+  __ pxor(acc[0], constants);
+  __ addq(ptr, Immediate(kCrc32FoldWidth * 16));
+  __ subl(remaining, Immediate(kCrc32FoldWidth * 16));
+  LoadCrc32Constant(assembler, constants, kCrc32Fold512Low, kCrc32Fold512High, temp, next[0]);
+  Label loop, fold_accumulators;
+  __ cmpl(remaining, Immediate(kCrc32FoldWidth * 16));
+  __ j(kLess, &fold_accumulators);
+  __ Bind(&loop);
+  for (size_t i = 0; i != kCrc32FoldWidth; ++i) {
+    __ movaps(next[i], acc[i]);
+    __ pclmulqdq(acc[i], constants, Immediate(0x00));
+    __ pclmulqdq(next[i], constants, Immediate(0x11));
+    __ pxor(acc[i], next[i]);
+  }
+  for (size_t i = 0; i != kCrc32FoldWidth; ++i) {
+    __ movdqu(next[i], Address(ptr, i * 16));
+    __ pxor(acc[i], next[i]);
+  }
+  __ addq(ptr, Immediate(kCrc32FoldWidth * 16));
+  __ subl(remaining, Immediate(kCrc32FoldWidth * 16));
+  __ cmpl(remaining, Immediate(kCrc32FoldWidth * 16));
+  __ j(kGreaterEqual, &loop);
+  __ Bind(&fold_accumulators);
+  LoadCrc32Constant(assembler, constants, kCrc32Fold128Low, kCrc32Fold128High, temp, next[0]);
+  for (size_t i = 1; i != kCrc32FoldWidth; ++i) {
+    GenerateCrc32Fold(assembler, acc[0], acc[i], constants, next[0]);
+  }
+  __ jmp(&fold_blocks);
+
+  // Less than 4 blocks: start from the first one.
+  __ Bind(&one_block);
+  __ movdqu(acc[0], Address(ptr, 0));
+  __ movd(constants, out);
+  __ pxor(acc[0], constants);
+  __ addq(ptr, Immediate(16));
+  __ subl(remaining, Immediate(16));
+  LoadCrc32Constant(assembler, constants, kCrc32Fold128Low, kCrc32Fold128High, temp, next[0]);
+
+  // Fold the remaining blocks one at a time.
+  __ Bind(&fold_blocks);
+  NearLabel block_loop;
+  __ cmpl(remaining, Immediate(16));
+  __ j(kLess, &last_block);
+  __ Bind(&block_loop);
+  __ movdqu(next[1], Address(ptr, 0));
+  GenerateCrc32Fold(assembler, acc[0], next[1], constants, next[0]);
+  __ addq(ptr, Immediate(16));
+  __ subl(remaining, Immediate(16));
+  __ cmpl(remaining, Immediate(16));
+  __ j(kGreaterEqual, &block_loop);
+
+  // Fold the 128 bits of the accumulator to 64 bits, then to 32 bits followed by 32 zero
+  // bits, and reduce those to the state.
+  __ Bind(&last_block);
+  __ movaps(next[0], constants);
+  __ pclmulqdq(next[0], acc[0], Immediate(0x01));
+  __ psrldq(acc[0], Immediate(8));
+  __ pxor(acc[0], next[0]);
+  __ movaps(next[0], acc[0]);
+  __ psrldq(next[0], Immediate(4));
+  __ psllq(acc[0], Immediate(32));
+  __ psrlq(acc[0], Immediate(32));
+  LoadCrc32Constant(assembler, constants, kCrc32Fold32, 0, temp, next[1]);
+  __ pclmulqdq(acc[0], constants, Immediate(0x00));
+  __ pxor(acc[0], next[0]);
+  LoadCrc32Constant(assembler, constants, kCrc32Polynomial, kCrc32BarrettConstant, temp, next[0]);
+  GenerateCrc32Barrett(assembler, acc[0], next[0], constants);
+  __ psrlq(acc[0], Immediate(32));
+  __ movd(out, acc[0], /* is64bit */ false);
+  __ jmp(&words);
+
+  __ Bind(&short_message);
+  LoadCrc32Constant(assembler, constants, kCrc32Polynomial, kCrc32BarrettConstant, temp, next[0]);
+
+  // Feed the last 15 bytes at most 4, then 1 at a time.
+  __ Bind(&words);
+  Label word_loop, bytes, byte_loop;
+  __ cmpl(remaining, Immediate(4));
+  __ j(kLess, &bytes);
+  __ Bind(&word_loop);
+  __ xorl(out, Address(ptr, 0));
+  GenerateCrc32Bytes(assembler, out, 4u, acc[0], next[0], constants);
+  __ addq(ptr, Immediate(4));
+  __ subl(remaining, Immediate(4));
+  __ cmpl(remaining, Immediate(4));
+  __ j(kGreaterEqual, &word_loop);
+  __ Bind(&bytes);
+  __ testl(remaining, remaining);
+  __ j(kZero, &done);
+  __ Bind(&byte_loop);
+  __ movzxb(temp, Address(ptr, 0));
+  __ xorl(out, temp);
+  GenerateCrc32Bytes(assembler, out, 1u, acc[0], next[0], constants);
+  __ addq(ptr, Immediate(1));
+  __ subl(remaining, Immediate(1));
+  __ j(kNotZero, &byte_loop);
+  __ Bind(&done);
+  __ notl(out);
 }
 
 static void CreateStringIndexOfLocations(HInvoke* invoke,
@@ -1827,6 +2721,224 @@ void IntrinsicCodeGeneratorX86_64::VisitStringIndexOfAfter(HInvoke* invoke) {
       invoke, GetAssembler(), codegen_, GetAllocator(), /* start_at_zero */ false);
 }
 
+static void CreateStringStringIndexOfLocations(HInvoke* invoke,
+                                               ArenaAllocator* allocator,
+                                               CodeGeneratorX86_64* codegen,
+                                               bool start_at_zero) {
+  // The substring search relies on PCMPESTRI.
+  if (!codegen->GetInstructionSetFeatures().HasSSE4_2()) {
+    return;
+  }
+
+  LocationSummary* locations = new (allocator) LocationSummary(invoke,
+                                                               LocationSummary::kCallOnSlowPath,
+                                                               kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  if (!start_at_zero) {
+    locations->SetInAt(2, Location::RequiresRegister());          // The starting index.
+  }
+  // The output holds the index being searched, it must not overlap the inputs,
+  // which the slow path still needs.
+  locations->SetOut(Location::RequiresRegister());
+
+  // PCMPESTRI takes the substring length in EAX, the string length in EDX
+  // and returns the index in ECX.
+  locations->AddTemp(Location::RegisterLocation(RAX));
+  locations->AddTemp(Location::RegisterLocation(RDX));
+  locations->AddTemp(Location::RegisterLocation(RCX));
+  // The characters of the substring.
+  locations->AddTemp(Location::RequiresFpuRegister());
+}
+
+// Search the substring in the string from index `out`, with the characters of both
+// strings in bytes when `is_compressed` or in 16-bit chars otherwise. The lengths of
+// the substring and of the string from `out` are in EAX and EDX.
+//
+// Only the substrings fitting in one XMM register are searched, in strings from which
+// at least a full XMM register of characters is left: the other cases go to the slow
+// path. The string is then read in vectors that are all within it, so that no read goes
+// past its end, and whose matches are checked in full by PCMPESTRI.
+static void GenerateStringStringIndexOfLoop(X86_64Assembler* assembler,
+                                            CpuRegister string_obj,
+                                            CpuRegister substring_obj,
+                                            CpuRegister out,
+                                            XmmRegister substring,
+                                            bool is_compressed,
+                                            Label* slow_path,
+                                            Label* done) {
+  int32_t value_offset = mirror::String::ValueOffset().Int32Value();
+  // Equal ordered aggregation, on unsigned bytes or unsigned words.
+  Immediate mode(is_compressed ? 0x0c : 0x0d);
+  ScaleFactor scale = is_compressed ? TIMES_1 : TIMES_2;
+  int32_t stride = is_compressed ? 16 : 8;
+  CpuRegister substring_length(RAX);
+  CpuRegister remaining(RDX);
+  CpuRegister index(RCX);
+
+  __ cmpl(substring_length, Immediate(stride));
+  __ j(kGreater, slow_path);
+  __ cmpl(remaining, Immediate(stride));
+  __ j(kLess, slow_path);
+
+  // Load the substring, reading at most up to the object alignment past its end.
+  NearLabel load_full, loaded;
+  __ cmpl(substring_length, Immediate(stride / 2));
+  __ j(kGreater, &load_full);
+  __ movsd(substring, Address(substring_obj, value_offset));
+  __ jmp(&loaded);
+  __ Bind(&load_full);
+  __ movdqu(substring, Address(substring_obj, value_offset));
+  __ Bind(&loaded);
+
+  // The string has at least `stride` characters left from `out`.
+  NearLabel scan, candidate, tail, not_found;
+  __ Bind(&scan);
+  __ pcmpestri(substring, Address(string_obj, out, scale, value_offset), mode);
+  __ j(kBelow, &candidate);
+  // Nothing matches, even partially at the end of the vector.
+  __ addl(out, Immediate(stride));
+  __ subl(remaining, Immediate(stride));
+  __ cmpl(remaining, Immediate(stride));
+  __ j(kGreaterEqual, &scan);
+  __ jmp(&tail);
+
+  __ Bind(&candidate);
+  __ addl(out, index);
+  // The match is complete when the substring fits the vector.
+  __ leal(CpuRegister(TMP), Address(index, substring_length, TIMES_1, 0));
+  __ cmpl(CpuRegister(TMP), Immediate(stride));
+  __ j(kLessEqual, done);
+  // Otherwise, try again from the start of the partial match.
+  __ subl(remaining, index);
+  __ cmpl(remaining, Immediate(stride));
+  __ j(kGreaterEqual, &scan);
+
+  // Search the last `stride` characters of the string. The characters before `out`
+  // did not match, and cannot start a partial match at the end of the string.
+  __ Bind(&tail);
+  __ cmpl(remaining, substring_length);
+  __ j(kLess, &not_found);
+  __ leal(out, Address(out, remaining, TIMES_1, -stride));
+  __ movl(remaining, Immediate(stride));
+  __ pcmpestri(substring, Address(string_obj, out, scale, value_offset), mode);
+  __ j(kAboveEqual, &not_found);
+  __ addl(out, index);
+  __ addl(index, substring_length);
+  __ cmpl(index, Immediate(stride));
+  __ j(kLessEqual, done);
+
+  __ Bind(&not_found);
+  __ movl(out, Immediate(-1));
+  __ jmp(done);
+}
+
+static void GenerateStringStringIndexOf(HInvoke* invoke,
+                                        X86_64Assembler* assembler,
+                                        CodeGeneratorX86_64* codegen,
+                                        ArenaAllocator* allocator,
+                                        bool start_at_zero) {
+  LocationSummary* locations = invoke->GetLocations();
+
+  // Note that the null check must have been done earlier.
+  DCHECK(!invoke->CanDoImplicitNullCheckOn(invoke->InputAt(0)));
+
+  CpuRegister string_obj = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister substring_obj = locations->InAt(1).AsRegister<CpuRegister>();
+  CpuRegister substring_length = locations->GetTemp(0).AsRegister<CpuRegister>();
+  CpuRegister remaining = locations->GetTemp(1).AsRegister<CpuRegister>();
+  XmmRegister substring = locations->GetTemp(3).AsFpuRegister<XmmRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+
+  // Check our assumptions for registers.
+  DCHECK_EQ(substring_length.AsRegister(), RAX);
+  DCHECK_EQ(remaining.AsRegister(), RDX);
+  DCHECK_EQ(locations->GetTemp(2).AsRegister<CpuRegister>().AsRegister(), RCX);
+
+  // The slow path calls String.indexOf, which also throws for a null substring.
+  SlowPathCode* slow_path = new (allocator) IntrinsicSlowPathX86_64(invoke);
+  codegen->AddSlowPath(slow_path);
+  if (invoke->InputAt(1)->CanBeNull()) {
+    __ testl(substring_obj, substring_obj);
+    __ j(kEqual, slow_path->GetEntryLabel());
+  }
+
+  // Location of count within the String object.
+  int32_t count_offset = mirror::String::CountOffset().Int32Value();
+  __ movl(substring_length, Address(substring_obj, count_offset));
+  __ movl(remaining, Address(string_obj, count_offset));
+
+  if (mirror::kUseStringCompression) {
+    // Both strings must have the same compression flag.
+    __ movl(CpuRegister(TMP), substring_length);
+    __ xorl(CpuRegister(TMP), remaining);
+    __ testl(CpuRegister(TMP), Immediate(1));
+    __ j(kNotZero, slow_path->GetEntryLabel());
+    // Use TMP to keep the flagged length of the string.
+    __ movl(CpuRegister(TMP), remaining);
+    __ shrl(substring_length, Immediate(1));
+    __ shrl(remaining, Immediate(1));
+  }
+
+  // The empty substring is left to the slow path.
+  __ testl(substring_length, substring_length);
+  __ j(kEqual, slow_path->GetEntryLabel());
+
+  // Ensure we have a start index >= 0, the rest of the string is searched from there.
+  __ xorl(out, out);
+  if (!start_at_zero) {
+    CpuRegister start_index = locations->InAt(2).AsRegister<CpuRegister>();
+    __ testl(start_index, start_index);
+    __ cmov(kGreater, out, start_index, /* is64bit */ false);  // 32-bit copy is enough.
+  }
+  __ subl(remaining, out);
+
+  Label done;
+  if (mirror::kUseStringCompression) {
+    Label uncompressed_search;
+    __ testl(CpuRegister(TMP), Immediate(1));
+    __ j(kNotZero, &uncompressed_search);
+    GenerateStringStringIndexOfLoop(assembler,
+                                    string_obj,
+                                    substring_obj,
+                                    out,
+                                    substring,
+                                    /* is_compressed */ true,
+                                    slow_path->GetEntryLabel(),
+                                    &done);
+    __ Bind(&uncompressed_search);
+  }
+  GenerateStringStringIndexOfLoop(assembler,
+                                  string_obj,
+                                  substring_obj,
+                                  out,
+                                  substring,
+                                  /* is_compressed */ false,
+                                  slow_path->GetEntryLabel(),
+                                  &done);
+
+  __ Bind(&done);
+  __ Bind(slow_path->GetExitLabel());
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitStringStringIndexOf(HInvoke* invoke) {
+  CreateStringStringIndexOfLocations(invoke, arena_, codegen_, /* start_at_zero */ true);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitStringStringIndexOf(HInvoke* invoke) {
+  GenerateStringStringIndexOf(
+      invoke, GetAssembler(), codegen_, GetAllocator(), /* start_at_zero */ true);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitStringStringIndexOfAfter(HInvoke* invoke) {
+  CreateStringStringIndexOfLocations(invoke, arena_, codegen_, /* start_at_zero */ false);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitStringStringIndexOfAfter(HInvoke* invoke) {
+  GenerateStringStringIndexOf(
+      invoke, GetAssembler(), codegen_, GetAllocator(), /* start_at_zero */ false);
+}
+
 void IntrinsicLocationsBuilderX86_64::VisitStringNewStringFromBytes(HInvoke* invoke) {
   LocationSummary* locations = new (arena_) LocationSummary(invoke,
                                                             LocationSummary::kCallOnMainAndSlowPath,
@@ -2532,6 +3644,127 @@ void IntrinsicCodeGeneratorX86_64::VisitUnsafeCASObject(HInvoke* invoke) {
   GenCAS(Primitive::kPrimNot, invoke, codegen_);
 }
 
+static void CreateIntIntIntIntToIntLocations(ArenaAllocator* arena,
+                                             Primitive::Type type,
+                                             HInvoke* invoke) {
+  LocationSummary* locations = new (arena) LocationSummary(invoke,
+                                                           LocationSummary::kNoCall,
+                                                           kIntrinsified);
+  locations->SetInAt(0, Location::NoLocation());        // Unused receiver.
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetInAt(2, Location::RequiresRegister());
+  locations->SetInAt(3, Location::RequiresRegister());
+  // The old value is exchanged in the output, which must not overlap the address.
+  locations->SetOut(Location::RequiresRegister());
+  if (type == Primitive::kPrimNot) {
+    // Need temporary registers for card-marking.
+    locations->AddTemp(Location::RequiresRegister());
+    locations->AddTemp(Location::RequiresRegister());
+  }
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitUnsafeGetAndAddInt(HInvoke* invoke) {
+  CreateIntIntIntIntToIntLocations(arena_, Primitive::kPrimInt, invoke);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitUnsafeGetAndAddLong(HInvoke* invoke) {
+  CreateIntIntIntIntToIntLocations(arena_, Primitive::kPrimLong, invoke);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitUnsafeGetAndSetInt(HInvoke* invoke) {
+  CreateIntIntIntIntToIntLocations(arena_, Primitive::kPrimInt, invoke);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitUnsafeGetAndSetLong(HInvoke* invoke) {
+  CreateIntIntIntIntToIntLocations(arena_, Primitive::kPrimLong, invoke);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitUnsafeGetAndSetObject(HInvoke* invoke) {
+  // The reference swapped out of the field would need a read barrier,
+  // which is left to the runtime implementation.
+  if (kEmitCompilerReadBarrier) {
+    return;
+  }
+
+  CreateIntIntIntIntToIntLocations(arena_, Primitive::kPrimNot, invoke);
+}
+
+static void GenGetAndAdd(Primitive::Type type, HInvoke* invoke, CodeGeneratorX86_64* codegen) {
+  X86_64Assembler* assembler = down_cast<X86_64Assembler*>(codegen->GetAssembler());
+  LocationSummary* locations = invoke->GetLocations();
+
+  CpuRegister base = locations->InAt(1).AsRegister<CpuRegister>();
+  CpuRegister offset = locations->InAt(2).AsRegister<CpuRegister>();
+  CpuRegister delta = locations->InAt(3).AsRegister<CpuRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+  Address field_addr(base, offset, ScaleFactor::TIMES_1, 0);
+
+  // LOCK XADD leaves the old value in `out` and has full barrier semantics.
+  if (type == Primitive::kPrimInt) {
+    __ movl(out, delta);
+    __ LockXaddl(field_addr, out);
+  } else {
+    DCHECK_EQ(type, Primitive::kPrimLong);
+    __ movq(out, delta);
+    __ LockXaddq(field_addr, out);
+  }
+}
+
+static void GenGetAndSet(Primitive::Type type, HInvoke* invoke, CodeGeneratorX86_64* codegen) {
+  X86_64Assembler* assembler = down_cast<X86_64Assembler*>(codegen->GetAssembler());
+  LocationSummary* locations = invoke->GetLocations();
+
+  CpuRegister base = locations->InAt(1).AsRegister<CpuRegister>();
+  CpuRegister offset = locations->InAt(2).AsRegister<CpuRegister>();
+  CpuRegister value = locations->InAt(3).AsRegister<CpuRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+  Address field_addr(base, offset, ScaleFactor::TIMES_1, 0);
+
+  // XCHG with a memory operand is implicitly locked, it has full barrier semantics.
+  if (type == Primitive::kPrimLong) {
+    __ movq(out, value);
+    __ xchgq(out, field_addr);
+  } else if (type == Primitive::kPrimInt) {
+    __ movl(out, value);
+    __ xchgl(out, field_addr);
+  } else {
+    DCHECK_EQ(type, Primitive::kPrimNot);
+    DCHECK(!kEmitCompilerReadBarrier);
+    CpuRegister temp1 = locations->GetTemp(0).AsRegister<CpuRegister>();
+    CpuRegister temp2 = locations->GetTemp(1).AsRegister<CpuRegister>();
+
+    // Mark card for object as the new value is stored.
+    bool value_can_be_null = true;  // TODO: Worth finding out this information?
+    codegen->MarkGCCard(temp1, temp2, base, value, value_can_be_null);
+
+    // Poisoning the copy in `out` leaves `value` intact.
+    __ movl(out, value);
+    __ MaybePoisonHeapReference(out);
+    __ xchgl(out, field_addr);
+    __ MaybeUnpoisonHeapReference(out);
+  }
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitUnsafeGetAndAddInt(HInvoke* invoke) {
+  GenGetAndAdd(Primitive::kPrimInt, invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitUnsafeGetAndAddLong(HInvoke* invoke) {
+  GenGetAndAdd(Primitive::kPrimLong, invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitUnsafeGetAndSetInt(HInvoke* invoke) {
+  GenGetAndSet(Primitive::kPrimInt, invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitUnsafeGetAndSetLong(HInvoke* invoke) {
+  GenGetAndSet(Primitive::kPrimLong, invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitUnsafeGetAndSetObject(HInvoke* invoke) {
+  GenGetAndSet(Primitive::kPrimNot, invoke, codegen_);
+}
+
 void IntrinsicLocationsBuilderX86_64::VisitIntegerReverse(HInvoke* invoke) {
   LocationSummary* locations = new (arena_) LocationSummary(invoke,
                                                            LocationSummary::kNoCall,
@@ -3045,12 +4278,48 @@ void IntrinsicCodeGeneratorX86_64::VisitThreadInterrupted(HInvoke* invoke) {
   __ Bind(&done);
 }
 
+void IntrinsicLocationsBuilderX86_64::VisitSystemIdentityHashCode(HInvoke* invoke) {
+  LocationSummary* locations = new (arena_) LocationSummary(invoke,
+                                                            LocationSummary::kCallOnSlowPath,
+                                                            kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  // The slow path still needs the object.
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+  locations->AddTemp(Location::RequiresRegister());
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitSystemIdentityHashCode(HInvoke* invoke) {
+  X86_64Assembler* assembler = GetAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  CpuRegister obj = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+  CpuRegister temp = locations->GetTemp(0).AsRegister<CpuRegister>();
+  uint32_t monitor_offset = mirror::Object::MonitorOffset().Int32Value();
+
+  SlowPathCode* slow_path = new (GetAllocator()) IntrinsicSlowPathX86_64(invoke);
+  codegen_->AddSlowPath(slow_path);
+
+  // The hash code of null is 0.
+  __ xorl(out, out);
+  __ testl(obj, obj);
+  __ j(kEqual, slow_path->GetExitLabel());
+
+  // Return the hash code of the lock word if it holds one. Hashing the object, or finding the
+  // hash code of a locked object, is left to the runtime.
+  __ movl(out, Address(obj, monitor_offset));
+  __ movl(temp, out);
+  __ shrl(temp, Immediate(LockWord::kStateShift));
+  __ cmpl(temp, Immediate(LockWord::kStateHash));
+  __ j(kNotEqual, slow_path->GetEntryLabel());
+  __ andl(out, Immediate(LockWord::kHashMask));
+  __ Bind(slow_path->GetExitLabel());
+}
+
 UNIMPLEMENTED_INTRINSIC(X86_64, ReferenceGetReferent)
 UNIMPLEMENTED_INTRINSIC(X86_64, FloatIsInfinite)
 UNIMPLEMENTED_INTRINSIC(X86_64, DoubleIsInfinite)
 
-UNIMPLEMENTED_INTRINSIC(X86_64, StringStringIndexOf);
-UNIMPLEMENTED_INTRINSIC(X86_64, StringStringIndexOfAfter);
 UNIMPLEMENTED_INTRINSIC(X86_64, StringBufferAppend);
 UNIMPLEMENTED_INTRINSIC(X86_64, StringBufferLength);
 UNIMPLEMENTED_INTRINSIC(X86_64, StringBufferToString);
@@ -3058,13 +4327,6 @@ UNIMPLEMENTED_INTRINSIC(X86_64, StringBuilderAppend);
 UNIMPLEMENTED_INTRINSIC(X86_64, StringBuilderLength);
 UNIMPLEMENTED_INTRINSIC(X86_64, StringBuilderToString);
 
-// 1.8.
-UNIMPLEMENTED_INTRINSIC(X86_64, UnsafeGetAndAddInt)
-UNIMPLEMENTED_INTRINSIC(X86_64, UnsafeGetAndAddLong)
-UNIMPLEMENTED_INTRINSIC(X86_64, UnsafeGetAndSetInt)
-UNIMPLEMENTED_INTRINSIC(X86_64, UnsafeGetAndSetLong)
-UNIMPLEMENTED_INTRINSIC(X86_64, UnsafeGetAndSetObject)
-
 UNREACHABLE_INTRINSICS(X86_64)
 
 #undef __
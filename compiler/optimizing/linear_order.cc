@@ -50,6 +50,36 @@ static void AddToListForLinearization(ArenaVector<HBasicBlock*>* worklist, HBasi
   worklist->insert(insert_pos.base(), block);
 }
 
+// Helper method to find the blocks that only lead to a throw or a deoptimization, that is,
+// the blocks which cannot reach a return or a loop. They are rarely executed, and this set
+// is closed under successors, so they can be placed after all the other blocks.
+static void MarkColdBlocks(const HGraph* graph,
+                           ArenaAllocator* allocator,
+                           ArenaBitVector* cold_blocks) {
+  ArenaVector<HBasicBlock*> worklist(allocator->Adapter(kArenaAllocLinearOrder));
+  for (HBasicBlock* block : graph->GetBlocks()) {
+    if (block == nullptr) {
+      continue;
+    }
+    HInstruction* last = block->GetLastInstruction();
+    if (block->IsInLoop() || last->IsReturn() || last->IsReturnVoid()) {
+      worklist.push_back(block);
+    } else {
+      cold_blocks->SetBit(block->GetBlockId());
+    }
+  }
+  while (!worklist.empty()) {
+    HBasicBlock* block = worklist.back();
+    worklist.pop_back();
+    for (HBasicBlock* predecessor : block->GetPredecessors()) {
+      if (cold_blocks->IsBitSet(predecessor->GetBlockId())) {
+        cold_blocks->ClearBit(predecessor->GetBlockId());
+        worklist.push_back(predecessor);
+      }
+    }
+  }
+}
+
 // Helper method to validate linear order.
 static bool IsLinearOrderWellFormed(const HGraph* graph, ArenaVector<HBasicBlock*>* linear_order) {
   for (HBasicBlock* header : graph->GetBlocks()) {
@@ -85,7 +115,9 @@ void LinearizeGraph(const HGraph* graph,
   DCHECK(linear_order->empty());
   // Create a reverse post ordering with the following properties:
   // - Blocks in a loop are consecutive,
-  // - Back-edge is the last block before loop exits.
+  // - Back-edge is the last block before loop exits,
+  // - Blocks that only lead to a throw come after all the other blocks, so that the
+  //   code of the hot paths is not interleaved with them.
   //
   // (1): Record the number of forward predecessors for each block. This is to
   //      ensure the resulting order is reverse post order. We could use the
@@ -105,10 +137,25 @@ void LinearizeGraph(const HGraph* graph,
   //      iterate over the successors. When all non-back edge predecessors of a
   //      successor block are visited, the successor block is added in the worklist
   //      following an order that satisfies the requirements to build our linear graph.
+  //      Cold blocks are kept aside until no other block is left: none of them is in a
+  //      loop, and all their successors are cold, so the order stays a reverse post order.
+  ArenaBitVector cold_blocks(allocator,
+                             graph->GetBlocks().size(),
+                             /* expandable */ false,
+                             kArenaAllocLinearOrder);
+  MarkColdBlocks(graph, allocator, &cold_blocks);
   linear_order->reserve(graph->GetReversePostOrder().size());
   ArenaVector<HBasicBlock*> worklist(allocator->Adapter(kArenaAllocLinearOrder));
+  ArenaVector<HBasicBlock*> cold_worklist(allocator->Adapter(kArenaAllocLinearOrder));
   worklist.push_back(graph->GetEntryBlock());
-  do {
+  while (true) {
+    if (worklist.empty()) {
+      if (cold_worklist.empty()) {
+        break;
+      }
+      worklist.push_back(cold_worklist.back());
+      cold_worklist.pop_back();
+    }
     HBasicBlock* current = worklist.back();
     worklist.pop_back();
     linear_order->push_back(current);
@@ -116,11 +163,15 @@ void LinearizeGraph(const HGraph* graph,
       int block_id = successor->GetBlockId();
       size_t number_of_remaining_predecessors = forward_predecessors[block_id];
       if (number_of_remaining_predecessors == 1) {
-        AddToListForLinearization(&worklist, successor);
+        if (cold_blocks.IsBitSet(block_id)) {
+          cold_worklist.push_back(successor);
+        } else {
+          AddToListForLinearization(&worklist, successor);
+        }
       }
       forward_predecessors[block_id] = number_of_remaining_predecessors - 1;
     }
-  } while (!worklist.empty());
+  }
 
   DCHECK(graph->HasIrreducibleLoops() || IsLinearOrderWellFormed(graph, linear_order));
 }
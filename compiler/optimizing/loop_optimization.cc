@@ -31,8 +31,8 @@ namespace art {
 // Enables vectorization (SIMDization) in the loop optimizer.
 static constexpr bool kEnableVectorization = true;
 
-// All current SIMD targets want 16-byte alignment.
-static constexpr size_t kAlignedBase = 16;
+// Minimum number of vector iterations for which peeling for alignment pays off.
+static constexpr int64_t kPeelingMinVectorIterations = 4;
 
 // Remove the instruction from the graph. A bit more elaborate than the usual
 // instruction removal, since there may be a cycle in the use structure.
@@ -266,7 +266,103 @@ static bool IsAddConst(HInstruction* instruction,
   return false;
 }
 
+// Detect a select of the minimum or maximum of the two integral values it compares,
+//   x < y ? x : y, x >= y ? y : x, ..
+static bool IsSelectMinMax(HInstruction* instruction, /*out*/ bool* is_min) {
+  if (!instruction->IsSelect() || !Primitive::IsIntegralType(instruction->GetType())) {
+    return false;
+  }
+  HSelect* select = instruction->AsSelect();
+  HInstruction* condition = select->GetCondition();
+  if (!condition->IsCondition()) {
+    return false;
+  }
+  bool is_less = false;
+  switch (condition->AsCondition()->GetCondition()) {
+    case kCondLT:
+    case kCondLE:
+      is_less = true;
+      break;
+    case kCondGT:
+    case kCondGE:
+      is_less = false;
+      break;
+    default:
+      return false;
+  }
+  HInstruction* opa = condition->InputAt(0);
+  HInstruction* opb = condition->InputAt(1);
+  if (select->GetTrueValue() == opa && select->GetFalseValue() == opb) {
+    *is_min = is_less;
+    return true;
+  } else if (select->GetTrueValue() == opb && select->GetFalseValue() == opa) {
+    *is_min = !is_less;
+    return true;
+  }
+  return false;
+}
+
 // Test vector restrictions.
+// Detect reductions of the following forms,
+//   x = x_phi + ..
+//   x = x_phi - ..
+//   x = min(x_phi, ..)
+//   x = max(x_phi, ..)
+static bool HasReductionFormat(HInstruction* reduction, HInstruction* phi) {
+  bool is_min = false;
+  if (IsSelectMinMax(reduction, &is_min)) {
+    HInstruction* opa = reduction->AsSelect()->GetTrueValue();
+    HInstruction* opb = reduction->AsSelect()->GetFalseValue();
+    return (opa == phi && opb != phi) || (opa != phi && opb == phi);
+  } else if (reduction->IsAdd()) {
+    return (reduction->InputAt(0) == phi && reduction->InputAt(1) != phi) ||
+           (reduction->InputAt(0) != phi && reduction->InputAt(1) == phi);
+  } else if (reduction->IsSub()) {
+    return (reduction->InputAt(0) == phi && reduction->InputAt(1) != phi);
+  } else if (reduction->IsInvokeStaticOrDirect()) {
+    switch (reduction->AsInvokeStaticOrDirect()->GetIntrinsic()) {
+      case Intrinsics::kMathMinIntInt:
+      case Intrinsics::kMathMinLongLong:
+      case Intrinsics::kMathMinFloatFloat:
+      case Intrinsics::kMathMinDoubleDouble:
+      case Intrinsics::kMathMaxIntInt:
+      case Intrinsics::kMathMaxLongLong:
+      case Intrinsics::kMathMaxFloatFloat:
+      case Intrinsics::kMathMaxDoubleDouble:
+        return (reduction->InputAt(0) == phi && reduction->InputAt(1) != phi) ||
+               (reduction->InputAt(0) != phi && reduction->InputAt(1) == phi);
+      default:
+        return false;
+    }
+  }
+  return false;
+}
+
+// Translate the operation of a reduction in the loop-body into the vector reduction kind.
+static HVecReduce::ReductionKind GetReductionKind(HInstruction* reduction) {
+  bool is_min = false;
+  if (IsSelectMinMax(reduction, &is_min)) {
+    return is_min ? HVecReduce::kMin : HVecReduce::kMax;
+  } else if (reduction->IsInvokeStaticOrDirect()) {
+    switch (reduction->AsInvokeStaticOrDirect()->GetIntrinsic()) {
+      case Intrinsics::kMathMinIntInt:
+      case Intrinsics::kMathMinLongLong:
+      case Intrinsics::kMathMinFloatFloat:
+      case Intrinsics::kMathMinDoubleDouble:
+        return HVecReduce::kMin;
+      case Intrinsics::kMathMaxIntInt:
+      case Intrinsics::kMathMaxLongLong:
+      case Intrinsics::kMathMaxFloatFloat:
+      case Intrinsics::kMathMaxDoubleDouble:
+        return HVecReduce::kMax;
+      default:
+        break;
+    }
+  }
+  DCHECK(reduction->IsAdd() || reduction->IsSub());
+  return HVecReduce::kSum;
+}
+
 static bool HasVectorRestrictions(uint64_t restrictions, uint64_t tested) {
   return (restrictions & tested) != 0;
 }
@@ -294,6 +390,7 @@ HLoopOptimization::HLoopOptimization(HGraph* graph,
       top_loop_(nullptr),
       last_loop_(nullptr),
       iset_(nullptr),
+      reductions_(nullptr),
       induction_simplication_count_(0),
       simplified_(false),
       vector_length_(0),
@@ -346,17 +443,21 @@ void HLoopOptimization::LocalRun() {
   // should use the global allocator.
   if (top_loop_ != nullptr) {
     ArenaSet<HInstruction*> iset(loop_allocator_->Adapter(kArenaAllocLoopOptimization));
+    ArenaSafeMap<HInstruction*, HInstruction*> reds(
+        std::less<HInstruction*>(), loop_allocator_->Adapter(kArenaAllocLoopOptimization));
     ArenaSet<ArrayReference> refs(loop_allocator_->Adapter(kArenaAllocLoopOptimization));
     ArenaSafeMap<HInstruction*, HInstruction*> map(
         std::less<HInstruction*>(), loop_allocator_->Adapter(kArenaAllocLoopOptimization));
     // Attach.
     iset_ = &iset;
+    reductions_ = &reds;
     vector_refs_ = &refs;
     vector_map_ = &map;
     // Traverse.
     TraverseLoopsInnerToOuter(top_loop_);
     // Detach.
     iset_ = nullptr;
+    reductions_ = nullptr;
     vector_refs_ = nullptr;
     vector_map_ = nullptr;
   }
@@ -539,11 +640,12 @@ void HLoopOptimization::OptimizeInnerLoop(LoopNode* node) {
   // Detect either an empty loop (no side effects other than plain iteration) or
   // a trivial loop (just iterating once). Replace subsequent index uses, if any,
   // with the last value and remove the loop, possibly after unrolling its body.
-  HInstruction* phi = header->GetFirstPhi();
+  HPhi* phi = nullptr;
   iset_->clear();  // prepare phi induction
-  if (TrySetSimpleLoopHeader(header)) {
+  if (TrySetSimpleLoopHeader(header, &phi)) {
     bool is_empty = IsEmptyBody(body);
-    if ((is_empty || trip_count == 1) &&
+    if (reductions_->empty() &&  // TODO: possible with some effort
+        (is_empty || trip_count == 1) &&
         TryAssignLastValue(node->loop_info, phi, preheader, /*collect_loop_uses*/ true)) {
       if (!is_empty) {
         // Unroll the loop-body, which sees initial value of the index.
@@ -567,7 +669,7 @@ void HLoopOptimization::OptimizeInnerLoop(LoopNode* node) {
   // Vectorize loop, if possible and valid.
   if (kEnableVectorization) {
     iset_->clear();  // prepare phi induction
-    if (TrySetSimpleLoopHeader(header) &&
+    if (TrySetSimpleLoopHeader(header, &phi) &&
         ShouldVectorize(node, body, trip_count) &&
         TryAssignLastValue(node->loop_info, phi, preheader, /*collect_loop_uses*/ true)) {
       Vectorize(node, body, exit, trip_count);
@@ -674,28 +776,38 @@ void HLoopOptimization::Vectorize(LoopNode* node,
 
   // Adjust vector bookkeeping.
   iset_->clear();  // prepare phi induction
-  bool is_simple_loop_header = TrySetSimpleLoopHeader(header);  // fills iset_
+  HPhi* main_phi = nullptr;
+  bool is_simple_loop_header = TrySetSimpleLoopHeader(header, &main_phi);  // fills iset_
   DCHECK(is_simple_loop_header);
   vector_header_ = header;
   vector_body_ = block;
 
-  // Generate dynamic loop peeling trip count, if needed:
+  // Generate loop control:
+  // stc = <trip-count>;
+  HInstruction* stc = induction_range_.GenerateTripCount(node->loop_info, graph_, preheader);
+
+  // Generate dynamic loop peeling trip count, if needed, which aligns the
+  // first access a[i + offset] of the vector loop to the vector size:
   // ptc = <peeling-needed-for-candidate>
+  // ptc = stc < chunk + vl ? 0 : ptc;
+  // The vector loop is skipped altogether for the short trip counts, which leaves
+  // all their iterations to the cleanup loop rather than to the peeling loop.
   HInstruction* ptc = nullptr;
+  HInstruction* is_short = nullptr;
   if (vector_peeling_candidate_ != nullptr) {
-    DCHECK_LT(vector_length_, trip_count) << "dynamic peeling currently requires known trip count";
-    //
-    // TODO: Implement this. Compute address of first access memory location and
-    //       compute peeling factor to obtain kAlignedBase alignment.
-    //
-    needs_cleanup = true;
+    ptc = GenerateAlignmentPeeling(preheader, vector_peeling_candidate_);
+    if (ptc != nullptr) {
+      is_short = Insert(preheader, new (global_allocator_) HLessThan(
+          stc, graph_->GetIntConstant(chunk + vector_length_)));
+      ptc = Insert(preheader, new (global_allocator_) HSelect(
+          is_short, graph_->GetIntConstant(0), ptc, kNoDexPc));
+      needs_cleanup = true;
+    }
   }
 
-  // Generate loop control:
-  // stc = <trip-count>;
   // vtc = stc - (stc - ptc) % chunk;
+  // vtc = stc < chunk + vl ? 0 : vtc;
   // i = 0;
-  HInstruction* stc = induction_range_.GenerateTripCount(node->loop_info, graph_, preheader);
   HInstruction* vtc = stc;
   if (needs_cleanup) {
     DCHECK(IsPowerOfTwo(chunk));
@@ -709,6 +821,10 @@ void HLoopOptimization::Vectorize(LoopNode* node,
                                                 graph_->GetIntConstant(chunk - 1)));
     vtc = Insert(preheader, new (global_allocator_) HSub(induc_type, stc, rem));
   }
+  if (is_short != nullptr) {
+    vtc = Insert(preheader, new (global_allocator_) HSelect(
+        is_short, graph_->GetIntConstant(0), vtc, kNoDexPc));
+  }
   vector_index_ = graph_->GetIntConstant(0);
 
   // Generate runtime disambiguation test:
@@ -763,6 +879,18 @@ void HLoopOptimization::Vectorize(LoopNode* node,
                     /*unroll*/ 1);
   }
 
+  // Link reductions to their final uses, with the value left by the last new loop.
+  for (auto i = reductions_->begin(); i != reductions_->end(); ++i) {
+    if (i->first->IsPhi()) {
+      HPhi* phi = i->first->AsPhi();
+      HInstruction* repl = ReduceAndExtractIfNeeded(phi);
+      for (const HUseListNode<HInstruction*>& use : phi->GetUses()) {
+        induction_range_.Replace(use.GetUser(), phi, repl);  // update induction use
+      }
+      phi->ReplaceWith(repl);
+    }
+  }
+
   // Remove the original loop by disconnecting the body block
   // and removing all instructions from the header.
   block->DisconnectAndDelete();
@@ -802,14 +930,27 @@ void HLoopOptimization::GenerateNewLoop(LoopNode* node,
   vector_header_->AddInstruction(new (global_allocator_) HIf(cond));
   vector_index_ = phi;
   for (uint32_t u = 0; u < unroll; u++) {
-    // Clear map, leaving loop invariants setup during unrolling.
+    // Clear map, leaving loop invariants setup during unrolling. The reduction
+    // phis start from their new phi, then from the value of the previous unrolling.
     if (u == 0) {
       vector_map_->clear();
+      for (auto i = reductions_->begin(); i != reductions_->end(); ++i) {
+        if (!i->first->IsPhi()) {
+          GenerateVecReductionPhi(i->second->AsPhi(), i->first);
+        }
+      }
     } else {
+      for (auto i = reductions_->begin(); i != reductions_->end(); ++i) {
+        if (!i->first->IsPhi()) {
+          vector_map_->Overwrite(i->second, vector_map_->Get(i->first));
+        }
+      }
       for (auto i = vector_map_->begin(); i != vector_map_->end(); ) {
         if (i->second->IsVecReplicateScalar()) {
           DCHECK(node->loop_info->IsDefinedOutOfTheLoop(i->first));
           ++i;
+        } else if (reductions_->find(i->first) != reductions_->end() && i->first->IsPhi()) {
+          ++i;
         } else {
           i = vector_map_->erase(i);
         }
@@ -826,6 +967,10 @@ void HLoopOptimization::GenerateNewLoop(LoopNode* node,
       auto i = vector_map_->find(it.Current());
       if (i != vector_map_->end() && !i->second->IsInBlock()) {
         Insert(vector_body_, i->second);
+        // Deal with the scalar selects, whose condition is new.
+        if (i->second->IsSelect() && !i->second->AsSelect()->GetCondition()->IsInBlock()) {
+          vector_body_->InsertInstructionBefore(i->second->AsSelect()->GetCondition(), i->second);
+        }
         // Deal with instructions that need an environment, such as the scalar intrinsics.
         if (i->second->NeedsEnvironment()) {
           i->second->CopyEnvironmentFromWithLoopPhiAdjustment(env, vector_header_);
@@ -839,9 +984,15 @@ void HLoopOptimization::GenerateNewLoop(LoopNode* node,
   phi->AddInput(lo);
   phi->AddInput(vector_index_);
   vector_index_ = phi;
+  // Finalize phis for the reductions, which now feed the next loop.
+  for (auto i = reductions_->begin(); i != reductions_->end(); ++i) {
+    if (!i->first->IsPhi()) {
+      reductions_->Get(i->second)->AsPhi()->AddInput(vector_map_->Get(i->first));
+    }
+  }
 }
 
-// TODO: accept reductions at left-hand-side, mixed-type store idioms, etc.
+// TODO: accept mixed-type store idioms, etc.
 bool HLoopOptimization::VectorizeDef(LoopNode* node,
                                      HInstruction* instruction,
                                      bool generate_code) {
@@ -871,6 +1022,14 @@ bool HLoopOptimization::VectorizeDef(LoopNode* node,
     }
     return false;
   }
+  // Accept a left-hand-side reduction for
+  // (1) supported vector type,
+  // (2) vectorizable right-hand-side value.
+  if (reductions_->find(instruction) != reductions_->end()) {
+    Primitive::Type type = instruction->GetType();
+    return TrySetVectorType(type, &restrictions) &&
+        VectorizeUse(node, instruction, generate_code, type, restrictions);
+  }
   // Branch back okay.
   if (instruction->IsGoto()) {
     return true;
@@ -901,6 +1060,11 @@ bool HLoopOptimization::VectorizeUse(LoopNode* node,
       GenerateVecInv(instruction, type);
     }
     return true;
+  } else if (instruction->IsPhi() && reductions_->find(instruction) != reductions_->end()) {
+    // Accept a reduction phi, unless restricted. Its new phi has been
+    // generated with the loop, before any use.
+    DCHECK(!generate_code);
+    return !HasVectorRestrictions(restrictions, kNoReduction);
   } else if (instruction->IsArrayGet()) {
     // Deal with vector restrictions.
     if (instruction->AsArrayGet()->IsStringCharAt() &&
@@ -1032,6 +1196,37 @@ bool HLoopOptimization::VectorizeUse(LoopNode* node,
         return true;
       }
     }
+  } else if (instruction->IsSelect()) {
+    // Accept MIN/MAX selects, as the MIN/MAX intrinsics below.
+    bool is_min = false;
+    if (!IsSelectMinMax(instruction, &is_min)) {
+      return false;
+    }
+    HInstruction* opa = instruction->AsSelect()->GetTrueValue();
+    HInstruction* opb = instruction->AsSelect()->GetFalseValue();
+    HInstruction* r = opa;
+    HInstruction* s = opb;
+    bool is_unsigned = false;
+    if (HasVectorRestrictions(restrictions, kNoMinMax)) {
+      return false;
+    } else if (HasVectorRestrictions(restrictions, kNoHiBits) &&
+               !IsNarrowerOperands(opa, opb, type, &r, &s, &is_unsigned)) {
+      return false;  // reject, unless all operands are same-extension narrower
+    }
+    DCHECK(r != nullptr && s != nullptr);
+    if (generate_code && vector_mode_ != kVector) {  // de-idiom
+      r = opa;
+      s = opb;
+    }
+    if (VectorizeUse(node, r, generate_code, type, restrictions) &&
+        VectorizeUse(node, s, generate_code, type, restrictions)) {
+      if (generate_code) {
+        GenerateVecOp(
+            instruction, vector_map_->Get(r), vector_map_->Get(s), type, is_unsigned);
+      }
+      return true;
+    }
+    return false;
   } else if (instruction->IsInvokeStaticOrDirect()) {
     // Accept particular intrinsics.
     HInvokeStaticOrDirect* invoke = instruction->AsInvokeStaticOrDirect();
@@ -1108,7 +1303,12 @@ bool HLoopOptimization::VectorizeUse(LoopNode* node,
 
 bool HLoopOptimization::TrySetVectorType(Primitive::Type type, uint64_t* restrictions) {
   const InstructionSetFeatures* features = compiler_driver_->GetInstructionSetFeatures();
-  switch (compiler_driver_->GetInstructionSet()) {
+  InstructionSet isa = compiler_driver_->GetInstructionSet();
+  // Only the x86 code generators implement the reduction at the loop exit.
+  if (isa != kX86 && isa != kX86_64) {
+    *restrictions |= kNoReduction;
+  }
+  switch (isa) {
     case kArm:
     case kThumb2:
       // Allow vectorization for all ARM devices, because Android assumes that
@@ -1156,29 +1356,32 @@ bool HLoopOptimization::TrySetVectorType(Primitive::Type type, uint64_t* restric
       }
     case kX86:
     case kX86_64:
-      // Allow vectorization for SSE4-enabled X86 devices only (128-bit vectors).
+      // Allow vectorization for SSE4-enabled X86 devices only (128-bit vectors),
+      // using the 256-bit vectors of AVX2 when available. The code generator picks
+      // the register width for the whole method, so all the loops use the same one.
       if (features->AsX86InstructionSetFeatures()->HasSSE4_1()) {
+        size_t vector_bytes = features->AsX86InstructionSetFeatures()->HasAVX2() ? 32 : 16;
         switch (type) {
           case Primitive::kPrimBoolean:
           case Primitive::kPrimByte:
             *restrictions |= kNoMul | kNoDiv | kNoShift | kNoAbs | kNoSignedHAdd | kNoUnroundedHAdd;
-            return TrySetVectorLength(16);
+            return TrySetVectorLength(vector_bytes);
           case Primitive::kPrimChar:
           case Primitive::kPrimShort:
             *restrictions |= kNoDiv | kNoAbs | kNoSignedHAdd | kNoUnroundedHAdd;
-            return TrySetVectorLength(8);
+            return TrySetVectorLength(vector_bytes / 2);
           case Primitive::kPrimInt:
             *restrictions |= kNoDiv;
-            return TrySetVectorLength(4);
+            return TrySetVectorLength(vector_bytes / 4);
           case Primitive::kPrimLong:
             *restrictions |= kNoMul | kNoDiv | kNoShr | kNoAbs | kNoMinMax;
-            return TrySetVectorLength(2);
+            return TrySetVectorLength(vector_bytes / 8);
           case Primitive::kPrimFloat:
-            *restrictions |= kNoMinMax;  // -0.0 vs +0.0
-            return TrySetVectorLength(4);
+            *restrictions |= kNoMinMax | kNoReduction;  // -0.0 vs +0.0, non-associative
+            return TrySetVectorLength(vector_bytes / 4);
           case Primitive::kPrimDouble:
-            *restrictions |= kNoMinMax;  // -0.0 vs +0.0
-            return TrySetVectorLength(2);
+            *restrictions |= kNoMinMax | kNoReduction;  // -0.0 vs +0.0, non-associative
+            return TrySetVectorLength(vector_bytes / 8);
           default:
             break;
         }  // switch type
@@ -1257,6 +1460,55 @@ bool HLoopOptimization::TrySetVectorLength(uint32_t length) {
   return vector_length_ == length;
 }
 
+void HLoopOptimization::GenerateVecReductionPhi(HPhi* phi, HInstruction* reduction) {
+  DCHECK(reductions_->find(phi) != reductions_->end());
+  DCHECK(reductions_->Get(reduction) == phi);
+  // The chain starts from the value left by the previous loop, if any.
+  HInstruction* init = ReduceAndExtractIfNeeded(phi);
+  HPhi* new_phi = nullptr;
+  if (vector_mode_ == kVector) {
+    // Generate a [init, 0, .., 0] vector for a sum, or a [init, .., init]
+    // vector for min/max, carried by a vector phi of partial results.
+    Primitive::Type type = phi->GetType();
+    if (GetReductionKind(reduction) == HVecReduce::kSum) {
+      init = new (global_allocator_) HVecSetScalars(
+          global_allocator_, &init, type, vector_length_, /* number_of_scalars */ 1);
+    } else {
+      init = new (global_allocator_) HVecReplicateScalar(
+          global_allocator_, init, type, vector_length_);
+    }
+    Insert(vector_preheader_, init);
+    new_phi = new (global_allocator_) HPhi(
+        global_allocator_, kNoRegNumber, 0, Primitive::kPrimDouble);
+  } else {
+    DCHECK(vector_mode_ == kSequential);
+    new_phi = new (global_allocator_) HPhi(global_allocator_, kNoRegNumber, 0, phi->GetType());
+  }
+  vector_header_->AddPhi(new_phi);
+  new_phi->AddInput(init);
+  // The back edge input follows once the body is generated.
+  vector_map_->Put(phi, new_phi);
+  reductions_->Overwrite(phi, new_phi);
+}
+
+HInstruction* HLoopOptimization::ReduceAndExtractIfNeeded(HPhi* phi) {
+  HInstruction* feed = reductions_->Get(phi);
+  if (feed->IsPhi() && feed->InputAt(1)->IsVecOperation()) {
+    // Generate the reduction of the partial results along the exit of the vector loop:
+    //    x = REDUCE( [x_1, .., x_n] )
+    HVecOperation* vector = feed->InputAt(1)->AsVecOperation();
+    HBasicBlock* exit = feed->GetBlock()->GetSuccessors()[0];
+    HInstruction* reduce = new (global_allocator_) HVecReduce(global_allocator_,
+                                                              feed,
+                                                              vector->GetPackedType(),
+                                                              vector->GetVectorLength(),
+                                                              GetReductionKind(phi->InputAt(1)));
+    exit->InsertInstructionBefore(reduce, exit->GetFirstInstruction());
+    return reduce;
+  }
+  return feed;
+}
+
 void HLoopOptimization::GenerateVecInv(HInstruction* org, Primitive::Type type) {
   if (vector_map_->find(org) == vector_map_->end()) {
     // In scalar code, just use a self pass-through for scalar invariants
@@ -1289,7 +1541,7 @@ void HLoopOptimization::GenerateVecSub(HInstruction* org, HInstruction* offset)
 void HLoopOptimization::GenerateVecMem(HInstruction* org,
                                        HInstruction* opa,
                                        HInstruction* opb,
-                                       HInstruction* offset,
+                                       HInstruction* offset ATTRIBUTE_UNUSED,
                                        Primitive::Type type) {
   HInstruction* vector = nullptr;
   if (vector_mode_ == kVector) {
@@ -1303,14 +1555,8 @@ void HLoopOptimization::GenerateVecMem(HInstruction* org,
       vector = new (global_allocator_) HVecLoad(
           global_allocator_, base, opa, type, vector_length_, is_string_char_at);
     }
-    // Known dynamically enforced alignment?
-    // TODO: detect offset + constant differences.
-    // TODO: long run, static alignment analysis?
-    if (vector_peeling_candidate_ != nullptr &&
-        vector_peeling_candidate_->base == base &&
-        vector_peeling_candidate_->offset == offset) {
-      vector->AsVecMemoryOperation()->SetAlignment(Alignment(kAlignedBase, 0));
-    }
+    // The peeling candidate starts aligned, but the array may be moved by the GC
+    // at any suspend check of the loop, so its alignment is not enforced.
   } else {
     // Scalar store or load.
     DCHECK(vector_mode_ == kSequential);
@@ -1325,6 +1571,24 @@ void HLoopOptimization::GenerateVecMem(HInstruction* org,
   vector_map_->Put(org, vector);
 }
 
+HInstruction* HLoopOptimization::GenerateAlignmentPeeling(HBasicBlock* block,
+                                                          const ArrayReference* ref) {
+  // Generate the number of iterations before base[i + offset] is aligned to the vector
+  // size, or nullptr if the target does not support it.
+#if defined(ART_ENABLE_CODEGEN_x86) || defined(ART_ENABLE_CODEGEN_x86_64)
+  InstructionSet isa = compiler_driver_->GetInstructionSet();
+  if (isa == kX86 || isa == kX86_64) {
+    HInstruction* offset = (ref->offset != nullptr) ? ref->offset : graph_->GetIntConstant(0);
+    size_t alignment = vector_length_ * Primitive::ComponentSize(ref->type);
+    return Insert(block, new (global_allocator_) HX86ArrayAlignmentPeeling(
+        ref->base, offset, ref->type, alignment));
+  }
+#else
+  UNUSED(block, ref);
+#endif
+  return nullptr;
+}
+
 #define GENERATE_VEC(x, y) \
   if (vector_mode_ == kVector) { \
     vector = (x); \
@@ -1410,6 +1674,28 @@ void HLoopOptimization::GenerateVecOp(HInstruction* org,
       GENERATE_VEC(
           new (global_allocator_) HVecUShr(global_allocator_, opa, opb, type, vector_length_),
           new (global_allocator_) HUShr(type, opa, opb));
+    case HInstruction::kSelect: {
+      // The operands are the true and false values of a MIN/MAX select.
+      bool is_min = false;
+      bool is_select_min_max = IsSelectMinMax(org, &is_min);
+      DCHECK(is_select_min_max);
+      UNUSED(is_select_min_max);
+      if (vector_mode_ == kVector) {
+        vector = is_min
+            ? static_cast<HInstruction*>(new (global_allocator_) HVecMin(
+                  global_allocator_, opa, opb, type, vector_length_, is_unsigned))
+            : static_cast<HInstruction*>(new (global_allocator_) HVecMax(
+                  global_allocator_, opa, opb, type, vector_length_, is_unsigned));
+      } else {
+        // In scalar code, the condition is new as well. It is inserted with the select.
+        DCHECK(vector_mode_ == kSequential);
+        HInstruction* condition = is_min
+            ? static_cast<HInstruction*>(new (global_allocator_) HLessThan(opa, opb))
+            : static_cast<HInstruction*>(new (global_allocator_) HGreaterThan(opa, opb));
+        vector = new (global_allocator_) HSelect(condition, opa, opb, kNoDexPc);
+      }
+      break;
+    }
     case HInstruction::kInvokeStaticOrDirect: {
       HInvokeStaticOrDirect* invoke = org->AsInvokeStaticOrDirect();
       if (vector_mode_ == kVector) {
@@ -1580,9 +1866,20 @@ bool HLoopOptimization::IsVectorizationProfitable(int64_t trip_count) {
   return true;
 }
 
-void HLoopOptimization::SetPeelingCandidate(int64_t trip_count ATTRIBUTE_UNUSED) {
-  // Current heuristic: none.
-  // TODO: implement
+void HLoopOptimization::SetPeelingCandidate(int64_t trip_count) {
+  // Current heuristic: on x86, where loads and stores crossing a cache line are slow on
+  // Atom and Silvermont, align a stored array, else a loaded one, when the loop runs
+  // long enough. The other references keep their relative alignment.
+  InstructionSet isa = compiler_driver_->GetInstructionSet();
+  if ((isa != kX86 && isa != kX86_64) ||
+      (trip_count > 0 && trip_count < kPeelingMinVectorIterations * vector_length_)) {
+    return;
+  }
+  for (auto i = vector_refs_->begin(); i != vector_refs_->end(); ++i) {
+    if (vector_peeling_candidate_ == nullptr || (i->lhs && !vector_peeling_candidate_->lhs)) {
+      vector_peeling_candidate_ = &*i;
+    }
+  }
 }
 
 uint32_t HLoopOptimization::GetUnrollingFactor(HBasicBlock* block, int64_t trip_count) {
@@ -1641,17 +1938,67 @@ bool HLoopOptimization::TrySetPhiInduction(HPhi* phi, bool restrict_uses) {
   return false;
 }
 
+bool HLoopOptimization::TrySetPhiReduction(HPhi* phi) {
+  DCHECK(iset_->empty());
+  // Only unclassified phi cycles are candidates for reductions.
+  if (induction_range_.IsClassified(phi)) {
+    return false;
+  }
+  // Accept operations like x = x + .., provided that the phi and the reduction are
+  // used exactly once inside this loop, and by each other.
+  if (phi->InputCount() == 2) {
+    HInstruction* reduction = phi->InputAt(1);
+    if (HasReductionFormat(reduction, phi)) {
+      HLoopInformation* loop_info = phi->GetBlock()->GetLoopInformation();
+      int32_t use_count = 0;
+      // A MIN/MAX select also uses phi in its condition, which must only be used by the select.
+      size_t num_loop_uses = 1u;
+      if (reduction->IsSelect()) {
+        HInstruction* condition = reduction->AsSelect()->GetCondition();
+        if (!condition->GetUses().HasExactlyOneElement() || condition->HasEnvironmentUses()) {
+          return false;
+        }
+        num_loop_uses = 2u;
+      }
+      bool single_use_inside_loop =
+          // Reduction update only used by phi.
+          reduction->GetUses().HasExactlyOneElement() &&
+          !reduction->HasEnvironmentUses() &&
+          // Reduction update (and its condition) is only use of phi inside the loop.
+          IsOnlyUsedAfterLoop(loop_info, phi, /*collect_loop_uses*/ true, &use_count) &&
+          iset_->size() == num_loop_uses;
+      iset_->clear();  // leave the way you found it
+      if (single_use_inside_loop) {
+        // Link reduction back, and start recording feed value.
+        reductions_->Put(reduction, phi);
+        reductions_->Put(phi, phi->InputAt(0));
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 // Find: phi: Phi(init, addsub)
 //       s:   SuspendCheck
 //       c:   Condition(phi, bound)
 //       i:   If(c)
+// besides any number of reduction phis.
 // TODO: Find a less pattern matching approach?
-bool HLoopOptimization::TrySetSimpleLoopHeader(HBasicBlock* block) {
+bool HLoopOptimization::TrySetSimpleLoopHeader(HBasicBlock* block, /*out*/ HPhi** main_phi) {
   DCHECK(iset_->empty());
-  HInstruction* phi = block->GetFirstPhi();
-  if (phi != nullptr &&
-      phi->GetNext() == nullptr &&
-      TrySetPhiInduction(phi->AsPhi(), /*restrict_uses*/ false)) {
+  reductions_->clear();
+  HPhi* phi = nullptr;
+  for (HInstructionIterator it(block->GetPhis()); !it.Done(); it.Advance()) {
+    if (TrySetPhiReduction(it.Current()->AsPhi())) {
+      continue;
+    } else if (phi == nullptr) {
+      phi = it.Current()->AsPhi();  // candidate for the main induction
+    } else {
+      return false;
+    }
+  }
+  if (phi != nullptr && TrySetPhiInduction(phi, /*restrict_uses*/ false)) {
     HInstruction* s = block->GetFirstInstruction();
     if (s != nullptr && s->IsSuspendCheck()) {
       HInstruction* c = s->GetNext();
@@ -1663,6 +2010,7 @@ bool HLoopOptimization::TrySetSimpleLoopHeader(HBasicBlock* block) {
         if (i != nullptr && i->IsIf() && i->InputAt(0) == c) {
           iset_->insert(c);
           iset_->insert(s);
+          *main_phi = phi;
           return true;
         }
       }
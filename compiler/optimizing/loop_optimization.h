@@ -73,6 +73,7 @@ class HLoopOptimization : public HOptimization {
     kNoAbs           = 128,  // no absolute value
     kNoMinMax        = 256,  // no min/max
     kNoStringCharAt  = 512,  // no StringCharAt
+    kNoReduction     = 1024,  // no reduction
   };
 
   /*
@@ -133,6 +134,8 @@ class HLoopOptimization : public HOptimization {
                     uint64_t restrictions);
   bool TrySetVectorType(Primitive::Type type, /*out*/ uint64_t* restrictions);
   bool TrySetVectorLength(uint32_t length);
+  void GenerateVecReductionPhi(HPhi* phi, HInstruction* reduction);
+  HInstruction* ReduceAndExtractIfNeeded(HPhi* phi);
   void GenerateVecInv(HInstruction* org, Primitive::Type type);
   void GenerateVecSub(HInstruction* org, HInstruction* offset);
   void GenerateVecMem(HInstruction* org,
@@ -145,6 +148,7 @@ class HLoopOptimization : public HOptimization {
                      HInstruction* opb,
                      Primitive::Type type,
                      bool is_unsigned = false);
+  HInstruction* GenerateAlignmentPeeling(HBasicBlock* block, const ArrayReference* ref);
 
   // Vectorization idioms.
   bool VectorizeHalvingAddIdiom(LoopNode* node,
@@ -160,7 +164,8 @@ class HLoopOptimization : public HOptimization {
 
   // Helpers.
   bool TrySetPhiInduction(HPhi* phi, bool restrict_uses);
-  bool TrySetSimpleLoopHeader(HBasicBlock* block);
+  bool TrySetPhiReduction(HPhi* phi);
+  bool TrySetSimpleLoopHeader(HBasicBlock* block, /*out*/ HPhi** main_phi);
   bool IsEmptyBody(HBasicBlock* block);
   bool IsOnlyUsedAfterLoop(HLoopInformation* loop_info,
                            HInstruction* instruction,
@@ -200,6 +205,13 @@ class HLoopOptimization : public HOptimization {
   // Contents reside in phase-local heap memory.
   ArenaSet<HInstruction*>* iset_;
 
+  // Temporary bookkeeping of reduction instructions. Mapping is two-fold:
+  // (1) reductions in the loop-body are mapped back to their phi definition,
+  // (2) phi definitions are mapped to their initial value (updated during
+  //     code generation to feed the proper values into the new chain).
+  // Contents reside in phase-local heap memory.
+  ArenaSafeMap<HInstruction*, HInstruction*>* reductions_;
+
   // Counter that tracks how many induction cycles have been simplified. Useful
   // to trigger incremental updates of induction variable analysis of outer loops
   // when the induction of inner loops has changed.
@@ -1393,7 +1393,7 @@ class HLoopInformationOutwardIterator : public ValueObject {
   M(UShr, BinaryOperation)                                              \
   M(Xor, BinaryOperation)                                               \
   M(VecReplicateScalar, VecUnaryOperation)                              \
-  M(VecSumReduce, VecUnaryOperation)                                    \
+  M(VecReduce, VecUnaryOperation)                                       \
   M(VecCnv, VecUnaryOperation)                                          \
   M(VecNeg, VecUnaryOperation)                                          \
   M(VecAbs, VecUnaryOperation)                                          \
@@ -1458,6 +1458,11 @@ class HLoopInformationOutwardIterator : public ValueObject {
 #if defined(ART_ENABLE_CODEGEN_x86) || defined(ART_ENABLE_CODEGEN_x86_64)
 #define FOR_EACH_CONCRETE_INSTRUCTION_X86_COMMON(M)                     \
   M(X86BoundsCheckMemory, Instruction)                                  \
+  M(X86ArrayAlignmentPeeling, Instruction)                              \
+  M(X86Prefetch, Instruction)                                           \
+  M(X86IncrementCounter, Instruction)                                   \
+  M(X86IsGcMarking, Instruction)                                        \
+  M(X86ReadModifyWriteMemory, Instruction)                              \
   M(Suspend, Instruction)                                               \
   M(TestSuspend, Instruction)                                           \
   M(AddRHSMemory, InstructionRHSMemory)                                 \
@@ -5509,10 +5514,19 @@ class HInstanceFieldGet FINAL : public HExpression<1> {
   MemberOffset GetFieldOffset() const { return field_info_.GetFieldOffset(); }
   Primitive::Type GetFieldType() const { return field_info_.GetFieldType(); }
   bool IsVolatile() const { return field_info_.IsVolatile(); }
+  // The load only runs while the GC is not marking, and needs no read barrier:
+  // see HReadBarrierElimination.
+  bool IsReadBarrierElided() const { return GetPackedFlag<kFlagReadBarrierElided>(); }
+  void ElideReadBarrier() { SetPackedFlag<kFlagReadBarrierElided>(true); }
 
   DECLARE_INSTRUCTION(InstanceFieldGet);
 
  private:
+  static constexpr size_t kFlagReadBarrierElided = kNumberOfExpressionPackedBits;
+  static constexpr size_t kNumberOfInstanceFieldGetPackedBits = kFlagReadBarrierElided + 1;
+  static_assert(kNumberOfInstanceFieldGetPackedBits <= kMaxNumberOfPackedBits,
+                "Too many packed fields.");
+
   const FieldInfo field_info_;
 
   DISALLOW_COPY_AND_ASSIGN(HInstanceFieldGet);
@@ -5555,12 +5569,17 @@ class HInstanceFieldSet FINAL : public HTemplateInstruction<2> {
   HInstruction* GetValue() const { return InputAt(1); }
   bool GetValueCanBeNull() const { return GetPackedFlag<kFlagValueCanBeNull>(); }
   void ClearValueCanBeNull() { SetPackedFlag<kFlagValueCanBeNull>(false); }
+  // The store is into an object allocated with no GC point since, and needs no card mark
+  // with the read barrier collectors: see PrepareForRegisterAllocation.
+  bool IsWriteBarrierElided() const { return GetPackedFlag<kFlagWriteBarrierElided>(); }
+  void ElideWriteBarrier() { SetPackedFlag<kFlagWriteBarrierElided>(true); }
 
   DECLARE_INSTRUCTION(InstanceFieldSet);
 
  private:
   static constexpr size_t kFlagValueCanBeNull = kNumberOfGenericPackedBits;
-  static constexpr size_t kNumberOfInstanceFieldSetPackedBits = kFlagValueCanBeNull + 1;
+  static constexpr size_t kFlagWriteBarrierElided = kFlagValueCanBeNull + 1;
+  static constexpr size_t kNumberOfInstanceFieldSetPackedBits = kFlagWriteBarrierElided + 1;
   static_assert(kNumberOfInstanceFieldSetPackedBits <= kMaxNumberOfPackedBits,
                 "Too many packed fields.");
 
@@ -5619,6 +5638,10 @@ class HArrayGet FINAL : public HExpression<2> {
   }
 
   bool IsStringCharAt() const { return GetPackedFlag<kFlagIsStringCharAt>(); }
+  // The load only runs while the GC is not marking, and needs no read barrier:
+  // see HReadBarrierElimination.
+  bool IsReadBarrierElided() const { return GetPackedFlag<kFlagReadBarrierElided>(); }
+  void ElideReadBarrier() { SetPackedFlag<kFlagReadBarrierElided>(true); }
 
   HInstruction* GetArray() const { return InputAt(0); }
   HInstruction* GetIndex() const { return InputAt(1); }
@@ -5632,7 +5655,8 @@ class HArrayGet FINAL : public HExpression<2> {
   // of the input but that requires holding the mutator lock, so we prefer to use
   // a flag, so that code generators don't need to do the locking.
   static constexpr size_t kFlagIsStringCharAt = kNumberOfExpressionPackedBits;
-  static constexpr size_t kNumberOfArrayGetPackedBits = kFlagIsStringCharAt + 1;
+  static constexpr size_t kFlagReadBarrierElided = kFlagIsStringCharAt + 1;
+  static constexpr size_t kNumberOfArrayGetPackedBits = kFlagReadBarrierElided + 1;
   static_assert(kNumberOfArrayGetPackedBits <= HInstruction::kMaxNumberOfPackedBits,
                 "Too many packed fields.");
 
@@ -5823,7 +5847,9 @@ class HBoundsCheck FINAL : public HExpression<2> {
 class HSuspendCheck FINAL : public HTemplateInstruction<0> {
  public:
   explicit HSuspendCheck(uint32_t dex_pc = kNoDexPc)
-      : HTemplateInstruction(SideEffects::CanTriggerGC(), dex_pc), slow_path_(nullptr) {
+      : HTemplateInstruction(SideEffects::CanTriggerGC(), dex_pc),
+        slow_path_(nullptr),
+        can_be_osr_entry_(true) {
     ASSIGN_INSTRUCTION_KIND(SuspendCheck);
   }
 
@@ -5834,6 +5860,11 @@ class HSuspendCheck FINAL : public HTemplateInstruction<0> {
   void SetSlowPath(SlowPathCode* slow_path) { slow_path_ = slow_path; }
   SlowPathCode* GetSlowPath() const { return slow_path_; }
 
+  // When compiling in OSR mode, whether the loop of this suspend check may be entered
+  // from the interpreter. The loops which may not are compiled as natural loops.
+  bool CanBeOsrEntry() const { return can_be_osr_entry_; }
+  void DisableOsrEntry() { can_be_osr_entry_ = false; }
+
   DECLARE_INSTRUCTION(SuspendCheck);
 
  private:
@@ -5841,6 +5872,8 @@ class HSuspendCheck FINAL : public HTemplateInstruction<0> {
   // of a same loop.
   SlowPathCode* slow_path_;
 
+  bool can_be_osr_entry_;
+
   DISALLOW_COPY_AND_ASSIGN(HSuspendCheck);
 };
 
@@ -167,6 +167,221 @@ class HX86BoundsCheckMemory : public HExpression<2> {
   DISALLOW_COPY_AND_ASSIGN(HX86BoundsCheckMemory);
 };
 
+// X86/X86-64 number of elements from array[index] to the next element aligned at
+// the given number of bytes, used to peel a loop until its vector accesses are aligned.
+// The array may be moved by the GC afterwards, so the result is only a hint.
+class HX86ArrayAlignmentPeeling FINAL : public HExpression<2> {
+ public:
+  HX86ArrayAlignmentPeeling(HInstruction* array,
+                            HInstruction* index,
+                            Primitive::Type component_type,
+                            size_t alignment,
+                            uint32_t dex_pc = kNoDexPc)
+      : HExpression(Primitive::kPrimInt, SideEffects::DependsOnGC(), dex_pc),
+        component_type_(component_type),
+        alignment_(alignment) {
+    ASSIGN_INSTRUCTION_KIND(X86ArrayAlignmentPeeling);
+    DCHECK_EQ(array->GetType(), Primitive::kPrimNot);
+    DCHECK_EQ(index->GetType(), Primitive::kPrimInt);
+    DCHECK(IsPowerOfTwo(alignment));
+    DCHECK_GT(alignment, Primitive::ComponentSize(component_type));
+    SetRawInputAt(0, array);
+    SetRawInputAt(1, index);
+  }
+
+  bool CanBeMoved() const OVERRIDE { return true; }
+  bool InstructionDataEquals(const HInstruction* other) const OVERRIDE {
+    const HX86ArrayAlignmentPeeling* o = other->AsX86ArrayAlignmentPeeling();
+    return component_type_ == o->component_type_ && alignment_ == o->alignment_;
+  }
+
+  HInstruction* GetArray() const { return InputAt(0); }
+
+  HInstruction* GetIndex() const { return InputAt(1); }
+
+  Primitive::Type GetComponentType() const { return component_type_; }
+
+  size_t GetAlignment() const { return alignment_; }
+
+  DECLARE_INSTRUCTION(X86ArrayAlignmentPeeling);
+
+ private:
+  const Primitive::Type component_type_;
+  const size_t alignment_;
+
+  DISALLOW_COPY_AND_ASSIGN(HX86ArrayAlignmentPeeling);
+};
+
+// X86/X86-64 software prefetch of array[index + distance], or, for an indirect prefetch of an
+// Object[], of the field at the given offset of the object it references. The indirect
+// prefetch loads the element only when index + distance is in the bounds of the array.
+// A prefetch never faults and does not change the state of the program, so it has no side
+// effects, and must be inserted after the passes removing the unused instructions.
+class HX86Prefetch FINAL : public HTemplateInstruction<2> {
+ public:
+  enum Hint {
+    kPrefetchT0,   // Into all the levels of the cache.
+    kPrefetchNTA,  // Minimizing the pollution of the caches, for data used once.
+  };
+
+  static constexpr uint32_t kNoFieldOffset = static_cast<uint32_t>(-1);
+
+  HX86Prefetch(HInstruction* array,
+               HInstruction* index,
+               Primitive::Type component_type,
+               int32_t distance,
+               Hint hint,
+               uint32_t field_offset = kNoFieldOffset,
+               uint32_t dex_pc = kNoDexPc)
+      : HTemplateInstruction(SideEffects::None(), dex_pc),
+        component_type_(component_type),
+        distance_(distance),
+        hint_(hint),
+        field_offset_(field_offset) {
+    ASSIGN_INSTRUCTION_KIND(X86Prefetch);
+    DCHECK_EQ(array->GetType(), Primitive::kPrimNot);
+    DCHECK_EQ(index->GetType(), Primitive::kPrimInt);
+    DCHECK(field_offset == kNoFieldOffset || component_type == Primitive::kPrimNot);
+    SetRawInputAt(0, array);
+    SetRawInputAt(1, index);
+  }
+
+  HInstruction* GetArray() const { return InputAt(0); }
+
+  HInstruction* GetIndex() const { return InputAt(1); }
+
+  Primitive::Type GetComponentType() const { return component_type_; }
+
+  // The number of elements ahead of the index.
+  int32_t GetDistance() const { return distance_; }
+
+  Hint GetHint() const { return hint_; }
+
+  bool IsIndirect() const { return field_offset_ != kNoFieldOffset; }
+
+  uint32_t GetFieldOffset() const { return field_offset_; }
+
+  DECLARE_INSTRUCTION(X86Prefetch);
+
+ private:
+  const Primitive::Type component_type_;
+  const int32_t distance_;
+  const Hint hint_;
+  const uint32_t field_offset_;
+
+  DISALLOW_COPY_AND_ASSIGN(HX86Prefetch);
+};
+
+// X86/X86-64 increment of a 64-bit counter at a fixed address, outside of the managed heap.
+// The increment is not atomic. It reads and writes memory like a long field, so that dead code
+// elimination keeps it and value numbering does not merge two increments.
+class HX86IncrementCounter FINAL : public HTemplateInstruction<0> {
+ public:
+  explicit HX86IncrementCounter(uint64_t* counter, uint32_t dex_pc = kNoDexPc)
+      : HTemplateInstruction(
+            SideEffects::FieldWriteOfType(Primitive::kPrimLong, /* is_volatile */ false).Union(
+                SideEffects::FieldReadOfType(Primitive::kPrimLong, /* is_volatile */ false)),
+            dex_pc),
+        counter_(counter) {
+    ASSIGN_INSTRUCTION_KIND(X86IncrementCounter);
+  }
+
+  uint64_t* GetCounter() const { return counter_; }
+
+  DECLARE_INSTRUCTION(X86IncrementCounter);
+
+ private:
+  uint64_t* const counter_;
+
+  DISALLOW_COPY_AND_ASSIGN(HX86IncrementCounter);
+};
+
+// X86/X86-64 load of the is_gc_marking flag of the current thread, non-zero while the
+// concurrent copying collector marks. The flag only changes at the GC points of the thread.
+class HX86IsGcMarking FINAL : public HExpression<0> {
+ public:
+  explicit HX86IsGcMarking(uint32_t dex_pc = kNoDexPc)
+      : HExpression(Primitive::kPrimInt, SideEffects::DependsOnGC(), dex_pc) {
+    ASSIGN_INSTRUCTION_KIND(X86IsGcMarking);
+  }
+
+  bool CanBeMoved() const OVERRIDE { return true; }
+
+  bool InstructionDataEquals(const HInstruction* other ATTRIBUTE_UNUSED) const OVERRIDE {
+    return true;
+  }
+
+  DECLARE_INSTRUCTION(X86IsGcMarking);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HX86IsGcMarking);
+};
+
+// X86/X86-64 read-modify-write of an int in memory: [base + index * 4 + offset] op= value,
+// where op is an Add, Sub, And, Or or Xor. A constant index is folded into the offset.
+class HX86ReadModifyWriteMemory FINAL : public HVariableInputSizeInstruction {
+ public:
+  HX86ReadModifyWriteMemory(InstructionKind op_kind,
+                            HInstruction* value,
+                            HInstruction* base,
+                            HInstruction* index,
+                            size_t offset,
+                            bool is_array_access,
+                            ArenaAllocator* arena,
+                            uint32_t dex_pc = kNoDexPc)
+      : HVariableInputSizeInstruction(
+            is_array_access ?
+                SideEffects::ArrayWriteOfType(Primitive::kPrimInt).Union(
+                    SideEffects::ArrayReadOfType(Primitive::kPrimInt)) :
+                SideEffects::FieldWriteOfType(Primitive::kPrimInt, false).Union(
+                    SideEffects::FieldReadOfType(Primitive::kPrimInt, false)),
+            dex_pc,
+            arena,
+            (index == nullptr) ? 2 : 3,
+            kArenaAllocMisc),
+        op_kind_(op_kind),
+        from_static_(false),
+        offset_(offset) {
+    ASSIGN_INSTRUCTION_KIND(X86ReadModifyWriteMemory);
+    DCHECK(op_kind == kAdd || op_kind == kSub || op_kind == kAnd ||
+           op_kind == kOr || op_kind == kXor);
+    DCHECK_EQ(value->GetType(), Primitive::kPrimInt);
+    SetRawInputAt(0, value);
+    SetRawInputAt(1, base);
+    if (index != nullptr) {
+      SetRawInputAt(2, index);
+    }
+  }
+
+  InstructionKind GetOpKind() const { return op_kind_; }
+
+  HInstruction* GetValue() const { return InputAt(0); }
+
+  HInstruction* GetBase() const { return InputAt(1); }
+
+  HInstruction* GetIndex() const { return (InputCount() == 3) ? InputAt(2) : nullptr; }
+
+  size_t GetOffset() const { return offset_; }
+
+  bool CanDoImplicitNullCheckOn(HInstruction* obj) const OVERRIDE {
+    // Like HInstructionRHSMemory, only the field accesses do the check.
+    return obj == InputAt(1) && !from_static_ && offset_ < kPageSize && InputCount() == 2;
+  }
+
+  size_t GetBaseInputIndex() const OVERRIDE { return 1; }
+
+  void SetFromStatic() { from_static_ = true; }
+
+  DECLARE_INSTRUCTION(X86ReadModifyWriteMemory);
+
+ private:
+  const InstructionKind op_kind_;
+  bool from_static_;
+  const size_t offset_;
+
+  DISALLOW_COPY_AND_ASSIGN(HX86ReadModifyWriteMemory);
+};
+
 // neeraj - modified according to O-Master (with O, InputCount is being returned as size of array & hence
 // HInstructionRHSMemory should be derived from HVariableInputSizeInstruction instead of HTemplateInstruction<3>,
 // otherwise it leads to input corruption for user instruction)
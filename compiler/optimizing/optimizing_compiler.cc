@@ -46,6 +46,7 @@
 #include "base/dumpable.h"
 #include "base/macros.h"
 #include "base/mutex.h"
+#include "base/time_utils.h"
 #include "base/timing_logger.h"
 #include "bounds_check_elimination.h"
 #include "builder.h"
@@ -99,6 +100,7 @@
 
 #include "graph_x86.h"
 #include "pass_framework.h"
+#include "pass_telemetry.h"
 
 namespace art {
 
@@ -146,7 +148,8 @@ class PassObserver : public ValueObject {
                CodeGenerator* codegen,
                std::ostream* visualizer_output,
                CompilerDriver* compiler_driver,
-               Mutex& dump_mutex)
+               Mutex& dump_mutex,
+               HPassTelemetry* pass_telemetry = nullptr)
       : graph_(graph),
         cached_method_name_(),
         timing_logger_enabled_(compiler_driver->GetDumpPasses()),
@@ -159,7 +162,8 @@ class PassObserver : public ValueObject {
         visualizer_enabled_(!compiler_driver->GetCompilerOptions().GetDumpCfgFileName().empty()),
         visualizer_(&visualizer_oss_, graph, *codegen),
         visualizer_dump_mutex_(dump_mutex),
-        graph_in_bad_state_(false) {
+        graph_in_bad_state_(false),
+        pass_telemetry_(pass_telemetry) {
     if (timing_logger_enabled_ || visualizer_enabled_) {
       if (!IsVerboseMethod(compiler_driver, GetMethodName())) {
         timing_logger_per_method_enabled_ = visualizer_enabled_ = false;
@@ -191,6 +195,10 @@ class PassObserver : public ValueObject {
 
   void SetGraphInBadState() { graph_in_bad_state_ = true; }
 
+  HPassTelemetry* GetPassTelemetry() const { return pass_telemetry_; }
+
+  HGraph* GetGraph() const { return graph_; }
+
   const char* GetMethodName() {
     // PrettyMethod() is expensive, so we delay calling it until we actually have to.
     if (cached_method_name_.empty()) {
@@ -280,6 +288,9 @@ class PassObserver : public ValueObject {
   // expected to validate.
   bool graph_in_bad_state_;
 
+  // Per-pass telemetry shared by all compiler threads, or null if disabled.
+  HPassTelemetry* const pass_telemetry_;
+
   friend PassScope;
 
   DISALLOW_COPY_AND_ASSIGN(PassObserver);
@@ -302,9 +313,57 @@ class PassScope : public ValueObject {
   PassObserver* const pass_observer_;
 };
 
+// A PassScope also recording the pass into the pass telemetry, for the passes run outside of
+// RunOptWithPassScope.
+class TelemetryPassScope : public ValueObject {
+ public:
+  TelemetryPassScope(const char *pass_name, PassObserver* pass_observer)
+      : pass_name_(pass_name),
+        pass_observer_(pass_observer),
+        scope_(pass_name, pass_observer),
+        before_(),
+        start_ns_(0u) {
+    if (pass_observer_->GetPassTelemetry() != nullptr) {
+      before_ = HPassTelemetry::TakeSnapshot(pass_observer_->GetGraph());
+      start_ns_ = NanoTime();
+    }
+  }
+
+  ~TelemetryPassScope() {
+    HPassTelemetry* telemetry = pass_observer_->GetPassTelemetry();
+    if (telemetry != nullptr) {
+      uint64_t end_ns = NanoTime();
+      HPassTelemetry::Snapshot after = HPassTelemetry::TakeSnapshot(pass_observer_->GetGraph());
+      telemetry->Record(pass_name_, before_, after, end_ns - start_ns_);
+    }
+  }
+
+ private:
+  const char* const pass_name_;
+  PassObserver* const pass_observer_;
+  PassScope scope_;
+  HPassTelemetry::Snapshot before_;
+  uint64_t start_ns_;
+};
+
 void RunOptWithPassScope::Run() {
-  PassScope scope(opt_->GetPassName(), pass_observer_);
-  opt_->Run();
+  HPassTelemetry* telemetry = pass_observer_->GetPassTelemetry();
+  if (telemetry == nullptr) {
+    PassScope scope(opt_->GetPassName(), pass_observer_);
+    opt_->Run();
+    return;
+  }
+
+  HGraph* graph = pass_observer_->GetGraph();
+  HPassTelemetry::Snapshot before = HPassTelemetry::TakeSnapshot(graph);
+  uint64_t start_ns = NanoTime();
+  {
+    PassScope scope(opt_->GetPassName(), pass_observer_);
+    opt_->Run();
+  }
+  uint64_t end_ns = NanoTime();
+  HPassTelemetry::Snapshot after = HPassTelemetry::TakeSnapshot(graph);
+  telemetry->Record(opt_->GetPassName(), before, after, end_ns - start_ns);
 }
 
 class OptimizingCompiler FINAL : public Compiler {
@@ -350,21 +409,38 @@ class OptimizingCompiler FINAL : public Compiler {
     }
   }
 
+  // Record the memory the compilation of a method took from its arena, in total and at peak.
+  void MaybeRecordArenaUse(const ArenaAllocator& arena) const {
+    if (compilation_stats_.get() != nullptr) {
+      uint32_t kbytes = static_cast<uint32_t>(arena.BytesUsed() / KB);
+      compilation_stats_->RecordStat(MethodCompilationStat::kArenaKBytesUsed, kbytes);
+      compilation_stats_->RecordMaxStat(MethodCompilationStat::kArenaKBytesPeak, kbytes);
+    }
+  }
+
   bool JitCompile(Thread* self,
                   jit::JitCodeCache* code_cache,
                   ArtMethod* method,
                   bool osr,
+                  bool baseline,
                   jit::JitLogger* jit_logger)
       OVERRIDE
       REQUIRES_SHARED(Locks::mutator_lock_);
 
  private:
+  // Compile the JNI stub of a hot native method and commit it to the code cache.
+  bool JitCompileJniStub(Thread* self, jit::JitCodeCache* code_cache, ArtMethod* method)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Baseline compilations only run the passes the code generation needs and the cheapest
+  // simplifications, without the inliner, the loop optimizations nor the extensions.
   void RunOptimizations(HGraph* graph,
                         CodeGenerator* codegen,
                         CompilerDriver* driver,
                         const DexCompilationUnit& dex_compilation_unit,
                         PassObserver* pass_observer,
-                        VariableSizedHandleScope* handles) const;
+                        VariableSizedHandleScope* handles,
+                        bool baseline) const;
 
   void RunOptimizations(HOptimization* optimizations[],
                         size_t length,
@@ -397,6 +473,7 @@ class OptimizingCompiler FINAL : public Compiler {
                             Handle<mirror::DexCache> dex_cache,
                             ArtMethod* method,
                             bool osr,
+                            bool baseline,
                             VariableSizedHandleScope* handles) const;
 
   void MaybeRunInliner(HGraph* graph,
@@ -414,6 +491,9 @@ class OptimizingCompiler FINAL : public Compiler {
 
   std::unique_ptr<OptimizingCompilerStats> compilation_stats_;
 
+  // Per-pass time and IR deltas, enabled by --dump-stats or --dump-passes.
+  std::unique_ptr<HPassTelemetry> pass_telemetry_;
+
   std::unique_ptr<std::ostream> visualizer_output_;
 
   mutable Mutex dump_mutex_;  // To synchronize visualizer writing.
@@ -440,6 +520,9 @@ void OptimizingCompiler::Init() {
   if (driver->GetDumpStats()) {
     compilation_stats_.reset(new OptimizingCompilerStats());
   }
+  if (driver->GetDumpStats() || driver->GetDumpPasses()) {
+    pass_telemetry_.reset(new HPassTelemetry());
+  }
 }
 
 void OptimizingCompiler::UnInit() const {
@@ -449,6 +532,11 @@ OptimizingCompiler::~OptimizingCompiler() {
   if (compilation_stats_.get() != nullptr) {
     compilation_stats_->Log();
   }
+  if (pass_telemetry_.get() != nullptr) {
+    std::ostringstream oss;
+    pass_telemetry_->Dump(oss);
+    LOG(INFO) << oss.str();
+  }
 }
 
 bool OptimizingCompiler::CanCompileMethod(uint32_t method_idx ATTRIBUTE_UNUSED,
@@ -715,10 +803,13 @@ void OptimizingCompiler::RunArchOptimizations(InstructionSet instruction_set,
     case kX86: {
       x86::PcRelativeFixups* pc_relative_fixups =
           new (arena) x86::PcRelativeFixups(graph, codegen, stats);
+      HInstructionScheduling* scheduling =
+          new (arena) HInstructionScheduling(graph, instruction_set, codegen);
       x86::X86MemoryOperandGeneration* memory_gen =
           new (arena) x86::X86MemoryOperandGeneration(graph, codegen, stats);
       HOptimization* x86_optimizations[] = {
           pc_relative_fixups,
+          scheduling,
           memory_gen
       };
       RunOptimizations(x86_optimizations, arraysize(x86_optimizations), pass_observer);
@@ -727,9 +818,12 @@ void OptimizingCompiler::RunArchOptimizations(InstructionSet instruction_set,
 #endif
 #ifdef ART_ENABLE_CODEGEN_x86_64
     case kX86_64: {
+      HInstructionScheduling* scheduling =
+          new (arena) HInstructionScheduling(graph, instruction_set, codegen);
       x86::X86MemoryOperandGeneration* memory_gen =
           new (arena) x86::X86MemoryOperandGeneration(graph, codegen, stats);
       HOptimization* x86_64_optimizations[] = {
+          scheduling,
           memory_gen
       };
       RunOptimizations(x86_64_optimizations, arraysize(x86_64_optimizations), pass_observer);
@@ -741,25 +835,76 @@ void OptimizingCompiler::RunArchOptimizations(InstructionSet instruction_set,
   }
 }
 
+// Returns the register allocator to use for a method. The graph coloring allocator
+// takes longer than the linear scan allocator, but coalesces moves and spills less:
+// the tiered strategy uses it for the hot methods of the profile only, and leaves the
+// JIT, whose compilations delay the app, to the linear scan allocator.
+static RegisterAllocator::Strategy GetRegisterAllocationStrategy(const CompilerDriver* driver,
+                                                                 const DexFile& dex_file,
+                                                                 uint32_t method_idx) {
+  RegisterAllocator::Strategy strategy =
+      driver->GetCompilerOptions().GetRegisterAllocationStrategy();
+  if (strategy != RegisterAllocator::kRegisterAllocatorTiered) {
+    return strategy;
+  }
+  const ProfileCompilationInfo* profile = driver->GetProfileCompilationInfo();
+  if (driver->GetInstructionSet() == kX86_64 &&
+      Runtime::Current()->IsAotCompiler() &&
+      profile != nullptr &&
+      profile->GetMethodHotness(MethodReference(&dex_file, method_idx)).IsHot()) {
+    return RegisterAllocator::kRegisterAllocatorGraphColor;
+  }
+  return RegisterAllocator::kRegisterAllocatorLinearScan;
+}
+
 NO_INLINE  // Avoid increasing caller's frame size by large stack-allocated objects.
 static void AllocateRegisters(HGraph* graph,
                               CodeGenerator* codegen,
                               PassObserver* pass_observer,
-                              RegisterAllocator::Strategy strategy) {
+                              RegisterAllocator::Strategy strategy,
+                              OptimizingCompilerStats* stats) {
   {
-    PassScope scope(PrepareForRegisterAllocation::kPrepareForRegisterAllocationPassName,
-                    pass_observer);
+    TelemetryPassScope scope(PrepareForRegisterAllocation::kPrepareForRegisterAllocationPassName,
+                             pass_observer);
     PrepareForRegisterAllocation(graph).Run();
   }
   SsaLivenessAnalysis liveness(graph, codegen);
   {
-    PassScope scope(SsaLivenessAnalysis::kLivenessPassName, pass_observer);
+    TelemetryPassScope scope(SsaLivenessAnalysis::kLivenessPassName, pass_observer);
     liveness.Analyze();
   }
+  uint64_t start_ns = NanoTime();
   {
-    PassScope scope(RegisterAllocator::kRegisterAllocatorPassName, pass_observer);
+    TelemetryPassScope scope(RegisterAllocator::kRegisterAllocatorPassName, pass_observer);
     RegisterAllocator::Create(graph->GetArena(), codegen, liveness, strategy)->AllocateRegisters();
   }
+  uint64_t allocation_ns = NanoTime() - start_ns;
+
+  // Count the values spilled to the stack. The parameters passed on the stack and the
+  // current method have a stack slot without being spilled.
+  size_t spilled_values = 0;
+  for (size_t i = 0, e = liveness.GetNumberOfSsaValues(); i < e; ++i) {
+    HInstruction* instruction = liveness.GetInstructionFromSsaIndex(i);
+    if (!instruction->IsParameterValue() &&
+        !instruction->IsCurrentMethod() &&
+        instruction->GetLiveInterval()->HasSpillSlot()) {
+      ++spilled_values;
+    }
+  }
+  VLOG(compiler) << "Allocated registers of " << pass_observer->GetMethodName()
+                 << " with the " << (strategy == RegisterAllocator::kRegisterAllocatorGraphColor
+                                         ? "graph coloring"
+                                         : "linear scan")
+                 << " allocator in " << PrettyDuration(allocation_ns)
+                 << ", spilled values: " << spilled_values;
+  if (stats != nullptr) {
+    stats->RecordStat(strategy == RegisterAllocator::kRegisterAllocatorGraphColor
+                          ? MethodCompilationStat::kRegisterAllocatedGraphColor
+                          : MethodCompilationStat::kRegisterAllocatedLinearScan);
+    stats->RecordStat(MethodCompilationStat::kRegisterAllocationMicros,
+                      static_cast<uint32_t>(allocation_ns / 1000));
+    stats->RecordStat(MethodCompilationStat::kRegisterAllocationSpilledValues, spilled_values);
+  }
 }
 
 void OptimizingCompiler::RunOptimizations(HGraph* graph,
@@ -767,7 +912,8 @@ void OptimizingCompiler::RunOptimizations(HGraph* graph,
                                           CompilerDriver* driver,
                                           const DexCompilationUnit& dex_compilation_unit,
                                           PassObserver* pass_observer,
-                                          VariableSizedHandleScope* handles) const {
+                                          VariableSizedHandleScope* handles,
+                                          bool baseline) const {
   OptimizingCompilerStats* stats = compilation_stats_.get();
   ArenaAllocator* arena = graph->GetArena();
   if (driver->GetCompilerOptions().GetPassesToRun() != nullptr) {
@@ -827,6 +973,13 @@ void OptimizingCompiler::RunOptimizations(HGraph* graph,
     simplify1,
     dce1,
   };
+  if (baseline) {
+    // The instruction simplifier also satisfies the assumptions of the code generators, see
+    // optimizations2.
+    RunOptimizations(optimizations1, arraysize(optimizations1), pass_observer);
+    RunArchOptimizations(driver->GetInstructionSet(), graph, codegen, pass_observer);
+    return;
+  }
   //RunOptimizations(optimizations1, arraysize(optimizations1), pass_observer);
 
   // FIXME: We don't invoke SILVER for methods with irreducible
@@ -949,6 +1102,7 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
                                               Handle<mirror::DexCache> dex_cache,
                                               ArtMethod* method,
                                               bool osr,
+                                              bool baseline,
                                               VariableSizedHandleScope* handles) const {
   MaybeRecordStat(MethodCompilationStat::kAttemptCompilation);
   CompilerDriver* compiler_driver = GetCompilerDriver();
@@ -1032,7 +1186,8 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
                              codegen.get(),
                              visualizer_output_.get(),
                              compiler_driver,
-                             dump_mutex_);
+                             dump_mutex_,
+                             pass_telemetry_.get());
 
   {
     VLOG(compiler) << "Building " << pass_observer.GetMethodName();
@@ -1076,11 +1231,13 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
                    compiler_driver,
                    dex_compilation_unit,
                    &pass_observer,
-                   handles);
+                   handles,
+                   baseline);
 
   RegisterAllocator::Strategy regalloc_strategy =
-    compiler_options.GetRegisterAllocationStrategy();
-  AllocateRegisters(graph, codegen.get(), &pass_observer, regalloc_strategy);
+      GetRegisterAllocationStrategy(compiler_driver, dex_file, method_idx);
+  AllocateRegisters(
+      graph, codegen.get(), &pass_observer, regalloc_strategy, compilation_stats_.get());
 
   codegen->Compile(code_allocator);
   pass_observer.DumpDisassembly();
@@ -1125,11 +1282,13 @@ CompiledMethod* OptimizingCompiler::Compile(const DexFile::CodeItem* code_item,
                      dex_cache,
                      nullptr,
                      /* osr */ false,
+                     /* baseline */ false,
                      &handles));
     }
     if (codegen.get() != nullptr) {
       MaybeRecordStat(MethodCompilationStat::kCompiled);
       method = Emit(&arena, &code_allocator, codegen.get(), compiler_driver, code_item);
+      MaybeRecordArenaUse(arena);
 
       if (kArenaAllocatorCountAllocations) {
         if (arena.BytesAllocated() > kArenaAllocatorMemoryReportThreshold) {
@@ -1194,11 +1353,53 @@ bool CanEncodeInlinedMethodInStackMap(const DexFile& caller_dex_file, ArtMethod*
   return false;
 }
 
+bool OptimizingCompiler::JitCompileJniStub(Thread* self,
+                                           jit::JitCodeCache* code_cache,
+                                           ArtMethod* method) {
+  // Query the JNI optimization annotations, like CompileMethodHarness does for AOT.
+  JniOptimizationFlags optimization_flags = kNone;
+  if (method->IsAnnotatedWithFastNative()) {
+    optimization_flags = kFastNative;
+  } else if (method->IsAnnotatedWithCriticalNative()) {
+    optimization_flags = kCriticalNative;
+  }
+
+  CompiledMethod* compiled_method = nullptr;
+  {
+    // Go to native so that we don't block GC during compilation.
+    ScopedThreadSuspension sts(self, kNative);
+    compiled_method = JniCompile(method->GetAccessFlags(),
+                                 method->GetDexMethodIndex(),
+                                 *method->GetDexFile(),
+                                 optimization_flags);
+  }
+  if (compiled_method == nullptr) {
+    return false;
+  }
+  DCHECK(compiled_method->GetPatches().empty());
+  ArrayRef<const uint8_t> quick_code = compiled_method->GetQuickCode();
+  const uint8_t* code = code_cache->CommitJniStub(self,
+                                                  method,
+                                                  jit::JitCodeCache::GetJniStubKey(method),
+                                                  compiled_method->GetFrameSizeInBytes(),
+                                                  compiled_method->GetCoreSpillMask(),
+                                                  compiled_method->GetFpSpillMask(),
+                                                  quick_code.data(),
+                                                  quick_code.size());
+  CompiledMethod::ReleaseSwapAllocatedCompiledMethod(GetCompilerDriver(), compiled_method);
+  return code != nullptr;
+}
+
 bool OptimizingCompiler::JitCompile(Thread* self,
                                     jit::JitCodeCache* code_cache,
                                     ArtMethod* method,
                                     bool osr,
+                                    bool baseline,
                                     jit::JitLogger* jit_logger) {
+  if (method->IsNative()) {
+    return JitCompileJniStub(self, code_cache, method);
+  }
+
   StackHandleScope<3> hs(self);
   Handle<mirror::ClassLoader> class_loader(hs.NewHandle(
       method->GetDeclaringClass()->GetClassLoader()));
@@ -1233,6 +1434,7 @@ bool OptimizingCompiler::JitCompile(Thread* self,
                    dex_cache,
                    method,
                    osr,
+                   baseline,
                    &handles));
     if (codegen.get() == nullptr) {
       return false;
@@ -1334,8 +1536,9 @@ bool OptimizingCompiler::JitCompile(Thread* self,
   }
 
   Runtime::Current()->GetJit()->AddMemoryUsage(method, arena.BytesUsed());
+  MaybeRecordArenaUse(arena);
   if (jit_logger != nullptr) {
-    jit_logger->WriteLog(code, code_allocator.GetSize(), method);
+    jit_logger->WriteLog(code, code_allocator.GetSize(), method, osr, baseline);
   }
 
   return true;
@@ -31,6 +31,7 @@ enum MethodCompilationStat {
   kCHAInline,
   kCompiled,
   kInlinedInvoke,
+  kInlinedInvokeInCountedLoop,
   kReplacedInvokeWithSimplePattern,
   kInstructionSimplifications,
   kInstructionSimplificationsArch,
@@ -81,6 +82,7 @@ enum MethodCompilationStat {
   kNotInlinedTryCatch,
   kNotInlinedRegisterAllocator,
   kNotInlinedCannotBuild,
+  kNotInlinedKnownFailure,
   kNotInlinedNotVerified,
   kNotInlinedCodeItem,
   kNotInlinedWont,
@@ -91,10 +93,21 @@ enum MethodCompilationStat {
   kIntelLoopPeeled,
   kIntelRemoveTrivialLoops,
   kIntelRemoveSuspendCheck,
+  kIntelCountedSuspendCheck,
   kIntelCCS,
   kIntelNonTemporalMove,
   kIntelLoopFullyUnrolled,
   kIntelLoopPartiallyUnrolled,
+  kIntelLoopUnrolledAndJammed,
+  kIntelLoopVersioned,
+  kIntelTypeGuardUnswitched,
+  kIntelOsrEntryMoved,
+  kIntelScalarReplaced,
+  kIntelLoopFused,
+  kIntelLoopInterchanged,
+  kIntelLoopBoundsCheckRemoved,
+  kIntelStrengthReduced,
+  kIntelIVEliminated,
   kIntelFormBottomLoop,
   kIntelLHSS,
   kIntelStoreSink,
@@ -102,6 +115,21 @@ enum MethodCompilationStat {
   kIntelCliqueInstructionEliminated,
   kIntelBranchSimplified,
   kIntelBranchConditionDeleted,
+  kIntelPartialRedundancyEliminated,
+  kIntelLoopIfConverted,
+  kIntelLoopInliningUnlocked,
+  kIntelCHAGuardHoisted,
+  kIntelTripCountSpeculated,
+  kIntelPrefetchInserted,
+  kIntelLoopAlignmentPadding,
+  kIntelReadBarrierLoopVersioned,
+  kIntelLoopCounted,
+  kRegisterAllocatedLinearScan,
+  kRegisterAllocatedGraphColor,
+  kRegisterAllocationMicros,
+  kRegisterAllocationSpilledValues,
+  kArenaKBytesUsed,
+  kArenaKBytesPeak,
   kLastStat
 };
 
@@ -116,6 +144,13 @@ class OptimizingCompilerStats {
     compile_stats_[stat] += count;
   }
 
+  // Record value if it is larger than the ones recorded for stat so far.
+  void RecordMaxStat(MethodCompilationStat stat, uint32_t value) {
+    uint32_t current = compile_stats_[stat].load(std::memory_order_relaxed);
+    while (value > current && !compile_stats_[stat].compare_exchange_weak(current, value)) {
+    }
+  }
+
   void Log() const {
     if (!kIsDebugBuild && !VLOG_IS_ON(compiler)) {
       // Log only in debug builds or if the compiler is verbose.
@@ -163,6 +198,7 @@ class OptimizingCompilerStats {
       case kCHAInline : name = "CHAInline"; break;
       case kCompiled : name = "Compiled"; break;
       case kInlinedInvoke : name = "InlinedInvoke"; break;
+      case kInlinedInvokeInCountedLoop : name = "InlinedInvokeInCountedLoop"; break;
       case kReplacedInvokeWithSimplePattern: name = "ReplacedInvokeWithSimplePattern"; break;
       case kInstructionSimplifications: name = "InstructionSimplifications"; break;
       case kInstructionSimplificationsArch: name = "InstructionSimplificationsArch"; break;
@@ -213,6 +249,7 @@ class OptimizingCompilerStats {
       case kNotInlinedTryCatch: name = "NotInlinedTryCatch"; break;
       case kNotInlinedRegisterAllocator: name = "NotInlinedRegisterAllocator"; break;
       case kNotInlinedCannotBuild: name = "NotInlinedCannotBuild"; break;
+      case kNotInlinedKnownFailure: name = "NotInlinedKnownFailure"; break;
       case kNotInlinedNotVerified: name = "NotInlinedNotVerified"; break;
       case kNotInlinedCodeItem: name = "NotInlinedCodeItem"; break;
       case kNotInlinedWont: name = "NotInlinedWont"; break;
@@ -223,10 +260,21 @@ class OptimizingCompilerStats {
       case kIntelLoopPeeled: return "kIntelLoopPeeled";
       case kIntelRemoveTrivialLoops: return "kIntelRemoveTrivialLoops";
       case kIntelRemoveSuspendCheck: return "kIntelRemoveSuspendCheck";
+      case kIntelCountedSuspendCheck: return "kIntelCountedSuspendCheck";
       case kIntelCCS: return "kIntelCCS";
       case kIntelNonTemporalMove: return "kIntelNonTemporalMove";
       case kIntelLoopFullyUnrolled: return "kIntelLoopFullyUnrolled";
       case kIntelLoopPartiallyUnrolled: return "kIntelLoopPartiallyUnrolled";
+      case kIntelLoopUnrolledAndJammed: return "kIntelLoopUnrolledAndJammed";
+      case kIntelLoopVersioned: return "kIntelLoopVersioned";
+      case kIntelTypeGuardUnswitched: return "kIntelTypeGuardUnswitched";
+      case kIntelOsrEntryMoved: return "kIntelOsrEntryMoved";
+      case kIntelScalarReplaced: return "kIntelScalarReplaced";
+      case kIntelLoopFused: return "kIntelLoopFused";
+      case kIntelLoopInterchanged: return "kIntelLoopInterchanged";
+      case kIntelLoopBoundsCheckRemoved: return "kIntelLoopBoundsCheckRemoved";
+      case kIntelStrengthReduced: return "kIntelStrengthReduced";
+      case kIntelIVEliminated: return "kIntelIVEliminated";
       case kIntelFormBottomLoop: return "kIntelFormBottomLoop";
       case kIntelLHSS: return "kIntelLHSS";
       case kIntelStoreSink: return "kIntelStoreSink";
@@ -234,6 +282,21 @@ class OptimizingCompilerStats {
       case kIntelCliqueInstructionEliminated: return "kIntelCliqueInstructionEliminated";
       case kIntelBranchSimplified: return "kIntelBranchSimplified";
       case kIntelBranchConditionDeleted: return "kIntelBranchConditionDeleted";
+      case kIntelPartialRedundancyEliminated: return "kIntelPartialRedundancyEliminated";
+      case kIntelLoopIfConverted: return "kIntelLoopIfConverted";
+      case kIntelLoopInliningUnlocked: return "kIntelLoopInliningUnlocked";
+      case kIntelCHAGuardHoisted: return "kIntelCHAGuardHoisted";
+      case kIntelTripCountSpeculated: return "kIntelTripCountSpeculated";
+      case kIntelPrefetchInserted: return "kIntelPrefetchInserted";
+      case kIntelLoopAlignmentPadding: return "kIntelLoopAlignmentPadding";
+      case kIntelReadBarrierLoopVersioned: return "kIntelReadBarrierLoopVersioned";
+      case kIntelLoopCounted: return "kIntelLoopCounted";
+      case kRegisterAllocatedLinearScan: name = "RegisterAllocatedLinearScan"; break;
+      case kRegisterAllocatedGraphColor: name = "RegisterAllocatedGraphColor"; break;
+      case kRegisterAllocationMicros: name = "RegisterAllocationMicros"; break;
+      case kRegisterAllocationSpilledValues: name = "RegisterAllocationSpilledValues"; break;
+      case kArenaKBytesUsed: name = "ArenaKBytesUsed"; break;
+      case kArenaKBytesPeak: name = "ArenaKBytesPeak"; break;
       case kLastStat:
         LOG(FATAL) << "invalid stat "
             << static_cast<std::underlying_type<MethodCompilationStat>::type>(stat);
@@ -101,6 +101,43 @@ void PrepareForRegisterAllocation::VisitArraySet(HArraySet* instruction) {
   }
 }
 
+bool PrepareForRegisterAllocation::IsFreshlyAllocated(HInstruction* object,
+                                                      HInstruction* user) const {
+  if (!object->IsNewInstance() || object->GetBlock() != user->GetBlock()) {
+    return false;
+  }
+  // The object must still be in the region it was allocated in when `user` executes:
+  // nothing in between may suspend the thread or trigger a GC.
+  for (HInstruction* current = object->GetNext(); current != user; current = current->GetNext()) {
+    if (current == nullptr ||
+        current->IsSuspendCheck() ||
+        current->IsSuspend() ||
+        current->GetSideEffects().Includes(SideEffects::CanTriggerGC())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PrepareForRegisterAllocation::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  // With the concurrent copying collectors, objects allocated since the last GC pause are
+  // in regions the next collection traces entirely, and the runtime dirties the card of
+  // those allocated elsewhere (see Heap::AllocObjectWithAllocator). A store into an object
+  // allocated with no GC point since does not need to mark the card then.
+  if (!kEmitCompilerReadBarrier ||
+      instruction->GetFieldType() != Primitive::kPrimNot ||
+      instruction->IsWriteBarrierElided()) {
+    return;
+  }
+  HInstruction* object = instruction->InputAt(0);
+  if (object->IsNullCheck()) {
+    object = object->InputAt(0);
+  }
+  if (IsFreshlyAllocated(object, instruction)) {
+    instruction->ElideWriteBarrier();
+  }
+}
+
 void PrepareForRegisterAllocation::VisitClinitCheck(HClinitCheck* check) {
   // Try to find a static invoke or a new-instance from which this check originated.
   HInstruction* implicit_clinit = nullptr;
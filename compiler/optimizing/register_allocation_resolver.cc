@@ -304,6 +304,7 @@ void RegisterAllocationResolver::ConnectSiblings(LiveInterval* interval) {
       case 1: loc = Location::StackSlot(interval->GetParent()->GetSpillSlot()); break;
       case 2: loc = Location::DoubleStackSlot(interval->GetParent()->GetSpillSlot()); break;
       case 4: loc = Location::SIMDStackSlot(interval->GetParent()->GetSpillSlot()); break;
+      case 8: loc = Location::SIMDStackSlot(interval->GetParent()->GetSpillSlot()); break;
       default: LOG(FATAL) << "Unexpected number of spill slots"; UNREACHABLE();
     }
     InsertMoveAfter(interval->GetDefinedBy(), interval->ToLocation(), loc);
@@ -467,6 +468,7 @@ void RegisterAllocationResolver::ConnectSplitSiblings(LiveInterval* interval,
         case 1: location_source = Location::StackSlot(parent->GetSpillSlot()); break;
         case 2: location_source = Location::DoubleStackSlot(parent->GetSpillSlot()); break;
         case 4: location_source = Location::SIMDStackSlot(parent->GetSpillSlot()); break;
+        case 8: location_source = Location::SIMDStackSlot(parent->GetSpillSlot()); break;
         default: LOG(FATAL) << "Unexpected number of spill slots"; UNREACHABLE();
       }
     }
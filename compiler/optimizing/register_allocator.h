@@ -41,7 +41,10 @@ class RegisterAllocator : public ArenaObject<kArenaAllocRegisterAllocator> {
  public:
   enum Strategy {
     kRegisterAllocatorLinearScan,
-    kRegisterAllocatorGraphColor
+    kRegisterAllocatorGraphColor,
+    // Graph coloring for the hot methods of the profile when compiling ahead of time
+    // for x86-64, linear scan otherwise. Picked by the compiler for each method.
+    kRegisterAllocatorTiered
   };
 
   static constexpr Strategy kRegisterAllocatorDefault = kRegisterAllocatorLinearScan;
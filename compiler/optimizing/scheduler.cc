@@ -27,6 +27,10 @@
 #include "scheduler_arm.h"
 #endif
 
+#if defined(ART_ENABLE_CODEGEN_x86) || defined(ART_ENABLE_CODEGEN_x86_64)
+#include "scheduler_x86.h"
+#endif
+
 namespace art {
 
 void SchedulingGraph::AddDependency(SchedulingNode* node,
@@ -788,7 +792,8 @@ bool HScheduler::IsSchedulingBarrier(const HInstruction* instr) const {
 
 void HInstructionScheduling::Run(bool only_optimize_loop_blocks,
                                  bool schedule_randomly) {
-#if defined(ART_ENABLE_CODEGEN_arm64) || defined(ART_ENABLE_CODEGEN_arm)
+#if defined(ART_ENABLE_CODEGEN_arm64) || defined(ART_ENABLE_CODEGEN_arm) || \
+    defined(ART_ENABLE_CODEGEN_x86) || defined(ART_ENABLE_CODEGEN_x86_64)
   // Phase-local allocator that allocates scheduler internal data structures like
   // scheduling nodes, internel nodes map, dependencies, etc.
   ArenaAllocator arena_allocator(graph_->GetArena()->GetArenaPool());
@@ -822,6 +827,16 @@ void HInstructionScheduling::Run(bool only_optimize_loop_blocks,
       scheduler.Schedule(graph_);
       break;
     }
+#endif
+#if defined(ART_ENABLE_CODEGEN_x86) || defined(ART_ENABLE_CODEGEN_x86_64)
+    case kX86:
+    case kX86_64: {
+      x86::SchedulingLatencyVisitorX86 x86_latency_visitor(codegen_);
+      x86::HSchedulerX86 scheduler(&arena_allocator, selector, &x86_latency_visitor);
+      scheduler.SetOnlyOptimizeLoopBlocks(only_optimize_loop_blocks);
+      scheduler.Schedule(graph_);
+      break;
+    }
 #endif
     default:
       break;
@@ -217,7 +217,7 @@ void SchedulingLatencyVisitorARM64::VisitVecSetScalars(HVecSetScalars* instr) {
   LOG(FATAL) << "Unsupported SIMD instruction " << instr->GetId();
 }
 
-void SchedulingLatencyVisitorARM64::VisitVecSumReduce(HVecSumReduce* instr) {
+void SchedulingLatencyVisitorARM64::VisitVecReduce(HVecReduce* instr) {
   LOG(FATAL) << "Unsupported SIMD instruction " << instr->GetId();
 }
 
@@ -84,7 +84,7 @@ class SchedulingLatencyVisitorARM64 : public SchedulingLatencyVisitor {
   M(TypeConversion       , unused)                   \
   M(VecReplicateScalar   , unused)                   \
   M(VecSetScalars        , unused)                   \
-  M(VecSumReduce         , unused)                   \
+  M(VecReduce            , unused)                   \
   M(VecCnv               , unused)                   \
   M(VecNeg               , unused)                   \
   M(VecAbs               , unused)                   \
@@ -33,6 +33,11 @@
 #include "scheduler_arm.h"
 #endif
 
+#if defined(ART_ENABLE_CODEGEN_x86) || defined(ART_ENABLE_CODEGEN_x86_64)
+#include "arch/x86/instruction_set_features_x86.h"
+#include "scheduler_x86.h"
+#endif
+
 namespace art {
 
 // Return all combinations of ISA and code generator that are executable on
@@ -370,6 +375,41 @@ TEST_F(SchedulerTest, ArrayAccessAliasingARM) {
 }
 #endif
 
+#if defined(ART_ENABLE_CODEGEN_x86) || defined(ART_ENABLE_CODEGEN_x86_64)
+TEST_F(SchedulerTest, DependencyGraphAndSchedulerX86) {
+  CriticalPathSchedulingNodeSelector critical_path_selector;
+  x86::SchedulingLatencyVisitorX86 x86_latency_visitor(/*CodeGenerator*/ nullptr);
+  x86::HSchedulerX86 scheduler(&allocator_, &critical_path_selector, &x86_latency_visitor);
+  TestBuildDependencyGraphAndSchedule(&scheduler);
+}
+
+TEST_F(SchedulerTest, ArrayAccessAliasingX86) {
+  CriticalPathSchedulingNodeSelector critical_path_selector;
+  x86::SchedulingLatencyVisitorX86 x86_latency_visitor(/*CodeGenerator*/ nullptr);
+  x86::HSchedulerX86 scheduler(&allocator_, &critical_path_selector, &x86_latency_visitor);
+  TestDependencyGraphOnAliasingArrayAccesses(&scheduler);
+}
+
+TEST_F(SchedulerTest, MicroarchitectureX86) {
+  std::string error_msg;
+  auto microarchitecture = [&error_msg](const std::string& variant) {
+    X86FeaturesUniquePtr features = X86InstructionSetFeatures::FromVariant(variant, &error_msg);
+    return x86::SchedulingLatencyVisitorX86::GetMicroarchitecture(*features);
+  };
+  EXPECT_EQ(x86::X86Microarchitecture::kBonnell, microarchitecture("atom"));
+  EXPECT_EQ(x86::X86Microarchitecture::kSilvermont, microarchitecture("silvermont"));
+  EXPECT_EQ(x86::X86Microarchitecture::kCore, microarchitecture("default"));
+
+  // The in-order cores pay most for long latencies left unhidden.
+  const x86::X86Latencies& bonnell =
+      x86::SchedulingLatencyVisitorX86::GetLatencies(x86::X86Microarchitecture::kBonnell);
+  const x86::X86Latencies& core =
+      x86::SchedulingLatencyVisitorX86::GetLatencies(x86::X86Microarchitecture::kCore);
+  EXPECT_GT(bonnell.mul_integer, core.mul_integer);
+  EXPECT_GT(bonnell.simd_div_float, core.simd_div_float);
+}
+#endif
+
 TEST_F(SchedulerTest, RandomScheduling) {
   //
   // Java source: crafted code to make sure (random) scheduling should get correct result.
@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scheduler_x86.h"
+
+#include "arch/x86/instruction_set_features_x86.h"
+#include "code_generator_utils.h"
+#include "code_generator_x86.h"
+#include "mirror/string.h"
+
+#ifdef ART_ENABLE_CODEGEN_x86_64
+#include "code_generator_x86_64.h"
+#endif
+
+namespace art {
+namespace x86 {
+
+// The latencies come from the optimization manuals of the Intel architectures, for
+// the forms emitted by the code generators: register operands, L1 hits for memory.
+static constexpr X86Latencies kBonnellLatencies = {
+  /* integer_op */ 1,
+  /* mul_integer */ 5,
+  /* div_integer */ 30,
+  /* floating_point_op */ 5,
+  /* mul_floating_point */ 5,
+  /* div_float */ 31,
+  /* div_double */ 60,
+  /* type_conversion_floating_point_integer */ 6,
+  /* memory_load */ 3,
+  /* memory_store */ 1,
+  /* simd_integer_op */ 1,
+  /* simd_mul_integer */ 5,
+  /* simd_floating_point_op */ 5,
+  /* simd_mul_floating_point */ 5,
+  /* simd_div_float */ 70,
+  /* simd_div_double */ 125,
+  /* simd_memory_load */ 3,
+  /* simd_memory_store */ 1,
+};
+
+static constexpr X86Latencies kSilvermontLatencies = {
+  /* integer_op */ 1,
+  /* mul_integer */ 3,
+  /* div_integer */ 25,
+  /* floating_point_op */ 3,
+  /* mul_floating_point */ 5,
+  /* div_float */ 19,
+  /* div_double */ 34,
+  /* type_conversion_floating_point_integer */ 4,
+  /* memory_load */ 3,
+  /* memory_store */ 1,
+  /* simd_integer_op */ 1,
+  /* simd_mul_integer */ 11,
+  /* simd_floating_point_op */ 3,
+  /* simd_mul_floating_point */ 5,
+  /* simd_div_float */ 39,
+  /* simd_div_double */ 69,
+  /* simd_memory_load */ 3,
+  /* simd_memory_store */ 1,
+};
+
+static constexpr X86Latencies kCoreLatencies = {
+  /* integer_op */ 1,
+  /* mul_integer */ 3,
+  /* div_integer */ 26,
+  /* floating_point_op */ 4,
+  /* mul_floating_point */ 4,
+  /* div_float */ 11,
+  /* div_double */ 14,
+  /* type_conversion_floating_point_integer */ 4,
+  /* memory_load */ 5,
+  /* memory_store */ 1,
+  /* simd_integer_op */ 1,
+  /* simd_mul_integer */ 10,
+  /* simd_floating_point_op */ 4,
+  /* simd_mul_floating_point */ 4,
+  /* simd_div_float */ 11,
+  /* simd_div_double */ 14,
+  /* simd_memory_load */ 6,
+  /* simd_memory_store */ 1,
+};
+
+static const X86InstructionSetFeatures* GetInstructionSetFeatures(CodeGenerator* codegen) {
+  if (codegen == nullptr) {
+    return nullptr;
+  }
+  switch (codegen->GetInstructionSet()) {
+    case kX86:
+      return &down_cast<CodeGeneratorX86*>(codegen)->GetInstructionSetFeatures();
+#ifdef ART_ENABLE_CODEGEN_x86_64
+    case kX86_64:
+      return &down_cast<x86_64::CodeGeneratorX86_64*>(codegen)->GetInstructionSetFeatures();
+#endif
+    default:
+      LOG(FATAL) << "Unexpected instruction set " << codegen->GetInstructionSet();
+      UNREACHABLE();
+  }
+}
+
+static X86Microarchitecture GetTargetMicroarchitecture(CodeGenerator* codegen) {
+  const X86InstructionSetFeatures* features = GetInstructionSetFeatures(codegen);
+  return (features == nullptr)
+      ? X86Microarchitecture::kCore
+      : SchedulingLatencyVisitorX86::GetMicroarchitecture(*features);
+}
+
+SchedulingLatencyVisitorX86::SchedulingLatencyVisitorX86(CodeGenerator* codegen)
+    : latencies_(GetLatencies(GetTargetMicroarchitecture(codegen))),
+      is_x86_64_(codegen != nullptr && codegen->GetInstructionSet() == kX86_64) {}
+
+X86Microarchitecture SchedulingLatencyVisitorX86::GetMicroarchitecture(
+    const X86InstructionSetFeatures& features) {
+  if (features.HasAVX()) {
+    return X86Microarchitecture::kCore;
+  } else if (features.HasSSE4_1()) {
+    return X86Microarchitecture::kSilvermont;
+  } else if (features.HasSSSE3()) {
+    return X86Microarchitecture::kBonnell;
+  } else {
+    // The default features tell nothing about the CPU.
+    return X86Microarchitecture::kCore;
+  }
+}
+
+const X86Latencies& SchedulingLatencyVisitorX86::GetLatencies(
+    X86Microarchitecture microarchitecture) {
+  switch (microarchitecture) {
+    case X86Microarchitecture::kBonnell:
+      return kBonnellLatencies;
+    case X86Microarchitecture::kSilvermont:
+      return kSilvermontLatencies;
+    case X86Microarchitecture::kCore:
+      return kCoreLatencies;
+  }
+  LOG(FATAL) << "Unreachable";
+  UNREACHABLE();
+}
+
+void SchedulingLatencyVisitorX86::VisitArrayGet(HArrayGet* instruction) {
+  if (instruction->IsStringCharAt() && mirror::kUseStringCompression) {
+    // Take the test of the compression flag into account.
+    last_visited_internal_latency_ = latencies_.memory_load + kX86BranchLatency;
+  }
+  last_visited_latency_ = latencies_.memory_load;
+}
+
+void SchedulingLatencyVisitorX86::VisitArrayLength(HArrayLength* ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_.memory_load;
+}
+
+void SchedulingLatencyVisitorX86::VisitArraySet(HArraySet* ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_.memory_store;
+}
+
+void SchedulingLatencyVisitorX86::VisitBinaryOperation(HBinaryOperation* instr) {
+  last_visited_latency_ = Primitive::IsFloatingPointType(instr->GetResultType())
+      ? latencies_.floating_point_op
+      : latencies_.integer_op;
+}
+
+void SchedulingLatencyVisitorX86::VisitBoundsCheck(HBoundsCheck* ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = latencies_.integer_op;
+  // Users do not use any data results.
+  last_visited_latency_ = 0;
+}
+
+void SchedulingLatencyVisitorX86::VisitDiv(HDiv* instr) {
+  Primitive::Type type = instr->GetResultType();
+  switch (type) {
+    case Primitive::kPrimFloat:
+      last_visited_latency_ = latencies_.div_float;
+      break;
+    case Primitive::kPrimDouble:
+      last_visited_latency_ = latencies_.div_double;
+      break;
+    default:
+      // Follow the code path used by code generation.
+      if (instr->GetRight()->IsConstant()) {
+        int64_t imm = Int64FromConstant(instr->GetRight()->AsConstant());
+        if (imm == 0) {
+          last_visited_internal_latency_ = 0;
+          last_visited_latency_ = 0;
+        } else if (imm == 1 || imm == -1) {
+          last_visited_internal_latency_ = 0;
+          last_visited_latency_ = latencies_.integer_op;
+        } else if (IsPowerOfTwo(AbsOrMin(imm))) {
+          last_visited_internal_latency_ = 3 * latencies_.integer_op;
+          last_visited_latency_ = latencies_.integer_op;
+        } else {
+          DCHECK(imm <= -2 || imm >= 2);
+          last_visited_internal_latency_ = latencies_.mul_integer + 2 * latencies_.integer_op;
+          last_visited_latency_ = latencies_.integer_op;
+        }
+      } else if (type == Primitive::kPrimLong && !is_x86_64_) {
+        // The 64-bit division is a runtime call on x86.
+        last_visited_internal_latency_ = kX86CallInternalLatency;
+        last_visited_latency_ = kX86CallLatency;
+      } else {
+        last_visited_latency_ = latencies_.div_integer;
+      }
+      break;
+  }
+}
+
+void SchedulingLatencyVisitorX86::VisitInstanceFieldGet(HInstanceFieldGet* ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_.memory_load;
+}
+
+void SchedulingLatencyVisitorX86::VisitInstanceOf(HInstanceOf* ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = kX86CallInternalLatency;
+  last_visited_latency_ = latencies_.integer_op;
+}
+
+void SchedulingLatencyVisitorX86::VisitInvoke(HInvoke* ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = kX86CallInternalLatency;
+  last_visited_latency_ = kX86CallLatency;
+}
+
+void SchedulingLatencyVisitorX86::VisitLoadString(HLoadString* ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = kX86LoadStringInternalLatency;
+  last_visited_latency_ = latencies_.memory_load;
+}
+
+void SchedulingLatencyVisitorX86::VisitMul(HMul* instr) {
+  Primitive::Type type = instr->GetResultType();
+  if (Primitive::IsFloatingPointType(type)) {
+    last_visited_latency_ = latencies_.mul_floating_point;
+  } else if (type == Primitive::kPrimLong && !is_x86_64_) {
+    // Three multiplications of the register pairs, the last two being independent.
+    last_visited_internal_latency_ = latencies_.mul_integer;
+    last_visited_latency_ = latencies_.mul_integer + latencies_.integer_op;
+  } else {
+    last_visited_latency_ = latencies_.mul_integer;
+  }
+}
+
+void SchedulingLatencyVisitorX86::VisitNewArray(HNewArray* ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = latencies_.integer_op + kX86CallInternalLatency;
+  last_visited_latency_ = kX86CallLatency;
+}
+
+void SchedulingLatencyVisitorX86::VisitNewInstance(HNewInstance* instruction) {
+  if (instruction->IsStringAlloc()) {
+    last_visited_internal_latency_ = 2 + latencies_.memory_load + kX86CallInternalLatency;
+  } else {
+    last_visited_internal_latency_ = kX86CallInternalLatency;
+  }
+  last_visited_latency_ = kX86CallLatency;
+}
+
+void SchedulingLatencyVisitorX86::VisitRem(HRem* instruction) {
+  Primitive::Type type = instruction->GetResultType();
+  if (Primitive::IsFloatingPointType(type)) {
+    // The x87 partial remainder loop.
+    last_visited_internal_latency_ = kX86CallInternalLatency;
+    last_visited_latency_ = kX86CallLatency;
+  } else if (instruction->GetRight()->IsConstant()) {
+    // Follow the code path used by code generation.
+    int64_t imm = Int64FromConstant(instruction->GetRight()->AsConstant());
+    if (imm == 0) {
+      last_visited_internal_latency_ = 0;
+      last_visited_latency_ = 0;
+    } else if (imm == 1 || imm == -1) {
+      last_visited_internal_latency_ = 0;
+      last_visited_latency_ = latencies_.integer_op;
+    } else if (IsPowerOfTwo(AbsOrMin(imm))) {
+      last_visited_internal_latency_ = 3 * latencies_.integer_op;
+      last_visited_latency_ = latencies_.integer_op;
+    } else {
+      DCHECK(imm <= -2 || imm >= 2);
+      last_visited_internal_latency_ = 2 * latencies_.mul_integer + 2 * latencies_.integer_op;
+      last_visited_latency_ = latencies_.integer_op;
+    }
+  } else if (type == Primitive::kPrimLong && !is_x86_64_) {
+    last_visited_internal_latency_ = kX86CallInternalLatency;
+    last_visited_latency_ = kX86CallLatency;
+  } else {
+    last_visited_latency_ = latencies_.div_integer;
+  }
+}
+
+void SchedulingLatencyVisitorX86::VisitStaticFieldGet(HStaticFieldGet* ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_.memory_load;
+}
+
+void SchedulingLatencyVisitorX86::VisitSuspendCheck(HSuspendCheck* instruction) {
+  HBasicBlock* block = instruction->GetBlock();
+  DCHECK((block->GetLoopInformation() != nullptr) ||
+         (block->IsEntryBlock() && instruction->GetNext()->IsGoto()));
+  // Users do not use any data results.
+  last_visited_latency_ = 0;
+}
+
+void SchedulingLatencyVisitorX86::VisitTypeConversion(HTypeConversion* instr) {
+  if (Primitive::IsFloatingPointType(instr->GetResultType()) ||
+      Primitive::IsFloatingPointType(instr->GetInputType())) {
+    last_visited_latency_ = latencies_.type_conversion_floating_point_integer;
+  } else {
+    last_visited_latency_ = latencies_.integer_op;
+  }
+}
+
+void SchedulingLatencyVisitorX86::VisitVecOperation(HVecOperation* instr) {
+  // The vector operations not handled below are simple arithmetic.
+  last_visited_latency_ = Primitive::IsFloatingPointType(instr->GetPackedType())
+      ? latencies_.simd_floating_point_op
+      : latencies_.simd_integer_op;
+}
+
+void SchedulingLatencyVisitorX86::VisitVecReplicateScalar(HVecReplicateScalar* instr) {
+  // A move to the vector register, then shuffles.
+  last_visited_internal_latency_ = latencies_.type_conversion_floating_point_integer;
+  VisitVecOperation(instr);
+}
+
+void SchedulingLatencyVisitorX86::VisitVecReduce(HVecReduce* instr) {
+  // A shuffle and an operation for each halving of the vector, then a move out.
+  uint32_t steps = WhichPowerOf2(instr->GetVectorLength());
+  last_visited_internal_latency_ = steps * (latencies_.simd_integer_op + 1);
+  last_visited_latency_ = latencies_.type_conversion_floating_point_integer;
+}
+
+void SchedulingLatencyVisitorX86::VisitVecMul(HVecMul* instr) {
+  last_visited_latency_ = Primitive::IsFloatingPointType(instr->GetPackedType())
+      ? latencies_.simd_mul_floating_point
+      : latencies_.simd_mul_integer;
+}
+
+void SchedulingLatencyVisitorX86::VisitVecDiv(HVecDiv* instr) {
+  if (instr->GetPackedType() == Primitive::kPrimFloat) {
+    last_visited_latency_ = latencies_.simd_div_float;
+  } else {
+    DCHECK(instr->GetPackedType() == Primitive::kPrimDouble);
+    last_visited_latency_ = latencies_.simd_div_double;
+  }
+}
+
+void SchedulingLatencyVisitorX86::VisitVecLoad(HVecLoad* instr) {
+  if (instr->IsStringCharAt() && mirror::kUseStringCompression) {
+    // Take the test of the compression flag into account.
+    last_visited_internal_latency_ = latencies_.memory_load + kX86BranchLatency;
+  }
+  last_visited_latency_ = latencies_.simd_memory_load;
+}
+
+void SchedulingLatencyVisitorX86::VisitVecStore(HVecStore* ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_.simd_memory_store;
+}
+
+void SchedulingLatencyVisitorX86::VisitX86LoadFromConstantTable(
+    HX86LoadFromConstantTable* ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_.memory_load;
+}
+
+void SchedulingLatencyVisitorX86::VisitX86FPNeg(HX86FPNeg* ATTRIBUTE_UNUSED) {
+  // A load of the sign mask, then an xor.
+  last_visited_internal_latency_ = latencies_.memory_load;
+  last_visited_latency_ = latencies_.simd_integer_op;
+}
+
+void SchedulingLatencyVisitorX86::VisitX86ArrayAlignmentPeeling(
+    HX86ArrayAlignmentPeeling* ATTRIBUTE_UNUSED) {
+  // lea, neg, and, shr.
+  last_visited_internal_latency_ = 3 * latencies_.integer_op;
+  last_visited_latency_ = latencies_.integer_op;
+}
+
+void SchedulingLatencyVisitorX86::VisitX86Prefetch(HX86Prefetch* instruction) {
+  // Nothing waits for a prefetch to complete, only the load of the element of an indirect
+  // prefetch takes time.
+  if (instruction->IsIndirect()) {
+    last_visited_internal_latency_ = latencies_.memory_load;
+  }
+  last_visited_latency_ = latencies_.integer_op;
+}
+
+void SchedulingLatencyVisitorX86::VisitX86IsGcMarking(HX86IsGcMarking* ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_.memory_load;
+}
+
+void SchedulingLatencyVisitorX86::VisitX86IncrementCounter(
+    HX86IncrementCounter* ATTRIBUTE_UNUSED) {
+  // A read-modify-write of memory, nothing reads the counter back.
+  last_visited_internal_latency_ = latencies_.memory_load;
+  last_visited_latency_ = latencies_.memory_store;
+}
+
+}  // namespace x86
+}  // namespace art
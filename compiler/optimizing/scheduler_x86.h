@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_SCHEDULER_X86_H_
+#define ART_COMPILER_OPTIMIZING_SCHEDULER_X86_H_
+
+#include "scheduler.h"
+
+namespace art {
+
+class X86InstructionSetFeatures;
+
+namespace x86 {
+
+// Latencies shared by all x86 and x86-64 CPUs.
+static constexpr uint32_t kX86BranchLatency = 1;
+static constexpr uint32_t kX86CallLatency = 5;
+static constexpr uint32_t kX86CallInternalLatency = 10;
+static constexpr uint32_t kX86LoadStringInternalLatency = 7;
+
+// The x86 microarchitectures with their own latency table. They are told apart by the
+// instruction set features: the in-order Atom cores (Bonnell, Saltwell) have SSSE3 but
+// not SSE4.1, the out-of-order Atom cores (Silvermont, Goldmont) lack AVX, and the big
+// cores have it. The big cores are also assumed when no feature is known.
+enum class X86Microarchitecture {
+  kBonnell,
+  kSilvermont,
+  kCore,
+};
+
+// Instruction latencies, in cycles, of an x86 microarchitecture.
+struct X86Latencies {
+  uint32_t integer_op;
+  uint32_t mul_integer;
+  uint32_t div_integer;
+  uint32_t floating_point_op;
+  uint32_t mul_floating_point;
+  uint32_t div_float;
+  uint32_t div_double;
+  uint32_t type_conversion_floating_point_integer;
+  uint32_t memory_load;
+  uint32_t memory_store;
+  uint32_t simd_integer_op;
+  uint32_t simd_mul_integer;
+  uint32_t simd_floating_point_op;
+  uint32_t simd_mul_floating_point;
+  uint32_t simd_div_float;
+  uint32_t simd_div_double;
+  uint32_t simd_memory_load;
+  uint32_t simd_memory_store;
+};
+
+class SchedulingLatencyVisitorX86 : public SchedulingLatencyVisitor {
+ public:
+  // The latencies are the ones of the CPU targeted by the code generator,
+  // or of the big cores when there is none.
+  explicit SchedulingLatencyVisitorX86(CodeGenerator* codegen);
+
+  static X86Microarchitecture GetMicroarchitecture(const X86InstructionSetFeatures& features);
+
+  static const X86Latencies& GetLatencies(X86Microarchitecture microarchitecture);
+
+  // Default visitor for instructions not handled specifically below.
+  void VisitInstruction(HInstruction* ATTRIBUTE_UNUSED) {
+    last_visited_latency_ = latencies_.integer_op;
+  }
+
+// We add a second unused parameter to be able to use this macro like the others
+// defined in `nodes.h`.
+#define FOR_EACH_SCHEDULED_X86_INSTRUCTION(M)    \
+  M(ArrayGet                , unused)            \
+  M(ArrayLength             , unused)            \
+  M(ArraySet                , unused)            \
+  M(BinaryOperation         , unused)            \
+  M(BoundsCheck             , unused)            \
+  M(Div                     , unused)            \
+  M(InstanceFieldGet        , unused)            \
+  M(InstanceOf              , unused)            \
+  M(Invoke                  , unused)            \
+  M(LoadString              , unused)            \
+  M(Mul                     , unused)            \
+  M(NewArray                , unused)            \
+  M(NewInstance             , unused)            \
+  M(Rem                     , unused)            \
+  M(StaticFieldGet          , unused)            \
+  M(SuspendCheck            , unused)            \
+  M(TypeConversion          , unused)            \
+  M(VecOperation            , unused)            \
+  M(VecReplicateScalar      , unused)            \
+  M(VecReduce               , unused)            \
+  M(VecMul                  , unused)            \
+  M(VecDiv                  , unused)            \
+  M(VecLoad                 , unused)            \
+  M(VecStore                , unused)            \
+  M(X86LoadFromConstantTable, unused)            \
+  M(X86FPNeg                , unused)            \
+  M(X86ArrayAlignmentPeeling, unused)            \
+  M(X86Prefetch             , unused)            \
+  M(X86IsGcMarking          , unused)            \
+  M(X86IncrementCounter     , unused)
+
+#define DECLARE_VISIT_INSTRUCTION(type, unused)  \
+  void Visit##type(H##type* instruction) OVERRIDE;
+
+  FOR_EACH_SCHEDULED_X86_INSTRUCTION(DECLARE_VISIT_INSTRUCTION)
+
+#undef DECLARE_VISIT_INSTRUCTION
+
+ private:
+  const X86Latencies& latencies_;
+  // The 64-bit multiplications and divisions are longer on x86.
+  const bool is_x86_64_;
+};
+
+// The vector and x86 instructions scheduled on top of the ones of HScheduler.
+#define FOR_EACH_SCHEDULABLE_X86_INSTRUCTION(M)  \
+  M(VecReplicateScalar      , unused)            \
+  M(VecReduce               , unused)            \
+  M(VecCnv                  , unused)            \
+  M(VecNeg                  , unused)            \
+  M(VecAbs                  , unused)            \
+  M(VecNot                  , unused)            \
+  M(VecAdd                  , unused)            \
+  M(VecHalvingAdd           , unused)            \
+  M(VecSub                  , unused)            \
+  M(VecMul                  , unused)            \
+  M(VecDiv                  , unused)            \
+  M(VecMin                  , unused)            \
+  M(VecMax                  , unused)            \
+  M(VecAnd                  , unused)            \
+  M(VecAndNot               , unused)            \
+  M(VecOr                   , unused)            \
+  M(VecXor                  , unused)            \
+  M(VecShl                  , unused)            \
+  M(VecShr                  , unused)            \
+  M(VecUShr                 , unused)            \
+  M(VecSetScalars           , unused)            \
+  M(VecLoad                 , unused)            \
+  M(VecStore                , unused)            \
+  M(X86LoadFromConstantTable, unused)            \
+  M(X86FPNeg                , unused)            \
+  M(X86ArrayAlignmentPeeling, unused)            \
+  M(X86Prefetch             , unused)            \
+  M(X86IsGcMarking          , unused)            \
+  M(X86IncrementCounter     , unused)
+
+class HSchedulerX86 : public HScheduler {
+ public:
+  HSchedulerX86(ArenaAllocator* arena,
+                SchedulingNodeSelector* selector,
+                SchedulingLatencyVisitorX86* x86_latency_visitor)
+      : HScheduler(arena, x86_latency_visitor, selector) {}
+  ~HSchedulerX86() OVERRIDE {}
+
+  bool IsSchedulable(const HInstruction* instruction) const OVERRIDE {
+#define CASE_INSTRUCTION_KIND(type, unused) case \
+  HInstruction::InstructionKind::k##type:
+    switch (instruction->GetKind()) {
+      FOR_EACH_SCHEDULABLE_X86_INSTRUCTION(CASE_INSTRUCTION_KIND)
+        return true;
+      default:
+        return HScheduler::IsSchedulable(instruction);
+    }
+#undef CASE_INSTRUCTION_KIND
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HSchedulerX86);
+};
+
+}  // namespace x86
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_SCHEDULER_X86_H_
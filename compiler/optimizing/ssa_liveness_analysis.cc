@@ -256,22 +256,40 @@ void SsaLivenessAnalysis::ComputeLiveRanges() {
 }
 
 void SsaLivenessAnalysis::ComputeLiveInAndLiveOutSets() {
-  bool changed;
-  do {
-    changed = false;
-
-    for (const HBasicBlock* block : graph_->GetPostOrder()) {
-      // The live_in set depends on the kill set (which does not
-      // change in this loop), and the live_out set.  If the live_out
-      // set does not change, there is no need to update the live_in set.
-      if (UpdateLiveOut(*block) && UpdateLiveIn(*block)) {
-        if (kIsDebugBuild) {
-          CheckNoLiveInIrreducibleLoop(*block);
+  // Every block is visited once, in post order. After that, a block is only visited
+  // again when the live_in set of one of its successors changed, instead of visiting
+  // all blocks until none changes.
+  ArenaAllocator* allocator = graph_->GetArena();
+  ArenaVector<HBasicBlock*> worklist(allocator->Adapter(kArenaAllocSsaLiveness));
+  ArenaBitVector in_worklist(
+      allocator, graph_->GetBlocks().size(), /* expandable */ false, kArenaAllocSsaLiveness);
+  worklist.reserve(graph_->GetBlocks().size());
+  for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+    // Pushed in reverse post order, to be popped in post order.
+    worklist.push_back(block);
+    in_worklist.SetBit(block->GetBlockId());
+  }
+
+  while (!worklist.empty()) {
+    HBasicBlock* block = worklist.back();
+    worklist.pop_back();
+    in_worklist.ClearBit(block->GetBlockId());
+
+    // The live_in set depends on the kill set (which does not
+    // change in this loop), and the live_out set.  If the live_out
+    // set does not change, there is no need to update the live_in set.
+    if (UpdateLiveOut(*block) && UpdateLiveIn(*block)) {
+      if (kIsDebugBuild) {
+        CheckNoLiveInIrreducibleLoop(*block);
+      }
+      for (HBasicBlock* predecessor : block->GetPredecessors()) {
+        if (!in_worklist.IsBitSet(predecessor->GetBlockId())) {
+          worklist.push_back(predecessor);
+          in_worklist.SetBit(predecessor->GetBlockId());
         }
-        changed = true;
       }
     }
-  } while (changed);
+  }
 }
 
 bool SsaLivenessAnalysis::UpdateLiveOut(const HBasicBlock& block) {
@@ -478,7 +496,12 @@ size_t LiveInterval::NumberOfSpillSlotsNeeded() const {
   // For a SIMD operation, compute the number of needed spill slots.
   // TODO: do through vector type?
   HInstruction* definition = GetParent()->GetDefinedBy();
-  if (definition != nullptr && definition->IsVecOperation()) {
+  if (definition != nullptr && definition->IsPhi() && definition->InputCount() == 2 &&
+      definition->InputAt(1)->IsVecOperation()) {
+    // A vector reduction phi is as wide as its update.
+    definition = definition->InputAt(1);
+  }
+  if (definition != nullptr && definition->IsVecOperation() && !definition->IsVecReduce()) {
     return definition->AsVecOperation()->GetVectorNumberOfBytes() / kVRegSize;
   }
   // Return number of needed spill slots based on type.
@@ -510,6 +533,7 @@ Location LiveInterval::ToLocation() const {
         case 1: return Location::StackSlot(GetParent()->GetSpillSlot());
         case 2: return Location::DoubleStackSlot(GetParent()->GetSpillSlot());
         case 4: return Location::SIMDStackSlot(GetParent()->GetSpillSlot());
+        case 8: return Location::SIMDStackSlot(GetParent()->GetSpillSlot());
         default: LOG(FATAL) << "Unexpected number of spill slots"; UNREACHABLE();
       }
     } else {
@@ -164,6 +164,7 @@ size_t StackMapStream::PrepareForFillIn() {
   encoding.register_mask.encoding.num_bits = MinimumBitsToStore(register_mask_max_);
   encoding.register_mask.num_entries = PrepareRegisterMasks();
   encoding.stack_map.num_entries = stack_maps_.size();
+  encoding.number_of_sorted_stack_maps = ComputeNumberOfSortedStackMaps();
   encoding.stack_map.encoding.SetFromSizes(
       // The stack map contains compressed native PC offsets.
       max_native_pc_offset.CompressedValue(),
@@ -182,6 +183,21 @@ size_t StackMapStream::PrepareForFillIn() {
   return needed_size_;
 }
 
+size_t StackMapStream::ComputeNumberOfSortedStackMaps() const {
+  // The safepoint stack maps are recorded in code order, the catch stack maps
+  // recorded after them are in block order.
+  size_t count = 0;
+  for (const StackMapEntry& entry : stack_maps_) {
+    if (count != 0 &&
+        entry.native_pc_code_offset.CompressedValue() <
+            stack_maps_[count - 1].native_pc_code_offset.CompressedValue()) {
+      break;
+    }
+    ++count;
+  }
+  return count;
+}
+
 size_t StackMapStream::ComputeDexRegisterLocationCatalogSize() const {
   size_t size = DexRegisterLocationCatalog::kFixedSize;
   for (const DexRegisterLocation& dex_register_location : location_catalog_entries_) {
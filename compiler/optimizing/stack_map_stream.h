@@ -181,6 +181,9 @@ class StackMapStream : public ValueObject {
 
   CodeOffset ComputeMaxNativePcCodeOffset() const;
 
+  // Returns the number of stack maps at the start of `stack_maps_` sorted by native PC.
+  size_t ComputeNumberOfSortedStackMaps() const;
+
   // Returns the number of unique stack masks.
   size_t PrepareStackMasks(size_t entry_size_in_bits);
 
@@ -1011,4 +1011,45 @@ TEST(StackMapTest, TestInvokeInfo) {
   EXPECT_EQ(invoke3.GetNativePcOffset(encoding.invoke_info.encoding, kRuntimeISA), 16u);
 }
 
+TEST(StackMapTest, TestNativePcOffsetLookup) {
+  ArenaPool pool;
+  ArenaAllocator arena(&pool);
+  StackMapStream stream(&arena, kRuntimeISA);
+
+  ArenaBitVector sp_mask(&arena, 0, false);
+  // Safepoint stack maps, in code order. The stack maps at 8 mark an OSR entry.
+  const uint32_t safepoint_native_pcs[] = { 4, 8, 8, 16, 24, 32 };
+  for (size_t i = 0; i < arraysize(safepoint_native_pcs); ++i) {
+    stream.BeginStackMapEntry(i, safepoint_native_pcs[i], 0x3, &sp_mask, 0, 0);
+    stream.EndStackMapEntry();
+  }
+  // Catch stack maps, in block order.
+  stream.BeginStackMapEntry(10, 20, 0, &sp_mask, 0, 0);
+  stream.EndStackMapEntry();
+  stream.BeginStackMapEntry(11, 12, 0, &sp_mask, 0, 0);
+  stream.EndStackMapEntry();
+
+  size_t size = stream.PrepareForFillIn();
+  void* memory = arena.Alloc(size, kArenaAllocMisc);
+  MemoryRegion region(memory, size);
+  stream.FillInCodeInfo(region);
+
+  CodeInfo code_info(region);
+  CodeInfoEncoding encoding = code_info.ExtractEncoding();
+  ASSERT_EQ(8u, code_info.GetNumberOfStackMaps(encoding));
+  ASSERT_EQ(6u, encoding.number_of_sorted_stack_maps);
+  const StackMapEncoding& stack_map_encoding = encoding.stack_map.encoding;
+
+  EXPECT_EQ(0u, code_info.GetStackMapForNativePcOffset(4, encoding).GetDexPc(stack_map_encoding));
+  // The first of the OSR stack maps is found.
+  EXPECT_EQ(1u, code_info.GetStackMapForNativePcOffset(8, encoding).GetDexPc(stack_map_encoding));
+  EXPECT_EQ(3u, code_info.GetStackMapForNativePcOffset(16, encoding).GetDexPc(stack_map_encoding));
+  EXPECT_EQ(5u, code_info.GetStackMapForNativePcOffset(32, encoding).GetDexPc(stack_map_encoding));
+  EXPECT_EQ(11u, code_info.GetStackMapForNativePcOffset(12, encoding).GetDexPc(stack_map_encoding));
+  EXPECT_EQ(10u, code_info.GetStackMapForNativePcOffset(20, encoding).GetDexPc(stack_map_encoding));
+  EXPECT_FALSE(code_info.GetStackMapForNativePcOffset(0, encoding).IsValid());
+  EXPECT_FALSE(code_info.GetStackMapForNativePcOffset(28, encoding).IsValid());
+  EXPECT_FALSE(code_info.GetStackMapForNativePcOffset(36, encoding).IsValid());
+}
+
 }  // namespace art
@@ -65,6 +65,12 @@ class MemoryOperandVisitor : public HGraphVisitor {
       return;
     }
 
+    // Is the result stored back to the memory it reads? Leave it to the store.
+    if (bin_op->HasOnlyOneNonEnvironmentUse() &&
+        GetReadModifyWriteLoad(bin_op->GetUses().front().GetUser()) != nullptr) {
+      return;
+    }
+
     // Can we convert to a HInstructionRHSMemory variant?
     HInstruction* rhs = bin_op->GetRight();
     HInstruction* lhs = bin_op->GetLeft();
@@ -79,7 +85,7 @@ class MemoryOperandVisitor : public HGraphVisitor {
     }
   }
 
-  bool IsSafeToReplaceWithMemOp(HInstruction* rhs, HBinaryOperation* bin_op) {
+  bool IsSafeToReplaceWithMemOp(HInstruction* rhs, HInstruction* bin_op) {
     // There is a case when we can't convert an op to mem variant.
     // Let's say we have the following instructions:
     // a = ArrayGet b, c
@@ -312,6 +318,181 @@ class MemoryOperandVisitor : public HGraphVisitor {
     return result;
   }
 
+  void VisitArraySet(HArraySet* store) OVERRIDE {
+    TryReadModifyWrite(store);
+  }
+
+  void VisitInstanceFieldSet(HInstanceFieldSet* store) OVERRIDE {
+    TryReadModifyWrite(store);
+  }
+
+  void VisitStaticFieldSet(HStaticFieldSet* store) OVERRIDE {
+    TryReadModifyWrite(store);
+  }
+
+  // The other instructions visited are the conditions.
+  void VisitInstruction(HInstruction* instruction) OVERRIDE {
+    if (instruction->IsCondition()) {
+      TryCompareWithMemory(instruction->AsCondition());
+    }
+  }
+
+  static const FieldInfo& GetFieldInfo(HInstruction* instruction) {
+    switch (instruction->GetKind()) {
+      case HInstruction::kInstanceFieldGet:
+        return instruction->AsInstanceFieldGet()->GetFieldInfo();
+      case HInstruction::kStaticFieldGet:
+        return instruction->AsStaticFieldGet()->GetFieldInfo();
+      case HInstruction::kInstanceFieldSet:
+        return instruction->AsInstanceFieldSet()->GetFieldInfo();
+      default:
+        DCHECK(instruction->IsStaticFieldSet());
+        return instruction->AsStaticFieldSet()->GetFieldInfo();
+    }
+  }
+
+  // Does load read the int that store writes?
+  static bool ReadsStoredMemory(HInstruction* load, HInstruction* store) {
+    switch (store->GetKind()) {
+      case HInstruction::kArraySet:
+        if (!load->IsArrayGet() || load->InputAt(1) != store->InputAt(1)) {
+          return false;
+        }
+        break;
+      case HInstruction::kInstanceFieldSet:
+        if (!load->IsInstanceFieldGet()) {
+          return false;
+        }
+        break;
+      case HInstruction::kStaticFieldSet:
+        if (!load->IsStaticFieldGet()) {
+          return false;
+        }
+        break;
+      default:
+        return false;
+    }
+    if (load->GetType() != Primitive::kPrimInt || load->InputAt(0) != store->InputAt(0)) {
+      return false;
+    }
+    return store->IsArraySet() ||
+           GetFieldInfo(load).GetFieldOffset().Uint32Value() ==
+               GetFieldInfo(store).GetFieldOffset().Uint32Value();
+  }
+
+  /**
+   * Returns the load updated by a single operation and stored back by store,
+   * if it can become a HX86ReadModifyWriteMemory, nullptr otherwise.
+   */
+  HInstruction* GetReadModifyWriteLoad(HInstruction* store) {
+    HInstruction* value = nullptr;
+    switch (store->GetKind()) {
+      case HInstruction::kArraySet:
+        if (store->AsArraySet()->GetComponentType() != Primitive::kPrimInt) {
+          return nullptr;
+        }
+        value = store->InputAt(2);
+        break;
+      case HInstruction::kInstanceFieldSet:
+      case HInstruction::kStaticFieldSet:
+        if (GetFieldInfo(store).IsVolatile() ||
+            GetFieldInfo(store).GetFieldType() != Primitive::kPrimInt) {
+          return nullptr;
+        }
+        value = store->InputAt(1);
+        break;
+      default:
+        return nullptr;
+    }
+
+    if ((!value->IsAdd() && !value->IsSub() && !value->IsAnd() &&
+         !value->IsOr() && !value->IsXor()) ||
+        value->GetType() != Primitive::kPrimInt ||
+        value->GetBlock() != store->GetBlock() ||
+        !value->HasOnlyOneNonEnvironmentUse() ||
+        value->HasEnvironmentUses()) {
+      return nullptr;
+    }
+
+    // memory = memory op x, or x op memory if op commutes. The load and the operation are
+    // removed, so no deoptimization or debugger may need their values.
+    HBinaryOperation* op = value->AsBinaryOperation();
+    HInstruction* load = op->GetLeft();
+    if (!ReadsStoredMemory(load, store) && op->IsCommutative()) {
+      load = op->GetRight();
+    }
+    if (!ReadsStoredMemory(load, store) ||
+        !load->HasOnlyOneNonEnvironmentUse() ||
+        load->HasEnvironmentUses() ||
+        !IsSafeToReplaceWithMemOp(load, store)) {
+      return nullptr;
+    }
+    return load;
+  }
+
+  void TryReadModifyWrite(HInstruction* store) {
+    HInstruction* load = GetReadModifyWriteLoad(store);
+    if (load == nullptr) {
+      return;
+    }
+
+    HBinaryOperation* op = store->InputAt(store->IsArraySet() ? 2 : 1)->AsBinaryOperation();
+    HInstruction* value = (op->GetLeft() == load) ? op->GetRight() : op->GetLeft();
+    HInstruction* base = store->InputAt(0);
+    HInstruction* index = nullptr;
+    uint32_t offset = 0;
+    if (store->IsArraySet()) {
+      index = store->InputAt(1);
+      offset = GetArrayOffset(Primitive::kPrimInt);
+      TryConvertConstantIndexToOffset(Primitive::kPrimInt, index, offset);
+    } else {
+      offset = GetFieldInfo(store).GetFieldOffset().Uint32Value();
+    }
+
+    HX86ReadModifyWriteMemory* new_insn = new (GetGraph()->GetArena())
+        HX86ReadModifyWriteMemory(op->GetKind(),
+                                  value,
+                                  base,
+                                  index,
+                                  offset,
+                                  store->IsArraySet(),
+                                  GetGraph()->GetArena(),
+                                  store->GetDexPc());
+    if (store->IsStaticFieldSet()) {
+      new_insn->SetFromStatic();
+    }
+    store->GetBlock()->ReplaceAndRemoveInstructionWith(store, new_insn);
+    op->GetBlock()->RemoveInstruction(op);
+    load->GetBlock()->RemoveInstruction(load);
+  }
+
+  void TryCompareWithMemory(HCondition* condition) {
+    // The load must be right before the condition: nothing writes the memory in
+    // between, and the compare can do the implicit null check of the load.
+    // The load gets no location of its own, the environments cannot refer to it.
+    HInstruction* load = condition->InputAt(1);
+    if (load->GetType() != Primitive::kPrimInt ||
+        load->GetNext() != condition ||
+        !load->HasOnlyOneNonEnvironmentUse() ||
+        load->HasEnvironmentUses()) {
+      return;
+    }
+    switch (load->GetKind()) {
+      case HInstruction::kInstanceFieldGet:
+      case HInstruction::kStaticFieldGet:
+        if (GetFieldInfo(load).IsVolatile()) {
+          return;
+        }
+        break;
+      case HInstruction::kArrayGet:
+        break;
+      default:
+        return;
+    }
+    // The code generators emit the load as the memory operand of the compare.
+    load->MarkEmittedAtUseSite();
+  }
+
   void VisitBoundsCheck(HBoundsCheck* check) OVERRIDE {
     // Replace the length by the array itself, so that we can do compares to memory.
     HArrayLength* array_len = check->InputAt(1)->AsArrayLength();
@@ -1610,6 +1610,509 @@ void X86Assembler::psrldq(XmmRegister reg, const Immediate& shift_count) {
 }
 
 
+void X86Assembler::vzeroupper() {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexPrefix(kVexMap0F, kVexPrefixNone, /* is_256 */ false, 0);
+  EmitUint8(0x77);
+}
+
+
+void X86Assembler::vmovd(XmmRegister dst, Register src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexPrefix(kVexMap0F, kVexPrefix66, /* is_256 */ false, 0);
+  EmitUint8(0x6E);
+  EmitOperand(dst, Operand(src));
+}
+
+
+void X86Assembler::vmovaps(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x28, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86Assembler::vcvtdq2ps(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x5B, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86Assembler::vpabsd(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x1E, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86Assembler::vextracti128(XmmRegister dst, XmmRegister src, const Immediate& imm) {
+  DCHECK(imm.is_uint8());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  // The source goes in ModRM.reg and the destination in ModRM.rm.
+  EmitVexRegisterOp(kVexMap0F3A, kVexPrefix66, 0x39, src, XmmRegister(XMM0), dst);
+  EmitUint8(imm.value());
+}
+
+
+void X86Assembler::vpbroadcastb(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x78, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86Assembler::vpbroadcastw(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x79, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86Assembler::vpbroadcastd(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x58, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86Assembler::vpbroadcastq(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x59, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86Assembler::vbroadcastss(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x18, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86Assembler::vbroadcastsd(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x19, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86Assembler::vmovdqa(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefix66, 0x6F, dst, src);
+}
+
+
+void X86Assembler::vmovdqu(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefixF3, 0x6F, dst, src);
+}
+
+
+void X86Assembler::vmovaps(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefixNone, 0x28, dst, src);
+}
+
+
+void X86Assembler::vmovups(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefixNone, 0x10, dst, src);
+}
+
+
+void X86Assembler::vmovapd(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefix66, 0x28, dst, src);
+}
+
+
+void X86Assembler::vmovupd(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefix66, 0x10, dst, src);
+}
+
+
+void X86Assembler::vpmovzxbw(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F38, kVexPrefix66, 0x30, dst, src);
+}
+
+
+void X86Assembler::vmovdqa(const Address& dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefix66, 0x7F, src, dst);
+}
+
+
+void X86Assembler::vmovdqu(const Address& dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefixF3, 0x7F, src, dst);
+}
+
+
+void X86Assembler::vmovaps(const Address& dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefixNone, 0x29, src, dst);
+}
+
+
+void X86Assembler::vmovups(const Address& dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefixNone, 0x11, src, dst);
+}
+
+
+void X86Assembler::vmovapd(const Address& dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefix66, 0x29, src, dst);
+}
+
+
+void X86Assembler::vmovupd(const Address& dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefix66, 0x11, src, dst);
+}
+
+
+void X86Assembler::vpaddb(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xFC, dst, src1, src2);
+}
+
+
+void X86Assembler::vpaddw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xFD, dst, src1, src2);
+}
+
+
+void X86Assembler::vpaddd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xFE, dst, src1, src2);
+}
+
+
+void X86Assembler::vpaddq(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xD4, dst, src1, src2);
+}
+
+
+void X86Assembler::vpsubb(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xF8, dst, src1, src2);
+}
+
+
+void X86Assembler::vpsubw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xF9, dst, src1, src2);
+}
+
+
+void X86Assembler::vpsubd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xFA, dst, src1, src2);
+}
+
+
+void X86Assembler::vpsubq(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xFB, dst, src1, src2);
+}
+
+
+void X86Assembler::vpmullw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xD5, dst, src1, src2);
+}
+
+
+void X86Assembler::vpmulld(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x40, dst, src1, src2);
+}
+
+
+void X86Assembler::vaddps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x58, dst, src1, src2);
+}
+
+
+void X86Assembler::vaddpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x58, dst, src1, src2);
+}
+
+
+void X86Assembler::vsubps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x5C, dst, src1, src2);
+}
+
+
+void X86Assembler::vsubpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x5C, dst, src1, src2);
+}
+
+
+void X86Assembler::vmulps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x59, dst, src1, src2);
+}
+
+
+void X86Assembler::vmulpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x59, dst, src1, src2);
+}
+
+
+void X86Assembler::vdivps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x5E, dst, src1, src2);
+}
+
+
+void X86Assembler::vdivpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x5E, dst, src1, src2);
+}
+
+
+void X86Assembler::vpand(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xDB, dst, src1, src2);
+}
+
+
+void X86Assembler::vpandn(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xDF, dst, src1, src2);
+}
+
+
+void X86Assembler::vpor(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xEB, dst, src1, src2);
+}
+
+
+void X86Assembler::vpxor(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xEF, dst, src1, src2);
+}
+
+
+void X86Assembler::vandps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x54, dst, src1, src2);
+}
+
+
+void X86Assembler::vandpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x54, dst, src1, src2);
+}
+
+
+void X86Assembler::vandnps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x55, dst, src1, src2);
+}
+
+
+void X86Assembler::vandnpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x55, dst, src1, src2);
+}
+
+
+void X86Assembler::vorps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x56, dst, src1, src2);
+}
+
+
+void X86Assembler::vorpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x56, dst, src1, src2);
+}
+
+
+void X86Assembler::vxorps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x57, dst, src1, src2);
+}
+
+
+void X86Assembler::vxorpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x57, dst, src1, src2);
+}
+
+
+void X86Assembler::vpavgb(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xE0, dst, src1, src2);
+}
+
+
+void X86Assembler::vpavgw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xE3, dst, src1, src2);
+}
+
+
+void X86Assembler::vpminsb(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x38, dst, src1, src2);
+}
+
+
+void X86Assembler::vpmaxsb(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x3C, dst, src1, src2);
+}
+
+
+void X86Assembler::vpminsw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xEA, dst, src1, src2);
+}
+
+
+void X86Assembler::vpmaxsw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xEE, dst, src1, src2);
+}
+
+
+void X86Assembler::vpminsd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x39, dst, src1, src2);
+}
+
+
+void X86Assembler::vpmaxsd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x3D, dst, src1, src2);
+}
+
+
+void X86Assembler::vpminub(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xDA, dst, src1, src2);
+}
+
+
+void X86Assembler::vpmaxub(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xDE, dst, src1, src2);
+}
+
+
+void X86Assembler::vpminuw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x3A, dst, src1, src2);
+}
+
+
+void X86Assembler::vpmaxuw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x3E, dst, src1, src2);
+}
+
+
+void X86Assembler::vpminud(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x3B, dst, src1, src2);
+}
+
+
+void X86Assembler::vpmaxud(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x3F, dst, src1, src2);
+}
+
+
+void X86Assembler::vminps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x5D, dst, src1, src2);
+}
+
+
+void X86Assembler::vmaxps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x5F, dst, src1, src2);
+}
+
+
+void X86Assembler::vminpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x5D, dst, src1, src2);
+}
+
+
+void X86Assembler::vmaxpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x5F, dst, src1, src2);
+}
+
+
+void X86Assembler::vpcmpeqb(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x74, dst, src1, src2);
+}
+
+
+void X86Assembler::vpcmpgtd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x66, dst, src1, src2);
+}
+
+
+void X86Assembler::vpsllw(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexShift(0x71, 6, dst, src, shift_count);
+}
+
+
+void X86Assembler::vpslld(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexShift(0x72, 6, dst, src, shift_count);
+}
+
+
+void X86Assembler::vpsllq(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexShift(0x73, 6, dst, src, shift_count);
+}
+
+
+void X86Assembler::vpsraw(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexShift(0x71, 4, dst, src, shift_count);
+}
+
+
+void X86Assembler::vpsrad(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexShift(0x72, 4, dst, src, shift_count);
+}
+
+
+void X86Assembler::vpsrlw(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexShift(0x71, 2, dst, src, shift_count);
+}
+
+
+void X86Assembler::vpsrld(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexShift(0x72, 2, dst, src, shift_count);
+}
+
+
+void X86Assembler::vpsrlq(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexShift(0x73, 2, dst, src, shift_count);
+}
+
 void X86Assembler::fldl(const Address& src) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitUint8(0xDD);
@@ -1883,6 +2386,19 @@ void X86Assembler::andl(Register dst, const Immediate& imm) {
 }
 
 
+void X86Assembler::andl(const Address& address, Register reg) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x21);
+  EmitOperand(reg, address);
+}
+
+
+void X86Assembler::andl(const Address& address, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitComplex(4, address, imm);
+}
+
+
 void X86Assembler::orl(Register dst, Register src) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitUint8(0x0B);
@@ -1903,6 +2419,19 @@ void X86Assembler::orl(Register dst, const Immediate& imm) {
 }
 
 
+void X86Assembler::orl(const Address& address, Register reg) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x09);
+  EmitOperand(reg, address);
+}
+
+
+void X86Assembler::orl(const Address& address, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitComplex(1, address, imm);
+}
+
+
 void X86Assembler::xorl(Register dst, Register src) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitUint8(0x33);
@@ -1923,6 +2452,19 @@ void X86Assembler::xorl(Register dst, const Immediate& imm) {
 }
 
 
+void X86Assembler::xorl(const Address& address, Register reg) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x31);
+  EmitOperand(reg, address);
+}
+
+
+void X86Assembler::xorl(const Address& address, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitComplex(6, address, imm);
+}
+
+
 void X86Assembler::addl(Register reg, const Immediate& imm) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitComplex(0, Operand(reg), imm);
@@ -1962,6 +2504,12 @@ void X86Assembler::adcl(Register dst, const Address& address) {
 }
 
 
+void X86Assembler::adcl(const Address& address, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitComplex(2, address, imm);
+}
+
+
 void X86Assembler::subl(Register dst, Register src) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitUint8(0x2B);
@@ -1989,6 +2537,12 @@ void X86Assembler::subl(const Address& address, Register reg) {
 }
 
 
+void X86Assembler::subl(const Address& address, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitComplex(5, address, imm);
+}
+
+
 void X86Assembler::cdq() {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitUint8(0x99);
@@ -2488,6 +3042,20 @@ void X86Assembler::mfence() {
   EmitUint8(0xF0);
 }
 
+void X86Assembler::prefetcht0(const Address& address) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x0F);
+  EmitUint8(0x18);
+  EmitOperand(1, address);
+}
+
+void X86Assembler::prefetchnta(const Address& address) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x0F);
+  EmitUint8(0x18);
+  EmitOperand(0, address);
+}
+
 X86Assembler* X86Assembler::fs() {
   // TODO: fs is a prefix and not an instruction
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
@@ -2574,6 +3142,51 @@ void X86Assembler::Bind(NearLabel* label) {
 }
 
 
+void X86Assembler::EmitVexPrefix(VexOpcodeMap map, VexSimdPrefix pp, bool is_256, int vvvv) {
+  // The register fields are stored inverted. R, X and B extend the registers of
+  // 64-bit mode and are left as ones here.
+  uint8_t l_pp = (is_256 ? 0x04 : 0x00) | pp;
+  uint8_t inverted_vvvv = (~vvvv & 0x0F) << 3;
+  if (map == kVexMap0F) {
+    // Two byte form: R vvvv L pp.
+    EmitUint8(0xC5);
+    EmitUint8(0x80 | inverted_vvvv | l_pp);
+  } else {
+    // Three byte form: R X B mmmmm, then W vvvv L pp.
+    EmitUint8(0xC4);
+    EmitUint8(0xE0 | map);
+    EmitUint8(inverted_vvvv | l_pp);
+  }
+}
+
+
+void X86Assembler::EmitVexRegisterOp(VexOpcodeMap map, VexSimdPrefix pp, uint8_t opcode,
+                                     XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  EmitVexPrefix(map, pp, /* is_256 */ true, src1);
+  EmitUint8(opcode);
+  EmitXmmRegisterOperand(dst, src2);
+}
+
+
+void X86Assembler::EmitVexMemoryOp(VexOpcodeMap map, VexSimdPrefix pp, uint8_t opcode,
+                                   XmmRegister reg, const Operand& operand) {
+  EmitVexPrefix(map, pp, /* is_256 */ true, 0);
+  EmitUint8(opcode);
+  EmitOperand(reg, operand);
+}
+
+
+void X86Assembler::EmitVexShift(uint8_t opcode, int rm, XmmRegister dst, XmmRegister src,
+                                const Immediate& shift_count) {
+  DCHECK(shift_count.is_uint8());
+  // The destination goes in vvvv, ModRM.reg extends the opcode.
+  EmitVexPrefix(kVexMap0F, kVexPrefix66, /* is_256 */ true, dst);
+  EmitUint8(opcode);
+  EmitXmmRegisterOperand(rm, src);
+  EmitUint8(shift_count.value());
+}
+
+
 void X86Assembler::EmitOperand(int reg_or_opcode, const Operand& operand) {
   CHECK_GE(reg_or_opcode, 0);
   CHECK_LT(reg_or_opcode, 8);
@@ -549,6 +549,115 @@ class X86Assembler FINAL : public Assembler {
   void psrlq(XmmRegister reg, const Immediate& shift_count);
   void psrldq(XmmRegister reg, const Immediate& shift_count);
 
+  //
+  // AVX2 instructions on 256-bit vectors. Each one uses the full YMM register extending
+  // the XmmRegister named. The three operand forms compute dst = src1 op src2.
+  //
+
+  void vzeroupper();
+  void vmovd(XmmRegister dst, Register src);  // 128-bit, clears the upper lanes
+
+  void vmovaps(XmmRegister dst, XmmRegister src);     // move
+  void vmovaps(XmmRegister dst, const Address& src);  // load aligned
+  void vmovups(XmmRegister dst, const Address& src);  // load unaligned
+  void vmovaps(const Address& dst, XmmRegister src);  // store aligned
+  void vmovups(const Address& dst, XmmRegister src);  // store unaligned
+
+  void vmovapd(XmmRegister dst, const Address& src);  // load aligned
+  void vmovupd(XmmRegister dst, const Address& src);  // load unaligned
+  void vmovapd(const Address& dst, XmmRegister src);  // store aligned
+  void vmovupd(const Address& dst, XmmRegister src);  // store unaligned
+
+  void vmovdqa(XmmRegister dst, const Address& src);  // load aligned
+  void vmovdqu(XmmRegister dst, const Address& src);  // load unaligned
+  void vmovdqa(const Address& dst, XmmRegister src);  // store aligned
+  void vmovdqu(const Address& dst, XmmRegister src);  // store unaligned
+
+  void vpmovzxbw(XmmRegister dst, const Address& src);  // 16 bytes into 16 words
+
+  void vpbroadcastb(XmmRegister dst, XmmRegister src);
+  void vpbroadcastw(XmmRegister dst, XmmRegister src);
+  void vpbroadcastd(XmmRegister dst, XmmRegister src);
+  void vpbroadcastq(XmmRegister dst, XmmRegister src);
+  void vbroadcastss(XmmRegister dst, XmmRegister src);
+  void vbroadcastsd(XmmRegister dst, XmmRegister src);
+
+  void vcvtdq2ps(XmmRegister dst, XmmRegister src);
+  void vpabsd(XmmRegister dst, XmmRegister src);
+  void vextracti128(XmmRegister dst, XmmRegister src, const Immediate& imm);  // 128-bit lane imm of src
+
+  void vpaddb(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpaddw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpaddd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpaddq(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpsubb(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpsubw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpsubd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpsubq(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpmullw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmulld(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vaddps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vaddpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vsubps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vsubpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vmulps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vmulpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vdivps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vdivpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpand(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpandn(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpor(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpxor(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vandps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vandpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vandnps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vandnpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vorps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vorpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vxorps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vxorpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpavgb(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpavgw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpminsb(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmaxsb(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpminsw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmaxsw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpminsd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmaxsd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpminub(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmaxub(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpminuw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmaxuw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpminud(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmaxud(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vminps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vmaxps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vminpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vmaxpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpcmpeqb(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpcmpgtd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpsllw(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+  void vpslld(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+  void vpsllq(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+
+  void vpsraw(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+  void vpsrad(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+
+  void vpsrlw(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+  void vpsrld(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+  void vpsrlq(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+
   void flds(const Address& src);
   void fstps(const Address& dst);
   void fsts(const Address& dst);
@@ -600,14 +709,20 @@ class X86Assembler FINAL : public Assembler {
   void andl(Register dst, const Immediate& imm);
   void andl(Register dst, Register src);
   void andl(Register dst, const Address& address);
+  void andl(const Address& address, Register reg);
+  void andl(const Address& address, const Immediate& imm);
 
   void orl(Register dst, const Immediate& imm);
   void orl(Register dst, Register src);
   void orl(Register dst, const Address& address);
+  void orl(const Address& address, Register reg);
+  void orl(const Address& address, const Immediate& imm);
 
   void xorl(Register dst, Register src);
   void xorl(Register dst, const Immediate& imm);
   void xorl(Register dst, const Address& address);
+  void xorl(const Address& address, Register reg);
+  void xorl(const Address& address, const Immediate& imm);
 
   void addl(Register dst, Register src);
   void addl(Register reg, const Immediate& imm);
@@ -619,11 +734,13 @@ class X86Assembler FINAL : public Assembler {
   void adcl(Register dst, Register src);
   void adcl(Register reg, const Immediate& imm);
   void adcl(Register dst, const Address& address);
+  void adcl(const Address& address, const Immediate& imm);
 
   void subl(Register dst, Register src);
   void subl(Register reg, const Immediate& imm);
   void subl(Register reg, const Address& address);
   void subl(const Address& address, Register src);
+  void subl(const Address& address, const Immediate& imm);
 
   void cdq();
 
@@ -704,6 +821,9 @@ class X86Assembler FINAL : public Assembler {
 
   void mfence();
 
+  void prefetcht0(const Address& address);
+  void prefetchnta(const Address& address);
+
   X86Assembler* fs();
   X86Assembler* gs();
 
@@ -807,6 +927,18 @@ class X86Assembler FINAL : public Assembler {
   void EmitGenericShift(int rm, const Operand& operand, const Immediate& imm);
   void EmitGenericShift(int rm, const Operand& operand, Register shifter);
 
+  // The opcode maps and implied SIMD prefixes of VEX encoded instructions.
+  enum VexOpcodeMap { kVexMap0F = 1, kVexMap0F38 = 2, kVexMap0F3A = 3 };
+  enum VexSimdPrefix { kVexPrefixNone = 0, kVexPrefix66 = 1, kVexPrefixF3 = 2, kVexPrefixF2 = 3 };
+
+  void EmitVexPrefix(VexOpcodeMap map, VexSimdPrefix pp, bool is_256, int vvvv);
+  void EmitVexRegisterOp(VexOpcodeMap map, VexSimdPrefix pp, uint8_t opcode,
+                         XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void EmitVexMemoryOp(VexOpcodeMap map, VexSimdPrefix pp, uint8_t opcode,
+                       XmmRegister reg, const Operand& operand);
+  void EmitVexShift(uint8_t opcode, int rm, XmmRegister dst, XmmRegister src,
+                    const Immediate& shift_count);
+
   ConstantArea constant_area_;
 
   DISALLOW_COPY_AND_ASSIGN(X86Assembler);
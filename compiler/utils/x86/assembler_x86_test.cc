@@ -122,6 +122,26 @@ TEST_F(AssemblerX86Test, Movntl) {
   DriverStr(expected, "movntl");
 }
 
+TEST_F(AssemblerX86Test, Prefetch) {
+  GetAssembler()->prefetcht0(x86::Address(x86::EDI, x86::EBX, x86::TIMES_4, 512));
+  GetAssembler()->prefetchnta(x86::Address(x86::EDI, 64));
+  const char* expected =
+    "prefetcht0 0x200(%EDI,%EBX,4)\n"
+    "prefetchnta 0x40(%EDI)\n";
+
+  DriverStr(expected, "prefetch");
+}
+
+TEST_F(AssemblerX86Test, AdclAddressImm) {
+  GetAssembler()->adcl(x86::Address(x86::EDI, 4), x86::Immediate(0));
+  GetAssembler()->adcl(x86::Address(x86::EDI, x86::EBX, x86::TIMES_4, 12), x86::Immediate(1000));
+  const char* expected =
+    "adcl $0, 0x4(%EDI)\n"
+    "adcl $1000, 0xc(%EDI,%EBX,4)\n";
+
+  DriverStr(expected, "adcl_address_imm");
+}
+
 TEST_F(AssemblerX86Test, LoadLongConstant) {
   GetAssembler()->LoadLongConstant(x86::XMM0, 51);
   const char* expected =
@@ -419,6 +439,38 @@ TEST_F(AssemblerX86Test, TestlAddressImmediate) {
   DriverStr(expected, "TestlAddressImmediate");
 }
 
+TEST_F(AssemblerX86Test, AluAddressRegister) {
+  x86::Address array_element(x86::Register(x86::EDI), x86::Register(x86::EBX), x86::TIMES_4, 12);
+  x86::Address field(x86::Register(x86::ESI), MemberOffset(130));
+  GetAssembler()->andl(array_element, x86::Register(x86::EAX));
+  GetAssembler()->orl(field, x86::Register(x86::ECX));
+  GetAssembler()->xorl(array_element, x86::Register(x86::EDX));
+  GetAssembler()->subl(field, x86::Register(x86::EBP));
+  const char* expected =
+      "andl %EAX, 0xc(%EDI,%EBX,4)\n"
+      "orl %ECX, 0x82(%ESI)\n"
+      "xorl %EDX, 0xc(%EDI,%EBX,4)\n"
+      "subl %EBP, 0x82(%ESI)\n";
+
+  DriverStr(expected, "AluAddressRegister");
+}
+
+TEST_F(AssemblerX86Test, AluAddressImmediate) {
+  x86::Address array_element(x86::Register(x86::EDI), x86::Register(x86::EBX), x86::TIMES_4, 12);
+  x86::Address field(x86::Register(x86::ESI), MemberOffset(130));
+  GetAssembler()->andl(array_element, x86::Immediate(1));
+  GetAssembler()->orl(field, x86::Immediate(-128));
+  GetAssembler()->xorl(array_element, x86::Immediate(77777777));
+  GetAssembler()->subl(field, x86::Immediate(-100000));
+  const char* expected =
+      "andl $1, 0xc(%EDI,%EBX,4)\n"
+      "orl $-128, 0x82(%ESI)\n"
+      "xorl $77777777, 0xc(%EDI,%EBX,4)\n"
+      "subl $-100000, 0x82(%ESI)\n";
+
+  DriverStr(expected, "AluAddressImmediate");
+}
+
 TEST_F(AssemblerX86Test, Movaps) {
   DriverStr(RepeatFF(&x86::X86Assembler::movaps, "movaps %{reg2}, %{reg1}"), "movaps");
 }
@@ -782,6 +834,92 @@ TEST_F(AssemblerX86Test, psrldq) {
   DriverStr("psrldq $0x10, %xmm0\n", "psrldqi");
 }
 
+TEST_F(AssemblerX86Test, VexArithmetic) {
+  GetAssembler()->vpaddd(x86::XMM0, x86::XMM1, x86::XMM2);
+  GetAssembler()->vpsubw(x86::XMM7, x86::XMM6, x86::XMM5);
+  GetAssembler()->vpmulld(x86::XMM3, x86::XMM4, x86::XMM5);
+  GetAssembler()->vmulps(x86::XMM1, x86::XMM2, x86::XMM3);
+  GetAssembler()->vdivpd(x86::XMM4, x86::XMM5, x86::XMM6);
+  GetAssembler()->vpandn(x86::XMM0, x86::XMM0, x86::XMM7);
+  GetAssembler()->vpminuw(x86::XMM2, x86::XMM3, x86::XMM4);
+  GetAssembler()->vpcmpeqb(x86::XMM5, x86::XMM5, x86::XMM5);
+  const char* expected =
+    "vpaddd %ymm2, %ymm1, %ymm0\n"
+    "vpsubw %ymm5, %ymm6, %ymm7\n"
+    "vpmulld %ymm5, %ymm4, %ymm3\n"
+    "vmulps %ymm3, %ymm2, %ymm1\n"
+    "vdivpd %ymm6, %ymm5, %ymm4\n"
+    "vpandn %ymm7, %ymm0, %ymm0\n"
+    "vpminuw %ymm4, %ymm3, %ymm2\n"
+    "vpcmpeqb %ymm5, %ymm5, %ymm5\n";
+  DriverStr(expected, "vex_arithmetic");
+}
+
+TEST_F(AssemblerX86Test, VexShifts) {
+  GetAssembler()->vpsllw(x86::XMM0, x86::XMM1, CreateImmediate(3));
+  GetAssembler()->vpsrad(x86::XMM2, x86::XMM3, CreateImmediate(16));
+  GetAssembler()->vpsrlq(x86::XMM7, x86::XMM7, CreateImmediate(1));
+  const char* expected =
+    "vpsllw $0x3, %ymm1, %ymm0\n"
+    "vpsrad $0x10, %ymm3, %ymm2\n"
+    "vpsrlq $0x1, %ymm7, %ymm7\n";
+  DriverStr(expected, "vex_shifts");
+}
+
+TEST_F(AssemblerX86Test, VexMoves) {
+  GetAssembler()->vmovaps(x86::XMM0, x86::XMM1);
+  GetAssembler()->vmovups(x86::XMM2, x86::Address(x86::Register(x86::ESP), 4));
+  GetAssembler()->vmovups(x86::Address(x86::Register(x86::ESP), 32), x86::XMM3);
+  GetAssembler()->vmovdqa(x86::XMM4, x86::Address(
+      x86::Register(x86::EAX), x86::Register(x86::EBX), x86::TIMES_4, 12));
+  GetAssembler()->vmovdqu(x86::Address(x86::Register(x86::ECX), 8), x86::XMM5);
+  GetAssembler()->vmovapd(x86::XMM6, x86::Address(x86::Register(x86::EDX), 0));
+  GetAssembler()->vpmovzxbw(x86::XMM7, x86::Address(x86::Register(x86::ESI), 16));
+  GetAssembler()->vmovd(x86::XMM1, x86::EAX);
+  GetAssembler()->vzeroupper();
+  const char* expected =
+    "vmovaps %ymm1, %ymm0\n"
+    "vmovups 0x4(%ESP), %ymm2\n"
+    "vmovups %ymm3, 0x20(%ESP)\n"
+    "vmovdqa 0xc(%EAX,%EBX,4), %ymm4\n"
+    "vmovdqu %ymm5, 0x8(%ECX)\n"
+    "vmovapd (%EDX), %ymm6\n"
+    "vpmovzxbw 0x10(%ESI), %ymm7\n"
+    "vmovd %EAX, %xmm1\n"
+    "vzeroupper\n";
+  DriverStr(expected, "vex_moves");
+}
+
+TEST_F(AssemblerX86Test, VexBroadcasts) {
+  GetAssembler()->vpbroadcastb(x86::XMM0, x86::XMM1);
+  GetAssembler()->vpbroadcastw(x86::XMM2, x86::XMM2);
+  GetAssembler()->vpbroadcastd(x86::XMM3, x86::XMM4);
+  GetAssembler()->vpbroadcastq(x86::XMM5, x86::XMM6);
+  GetAssembler()->vbroadcastss(x86::XMM7, x86::XMM7);
+  GetAssembler()->vbroadcastsd(x86::XMM0, x86::XMM1);
+  GetAssembler()->vcvtdq2ps(x86::XMM2, x86::XMM3);
+  GetAssembler()->vpabsd(x86::XMM4, x86::XMM5);
+  const char* expected =
+    "vpbroadcastb %xmm1, %ymm0\n"
+    "vpbroadcastw %xmm2, %ymm2\n"
+    "vpbroadcastd %xmm4, %ymm3\n"
+    "vpbroadcastq %xmm6, %ymm5\n"
+    "vbroadcastss %xmm7, %ymm7\n"
+    "vbroadcastsd %xmm1, %ymm0\n"
+    "vcvtdq2ps %ymm3, %ymm2\n"
+    "vpabsd %ymm5, %ymm4\n";
+  DriverStr(expected, "vex_broadcasts");
+}
+
+TEST_F(AssemblerX86Test, Vextracti128) {
+  GetAssembler()->vextracti128(x86::XMM6, x86::XMM7, x86::Immediate(1));
+  GetAssembler()->vextracti128(x86::XMM0, x86::XMM3, x86::Immediate(0));
+  const char* expected =
+    "vextracti128 $1, %ymm7, %xmm6\n"
+    "vextracti128 $0, %ymm3, %xmm0\n";
+  DriverStr(expected, "vextracti128");
+}
+
 /////////////////
 // Near labels //
 /////////////////
@@ -1260,6 +1260,18 @@ void X86_64Assembler::roundsd(XmmRegister dst, XmmRegister src, const Immediate&
 }
 
 
+void X86_64Assembler::pcmpestri(XmmRegister dst, const Address& src, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0x3A);
+  EmitUint8(0x61);
+  EmitOperand(dst.LowBits(), src);
+  EmitUint8(imm.value());
+}
+
+
 void X86_64Assembler::roundss(XmmRegister dst, XmmRegister src, const Immediate& imm) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitUint8(0x66);
@@ -1641,202 +1653,765 @@ void X86_64Assembler::pcmpgtb(XmmRegister dst, XmmRegister src) {
   EmitXmmRegisterOperand(dst.LowBits(), src);
 }
 
-void X86_64Assembler::pcmpgtw(XmmRegister dst, XmmRegister src) {
+void X86_64Assembler::pcmpgtw(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0x65);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+}
+
+void X86_64Assembler::pcmpgtd(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0x66);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+}
+
+void X86_64Assembler::pcmpgtq(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0x38);
+  EmitUint8(0x37);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+}
+
+void X86_64Assembler::pmovmskb(CpuRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0xD7);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+}
+
+void X86_64Assembler::ptest(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0x38);
+  EmitUint8(0x17);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+}
+
+void X86_64Assembler::pclmulqdq(XmmRegister dst, XmmRegister src, const Immediate& imm) {
+  DCHECK(imm.is_uint8());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0x3A);
+  EmitUint8(0x44);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+  EmitUint8(imm.value());
+}
+
+void X86_64Assembler::shufpd(XmmRegister dst, XmmRegister src, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0xC6);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+  EmitUint8(imm.value());
+}
+
+
+void X86_64Assembler::shufps(XmmRegister dst, XmmRegister src, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0xC6);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+  EmitUint8(imm.value());
+}
+
+
+void X86_64Assembler::pshufd(XmmRegister dst, XmmRegister src, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0x70);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+  EmitUint8(imm.value());
+}
+
+
+void X86_64Assembler::punpcklbw(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0x60);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+}
+
+
+void X86_64Assembler::punpcklwd(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0x61);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+}
+
+
+void X86_64Assembler::punpckldq(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0x62);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+}
+
+
+void X86_64Assembler::punpcklqdq(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex32(dst, src);
+  EmitUint8(0x0F);
+  EmitUint8(0x6C);
+  EmitXmmRegisterOperand(dst.LowBits(), src);
+}
+
+
+void X86_64Assembler::psllw(XmmRegister reg, const Immediate& shift_count) {
+  DCHECK(shift_count.is_uint8());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
+  EmitUint8(0x0F);
+  EmitUint8(0x71);
+  EmitXmmRegisterOperand(6, reg);
+  EmitUint8(shift_count.value());
+}
+
+
+void X86_64Assembler::pslld(XmmRegister reg, const Immediate& shift_count) {
+  DCHECK(shift_count.is_uint8());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
+  EmitUint8(0x0F);
+  EmitUint8(0x72);
+  EmitXmmRegisterOperand(6, reg);
+  EmitUint8(shift_count.value());
+}
+
+
+void X86_64Assembler::psllq(XmmRegister reg, const Immediate& shift_count) {
+  DCHECK(shift_count.is_uint8());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
+  EmitUint8(0x0F);
+  EmitUint8(0x73);
+  EmitXmmRegisterOperand(6, reg);
+  EmitUint8(shift_count.value());
+}
+
+
+void X86_64Assembler::psraw(XmmRegister reg, const Immediate& shift_count) {
+  DCHECK(shift_count.is_uint8());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
+  EmitUint8(0x0F);
+  EmitUint8(0x71);
+  EmitXmmRegisterOperand(4, reg);
+  EmitUint8(shift_count.value());
+}
+
+
+void X86_64Assembler::psrad(XmmRegister reg, const Immediate& shift_count) {
+  DCHECK(shift_count.is_uint8());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
+  EmitUint8(0x0F);
+  EmitUint8(0x72);
+  EmitXmmRegisterOperand(4, reg);
+  EmitUint8(shift_count.value());
+}
+
+
+void X86_64Assembler::psrlw(XmmRegister reg, const Immediate& shift_count) {
+  DCHECK(shift_count.is_uint8());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
+  EmitUint8(0x0F);
+  EmitUint8(0x71);
+  EmitXmmRegisterOperand(2, reg);
+  EmitUint8(shift_count.value());
+}
+
+
+void X86_64Assembler::psrld(XmmRegister reg, const Immediate& shift_count) {
+  DCHECK(shift_count.is_uint8());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
+  EmitUint8(0x0F);
+  EmitUint8(0x72);
+  EmitXmmRegisterOperand(2, reg);
+  EmitUint8(shift_count.value());
+}
+
+
+void X86_64Assembler::psrlq(XmmRegister reg, const Immediate& shift_count) {
+  DCHECK(shift_count.is_uint8());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
+  EmitUint8(0x0F);
+  EmitUint8(0x73);
+  EmitXmmRegisterOperand(2, reg);
+  EmitUint8(shift_count.value());
+}
+
+
+void X86_64Assembler::psrldq(XmmRegister reg, const Immediate& shift_count) {
+  DCHECK(shift_count.is_uint8());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
+  EmitUint8(0x0F);
+  EmitUint8(0x73);
+  EmitXmmRegisterOperand(3, reg);
+  EmitUint8(shift_count.value());
+}
+
+
+void X86_64Assembler::vzeroupper() {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexPrefix(kVexMap0F, kVexPrefixNone, /* is_256 */ false, /* w */ false,
+                /* r */ false, /* x */ false, /* b */ false, 0);
+  EmitUint8(0x77);
+}
+
+
+void X86_64Assembler::vmovd(XmmRegister dst, CpuRegister src, bool is64bit) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexPrefix(kVexMap0F, kVexPrefix66, /* is_256 */ false, is64bit,
+                dst.NeedsRex(), /* x */ false, src.NeedsRex(), 0);
+  EmitUint8(0x6E);
+  EmitOperand(dst.LowBits(), Operand(src));
+}
+
+
+void X86_64Assembler::vmovaps(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x28, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86_64Assembler::vcvtdq2ps(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x5B, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86_64Assembler::vpabsd(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x1E, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86_64Assembler::vextracti128(XmmRegister dst, XmmRegister src, const Immediate& imm) {
+  DCHECK(imm.is_uint8());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  // The source goes in ModRM.reg and the destination in ModRM.rm.
+  EmitVexRegisterOp(kVexMap0F3A, kVexPrefix66, 0x39, src, XmmRegister(XMM0), dst);
+  EmitUint8(imm.value());
+}
+
+
+void X86_64Assembler::vpbroadcastb(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x78, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86_64Assembler::vpbroadcastw(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x79, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86_64Assembler::vpbroadcastd(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x58, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86_64Assembler::vpbroadcastq(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x59, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86_64Assembler::vbroadcastss(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x18, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86_64Assembler::vbroadcastsd(XmmRegister dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x19, dst, XmmRegister(XMM0), src);
+}
+
+
+void X86_64Assembler::vmovdqa(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefix66, 0x6F, dst, src);
+}
+
+
+void X86_64Assembler::vmovdqu(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefixF3, 0x6F, dst, src);
+}
+
+
+void X86_64Assembler::vmovaps(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefixNone, 0x28, dst, src);
+}
+
+
+void X86_64Assembler::vmovups(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefixNone, 0x10, dst, src);
+}
+
+
+void X86_64Assembler::vmovapd(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefix66, 0x28, dst, src);
+}
+
+
+void X86_64Assembler::vmovupd(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefix66, 0x10, dst, src);
+}
+
+
+void X86_64Assembler::vpmovzxbw(XmmRegister dst, const Address& src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F38, kVexPrefix66, 0x30, dst, src);
+}
+
+
+void X86_64Assembler::vmovdqa(const Address& dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefix66, 0x7F, src, dst);
+}
+
+
+void X86_64Assembler::vmovdqu(const Address& dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefixF3, 0x7F, src, dst);
+}
+
+
+void X86_64Assembler::vmovaps(const Address& dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefixNone, 0x29, src, dst);
+}
+
+
+void X86_64Assembler::vmovups(const Address& dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefixNone, 0x11, src, dst);
+}
+
+
+void X86_64Assembler::vmovapd(const Address& dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefix66, 0x29, src, dst);
+}
+
+
+void X86_64Assembler::vmovupd(const Address& dst, XmmRegister src) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexMemoryOp(kVexMap0F, kVexPrefix66, 0x11, src, dst);
+}
+
+
+void X86_64Assembler::vpaddb(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xFC, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpaddw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xFD, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpaddd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xFE, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpaddq(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xD4, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpsubb(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xF8, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpsubw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xF9, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpsubd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xFA, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpsubq(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xFB, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpmullw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xD5, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpmulld(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x40, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vaddps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x58, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vaddpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x58, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vsubps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x5C, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vsubpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x5C, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vmulps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x59, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vmulpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x59, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vdivps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x5E, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vdivpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x5E, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpand(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xDB, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpandn(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xDF, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpor(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xEB, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpxor(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xEF, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vandps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x54, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vandpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x54, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vandnps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x55, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vandnpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x55, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vorps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x56, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vorpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x56, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vxorps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x57, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vxorpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x57, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpavgb(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xE0, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpavgw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xE3, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpminsb(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x38, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpmaxsb(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x3C, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpminsw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xEA, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpmaxsw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xEE, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpminsd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x39, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpmaxsd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x3D, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpminub(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xDA, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpmaxub(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0xDE, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpminuw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x3A, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpmaxuw(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x3E, dst, src1, src2);
+}
+
+
+void X86_64Assembler::vpminud(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex32(dst, src);
-  EmitUint8(0x0F);
-  EmitUint8(0x65);
-  EmitXmmRegisterOperand(dst.LowBits(), src);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x3B, dst, src1, src2);
 }
 
-void X86_64Assembler::pcmpgtd(XmmRegister dst, XmmRegister src) {
+
+void X86_64Assembler::vpmaxud(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex32(dst, src);
-  EmitUint8(0x0F);
-  EmitUint8(0x66);
-  EmitXmmRegisterOperand(dst.LowBits(), src);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x3F, dst, src1, src2);
 }
 
-void X86_64Assembler::pcmpgtq(XmmRegister dst, XmmRegister src) {
+
+void X86_64Assembler::vminps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex32(dst, src);
-  EmitUint8(0x0F);
-  EmitUint8(0x38);
-  EmitUint8(0x37);
-  EmitXmmRegisterOperand(dst.LowBits(), src);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x5D, dst, src1, src2);
 }
 
-void X86_64Assembler::shufpd(XmmRegister dst, XmmRegister src, const Immediate& imm) {
+
+void X86_64Assembler::vmaxps(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex32(dst, src);
-  EmitUint8(0x0F);
-  EmitUint8(0xC6);
-  EmitXmmRegisterOperand(dst.LowBits(), src);
-  EmitUint8(imm.value());
+  EmitVexRegisterOp(kVexMap0F, kVexPrefixNone, 0x5F, dst, src1, src2);
 }
 
 
-void X86_64Assembler::shufps(XmmRegister dst, XmmRegister src, const Immediate& imm) {
+void X86_64Assembler::vminpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitOptionalRex32(dst, src);
-  EmitUint8(0x0F);
-  EmitUint8(0xC6);
-  EmitXmmRegisterOperand(dst.LowBits(), src);
-  EmitUint8(imm.value());
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x5D, dst, src1, src2);
 }
 
 
-void X86_64Assembler::pshufd(XmmRegister dst, XmmRegister src, const Immediate& imm) {
+void X86_64Assembler::vmaxpd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex32(dst, src);
-  EmitUint8(0x0F);
-  EmitUint8(0x70);
-  EmitXmmRegisterOperand(dst.LowBits(), src);
-  EmitUint8(imm.value());
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x5F, dst, src1, src2);
 }
 
 
-void X86_64Assembler::punpcklbw(XmmRegister dst, XmmRegister src) {
+void X86_64Assembler::vpcmpeqb(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex32(dst, src);
-  EmitUint8(0x0F);
-  EmitUint8(0x60);
-  EmitXmmRegisterOperand(dst.LowBits(), src);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x74, dst, src1, src2);
 }
 
 
-void X86_64Assembler::punpcklwd(XmmRegister dst, XmmRegister src) {
+void X86_64Assembler::vpcmpgtd(XmmRegister dst, XmmRegister src1, XmmRegister src2) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex32(dst, src);
-  EmitUint8(0x0F);
-  EmitUint8(0x61);
-  EmitXmmRegisterOperand(dst.LowBits(), src);
+  EmitVexRegisterOp(kVexMap0F, kVexPrefix66, 0x66, dst, src1, src2);
 }
 
 
-void X86_64Assembler::punpckldq(XmmRegister dst, XmmRegister src) {
+void X86_64Assembler::vpmovmskb(CpuRegister dst, XmmRegister src) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex32(dst, src);
-  EmitUint8(0x0F);
-  EmitUint8(0x62);
+  EmitVexPrefix(kVexMap0F, kVexPrefix66, /* is_256 */ true, /* w */ false,
+                dst.NeedsRex(), /* x */ false, src.NeedsRex(), 0);
+  EmitUint8(0xD7);
   EmitXmmRegisterOperand(dst.LowBits(), src);
 }
 
 
-void X86_64Assembler::punpcklqdq(XmmRegister dst, XmmRegister src) {
+void X86_64Assembler::vptest(XmmRegister dst, XmmRegister src) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex32(dst, src);
-  EmitUint8(0x0F);
-  EmitUint8(0x6C);
-  EmitXmmRegisterOperand(dst.LowBits(), src);
+  EmitVexRegisterOp(kVexMap0F38, kVexPrefix66, 0x17, dst, XmmRegister(XMM0), src);
 }
 
 
-void X86_64Assembler::psllw(XmmRegister reg, const Immediate& shift_count) {
-  DCHECK(shift_count.is_uint8());
+void X86_64Assembler::vpsllw(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
-  EmitUint8(0x0F);
-  EmitUint8(0x71);
-  EmitXmmRegisterOperand(6, reg);
-  EmitUint8(shift_count.value());
+  EmitVexShift(0x71, 6, dst, src, shift_count);
 }
 
 
-void X86_64Assembler::pslld(XmmRegister reg, const Immediate& shift_count) {
-  DCHECK(shift_count.is_uint8());
+void X86_64Assembler::vpslld(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
-  EmitUint8(0x0F);
-  EmitUint8(0x72);
-  EmitXmmRegisterOperand(6, reg);
-  EmitUint8(shift_count.value());
+  EmitVexShift(0x72, 6, dst, src, shift_count);
 }
 
 
-void X86_64Assembler::psllq(XmmRegister reg, const Immediate& shift_count) {
-  DCHECK(shift_count.is_uint8());
+void X86_64Assembler::vpsllq(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
-  EmitUint8(0x0F);
-  EmitUint8(0x73);
-  EmitXmmRegisterOperand(6, reg);
-  EmitUint8(shift_count.value());
+  EmitVexShift(0x73, 6, dst, src, shift_count);
 }
 
 
-void X86_64Assembler::psraw(XmmRegister reg, const Immediate& shift_count) {
-  DCHECK(shift_count.is_uint8());
+void X86_64Assembler::vpsraw(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
-  EmitUint8(0x0F);
-  EmitUint8(0x71);
-  EmitXmmRegisterOperand(4, reg);
-  EmitUint8(shift_count.value());
+  EmitVexShift(0x71, 4, dst, src, shift_count);
 }
 
 
-void X86_64Assembler::psrad(XmmRegister reg, const Immediate& shift_count) {
-  DCHECK(shift_count.is_uint8());
+void X86_64Assembler::vpsrad(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
-  EmitUint8(0x0F);
-  EmitUint8(0x72);
-  EmitXmmRegisterOperand(4, reg);
-  EmitUint8(shift_count.value());
+  EmitVexShift(0x72, 4, dst, src, shift_count);
 }
 
 
-void X86_64Assembler::psrlw(XmmRegister reg, const Immediate& shift_count) {
-  DCHECK(shift_count.is_uint8());
+void X86_64Assembler::vpsrlw(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
-  EmitUint8(0x0F);
-  EmitUint8(0x71);
-  EmitXmmRegisterOperand(2, reg);
-  EmitUint8(shift_count.value());
+  EmitVexShift(0x71, 2, dst, src, shift_count);
 }
 
 
-void X86_64Assembler::psrld(XmmRegister reg, const Immediate& shift_count) {
-  DCHECK(shift_count.is_uint8());
+void X86_64Assembler::vpsrld(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
-  EmitUint8(0x0F);
-  EmitUint8(0x72);
-  EmitXmmRegisterOperand(2, reg);
-  EmitUint8(shift_count.value());
+  EmitVexShift(0x72, 2, dst, src, shift_count);
 }
 
 
-void X86_64Assembler::psrlq(XmmRegister reg, const Immediate& shift_count) {
-  DCHECK(shift_count.is_uint8());
+void X86_64Assembler::vpsrlq(XmmRegister dst, XmmRegister src, const Immediate& shift_count) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
-  EmitUint8(0x66);
-  EmitOptionalRex(false, false, false, false, reg.NeedsRex());
-  EmitUint8(0x0F);
-  EmitUint8(0x73);
-  EmitXmmRegisterOperand(2, reg);
-  EmitUint8(shift_count.value());
+  EmitVexShift(0x73, 2, dst, src, shift_count);
 }
 
-
 void X86_64Assembler::fldl(const Address& src) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitUint8(0xDD);
@@ -2010,6 +2585,14 @@ void X86_64Assembler::xchgl(CpuRegister reg, const Address& address) {
 }
 
 
+void X86_64Assembler::xchgq(CpuRegister reg, const Address& address) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitRex64(reg, address);
+  EmitUint8(0x87);
+  EmitOperand(reg.LowBits(), address);
+}
+
+
 void X86_64Assembler::cmpb(const Address& address, const Immediate& imm) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   CHECK(imm.is_int32());
@@ -2217,6 +2800,21 @@ void X86_64Assembler::andl(CpuRegister dst, const Immediate& imm) {
 }
 
 
+void X86_64Assembler::andl(const Address& address, CpuRegister reg) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitOptionalRex32(reg, address);
+  EmitUint8(0x21);
+  EmitOperand(reg.LowBits(), address);
+}
+
+
+void X86_64Assembler::andl(const Address& address, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitOptionalRex32(address);
+  EmitComplex(4, address, imm);
+}
+
+
 void X86_64Assembler::andq(CpuRegister reg, const Immediate& imm) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   CHECK(imm.is_int32());  // andq only supports 32b immediate.
@@ -2264,6 +2862,21 @@ void X86_64Assembler::orl(CpuRegister dst, const Immediate& imm) {
 }
 
 
+void X86_64Assembler::orl(const Address& address, CpuRegister reg) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitOptionalRex32(reg, address);
+  EmitUint8(0x09);
+  EmitOperand(reg.LowBits(), address);
+}
+
+
+void X86_64Assembler::orl(const Address& address, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitOptionalRex32(address);
+  EmitComplex(1, address, imm);
+}
+
+
 void X86_64Assembler::orq(CpuRegister dst, const Immediate& imm) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   CHECK(imm.is_int32());  // orq only supports 32b immediate.
@@ -2311,6 +2924,21 @@ void X86_64Assembler::xorl(CpuRegister dst, const Immediate& imm) {
 }
 
 
+void X86_64Assembler::xorl(const Address& address, CpuRegister reg) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitOptionalRex32(reg, address);
+  EmitUint8(0x31);
+  EmitOperand(reg.LowBits(), address);
+}
+
+
+void X86_64Assembler::xorl(const Address& address, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitOptionalRex32(address);
+  EmitComplex(6, address, imm);
+}
+
+
 void X86_64Assembler::xorq(CpuRegister dst, CpuRegister src) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitRex64(dst, src);
@@ -2410,6 +3038,14 @@ void X86_64Assembler::addq(CpuRegister dst, const Address& address) {
 }
 
 
+void X86_64Assembler::addq(const Address& address, const Immediate& imm) {
+  CHECK(imm.is_int32());  // addq only supports 32b immediate.
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitRex64(address);
+  EmitComplex(0, address, imm);
+}
+
+
 void X86_64Assembler::addq(CpuRegister dst, CpuRegister src) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   // 0x01 is addq r/m64 <- r/m64 + r64, with op1 in r/m and op2 in reg: so reverse EmitRex64
@@ -2481,6 +3117,21 @@ void X86_64Assembler::subl(CpuRegister reg, const Address& address) {
 }
 
 
+void X86_64Assembler::subl(const Address& address, CpuRegister reg) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitOptionalRex32(reg, address);
+  EmitUint8(0x29);
+  EmitOperand(reg.LowBits(), address);
+}
+
+
+void X86_64Assembler::subl(const Address& address, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitOptionalRex32(address);
+  EmitComplex(5, address, imm);
+}
+
+
 void X86_64Assembler::cdq() {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitUint8(0x99);
@@ -2925,6 +3576,13 @@ void X86_64Assembler::jmp(NearLabel* label) {
 }
 
 
+void X86_64Assembler::rep_movsb() {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0xF3);
+  EmitUint8(0xA4);
+}
+
+
 void X86_64Assembler::rep_movsw() {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitUint8(0x66);
@@ -2933,6 +3591,21 @@ void X86_64Assembler::rep_movsw() {
 }
 
 
+void X86_64Assembler::rep_movsl() {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0xF3);
+  EmitUint8(0xA5);
+}
+
+
+void X86_64Assembler::rep_movsq() {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0xF3);
+  EmitRex64();
+  EmitUint8(0xA5);
+}
+
+
 X86_64Assembler* X86_64Assembler::lock() {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitUint8(0xF0);
@@ -2958,6 +3631,24 @@ void X86_64Assembler::cmpxchgq(const Address& address, CpuRegister reg) {
 }
 
 
+void X86_64Assembler::xaddl(const Address& address, CpuRegister reg) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitOptionalRex32(reg, address);
+  EmitUint8(0x0F);
+  EmitUint8(0xC1);
+  EmitOperand(reg.LowBits(), address);
+}
+
+
+void X86_64Assembler::xaddq(const Address& address, CpuRegister reg) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitRex64(reg, address);
+  EmitUint8(0x0F);
+  EmitUint8(0xC1);
+  EmitOperand(reg.LowBits(), address);
+}
+
+
 void X86_64Assembler::mfence() {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitUint8(0x0F);
@@ -2965,6 +3656,22 @@ void X86_64Assembler::mfence() {
   EmitUint8(0xF0);
 }
 
+void X86_64Assembler::prefetcht0(const Address& address) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitOptionalRex32(address);
+  EmitUint8(0x0F);
+  EmitUint8(0x18);
+  EmitOperand(1, address);
+}
+
+void X86_64Assembler::prefetchnta(const Address& address) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitOptionalRex32(address);
+  EmitUint8(0x0F);
+  EmitUint8(0x18);
+  EmitOperand(0, address);
+}
+
 
 X86_64Assembler* X86_64Assembler::gs() {
   // TODO: gs is a prefix and not an instruction
@@ -3166,6 +3873,33 @@ void X86_64Assembler::Align(int alignment, int offset) {
 }
 
 
+size_t X86_64Assembler::AlignWithNops(int alignment) {
+  CHECK(IsPowerOfTwo(alignment));
+  // The nops recommended by the Intel optimization manual, of 1 to 9 bytes.
+  static constexpr uint8_t kNops[][9] = {
+    { 0x90 },
+    { 0x66, 0x90 },
+    { 0x0F, 0x1F, 0x00 },
+    { 0x0F, 0x1F, 0x40, 0x00 },
+    { 0x0F, 0x1F, 0x44, 0x00, 0x00 },
+    { 0x66, 0x0F, 0x1F, 0x44, 0x00, 0x00 },
+    { 0x0F, 0x1F, 0x80, 0x00, 0x00, 0x00, 0x00 },
+    { 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    { 0x66, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+  };
+  size_t padding = static_cast<size_t>(-buffer_.GetPosition() & (alignment - 1));
+  for (size_t remaining = padding; remaining != 0u;) {
+    AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+    size_t size = std::min<size_t>(remaining, arraysize(kNops));
+    for (size_t i = 0; i != size; ++i) {
+      EmitUint8(kNops[size - 1][i]);
+    }
+    remaining -= size;
+  }
+  return padding;
+}
+
+
 void X86_64Assembler::Bind(Label* label) {
   int bound = buffer_.Size();
   CHECK(!label->IsBound());  // Labels can only be bound once.
@@ -3194,6 +3928,57 @@ void X86_64Assembler::Bind(NearLabel* label) {
 }
 
 
+void X86_64Assembler::EmitVexPrefix(VexOpcodeMap map, VexSimdPrefix pp, bool is_256, bool w,
+                                    bool r, bool x, bool b, int vvvv) {
+  // R, X, B and vvvv are stored inverted.
+  uint8_t l_pp = (is_256 ? 0x04 : 0x00) | pp;
+  uint8_t inverted_vvvv = (~vvvv & 0x0F) << 3;
+  uint8_t inverted_r = r ? 0x00 : 0x80;
+  if (map == kVexMap0F && !w && !x && !b) {
+    // Two byte form: R vvvv L pp.
+    EmitUint8(0xC5);
+    EmitUint8(inverted_r | inverted_vvvv | l_pp);
+  } else {
+    // Three byte form: R X B mmmmm, then W vvvv L pp.
+    EmitUint8(0xC4);
+    EmitUint8(inverted_r | (x ? 0x00 : 0x40) | (b ? 0x00 : 0x20) | map);
+    EmitUint8((w ? 0x80 : 0x00) | inverted_vvvv | l_pp);
+  }
+}
+
+
+void X86_64Assembler::EmitVexRegisterOp(VexOpcodeMap map, VexSimdPrefix pp, uint8_t opcode,
+                                        XmmRegister dst, XmmRegister src1, XmmRegister src2) {
+  EmitVexPrefix(map, pp, /* is_256 */ true, /* w */ false,
+                dst.NeedsRex(), /* x */ false, src2.NeedsRex(), src1.AsFloatRegister());
+  EmitUint8(opcode);
+  EmitXmmRegisterOperand(dst.LowBits(), src2);
+}
+
+
+void X86_64Assembler::EmitVexMemoryOp(VexOpcodeMap map, VexSimdPrefix pp, uint8_t opcode,
+                                      XmmRegister reg, const Operand& operand) {
+  // The operand keeps its SIB.index and base extensions as REX bits.
+  uint8_t rex = operand.rex();
+  EmitVexPrefix(map, pp, /* is_256 */ true, /* w */ false,
+                reg.NeedsRex(), (rex & 0x02) != 0, (rex & 0x01) != 0, 0);
+  EmitUint8(opcode);
+  EmitOperand(reg.LowBits(), operand);
+}
+
+
+void X86_64Assembler::EmitVexShift(uint8_t opcode, int rm, XmmRegister dst, XmmRegister src,
+                                   const Immediate& shift_count) {
+  DCHECK(shift_count.is_uint8());
+  // The destination goes in vvvv, ModRM.reg extends the opcode.
+  EmitVexPrefix(kVexMap0F, kVexPrefix66, /* is_256 */ true, /* w */ false,
+                /* r */ false, /* x */ false, src.NeedsRex(), dst.AsFloatRegister());
+  EmitUint8(opcode);
+  EmitXmmRegisterOperand(rm, src);
+  EmitUint8(shift_count.value());
+}
+
+
 void X86_64Assembler::EmitOperand(uint8_t reg_or_opcode, const Operand& operand) {
   CHECK_GE(reg_or_opcode, 0);
   CHECK_LT(reg_or_opcode, 8);
@@ -501,6 +501,8 @@ class X86_64Assembler FINAL : public Assembler {
   void roundsd(XmmRegister dst, XmmRegister src, const Immediate& imm);
   void roundss(XmmRegister dst, XmmRegister src, const Immediate& imm);
 
+  void pcmpestri(XmmRegister dst, const Address& src, const Immediate& imm);  // SSE4.2
+
   void sqrtsd(XmmRegister dst, XmmRegister src);
   void sqrtss(XmmRegister dst, XmmRegister src);
 
@@ -555,6 +557,11 @@ class X86_64Assembler FINAL : public Assembler {
   void pcmpgtd(XmmRegister dst, XmmRegister src);
   void pcmpgtq(XmmRegister dst, XmmRegister src);  // SSE4.2
 
+  void pmovmskb(CpuRegister dst, XmmRegister src);  // one bit per byte
+  void ptest(XmmRegister dst, XmmRegister src);  // SSE4.1
+
+  void pclmulqdq(XmmRegister dst, XmmRegister src, const Immediate& imm);  // PCLMUL
+
   void shufpd(XmmRegister dst, XmmRegister src, const Immediate& imm);
   void shufps(XmmRegister dst, XmmRegister src, const Immediate& imm);
   void pshufd(XmmRegister dst, XmmRegister src, const Immediate& imm);
@@ -575,6 +582,119 @@ class X86_64Assembler FINAL : public Assembler {
   void psrlw(XmmRegister reg, const Immediate& shift_count);
   void psrld(XmmRegister reg, const Immediate& shift_count);
   void psrlq(XmmRegister reg, const Immediate& shift_count);
+  void psrldq(XmmRegister reg, const Immediate& shift_count);  // shift in bytes
+
+  //
+  // AVX2 instructions on 256-bit vectors. Each one uses the full YMM register extending
+  // the XmmRegister named. The three operand forms compute dst = src1 op src2.
+  //
+
+  void vzeroupper();
+  void vmovd(XmmRegister dst, CpuRegister src, bool is64bit);  // 128-bit, clears the upper lanes
+
+  void vmovaps(XmmRegister dst, XmmRegister src);     // move
+  void vmovaps(XmmRegister dst, const Address& src);  // load aligned
+  void vmovups(XmmRegister dst, const Address& src);  // load unaligned
+  void vmovaps(const Address& dst, XmmRegister src);  // store aligned
+  void vmovups(const Address& dst, XmmRegister src);  // store unaligned
+
+  void vmovapd(XmmRegister dst, const Address& src);  // load aligned
+  void vmovupd(XmmRegister dst, const Address& src);  // load unaligned
+  void vmovapd(const Address& dst, XmmRegister src);  // store aligned
+  void vmovupd(const Address& dst, XmmRegister src);  // store unaligned
+
+  void vmovdqa(XmmRegister dst, const Address& src);  // load aligned
+  void vmovdqu(XmmRegister dst, const Address& src);  // load unaligned
+  void vmovdqa(const Address& dst, XmmRegister src);  // store aligned
+  void vmovdqu(const Address& dst, XmmRegister src);  // store unaligned
+
+  void vpmovzxbw(XmmRegister dst, const Address& src);  // 16 bytes into 16 words
+
+  void vpbroadcastb(XmmRegister dst, XmmRegister src);
+  void vpbroadcastw(XmmRegister dst, XmmRegister src);
+  void vpbroadcastd(XmmRegister dst, XmmRegister src);
+  void vpbroadcastq(XmmRegister dst, XmmRegister src);
+  void vbroadcastss(XmmRegister dst, XmmRegister src);
+  void vbroadcastsd(XmmRegister dst, XmmRegister src);
+
+  void vcvtdq2ps(XmmRegister dst, XmmRegister src);
+  void vpabsd(XmmRegister dst, XmmRegister src);
+  void vextracti128(XmmRegister dst, XmmRegister src, const Immediate& imm);  // 128-bit lane imm of src
+
+  void vpaddb(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpaddw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpaddd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpaddq(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpsubb(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpsubw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpsubd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpsubq(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpmullw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmulld(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vaddps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vaddpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vsubps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vsubpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vmulps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vmulpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vdivps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vdivpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpand(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpandn(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpor(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpxor(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vandps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vandpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vandnps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vandnpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vorps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vorpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vxorps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vxorpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpavgb(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpavgw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpminsb(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmaxsb(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpminsw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmaxsw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpminsd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmaxsd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpminub(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmaxub(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpminuw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmaxuw(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpminud(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpmaxud(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vminps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vmaxps(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vminpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vmaxpd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpcmpeqb(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void vpcmpgtd(XmmRegister dst, XmmRegister src1, XmmRegister src2);
+
+  void vpmovmskb(CpuRegister dst, XmmRegister src);  // one bit per byte, 32 bits
+  void vptest(XmmRegister dst, XmmRegister src);
+
+  void vpsllw(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+  void vpslld(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+  void vpsllq(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+
+  void vpsraw(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+  void vpsrad(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+
+  void vpsrlw(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+  void vpsrld(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
+  void vpsrlq(XmmRegister dst, XmmRegister src, const Immediate& shift_count);
 
   void flds(const Address& src);
   void fstps(const Address& dst);
@@ -607,6 +727,7 @@ class X86_64Assembler FINAL : public Assembler {
   void xchgl(CpuRegister dst, CpuRegister src);
   void xchgq(CpuRegister dst, CpuRegister src);
   void xchgl(CpuRegister reg, const Address& address);
+  void xchgq(CpuRegister reg, const Address& address);
 
   void cmpb(const Address& address, const Immediate& imm);
   void cmpw(const Address& address, const Immediate& imm);
@@ -635,6 +756,8 @@ class X86_64Assembler FINAL : public Assembler {
   void andl(CpuRegister dst, const Immediate& imm);
   void andl(CpuRegister dst, CpuRegister src);
   void andl(CpuRegister reg, const Address& address);
+  void andl(const Address& address, CpuRegister reg);
+  void andl(const Address& address, const Immediate& imm);
   void andq(CpuRegister dst, const Immediate& imm);
   void andq(CpuRegister dst, CpuRegister src);
   void andq(CpuRegister reg, const Address& address);
@@ -642,6 +765,8 @@ class X86_64Assembler FINAL : public Assembler {
   void orl(CpuRegister dst, const Immediate& imm);
   void orl(CpuRegister dst, CpuRegister src);
   void orl(CpuRegister reg, const Address& address);
+  void orl(const Address& address, CpuRegister reg);
+  void orl(const Address& address, const Immediate& imm);
   void orq(CpuRegister dst, CpuRegister src);
   void orq(CpuRegister dst, const Immediate& imm);
   void orq(CpuRegister reg, const Address& address);
@@ -649,6 +774,8 @@ class X86_64Assembler FINAL : public Assembler {
   void xorl(CpuRegister dst, CpuRegister src);
   void xorl(CpuRegister dst, const Immediate& imm);
   void xorl(CpuRegister reg, const Address& address);
+  void xorl(const Address& address, CpuRegister reg);
+  void xorl(const Address& address, const Immediate& imm);
   void xorq(CpuRegister dst, const Immediate& imm);
   void xorq(CpuRegister dst, CpuRegister src);
   void xorq(CpuRegister reg, const Address& address);
@@ -662,10 +789,13 @@ class X86_64Assembler FINAL : public Assembler {
   void addq(CpuRegister reg, const Immediate& imm);
   void addq(CpuRegister dst, CpuRegister src);
   void addq(CpuRegister dst, const Address& address);
+  void addq(const Address& address, const Immediate& imm);
 
   void subl(CpuRegister dst, CpuRegister src);
   void subl(CpuRegister reg, const Immediate& imm);
   void subl(CpuRegister reg, const Address& address);
+  void subl(const Address& address, CpuRegister reg);
+  void subl(const Address& address, const Immediate& imm);
 
   void subq(CpuRegister reg, const Immediate& imm);
   void subq(CpuRegister dst, CpuRegister src);
@@ -736,9 +866,14 @@ class X86_64Assembler FINAL : public Assembler {
   X86_64Assembler* lock();
   void cmpxchgl(const Address& address, CpuRegister reg);
   void cmpxchgq(const Address& address, CpuRegister reg);
+  void xaddl(const Address& address, CpuRegister reg);
+  void xaddq(const Address& address, CpuRegister reg);
 
   void mfence();
 
+  void prefetcht0(const Address& address);
+  void prefetchnta(const Address& address);
+
   X86_64Assembler* gs();
 
   void setcc(Condition condition, CpuRegister dst);
@@ -776,7 +911,10 @@ class X86_64Assembler FINAL : public Assembler {
   void repe_cmpsw();
   void repe_cmpsl();
   void repe_cmpsq();
+  void rep_movsb();
   void rep_movsw();
+  void rep_movsl();
+  void rep_movsq();
 
   //
   // Macros for High-level operations.
@@ -794,11 +932,22 @@ class X86_64Assembler FINAL : public Assembler {
     lock()->cmpxchgq(address, reg);
   }
 
+  void LockXaddl(const Address& address, CpuRegister reg) {
+    lock()->xaddl(address, reg);
+  }
+
+  void LockXaddq(const Address& address, CpuRegister reg) {
+    lock()->xaddq(address, reg);
+  }
+
   //
   // Misc. functionality
   //
   int PreferredLoopAlignment() { return 16; }
   void Align(int alignment, int offset);
+  // Align the next instruction with the fewest multi-byte nops, for the code executing them.
+  // Returns the number of bytes of padding.
+  size_t AlignWithNops(int alignment);
   void Bind(Label* label) OVERRIDE;
   void Jump(Label* label) OVERRIDE {
     jmp(label);
@@ -905,6 +1054,19 @@ class X86_64Assembler FINAL : public Assembler {
   void EmitOptionalByteRegNormalizingRex32(CpuRegister dst, CpuRegister src);
   void EmitOptionalByteRegNormalizingRex32(CpuRegister dst, const Operand& operand);
 
+  // The opcode maps and implied SIMD prefixes of VEX encoded instructions.
+  enum VexOpcodeMap { kVexMap0F = 1, kVexMap0F38 = 2, kVexMap0F3A = 3 };
+  enum VexSimdPrefix { kVexPrefixNone = 0, kVexPrefix66 = 1, kVexPrefixF3 = 2, kVexPrefixF2 = 3 };
+
+  void EmitVexPrefix(VexOpcodeMap map, VexSimdPrefix pp, bool is_256, bool w,
+                     bool r, bool x, bool b, int vvvv);
+  void EmitVexRegisterOp(VexOpcodeMap map, VexSimdPrefix pp, uint8_t opcode,
+                         XmmRegister dst, XmmRegister src1, XmmRegister src2);
+  void EmitVexMemoryOp(VexOpcodeMap map, VexSimdPrefix pp, uint8_t opcode,
+                       XmmRegister reg, const Operand& operand);
+  void EmitVexShift(uint8_t opcode, int rm, XmmRegister dst, XmmRegister src,
+                    const Immediate& shift_count);
+
   ConstantArea constant_area_;
 
   DISALLOW_COPY_AND_ASSIGN(X86_64Assembler);
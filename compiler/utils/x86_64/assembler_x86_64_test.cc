@@ -45,6 +45,29 @@ static constexpr size_t kRandomIterations = 1000;  // Devices might be puny, don
 static constexpr size_t kRandomIterations = 100000;  // Hosts are pretty powerful.
 #endif
 
+TEST(AssemblerX86_64, AlignWithNops) {
+  ArenaPool pool;
+  ArenaAllocator arena(&pool);
+  x86_64::X86_64Assembler assembler(&arena);
+  assembler.movl(x86_64::CpuRegister(x86_64::RAX), x86_64::Immediate(1));
+  ASSERT_EQ(5u, assembler.CodeSize());
+  // A 9-byte nop, then a 2-byte one.
+  EXPECT_EQ(11u, assembler.AlignWithNops(16));
+  EXPECT_EQ(16u, assembler.CodeSize());
+  EXPECT_EQ(0u, assembler.AlignWithNops(16));
+  assembler.nop();
+  EXPECT_EQ(31u, assembler.AlignWithNops(32));
+  EXPECT_EQ(48u, assembler.CodeSize());
+  assembler.FinalizeCode();
+  std::vector<uint8_t> code(assembler.CodeSize());
+  MemoryRegion region(code.data(), code.size());
+  assembler.FinalizeInstructions(region);
+  EXPECT_EQ(0x66u, code[5]);
+  EXPECT_EQ(0x84u, code[8]);
+  EXPECT_EQ(0x66u, code[14]);
+  EXPECT_EQ(0x90u, code[15]);
+}
+
 TEST(AssemblerX86_64, SignExtension) {
   // 32bit.
   for (int32_t i = 0; i < 128; i++) {
@@ -735,6 +758,57 @@ TEST_F(AssemblerX86_64Test, LockCmpxchgq) {
   DriverStr(expected, "lock_cmpxchg");
 }
 
+TEST_F(AssemblerX86_64Test, LockXaddl) {
+  GetAssembler()->LockXaddl(x86_64::Address(
+      x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::RBX), x86_64::TIMES_4, 12),
+      x86_64::CpuRegister(x86_64::RSI));
+  GetAssembler()->LockXaddl(x86_64::Address(
+      x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::R9), x86_64::TIMES_4, 12),
+      x86_64::CpuRegister(x86_64::R8));
+  GetAssembler()->LockXaddl(x86_64::Address(
+      x86_64::CpuRegister(x86_64::R13), x86_64::CpuRegister(x86_64::R9), x86_64::TIMES_1, 0),
+      x86_64::CpuRegister(x86_64::RSI));
+  const char* expected =
+    "lock xaddl %ESI, 0xc(%RDI,%RBX,4)\n"
+    "lock xaddl %R8d, 0xc(%RDI,%R9,4)\n"
+    "lock xaddl %ESI, (%R13,%R9,1)\n";
+
+  DriverStr(expected, "lock_xaddl");
+}
+
+TEST_F(AssemblerX86_64Test, LockXaddq) {
+  GetAssembler()->LockXaddq(x86_64::Address(
+      x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::RBX), x86_64::TIMES_4, 12),
+      x86_64::CpuRegister(x86_64::RSI));
+  GetAssembler()->LockXaddq(x86_64::Address(
+      x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::R9), x86_64::TIMES_4, 12),
+      x86_64::CpuRegister(x86_64::R8));
+  GetAssembler()->LockXaddq(x86_64::Address(
+      x86_64::CpuRegister(x86_64::R13), x86_64::CpuRegister(x86_64::R9), x86_64::TIMES_1, 0),
+      x86_64::CpuRegister(x86_64::RSI));
+  const char* expected =
+    "lock xaddq %RSI, 0xc(%RDI,%RBX,4)\n"
+    "lock xaddq %R8, 0xc(%RDI,%R9,4)\n"
+    "lock xaddq %RSI, (%R13,%R9,1)\n";
+
+  DriverStr(expected, "lock_xaddq");
+}
+
+TEST_F(AssemblerX86_64Test, XchgAddress) {
+  GetAssembler()->xchgl(x86_64::CpuRegister(x86_64::RSI), x86_64::Address(
+      x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::R9), x86_64::TIMES_1, 0));
+  GetAssembler()->xchgq(x86_64::CpuRegister(x86_64::RSI), x86_64::Address(
+      x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::R9), x86_64::TIMES_1, 0));
+  GetAssembler()->xchgq(x86_64::CpuRegister(x86_64::R8), x86_64::Address(
+      x86_64::CpuRegister(x86_64::R13), 0));
+  const char* expected =
+    "xchgl %ESI, (%RDI,%R9,1)\n"
+    "xchgq %RSI, (%RDI,%R9,1)\n"
+    "xchgq %R8, (%R13)\n";
+
+  DriverStr(expected, "xchg_address");
+}
+
 TEST_F(AssemblerX86_64Test, Movl) {
   GetAssembler()->movl(x86_64::CpuRegister(x86_64::RAX), x86_64::Address(
       x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::RBX), x86_64::TIMES_4, 12));
@@ -814,6 +888,17 @@ TEST_F(AssemblerX86_64Test, Movntl) {
   DriverStr(expected, "movntl");
 }
 
+TEST_F(AssemblerX86_64Test, Prefetch) {
+  GetAssembler()->prefetcht0(x86_64::Address(
+      x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::R9), x86_64::TIMES_4, 512));
+  GetAssembler()->prefetchnta(x86_64::Address(x86_64::CpuRegister(x86_64::R13), 64));
+  const char* expected =
+    "prefetcht0 0x200(%RDI,%R9,4)\n"
+    "prefetchnta 0x40(%R13)\n";
+
+  DriverStr(expected, "prefetch");
+}
+
 TEST_F(AssemblerX86_64Test, Movntq) {
   GetAssembler()->movntq(x86_64::Address(
       x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::RBX), x86_64::TIMES_4, 12), x86_64::CpuRegister(x86_64::RAX));
@@ -886,6 +971,16 @@ TEST_F(AssemblerX86_64Test, AddqAddr) {
   DriverStr(expected, "addq");
 }
 
+TEST_F(AssemblerX86_64Test, AddqAddrImm) {
+  GetAssembler()->addq(x86_64::Address(x86_64::CpuRegister(x86_64::R9), 8), x86_64::Immediate(1));
+  GetAssembler()->addq(x86_64::Address(x86_64::CpuRegister(x86_64::RSP), 16),
+                       x86_64::Immediate(0x12345));
+  const char* expected =
+    "addq $1, 8(%R9)\n"
+    "addq $0x12345, 16(%RSP)\n";
+  DriverStr(expected, "addq_addr_imm");
+}
+
 TEST_F(AssemblerX86_64Test, SubqAddr) {
   GetAssembler()->subq(x86_64::CpuRegister(x86_64::R12),
                         x86_64::Address(x86_64::CpuRegister(x86_64::R9), 0));
@@ -968,12 +1063,30 @@ TEST_F(AssemblerX86_64Test, RepneScasw) {
   DriverStr(expected, "repne_scasw");
 }
 
+TEST_F(AssemblerX86_64Test, RepMovsb) {
+  GetAssembler()->rep_movsb();
+  const char* expected = "rep movsb\n";
+  DriverStr(expected, "rep_movsb");
+}
+
 TEST_F(AssemblerX86_64Test, RepMovsw) {
   GetAssembler()->rep_movsw();
   const char* expected = "rep movsw\n";
   DriverStr(expected, "rep_movsw");
 }
 
+TEST_F(AssemblerX86_64Test, RepMovsl) {
+  GetAssembler()->rep_movsl();
+  const char* expected = "rep movsl\n";
+  DriverStr(expected, "rep_movsl");
+}
+
+TEST_F(AssemblerX86_64Test, RepMovsq) {
+  GetAssembler()->rep_movsq();
+  const char* expected = "rep movsq\n";
+  DriverStr(expected, "rep_movsq");
+}
+
 TEST_F(AssemblerX86_64Test, Movsxd) {
   DriverStr(RepeatRr(&x86_64::X86_64Assembler::movsxd, "movsxd %{reg2}, %{reg1}"), "movsxd");
 }
@@ -1056,6 +1169,19 @@ TEST_F(AssemblerX86_64Test, MovdquAddr) {
   DriverStr(expected, "movdqu_address");
 }
 
+TEST_F(AssemblerX86_64Test, Pcmpestri) {
+  GetAssembler()->pcmpestri(x86_64::XmmRegister(x86_64::XMM0), x86_64::Address(
+      x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::RBX), x86_64::TIMES_2, 16),
+      x86_64::Immediate(0x0d));
+  GetAssembler()->pcmpestri(x86_64::XmmRegister(x86_64::XMM9), x86_64::Address(
+      x86_64::CpuRegister(x86_64::R13), x86_64::CpuRegister(x86_64::R9), x86_64::TIMES_1, 16),
+      x86_64::Immediate(0x0c));
+  const char* expected =
+    "pcmpestri $0xd, 0x10(%RDI,%RBX,2), %xmm0\n"
+    "pcmpestri $0xc, 0x10(%R13,%R9,1), %xmm9\n";
+  DriverStr(expected, "pcmpestri");
+}
+
 TEST_F(AssemblerX86_64Test, Movd1) {
   DriverStr(RepeatFR(&x86_64::X86_64Assembler::movd, "movd %{reg2}, %{reg1}"), "movd.1");
 }
@@ -1381,6 +1507,32 @@ TEST_F(AssemblerX86_64Test, PCmpeqq) {
   DriverStr(RepeatFF(&x86_64::X86_64Assembler::pcmpeqq, "pcmpeqq %{reg2}, %{reg1}"), "pcmpeqq");
 }
 
+TEST_F(AssemblerX86_64Test, PMovmskbPTest) {
+  GetAssembler()->pmovmskb(x86_64::CpuRegister(x86_64::RAX), x86_64::XmmRegister(x86_64::XMM1));
+  GetAssembler()->pmovmskb(x86_64::CpuRegister(x86_64::R9), x86_64::XmmRegister(x86_64::XMM12));
+  GetAssembler()->ptest(x86_64::XmmRegister(x86_64::XMM0), x86_64::XmmRegister(x86_64::XMM0));
+  GetAssembler()->ptest(x86_64::XmmRegister(x86_64::XMM10), x86_64::XmmRegister(x86_64::XMM3));
+  const char* expected =
+    "pmovmskb %xmm1, %eax\n"
+    "pmovmskb %xmm12, %r9d\n"
+    "ptest %xmm0, %xmm0\n"
+    "ptest %xmm3, %xmm10\n";
+  DriverStr(expected, "pmovmskb_ptest");
+}
+
+TEST_F(AssemblerX86_64Test, Pclmulqdq) {
+  GetAssembler()->pclmulqdq(x86_64::XmmRegister(x86_64::XMM1),
+                            x86_64::XmmRegister(x86_64::XMM2),
+                            x86_64::Immediate(0x00));
+  GetAssembler()->pclmulqdq(x86_64::XmmRegister(x86_64::XMM9),
+                            x86_64::XmmRegister(x86_64::XMM14),
+                            x86_64::Immediate(0x11));
+  const char* expected =
+    "pclmulqdq $0x0, %xmm2, %xmm1\n"
+    "pclmulqdq $0x11, %xmm14, %xmm9\n";
+  DriverStr(expected, "pclmulqdq");
+}
+
 TEST_F(AssemblerX86_64Test, PCmpgtb) {
   DriverStr(RepeatFF(&x86_64::X86_64Assembler::pcmpgtb, "pcmpgtb %{reg2}, %{reg1}"), "pcmpgtb");
 }
@@ -1481,6 +1633,126 @@ TEST_F(AssemblerX86_64Test, Psrlq) {
             "psrlq $2, %xmm15\n", "pslrqi");
 }
 
+TEST_F(AssemblerX86_64Test, Psrldq) {
+  GetAssembler()->psrldq(x86_64::XmmRegister(x86_64::XMM0),  x86_64::Immediate(4));
+  GetAssembler()->psrldq(x86_64::XmmRegister(x86_64::XMM15), x86_64::Immediate(8));
+  DriverStr("psrldq $4, %xmm0\n"
+            "psrldq $8, %xmm15\n", "psrldqi");
+}
+
+TEST_F(AssemblerX86_64Test, VexArithmetic) {
+  GetAssembler()->vpaddd(x86_64::XmmRegister(x86_64::XMM0),
+                         x86_64::XmmRegister(x86_64::XMM1),
+                         x86_64::XmmRegister(x86_64::XMM2));
+  GetAssembler()->vpsubq(x86_64::XmmRegister(x86_64::XMM8),
+                         x86_64::XmmRegister(x86_64::XMM9),
+                         x86_64::XmmRegister(x86_64::XMM10));
+  GetAssembler()->vpmaxsb(x86_64::XmmRegister(x86_64::XMM15),
+                          x86_64::XmmRegister(x86_64::XMM0),
+                          x86_64::XmmRegister(x86_64::XMM12));
+  GetAssembler()->vaddpd(x86_64::XmmRegister(x86_64::XMM3),
+                         x86_64::XmmRegister(x86_64::XMM14),
+                         x86_64::XmmRegister(x86_64::XMM4));
+  GetAssembler()->vxorps(x86_64::XmmRegister(x86_64::XMM11),
+                         x86_64::XmmRegister(x86_64::XMM11),
+                         x86_64::XmmRegister(x86_64::XMM11));
+  const char* expected =
+    "vpaddd %ymm2, %ymm1, %ymm0\n"
+    "vpsubq %ymm10, %ymm9, %ymm8\n"
+    "vpmaxsb %ymm12, %ymm0, %ymm15\n"
+    "vaddpd %ymm4, %ymm14, %ymm3\n"
+    "vxorps %ymm11, %ymm11, %ymm11\n";
+  DriverStr(expected, "vex_arithmetic");
+}
+
+TEST_F(AssemblerX86_64Test, VexMaskAndTest) {
+  GetAssembler()->vpmovmskb(x86_64::CpuRegister(x86_64::RCX), x86_64::XmmRegister(x86_64::XMM2));
+  GetAssembler()->vpmovmskb(x86_64::CpuRegister(x86_64::R11), x86_64::XmmRegister(x86_64::XMM9));
+  GetAssembler()->vptest(x86_64::XmmRegister(x86_64::XMM4), x86_64::XmmRegister(x86_64::XMM4));
+  GetAssembler()->vptest(x86_64::XmmRegister(x86_64::XMM13), x86_64::XmmRegister(x86_64::XMM1));
+  const char* expected =
+    "vpmovmskb %ymm2, %ecx\n"
+    "vpmovmskb %ymm9, %r11d\n"
+    "vptest %ymm4, %ymm4\n"
+    "vptest %ymm1, %ymm13\n";
+  DriverStr(expected, "vex_mask_and_test");
+}
+
+TEST_F(AssemblerX86_64Test, VexShifts) {
+  GetAssembler()->vpslld(x86_64::XmmRegister(x86_64::XMM0),
+                         x86_64::XmmRegister(x86_64::XMM9), x86_64::Immediate(3));
+  GetAssembler()->vpsraw(x86_64::XmmRegister(x86_64::XMM13),
+                         x86_64::XmmRegister(x86_64::XMM2), x86_64::Immediate(15));
+  GetAssembler()->vpsrld(x86_64::XmmRegister(x86_64::XMM15),
+                         x86_64::XmmRegister(x86_64::XMM15), x86_64::Immediate(1));
+  const char* expected =
+    "vpslld $3, %ymm9, %ymm0\n"
+    "vpsraw $15, %ymm2, %ymm13\n"
+    "vpsrld $1, %ymm15, %ymm15\n";
+  DriverStr(expected, "vex_shifts");
+}
+
+TEST_F(AssemblerX86_64Test, VexMoves) {
+  GetAssembler()->vmovaps(x86_64::XmmRegister(x86_64::XMM8), x86_64::XmmRegister(x86_64::XMM1));
+  GetAssembler()->vmovups(x86_64::XmmRegister(x86_64::XMM2),
+                          x86_64::Address(x86_64::CpuRegister(x86_64::RSP), 4));
+  GetAssembler()->vmovups(x86_64::Address(x86_64::CpuRegister(x86_64::RSP), 32),
+                          x86_64::XmmRegister(x86_64::XMM10));
+  GetAssembler()->vmovdqa(x86_64::XmmRegister(x86_64::XMM4), x86_64::Address(
+      x86_64::CpuRegister(x86_64::R9), x86_64::CpuRegister(x86_64::R10), x86_64::TIMES_4, 12));
+  GetAssembler()->vmovdqu(x86_64::Address(x86_64::CpuRegister(x86_64::R13), 8),
+                          x86_64::XmmRegister(x86_64::XMM5));
+  GetAssembler()->vpmovzxbw(x86_64::XmmRegister(x86_64::XMM11), x86_64::Address(
+      x86_64::CpuRegister(x86_64::RAX), x86_64::CpuRegister(x86_64::R8), x86_64::TIMES_1, 16));
+  GetAssembler()->vmovd(x86_64::XmmRegister(x86_64::XMM1), x86_64::CpuRegister(x86_64::RAX),
+                        /* is64bit */ false);
+  GetAssembler()->vmovd(x86_64::XmmRegister(x86_64::XMM9), x86_64::CpuRegister(x86_64::R11),
+                        /* is64bit */ true);
+  GetAssembler()->vzeroupper();
+  const char* expected =
+    "vmovaps %ymm1, %ymm8\n"
+    "vmovups 0x4(%RSP), %ymm2\n"
+    "vmovups %ymm10, 0x20(%RSP)\n"
+    "vmovdqa 0xc(%R9,%R10,4), %ymm4\n"
+    "vmovdqu %ymm5, 0x8(%R13)\n"
+    "vpmovzxbw 0x10(%RAX,%R8,1), %ymm11\n"
+    "vmovd %eax, %xmm1\n"
+    "vmovq %r11, %xmm9\n"
+    "vzeroupper\n";
+  DriverStr(expected, "vex_moves");
+}
+
+TEST_F(AssemblerX86_64Test, VexBroadcasts) {
+  GetAssembler()->vpbroadcastb(x86_64::XmmRegister(x86_64::XMM0),
+                               x86_64::XmmRegister(x86_64::XMM9));
+  GetAssembler()->vpbroadcastq(x86_64::XmmRegister(x86_64::XMM12),
+                               x86_64::XmmRegister(x86_64::XMM3));
+  GetAssembler()->vbroadcastss(x86_64::XmmRegister(x86_64::XMM7),
+                               x86_64::XmmRegister(x86_64::XMM7));
+  GetAssembler()->vbroadcastsd(x86_64::XmmRegister(x86_64::XMM14),
+                               x86_64::XmmRegister(x86_64::XMM15));
+  GetAssembler()->vcvtdq2ps(x86_64::XmmRegister(x86_64::XMM2),
+                            x86_64::XmmRegister(x86_64::XMM10));
+  const char* expected =
+    "vpbroadcastb %xmm9, %ymm0\n"
+    "vpbroadcastq %xmm3, %ymm12\n"
+    "vbroadcastss %xmm7, %ymm7\n"
+    "vbroadcastsd %xmm15, %ymm14\n"
+    "vcvtdq2ps %ymm10, %ymm2\n";
+  DriverStr(expected, "vex_broadcasts");
+}
+
+TEST_F(AssemblerX86_64Test, Vextracti128) {
+  GetAssembler()->vextracti128(x86_64::XmmRegister(x86_64::XMM11),
+                               x86_64::XmmRegister(x86_64::XMM4), x86_64::Immediate(1));
+  GetAssembler()->vextracti128(x86_64::XmmRegister(x86_64::XMM0),
+                               x86_64::XmmRegister(x86_64::XMM13), x86_64::Immediate(0));
+  const char* expected =
+    "vextracti128 $1, %ymm4, %xmm11\n"
+    "vextracti128 $0, %ymm13, %xmm0\n";
+  DriverStr(expected, "vextracti128");
+}
+
 TEST_F(AssemblerX86_64Test, UcomissAddress) {
   GetAssembler()->ucomiss(x86_64::XmmRegister(x86_64::XMM0), x86_64::Address(
       x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::RBX), x86_64::TIMES_4, 12));
@@ -1924,6 +2196,44 @@ TEST_F(AssemblerX86_64Test, TestlAddressImmediate) {
   DriverStr(expected, "TestlAddressImmediate");
 }
 
+TEST_F(AssemblerX86_64Test, AluAddressRegister) {
+  x86_64::Address array_element(x86_64::CpuRegister(x86_64::RDI),
+                                x86_64::CpuRegister(x86_64::R9),
+                                x86_64::TIMES_4,
+                                12);
+  x86_64::Address field(x86_64::CpuRegister(x86_64::R12), MemberOffset(130));
+  GetAssembler()->andl(array_element, x86_64::CpuRegister(x86_64::RAX));
+  GetAssembler()->orl(field, x86_64::CpuRegister(x86_64::R8));
+  GetAssembler()->xorl(array_element, x86_64::CpuRegister(x86_64::R15));
+  GetAssembler()->subl(field, x86_64::CpuRegister(x86_64::RCX));
+  const char* expected =
+      "andl %EAX, 0xc(%RDI,%R9,4)\n"
+      "orl %R8d, 0x82(%R12)\n"
+      "xorl %R15d, 0xc(%RDI,%R9,4)\n"
+      "subl %ECX, 0x82(%R12)\n";
+
+  DriverStr(expected, "AluAddressRegister");
+}
+
+TEST_F(AssemblerX86_64Test, AluAddressImmediate) {
+  x86_64::Address array_element(x86_64::CpuRegister(x86_64::RDI),
+                                x86_64::CpuRegister(x86_64::R9),
+                                x86_64::TIMES_4,
+                                12);
+  x86_64::Address field(x86_64::CpuRegister(x86_64::R12), MemberOffset(130));
+  GetAssembler()->andl(array_element, x86_64::Immediate(1));
+  GetAssembler()->orl(field, x86_64::Immediate(-128));
+  GetAssembler()->xorl(array_element, x86_64::Immediate(77777777));
+  GetAssembler()->subl(field, x86_64::Immediate(-100000));
+  const char* expected =
+      "andl $1, 0xc(%RDI,%R9,4)\n"
+      "orl $-128, 0x82(%R12)\n"
+      "xorl $77777777, 0xc(%RDI,%R9,4)\n"
+      "subl $-100000, 0x82(%R12)\n";
+
+  DriverStr(expected, "AluAddressImmediate");
+}
+
 class JNIMacroAssemblerX86_64Test : public JNIMacroAssemblerTest<x86_64::X86_64JNIMacroAssembler> {
  public:
   using Base = JNIMacroAssemblerTest<x86_64::X86_64JNIMacroAssembler>;
@@ -1177,6 +1177,50 @@ TEST_F(VerifierDepsTest, UnverifiedOrder) {
   EXPECT_EQ(buffer1, buffer2);
 }
 
+TEST_F(VerifierDepsTest, UnchangedClasses) {
+  VerifyDexFile();
+
+  std::vector<uint8_t> buffer;
+  verifier_deps_->Encode(dex_files_, &buffer);
+  ASSERT_FALSE(buffer.empty());
+  VerifierDeps reference_deps(dex_files_, ArrayRef<const uint8_t>(buffer));
+
+  // Reloading the same dex files stands for an update that changed no class.
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<1> hs(soa.Self());
+  jobject new_loader = LoadDex("VerifierDeps");
+  Handle<mirror::ClassLoader> new_class_loader(
+      hs.NewHandle(soa.Decode<mirror::ClassLoader>(new_loader)));
+  std::vector<const DexFile*> new_dex_files = GetDexFiles(new_loader);
+  ASSERT_EQ(1u, new_dex_files.size());
+  const DexFile& new_dex_file = *new_dex_files[0];
+
+  std::vector<std::map<uint32_t, bool>> unchanged_classes;
+  ASSERT_TRUE(reference_deps.FindUnchangedClasses(
+      new_class_loader, dex_files_, new_dex_files, &unchanged_classes, soa.Self()));
+  ASSERT_EQ(1u, unchanged_classes.size());
+  ASSERT_EQ(new_dex_file.NumClassDefs(), unchanged_classes[0].size());
+
+  // The classes keep their recorded outcome.
+  auto is_verified = [&](const char* descriptor) {
+    const DexFile::TypeId* type_id = new_dex_file.FindTypeId(descriptor);
+    CHECK(type_id != nullptr) << descriptor;
+    const DexFile::ClassDef* class_def =
+        new_dex_file.FindClassDef(new_dex_file.GetIndexForTypeId(*type_id));
+    CHECK(class_def != nullptr) << descriptor;
+    return unchanged_classes[0][new_dex_file.GetIndexForClassDef(*class_def)];
+  };
+  ASSERT_TRUE(is_verified("LMyThread;"));
+  ASSERT_FALSE(is_verified("LMain;"));
+  ASSERT_FALSE(is_verified("LMyVerificationFailure;"));
+
+  // Without fingerprints, nothing is reused.
+  VerifierDeps::DexFileDeps* deps = reference_deps.GetDexFileDeps(*primary_dex_file_);
+  deps->class_fingerprints_.clear();
+  ASSERT_FALSE(reference_deps.FindUnchangedClasses(
+      new_class_loader, dex_files_, new_dex_files, &unchanged_classes, soa.Self()));
+}
+
 TEST_F(VerifierDepsTest, VerifyDeps) {
   VerifyDexFile();
 
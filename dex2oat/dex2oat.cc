@@ -86,6 +86,7 @@
 #include "runtime.h"
 #include "runtime_options.h"
 #include "scoped_thread_state_change-inl.h"
+#include "thread_pool.h"
 #include "utils.h"
 #include "vdex_file.h"
 #include "verifier/verifier_deps.h"
@@ -229,6 +230,11 @@ NO_RETURN static void Usage(const char* fmt, ...) {
   UsageError("      corresponding to the file descriptor specified by --zip-fd.");
   UsageError("      Example: --zip-location=/system/app/Calculator.apk");
   UsageError("");
+  UsageError("  --reference-vdex=<file.vdex>: specifies the vdex file of a previous version of");
+  UsageError("      the dex files. The classes that did not change since, nor did the classes");
+  UsageError("      they depend on, keep their recorded verification instead of being verified.");
+  UsageError("      Example: --reference-vdex=/data/app/com.example-1/oat/arm64/base.vdex");
+  UsageError("");
   UsageError("  --oat-file=<file.oat>: specifies an oat output destination via a filename.");
   UsageError("      Example: --oat-file=/system/framework/boot.oat");
   UsageError("");
@@ -384,6 +390,11 @@ NO_RETURN static void Usage(const char* fmt, ...) {
   UsageError("      Example: --swap-dex-count-threshold=10");
   UsageError("      Default: %zu", kDefaultMinDexFilesForSwap);
   UsageError("");
+  UsageError("  --memory-budget=<size>: specifies the resident set size in bytes above which");
+  UsageError("      the methods are compiled one at a time and the compiler memory is released");
+  UsageError("      between them. Forces the use of swap when a swap file is given.");
+  UsageError("      Example: --memory-budget=1500000000");
+  UsageError("");
   UsageError("  --very-large-app-threshold=<size>: specifies the minimum total dex file size in");
   UsageError("      bytes to consider the input \"very large\" and reduce compilation done.");
   UsageError("      Example: --very-large-app-threshold=100000000");
@@ -407,6 +418,14 @@ NO_RETURN static void Usage(const char* fmt, ...) {
   UsageError("      the default behavior). This option is only meaningful when used with");
   UsageError("      --dump-cfg.");
   UsageError("");
+  UsageError("  --pass-pipeline=<rule>[,<rule>...]: change the optimization pass pipeline.");
+  UsageError("      A rule is <all|aot|jit>:<method-pattern>:<disable|enable|before|after>:<pass>");
+  UsageError("      followed by :<relative-pass> for before/after. '*' in the method pattern");
+  UsageError("      matches any sequence of characters.");
+  UsageError("      Example: --pass-pipeline=all:com.foo.*:disable:loop_peeling");
+  UsageError("");
+  UsageError("  --pass-pipeline-file=<file>: same as --pass-pipeline, with one rule per line.");
+  UsageError("");
   UsageError("  --classpath-dir=<directory-path>: directory used to resolve relative class paths.");
   UsageError("");
   UsageError("  --class-loader-context=<string spec>: a string specifying the intended");
@@ -1203,6 +1222,8 @@ class Dex2Oat FINAL {
         ParseInputVdexFd(option);
       } else if (option.starts_with("--input-vdex=")) {
         input_vdex_ = option.substr(strlen("--input-vdex=")).data();
+      } else if (option.starts_with("--reference-vdex=")) {
+        reference_vdex_ = option.substr(strlen("--reference-vdex=")).data();
       } else if (option.starts_with("--output-vdex=")) {
         output_vdex_ = option.substr(strlen("--output-vdex=")).data();
       } else if (option.starts_with("--output-vdex-fd=")) {
@@ -1886,11 +1907,17 @@ class Dex2Oat FINAL {
       // if the boot image has changed. How exactly we'll know is under
       // experimentation.
       TimingLogger::ScopedTiming time_unquicken("Unquicken", timings_);
-      VdexFile::Unquicken(dex_files_, input_vdex_file_->GetQuickeningInfo());
+      ThreadPool unquicken_thread_pool("Unquicken thread pool",
+                                       thread_count_ > 0 ? thread_count_ - 1 : 0);
+      VdexFile::Unquicken(
+          dex_files_, input_vdex_file_->GetQuickeningInfo(), &unquicken_thread_pool);
     } else {
       // Create the main VerifierDeps, here instead of in the compiler since we want to aggregate
       // the results for all the dex files, not just the results for the current dex file.
       callbacks_->SetVerifierDeps(new verifier::VerifierDeps(dex_files_));
+      if (!reference_vdex_.empty()) {
+        SetupReferenceVdex();
+      }
     }
     // Invoke the compilation.
     if (compile_individually) {
@@ -2121,7 +2148,8 @@ class Dex2Oat FINAL {
 
         // We need to mirror the layout of the ELF file in the compressed debug-info.
         // Therefore PrepareDebugInfo() relies on the SetLoadedSectionSizes() call further above.
-        elf_writer->PrepareDebugInfo(oat_writer->GetMethodDebugInfo());
+        // The compilation is over, the compression of the mini-debug-info can use its threads.
+        elf_writer->PrepareDebugInfo(oat_writer->GetMethodDebugInfo(), thread_count_);
 
         OutputStream*& rodata = rodata_[i];
         DCHECK(rodata != nullptr);
@@ -2340,7 +2368,32 @@ class Dex2Oat FINAL {
   }
 
  private:
+  // Open the reference vdex and the dex files it contains, and hand its VerifierDeps to the
+  // compiler driver. The compilation goes on without them if they cannot be used.
+  void SetupReferenceVdex() {
+    std::string error_msg;
+    reference_vdex_file_ = VdexFile::Open(reference_vdex_,
+                                          /* writable */ false,
+                                          /* low_4gb */ false,
+                                          /* unquicken */ false,
+                                          &error_msg);
+    if (reference_vdex_file_ == nullptr ||
+        !reference_vdex_file_->OpenAllDexFiles(&reference_dex_files_, &error_msg)) {
+      LOG(WARNING) << "Ignoring the reference vdex " << reference_vdex_ << ": " << error_msg;
+      return;
+    }
+    std::vector<const DexFile*> reference_dex_files =
+        MakeNonOwningPointerVector(reference_dex_files_);
+    reference_verifier_deps_.reset(new verifier::VerifierDeps(
+        reference_dex_files, reference_vdex_file_->GetVerifierDepsData()));
+    driver_->SetReferenceVerifierDeps(reference_verifier_deps_.get(), reference_dex_files);
+  }
+
   bool UseSwap(bool is_image, const std::vector<const DexFile*>& dex_files) {
+    if (compiler_options_->GetMemoryBudget() != 0u) {
+      // The memory used by the compilation is bounded, keep the compiled methods out of it.
+      return true;
+    }
     if (is_image) {
       // Don't use swap, we know generation should succeed, and we don't want to slow it down.
       return false;
@@ -2873,6 +2926,10 @@ class Dex2Oat FINAL {
   std::string input_vdex_;
   std::string output_vdex_;
   std::unique_ptr<VdexFile> input_vdex_file_;
+  std::string reference_vdex_;
+  std::unique_ptr<VdexFile> reference_vdex_file_;
+  std::vector<std::unique_ptr<const DexFile>> reference_dex_files_;
+  std::unique_ptr<verifier::VerifierDeps> reference_verifier_deps_;
   std::vector<const char*> dex_filenames_;
   std::vector<const char*> dex_locations_;
   int zip_fd_;
@@ -935,6 +935,7 @@ class CodeItem : public Item {
   uint16_t OutsSize() const { return outs_size_; }
   uint16_t TriesSize() const { return tries_ == nullptr ? 0 : tries_->size(); }
   DebugInfoItem* DebugInfo() const { return debug_info_; }
+  void SetDebugInfo(DebugInfoItem* debug_info) { debug_info_ = debug_info; }
   uint32_t InsnsSize() const { return insns_size_; }
   uint16_t* Insns() const { return insns_.get(); }
   TryItemVector* Tries() const { return tries_.get(); }
@@ -26,9 +26,14 @@
 #include <stdio.h>
 #include <sys/mman.h>  // For the PROT_* and MAP_* constants.
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
+#include <set>
 #include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "android-base/stringprintf.h"
@@ -1535,21 +1540,30 @@ void DexLayout::LayoutStringData(const DexFile* dex_file) {
   const size_t num_strings = header_->GetCollections().StringIds().size();
   std::vector<bool> is_shorty(num_strings, false);
   std::vector<bool> from_hot_method(num_strings, false);
+  // The order in which the hot strings are first referenced, to pack the strings of a method.
+  std::vector<uint32_t> hot_rank(num_strings, 0u);
+  uint32_t next_hot_rank = 0u;
+  auto mark_hot = [&](uint32_t string_index) {
+    if (!from_hot_method[string_index]) {
+      from_hot_method[string_index] = true;
+      hot_rank[string_index] = next_hot_rank++;
+    }
+  };
   for (std::unique_ptr<dex_ir::ClassDef>& class_def : header_->GetCollections().ClassDefs()) {
     // A name of a profile class is probably going to get looked up by ClassTable::Lookup, mark it
     // as hot. Add its super class and interfaces as well, which can be used during initialization.
     const bool is_profile_class =
         info_->ContainsClass(*dex_file, dex::TypeIndex(class_def->ClassType()->GetIndex()));
     if (is_profile_class) {
-      from_hot_method[class_def->ClassType()->GetStringId()->GetIndex()] = true;
+      mark_hot(class_def->ClassType()->GetStringId()->GetIndex());
       const dex_ir::TypeId* superclass = class_def->Superclass();
       if (superclass != nullptr) {
-        from_hot_method[superclass->GetStringId()->GetIndex()] = true;
+        mark_hot(superclass->GetStringId()->GetIndex());
       }
       const dex_ir::TypeList* interfaces = class_def->Interfaces();
       if (interfaces != nullptr) {
         for (const dex_ir::TypeId* interface_type : *interfaces->GetTypeList()) {
-          from_hot_method[interface_type->GetStringId()->GetIndex()] = true;
+          mark_hot(interface_type->GetStringId()->GetIndex());
         }
       }
     }
@@ -1579,20 +1593,20 @@ void DexLayout::LayoutStringData(const DexFile* dex_file) {
         }
         // Add const-strings.
         for (dex_ir::StringId* id : *fixups->StringIds()) {
-          from_hot_method[id->GetIndex()] = true;
+          mark_hot(id->GetIndex());
         }
         // Add field classes, names, and types.
         for (dex_ir::FieldId* id : *fixups->FieldIds()) {
           // TODO: Only visit field ids from static getters and setters.
-          from_hot_method[id->Class()->GetStringId()->GetIndex()] = true;
-          from_hot_method[id->Name()->GetIndex()] = true;
-          from_hot_method[id->Type()->GetStringId()->GetIndex()] = true;
+          mark_hot(id->Class()->GetStringId()->GetIndex());
+          mark_hot(id->Name()->GetIndex());
+          mark_hot(id->Type()->GetStringId()->GetIndex());
         }
         // For clinits, add referenced method classes, names, and protos.
         if (is_clinit) {
           for (dex_ir::MethodId* id : *fixups->MethodIds()) {
-            from_hot_method[id->Class()->GetStringId()->GetIndex()] = true;
-            from_hot_method[id->Name()->GetIndex()] = true;
+            mark_hot(id->Class()->GetStringId()->GetIndex());
+            mark_hot(id->Name()->GetIndex());
             is_shorty[id->Proto()->Shorty()->GetIndex()] = true;
           }
         }
@@ -1620,8 +1634,8 @@ void DexLayout::LayoutStringData(const DexFile* dex_file) {
   VLOG(compiler) << "Hot string data bytes " << hot_bytes << "/" << max_offset - min_offset;
   std::sort(string_ids.begin(),
             string_ids.end(),
-            [&is_shorty, &from_hot_method](const dex_ir::StringId* a,
-                                           const dex_ir::StringId* b) {
+            [&is_shorty, &from_hot_method, &hot_rank](const dex_ir::StringId* a,
+                                                      const dex_ir::StringId* b) {
     const bool a_is_hot = from_hot_method[a->GetIndex()];
     const bool b_is_hot = from_hot_method[b->GetIndex()];
     if (a_is_hot != b_is_hot) {
@@ -1633,6 +1647,10 @@ void DexLayout::LayoutStringData(const DexFile* dex_file) {
     if (a_is_shorty != b_is_shorty) {
       return a_is_shorty < b_is_shorty;
     }
+    // Keep the hot strings in the order they are referenced.
+    if (a_is_hot) {
+      return hot_rank[a->GetIndex()] < hot_rank[b->GetIndex()];
+    }
     // Preserve order.
     return a->DataItem()->GetOffset() < b->DataItem()->GetOffset();
   });
@@ -1653,6 +1671,56 @@ void DexLayout::LayoutStringData(const DexFile* dex_file) {
   }
 }
 
+// Adds to pages the indexes of the pages spanned by size bytes at offset.
+static void AddSpannedPages(uint32_t offset, uint32_t size, std::set<uint32_t>* pages) {
+  if (size == 0u) {
+    return;
+  }
+  for (uint32_t page = offset / kPageSize; page <= (offset + size - 1u) / kPageSize; ++page) {
+    pages->insert(page);
+  }
+}
+
+// Orders code_items by a depth-first walk of the calls between them, given the code items of the
+// methods by method index.
+static std::vector<dex_ir::CodeItem*> OrderCodeItemsByCalls(
+    const std::vector<dex_ir::CodeItem*>& code_items,
+    const std::unordered_map<uint32_t, dex_ir::CodeItem*>& method_code_items) {
+  const std::unordered_set<dex_ir::CodeItem*> code_items_set(code_items.begin(),
+                                                             code_items.end());
+  std::vector<dex_ir::CodeItem*> ordered;
+  std::unordered_set<dex_ir::CodeItem*> visited;
+  std::vector<dex_ir::CodeItem*> worklist;
+  // Depth-first walk of the calls from each code item in the given order.
+  for (dex_ir::CodeItem* root : code_items) {
+    worklist.push_back(root);
+    while (!worklist.empty()) {
+      dex_ir::CodeItem* code_item = worklist.back();
+      worklist.pop_back();
+      if (!visited.insert(code_item).second) {
+        continue;
+      }
+      ordered.push_back(code_item);
+      dex_ir::CodeFixups* fixups = code_item->GetCodeFixups();
+      if (fixups == nullptr) {
+        continue;
+      }
+      // Push in reverse order, for the first callee to be placed first.
+      const std::vector<dex_ir::MethodId*>& callees = *fixups->MethodIds();
+      for (auto it = callees.rbegin(); it != callees.rend(); ++it) {
+        auto callee = method_code_items.find((*it)->GetIndex());
+        if (callee != method_code_items.end() &&
+            code_items_set.find(callee->second) != code_items_set.end() &&
+            visited.find(callee->second) == visited.end()) {
+          worklist.push_back(callee->second);
+        }
+      }
+    }
+  }
+  DCHECK_EQ(ordered.size(), code_items.size());
+  return ordered;
+}
+
 // Orders code items according to specified class data ordering.
 // NOTE: If the section following the code items is byte aligned, the last code item is left in
 // place to preserve alignment. Layout needs an overhaul to handle movement of other sections.
@@ -1730,29 +1798,76 @@ int32_t DexLayout::LayoutCodeItems(const DexFile* dex_file,
     }
   }
 
+  // The code items of the methods defined in this dex file, to follow the calls between them.
+  std::unordered_map<uint32_t, dex_ir::CodeItem*> method_code_items;
+  for (dex_ir::ClassData* data : new_class_data_order) {
+    for (InvokeType invoke_type : invoke_types) {
+      for (auto& method : *(invoke_type == InvokeType::kDirect
+                                ? data->DirectMethods()
+                                : data->VirtualMethods())) {
+        if (method->GetCodeItem() != nullptr) {
+          method_code_items.emplace(method->GetMethodId()->GetIndex(), method->GetCodeItem());
+        }
+      }
+    }
+  }
+
   // Total_diff includes diffs generated by clinits, executed, and non-executed methods.
   int32_t total_diff = 0;
+  // The pages spanned by the code items of the startup methods, before and after the layout.
+  std::set<uint32_t> startup_pages_before;
+  std::set<uint32_t> startup_pages_after;
   // The relative placement has no effect on correctness; it is used to ensure
   // the layout is deterministic
   for (size_t index = 0; index < num_layout_types; ++index) {
     const std::unordered_set<dex_ir::CodeItem*>& code_items_set = code_items[index];
+    // The code items in class data order.
+    std::vector<dex_ir::CodeItem*> ordered_code_items;
+    std::unordered_set<dex_ir::CodeItem*> ordered_set;
+    for (dex_ir::ClassData* data : new_class_data_order) {
+      for (InvokeType invoke_type : invoke_types) {
+        for (auto& method : *(invoke_type == InvokeType::kDirect
+                                  ? data->DirectMethods()
+                                  : data->VirtualMethods())) {
+          dex_ir::CodeItem* code_item = method->GetCodeItem();
+          if (code_item != nullptr &&
+              code_items_set.find(code_item) != code_items_set.end() &&
+              ordered_set.insert(code_item).second) {
+            ordered_code_items.push_back(code_item);
+          }
+        }
+      }
+    }
+    const bool is_executed = index == static_cast<size_t>(LayoutType::kLayoutTypeHot) ||
+        index == static_cast<size_t>(LayoutType::kLayoutTypeStartupOnly);
+    if (is_executed) {
+      // Place the executed code items in call order, the callees of the bucket after their first
+      // caller, for a call path to touch as few pages as possible.
+      ordered_code_items = OrderCodeItemsByCalls(ordered_code_items, method_code_items);
+    }
+    std::unordered_map<dex_ir::CodeItem*, uint32_t> old_offsets;
+    const uint32_t start_offset = code_item_offset;
+    for (dex_ir::CodeItem* code_item : ordered_code_items) {
+      old_offsets.emplace(code_item, code_item->GetOffset());
+      if (is_executed) {
+        AddSpannedPages(code_item->GetOffset(), code_item->GetSize(), &startup_pages_before);
+        AddSpannedPages(code_item_offset, code_item->GetSize(), &startup_pages_after);
+      }
+      code_item->SetOffset(code_item_offset);
+      code_item_offset += RoundUp(code_item->GetSize(), kDexCodeItemAlignment);
+    }
+    // The class data encode the code item offsets in ULEB128, whose size may have changed.
     // diff is reset for each class of code items.
     int32_t diff = 0;
-    const uint32_t start_offset = code_item_offset;
     for (dex_ir::ClassData* data : new_class_data_order) {
       data->SetOffset(data->GetOffset() + diff);
       for (InvokeType invoke_type : invoke_types) {
-        for (auto &method : *(invoke_type == InvokeType::kDirect
+        for (auto& method : *(invoke_type == InvokeType::kDirect
                                   ? data->DirectMethods()
                                   : data->VirtualMethods())) {
-          dex_ir::CodeItem* code_item = method->GetCodeItem();
-          if (code_item != nullptr &&
-              code_items_set.find(code_item) != code_items_set.end()) {
-            diff += UnsignedLeb128Size(code_item_offset)
-                - UnsignedLeb128Size(code_item->GetOffset());
-            code_item->SetOffset(code_item_offset);
-            code_item_offset +=
-                RoundUp(code_item->GetSize(), kDexCodeItemAlignment);
+          auto it = old_offsets.find(method->GetCodeItem());
+          if (it != old_offsets.end()) {
+            diff += UnsignedLeb128Size(it->first->GetOffset()) - UnsignedLeb128Size(it->second);
           }
         }
       }
@@ -1767,6 +1882,8 @@ int32_t DexLayout::LayoutCodeItems(const DexFile* dex_file,
     }
     total_diff += diff;
   }
+  VLOG(dex) << "Startup code item pages " << startup_pages_before.size() << " before layout, "
+            << startup_pages_after.size() << " after";
   // Adjust diff to be 4-byte aligned.
   return RoundUp(total_diff, kDexCodeItemAlignment);
 }
@@ -1874,6 +1991,111 @@ void DexLayout::FixupSections(uint32_t offset, uint32_t diff) {
   }
 }
 
+// Returns whether the debug info items have the same contents, decoded for their methods too.
+static bool SameDebugInfo(dex_ir::DebugInfoItem* a, dex_ir::DebugInfoItem* b) {
+  if (a->GetDebugInfoSize() != b->GetDebugInfoSize() ||
+      memcmp(a->GetDebugInfo(), b->GetDebugInfo(), a->GetDebugInfoSize()) != 0 ||
+      a->GetPositionInfo().size() != b->GetPositionInfo().size() ||
+      a->GetLocalInfo().size() != b->GetLocalInfo().size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a->GetPositionInfo().size(); ++i) {
+    const dex_ir::PositionInfo& a_position = *a->GetPositionInfo()[i];
+    const dex_ir::PositionInfo& b_position = *b->GetPositionInfo()[i];
+    if (a_position.address_ != b_position.address_ || a_position.line_ != b_position.line_) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < a->GetLocalInfo().size(); ++i) {
+    const dex_ir::LocalInfo& a_local = *a->GetLocalInfo()[i];
+    const dex_ir::LocalInfo& b_local = *b->GetLocalInfo()[i];
+    if (a_local.name_ != b_local.name_ ||
+        a_local.descriptor_ != b_local.descriptor_ ||
+        a_local.signature_ != b_local.signature_ ||
+        a_local.start_address_ != b_local.start_address_ ||
+        a_local.end_address_ != b_local.end_address_ ||
+        a_local.reg_ != b_local.reg_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Shares one debug info item between the code items whose debug info items have the same
+// contents, and packs the remaining items at the start of their section. The sections after it
+// move by a multiple of 4 bytes, for their items to stay aligned.
+// NOTE: The locals of a debug info stream are decoded with the signature of its method, the
+// items are only shared when they decode the same, for the output to verify as the input.
+void DexLayout::DedupeDebugInfoItems() {
+  dex_ir::Collections& collections = header_->GetCollections();
+  std::map<uint32_t, std::unique_ptr<dex_ir::DebugInfoItem>>& debug_info_items =
+      collections.DebugInfoItems();
+  if (debug_info_items.empty()) {
+    return;
+  }
+  // The map is keyed by the offsets of the input file, the layout may have moved the items.
+  std::vector<dex_ir::DebugInfoItem*> ordered_items;
+  for (auto& debug_info_pair : debug_info_items) {
+    ordered_items.push_back(debug_info_pair.second.get());
+  }
+  std::sort(ordered_items.begin(),
+            ordered_items.end(),
+            [](dex_ir::DebugInfoItem* a, dex_ir::DebugInfoItem* b) {
+              return a->GetOffset() < b->GetOffset();
+            });
+  const uint32_t section_offset = collections.DebugInfoItemsOffset();
+  const uint32_t section_end =
+      ordered_items.back()->GetOffset() + ordered_items.back()->GetDebugInfoSize();
+
+  // The kept items by contents, and the item replacing each duplicate.
+  std::unordered_map<std::string, std::vector<dex_ir::DebugInfoItem*>> kept_items;
+  std::unordered_map<dex_ir::DebugInfoItem*, dex_ir::DebugInfoItem*> replacements;
+  uint32_t offset = section_offset;
+  for (dex_ir::DebugInfoItem* debug_info : ordered_items) {
+    std::vector<dex_ir::DebugInfoItem*>& same_bytes = kept_items[std::string(
+        reinterpret_cast<const char*>(debug_info->GetDebugInfo()),
+        debug_info->GetDebugInfoSize())];
+    auto kept = std::find_if(same_bytes.begin(),
+                             same_bytes.end(),
+                             [debug_info](dex_ir::DebugInfoItem* item) {
+                               return SameDebugInfo(item, debug_info);
+                             });
+    if (kept != same_bytes.end()) {
+      replacements.emplace(debug_info, *kept);
+      continue;
+    }
+    same_bytes.push_back(debug_info);
+    debug_info->SetOffset(offset);
+    offset += debug_info->GetDebugInfoSize();
+  }
+  if (replacements.empty()) {
+    return;
+  }
+
+  for (auto& code_item_pair : collections.CodeItems()) {
+    dex_ir::CodeItem* code_item = code_item_pair.second.get();
+    auto it = replacements.find(code_item->DebugInfo());
+    if (it != replacements.end()) {
+      code_item->SetDebugInfo(it->second);
+    }
+  }
+  for (auto it = debug_info_items.begin(); it != debug_info_items.end();) {
+    if (replacements.find(it->second.get()) != replacements.end()) {
+      it = debug_info_items.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  const uint32_t diff = RoundDown(section_end - offset, kDexCodeItemAlignment);
+  VLOG(dex) << "Shared " << replacements.size() << " debug info items, saving " << diff
+            << " bytes";
+  // Move the sections after the debug info items back by diff bytes.
+  FixupSections(section_offset, -diff);
+  header_->SetFileSize(header_->FileSize() - diff);
+  header_->SetDataSize(header_->DataSize() - diff);
+}
+
 void DexLayout::LayoutOutputFile(const DexFile* dex_file) {
   LayoutStringData(dex_file);
   std::vector<dex_ir::ClassData*> new_class_data_order = LayoutClassDefsAndClassData(dex_file);
@@ -1981,6 +2203,9 @@ void DexLayout::ProcessDexFile(const char* file_name,
     if (info_ != nullptr) {
       LayoutOutputFile(dex_file);
     }
+    if (options_.dedupe_debug_info_) {
+      DedupeDebugInfoItems();
+    }
     OutputDexFile(dex_file);
   }
 }
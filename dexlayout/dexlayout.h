@@ -50,6 +50,7 @@ class Options {
   bool dump_ = false;
   bool build_dex_ir_ = false;
   bool checksum_only_ = false;
+  bool dedupe_debug_info_ = false;
   bool disassemble_ = false;
   bool exports_only_ = false;
   bool ignore_bad_checksum_ = false;
@@ -119,6 +120,7 @@ class DexLayout {
   bool IsNextSectionCodeItemAligned(uint32_t offset);
   template<class T> void FixupSection(std::map<uint32_t, std::unique_ptr<T>>& map, uint32_t diff);
   void FixupSections(uint32_t offset, uint32_t diff);
+  void DedupeDebugInfoItems();
 
   // Creates a new layout for the dex file based on profile info.
   // Currently reorders ClassDefs, ClassDataItems, and CodeItems.
@@ -671,4 +671,36 @@ TEST_F(DexLayoutTest, DuplicateCodeItem) {
                             dexlayout_exec_argv));
 }
 
+TEST_F(DexLayoutTest, DedupeDebugInfo) {
+  // Disable test on target.
+  TEST_DISABLED_FOR_TARGET();
+  ScratchFile tmp_file;
+  const std::string& tmp_name = tmp_file.GetFilename();
+  size_t tmp_last_slash = tmp_name.rfind('/');
+  std::string tmp_dir = tmp_name.substr(0, tmp_last_slash + 1);
+  std::string dexlayout = GetTestAndroidRoot() + "/bin/dexlayout";
+  EXPECT_TRUE(OS::FileExists(dexlayout.c_str())) << dexlayout << " should be a valid file path";
+
+  for (const std::string& dex_file : GetLibCoreDexFileNames()) {
+    std::string error_msg;
+    // -v makes sure that sharing the debug info items did not change the methods.
+    std::vector<std::string> dexlayout_exec_argv =
+        { dexlayout, "-u", "-v", "-w", tmp_dir, "-o", tmp_name, dex_file };
+    ASSERT_TRUE(::art::Exec(dexlayout_exec_argv, &error_msg)) << error_msg;
+    std::vector<std::string> unzip_exec_argv =
+        { "/usr/bin/unzip", dex_file, "classes.dex", "-d", tmp_dir };
+    ASSERT_TRUE(::art::Exec(unzip_exec_argv, &error_msg)) << error_msg;
+
+    std::string output_dex = tmp_dir + dex_file.substr(dex_file.rfind('/') + 1);
+    std::unique_ptr<File> input(OS::OpenFileForReading((tmp_dir + "classes.dex").c_str()));
+    std::unique_ptr<File> output(OS::OpenFileForReading(output_dex.c_str()));
+    ASSERT_TRUE(input != nullptr);
+    ASSERT_TRUE(output != nullptr);
+    EXPECT_LE(output->GetLength(), input->GetLength());
+
+    std::vector<std::string> rm_exec_argv = { "/bin/rm", tmp_dir + "classes.dex", output_dex };
+    ASSERT_TRUE(::art::Exec(rm_exec_argv, &error_msg)) << error_msg;
+  }
+}
+
 }  // namespace art
@@ -17,16 +17,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 #include <set>
 #include <map>
 #include <unordered_set>
 
+#include "android-base/file.h"
 #include "android-base/stringprintf.h"
+#include "android-base/strings.h"
 
 #include "art_field-inl.h"
 #include "art_method-inl.h"
@@ -1629,6 +1633,262 @@ class ImgDiagDumper {
   DISALLOW_COPY_AND_ASSIGN(ImgDiagDumper);
 };
 
+// Compares the boot image of many children of the zygote against the zygote, and ranks the
+// classes by the number of children which dirtied them. Only the pages which differ from the
+// zygote are walked, and the page flags of the kernel are not read: a child dirties a page of
+// the image privately when it makes it differ from the zygote.
+class DirtyClassSampler {
+ public:
+  DirtyClassSampler(std::ostream* os,
+                    const ImageHeader& image_header,
+                    const std::string& image_location,
+                    pid_t zygote_pid,
+                    const std::vector<pid_t>& sample_pids)
+      : os_(os),
+        image_header_(image_header),
+        image_location_(image_location),
+        zygote_pid_(zygote_pid),
+        sample_pids_(sample_pids),
+        sampled_processes_(0u) {}
+
+  bool Init() {
+    std::ostream& os = *os_;
+    std::unique_ptr<BacktraceMap> proc_maps(BacktraceMap::Create(zygote_pid_));
+    if (proc_maps == nullptr) {
+      os << "Could not read backtrace maps";
+      return false;
+    }
+    const std::string image_name = image_location_.substr(image_location_.rfind('/') + 1u);
+    bool found_boot_map = false;
+    for (const backtrace_map_t& map : *proc_maps) {
+      // The children of the zygote map the image at the same address, only the write-able map
+      // can differ between them.
+      if (android::base::EndsWith(map.name, image_name) && (map.flags & PROT_WRITE) != 0) {
+        boot_map_ = map;
+        found_boot_map = true;
+        break;
+      }
+    }
+    if (!found_boot_map) {
+      os << "Could not find map for " << image_name;
+      return false;
+    }
+    if (reinterpret_cast<uintptr_t>(image_header_.GetImageBegin()) != boot_map_.start) {
+      os << "Remote boot map " << reinterpret_cast<const void*>(boot_map_.start)
+         << " does not start at the local image " << image_header_.GetImageBegin();
+      return false;
+    }
+    std::string error_msg;
+    if (!ReadImageContents(zygote_pid_, &zygote_contents_, &error_msg)) {
+      os << error_msg;
+      return false;
+    }
+    return true;
+  }
+
+  // Sample the processes, and append to dirty_image_objects the classes with dirty static
+  // fields, in the format of dex2oat --dirty-image-objects. dex2oat places these classes
+  // together in the image, away from the classes which stay clean.
+  bool Dump(std::string* dirty_image_objects) REQUIRES_SHARED(Locks::mutator_lock_) {
+    std::ostream& os = *os_;
+    os << "IMAGE LOCATION: " << image_location_ << "\n\n";
+    // Read the images of the children in parallel, a batch at a time to bound the memory used.
+    const size_t batch_size = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t first = 0; first < sample_pids_.size(); first += batch_size) {
+      const size_t count = std::min(batch_size, sample_pids_.size() - first);
+      std::vector<std::vector<uint8_t>> contents(count);
+      std::vector<std::string> error_msgs(count);
+      std::unique_ptr<bool[]> read_ok(new bool[count]);
+      std::vector<std::thread> threads;
+      for (size_t i = 0; i < count; ++i) {
+        threads.emplace_back([&, i]() {
+          read_ok[i] = ReadImageContents(sample_pids_[first + i], &contents[i], &error_msgs[i]);
+        });
+      }
+      for (std::thread& thread : threads) {
+        thread.join();
+      }
+      for (size_t i = 0; i < count; ++i) {
+        if (!read_ok[i]) {
+          // The process may have exited since it was listed, sample the others.
+          LOG(WARNING) << error_msgs[i];
+          continue;
+        }
+        SampleProcess(contents[i]);
+        std::vector<uint8_t>().swap(contents[i]);
+      }
+    }
+    if (sampled_processes_ == 0u) {
+      os << "No process could be sampled\n";
+      return false;
+    }
+
+    os << "SAMPLED PROCESSES: " << sampled_processes_ << "\n\n";
+    os << "Classes with private dirty static fields, by processes:\n";
+    DumpClassData(class_objects_);
+    os << "\nClasses with private dirty instances, by processes:\n";
+    DumpClassData(instance_classes_);
+    os << std::flush;
+
+    for (const ClassData* data : RankClassData(class_objects_)) {
+      *dirty_image_objects += StringPrintf("# %zu/%zu processes\n",
+                                           data->dirty_processes,
+                                           sampled_processes_);
+      *dirty_image_objects += data->pretty_descriptor + "\n";
+    }
+    return true;
+  }
+
+ private:
+  struct ClassData {
+    std::string pretty_descriptor;
+    // The number of sampled processes which dirtied the class.
+    size_t dirty_processes = 0u;
+    size_t dirty_objects = 0u;
+    size_t dirty_bytes = 0u;
+    // The number of sampled processes which dirtied each field.
+    std::map<ArtField*, size_t> dirty_fields;
+  };
+
+  bool ReadImageContents(pid_t pid,
+                         std::vector<uint8_t>* contents,
+                         std::string* error_msg) const {
+    std::string file_name = StringPrintf("/proc/%ld/mem", static_cast<long>(pid));  // NOLINT
+    std::unique_ptr<File> file(OS::OpenFileForReading(file_name.c_str()));
+    if (file == nullptr) {
+      *error_msg = "Failed to open " + file_name + " for reading";
+      return false;
+    }
+    contents->resize(boot_map_.end - boot_map_.start);
+    if (!file->PreadFully(contents->data(), contents->size(), boot_map_.start)) {
+      *error_msg = "Could not fully read file " + file_name;
+      return false;
+    }
+    return true;
+  }
+
+  void SampleProcess(const std::vector<uint8_t>& contents)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    ++sampled_processes_;
+    std::vector<bool> different_pages(contents.size() / kPageSize, false);
+    bool any_different = false;
+    for (size_t page = 0; page != different_pages.size(); ++page) {
+      if (memcmp(&contents[page * kPageSize], &zygote_contents_[page * kPageSize], kPageSize) !=
+          0) {
+        different_pages[page] = true;
+        any_different = true;
+      }
+    }
+    if (!any_different) {
+      return;
+    }
+    std::set<ClassData*> dirty_classes;
+    std::set<std::pair<ClassData*, ArtField*>> dirty_fields;
+    const uint8_t* image_begin = image_header_.GetImageBegin();
+    auto visit_object = [&](mirror::Object* object,
+                            const uint8_t* begin ATTRIBUTE_UNUSED,
+                            const std::set<size_t>& pages ATTRIBUTE_UNUSED)
+        REQUIRES_SHARED(Locks::mutator_lock_) {
+      const size_t offset = reinterpret_cast<uint8_t*>(object) - image_begin;
+      const size_t size = object->SizeOf();
+      bool on_different_page = false;
+      for (size_t page = offset / kPageSize; page <= (offset + size - 1u) / kPageSize; ++page) {
+        on_different_page = on_different_page || different_pages[page];
+      }
+      if (!on_different_page ||
+          memcmp(&contents[offset], &zygote_contents_[offset], size) == 0) {
+        return;
+      }
+      // Static fields dirty their class object, which dex2oat can move, other fields dirty an
+      // instance of their class.
+      mirror::Class* klass = object->GetClass();
+      std::set<ClassData*> object_classes;
+      for (size_t i = 0; i < size; ++i) {
+        if (contents[offset + i] == zygote_contents_[offset + i]) {
+          continue;
+        }
+        mirror::Class* owner = klass;
+        std::map<mirror::Class*, ClassData>* class_data = &instance_classes_;
+        ArtField* field = ArtField::FindInstanceFieldWithOffset</*exact*/false>(klass, i);
+        if (field == nullptr && object->IsClass()) {
+          ArtField* static_field =
+              ArtField::FindStaticFieldWithOffset</*exact*/false>(object->AsClass(), i);
+          if (static_field != nullptr) {
+            field = static_field;
+            owner = object->AsClass();
+            class_data = &class_objects_;
+          }
+        }
+        ClassData* data = &(*class_data)[owner];
+        if (data->pretty_descriptor.empty()) {
+          data->pretty_descriptor = owner->PrettyDescriptor();
+        }
+        if (dirty_classes.insert(data).second) {
+          ++data->dirty_processes;
+        }
+        if (object_classes.insert(data).second) {
+          ++data->dirty_objects;
+        }
+        ++data->dirty_bytes;
+        if (field != nullptr && dirty_fields.emplace(data, field).second) {
+          ++data->dirty_fields[field];
+        }
+      }
+    };
+    ImgObjectVisitor visitor(visit_object, image_begin, empty_page_set_);
+    PointerSize pointer_size = InstructionSetPointerSize(Runtime::Current()->GetInstructionSet());
+    image_header_.VisitObjects(&visitor, const_cast<uint8_t*>(image_begin), pointer_size);
+  }
+
+  static std::vector<const ClassData*> RankClassData(
+      const std::map<mirror::Class*, ClassData>& class_data) {
+    std::vector<const ClassData*> ranked;
+    for (const auto& entry : class_data) {
+      if (entry.second.dirty_processes != 0u) {
+        ranked.push_back(&entry.second);
+      }
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const ClassData* a, const ClassData* b) {
+      return a->dirty_processes != b->dirty_processes
+          ? a->dirty_processes > b->dirty_processes
+          : a->dirty_bytes > b->dirty_bytes;
+    });
+    return ranked;
+  }
+
+  void DumpClassData(const std::map<mirror::Class*, ClassData>& class_data)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    std::ostream& os = *os_;
+    for (const ClassData* data : RankClassData(class_data)) {
+      os << "  " << data->pretty_descriptor << " ("
+         << "processes: " << data->dirty_processes << ", "
+         << "dirty objects: " << data->dirty_objects << ", "
+         << "dirty bytes: " << data->dirty_bytes << ")\n";
+      for (const auto& field : data->dirty_fields) {
+        os << "    " << ArtField::PrettyField(field.first) << " (processes: " << field.second
+           << ")\n";
+      }
+    }
+  }
+
+  std::ostream* os_;
+  const ImageHeader& image_header_;
+  const std::string image_location_;
+  const pid_t zygote_pid_;
+  const std::vector<pid_t> sample_pids_;
+  // The write-able mapping of the image in the zygote and its children.
+  backtrace_map_t boot_map_{};  // NOLINT
+  std::vector<uint8_t> zygote_contents_;
+  const std::set<size_t> empty_page_set_;
+  size_t sampled_processes_;
+  // The dirty class objects, by class.
+  std::map<mirror::Class*, ClassData> class_objects_;
+  // The dirty instances, by class.
+  std::map<mirror::Class*, ClassData> instance_classes_;
+
+  DISALLOW_COPY_AND_ASSIGN(DirtyClassSampler);
+};
+
 static int DumpImage(Runtime* runtime,
                      std::ostream* os,
                      pid_t image_diff_pid,
@@ -1661,6 +1921,40 @@ static int DumpImage(Runtime* runtime,
   return EXIT_SUCCESS;
 }
 
+static int SampleDirtyClasses(Runtime* runtime,
+                              std::ostream* os,
+                              pid_t zygote_pid,
+                              const std::vector<pid_t>& sample_pids,
+                              const std::string& dirty_image_objects_output) {
+  ScopedObjectAccess soa(Thread::Current());
+  gc::Heap* heap = runtime->GetHeap();
+  std::vector<gc::space::ImageSpace*> image_spaces = heap->GetBootImageSpaces();
+  CHECK(!image_spaces.empty());
+  // dex2oat reads the dirty classes of all the boot images from one list.
+  std::string dirty_image_objects;
+  for (gc::space::ImageSpace* image_space : image_spaces) {
+    const ImageHeader& image_header = image_space->GetImageHeader();
+    if (!image_header.IsValid()) {
+      fprintf(stderr, "Invalid image header %s\n", image_space->GetImageLocation().c_str());
+      return EXIT_FAILURE;
+    }
+    DirtyClassSampler sampler(os,
+                              image_header,
+                              image_space->GetImageLocation(),
+                              zygote_pid,
+                              sample_pids);
+    if (!sampler.Init() || !sampler.Dump(&dirty_image_objects)) {
+      return EXIT_FAILURE;
+    }
+  }
+  if (!dirty_image_objects_output.empty() &&
+      !android::base::WriteStringToFile(dirty_image_objects, dirty_image_objects_output)) {
+    fprintf(stderr, "Failed to write %s\n", dirty_image_objects_output.c_str());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
 struct ImgDiagArgs : public CmdlineArgs {
  protected:
   using Base = CmdlineArgs;
@@ -1690,6 +1984,19 @@ struct ImgDiagArgs : public CmdlineArgs {
       }
     } else if (option == "--dump-dirty-objects") {
       dump_dirty_objects_ = true;
+    } else if (option.starts_with("--sample-pids=")) {
+      for (const std::string& pid_str :
+           android::base::Split(option.substr(strlen("--sample-pids=")).ToString(), ",")) {
+        pid_t pid;
+        if (!ParseInt(pid_str.c_str(), &pid)) {
+          *error_msg = "Sample pid out of range";
+          return kParseError;
+        }
+        sample_pids_.push_back(pid);
+      }
+    } else if (option.starts_with("--dirty-image-objects-output=")) {
+      dirty_image_objects_output_ =
+          option.substr(strlen("--dirty-image-objects-output=")).ToString();
     } else {
       return kParseUnknownArgument;
     }
@@ -1706,16 +2013,21 @@ struct ImgDiagArgs : public CmdlineArgs {
 
     // Perform our own checks.
 
-    if (kill(image_diff_pid_,
-             /*sig*/0) != 0) {  // No signal is sent, perform error-checking only.
-      // Check if the pid exists before proceeding.
-      if (errno == ESRCH) {
-        *error_msg = "Process specified does not exist";
-      } else {
-        *error_msg = StringPrintf("Failed to check process status: %s", strerror(errno));
+    if (!sample_pids_.empty()) {
+      if (zygote_diff_pid_ < 0) {
+        *error_msg = "--sample-pids requires --zygote-diff-pid";
+        return kParseError;
       }
+      if (!CheckProcessExists(zygote_diff_pid_, error_msg)) {
+        return kParseError;
+      }
+    } else if (!dirty_image_objects_output_.empty()) {
+      *error_msg = "--dirty-image-objects-output requires --sample-pids";
       return kParseError;
-    } else if (instruction_set_ != kRuntimeISA) {
+    } else if (!CheckProcessExists(image_diff_pid_, error_msg)) {
+      return kParseError;
+    }
+    if (instruction_set_ != kRuntimeISA) {
       // Don't allow different ISAs since the images are ISA-specific.
       // Right now the code assumes both the runtime ISA and the remote ISA are identical.
       *error_msg = "Must use the default runtime ISA; changing ISA is not supported.";
@@ -1725,6 +2037,19 @@ struct ImgDiagArgs : public CmdlineArgs {
     return kParseOk;
   }
 
+  static bool CheckProcessExists(pid_t pid, std::string* error_msg) {
+    if (kill(pid, /*sig*/0) != 0) {  // No signal is sent, perform error-checking only.
+      // Check if the pid exists before proceeding.
+      if (errno == ESRCH) {
+        *error_msg = "Process specified does not exist";
+      } else {
+        *error_msg = StringPrintf("Failed to check process status: %s", strerror(errno));
+      }
+      return false;
+    }
+    return true;
+  }
+
   virtual std::string GetUsage() const {
     std::string usage;
 
@@ -1743,6 +2068,12 @@ struct ImgDiagArgs : public CmdlineArgs {
         "against.\n"
         "      Example: --zygote-diff-pid=$(pid zygote)\n"
         "  --dump-dirty-objects: additionally output dirty objects of interest.\n"
+        "  --sample-pids=<pid>,...: rank the classes of the boot image by the number of the\n"
+        "      given children of the zygote which dirtied them, instead of diffing one process.\n"
+        "      Requires --zygote-diff-pid.\n"
+        "      Example: --sample-pids=$(pidof com.example.a),$(pidof com.example.b)\n"
+        "  --dirty-image-objects-output=<file>: with --sample-pids, write the classes with dirty\n"
+        "      static fields to the file, in the format of dex2oat --dirty-image-objects.\n"
         "\n";
 
     return usage;
@@ -1752,12 +2083,21 @@ struct ImgDiagArgs : public CmdlineArgs {
   pid_t image_diff_pid_ = -1;
   pid_t zygote_diff_pid_ = -1;
   bool dump_dirty_objects_ = false;
+  std::vector<pid_t> sample_pids_;
+  std::string dirty_image_objects_output_;
 };
 
 struct ImgDiagMain : public CmdlineMain<ImgDiagArgs> {
   virtual bool ExecuteWithRuntime(Runtime* runtime) {
     CHECK(args_ != nullptr);
 
+    if (!args_->sample_pids_.empty()) {
+      return SampleDirtyClasses(runtime,
+                                args_->os_,
+                                args_->zygote_diff_pid_,
+                                args_->sample_pids_,
+                                args_->dirty_image_objects_output_) == EXIT_SUCCESS;
+    }
     return DumpImage(runtime,
                      args_->os_,
                      args_->image_diff_pid_,
@@ -17,11 +17,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -320,6 +323,7 @@ class OatDumperOptions {
                    bool list_classes,
                    bool list_methods,
                    bool dump_header_only,
+                   bool stats_only,
                    const char* export_dex_location,
                    const char* app_image,
                    const char* app_oat,
@@ -333,6 +337,7 @@ class OatDumperOptions {
       list_classes_(list_classes),
       list_methods_(list_methods),
       dump_header_only_(dump_header_only),
+      stats_only_(stats_only),
       export_dex_location_(export_dex_location),
       app_image_(app_image),
       app_oat_(app_oat),
@@ -348,6 +353,7 @@ class OatDumperOptions {
   const bool list_classes_;
   const bool list_methods_;
   const bool dump_header_only_;
+  const bool stats_only_;
   const char* const export_dex_location_;
   const char* const app_image_;
   const char* const app_oat_;
@@ -387,6 +393,9 @@ class OatDumper {
   }
 
   bool Dump(std::ostream& os) {
+    if (options_.stats_only_) {
+      return DumpCodeSizeStats(os);
+    }
     bool success = true;
     const OatHeader& oat_header = oat_file_.GetOatHeader();
 
@@ -561,6 +570,133 @@ class OatDumper {
     return success;
   }
 
+  // Write the code size of the compiled methods as one line of JSON, for tools tracking the size
+  // of the code across builds. The methods are not disassembled and the stats are not collected,
+  // the classes of each dex file are walked by several threads.
+  bool DumpCodeSizeStats(std::ostream& os) {
+    struct MethodCodeSize {
+      std::string name;
+      uint32_t code_offset;
+      uint32_t code_size;
+    };
+
+    bool success = true;
+    std::unordered_set<uint32_t> oat_code_offsets;
+    size_t oat_code_size = 0u;
+    size_t oat_num_methods = 0u;
+    os << "{\"location\":\"" << JsonEscape(oat_file_.GetLocation()) << "\""
+       << ",\"isa\":\"" << GetInstructionSetString(instruction_set_) << "\""
+       << ",\"dex_files\":[";
+    for (size_t i = 0; i < oat_dex_files_.size(); i++) {
+      const OatFile::OatDexFile* oat_dex_file = oat_dex_files_[i];
+      CHECK(oat_dex_file != nullptr);
+      std::string error_msg;
+      const DexFile* const dex_file = OpenDexFile(oat_dex_file, &error_msg);
+      if (dex_file == nullptr) {
+        LOG(ERROR) << "Failed to open dex file '" << oat_dex_file->GetDexFileLocation() << "': "
+                   << error_msg;
+        success = false;
+        continue;
+      }
+
+      // Each thread takes the next class, and records its compiled methods in its own vector.
+      const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+      std::vector<std::vector<MethodCodeSize>> thread_methods(num_threads);
+      std::atomic<size_t> next_class_def(0u);
+      auto walk_classes = [&](std::vector<MethodCodeSize>* methods) {
+        for (size_t class_def_index = next_class_def.fetch_add(1u);
+             class_def_index < dex_file->NumClassDefs();
+             class_def_index = next_class_def.fetch_add(1u)) {
+          const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
+          const char* descriptor = dex_file->GetClassDescriptor(class_def);
+          const uint8_t* class_data = dex_file->GetClassData(class_def);
+          if (class_data == nullptr ||
+              DescriptorToDot(descriptor).find(options_.class_filter_) == std::string::npos) {
+            continue;
+          }
+          const OatFile::OatClass oat_class = oat_dex_file->GetOatClass(class_def_index);
+          ClassDataItemIterator it(*dex_file, class_data);
+          it.SkipAllFields();
+          for (uint32_t class_method_index = 0; it.HasNext(); ++class_method_index) {
+            const uint32_t dex_method_idx = it.GetMemberIndex();
+            it.Next();
+            const OatFile::OatMethod oat_method = oat_class.GetOatMethod(class_method_index);
+            const uint32_t code_size = oat_method.GetQuickCodeSize();
+            if (code_size == 0u) {
+              continue;
+            }
+            std::string method_name =
+                dex_file->GetMethodName(dex_file->GetMethodId(dex_method_idx));
+            if (method_name.find(options_.method_filter_) == std::string::npos) {
+              continue;
+            }
+            methods->push_back({ dex_file->PrettyMethod(dex_method_idx, true),
+                                 oat_method.GetCodeOffset(),
+                                 code_size });
+          }
+        }
+      };
+      std::vector<std::thread> threads;
+      for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(walk_classes, &thread_methods[t]);
+      }
+      walk_classes(&thread_methods[0]);
+      for (std::thread& thread : threads) {
+        thread.join();
+      }
+
+      // Sort the methods by name for the output of two builds to be compared line by line.
+      std::vector<MethodCodeSize> methods;
+      for (std::vector<MethodCodeSize>& t_methods : thread_methods) {
+        for (MethodCodeSize& method : t_methods) {
+          methods.push_back(std::move(method));
+        }
+      }
+      std::sort(methods.begin(),
+                methods.end(),
+                [](const MethodCodeSize& a, const MethodCodeSize& b) { return a.name < b.name; });
+      // Deduplicated code is counted once in the code size of the dex file and of the oat file.
+      std::unordered_set<uint32_t> code_offsets;
+      size_t code_size = 0u;
+      os << (i != 0u ? "," : "")
+         << "{\"location\":\"" << JsonEscape(oat_dex_file->GetDexFileLocation()) << "\""
+         << ",\"methods\":[";
+      for (size_t m = 0; m < methods.size(); ++m) {
+        const MethodCodeSize& method = methods[m];
+        if (code_offsets.insert(method.code_offset).second) {
+          code_size += method.code_size;
+        }
+        if (oat_code_offsets.insert(method.code_offset).second) {
+          oat_code_size += method.code_size;
+        }
+        os << (m != 0u ? "," : "")
+           << "{\"name\":\"" << JsonEscape(method.name) << "\",\"size\":" << method.code_size
+           << "}";
+      }
+      os << "],\"compiled_methods\":" << methods.size() << ",\"code_size\":" << code_size << "}";
+      oat_num_methods += methods.size();
+    }
+    os << "],\"compiled_methods\":" << oat_num_methods << ",\"code_size\":" << oat_code_size
+       << "}\n";
+    os << std::flush;
+    return success;
+  }
+
+  static std::string JsonEscape(const std::string& str) {
+    std::string escaped;
+    for (char c : str) {
+      if (c == '"' || c == '\\') {
+        escaped += '\\';
+        escaped += c;
+      } else if (static_cast<unsigned char>(c) < 0x20u) {
+        escaped += StringPrintf("\\u%04x", static_cast<unsigned char>(c));
+      } else {
+        escaped += c;
+      }
+    }
+    return escaped;
+  }
+
   size_t ComputeSize(const void* oat_data) {
     if (reinterpret_cast<const uint8_t*>(oat_data) < oat_file_.Begin() ||
         reinterpret_cast<const uint8_t*>(oat_data) > oat_file_.End()) {
@@ -3404,6 +3540,8 @@ struct OatdumpArgs : public CmdlineArgs {
       disassemble_code_ = false;
     } else if (option =="--header-only") {
       dump_header_only_ = true;
+    } else if (option == "--stats-only") {
+      stats_only_ = true;
     } else if (option.starts_with("--symbolize=")) {
       oat_filename_ = option.substr(strlen("--symbolize=")).data();
       symbolize_ = true;
@@ -3458,6 +3596,9 @@ struct OatdumpArgs : public CmdlineArgs {
     } else if (image_location_ != nullptr && oat_filename_ != nullptr) {
       *error_msg = "Either --image or --oat-file must be specified but not both";
       return kParseError;
+    } else if (stats_only_ && oat_filename_ == nullptr) {
+      *error_msg = "--stats-only requires --oat-file";
+      return kParseError;
     }
 
     return kParseOk;
@@ -3501,6 +3642,10 @@ struct OatdumpArgs : public CmdlineArgs {
         "  --header-only may be used to print only the oat header.\n"
         "      Example: --header-only\n"
         "\n"
+        "  --stats-only may be used to print only the code size of the compiled methods of\n"
+        "      the oat file, as one line of JSON (can be used with filters).\n"
+        "      Example: --oat-file=/system/framework/boot.oat --stats-only\n"
+        "\n"
         "  --list-classes may be used to list target file classes (can be used with filters).\n"
         "      Example: --list-classes\n"
         "      Example: --list-classes --class-filter=com.example.foo\n"
@@ -3558,6 +3703,7 @@ struct OatdumpArgs : public CmdlineArgs {
   bool list_classes_ = false;
   bool list_methods_ = false;
   bool dump_header_only_ = false;
+  bool stats_only_ = false;
   bool imt_stat_dump_ = false;
   uint32_t addr2instr_ = 0;
   const char* export_dex_location_ = nullptr;
@@ -3582,6 +3728,7 @@ struct OatdumpMain : public CmdlineMain<OatdumpArgs> {
         args_->list_classes_,
         args_->list_methods_,
         args_->dump_header_only_,
+        args_->stats_only_,
         args_->export_dex_location_,
         args_->app_image_,
         args_->app_oat_,
@@ -61,6 +61,11 @@ TEST_F(OatDumpTest, TestListMethodsStatic) {
   ASSERT_TRUE(Exec(kStatic, kModeArt, {"--list-methods"}, kListOnly, &error_msg)) << error_msg;
 }
 
+TEST_F(OatDumpTest, TestCodeSizeStats) {
+  std::string error_msg;
+  ASSERT_TRUE(Exec(kDynamic, kModeCodeSizeStats, {}, kListOnly, &error_msg)) << error_msg;
+}
+
 TEST_F(OatDumpTest, TestSymbolize) {
   std::string error_msg;
   ASSERT_TRUE(Exec(kDynamic, kModeSymbolize, {}, kListOnly, &error_msg)) << error_msg;
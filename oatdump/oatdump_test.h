@@ -70,6 +70,7 @@ class OatDumpTest : public CommonRuntimeTest {
     kModeOat,
     kModeArt,
     kModeSymbolize,
+    kModeCodeSizeStats,
   };
 
   // Display style.
@@ -94,6 +95,10 @@ class OatDumpTest : public CommonRuntimeTest {
     if (mode == kModeSymbolize) {
       exec_argv.push_back("--symbolize=" + core_oat_location_);
       exec_argv.push_back("--output=" + core_oat_location_ + ".symbolize");
+    } else if (mode == kModeCodeSizeStats) {
+      exec_argv.push_back("--oat-file=" + core_oat_location_);
+      exec_argv.push_back("--stats-only");
+      expected_prefixes.push_back("{\"location\":");
     } else {
       expected_prefixes.push_back("Dex file data for");
       expected_prefixes.push_back("Num string ids:");
@@ -15,7 +15,6 @@
  */
 
 #include <memory>
-#include <set>
 
 #include "boot_image_profile.h"
 #include "dex_file-inl.h"
@@ -26,18 +25,67 @@ namespace art {
 
 using Hotness = ProfileCompilationInfo::MethodHotness;
 
-void GenerateBootImageProfile(
-    const std::vector<std::unique_ptr<const DexFile>>& dex_files,
-    const std::vector<std::unique_ptr<const ProfileCompilationInfo>>& profiles,
-    const BootImageOptions& options,
-    bool verbose,
-    ProfileCompilationInfo* out_profile) {
-  for (const std::unique_ptr<const ProfileCompilationInfo>& profile : profiles) {
-    // Avoid merging classes since we may want to only add classes that fit a certain criteria.
-    // If we merged the classes, every single class in each profile would be in the out_profile,
-    // but we want to only included classes that are in at least a few profiles.
-    out_profile->MergeWith(*profile, /*merge_classes*/ false);
+BootImageProfileAggregator::BootImageProfileAggregator(
+    const std::vector<std::unique_ptr<const DexFile>>& dex_files)
+    : dex_files_(dex_files),
+      num_profiles_(0u) {
+  for (const std::unique_ptr<const DexFile>& dex_file : dex_files_) {
+    method_counts_.emplace_back(dex_file->NumMethodIds(), 0u);
+    class_counts_.emplace_back(dex_file->NumClassDefs(), 0u);
+  }
+}
+
+void BootImageProfileAggregator::AddProfile(const ProfileCompilationInfo& profile) {
+  // Avoid merging classes since we may want to only add classes that fit a certain criteria.
+  // If we merged the classes, every single class in each profile would be in the out_profile,
+  // but we want to only included classes that are in at least a few profiles.
+  merged_profile_.MergeWith(profile, /*merge_classes*/ false);
+  ++num_profiles_;
+
+  // Inferred classes are classes inferred from method samples, by type index.
+  std::vector<bool> inferred_classes;
+  for (size_t dex_index = 0; dex_index < dex_files_.size(); ++dex_index) {
+    const DexFile* dex_file = dex_files_[dex_index].get();
+    inferred_classes.assign(dex_file->NumTypeIds(), false);
+    std::vector<uint32_t>& method_counts = method_counts_[dex_index];
+    for (size_t i = 0; i < dex_file->NumMethodIds(); ++i) {
+      MethodReference ref(dex_file, i);
+      Hotness hotness = profile.GetMethodHotness(ref);
+      if (hotness.IsInProfile()) {
+        ++method_counts[i];
+        merged_profile_.AddMethodHotness(ref, hotness);
+        inferred_classes[dex_file->GetMethodId(i).class_idx_.index_] = true;
+      }
+    }
+    std::vector<uint32_t>& class_counts = class_counts_[dex_index];
+    for (size_t i = 0; i < dex_file->NumClassDefs(); ++i) {
+      const dex::TypeIndex type_index = dex_file->GetClassDef(i).class_idx_;
+      if (inferred_classes[type_index.index_] || profile.ContainsClass(*dex_file, type_index)) {
+        ++class_counts[i];
+      }
+    }
+  }
+}
+
+void BootImageProfileAggregator::MergeWith(const BootImageProfileAggregator& other) {
+  DCHECK_EQ(dex_files_.size(), other.dex_files_.size());
+  merged_profile_.MergeWith(other.merged_profile_, /*merge_classes*/ false);
+  num_profiles_ += other.num_profiles_;
+  for (size_t dex_index = 0; dex_index < dex_files_.size(); ++dex_index) {
+    DCHECK_EQ(dex_files_[dex_index].get(), other.dex_files_[dex_index].get());
+    for (size_t i = 0; i < method_counts_[dex_index].size(); ++i) {
+      method_counts_[dex_index][i] += other.method_counts_[dex_index][i];
+    }
+    for (size_t i = 0; i < class_counts_[dex_index].size(); ++i) {
+      class_counts_[dex_index][i] += other.class_counts_[dex_index][i];
+    }
   }
+}
+
+void BootImageProfileAggregator::GenerateProfile(const BootImageOptions& options,
+                                                 bool verbose,
+                                                 ProfileCompilationInfo* out_profile) const {
+  out_profile->MergeWith(merged_profile_, /*merge_classes*/ false);
 
   // Image classes that were added because they are commonly used.
   size_t class_count = 0;
@@ -48,35 +96,22 @@ void GenerateBootImageProfile(
   // Total dirty classes.
   size_t dirty_count = 0;
 
-  for (const std::unique_ptr<const DexFile>& dex_file : dex_files) {
-    // Inferred classes are classes inferred from method samples.
-    std::set<std::pair<const ProfileCompilationInfo*, dex::TypeIndex>> inferred_classes;
+  for (size_t dex_index = 0; dex_index < dex_files_.size(); ++dex_index) {
+    const DexFile* dex_file = dex_files_[dex_index].get();
     for (size_t i = 0; i < dex_file->NumMethodIds(); ++i) {
-      MethodReference ref(dex_file.get(), i);
-      // This counter is how many profiles contain the method as sampled or hot.
-      size_t counter = 0;
-      for (const std::unique_ptr<const ProfileCompilationInfo>& profile : profiles) {
-        Hotness hotness = profile->GetMethodHotness(ref);
-        if (hotness.IsInProfile()) {
-          ++counter;
-          out_profile->AddMethodHotness(ref, hotness);
-          inferred_classes.emplace(profile.get(),
-                                   dex_file->GetMethodId(ref.dex_method_index).class_idx_);
-        }
-      }
       // If the counter is greater or equal to the compile threshold, mark the method as hot.
       // Note that all hot methods are also marked as hot in the out profile during the merging
       // process.
-      if (counter >= options.compiled_method_threshold) {
+      if (method_counts_[dex_index][i] >= options.compiled_method_threshold) {
         Hotness hotness;
         hotness.AddFlag(Hotness::kFlagHot);
-        out_profile->AddMethodHotness(ref, hotness);
+        out_profile->AddMethodHotness(MethodReference(dex_file, i), hotness);
       }
     }
     // Walk all of the classes and add them to the profile if they meet the requirements.
     for (size_t i = 0; i < dex_file->NumClassDefs(); ++i) {
       const DexFile::ClassDef& class_def = dex_file->GetClassDef(i);
-      TypeReference ref(dex_file.get(), class_def.class_idx_);
+      TypeReference ref(dex_file, class_def.class_idx_);
       bool is_clean = true;
       const uint8_t* class_data = dex_file->GetClassData(class_def);
       if (class_data != nullptr) {
@@ -108,14 +143,7 @@ void GenerateBootImageProfile(
       }
       ++(is_clean ? clean_count : dirty_count);
       // This counter is how many profiles contain the class.
-      size_t counter = 0;
-      for (const std::unique_ptr<const ProfileCompilationInfo>& profile : profiles) {
-        auto it = inferred_classes.find(std::make_pair(profile.get(), ref.type_index));
-        if (it != inferred_classes.end() ||
-            profile->ContainsClass(*ref.dex_file, ref.type_index)) {
-          ++counter;
-        }
-      }
+      const uint32_t counter = class_counts_[dex_index][i];
       if (counter == 0) {
         continue;
       }
@@ -131,8 +159,22 @@ void GenerateBootImageProfile(
   if (verbose) {
     LOG(INFO) << "Image classes " << class_count + clean_class_count
               << " added because clean " << clean_class_count
-              << " total clean " << clean_count << " total dirty " << dirty_count;
+              << " total clean " << clean_count << " total dirty " << dirty_count
+              << " from " << num_profiles_ << " profiles";
+  }
+}
+
+void GenerateBootImageProfile(
+    const std::vector<std::unique_ptr<const DexFile>>& dex_files,
+    const std::vector<std::unique_ptr<const ProfileCompilationInfo>>& profiles,
+    const BootImageOptions& options,
+    bool verbose,
+    ProfileCompilationInfo* out_profile) {
+  BootImageProfileAggregator aggregator(dex_files);
+  for (const std::unique_ptr<const ProfileCompilationInfo>& profile : profiles) {
+    aggregator.AddProfile(*profile);
   }
+  aggregator.GenerateProfile(options, verbose, out_profile);
 }
 
 }  // namespace art
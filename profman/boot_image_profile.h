@@ -21,6 +21,7 @@
 #include <memory>
 #include <vector>
 
+#include "base/macros.h"
 #include "dex_file.h"
 #include "jit/profile_compilation_info.h"
 
@@ -41,6 +42,44 @@ struct BootImageOptions {
   uint32_t compiled_method_threshold = std::numeric_limits<uint32_t>::max();
 };
 
+// Counts in how many profiles each method and class of the dex files appears, one profile at a
+// time, so that the profiles do not need to be all in memory. Aggregators of disjoint sets of
+// profiles can be filled on different threads and merged together.
+class BootImageProfileAggregator {
+ public:
+  explicit BootImageProfileAggregator(
+      const std::vector<std::unique_ptr<const DexFile>>& dex_files);
+
+  // Count the methods and classes of profile. The profile is not referenced after the call.
+  void AddProfile(const ProfileCompilationInfo& profile);
+
+  // Add the counts of the profiles of other, which must be built for the same dex files.
+  void MergeWith(const BootImageProfileAggregator& other);
+
+  // Add to out_profile the methods of the profiles, and the classes and methods which meet the
+  // options.
+  void GenerateProfile(const BootImageOptions& options,
+                       bool verbose,
+                       ProfileCompilationInfo* out_profile) const;
+
+  size_t GetNumberOfProfiles() const {
+    return num_profiles_;
+  }
+
+ private:
+  const std::vector<std::unique_ptr<const DexFile>>& dex_files_;
+  // The methods of the profiles, without their classes.
+  ProfileCompilationInfo merged_profile_;
+  // For each dex file, the number of profiles containing each method, by method index.
+  std::vector<std::vector<uint32_t>> method_counts_;
+  // For each dex file, the number of profiles containing each class, by class def index. A class
+  // is contained in a profile which has it, or has one of its methods.
+  std::vector<std::vector<uint32_t>> class_counts_;
+  size_t num_profiles_;
+
+  DISALLOW_COPY_AND_ASSIGN(BootImageProfileAggregator);
+};
+
 // Merge a bunch of profiles together to generate a boot profile. Classes and methods are added
 // to the out_profile if they meet the options.
 void GenerateBootImageProfile(
@@ -21,10 +21,13 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
@@ -39,6 +42,7 @@
 #include "boot_image_profile.h"
 #include "bytecode_utils.h"
 #include "dex_file.h"
+#include "jit/flat_profile.h"
 #include "jit/profile_compilation_info.h"
 #include "profile_assistant.h"
 #include "runtime.h"
@@ -145,6 +149,13 @@ NO_RETURN static void Usage(const char *fmt, ...) {
   UsageError("  --boot-image-sampled-method-threshold=<value>: minimum number of profiles a");
   UsageError("      non-hot method needs to be in order to be hot in the output profile. The");
   UsageError("      default is max int.");
+  UsageError("  --boot-image-threads=<value>: number of threads loading and counting the input");
+  UsageError("      profiles. Each thread holds one input profile at a time. The default is the");
+  UsageError("      number of CPUs.");
+  UsageError("");
+  UsageError("  --generate-flat-profile: merge the profile files into the reference profile");
+  UsageError("      file, written in the flat format that can be mapped and queried in place.");
+  UsageError("      The inline caches are not kept.");
   UsageError("");
 
   exit(EXIT_FAILURE);
@@ -177,6 +188,8 @@ class ProfMan FINAL {
       dump_only_(false),
       dump_classes_and_methods_(false),
       generate_boot_image_profile_(false),
+      generate_flat_profile_(false),
+      boot_image_threads_(std::thread::hardware_concurrency()),
       dump_output_to_fd_(kInvalidFd),
       test_profile_num_dex_(kDefaultTestProfileNumDex),
       test_profile_method_ratio_(kDefaultTestProfileMethodRatio),
@@ -218,6 +231,8 @@ class ProfMan FINAL {
         ParseUintOption(option, "--dump-output-to-fd", &dump_output_to_fd_, Usage);
       } else if (option == "--generate-boot-image-profile") {
         generate_boot_image_profile_ = true;
+      } else if (option == "--generate-flat-profile") {
+        generate_flat_profile_ = true;
       } else if (option.starts_with("--boot-image-class-threshold=")) {
         ParseUintOption(option,
                         "--boot-image-class-threshold",
@@ -233,6 +248,8 @@ class ProfMan FINAL {
                         "--boot-image-sampled-method-threshold",
                         &boot_image_options_.compiled_method_threshold,
                         Usage);
+      } else if (option.starts_with("--boot-image-threads=")) {
+        ParseUintOption(option, "--boot-image-threads", &boot_image_threads_, Usage);
       } else if (option.starts_with("--profile-file=")) {
         profile_files_.push_back(option.substr(strlen("--profile-file=")).ToString());
       } else if (option.starts_with("--profile-file-fd=")) {
@@ -363,7 +380,12 @@ class ProfMan FINAL {
       }
     }
     std::unique_ptr<ProfileCompilationInfo> info(new ProfileCompilationInfo);
-    if (!info->Load(fd)) {
+    const bool loaded = info->Load(fd);
+    if (!filename.empty()) {
+      // Do not keep a descriptor for every input, there may be thousands of them.
+      close(fd);
+    }
+    if (!loaded) {
       LOG(ERROR) << "Cannot load profile info from fd=" << fd << "\n";
       return nullptr;
     }
@@ -978,37 +1000,85 @@ class ProfMan FINAL {
       PLOG(ERROR) << "Expected dex files for creating boot profile";
       return -2;
     }
-    // Open the input profiles.
-    std::vector<std::unique_ptr<const ProfileCompilationInfo>> profiles;
-    if (!profile_files_fd_.empty()) {
-      for (int profile_file_fd : profile_files_fd_) {
-        std::unique_ptr<const ProfileCompilationInfo> profile(LoadProfile("", profile_file_fd));
-        if (profile == nullptr) {
-          return -3;
+    // Count the input profiles. Each thread loads the next profile, counts it in its own
+    // aggregator and drops it, the aggregators are merged once all the profiles are counted.
+    const size_t num_profiles = profile_files_fd_.size() + profile_files_.size();
+    const size_t num_threads =
+        std::max<size_t>(1u, std::min<size_t>(boot_image_threads_, num_profiles));
+    std::vector<std::unique_ptr<BootImageProfileAggregator>> aggregators;
+    for (size_t i = 0; i < num_threads; ++i) {
+      aggregators.emplace_back(new BootImageProfileAggregator(dex_files));
+    }
+    std::atomic<size_t> next_profile(0u);
+    std::atomic<int> result(0);
+    auto count_profiles = [&](BootImageProfileAggregator* aggregator) {
+      for (size_t i = next_profile.fetch_add(1u); i < num_profiles && result.load() == 0;
+           i = next_profile.fetch_add(1u)) {
+        std::unique_ptr<const ProfileCompilationInfo> profile;
+        if (i < profile_files_fd_.size()) {
+          profile = LoadProfile("", profile_files_fd_[i]);
+        } else {
+          profile = LoadProfile(profile_files_[i - profile_files_fd_.size()], kInvalidFd);
         }
-        profiles.emplace_back(std::move(profile));
-      }
-    }
-    if (!profile_files_.empty()) {
-      for (const std::string& profile_file : profile_files_) {
-        std::unique_ptr<const ProfileCompilationInfo> profile(LoadProfile(profile_file, kInvalidFd));
         if (profile == nullptr) {
-          return -4;
+          result.store(i < profile_files_fd_.size() ? -3 : -4);
+          return;
         }
-        profiles.emplace_back(std::move(profile));
+        aggregator->AddProfile(*profile);
       }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i) {
+      threads.emplace_back(count_profiles, aggregators[i].get());
+    }
+    count_profiles(aggregators[0].get());
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    if (result.load() != 0) {
+      return result.load();
+    }
+    for (size_t i = 1; i < num_threads; ++i) {
+      aggregators[0]->MergeWith(*aggregators[i]);
+      aggregators[i].reset();
     }
     ProfileCompilationInfo out_profile;
-    GenerateBootImageProfile(dex_files,
-                             profiles,
-                             boot_image_options_,
-                             VLOG_IS_ON(profiler),
-                             &out_profile);
+    aggregators[0]->GenerateProfile(boot_image_options_, VLOG_IS_ON(profiler), &out_profile);
     out_profile.Save(reference_fd);
     close(reference_fd);
     return 0;
   }
 
+  bool ShouldCreateFlatProfile() const {
+    return generate_flat_profile_;
+  }
+
+  // Merges the profile files into the reference profile, in the flat format. When all the
+  // profile files are flat, they are merged as they are read.
+  int CreateFlatProfile() {
+    if (profile_files_.empty() && profile_files_fd_.empty()) {
+      Usage("No profile files specified.");
+    }
+    if (reference_profile_file_.empty() && !FdIsValid(reference_profile_file_fd_)) {
+      Usage("No reference profile file specified.");
+    }
+    // Initialize memmap since it's required to map the flat profiles.
+    MemMap::Init();
+    std::vector<int> profile_fds(profile_files_fd_);
+    for (const std::string& profile_file : profile_files_) {
+      int fd = open(profile_file.c_str(), O_RDONLY);
+      if (fd < 0) {
+        PLOG(ERROR) << "Cannot open " << profile_file;
+        CloseAllFds(profile_fds, "profile_fds");
+        return -1;
+      }
+      profile_fds.push_back(fd);
+    }
+    int result = WriteFlatProfile(profile_fds);
+    CloseAllFds(profile_fds, "profile_fds");
+    return result;
+  }
+
   bool ShouldCreateProfile() {
     return !create_profile_from_file_.empty();
   }
@@ -1079,6 +1149,61 @@ class ProfMan FINAL {
     }
   }
 
+  int WriteFlatProfile(const std::vector<int>& profile_fds) {
+    const int reference_fd = OpenReferenceProfile();
+    if (!FdIsValid(reference_fd)) {
+      PLOG(ERROR) << "Error opening reference profile";
+      return -2;
+    }
+    // The flat profile is written from the start of an empty file.
+    if (ftruncate(reference_fd, 0) != 0 || lseek(reference_fd, 0, SEEK_SET) != 0) {
+      PLOG(ERROR) << "Error clearing reference profile";
+      close(reference_fd);
+      return -2;
+    }
+    bool all_flat = std::all_of(profile_fds.begin(), profile_fds.end(), [](int fd) {
+      return FlatProfile::IsFlatProfile(fd);
+    });
+    int result = 0;
+    std::string error;
+    if (all_flat) {
+      std::vector<std::unique_ptr<FlatProfile>> profiles;
+      std::vector<const FlatProfile*> inputs;
+      for (int fd : profile_fds) {
+        std::unique_ptr<FlatProfile> profile = FlatProfile::Open(fd, &error);
+        if (profile == nullptr) {
+          LOG(ERROR) << "Cannot open flat profile fd=" << fd << ": " << error;
+          result = -3;
+          break;
+        }
+        inputs.push_back(profile.get());
+        profiles.push_back(std::move(profile));
+      }
+      if (result == 0 && !FlatProfile::Merge(inputs, reference_fd, &error)) {
+        LOG(ERROR) << "Cannot merge the flat profiles: " << error;
+        result = -4;
+      }
+    } else {
+      ProfileCompilationInfo info;
+      for (int fd : profile_fds) {
+        std::unique_ptr<const ProfileCompilationInfo> profile(LoadProfile("", fd));
+        if (profile == nullptr || !info.MergeWith(*profile)) {
+          LOG(ERROR) << "Cannot merge the profile fd=" << fd;
+          result = -3;
+          break;
+        }
+      }
+      if (result == 0 && !FlatProfile::Write(info, reference_fd)) {
+        PLOG(ERROR) << "Cannot write the flat profile";
+        result = -4;
+      }
+    }
+    if (close(reference_fd) < 0) {
+      PLOG(WARNING) << "Failed to close descriptor";
+    }
+    return result;
+  }
+
   void LogCompletionTime() {
     static constexpr uint64_t kLogThresholdTime = MsToNs(100);  // 100ms
     uint64_t time_taken = NanoTime() - start_ns_;
@@ -1097,6 +1222,8 @@ class ProfMan FINAL {
   bool dump_only_;
   bool dump_classes_and_methods_;
   bool generate_boot_image_profile_;
+  bool generate_flat_profile_;
+  uint32_t boot_image_threads_;
   int dump_output_to_fd_;
   BootImageOptions boot_image_options_;
   std::string test_profile_;
@@ -1131,6 +1258,10 @@ static int profman(int argc, char** argv) {
   if (profman.ShouldCreateBootProfile()) {
     return profman.CreateBootProfile();
   }
+
+  if (profman.ShouldCreateFlatProfile()) {
+    return profman.CreateFlatProfile();
+  }
   // Process profile information and assess if we need to do a profile guided compilation.
   // This operation involves I/O.
   return profman.ProcessProfiles();
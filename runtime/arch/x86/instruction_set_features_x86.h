@@ -52,6 +52,8 @@ class X86InstructionSetFeatures : public InstructionSetFeatures {
 
   bool Equals(const InstructionSetFeatures* other) const OVERRIDE;
 
+  bool HasAtLeast(const InstructionSetFeatures* other) const OVERRIDE;
+
   virtual InstructionSet GetInstructionSet() const OVERRIDE {
     return kX86;
   }
@@ -62,8 +64,16 @@ class X86InstructionSetFeatures : public InstructionSetFeatures {
 
   virtual ~X86InstructionSetFeatures() {}
 
+  bool HasSSSE3() const { return has_SSSE3_; }
+
   bool HasSSE4_1() const { return has_SSE4_1_; }
 
+  bool HasSSE4_2() const { return has_SSE4_2_; }
+
+  bool HasAVX() const { return has_AVX_; }
+
+  bool HasAVX2() const { return has_AVX2_; }
+
   bool HasPopCnt() const { return has_POPCNT_; }
 
  protected:
@@ -143,4 +143,39 @@ TEST(X86InstructionSetFeaturesTest, X86FeaturesFromSilvermontVariant) {
   EXPECT_FALSE(x86_features->Equals(x86_default_features.get()));
 }
 
+TEST(X86InstructionSetFeaturesTest, X86FeaturesHasAtLeast) {
+  std::string error_msg;
+  std::unique_ptr<const InstructionSetFeatures> x86_default_features(
+      InstructionSetFeatures::FromVariant(kX86, "default", &error_msg));
+  ASSERT_TRUE(x86_default_features.get() != nullptr) << error_msg;
+  std::unique_ptr<const InstructionSetFeatures> x86_atom_features(
+      InstructionSetFeatures::FromVariant(kX86, "atom", &error_msg));
+  ASSERT_TRUE(x86_atom_features.get() != nullptr) << error_msg;
+  std::unique_ptr<const InstructionSetFeatures> x86_silvermont_features(
+      InstructionSetFeatures::FromVariant(kX86, "silvermont", &error_msg));
+  ASSERT_TRUE(x86_silvermont_features.get() != nullptr) << error_msg;
+  std::unique_ptr<const InstructionSetFeatures> x86_avx2_features(
+      x86_silvermont_features->AddFeaturesFromString("avx,avx2", &error_msg));
+  ASSERT_TRUE(x86_avx2_features.get() != nullptr) << error_msg;
+
+  EXPECT_TRUE(x86_silvermont_features->HasAtLeast(x86_silvermont_features.get()));
+  EXPECT_TRUE(x86_silvermont_features->HasAtLeast(x86_atom_features.get()));
+  EXPECT_TRUE(x86_silvermont_features->HasAtLeast(x86_default_features.get()));
+  EXPECT_TRUE(x86_avx2_features->HasAtLeast(x86_silvermont_features.get()));
+  EXPECT_FALSE(x86_silvermont_features->HasAtLeast(x86_avx2_features.get()));
+  EXPECT_FALSE(x86_atom_features->HasAtLeast(x86_silvermont_features.get()));
+  EXPECT_FALSE(x86_default_features->HasAtLeast(x86_atom_features.get()));
+
+  // The features are kept in the oat header as a bitmap.
+  std::unique_ptr<const InstructionSetFeatures> x86_avx2_bitmap_features(
+      InstructionSetFeatures::FromBitmap(kX86, x86_avx2_features->AsBitmap()));
+  EXPECT_TRUE(x86_avx2_bitmap_features->Equals(x86_avx2_features.get()));
+
+  // The 32-bit and 64-bit features do not run each other's code.
+  std::unique_ptr<const InstructionSetFeatures> x86_64_silvermont_features(
+      InstructionSetFeatures::FromVariant(kX86_64, "silvermont", &error_msg));
+  ASSERT_TRUE(x86_64_silvermont_features.get() != nullptr) << error_msg;
+  EXPECT_FALSE(x86_64_silvermont_features->HasAtLeast(x86_default_features.get()));
+}
+
 }  // namespace art
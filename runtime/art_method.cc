@@ -24,8 +24,10 @@
 #include "art_method-inl.h"
 #include "base/stringpiece.h"
 #ifdef CAPSTONE
-#include "binary_analyzer/binary_analyzer.h"
+#include "binary_analyzer/autofast_jni_cache.h"
+#include "binary_analyzer/autofast_jni_queue.h"
 #endif
+#include "catch_block_cache.h"
 #include "class_linker-inl.h"
 #include "debugger.h"
 #include "dex_file-inl.h"
@@ -267,13 +269,26 @@ uint32_t ArtMethod::FindDexMethodIndexInOtherDexFile(const DexFile& other_dexfil
 uint32_t ArtMethod::FindCatchBlock(Handle<mirror::Class> exception_type,
                                    uint32_t dex_pc, bool* has_no_move_exception) {
   const DexFile::CodeItem* code_item = GetCodeItem();
-  // Set aside the exception while we resolve its type.
   Thread* self = Thread::Current();
+  CatchBlockCache* cache = self->GetOrCreateCatchBlockCache();
+  const uint16_t* dex_pc_ptr = &code_item->insns_[dex_pc];
+  uint32_t found_dex_pc;
+  bool cached_has_no_move_exception;
+  if (cache->Get(this, dex_pc_ptr, exception_type.Get(), &found_dex_pc,
+                 &cached_has_no_move_exception)) {
+    if (found_dex_pc != DexFile::kDexNoIndex) {
+      *has_no_move_exception = cached_has_no_move_exception;
+    }
+    return found_dex_pc;
+  }
+  // Set aside the exception while we resolve its type.
   StackHandleScope<1> hs(self);
   Handle<mirror::Throwable> exception(hs.NewHandle(self->GetException()));
   self->ClearException();
   // Default to handler not found.
-  uint32_t found_dex_pc = DexFile::kDexNoIndex;
+  found_dex_pc = DexFile::kDexNoIndex;
+  // Whether the handler types could all be resolved, a later lookup may find another handler.
+  bool cacheable = true;
   // Iterate over the catch handlers associated with dex_pc.
   for (CatchHandlerIterator it(*code_item, dex_pc); it.HasNext(); it.Next()) {
     dex::TypeIndex iter_type_idx = it.GetHandlerTypeIndex();
@@ -289,6 +304,7 @@ uint32_t ArtMethod::FindCatchBlock(Handle<mirror::Class> exception_type,
       // removed by a pro-guard like tool.
       // Note: this is not RI behavior. RI would have failed when loading the class.
       self->ClearException();
+      cacheable = false;
       // Delete any long jump context as this routine is called during a stack walk which will
       // release its in use context at the end.
       delete self->GetLongJumpContext();
@@ -304,6 +320,13 @@ uint32_t ArtMethod::FindCatchBlock(Handle<mirror::Class> exception_type,
         Instruction::At(&code_item->insns_[found_dex_pc]);
     *has_no_move_exception = (first_catch_instr->Opcode() != Instruction::MOVE_EXCEPTION);
   }
+  if (cacheable) {
+    cache->Set(this,
+               dex_pc_ptr,
+               exception_type.Get(),
+               found_dex_pc,
+               found_dex_pc != DexFile::kDexNoIndex && *has_no_move_exception);
+  }
   // Put the exception back.
   if (exception != nullptr) {
     self->SetException(exception.Get());
@@ -393,51 +416,24 @@ void ArtMethod::Invoke(Thread* self, uint32_t* args, uint32_t args_size, JValue*
   self->PopManagedStackFragment(fragment);
 }
 
-#ifdef CAPSTONE
-
-class AutoFastJniDetectTask FINAL : public jit::JniTask {
- public:
-  AutoFastJniDetectTask(ArtMethod* method, const void* native_method)
-      : method_(method), native_method_(native_method) { }
-
-  ~AutoFastJniDetectTask() { }
-
-  void Run(Thread* self) OVERRIDE {
-    ScopedObjectAccess soa(self);
-    bool is_fast = IsFastJNI(method_->GetDexMethodIndex(), *method_->GetDexFile(), native_method_);
-    if (is_fast) {
-      method_->SetAccessFlags(method_->GetAccessFlags() | kAccFastNative);
-    }
-  }
-
-  void Finalize() OVERRIDE {
-    delete this;
-  }
-
- private:
-  ArtMethod* const method_;
-  const void* native_method_;
-
-  DISALLOW_IMPLICIT_CONSTRUCTORS(AutoFastJniDetectTask);
-};
-
-#endif // #ifdef CAPSTONE
-
 const void* ArtMethod::RegisterNative(const void* native_method, bool is_fast) {
   CHECK(IsNative()) << PrettyMethod();
   CHECK(native_method != nullptr) << PrettyMethod();
 #ifdef CAPSTONE
   const bool not_going_to_unregister = (native_method != GetJniDlsymLookupStub());
   if (!is_fast && Runtime::Current()->IsAutoFastDetect() && not_going_to_unregister) {
-    jit::Jit* jit = Runtime::Current()->GetJit();
-    if (jit != nullptr) {
-      jit->AddJniTask(Thread::Current(), new AutoFastJniDetectTask(this, native_method));
-    } else {
+    bool cached_is_fast = false;
+    if (Runtime::Current()->GetAutoFastJniCache()->Lookup(this, native_method, &cached_is_fast)) {
+      // Analyzed by an earlier run of the app.
+      is_fast = cached_is_fast;
+    } else if (
+        !Runtime::Current()->GetAutoFastJniQueue()->Add(Thread::Current(), this, native_method)) {
       // If we can't use JIT's thread pool it's better to disable auto fast JNI detection because
       // if we run it in main thread it causes ~20% app launch time regression, so we decided to
       // disable it as app launch time much more important than this optimization. Now auto fast
       // JNI detection doesn't work in AOT at all. In JIT mode it doesn't work too but only between
-      // process startup and JIT creation.
+      // process startup and JIT creation. The methods registered while the queue is full are
+      // not analyzed either.
     }
   }
 #endif
@@ -783,7 +779,10 @@ void ArtMethod::CopyFrom(ArtMethod* src, PointerSize image_pointer_size) {
   Runtime* runtime = Runtime::Current();
   if (runtime->UseJitCompilation()) {
     if (runtime->GetJit()->GetCodeCache()->ContainsPc(GetEntryPointFromQuickCompiledCode())) {
-      SetEntryPointFromQuickCompiledCodePtrSize(GetQuickToInterpreterBridge(), image_pointer_size);
+      // The JIT compiled JNI stubs are shared, the native methods go back to the generic JNI.
+      const void* entry_point =
+          src->IsNative() ? GetQuickGenericJniStub() : GetQuickToInterpreterBridge();
+      SetEntryPointFromQuickCompiledCodePtrSize(entry_point, image_pointer_size);
     }
   }
   // Clear the profiling info for the same reasons as the JIT code.
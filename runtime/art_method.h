@@ -250,6 +250,22 @@ class ArtMethod FINAL {
     return (GetAccessFlags() & kAccObsoleteMethod) != 0;
   }
 
+  bool PreviouslyWarm() {
+    if (IsIntrinsic()) {
+      // kAccPreviouslyWarm is part of the intrinsic ordinal.
+      return false;
+    }
+    return (GetAccessFlags() & kAccPreviouslyWarm) != 0;
+  }
+
+  void SetPreviouslyWarm() {
+    if (IsIntrinsic()) {
+      // kAccPreviouslyWarm is part of the intrinsic ordinal.
+      return;
+    }
+    AddAccessFlags(kAccPreviouslyWarm);
+  }
+
   void SetIsObsolete() {
     AddAccessFlags(kAccObsoleteMethod);
   }
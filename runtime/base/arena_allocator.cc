@@ -229,38 +229,27 @@ MallocArena::~MallocArena() {
   free(reinterpret_cast<void*>(unaligned_memory_));
 }
 
+// The memory arenas are carved out of reservations of this size.
+static constexpr size_t kArenaReservationSize = 16 * arena_allocator::kArenaDefaultSize;
+
+// An arena carved out of the memory reservations of its pool, which frees its memory.
 class MemMapArena FINAL : public Arena {
  public:
-  MemMapArena(size_t size, bool low_4gb, const char* name);
-  virtual ~MemMapArena();
+  MemMapArena(uint8_t* memory, size_t size);
   void Release() OVERRIDE;
-
- private:
-  std::unique_ptr<MemMap> map_;
 };
 
-MemMapArena::MemMapArena(size_t size, bool low_4gb, const char* name) {
-  // Round up to a full page as that's the smallest unit of allocation for mmap()
-  // and we want to be able to use all memory that we actually allocate.
-  size = RoundUp(size, kPageSize);
-  std::string error_msg;
-  map_.reset(MemMap::MapAnonymous(
-      name, nullptr, size, PROT_READ | PROT_WRITE, low_4gb, false, &error_msg));
-  CHECK(map_.get() != nullptr) << error_msg;
-  memory_ = map_->Begin();
+MemMapArena::MemMapArena(uint8_t* memory, size_t size) {
+  memory_ = memory;
   static_assert(ArenaAllocator::kArenaAlignment <= kPageSize,
                 "Arena should not need stronger alignment than kPageSize.");
   DCHECK_ALIGNED(memory_, ArenaAllocator::kArenaAlignment);
-  size_ = map_->Size();
-}
-
-MemMapArena::~MemMapArena() {
-  // Destroys MemMap via std::unique_ptr<>.
+  size_ = size;
 }
 
 void MemMapArena::Release() {
   if (bytes_allocated_ > 0) {
-    map_->MadviseDontNeedAndZero();
+    ZeroAndReleasePages(memory_, size_);
     bytes_allocated_ = 0;
   }
 }
@@ -276,13 +265,15 @@ ArenaPool::ArenaPool(bool use_malloc, bool low_4gb, const char* name)
     : use_malloc_(use_malloc),
       lock_("Arena pool lock", kArenaPoolLock),
       free_arenas_(nullptr),
-      low_4gb_(low_4gb),
-      name_(name) {
+      free_large_arenas_(nullptr),
+      bytes_in_use_(0u),
+      peak_bytes_in_use_(0u) {
   if (low_4gb) {
     CHECK(!use_malloc) << "low4gb must use map implementation";
   }
   if (!use_malloc) {
     MemMap::Init();
+    reservations_.reset(new MemMapReservations(name, kArenaReservationSize, low_4gb));
   }
 }
 
@@ -291,13 +282,22 @@ ArenaPool::~ArenaPool() {
 }
 
 void ArenaPool::ReclaimMemory() {
-  while (free_arenas_ != nullptr) {
-    auto* arena = free_arenas_;
-    free_arenas_ = free_arenas_->next_;
-    delete arena;
+  for (Arena** list : { &free_arenas_, &free_large_arenas_ }) {
+    while (*list != nullptr) {
+      auto* arena = *list;
+      *list = arena->next_;
+      DeleteArena(arena);
+    }
   }
 }
 
+void ArenaPool::DeleteArena(Arena* arena) {
+  if (!use_malloc_) {
+    reservations_->Free(arena->Begin(), arena->Size());
+  }
+  delete arena;
+}
+
 void ArenaPool::LockReclaimMemory() {
   MutexLock lock(Thread::Current(), lock_);
   ReclaimMemory();
@@ -306,16 +306,40 @@ void ArenaPool::LockReclaimMemory() {
 Arena* ArenaPool::AllocArena(size_t size) {
   Thread* self = Thread::Current();
   Arena* ret = nullptr;
+  uint8_t* memory = nullptr;
+  if (!use_malloc_) {
+    // Round up to a full page as that's the smallest unit of allocation for mmap()
+    // and we want to be able to use all memory that we actually allocate.
+    size = RoundUp(size, kPageSize);
+  }
   {
     MutexLock lock(self, lock_);
-    if (free_arenas_ != nullptr && LIKELY(free_arenas_->Size() >= size)) {
-      ret = free_arenas_;
-      free_arenas_ = free_arenas_->next_;
+    if (size <= arena_allocator::kArenaDefaultSize) {
+      if (free_arenas_ != nullptr) {
+        ret = free_arenas_;
+        free_arenas_ = free_arenas_->next_;
+      }
+    } else {
+      // Take the first large arena that fits.
+      for (Arena** link = &free_large_arenas_; *link != nullptr; link = &(*link)->next_) {
+        if ((*link)->Size() >= size) {
+          ret = *link;
+          *link = ret->next_;
+          break;
+        }
+      }
+    }
+    if (ret == nullptr && !use_malloc_) {
+      std::string error_msg;
+      memory = reservations_->Allocate(size, &error_msg);
+      CHECK(memory != nullptr) << error_msg;
     }
+    bytes_in_use_ += (ret != nullptr) ? ret->Size() : size;
+    peak_bytes_in_use_ = std::max(peak_bytes_in_use_, bytes_in_use_);
   }
   if (ret == nullptr) {
     ret = use_malloc_ ? static_cast<Arena*>(new MallocArena(size)) :
-        new MemMapArena(size, low_4gb_, name_);
+        new MemMapArena(memory, size);
   }
   ret->Reset();
   return ret;
@@ -326,8 +350,10 @@ void ArenaPool::TrimMaps() {
     ScopedTrace trace(__PRETTY_FUNCTION__);
     // Doesn't work for malloc.
     MutexLock lock(Thread::Current(), lock_);
-    for (auto* arena = free_arenas_; arena != nullptr; arena = arena->next_) {
-      arena->Release();
+    for (Arena* list : { free_arenas_, free_large_arenas_ }) {
+      for (auto* arena = list; arena != nullptr; arena = arena->next_) {
+        arena->Release();
+      }
     }
   }
 }
@@ -335,39 +361,73 @@ void ArenaPool::TrimMaps() {
 size_t ArenaPool::GetBytesAllocated() const {
   size_t total = 0;
   MutexLock lock(Thread::Current(), lock_);
-  for (Arena* arena = free_arenas_; arena != nullptr; arena = arena->next_) {
-    total += arena->GetBytesAllocated();
+  for (Arena* list : { free_arenas_, free_large_arenas_ }) {
+    for (Arena* arena = list; arena != nullptr; arena = arena->next_) {
+      total += arena->GetBytesAllocated();
+    }
   }
   return total;
 }
 
+size_t ArenaPool::GetBytesInUse() const {
+  MutexLock lock(Thread::Current(), lock_);
+  return bytes_in_use_;
+}
+
+size_t ArenaPool::GetPeakBytesInUse() const {
+  MutexLock lock(Thread::Current(), lock_);
+  return peak_bytes_in_use_;
+}
+
 void ArenaPool::FreeArenaChain(Arena* first) {
-  if (UNLIKELY(RUNNING_ON_MEMORY_TOOL > 0)) {
-    for (Arena* arena = first; arena != nullptr; arena = arena->next_) {
+  if (first == nullptr) {
+    return;
+  }
+
+  size_t freed_bytes = 0u;
+  for (Arena* arena = first; arena != nullptr; arena = arena->next_) {
+    if (UNLIKELY(RUNNING_ON_MEMORY_TOOL > 0)) {
       MEMORY_TOOL_MAKE_UNDEFINED(arena->memory_, arena->bytes_allocated_);
     }
+    freed_bytes += arena->Size();
   }
 
   if (arena_allocator::kArenaAllocatorPreciseTracking) {
     // Do not reuse arenas when tracking.
+    MutexLock lock(Thread::Current(), lock_);
+    bytes_in_use_ -= freed_bytes;
     while (first != nullptr) {
       Arena* next = first->next_;
-      delete first;
+      DeleteArena(first);
       first = next;
     }
     return;
   }
 
-  if (first != nullptr) {
-    Arena* last = first;
-    while (last->next_ != nullptr) {
-      last = last->next_;
+  // Split the chain between the default and the large arenas outside of the lock.
+  Arena* heads[2] = { nullptr, nullptr };
+  Arena* tails[2] = { nullptr, nullptr };
+  while (first != nullptr) {
+    Arena* next = first->next_;
+    size_t index = (first->Size() > arena_allocator::kArenaDefaultSize) ? 1u : 0u;
+    if (tails[index] == nullptr) {
+      tails[index] = first;
     }
-    Thread* self = Thread::Current();
-    MutexLock lock(self, lock_);
-    last->next_ = free_arenas_;
-    free_arenas_ = first;
+    first->next_ = heads[index];
+    heads[index] = first;
+    first = next;
+  }
+  Thread* self = Thread::Current();
+  MutexLock lock(self, lock_);
+  if (tails[0] != nullptr) {
+    tails[0]->next_ = free_arenas_;
+    free_arenas_ = heads[0];
+  }
+  if (tails[1] != nullptr) {
+    tails[1]->next_ = free_large_arenas_;
+    free_large_arenas_ = heads[1];
   }
+  bytes_in_use_ -= freed_bytes;
 }
 
 size_t ArenaAllocator::BytesAllocated() const {
@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include <memory>
+
 #include "base/bit_utils.h"
 #include "base/dchecked_vector.h"
 #include "base/memory_tool.h"
@@ -35,6 +37,7 @@ class ArenaAllocator;
 class ArenaStack;
 class ScopedArenaAllocator;
 class MemStats;
+class MemMapReservations;
 
 template <typename T>
 class ArenaAllocatorAdapter;
@@ -253,6 +256,10 @@ class ArenaPool {
   Arena* AllocArena(size_t size) REQUIRES(!lock_);
   void FreeArenaChain(Arena* first) REQUIRES(!lock_);
   size_t GetBytesAllocated() const REQUIRES(!lock_);
+  // The bytes of the arenas handed out and not yet freed, and their peak since the creation
+  // of the pool. Counted per arena, they are always cheap to maintain.
+  size_t GetBytesInUse() const REQUIRES(!lock_);
+  size_t GetPeakBytesInUse() const REQUIRES(!lock_);
   void ReclaimMemory() NO_THREAD_SAFETY_ANALYSIS;
   void LockReclaimMemory() REQUIRES(!lock_);
   // Trim the maps in arenas by madvising, used by JIT to reduce memory usage. This only works
@@ -260,11 +267,18 @@ class ArenaPool {
   void TrimMaps() REQUIRES(!lock_);
 
  private:
+  void DeleteArena(Arena* arena) REQUIRES(lock_);
+
   const bool use_malloc_;
   mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   Arena* free_arenas_ GUARDED_BY(lock_);
-  const bool low_4gb_;
-  const char* name_;
+  // The free arenas larger than the default size, allocated for huge methods. They are kept
+  // apart for the next allocations too large for a default arena.
+  Arena* free_large_arenas_ GUARDED_BY(lock_);
+  size_t bytes_in_use_ GUARDED_BY(lock_);
+  size_t peak_bytes_in_use_ GUARDED_BY(lock_);
+  // The memory of the arenas when use_malloc_ is false.
+  std::unique_ptr<MemMapReservations> reservations_ GUARDED_BY(lock_);
   DISALLOW_COPY_AND_ASSIGN(ArenaPool);
 };
 
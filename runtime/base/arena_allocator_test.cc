@@ -130,6 +130,30 @@ TEST_F(ArenaAllocatorTest, LargeAllocations) {
   }
 }
 
+TEST_F(ArenaAllocatorTest, LargeArenaReuse) {
+  if (arena_allocator::kArenaAllocatorPreciseTracking) {
+    printf("WARNING: TEST DISABLED FOR precise arena tracking\n");
+    return;
+  }
+
+  ArenaPool pool;
+  void* large_allocation;
+  {
+    ArenaAllocator arena(&pool);
+    large_allocation = arena.Alloc(arena_allocator::kArenaDefaultSize * 2);
+    EXPECT_GE(pool.GetBytesInUse(), arena_allocator::kArenaDefaultSize * 2);
+  }
+  EXPECT_EQ(0u, pool.GetBytesInUse());
+  EXPECT_GE(pool.GetPeakBytesInUse(), arena_allocator::kArenaDefaultSize * 2);
+  {
+    ArenaAllocator arena(&pool);
+    // A default allocation does not take the large arena, the next large allocation does.
+    arena.Alloc(arena_allocator::kArenaDefaultSize * 1 / 16);
+    void* allocation = arena.Alloc(arena_allocator::kArenaDefaultSize * 3 / 2);
+    EXPECT_EQ(large_allocation, allocation);
+  }
+}
+
 TEST_F(ArenaAllocatorTest, AllocAlignment) {
   ArenaPool pool;
   ArenaAllocator arena(&pool);
@@ -136,82 +136,84 @@ void BitVector::Intersect(const BitVector* src) {
 }
 
 bool BitVector::Union(const BitVector* src) {
-  // Get the highest bit to determine how much we need to expand.
-  int highest_bit = src->GetHighestBitSet();
-  bool changed = false;
-
-  // If src has no bit set, we are done: there is no need for a union with src.
-  if (highest_bit == -1) {
-    return changed;
-  }
-
-  // Update src_size to how many cells we actually care about: where the bit is + 1.
-  uint32_t src_size = BitsToWords(highest_bit + 1);
+  uint32_t src_size = src->storage_size_;
 
-  // Is the storage size smaller than src's?
+  // Is the storage size smaller than src's? Only expand for the words of src with bits set.
   if (storage_size_ < src_size) {
-    changed = true;
+    int highest_bit = src->GetHighestBitSet();
 
-    EnsureSize(highest_bit);
+    // If src has no bit set, we are done: there is no need for a union with src.
+    if (highest_bit == -1) {
+      return false;
+    }
 
-    // Paranoid: storage size should be big enough to hold this bit now.
-    DCHECK_LT(static_cast<uint32_t> (highest_bit), storage_size_ * kWordBits);
+    // Update src_size to how many cells we actually care about: where the bit is + 1.
+    src_size = BitsToWords(highest_bit + 1);
+    if (storage_size_ < src_size) {
+      EnsureSize(highest_bit);
+
+      // Paranoid: storage size should be big enough to hold this bit now.
+      DCHECK_LT(static_cast<uint32_t> (highest_bit), storage_size_ * kWordBits);
+    }
   }
 
+  // Without any branch in the loop, the compiler can vectorize it.
+  uint32_t* storage = storage_;
+  const uint32_t* src_storage = src->GetRawStorage();
+  uint32_t changed_bits = 0u;
   for (uint32_t idx = 0; idx < src_size; idx++) {
-    uint32_t existing = storage_[idx];
-    uint32_t update = existing | src->GetRawStorageWord(idx);
-    if (existing != update) {
-      changed = true;
-      storage_[idx] = update;
-    }
+    uint32_t existing = storage[idx];
+    uint32_t update = existing | src_storage[idx];
+    changed_bits |= existing ^ update;
+    storage[idx] = update;
   }
-  return changed;
+  return changed_bits != 0u;
 }
 
 bool BitVector::UnionIfNotIn(const BitVector* union_with, const BitVector* not_in) {
-  // Get the highest bit to determine how much we need to expand.
-  int highest_bit = union_with->GetHighestBitSet();
-  bool changed = false;
+  uint32_t union_with_size = union_with->storage_size_;
 
-  // If src has no bit set, we are done: there is no need for a union with src.
-  if (highest_bit == -1) {
-    return changed;
-  }
+  // Is the storage size smaller than union_with's? Only expand for the words with bits set.
+  if (storage_size_ < union_with_size) {
+    int highest_bit = union_with->GetHighestBitSet();
 
-  // Update union_with_size to how many cells we actually care about: where the bit is + 1.
-  uint32_t union_with_size = BitsToWords(highest_bit + 1);
+    // If union_with has no bit set, we are done: there is no need for a union with it.
+    if (highest_bit == -1) {
+      return false;
+    }
 
-  // Is the storage size smaller than src's?
-  if (storage_size_ < union_with_size) {
-    EnsureSize(highest_bit);
+    // Update union_with_size to how many cells we actually care about: where the bit is + 1.
+    union_with_size = BitsToWords(highest_bit + 1);
+    if (storage_size_ < union_with_size) {
+      EnsureSize(highest_bit);
 
-    // Paranoid: storage size should be big enough to hold this bit now.
-    DCHECK_LT(static_cast<uint32_t> (highest_bit), storage_size_ * kWordBits);
+      // Paranoid: storage size should be big enough to hold this bit now.
+      DCHECK_LT(static_cast<uint32_t> (highest_bit), storage_size_ * kWordBits);
+    }
   }
 
-  uint32_t not_in_size = not_in->GetStorageSize();
+  // Without any branch in the loops, the compiler can vectorize them.
+  uint32_t* storage = storage_;
+  const uint32_t* union_with_storage = union_with->GetRawStorage();
+  const uint32_t* not_in_storage = not_in->GetRawStorage();
+  uint32_t not_in_size = std::min(not_in->GetStorageSize(), union_with_size);
+  uint32_t changed_bits = 0u;
 
   uint32_t idx = 0;
-  for (; idx < std::min(not_in_size, union_with_size); idx++) {
-    uint32_t existing = storage_[idx];
-    uint32_t update = existing |
-        (union_with->GetRawStorageWord(idx) & ~not_in->GetRawStorageWord(idx));
-    if (existing != update) {
-      changed = true;
-      storage_[idx] = update;
-    }
+  for (; idx < not_in_size; idx++) {
+    uint32_t existing = storage[idx];
+    uint32_t update = existing | (union_with_storage[idx] & ~not_in_storage[idx]);
+    changed_bits |= existing ^ update;
+    storage[idx] = update;
   }
 
   for (; idx < union_with_size; idx++) {
-    uint32_t existing = storage_[idx];
-    uint32_t update = existing | union_with->GetRawStorageWord(idx);
-    if (existing != update) {
-      changed = true;
-      storage_[idx] = update;
-    }
+    uint32_t existing = storage[idx];
+    uint32_t update = existing | union_with_storage[idx];
+    changed_bits |= existing ^ update;
+    storage[idx] = update;
   }
-  return changed;
+  return changed_bits != 0u;
 }
 
 void BitVector::Subtract(const BitVector *src) {
@@ -167,6 +167,43 @@ TEST(BitVector, UnionIfNotIn) {
   }
 }
 
+TEST(BitVector, Union) {
+  {
+    BitVector first(2, true, Allocator::GetMallocAllocator());
+    BitVector second(128, true, Allocator::GetMallocAllocator());
+
+    // Nothing to add, even though second is larger.
+    first.SetBit(1);
+    second.SetBit(1);
+    EXPECT_FALSE(first.Union(&second));
+    EXPECT_EQ(1u, first.NumSetBits());
+  }
+
+  {
+    BitVector first(128, true, Allocator::GetMallocAllocator());
+    BitVector second(128, true, Allocator::GetMallocAllocator());
+
+    first.SetBit(3);
+    second.SetBit(3);
+    second.SetBit(100);
+    EXPECT_TRUE(first.Union(&second));
+    EXPECT_EQ(2u, first.NumSetBits());
+    EXPECT_TRUE(first.IsBitSet(100));
+    EXPECT_FALSE(first.Union(&second));
+  }
+
+  {
+    BitVector first(2, true, Allocator::GetMallocAllocator());
+    BitVector second(5, true, Allocator::GetMallocAllocator());
+
+    // A union expanding the storage.
+    second.SetBit(70);
+    EXPECT_TRUE(first.Union(&second));
+    EXPECT_TRUE(first.IsBitSet(70));
+    EXPECT_EQ(1u, first.NumSetBits());
+  }
+}
+
 TEST(BitVector, Subset) {
   {
     BitVector first(2, true, Allocator::GetMallocAllocator());
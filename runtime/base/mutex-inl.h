@@ -130,9 +130,16 @@ inline void ReaderWriterMutex::SharedLock(Thread* self) {
   DCHECK(self == nullptr || self == Thread::Current());
 #if ART_USE_FUTEXES
   bool done = false;
+  bool yielded = false;
   do {
     int32_t cur_state = state_.LoadRelaxed();
     if (LIKELY(cur_state >= 0)) {
+      if (UNLIKELY(num_pending_writers_.LoadRelaxed() > 0) && !yielded) {
+        // Let the pending writer in before adding another reader, once.
+        yielded = true;
+        YieldToPendingWriter();
+        continue;
+      }
       // Add as an extra reader.
       done = state_.CompareExchangeWeakAcquire(cur_state, cur_state + 1);
     } else {
@@ -19,6 +19,8 @@
 #include <errno.h>
 #include <sys/time.h>
 
+#include <algorithm>
+
 #include "android-base/stringprintf.h"
 
 #include "atomic.h"
@@ -26,6 +28,7 @@
 #include "base/time_utils.h"
 #include "base/systrace.h"
 #include "base/value_object.h"
+#include "contention_profiler.h"
 #include "mutex-inl.h"
 #include "scoped_thread_state_change-inl.h"
 #include "thread-inl.h"
@@ -34,6 +37,12 @@ namespace art {
 
 using android::base::StringPrintf;
 
+#if ART_USE_FUTEXES
+// The bounds of ReaderWriterMutex::spin_limit_.
+static constexpr int32_t kMinRwMutexSpinLimit = 16;
+static constexpr int32_t kMaxRwMutexSpinLimit = 1024;
+#endif
+
 static Atomic<Locks::ClientCallback*> safe_to_call_abort_callback(nullptr);
 
 Mutex* Locks::abort_lock_ = nullptr;
@@ -139,14 +148,46 @@ class Locks::ScopedExpectedMutexesOnWeakRefAccessLock FINAL {
   const BaseMutex* const mutex_;
 };
 
+// The contentions of the mutexes of a lock level.
+struct LockLevelContentionData {
+  // Number of times a mutex of the level has been contended.
+  Atomic<uint64_t> contention_count;
+  // Sum of time waited by all contenders in ns.
+  Atomic<uint64_t> wait_time;
+  // Number of contentions per bucket of wait time, see kContentionHistogramSize.
+  Atomic<uint64_t> histogram[kContentionHistogramSize];
+};
+static LockLevelContentionData gLockLevelContentionData[kLockLevelCount];
+static const char* const kContentionHistogramNames[kContentionHistogramSize] = {
+  "<10us", "<100us", "<1ms", "<10ms", "<100ms", "<1s", ">=1s"
+};
+
+static void RecordLockLevelContention(LockLevel level, uint64_t nano_time_blocked) {
+  LockLevelContentionData* data = &gLockLevelContentionData[level];
+  data->contention_count.FetchAndAddRelaxed(1u);
+  data->wait_time.FetchAndAddRelaxed(nano_time_blocked);
+  size_t bucket = 0u;
+  for (uint64_t limit = 10 * 1000; bucket != kContentionHistogramSize - 1u; limit *= 10) {
+    if (nano_time_blocked < limit) {
+      break;
+    }
+    ++bucket;
+  }
+  data->histogram[bucket].FetchAndAddRelaxed(1u);
+}
+
 // Scoped class that generates events at the beginning and end of lock contention.
 class ScopedContentionRecorder FINAL : public ValueObject {
  public:
-  ScopedContentionRecorder(BaseMutex* mutex, uint64_t blocked_tid, uint64_t owner_tid)
-      : mutex_(kLogLockContentions ? mutex : nullptr),
+  ScopedContentionRecorder(BaseMutex* mutex,
+                           const void* call_site,
+                           uint64_t blocked_tid,
+                           uint64_t owner_tid)
+      : mutex_(mutex),
+        call_site_(call_site),
         blocked_tid_(kLogLockContentions ? blocked_tid : 0),
         owner_tid_(kLogLockContentions ? owner_tid : 0),
-        start_nano_time_(kLogLockContentions ? NanoTime() : 0) {
+        start_nano_time_(NanoTime()) {
     if (ATRACE_ENABLED()) {
       std::string msg = StringPrintf("Lock contention on %s (owner tid: %" PRIu64 ")",
                                      mutex->GetName(), owner_tid);
@@ -156,14 +197,19 @@ class ScopedContentionRecorder FINAL : public ValueObject {
 
   ~ScopedContentionRecorder() {
     ATRACE_END();
+    uint64_t end_nano_time = NanoTime();
+    RecordLockLevelContention(mutex_->level_, end_nano_time - start_nano_time_);
+    ContentionProfiler::RecordWait(ContentionProfiler::FindMutexSite(mutex_, call_site_),
+                                   end_nano_time - start_nano_time_);
     if (kLogLockContentions) {
-      uint64_t end_nano_time = NanoTime();
       mutex_->RecordContention(blocked_tid_, owner_tid_, end_nano_time - start_nano_time_);
     }
   }
 
  private:
   BaseMutex* const mutex_;
+  // The native pc of the caller of the lock.
+  const void* const call_site_;
   const uint64_t blocked_tid_;
   const uint64_t owner_tid_;
   const uint64_t start_nano_time_;
@@ -221,6 +267,26 @@ void BaseMutex::DumpAll(std::ostream& os) {
   }
 }
 
+void BaseMutex::DumpLockLevelContention(std::ostream& os) {
+  os << "Lock contention by level:\n";
+  for (int i = 0; i != kLockLevelCount; ++i) {
+    const LockLevelContentionData& data = gLockLevelContentionData[i];
+    uint64_t contention_count = data.contention_count.LoadRelaxed();
+    if (contention_count == 0u) {
+      continue;
+    }
+    uint64_t wait_time = data.wait_time.LoadRelaxed();
+    os << "  " << static_cast<LockLevel>(i) << ": contended " << contention_count
+       << " total wait " << PrettyDuration(wait_time)
+       << " average " << PrettyDuration(wait_time / contention_count) << " (";
+    for (size_t bucket = 0; bucket != kContentionHistogramSize; ++bucket) {
+      os << ((bucket == 0u) ? "" : " ") << kContentionHistogramNames[bucket] << ":"
+         << data.histogram[bucket].LoadRelaxed();
+    }
+    os << ")\n";
+  }
+}
+
 void BaseMutex::CheckSafeToWait(Thread* self) {
   if (self == nullptr) {
     CheckUnattachedThread(level_);
@@ -420,7 +486,10 @@ void Mutex::ExclusiveLock(Thread* self) {
         done = state_.CompareExchangeWeakAcquire(0 /* cur_state */, 1 /* new state */);
       } else {
         // Failed to acquire, hang up.
-        ScopedContentionRecorder scr(this, SafeGetTid(self), GetExclusiveOwnerTid());
+        ScopedContentionRecorder scr(this,
+                                     __builtin_return_address(0),
+                                     SafeGetTid(self),
+                                     GetExclusiveOwnerTid());
         num_contenders_++;
         if (UNLIKELY(should_respond_to_empty_checkpoint_request_)) {
           self->CheckEmptyCheckpointFromMutex();
@@ -582,7 +651,8 @@ void Mutex::WakeupToRespondToEmptyCheckpoint() {
 ReaderWriterMutex::ReaderWriterMutex(const char* name, LockLevel level)
     : BaseMutex(name, level)
 #if ART_USE_FUTEXES
-    , state_(0), num_pending_readers_(0), num_pending_writers_(0)
+    , state_(0), num_pending_readers_(0), num_pending_writers_(0),
+    spin_limit_(kMinRwMutexSpinLimit)
 #endif
 {  // NOLINT(whitespace/braces)
 #if !ART_USE_FUTEXES
@@ -614,14 +684,22 @@ void ReaderWriterMutex::ExclusiveLock(Thread* self) {
   AssertNotExclusiveHeld(self);
 #if ART_USE_FUTEXES
   bool done = false;
+  bool spun = false;
   do {
     int32_t cur_state = state_.LoadRelaxed();
     if (LIKELY(cur_state == 0)) {
       // Change state from 0 to -1 and impose load/store ordering appropriate for lock acquisition.
       done =  state_.CompareExchangeWeakAcquire(0 /* cur_state*/, -1 /* new state */);
+    } else if (!spun) {
+      // Spin once before blocking.
+      spun = true;
+      SpinUntilAvailable(/* exclusive */ true);
     } else {
       // Failed to acquire, hang up.
-      ScopedContentionRecorder scr(this, SafeGetTid(self), GetExclusiveOwnerTid());
+      ScopedContentionRecorder scr(this,
+                                   __builtin_return_address(0),
+                                   SafeGetTid(self),
+                                   GetExclusiveOwnerTid());
       ++num_pending_writers_;
       if (UNLIKELY(should_respond_to_empty_checkpoint_request_)) {
         self->CheckEmptyCheckpointFromMutex();
@@ -687,11 +765,16 @@ bool ReaderWriterMutex::ExclusiveLockWithTimeout(Thread* self, int64_t ms, int32
   bool done = false;
   timespec end_abs_ts;
   InitTimeSpec(true, CLOCK_MONOTONIC, ms, ns, &end_abs_ts);
+  bool spun = false;
   do {
     int32_t cur_state = state_.LoadRelaxed();
     if (cur_state == 0) {
       // Change state from 0 to -1 and impose load/store ordering appropriate for lock acquisition.
       done =  state_.CompareExchangeWeakAcquire(0 /* cur_state */, -1 /* new state */);
+    } else if (!spun) {
+      // Spin once before blocking.
+      spun = true;
+      SpinUntilAvailable(/* exclusive */ true);
     } else {
       // Failed to acquire, hang up.
       timespec now_abs_ts;
@@ -700,7 +783,10 @@ bool ReaderWriterMutex::ExclusiveLockWithTimeout(Thread* self, int64_t ms, int32
       if (ComputeRelativeTimeSpec(&rel_ts, end_abs_ts, now_abs_ts)) {
         return false;  // Timed out.
       }
-      ScopedContentionRecorder scr(this, SafeGetTid(self), GetExclusiveOwnerTid());
+      ScopedContentionRecorder scr(this,
+                                   __builtin_return_address(0),
+                                   SafeGetTid(self),
+                                   GetExclusiveOwnerTid());
       ++num_pending_writers_;
       if (UNLIKELY(should_respond_to_empty_checkpoint_request_)) {
         self->CheckEmptyCheckpointFromMutex();
@@ -740,8 +826,14 @@ bool ReaderWriterMutex::ExclusiveLockWithTimeout(Thread* self, int64_t ms, int32
 
 #if ART_USE_FUTEXES
 void ReaderWriterMutex::HandleSharedLockContention(Thread* self, int32_t cur_state) {
+  if (SpinUntilAvailable(/* exclusive */ false)) {
+    return;
+  }
   // Owner holds it exclusively, hang up.
-  ScopedContentionRecorder scr(this, GetExclusiveOwnerTid(), SafeGetTid(self));
+  ScopedContentionRecorder scr(this,
+                               __builtin_return_address(0),
+                               GetExclusiveOwnerTid(),
+                               SafeGetTid(self));
   ++num_pending_readers_;
   if (UNLIKELY(should_respond_to_empty_checkpoint_request_)) {
     self->CheckEmptyCheckpointFromMutex();
@@ -753,6 +845,40 @@ void ReaderWriterMutex::HandleSharedLockContention(Thread* self, int32_t cur_sta
   }
   --num_pending_readers_;
 }
+
+bool ReaderWriterMutex::SpinUntilAvailable(bool exclusive) {
+  const int32_t spin_limit = spin_limit_.LoadRelaxed();
+  // A spinning writer is pending too, for the new readers to yield to it.
+  if (exclusive) {
+    ++num_pending_writers_;
+  }
+  bool available = false;
+  for (int32_t i = 0; i != spin_limit; ++i) {
+    int32_t cur_state = state_.LoadRelaxed();
+    if (exclusive ? (cur_state == 0) : (cur_state >= 0)) {
+      available = true;
+      break;
+    }
+    SpinPause();
+  }
+  if (exclusive) {
+    --num_pending_writers_;
+  }
+  spin_limit_.StoreRelaxed(available ? std::min(spin_limit * 2, kMaxRwMutexSpinLimit)
+                                     : std::max(spin_limit / 2, kMinRwMutexSpinLimit));
+  return available;
+}
+
+void ReaderWriterMutex::YieldToPendingWriter() {
+  const int32_t spin_limit = spin_limit_.LoadRelaxed();
+  for (int32_t i = 0; i != spin_limit; ++i) {
+    if (num_pending_writers_.LoadRelaxed() == 0 || state_.LoadRelaxed() < 0) {
+      // The writers are gone, or one of them got the mutex.
+      return;
+    }
+    SpinPause();
+  }
+}
 #endif
 
 bool ReaderWriterMutex::SharedTryLock(Thread* self) {
@@ -55,6 +55,7 @@ class Thread;
 // [1] http://www.drdobbs.com/parallel/use-lock-hierarchies-to-avoid-deadlock/204801163
 enum LockLevel {
   kLoggingLock = 0,
+  kNativeStackSymbolCacheLock,
   kSwapMutexesLock,
   kUnexpectedSignalLock,
   kThreadSuspendCountLock,
@@ -66,6 +67,11 @@ enum LockLevel {
   kRosAllocGlobalLock,
   kRosAllocBracketLock,
   kRosAllocBulkFreeLock,
+  kAllocationBatchBufferLock,
+  kAllocationBatchBuffersLock,
+  kAllocationBatchLock,
+  kTaggingShardLockLevel,
+  kTaggingTableLockLevel,
   kTaggingLockLevel,
   kTransactionLogLock,
   kJniFunctionTableLock,
@@ -78,6 +84,7 @@ enum LockLevel {
   kReferenceQueueClearedReferencesLock,
   kReferenceProcessorLock,
   kJitDebugInterfaceLock,
+  kLargeObjectFreeListLock,
   kAllocSpaceLock,
   kArenaPoolLock,
   kInternTableLock,
@@ -87,8 +94,12 @@ enum LockLevel {
   kOatFileManagerLock,
   kTracingUniqueMethodsLock,
   kTracingStreamingLock,
+  kGcProfilerStreamingLock,
+  kGcProfilerAllocSiteLock,
+  kPretenureTableLock,
   kDeoptimizedMethodsLock,
   kClassLoaderClassesLock,
+  kMonitorHashCodesLock,
   kDefaultMutexLevel,
   kDexLock,
   kMarkSweepLargeObjectLock,
@@ -137,6 +148,18 @@ const bool kLogLockContentions = false;
 const size_t kContentionLogSize = 4;
 const size_t kContentionLogDataSize = kLogLockContentions ? 1 : 0;
 const size_t kAllMutexDataSize = kLogLockContentions ? 1 : 0;
+// Buckets of the wait times of the contentions per lock level, by powers of ten from 10us.
+const size_t kContentionHistogramSize = 7;
+
+// Hint the processor that this is a spin loop, which frees its resources for the lock owner on
+// SMT cores.
+static inline void SpinPause() {
+#if defined(__i386__) || defined(__x86_64__)
+  __builtin_ia32_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
 
 // Base class for all Mutex implementations
 class BaseMutex {
@@ -145,6 +168,10 @@ class BaseMutex {
     return name_;
   }
 
+  LockLevel GetLevel() const {
+    return level_;
+  }
+
   virtual bool IsMutex() const { return false; }
   virtual bool IsReaderWriterMutex() const { return false; }
   virtual bool IsMutatorMutex() const { return false; }
@@ -153,6 +180,10 @@ class BaseMutex {
 
   static void DumpAll(std::ostream& os);
 
+  // Dump the number and wait times of the contentions per lock level. Unlike DumpAll, they are
+  // always recorded, by the waiting threads only.
+  static void DumpLockLevelContention(std::ostream& os);
+
   bool ShouldRespondToEmptyCheckpointRequest() const {
     return should_respond_to_empty_checkpoint_request_;
   }
@@ -399,6 +430,14 @@ class SHARED_LOCKABLE ReaderWriterMutex : public BaseMutex {
   // Out-of-inline path for handling contention for a SharedLock.
   void HandleSharedLockContention(Thread* self, int32_t cur_state);
 
+  // Spin until the mutex can be acquired exclusively, or in shared mode, for up to spin_limit_
+  // iterations, and adapt spin_limit_ to the outcome. Returns whether the mutex can be acquired.
+  bool SpinUntilAvailable(bool exclusive);
+
+  // Out-of-inline path of a SharedLock letting a pending writer acquire the mutex first. It
+  // spins for a bounded time only, as the thread may already hold the mutex in shared mode.
+  void YieldToPendingWriter();
+
   // -1 implies held exclusive, +ve shared held by state_ many owners.
   AtomicInteger state_;
   // Exclusive owner. Modification guarded by this mutex.
@@ -407,6 +446,8 @@ class SHARED_LOCKABLE ReaderWriterMutex : public BaseMutex {
   AtomicInteger num_pending_readers_;
   // Number of contenders waiting to be the writer.
   AtomicInteger num_pending_writers_;
+  // How long a contender spins before waiting on the futex. Updated racily, it is only a hint.
+  AtomicInteger spin_limit_;
 #else
   pthread_rwlock_t rwlock_;
   volatile uint64_t exclusive_owner_;  // Guarded by rwlock_.
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "autofast_jni_cache.h"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <link.h>
+#include <sstream>
+#include <vector>
+
+#include "android-base/stringprintf.h"
+#include "art_method-inl.h"
+#include "base/bit_utils.h"
+#include "base/logging.h"
+#include "base/unix_file/fd_file.h"
+#include "dex_file.h"
+#include "os.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+
+using android::base::StringAppendF;
+using android::base::StringPrintf;
+
+void AutoFastJniCache::Open(const std::string& filename) {
+  std::string contents;
+  std::vector<std::string> lines;
+  if (ReadFileToString(filename, &contents)) {
+    Split(contents, '\n', &lines);
+  }
+
+  MutexLock mu(Thread::Current(), lock_);
+  if (!filename_.empty()) {
+    return;
+  }
+  if (!lines.empty() && lines[0] == kHeader) {
+    for (size_t i = 1; i < lines.size(); ++i) {
+      Key key;
+      bool is_fast;
+      if (FromLine(lines[i], &key, &is_fast)) {
+        results_.Overwrite(key, is_fast);
+      }
+    }
+  } else {
+    // The file is missing, or written by another version of the analysis.
+    std::unique_ptr<File> file(OS::CreateEmptyFileWriteOnly(filename.c_str()));
+    if (file == nullptr) {
+      VLOG(autofast_jni) << "Could not create " << filename;
+      return;
+    }
+    std::string header = StringPrintf("%s\n", kHeader);
+    bool written = file->WriteFully(header.data(), header.size());
+    if (file->FlushCloseOrErase() != 0 || !written) {
+      VLOG(autofast_jni) << "Could not write " << filename;
+      return;
+    }
+  }
+  VLOG(autofast_jni) << "Loaded " << results_.size() << " auto fast JNI results from " << filename;
+  filename_ = filename;
+}
+
+bool AutoFastJniCache::Lookup(ArtMethod* method, const void* native_method, bool* is_fast) {
+  Key key;
+  if (!GetKey(method, native_method, &key)) {
+    return false;
+  }
+  MutexLock mu(Thread::Current(), lock_);
+  auto it = results_.find(key);
+  if (it == results_.end()) {
+    return false;
+  }
+  *is_fast = it->second;
+  return true;
+}
+
+void AutoFastJniCache::Record(ArtMethod* method, const void* native_method, bool is_fast) {
+  Key key;
+  if (!GetKey(method, native_method, &key)) {
+    return;
+  }
+  MutexLock mu(Thread::Current(), lock_);
+  auto it = results_.find(key);
+  if (it != results_.end() && it->second == is_fast) {
+    return;
+  }
+  results_.Overwrite(key, is_fast);
+  pending_ += ToLine(key, is_fast);
+  pending_ += '\n';
+}
+
+void AutoFastJniCache::Flush() {
+  MutexLock mu(Thread::Current(), lock_);
+  if (filename_.empty() || pending_.empty()) {
+    return;
+  }
+  std::unique_ptr<File> file(OS::OpenFileWithFlags(filename_.c_str(), O_WRONLY | O_APPEND));
+  if (file == nullptr) {
+    VLOG(autofast_jni) << "Could not open " << filename_;
+    return;
+  }
+  bool written = file->WriteFully(pending_.data(), pending_.size());
+  // Keep the results written earlier if this write fails.
+  if (file->FlushClose() != 0 || !written) {
+    VLOG(autofast_jni) << "Could not write " << filename_;
+    return;
+  }
+  pending_.clear();
+}
+
+bool AutoFastJniCache::GetKey(ArtMethod* method, const void* native_method, Key* key) {
+  struct FindLibraryContext {
+    static int Callback(struct dl_phdr_info* info, size_t /* size */, void* data) {
+      FindLibraryContext* context = reinterpret_cast<FindLibraryContext*>(data);
+      bool contains_address = false;
+      for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+        uintptr_t vaddr = info->dlpi_addr + phdr.p_vaddr;
+        if (phdr.p_type == PT_LOAD && vaddr <= context->address &&
+            context->address < vaddr + phdr.p_memsz) {
+          contains_address = true;
+          break;
+        }
+      }
+      if (!contains_address) {
+        return 0;  // Continue iteration.
+      }
+      context->key->offset = context->address - info->dlpi_addr;
+      for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+        if (phdr.p_type != PT_NOTE) {
+          continue;
+        }
+        const uint8_t* note = reinterpret_cast<const uint8_t*>(info->dlpi_addr + phdr.p_vaddr);
+        const uint8_t* end = note + phdr.p_memsz;
+        while (note + sizeof(ElfW(Nhdr)) <= end) {
+          const ElfW(Nhdr)* header = reinterpret_cast<const ElfW(Nhdr)*>(note);
+          const uint8_t* name = note + sizeof(ElfW(Nhdr));
+          const uint8_t* desc = name + RoundUp(header->n_namesz, 4u);
+          const uint8_t* next = desc + RoundUp(header->n_descsz, 4u);
+          if (next > end) {
+            break;
+          }
+          if (header->n_type == NT_GNU_BUILD_ID && header->n_namesz == 4u &&
+              memcmp(name, "GNU", 4u) == 0) {
+            for (size_t j = 0; j < header->n_descsz; j++) {
+              StringAppendF(&context->key->build_id, "%02x", desc[j]);
+            }
+            context->found = true;
+            break;
+          }
+          note = next;
+        }
+      }
+      return 1;  // Stop iteration, the library may have no build id.
+    }
+
+    uintptr_t address;
+    Key* key;
+    bool found;
+  };
+
+  key->build_id.clear();
+  FindLibraryContext context = { reinterpret_cast<uintptr_t>(native_method), key, false };
+  dl_iterate_phdr(FindLibraryContext::Callback, &context);
+  if (!context.found) {
+    // Without a build id, a new version of the library could not be told apart.
+    return false;
+  }
+  key->dex_checksum = method->GetDexFile()->GetLocationChecksum();
+  key->method_idx = method->GetDexMethodIndex();
+  return true;
+}
+
+std::string AutoFastJniCache::ToLine(const Key& key, bool is_fast) {
+  return StringPrintf("%s %" PRIxPTR " %08x %u %d",
+                      key.build_id.c_str(),
+                      key.offset,
+                      key.dex_checksum,
+                      key.method_idx,
+                      is_fast ? 1 : 0);
+}
+
+bool AutoFastJniCache::FromLine(const std::string& line, Key* key, bool* is_fast) {
+  std::istringstream stream(line);
+  int fast = 0;
+  stream >> key->build_id >> std::hex >> key->offset >> key->dex_checksum
+         >> std::dec >> key->method_idx >> fast;
+  if (stream.fail() || (fast != 0 && fast != 1)) {
+    return false;
+  }
+  *is_fast = (fast == 1);
+  return true;
+}
+
+}  // namespace art
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_BINARY_ANALYZER_AUTOFAST_JNI_CACHE_H_
+#define ART_RUNTIME_BINARY_ANALYZER_AUTOFAST_JNI_CACHE_H_
+
+#include <string>
+#include <tuple>
+
+#include "base/mutex.h"
+#include "safe_map.h"
+
+namespace art {
+
+class ArtMethod;
+
+/**
+ * @brief The results of the auto fast JNI detection, kept across the runs of an app.
+ * @details A result is recorded for a native method of a dex file, bound to a function
+ * at an offset of a library with a build id. The results are written to a file next to
+ * the profile of the app, so that the next runs mark the methods found fast as soon as
+ * they are registered, without analyzing them again.
+ */
+class AutoFastJniCache {
+ public:
+  AutoFastJniCache() : lock_("Auto fast JNI cache lock") {}
+
+  /**
+   * @brief Load the results recorded in a file, and record the new results there.
+   * @param filename - the file of the results, created if missing.
+   */
+  void Open(const std::string& filename) REQUIRES(!lock_);
+
+  /**
+   * @brief Get the recorded result of a method.
+   * @param method - the native method.
+   * @param native_method - the function bound to the method.
+   * @param is_fast - set to whether the method was found fast.
+   * @return true if a result was recorded; false otherwise.
+   */
+  bool Lookup(ArtMethod* method, const void* native_method, bool* is_fast)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!lock_);
+
+  /**
+   * @brief Record the result of the analysis of a method, to be written by Flush().
+   * @param method - the native method.
+   * @param native_method - the function bound to the method.
+   * @param is_fast - whether the method was found fast.
+   */
+  void Record(ArtMethod* method, const void* native_method, bool is_fast)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!lock_);
+
+  /**
+   * @brief Write the results recorded since the last call, once a file is open.
+   */
+  void Flush() REQUIRES(!lock_);
+
+ private:
+  struct Key {
+    std::string build_id;
+    uintptr_t offset;
+    uint32_t dex_checksum;
+    uint32_t method_idx;
+
+    bool operator<(const Key& other) const {
+      return std::tie(build_id, offset, dex_checksum, method_idx) <
+             std::tie(other.build_id, other.offset, other.dex_checksum, other.method_idx);
+    }
+  };
+
+  /**
+   * @brief Get the key of a method bound to a function.
+   * @return true if the function is in a library with a build id; false otherwise.
+   */
+  static bool GetKey(ArtMethod* method, const void* native_method, Key* key)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  static std::string ToLine(const Key& key, bool is_fast);
+
+  static bool FromLine(const std::string& line, Key* key, bool* is_fast);
+
+  // Changed along with the analysis, which makes the results of the files written
+  // by the earlier versions be discarded.
+  static constexpr const char* kHeader = "autofast-jni 1";
+
+  Mutex lock_;
+  std::string filename_ GUARDED_BY(lock_);
+  SafeMap<Key, bool> results_ GUARDED_BY(lock_);
+  // The lines of the results not written yet.
+  std::string pending_ GUARDED_BY(lock_);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_BINARY_ANALYZER_AUTOFAST_JNI_CACHE_H_
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "autofast_jni_queue.h"
+
+#include <dlfcn.h>
+
+#include "art_method-inl.h"
+#include "autofast_jni_cache.h"
+#include "base/logging.h"
+#include "binary_analyzer.h"
+#include "jit/jit.h"
+#include "modifiers.h"
+#include "runtime.h"
+#include "scoped_thread_state_change-inl.h"
+#include "thread.h"
+
+namespace art {
+
+class AutoFastJniBatchTask FINAL : public jit::JniTask {
+ public:
+  explicit AutoFastJniBatchTask(const void* library) : library_(library) { }
+
+  ~AutoFastJniBatchTask() { }
+
+  void Run(Thread* self) OVERRIDE {
+    Runtime::Current()->GetAutoFastJniQueue()->RunBatch(self, library_);
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  const void* const library_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(AutoFastJniBatchTask);
+};
+
+bool AutoFastJniQueue::Add(Thread* self, ArtMethod* method, const void* native_method) {
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  if (jit == nullptr) {
+    return false;
+  }
+  // A function known to no library makes its own batch.
+  Dl_info info;
+  const void* library = native_method;
+  if (dladdr(native_method, &info) != 0 && info.dli_fbase != nullptr) {
+    library = info.dli_fbase;
+  }
+
+  {
+    MutexLock mu(self, lock_);
+    if (pending_count_ >= kMaxPendingMethods) {
+      VLOG(autofast_jni) << "Too many pending analyses, not analyzing " << method->PrettyMethod();
+      return false;
+    }
+    ++pending_count_;
+    auto it = batches_.find(library);
+    if (it != batches_.end()) {
+      // The task of the batch has not started yet.
+      it->second.push_back({ method, native_method });
+      return true;
+    }
+    batches_.Put(library, std::vector<PendingMethod>{ { method, native_method } });
+  }
+
+  if (!jit->AddJniTask(self, new AutoFastJniBatchTask(library))) {
+    MutexLock mu(self, lock_);
+    auto it = batches_.find(library);
+    DCHECK(it != batches_.end());
+    pending_count_ -= it->second.size();
+    batches_.erase(it);
+    return false;
+  }
+  return true;
+}
+
+void AutoFastJniQueue::RunBatch(Thread* self, const void* library) {
+  std::vector<PendingMethod> batch;
+  {
+    MutexLock mu(self, lock_);
+    auto it = batches_.find(library);
+    if (it == batches_.end()) {
+      return;
+    }
+    // The methods registered from now on start a new batch.
+    batch = std::move(it->second);
+    batches_.erase(it);
+  }
+
+  AutoFastJniCache* cache = Runtime::Current()->GetAutoFastJniCache();
+  for (const PendingMethod& pending : batch) {
+    {
+      ScopedObjectAccess soa(self);
+      ArtMethod* method = pending.method;
+      bool is_fast =
+          IsFastJNI(method->GetDexMethodIndex(), *method->GetDexFile(), pending.native_method);
+      if (is_fast) {
+        method->SetAccessFlags(method->GetAccessFlags() | kAccFastNative);
+      }
+      cache->Record(method, pending.native_method, is_fast);
+    }
+    MutexLock mu(self, lock_);
+    --pending_count_;
+    ++processed_count_;
+  }
+  // Write the results without holding the mutator lock.
+  cache->Flush();
+}
+
+size_t AutoFastJniQueue::GetPendingCount() {
+  MutexLock mu(Thread::Current(), lock_);
+  return pending_count_;
+}
+
+size_t AutoFastJniQueue::GetProcessedCount() {
+  MutexLock mu(Thread::Current(), lock_);
+  return processed_count_;
+}
+
+void AutoFastJniQueue::DumpForSigQuit(std::ostream& os) {
+  MutexLock mu(Thread::Current(), lock_);
+  os << "Auto fast JNI analyses: " << pending_count_ << " pending, "
+     << processed_count_ << " processed\n";
+}
+
+}  // namespace art
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_BINARY_ANALYZER_AUTOFAST_JNI_QUEUE_H_
+#define ART_RUNTIME_BINARY_ANALYZER_AUTOFAST_JNI_QUEUE_H_
+
+#include <ostream>
+#include <vector>
+
+#include "base/mutex.h"
+#include "safe_map.h"
+
+namespace art {
+
+class ArtMethod;
+class Thread;
+
+/**
+ * @brief The native methods waiting for the auto fast JNI detection.
+ * @details The methods are batched by the library of their function: the methods of a
+ * library registered before its batch starts are analyzed by the same task, on the JNI
+ * thread pool of the JIT, which runs at a lower priority than the JIT compilations.
+ * The functions called by several methods of the batch are then analyzed once, and the
+ * results are written once per batch.
+ */
+class AutoFastJniQueue {
+ public:
+  // The methods waiting beyond it are not analyzed, and keep the normal JNI transitions.
+  static constexpr size_t kMaxPendingMethods = 4096;
+
+  AutoFastJniQueue()
+      : lock_("Auto fast JNI queue lock"), pending_count_(0u), processed_count_(0u) {}
+
+  /**
+   * @brief Queue the analysis of a native method.
+   * @param self - the current thread.
+   * @param method - the native method.
+   * @param native_method - the function bound to the method.
+   * @return true if the method is queued; false if there is no JIT or the queue is full.
+   */
+  bool Add(Thread* self, ArtMethod* method, const void* native_method) REQUIRES(!lock_);
+
+  /**
+   * @brief Analyze the methods queued for a library.
+   * @param self - the current thread.
+   * @param library - the base address of the library.
+   */
+  void RunBatch(Thread* self, const void* library)
+      REQUIRES(!Locks::mutator_lock_) REQUIRES(!lock_);
+
+  // The number of methods queued and not analyzed yet.
+  size_t GetPendingCount() REQUIRES(!lock_);
+
+  // The number of methods analyzed since the start of the runtime.
+  size_t GetProcessedCount() REQUIRES(!lock_);
+
+  void DumpForSigQuit(std::ostream& os) REQUIRES(!lock_);
+
+ private:
+  struct PendingMethod {
+    ArtMethod* method;
+    const void* native_method;
+  };
+
+  Mutex lock_;
+  // The methods waiting for a task, by the base address of their library.
+  SafeMap<const void*, std::vector<PendingMethod>> batches_ GUARDED_BY(lock_);
+  size_t pending_count_ GUARDED_BY(lock_);
+  size_t processed_count_ GUARDED_BY(lock_);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_BINARY_ANALYZER_AUTOFAST_JNI_QUEUE_H_
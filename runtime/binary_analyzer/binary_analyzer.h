@@ -32,11 +32,19 @@ static bool IsFastJNI(uint32_t method_idx, const DexFile& dex_file, const void*
   InstructionSet instruction_set = Runtime::Current()->GetInstructionSet();
   switch (instruction_set) {
     case InstructionSet::kX86:
-    case InstructionSet::kX86_64: {
+    case InstructionSet::kX86_64:
+    case InstructionSet::kArm64: {
+      // The ARM64 analysis shares the CFG model of the x86 one.
       x86::AnalysisResult result = x86::AnalyzeMethod(method_idx, dex_file, fn_ptr);
       if (result == x86::AnalysisResult::kFast) {
         is_fast = true;
         VLOG(autofast_jni) <<  dex_file.PrettyMethod(method_idx) << " is a fast JNI Method";
+      } else if (result == x86::AnalysisResult::kCritical) {
+        // The native code is compiled for the arguments of a normal JNI method, so the
+        // method keeps its calling convention and only skips the transitions.
+        is_fast = true;
+        VLOG(autofast_jni) <<  dex_file.PrettyMethod(method_idx)
+                           << " is a fast JNI Method, eligible to @CriticalNative";
       } else {
         VLOG(autofast_jni) <<  dex_file.PrettyMethod(method_idx) << " is not a fast JNI Method: "
                            << x86::AnalysisResultToStr(result);
@@ -44,7 +52,6 @@ static bool IsFastJNI(uint32_t method_idx, const DexFile& dex_file, const void*
       break;
     }
     case InstructionSet::kArm:
-    case InstructionSet::kArm64:
     case InstructionSet::kMips:
     case InstructionSet::kMips64:
       break;
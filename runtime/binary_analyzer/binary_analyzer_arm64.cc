@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "binary_analyzer_arm64.h"
+
+#include "base/logging.h"
+
+namespace art {
+namespace arm64 {
+
+/**
+ * @brief Check if a register is (part of) X0 or X1, which hold the JNIEnv and the
+ * jclass/jobject argument at the entry of a native method on ARM64.
+ * @param reg - The capstone register.
+ * @return true if it is one of these registers; false otherwise.
+ */
+static bool IsJniArgumentRegister(unsigned int reg) {
+  switch (reg) {
+  case ARM64_REG_X0:
+  case ARM64_REG_W0:
+  case ARM64_REG_X1:
+  case ARM64_REG_W1:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief Check if an instruction uses X0 or X1, explicitly or implicitly, in any way.
+ * @details As on x86-64, a write is counted as a use as well.
+ * @param insn - The decoded instruction.
+ * @return true if the instruction uses these registers; false otherwise.
+ */
+static bool UsesJniArgumentRegisters(const cs_insn* insn) {
+  const cs_detail* detail = insn->detail;
+  for (uint8_t i = 0; i < detail->regs_read_count; i++) {
+    if (IsJniArgumentRegister(detail->regs_read[i])) {
+      return true;
+    }
+  }
+  for (uint8_t i = 0; i < detail->regs_write_count; i++) {
+    if (IsJniArgumentRegister(detail->regs_write[i])) {
+      return true;
+    }
+  }
+  const cs_arm64& insn_arm64 = detail->arm64;
+  for (uint8_t i = 0; i < insn_arm64.op_count; i++) {
+    const cs_arm64_op& op = insn_arm64.operands[i];
+    if (op.type == ARM64_OP_REG && IsJniArgumentRegister(op.reg)) {
+      return true;
+    }
+    if (op.type == ARM64_OP_MEM &&
+        (IsJniArgumentRegister(op.mem.base) || IsJniArgumentRegister(op.mem.index))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Get the target of a direct branch.
+ * @param insn_arm64 - The details of the decoded branch.
+ * @param operand - The index of the target operand.
+ * @param branch_type - The kind of the branch if it is direct.
+ * @param target - Set to the target.
+ * @return kIndirectJump if the target is not an immediate; branch_type otherwise.
+ */
+static int32_t GetBranchTarget(const cs_arm64& insn_arm64,
+                               uint8_t operand,
+                               int32_t branch_type,
+                               const uint8_t** target) {
+  DCHECK_GT(insn_arm64.op_count, operand);
+  if (insn_arm64.operands[operand].type != ARM64_OP_IMM) {
+    return x86::kIndirectJump;
+  }
+  *target = reinterpret_cast<const uint8_t*>(insn_arm64.operands[operand].imm);
+  return branch_type;
+}
+
+ptrdiff_t AnalyzeInstruction(const uint8_t* instr,
+                             x86::MachineBlock* curr_bb,
+                             int32_t* is_bb_end,
+                             const uint8_t** target,
+                             bool* uses_jni_arguments,
+                             Disassembler* disassembler) {
+  *is_bb_end = x86::kNone;
+  if (!disassembler->IsDisassemblerValid()) {
+    return -1;
+  }
+  disassembler->Seek(instr);
+  const cs_insn* insn = disassembler->Next();
+  if (insn == nullptr) {
+    return -1;
+  }
+  *target = instr + insn->size;
+  *uses_jni_arguments = UsesJniArgumentRegisters(insn);
+  const cs_arm64& insn_arm64 = insn->detail->arm64;
+
+  switch (insn->id) {
+  case ARM64_INS_INVALID:
+    *is_bb_end = x86::kUnknown;
+    break;
+  // The exclusive monitor is how locks and atomics are built, and a wait for an event
+  // is how a spin lock waits.
+  case ARM64_INS_LDXR:
+  case ARM64_INS_LDXRB:
+  case ARM64_INS_LDXRH:
+  case ARM64_INS_LDXP:
+  case ARM64_INS_LDAXR:
+  case ARM64_INS_LDAXRB:
+  case ARM64_INS_LDAXRH:
+  case ARM64_INS_LDAXP:
+  case ARM64_INS_STXR:
+  case ARM64_INS_STXRB:
+  case ARM64_INS_STXRH:
+  case ARM64_INS_STXP:
+  case ARM64_INS_STLXR:
+  case ARM64_INS_STLXRB:
+  case ARM64_INS_STLXRH:
+  case ARM64_INS_STLXP:
+  case ARM64_INS_WFE:
+  case ARM64_INS_WFI:
+    *is_bb_end = x86::kLock;
+    break;
+  case ARM64_INS_SVC:
+  case ARM64_INS_HVC:
+  case ARM64_INS_SMC:
+  case ARM64_INS_BRK:
+  case ARM64_INS_HLT:
+    *is_bb_end = x86::kInterrupt;
+    break;
+  case ARM64_INS_B:
+    if (insn_arm64.cc != ARM64_CC_INVALID && insn_arm64.cc != ARM64_CC_AL) {
+      *is_bb_end = GetBranchTarget(insn_arm64, 0u, x86::kConditionalBranch, target);
+    } else {
+      *is_bb_end = GetBranchTarget(insn_arm64, 0u, x86::kUnconditionalBranch, target);
+    }
+    break;
+  case ARM64_INS_CBZ:
+  case ARM64_INS_CBNZ:
+    *is_bb_end = GetBranchTarget(insn_arm64, 1u, x86::kConditionalBranch, target);
+    break;
+  case ARM64_INS_TBZ:
+  case ARM64_INS_TBNZ:
+    *is_bb_end = GetBranchTarget(insn_arm64, 2u, x86::kConditionalBranch, target);
+    break;
+  case ARM64_INS_BR:
+    *is_bb_end = x86::kIndirectJump;
+    break;
+  case ARM64_INS_RET:
+    *is_bb_end = x86::kReturn;
+    break;
+  case ARM64_INS_BL:
+    DCHECK_GE(insn_arm64.op_count, 1);
+    if (insn_arm64.operands[0].type != ARM64_OP_IMM) {
+      *is_bb_end = x86::kIndirectCall;
+    } else {
+      *is_bb_end = x86::kCall;
+      *target = reinterpret_cast<const uint8_t*>(insn_arm64.operands[0].imm);
+    }
+    break;
+  case ARM64_INS_BLR:
+    *is_bb_end = x86::kIndirectCall;
+    break;
+  }
+  x86::AppendInstruction(curr_bb, insn, instr);
+  return insn->size;
+}
+
+const uint8_t* ResolvePltEntry(const uint8_t* function, Disassembler* disassembler) {
+  // The PLT entries are:
+  //   adrp x16, <page of the GOT entry>
+  //   ldr  x17, [x16, <offset of the GOT entry>]
+  //   add  x16, x16, <offset of the GOT entry>
+  //   br   x17
+  disassembler->Seek(function);
+  const cs_insn* insn = disassembler->Next();
+  if (insn == nullptr || insn->id != ARM64_INS_ADRP || insn->detail->arm64.op_count != 2 ||
+      insn->detail->arm64.operands[0].reg != ARM64_REG_X16 ||
+      insn->detail->arm64.operands[1].type != ARM64_OP_IMM) {
+    return nullptr;
+  }
+  uintptr_t page = static_cast<uintptr_t>(insn->detail->arm64.operands[1].imm);
+  insn = disassembler->Next();
+  if (insn == nullptr || insn->id != ARM64_INS_LDR || insn->detail->arm64.op_count != 2 ||
+      insn->detail->arm64.operands[0].reg != ARM64_REG_X17 ||
+      insn->detail->arm64.operands[1].type != ARM64_OP_MEM ||
+      insn->detail->arm64.operands[1].mem.base != ARM64_REG_X16 ||
+      insn->detail->arm64.operands[1].mem.index != ARM64_REG_INVALID) {
+    return nullptr;
+  }
+  const uint8_t* slot = reinterpret_cast<const uint8_t*>(
+      page + static_cast<intptr_t>(insn->detail->arm64.operands[1].mem.disp));
+  insn = disassembler->Next();
+  if (insn == nullptr || insn->id != ARM64_INS_ADD) {
+    return nullptr;
+  }
+  insn = disassembler->Next();
+  if (insn == nullptr || insn->id != ARM64_INS_BR ||
+      insn->detail->arm64.operands[0].reg != ARM64_REG_X17) {
+    return nullptr;
+  }
+  // The dynamic linker of Android binds the GOT entries when loading the library.
+  return *reinterpret_cast<const uint8_t* const*>(slot);
+}
+
+}  // namespace arm64
+}  // namespace art
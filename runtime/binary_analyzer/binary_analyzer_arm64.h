@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_BINARY_ANALYZER_BINARY_ANALYZER_ARM64_H_
+#define ART_RUNTIME_BINARY_ANALYZER_BINARY_ANALYZER_ARM64_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "binary_analyzer_x86.h"
+#include "disassembler.h"
+
+namespace art {
+namespace arm64 {
+
+/**
+ * @brief Analyze how an ARM64 instruction affects control flow (see ControlTransferType).
+ * @details The exclusive loads and stores, and the waits for an event, are found to be
+ * locks; svc, hvc, smc, brk and hlt interrupts.
+ * @param instr - The instruction pointer.
+ * @param curr_bb - Pointer to the Current Basic Block.
+ * @param is_bb_end - Does the instruction mark the end of Basic Block.
+ * @param target - Adress for direct branch/call.
+ * @param uses_jni_arguments - Set if the instruction uses X0 or X1.
+ * @param disassembler - Disassembler to be used for instruction decoding.
+ * @return Size of analyzed instruction in bytes. -1 in case of error.
+ */
+ptrdiff_t AnalyzeInstruction(const uint8_t* instr,
+                             x86::MachineBlock* curr_bb,
+                             int32_t* is_bb_end,
+                             const uint8_t** target,
+                             bool* uses_jni_arguments,
+                             Disassembler* disassembler);
+
+/**
+ * @brief Get the function an ARM64 PLT entry branches to.
+ * @param function - the called address.
+ * @param disassembler - Disassembler to be used for instruction decoding.
+ * @return the function bound to the PLT entry; nullptr if it is not a PLT entry.
+ */
+const uint8_t* ResolvePltEntry(const uint8_t* function, Disassembler* disassembler);
+
+}  // namespace arm64
+}  // namespace art
+
+#endif  // ART_RUNTIME_BINARY_ANALYZER_BINARY_ANALYZER_ARM64_H_
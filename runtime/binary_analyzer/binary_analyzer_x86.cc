@@ -16,12 +16,15 @@
 
 #include "binary_analyzer_x86.h"
 
+#include <cstring>
+#include <dlfcn.h>
 #include <inttypes.h>
 #include <iostream>
 #include <ostream>
 #include <sstream>
 #include "android-base/stringprintf.h"
 #include "base/logging.h"
+#include "binary_analyzer_arm64.h"
 #include "thread.h"
 
 namespace art {
@@ -34,19 +37,61 @@ static constexpr size_t kCallDepthLimit = 3;
 static constexpr size_t kBasicBlockLimit = 20;
 static constexpr size_t kInstructionLimit = 100;
 
-enum ControlTransferType {
-  kNone,                 // Instructions with no control flow transfer.
-  kConditionalBranch,    // Conditional branch.
-  kUnconditionalBranch,  // Unconditional branch.
-  kInterrupt,            // Software Interrupt.
-  kCall,                 // Direct call.
-  kUnknown,              // Unsupported instruction.
-  kIndirectCall,         // Indirect call.
-  kIndirectJump,         // Indirect jump.
-  kReturn,               // Return instruction.
-  kLock,                 // Lock prefix.
-  kCycle,                // Cycling prefix/instruction.
-};
+/**
+ * @brief Check if a register is (part of) RDI or RSI, which hold the JNIEnv and the
+ * jclass/jobject argument at the entry of a native method on x86-64.
+ * @param reg - The capstone register.
+ * @return true if it is one of these registers; false otherwise.
+ */
+static bool IsJniArgumentRegister(unsigned int reg) {
+  switch (reg) {
+  case X86_REG_RDI:
+  case X86_REG_EDI:
+  case X86_REG_DI:
+  case X86_REG_DIL:
+  case X86_REG_RSI:
+  case X86_REG_ESI:
+  case X86_REG_SI:
+  case X86_REG_SIL:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief Check if an instruction uses RDI or RSI, explicitly or implicitly, in any way.
+ * @details A write is counted as a use as well: this keeps the check independent of
+ * the order of the instructions, the callees reading the registers written by their
+ * callers.
+ * @param insn - The decoded instruction.
+ * @return true if the instruction uses these registers; false otherwise.
+ */
+static bool UsesJniArgumentRegisters(const cs_insn* insn) {
+  const cs_detail* detail = insn->detail;
+  for (uint8_t i = 0; i < detail->regs_read_count; i++) {
+    if (IsJniArgumentRegister(detail->regs_read[i])) {
+      return true;
+    }
+  }
+  for (uint8_t i = 0; i < detail->regs_write_count; i++) {
+    if (IsJniArgumentRegister(detail->regs_write[i])) {
+      return true;
+    }
+  }
+  const cs_x86& insn_x86 = detail->x86;
+  for (uint8_t i = 0; i < insn_x86.op_count; i++) {
+    const cs_x86_op& op = insn_x86.operands[i];
+    if (op.type == X86_OP_REG && IsJniArgumentRegister(op.reg)) {
+      return true;
+    }
+    if (op.type == X86_OP_MEM &&
+        (IsJniArgumentRegister(op.mem.base) || IsJniArgumentRegister(op.mem.index))) {
+      return true;
+    }
+  }
+  return false;
+}
 
 /**
  * @brief Analyze how instruction affects control flow (see ControlTransferType)
@@ -54,6 +99,7 @@ enum ControlTransferType {
  * @param curr_bb - Pointer to the Current Basic Block.
  * @param is_bb_end - Does the instruction mark the end of Basic Block.
  * @param target - Adress for direct jump/call.
+ * @param uses_jni_arguments - Set if the instruction uses RDI or RSI.
  * @param disassembler - Disassembler to be used for instruction decoding.
  * @return Size of analyzed instruction in bytes. -1 in case of error.
  */
@@ -61,6 +107,7 @@ ptrdiff_t AnalyzeInstruction(const uint8_t* instr,
                              MachineBlock* curr_bb,
                              int32_t* is_bb_end,
                              const uint8_t** target,
+                             bool* uses_jni_arguments,
                              Disassembler* disassembler) {
   *is_bb_end = kNone;
   if (!disassembler->IsDisassemblerValid()) {
@@ -72,6 +119,7 @@ ptrdiff_t AnalyzeInstruction(const uint8_t* instr,
     return -1;
   }
   *target = instr + insn->size;
+  *uses_jni_arguments = UsesJniArgumentRegisters(insn);
   const cs_x86& insn_x86 = insn->detail->x86;
 
   switch(insn_x86.prefix[0]) {
@@ -147,16 +195,20 @@ ptrdiff_t AnalyzeInstruction(const uint8_t* instr,
     }
     break;
   }
+  AppendInstruction(curr_bb, insn, instr);
+  return insn->size;
+}
+
+void AppendInstruction(MachineBlock* bblock, const cs_insn* insn, const uint8_t* instr) {
   MachineInstruction* ir = new MachineInstruction(std::string(insn->mnemonic) + " " + insn->op_str,
                                                   static_cast<uint8_t>(insn->size),
                                                   reinterpret_cast<const uint8_t*>(instr));
-  MachineInstruction* prev_ir = curr_bb->GetLastInstruction();
+  MachineInstruction* prev_ir = bblock->GetLastInstruction();
   ir->SetPrevInstruction(prev_ir);
   if (prev_ir != nullptr) {
     prev_ir->SetNextInstruction(ir);
   }
-  curr_bb->AddInstruction(ir);
-  return insn->size;
+  bblock->AddInstruction(ir);
 }
 
 MachineBlock* CFGraph::GetCorrectBB(MachineBlock* bblock) {
@@ -317,6 +369,10 @@ MachineBlock* GetTailBB(MachineBlock* bblock) {
   }
 }
 
+static FunctionSummary SummarizeFunction(const uint8_t* function,
+                                         const std::string& name,
+                                         std::vector<const uint8_t*>* call_stack);
+
 /**
  * @brief The Helper function to build CFG for the given method.
  * @param cfg - The CFG.
@@ -326,6 +382,7 @@ MachineBlock* GetTailBB(MachineBlock* bblock) {
  * @param depth - Call depth/levels of call nesting.
  * @param dummy_end - Dummy basic block.
  * @param disasm - Disassembler to be used for instructions decoding.
+ * @param call_stack - The functions being analyzed, callers first.
  */
 void CFGHelper(CFGraph* cfg,
                const uint8_t* instr_ptr,
@@ -334,14 +391,23 @@ void CFGHelper(CFGraph* cfg,
                uint32_t depth,
                MachineBlock* dummy_end,
                Disassembler* disasm,
-               CallGraph* call_graph) {
+               std::vector<const uint8_t*>* call_stack) {
   ptrdiff_t len = 0;
   int32_t is_bb_end = kNone;
   const uint8_t* target = nullptr;
   const uint8_t* ptr = reinterpret_cast<const uint8_t*>(instr_ptr);
   const uint8_t* start_ptr = reinterpret_cast<const uint8_t*>(ptr);
 
-  while ((len = AnalyzeInstruction(ptr, curr_bblock, &is_bb_end, &target, disasm)) > 0) {
+  bool uses_jni_arguments = false;
+  auto analyze_instruction =
+      (Runtime::Current()->GetInstructionSet() == InstructionSet::kArm64)
+          ? arm64::AnalyzeInstruction
+          : AnalyzeInstruction;
+  while ((len = analyze_instruction(
+      ptr, curr_bblock, &is_bb_end, &target, &uses_jni_arguments, disasm)) > 0) {
+    if (uses_jni_arguments) {
+      cfg->SetUsesJniArguments();
+    }
     switch (is_bb_end) {
     case kUnconditionalBranch: {
       // Push the jmp target to backlog.
@@ -393,31 +459,10 @@ void CFGHelper(CFGraph* cfg,
       break;
     }
     case kCall: {
-      // Add the current Basic Block to the CFG.
-      cfg->AddTuple(curr_bblock, start_ptr, reinterpret_cast<const uint8_t*>(ptr));
-      MachineBlock* start_bb = cfg->CreateBBlock(curr_bblock, curr_bblock->GetFunctionStartAddr());
-      MachineBlock* end_bb = cfg->CreateBBlock(nullptr, curr_bblock->GetFunctionStartAddr());
-      start_bb->SetDummy();
-      end_bb->SetDummy();
-      BackLogDs* call_entry = new BackLogDs();
-      call_entry->pred_bb = start_bb;
-      call_entry->ptr = target;
-      call_entry->function_start = target;
-      call_entry->succ_bb = end_bb;
-      call_entry->is_function_start = true;
-      call_entry->call_depth = depth + 1;
-      if (call_entry->call_depth > cfg->GetCallDepth()) {
-        cfg->SetCallDepth(call_entry->call_depth);
-      }
-      backlog->push_back(call_entry);
-      MachineBlock* bb_after_call = cfg->CreateBBlock(end_bb, curr_bblock->GetFunctionStartAddr());
-      curr_bblock = bb_after_call;
-      is_bb_end = kNone;
-      start_ptr = ptr + len;
-      cfg->AddTuple(start_bb, nullptr, nullptr);
-      cfg->AddTuple(end_bb, nullptr, nullptr);
-
-      call_graph->AddCall(curr_bblock->GetFunctionStartAddr(), target);
+      // The callee is analyzed on its own, once per process, and the current
+      // Basic Block goes on after the call.
+      cfg->AddCall(
+          SummarizeFunction(target, StringPrintf("function at %p", target), call_stack));
       break;
     }
     case kReturn: {
@@ -468,14 +513,16 @@ void CFGHelper(CFGraph* cfg,
 }
 
 /**
- * @brief Constructs the CFG for the method by binary analysis.
- * @param ptr - the method function pointer.
- * @param method_name - Pretty Name of method.
- * @return the CFG for the analyzed method.
+ * @brief Constructs the CFG for a function by binary analysis.
+ * @param ptr - the function pointer.
+ * @param method_name - Pretty Name of method, or the address of a callee.
+ * @param call_stack - The functions being analyzed, callers first.
+ * @return the summary of the analyzed function.
  */
-AnalysisResult AnalyzeCFG(const uint8_t* ptr, const std::string& method_name) {
+static FunctionSummary AnalyzeCFG(const uint8_t* ptr,
+                                  const std::string& method_name,
+                                  std::vector<const uint8_t*>* call_stack) {
   CFGraph cfg(method_name);
-  auto call_graph = CallGraph::CreateNew();
   Disassembler disassembler(Runtime::Current()->GetInstructionSet());
   MachineBlock* predecessor_bb = nullptr;
   MachineBlock* start_bb = cfg.CreateBBlock(predecessor_bb, nullptr);
@@ -484,13 +531,13 @@ AnalysisResult AnalyzeCFG(const uint8_t* ptr, const std::string& method_name) {
   MachineBlock* dummy_end = nullptr;
   uint32_t depth = 0;
   std::vector<BackLogDs*> backlog;
-  CFGHelper(&cfg, ptr, curr_bb, &backlog, depth, dummy_end, &disassembler, call_graph.get());
+  CFGHelper(&cfg, ptr, curr_bb, &backlog, depth, dummy_end, &disassembler, call_stack);
 
   if (!cfg.IsStillFast()) {
     for (auto& e : backlog) {
         delete e;
       }
-      return cfg.GetAnalysisState();
+      return cfg.GetSummary();
   }
 
   do {
@@ -504,7 +551,7 @@ AnalysisResult AnalyzeCFG(const uint8_t* ptr, const std::string& method_name) {
         curr_bb = cfg.CreateBBlock(predecessor_bb, entry->function_start);
         dummy_end = entry->succ_bb;
         depth = entry->call_depth;
-        CFGHelper(&cfg, ptr, curr_bb, &backlog, depth, dummy_end, &disassembler, call_graph.get());
+        CFGHelper(&cfg, ptr, curr_bb, &backlog, depth, dummy_end, &disassembler, call_stack);
       }
     }
     delete entry;
@@ -512,13 +559,79 @@ AnalysisResult AnalyzeCFG(const uint8_t* ptr, const std::string& method_name) {
       for (auto& e : backlog) {
         delete e;
       }
-      return cfg.GetAnalysisState();
+      return cfg.GetSummary();
     }
   } while ((!backlog.empty()));
-  if (CallGraph::HasCycles(std::move(call_graph))) {
-    return AnalysisResult::kHasCycles;
+  return cfg.GetSummary();
+}
+
+/**
+ * @brief Get the function a PLT entry jumps to.
+ * @param function - the called address.
+ * @param disassembler - Disassembler to be used for instruction decoding.
+ * @return the function bound to the PLT entry; nullptr if it is not a PLT entry.
+ */
+static const uint8_t* ResolvePltEntry(const uint8_t* function, Disassembler* disassembler) {
+  disassembler->Seek(function);
+  const cs_insn* insn = disassembler->Next();
+  if (insn == nullptr || insn->id != X86_INS_JMP ||
+      insn->detail->x86.op_count != 1 || insn->detail->x86.operands[0].type != X86_OP_MEM) {
+    return nullptr;
+  }
+  // Only the GOT entries addressed from RIP, or absolute, are known. The ones based
+  // on EBX in the position independent code of x86 are not.
+  const auto& mem = insn->detail->x86.operands[0].mem;
+  const uint8_t* slot = nullptr;
+  if (mem.base == X86_REG_RIP && mem.index == X86_REG_INVALID) {
+    slot = function + insn->size + mem.disp;
+  } else if (mem.base == X86_REG_INVALID && mem.index == X86_REG_INVALID) {
+    slot = reinterpret_cast<const uint8_t*>(static_cast<uintptr_t>(mem.disp));
+  } else {
+    return nullptr;
+  }
+  // The dynamic linker of Android binds the GOT entries when loading the library.
+  return *reinterpret_cast<const uint8_t* const*>(slot);
+}
+
+/**
+ * @brief Get the summary of a function, analyzing it if it is not known yet.
+ * @param function - the function pointer.
+ * @param name - the name of the function in the dumps of its CFG.
+ * @param call_stack - The functions being analyzed, callers first.
+ * @return the summary of the function.
+ */
+static FunctionSummary SummarizeFunction(const uint8_t* function,
+                                         const std::string& name,
+                                         std::vector<const uint8_t*>* call_stack) {
+  FunctionSummaries* summaries = FunctionSummaries::Get();
+  FunctionSummary summary;
+  if (summaries->Lookup(function, &summary)) {
+    return summary;
+  }
+  if (std::find(call_stack->begin(), call_stack->end(), function) != call_stack->end()) {
+    return { AnalysisResult::kHasCycles, 0u, false, /* is_complete */ false };
+  }
+  if (call_stack->size() >= kCallDepthLimit + 1) {
+    return { AnalysisResult::kCallDepthLimitExceeded, 0u, false, /* is_complete */ false };
+  }
+
+  Disassembler disassembler(Runtime::Current()->GetInstructionSet());
+  const uint8_t* bound_function =
+      (Runtime::Current()->GetInstructionSet() == InstructionSet::kArm64)
+          ? arm64::ResolvePltEntry(function, &disassembler)
+          : ResolvePltEntry(function, &disassembler);
+  if (bound_function != nullptr) {
+    // The PLT entry only forwards the call.
+    summary = SummarizeFunction(bound_function, name, call_stack);
+  } else {
+    call_stack->push_back(function);
+    summary = AnalyzeCFG(function, name, call_stack);
+    call_stack->pop_back();
+  }
+  if (summary.is_complete) {
+    summaries->Add(function, summary);
   }
-  return cfg.GetAnalysisState();
+  return summary;
 }
 
 bool CFGraph::IsStillFast() const {
@@ -625,7 +738,24 @@ MachineBlock::~MachineBlock() {
 }
 
 AnalysisResult AnalyzeMethod(uint32_t method_idx, const DexFile& dex_file, const void* fn_ptr) {
-  return AnalyzeCFG((unsigned char*) fn_ptr,dex_file.PrettyMethod(method_idx));
+  InstructionSet instruction_set = Runtime::Current()->GetInstructionSet();
+  Disassembler disassembler(instruction_set);
+  if (!disassembler.IsDisassemblerValid()) {
+    // The capstone library is not configured for this architecture.
+    return AnalysisResult::kHasUnknownInstructions;
+  }
+  std::vector<const uint8_t*> call_stack;
+  FunctionSummary summary = SummarizeFunction(
+      reinterpret_cast<const uint8_t*>(fn_ptr), dex_file.PrettyMethod(method_idx), &call_stack);
+  // On x86 the arguments are on the stack, whose slots are not tracked.
+  // @CriticalNative methods only take and return primitives.
+  if (summary.result == AnalysisResult::kFast &&
+      (instruction_set == InstructionSet::kX86_64 || instruction_set == InstructionSet::kArm64) &&
+      !summary.uses_jni_arguments &&
+      strchr(dex_file.GetMethodShorty(method_idx), 'L') == nullptr) {
+    return AnalysisResult::kCritical;
+  }
+  return summary.result;
 }
 
 void MachineBlock::AddPredBBlock(MachineBlock* bblock) {
@@ -706,51 +836,70 @@ void CFGraph::AddTuple(MachineBlock* bblock, const uint8_t* start, const uint8_t
   IncreaseInstructionCnt(bblock->GetInstrCnt());
 }
 
-bool CallGraph::HasCycles(std::unique_ptr<CallGraph> graph) {
-  if (graph->root == nullptr) {
-    return false;
+void CFGraph::AddCall(const FunctionSummary& summary) {
+  if (summary.result != AnalysisResult::kFast) {
+    state_ = summary.result;
+  }
+  uses_jni_arguments_ |= summary.uses_jni_arguments;
+  is_complete_ &= summary.is_complete;
+  if (summary.call_height + 1 > call_depth_) {
+    SetCallDepth(summary.call_height + 1);
   }
-  return graph->SubgraphCheckCycles(graph->root);
 }
 
-void CallGraph::AddCall(const uint8_t* caller, const uint8_t* callee) {
-  auto caller_entry = GetOrAddCallEntry(caller);
-  auto callee_entry = GetOrAddCallEntry(callee);
-  if (root == nullptr) {
-    root = caller_entry;
-  }
-  caller_entry->AddCallee(callee_entry);
+// The libc and libm functions with no locks, system calls nor callbacks.
+static const char* const kAllowlistedFunctions[] = {
+  "memchr", "memcmp", "memcpy", "memmove", "memset",
+  "strchr", "strcmp", "strcpy", "strlen", "strncmp", "strncpy", "strnlen", "strrchr",
+  "abs", "labs", "llabs",
+  "acos", "asin", "atan", "atan2", "cbrt", "ceil", "cos", "cosh", "exp", "expm1",
+  "fabs", "floor", "fmod", "hypot", "log", "log10", "log1p", "pow", "rint", "round",
+  "sin", "sinh", "sqrt", "tan", "tanh", "trunc",
+  "acosf", "asinf", "atanf", "atan2f", "cbrtf", "ceilf", "cosf", "coshf", "expf", "expm1f",
+  "fabsf", "floorf", "fmodf", "hypotf", "logf", "log10f", "log1pf", "powf", "rintf", "roundf",
+  "sinf", "sinhf", "sqrtf", "tanf", "tanhf", "truncf",
+};
+
+FunctionSummaries::FunctionSummaries() : lock_("Auto fast JNI function summaries lock") {
+  MutexLock mu(Thread::Current(), lock_);
+  AddAllowlisted();
+}
+
+FunctionSummaries* FunctionSummaries::Get() {
+  static FunctionSummaries* summaries = new FunctionSummaries();
+  return summaries;
 }
 
-bool CallGraph::SubgraphCheckCycles(CallEntry* node) {
-  // The classic algorithm for checking a directed graph for the presence of cycles in it.
-  if (node->state == NodeState::kAlreadyChecked) {
+bool FunctionSummaries::Lookup(const uint8_t* function, FunctionSummary* summary) {
+  MutexLock mu(Thread::Current(), lock_);
+  auto it = summaries_.find(function);
+  if (it == summaries_.end()) {
     return false;
   }
-  if (node->state == NodeState::kInCurrentPath) {
-    return true;
-  }
+  *summary = it->second;
+  return true;
+}
 
-  node->state = NodeState::kInCurrentPath;
-  for (auto& child : node->callees) {
-    if (SubgraphCheckCycles(child)) {
-      return true;
-    }
-  }
+void FunctionSummaries::Add(const uint8_t* function, const FunctionSummary& summary) {
+  MutexLock mu(Thread::Current(), lock_);
+  summaries_.emplace(function, summary);
+}
 
-  node->state = NodeState::kAlreadyChecked;
-  return false;
+void FunctionSummaries::Clear() {
+  MutexLock mu(Thread::Current(), lock_);
+  summaries_.clear();
+  AddAllowlisted();
 }
 
-CallGraph::CallEntry* CallGraph::GetOrAddCallEntry(const uint8_t* entry_start_address) {
-  auto it = entries.find(entry_start_address);
-  if (it != entries.end()) {
-    return it->second.get();
+void FunctionSummaries::AddAllowlisted() {
+  for (const char* name : kAllowlistedFunctions) {
+    const uint8_t* function = reinterpret_cast<const uint8_t*>(dlsym(RTLD_DEFAULT, name));
+    if (function != nullptr) {
+      // They read their arguments from RDI and RSI, or X0 and X1.
+      summaries_[function] =
+          { AnalysisResult::kFast, 0u, /* uses_jni_arguments */ true, /* is_complete */ true };
+    }
   }
-  auto new_entry = std::unique_ptr<CallEntry>(new CallEntry(entry_start_address));
-  auto new_entry_ptr = new_entry.get();
-  entries[entry_start_address] = std::move(new_entry);
-  return new_entry_ptr;
 }
 
 }  // namespace x86
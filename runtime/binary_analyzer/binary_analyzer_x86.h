@@ -24,11 +24,13 @@
 #include <string>
 #include <sys/uio.h>
 #include <tuple>
+#include <unordered_map>
 
 #include "art_field-inl.h"
 #include "art_method-inl.h"
 #include "utils.h"
 #include "base/logging.h"
+#include "base/mutex.h"
 #include "disassembler.h"
 #include "mirror/class-inl.h"
 #include "mirror/class_loader.h"
@@ -385,56 +387,25 @@ struct BackLogDs {
   uint32_t call_depth;
 };
 
-/**
- * Call graph used to detect recursion since we disabled detection of cycles
- * on CFG level (it was replaced with heuristic which cannot detect recursion).
- */
-class CallGraph {
-  struct CallEntry;
- public:
-  CallGraph(CallGraph&& other) = default;
-  CallGraph& operator=(CallGraph&& other) = default;
-
-  static std::unique_ptr<CallGraph> CreateNew() {
-    return std::unique_ptr<CallGraph>(new CallGraph);
-  }
-
-  static bool HasCycles(std::unique_ptr<CallGraph> graph);
-
-  void AddCall(const uint8_t* caller, const uint8_t* callee);
-
- private:
-  enum class NodeState {
-    kNotVisited,     // Not visited node.
-    kInCurrentPath,  // Already visited during current sub-path.
-    kAlreadyChecked, // Node from checked subgraph.
-  };
-
-  struct CallEntry {
-    CallEntry(const uint8_t* call_entry_address)
-        : call_entry_addr(call_entry_address) {}
-
-    void AddCallee(CallEntry* callee) {
-      callees.insert(callee);
-    }
-
-    const uint8_t* const call_entry_addr;
-    std::unordered_set<CallEntry*> callees;
-    NodeState state = NodeState::kNotVisited;
-  };
-
-  DISALLOW_COPY_AND_ASSIGN(CallGraph);
-  CallGraph() = default;
-
-  bool SubgraphCheckCycles(CallEntry* node);
-  CallEntry* GetOrAddCallEntry(const uint8_t* entry_start_address);
-
-  CallEntry* root = nullptr;
-  std::unordered_map<const uint8_t*, std::unique_ptr<CallEntry>> entries;
+// How an instruction affects the control flow.
+enum ControlTransferType {
+  kNone,                 // Instructions with no control flow transfer.
+  kConditionalBranch,    // Conditional branch.
+  kUnconditionalBranch,  // Unconditional branch.
+  kInterrupt,            // Software Interrupt.
+  kCall,                 // Direct call.
+  kUnknown,              // Unsupported instruction.
+  kIndirectCall,         // Indirect call.
+  kIndirectJump,         // Indirect jump.
+  kReturn,               // Return instruction.
+  kLock,                 // Lock prefix.
+  kCycle,                // Cycling prefix/instruction.
 };
 
 enum class AnalysisResult {
   kFast,
+  // Fast, and neither the JNIEnv nor the jclass/jobject argument is ever used.
+  kCritical,
   kHasLocks,
   kHasCycles,
   kHasInterrupts,
@@ -450,6 +421,8 @@ inline const char* AnalysisResultToStr(AnalysisResult res) {
   switch (res) {
     case AnalysisResult::kFast:
       return "fast";
+    case AnalysisResult::kCritical:
+      return "critical";
     case AnalysisResult::kHasLocks:
       return "has locks";
     case AnalysisResult::kHasCycles:
@@ -474,6 +447,48 @@ inline const char* AnalysisResultToStr(AnalysisResult res) {
   }
 }
 
+/**
+ * @brief The result of the analysis of a function, its callees included.
+ */
+struct FunctionSummary {
+  AnalysisResult result;
+  // The longest chain of calls from the function, 0 for a leaf.
+  uint32_t call_height;
+  // Whether the function uses RDI or RSI, X0 or X1 on ARM64 (see AnalysisResult::kCritical).
+  bool uses_jni_arguments;
+  // False if a recursion or the call depth limit stopped the analysis of a callee,
+  // which makes the summary depend on the callers being analyzed.
+  bool is_complete;
+};
+
+/**
+ * @brief The summaries of the functions analyzed by the process, so that the callees
+ * shared by native methods are analyzed once.
+ * @details The summaries of a set of well-known libc and libm functions are known
+ * upfront: being bounded leaves, they let their callers be fast. The summaries are
+ * dropped when native libraries are unloaded, as their addresses may be reused.
+ */
+class FunctionSummaries {
+ public:
+  static FunctionSummaries* Get();
+
+  bool Lookup(const uint8_t* function, FunctionSummary* summary) REQUIRES(!lock_);
+
+  void Add(const uint8_t* function, const FunctionSummary& summary) REQUIRES(!lock_);
+
+  void Clear() REQUIRES(!lock_);
+
+ private:
+  FunctionSummaries();
+
+  void AddAllowlisted() REQUIRES(lock_);
+
+  Mutex lock_;
+  std::unordered_map<const uint8_t*, FunctionSummary> summaries_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(FunctionSummaries);
+};
+
 /**
  * CFGraph Class has information about the Control Flow Graph.
  */
@@ -539,6 +554,36 @@ class CFGraph {
     state_ = AnalysisResult::kHasIndirectCalls;
   }
 
+  /**
+   * @brief Record that an instruction uses the register of the JNIEnv or of the
+   * jclass/jobject argument.
+   */
+  void SetUsesJniArguments() {
+    uses_jni_arguments_ = true;
+  }
+
+  /**
+   * @brief Get whether the JNIEnv or the jclass/jobject argument may be used.
+   * @return true if an instruction uses their registers; false otherwise.
+   */
+  bool UsesJniArguments() const {
+    return uses_jni_arguments_;
+  }
+
+  /**
+   * @brief Account for a call to a function.
+   * @param summary - the summary of the callee.
+   */
+  void AddCall(const FunctionSummary& summary);
+
+  /**
+   * @brief Get the summary of the function of the CFG.
+   * @return the summary.
+   */
+  FunctionSummary GetSummary() const {
+    return { state_, call_depth_, uses_jni_arguments_, is_complete_ };
+  }
+
   /**
    * @brief Get the levels of call nesting.
    * @return the levels of call nesting.
@@ -680,17 +725,31 @@ class CFGraph {
   uint32_t num_of_instrs_ = 0u;
   uint32_t call_depth_ = 0u;
   AnalysisResult state_ = AnalysisResult::kFast;
+  bool uses_jni_arguments_ = false;
+  bool is_complete_ = true;
   std::vector<MachineBlock*> cfg_bblock_list_;
   std::vector<MachineBlock*> visited_bblock_list_;
   std::string method_name_;
 };
 
+/**
+ * @brief Add a decoded instruction at the end of a Basic Block.
+ * @param bblock - The Basic Block.
+ * @param insn - The decoded instruction.
+ * @param instr - The instruction pointer.
+ */
+void AppendInstruction(MachineBlock* bblock, const cs_insn* insn, const uint8_t* instr);
+
 /**
  * @brief Analyze a method and determine whether it can be marked fast or not.
+ * @details The CFG model is shared by the x86 and ARM64 analyzers, which only differ
+ * in the decoding of the instructions. On x86-64 and ARM64, a fast method with only
+ * primitive arguments and result whose code never uses the registers of its first two
+ * arguments is found critical.
  * @param method_idx - dex method Index.
  * @param dex_file - dex File.
  * @param fn_ptr - Function pointer of method to be analyzed.
- * @return true if fast; false otherwise.
+ * @return kFast or kCritical if fast; the reason why it is not otherwise.
  */
 AnalysisResult AnalyzeMethod(uint32_t method_idx, const DexFile& dex_file, const void* fn_ptr);
 
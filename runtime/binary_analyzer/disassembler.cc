@@ -39,6 +39,10 @@ Disassembler::Disassembler(InstructionSet insn_set) {
     err_ = cs_open(CS_ARCH_X86, CS_MODE_64, &handle_);
     break;
 
+  case kArm64:
+    err_ = cs_open(CS_ARCH_ARM64, CS_MODE_ARM, &handle_);
+    break;
+
   default:
     err_ = CS_ERR_ARCH;
     return;
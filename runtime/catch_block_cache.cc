@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "catch_block_cache.h"
+
+#include "base/bit_utils.h"
+#include "gc/heap.h"
+#include "runtime.h"
+
+namespace art {
+
+Atomic<uint32_t> CatchBlockCache::generation_(0u);
+
+CatchBlockCache::CatchBlockCache()
+    : cached_generation_(generation_.LoadRelaxed()),
+      cached_moving_gc_count_(Runtime::Current()->GetHeap()->GetMovingGCCount()) {
+  Clear();
+}
+
+size_t CatchBlockCache::IndexOf(const uint16_t* dex_pc_ptr, mirror::Class* exception_class) {
+  static_assert(IsPowerOfTwo(kSize), "Catch block cache size is not a power of 2");
+  // Instructions are at least 2 bytes, objects are 8 bytes aligned.
+  uintptr_t hash = (reinterpret_cast<uintptr_t>(dex_pc_ptr) >> 1) ^
+      (reinterpret_cast<uintptr_t>(exception_class) >> kObjectAlignmentShift);
+  return hash & (kSize - 1u);
+}
+
+bool CatchBlockCache::Get(ArtMethod* method,
+                          const uint16_t* dex_pc_ptr,
+                          mirror::Class* exception_class,
+                          uint32_t* found_dex_pc,
+                          bool* has_no_move_exception) {
+  uint32_t generation = generation_.LoadRelaxed();
+  size_t moving_gc_count = Runtime::Current()->GetHeap()->GetMovingGCCount();
+  if (UNLIKELY(generation != cached_generation_ || moving_gc_count != cached_moving_gc_count_)) {
+    Clear();
+    cached_generation_ = generation;
+    cached_moving_gc_count_ = moving_gc_count;
+    return false;
+  }
+  const Entry& entry = entries_[IndexOf(dex_pc_ptr, exception_class)];
+  if (entry.method == method &&
+      entry.dex_pc_ptr == dex_pc_ptr &&
+      entry.exception_class == exception_class) {
+    *found_dex_pc = entry.found_dex_pc;
+    *has_no_move_exception = entry.has_no_move_exception;
+    return true;
+  }
+  return false;
+}
+
+void CatchBlockCache::Set(ArtMethod* method,
+                          const uint16_t* dex_pc_ptr,
+                          mirror::Class* exception_class,
+                          uint32_t found_dex_pc,
+                          bool has_no_move_exception) {
+  // The count is odd while a moving GC runs, and changes when one starts or finishes. With the
+  // count of the last Get(), no class moved while the catch block was looked up.
+  size_t moving_gc_count = Runtime::Current()->GetHeap()->GetMovingGCCount();
+  if (moving_gc_count != cached_moving_gc_count_ || (moving_gc_count & 1u) != 0u) {
+    return;
+  }
+  entries_[IndexOf(dex_pc_ptr, exception_class)] =
+      Entry { method, dex_pc_ptr, exception_class, found_dex_pc, has_no_move_exception };
+}
+
+void CatchBlockCache::Clear() {
+  for (Entry& entry : entries_) {
+    entry = Entry { nullptr, nullptr, nullptr, 0u, false };
+  }
+}
+
+}  // namespace art
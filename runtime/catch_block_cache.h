@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CATCH_BLOCK_CACHE_H_
+#define ART_RUNTIME_CATCH_BLOCK_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+
+class ArtMethod;
+
+namespace mirror {
+class Class;
+}  // namespace mirror
+
+// A small direct-mapped cache of the catch blocks found by ArtMethod::FindCatchBlock, keyed by
+// the method, the throwing instruction and the class of the exception. A hit replaces the
+// decoding of the try items and the resolution of the handler types, so that repeated throws
+// through the same frames, e.g. by code using exceptions for control flow, are cheap. Misses,
+// where the exception goes through the frame, are cached too.
+//
+// Each thread has its own cache, only used by the thread itself, so no synchronization is needed.
+// The classes of the keys are not roots: the cache is cleared when a moving GC may have moved
+// them, when class loaders are unloaded, and when methods are redefined.
+class CatchBlockCache {
+ public:
+  // Number of entries, must be a power of 2.
+  static constexpr size_t kSize = 64;
+
+  CatchBlockCache();
+
+  // Look up the catch block of exception_class for the instruction at dex_pc_ptr of method,
+  // returns false on a miss.
+  bool Get(ArtMethod* method,
+           const uint16_t* dex_pc_ptr,
+           mirror::Class* exception_class,
+           uint32_t* found_dex_pc,
+           bool* has_no_move_exception)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Record a catch block looked up since the last Get(). Ignored if a moving GC started since.
+  void Set(ArtMethod* method,
+           const uint16_t* dex_pc_ptr,
+           mirror::Class* exception_class,
+           uint32_t found_dex_pc,
+           bool has_no_move_exception)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Called before the classes and methods of the keys may be freed or changed.
+  static void InvalidateAll() {
+    generation_.FetchAndAddSequentiallyConsistent(1u);
+  }
+
+ private:
+  struct Entry {
+    ArtMethod* method;
+    const uint16_t* dex_pc_ptr;
+    mirror::Class* exception_class;
+    uint32_t found_dex_pc;
+    bool has_no_move_exception;
+  };
+
+  static size_t IndexOf(const uint16_t* dex_pc_ptr, mirror::Class* exception_class);
+
+  void Clear();
+
+  Entry entries_[kSize];
+  uint32_t cached_generation_;
+  // The moving GC count of the heap when the entries were recorded.
+  size_t cached_moving_gc_count_;
+
+  static Atomic<uint32_t> generation_;
+
+  DISALLOW_COPY_AND_ASSIGN(CatchBlockCache);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CATCH_BLOCK_CACHE_H_
@@ -43,6 +43,7 @@
 #include "base/time_utils.h"
 #include "base/unix_file/fd_file.h"
 #include "base/value_object.h"
+#include "catch_block_cache.h"
 #include "cha.h"
 #include "class_linker-inl.h"
 #include "class_loader_utils.h"
@@ -68,13 +69,16 @@
 #include "imtable-inl.h"
 #include "intern_table.h"
 #include "interpreter/interpreter.h"
+#include "interpreter/interpreter_cache.h"
 #include "java_vm_ext.h"
 #include "jit/jit.h"
 #include "jit/jit_code_cache.h"
 #include "jit/profile_compilation_info.h"
+#include "jit/profile_saver.h"
 #include "jni_internal.h"
 #include "leb128.h"
 #include "linear_alloc.h"
+#include "method_header_cache.h"
 #include "mirror/call_site.h"
 #include "mirror/class-inl.h"
 #include "mirror/class.h"
@@ -359,6 +363,12 @@ static void ShuffleForward(size_t* current_field_idx,
 ClassLinker::ClassLinker(InternTable* intern_table)
     : boot_class_table_(new ClassTable()),
       failed_dex_cache_class_lookups_(0),
+      dex_cache_type_misses_(0u),
+      dex_cache_type_conflicts_(0u),
+      dex_cache_string_misses_(0u),
+      dex_cache_string_conflicts_(0u),
+      dex_cache_field_misses_(0u),
+      dex_cache_field_conflicts_(0u),
       class_roots_(nullptr),
       array_iftable_(nullptr),
       find_array_class_cache_next_victim_(0),
@@ -1812,8 +1822,10 @@ bool ClassLinker::AddImageSpace(
     class_table->InsertOatFile(oat_file);
   }
   if (added_class_table) {
+    // Read the set again from the image rather than adding temp_set, so that the lookups can
+    // search it without the class table lock.
     WriterMutexLock mu(self, *Locks::classlinker_classes_lock_);
-    class_table->AddClassSet(std::move(temp_set));
+    class_table->ReadFromMemory(space->Begin() + class_table_section.Offset());
   }
   if (kIsDebugBuild && app_image) {
     // This verification needs to happen after the classes have been added to the class loader.
@@ -3827,6 +3839,11 @@ mirror::Class* ClassLinker::LookupClass(Thread* self,
                                         const char* descriptor,
                                         size_t hash,
                                         ObjPtr<mirror::ClassLoader> class_loader) {
+  if (class_loader == nullptr) {
+    // The boot class table is never replaced and is guarded by its own lock, the class linker
+    // classes lock is only needed to find the table of a class loader.
+    return ClassTableForClassLoader(nullptr)->Lookup(descriptor, hash);
+  }
   ReaderMutexLock mu(self, *Locks::classlinker_classes_lock_);
   ClassTable* const class_table = ClassTableForClassLoader(class_loader);
   if (class_table != nullptr) {
@@ -7645,6 +7662,10 @@ mirror::String* ClassLinker::ResolveString(const DexFile& dex_file,
   if (resolved != nullptr) {
     return resolved.Ptr();
   }
+  dex_cache_string_misses_.FetchAndAddRelaxed(1u);
+  if (dex_cache->IsStringSlotTaken(string_idx)) {
+    dex_cache_string_conflicts_.FetchAndAddRelaxed(1u);
+  }
   uint32_t utf16_length;
   const char* utf8_data = dex_file.StringDataAndUtf16LengthByIdx(string_idx, &utf16_length);
   ObjPtr<mirror::String> string = intern_table_->InternStrong(utf16_length, utf8_data);
@@ -7720,6 +7741,10 @@ mirror::Class* ClassLinker::ResolveType(const DexFile& dex_file,
   Thread::PoisonObjectPointersIfDebug();
   ObjPtr<mirror::Class> resolved = dex_cache->GetResolvedType(type_idx);
   if (resolved == nullptr) {
+    dex_cache_type_misses_.FetchAndAddRelaxed(1u);
+    if (dex_cache->IsTypeSlotTaken(type_idx)) {
+      dex_cache_type_conflicts_.FetchAndAddRelaxed(1u);
+    }
     // TODO: Avoid this lookup as it duplicates work done in FindClass(). It is here
     // as a workaround for FastNative JNI to avoid AssertNoPendingException() when
     // trying to resolve annotations while an exception may be pending. Bug: 34659969
@@ -7934,6 +7959,10 @@ ArtField* ClassLinker::ResolveField(const DexFile& dex_file,
   if (resolved != nullptr) {
     return resolved;
   }
+  dex_cache_field_misses_.FetchAndAddRelaxed(1u);
+  if (dex_cache->IsFieldSlotTaken(field_idx, image_pointer_size_)) {
+    dex_cache_field_conflicts_.FetchAndAddRelaxed(1u);
+  }
   const DexFile::FieldId& field_id = dex_file.GetFieldId(field_idx);
   Thread* const self = Thread::Current();
   ObjPtr<mirror::Class> klass = ResolveType(dex_file, field_id.class_idx_, dex_cache, class_loader);
@@ -8423,6 +8452,12 @@ void ClassLinker::DumpForSigQuit(std::ostream& os) {
   ReaderMutexLock mu(soa.Self(), *Locks::classlinker_classes_lock_);
   os << "Zygote loaded classes=" << NumZygoteClasses() << " post zygote classes="
      << NumNonZygoteClasses() << "\n";
+  os << "Dex cache misses (conflicts): types=" << dex_cache_type_misses_.LoadRelaxed()
+     << " (" << dex_cache_type_conflicts_.LoadRelaxed() << ") strings="
+     << dex_cache_string_misses_.LoadRelaxed()
+     << " (" << dex_cache_string_conflicts_.LoadRelaxed() << ") fields="
+     << dex_cache_field_misses_.LoadRelaxed()
+     << " (" << dex_cache_field_conflicts_.LoadRelaxed() << ")\n";
 }
 
 class CountClassesVisitor : public ClassLoaderVisitor {
@@ -8703,6 +8738,16 @@ void ClassLinker::CleanupClassLoaders() {
       }
     }
   }
+  if (!to_delete.empty()) {
+    // The methods the threads recorded for the profile saver may be freed.
+    ProfileSaver::NotifyClassLoadersUnloaded();
+    // So may the fields cached by the interpreter.
+    InterpreterCache::NotifyClassLoadersUnloaded();
+    // And the methods and classes of the catch blocks found.
+    CatchBlockCache::InvalidateAll();
+    // And the headers of the code of their oat files.
+    MethodHeaderCache::InvalidateAll();
+  }
   for (ClassLoaderData& data : to_delete) {
     DeleteClassLoader(self, data);
   }
@@ -1257,6 +1257,15 @@ class ClassLinker {
   // the classes into the class_table_ to avoid dex cache based searches.
   Atomic<uint32_t> failed_dex_cache_class_lookups_;
 
+  // Misses of the hashed type, string and field dex caches in the resolution slow paths, and how
+  // many of them were conflicts with another id of the same slot. Dumped on SIGQUIT.
+  Atomic<uint64_t> dex_cache_type_misses_;
+  Atomic<uint64_t> dex_cache_type_conflicts_;
+  Atomic<uint64_t> dex_cache_string_misses_;
+  Atomic<uint64_t> dex_cache_string_conflicts_;
+  Atomic<uint64_t> dex_cache_field_misses_;
+  Atomic<uint64_t> dex_cache_field_conflicts_;
+
   // Well known mirror::Class roots.
   GcRoot<mirror::ObjectArray<mirror::Class>> class_roots_;
 
@@ -22,7 +22,9 @@
 
 namespace art {
 
-ClassTable::ClassTable() : lock_("Class loader classes", kClassLoaderClassesLock) {
+ClassTable::ClassTable()
+    : lock_("Class loader classes", kClassLoaderClassesLock),
+      sets_from_memory_(nullptr) {
   Runtime* const runtime = Runtime::Current();
   classes_.push_back(ClassSet(runtime->GetHashTableMinLoadFactor(),
                               runtime->GetHashTableMaxLoadFactor()));
@@ -129,8 +131,27 @@ size_t ClassTable::NumReferencedNonZygoteClasses() const {
   return classes_.back().Size();
 }
 
+mirror::Class* ClassTable::LookupInSetsFromMemory(const DescriptorHashPair& pair,
+                                                  size_t hash) const {
+  const std::vector<ClassSet>* class_sets = sets_from_memory_.LoadAcquire();
+  if (class_sets != nullptr) {
+    for (const ClassSet& class_set : *class_sets) {
+      auto it = class_set.FindWithHash(pair, hash);
+      if (it != class_set.end()) {
+        return it->Read();
+      }
+    }
+  }
+  return nullptr;
+}
+
 mirror::Class* ClassTable::Lookup(const char* descriptor, size_t hash) {
   DescriptorHashPair pair(descriptor, hash);
+  // Most startup lookups are for image classes, find them without the lock.
+  mirror::Class* image_class = LookupInSetsFromMemory(pair, hash);
+  if (image_class != nullptr) {
+    return image_class;
+  }
   ReaderMutexLock mu(Thread::Current(), lock_);
   for (ClassSet& class_set : classes_) {
     auto it = class_set.FindWithHash(pair, hash);
@@ -253,6 +274,18 @@ bool ClassTable::InsertOatFile(const OatFile* oat_file) {
   return InsertOatFileLocked(oat_file);
 }
 
+const LineTable* ClassTable::LookupLineTable(const DexFile::CodeItem* code_item) {
+  ReaderMutexLock mu(Thread::Current(), lock_);
+  auto it = line_tables_.find(code_item);
+  return (it != line_tables_.end()) ? it->second : nullptr;
+}
+
+const LineTable* ClassTable::InsertLineTable(const DexFile::CodeItem* code_item,
+                                             const LineTable* line_table) {
+  WriterMutexLock mu(Thread::Current(), lock_);
+  return line_tables_.emplace(code_item, line_table).first->second;
+}
+
 bool ClassTable::InsertOatFileLocked(const OatFile* oat_file) {
   if (ContainsElement(oat_files_, oat_file)) {
     return false;
@@ -283,7 +316,23 @@ size_t ClassTable::WriteToMemory(uint8_t* ptr) const {
 
 size_t ClassTable::ReadFromMemory(uint8_t* ptr) {
   size_t read_count = 0;
-  AddClassSet(ClassSet(ptr, /*make copy*/false, &read_count));
+  ClassSet set(ptr, /*make copy*/false, &read_count);
+  WriterMutexLock mu(Thread::Current(), lock_);
+  classes_.insert(classes_.begin(), std::move(set));
+  // Publish the sets read so far, including the new one at the front like in classes_. The sets
+  // do not copy the data in memory, so they are cheap to recreate.
+  set_from_memory_ptrs_.insert(set_from_memory_ptrs_.begin(), ptr);
+  std::unique_ptr<std::vector<ClassSet>> class_sets(new std::vector<ClassSet>());
+  class_sets->reserve(set_from_memory_ptrs_.size());
+  for (const uint8_t* set_ptr : set_from_memory_ptrs_) {
+    size_t set_read_count = 0;
+    ClassSet class_set(set_ptr, /*make copy*/false, &set_read_count);
+    if (!class_set.Empty()) {
+      class_sets->push_back(std::move(class_set));
+    }
+  }
+  sets_from_memory_.StoreRelease(class_sets.get());
+  sets_from_memory_arrays_.push_back(std::move(class_sets));
   return read_count;
 }
 
@@ -17,19 +17,24 @@
 #ifndef ART_RUNTIME_CLASS_TABLE_H_
 #define ART_RUNTIME_CLASS_TABLE_H_
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "atomic.h"
 #include "base/allocator.h"
 #include "base/hash_set.h"
 #include "base/macros.h"
 #include "base/mutex.h"
+#include "dex_file.h"
 #include "gc_root.h"
 #include "obj_ptr.h"
 
 namespace art {
 
+class LineTable;
 class OatFile;
 
 namespace mirror {
@@ -230,12 +235,21 @@ class ClassTable {
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Returns the line table of a code item of the dex files of this table, null if not built yet.
+  const LineTable* LookupLineTable(const DexFile::CodeItem* code_item) REQUIRES(!lock_);
+
+  // Insert the line table of a code item, unless it was inserted already. Returns the line table
+  // of the code item in the table.
+  const LineTable* InsertLineTable(const DexFile::CodeItem* code_item, const LineTable* line_table)
+      REQUIRES(!lock_);
+
   // Combines all of the tables into one class set.
   size_t WriteToMemory(uint8_t* ptr) const
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
-  // Read a table from ptr and put it at the front of the class set.
+  // Read a table from ptr and put it at the front of the class set. The lookups search the tables
+  // read from memory without the lock first, they must not be modified afterwards.
   size_t ReadFromMemory(uint8_t* ptr)
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -265,6 +279,11 @@ class ClassTable {
   void CopyWithoutLocks(const ClassTable& source_table) NO_THREAD_SAFETY_ANALYSIS;
   void InsertWithoutLocks(ObjPtr<mirror::Class> klass) NO_THREAD_SAFETY_ANALYSIS;
 
+  // Return the first class that matches the descriptor in the tables read from memory, without
+  // the lock. Returns null if there are none, the class may still be in the other tables.
+  mirror::Class* LookupInSetsFromMemory(const DescriptorHashPair& pair, size_t hash) const
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   size_t CountDefiningLoaderClasses(ObjPtr<mirror::ClassLoader> defining_loader,
                                     const ClassSet& set) const
       REQUIRES(lock_)
@@ -285,6 +304,14 @@ class ClassTable {
   std::vector<GcRoot<mirror::Object>> strong_roots_ GUARDED_BY(lock_);
   // Keep track of oat files with GC roots associated with dex caches in `strong_roots_`.
   std::vector<const OatFile*> oat_files_ GUARDED_BY(lock_);
+  // The line tables built for the code items, allocated in the LinearAlloc of the class loader.
+  std::unordered_map<const DexFile::CodeItem*, const LineTable*> line_tables_ GUARDED_BY(lock_);
+  // Non-owning views of the class sets read from memory, that is the class tables of the images,
+  // in the order of classes_. Each read publishes a new array, the previous arrays are kept for
+  // the lookups still searching them.
+  Atomic<const std::vector<ClassSet>*> sets_from_memory_;
+  std::vector<const uint8_t*> set_from_memory_ptrs_ GUARDED_BY(lock_);
+  std::vector<std::unique_ptr<std::vector<ClassSet>>> sets_from_memory_arrays_ GUARDED_BY(lock_);
 
   friend class ImageWriter;  // for InsertWithoutLocks.
 };
@@ -155,6 +155,9 @@ TEST_F(ClassTableTest, ClassTable) {
   // Strong roots are not serialized, only classes.
   EXPECT_TRUE(table2.Contains(h_X.Get()));
   EXPECT_TRUE(table2.Contains(h_Y.Get()));
+  // The lookups find the classes read from memory without the lock.
+  EXPECT_EQ(table2.Lookup(descriptor_x, ComputeModifiedUtf8Hash(descriptor_x)), h_X.Get());
+  EXPECT_EQ(table2.Lookup(descriptor_y, ComputeModifiedUtf8Hash(descriptor_y)), h_Y.Get());
 
   // TODO: Add tests for UpdateClass, InsertOatFile.
 }
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "contention_profiler.h"
+
+#include <dlfcn.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "android-base/stringprintf.h"
+
+#include "art_method.h"
+#include "base/time_utils.h"
+
+namespace art {
+
+using android::base::StringPrintf;
+
+// Number of sites, must be a power of 2.
+static constexpr size_t kSiteTableSize = 1024u;
+// Number of slots looked at before giving up on a site.
+static constexpr size_t kMaxProbes = 16u;
+// Number of sites dumped.
+static constexpr size_t kDumpedSites = 20u;
+static constexpr size_t kMutexNameSize = 64u;
+
+struct ContentionProfiler::Site {
+  // The hash of the site once claimed, 0 when free.
+  Atomic<uint64_t> key;
+  // Set by the thread claiming the site once it wrote the fields below.
+  Atomic<bool> ready;
+  // The waiter and the owner of a monitor, named by the dump.
+  ArtMethod* method;
+  uint32_t dex_pc;
+  ArtMethod* owner_method;
+  uint32_t owner_dex_pc;
+  // The native pc of the caller of the lock of a mutex, symbolized by the dump, and the name of
+  // the mutex first seen there. The name is copied, as the mutex may be gone by the dump.
+  const void* call_site;
+  char mutex_name[kMutexNameSize];
+  Atomic<uint64_t> contention_count;
+  Atomic<uint64_t> wait_time;
+  Atomic<uint64_t> max_wait_time;
+};
+
+static ContentionProfiler::Site gSites[kSiteTableSize];
+static Atomic<uint32_t> gMonitorContentions(0u);
+
+static uint64_t HashSite(uintptr_t first, uintptr_t second) {
+  uint64_t hash = (static_cast<uint64_t>(first) * UINT64_C(0x9e3779b97f4a7c15)) ^
+                  (static_cast<uint64_t>(second) * UINT64_C(0xc2b2ae3d27d4eb4f));
+  hash ^= hash >> 31;
+  return (hash != 0u) ? hash : 1u;
+}
+
+// Returns the site of key, or null if the table is full. Sets claimed if the caller claimed the
+// site and must describe it.
+static ContentionProfiler::Site* FindSite(uint64_t key, bool* claimed) {
+  *claimed = false;
+  for (size_t probe = 0; probe != kMaxProbes; ++probe) {
+    ContentionProfiler::Site* site = &gSites[(key + probe) & (kSiteTableSize - 1u)];
+    uint64_t site_key = site->key.LoadRelaxed();
+    if (site_key == 0u) {
+      if (site->key.CompareExchangeStrongRelaxed(0u, key)) {
+        *claimed = true;
+        return site;
+      }
+      site_key = site->key.LoadRelaxed();
+    }
+    if (site_key == key) {
+      return site;
+    }
+  }
+  return nullptr;
+}
+
+bool ContentionProfiler::SampleMonitorContention() {
+  return gMonitorContentions.FetchAndAddRelaxed(1u) % kMonitorSamplingInterval == 0u;
+}
+
+ContentionProfiler::Site* ContentionProfiler::FindMonitorSite(ArtMethod* method,
+                                                              uint32_t dex_pc,
+                                                              ArtMethod* owner_method,
+                                                              uint32_t owner_dex_pc) {
+  bool claimed;
+  Site* site = FindSite(HashSite(reinterpret_cast<uintptr_t>(method), dex_pc), &claimed);
+  if (claimed) {
+    site->method = method;
+    site->dex_pc = dex_pc;
+    site->owner_method = owner_method;
+    site->owner_dex_pc = owner_dex_pc;
+    site->call_site = nullptr;
+    site->ready.StoreRelease(true);
+  }
+  return site;
+}
+
+ContentionProfiler::Site* ContentionProfiler::FindMutexSite(const BaseMutex* mutex,
+                                                            const void* call_site) {
+  bool claimed;
+  Site* site = FindSite(HashSite(reinterpret_cast<uintptr_t>(call_site),
+                                 static_cast<uintptr_t>(mutex->GetLevel())),
+                        &claimed);
+  if (claimed) {
+    site->method = nullptr;
+    site->call_site = call_site;
+    snprintf(site->mutex_name, kMutexNameSize, "%s", mutex->GetName());
+    site->ready.StoreRelease(true);
+  }
+  return site;
+}
+
+void ContentionProfiler::RecordWait(Site* site, uint64_t wait_ns) {
+  if (site == nullptr) {
+    return;
+  }
+  site->contention_count.FetchAndAddRelaxed(1u);
+  site->wait_time.FetchAndAddRelaxed(wait_ns);
+  uint64_t max_wait_ns = site->max_wait_time.LoadRelaxed();
+  while (wait_ns > max_wait_ns &&
+         !site->max_wait_time.CompareExchangeWeakRelaxed(max_wait_ns, wait_ns)) {
+    max_wait_ns = site->max_wait_time.LoadRelaxed();
+  }
+}
+
+static std::string DescribeNativePc(const void* pc) {
+  Dl_info info;
+  if (dladdr(pc, &info) == 0 || info.dli_sname == nullptr) {
+    return StringPrintf("%p", pc);
+  }
+  return StringPrintf("%s+%zu",
+                      info.dli_sname,
+                      reinterpret_cast<uintptr_t>(pc) -
+                          reinterpret_cast<uintptr_t>(info.dli_saddr));
+}
+
+void ContentionProfiler::Dump(std::ostream& os) {
+  std::vector<const Site*> sites;
+  for (const Site& site : gSites) {
+    if (site.ready.LoadAcquire() && site.contention_count.LoadRelaxed() != 0u) {
+      sites.push_back(&site);
+    }
+  }
+  std::sort(sites.begin(), sites.end(), [](const Site* a, const Site* b) {
+    return a->wait_time.LoadRelaxed() > b->wait_time.LoadRelaxed();
+  });
+  os << "Lock contention sites (monitors sampled 1/" << kMonitorSamplingInterval << "):\n";
+  for (size_t i = 0; i != std::min(sites.size(), kDumpedSites); ++i) {
+    const Site* site = sites[i];
+    uint64_t contention_count = site->contention_count.LoadRelaxed();
+    if (site->call_site != nullptr) {
+      os << "  \"" << site->mutex_name << "\" at " << DescribeNativePc(site->call_site);
+    } else {
+      os << "  monitor in " << ArtMethod::PrettyMethod(site->method)
+         << " at dex pc " << site->dex_pc
+         << ", owner in " << ArtMethod::PrettyMethod(site->owner_method)
+         << " at dex pc " << site->owner_dex_pc;
+    }
+    os << ": contended " << contention_count
+       << " total wait " << PrettyDuration(site->wait_time.LoadRelaxed())
+       << " max " << PrettyDuration(site->max_wait_time.LoadRelaxed()) << "\n";
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CONTENTION_PROFILER_H_
+#define ART_RUNTIME_CONTENTION_PROFILER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <iosfwd>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+
+class ArtMethod;
+
+// Aggregates the contentions of the Java monitors and of the internal mutexes by call site, for
+// SIGQUIT to show where the threads wait and for how long. A monitor site is the method and dex
+// pc of the waiter, with the owner first seen there. A mutex site is the native pc of the caller
+// of the lock and the level of the mutex, rather than the mutex itself, as the mutexes of the
+// monitors and other objects are many.
+//
+// The sites live in a fixed table of open addressing, claimed with a compare-and-swap, so that
+// recording takes no lock and allocates nothing, and the mutexes can use it while they wait. The
+// methods are only named by the dump. The contentions of the monitors are sampled, as finding the
+// waiter walks its stack. Sites are never removed: the ones past a full table are dropped.
+class ContentionProfiler {
+ public:
+  // One in this many monitor contentions is recorded.
+  static constexpr uint32_t kMonitorSamplingInterval = 8u;
+
+  struct Site;
+
+  // Returns whether the current monitor contention should be recorded.
+  static bool SampleMonitorContention();
+
+  // Returns the site of a contention on a Java monitor, or null if the table is full.
+  static Site* FindMonitorSite(ArtMethod* method,
+                               uint32_t dex_pc,
+                               ArtMethod* owner_method,
+                               uint32_t owner_dex_pc);
+
+  // Returns the site of a contention on an internal mutex, or null if the table is full.
+  static Site* FindMutexSite(const BaseMutex* mutex, const void* call_site);
+
+  // Record a wait of wait_ns at site.
+  static void RecordWait(Site* site, uint64_t wait_ns);
+
+  // Dump the sites waited on the longest.
+  static void Dump(std::ostream& os) REQUIRES_SHARED(Locks::mutator_lock_);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(ContentionProfiler);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CONTENTION_PROFILER_H_
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "contention_profiler.h"
+
+#include <sstream>
+#include <string>
+
+#include "base/mutex.h"
+#include "base/time_utils.h"
+#include "common_runtime_test.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+
+class ContentionProfilerTest : public CommonRuntimeTest {};
+
+TEST_F(ContentionProfilerTest, RecordMutexWait) {
+  Mutex mutex("contention profiler test lock");
+  static int call_site;
+  ContentionProfiler::Site* site = ContentionProfiler::FindMutexSite(&mutex, &call_site);
+  ASSERT_TRUE(site != nullptr);
+  EXPECT_EQ(site, ContentionProfiler::FindMutexSite(&mutex, &call_site));
+  ContentionProfiler::RecordWait(site, MsToNs(1000));
+  ContentionProfiler::RecordWait(site, MsToNs(3000));
+
+  std::ostringstream oss;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    ContentionProfiler::Dump(oss);
+  }
+  std::string dump = oss.str();
+  size_t pos = dump.find("\"contention profiler test lock\"");
+  ASSERT_NE(std::string::npos, pos) << dump;
+  std::string expected = ": contended 2 total wait " + PrettyDuration(MsToNs(4000)) +
+      " max " + PrettyDuration(MsToNs(3000));
+  EXPECT_NE(std::string::npos, dump.find(expected, pos)) << dump;
+}
+
+TEST_F(ContentionProfilerTest, MutexSiteOfLevel) {
+  // The mutexes of a level locked at a call site, such as those of the monitors, share a site.
+  Mutex mutex("contention profiler test lock");
+  Mutex mutex2("contention profiler test lock");
+  Mutex other_level_mutex("contention profiler test lock", kThreadListLock);
+  static int call_site;
+  ContentionProfiler::Site* site = ContentionProfiler::FindMutexSite(&mutex, &call_site);
+  ASSERT_TRUE(site != nullptr);
+  EXPECT_EQ(site, ContentionProfiler::FindMutexSite(&mutex2, &call_site));
+  EXPECT_NE(site, ContentionProfiler::FindMutexSite(&other_level_mutex, &call_site));
+}
+
+}  // namespace art
@@ -71,6 +71,10 @@ using android::base::StringPrintf;
 
 // The key identifying the debugger to update instrumentation.
 static constexpr const char* kDbgInstrumentationKey = "Debugger";
+// The key of the instrumentation stubs reporting the method entries and exits to the debugger.
+static constexpr const char* kDbgMethodTracingKey = "DebuggerMethodTracing";
+static constexpr uint32_t kMethodTracingEvents = instrumentation::Instrumentation::kMethodEntered |
+                                                 instrumentation::Instrumentation::kMethodExited;
 
 // Limit alloc_record_count to the 2BE value (64k-1) that is the limit of the current protocol.
 static uint16_t CappedAllocRecordCount(size_t alloc_record_count) {
@@ -670,6 +674,9 @@ void Dbg::Disconnected() {
       if (instrumentation_events_ != 0) {
         runtime->GetInstrumentation()->RemoveListener(&gDebugInstrumentationListener,
                                                       instrumentation_events_);
+        if ((instrumentation_events_ & kMethodTracingEvents) != 0) {
+          runtime->GetInstrumentation()->DisableMethodTracing(kDbgMethodTracingKey);
+        }
         instrumentation_events_ = 0;
       }
       if (RequiresDeoptimization()) {
@@ -3162,6 +3169,11 @@ void Dbg::ProcessDeoptimizationRequest(const DeoptimizationRequest& request) {
     case DeoptimizationRequest::kRegisterForEvent:
       VLOG(jdwp) << StringPrintf("Add debugger as listener for instrumentation event 0x%x",
                                  request.InstrumentationEvent());
+      if ((request.InstrumentationEvent() & kMethodTracingEvents) != 0) {
+        // Compiled code reports the method entries and exits through the instrumentation
+        // stubs, nothing needs to be deoptimized.
+        instrumentation->EnableMethodTracing(kDbgMethodTracingKey, /* needs_interpreter */ false);
+      }
       instrumentation->AddListener(&gDebugInstrumentationListener, request.InstrumentationEvent());
       instrumentation_events_ |= request.InstrumentationEvent();
       break;
@@ -3171,6 +3183,10 @@ void Dbg::ProcessDeoptimizationRequest(const DeoptimizationRequest& request) {
       instrumentation->RemoveListener(&gDebugInstrumentationListener,
                                       request.InstrumentationEvent());
       instrumentation_events_ &= ~request.InstrumentationEvent();
+      if ((request.InstrumentationEvent() & kMethodTracingEvents) != 0 &&
+          (instrumentation_events_ & kMethodTracingEvents) == 0) {
+        instrumentation->DisableMethodTracing(kDbgMethodTracingKey);
+      }
       break;
     case DeoptimizationRequest::kFullDeoptimization:
       VLOG(jdwp) << "Deoptimize the world ...";
@@ -27,6 +27,8 @@ enum class DeoptimizationKind {
   kLoopNullBCE,
   kBlockBCE,
   kCHA,
+  kLoopTripCount,
+  kGcMarking,
   kFullFrame,
   kLast = kFullFrame
 };
@@ -40,6 +42,8 @@ inline const char* GetDeoptimizationKindName(DeoptimizationKind kind) {
     case DeoptimizationKind::kLoopNullBCE: return "loop bounds check elimination on null";
     case DeoptimizationKind::kBlockBCE: return "block bounds check elimination";
     case DeoptimizationKind::kCHA: return "class hierarchy analysis";
+    case DeoptimizationKind::kLoopTripCount: return "speculated loop trip count";
+    case DeoptimizationKind::kGcMarking: return "GC marking in a loop without read barriers";
     case DeoptimizationKind::kFullFrame: return "full frame";
   }
   LOG(FATAL) << "Unexpected kind " << static_cast<size_t>(kind);
@@ -43,6 +43,7 @@
 #include "jvalue.h"
 #include "leb128.h"
 #include "os.h"
+#include "type_lookup_table.h"
 #include "utf-inl.h"
 #include "utils.h"
 #include "zip_archive.h"
@@ -636,6 +637,13 @@ uint32_t DexFile::Header::GetVersion() const {
   return atoi(version);
 }
 
+void DexFile::CreateTypeLookupTable() const {
+  DCHECK(oat_dex_file_ == nullptr) << GetLocation();
+  DCHECK(type_lookup_table_ == nullptr) << GetLocation();
+  // Null if there are no class defs, or too many for a table.
+  type_lookup_table_ = TypeLookupTable::Create(*this);
+}
+
 const DexFile::ClassDef* DexFile::FindClassDef(dex::TypeIndex type_idx) const {
   size_t num_class_defs = NumClassDefs();
   // Fast path for rare no class defs case.
@@ -1141,6 +1149,8 @@ bool DexFile::DecodeDebugPositionInfo(const CodeItem* code_item, DexDebugNewPosi
     return false;
   }
 
+  // The stream is decoded a word at a time away from the end of the file.
+  const uint8_t* const end = Begin() + Size();
   PositionInfo entry = PositionInfo();
   entry.line_ = DecodeUnsignedLeb128(&stream);
   uint32_t parameters_size = DecodeUnsignedLeb128(&stream);
@@ -1154,10 +1164,10 @@ bool DexFile::DecodeDebugPositionInfo(const CodeItem* code_item, DexDebugNewPosi
       case DBG_END_SEQUENCE:
         return true;  // end of stream.
       case DBG_ADVANCE_PC:
-        entry.address_ += DecodeUnsignedLeb128(&stream);
+        entry.address_ += DecodeUnsignedLeb128Fast(&stream, end);
         break;
       case DBG_ADVANCE_LINE:
-        entry.line_ += DecodeSignedLeb128(&stream);
+        entry.line_ += DecodeSignedLeb128Fast(&stream, end);
         break;
       case DBG_START_LOCAL:
         DecodeUnsignedLeb128(&stream);  // reg.
@@ -1421,16 +1431,18 @@ void ClassDataItemIterator::ReadClassDataHeader() {
 }
 
 void ClassDataItemIterator::ReadClassDataField() {
-  field_.field_idx_delta_ = DecodeUnsignedLeb128(&ptr_pos_);
-  field_.access_flags_ = DecodeUnsignedLeb128(&ptr_pos_);
+  const uint8_t* end = dex_file_.Begin() + dex_file_.Size();
+  field_.field_idx_delta_ = DecodeUnsignedLeb128Fast(&ptr_pos_, end);
+  field_.access_flags_ = DecodeUnsignedLeb128Fast(&ptr_pos_, end);
   // The user of the iterator is responsible for checking if there
   // are unordered or duplicate indexes.
 }
 
 void ClassDataItemIterator::ReadClassDataMethod() {
-  method_.method_idx_delta_ = DecodeUnsignedLeb128(&ptr_pos_);
-  method_.access_flags_ = DecodeUnsignedLeb128(&ptr_pos_);
-  method_.code_off_ = DecodeUnsignedLeb128(&ptr_pos_);
+  const uint8_t* end = dex_file_.Begin() + dex_file_.Size();
+  method_.method_idx_delta_ = DecodeUnsignedLeb128Fast(&ptr_pos_, end);
+  method_.access_flags_ = DecodeUnsignedLeb128Fast(&ptr_pos_, end);
+  method_.code_off_ = DecodeUnsignedLeb128Fast(&ptr_pos_, end);
   if (last_idx_ != 0 && method_.method_idx_delta_ == 0) {
     LOG(WARNING) << "Duplicate method in " << dex_file_.GetLocation();
   }
@@ -35,6 +35,7 @@ class MemMap;
 class OatDexFile;
 class Signature;
 class StringPiece;
+class TypeLookupTable;
 class ZipArchive;
 
 class DexFile {
@@ -1089,6 +1090,15 @@ class DexFile {
     oat_dex_file_ = oat_dex_file;
   }
 
+  // Type lookup table of a dex file opened without an oat file, or null.
+  const TypeLookupTable* GetTypeLookupTable() const {
+    return type_lookup_table_.get();
+  }
+
+  // Build the type lookup table of a dex file opened without an oat file, so that class
+  // lookups do not scan the class defs. Must be called before the dex file is shared.
+  void CreateTypeLookupTable() const;
+
   // Utility methods for reading integral values from a buffer.
   static int32_t ReadSignedInt(const uint8_t* ptr, int zwidth);
   static uint32_t ReadUnsignedInt(const uint8_t* ptr, int zwidth, bool fill_on_right);
@@ -1233,6 +1243,9 @@ class DexFile {
   // null.
   mutable const OatDexFile* oat_dex_file_;
 
+  // Without an oat file, the type lookup table built by CreateTypeLookupTable(), if any.
+  mutable std::unique_ptr<const TypeLookupTable> type_lookup_table_;
+
   friend class DexFileVerifierTest;
   friend class OatWriter;
   ART_FRIEND_TEST(ClassLinkerTest, RegisterDexFileName);  // for constructor
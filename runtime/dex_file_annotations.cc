@@ -26,6 +26,7 @@
 #include "dex_file-inl.h"
 #include "jni_internal.h"
 #include "jvalue-inl.h"
+#include "line_table.h"
 #include "mirror/field.h"
 #include "mirror/method.h"
 #include "reflection.h"
@@ -1511,6 +1512,10 @@ int32_t GetLineNumFromPC(const DexFile* dex_file, ArtMethod* method, uint32_t re
   DCHECK(code_item != nullptr) << method->PrettyMethod() << " " << dex_file->GetLocation();
 
   // A method with no line number info should return -1
+  if (dex_file == method->GetDexFile()) {
+    const LineTable* line_table = LineTable::ForMethod(method);
+    return (line_table != nullptr) ? line_table->GetLineNumber(rel_pc) : -1;
+  }
   DexFile::LineNumFromPcContext context(rel_pc, -1);
   dex_file->DecodeDebugPositionInfo(code_item, DexFile::LineNumForPcCb, &context);
   return context.line_num_;
@@ -119,7 +119,7 @@ constexpr bool IsInstructionIGetOrIPut(Instruction::Code code) {
 
 constexpr bool IsInstructionIGetQuickOrIPutQuick(Instruction::Code code) {
   return (code >= Instruction::IGET_QUICK && code <= Instruction::IPUT_OBJECT_QUICK) ||
-      (code >= Instruction::IPUT_BOOLEAN_QUICK && code <= Instruction::IGET_SHORT_QUICK);
+      (code >= Instruction::IPUT_BOOLEAN_QUICK && code <= Instruction::IGET_OBJECT_QUICK_IF_NEZ);
 }
 
 constexpr bool IsInstructionSGetOrSPut(Instruction::Code code) {
@@ -189,6 +189,7 @@ inline DexMemAccessType IGetQuickOrIPutQuickMemAccessType(Instruction::Code code
     case Instruction::IGET_WIDE_QUICK: case Instruction::IPUT_WIDE_QUICK:
       return kDexMemAccessWide;
     case Instruction::IGET_OBJECT_QUICK: case Instruction::IPUT_OBJECT_QUICK:
+    case Instruction::IGET_OBJECT_QUICK_IF_EQZ: case Instruction::IGET_OBJECT_QUICK_IF_NEZ:
       return kDexMemAccessObject;
     case Instruction::IGET_BOOLEAN_QUICK: case Instruction::IPUT_BOOLEAN_QUICK:
       return kDexMemAccessBoolean;
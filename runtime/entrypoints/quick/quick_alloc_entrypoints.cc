@@ -40,7 +40,8 @@ static ALWAYS_INLINE inline mirror::Object* artAllocObjectFromCode(
   DCHECK(klass != nullptr);
   if (kUseTlabFastPath && !kInstrumented && allocator_type == gc::kAllocatorTypeTLAB) {
     if (kInitialized || klass->IsInitialized()) {
-      if (!kFinalize || !klass->IsFinalizable()) {
+      // The pretenured classes are allocated in the old generation, by the slow path.
+      if ((!kFinalize || !klass->IsFinalizable()) && !klass->IsPretenured()) {
         size_t byte_count = klass->GetObjectSize();
         byte_count = RoundUp(byte_count, gc::space::BumpPointerSpace::kAlignment);
         mirror::Object* obj;
@@ -199,6 +200,10 @@ void SetQuickAllocEntryPointsInstrumented(bool instrumented) {
   entry_points_instrumented = instrumented;
 }
 
+bool AreQuickAllocEntryPointsInstrumented() {
+  return entry_points_instrumented;
+}
+
 void ResetQuickAllocEntryPoints(QuickEntryPoints* qpoints, bool is_marking) {
 #if !defined(__APPLE__) || !defined(__LP64__)
   switch (entry_points_allocator) {
@@ -29,6 +29,7 @@
 #include "imtable-inl.h"
 #include "interpreter/interpreter.h"
 #include "instrumentation.h"
+#include "jit/jit.h"
 #include "linear_alloc.h"
 #include "method_bss_mapping.h"
 #include "method_handles.h"
@@ -2177,6 +2178,12 @@ extern "C" TwoWordReturn artQuickGenericJniTrampoline(Thread* self, ArtMethod**
     self->ClearException();
   }
   bool normal_native = !critical_native && !fast_native;
+  // Count the call, the JIT compiles the JNI stub of the hot native methods, which
+  // saves the lookups above and the building of the frame below.
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  if (jit != nullptr && Runtime::Current()->UseJitCompilation()) {
+    jit->AddSamples(self, called, 1, /* with_backedges */ false);
+  }
   // Restore the initial ArtMethod pointer at `*sp`.
   *sp = called;
 
@@ -138,7 +138,9 @@ class EntrypointsOrderTest : public CommonRuntimeTest {
                         sizeof(void*) * kLockLevelCount);
     EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, flip_function, method_verifier, sizeof(void*));
     EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, method_verifier, thread_local_mark_stack, sizeof(void*));
-    EXPECT_OFFSET_DIFF(Thread, tlsPtr_.thread_local_mark_stack, Thread, wait_mutex_, sizeof(void*),
+    EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, thread_local_mark_stack, inline_alloc_disabled,
+                        sizeof(void*));
+    EXPECT_OFFSET_DIFF(Thread, tlsPtr_.inline_alloc_disabled, Thread, wait_mutex_, sizeof(size_t),
                        thread_tlsptr_end);
   }
 
@@ -16,7 +16,10 @@
 
 #include "aging_table.h"
 
+#include <algorithm>
+
 #include "android-base/stringprintf.h"
+#include "atomic.h"
 #include "mem_map.h"
 #include "mirror/object-inl.h"
 #include "base/logging.h"
@@ -27,6 +30,11 @@ namespace accounting {
 
 // Keep the same object alignment as bump pointer space.
 static constexpr size_t kBumpPointerSpaceAlignment = 8;
+// The ages are nibbles.
+static constexpr size_t kAgesPerByte = 2;
+static constexpr size_t kAgeBits = 4;
+static constexpr uint8_t kAgeMask = (1u << kAgeBits) - 1u;
+static_assert(AgingTable::kMaxAge == kAgeMask, "The maximum age must fit a nibble");
 
 AgingTable::AgingTable(MemMap* mem_map, size_t table_size, uint8_t* space_begin,
                        uint8_t* space_end, const std::string& name)
@@ -46,7 +54,8 @@ AgingTable::~AgingTable() {
 
 AgingTable* AgingTable::Create(const std::string& name, size_t capacity, uint8_t* space_begin,
                                uint8_t* space_end) {
-  const size_t table_size = capacity / kBumpPointerSpaceAlignment;
+  const size_t table_size = RoundUp(capacity / kBumpPointerSpaceAlignment, kAgesPerByte) /
+      kAgesPerByte;
   std::string error_msg;
   std::unique_ptr<MemMap> mem_map(MemMap::MapAnonymous(name.c_str(), nullptr, table_size,
                                                        PROT_READ | PROT_WRITE, false, false,
@@ -61,7 +70,8 @@ AgingTable* AgingTable::Create(const std::string& name, size_t capacity, uint8_t
 AgingTable* AgingTable::CreateFromMemMap(const std::string& name, MemMap* mem_map,
                                     size_t capacity, uint8_t* space_begin, uint8_t* space_end) {
   CHECK(mem_map != nullptr);
-  const size_t table_size = capacity / kBumpPointerSpaceAlignment;
+  const size_t table_size = RoundUp(capacity / kBumpPointerSpaceAlignment, kAgesPerByte) /
+      kAgesPerByte;
   return new AgingTable(mem_map, table_size, space_begin, space_end, name);
 }
 
@@ -70,7 +80,8 @@ uint8_t AgingTable::GetObjectAge(mirror::Object* obj) {
       return 0;
   }
   size_t offset = OffsetFromObject(obj);
-  return *(begin_ + offset);
+  uint8_t ages = reinterpret_cast<Atomic<uint8_t>*>(begin_ + offset / kAgesPerByte)->LoadRelaxed();
+  return (ages >> ((offset % kAgesPerByte) * kAgeBits)) & kAgeMask;
 }
 
 void AgingTable::IncreaseObjectAge(mirror::Object* obj, uint8_t old_age) {
@@ -78,7 +89,16 @@ void AgingTable::IncreaseObjectAge(mirror::Object* obj, uint8_t old_age) {
       return;
   }
   size_t offset = OffsetFromObject(obj);
-  *(begin_ + offset) = old_age + 1;
+  const size_t shift = (offset % kAgesPerByte) * kAgeBits;
+  const uint8_t age = std::min(static_cast<uint8_t>(old_age + 1u), kMaxAge);
+  // The other nibble of the byte may be the age of an object copied by another thread.
+  Atomic<uint8_t>* ages = reinterpret_cast<Atomic<uint8_t>*>(begin_ + offset / kAgesPerByte);
+  uint8_t old_ages;
+  uint8_t new_ages;
+  do {
+    old_ages = ages->LoadRelaxed();
+    new_ages = static_cast<uint8_t>((old_ages & ~(kAgeMask << shift)) | (age << shift));
+  } while (!ages->CompareExchangeWeakRelaxed(old_ages, new_ages));
 }
 
 size_t AgingTable::OffsetFromObject(mirror::Object* obj) {
@@ -86,13 +106,19 @@ size_t AgingTable::OffsetFromObject(mirror::Object* obj) {
   CHECK_LE(space_begin_, obj_ptr);
   CHECK_GT(space_end_, obj_ptr);
   size_t offset = (obj_ptr - space_begin_) / kBumpPointerSpaceAlignment;
-  CHECK_LT(offset, size_) << "object: " << obj_ptr << ", space: " << space_begin_ << ", " << space_end_;
+  CHECK_LT(offset / kAgesPerByte, size_)
+      << "object: " << obj_ptr << ", space: " << space_begin_ << ", " << space_end_;
   return offset;
 }
 
-void AgingTable::Reset() {
+void AgingTable::Reset(uint8_t* end) {
   CHECK(mem_map_.get() != nullptr) << "backing storage for this aging table does not exist";
-  mem_map_->MadviseDontNeedAndZero();
+  CHECK_LE(space_begin_, end);
+  CHECK_LE(end, space_end_);
+  size_t ages = RoundUp(static_cast<size_t>(end - space_begin_), kBumpPointerSpaceAlignment) /
+      kBumpPointerSpaceAlignment;
+  // Only the ages of the objects allocated were set. The pages past them are left untouched.
+  ZeroAndReleasePages(begin_, std::min(RoundUp(ages, kAgesPerByte) / kAgesPerByte, size_));
 }
 
 }  // namespace accounting
@@ -30,8 +30,12 @@ namespace mirror {
 namespace gc {
 namespace accounting {
 
+// The ages of the objects of a space, packed in a nibble per object alignment slot. The ages
+// saturate at kMaxAge.
 class AgingTable {
  public:
+  static constexpr uint8_t kMaxAge = 15;
+
   // Create and initialize an age_table with capacity. Storage is allocated with a MemMap.
   static AgingTable* Create(const std::string& name, size_t capacity,
                             uint8_t* space_begin, uint8_t* space_end);
@@ -46,10 +50,11 @@ class AgingTable {
 
   // Return age of an object.
   uint8_t GetObjectAge(mirror::Object* obj);
-  // Increase age of an object by 1.
+  // Set the age of an object to old_age + 1, up to kMaxAge. Thread safe against the updates of
+  // the ages of the other objects.
   void IncreaseObjectAge(mirror::Object* obj, uint8_t old_age);
-  // Zero aging table.
-  void Reset();
+  // Zero the ages of the objects below end, releasing the pages of the aging table in between.
+  void Reset(uint8_t* end);
 
  private:
   AgingTable(MemMap* mem_map, size_t table_size, uint8_t* space_begin,
@@ -58,7 +63,7 @@ class AgingTable {
   std::unique_ptr<MemMap> mem_map_;
   // The aging table itself.
   uint8_t* begin_;
-  // Size of the aging table.
+  // Size of the aging table, in bytes.
   size_t size_;
   // The base address of the space, which corresponds to the first byte in this aging table.
   uint8_t* space_begin_;
@@ -66,7 +71,7 @@ class AgingTable {
   // Name of this aging table.
   std::string name_;
 
-  // Convert to address in age table from an object.
+  // Convert to the index of the age of an object, two ages per byte of the aging table.
   size_t OffsetFromObject(mirror::Object* obj);
 };
 
@@ -59,15 +59,24 @@ constexpr uint8_t CardTable::kCardDirty;
  * byte is equal to GC_DIRTY_CARD. See CardTable::Create for details.
  */
 
-CardTable* CardTable::Create(const uint8_t* heap_begin, size_t heap_capacity) {
+CardTable* CardTable::Create(const uint8_t* heap_begin, size_t heap_capacity,
+                             bool use_huge_pages) {
   ScopedTrace trace(__PRETTY_FUNCTION__);
   /* Set up the card table */
   size_t capacity = heap_capacity / kCardSize;
   /* Allocate an extra 256 bytes to allow fixed low-byte of base */
   std::string error_msg;
-  std::unique_ptr<MemMap> mem_map(
-      MemMap::MapAnonymous("card table", nullptr, capacity + 256, PROT_READ | PROT_WRITE,
-                           false, false, &error_msg));
+  std::unique_ptr<MemMap> mem_map;
+  if (use_huge_pages) {
+    mem_map.reset(MemMap::MapAnonymousAligned("card table", capacity + 256, PROT_READ | PROT_WRITE,
+                                              false, MemMap::kHugePageSize, &error_msg));
+    if (mem_map != nullptr) {
+      mem_map->MadviseHugePages();
+    }
+  } else {
+    mem_map.reset(MemMap::MapAnonymous("card table", nullptr, capacity + 256,
+                                       PROT_READ | PROT_WRITE, false, false, &error_msg));
+  }
   CHECK(mem_map.get() != nullptr) << "couldn't allocate card table: " << error_msg;
   // All zeros is the correct initial value; all clean. Anonymous mmaps are initialized to zero, we
   // don't clear the card table to avoid unnecessary pages being allocated
@@ -110,7 +119,9 @@ void CardTable::ClearCardRange(uint8_t* start, uint8_t* end) {
   static_assert(kCardClean == 0, "kCardClean must be 0");
   uint8_t* start_card = CardFromAddr(start);
   uint8_t* end_card = CardFromAddr(end);
-  ZeroAndReleasePages(start_card, end_card - start_card);
+  ZeroAndReleasePages(start_card,
+                      end_card - start_card,
+                      mem_map_->UsesHugePages() ? MemMap::kHugePageSize : kPageSize);
 }
 
 bool CardTable::AddrIsInCardTable(const void* addr) const {
@@ -53,7 +53,10 @@ class CardTable {
   static constexpr uint8_t kCardDirty = 0x70;
   static constexpr uint8_t kCardAged = kCardDirty - 1;
 
-  static CardTable* Create(const uint8_t* heap_begin, size_t heap_capacity);
+  // With use_huge_pages, the card table is aligned by and backed by huge pages.
+  static CardTable* Create(const uint8_t* heap_begin,
+                           size_t heap_capacity,
+                           bool use_huge_pages = false);
   ~CardTable();
 
   // Set the card associated with the given address to GC_CARD_DIRTY.
@@ -132,6 +135,10 @@ class CardTable {
 
   bool AddrIsInCardTable(const void* addr) const;
 
+  const MemMap* GetMemMap() const {
+    return mem_map_.get();
+  }
+
  private:
   CardTable(MemMap* begin, uint8_t* biased_begin, size_t offset);
 
@@ -18,6 +18,7 @@
 
 #include <memory>
 
+#include "atomic_stack.h"
 #include "base/stl_util.h"
 #include "card_table-inl.h"
 #include "heap_bitmap.h"
@@ -168,6 +169,99 @@ void RememberedSet::UpdateAndMarkReferences(space::ContinuousSpace* target_space
   }
 }
 
+// Finds whether an object has a reference to the target space, without marking it.
+class RememberedSetPreCleanVisitor {
+ public:
+  RememberedSetPreCleanVisitor(space::ContinuousSpace* target_space,
+                               bool* const contains_reference_to_target_space)
+      : target_space_(target_space),
+        contains_reference_to_target_space_(contains_reference_to_target_space) {}
+
+  void operator()(ObjPtr<mirror::Object> obj) const REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (!*contains_reference_to_target_space_) {
+      obj->VisitReferences(*this, *this);
+    }
+  }
+
+  void operator()(ObjPtr<mirror::Object> obj,
+                  MemberOffset offset,
+                  bool is_static ATTRIBUTE_UNUSED) const
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    mirror::Object* ref = obj->GetFieldObject<mirror::Object, kVerifyNone, kWithoutReadBarrier>(
+        offset);
+    if (target_space_->HasAddress(ref)) {
+      *contains_reference_to_target_space_ = true;
+    }
+  }
+
+  void operator()(ObjPtr<mirror::Class> klass ATTRIBUTE_UNUSED, ObjPtr<mirror::Reference> ref) const
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (target_space_->HasAddress(ref->GetReferent<kWithoutReadBarrier>())) {
+      *contains_reference_to_target_space_ = true;
+    }
+  }
+
+  void VisitRootIfNonNull(mirror::CompressedReference<mirror::Object>* root) const
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (!root->IsNull()) {
+      VisitRoot(root);
+    }
+  }
+
+  void VisitRoot(mirror::CompressedReference<mirror::Object>* root) const
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (target_space_->HasAddress(root->AsMirrorPtr())) {
+      *contains_reference_to_target_space_ = true;
+    }
+  }
+
+ private:
+  space::ContinuousSpace* const target_space_;
+  bool* const contains_reference_to_target_space_;
+};
+
+void RememberedSet::PreCleanCards(space::ContinuousSpace* target_space) {
+  DCHECK(pre_cleaned_cards_.empty());
+  ClearCards();
+  CardTable* card_table = heap_->GetCardTable();
+  ContinuousSpaceBitmap* bitmap = space_->GetLiveBitmap();
+  bool contains_reference_to_target_space = false;
+  RememberedSetPreCleanVisitor visitor(target_space, &contains_reference_to_target_space);
+  for (auto it = dirty_cards_.begin(); it != dirty_cards_.end(); ) {
+    uint8_t* const card_addr = *it;
+    contains_reference_to_target_space = false;
+    uintptr_t start = reinterpret_cast<uintptr_t>(card_table->AddrFromCard(card_addr));
+    bitmap->VisitMarkedRange(start, start + CardTable::kCardSize, visitor);
+    if (contains_reference_to_target_space) {
+      ++it;
+    } else {
+      // A reference stored into the card from now on dirties it again, which the ClearCards()
+      // of the pause sees.
+      pre_cleaned_cards_.insert(card_addr);
+      it = dirty_cards_.erase(it);
+    }
+  }
+}
+
+void RememberedSet::RestorePreCleanedCards(ObjectStack* allocation_stack) {
+  if (!pre_cleaned_cards_.empty()) {
+    CardTable* card_table = heap_->GetCardTable();
+    for (StackReference<mirror::Object>* it = allocation_stack->Begin();
+         it != allocation_stack->End();
+         ++it) {
+      mirror::Object* obj = it->AsMirrorPtr();
+      // The write barrier dirties the card of the object header.
+      if (obj != nullptr && space_->HasAddress(obj)) {
+        uint8_t* card_addr = card_table->CardFromAddr(obj);
+        if (pre_cleaned_cards_.erase(card_addr) != 0) {
+          dirty_cards_.insert(card_addr);
+        }
+      }
+    }
+  }
+  pre_cleaned_cards_.clear();
+}
+
 void RememberedSet::Dump(std::ostream& os) {
   CardTable* card_table = heap_->GetCardTable();
   os << "RememberedSet dirty cards: [";
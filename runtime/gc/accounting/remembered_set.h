@@ -25,6 +25,11 @@
 #include <vector>
 
 namespace art {
+
+namespace mirror {
+  class Object;
+}  // namespace mirror
+
 namespace gc {
 
 namespace collector {
@@ -39,6 +44,9 @@ class Heap;
 
 namespace accounting {
 
+template <typename T> class AtomicStack;
+typedef AtomicStack<mirror::Object> ObjectStack;
+
 // The remembered set keeps track of cards that may contain references
 // from the free list spaces to the bump pointer spaces.
 class RememberedSet {
@@ -52,6 +60,17 @@ class RememberedSet {
   // Clear dirty cards and add them to the dirty card set.
   void ClearCards();
 
+  // Concurrently with the mutators, clear the dirty cards and drop the cards with no reference to
+  // the target space from the dirty card set. The cards dirtied again are added back by the next
+  // ClearCards().
+  void PreCleanCards(space::ContinuousSpace* target_space)
+      REQUIRES_SHARED(Locks::mutator_lock_, Locks::heap_bitmap_lock_);
+
+  // Add back the dropped cards of the objects allocated since the last collection, which were
+  // not in the live bitmap when PreCleanCards() scanned the cards.
+  void RestorePreCleanedCards(ObjectStack* allocation_stack)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Mark through all references to the target space.
   void UpdateAndMarkReferences(space::ContinuousSpace* target_space,
                                collector::GarbageCollector* collector,
@@ -78,6 +97,8 @@ class RememberedSet {
   space::ContinuousSpace* const space_;
 
   CardSet dirty_cards_;
+  // The cards dropped by PreCleanCards().
+  CardSet pre_cleaned_cards_;
 };
 
 }  // namespace accounting
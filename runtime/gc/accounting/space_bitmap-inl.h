@@ -61,6 +61,15 @@ inline bool SpaceBitmap<kAlignment>::Test(const mirror::Object* obj) const {
   return (bitmap_begin_[OffsetToIndex(offset)].LoadRelaxed() & OffsetToMask(offset)) != 0;
 }
 
+template<size_t kAlignment>
+inline bool SpaceBitmap<kAlignment>::IsSpanClear(const Atomic<uintptr_t>* words) {
+  uintptr_t any = 0;
+  for (size_t i = 0; i < kWordsPerSpan; ++i) {
+    any |= words[i].LoadRelaxed();
+  }
+  return any == 0;
+}
+
 template<size_t kAlignment> template<typename Visitor>
 inline void SpaceBitmap<kAlignment>::VisitMarkedRange(uintptr_t visit_begin,
                                                       uintptr_t visit_end,
@@ -115,8 +124,18 @@ inline void SpaceBitmap<kAlignment>::VisitMarkedRange(uintptr_t visit_begin,
       } while (left_edge != 0);
     }
 
-    // Traverse the middle, full part.
+    // Traverse the middle, full part. Skip the spans without marked objects at once, and load the
+    // words of the other spans again one at a time, since the visitor may mark objects.
+    size_t span_end = index_start + 1;
     for (size_t i = index_start + 1; i < index_end; ++i) {
+      if (i == span_end) {
+        if (index_end - i >= kWordsPerSpan && IsSpanClear(&bitmap_begin_[i])) {
+          span_end = i + kWordsPerSpan;
+          i = span_end - 1;
+          continue;
+        }
+        span_end = i + kWordsPerSpan;
+      }
       uintptr_t w = bitmap_begin_[i].LoadRelaxed();
       if (w != 0) {
         const uintptr_t ptr_base = IndexToOffset(i) + heap_begin_;
@@ -176,7 +176,23 @@ void SpaceBitmap<kAlignment>::SweepWalk(const SpaceBitmap<kAlignment>& live_bitm
   CHECK_LT(end, live_bitmap.Size() / sizeof(intptr_t));
   Atomic<uintptr_t>* live = live_bitmap.bitmap_begin_;
   Atomic<uintptr_t>* mark = mark_bitmap.bitmap_begin_;
+  size_t span_end = start;
   for (size_t i = start; i <= end; i++) {
+    // Skip the spans without garbage at once. Live objects that are all marked are the common
+    // case, as are the free parts of the space where neither bitmap has a bit set.
+    if (i == span_end) {
+      span_end = i + kWordsPerSpan;
+      if (end - i >= kWordsPerSpan - 1) {
+        uintptr_t any_garbage = 0;
+        for (size_t j = 0; j < kWordsPerSpan; ++j) {
+          any_garbage |= live[i + j].LoadRelaxed() & ~mark[i + j].LoadRelaxed();
+        }
+        if (any_garbage == 0) {
+          i = span_end - 1;
+          continue;
+        }
+      }
+    }
     uintptr_t garbage = live[i].LoadRelaxed() & ~mark[i].LoadRelaxed();
     if (UNLIKELY(garbage != 0)) {
       uintptr_t ptr_base = IndexToOffset(i) + live_bitmap.heap_begin_;
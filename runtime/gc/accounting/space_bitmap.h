@@ -207,6 +207,13 @@ class SpaceBitmap {
   template<bool kSetBit>
   bool Modify(const mirror::Object* obj);
 
+  // The walks test this many words at once to skip the empty spans of the bitmap, 256 bits on
+  // 64-bit targets. The loops over a span have a constant trip count, and are unrolled.
+  static constexpr size_t kWordsPerSpan = 4;
+
+  // Returns whether the kWordsPerSpan words starting at words are all 0.
+  ALWAYS_INLINE static bool IsSpanClear(const Atomic<uintptr_t>* words);
+
   // Backing storage for bitmap.
   std::unique_ptr<MemMap> mem_map_;
 
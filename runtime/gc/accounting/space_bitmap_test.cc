@@ -18,6 +18,7 @@
 
 #include <stdint.h>
 #include <memory>
+#include <vector>
 
 #include "common_runtime_test.h"
 #include "globals.h"
@@ -87,6 +88,64 @@ TEST_F(SpaceBitmapTest, ScanRange) {
   }
 }
 
+struct SweepState {
+  std::vector<mirror::Object*> swept;
+};
+
+static void SweepCallback(size_t num_ptrs, mirror::Object** ptrs, void* arg) {
+  SweepState* state = reinterpret_cast<SweepState*>(arg);
+  state->swept.insert(state->swept.end(), ptrs, ptrs + num_ptrs);
+}
+
+TEST_F(SpaceBitmapTest, SweepWalkSparse) {
+  uint8_t* heap_begin = reinterpret_cast<uint8_t*>(0x10000000);
+  size_t heap_capacity = 16 * MB;
+
+  std::unique_ptr<ContinuousSpaceBitmap> live_bitmap(
+      ContinuousSpaceBitmap::Create("test live bitmap", heap_begin, heap_capacity));
+  std::unique_ptr<ContinuousSpaceBitmap> mark_bitmap(
+      ContinuousSpaceBitmap::Create("test mark bitmap", heap_begin, heap_capacity));
+  ASSERT_TRUE(live_bitmap != nullptr);
+  ASSERT_TRUE(mark_bitmap != nullptr);
+
+  // A few live objects spread over long empty parts of the bitmap, at both ends of the words, some
+  // of them marked.
+  std::vector<mirror::Object*> expected;
+  for (size_t i = 0; i < heap_capacity / kObjectAlignment; i += 997) {
+    mirror::Object* obj = reinterpret_cast<mirror::Object*>(heap_begin + i * kObjectAlignment);
+    live_bitmap->Set(obj);
+    if (i % 3 == 0) {
+      mark_bitmap->Set(obj);
+    } else {
+      expected.push_back(obj);
+    }
+  }
+  mirror::Object* last = reinterpret_cast<mirror::Object*>(
+      heap_begin + heap_capacity - kObjectAlignment);
+  live_bitmap->Set(last);
+  expected.push_back(last);
+
+  // Sweep the whole bitmap, then ranges of a number of words that is not a multiple of the spans.
+  // The sweep covers the whole words of its range.
+  const size_t kBytesPerWord = kBitsPerIntPtrT * kObjectAlignment;
+  const size_t kRangeEnds[] = {
+      heap_capacity, kBytesPerWord, 10 * kBytesPerWord, 2049 * kBytesPerWord };
+  for (size_t range_end : kRangeEnds) {
+    uintptr_t sweep_begin = reinterpret_cast<uintptr_t>(heap_begin);
+    uintptr_t sweep_end = sweep_begin + range_end;
+    SweepState state;
+    ContinuousSpaceBitmap::SweepWalk(*live_bitmap, *mark_bitmap, sweep_begin, sweep_end,
+                                     SweepCallback, &state);
+    std::vector<mirror::Object*> expected_in_range;
+    for (mirror::Object* obj : expected) {
+      if (reinterpret_cast<uintptr_t>(obj) < sweep_end) {
+        expected_in_range.push_back(obj);
+      }
+    }
+    EXPECT_EQ(expected_in_range, state.swept) << range_end;
+  }
+}
+
 TEST_F(SpaceBitmapTest, ClearRange) {
   uint8_t* heap_begin = reinterpret_cast<uint8_t*>(0x10000000);
   size_t heap_capacity = 16 * MB;
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ACCOUNTING_WORK_STEALING_DEQUE_H_
+#define ART_RUNTIME_GC_ACCOUNTING_WORK_STEALING_DEQUE_H_
+
+#include <sys/types.h>
+
+#include <memory>
+
+#include "atomic.h"
+#include "base/bit_utils.h"
+#include "base/logging.h"
+#include "base/macros.h"
+
+// This implements the lock-free work-stealing deque of Chase and Lev ("Dynamic Circular
+// Work-Stealing Deque", SPAA 2005) with a fixed capacity, and the memory orderings given by
+// Le et al. ("Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP 2013).
+// A single thread, the owner, pushes and pops at the bottom of the deque, while any other
+// thread may steal from its top.
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+// T must be small enough to be loaded and stored atomically, such as a pointer.
+template <typename T>
+class WorkStealingDeque {
+ public:
+  // The capacity must be a power of two.
+  explicit WorkStealingDeque(size_t capacity)
+      : top_(0),
+        bottom_(0),
+        mask_(static_cast<ssize_t>(capacity) - 1),
+        buffer_(new Atomic<T>[capacity]) {
+    DCHECK(IsPowerOfTwo(capacity)) << capacity;
+  }
+
+  // Owner only. Returns false, leaving the deque unchanged, if it is full.
+  bool Push(T value) {
+    ssize_t bottom = bottom_.LoadRelaxed();
+    ssize_t top = top_.LoadAcquire();
+    if (UNLIKELY(bottom - top > mask_)) {
+      return false;
+    }
+    buffer_[bottom & mask_].StoreRelaxed(value);
+    // Publish the value before the thieves can see the new bottom.
+    QuasiAtomic::ThreadFenceRelease();
+    bottom_.StoreRelaxed(bottom + 1);
+    return true;
+  }
+
+  // Owner only. Returns false if the deque is empty, or if its last value was stolen.
+  bool Pop(T* value) {
+    ssize_t bottom = bottom_.LoadRelaxed() - 1;
+    bottom_.StoreRelaxed(bottom);
+    // Order the store of the bottom with the load of the top, against the thieves doing
+    // the opposite.
+    QuasiAtomic::ThreadFenceSequentiallyConsistent();
+    ssize_t top = top_.LoadRelaxed();
+    if (top > bottom) {
+      bottom_.StoreRelaxed(bottom + 1);
+      return false;
+    }
+    *value = buffer_[bottom & mask_].LoadRelaxed();
+    if (top == bottom) {
+      // The last value, race with the thieves for it.
+      bool won = top_.CompareExchangeStrongSequentiallyConsistent(top, top + 1);
+      bottom_.StoreRelaxed(bottom + 1);
+      return won;
+    }
+    return true;
+  }
+
+  // Any thread. Returns false if the deque looked empty, or if another thread took the value.
+  bool Steal(T* value) {
+    ssize_t top = top_.LoadAcquire();
+    QuasiAtomic::ThreadFenceSequentiallyConsistent();
+    ssize_t bottom = bottom_.LoadAcquire();
+    if (top >= bottom) {
+      return false;
+    }
+    // The owner does not overwrite this slot before the top moves past it.
+    T stolen = buffer_[top & mask_].LoadRelaxed();
+    if (!top_.CompareExchangeStrongSequentiallyConsistent(top, top + 1)) {
+      return false;
+    }
+    *value = stolen;
+    return true;
+  }
+
+  // Any thread. The result is only a hint while the owner or the thieves are active.
+  bool IsEmpty() const {
+    ssize_t top = top_.LoadSequentiallyConsistent();
+    return bottom_.LoadSequentiallyConsistent() <= top;
+  }
+
+  size_t Capacity() const {
+    return static_cast<size_t>(mask_ + 1);
+  }
+
+ private:
+  // The index of the next value to steal. It only increases.
+  Atomic<ssize_t> top_;
+  // The index of the next value to push.
+  Atomic<ssize_t> bottom_;
+  const ssize_t mask_;
+  std::unique_ptr<Atomic<T>[]> buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+};
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ACCOUNTING_WORK_STEALING_DEQUE_H_
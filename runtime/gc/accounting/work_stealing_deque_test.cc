@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "work_stealing_deque.h"
+
+#include <pthread.h>
+
+#include <vector>
+
+#include "base/logging.h"
+#include "common_runtime_test.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+class WorkStealingDequeTest : public CommonRuntimeTest {};
+
+TEST_F(WorkStealingDequeTest, PushPopSteal) {
+  WorkStealingDeque<size_t> deque(4);
+  size_t value = 0;
+  EXPECT_TRUE(deque.IsEmpty());
+  EXPECT_FALSE(deque.Pop(&value));
+  EXPECT_FALSE(deque.Steal(&value));
+  for (size_t i = 1; i <= 4; ++i) {
+    EXPECT_TRUE(deque.Push(i));
+  }
+  // Full.
+  EXPECT_FALSE(deque.Push(5));
+  // The owner pops the last value pushed, the thieves steal the first one.
+  EXPECT_TRUE(deque.Pop(&value));
+  EXPECT_EQ(4u, value);
+  EXPECT_TRUE(deque.Steal(&value));
+  EXPECT_EQ(1u, value);
+  // The slots freed at both ends are reused.
+  EXPECT_TRUE(deque.Push(6));
+  EXPECT_TRUE(deque.Push(7));
+  EXPECT_FALSE(deque.Push(8));
+  EXPECT_TRUE(deque.Steal(&value));
+  EXPECT_EQ(2u, value);
+  EXPECT_TRUE(deque.Pop(&value));
+  EXPECT_EQ(7u, value);
+  EXPECT_TRUE(deque.Pop(&value));
+  EXPECT_EQ(6u, value);
+  EXPECT_TRUE(deque.Pop(&value));
+  EXPECT_EQ(3u, value);
+  EXPECT_TRUE(deque.IsEmpty());
+  EXPECT_FALSE(deque.Pop(&value));
+  EXPECT_FALSE(deque.Steal(&value));
+}
+
+struct StealState {
+  WorkStealingDeque<size_t>* deque;
+  Atomic<bool>* done;
+  std::vector<size_t> stolen;
+};
+
+static void* StealCallback(void* arg) {
+  StealState* state = reinterpret_cast<StealState*>(arg);
+  size_t value;
+  while (!state->done->LoadSequentiallyConsistent() || !state->deque->IsEmpty()) {
+    if (state->deque->Steal(&value)) {
+      state->stolen.push_back(value);
+    }
+  }
+  return nullptr;
+}
+
+TEST_F(WorkStealingDequeTest, ConcurrentSteal) {
+  static constexpr size_t kNumValues = 100000;
+  static constexpr size_t kNumThieves = 3;
+  WorkStealingDeque<size_t> deque(64);
+  Atomic<bool> done(false);
+  StealState states[kNumThieves];
+  pthread_t threads[kNumThieves];
+  for (size_t i = 0; i < kNumThieves; ++i) {
+    states[i].deque = &deque;
+    states[i].done = &done;
+    CHECK_PTHREAD_CALL(pthread_create, (&threads[i], nullptr, StealCallback, &states[i]),
+                       "work stealing deque test thread");
+  }
+  // Push all the values, popping some of them on the way and when the deque is full.
+  std::vector<size_t> popped;
+  size_t value;
+  for (size_t i = 0; i < kNumValues; ++i) {
+    while (!deque.Push(i)) {
+      if (deque.Pop(&value)) {
+        popped.push_back(value);
+      }
+    }
+    if (i % 3 == 0 && deque.Pop(&value)) {
+      popped.push_back(value);
+    }
+  }
+  while (deque.Pop(&value)) {
+    popped.push_back(value);
+  }
+  done.StoreSequentiallyConsistent(true);
+  for (size_t i = 0; i < kNumThieves; ++i) {
+    CHECK_PTHREAD_CALL(pthread_join, (threads[i], nullptr), "work stealing deque test thread");
+  }
+  // Every value was taken exactly once.
+  std::vector<size_t> counts(kNumValues, 0u);
+  for (size_t popped_value : popped) {
+    ++counts[popped_value];
+  }
+  for (size_t i = 0; i < kNumThieves; ++i) {
+    for (size_t stolen_value : states[i].stolen) {
+      ++counts[stolen_value];
+    }
+  }
+  for (size_t i = 0; i < kNumValues; ++i) {
+    EXPECT_EQ(1u, counts[i]) << i;
+  }
+}
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
@@ -91,9 +91,42 @@ void AllocRecordObjectMap::SetProperties() {
       max_stack_depth_ = value;
     }
   }
+  // Check whether there's a system property to sample the allocations.
+  propertyName = "debug.allocTracker.sampleInterval";
+  char sampleIntervalString[PROPERTY_VALUE_MAX];
+  if (property_get(propertyName, sampleIntervalString, "") > 0) {
+    char* end;
+    size_t value = strtoul(sampleIntervalString, &end, 10);
+    if (*end != '\0' || value == 0) {
+      LOG(ERROR) << "Ignoring  " << propertyName << " '" << sampleIntervalString
+                 << "' --- invalid";
+    } else {
+      sample_interval_ = value;
+    }
+  }
 #endif  // ART_TARGET_ANDROID
 }
 
+const AllocRecordStackTrace* AllocRecordObjectMap::InternStackTrace(
+    AllocRecordStackTrace&& trace) {
+  auto it = traces_.find(trace);
+  if (it == traces_.end()) {
+    it = traces_.emplace(std::move(trace), 0u).first;
+  }
+  ++it->second;
+  return &it->first;
+}
+
+void AllocRecordObjectMap::ReleaseStackTrace(const AllocRecordStackTrace* trace) {
+  auto it = traces_.find(*trace);
+  DCHECK(it != traces_.end());
+  DCHECK_EQ(&it->first, trace);
+  DCHECK_NE(it->second, 0u);
+  if (--it->second == 0u) {
+    traces_.erase(it);
+  }
+}
+
 AllocRecordObjectMap::~AllocRecordObjectMap() {
   Clear();
 }
@@ -104,16 +137,16 @@ void AllocRecordObjectMap::VisitRoots(RootVisitor* visitor) {
   size_t count = recent_record_max_;
   // Only visit the last recent_record_max_ number of allocation records in entries_ and mark the
   // klass_ fields as strong roots.
-  for (auto it = entries_.rbegin(), end = entries_.rend(); it != end; ++it) {
-    AllocRecord& record = it->second;
-    if (count > 0) {
-      buffered_visitor.VisitRootIfNonNull(record.GetClassGcRoot());
-      --count;
-    }
-    // Visit all of the stack frames to make sure no methods in the stack traces get unloaded by
-    // class unloading.
-    for (size_t i = 0, depth = record.GetDepth(); i < depth; ++i) {
-      const AllocRecordStackTraceElement& element = record.StackElement(i);
+  for (auto it = entries_.rbegin(), end = entries_.rend(); it != end && count > 0; ++it) {
+    buffered_visitor.VisitRootIfNonNull(it->second.GetClassGcRoot());
+    --count;
+  }
+  // Visit all of the stack frames to make sure no methods in the stack traces get unloaded by
+  // class unloading. The records share their traces, visit each once.
+  for (const auto& entry : traces_) {
+    const AllocRecordStackTrace& trace = entry.first;
+    for (size_t i = 0, depth = trace.GetDepth(); i < depth; ++i) {
+      const AllocRecordStackTraceElement& element = trace.GetStackElement(i);
       DCHECK(element.GetMethod() != nullptr);
       element.GetMethod()->VisitRoots(buffered_visitor, kRuntimePointerSize);
     }
@@ -154,6 +187,7 @@ void AllocRecordObjectMap::SweepAllocationRecords(IsMarkedVisitor* visitor) {
         SweepClassObject(&record, visitor);
         ++it;
       } else {
+        ReleaseStackTrace(record.GetStackTrace());
         it = entries_.erase(it);
         ++count_deleted;
       }
@@ -238,7 +272,8 @@ void AllocRecordObjectMap::SetAllocTrackingEnabled(bool enable) {
                   sizeof(AllocRecord) + sizeof(AllocRecordStackTrace);
       LOG(INFO) << "Enabling alloc tracker (" << records->alloc_record_max_ << " entries of "
                 << records->max_stack_depth_ << " frames, taking up to "
-                << PrettySize(sz * records->alloc_record_max_) << ")";
+                << PrettySize(sz * records->alloc_record_max_) << ", recording 1 allocation in "
+                << records->sample_interval_ << ")";
     }
     Runtime::Current()->GetInstrumentation()->InstrumentQuickAllocEntryPoints();
     {
@@ -266,9 +301,14 @@ void AllocRecordObjectMap::SetAllocTrackingEnabled(bool enable) {
 void AllocRecordObjectMap::RecordAllocation(Thread* self,
                                             ObjPtr<mirror::Object>* obj,
                                             size_t byte_count) {
+  if (sample_interval_ != 1u &&
+      allocation_count_.FetchAndAddRelaxed(1u) % sample_interval_ != 0u) {
+    return;
+  }
   // Get stack trace outside of lock in case there are allocations during the stack walk.
   // b/27858645.
   AllocRecordStackTrace trace;
+  trace.Reserve(max_stack_depth_);
   AllocRecordStackVisitor visitor(self, max_stack_depth_, /*out*/ &trace);
   {
     StackHandleScope<1> hs(self);
@@ -309,16 +349,18 @@ void AllocRecordObjectMap::RecordAllocation(Thread* self,
   trace.SetTid(self->GetTid());
 
   // Add the record.
-  Put(obj->Ptr(), AllocRecord(byte_count, (*obj)->GetClass(), std::move(trace)));
+  Put(obj->Ptr(), AllocRecord(byte_count, (*obj)->GetClass(), InternStackTrace(std::move(trace))));
   DCHECK_LE(Size(), alloc_record_max_);
 }
 
 void AllocRecordObjectMap::Clear() {
   entries_.clear();
+  traces_.clear();
 }
 
 AllocRecordObjectMap::AllocRecordObjectMap()
-    : new_record_condition_("New allocation record condition", *Locks::alloc_tracker_lock_) {}
+    : allocation_count_(0u),
+      new_record_condition_("New allocation record condition", *Locks::alloc_tracker_lock_) {}
 
 }  // namespace gc
 }  // namespace art
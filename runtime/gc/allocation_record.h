@@ -19,7 +19,9 @@
 
 #include <list>
 #include <memory>
+#include <unordered_map>
 
+#include "atomic.h"
 #include "base/mutex.h"
 #include "obj_ptr.h"
 #include "gc_root.h"
@@ -106,6 +108,10 @@ class AllocRecordStackTrace {
     stack_.push_back(element);
   }
 
+  void Reserve(size_t depth) {
+    stack_.reserve(depth);
+  }
+
   void SetStackElementAt(size_t index, ArtMethod* m, uint32_t dex_pc) {
     DCHECK_LT(index, stack_.size());
     stack_[index].SetMethod(m);
@@ -155,16 +161,17 @@ template <typename T> struct EqAllocRecordTypesPtr {
 
 class AllocRecord {
  public:
-  // All instances of AllocRecord should be managed by an instance of AllocRecordObjectMap.
-  AllocRecord(size_t count, mirror::Class* klass, AllocRecordStackTrace&& trace)
-      : byte_count_(count), klass_(klass), trace_(std::move(trace)) {}
+  // All instances of AllocRecord should be managed by an instance of AllocRecordObjectMap, which
+  // also owns their stack trace.
+  AllocRecord(size_t count, mirror::Class* klass, const AllocRecordStackTrace* trace)
+      : byte_count_(count), klass_(klass), trace_(trace) {}
 
   size_t GetDepth() const {
-    return trace_.GetDepth();
+    return trace_->GetDepth();
   }
 
   const AllocRecordStackTrace* GetStackTrace() const {
-    return &trace_;
+    return trace_;
   }
 
   size_t ByteCount() const {
@@ -172,7 +179,7 @@ class AllocRecord {
   }
 
   pid_t GetTid() const {
-    return trace_.GetTid();
+    return trace_->GetTid();
   }
 
   mirror::Class* GetClass() const REQUIRES_SHARED(Locks::mutator_lock_) {
@@ -187,15 +194,15 @@ class AllocRecord {
   }
 
   const AllocRecordStackTraceElement& StackElement(size_t index) const {
-    return trace_.GetStackElement(index);
+    return trace_->GetStackElement(index);
   }
 
  private:
   const size_t byte_count_;
   // The klass_ could be a strong or weak root for GC
   GcRoot<mirror::Class> klass_;
-  // TODO: Share between alloc records with identical stack traces.
-  AllocRecordStackTrace trace_;
+  // Shared between alloc records with identical stack traces.
+  const AllocRecordStackTrace* trace_;
 };
 
 class AllocRecordObjectMap {
@@ -225,11 +232,21 @@ class AllocRecordObjectMap {
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(Locks::alloc_tracker_lock_) {
     if (entries_.size() == alloc_record_max_) {
+      ReleaseStackTrace(entries_.front().second.GetStackTrace());
       entries_.pop_front();
     }
     entries_.push_back(EntryPair(GcRoot<mirror::Object>(obj), std::move(record)));
   }
 
+  // Returns the stack trace equal to trace shared by the records, for a new record to use.
+  const AllocRecordStackTrace* InternStackTrace(AllocRecordStackTrace&& trace)
+      REQUIRES(Locks::alloc_tracker_lock_);
+
+  // The number of distinct stack traces of the records.
+  size_t GetStackTraceCount() const REQUIRES_SHARED(Locks::alloc_tracker_lock_) {
+    return traces_.size();
+  }
+
   size_t Size() const REQUIRES_SHARED(Locks::alloc_tracker_lock_) {
     return entries_.size();
   }
@@ -295,16 +312,26 @@ class AllocRecordObjectMap {
   static constexpr size_t kDefaultNumRecentRecords = 64 * 1024 - 1;
   static constexpr size_t kDefaultAllocStackDepth = 16;
   static constexpr size_t kMaxSupportedStackDepth = 128;
+  // The stack traces shared by the records, with the number of records using them. The keys
+  // keep their address in an unordered_map, the records point to them.
+  using StackTraceMap = std::unordered_map<AllocRecordStackTrace, size_t, HashAllocRecordTypes>;
   size_t alloc_record_max_ GUARDED_BY(Locks::alloc_tracker_lock_) = kDefaultNumAllocRecords;
   size_t recent_record_max_ GUARDED_BY(Locks::alloc_tracker_lock_) = kDefaultNumRecentRecords;
   size_t max_stack_depth_ = kDefaultAllocStackDepth;
+  // Record one allocation out of sample_interval_, to lower the overhead of the tracking.
+  size_t sample_interval_ = 1;
+  Atomic<size_t> allocation_count_;
   pid_t alloc_ddm_thread_id_  GUARDED_BY(Locks::alloc_tracker_lock_) = 0;
   bool allow_new_record_ GUARDED_BY(Locks::alloc_tracker_lock_) = true;
   ConditionVariable new_record_condition_ GUARDED_BY(Locks::alloc_tracker_lock_);
   // see the comment in typedef of EntryList
   EntryList entries_ GUARDED_BY(Locks::alloc_tracker_lock_);
+  StackTraceMap traces_ GUARDED_BY(Locks::alloc_tracker_lock_);
 
   void SetProperties() REQUIRES(Locks::alloc_tracker_lock_);
+
+  // A record using trace is deleted.
+  void ReleaseStackTrace(const AllocRecordStackTrace* trace) REQUIRES(Locks::alloc_tracker_lock_);
 };
 
 }  // namespace gc
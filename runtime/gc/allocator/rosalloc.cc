@@ -16,6 +16,10 @@
 
 #include "rosalloc.h"
 
+#include <sched.h>
+#include <unistd.h>
+
+#include <limits>
 #include <map>
 #include <list>
 #include <sstream>
@@ -25,6 +29,7 @@
 
 #include "base/memory_tool.h"
 #include "base/mutex-inl.h"
+#include "base/time_utils.h"
 #include "gc/space/memory_tool_settings.h"
 #include "mem_map.h"
 #include "mirror/class-inl.h"
@@ -54,19 +59,22 @@ RosAlloc::Run* RosAlloc::dedicated_full_run_ =
 
 RosAlloc::RosAlloc(void* base, size_t capacity, size_t max_capacity,
                    PageReleaseMode page_release_mode, bool running_on_memory_tool,
-                   size_t page_release_size_threshold)
+                   size_t page_release_size_threshold, size_t page_release_alignment)
     : base_(reinterpret_cast<uint8_t*>(base)), footprint_(capacity),
       capacity_(capacity), max_capacity_(max_capacity),
       lock_("rosalloc global lock", kRosAllocGlobalLock),
       bulk_free_lock_("rosalloc bulk free lock", kRosAllocBulkFreeLock),
       page_release_mode_(page_release_mode),
       page_release_size_threshold_(page_release_size_threshold),
+      page_release_alignment_(page_release_alignment),
+      num_cpu_caches_(0),
       is_running_on_memory_tool_(running_on_memory_tool) {
   DCHECK_ALIGNED(base, kPageSize);
   DCHECK_EQ(RoundUp(capacity, kPageSize), capacity);
   DCHECK_EQ(RoundUp(max_capacity, kPageSize), max_capacity);
   CHECK_LE(capacity, max_capacity);
   CHECK_ALIGNED(page_release_size_threshold_, kPageSize);
+  CHECK_ALIGNED_PARAM(page_release_alignment_, kPageSize);
   // Zero the memory explicitly (don't rely on that the mem map is zero-initialized).
   if (!kMadviseZeroes) {
     memset(base_, 0, max_capacity);
@@ -86,6 +94,15 @@ RosAlloc::RosAlloc(void* base, size_t capacity, size_t max_capacity,
     size_bracket_locks_[i] = new Mutex(size_bracket_lock_names_[i].c_str(), kRosAllocBracketLock);
     current_runs_[i] = dedicated_full_run_;
   }
+#ifdef __linux__
+  if (kUseCpuCaches) {
+    const int num_cpus = static_cast<int>(sysconf(_SC_NPROCESSORS_CONF));
+    if (num_cpus > 0) {
+      num_cpu_caches_ = static_cast<size_t>(num_cpus);
+      cpu_caches_.reset(new CpuCache[num_cpu_caches_]);
+    }
+  }
+#endif
   DCHECK_EQ(footprint_, capacity_);
   size_t num_of_pages = footprint_ / kPageSize;
   size_t max_num_of_pages = max_capacity_ / kPageSize;
@@ -735,8 +752,12 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated,
     *usable_size = bracket_size;
   } else {
     // Use the (shared) current run.
-    MutexLock mu(self, *size_bracket_locks_[idx]);
-    slot_addr = AllocFromCurrentRunUnlocked(self, idx);
+    if (idx < kNumRegularSizeBrackets) {
+      slot_addr = AllocFromCpuCache(self, idx);
+    } else {
+      MutexLock mu(self, *size_bracket_locks_[idx]);
+      slot_addr = AllocFromCurrentRunUnlocked(self, idx);
+    }
     if (kTraceRosAlloc) {
       LOG(INFO) << "RosAlloc::AllocFromRun() : 0x" << std::hex
                 << reinterpret_cast<intptr_t>(slot_addr)
@@ -753,6 +774,76 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated,
   return slot_addr;
 }
 
+RosAlloc::Magazine* RosAlloc::GetCpuMagazine(size_t idx) {
+  DCHECK_GE(idx, kNumThreadLocalSizeBrackets);
+  DCHECK_LT(idx, kNumRegularSizeBrackets);
+  if (num_cpu_caches_ == 0) {
+    return nullptr;
+  }
+#ifdef __linux__
+  int cpu = sched_getcpu();
+  if (UNLIKELY(cpu < 0 || static_cast<size_t>(cpu) >= num_cpu_caches_)) {
+    return nullptr;
+  }
+  return &cpu_caches_[cpu].magazines_[idx - kNumThreadLocalSizeBrackets];
+#else
+  return nullptr;
+#endif
+}
+
+void* RosAlloc::AllocFromCpuCache(Thread* self, size_t idx) {
+  Magazine* magazine = GetCpuMagazine(idx);
+  if (magazine == nullptr || !magazine->TryAcquire()) {
+    MutexLock mu(self, *size_bracket_locks_[idx]);
+    return AllocFromCurrentRunUnlocked(self, idx);
+  }
+  if (magazine->num_slots_ == 0) {
+    // Refill the magazine, only swapping the current run when it gets full.
+    void* slots[kCpuCacheMagazineCapacity];
+    size_t num_slots = 0;
+    {
+      MutexLock mu(self, *size_bracket_locks_[idx]);
+      while (num_slots < kCpuCacheMagazineCapacity) {
+        void* slot = AllocFromCurrentRunUnlocked(self, idx);
+        if (slot == nullptr) {
+          break;
+        }
+        slots[num_slots++] = slot;
+      }
+    }
+    // Hand out the slots in the order of the run.
+    for (size_t i = 0; i < num_slots; ++i) {
+      magazine->slots_[i] = slots[num_slots - 1 - i];
+    }
+    magazine->num_slots_ = num_slots;
+  }
+  void* slot_addr = nullptr;
+  if (LIKELY(magazine->num_slots_ != 0)) {
+    slot_addr = magazine->slots_[--magazine->num_slots_];
+  }
+  magazine->Release();
+  return slot_addr;
+}
+
+void RosAlloc::RevokeCpuCaches() {
+  Thread* self = Thread::Current();
+  ReaderMutexLock rmu(self, bulk_free_lock_);
+  for (size_t cpu = 0; cpu < num_cpu_caches_; ++cpu) {
+    for (Magazine& magazine : cpu_caches_[cpu].magazines_) {
+      // The magazines are only held for a few instructions by the allocating threads.
+      while (!magazine.TryAcquire()) {
+        sched_yield();
+      }
+      for (size_t i = 0; i < magazine.num_slots_; ++i) {
+        // The cached slots were not counted in Heap::num_bytes_allocated_.
+        FreeInternal(self, magazine.slots_[i]);
+      }
+      magazine.num_slots_ = 0;
+      magazine.Release();
+    }
+  }
+}
+
 size_t RosAlloc::FreeFromRun(Thread* self, void* ptr, Run* run) {
   DCHECK_EQ(run->magic_num_, kMagicNum);
   DCHECK_LT(run, ptr);
@@ -988,7 +1079,29 @@ inline void RosAlloc::Run::ZeroData() {
   memset(slot_begin, 0, numOfSlots[idx] * bracketSizes[idx]);
 }
 
-void RosAlloc::Run::InspectAllSlots(void (*handler)(void* start, void* end, size_t used_bytes, void* callback_arg),
+void RosAlloc::Run::MarkCpuCachedSlotsFree(const RosAlloc* rosalloc, bool* is_free) const {
+  const size_t idx = size_bracket_idx_;
+  if (idx < kNumThreadLocalSizeBrackets || idx >= kNumRegularSizeBrackets) {
+    return;
+  }
+  const uint8_t* slot_base = reinterpret_cast<const uint8_t*>(this) + headerSizes[idx];
+  const size_t bracket_size = IndexToBracketSize(idx);
+  const uint8_t* slot_end = slot_base + numOfSlots[idx] * bracket_size;
+  for (size_t cpu = 0; cpu < rosalloc->num_cpu_caches_; ++cpu) {
+    const Magazine& magazine =
+        rosalloc->cpu_caches_[cpu].magazines_[idx - kNumThreadLocalSizeBrackets];
+    for (size_t i = 0; i < magazine.num_slots_; ++i) {
+      const uint8_t* slot = reinterpret_cast<const uint8_t*>(magazine.slots_[i]);
+      if (slot_base <= slot && slot < slot_end) {
+        is_free[(slot - slot_base) / bracket_size] = true;
+      }
+    }
+  }
+}
+
+void RosAlloc::Run::InspectAllSlots(RosAlloc* rosalloc,
+                                    void (*handler)(void* start, void* end, size_t used_bytes,
+                                                    void* callback_arg),
                                     void* arg) {
   size_t idx = size_bracket_idx_;
   uint8_t* slot_base = reinterpret_cast<uint8_t*>(this) + headerSizes[idx];
@@ -1011,6 +1124,7 @@ void RosAlloc::Run::InspectAllSlots(void (*handler)(void* start, void* end, size
       is_free[slot_idx] = true;
     }
   }
+  MarkCpuCachedSlotsFree(rosalloc, is_free.get());
   for (size_t slot_idx = 0; slot_idx < num_slots; ++slot_idx) {
     uint8_t* slot_addr = slot_base + slot_idx * bracket_size;
     if (!is_free[slot_idx]) {
@@ -1485,7 +1599,7 @@ void RosAlloc::InspectAll(void (*handler)(void* start, void* end, size_t used_by
         DCHECK_EQ(run->magic_num_, kMagicNum);
         // The dedicated full run doesn't contain any real allocations, don't visit the slots in
         // there.
-        run->InspectAllSlots(handler, arg);
+        run->InspectAllSlots(this, handler, arg);
         size_t num_pages = numOfPages[run->size_bracket_idx_];
         if (kIsDebugBuild) {
           for (size_t j = i + 1; j < i + num_pages; ++j) {
@@ -1614,6 +1728,7 @@ size_t RosAlloc::RevokeAllThreadLocalRuns() {
     free_bytes += RevokeThreadLocalRuns(thread);
   }
   RevokeThreadUnsafeCurrentRuns();
+  RevokeCpuCaches();
   return free_bytes;
 }
 
@@ -1643,6 +1758,11 @@ void RosAlloc::AssertAllThreadLocalRunsAreRevoked() {
       MutexLock brackets_mu(self, *size_bracket_locks_[idx]);
       CHECK_EQ(current_runs_[idx], dedicated_full_run_);
     }
+    for (size_t cpu = 0; cpu < num_cpu_caches_; ++cpu) {
+      for (const Magazine& magazine : cpu_caches_[cpu].magazines_) {
+        CHECK_EQ(magazine.num_slots_, 0U);
+      }
+    }
   }
 }
 
@@ -1983,6 +2103,9 @@ void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc, bool running_on_mem
       is_free[slot_idx] = true;
     }
   }
+  // Verify() runs with the mutators suspended, but the magazines are only emptied by the
+  // revocation of the thread-local runs, which does not always come first.
+  MarkCpuCachedSlotsFree(rosalloc, is_free.get());
   for (size_t slot_idx = 0; slot_idx < num_slots; ++slot_idx) {
     uint8_t* slot_addr = slot_base + slot_idx * bracket_size;
     if (running_on_memory_tool) {
@@ -2004,12 +2127,29 @@ void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc, bool running_on_mem
 
 size_t RosAlloc::ReleasePages() {
   VLOG(heap) << "RosAlloc::ReleasePages()";
+  size_t resume_idx = 0;
+  size_t reclaimed_bytes = 0;
+  bool finished = ReleasePages(&resume_idx, std::numeric_limits<uint64_t>::max(), &reclaimed_bytes);
+  DCHECK(finished);
+  return reclaimed_bytes;
+}
+
+bool RosAlloc::ReleasePages(size_t* resume_idx, uint64_t deadline_ns, size_t* reclaimed_bytes) {
   DCHECK(!DoesReleaseAllPages());
+  // How many pages are looked at between two reads of the time, when no page is released.
+  static constexpr size_t kPagesPerDeadlineCheck = 1024;
   Thread* self = Thread::Current();
-  size_t reclaimed_bytes = 0;
-  size_t i = 0;
+  size_t i = *resume_idx;
+  size_t pages_since_deadline_check = 0;
   // Check the page map size which might have changed due to grow/shrink.
   while (i < page_map_size_) {
+    if (pages_since_deadline_check >= kPagesPerDeadlineCheck) {
+      if (NanoTime() >= deadline_ns) {
+        *resume_idx = i;
+        return false;
+      }
+      pages_since_deadline_check = 0;
+    }
     // Reading the page map without a lock is racy but the race is benign since it should only
     // result in occasionally not releasing pages which we could release.
     uint8_t pm = page_map_[i];
@@ -2034,11 +2174,15 @@ size_t RosAlloc::ReleasePages() {
             size_t fpr_size = fpr->ByteSize(this);
             DCHECK_ALIGNED(fpr_size, kPageSize);
             uint8_t* start = reinterpret_cast<uint8_t*>(fpr);
-            reclaimed_bytes += ReleasePageRange(start, start + fpr_size);
+            size_t released_bytes = ReleasePageRange(start, start + fpr_size);
+            *reclaimed_bytes += released_bytes;
             size_t pages = fpr_size / kPageSize;
             CHECK_GT(pages, 0U) << "Infinite loop probable";
             i += pages;
             DCHECK_LE(i, page_map_size_);
+            // Look at the time after every madvise.
+            pages_since_deadline_check =
+                released_bytes != 0 ? kPagesPerDeadlineCheck : pages_since_deadline_check + pages;
             break;
           }
         }
@@ -2049,13 +2193,14 @@ size_t RosAlloc::ReleasePages() {
       case kPageMapRun:              // Fall through.
       case kPageMapRunPart:          // Fall through.
         ++i;
+        ++pages_since_deadline_check;
         break;  // Skip.
       default:
         LOG(FATAL) << "Unreachable - page map type: " << static_cast<int>(pm);
         break;
     }
   }
-  return reclaimed_bytes;
+  return true;
 }
 
 size_t RosAlloc::ReleasePageRange(uint8_t* start, uint8_t* end) {
@@ -2072,11 +2217,43 @@ size_t RosAlloc::ReleasePageRange(uint8_t* start, uint8_t* end) {
       return 0;
     }
   }
+  if (page_release_alignment_ != kPageSize) {
+    // Only release the whole blocks. The pages around them stay empty, zero them as FreePages()
+    // does not when all of the pages are released.
+    uint8_t* aligned_start = std::min(AlignUp(start, page_release_alignment_), end);
+    uint8_t* aligned_end = std::max(AlignDown(end, page_release_alignment_), aligned_start);
+    if (DoesReleaseAllPages()) {
+      memset(start, 0, aligned_start - start);
+      memset(aligned_end, 0, end - aligned_end);
+    }
+    if (aligned_start == aligned_end) {
+      return 0;
+    }
+    start = aligned_start;
+    end = aligned_end;
+  } else {
+    // Only madvise the span of the empty pages, the released pages around it were released by an
+    // earlier trim already.
+    while (start < end && page_map_[ToPageMapIndex(start)] == kPageMapReleased) {
+      start += kPageSize;
+    }
+    while (end > start && page_map_[ToPageMapIndex(end - kPageSize)] == kPageMapReleased) {
+      end -= kPageSize;
+    }
+    if (start == end) {
+      return 0;
+    }
+  }
   if (!kMadviseZeroes) {
     // TODO: Do this when we resurrect the page instead.
     memset(start, 0, end - start);
   }
-  CHECK_EQ(madvise(start, end - start, MADV_DONTNEED), 0);
+  if (DoesReleaseAllPages()) {
+    // FreePages() does not zero the pages in this mode, the madvise does.
+    CHECK_EQ(madvise(start, end - start, MADV_DONTNEED), 0);
+  } else {
+    ReleaseZeroedPages(start, end - start);
+  }
   size_t pm_idx = ToPageMapIndex(start);
   size_t reclaimed_bytes = 0;
   // Calculate reclaimed bytes and upate page map.
@@ -26,6 +26,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include "atomic.h"
 #include "base/allocator.h"
 #include "base/bit_utils.h"
 #include "base/mutex.h"
@@ -450,7 +451,10 @@ class RosAlloc {
     // Zero the run's header and the slot headers.
     void ZeroHeaderAndSlotHeaders();
     // Iterate over all the slots and apply the given function.
-    void InspectAllSlots(void (*handler)(void* start, void* end, size_t used_bytes, void* callback_arg), void* arg);
+    void InspectAllSlots(RosAlloc* rosalloc,
+                         void (*handler)(void* start, void* end, size_t used_bytes,
+                                         void* callback_arg),
+                         void* arg);
     // Dump the run metadata for debugging.
     std::string Dump();
     // Verify for debugging.
@@ -465,6 +469,9 @@ class RosAlloc {
     // Turns a FreeList into a string for debugging.
     template<bool kUseTail>
     std::string FreeListToStr(SlotFreeList<kUseTail>* free_list);
+    // Marks the slots of the run cached in the CPU magazines in `is_free`. They are allocated
+    // in the run but do not hold objects.
+    void MarkCpuCachedSlotsFree(const RosAlloc* rosalloc, bool* is_free) const;
     // Check a given pointer is a valid slot address and return it as Slot*.
     Slot* ToSlot(void* ptr) {
       const uint8_t idx = size_bracket_idx_;
@@ -693,6 +700,13 @@ class RosAlloc {
   // Equal to Log2(kBracketQuantumSize).
   static constexpr size_t kBracketQuantumSizeShift = 4;
 
+  // Whether the allocations of the regular brackets that do not use thread-local runs are first
+  // attempted from a per-CPU cache of slots, not to contend on the bracket locks.
+  static constexpr bool kUseCpuCaches = true;
+
+  // The number of slots a per-CPU cache holds at most for a size bracket.
+  static constexpr size_t kCpuCacheMagazineCapacity = 16;
+
  private:
   // The base address of the memory region that's managed by this allocator.
   uint8_t* base_;
@@ -734,6 +748,37 @@ class RosAlloc {
   Mutex* size_bracket_locks_[kNumOfSizeBrackets];
   // Bracket lock names (since locks only have char* names).
   std::string size_bracket_lock_names_[kNumOfSizeBrackets];
+
+  // The slots of a size bracket cached for a CPU. The slots are allocated in their runs. A thread
+  // that fails to acquire the magazine, as it may have been migrated off the CPU in between, takes
+  // the bracket lock instead. The magazine is refilled from the current run, taking the bracket
+  // lock once for all of its slots.
+  struct Magazine {
+    Atomic<bool> busy_;
+    size_t num_slots_;
+    void* slots_[kCpuCacheMagazineCapacity];
+
+    Magazine() : busy_(false), num_slots_(0) {}
+
+    bool TryAcquire() {
+      return busy_.CompareExchangeWeakAcquire(false, true);
+    }
+
+    void Release() {
+      busy_.StoreRelease(false);
+    }
+  };
+
+  // The magazines of a CPU, for the regular brackets that do not use thread-local runs.
+  struct CpuCache {
+    Magazine magazines_[kNumRegularSizeBrackets - kNumThreadLocalSizeBrackets];
+    // Keep the magazines of the CPUs apart, on different cache lines.
+    uint8_t padding_[64];
+  };
+
+  // One per CPU, empty if the CPU of a thread cannot be known.
+  size_t num_cpu_caches_;
+  std::unique_ptr<CpuCache[]> cpu_caches_;
   // The types of page map entries.
   enum PageMapKind {
     kPageMapReleased = 0,     // Zero and released back to the OS.
@@ -770,6 +815,9 @@ class RosAlloc {
   // Under kPageReleaseModeSize(AndEnd), if the free page run size is
   // greater than or equal to this value, release pages.
   const size_t page_release_size_threshold_;
+  // The pages are released by whole blocks of this size, such as the huge pages backing the
+  // memory region, which releasing a part of would split.
+  const size_t page_release_alignment_;
 
   // Whether this allocator is running under Valgrind.
   bool is_running_on_memory_tool_;
@@ -795,6 +843,13 @@ class RosAlloc {
                                  size_t* usable_size, size_t* bytes_tl_bulk_allocated)
       REQUIRES(!lock_);
   void* AllocFromCurrentRunUnlocked(Thread* self, size_t idx) REQUIRES(!lock_);
+  // Allocate a slot of a regular bracket that does not use thread-local runs, from the cache of
+  // the current CPU if possible.
+  void* AllocFromCpuCache(Thread* self, size_t idx) REQUIRES(!lock_);
+  // Returns the magazine of the current CPU for the bracket, or null if the CPU is unknown.
+  Magazine* GetCpuMagazine(size_t idx);
+  // Free the slots cached for the CPUs back to their runs.
+  void RevokeCpuCaches() REQUIRES(!lock_, !bulk_free_lock_);
 
   // Returns the bracket size.
   size_t FreeFromRun(Thread* self, void* ptr, Run* run)
@@ -831,7 +886,8 @@ class RosAlloc {
   RosAlloc(void* base, size_t capacity, size_t max_capacity,
            PageReleaseMode page_release_mode,
            bool running_on_memory_tool,
-           size_t page_release_size_threshold = kDefaultPageReleaseSizeThreshold);
+           size_t page_release_size_threshold = kDefaultPageReleaseSizeThreshold,
+           size_t page_release_alignment = kPageSize);
   ~RosAlloc();
 
   static size_t RunFreeListOffset() {
@@ -892,6 +948,11 @@ class RosAlloc {
 
   // Release empty pages.
   size_t ReleasePages() REQUIRES(!lock_);
+  // Release the empty pages from the page map index *resume_idx on, stopping once NanoTime()
+  // passes deadline_ns. Returns true if it reached the end of the page map, false after setting
+  // *resume_idx to the index to resume from. Adds the bytes released to *reclaimed_bytes.
+  bool ReleasePages(size_t* resume_idx, uint64_t deadline_ns, size_t* reclaimed_bytes)
+      REQUIRES(!lock_);
   // Returns the current footprint.
   size_t Footprint() REQUIRES(!lock_);
   // Returns the current capacity, maximum footprint.
@@ -69,12 +69,12 @@ inline mirror::Object* ConcurrentCopying::MarkUnevacFromSpaceRegion(
 template<bool kGrayImmuneObject>
 inline mirror::Object* ConcurrentCopying::MarkImmuneSpace(mirror::Object* ref) {
   if (kUseBakerReadBarrier) {
-    // The GC-running thread doesn't (need to) gray immune objects except when updating thread roots
-    // in the thread flip on behalf of suspended threads (when gc_grays_immune_objects_ is
-    // true). Also, a mutator doesn't (need to) gray an immune object after GC has updated all
-    // immune space objects (when updated_all_immune_objects_ is true).
+    // The GC-running thread (or a thread helping it to mark) doesn't (need to) gray immune objects
+    // except when updating thread roots in the thread flip on behalf of suspended threads (when
+    // gc_grays_immune_objects_ is true). Also, a mutator doesn't (need to) gray an immune object
+    // after GC has updated all immune space objects (when updated_all_immune_objects_ is true).
     if (kIsDebugBuild) {
-      if (Thread::Current() == thread_running_gc_) {
+      if (IsMarkingThread(Thread::Current())) {
         DCHECK(!kGrayImmuneObject ||
                updated_all_immune_objects_.LoadRelaxed() ||
                gc_grays_immune_objects_);
@@ -106,7 +106,7 @@ inline mirror::Object* ConcurrentCopying::Mark(mirror::Object* from_ref,
   DCHECK(heap_->collector_type_ == kCollectorTypeCC);
   if (kFromGCThread) {
     DCHECK(is_active_);
-    DCHECK_EQ(Thread::Current(), thread_running_gc_);
+    DCHECK(IsMarkingThread(Thread::Current()));
   } else if (UNLIKELY(kUseBakerReadBarrier && !is_active_)) {
     // In the lock word forward address state, the read barrier bits
     // in the lock word are part of the stored forwarding address and
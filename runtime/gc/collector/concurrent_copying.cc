@@ -16,6 +16,8 @@
 
 #include "concurrent_copying.h"
 
+#include <sched.h>
+
 #include "art_field-inl.h"
 #include "base/enums.h"
 #include "base/histogram-inl.h"
@@ -27,6 +29,7 @@
 #include "gc/accounting/mod_union_table-inl.h"
 #include "gc/accounting/read_barrier_table.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/accounting/work_stealing_deque.h"
 #include "gc/gc_pause_listener.h"
 #include "gc/reference_processor.h"
 #include "gc/space/image_space.h"
@@ -40,6 +43,7 @@
 #include "scoped_thread_state_change-inl.h"
 #include "thread-inl.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 #include "well_known_classes.h"
 
 namespace art {
@@ -62,7 +66,9 @@ static constexpr bool kVerifyNoMissingCardMarks = kIsDebugBuild;
 
 ConcurrentCopying::ConcurrentCopying(Heap* heap,
                                      const std::string& name_prefix,
-                                     bool measure_read_barrier_slow_path)
+                                     bool measure_read_barrier_slow_path,
+                                     bool use_generational,
+                                     bool young_gen)
     : GarbageCollector(heap,
                        name_prefix + (name_prefix.empty() ? "" : " ") +
                        "concurrent copying"),
@@ -99,11 +105,15 @@ ConcurrentCopying::ConcurrentCopying(Heap* heap,
       rb_slow_path_count_gc_total_(0),
       rb_table_(heap_->GetReadBarrierTable()),
       force_evacuate_all_(false),
+      use_generational_(use_generational),
+      young_gen_(young_gen),
       gc_grays_immune_objects_(false),
       immune_gray_stack_lock_("concurrent copying immune gray stack lock",
                               kMarkSweepMarkStackLock) {
   static_assert(space::RegionSpace::kRegionSize == accounting::ReadBarrierTable::kRegionSize,
                 "The region space size and the read barrier table region size must match");
+  // The young collections rely on the Baker read barrier to gray the old objects on dirty cards.
+  CHECK(!young_gen_ || (use_generational_ && kUseBakerReadBarrier));
   Thread* self = Thread::Current();
   {
     ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
@@ -172,6 +182,9 @@ void ConcurrentCopying::RunPhases() {
     // the pause.
     ReaderMutexLock mu(self, *Locks::mutator_lock_);
     GrayAllDirtyImmuneObjects();
+    if (young_gen_) {
+      GrayAllDirtyOldObjects();
+    }
   }
   FlipThreadRoots();
   {
@@ -268,7 +281,11 @@ void ConcurrentCopying::BindBitmaps() {
       // It is OK to clear the bitmap with mutators running since the only place it is read is
       // VisitObjects which has exclusion with CC.
       region_space_bitmap_ = region_space_->GetMarkBitmap();
-      region_space_bitmap_->Clear();
+      // The young collections keep the bits of the old regions, the regions they collect have
+      // none since they were allocated after the last collection.
+      if (!young_gen_) {
+        region_space_bitmap_->Clear();
+      }
     }
   }
 }
@@ -294,6 +311,14 @@ void ConcurrentCopying::InitializePhase() {
     rb_slow_path_count_gc_.StoreRelaxed(0);
   }
 
+  marking_helper_threads_.clear();
+  ThreadPool* thread_pool = heap_->GetThreadPool();
+  if (thread_pool != nullptr) {
+    for (ThreadPoolWorker* worker : thread_pool->GetWorkers()) {
+      marking_helper_threads_.push_back(worker->GetThread());
+    }
+  }
+
   immune_spaces_.Reset();
   bytes_moved_.StoreRelaxed(0);
   objects_moved_.StoreRelaxed(0);
@@ -325,8 +350,11 @@ void ConcurrentCopying::InitializePhase() {
     }
     LOG(INFO) << "GC end of InitializePhase";
   }
-  // Mark all of the zygote large objects without graying them.
-  MarkZygoteLargeObjects();
+  // Mark all of the zygote large objects without graying them. The young collections do not mark
+  // the large objects.
+  if (!young_gen_) {
+    MarkZygoteLargeObjects();
+  }
 }
 
 // Used to switch the thread roots of a thread from from-space refs to to-space refs.
@@ -419,13 +447,22 @@ class ConcurrentCopying::FlipCallback : public Closure {
     Locks::mutator_lock_->AssertExclusiveHeld(self);
     {
       TimingLogger::ScopedTiming split2("(Paused)SetFromSpace", cc->GetTimings());
-      cc->region_space_->SetFromSpace(cc->rb_table_, cc->force_evacuate_all_);
+      cc->region_space_->SetFromSpace(cc->rb_table_,
+                                      cc->force_evacuate_all_,
+                                      cc->young_gen_,
+                                      cc->heap_->GetRegionEvacuateLivePercent());
     }
     cc->SwapStacks();
     if (ConcurrentCopying::kEnableFromSpaceAccountingCheck) {
       cc->RecordLiveStackFreezeSize(self);
       cc->from_space_num_objects_at_first_pause_ = cc->region_space_->GetObjectsAllocated();
       cc->from_space_num_bytes_at_first_pause_ = cc->region_space_->GetBytesAllocated();
+      if (cc->young_gen_) {
+        // The old regions, left in the to-space, are not collected.
+        cc->from_space_num_objects_at_first_pause_ -=
+            cc->region_space_->GetObjectsAllocatedInToSpace();
+        cc->from_space_num_bytes_at_first_pause_ -= cc->region_space_->GetBytesAllocatedInToSpace();
+      }
     }
     cc->is_marking_ = true;
     cc->mark_stack_mode_.StoreRelaxed(ConcurrentCopying::kMarkStackModeThreadLocal);
@@ -444,6 +481,18 @@ class ConcurrentCopying::FlipCallback : public Closure {
         cc->VerifyGrayImmuneObjects();
       }
     }
+    if (cc->use_generational_) {
+      if (cc->young_gen_) {
+        cc->GrayAllNewlyDirtyOldObjects();
+      }
+      // The stores from now on dirty the cards for the next young collection. The objects the
+      // collection moves or keeps are all old, the references to them need no card.
+      TimingLogger::ScopedTiming split4("(Paused)ClearOldCards", cc->GetTimings());
+      accounting::CardTable* const card_table = cc->heap_->GetCardTable();
+      card_table->ClearCardRange(cc->region_space_->Begin(), cc->region_space_->Limit());
+      card_table->ClearCardRange(cc->heap_->non_moving_space_->Begin(),
+                                 cc->heap_->non_moving_space_->Limit());
+    }
     // May be null during runtime creation, in this case leave java_lang_Object null.
     // This is safe since single threaded behavior should mean FillDummyObject does not
     // happen when java_lang_Object_ is null.
@@ -729,6 +778,100 @@ void ConcurrentCopying::GrayAllNewlyDirtyImmuneObjects() {
   updated_all_immune_objects_.StoreRelaxed(true);
 }
 
+template <bool kConcurrent>
+class ConcurrentCopying::GrayOldObjectVisitor {
+ public:
+  explicit GrayOldObjectVisitor(ConcurrentCopying* collector) : collector_(collector) {}
+
+  ALWAYS_INLINE void operator()(mirror::Object* obj) const REQUIRES_SHARED(Locks::mutator_lock_) {
+    DCHECK(!collector_->region_space_->HasAddress(obj) ||
+           collector_->region_space_->IsInOldRegion(obj)) << obj;
+    bool grayed;
+    if (kConcurrent) {
+      grayed = obj->AtomicSetReadBarrierState(ReadBarrier::WhiteState(), ReadBarrier::GrayState());
+    } else {
+      grayed = obj->GetReadBarrierState() == ReadBarrier::WhiteState();
+      if (grayed) {
+        obj->SetReadBarrierState(ReadBarrier::GrayState());
+      }
+    }
+    if (grayed) {
+      // Only the GC thread pushes before the thread flip and in the pause.
+      accounting::ObjectStack* const gc_mark_stack = collector_->gc_mark_stack_.get();
+      if (UNLIKELY(gc_mark_stack->IsFull())) {
+        collector_->ExpandGcMarkStack();
+      }
+      gc_mark_stack->PushBack(obj);
+    }
+  }
+
+ private:
+  ConcurrentCopying* const collector_;
+};
+
+void ConcurrentCopying::GrayAllDirtyOldObjects() {
+  TimingLogger::ScopedTiming split("GrayAllDirtyOldObjects", GetTimings());
+  accounting::CardTable* const card_table = heap_->GetCardTable();
+  GrayOldObjectVisitor</* kConcurrent */ true> visitor(this);
+  WriterMutexLock mu(Thread::Current(), *Locks::heap_bitmap_lock_);
+  space::ContinuousSpace* const spaces[] = { region_space_, heap_->non_moving_space_ };
+  for (space::ContinuousSpace* space : spaces) {
+    // Age the cards so that the pause only rescans the cards dirtied from now on.
+    card_table->ModifyCardsAtomic(space->Begin(),
+                                  space->Limit(),
+                                  AgeCardVisitor(),
+                                  /* card modified visitor */ VoidFunctor());
+    // The bitmap of the region space only has the objects of the old regions.
+    card_table->Scan</* kClearCard */ false>(space->GetLiveBitmap(),
+                                             space->Begin(),
+                                             space->Limit(),
+                                             visitor,
+                                             accounting::CardTable::kCardAged);
+  }
+}
+
+void ConcurrentCopying::GrayAllNewlyDirtyOldObjects() {
+  TimingLogger::ScopedTiming split("(Paused)GrayAllNewlyDirtyOldObjects", GetTimings());
+  accounting::CardTable* const card_table = heap_->GetCardTable();
+  GrayOldObjectVisitor</* kConcurrent */ false> visitor(this);
+  WriterMutexLock mu(Thread::Current(), *Locks::heap_bitmap_lock_);
+  space::ContinuousSpace* const spaces[] = { region_space_, heap_->non_moving_space_ };
+  for (space::ContinuousSpace* space : spaces) {
+    card_table->Scan</* kClearCard */ false>(space->GetLiveBitmap(),
+                                             space->Begin(),
+                                             space->Limit(),
+                                             visitor,
+                                             accounting::CardTable::kCardDirty);
+  }
+  // The objects allocated in the non-moving space and the large object space since the last
+  // collection are not in the live bitmaps yet, and the class of a large object is set without a
+  // card mark.
+  accounting::ObjectStack* const live_stack = heap_->GetLiveStack();
+  for (StackReference<mirror::Object>* it = live_stack->Begin(); it != live_stack->End(); ++it) {
+    mirror::Object* const obj = it->AsMirrorPtr();
+    // The thread-local allocation stacks may not be full.
+    if (obj != nullptr) {
+      visitor(obj);
+    }
+  }
+  // The large objects are not in a continuous space, look at the card of each one of them.
+  space::LargeObjectSpace* const los = heap_->GetLargeObjectsSpace();
+  if (los != nullptr) {
+    std::pair<uint8_t*, uint8_t*> range = los->GetBeginEndAtomic();
+    los->GetLiveBitmap()->VisitMarkedRange(
+        reinterpret_cast<uintptr_t>(range.first),
+        reinterpret_cast<uintptr_t>(range.second),
+        [card_table, &visitor](mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
+          if (card_table->GetCard(obj) != accounting::CardTable::kCardClean) {
+            visitor(obj);
+            // The large objects are page aligned.
+            uint8_t* const begin = reinterpret_cast<uint8_t*>(obj);
+            card_table->ClearCardRange(begin, begin + accounting::CardTable::kCardSize);
+          }
+        });
+  }
+}
+
 void ConcurrentCopying::SwapStacks() {
   heap_->SwapStacks();
 }
@@ -1412,13 +1555,26 @@ bool ConcurrentCopying::ProcessMarkStackOnce() {
   MarkStackMode mark_stack_mode = mark_stack_mode_.LoadRelaxed();
   if (mark_stack_mode == kMarkStackModeThreadLocal) {
     // Process the thread-local mark stacks and the GC mark stack.
-    count += ProcessThreadLocalMarkStacks(false, nullptr);
-    while (!gc_mark_stack_->IsEmpty()) {
-      mirror::Object* to_ref = gc_mark_stack_->PopBack();
-      ProcessMarkStackRef(to_ref);
-      ++count;
+    RevokeThreadLocalMarkStacks(false, nullptr);
+    size_t thread_count = GetThreadCount();
+    size_t num_refs = gc_mark_stack_->Size();
+    if (thread_count > 1) {
+      MutexLock mu(self, mark_stack_lock_);
+      for (accounting::ObjectStack* mark_stack : revoked_mark_stacks_) {
+        num_refs += mark_stack->Size();
+      }
+    }
+    if (thread_count > 1 && num_refs >= kMinParallelMarkStackSize) {
+      count += ProcessMarkStackParallel(thread_count);
+    } else {
+      count += ProcessRevokedMarkStacks();
+      while (!gc_mark_stack_->IsEmpty()) {
+        mirror::Object* to_ref = gc_mark_stack_->PopBack();
+        ProcessMarkStackRef(to_ref);
+        ++count;
+      }
+      gc_mark_stack_->Reset();
     }
-    gc_mark_stack_->Reset();
   } else if (mark_stack_mode == kMarkStackModeShared) {
     // Do an empty checkpoint to avoid a race with a mutator preempted in the middle of a read
     // barrier but before pushing onto the mark stack. b/32508093. Note the weak ref access is
@@ -1472,6 +1628,10 @@ size_t ConcurrentCopying::ProcessThreadLocalMarkStacks(bool disable_weak_ref_acc
                                                        Closure* checkpoint_callback) {
   // Run a checkpoint to collect all thread local mark stacks and iterate over them all.
   RevokeThreadLocalMarkStacks(disable_weak_ref_access, checkpoint_callback);
+  return ProcessRevokedMarkStacks();
+}
+
+size_t ConcurrentCopying::ProcessRevokedMarkStacks() {
   size_t count = 0;
   std::vector<accounting::AtomicStack<mirror::Object>*> mark_stacks;
   {
@@ -1486,22 +1646,314 @@ size_t ConcurrentCopying::ProcessThreadLocalMarkStacks(bool disable_weak_ref_acc
       ProcessMarkStackRef(to_ref);
       ++count;
     }
-    {
-      MutexLock mu(Thread::Current(), mark_stack_lock_);
-      if (pooled_mark_stacks_.size() >= kMarkStackPoolSize) {
-        // The pool has enough. Delete it.
-        delete mark_stack;
+    RecycleMarkStack(mark_stack);
+  }
+  return count;
+}
+
+void ConcurrentCopying::RecycleMarkStack(accounting::ObjectStack* mark_stack) {
+  MutexLock mu(Thread::Current(), mark_stack_lock_);
+  if (pooled_mark_stacks_.size() >= kMarkStackPoolSize) {
+    // The pool has enough. Delete it.
+    delete mark_stack;
+  } else {
+    // Otherwise, put it into the pool for later reuse.
+    mark_stack->Reset();
+    pooled_mark_stacks_.push_back(mark_stack);
+  }
+}
+
+// The refs to process of the parallel marking, split in one work-stealing deque per thread as for
+// the parallel copying of SemiSpace. A thread moves the refs it marks from the GC mark stack, or
+// from its thread-local mark stack, to its deque after each ref processed, so that the others can
+// steal them. The thread-local mark stacks revoked meanwhile are taken by the threads out of refs.
+class ConcurrentCopying::ParallelMarkWork {
+ public:
+  typedef accounting::WorkStealingDeque<mirror::Object*> Deque;
+
+  // The capacity of a deque, the refs past it stay private to their thread.
+  static constexpr size_t kDequeCapacity = 16 * KB;
+
+  ParallelMarkWork(ConcurrentCopying* concurrent_copying, size_t num_deques)
+      : active_tasks_(static_cast<int32_t>(num_deques)),
+        refs_processed_(0u),
+        concurrent_copying_(concurrent_copying) {
+    for (size_t i = 0; i != num_deques; ++i) {
+      deques_.emplace_back(new Deque(kDequeCapacity));
+    }
+  }
+
+  Deque* GetDeque(size_t index) const {
+    return deques_[index].get();
+  }
+
+  // Steal a ref from the deques of the other threads, starting past the one of the thief.
+  bool Steal(size_t thief_index, mirror::Object** to_ref) const {
+    for (size_t i = 1; i < deques_.size(); ++i) {
+      if (deques_[(thief_index + i) % deques_.size()]->Steal(to_ref)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Take a thread-local mark stack revoked by a mutator, or by a thread of the parallel marking
+  // whose own one was full. Returns null if there is none.
+  accounting::ObjectStack* TakeRevokedMarkStack() const NO_THREAD_SAFETY_ANALYSIS {
+    MutexLock mu(Thread::Current(), concurrent_copying_->mark_stack_lock_);
+    std::vector<accounting::ObjectStack*>& revoked_mark_stacks =
+        concurrent_copying_->revoked_mark_stacks_;
+    if (revoked_mark_stacks.empty()) {
+      return nullptr;
+    }
+    accounting::ObjectStack* mark_stack = revoked_mark_stacks.back();
+    revoked_mark_stacks.pop_back();
+    return mark_stack;
+  }
+
+  bool HasWork() const NO_THREAD_SAFETY_ANALYSIS {
+    for (const std::unique_ptr<Deque>& deque : deques_) {
+      if (!deque->IsEmpty()) {
+        return true;
+      }
+    }
+    MutexLock mu(Thread::Current(), concurrent_copying_->mark_stack_lock_);
+    return !concurrent_copying_->revoked_mark_stacks_.empty();
+  }
+
+  // The tasks not out of work, as for the parallel copying of SemiSpace. The mutators may revoke
+  // more thread-local mark stacks after the tasks are done, which are left to the next round of
+  // ProcessMarkStackOnce().
+  AtomicInteger active_tasks_;
+  Atomic<size_t> refs_processed_;
+
+ private:
+  ConcurrentCopying* const concurrent_copying_;
+  std::vector<std::unique_ptr<Deque>> deques_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMarkWork);
+};
+
+class ConcurrentCopying::ParallelMarkTask : public Task {
+ public:
+  ParallelMarkTask(ConcurrentCopying* concurrent_copying, ParallelMarkWork* work, size_t index)
+      : concurrent_copying_(concurrent_copying),
+        work_(work),
+        index_(index),
+        deque_(work->GetDeque(index)),
+        refs_processed_(0u) {
+  }
+
+  // The object arrays longer than this are scanned this many elements at a time, so that the
+  // other threads can steal the rest of a large array instead of waiting for its scan.
+  static constexpr int32_t kArrayRangeLength = 1 * KB;
+
+  static bool IsLargeObjectArray(mirror::Object* to_ref) REQUIRES_SHARED(Locks::mutator_lock_) {
+    return to_ref->IsObjectArray<kVerifyNone, kWithoutReadBarrier>() &&
+        to_ref->AsObjectArray<mirror::Object, kVerifyNone, kWithoutReadBarrier>()->
+            GetLength<kVerifyNone>() > kArrayRangeLength;
+  }
+
+  // Only called by the thread running the task, or before the workers are started.
+  void Push(mirror::Object* to_ref) {
+    DCHECK(to_ref != nullptr);
+    if (UNLIKELY(!deque_->Push(to_ref))) {
+      // The deque is full, keep the ref until there is room again.
+      overflow_stack_.push_back(to_ref);
+    }
+  }
+
+  virtual void Run(Thread* self) OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    // The GC-running thread pushes the refs it marks onto the GC mark stack, the threads of the
+    // heap thread pool onto their thread-local mark stacks.
+    const bool is_gc_thread = (self == concurrent_copying_->thread_running_gc_);
+    DCHECK(concurrent_copying_->IsMarkingThread(self));
+    mirror::Object* to_ref;
+    while (PopLocal(&to_ref) ||
+           (TakeRevokedMarkStack() && PopLocal(&to_ref)) ||
+           StealOrFinish(&to_ref)) {
+      if (IsArrayRange(to_ref)) {
+        ScanArrayRange(to_ref);
       } else {
-        // Otherwise, put it into the pool for later reuse.
-        mark_stack->Reset();
-        pooled_mark_stacks_.push_back(mark_stack);
+        if (!concurrent_copying_->ProcessMarkStackRef</*kParallel*/ true>(to_ref)) {
+          mirror::ObjectArray<mirror::Object>* array =
+              to_ref->AsObjectArray<mirror::Object, kVerifyNone, kWithoutReadBarrier>();
+          const int32_t length = array->GetLength<kVerifyNone>();
+          ArrayRange* range = new ArrayRange;
+          range->array = array;
+          range->begin = 0;
+          range->end = length;
+          range->ranges_left.StoreRelaxed(RoundUp(length, kArrayRangeLength) / kArrayRangeLength);
+          ScanArrayRange(reinterpret_cast<mirror::Object*>(
+              reinterpret_cast<uintptr_t>(range) | kArrayRangeTag));
+        }
+        ++refs_processed_;
+      }
+      accounting::ObjectStack* mark_stack = is_gc_thread
+          ? concurrent_copying_->gc_mark_stack_.get()
+          : self->GetThreadLocalMarkStack();
+      if (mark_stack != nullptr) {
+        while (!mark_stack->IsEmpty()) {
+          Push(mark_stack->PopBack());
+        }
       }
     }
+    DCHECK(deque_->IsEmpty());
+    DCHECK(overflow_stack_.empty());
   }
-  return count;
-}
 
-inline void ConcurrentCopying::ProcessMarkStackRef(mirror::Object* to_ref) {
+  virtual void Finalize() OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    work_->refs_processed_.FetchAndAddSequentiallyConsistent(refs_processed_);
+    // Give back the thread-local mark stack of a thread of the heap thread pool, left empty.
+    Thread* self = Thread::Current();
+    accounting::ObjectStack* tl_mark_stack = self->GetThreadLocalMarkStack();
+    if (tl_mark_stack != nullptr) {
+      DCHECK(tl_mark_stack->IsEmpty());
+      self->SetThreadLocalMarkStack(nullptr);
+      concurrent_copying_->RecycleMarkStack(tl_mark_stack);
+    }
+    delete this;
+  }
+
+ private:
+  // The elements of a large object array left to scan, pushed tagged in place of a ref.
+  struct ArrayRange {
+    mirror::ObjectArray<mirror::Object>* array;
+    int32_t begin;
+    int32_t end;
+    // The ranges of the array not scanned yet, the last one scanned finishes the array.
+    AtomicInteger ranges_left;
+  };
+  static constexpr uintptr_t kArrayRangeTag = 1u;
+
+  static bool IsArrayRange(mirror::Object* to_ref) {
+    return (reinterpret_cast<uintptr_t>(to_ref) & kArrayRangeTag) != 0u;
+  }
+
+  // Scan the next elements of a range, after pushing the rest of the range for a thief.
+  void ScanArrayRange(mirror::Object* tagged_range) NO_THREAD_SAFETY_ANALYSIS {
+    ArrayRange* range =
+        reinterpret_cast<ArrayRange*>(reinterpret_cast<uintptr_t>(tagged_range) & ~kArrayRangeTag);
+    mirror::ObjectArray<mirror::Object>* const array = range->array;
+    const int32_t begin = range->begin;
+    const int32_t end = std::min(range->end, begin + kArrayRangeLength);
+    if (end != range->end) {
+      range->begin = end;
+      Push(tagged_range);
+    }
+    concurrent_copying_->ScanArrayElements(array, begin, end);
+    if (range->ranges_left.FetchAndSubSequentiallyConsistent(1) == 1) {
+      delete range;
+      concurrent_copying_->FinishMarkStackRef(array);
+    }
+  }
+
+  // Pop a ref of the task. Returns false once its deque and its private refs are both empty.
+  bool PopLocal(mirror::Object** to_ref) {
+    do {
+      if (LIKELY(deque_->Pop(to_ref))) {
+        return true;
+      }
+      // Move the overflowed refs back to the deque, where they can be stolen.
+      while (!overflow_stack_.empty() && deque_->Push(overflow_stack_.back())) {
+        overflow_stack_.pop_back();
+      }
+    } while (!deque_->IsEmpty() || !overflow_stack_.empty());
+    return false;
+  }
+
+  // Move the refs of a revoked thread-local mark stack to the task. Returns false if there was
+  // none.
+  bool TakeRevokedMarkStack() NO_THREAD_SAFETY_ANALYSIS {
+    accounting::ObjectStack* mark_stack = work_->TakeRevokedMarkStack();
+    if (mark_stack == nullptr) {
+      return false;
+    }
+    for (StackReference<mirror::Object>* p = mark_stack->Begin(); p != mark_stack->End(); ++p) {
+      Push(p->AsMirrorPtr());
+    }
+    concurrent_copying_->RecycleMarkStack(mark_stack);
+    return true;
+  }
+
+  // Called when the task is out of refs. Returns false once all the tasks are.
+  bool StealOrFinish(mirror::Object** to_ref) {
+    if (work_->Steal(index_, to_ref)) {
+      return true;
+    }
+    work_->active_tasks_.FetchAndSubSequentiallyConsistent(1);
+    for (;;) {
+      // Check the work left before the active tasks: a thief becomes active before taking the
+      // last ref of a deque or a revoked mark stack, and stays active until it pushed the refs
+      // marked from it.
+      if (work_->HasWork()) {
+        work_->active_tasks_.FetchAndAddSequentiallyConsistent(1);
+        if (work_->Steal(index_, to_ref) || (TakeRevokedMarkStack() && PopLocal(to_ref))) {
+          return true;
+        }
+        work_->active_tasks_.FetchAndSubSequentiallyConsistent(1);
+      } else if (work_->active_tasks_.LoadSequentiallyConsistent() == 0) {
+        return false;
+      } else {
+        sched_yield();
+      }
+    }
+  }
+
+  ConcurrentCopying* const concurrent_copying_;
+  ParallelMarkWork* const work_;
+  const size_t index_;
+  ParallelMarkWork::Deque* const deque_;
+  // The refs pushed while the deque was full, not visible to the other threads.
+  std::vector<mirror::Object*> overflow_stack_;
+  size_t refs_processed_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMarkTask);
+};
+
+size_t ConcurrentCopying::ProcessMarkStackParallel(size_t thread_count) {
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = heap_->GetThreadPool();
+  // One task per thread, each owning a deque its thread pushes to and the others steal from.
+  ParallelMarkWork work(this, thread_count);
+  std::vector<ParallelMarkTask*> tasks;
+  for (size_t i = 0; i != thread_count; ++i) {
+    tasks.push_back(new ParallelMarkTask(this, &work, i));
+  }
+  // Deal the GC mark stack to the tasks. They take the revoked thread-local mark stacks as they
+  // run out of refs.
+  size_t next_task = 0;
+  for (StackReference<mirror::Object>* p = gc_mark_stack_->Begin(); p != gc_mark_stack_->End();
+       ++p) {
+    tasks[next_task]->Push(p->AsMirrorPtr());
+    next_task = (next_task + 1) % thread_count;
+  }
+  gc_mark_stack_->Reset();
+  for (ParallelMarkTask* task : tasks) {
+    thread_pool->AddTask(self, task);
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  // The GC-running thread runs a task too, still holding the mutator lock shared like the
+  // concurrent marking of MarkSweep does, so that the threads of the pool may access the heap.
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+  DCHECK(gc_mark_stack_->IsEmpty());
+  gc_mark_stack_->Reset();
+  return work.refs_processed_.LoadSequentiallyConsistent();
+}
+
+size_t ConcurrentCopying::GetThreadCount() const {
+  // Use less threads if we are in a background state (non jank perceptible) since we want to leave
+  // more CPU time for the foreground apps.
+  if (heap_->GetThreadPool() == nullptr || !Runtime::Current()->InJankPerceptibleProcessState()) {
+    return 1;
+  }
+  return heap_->GetConcGCThreadCount() + 1;
+}
+
+template <bool kParallel>
+inline bool ConcurrentCopying::ProcessMarkStackRef(mirror::Object* to_ref) {
   DCHECK(!region_space_->IsInFromSpace(to_ref));
   if (kUseBakerReadBarrier) {
     DCHECK(to_ref->GetReadBarrierState() == ReadBarrier::GrayState())
@@ -1509,18 +1961,46 @@ inline void ConcurrentCopying::ProcessMarkStackRef(mirror::Object* to_ref) {
         << " is_marked=" << IsMarked(to_ref);
   }
   bool add_to_live_bytes = false;
+  // The parallel marking scans the large object arrays by ranges instead.
+  bool split = false;
   if (region_space_->IsInUnevacFromSpace(to_ref)) {
-    // Mark the bitmap only in the GC thread here so that we don't need a CAS.
-    if (!kUseBakerReadBarrier || !region_space_bitmap_->Set(to_ref)) {
+    // Mark the bitmap only in the GC threads here so that we don't need a CAS unless several of
+    // them process the mark stack.
+    if (!kUseBakerReadBarrier ||
+        !(kParallel ? region_space_bitmap_->AtomicTestAndSet(to_ref)
+                    : region_space_bitmap_->Set(to_ref))) {
       // It may be already marked if we accidentally pushed the same object twice due to the racy
       // bitmap read in MarkUnevacFromSpaceRegion.
-      Scan(to_ref);
+      split = kParallel && ParallelMarkTask::IsLargeObjectArray(to_ref);
+      if (!split) {
+        Scan(to_ref);
+      }
       // Only add to the live bytes if the object was not already marked.
       add_to_live_bytes = true;
     }
   } else {
-    Scan(to_ref);
+    split = kParallel && ParallelMarkTask::IsLargeObjectArray(to_ref);
+    if (!split) {
+      Scan(to_ref);
+    }
+  }
+  if (add_to_live_bytes) {
+    // Add to the live bytes per unevacuated from space. Note this code is always run by the
+    // GC-running thread (no synchronization required) unless the mark stack is processed in
+    // parallel.
+    DCHECK(region_space_bitmap_->Test(to_ref));
+    size_t obj_size = to_ref->SizeOf<kDefaultVerifyFlags>();
+    size_t alloc_size = RoundUp(obj_size, space::RegionSpace::kAlignment);
+    region_space_->AddLiveBytes<kParallel>(to_ref, alloc_size);
+  }
+  if (split) {
+    return false;
   }
+  FinishMarkStackRef(to_ref);
+  return true;
+}
+
+inline void ConcurrentCopying::FinishMarkStackRef(mirror::Object* to_ref) {
   if (kUseBakerReadBarrier) {
     DCHECK(to_ref->GetReadBarrierState() == ReadBarrier::GrayState())
         << " " << to_ref << " " << to_ref->GetReadBarrierState()
@@ -1550,14 +2030,6 @@ inline void ConcurrentCopying::ProcessMarkStackRef(mirror::Object* to_ref) {
   DCHECK(!kUseBakerReadBarrier);
 #endif
 
-  if (add_to_live_bytes) {
-    // Add to the live bytes per unevacuated from space. Note this code is always run by the
-    // GC-running thread (no synchronization required).
-    DCHECK(region_space_bitmap_->Test(to_ref));
-    size_t obj_size = to_ref->SizeOf<kDefaultVerifyFlags>();
-    size_t alloc_size = RoundUp(obj_size, space::RegionSpace::kAlignment);
-    region_space_->AddLiveBytes(to_ref, alloc_size);
-  }
   if (ReadBarrier::kEnableToSpaceInvariantChecks) {
     CHECK(to_ref != nullptr);
     space::RegionSpace* region_space = RegionSpace();
@@ -1660,16 +2132,18 @@ void ConcurrentCopying::SweepSystemWeaks(Thread* self) {
   Runtime::Current()->SweepSystemWeaks(this);
 }
 
-void ConcurrentCopying::Sweep(bool swap_bitmaps) {
-  {
-    TimingLogger::ScopedTiming t("MarkStackAsLive", GetTimings());
-    accounting::ObjectStack* live_stack = heap_->GetLiveStack();
-    if (kEnableFromSpaceAccountingCheck) {
-      CHECK_GE(live_stack_freeze_size_, live_stack->Size());
-    }
-    heap_->MarkAllocStackAsLive(live_stack);
-    live_stack->Reset();
+void ConcurrentCopying::MarkStackAsLive() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  accounting::ObjectStack* live_stack = heap_->GetLiveStack();
+  if (kEnableFromSpaceAccountingCheck) {
+    CHECK_GE(live_stack_freeze_size_, live_stack->Size());
   }
+  heap_->MarkAllocStackAsLive(live_stack);
+  live_stack->Reset();
+}
+
+void ConcurrentCopying::Sweep(bool swap_bitmaps) {
+  MarkStackAsLive();
   CheckEmptyMarkStack();
   TimingLogger::ScopedTiming split("Sweep", GetTimings());
   for (const auto& space : GetHeap()->GetContinuousSpaces()) {
@@ -1752,6 +2226,12 @@ void ConcurrentCopying::ReclaimPhase() {
     cumulative_bytes_moved_.FetchAndAddRelaxed(to_bytes);
     uint64_t to_objects = objects_moved_.LoadSequentiallyConsistent();
     cumulative_objects_moved_.FetchAndAddRelaxed(to_objects);
+    const size_t evacuated_regions = region_space_->GetNumEvacuatedRegions();
+    const size_t unevacuated_regions = region_space_->GetNumUnevacuatedRegions();
+    cumulative_regions_evacuated_.FetchAndAddRelaxed(evacuated_regions);
+    cumulative_regions_unevacuated_.FetchAndAddRelaxed(unevacuated_regions);
+    VLOG(heap) << GetName() << " evacuated " << evacuated_regions << " regions and kept "
+               << unevacuated_regions << " in place";
     if (kEnableFromSpaceAccountingCheck) {
       CHECK_EQ(from_space_num_objects_at_first_pause_, from_objects + unevac_from_objects);
       CHECK_EQ(from_space_num_bytes_at_first_pause_, from_bytes + unevac_from_bytes);
@@ -1764,7 +2244,7 @@ void ConcurrentCopying::ReclaimPhase() {
     uint64_t cleared_objects;
     {
       TimingLogger::ScopedTiming split4("ClearFromSpace", GetTimings());
-      region_space_->ClearFromSpace(&cleared_bytes, &cleared_objects);
+      region_space_->ClearFromSpace(&cleared_bytes, &cleared_objects, use_generational_);
       CHECK_GE(cleared_bytes, from_bytes);
       CHECK_GE(cleared_objects, from_objects);
     }
@@ -1789,9 +2269,15 @@ void ConcurrentCopying::ReclaimPhase() {
 
   {
     WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
-    Sweep(false);
-    SwapBitmaps();
-    heap_->UnBindBitmaps();
+    if (young_gen_) {
+      // The non-moving space and the large object space are not swept, only keep their objects
+      // allocated since the last collection.
+      MarkStackAsLive();
+    } else {
+      Sweep(false);
+      SwapBitmaps();
+      heap_->UnBindBitmaps();
+    }
 
     // The bitmap was cleared at the start of the GC, there is nothing we need to do here.
     DCHECK(region_space_bitmap_ != nullptr);
@@ -1947,7 +2433,7 @@ void ConcurrentCopying::AssertToSpaceInvariantInNonMovingSpace(mirror::Object* o
   if (immune_spaces_.ContainsObject(ref)) {
     if (kUseBakerReadBarrier) {
       // Immune object may not be gray if called from the GC.
-      if (Thread::Current() == thread_running_gc_ && !gc_grays_immune_objects_) {
+      if (IsMarkingThread(Thread::Current()) && !gc_grays_immune_objects_) {
         return;
       }
       bool updated_all_immune_objects = updated_all_immune_objects_.LoadSequentiallyConsistent();
@@ -1957,6 +2443,8 @@ void ConcurrentCopying::AssertToSpaceInvariantInNonMovingSpace(mirror::Object* o
           << " ref=" << ref << " ref rb_state=" << ref->GetReadBarrierState()
           << " updated_all_immune_objects=" << updated_all_immune_objects;
     }
+  } else if (young_gen_) {
+    // Not marked by a young collection, but alive.
   } else {
     accounting::ContinuousSpaceBitmap* mark_bitmap =
         heap_mark_bitmap_->GetContinuousSpaceBitmap(ref);
@@ -2021,7 +2509,7 @@ inline void ConcurrentCopying::Scan(mirror::Object* to_ref) {
     Thread::Current()->ModifyDebugDisallowReadBarrier(1);
   }
   DCHECK(!region_space_->IsInFromSpace(to_ref));
-  DCHECK_EQ(Thread::Current(), thread_running_gc_);
+  DCHECK(IsMarkingThread(Thread::Current()));
   RefFieldsVisitor visitor(this);
   // Disable the read barrier for a performance reason.
   to_ref->VisitReferences</*kVisitNativeRoots*/true, kDefaultVerifyFlags, kWithoutReadBarrier>(
@@ -2031,9 +2519,27 @@ inline void ConcurrentCopying::Scan(mirror::Object* to_ref) {
   }
 }
 
+inline void ConcurrentCopying::ScanArrayElements(mirror::ObjectArray<mirror::Object>* array,
+                                                 int32_t begin,
+                                                 int32_t end) {
+  if (kDisallowReadBarrierDuringScan && !Runtime::Current()->IsActiveTransaction()) {
+    Thread::Current()->ModifyDebugDisallowReadBarrier(1);
+  }
+  DCHECK(!region_space_->IsInFromSpace(array));
+  if (begin == 0) {
+    Process(array, mirror::Object::ClassOffset());
+  }
+  for (int32_t i = begin; i != end; ++i) {
+    Process(array, mirror::ObjectArray<mirror::Object>::OffsetOfElement(i));
+  }
+  if (kDisallowReadBarrierDuringScan && !Runtime::Current()->IsActiveTransaction()) {
+    Thread::Current()->ModifyDebugDisallowReadBarrier(-1);
+  }
+}
+
 // Process a field.
 inline void ConcurrentCopying::Process(mirror::Object* obj, MemberOffset offset) {
-  DCHECK_EQ(Thread::Current(), thread_running_gc_);
+  DCHECK(IsMarkingThread(Thread::Current()));
   mirror::Object* ref = obj->GetFieldObject<
       mirror::Object, kVerifyNone, kWithoutReadBarrier, false>(offset);
   mirror::Object* to_ref = Mark</*kGrayImmuneObject*/false, /*kFromGCThread*/true>(
@@ -2253,9 +2759,10 @@ mirror::Object* ConcurrentCopying::Copy(mirror::Object* from_ref,
   // Note that from_ref is a from space ref so the SizeOf() call will access the from-space meta
   // objects, but it's ok and necessary.
   size_t obj_size = from_ref->SizeOf<kDefaultVerifyFlags>();
-  size_t region_space_alloc_size = (obj_size <= space::RegionSpace::kRegionSize)
+  const size_t region_size = region_space_->GetRegionSize();
+  size_t region_space_alloc_size = (obj_size <= region_size)
       ? RoundUp(obj_size, space::RegionSpace::kAlignment)
-      : RoundUp(obj_size, space::RegionSpace::kRegionSize);
+      : RoundUp(obj_size, region_size);
   size_t region_space_bytes_allocated = 0U;
   size_t non_moving_space_bytes_allocated = 0U;
   size_t bytes_allocated = 0U;
@@ -2295,9 +2802,9 @@ mirror::Object* ConcurrentCopying::Copy(mirror::Object* from_ref,
         LOG(FATAL) << "Object address=" << from_ref << " type=" << from_ref->PrettyTypeOf();
       }
       bytes_allocated = non_moving_space_bytes_allocated;
-      // Mark it in the mark bitmap.
-      accounting::ContinuousSpaceBitmap* mark_bitmap =
-          heap_mark_bitmap_->GetContinuousSpaceBitmap(to_ref);
+      // Mark it in the mark bitmap, or the live bitmap for a young collection, which does not swap
+      // the bitmaps.
+      accounting::ContinuousSpaceBitmap* mark_bitmap = NonMovingFallbackBitmap(to_ref);
       CHECK(mark_bitmap != nullptr);
       CHECK(!mark_bitmap->AtomicTestAndSet(to_ref));
     }
@@ -2330,7 +2837,7 @@ mirror::Object* ConcurrentCopying::Copy(mirror::Object* from_ref,
       FillWithDummyObject(to_ref, bytes_allocated);
       if (!fall_back_to_non_moving) {
         DCHECK(region_space_->IsInToSpace(to_ref));
-        if (bytes_allocated > space::RegionSpace::kRegionSize) {
+        if (bytes_allocated > region_size) {
           // Free the large alloc.
           region_space_->FreeLarge(to_ref, bytes_allocated);
         } else {
@@ -2346,8 +2853,7 @@ mirror::Object* ConcurrentCopying::Copy(mirror::Object* from_ref,
         DCHECK(heap_->non_moving_space_->HasAddress(to_ref));
         DCHECK_EQ(bytes_allocated, non_moving_space_bytes_allocated);
         // Free the non-moving-space chunk.
-        accounting::ContinuousSpaceBitmap* mark_bitmap =
-            heap_mark_bitmap_->GetContinuousSpaceBitmap(to_ref);
+        accounting::ContinuousSpaceBitmap* mark_bitmap = NonMovingFallbackBitmap(to_ref);
         CHECK(mark_bitmap != nullptr);
         CHECK(mark_bitmap->Clear(to_ref));
         heap_->non_moving_space_->Free(Thread::Current(), to_ref);
@@ -2385,6 +2891,11 @@ mirror::Object* ConcurrentCopying::Copy(mirror::Object* from_ref,
       bytes_moved_.FetchAndAddRelaxed(region_space_alloc_size);
       if (LIKELY(!fall_back_to_non_moving)) {
         DCHECK(region_space_->IsInToSpace(to_ref));
+        if (use_generational_) {
+          // Keep all the objects of the old regions in the bitmap, for the card scans of the young
+          // collections.
+          region_space_bitmap_->AtomicTestAndSet(to_ref);
+        }
       } else {
         DCHECK(heap_->non_moving_space_->HasAddress(to_ref));
         DCHECK_EQ(bytes_allocated, non_moving_space_bytes_allocated);
@@ -2403,6 +2914,14 @@ mirror::Object* ConcurrentCopying::Copy(mirror::Object* from_ref,
   }
 }
 
+accounting::ContinuousSpaceBitmap* ConcurrentCopying::NonMovingFallbackBitmap(
+    mirror::Object* to_ref) {
+  DCHECK(heap_->non_moving_space_->HasAddress(to_ref));
+  return young_gen_
+      ? heap_->non_moving_space_->GetLiveBitmap()
+      : heap_mark_bitmap_->GetContinuousSpaceBitmap(to_ref);
+}
+
 mirror::Object* ConcurrentCopying::IsMarked(mirror::Object* from_ref) {
   DCHECK(from_ref != nullptr);
   space::RegionSpace::RegionType rtype = region_space_->GetRegionType(from_ref);
@@ -2424,8 +2943,8 @@ mirror::Object* ConcurrentCopying::IsMarked(mirror::Object* from_ref) {
     }
   } else {
     // from_ref is in a non-moving space.
-    if (immune_spaces_.ContainsObject(from_ref)) {
-      // An immune object is alive.
+    if (immune_spaces_.ContainsObject(from_ref) || young_gen_) {
+      // An immune object is alive, and so are the non-moving objects of a young collection.
       to_ref = from_ref;
     } else {
       // Non-immune non-moving space. Use the mark bitmap.
@@ -2475,6 +2994,11 @@ mirror::Object* ConcurrentCopying::MarkNonMoving(mirror::Object* ref,
   // ref is in a non-moving space (from_ref == to_ref).
   DCHECK(!region_space_->HasAddress(ref)) << ref;
   DCHECK(!immune_spaces_.ContainsObject(ref));
+  if (young_gen_) {
+    // The non-moving space and the large objects are only collected by the full collections. The
+    // ones that may refer to young objects were grayed from their cards.
+    return ref;
+  }
   // Use the mark bitmap.
   accounting::ContinuousSpaceBitmap* mark_bitmap =
       heap_mark_bitmap_->GetContinuousSpaceBitmap(ref);
@@ -2559,8 +3083,8 @@ void ConcurrentCopying::FinishPhase() {
     CHECK_EQ(pooled_mark_stacks_.size(), kMarkStackPoolSize);
   }
   // kVerifyNoMissingCardMarks relies on the region space cards not being cleared to avoid false
-  // positives.
-  if (!kVerifyNoMissingCardMarks) {
+  // positives. The generational mode clears them in the pause instead.
+  if (!kVerifyNoMissingCardMarks && !use_generational_) {
     TimingLogger::ScopedTiming split("ClearRegionSpaceCards", GetTimings());
     // We do not currently use the region space cards at all, madvise them away to save ram.
     heap_->GetCardTable()->ClearCardRange(region_space_->Begin(), region_space_->Limit());
@@ -2685,6 +3209,9 @@ void ConcurrentCopying::DumpPerformanceInfo(std::ostream& os) {
   }
   os << "Cumulative bytes moved " << cumulative_bytes_moved_.LoadRelaxed() << "\n";
   os << "Cumulative objects moved " << cumulative_objects_moved_.LoadRelaxed() << "\n";
+  os << "Cumulative regions evacuated " << cumulative_regions_evacuated_.LoadRelaxed() << "\n";
+  os << "Cumulative regions kept in place " << cumulative_regions_unevacuated_.LoadRelaxed()
+     << "\n";
 }
 
 }  // namespace collector
@@ -25,6 +25,7 @@
 #include "mirror/object_reference.h"
 #include "safe_map.h"
 
+#include <algorithm>
 #include <unordered_map>
 #include <vector>
 
@@ -34,6 +35,7 @@ class RootInfo;
 
 namespace mirror {
 class Object;
+template<class T> class ObjectArray;
 }  // namespace mirror
 
 namespace gc {
@@ -65,9 +67,14 @@ class ConcurrentCopying : public GarbageCollector {
   // pages.
   static constexpr bool kGrayDirtyImmuneObjects = true;
 
+  // With use_generational, the collections keep the objects of the old regions in the region
+  // space bitmap and the cards of the old regions and the non-moving space, for the young
+  // collections (young_gen) that only collect the regions allocated since the last collection.
   explicit ConcurrentCopying(Heap* heap,
                              const std::string& name_prefix = "",
-                             bool measure_read_barrier_slow_path = false);
+                             bool measure_read_barrier_slow_path = false,
+                             bool use_generational = false,
+                             bool young_gen = false);
   ~ConcurrentCopying();
 
   virtual void RunPhases() OVERRIDE
@@ -87,7 +94,7 @@ class ConcurrentCopying : public GarbageCollector {
   void BindBitmaps() REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!Locks::heap_bitmap_lock_);
   virtual GcType GetGcType() const OVERRIDE {
-    return kGcTypePartial;
+    return young_gen_ ? kGcTypeSticky : kGcTypePartial;
   }
   virtual CollectorType GetCollectorType() const OVERRIDE {
     return kCollectorTypeCC;
@@ -148,8 +155,15 @@ class ConcurrentCopying : public GarbageCollector {
                        MemberOffset offset)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_, !skipped_blocks_lock_, !immune_gray_stack_lock_);
+  // The bitmap to mark the copies that fall back to the non-moving space.
+  accounting::ContinuousSpaceBitmap* NonMovingFallbackBitmap(mirror::Object* to_ref)
+      REQUIRES_SHARED(Locks::mutator_lock_);
   void Scan(mirror::Object* to_ref) REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
+  // Scan the elements [begin, end) of an object array, and its class along the first elements.
+  void ScanArrayElements(mirror::ObjectArray<mirror::Object>* array, int32_t begin, int32_t end)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
   void Process(mirror::Object* obj, MemberOffset offset)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_ , !skipped_blocks_lock_, !immune_gray_stack_lock_);
@@ -170,14 +184,45 @@ class ConcurrentCopying : public GarbageCollector {
   virtual void ProcessMarkStack() OVERRIDE REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
   bool ProcessMarkStackOnce() REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!mark_stack_lock_);
-  void ProcessMarkStackRef(mirror::Object* to_ref) REQUIRES_SHARED(Locks::mutator_lock_)
+  // kParallel is true if the threads of the heap thread pool process the mark stack too. Returns
+  // false if to_ref is a large object array then, left for the caller to scan by ranges of
+  // elements and to finish with FinishMarkStackRef().
+  template <bool kParallel = false>
+  bool ProcessMarkStackRef(mirror::Object* to_ref) REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
+  // Done with the scan of to_ref, turn it white unless it is a reference to leave gray.
+  void FinishMarkStackRef(mirror::Object* to_ref) REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
+  // Process the GC mark stack and the revoked thread-local mark stacks with the GC-running thread
+  // and the threads of the heap thread pool, in the thread-local mark stack mode. Returns the
+  // number of refs processed.
+  size_t ProcessMarkStackParallel(size_t thread_count) REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
+  // The number of threads processing the mark stack concurrently, including the GC-running thread.
+  size_t GetThreadCount() const;
+  // True for the GC-running thread, and for the threads of the heap thread pool, which help it
+  // to process the mark stack.
+  bool IsMarkingThread(Thread* self) const {
+    return self == thread_running_gc_ ||
+        std::find(marking_helper_threads_.begin(), marking_helper_threads_.end(), self) !=
+            marking_helper_threads_.end();
+  }
   void GrayAllDirtyImmuneObjects()
       REQUIRES(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
   void GrayAllNewlyDirtyImmuneObjects()
       REQUIRES(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
+  // Gray and push the old objects of the region space and the non-moving space that are on dirty
+  // cards, since these may point to young objects.
+  void GrayAllDirtyOldObjects()
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
+  // Same for the cards dirtied since GrayAllDirtyOldObjects(), and for the large objects, which
+  // are scanned in the pause only.
+  void GrayAllNewlyDirtyOldObjects()
+      REQUIRES(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
   void VerifyGrayImmuneObjects()
       REQUIRES(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
@@ -186,6 +231,11 @@ class ConcurrentCopying : public GarbageCollector {
       REQUIRES(!mark_stack_lock_);
   size_t ProcessThreadLocalMarkStacks(bool disable_weak_ref_access, Closure* checkpoint_callback)
       REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!mark_stack_lock_);
+  // Process the thread-local mark stacks revoked so far. Returns the number of refs processed.
+  size_t ProcessRevokedMarkStacks() REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
+  // Put a thread-local mark stack back into the pool once processed.
+  void RecycleMarkStack(accounting::ObjectStack* mark_stack) REQUIRES(!mark_stack_lock_);
   void RevokeThreadLocalMarkStacks(bool disable_weak_ref_access, Closure* checkpoint_callback)
       REQUIRES_SHARED(Locks::mutator_lock_);
   void SwitchToSharedMarkStackMode() REQUIRES_SHARED(Locks::mutator_lock_)
@@ -209,6 +259,8 @@ class ConcurrentCopying : public GarbageCollector {
       REQUIRES_SHARED(Locks::mutator_lock_);
   void SweepSystemWeaks(Thread* self)
       REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!Locks::heap_bitmap_lock_);
+  void MarkStackAsLive()
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::heap_bitmap_lock_);
   void Sweep(bool swap_bitmaps)
       REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::heap_bitmap_lock_, !mark_stack_lock_);
   void SweepLargeObjects(bool swap_bitmaps)
@@ -277,6 +329,10 @@ class ConcurrentCopying : public GarbageCollector {
   std::vector<accounting::ObjectStack*> pooled_mark_stacks_
       GUARDED_BY(mark_stack_lock_);
   Thread* thread_running_gc_;
+  // The threads of the heap thread pool, for IsMarkingThread(). Set in InitializePhase().
+  std::vector<Thread*> marking_helper_threads_;
+  // Below this number of refs to process, the GC-running thread processes them alone.
+  static constexpr size_t kMinParallelMarkStackSize = 1 * KB;
   bool is_marking_;                       // True while marking is ongoing.
   // True while we might dispatch on the read barrier entrypoints.
   bool is_using_read_barrier_entrypoints_;
@@ -307,6 +363,9 @@ class ConcurrentCopying : public GarbageCollector {
   Atomic<size_t> objects_moved_;
   Atomic<uint64_t> cumulative_bytes_moved_;
   Atomic<uint64_t> cumulative_objects_moved_;
+  // How many regions were evacuated, and kept in place as unevacuated from-space.
+  Atomic<uint64_t> cumulative_regions_evacuated_;
+  Atomic<uint64_t> cumulative_regions_unevacuated_;
 
   // The skipped blocks are memory blocks/chucks that were copies of
   // objects that were unused due to lost races (cas failures) at
@@ -332,6 +391,8 @@ class ConcurrentCopying : public GarbageCollector {
 
   accounting::ReadBarrierTable* rb_table_;
   bool force_evacuate_all_;  // True if all regions are evacuated.
+  const bool use_generational_;  // True if the old regions are kept for the young collections.
+  const bool young_gen_;  // True if only the young regions are collected.
   Atomic<bool> updated_all_immune_objects_;
   bool gc_grays_immune_objects_;
   Mutex immune_gray_stack_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
@@ -353,8 +414,11 @@ class ConcurrentCopying : public GarbageCollector {
   class DisableWeakRefAccessCallback;
   class FlipCallback;
   template <bool kConcurrent> class GrayImmuneObjectVisitor;
+  template <bool kConcurrent> class GrayOldObjectVisitor;
   class ImmuneSpaceScanObjVisitor;
   class LostCopyVisitor;
+  class ParallelMarkTask;
+  class ParallelMarkWork;
   class RefFieldsVisitor;
   class RevokeThreadLocalMarkStackCheckpoint;
   class ScopedGcGraysImmuneObjects;
@@ -57,6 +57,7 @@ void Iteration::Reset(GcCause gc_cause, bool clear_soft_references) {
   freed_ = ObjectBytePair();
   freed_los_ = ObjectBytePair();
   freed_bytes_revoke_ = 0;
+  promoted_bytes_ = 0;
 }
 
 uint64_t Iteration::GetEstimatedThroughput() const {
@@ -125,6 +126,12 @@ void GarbageCollector::Run(GcCause gc_cause, bool clear_soft_references) {
     MutexLock mu(self, pause_histogram_lock_);
     pause_histogram_.AdjustAndAddValue(pause_time);
   }
+  metrics_.RecordGc(gc_cause,
+                    current_iteration->GetDurationNs(),
+                    current_iteration->GetPauseTimes(),
+                    current_iteration->GetFreedBytes() +
+                        current_iteration->GetFreedLargeObjectBytes(),
+                    current_iteration->GetPromotedBytes());
   // Update max mark/sweep/pause times for gc profile.
   if (Runtime::Current()->EnabledGcProfile()) {
     uint64_t pause_max = 0;
@@ -221,16 +228,37 @@ void GarbageCollector::RecordFree(const ObjectBytePair& freed) {
   GetCurrentIteration()->freed_.Add(freed);
   heap_->RecordFree(freed.objects, freed.bytes);
 }
+
 void GarbageCollector::RecordFreeLOS(const ObjectBytePair& freed) {
   GetCurrentIteration()->freed_los_.Add(freed);
   heap_->RecordFree(freed.objects, freed.bytes);
 }
 
+void GarbageCollector::RecordPromoted(uint64_t bytes) {
+  GetCurrentIteration()->promoted_bytes_ += bytes;
+}
+
 uint64_t GarbageCollector::GetTotalPausedTimeNs() {
   MutexLock mu(Thread::Current(), pause_histogram_lock_);
   return pause_histogram_.AdjustedSum();
 }
 
+uint64_t GarbageCollector::GetPausePercentileNs(double per) {
+  MutexLock mu(Thread::Current(), pause_histogram_lock_);
+  if (pause_histogram_.SampleSize() == 0) {
+    return 0;
+  }
+  Histogram<uint64_t>::CumulativeData cumulative_data;
+  pause_histogram_.CreateHistogram(&cumulative_data);
+  // The pauses are added in microseconds.
+  return UsToNs(static_cast<uint64_t>(pause_histogram_.Percentile(per, cumulative_data)));
+}
+
+uint64_t GarbageCollector::GetMaxPauseNs() {
+  MutexLock mu(Thread::Current(), pause_histogram_lock_);
+  return pause_histogram_.SampleSize() == 0 ? 0 : UsToNs(pause_histogram_.Max());
+}
+
 void GarbageCollector::DumpPerformanceInfo(std::ostream& os) {
   const CumulativeLogger& logger = GetCumulativeTimings();
   const size_t iterations = logger.GetIterations();
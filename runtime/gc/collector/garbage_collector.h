@@ -25,6 +25,7 @@
 #include "base/timing_logger.h"
 #include "gc/collector_type.h"
 #include "gc/gc_cause.h"
+#include "gc/gc_metrics.h"
 #include "gc_root.h"
 #include "gc_type.h"
 #include "iteration.h"
@@ -85,6 +86,10 @@ class GarbageCollector : public RootVisitor, public IsMarkedVisitor, public Mark
       REQUIRES(Locks::heap_bitmap_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
   uint64_t GetTotalPausedTimeNs() REQUIRES(!pause_histogram_lock_);
+  // Returns the pause time below which the given fraction of the pauses fall, 0 without pauses.
+  uint64_t GetPausePercentileNs(double per) REQUIRES(!pause_histogram_lock_);
+  // Returns the longest pause, 0 without pauses.
+  uint64_t GetMaxPauseNs() REQUIRES(!pause_histogram_lock_);
   int64_t GetTotalFreedBytes() const {
     return total_freed_bytes_;
   }
@@ -109,6 +114,12 @@ class GarbageCollector : public RootVisitor, public IsMarkedVisitor, public Mark
   void RecordFree(const ObjectBytePair& freed);
   // Record a free of large objects.
   void RecordFreeLOS(const ObjectBytePair& freed);
+  // Record bytes copied to the old generation.
+  void RecordPromoted(uint64_t bytes);
+  // The metrics of the GCs run, readable at any time without locks.
+  const GcMetrics& GetMetrics() const {
+    return metrics_;
+  }
   virtual void DumpPerformanceInfo(std::ostream& os) REQUIRES(!pause_histogram_lock_);
 
   // Helper functions for querying if objects are marked. These are used for processing references,
@@ -153,6 +164,7 @@ class GarbageCollector : public RootVisitor, public IsMarkedVisitor, public Mark
   uint64_t total_freed_objects_;
   int64_t total_freed_bytes_;
   CumulativeLogger cumulative_timings_;
+  GcMetrics metrics_;
   mutable Mutex pause_histogram_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   bool is_transaction_active_;
 
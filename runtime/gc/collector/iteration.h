@@ -66,6 +66,10 @@ class Iteration {
   uint64_t GetFreedLargeObjects() const {
     return freed_los_.objects;
   }
+  // Returns the bytes copied to the old generation by a generational collector.
+  uint64_t GetPromotedBytes() const {
+    return promoted_bytes_;
+  }
   uint64_t GetFreedRevokeBytes() const {
     return freed_bytes_revoke_;
   }
@@ -97,6 +101,7 @@ class Iteration {
   ObjectBytePair freed_;
   ObjectBytePair freed_los_;
   uint64_t freed_bytes_revoke_;  // see Heap::num_bytes_freed_revoke_.
+  uint64_t promoted_bytes_;
   std::vector<uint64_t> pause_times_;
   // Mark/sweep times for gc profiling.
   uint64_t mark_time_;
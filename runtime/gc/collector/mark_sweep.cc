@@ -18,6 +18,7 @@
 
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <numeric>
 #include <climits>
 #include <vector>
@@ -67,6 +68,15 @@ static constexpr bool kParallelRecursiveMark = true;
 // ProcessMarkStack with very small mark stacks.
 static constexpr size_t kMinimumParallelMarkStackSize = 128;
 static constexpr bool kParallelProcessMarkStack = true;
+// The card ranges and sweep ranges are cut in this many tasks per thread. The threads take the
+// next task from the pool when they are done, which balances the work when the dirty cards or
+// the garbage concentrate in a part of the space.
+static constexpr size_t kTasksPerThread = 4;
+static constexpr bool kParallelSweep = true;
+// Don't sweep in parallel the allocation stacks smaller than this, or split the spaces in
+// ranges smaller than this.
+static constexpr size_t kMinimumParallelSweepArraySize = 4 * KB;
+static constexpr size_t kMinimumParallelSweepRange = 256 * KB;
 
 // Profiling and information flags.
 static constexpr bool kProfileLargeObjects = false;
@@ -104,6 +114,7 @@ MarkSweep::MarkSweep(Heap* heap, bool is_concurrent, bool is_copying,
       mark_stack_(nullptr),
       gc_barrier_(new Barrier(0)),
       mark_stack_lock_("mark sweep mark stack lock", kMarkSweepMarkStackLock),
+      sweep_free_lock_("mark sweep free lock", kDefaultMutexLevel),
       is_concurrent_(is_concurrent),
       is_copying_(is_copying),
       live_stack_freeze_size_(0),
@@ -1024,6 +1035,7 @@ void MarkSweep::PausePhase() {
     // Add the promoted bytes here as the revoke count on it.
     if (bytes_promoted_ > 0u) {
       GetHeap()->AddBytesAllocated(bytes_promoted_.LoadRelaxed());
+      RecordPromoted(bytes_promoted_.LoadRelaxed());
     }
     // Revoke buffers before measuring how many objects were moved since the TLABs needs
     // to be revoked before they are properly counted.
@@ -1062,7 +1074,7 @@ void MarkSweep::PausePhase() {
     // is no lock in the GetReferent fast path.
     GetHeap()->GetReferenceProcessor()->EnableSlowPath();
   } else {
-    from_bps_->GetAgingTable()->Reset();
+    // The aging table of the from space was cleared along with it.
     heap_->SwapSemiSpaces();
   }
 }
@@ -1183,8 +1195,8 @@ void MarkSweep::ReclaimPhase() {
   if (!IsCopying()) {
     // Process the references concurrently.
     ProcessReferences(self);
+    // Also allows the new system weaks, of each holder once it is swept.
     SweepSystemWeaks(self);
-    runtime->AllowNewSystemWeaks();
   }
   // Clean up class loaders after system weaks are swept since that is how we know if class
   // unloading occurred.
@@ -1752,7 +1764,8 @@ void MarkSweep::ScanGrayObjects(bool paused, uint8_t minimum_age) {
     StackReference<mirror::Object>* mark_stack_end = mark_stack_->End();
     const size_t mark_stack_size = mark_stack_end - mark_stack_begin;
     // Estimated number of work tasks we will create.
-    const size_t mark_stack_tasks = GetHeap()->GetContinuousSpaces().size() * thread_count;
+    const size_t mark_stack_tasks =
+        GetHeap()->GetContinuousSpaces().size() * thread_count * kTasksPerThread;
     DCHECK_NE(mark_stack_tasks, 0U);
     const size_t mark_stack_delta = std::min(CardScanTask::kMaxSize / 2,
                                              mark_stack_size / mark_stack_tasks + 1);
@@ -1779,7 +1792,7 @@ void MarkSweep::ScanGrayObjects(bool paused, uint8_t minimum_age) {
       // Calculate how many bytes of heap we will scan,
       const size_t address_range = card_end - card_begin;
       // Calculate how much address range each task gets.
-      const size_t card_delta = RoundUp(address_range / thread_count + 1,
+      const size_t card_delta = RoundUp(address_range / (thread_count * kTasksPerThread) + 1,
                                         accounting::CardTable::kCardSize);
       // If paused and the space is neither zygote nor image space, we could clear the dirty
       // cards to avoid accumulating them to increase card scanning load in the following GC
@@ -1981,7 +1994,7 @@ void MarkSweep::ReMarkRoots() {
 void MarkSweep::SweepSystemWeaks(Thread* self) {
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
-  Runtime::Current()->SweepSystemWeaks(this);
+  Runtime::Current()->SweepAndAllowSystemWeaks(this, GetTimings());
 }
 
 class MarkSweep::VerifySystemWeakVisitor : public IsMarkedVisitor {
@@ -2085,9 +2098,114 @@ void MarkSweep::MarkRootsCheckpoint(Thread* self,
   Locks::heap_bitmap_lock_->ExclusiveLock(self);
 }
 
+// Frees the garbage of a chunk of the allocation stack for SweepArray. Like the serial sweep,
+// the garbage is buffered by kSweepArrayChunkFreeSize objects, and each full buffer is freed
+// under the sweep free lock.
+class MarkSweep::SweepArrayTask : public Task {
+ public:
+  SweepArrayTask(MarkSweep* mark_sweep,
+                 const std::vector<space::ContinuousSpace*>& spaces,
+                 const std::vector<accounting::ContinuousSpaceBitmap*>& mark_bitmaps,
+                 space::LargeObjectSpace* large_object_space,
+                 accounting::LargeObjectBitmap* large_mark_objects,
+                 StackReference<mirror::Object>* objects,
+                 size_t count)
+      : mark_sweep_(mark_sweep),
+        spaces_(spaces),
+        mark_bitmaps_(mark_bitmaps),
+        large_object_space_(large_object_space),
+        large_mark_objects_(large_mark_objects),
+        objects_(objects),
+        count_(count),
+        garbage_(spaces.size()) {}
+
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    for (size_t i = 0; i < count_; ++i) {
+      mirror::Object* const obj = objects_[i].AsMirrorPtr();
+      if (kUseThreadLocalAllocationStack && obj == nullptr) {
+        continue;
+      }
+      size_t index = 0;
+      while (index != spaces_.size() && !spaces_[index]->HasAddress(obj)) {
+        ++index;
+      }
+      if (index != spaces_.size()) {
+        if (!mark_bitmaps_[index]->Test(obj)) {
+          garbage_[index].push_back(obj);
+          if (garbage_[index].size() >= kSweepArrayChunkFreeSize) {
+            FreeGarbage(self, index);
+          }
+        }
+      } else if (large_mark_objects_ != nullptr && !large_mark_objects_->Test(obj)) {
+        large_garbage_.push_back(obj);
+        if (large_garbage_.size() >= kSweepArrayChunkFreeSize) {
+          FreeLargeGarbage(self);
+        }
+      }
+    }
+    for (size_t index = 0; index != spaces_.size(); ++index) {
+      FreeGarbage(self, index);
+    }
+    FreeLargeGarbage(self);
+    // Don't keep the buffers until the end of the sweep.
+    garbage_.clear();
+    garbage_.shrink_to_fit();
+    large_garbage_.shrink_to_fit();
+  }
+
+  const ObjectBytePair& GetFreed() const {
+    return freed_;
+  }
+
+  const ObjectBytePair& GetFreedLargeObjects() const {
+    return freed_los_;
+  }
+
+ private:
+  void FreeGarbage(Thread* self, size_t index) NO_THREAD_SAFETY_ANALYSIS {
+    std::vector<mirror::Object*>& garbage = garbage_[index];
+    if (garbage.empty()) {
+      return;
+    }
+    MutexLock mu(self, mark_sweep_->sweep_free_lock_);
+    freed_.objects += garbage.size();
+    freed_.bytes += spaces_[index]->AsAllocSpace()->FreeList(self, garbage.size(), garbage.data());
+    garbage.clear();
+  }
+
+  void FreeLargeGarbage(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    if (large_garbage_.empty()) {
+      return;
+    }
+    MutexLock mu(self, mark_sweep_->sweep_free_lock_);
+    for (mirror::Object* obj : large_garbage_) {
+      ++freed_los_.objects;
+      freed_los_.bytes += large_object_space_->Free(self, obj);
+    }
+    large_garbage_.clear();
+  }
+
+  MarkSweep* const mark_sweep_;
+  const std::vector<space::ContinuousSpace*>& spaces_;
+  const std::vector<accounting::ContinuousSpaceBitmap*>& mark_bitmaps_;
+  space::LargeObjectSpace* const large_object_space_;
+  accounting::LargeObjectBitmap* const large_mark_objects_;
+  StackReference<mirror::Object>* const objects_;
+  const size_t count_;
+  std::vector<std::vector<mirror::Object*>> garbage_;
+  std::vector<mirror::Object*> large_garbage_;
+  ObjectBytePair freed_;
+  ObjectBytePair freed_los_;
+};
+
 void MarkSweep::SweepArray(accounting::ObjectStack* allocations, bool swap_bitmaps) {
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   Thread* self = Thread::Current();
+  const size_t thread_count = GetThreadCount(false);
+  if (kParallelSweep && thread_count > 1 && allocations->Size() >= kMinimumParallelSweepArraySize) {
+    SweepArrayParallel(allocations, swap_bitmaps, thread_count);
+    return;
+  }
   mirror::Object** chunk_free_buffer = reinterpret_cast<mirror::Object**>(
       sweep_array_free_buffer_mem_map_->BaseBegin());
   size_t chunk_free_pos = 0;
@@ -2185,6 +2303,179 @@ void MarkSweep::SweepArray(accounting::ObjectStack* allocations, bool swap_bitma
   sweep_array_free_buffer_mem_map_->MadviseDontNeedAndZero();
 }
 
+void MarkSweep::SweepArrayParallel(accounting::ObjectStack* allocations,
+                                   bool swap_bitmaps,
+                                   size_t thread_count) {
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+  std::vector<space::ContinuousSpace*> sweep_spaces;
+  std::vector<accounting::ContinuousSpaceBitmap*> mark_bitmaps;
+  for (space::ContinuousSpace* space : heap_->GetContinuousSpaces()) {
+    if (space->IsAllocSpace() &&
+        !immune_spaces_.ContainsSpace(space) &&
+        space->GetLiveBitmap() != nullptr) {
+      sweep_spaces.push_back(space);
+      mark_bitmaps.push_back(swap_bitmaps ? space->GetLiveBitmap() : space->GetMarkBitmap());
+    }
+  }
+  space::LargeObjectSpace* large_object_space = GetHeap()->GetLargeObjectsSpace();
+  accounting::LargeObjectBitmap* large_mark_objects = nullptr;
+  if (large_object_space != nullptr) {
+    large_mark_objects = swap_bitmaps ? large_object_space->GetLiveBitmap()
+                                      : large_object_space->GetMarkBitmap();
+  }
+  // Find and free the garbage in parallel. Each task holds at most kSweepArrayChunkFreeSize
+  // objects of garbage per space at a time.
+  StackReference<mirror::Object>* objects = allocations->Begin();
+  const size_t count = allocations->Size();
+  const size_t chunk_size = count / (thread_count * kTasksPerThread) + 1;
+  std::vector<std::unique_ptr<SweepArrayTask>> tasks;
+  {
+    TimingLogger::ScopedTiming t("SweepChunks", GetTimings());
+    for (size_t begin = 0; begin < count; begin += chunk_size) {
+      tasks.emplace_back(new SweepArrayTask(this,
+                                            sweep_spaces,
+                                            mark_bitmaps,
+                                            large_object_space,
+                                            large_mark_objects,
+                                            objects + begin,
+                                            std::min(chunk_size, count - begin)));
+      thread_pool->AddTask(self, tasks.back().get());
+    }
+    thread_pool->SetMaxActiveWorkers(thread_count - 1);
+    thread_pool->StartWorkers(self);
+    thread_pool->Wait(self, true, true);
+    thread_pool->StopWorkers(self);
+  }
+  ObjectBytePair freed;
+  ObjectBytePair freed_los;
+  for (const std::unique_ptr<SweepArrayTask>& task : tasks) {
+    freed.Add(task->GetFreed());
+    freed_los.Add(task->GetFreedLargeObjects());
+  }
+  tasks.clear();
+  TimingLogger::ScopedTiming t("RecordFree", GetTimings());
+  RecordFree(freed);
+  RecordFreeLOS(freed_los);
+  t.NewTiming("ResetStack");
+  allocations->Reset();
+}
+
+// Frees the garbage of a range of a space for SweepMallocSpaceParallel, buffered by
+// kSweepArrayChunkFreeSize objects as in SweepArrayTask.
+class MarkSweep::SweepRangeTask : public Task {
+ public:
+  SweepRangeTask(MarkSweep* mark_sweep,
+                 space::ContinuousMemMapAllocSpace* space,
+                 accounting::ContinuousSpaceBitmap* live_bitmap,
+                 accounting::ContinuousSpaceBitmap* mark_bitmap,
+                 uintptr_t begin,
+                 uintptr_t end,
+                 bool clear_live_bits)
+      : mark_sweep_(mark_sweep),
+        space_(space),
+        live_bitmap_(live_bitmap),
+        mark_bitmap_(mark_bitmap),
+        begin_(begin),
+        end_(end),
+        clear_live_bits_(clear_live_bits),
+        self_(nullptr) {}
+
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    self_ = self;
+    accounting::ContinuousSpaceBitmap::SweepWalk(
+        *live_bitmap_, *mark_bitmap_, begin_, end_, &Callback, this);
+    FreeGarbage();
+    // Don't keep the buffer until the end of the sweep.
+    garbage_.shrink_to_fit();
+  }
+
+  const ObjectBytePair& GetFreed() const {
+    return freed_;
+  }
+
+ private:
+  static void Callback(size_t num_ptrs, mirror::Object** ptrs, void* arg) {
+    SweepRangeTask* task = reinterpret_cast<SweepRangeTask*>(arg);
+    // Like MallocSpace::SweepCallback, clear the bits if the GC is not going to swap the
+    // bitmaps. The range covers whole words of the bitmaps, no other task writes them.
+    if (task->clear_live_bits_) {
+      for (size_t i = 0; i < num_ptrs; ++i) {
+        task->live_bitmap_->Clear(ptrs[i]);
+      }
+    }
+    task->garbage_.insert(task->garbage_.end(), ptrs, ptrs + num_ptrs);
+    // The walk passes at most a buffer of its own at a time, which bounds the overshoot.
+    if (task->garbage_.size() >= kSweepArrayChunkFreeSize) {
+      task->FreeGarbage();
+    }
+  }
+
+  void FreeGarbage() NO_THREAD_SAFETY_ANALYSIS {
+    if (garbage_.empty()) {
+      return;
+    }
+    MutexLock mu(self_, mark_sweep_->sweep_free_lock_);
+    freed_.objects += garbage_.size();
+    freed_.bytes += space_->FreeList(self_, garbage_.size(), garbage_.data());
+    garbage_.clear();
+  }
+
+  MarkSweep* const mark_sweep_;
+  space::ContinuousMemMapAllocSpace* const space_;
+  accounting::ContinuousSpaceBitmap* const live_bitmap_;
+  accounting::ContinuousSpaceBitmap* const mark_bitmap_;
+  const uintptr_t begin_;
+  const uintptr_t end_;
+  const bool clear_live_bits_;
+  Thread* self_;
+  std::vector<mirror::Object*> garbage_;
+  ObjectBytePair freed_;
+};
+
+ObjectBytePair MarkSweep::SweepMallocSpaceParallel(space::ContinuousMemMapAllocSpace* space,
+                                                   bool swap_bitmaps,
+                                                   size_t thread_count) {
+  accounting::ContinuousSpaceBitmap* live_bitmap = space->GetLiveBitmap();
+  accounting::ContinuousSpaceBitmap* mark_bitmap = space->GetMarkBitmap();
+  // If the bitmaps are bound then sweeping this space clearly won't do anything.
+  if (live_bitmap == mark_bitmap) {
+    return ObjectBytePair(0, 0);
+  }
+  if (swap_bitmaps) {
+    std::swap(live_bitmap, mark_bitmap);
+  }
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(space->Begin());
+  const uintptr_t end = reinterpret_cast<uintptr_t>(space->End());
+  // The ranges must not share words of the bitmaps, whose bits get cleared.
+  const size_t range_size =
+      RoundUp(std::max((end - begin) / (thread_count * kTasksPerThread) + 1,
+                       kMinimumParallelSweepRange),
+              kObjectAlignment * kBitsPerIntPtrT);
+  std::vector<std::unique_ptr<SweepRangeTask>> tasks;
+  for (uintptr_t range_begin = begin; range_begin < end; range_begin += range_size) {
+    tasks.emplace_back(new SweepRangeTask(this,
+                                          space,
+                                          live_bitmap,
+                                          mark_bitmap,
+                                          range_begin,
+                                          std::min(range_begin + range_size, end),
+                                          !swap_bitmaps));
+    thread_pool->AddTask(self, tasks.back().get());
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+  ObjectBytePair freed;
+  for (const std::unique_ptr<SweepRangeTask>& task : tasks) {
+    freed.Add(task->GetFreed());
+  }
+  return freed;
+}
+
 void MarkSweep::Sweep(bool swap_bitmaps) {
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   // Ensure that nobody inserted items in the live stack after we swapped the stacks.
@@ -2198,6 +2489,7 @@ void MarkSweep::Sweep(bool swap_bitmaps) {
     live_stack->Reset();
     DCHECK(mark_stack_->IsEmpty());
   }
+  const size_t thread_count = GetThreadCount(false);
   for (const auto& space : GetHeap()->GetContinuousSpaces()) {
     // The free of bps is done separately.
     if (space->IsContinuousMemMapAllocSpace() && !space->IsBumpPointerSpace()) {
@@ -2205,7 +2497,11 @@ void MarkSweep::Sweep(bool swap_bitmaps) {
       TimingLogger::ScopedTiming split(
           alloc_space->IsZygoteSpace() ? "SweepZygoteSpace" : "SweepMallocSpace",
           GetTimings());
-      RecordFree(alloc_space->Sweep(swap_bitmaps));
+      if (kParallelSweep && thread_count > 1 && alloc_space->IsMallocSpace()) {
+        RecordFree(SweepMallocSpaceParallel(alloc_space, swap_bitmaps, thread_count));
+      } else {
+        RecordFree(alloc_space->Sweep(swap_bitmaps));
+      }
     }
   }
   SweepLargeObjects(swap_bitmaps);
@@ -181,6 +181,20 @@ class MarkSweep : public GarbageCollector {
   // Sweeps unmarked objects to complete the garbage collection.
   void SweepLargeObjects(bool swap_bitmaps) REQUIRES(Locks::heap_bitmap_lock_);
 
+  // Sweeps the allocation stack with thread_count threads, each freeing the garbage of a chunk.
+  void SweepArrayParallel(accounting::ObjectStack* allocations,
+                          bool swap_bitmaps,
+                          size_t thread_count)
+      REQUIRES(Locks::heap_bitmap_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Sweeps a malloc space with thread_count threads, each freeing the garbage of a range.
+  ObjectBytePair SweepMallocSpaceParallel(space::ContinuousMemMapAllocSpace* space,
+                                          bool swap_bitmaps,
+                                          size_t thread_count)
+      REQUIRES(Locks::heap_bitmap_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Sweep only pointers within an array. WARNING: Trashes objects.
   void SweepArray(accounting::ObjectStack* allocation_stack_, bool swap_bitmaps)
       REQUIRES(Locks::heap_bitmap_lock_)
@@ -201,6 +215,7 @@ class MarkSweep : public GarbageCollector {
       REQUIRES(!mark_stack_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Sweeps the system weaks disallowed by the pause phase, allowing them again as they are swept.
   void SweepSystemWeaks(Thread* self)
       REQUIRES(!Locks::heap_bitmap_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -462,6 +477,8 @@ class MarkSweep : public GarbageCollector {
 
   std::unique_ptr<Barrier> gc_barrier_;
   Mutex mark_stack_lock_ ACQUIRED_AFTER(Locks::classlinker_classes_lock_);
+  // Serializes the frees of the parallel sweep tasks, RosAlloc::BulkFree is not thread safe.
+  Mutex sweep_free_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
 
   const bool is_concurrent_;
   const bool is_copying_;
@@ -481,6 +498,8 @@ class MarkSweep : public GarbageCollector {
 
  private:
   class CardScanTask;
+  class SweepArrayTask;
+  class SweepRangeTask;
   class CheckpointMarkThreadRoots;
   class DelayReferenceReferentVisitor;
   template<bool kUseFinger> class MarkStackTask;
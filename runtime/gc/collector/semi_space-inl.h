@@ -159,96 +159,108 @@ static inline size_t CopyAvoidingDirtyingPages(void* dest, const void* src, size
   return saved_bytes;
 }
 
+inline mirror::Object* SemiSpace::AllocForParallelCopy(
+    space::ContinuousMemMapAllocSpace* dest_space,
+    size_t object_size,
+    size_t* bytes_allocated) {
+  Thread* self = Thread::Current();
+  size_t dummy = 0;
+  if (dest_space->IsRosAllocSpace()) {
+    // The runs of the thread are its size classed buffers, refilled by Alloc() once full.
+    size_t byte_count = RoundUp(object_size, space::BumpPointerSpace::kAlignment);
+    space::RosAllocSpace* ros_space = dest_space->AsRosAllocSpace();
+    mirror::Object* forward_address = ros_space->AllocThreadLocal(self, byte_count,
+                                                                  bytes_allocated);
+    if (forward_address == nullptr) {
+      forward_address = ros_space->Alloc(self, object_size, bytes_allocated, nullptr, &dummy);
+    }
+    return forward_address;
+  }
+  if (!kUsePlab || !dest_space->IsBumpPointerSpace()) {
+    return dest_space->Alloc(self, object_size, bytes_allocated, nullptr, &dummy);
+  }
+  size_t byte_count = RoundUp(object_size, space::BumpPointerSpace::kAlignment);
+  if (byte_count > self->TlabSize()) {
+    // Fail allocate in Tlab, create a new one.
+    // TODO: Delete this atomic operation, it is only for statistic.
+    wasted_bytes_.FetchAndAddSequentiallyConsistent(self->TlabSize());
+    DCHECK_ALIGNED(byte_count, space::BumpPointerSpace::kAlignment);
+    size_t new_tlab_size = byte_count + kDefaultPLABSize;
+    space::BumpPointerSpace* bump_pointer_space = dest_space->AsBumpPointerSpace();
+    // Try allocating a new thread local buffer, if the allocation fails the space must be
+    // full so return null.
+    if (!bump_pointer_space->AllocNewTlab(self, new_tlab_size)) {
+      // Try alloc smaller.
+      new_tlab_size -= kDefaultPLABSize / 2;
+      if (!bump_pointer_space->AllocNewTlab(self, new_tlab_size)) {
+        // Try just the required size.
+        new_tlab_size = byte_count;
+        if (!bump_pointer_space->AllocNewTlab(self, new_tlab_size)) {
+          return nullptr;
+        }
+      }
+    }
+  }
+  // The allocation can't fail.
+  mirror::Object* forward_address = self->AllocTlab(byte_count);
+  DCHECK(forward_address != nullptr);
+  *bytes_allocated = byte_count;
+  return forward_address;
+}
+
+inline void SemiSpace::FreeLostParallelCopy(space::ContinuousMemMapAllocSpace* dest_space,
+                                            mirror::Object* forward_address,
+                                            size_t* bytes_allocated,
+                                            bool copied) {
+  Thread* self = Thread::Current();
+  if (dest_space->IsBumpPointerSpace()) {
+    DCHECK_ALIGNED(*bytes_allocated, space::BumpPointerSpace::kAlignment);
+    if (copied) {
+      // Zero memory because we already copied object.
+      memset(forward_address, 0, *bytes_allocated);
+    }
+    if (kUsePlab) {
+      // Roll back directly.
+      self->RollBackTlab(*bytes_allocated);
+    } else if (!dest_space->AsBumpPointerSpace()->FreeLastAllocation(forward_address,
+                                                                     *bytes_allocated)) {
+      // Another thread allocated past the copy, which can only be filled.
+      this->FillWithDummyObject(forward_address, *bytes_allocated);
+      dummy_bytes_.FetchAndAddSequentiallyConsistent(*bytes_allocated);
+      dummy_objects_.FetchAndAddSequentiallyConsistent(1);
+      return;
+    }
+  } else if (dest_space->IsRosAllocSpace()) {
+    // The slot goes back to the free list of the run of the thread, for the next copy of its
+    // size class. It is zeroed there.
+    space::RosAllocSpace* ros_space = dest_space->AsRosAllocSpace();
+    if (!ros_space->FreeThreadLocal(self, *bytes_allocated, forward_address)) {
+      // Object not in thread local run.
+      size_t freed_bytes = ros_space->FreeNonThread(self, forward_address);
+      DCHECK(freed_bytes == *bytes_allocated);
+    }
+  } else {
+    size_t freed_bytes = dest_space->Free(self, forward_address);
+    DCHECK(freed_bytes == *bytes_allocated);
+  }
+  *bytes_allocated = 0;
+}
+
 // Alloc the object in the dest_space and try update the lockword.
-// If the update fail, try roll back the space.
+// If the update fail, give the copy back to the space.
 inline mirror::Object* SemiSpace::TryInstallForwardingAddress(mirror::Object* obj,
                                                    space::ContinuousMemMapAllocSpace* dest_space,
                                                    size_t* bytes_allocated,
                                                    bool* win) {
   const size_t object_size = obj->SizeOf();
-  mirror::Object* forward_address = nullptr;
-  Thread* self = Thread::Current();
-  size_t dummy = 0;
   *win = false;
-  if (!kUsePlab) {
-    forward_address = dest_space->Alloc(self, object_size, bytes_allocated, nullptr, &dummy);
-  } else {
-    if (dest_space->IsBumpPointerSpace()) {
-     size_t  byte_count = RoundUp(object_size, space::BumpPointerSpace::kAlignment);
-     if (byte_count <= self->TlabSize()) {
-       forward_address = self->AllocTlab(byte_count);
-       DCHECK(forward_address != nullptr);
-     } else {
-       // Fail allocate in Tlab, create a new one.
-       // TODO: Delete this atomic operation, it is only for statistic.
-       wasted_bytes_.FetchAndAddSequentiallyConsistent(self->TlabSize());
-       DCHECK_ALIGNED(byte_count, space::BumpPointerSpace::kAlignment);
-       size_t new_tlab_size = byte_count + kDefaultPLABSize;
-       space::BumpPointerSpace* bump_pointer_space = dest_space->AsBumpPointerSpace();
-       // Try allocating a new thread local buffer, if the allocation fails the space must be
-       // full so return null.
-       if (!bump_pointer_space->AllocNewTlab(self, new_tlab_size)) {
-         // Try alloc smaller.
-         new_tlab_size -= kDefaultPLABSize / 2;
-         if (!bump_pointer_space->AllocNewTlab(self, new_tlab_size)) {
-           // Try just the required size.
-           new_tlab_size = byte_count;
-           if (!bump_pointer_space->AllocNewTlab(self, new_tlab_size)) {
-             return nullptr;
-           }
-         }
-       }
-       // The allocation can't fail.
-       forward_address = self->AllocTlab(byte_count);
-       DCHECK(forward_address != nullptr);
-     }
-     *bytes_allocated = byte_count;
-    } else if (dest_space->IsRosAllocSpace()) {
-      size_t byte_count = RoundUp(object_size, space::BumpPointerSpace::kAlignment);
-      space::RosAllocSpace* ros_space = dest_space->AsRosAllocSpace();
-      forward_address = ros_space->AllocThreadLocal(self, byte_count, bytes_allocated);
-      if (forward_address == nullptr) {
-        forward_address = ros_space->Alloc(self, object_size, bytes_allocated, nullptr, &dummy);
-      }
-    } else {
-      forward_address = dest_space->Alloc(self, object_size, bytes_allocated, nullptr, &dummy);
-    }
-  }
+  mirror::Object* forward_address = AllocForParallelCopy(dest_space, object_size, bytes_allocated);
   if (forward_address != nullptr) {
     // Try to set lockword.
     LockWord old_lock_word = obj->GetLockWord(false);
     if (old_lock_word.GetState() == LockWord::kForwardingAddress) {
       // Object has been copied by another thread, roll back.
-      if (!kUsePlab) {
-        // The RollBack should for all different space.
-        // For Bump pointer space, need fill with dummy.
-        // For ROS, need roll back.
-        if (dest_space->IsBumpPointerSpace()) {
-          this->FillWithDummyObject(forward_address, *bytes_allocated);
-          dummy_bytes_.FetchAndAddSequentiallyConsistent(*bytes_allocated);
-          dummy_objects_.FetchAndAddSequentiallyConsistent(1);
-        } else {
-          dest_space->Free(self, forward_address);
-          *bytes_allocated -= *bytes_allocated;
-        }
-      } else {
-        if (dest_space->IsBumpPointerSpace()) {
-           // Roll back directly.
-           DCHECK_ALIGNED(*bytes_allocated, space::BumpPointerSpace::kAlignment);
-           self->RollBackTlab(*bytes_allocated);
-        } else if (dest_space->IsRosAllocSpace()) {
-          bool freed = dest_space->AsRosAllocSpace()->FreeThreadLocal(self, *bytes_allocated, forward_address);
-          if (!freed) {
-            // Object not in thread local run.
-            size_t freed_bytes = dest_space->AsRosAllocSpace()->FreeNonThread(self, forward_address);
-            DCHECK(freed_bytes == *bytes_allocated);
-          }
-        } else {
-            size_t freed_bytes = dest_space->Free(self, forward_address);
-            DCHECK(freed_bytes == *bytes_allocated);
-        }
-        *bytes_allocated -= *bytes_allocated;
-      }
+      FreeLostParallelCopy(dest_space, forward_address, bytes_allocated, false);
       // Fail, return new forwarding address.
       forward_address = reinterpret_cast<mirror::Object*>(old_lock_word.ForwardingAddress());
     } else {
@@ -266,35 +278,7 @@ inline mirror::Object* SemiSpace::TryInstallForwardingAddress(mirror::Object* ob
 
       if (!success) {
         // Object has been copied by other thread, roll back.
-        if (!kUsePlab) {
-          if (dest_space->IsBumpPointerSpace()) {
-            this->FillWithDummyObject(forward_address, *bytes_allocated);
-            dummy_bytes_.FetchAndAddSequentiallyConsistent(*bytes_allocated);
-            dummy_objects_.FetchAndAddSequentiallyConsistent(1);
-          } else {
-            dest_space->Free(self, forward_address);
-            *bytes_allocated -= *bytes_allocated;
-          }
-        } else {
-          if (dest_space->IsBumpPointerSpace()) {
-            DCHECK_ALIGNED(*bytes_allocated, space::BumpPointerSpace::kAlignment);
-            if (UNLIKELY(obj_is_class)) {
-              // Zero memory because we already copied object.
-              memset(forward_address, 0, *bytes_allocated);
-            }
-            self->RollBackTlab(*bytes_allocated);
-          } else if (dest_space->IsRosAllocSpace()) {
-            bool freed = dest_space->AsRosAllocSpace()->FreeThreadLocal(self, *bytes_allocated, forward_address);
-            if (!freed) {
-              size_t freed_bytes = dest_space->AsRosAllocSpace()->FreeNonThread(self, forward_address);
-              DCHECK(freed_bytes == *bytes_allocated);
-            }
-          } else {
-              size_t freed_bytes = dest_space->Free(self, forward_address);
-              DCHECK(freed_bytes == *bytes_allocated);
-          }
-          *bytes_allocated -= *bytes_allocated;
-        }
+        FreeLostParallelCopy(dest_space, forward_address, bytes_allocated, obj_is_class);
 
         // Other thread has updated the lock_word, return winner's forward address.
         DCHECK(obj->GetLockWord(false).GetState() == LockWord::kForwardingAddress);
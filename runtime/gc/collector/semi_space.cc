@@ -16,6 +16,14 @@
 
 #include "semi_space.h"
 
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#endif
+
 #include <climits>
 #include <functional>
 #include <numeric>
@@ -31,7 +39,9 @@
 #include "gc/accounting/mod_union_table.h"
 #include "gc/accounting/remembered_set.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/accounting/work_stealing_deque.h"
 #include "gc/heap.h"
+#include "gc/pretenure_table.h"
 #include "gc/reference_processor.h"
 #include "gc/space/bump_pointer_space.h"
 #include "gc/space/bump_pointer_space-inl.h"
@@ -44,6 +54,7 @@
 #include "semi_space-inl.h"
 #include "mark_sweep-inl.h"
 #include "monitor.h"
+#include "os.h"
 #include "mirror/reference-inl.h"
 #include "mirror/object-inl.h"
 #include "mirror/object-refvisitor-inl.h"
@@ -64,9 +75,43 @@ static constexpr size_t kLargeObjectBytesAllocatedThreshold = 16 * MB;
 static constexpr bool kSSParallelCopy = true;//false;
 static constexpr bool kSSUseMarkStackPrefetch = true;
 static constexpr size_t kSSMinimumParallelMarkStackSize = 32;
+// The number of threads from which their roots are marked by the GC threads in parallel.
+static constexpr size_t kSSMinimumParallelRootsThreads = 16;
+// The number of threads whose roots a GC thread claims at a time.
+static constexpr size_t kSSParallelRootsThreadsBatchSize = 4;
 static constexpr bool kCountTasks = false;
 static const size_t kFifoSize = 4;
 
+// Whether the memory of the machine is split in several NUMA nodes.
+static bool HasMultipleNumaNodes() {
+  return OS::DirectoryExists("/sys/devices/system/node/node1");
+}
+
+// The NUMA node of the CPU running the calling thread, or -1 if unknown.
+static int GetCurrentNumaNode() {
+#if defined(__linux__)
+  unsigned cpu;
+  unsigned node;
+  if (syscall(__NR_getcpu, &cpu, &node, nullptr) == 0) {
+    return static_cast<int>(node);
+  }
+#endif
+  return -1;
+}
+
+// The NUMA node of the page holding an address, which must be mapped, or -1 if unknown.
+static int GetNumaNodeOfAddress(const void* addr) {
+#if defined(__linux__)
+  int node;
+  if (syscall(__NR_get_mempolicy, &node, nullptr, 0, addr, MPOL_F_NODE | MPOL_F_ADDR) == 0) {
+    return node;
+  }
+#else
+  UNUSED(addr);
+#endif
+  return -1;
+}
+
 SemiSpace::ThreadRootMarkStack::ThreadRootMarkStack(size_t capacity)
     : capacity_(capacity),
       incremental_(capacity),
@@ -176,7 +221,9 @@ SemiSpace::SemiSpace(Heap* heap, bool generational,
       thread_roots_stacks_(nullptr),
       thread_mark_stack_(nullptr),
       support_parallel_(support_parallel),
-      support_parallel_default_(support_parallel) {
+      support_parallel_default_(support_parallel),
+      has_multiple_numa_nodes_(HasMultipleNumaNodes()),
+      count_promoted_classes_(false) {
 }
 
 void SemiSpace::NeedToWakeMutators() {
@@ -211,6 +258,11 @@ void SemiSpace::RunPhases() {
     GetHeap()->PostGcVerificationPaused(this);
   } else {
     Locks::mutator_lock_->AssertNotHeld(self);
+    if (kUseRememberedSet && generational_ && collect_from_space_only_ &&
+        !IsWholeHeapCollectionRequested()) {
+      ReaderMutexLock mu(self, *Locks::mutator_lock_);
+      PreCleanCards();
+    }
     {
       ScopedPause pause(this);
       GetHeap()->PreGcVerificationPaused(this);
@@ -256,6 +308,8 @@ void SemiSpace::InitializePhase() {
     wasted_bytes_.StoreRelaxed(0);
     fallback_bytes_parallel_.StoreRelaxed(0);
     fallback_objects_parallel_.StoreRelaxed(0);
+    objects_copied_numa_local_parallel_.StoreRelaxed(0);
+    objects_copied_numa_remote_parallel_.StoreRelaxed(0);
     // Create the ThreadRootStacksMap for storing the roots
     // of specific thread.
     DCHECK(thread_roots_stacks_ == nullptr);
@@ -264,6 +318,11 @@ void SemiSpace::InitializePhase() {
   }
   work_chunks_created_.StoreRelaxed(0);
   work_chunks_deleted_.StoreRelaxed(0);
+  cards_pre_cleaned_ = false;
+  survival_histogram_.Reset();
+  for (size_t i = 0; i != kSurvivalHistogramAges; ++i) {
+    survived_bytes_by_age_parallel_[i].StoreRelaxed(0);
+  }
 
   self_ = Thread::Current();
   CHECK(from_space_->CanMoveObjects()) << "Attempting to move from " << *from_space_;
@@ -294,6 +353,56 @@ void SemiSpace::InitializePhase() {
   }
 }
 
+void SemiSpace::UpdateThresholdAge() {
+  // As the adaptive tenuring of HotSpot, promote from the youngest age whose survivors and the
+  // younger ones overflow the target part of the to-space. -XX:TenureThreshold is the maximum.
+  const size_t max_threshold_age = heap_->GetMaxThresholdAge();
+  const size_t target_bytes = to_space_->Capacity() / 100 * kTargetSurvivorPercent;
+  size_t threshold_age = max_threshold_age;
+  size_t survived_bytes = 0;
+  std::ostringstream histogram;
+  for (size_t i = 1; i != kSurvivalHistogramAges; ++i) {
+    size_t age_bytes =
+        survival_histogram_.GetBytes(i) + survived_bytes_by_age_parallel_[i].LoadRelaxed();
+    if (VLOG_IS_ON(heap) && age_bytes != 0) {
+      histogram << " " << i << ":" << PrettySize(age_bytes);
+    }
+    survived_bytes += age_bytes;
+    // The survivors of age i have the age i - 1 in the from-space, see CountSurvivor().
+    if (survived_bytes > target_bytes && i < threshold_age) {
+      threshold_age = i;
+    }
+  }
+  VLOG(heap) << "Survivors by age:" << histogram.str() << ", threshold age " << threshold_age_
+             << " -> " << threshold_age;
+  heap_->SetThresholdAge(threshold_age);
+}
+
+bool SemiSpace::IsWholeHeapCollectionRequested() {
+  // If an explicit, native allocation-triggered, or last attempt collection, collect the whole
+  // heap.
+  return GetCurrentIteration()->GetGcCause() == kGcCauseExplicit ||
+      GetCurrentIteration()->GetGcCause() == kGcCauseForNativeAlloc ||
+      GetCurrentIteration()->GetGcCause() == kGcCauseForNativeAllocBlocking ||
+      GetCurrentIteration()->GetClearSoftReferences();
+}
+
+void SemiSpace::PreCleanCards() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  // Scan the dirty cards of the old spaces before the pause, like the concurrent mark sweep does,
+  // so that the pause only scans the cards with references to the from space and the cards
+  // dirtied again since.
+  ReaderMutexLock mu(self_, *Locks::heap_bitmap_lock_);
+  for (const auto& space : heap_->GetContinuousSpaces()) {
+    accounting::RememberedSet* rem_set = heap_->FindRememberedSetFromSpace(space);
+    if (rem_set != nullptr &&
+        (space->IsRosAllocSpace() || space == heap_->GetNonMovingSpace())) {
+      rem_set->PreCleanCards(from_space_);
+    }
+  }
+  cards_pre_cleaned_ = true;
+}
+
 void SemiSpace::ProcessReferences(Thread* self) {
   WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
   GetHeap()->GetReferenceProcessor()->ProcessReferences(
@@ -323,12 +432,7 @@ void SemiSpace::MarkingPhase() {
     //  In most cases Generational Copying GC doesn't walk here.
     //  If bps is full, it will trigger STW semi-space GC.
     //  And just before OOM, it's true to clear soft references.
-    if (GetCurrentIteration()->GetGcCause() == kGcCauseExplicit ||
-        GetCurrentIteration()->GetGcCause() == kGcCauseForNativeAlloc ||
-        GetCurrentIteration()->GetGcCause() == kGcCauseForNativeAllocBlocking ||
-        GetCurrentIteration()->GetClearSoftReferences()) {
-      // If an explicit, native allocation-triggered, or last attempt
-      // collection, collect the whole heap.
+    if (IsWholeHeapCollectionRequested()) {
       collect_from_space_only_ = false;
     }
     if (!collect_from_space_only_) {
@@ -370,6 +474,8 @@ void SemiSpace::MarkingPhase() {
     bytes_wasted_promoted_parallel_.StoreRelaxed(0);
     objects_promoted_parallel_.StoreRelaxed(0);
   }
+  count_promoted_classes_ = generational_ && need_aging_table_ && swap_semi_spaces_ &&
+      GetHeap()->GetPretenureTable() != nullptr;
   // Assume the cleared space is already empty.
   BindBitmaps();
   // Process dirty cards and add dirty cards to mod-union tables.
@@ -395,6 +501,9 @@ void SemiSpace::MarkingPhase() {
   {
     ReaderMutexLock mu(self_, *Locks::heap_bitmap_lock_);
     SweepSystemWeaks();
+    if (count_promoted_classes_) {
+      RecordPromotedClasses();
+    }
   }
   Runtime::Current()->GetClassLinker()->CleanupClassLoaders();
   // Revoke buffers before measuring how many objects were moved since the TLABs need to be revoked
@@ -405,6 +514,7 @@ void SemiSpace::MarkingPhase() {
   const size_t from_bytes = from_space_->GetBytesAllocated();
   const size_t to_space_bytes = to_space_->GetBytesAllocated();
   const size_t total_bytes_promoted = bytes_promoted_ + bytes_promoted_parallel_.LoadRelaxed();
+  RecordPromoted(total_bytes_promoted);
   const size_t to_bytes = static_cast<int64_t>(to_space_bytes) + total_bytes_promoted;
 
   const size_t from_objects = from_space_->GetObjectsAllocated();
@@ -430,10 +540,12 @@ void SemiSpace::MarkingPhase() {
     }
   }
   heap_->PreSweepingGcVerification(this);
+  if (need_aging_table_ && swap_semi_spaces_ && !force_copy_all_) {
+    // The whole heap collections promote all the survivors, which says nothing of their ages.
+    UpdateThresholdAge();
+  }
   if (swap_semi_spaces_) {
-    // Clear aging table of from space.
-    if (from_space_->IsBumpPointerSpace())
-      from_space_->AsBumpPointerSpace()->GetAgingTable()->Reset();
+    // The aging table of the from space was cleared along with it.
     heap_->SwapSemiSpaces();
   }
 }
@@ -485,6 +597,15 @@ void SemiSpace::MarkReachableObjects() {
     TimingLogger::ScopedTiming t2("MarkStackAsLive", GetTimings());
     accounting::ObjectStack* live_stack = heap_->GetLiveStack();
     heap_->MarkAllocStackAsLive(live_stack);
+    if (cards_pre_cleaned_) {
+      // The objects allocated since the last collection were not scanned by PreCleanCards().
+      for (auto& space : heap_->GetContinuousSpaces()) {
+        accounting::RememberedSet* rem_set = heap_->FindRememberedSetFromSpace(space);
+        if (rem_set != nullptr) {
+          rem_set->RestorePreCleanedCards(live_stack);
+        }
+      }
+    }
     live_stack->Reset();
   }
   for (auto& space : heap_->GetContinuousSpaces()) {
@@ -586,15 +707,95 @@ void SemiSpace::ReclaimPhase() {
   if (saved_bytes_ > 0) {
     VLOG(heap) << "Avoided dirtying " << PrettySize(saved_bytes_);
   }
+  if (kSSParallelCopy && has_multiple_numa_nodes_) {
+    VLOG(heap) << "Parallel copies to the NUMA node of the GC thread: "
+               << objects_copied_numa_local_parallel_.LoadRelaxed() << " objects, to another: "
+               << objects_copied_numa_remote_parallel_.LoadRelaxed() << " objects";
+  }
 }
 
+// The objects to scan of the parallel copying, split in one work-stealing deque per GC thread.
+// A thread pushes and pops the objects of its own deque, and steals from the others once it
+// runs out of them, so that no lock is taken while copying.
+class ParallelCopyWork {
+ public:
+  typedef accounting::WorkStealingDeque<mirror::Object*> Deque;
+
+  // The capacity of a deque, the objects past it stay private to their thread.
+  static constexpr size_t kDequeCapacity = 16 * KB;
+
+  // The roots of the threads given are marked by the tasks before their objects are scanned.
+  ParallelCopyWork(size_t num_deques, std::vector<Thread*>&& roots_threads)
+      : active_tasks_(static_cast<int32_t>(num_deques)),
+        roots_threads_(std::move(roots_threads)),
+        next_roots_thread_(0) {
+    for (size_t i = 0; i != num_deques; ++i) {
+      deques_.emplace_back(new Deque(kDequeCapacity));
+    }
+  }
+
+  // Claim a batch of the threads whose roots to mark. Returns false once all are claimed.
+  bool ClaimRootsThreads(size_t* begin, size_t* end) {
+    size_t claimed = next_roots_thread_.FetchAndAddRelaxed(kSSParallelRootsThreadsBatchSize);
+    if (claimed >= roots_threads_.size()) {
+      return false;
+    }
+    *begin = claimed;
+    *end = std::min(claimed + kSSParallelRootsThreadsBatchSize, roots_threads_.size());
+    return true;
+  }
+
+  Thread* GetRootsThread(size_t index) const {
+    return roots_threads_[index];
+  }
+
+  size_t NumDeques() const {
+    return deques_.size();
+  }
+
+  Deque* GetDeque(size_t index) const {
+    return deques_[index].get();
+  }
+
+  // Steal an object from the deques of the other threads, starting past the one of the thief.
+  bool Steal(size_t thief_index, mirror::Object** obj) const {
+    for (size_t i = 1; i < deques_.size(); ++i) {
+      if (deques_[(thief_index + i) % deques_.size()]->Steal(obj)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool HasWork() const {
+    for (const std::unique_ptr<Deque>& deque : deques_) {
+      if (!deque->IsEmpty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The tasks not out of work, including the ones not started yet, which may have private
+  // objects. A task only becomes active again to steal, so that the work is done once it
+  // drops to zero while all the deques are empty. This needs a thread for every task.
+  AtomicInteger active_tasks_;
+
+ private:
+  std::vector<std::unique_ptr<Deque>> deques_;
+  const std::vector<Thread*> roots_threads_;
+  Atomic<size_t> next_roots_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelCopyWork);
+};
+
 class MarkStackCopyTask : public Task {
  public:
-  MarkStackCopyTask(ThreadPool* thread_pool, SemiSpace* semi_space, size_t mark_stack_size,
-                    StackReference<mirror::Object>* mark_stack)
+  MarkStackCopyTask(SemiSpace* semi_space, ParallelCopyWork* work, size_t index)
       : semi_space_(semi_space),
-        thread_pool_(thread_pool),
-        mark_stack_pos_(mark_stack_size),
+        work_(work),
+        index_(index),
+        deque_(work->GetDeque(index)),
         objects_copied_(0),
         bytes_copied_(0),
         objects_promoted_(0),
@@ -603,11 +804,11 @@ class MarkStackCopyTask : public Task {
         objects_fallback_(0),
         bytes_fallback_(0),
         objects_updated_(0),
-        objects_processed_(0)  {
-    if (mark_stack_size != 0) {
-      DCHECK(mark_stack != nullptr);
-      std::copy(mark_stack, mark_stack + mark_stack_size, mark_stack_);
-    }
+        objects_processed_(0),
+        objects_copied_numa_local_(0),
+        objects_copied_numa_remote_(0),
+        numa_plab_start_(nullptr),
+        numa_plab_is_local_(false)  {
     if (kCountTasks) {
       ++semi_space_->work_chunks_created_;
     }
@@ -618,12 +819,42 @@ class MarkStackCopyTask : public Task {
     bytes_copied_ += bytes;
   }
 
+  // Count an object copied to the PLAB of the thread, to memory of its NUMA node or not.
+  // The pages of a PLAB are first touched by the thread copying to them, so that they are
+  // on its node unless the node is full. The node of a PLAB is checked at its first object.
+  ALWAYS_INLINE void CountObjectCopiedNumaNode(Thread* self, mirror::Object* forward_address) {
+    uint8_t* plab_start = self->GetTlabStart();
+    uint8_t* address = reinterpret_cast<uint8_t*>(forward_address);
+    if (plab_start == nullptr || address < plab_start || address >= self->GetTlabPos()) {
+      return;
+    }
+    if (UNLIKELY(plab_start != numa_plab_start_)) {
+      numa_plab_start_ = plab_start;
+      int node = GetNumaNodeOfAddress(address);
+      numa_plab_is_local_ = (node != -1 && node == GetCurrentNumaNode());
+    }
+    if (numa_plab_is_local_) {
+      ++objects_copied_numa_local_;
+    } else {
+      ++objects_copied_numa_remote_;
+    }
+  }
+
+  ALWAYS_INLINE void CountSurvivor(uint8_t old_age, size_t bytes) {
+    survival_histogram_.CountSurvivor(old_age, bytes);
+  }
+
   ALWAYS_INLINE void CountObjectsPromoted(size_t count, size_t bytes, size_t wasted) {
     objects_promoted_ += count;
     bytes_promoted_ += bytes;
     bytes_wasted_promoted_ += wasted;
   }
 
+  // Count the bytes of an instance of klass promoted because of its age, in the map of the task.
+  ALWAYS_INLINE void CountClassPromoted(mirror::Class* klass, size_t bytes) {
+    semi_space_->bytes_promoted_by_class_parallel_[index_][klass] += bytes;
+  }
+
   ALWAYS_INLINE void CountObjectsFallback(size_t count, size_t bytes) {
     objects_fallback_ += count;
     bytes_fallback_ += bytes;
@@ -637,39 +868,35 @@ class MarkStackCopyTask : public Task {
     objects_processed_ += count;
   }
 
-  ALWAYS_INLINE void MarkStackPush(Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) NO_THREAD_SAFETY_ANALYSIS {
-    if (UNLIKELY(mark_stack_pos_ == kMaxSize)) {
-      // Mark stack overflow, give 1/2 the stack to the thread pool as a new work task.
-      mark_stack_pos_ /= 2;
-      size_t size = kMaxSize - mark_stack_pos_;
-      auto* task = new MarkStackCopyTask(thread_pool_, semi_space_, size,
-                                     mark_stack_ + mark_stack_pos_);
-      // TODO: This is workaround that kClassLoaderClassesLock is used when class_table visit roots.
-      // The thread pool AddTask fail at checking lock level because kClassLoaderClassesLock is held
-      // However, if enlarge kClassLoaderClassesLock's level there is deadlock between reference
-      // processor and class table.
-      // To fix the root cause may require the redesign of lock levels for thread pool, reference
-      // processor and class table.
-      Thread* self = Thread::Current();
-      BaseMutex* bmu = self->GetHeldMutex(kClassLoaderClassesLock);
-      ReaderWriterMutex* rmu = down_cast<ReaderWriterMutex*>(bmu);
-      if (UNLIKELY(rmu != nullptr)) {
-        rmu->AssertSharedHeld(self);
-        rmu->SharedUnlock(self);
-      }
-      thread_pool_->AddTask(Thread::Current(), task);
-      if (UNLIKELY(rmu != nullptr)) {
-        rmu->SharedLock(self);
-      }
-    }
+  // Only called by the thread running the task, or before the workers are started.
+  ALWAYS_INLINE void MarkStackPush(Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
     DCHECK(obj != nullptr);
-    DCHECK_LT(mark_stack_pos_, kMaxSize);
-    mark_stack_[mark_stack_pos_++].Assign(obj);
+    if (UNLIKELY(!deque_->Push(obj))) {
+      // The deque is full, keep the object until there is room again.
+      overflow_stack_.push_back(obj);
+    }
   }
 
+  // The initial capacity of the mark stacks of the thread roots.
   static const size_t kMaxSize = 4*KB;
 
+  // The object arrays longer than this are scanned this many elements at a time, so that the
+  // other GC threads can steal the rest of a large array instead of waiting for its scan.
+  static constexpr int32_t kArrayRangeLength = 1 * KB;
+
  protected:
+  // The elements of an object array left to scan, pushed tagged in place of an object.
+  struct ArrayRange {
+    mirror::ObjectArray<mirror::Object>* array;
+    int32_t begin;
+    int32_t end;
+  };
+  static constexpr uintptr_t kArrayRangeTag = 1u;
+
+  static bool IsArrayRange(mirror::Object* obj) {
+    return (reinterpret_cast<uintptr_t>(obj) & kArrayRangeTag) != 0u;
+  }
+
   class SSMarkObjectParallelVisitor {
    public:
     SSMarkObjectParallelVisitor(MarkStackCopyTask* chunk_task,
@@ -723,17 +950,107 @@ class MarkStackCopyTask : public Task {
     MarkStackCopyTask* const chunk_task_;
   };
 
+  class SSThreadRootParallelVisitor : public RootVisitor {
+   public:
+    explicit SSThreadRootParallelVisitor(MarkStackCopyTask* chunk_task)
+        : chunk_task_(chunk_task) {}
+
+    // TODO: Remove NO_THREAD_SAFETY_ANALYSIS when clang better understands visitors.
+    void VisitRoots(mirror::Object*** roots, size_t count, const RootInfo& info ATTRIBUTE_UNUSED)
+        OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+      for (size_t i = 0; i < count; ++i) {
+        auto* root = roots[i];
+        auto ref = StackReference<mirror::Object>::FromMirrorPtr(*root);
+        // The root can be in the to-space since we may visit the declaring class of an
+        // ArtMethod multiple times, from the call stacks of several threads.
+        chunk_task_->semi_space_->MarkObjectIfNotInToSpaceParallel(&ref, chunk_task_);
+        if (*root != ref.AsMirrorPtr()) {
+          *root = ref.AsMirrorPtr();
+        }
+      }
+    }
+
+    void VisitRoots(mirror::CompressedReference<mirror::Object>** roots,
+                    size_t count,
+                    const RootInfo& info ATTRIBUTE_UNUSED)
+        OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+      for (size_t i = 0; i < count; ++i) {
+        chunk_task_->semi_space_->MarkObjectIfNotInToSpaceParallel(roots[i], chunk_task_);
+      }
+    }
+
+   private:
+    MarkStackCopyTask* const chunk_task_;
+  };
+
+  // Scan the next elements of a range, after pushing the rest of the range for a thief.
+  void ScanArrayRange(mirror::Object* tagged_range)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(Locks::heap_bitmap_lock_) {
+    ArrayRange* range =
+        reinterpret_cast<ArrayRange*>(reinterpret_cast<uintptr_t>(tagged_range) & ~kArrayRangeTag);
+    mirror::ObjectArray<mirror::Object>* const array = range->array;
+    const int32_t begin = range->begin;
+    const int32_t end = std::min(range->end, begin + kArrayRangeLength);
+    if (end != range->end) {
+      range->begin = end;
+      MarkStackPush(tagged_range);
+    } else {
+      delete range;
+    }
+    SSMarkObjectParallelVisitor mark_visitor(this, semi_space_);
+    for (int32_t i = begin; i != end; ++i) {
+      mark_visitor(array, mirror::ObjectArray<mirror::Object>::OffsetOfElement(i), false);
+    }
+  }
+
+  // Scan an object, a large object array one range of elements at a time.
+  void ScanObject(mirror::Object* obj, const SSScanObjectParallelVisitor& visitor)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(Locks::heap_bitmap_lock_) {
+    if (obj->IsObjectArray<kVerifyNone, kWithoutReadBarrier>()) {
+      mirror::ObjectArray<mirror::Object>* array =
+          obj->AsObjectArray<mirror::Object, kVerifyNone, kWithoutReadBarrier>();
+      const int32_t length = array->GetLength<kVerifyNone>();
+      if (length > kArrayRangeLength) {
+        SSMarkObjectParallelVisitor mark_visitor(this, semi_space_);
+        mark_visitor(array, mirror::Object::ClassOffset(), false);
+        ArrayRange* range = new ArrayRange{array, 0, length};
+        ScanArrayRange(
+            reinterpret_cast<mirror::Object*>(reinterpret_cast<uintptr_t>(range) | kArrayRangeTag));
+        return;
+      }
+    }
+    visitor(obj);
+  }
+
+  // Mark the roots of the threads left to the GC threads, a batch of threads at a time.
+  // The objects of a thread go to the deque of the task marking its roots.
+  void MarkThreadRoots() REQUIRES_SHARED(Locks::mutator_lock_) {
+    SSThreadRootParallelVisitor visitor(this);
+    size_t begin;
+    size_t end;
+    while (work_->ClaimRootsThreads(&begin, &end)) {
+      for (size_t i = begin; i != end; ++i) {
+        work_->GetRootsThread(i)->VisitRoots(&visitor, kVisitRootFlagAllRoots);
+      }
+    }
+  }
+
   virtual ~MarkStackCopyTask() {
-    DCHECK_EQ(mark_stack_pos_, 0u);
+    DCHECK(deque_->IsEmpty());
+    DCHECK(overflow_stack_.empty());
     if (kCountTasks) {
       ++semi_space_->work_chunks_deleted_;
     }
   }
 
   SemiSpace* semi_space_;
-  ThreadPool* const thread_pool_;
-  StackReference<mirror::Object> mark_stack_[kMaxSize];
-  size_t mark_stack_pos_;
+  ParallelCopyWork* const work_;
+  const size_t index_;
+  ParallelCopyWork::Deque* const deque_;
+  // The objects pushed while the deque was full, not visible to the other threads.
+  std::vector<mirror::Object*> overflow_stack_;
   size_t objects_copied_;
   size_t bytes_copied_;
   size_t objects_promoted_;
@@ -743,6 +1060,12 @@ class MarkStackCopyTask : public Task {
   size_t bytes_fallback_;
   size_t objects_updated_;
   size_t objects_processed_;
+  size_t objects_copied_numa_local_;
+  size_t objects_copied_numa_remote_;
+  SemiSpace::SurvivalHistogram survival_histogram_;
+  // The last PLAB whose NUMA node was checked.
+  uint8_t* numa_plab_start_;
+  bool numa_plab_is_local_;
 
   virtual void Finalize()
       REQUIRES_SHARED(Locks::mutator_lock_) {
@@ -758,6 +1081,14 @@ class MarkStackCopyTask : public Task {
     semi_space_->objects_promoted_parallel_.FetchAndAddSequentiallyConsistent(objects_promoted_);
     semi_space_->fallback_bytes_parallel_.FetchAndAddSequentiallyConsistent(bytes_fallback_);
     semi_space_->fallback_objects_parallel_.FetchAndAddSequentiallyConsistent(objects_fallback_);
+    semi_space_->objects_copied_numa_local_parallel_
+                  .FetchAndAddSequentiallyConsistent(objects_copied_numa_local_);
+    semi_space_->objects_copied_numa_remote_parallel_
+                  .FetchAndAddSequentiallyConsistent(objects_copied_numa_remote_);
+    for (size_t i = 0; i != SemiSpace::kSurvivalHistogramAges; ++i) {
+      semi_space_->survived_bytes_by_age_parallel_[i]
+                    .FetchAndAddSequentiallyConsistent(survival_histogram_.GetBytes(i));
+    }
     VLOG(heap) << "Parallel Copying Thread Info: Thread:" << self
                << " objects copied: " << objects_copied_
                << " objects updated: " << objects_updated_;
@@ -773,6 +1104,44 @@ class MarkStackCopyTask : public Task {
     delete this;
   }
 
+  // Pop an object of the task.
+  ALWAYS_INLINE bool PopLocal(mirror::Object** obj) {
+    if (LIKELY(deque_->Pop(obj))) {
+      return true;
+    }
+    if (overflow_stack_.empty()) {
+      return false;
+    }
+    // Move the overflowed objects back to the deque, where they can be stolen.
+    while (!overflow_stack_.empty() && deque_->Push(overflow_stack_.back())) {
+      overflow_stack_.pop_back();
+    }
+    return deque_->Pop(obj);
+  }
+
+  // Called when the task is out of objects. Returns false once all the tasks are.
+  bool StealOrFinish(mirror::Object** obj) {
+    if (work_->Steal(index_, obj)) {
+      return true;
+    }
+    work_->active_tasks_.FetchAndSubSequentiallyConsistent(1);
+    for (;;) {
+      // Check the deques before the active tasks: a thief becomes active before taking the
+      // last object of a deque, and stays active until it pushed the objects it references.
+      if (work_->HasWork()) {
+        work_->active_tasks_.FetchAndAddSequentiallyConsistent(1);
+        if (work_->Steal(index_, obj)) {
+          return true;
+        }
+        work_->active_tasks_.FetchAndSubSequentiallyConsistent(1);
+      } else if (work_->active_tasks_.LoadSequentiallyConsistent() == 0) {
+        return false;
+      } else {
+        sched_yield();
+      }
+    }
+  }
+
   virtual void Run(Thread* self)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(Locks::heap_bitmap_lock_) {
@@ -792,36 +1161,44 @@ class MarkStackCopyTask : public Task {
     } else if (to_space->IsRosAllocSpace()) {
       to_space->AsRosAllocSpace()->AssertThreadLocalBuffersAreRevoked(self);
     }
+    MarkThreadRoots();
     for (;;) {
       mirror::Object* obj = nullptr;
       if (kSSUseMarkStackPrefetch) {
         // Use prefetch as CMS for speed up the access of mark stack.
-        while (mark_stack_pos_ != 0 && prefetch_fifo.size() < kFifoSize) {
-          mirror::Object* const mark_stack_obj = mark_stack_[--mark_stack_pos_].AsMirrorPtr();
+        mirror::Object* mark_stack_obj;
+        while (prefetch_fifo.size() < kFifoSize && PopLocal(&mark_stack_obj)) {
           DCHECK(mark_stack_obj != nullptr);
           __builtin_prefetch(mark_stack_obj);
           prefetch_fifo.push_back(mark_stack_obj);
         }
         if (UNLIKELY(prefetch_fifo.empty())) {
-          break;
+          if (!StealOrFinish(&obj)) {
+            break;
+          }
+        } else {
+          obj = prefetch_fifo.front();
+          prefetch_fifo.pop_front();
         }
-        obj = prefetch_fifo.front();
-        prefetch_fifo.pop_front();
       } else {
-        if (UNLIKELY(mark_stack_pos_ == 0)) {
+        if (UNLIKELY(!PopLocal(&obj)) && !StealOrFinish(&obj)) {
           break;
         }
-        obj =  mark_stack_[--mark_stack_pos_].AsMirrorPtr();
       }
       DCHECK(obj != nullptr);
+      if (IsArrayRange(obj)) {
+        ScanArrayRange(obj);
+        continue;
+      }
       if (collect_from_space_only && promo_dest_space->HasAddress(obj)) {
         // Object just promoted, Mark the live bitmap for it.
         // Which is delayed from MarkObject().
         CHECK(!live_bitmap->AtomicTestAndSet(obj)) << obj;
       }
-      visitor(obj);
+      ScanObject(obj, visitor);
     }
-    DCHECK_EQ(mark_stack_pos_, 0u) << "mark stack size not zero: " << mark_stack_pos_;
+    DCHECK(deque_->IsEmpty());
+    DCHECK(overflow_stack_.empty());
   }
 };
 
@@ -868,12 +1245,19 @@ mirror::Object* SemiSpace::MarkNonForwardedObject(mirror::Object* obj) {
                                                      &dummy);
       if (to_age_table_ != nullptr) {
         to_age_table_->IncreaseObjectAge(forward_address, age);
+        if (forward_address != nullptr) {
+          survival_histogram_.CountSurvivor(age, bytes_allocated);
+        }
       }
       // No logic for marking the bitmap, so it must be null.
       DCHECK(to_space_live_bitmap_ == nullptr);
     } else {
       bytes_promoted_ += bytes_allocated;
       bytes_wasted_ += bytes_allocated - object_size;
+      if (count_promoted_classes_ && age >= threshold_age_) {
+        bytes_promoted_by_class_[obj->GetClass<kVerifyNone, kWithoutReadBarrier>()] +=
+            bytes_allocated;
+      }
       // Dirty the card at the destionation as it may contain
       // references (including the class pointer) to the bump pointer
       // space.
@@ -918,6 +1302,9 @@ mirror::Object* SemiSpace::MarkNonForwardedObject(mirror::Object* obj) {
                                                    &dummy);
     if (to_age_table_ != nullptr && need_aging_table_ && swap_semi_spaces_) {
       to_age_table_->IncreaseObjectAge(forward_address, age);
+      if (forward_address != nullptr) {
+        survival_histogram_.CountSurvivor(age, bytes_allocated);
+      }
     }
     if (forward_address != nullptr && to_space_live_bitmap_ != nullptr) {
       to_space_live_bitmap_->Set(forward_address);
@@ -989,11 +1376,22 @@ void SemiSpace::MarkRoots() {
   // This help to make most of objects scanned in one gc thread
   // in later parallel copying.
   if (kSSParallelCopy) {
-    marking_roots_ = true;
-    DCHECK(thread_roots_stacks_ != nullptr);
-    // Thread_roots_stacks_ is used for MarkThreadRoots.
-    MarkThreadRoots();
-    marking_roots_ = false;
+    DCHECK(parallel_roots_threads_.empty());
+    if (support_parallel_ && GetThreadCount() > 1) {
+      MutexLock mu(self_, *Locks::thread_list_lock_);
+      std::list<Thread*> thread_list = Runtime::Current()->GetThreadList()->GetList();
+      if (thread_list.size() >= kSSMinimumParallelRootsThreads) {
+        // Leave the thread roots to the GC threads, see ProcessMarkStackParallel().
+        parallel_roots_threads_.assign(thread_list.begin(), thread_list.end());
+      }
+    }
+    if (parallel_roots_threads_.empty()) {
+      marking_roots_ = true;
+      DCHECK(thread_roots_stacks_ != nullptr);
+      // Thread_roots_stacks_ is used for MarkThreadRoots.
+      MarkThreadRoots();
+      marking_roots_ = false;
+    }
     // mark_stack_ is used for later mark.
     MarkNonThreadRoots();
     MarkConcurrentRoots();
@@ -1052,6 +1450,26 @@ void SemiSpace::MarkConcurrentRoots() {
   Runtime::Current()->VisitConcurrentRoots(this);
 }
 
+void SemiSpace::RecordPromotedClasses() {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  PretenureTable* table = GetHeap()->GetPretenureTable();
+  auto record = [this, table](std::unordered_map<mirror::Class*, size_t>* bytes_by_class)
+      REQUIRES(Locks::mutator_lock_) REQUIRES_SHARED(Locks::heap_bitmap_lock_) {
+    for (const auto& entry : *bytes_by_class) {
+      // The classes may have moved, or died with their promoted instances.
+      mirror::Object* klass = IsMarked(entry.first);
+      if (klass != nullptr) {
+        table->RecordPromotion(klass->AsClass<kVerifyNone, kWithoutReadBarrier>(), entry.second);
+      }
+    }
+    bytes_by_class->clear();
+  };
+  record(&bytes_promoted_by_class_);
+  for (auto& bytes_by_class : bytes_promoted_by_class_parallel_) {
+    record(&bytes_by_class);
+  }
+}
+
 void SemiSpace::SweepSystemWeaks() {
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   Runtime::Current()->SweepSystemWeaks(this);
@@ -1191,12 +1609,17 @@ mirror::Object* SemiSpace::MarkNonForwardedObjectParallel(mirror::Object* obj,
       if (*win == true && forward_address != nullptr) {
         if (to_age_table_ != nullptr) {
           to_age_table_->IncreaseObjectAge(forward_address, age);
+          chunk_task->CountSurvivor(age, bytes_allocated);
         }
       }
     } else {
       if (*win == true) {
         // The lock word was updated by current thread.
         chunk_task->CountObjectsPromoted(1, bytes_allocated, bytes_allocated - obj->SizeOf());
+        if (count_promoted_classes_ && age >= threshold_age_) {
+          chunk_task->CountClassPromoted(obj->GetClass<kVerifyNone, kWithoutReadBarrier>(),
+                                         bytes_allocated);
+        }
         // Dirty the card at the destionation as it may contain
         // references (including the class pointer) to the bump pointer
         // space.
@@ -1244,6 +1667,7 @@ mirror::Object* SemiSpace::MarkNonForwardedObjectParallel(mirror::Object* obj,
     if (*win == true) {
       if (to_age_table_ != nullptr) {
         to_age_table_->IncreaseObjectAge(forward_address, age);
+        chunk_task->CountSurvivor(age, bytes_allocated);
       }
     }
   }
@@ -1295,6 +1719,9 @@ mirror::Object* SemiSpace::MarkNonForwardedObjectParallel(mirror::Object* obj,
   }
   if (*win) {
     chunk_task->CountObjectsCopied(1, bytes_allocated);
+    if (has_multiple_numa_nodes_) {
+      chunk_task->CountObjectCopiedNumaNode(Thread::Current(), forward_address);
+    }
     if (kUseBakerOrBrooksReadBarrier) {
       obj->AssertReadBarrierPointer();
       if (kUseBrooksReadBarrier) {
@@ -1358,45 +1785,46 @@ void SemiSpace::ProcessMarkStackParallel(size_t thread_count) {
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   Thread* self = Thread::Current();
   ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+  // One task per GC thread, each owning a deque its thread pushes to and the others steal from.
+  // The tasks start by marking the roots of the threads MarkRoots() left to them.
+  ParallelCopyWork work(thread_count, std::move(parallel_roots_threads_));
+  parallel_roots_threads_.clear();
+  if (count_promoted_classes_ && bytes_promoted_by_class_parallel_.size() < thread_count) {
+    // The maps are kept across the calls of a GC, until RecordPromotedClasses().
+    bytes_promoted_by_class_parallel_.resize(thread_count);
+  }
+  std::vector<MarkStackCopyTask*> tasks;
+  for (size_t i = 0; i != thread_count; ++i) {
+    tasks.push_back(new MarkStackCopyTask(this, &work, i));
+  }
+  size_t next_task = 0;
   // Make thread roots processed within one thread first.
   // Experiment shows it helps improve the performance of parallel copy.
-  if (thread_roots_stacks_->size() > 0) {
-    for (auto it = thread_roots_stacks_->begin(); it != thread_roots_stacks_->end();) {
-      DCHECK(it->first != nullptr && it->second != nullptr);
-      // Get the ThreadRootMarkStack for every thread.
-      ThreadRootMarkStack* rms = it->second;
-      size_t stack_size = rms->Size();
-      if (stack_size <= 0) {
-        // No thread root objects, skip.
-        delete rms;
-        thread_roots_stacks_->erase(it++);
-        continue;
-      }
+  for (auto it = thread_roots_stacks_->begin(); it != thread_roots_stacks_->end();) {
+    DCHECK(it->first != nullptr && it->second != nullptr);
+    // Get the ThreadRootMarkStack for every thread.
+    ThreadRootMarkStack* rms = it->second;
+    size_t stack_size = rms->Size();
+    if (stack_size > 0) {
       StackReference<mirror::Object>* mark_stack = rms->GetMarkStack();
       DCHECK(mark_stack != nullptr);
-      for (size_t idx = 0; idx < stack_size;) {
-        size_t chunk_size = std::min(stack_size - idx,
-                                     static_cast<size_t>(MarkStackCopyTask::kMaxSize));
-        CHECK_GT(chunk_size, 0U);
-        auto* task = new MarkStackCopyTask(thread_pool, this, chunk_size, mark_stack + idx);
-        thread_pool->AddTask(Thread::Current(), task);
-        idx += chunk_size;
+      MarkStackCopyTask* task = tasks[next_task];
+      next_task = (next_task + 1) % thread_count;
+      for (size_t idx = 0; idx < stack_size; ++idx) {
+        task->MarkStackPush(mark_stack[idx].AsMirrorPtr());
       }
-      // All objects on root mark stack have been copied to MarkStackCopyTask, reclaim the memory.
-      delete rms;
-      thread_roots_stacks_->erase(it++);
-    }
-  }
-  size_t task_size = (mark_stack_->Size()) / (thread_count) + 1;
-  size_t chunk_size = std::min(task_size,
-                             static_cast<size_t>(MarkStackCopyTask::kMaxSize));
-  CHECK_GT(chunk_size, 0U);
-  // Remains of stack.
-  for (auto* it = mark_stack_->Begin(), *end = mark_stack_->End(); it < end;) {
-    const size_t delta = std::min(static_cast<size_t>(end - it), chunk_size);
-    thread_pool->AddTask(self,
-                         new MarkStackCopyTask(thread_pool, this, delta, it));
-    it+= delta;
+    }
+    // All objects on root mark stack have been pushed to a task, reclaim the memory.
+    delete rms;
+    thread_roots_stacks_->erase(it++);
+  }
+  // Deal the remains of the stack to the tasks.
+  for (auto* it = mark_stack_->Begin(), *end = mark_stack_->End(); it < end; ++it) {
+    tasks[next_task]->MarkStackPush(it->AsMirrorPtr());
+    next_task = (next_task + 1) % thread_count;
+  }
+  for (MarkStackCopyTask* task : tasks) {
+    thread_pool->AddTask(self, task);
   }
   thread_pool->SetMaxActiveWorkers(thread_count - 1);
   thread_pool->StartWorkers(self);
@@ -1424,8 +1852,9 @@ void SemiSpace::ProcessMarkStack() {
     DCHECK_EQ(live_bitmap, mark_bitmap);
   }
 
-  if (support_parallel_ && kSSParallelCopy && thread_count > 1 &&
-    mark_stack_->Size() >= kSSMinimumParallelMarkStackSize) {
+  if (!parallel_roots_threads_.empty() ||
+      (support_parallel_ && kSSParallelCopy && thread_count > 1 &&
+       mark_stack_->Size() >= kSSMinimumParallelMarkStackSize)) {
     ProcessMarkStackParallel(thread_count);
   } else {
     BoundedFifoPowerOfTwo<mirror::Object*, kFifoSize> prefetch_fifo;
@@ -17,7 +17,10 @@
 #ifndef ART_RUNTIME_GC_COLLECTOR_SEMI_SPACE_H_
 #define ART_RUNTIME_GC_COLLECTOR_SEMI_SPACE_H_
 
+#include <algorithm>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "atomic.h"
 #include "base/macros.h"
@@ -92,6 +95,11 @@ class SemiSpace : public GarbageCollector {
   // Set the space where we copy objects from.
   void SetFromSpace(space::ContinuousMemMapAllocSpace* from_space);
 
+  // The bytes copied by the last collection, to the to-space or promoted.
+  uint64_t GetBytesMoved() const {
+    return bytes_moved_ + bytes_moved_parallel_.LoadRelaxed();
+  }
+
   // Get from space.
   space::ContinuousMemMapAllocSpace* GetFromSpace();
   // Get to space.
@@ -152,6 +160,12 @@ class SemiSpace : public GarbageCollector {
   void UnBindBitmaps()
       REQUIRES(Locks::heap_bitmap_lock_);
 
+  // Whether the cause of the collection requires to collect the whole heap.
+  bool IsWholeHeapCollectionRequested();
+
+  // Scan the dirty cards of the remembered sets concurrently with the mutators, before the pause.
+  void PreCleanCards() REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!Locks::heap_bitmap_lock_);
+
   void ProcessReferences(Thread* self) REQUIRES(Locks::mutator_lock_)
       REQUIRES(Locks::mutator_lock_);
 
@@ -166,6 +180,11 @@ class SemiSpace : public GarbageCollector {
   void SweepSystemWeaks()
       REQUIRES_SHARED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
 
+  // Hand the bytes promoted because of their age, by class, to the pretenure table of the heap.
+  void RecordPromotedClasses()
+      REQUIRES(Locks::mutator_lock_)
+      REQUIRES_SHARED(Locks::heap_bitmap_lock_);
+
   virtual void VisitRoots(mirror::Object*** roots, size_t count, const RootInfo& info) OVERRIDE
       REQUIRES(Locks::mutator_lock_, Locks::heap_bitmap_lock_);
 
@@ -251,6 +270,39 @@ class SemiSpace : public GarbageCollector {
   // Get thread count for parallel copy.
   size_t GetThreadCount() const;
 
+  // The ages told apart by the survival histogram, the older ones are counted with the last.
+  static constexpr size_t kSurvivalHistogramAges = 16;
+  // The part of the to-space the survivors not promoted should fit in.
+  static constexpr size_t kTargetSurvivorPercent = 50;
+
+  // The bytes surviving at each age, counted by the serial copy or by a parallel copy task.
+  class SurvivalHistogram {
+   public:
+    SurvivalHistogram() {
+      Reset();
+    }
+
+    void Reset() {
+      std::fill_n(bytes_by_age_, kSurvivalHistogramAges, 0u);
+    }
+
+    // Count the bytes of an object of an age copied to the to-space, which made it one GC older.
+    void CountSurvivor(uint8_t old_age, size_t bytes) {
+      bytes_by_age_[std::min(static_cast<size_t>(old_age) + 1, kSurvivalHistogramAges - 1)] +=
+          bytes;
+    }
+
+    size_t GetBytes(size_t age) const {
+      return bytes_by_age_[age];
+    }
+
+   private:
+    size_t bytes_by_age_[kSurvivalHistogramAges];
+  };
+
+  // Set the threshold age of the next collections from the survival histogram.
+  void UpdateThresholdAge() REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Used to fill a memory block when updating the forwarding pointer fails.
   ALWAYS_INLINE void FillWithDummyObject(mirror::Object* dummy_obj, size_t byte_size)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -260,6 +312,23 @@ class SemiSpace : public GarbageCollector {
                                                          void* task)
       REQUIRES_SHARED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
 
+  // Allocate the copy of an object for the parallel copying. The RosAlloc spaces allocate from
+  // the runs of the calling GC thread, which are size classed buffers, and the bump pointer
+  // spaces from its PLAB when kUsePlab.
+  mirror::Object* AllocForParallelCopy(space::ContinuousMemMapAllocSpace* dest_space,
+                                       size_t object_size,
+                                       size_t* bytes_allocated) ALWAYS_INLINE
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Give back the copy of an object that another GC thread installed its copy of first, so
+  // that the next copy of the calling thread may reuse it. The copy is only filled with a
+  // dummy object when it cannot be given back. `copied` tells if the object was copied to it.
+  void FreeLostParallelCopy(space::ContinuousMemMapAllocSpace* dest_space,
+                            mirror::Object* forward_address,
+                            size_t* bytes_allocated,
+                            bool copied) ALWAYS_INLINE
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   mirror::Object* TryInstallForwardingAddress(mirror::Object* obj,
                                               space::ContinuousMemMapAllocSpace* dest_space,
                                               size_t* bytes_allocated,
@@ -331,6 +400,8 @@ class SemiSpace : public GarbageCollector {
   // Used for generational mode. When true, we only collect the from_space_.
   bool collect_from_space_only_;
   bool force_copy_all_ = false;
+  // Whether PreCleanCards() ran before the pause of this collection.
+  bool cards_pre_cleaned_ = false;
 
   // The space which we are promoting into, only used for GSS.
   space::ContinuousMemMapAllocSpace* promo_dest_space_;
@@ -374,10 +445,15 @@ class SemiSpace : public GarbageCollector {
   Atomic<size_t> fallback_bytes_parallel_;
   Atomic<size_t> fallback_objects_parallel_;
   Atomic<size_t> wasted_bytes_;
+  // The objects copied in parallel to PLABs on the NUMA node of the GC thread, or on another.
+  Atomic<size_t> objects_copied_numa_local_parallel_;
+  Atomic<size_t> objects_copied_numa_remote_parallel_;
 
   // Map stores the pair of thread and stack of the thread's roots.
   ThreadRootStacksMap* thread_roots_stacks_;
   ThreadRootMarkStack* thread_mark_stack_;
+  // The threads whose roots are left to the GC threads of the parallel copying to mark.
+  std::vector<Thread*> parallel_roots_threads_;
   // Support parallel copy or not.
   // Used for ZygoteCompact because we don't want gaps in zygote space.
   bool support_parallel_;
@@ -387,6 +463,18 @@ class SemiSpace : public GarbageCollector {
   size_t threshold_age_;
   //Support parallel copy or not.
   bool support_parallel_default_;
+  // Whether to count the parallel copies to the NUMA node of the GC thread.
+  bool has_multiple_numa_nodes_;
+
+  // The bytes surviving at each age, copied serially and in parallel.
+  SurvivalHistogram survival_histogram_;
+  Atomic<size_t> survived_bytes_by_age_parallel_[kSurvivalHistogramAges];
+
+  // Whether the bytes promoted because of their age are counted by class, for the pretenure table.
+  bool count_promoted_classes_;
+  // The bytes promoted because of their age by class, serially and by each parallel copy task.
+  std::unordered_map<mirror::Class*, size_t> bytes_promoted_by_class_;
+  std::vector<std::unordered_map<mirror::Class*, size_t>> bytes_promoted_by_class_parallel_;
 private:
   class BitmapSetSlowPathVisitor;
   class MarkObjectVisitor;
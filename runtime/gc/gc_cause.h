@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_GC_GC_CAUSE_H_
 #define ART_RUNTIME_GC_GC_CAUSE_H_
 
+#include <stddef.h>
+
 #include <iosfwd>
 
 namespace art {
@@ -66,6 +68,8 @@ enum GcCause {
   // GC cause for the profile saver.
   kGcCauseProfileSaver,
 };
+// The number of causes, for the tables indexed by cause. Keep kGcCauseProfileSaver last.
+static constexpr size_t kGcCauseCount = static_cast<size_t>(kGcCauseProfileSaver) + 1;
 
 const char* PrettyCause(GcCause cause);
 std::ostream& operator<<(std::ostream& os, const GcCause& gc_cause);
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gc_metrics.h"
+
+#include <algorithm>
+#include <ostream>
+
+#include "base/bit_utils.h"
+
+namespace art {
+namespace gc {
+
+GcDurationHistogram::GcDurationHistogram() : count_(0), sum_us_(0), max_us_(0) {
+  for (Atomic<uint64_t>& bucket : buckets_) {
+    bucket.StoreRelaxed(0);
+  }
+}
+
+void GcDurationHistogram::AddValueNs(uint64_t duration_ns) {
+  // There is only one writer, the GC, the values need no read-modify-write atomics.
+  const uint64_t duration_us = duration_ns / 1000u;
+  const size_t bucket = std::min<size_t>(
+      duration_us == 0u ? 0u : MinimumBitsToStore(duration_us), kNumBuckets - 1);
+  buckets_[bucket].StoreRelaxed(buckets_[bucket].LoadRelaxed() + 1u);
+  sum_us_.StoreRelaxed(sum_us_.LoadRelaxed() + duration_us);
+  max_us_.StoreRelaxed(std::max(max_us_.LoadRelaxed(), duration_us));
+  // Published last, a reader seeing the count sees the value in the sum.
+  count_.StoreRelease(count_.LoadRelaxed() + 1u);
+}
+
+void GcDurationHistogram::Dump(const std::string& prefix, std::ostream& os) const {
+  os << prefix << ".count " << count_.LoadAcquire() << "\n";
+  os << prefix << ".sum_us " << sum_us_.LoadRelaxed() << "\n";
+  os << prefix << ".max_us " << max_us_.LoadRelaxed() << "\n";
+  uint64_t cumulative = 0u;
+  for (size_t i = 0; i != kNumBuckets; ++i) {
+    const uint64_t count = buckets_[i].LoadRelaxed();
+    if (count == 0u) {
+      continue;
+    }
+    cumulative += count;
+    if (i == kNumBuckets - 1) {
+      os << prefix << ".le_inf " << cumulative << "\n";
+    } else {
+      os << prefix << ".le_" << (UINT64_C(1) << i) << "us " << cumulative << "\n";
+    }
+  }
+}
+
+void GcMetrics::RecordGc(GcCause cause,
+                         uint64_t duration_ns,
+                         const std::vector<uint64_t>& pause_times_ns,
+                         int64_t freed_bytes,
+                         uint64_t promoted_bytes) {
+  CauseMetrics& metrics = causes_[static_cast<size_t>(cause)];
+  for (uint64_t pause_ns : pause_times_ns) {
+    metrics.pauses.AddValueNs(pause_ns);
+  }
+  metrics.freed_bytes.StoreRelaxed(metrics.freed_bytes.LoadRelaxed() + freed_bytes);
+  metrics.promoted_bytes.StoreRelaxed(metrics.promoted_bytes.LoadRelaxed() + promoted_bytes);
+  metrics.durations.AddValueNs(duration_ns);
+}
+
+void GcMetrics::Dump(const std::string& prefix, std::ostream& os) const {
+  for (size_t i = 0; i != kGcCauseCount; ++i) {
+    const CauseMetrics& metrics = causes_[i];
+    if (metrics.durations.GetCount() == 0u) {
+      continue;
+    }
+    const std::string cause_prefix = prefix + "." + PrettyCause(static_cast<GcCause>(i));
+    metrics.durations.Dump(cause_prefix + ".duration", os);
+    metrics.pauses.Dump(cause_prefix + ".pause", os);
+    os << cause_prefix << ".freed_bytes " << metrics.freed_bytes.LoadRelaxed() << "\n";
+    os << cause_prefix << ".promoted_bytes " << metrics.promoted_bytes.LoadRelaxed() << "\n";
+  }
+}
+
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_GC_METRICS_H_
+#define ART_RUNTIME_GC_GC_METRICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "gc/gc_cause.h"
+
+namespace art {
+namespace gc {
+
+// A histogram of durations recorded by one thread at a time, the GC, and read by any thread
+// without locks. Unlike Histogram, the buckets are fixed, powers of two of microseconds.
+class GcDurationHistogram {
+ public:
+  // Bucket i counts the durations below 2^i us, and at least 2^(i-1) us but for the first one.
+  // The last bucket counts all the longer durations, from 2^(kNumBuckets-2) us, about 17s.
+  static constexpr size_t kNumBuckets = 26;
+
+  GcDurationHistogram();
+
+  void AddValueNs(uint64_t duration_ns);
+
+  uint64_t GetCount() const {
+    return count_.LoadRelaxed();
+  }
+
+  // Write the count, sum and max of the durations, and the cumulative count of the non-empty
+  // buckets, as "<prefix>.<name> <value>" lines.
+  void Dump(const std::string& prefix, std::ostream& os) const;
+
+ private:
+  Atomic<uint64_t> buckets_[kNumBuckets];
+  Atomic<uint64_t> count_;
+  Atomic<uint64_t> sum_us_;
+  Atomic<uint64_t> max_us_;
+
+  DISALLOW_COPY_AND_ASSIGN(GcDurationHistogram);
+};
+
+// The metrics of the GCs run by a collector, by GC cause. Updated at the end of every GC, they
+// can be read at any time: the monitoring tools poll them instead of parsing the GC profiler
+// files or the dump of the performance info at exit.
+class GcMetrics {
+ public:
+  GcMetrics() {}
+
+  void RecordGc(GcCause cause,
+                uint64_t duration_ns,
+                const std::vector<uint64_t>& pause_times_ns,
+                int64_t freed_bytes,
+                uint64_t promoted_bytes);
+
+  // Write the metrics of the causes which ran GCs as "<prefix>.<cause>.<name> <value>" lines.
+  void Dump(const std::string& prefix, std::ostream& os) const;
+
+ private:
+  struct CauseMetrics {
+    CauseMetrics() : freed_bytes(0), promoted_bytes(0) {}
+
+    GcDurationHistogram durations;
+    GcDurationHistogram pauses;
+    Atomic<int64_t> freed_bytes;
+    Atomic<uint64_t> promoted_bytes;
+  };
+
+  CauseMetrics causes_[kGcCauseCount];
+
+  DISALLOW_COPY_AND_ASSIGN(GcMetrics);
+};
+
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_GC_METRICS_H_
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <fcntl.h>
 #include <fstream>
 #include <limits>
@@ -21,8 +22,12 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <vector>
+#include "android-base/stringprintf.h"
+#include "art_method-inl.h"
 #include "base/histogram-inl.h"
 #include "base/stl_util.h"
+#include "base/time_utils.h"
+#include "base/unix_file/fd_file.h"
 #include "common_throws.h"
 #include "cutils/sched_policy.h"
 #include "debugger.h"
@@ -71,6 +76,65 @@ namespace gc {
 // Number of regions divided for size distribution.
 static constexpr size_t kNumSizeDistRegions = 11;
 static constexpr size_t kConstToFragmentPhase = 4;
+// Size of the type and the size of the fields of a streamed record.
+static constexpr size_t kStreamRecordHeaderSize = 4;
+static constexpr size_t kStreamFileHeaderSize = 16;
+
+ProfileRecordEncoder::ProfileRecordEncoder(RecordType record_type) {
+  Put<uint8_t>(static_cast<uint8_t>(record_type));
+  Put<uint8_t>(0);
+  Put<uint16_t>(0);
+}
+
+void ProfileRecordEncoder::PutString(const std::string& str) {
+  uint16_t length = static_cast<uint16_t>(std::min<size_t>(str.size(), UINT16_MAX));
+  Put<uint16_t>(length);
+  data_.insert(data_.end(), str.begin(), str.begin() + length);
+}
+
+const std::vector<uint8_t>& ProfileRecordEncoder::Finish() {
+  DCHECK_LE(data_.size() - kStreamRecordHeaderSize, static_cast<size_t>(UINT16_MAX));
+  uint16_t size = static_cast<uint16_t>(data_.size() - kStreamRecordHeaderSize);
+  memcpy(&data_[2], &size, sizeof(size));
+  return data_;
+}
+
+ProfileStreamBuffer::ProfileStreamBuffer(size_t capacity)
+    : mask_(capacity - 1),
+      buffer_(new uint8_t[capacity]),
+      head_(0),
+      tail_(0) {
+  DCHECK(IsPowerOfTwo(capacity)) << capacity;
+}
+
+bool ProfileStreamBuffer::Write(const std::vector<uint8_t>& record) {
+  size_t head = head_.LoadRelaxed();
+  size_t tail = tail_.LoadAcquire();
+  size_t size = record.size();
+  if (UNLIKELY(mask_ + 1 - (head - tail) < size)) {
+    return false;
+  }
+  size_t start = head & mask_;
+  size_t first = std::min(size, mask_ + 1 - start);
+  memcpy(&buffer_[start], record.data(), first);
+  memcpy(&buffer_[0], record.data() + first, size - first);
+  // Publish the record before the reader can see the new head.
+  head_.StoreRelease(head + size);
+  return true;
+}
+
+void ProfileStreamBuffer::Read(std::vector<uint8_t>* out) {
+  size_t tail = tail_.LoadRelaxed();
+  size_t head = head_.LoadAcquire();
+  size_t size = head - tail;
+  size_t start = tail & mask_;
+  size_t first = std::min(size, mask_ + 1 - start);
+  out->insert(out->end(), &buffer_[start], &buffer_[start] + first);
+  out->insert(out->end(), &buffer_[0], &buffer_[0] + (size - first));
+  // Hand the space back to the writers once it is copied out.
+  tail_.StoreRelease(head);
+}
+
 // Dump Record Header based on record type.
 void RecordList::DumpHeader(std::ofstream& os) {
   switch (record_type_) {
@@ -102,6 +166,10 @@ void RecordList::DumpHeader(std::ofstream& os) {
          << "total_objects_allocated, Alloc_ThroughPut, Alloc_ThroughPut" << std::endl;
       break;
     }
+    case kRecordTypeAllocSite: {
+      os << "Allocation Sites, method, dex_pc, type, samples, estimated_bytes" << std::endl;
+      break;
+    }
     default: {
       os << "Not Supported Info!!" << record_type_ << std::endl;
       break;
@@ -127,6 +195,17 @@ void RecordList::ReleaseRecordsAndClear() {
   record_list_.clear();
 }
 
+// Release Records in list but the last one, which the heap may still update.
+void RecordList::ReleaseRecordsButLast() {
+  if (record_list_.size() <= 1) {
+    return;
+  }
+  for (auto iter = record_list_.begin(); iter != record_list_.end() - 1; iter++) {
+    delete (*iter);
+  }
+  record_list_.erase(record_list_.begin(), record_list_.end() - 1);
+}
+
 // Create new record and insert to list.
 void RecordList::InsertRecord(ProfileRecord* record) {
   record_list_.push_back(record);
@@ -241,6 +320,37 @@ void GCRecord::DumpRecord(std::ofstream& os) {
   os.flush();
 }
 
+// Encode GC record, in nanoseconds and bytes.
+void GCRecord::EncodeRecord(ProfileRecordEncoder* encoder) {
+  encoder->Put<uint32_t>(id_);
+  encoder->Put<uint64_t>(timestamp_);
+  encoder->PutName(reason_);
+  encoder->Put<uint64_t>(pause_time_max_);
+  encoder->Put<uint64_t>(mark_time_);
+  encoder->Put<uint64_t>(sweep_time_);
+  encoder->Put<uint64_t>(gc_time_);
+  encoder->Put<uint32_t>(free_object_count_);
+  encoder->Put<uint32_t>(free_bytes_);
+  encoder->Put<uint32_t>(free_large_object_count_);
+  encoder->Put<uint32_t>(free_large_object_bytes_);
+  encoder->Put<uint64_t>(max_wait_time_);
+  encoder->PutName(type_);
+  encoder->Put<uint32_t>(max_allowed_footprint_);
+  encoder->Put<uint32_t>(concurrent_start_bytes_);
+  encoder->Put<uint64_t>(blocking_time_);
+  encoder->Put<uint32_t>(allocated_size_before_gc_);
+  encoder->Put<uint32_t>(allocated_size_after_gc_);
+  encoder->Put<uint32_t>(total_object_count_in_alloc_stack_during_gc_);
+  encoder->Put<double>(gc_throughput_bpns_);
+  encoder->Put<double>(gc_throughput_npns_);
+  encoder->Put<uint32_t>(footprint_size_before_gc_);
+  encoder->Put<uint32_t>(footprint_size_after_gc_);
+  encoder->Put<uint32_t>(main_space_size_before_gc_);
+  encoder->Put<uint32_t>(main_space_size_after_gc_);
+  encoder->Put<uint32_t>(los_space_size_before_gc_);
+  encoder->Put<uint32_t>(los_space_size_after_gc_);
+}
+
 // Convert the data unit for inaccurate mode.
 void SuccAllocRecord::ConvertDataUnits() {
   if (GcProfiler::InaccurateMode()) {
@@ -263,6 +373,15 @@ void SuccAllocRecord::DumpRecord(std::ofstream& os) {
   }
   os.flush();
 }
+// Encode succeed allocation info.
+void SuccAllocRecord::EncodeRecord(ProfileRecordEncoder* encoder) {
+  encoder->Put<uint32_t>(gc_id_);
+  encoder->Put<uint32_t>(total_size_);
+  for (int i = 0; i < 12; i++) {
+    encoder->Put<uint32_t>(size_dist_[i]);
+  }
+}
+
 // Insert the size to distribution in allocation info record.
 // The size_dist_[] divided the object size into kNumSizeDistRegions.
 // It records the count of objects whose size is in coressponding region.
@@ -305,6 +424,15 @@ void FailAllocRecord::DumpRecord(std::ofstream& os) {
   os.flush();
 }
 
+// Encode fail allocation info.
+void FailAllocRecord::EncodeRecord(ProfileRecordEncoder* encoder) {
+  encoder->Put<uint32_t>(gc_id_);
+  encoder->Put<uint32_t>(size_);
+  encoder->PutName(phase_);
+  encoder->PutName(last_gc_type_);
+  encoder->PutString(std::string(type_, strnlen(type_, sizeof(type_))));
+}
+
 // Fill fail allocation info fields.
 void FailAllocRecord::FillFields(mirror::Class* klass,
                                  uint32_t bytes_allocated,
@@ -348,6 +476,13 @@ void LargeObjAllocRecord::DumpRecord(std::ofstream& os) {
   os.flush();
 }
 
+// Encode large object allocation info.
+void LargeObjAllocRecord::EncodeRecord(ProfileRecordEncoder* encoder) {
+  encoder->Put<uint32_t>(gc_id_);
+  encoder->Put<uint32_t>(size_);
+  encoder->PutString(std::string(type_, strnlen(type_, sizeof(type_))));
+}
+
 // Fill large object allocation info.
 void LargeObjAllocRecord::FillFields(uint32_t gc_id, uint32_t byte_count, mirror::Class* klass) {
   gc_id_ = gc_id;
@@ -405,6 +540,56 @@ void AllocInfoRecord::DumpRecord(std::ofstream& os) {
   os.flush();
 }
 
+// Encode allocation record.
+void AllocInfoRecord::EncodeRecord(ProfileRecordEncoder* encoder) {
+  encoder->Put<uint64_t>(duration_);
+  encoder->Put<uint32_t>(number_bytes_alloc_atomic_.LoadSequentiallyConsistent());
+  encoder->Put<uint32_t>(number_objects_alloc_.LoadSequentiallyConsistent());
+  encoder->Put<double>(throughput_bpns_);
+  encoder->Put<double>(throughput_npns_);
+}
+
+// Fill allocation site info.
+void AllocSiteRecord::FillFields(const std::string& method,
+                                 uint32_t dex_pc,
+                                 const std::string& type,
+                                 uint32_t samples,
+                                 uint64_t bytes) {
+  method_ = method;
+  dex_pc_ = dex_pc;
+  type_ = type;
+  samples_ = samples;
+  bytes_ = bytes;
+}
+
+// Convert the data unit for inaccurate mode.
+void AllocSiteRecord::ConvertDataUnits() {
+  if (GcProfiler::InaccurateMode()) {
+    // Convert bytes to Mb.
+    bytes_ = bytes_ / MB;
+  }
+}
+
+// Dump allocation site record.
+void AllocSiteRecord::DumpRecord(std::ofstream& os) {
+  // The strings have no raw form, only dump them as .csv.
+  if (!GcProfiler::DumpBinary()) {
+    ConvertDataUnits();
+    os << ", " << method_ << ", " << dex_pc_ << ", " << type_ << ", " << samples_
+       << ", " << bytes_ << std::endl;
+  }
+  os.flush();
+}
+
+// Encode allocation site record.
+void AllocSiteRecord::EncodeRecord(ProfileRecordEncoder* encoder) {
+  encoder->PutString(method_);
+  encoder->Put<uint32_t>(dex_pc_);
+  encoder->PutString(type_);
+  encoder->Put<uint32_t>(samples_);
+  encoder->Put<uint64_t>(bytes_);
+}
+
 GcProfiler GcProfiler::s_instance;
 
 GcProfiler::GcProfiler()
@@ -412,27 +597,40 @@ GcProfiler::GcProfiler()
             gc_id_(0),
             gc_prof_running_(false),
             prof_succ_allocation_(false),
-            data_dir_("data/local/tmp/gcprofile/") {
+            data_dir_("data/local/tmp/gcprofile/"),
+            alloc_sample_interval_(0),
+            stream_file_size_limit_(0),
+            stream_writer_(),
+            stream_writer_running_(false),
+            stream_dropped_records_(0),
+            stream_file_size_(0),
+            stream_file_index_(0) {
   gc_profiler_lock_ = new Mutex("Gcprofiling lock");
   succ_record_lock_ = new Mutex("Successfull allocation record lock");
   fail_record_lock_ = new Mutex("Fail allocation record lock");
+  alloc_site_lock_ = new Mutex("Allocation site samples lock", kGcProfilerAllocSiteLock);
+  stream_lock_ = new Mutex("Gcprofiling stream lock", kGcProfilerStreamingLock);
   // Build up the record lists for dump iteration.
   record_lists_.push_back(&gc_record_list_);
   record_lists_.push_back(&succ_record_list_);
   record_lists_.push_back(&fail_record_list_);
   record_lists_.push_back(&large_object_alloc_record_list_);
   record_lists_.push_back(&alloc_info_record_list_);
+  record_lists_.push_back(&alloc_site_record_list_);
   // Set the record list type.
   gc_record_list_.SetRecordType(kRecordTypeGC);
   succ_record_list_.SetRecordType(kRecordTypeSucc);
   fail_record_list_.SetRecordType(kRecordTypeFail);
   large_object_alloc_record_list_.SetRecordType(kRecordTypeLarge);
   alloc_info_record_list_.SetRecordType(kRecordTypeAlloc);
+  alloc_site_record_list_.SetRecordType(kRecordTypeAllocSite);
 }
 
 GcProfiler::~GcProfiler() {
   delete succ_record_lock_;
   delete fail_record_lock_;
+  delete alloc_site_lock_;
+  delete stream_lock_;
   //atul.b Fix Klocwork Memory Leak issue 112887
   delete gc_profiler_lock_;
 }
@@ -448,6 +646,9 @@ void GcProfiler::Start() {
     return;
   }
   profile_duration_ = NsToMs(NanoTime());
+  if (IsStreaming()) {
+    StartStreaming();
+  }
   gc_prof_running_ = true;
 
   // Create allocation info record.
@@ -465,6 +666,9 @@ void GcProfiler::Stop(bool drop_result) {
   }
   // Don't need the result.
   if (drop_result) {
+    if (IsStreaming()) {
+      StopStreaming();
+    }
     ClearAndReleaseAllRecords();
     gc_prof_running_ = false;
     return;
@@ -473,12 +677,139 @@ void GcProfiler::Stop(bool drop_result) {
   profile_duration_ = NsToMs(NanoTime()) - profile_duration_;
   // Calculate throughput.
   CalculateAllocThroughput(profile_duration_);
-  DumpRecordLists();
+  CreateAllocSiteRecords();
+  if (IsStreaming()) {
+    // The records before the last GC and success allocation records are already streamed, the
+    // fail and large object allocation records are streamed as soon as they are created.
+    StreamRecord(kRecordTypeGC, gc_record_list_.GetLastRecord());
+    StreamRecord(kRecordTypeSucc, succ_record_list_.GetLastRecord());
+    StreamRecord(kRecordTypeAlloc, alloc_info_record_list_.GetLastRecord());
+    for (ProfileRecord* record : alloc_site_record_list_.GetRecords()) {
+      StreamRecord(kRecordTypeAllocSite, record);
+    }
+    StopStreaming();
+  } else {
+    DumpRecordLists();
+  }
   ClearAndReleaseAllRecords();
   LOG(INFO) << "GCProfile: Finish!";
   gc_prof_running_ = false;
 }
 
+// Open the first stream file and start the writer thread, or fall back to dumping the records
+// at Stop() if the file cannot be created.
+void GcProfiler::StartStreaming() {
+  if (stream_buffer_ == nullptr) {
+    stream_buffer_.reset(new ProfileStreamBuffer(kStreamBufferCapacity));
+  }
+  stream_file_index_ = 0;
+  stream_dropped_records_.StoreRelaxed(0);
+  if (!OpenStreamFile()) {
+    LOG(WARNING) << "GCProfile: cannot stream to " << data_dir_ << ", dump at the end instead";
+    stream_file_size_limit_ = 0;
+    return;
+  }
+  stream_writer_running_.StoreRelease(true);
+  CHECK_PTHREAD_CALL(pthread_create, (&stream_writer_, nullptr, StreamWriterCallback, this),
+                     "GcProfiler stream writer thread");
+}
+
+// Stop the writer thread once it wrote all the records streamed so far.
+void GcProfiler::StopStreaming() {
+  if (!stream_writer_running_.LoadRelaxed()) {
+    return;
+  }
+  stream_writer_running_.StoreRelease(false);
+  CHECK_PTHREAD_CALL(pthread_join, (stream_writer_, nullptr), "GcProfiler stream writer thread");
+  uint32_t dropped = stream_dropped_records_.LoadRelaxed();
+  if (dropped != 0) {
+    LOG(WARNING) << "GCProfile: dropped " << dropped << " records, the writer fell behind";
+  }
+  // The writer may have failed to open its last file.
+  if (stream_file_ != nullptr) {
+    if (stream_file_->FlushClose() != 0) {
+      PLOG(WARNING) << "GCProfile: cannot write " << stream_file_->GetPath();
+    }
+    stream_file_.reset();
+  }
+}
+
+void GcProfiler::StreamRecord(RecordType record_type, ProfileRecord* record) {
+  if (record == nullptr || !stream_writer_running_.LoadRelaxed()) {
+    return;
+  }
+  ProfileRecordEncoder encoder(record_type);
+  record->EncodeRecord(&encoder);
+  MutexLock mu(Thread::Current(), *stream_lock_);
+  if (!stream_buffer_->Write(encoder.Finish())) {
+    stream_dropped_records_.FetchAndAddSequentiallyConsistent(1);
+  }
+}
+
+// Create the next stream file and write its header.
+bool GcProfiler::OpenStreamFile() {
+  std::string file_name = android::base::StringPrintf("%s/alloc_free_log_%d_%u.gcps",
+                                                      data_dir_.c_str(),
+                                                      getpid(),
+                                                      stream_file_index_);
+  stream_file_.reset(OS::CreateEmptyFileWriteOnly(file_name.c_str()));
+  if (stream_file_ == nullptr) {
+    PLOG(WARNING) << "GCProfile: cannot open " << file_name;
+    return false;
+  }
+  uint8_t bytes[kStreamFileHeaderSize];
+  uint32_t magic = kStreamMagic;
+  uint16_t version = kStreamVersion;
+  uint16_t header_size = kStreamFileHeaderSize;
+  uint32_t pid = static_cast<uint32_t>(getpid());
+  memcpy(&bytes[0], &magic, sizeof(magic));
+  memcpy(&bytes[4], &version, sizeof(version));
+  memcpy(&bytes[6], &header_size, sizeof(header_size));
+  memcpy(&bytes[8], &pid, sizeof(pid));
+  memcpy(&bytes[12], &stream_file_index_, sizeof(stream_file_index_));
+  if (!stream_file_->WriteFully(bytes, sizeof(bytes))) {
+    PLOG(WARNING) << "GCProfile: cannot write " << file_name;
+    stream_file_->Erase(true);
+    stream_file_.reset();
+    return false;
+  }
+  LOG(INFO) << file_name << " will be used.";
+  stream_file_size_ = sizeof(bytes);
+  return true;
+}
+
+// Write the records streamed so far, and go on in a new file once this one is full.
+void GcProfiler::WriteStreamBuffer() {
+  stream_chunk_.clear();
+  stream_buffer_->Read(&stream_chunk_);
+  if (stream_chunk_.empty() || stream_file_ == nullptr) {
+    return;
+  }
+  if (!stream_file_->WriteFully(stream_chunk_.data(), stream_chunk_.size())) {
+    PLOG(WARNING) << "GCProfile: cannot write " << stream_file_->GetPath();
+    return;
+  }
+  stream_file_size_ += stream_chunk_.size();
+  if (stream_file_size_ >= stream_file_size_limit_) {
+    if (stream_file_->FlushClose() != 0) {
+      PLOG(WARNING) << "GCProfile: cannot write " << stream_file_->GetPath();
+    }
+    ++stream_file_index_;
+    OpenStreamFile();
+  }
+}
+
+void* GcProfiler::StreamWriterCallback(void* arg) {
+  GcProfiler* profiler = reinterpret_cast<GcProfiler*>(arg);
+  while (profiler->stream_writer_running_.LoadAcquire()) {
+    NanoSleep(kStreamWriteIntervalNs);
+    profiler->WriteStreamBuffer();
+  }
+  // Write the records streamed before the stop.
+  profiler->WriteStreamBuffer();
+  return nullptr;
+}
+
 // Dump title line that contains data unit.
 void GcProfiler::DumpTitleLine(std::ofstream& out) {
   std::string time_unit = "nanoseconds";
@@ -584,6 +915,10 @@ void GcProfiler::ClearAndReleaseAllRecords() {
        it != record_lists_.end(); it++) {
     (*it)->ReleaseRecordsAndClear();
   }
+  {
+    MutexLock mu(Thread::Current(), *alloc_site_lock_);
+    alloc_sites_.clear();
+  }
   // Clear all counters.
   gc_id_ = 0;
   profile_duration_ = 0;
@@ -630,9 +965,20 @@ void GcProfiler::InsertNewGcRecord(const GcCause gc_cause, const collector::GcTy
     if (record != nullptr) {
       record->FillBasicInfo(gc_id_++, gc_cause, gc_type, gc_start_time_ns, footprint,
                             bytes_allocated, main_space_size, los_space_size);
+      if (IsStreaming()) {
+        // The last GC record is complete, but keep it until the next GC for the threads
+        // that may still be updating its times.
+        StreamRecord(kRecordTypeGC, gc_record_list_.GetLastRecord());
+        gc_record_list_.ReleaseRecordsButLast();
+      }
       gc_record_list_.InsertRecord(reinterpret_cast<ProfileRecord*>(record));
       // Create success allocation record if necessory.
       if (prof_succ_allocation_) {
+        MutexLock mu(Thread::Current(), *succ_record_lock_);
+        if (IsStreaming()) {
+          StreamRecord(kRecordTypeSucc, succ_record_list_.GetLastRecord());
+          succ_record_list_.ReleaseRecordsAndClear();
+        }
         CreateSuccAllocRecord(record->GetGcId());
       }
     }
@@ -706,11 +1052,70 @@ void GcProfiler::InsertLargeObjAllocRecord(uint32_t gc_id, uint32_t byte_count,
     LargeObjAllocRecord *record = new LargeObjAllocRecord();
     if (record != nullptr) {
       record->FillFields(gc_id, byte_count, klass);
+      if (IsStreaming()) {
+        StreamRecord(kRecordTypeLarge, record);
+        delete record;
+        return;
+      }
       large_object_alloc_record_list_.InsertRecord(reinterpret_cast<ProfileRecord*>(record));
     }
   }
 }
 
+// Take the samples that fall in the bytes a thread just allocated. Each sample stands for the
+// sample interval bytes, and is attributed to the allocation that crossed it.
+void GcProfiler::SampleAllocSite(Thread* self, size_t bytes, mirror::Class* klass) {
+  if (!gc_prof_running_) {
+    return;
+  }
+  size_t interval = alloc_sample_interval_;
+  size_t bytes_left = self->GetAllocSampleBytesLeft();
+  if (bytes_left == 0 || bytes_left > interval) {
+    // The thread starts counting, or the interval changed.
+    bytes_left = interval;
+  }
+  if (bytes < bytes_left) {
+    self->SetAllocSampleBytesLeft(bytes_left - bytes);
+    return;
+  }
+  uint32_t samples = 1 + (bytes - bytes_left) / interval;
+  self->SetAllocSampleBytesLeft(interval - (bytes - bytes_left) % interval);
+  uint32_t dex_pc = 0;
+  ArtMethod* method = self->GetCurrentMethod(&dex_pc,
+                                             /* check_suspended */ false,
+                                             /* abort_on_error */ false);
+  AllocSiteKey key;
+  // No signature, as its commas would break the .csv columns.
+  key.method = method != nullptr ? method->PrettyMethod(/* with_signature */ false) : "<runtime>";
+  key.dex_pc = method != nullptr ? dex_pc : 0u;
+  key.type = Runtime::Current()->GetHeap()->SafeGetClassDescriptor(klass);
+  MutexLock mu(self, *alloc_site_lock_);
+  alloc_sites_[key] += samples;
+}
+
+void GcProfiler::CreateAllocSiteRecords() {
+  std::vector<std::pair<AllocSiteKey, uint32_t>> sites;
+  {
+    MutexLock mu(Thread::Current(), *alloc_site_lock_);
+    sites.assign(alloc_sites_.begin(), alloc_sites_.end());
+  }
+  std::sort(sites.begin(),
+            sites.end(),
+            [](const std::pair<AllocSiteKey, uint32_t>& a,
+               const std::pair<AllocSiteKey, uint32_t>& b) {
+              return a.second > b.second;
+            });
+  for (const std::pair<AllocSiteKey, uint32_t>& site : sites) {
+    AllocSiteRecord* record = new AllocSiteRecord();
+    record->FillFields(site.first.method,
+                       site.first.dex_pc,
+                       site.first.type,
+                       site.second,
+                       static_cast<uint64_t>(site.second) * alloc_sample_interval_);
+    alloc_site_record_list_.InsertRecord(reinterpret_cast<ProfileRecord*>(record));
+  }
+}
+
 // Calaculate alloc throughput with duration.
 void GcProfiler::CalculateAllocThroughput(uint64_t duration) {
   AllocInfoRecord* record = reinterpret_cast<AllocInfoRecord*>(alloc_info_record_list_.GetLastRecord());
@@ -732,6 +1137,11 @@ void GcProfiler::CreateFailRecord(mirror::Class* klass,
     FailAllocRecord* record = new FailAllocRecord();
     if (record != nullptr) {
       record->FillFields(klass, bytes_allocated, max_allowed_footprint, alloc_size, gc_id, gc_type, fail_phase);
+      if (IsStreaming()) {
+        StreamRecord(kRecordTypeFail, record);
+        delete record;
+        return;
+      }
       fail_record_list_.InsertRecord(reinterpret_cast<ProfileRecord*>(record));
     }
   }
@@ -17,7 +17,17 @@
 #ifndef ART_RUNTIME_GC_GCPROFILER_H_
 #define ART_RUNTIME_GC_GCPROFILER_H_
 
+#include <pthread.h>
+
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "atomic.h"
+#include "base/time_utils.h"
 #include "gc/heap.h"
+#include "os.h"
 
 namespace art {
 
@@ -46,15 +56,68 @@ enum RecordType {
   kRecordTypeFail,
   kRecordTypeLarge,
   kRecordTypeAlloc,
+  kRecordTypeAllocSite,
 };
 
 std::ostream& operator<<(std::ostream& os, const AllocFailPhase& alloc_fail_phase);
 std::ostream& operator<<(std::ostream& os, const RecordType& record_type);
 
+// Encodes a record of the streaming binary format, in the byte order of the device:
+//   uint8_t record type, uint8_t reserved, uint16_t size of the fields, fields.
+// The strings are a uint16_t length followed by their characters. The fields are in the order
+// of the .csv columns, in nanoseconds and bytes.
+class ProfileRecordEncoder {
+ public:
+  explicit ProfileRecordEncoder(RecordType record_type);
+
+  template <typename T>
+  void Put(T value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    data_.insert(data_.end(), bytes, bytes + sizeof(T));
+  }
+  void PutString(const std::string& str);
+  // Encode the string of an enum, as the .csv has it.
+  template <typename T>
+  void PutName(const T& value) {
+    std::ostringstream os;
+    os << value;
+    PutString(os.str());
+  }
+  // Set the size of the fields, once all of them are encoded.
+  const std::vector<uint8_t>& Finish();
+
+ private:
+  std::vector<uint8_t> data_;
+};
+
+// A ring buffer of the encoded records, which a single thread drains without locking. The
+// writers serialize with each other.
+class ProfileStreamBuffer {
+ public:
+  // The capacity must be a power of two.
+  explicit ProfileStreamBuffer(size_t capacity);
+  // Returns false, leaving the buffer unchanged, if the encoded record does not fit.
+  bool Write(const std::vector<uint8_t>& record);
+  // Move the records written so far to out, which only ever ends with whole records.
+  void Read(std::vector<uint8_t>* out);
+
+ private:
+  const size_t mask_;
+  std::unique_ptr<uint8_t[]> buffer_;
+  // The index of the next byte to write.
+  Atomic<size_t> head_;
+  // The index of the next byte to read.
+  Atomic<size_t> tail_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProfileStreamBuffer);
+};
+
 // Base class of all records that GC Profiler dump.
 class ProfileRecord {
  public:
   virtual void DumpRecord(std::ofstream& os) { UNUSED(os); }
+  // Encode the fields for the streaming mode.
+  virtual void EncodeRecord(ProfileRecordEncoder* encoder) { UNUSED(encoder); }
   virtual ~ProfileRecord() {}
   // Convert time from ns to ms.
   void ConvertTimeToMs(uint64_t& time) {
@@ -120,6 +183,7 @@ class GCRecord : public ProfileRecord {
   }
 
   void DumpRecord(std::ofstream& os);
+  void EncodeRecord(ProfileRecordEncoder* encoder);
   void ConvertDataUnits();
   uint32_t GetGcId() { return id_; }
 
@@ -165,6 +229,7 @@ class SuccAllocRecord : public ProfileRecord {
   // Insert the size distribution to allocinfo.
   void InsertSizeDist(uint32_t size);
   void DumpRecord(std::ofstream& os);
+  void EncodeRecord(ProfileRecordEncoder* encoder);
   void FillFields(uint32_t byte_count);
   void SetGcId(uint32_t id) { gc_id_ = id; }
   uint32_t GetGcId() { return gc_id_; }
@@ -182,6 +247,7 @@ class FailAllocRecord : public ProfileRecord {
 
  public:
   void DumpRecord(std::ofstream& os);
+  void EncodeRecord(ProfileRecordEncoder* encoder);
   void ConvertDataUnits();
   void FillFields(mirror::Class* klass,
                   uint32_t bytes_allocated,
@@ -201,6 +267,7 @@ class LargeObjAllocRecord : public ProfileRecord {
 
  public:
   void DumpRecord(std::ofstream& os);
+  void EncodeRecord(ProfileRecordEncoder* encoder);
   void ConvertDataUnits();
   void FillFields(uint32_t gc_id, uint32_t byte_count, mirror::Class* klass);
 };
@@ -220,6 +287,7 @@ class AllocInfoRecord : public ProfileRecord {
   // Add allocation info.
   void AddAllocInfo(uint32_t bytes_allocated);
   void DumpRecord(std::ofstream& os);
+  void EncodeRecord(ProfileRecordEncoder* encoder);
   void ConvertDataUnits();
   void CalculateAllocThroughput(uint64_t duration);
   AllocInfoRecord() : number_bytes_alloc_atomic_(0),
@@ -230,6 +298,27 @@ class AllocInfoRecord : public ProfileRecord {
                       duration_(0) { }
 };
 
+// Sampled allocations of a type at an allocation site.
+class AllocSiteRecord : public ProfileRecord {
+ private:
+  std::string method_;
+  uint32_t dex_pc_;
+  std::string type_;
+  uint32_t samples_;
+  // Estimated from the samples and the sample interval.
+  uint64_t bytes_;
+
+ public:
+  void DumpRecord(std::ofstream& os);
+  void EncodeRecord(ProfileRecordEncoder* encoder);
+  void ConvertDataUnits();
+  void FillFields(const std::string& method,
+                  uint32_t dex_pc,
+                  const std::string& type,
+                  uint32_t samples,
+                  uint64_t bytes);
+};
+
 // Class of record list.
 class RecordList {
  public:
@@ -237,6 +326,11 @@ class RecordList {
   void InsertRecord(ProfileRecord* record);
   ProfileRecord* GetLastRecord();
   void ReleaseRecordsAndClear();
+  // Release the records but the last one, which may still be in use.
+  void ReleaseRecordsButLast();
+  const std::vector<ProfileRecord*>& GetRecords() const {
+    return record_list_;
+  }
   uint32_t Size() { return record_list_.size(); }
   void SetRecordType(RecordType record_type) {
     record_type_ = record_type;
@@ -321,6 +415,34 @@ class GcProfiler {
     return gc_prof_running_;
   }
 
+  // Stream the records to binary files of about file_size bytes each, while profiling, rather
+  // than keep them until Stop(). tools/gcprofile-stream-converter.py converts the files to .csv.
+  void EnableStreaming(size_t file_size) {
+    stream_file_size_limit_ = file_size;
+  }
+
+  bool IsStreaming() const {
+    return stream_file_size_limit_ != 0;
+  }
+
+  // Sample the allocation sites about every interval bytes allocated by each thread, 0 to
+  // disable. Unlike the success allocation profile, only the allocations that refill a thread
+  // local buffer or go to the shared spaces are looked at, which keeps it cheap enough to
+  // leave on.
+  void SetAllocSampleInterval(size_t interval) {
+    alloc_sample_interval_ = interval;
+  }
+
+  bool SampleAllocSites() const {
+    return alloc_sample_interval_ != 0;
+  }
+
+  // Account bytes allocated by self for an allocation of klass, which takes the samples that
+  // fall in them.
+  void SampleAllocSite(Thread* self, size_t bytes, mirror::Class* klass)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!*alloc_site_lock_);
+
   // By default dump .csv file, leave binary options here for extension.
   static bool DumpBinary() {
     return dump_binary_format_;
@@ -373,6 +495,60 @@ class GcProfiler {
   void InsertLargeObjAllocRecord(uint32_t gc_id, uint32_t byte_count, mirror::Class* klass);
   void CreateAllocInfoRecord();
   uint32_t GetCurrentGcId();
+  // Turn the sampled allocation sites into records, the most sampled first.
+  void CreateAllocSiteRecords() REQUIRES(!*alloc_site_lock_);
+
+  struct AllocSiteKey {
+    std::string method;
+    uint32_t dex_pc;
+    std::string type;
+
+    bool operator==(const AllocSiteKey& other) const {
+      return dex_pc == other.dex_pc && method == other.method && type == other.type;
+    }
+  };
+
+  struct AllocSiteKeyHash {
+    size_t operator()(const AllocSiteKey& key) const {
+      std::hash<std::string> hash;
+      return (hash(key.method) * 31u + key.dex_pc) * 31u + hash(key.type);
+    }
+  };
+
+  size_t alloc_sample_interval_;
+  // Lock for the sampled allocation sites.
+  Mutex* alloc_site_lock_;
+  // The number of samples of each allocation site.
+  std::unordered_map<AllocSiteKey, uint32_t, AllocSiteKeyHash> alloc_sites_;
+  RecordList alloc_site_record_list_;
+
+  // Streaming mode.
+  static constexpr uint32_t kStreamMagic = 0x53504347;  // "GCPS"
+  static constexpr uint16_t kStreamVersion = 1;
+  static constexpr size_t kStreamBufferCapacity = 1 * MB;
+  static constexpr uint64_t kStreamWriteIntervalNs = MsToNs(100);
+  void StartStreaming();
+  void StopStreaming();
+  // Hand a complete record to the writer thread, or drop it if the writer falls behind.
+  void StreamRecord(RecordType record_type, ProfileRecord* record) REQUIRES(!*stream_lock_);
+  // Writer thread only, once started.
+  bool OpenStreamFile();
+  void WriteStreamBuffer();
+  static void* StreamWriterCallback(void* arg);
+
+  // The size of the files after which the writer goes on in a new one, or 0 when not streaming.
+  size_t stream_file_size_limit_;
+  std::unique_ptr<ProfileStreamBuffer> stream_buffer_;
+  // Serializes the writes to the stream buffer.
+  Mutex* stream_lock_;
+  pthread_t stream_writer_;
+  Atomic<bool> stream_writer_running_;
+  // The records the writer did not drain in time for.
+  Atomic<uint32_t> stream_dropped_records_;
+  std::unique_ptr<File> stream_file_;
+  size_t stream_file_size_;
+  uint32_t stream_file_index_;
+  std::vector<uint8_t> stream_chunk_;
 };
 }   // namespace gc
 }   // namespace art
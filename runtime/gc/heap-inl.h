@@ -81,8 +81,10 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self,
   size_t new_num_bytes_allocated = 0;
   if (IsTLABAllocator(allocator))
     byte_count = RoundUp(byte_count, space::BumpPointerSpace::kAlignment);
+  // The instances of the pretenured classes skip the thread-local buffers of the young generation.
+  const bool pretenure = IsTLABAllocator(allocator) && UNLIKELY(klass->IsPretenured());
   // If we have a thread local allocation we don't need to update bytes allocated.
-  if (IsTLABAllocator(allocator) && byte_count <= self->TlabSize()) {
+  if (IsTLABAllocator(allocator) && !pretenure && byte_count <= self->TlabSize()) {
     obj = self->AllocTlab(byte_count);
     DCHECK(obj != nullptr) << "AllocTlab can't fail";
     obj->SetClass(klass);
@@ -114,8 +116,19 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self,
   } else {
     // bytes allocated that takes bulk thread-local buffer allocations into account.
     size_t bytes_tl_bulk_allocated = 0;
-    obj = TryToAllocate<kInstrumented, false>(self, allocator, byte_count, &bytes_allocated,
-                                              &usable_size, &bytes_tl_bulk_allocated);
+    if (UNLIKELY(pretenure)) {
+      // Allocate in the old generation, or in the young one when it is full.
+      obj = TryToAllocate<kInstrumented, false>(self, kAllocatorTypeNonMoving, byte_count,
+                                                &bytes_allocated, &usable_size,
+                                                &bytes_tl_bulk_allocated);
+      if (obj != nullptr) {
+        allocator = kAllocatorTypeNonMoving;
+      }
+    }
+    if (obj == nullptr) {
+      obj = TryToAllocate<kInstrumented, false>(self, allocator, byte_count, &bytes_allocated,
+                                                &usable_size, &bytes_tl_bulk_allocated);
+    }
     if (UNLIKELY(obj == nullptr)) {
       // AllocateInternalWithGc can cause thread suspension, if someone instruments the entrypoints
       // or changes the allocator in a suspend point here, we need to retry the allocation.
@@ -146,6 +159,16 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self,
       if (obj != nullptr && gcProfiler->ProfileSuccAllocInfo()) {
         gcProfiler->InsertSuccAllocRecord(byte_count, klass.Ptr());
       }
+      // The bytes of a new thread local buffer are all accounted here, the allocations that
+      // bump in it are not looked at.
+      if (gcProfiler->SampleAllocSites()) {
+        gcProfiler->SampleAllocSite(self, bytes_tl_bulk_allocated, klass.Ptr());
+      }
+    }
+    if (pretenure_table_ != nullptr && bytes_tl_bulk_allocated != 0u &&
+        IsTLABAllocator(allocator)) {
+      // Like the GC profiler, account the new thread-local buffer to the class allocating it.
+      SamplePretenureAllocation(self, klass, bytes_tl_bulk_allocated);
     }
     DCHECK_GT(bytes_allocated, 0u);
     DCHECK_GT(usable_size, 0u);
@@ -164,6 +187,12 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self,
       // cases because we don't directly allocate into the main alloc
       // space (besides promotions) under the SS/GSS collector.
       WriteBarrierField(obj, mirror::Object::ClassOffset(), klass);
+    } else if (kUseReadBarrier && AllocatorHasAllocationStack(allocator)) {
+      // The compiled code does not mark the card for reference stores into an object it
+      // allocated with no GC point since, relying on the collector to trace the regions
+      // allocated since the last pause entirely. Mark it for the objects allocated anywhere
+      // else, as their stores would otherwise be missed.
+      WriteBarrierField(obj, mirror::Object::ClassOffset(), klass);
     }
     if (AllocatorHasAllocationStack(allocator)) {
       PushOnAllocationStack(self, &obj);
@@ -16,6 +16,7 @@
 
 #include "heap.h"
 
+#include <algorithm>
 #include <limits>
 #include <memory>
 #include <vector>
@@ -51,6 +52,7 @@
 #include "gc/collector/partial_mark_sweep.h"
 #include "gc/collector/semi_space.h"
 #include "gc/collector/sticky_mark_sweep.h"
+#include "gc/pretenure_table.h"
 #include "gc/reference_processor.h"
 #include "gc/scoped_gc_critical_section.h"
 #include "gc/space/bump_pointer_space.h"
@@ -102,12 +104,23 @@ static constexpr size_t kCollectorTransitionStressWait = 10 * 1000;  // Microsec
 // Minimum amount of remaining bytes before a concurrent GC is triggered.
 static constexpr size_t kMinConcurrentRemainingBytes = 128 * KB;
 static constexpr size_t kMaxConcurrentRemainingBytes = 512 * KB;
+// Start the concurrent GCs early enough for the allocations predicted during a cycle, times
+// this headroom, to fit below the growth limit.
+static constexpr bool kUseConcurrentGcPrediction = true;
+static constexpr double kConcurrentGcPredictionHeadroom = 1.5;
+// Bounds of the bump pointer spaces resized for -XX:GenCopyingPauseGoalMs. Each young collection
+// changes their size by kMaxYoungSizeChange at most.
+static constexpr size_t kMinYoungSize = 1 * MB;
+static constexpr double kMaxYoungSizeChange = 2.0;
 // Sticky GC throughput adjustment, divided by 4. Increasing this causes sticky GC to occur more
 // relative to partial/full GC. This may be desirable since sticky GCs interfere less with mutator
 // threads (lower pauses, use less memory bandwidth).
 static constexpr double kStickyGcThroughputAdjustment = 1.0;
 // Whether or not we compact the zygote in PreZygoteFork.
 static constexpr bool kCompactZygote = kMovingCollector;
+// Whether GenCopying allocates the instances of the classes that mostly survive until promoted
+// directly in the non-moving space.
+static constexpr bool kPretenureLongLivedClasses = true;
 // How many reserve entries are at the end of the allocation stack, these are only needed if the
 // allocation stack overflows.
 static constexpr size_t kAllocationStackReserveSize = 1024;
@@ -138,6 +151,13 @@ static constexpr uint32_t kAllocSpaceBeginForDeterministicAoT = 0x40000000;
 static constexpr bool kDumpRosAllocStatsOnSigQuit = false;
 
 static const char* kRegionSpaceName = "main space (region space)";
+static_assert(Heap::kDefaultRegionSize == space::RegionSpace::kRegionSize,
+              "The default region size must be the smallest one");
+static_assert(Heap::kMaxRegionSize == space::RegionSpace::kMaxRegionSize,
+              "Mismatch of the largest region size");
+static_assert(Heap::kDefaultRegionEvacuateLivePercent ==
+                  space::RegionSpace::kDefaultEvacuateLivePercentThreshold,
+              "Mismatch of the default evacuation threshold");
 
 // If true, we log all GCs in the both the foreground and background. Used for debugging.
 static constexpr bool kLogAllGCs = false;
@@ -146,6 +166,10 @@ static constexpr bool kLogAllGCs = false;
 static constexpr size_t kPartialTlabSize = 16 * KB;
 static constexpr bool kUsePartialTlabs = true;
 
+// A heap trim of a process that cares about pause times only suspends all threads to deflate the
+// idle monitors if there are at least this many.
+static constexpr size_t kMinIdleMonitorsToDeflate = 64;
+
 #if defined(__LP64__) || !defined(ADDRESS_SANITIZER)
 // 300 MB (0x12c00000) - (default non-moving space capacity).
 static uint8_t* const kPreferredAllocSpaceBegin =
@@ -196,6 +220,11 @@ Heap::Heap(size_t initial_size,
            size_t tlab_alloc_threshold,
            size_t tenure_threshold,
            size_t bump_space_capacity,
+           unsigned int gen_copying_pause_goal_ms,
+           bool use_generational_cc,
+           size_t region_size,
+           unsigned int region_evacuate_live_percent,
+           bool use_huge_pages,
            bool measure_gc_performance,
            bool use_homogeneous_space_compaction_for_oom,
            uint64_t min_interval_homogeneous_space_compaction_by_oom,
@@ -249,6 +278,13 @@ Heap::Heap(size_t initial_size,
       verify_pre_sweeping_rosalloc_(verify_pre_sweeping_rosalloc),
       verify_post_gc_rosalloc_(verify_post_gc_rosalloc),
       gc_stress_mode_(gc_stress_mode),
+      allocation_rate_(0u),
+      concurrent_gc_duration_ns_(0u),
+      last_gc_end_time_ns_(0u),
+      bytes_allocated_after_last_gc_(0u),
+      unpredicted_concurrent_start_bytes_(0u),
+      predicted_concurrent_gc_count_(0u),
+      blocking_gc_avoided_count_(0u),
       /* For GC a lot mode, we limit the allocations stacks to be kGcAlotInterval allocations. This
        * causes a lot of GC since we do a GC for alloc whenever the stack is full. When heap
        * verification is enabled, we limit the size of allocation stacks to speed up their
@@ -275,10 +311,17 @@ Heap::Heap(size_t initial_size,
       tlab_size_(tlab_size),
       tlab_alloc_threshold_(tlab_alloc_threshold),
       bump_space_capacity_(bump_space_capacity),
+      gen_copying_pause_goal_ms_(gen_copying_pause_goal_ms),
+      young_size_(0),
 	  moving_gc_count_(0),
       semi_space_collector_(nullptr),
       mark_compact_collector_(nullptr),
       concurrent_copying_collector_(nullptr),
+      young_concurrent_copying_collector_(nullptr),
+      active_concurrent_copying_collector_(nullptr),
+      use_generational_cc_(use_generational_cc && kUseBakerReadBarrier),
+      region_evacuate_live_percent_(region_evacuate_live_percent),
+      use_huge_pages_(use_huge_pages),
       is_running_on_memory_tool_(Runtime::Current()->IsRunningOnMemoryTool()),
       use_tlab_(use_tlab),
       main_space_backup_(nullptr),
@@ -287,6 +330,8 @@ Heap::Heap(size_t initial_size,
       last_time_homogeneous_space_compaction_by_oom_(NanoTime()),
       pending_collector_transition_(nullptr),
       pending_heap_trim_(nullptr),
+      trim_resume_space_(nullptr),
+      trim_resume_page_idx_(0),
       use_homogeneous_space_compaction_for_oom_(use_homogeneous_space_compaction_for_oom),
       running_collection_is_blocking_(false),
       blocking_gc_count_(0U),
@@ -298,6 +343,10 @@ Heap::Heap(size_t initial_size,
       gc_count_rate_histogram_("gc count rate histogram", 1U, kGcCountRateMaxBucketCount),
       blocking_gc_count_rate_histogram_("blocking gc count rate histogram", 1U,
                                         kGcCountRateMaxBucketCount),
+      last_gc_metrics_time_(NanoTime()),
+      last_gc_metrics_bytes_allocated_(0U),
+      metrics_allocation_rate_(0U),
+      promotion_rate_(0U),
       alloc_tracking_enabled_(false),
       backtrace_lock_(nullptr),
       seen_backtrace_count_(0u),
@@ -452,6 +501,7 @@ Heap::Heap(size_t initial_size,
                                                 &error_str));
     }
     CHECK(main_mem_map_1.get() != nullptr) << error_str;
+    AdviseHugePages(main_mem_map_1.get());
   }
   if (support_homogeneous_space_compaction ||
       background_collector_type_ == kCollectorTypeSS ||
@@ -460,6 +510,7 @@ Heap::Heap(size_t initial_size,
     main_mem_map_2.reset(MapAnonymousPreferredAddress(kMemMapSpaceName[1], main_mem_map_1->End(),
                                                       capacity_, &error_str));
     CHECK(main_mem_map_2.get() != nullptr) << error_str;
+    AdviseHugePages(main_mem_map_2.get());
   }
 
   // Create the non moving space first so that bitmaps don't take up the address range.
@@ -479,11 +530,17 @@ Heap::Heap(size_t initial_size,
   // Create other spaces based on whether or not we have a moving GC.
   if (foreground_collector_type_ == kCollectorTypeCC) {
     CHECK(separate_non_moving_space);
-    MemMap* region_space_mem_map = space::RegionSpace::CreateMemMap(kRegionSpaceName,
-                                                                    capacity_ * 2,
-                                                                    request_begin);
+    // Align the region space by the huge pages to back all of it by them.
+    const size_t alignment =
+        use_huge_pages_ ? MemMap::kHugePageSize : space::RegionSpace::kRegionSize;
+    MemMap* region_space_mem_map = space::RegionSpace::CreateMemMap(
+        kRegionSpaceName,
+        RoundUp(capacity_ * 2, std::max(region_size, alignment)),
+        request_begin,
+        alignment);
     CHECK(region_space_mem_map != nullptr) << "No region space mem map";
-    region_space_ = space::RegionSpace::Create(kRegionSpaceName, region_space_mem_map);
+    AdviseHugePages(region_space_mem_map);
+    region_space_ = space::RegionSpace::Create(kRegionSpaceName, region_space_mem_map, region_size);
     AddSpace(region_space_);
   } else if (IsMovingGc(foreground_collector_type_) &&
       foreground_collector_type_ != kCollectorTypeGSS &&
@@ -517,11 +574,14 @@ Heap::Heap(size_t initial_size,
       bump_pointer_space_ = space::BumpPointerSpace::Create("Bump pointer space 1",
                                                             bump_space_capacity_, nullptr);
       CHECK(bump_pointer_space_ != nullptr);
+      AdviseHugePages(bump_pointer_space_->GetMemMap());
       AddSpace(bump_pointer_space_);
       temp_space_ = space::BumpPointerSpace::Create("Bump pointer space 2",
                                                     bump_space_capacity_, nullptr);
       CHECK(temp_space_ != nullptr);
+      AdviseHugePages(temp_space_->GetMemMap());
       AddSpace(temp_space_);
+      young_size_ = bump_space_capacity_;
     } else if (main_mem_map_2.get() != nullptr) {
       const char* name = kUseRosAlloc ? kRosAllocSpaceName[1] : kDlMallocSpaceName[1];
       main_space_backup_.reset(CreateMallocSpaceFromMemMap(main_mem_map_2.release(), initial_size,
@@ -569,7 +629,8 @@ Heap::Heap(size_t initial_size,
   // reserved by the kernel.
   static constexpr size_t kMinHeapAddress = 4 * KB;
   card_table_.reset(accounting::CardTable::Create(reinterpret_cast<uint8_t*>(kMinHeapAddress),
-                                                  4 * GB - kMinHeapAddress));
+                                                  4 * GB - kMinHeapAddress,
+                                                  use_huge_pages_));
   CHECK(card_table_.get() != nullptr) << "Failed to create card table";
   if (foreground_collector_type_ == kCollectorTypeCC && kUseTableLookupReadBarrier) {
     rb_table_.reset(new accounting::ReadBarrierTable());
@@ -653,6 +714,11 @@ Heap::Heap(size_t initial_size,
                                                        generational ? "generational" : "",
                                                        need_aging_table);
       garbage_collectors_.push_back(semi_space_collector_);
+      if (kPretenureLongLivedClasses &&
+          foreground_collector_type_ == kCollectorTypeGenCopying &&
+          need_aging_table) {
+        pretenure_table_.reset(new PretenureTable());
+      }
     }
     if (MayUseCollector(kCollectorTypeGenCopying)) {
       garbage_collectors_.push_back(new collector::PartialMarkSweep(this, true/*concurrent*/, true/*copying*/));
@@ -661,10 +727,22 @@ Heap::Heap(size_t initial_size,
     if (MayUseCollector(kCollectorTypeCC)) {
       concurrent_copying_collector_ = new collector::ConcurrentCopying(this,
                                                                        "",
-                                                                       measure_gc_performance);
+                                                                       measure_gc_performance,
+                                                                       use_generational_cc_);
       DCHECK(region_space_ != nullptr);
       concurrent_copying_collector_->SetRegionSpace(region_space_);
       garbage_collectors_.push_back(concurrent_copying_collector_);
+      if (use_generational_cc_) {
+        young_concurrent_copying_collector_ = new collector::ConcurrentCopying(
+            this,
+            "young",
+            measure_gc_performance,
+            /* use_generational */ true,
+            /* young_gen */ true);
+        young_concurrent_copying_collector_->SetRegionSpace(region_space_);
+        garbage_collectors_.push_back(young_concurrent_copying_collector_);
+      }
+      active_concurrent_copying_collector_ = concurrent_copying_collector_;
     }
     if (MayUseCollector(kCollectorTypeMC)) {
       mark_compact_collector_ = new collector::MarkCompact(this);
@@ -702,7 +780,10 @@ Heap::Heap(size_t initial_size,
   }
   // For GSS and Generational Copying collector.
   // It won't impact other collectors.
-  SetThresholdAge(tenure_threshold);
+  // The aging tables do not count past kMaxAge.
+  max_threshold_age_ = std::min(tenure_threshold,
+                                static_cast<size_t>(accounting::AgingTable::kMaxAge));
+  SetThresholdAge(max_threshold_age_);
 }
 
 MemMap* Heap::MapAnonymousPreferredAddress(const char* name,
@@ -720,6 +801,33 @@ MemMap* Heap::MapAnonymousPreferredAddress(const char* name,
   }
 }
 
+void Heap::AdviseHugePages(MemMap* mem_map) {
+  if (use_huge_pages_ && !mem_map->MadviseHugePages()) {
+    VLOG(heap) << "Could not back " << mem_map->GetName() << " by huge pages";
+  }
+}
+
+void Heap::GetHugePageCoverage(size_t* advised_bytes, size_t* backed_bytes) {
+  std::vector<const MemMap*> mem_maps;
+  for (space::ContinuousSpace* space : continuous_spaces_) {
+    if (space->IsContinuousMemMapAllocSpace()) {
+      mem_maps.push_back(space->AsContinuousMemMapAllocSpace()->GetMemMap());
+    }
+  }
+  if (main_space_backup_ != nullptr) {
+    mem_maps.push_back(main_space_backup_->GetMemMap());
+  }
+  mem_maps.push_back(card_table_->GetMemMap());
+  *advised_bytes = 0;
+  *backed_bytes = 0;
+  for (const MemMap* mem_map : mem_maps) {
+    if (mem_map != nullptr && mem_map->UsesHugePages()) {
+      *advised_bytes += mem_map->GetHugePageAdvisedSize();
+      *backed_bytes += mem_map->GetHugePageBackedSize();
+    }
+  }
+}
+
 bool Heap::MayUseCollector(CollectorType type) const {
   return foreground_collector_type_ == type || background_collector_type_ == type;
 }
@@ -878,6 +986,30 @@ void Heap::DecrementDisableMovingGC(Thread* self) {
   --disable_moving_gc_count_;
 }
 
+bool Heap::IsInPinnableRegion(ObjPtr<mirror::Object> obj) const {
+  // Only the concurrent copying collector leaves the pinned regions in place.
+  return kUseReadBarrier &&
+      foreground_collector_type_ == kCollectorTypeCC &&
+      region_space_ != nullptr &&
+      region_space_->HasAddress(obj.Ptr());
+}
+
+bool Heap::PinObjectRegion(ObjPtr<mirror::Object> obj) {
+  if (!IsInPinnableRegion(obj)) {
+    return false;
+  }
+  region_space_->PinRegion(obj.Ptr());
+  return true;
+}
+
+bool Heap::UnpinObjectRegion(ObjPtr<mirror::Object> obj) {
+  if (!IsInPinnableRegion(obj)) {
+    return false;
+  }
+  region_space_->UnpinRegion(obj.Ptr());
+  return true;
+}
+
 void Heap::IncrementDisableThreadFlip(Thread* self) {
   // Supposed to be called by mutators. If thread_flip_running_ is true, block. Otherwise, go ahead.
   CHECK(kUseReadBarrier);
@@ -996,6 +1128,7 @@ void Heap::CreateThreadPool() {
   const size_t num_threads = std::max(parallel_gc_threads_, conc_gc_threads_);
   if (num_threads != 0) {
     thread_pool_.reset(new ThreadPool("Heap thread pool", num_threads));
+    thread_pool_->SetCpuAffinity(thread_pool_cpus_);
   }
 }
 
@@ -1140,6 +1273,8 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
   os << "Total GC time: " << PrettyDuration(GetGcTime()) << "\n";
   os << "Total blocking GC count: " << GetBlockingGcCount() << "\n";
   os << "Total blocking GC time: " << PrettyDuration(GetBlockingGcTime()) << "\n";
+  os << "Concurrent GCs started early by prediction: " << predicted_concurrent_gc_count_ << "\n";
+  os << "Blocking GCs avoided by prediction: " << GetBlockingGcAvoidedCount() << "\n";
 
   {
     MutexLock mu(Thread::Current(), *gc_complete_lock_);
@@ -1164,6 +1299,24 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
      << old_native_bytes_allocated_.LoadRelaxed() + new_native_bytes_allocated_.LoadRelaxed()
      << "\n";
 
+  if (use_huge_pages_) {
+    size_t advised_bytes;
+    size_t backed_bytes;
+    GetHugePageCoverage(&advised_bytes, &backed_bytes);
+    os << "Huge pages: " << PrettySize(backed_bytes) << " backed of "
+       << PrettySize(advised_bytes) << " advised";
+    if (advised_bytes != 0) {
+      os << " (" << backed_bytes * 100 / advised_bytes << "%)";
+    }
+    os << "\n";
+  }
+
+  if (thread_pool_ != nullptr) {
+    thread_pool_->DumpQueueingLatency(os);
+  }
+
+  reference_processor_->DumpPerformanceInfo(os);
+
   BaseMutex::DumpAll(os);
 }
 
@@ -1176,6 +1329,8 @@ void Heap::ResetGcPerformanceInfo() {
   total_wait_time_ = 0;
   blocking_gc_count_ = 0;
   blocking_gc_time_ = 0;
+  predicted_concurrent_gc_count_ = 0;
+  blocking_gc_avoided_count_ = 0;
   gc_count_last_window_ = 0;
   blocking_gc_count_last_window_ = 0;
   last_update_time_gc_count_rate_histograms_ =  // Round down by the window duration.
@@ -1185,6 +1340,7 @@ void Heap::ResetGcPerformanceInfo() {
     gc_count_rate_histogram_.Reset();
     blocking_gc_count_rate_histogram_.Reset();
   }
+  reference_processor_->ResetPerformanceInfo();
 }
 
 uint64_t Heap::GetGcCount() const {
@@ -1211,6 +1367,10 @@ uint64_t Heap::GetBlockingGcTime() const {
   return blocking_gc_time_;
 }
 
+uint64_t Heap::GetBlockingGcAvoidedCount() const {
+  return blocking_gc_avoided_count_;
+}
+
 void Heap::DumpGcCountRateHistogram(std::ostream& os) const {
   MutexLock mu(Thread::Current(), *gc_complete_lock_);
   if (gc_count_rate_histogram_.SampleSize() > 0U) {
@@ -1225,6 +1385,33 @@ void Heap::DumpBlockingGcCountRateHistogram(std::ostream& os) const {
   }
 }
 
+void Heap::DumpGcMetrics(std::ostream& os) const {
+  os << "art.gc.bytes_allocated " << GetBytesAllocatedEver() << "\n";
+  os << "art.gc.bytes_freed " << GetBytesFreedEver() << "\n";
+  os << "art.gc.allocation_rate_bytes_per_s " << metrics_allocation_rate_.LoadRelaxed()
+     << "\n";
+  os << "art.gc.promotion_rate_bytes_per_s " << promotion_rate_.LoadRelaxed() << "\n";
+  for (collector::GarbageCollector* collector : garbage_collectors_) {
+    std::string prefix = std::string("art.gc.") + collector->GetName();
+    std::replace(prefix.begin(), prefix.end(), ' ', '_');
+    collector->GetMetrics().Dump(prefix, os);
+  }
+}
+
+void Heap::UpdateGcMetricsRates(uint64_t bytes_promoted) {
+  const uint64_t now = NanoTime();
+  const uint64_t bytes_allocated = GetBytesAllocatedEver();
+  // Add 1ms to prevent possible division by 0.
+  const uint64_t interval_ms = NsToMs(now - last_gc_metrics_time_) + 1;
+  if (bytes_allocated > last_gc_metrics_bytes_allocated_) {
+    metrics_allocation_rate_.StoreRelaxed(
+        (bytes_allocated - last_gc_metrics_bytes_allocated_) * 1000 / interval_ms);
+  }
+  promotion_rate_.StoreRelaxed(bytes_promoted * 1000 / interval_ms);
+  last_gc_metrics_time_ = now;
+  last_gc_metrics_bytes_allocated_ = bytes_allocated;
+}
+
 ALWAYS_INLINE
 static inline AllocationListener* GetAndOverwriteAllocationListener(
     Atomic<AllocationListener*>* storage, AllocationListener* new_value) {
@@ -1378,7 +1565,11 @@ void Heap::DoPendingCollectorTransition() {
   }
 }
 
-void Heap::Trim(Thread* self) {
+bool Heap::Trim(Thread* self, uint64_t deadline_ns) {
+  // Release the pages of the managed spaces first, the rest is done once they are all released.
+  if (!TrimSpaces(self, deadline_ns)) {
+    return false;
+  }
   Runtime* const runtime = Runtime::Current();
   if (!CareAboutPauseTimes()) {
     // Deflate the monitors, this can cause a pause but shouldn't matter since we don't care
@@ -1391,11 +1582,21 @@ void Heap::Trim(Thread* self) {
     size_t count = runtime->GetMonitorList()->DeflateMonitors();
     VLOG(heap) << "Deflating " << count << " monitors took "
         << PrettyDuration(NanoTime() - start_time);
+  } else if (runtime->GetMonitorList()->ScanIdleMonitors() >= kMinIdleMonitorsToDeflate) {
+    // Only pause for the monitors that were not used since the previous trim. The contended
+    // monitors in use stay inflated, deflating them would only have them inflated again.
+    ScopedTrace trace("Deflating idle monitors");
+    ScopedGCCriticalSection gcs(self, kGcCauseTrim, kCollectorTypeHeapTrim);
+    ScopedSuspendAll ssa(__FUNCTION__);
+    uint64_t start_time = NanoTime();
+    size_t count = runtime->GetMonitorList()->DeflateIdleMonitors();
+    VLOG(heap) << "Deflating " << count << " idle monitors took "
+        << PrettyDuration(NanoTime() - start_time);
   }
   TrimIndirectReferenceTables(self);
-  TrimSpaces(self);
   // Trim arenas that may have been used by JIT or verifier.
   runtime->GetArenaPool()->TrimMaps();
+  return true;
 }
 
 class TrimIndirectReferenceTableClosure : public Closure {
@@ -1449,7 +1650,7 @@ void Heap::UnblockGC(Thread* self) {
   FinishGC(self, collector::kGcTypeNone);
 }
 
-void Heap::TrimSpaces(Thread* self) {
+bool Heap::TrimSpaces(Thread* self, uint64_t deadline_ns) {
   // Pretend we are doing a GC to prevent background compaction from deleting the space we are
   // trimming.
   StartGC(self, kGcCauseTrim, kCollectorTypeHeapTrim);
@@ -1459,17 +1660,45 @@ void Heap::TrimSpaces(Thread* self) {
   uint64_t total_alloc_space_allocated = 0;
   uint64_t total_alloc_space_size = 0;
   uint64_t managed_reclaimed = 0;
+  bool finished = true;
   {
     ScopedObjectAccess soa(self);
+    // Skip the spaces the previous slices of the trim finished. If the space to resume was
+    // deleted meanwhile, the trim is over.
+    gc::space::MallocSpace* resume_space = trim_resume_space_;
+    size_t resume_page_idx = trim_resume_page_idx_;
+    trim_resume_space_ = nullptr;
+    trim_resume_page_idx_ = 0;
     for (const auto& space : continuous_spaces_) {
-      if (space->IsMallocSpace()) {
-        gc::space::MallocSpace* malloc_space = space->AsMallocSpace();
-        if (malloc_space->IsRosAllocSpace() || !CareAboutPauseTimes()) {
-          // Don't trim dlmalloc spaces if we care about pauses since this can hold the space lock
-          // for a long period of time.
-          managed_reclaimed += malloc_space->Trim();
+      if (!space->IsMallocSpace()) {
+        continue;
+      }
+      gc::space::MallocSpace* malloc_space = space->AsMallocSpace();
+      total_alloc_space_size += malloc_space->Size();
+      if (!finished) {
+        continue;
+      }
+      if (resume_space != nullptr) {
+        if (malloc_space != resume_space) {
+          continue;
+        }
+        resume_space = nullptr;
+      } else {
+        resume_page_idx = 0;
+      }
+      if (malloc_space->IsRosAllocSpace()) {
+        size_t page_idx = resume_page_idx;
+        if (!malloc_space->AsRosAllocSpace()->TrimIncrementally(&page_idx,
+                                                                deadline_ns,
+                                                                &managed_reclaimed)) {
+          trim_resume_space_ = malloc_space;
+          trim_resume_page_idx_ = page_idx;
+          finished = false;
         }
-        total_alloc_space_size += malloc_space->Size();
+      } else if (!CareAboutPauseTimes()) {
+        // Don't trim dlmalloc spaces if we care about pauses since this can hold the space lock
+        // for a long period of time.
+        managed_reclaimed += malloc_space->Trim();
       }
     }
   }
@@ -1491,7 +1720,8 @@ void Heap::TrimSpaces(Thread* self) {
 
   VLOG(heap) << "Heap trim of managed (duration=" << PrettyDuration(gc_heap_end_ns - start_ns)
       << ", advised=" << PrettySize(managed_reclaimed) << ") heap. Managed heap utilization of "
-      << static_cast<int>(100 * managed_utilization) << "%.";
+      << static_cast<int>(100 * managed_utilization) << "%." << (finished ? "" : " To resume.");
+  return finished;
 }
 
 bool Heap::IsValidObjectAddress(const void* addr) const {
@@ -2333,6 +2563,9 @@ void Heap::ChangeCollector(CollectorType collector_type) {
     gc_plan_.clear();
     switch (collector_type_) {
       case kCollectorTypeCC: {
+        if (use_generational_cc_) {
+          gc_plan_.push_back(collector::kGcTypeSticky);
+        }
         gc_plan_.push_back(collector::kGcTypeFull);
         if (use_tlab_) {
           ChangeAllocator(kAllocatorTypeRegionTLAB);
@@ -2398,6 +2631,8 @@ class ZygoteCompactingCollector FINAL : public collector::SemiSpace {
       : SemiSpace(heap, false, "zygote collector", false, false),
         bin_live_bitmap_(nullptr),
         bin_mark_bitmap_(nullptr),
+        dirty_pos_(0u),
+        dirty_end_(0u),
         is_running_on_memory_tool_(is_running_on_memory_tool) {}
 
   void BuildBins(space::ContinuousSpace* space) REQUIRES_SHARED(Locks::mutator_lock_) {
@@ -2418,6 +2653,15 @@ class ZygoteCompactingCollector FINAL : public collector::SemiSpace {
     AddBin(reinterpret_cast<uintptr_t>(space->End()) - prev, prev);
   }
 
+  // Release the pages left unused in the bins and in the dirty region, the zygote space never
+  // allocates in them.
+  void ReleaseUnusedPages() {
+    for (const auto& bin : bins_) {
+      ReleasePages(bin.second, bin.second + bin.first);
+    }
+    ReleasePages(dirty_pos_, dirty_end_);
+  }
+
  private:
   // Maps from bin sizes to locations.
   std::multimap<size_t, uintptr_t> bins_;
@@ -2425,8 +2669,71 @@ class ZygoteCompactingCollector FINAL : public collector::SemiSpace {
   accounting::ContinuousSpaceBitmap* bin_live_bitmap_;
   // Mark bitmap of the space which contains the bins.
   accounting::ContinuousSpaceBitmap* bin_mark_bitmap_;
+  // Region at the start of the target space, ending on a page boundary, which receives the
+  // objects likely to be written after the fork. Keeping them off the pages of the other objects
+  // leaves these pages shared with the zygote.
+  uintptr_t dirty_pos_;
+  uintptr_t dirty_end_;
   const bool is_running_on_memory_tool_;
 
+  // Is obj likely to be written by the forked processes? Uses the heuristics of the image writer:
+  // the dex caches, the classes not yet initialized, and the classes with non-final statics.
+  static bool IsLikelyDirty(mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (obj->IsDexCache()) {
+      return true;
+    }
+    if (!obj->IsClass()) {
+      return false;
+    }
+    mirror::Class* klass = obj->AsClass();
+    if (!klass->IsInitialized()) {
+      return true;
+    }
+    for (uint32_t i = 0, num_static_fields = klass->NumStaticFields(); i != num_static_fields;
+         ++i) {
+      if (!klass->GetStaticField(i)->IsFinal()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static void ReleasePages(uintptr_t begin, uintptr_t end) {
+    uintptr_t page_begin = RoundUp(begin, kPageSize);
+    uintptr_t page_end = RoundDown(end, kPageSize);
+    if (page_begin < page_end) {
+      madvise(reinterpret_cast<void*>(page_begin), page_end - page_begin, MADV_DONTNEED);
+    }
+  }
+
+  virtual void MarkingPhase() OVERRIDE REQUIRES(Locks::mutator_lock_)
+      REQUIRES(!Locks::heap_bitmap_lock_) {
+    ReserveDirtyRegion();
+    SemiSpace::MarkingPhase();
+  }
+
+  // Reserve the dirty region, sized for the likely dirty objects of the from space, dead or alive.
+  void ReserveDirtyRegion() REQUIRES(Locks::mutator_lock_, !Locks::heap_bitmap_lock_) {
+    TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+    RevokeAllThreadLocalBuffers();
+    size_t dirty_bytes = 0u;
+    GetHeap()->VisitObjectsPaused([&](mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
+      if (from_space_->HasAddress(obj) && IsLikelyDirty(obj)) {
+        dirty_bytes += RoundUp(obj->SizeOf<kDefaultVerifyFlags>(), kObjectAlignment);
+      }
+    });
+    if (dirty_bytes == 0u) {
+      return;
+    }
+    uintptr_t begin = reinterpret_cast<uintptr_t>(to_space_->End());
+    size_t reserved_bytes = RoundUp(begin + dirty_bytes, kPageSize) - begin;
+    size_t bytes_allocated, dummy;
+    if (to_space_->Alloc(self_, reserved_bytes, &bytes_allocated, nullptr, &dummy) != nullptr) {
+      dirty_pos_ = begin;
+      dirty_end_ = begin + reserved_bytes;
+    }
+  }
+
   void AddBin(size_t size, uintptr_t position) {
     if (is_running_on_memory_tool_) {
       MEMORY_TOOL_MAKE_DEFINED(reinterpret_cast<void*>(position), size);
@@ -2447,9 +2754,15 @@ class ZygoteCompactingCollector FINAL : public collector::SemiSpace {
     size_t obj_size = obj->SizeOf<kDefaultVerifyFlags>();
     size_t alloc_size = RoundUp(obj_size, kObjectAlignment);
     mirror::Object* forward_address;
-    // Find the smallest bin which we can move obj in.
-    auto it = bins_.lower_bound(alloc_size);
-    if (it == bins_.end()) {
+    const bool is_dirty = dirty_end_ - dirty_pos_ >= alloc_size && IsLikelyDirty(obj);
+    // Find the smallest bin which we can move obj in, unless it goes to the dirty region.
+    auto it = is_dirty ? bins_.end() : bins_.lower_bound(alloc_size);
+    if (is_dirty) {
+      forward_address = reinterpret_cast<mirror::Object*>(dirty_pos_);
+      dirty_pos_ += alloc_size;
+      GetHeap()->GetNonMovingSpace()->GetLiveBitmap()->Set(forward_address);
+      GetHeap()->GetNonMovingSpace()->GetMarkBitmap()->Set(forward_address);
+    } else if (it == bins_.end()) {
       // No available space in the bins, place it in the target space instead (grows the zygote
       // space).
       size_t bytes_allocated, dummy;
@@ -2544,6 +2857,7 @@ void Heap::PreZygoteFork() {
     zygote_collector.SetToSpace(&target_space);
     zygote_collector.SetSwapSemiSpaces(false);
     zygote_collector.Run(kGcCauseCollectorTransition, false);
+    zygote_collector.ReleaseUnusedPages();
     if (reset_main_space) {
       main_space_->GetMemMap()->Protect(PROT_READ | PROT_WRITE);
       madvise(main_space_->Begin(), main_space_->Capacity(), MADV_DONTNEED);
@@ -2845,7 +3159,15 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type,
         }
         break;
       case kCollectorTypeCC:
-        collector = concurrent_copying_collector_;
+        // The read barriers only use the active collector while it is marking, it can be switched
+        // here since no other CC collection runs.
+        if (use_generational_cc_) {
+          active_concurrent_copying_collector_ =
+              (gc_type == collector::kGcTypeSticky && !clear_soft_references)
+                  ? young_concurrent_copying_collector_
+                  : concurrent_copying_collector_;
+        }
+        collector = active_concurrent_copying_collector_;
         break;
       case kCollectorTypeMC:
         mark_compact_collector_->SetSpace(bump_pointer_space_);
@@ -2854,7 +3176,8 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type,
       default:
         LOG(FATAL) << "Invalid collector type " << static_cast<size_t>(collector_type_);
     }
-    if (collector != mark_compact_collector_ && collector != concurrent_copying_collector_) {
+    if (collector != mark_compact_collector_ &&
+        collector != active_concurrent_copying_collector_) {
       temp_space_->GetMemMap()->Protect(PROT_READ | PROT_WRITE);
       if (kIsDebugBuild) {
         // Try to read each page of the memory map in case mprotect didn't work properly b/19894268.
@@ -2862,7 +3185,9 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type,
       }
       CHECK(temp_space_->IsEmpty());
     }
-    if (collector_type_ != kCollectorTypeGenCopying) {
+    // The young CC collections are sticky.
+    const bool young_cc = use_generational_cc_ && collector == young_concurrent_copying_collector_;
+    if (collector_type_ != kCollectorTypeGenCopying && !young_cc) {
       gc_type = collector::kGcTypeFull;  // TODO: Not hard code this in.
     }
   } else if (current_allocator_ == kAllocatorTypeRosAlloc ||
@@ -2893,6 +3218,7 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type,
   collector->Run(gc_cause, clear_soft_references || runtime->IsZygote());
   total_objects_freed_ever_ += GetCurrentGcIteration()->GetFreedObjects();
   total_bytes_freed_ever_ += GetCurrentGcIteration()->GetFreedBytes();
+  UpdateGcMetricsRates(GetCurrentGcIteration()->GetPromotedBytes());
   RequestTrim(self);
   // Enqueue cleared references.
   reference_processor_->EnqueueClearedReferences(self);
@@ -3800,8 +4126,72 @@ double Heap::HeapGrowthMultiplier() const {
   return foreground_heap_growth_multiplier_;
 }
 
+void Heap::UpdateConcurrentGcPrediction(uint64_t bytes_allocated_before_gc) {
+  const uint64_t now = NanoTime();
+  const uint64_t duration = current_gc_iteration_.GetDurationNs();
+  const uint64_t bytes_allocated = GetBytesAllocated();
+  // The semi-space and homogeneous compaction transitions do not measure the bytes before.
+  if (bytes_allocated_before_gc != 0u && last_gc_end_time_ns_ != 0u && duration <= now) {
+    const uint64_t gc_start_time = now - duration;
+    if (gc_start_time > last_gc_end_time_ns_ &&
+        bytes_allocated_before_gc > bytes_allocated_after_last_gc_) {
+      const double seconds = static_cast<double>(gc_start_time - last_gc_end_time_ns_) / 1e9;
+      const uint64_t rate =
+          static_cast<uint64_t>((bytes_allocated_before_gc - bytes_allocated_after_last_gc_) /
+                                seconds);
+      // Weigh the last period as much as all the previous ones, to follow the bursts.
+      allocation_rate_ = (allocation_rate_ == 0u) ? rate : (allocation_rate_ + rate) / 2u;
+    }
+  }
+  if (IsGcConcurrent() && current_gc_iteration_.GetGcCause() == kGcCauseBackground) {
+    concurrent_gc_duration_ns_ = (concurrent_gc_duration_ns_ == 0u)
+        ? duration
+        : (concurrent_gc_duration_ns_ + duration) / 2u;
+    const uint64_t freed_bytes = current_gc_iteration_.GetFreedBytes() +
+        current_gc_iteration_.GetFreedLargeObjectBytes() +
+        current_gc_iteration_.GetFreedRevokeBytes();
+    if (unpredicted_concurrent_start_bytes_ != 0u &&
+        bytes_allocated_before_gc != 0u &&
+        bytes_allocated + freed_bytes >= bytes_allocated_before_gc) {
+      // Had this GC started later, the allocations during it would have filled the heap.
+      const uint64_t bytes_allocated_during_gc =
+          bytes_allocated + freed_bytes - bytes_allocated_before_gc;
+      if (unpredicted_concurrent_start_bytes_ + bytes_allocated_during_gc > growth_limit_) {
+        ++blocking_gc_avoided_count_;
+      }
+    }
+  }
+  unpredicted_concurrent_start_bytes_ = 0u;
+  last_gc_end_time_ns_ = now;
+  bytes_allocated_after_last_gc_ = bytes_allocated;
+}
+
+void Heap::ApplyConcurrentGcPrediction(uint64_t bytes_allocated) {
+  if (!kUseConcurrentGcPrediction || allocation_rate_ == 0u || concurrent_gc_duration_ns_ == 0u) {
+    return;
+  }
+  const double predicted_bytes = static_cast<double>(allocation_rate_) *
+      (static_cast<double>(concurrent_gc_duration_ns_) / 1e9) * kConcurrentGcPredictionHeadroom;
+  const size_t predicted_start_bytes = (predicted_bytes >= growth_limit_)
+      ? 0u
+      : growth_limit_ - static_cast<size_t>(predicted_bytes);
+  if (predicted_start_bytes >= concurrent_start_bytes_) {
+    return;
+  }
+  // With no threshold from the heap growth, there is nothing to compare the early start with.
+  if (concurrent_start_bytes_ != std::numeric_limits<size_t>::max()) {
+    unpredicted_concurrent_start_bytes_ = concurrent_start_bytes_;
+  }
+  concurrent_start_bytes_ = std::max(predicted_start_bytes, static_cast<size_t>(bytes_allocated));
+  ++predicted_concurrent_gc_count_;
+  VLOG(heap) << "Predicted concurrent_start_bytes: " << concurrent_start_bytes_
+             << " allocation rate: " << PrettySize(allocation_rate_) << "/s"
+             << " concurrent GC duration: " << PrettyDuration(concurrent_gc_duration_ns_);
+}
+
 void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran,
                               uint64_t bytes_allocated_before_gc) {
+  UpdateConcurrentGcPrediction(bytes_allocated_before_gc);
   //Re-direct the call for GenCopying collector
   if (foreground_collector_type_ == kCollectorTypeGenCopying) {
     GrowForUtilizationGenCopying(collector_ran);
@@ -3830,6 +4220,10 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran,
     collector::GcType non_sticky_gc_type = NonStickyGcType();
     // Find what the next non sticky collector will be.
     collector::GarbageCollector* non_sticky_collector = FindCollectorByGcType(non_sticky_gc_type);
+    if (collector_type_ == kCollectorTypeCC) {
+      // The full CC collector runs for all the non sticky types.
+      non_sticky_collector = concurrent_copying_collector_;
+    }
     // If the throughput of the current sticky GC >= throughput of the non sticky collector, then
     // do another sticky collection next.
     // We also check that the bytes allocated aren't over the footprint limit in order to prevent a
@@ -3899,6 +4293,7 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran,
       } else {
         concurrent_start_bytes_ = comp_concurrent_start_bytes;
       }
+      ApplyConcurrentGcPrediction(bytes_allocated);
     }
   }
 }
@@ -3928,7 +4323,13 @@ void Heap::GrowForUtilizationGenCopying(collector::GarbageCollector* collector_r
     // If total bytes allocated is not excees the footprint,
     // Or promote space is enough, trigger Young as next GC.
     // And keep max_allowed_footprint, shrink only after the non-Young GC.
-    if (bytes_allocated <= max_allowed_footprint_) {
+    if (gen_copying_pause_goal_ms_ != 0) {
+      ResizeYoungSpacesForPauseGoal();
+    }
+    // With a pause goal, start the concurrent Partial/Full GC while the footprint still fits the
+    // promotions of the next Young GC, rather than fall back to a long stop-the-world one.
+    const uint64_t young_headroom = gen_copying_pause_goal_ms_ != 0 ? young_size_ : 0;
+    if (bytes_allocated + young_headroom <= max_allowed_footprint_) {
       next_gc_type_ = collector::kGcTypeYoung;
       target_size = max_allowed_footprint_;
       if (bytes_allocated == max_allowed_footprint_) {
@@ -3956,6 +4357,9 @@ void Heap::GrowForUtilizationGenCopying(collector::GarbageCollector* collector_r
     if (IsGcConcurrent()) {
       if (next_gc_type_ == collector::kGcTypeYoung) {
         concurrent_start_bytes_ = std::numeric_limits<size_t>::max();
+        // The young GCs start when the bump pointer space fills, unless the predicted
+        // allocations would reach the growth limit first.
+        ApplyConcurrentGcPrediction(bytes_allocated);
         VLOG(heap) << " next YoungGC concurrent_start_bytes: " << concurrent_start_bytes_
                    << " max_allowed_footprint_: " << max_allowed_footprint_
                    << " bytes_allocated: " << bytes_allocated;
@@ -3971,6 +4375,33 @@ void Heap::GrowForUtilizationGenCopying(collector::GarbageCollector* collector_r
   }
 }
 
+void Heap::ResizeYoungSpacesForPauseGoal() {
+  uint64_t pause_ns = 0;
+  for (uint64_t pause : current_gc_iteration_.GetPauseTimes()) {
+    pause_ns += pause;
+  }
+  if (pause_ns == 0 || young_size_ == 0) {
+    return;
+  }
+  const double pause_ms = static_cast<double>(pause_ns) / MsToNs(1);
+  // The copy rate includes the fixed costs of the pause, such as the roots and the cards.
+  const uint64_t bytes_copied = semi_space_collector_->GetBytesMoved();
+  const double copy_rate = bytes_copied / pause_ms;
+  // Assuming the same part of the young objects survives, the survivors of a young space of
+  // young_size * goal / pause bytes are copied within the goal.
+  double young_size = young_size_ * (gen_copying_pause_goal_ms_ / pause_ms);
+  young_size = std::min(young_size, young_size_ * kMaxYoungSizeChange);
+  young_size = std::max(young_size, young_size_ / kMaxYoungSizeChange);
+  const size_t old_young_size = young_size_;
+  young_size_ = std::min(std::max(static_cast<size_t>(young_size), kMinYoungSize),
+                         bump_space_capacity_);
+  young_size_ = RoundUp(young_size_, kPageSize);
+  bump_pointer_space_->SetGrowthLimit(young_size_);
+  temp_space_->SetGrowthLimit(young_size_);
+  VLOG(heap) << "Young pause " << pause_ms << "ms copied " << PrettySize(bytes_copied) << " at "
+             << PrettySize(static_cast<uint64_t>(copy_rate)) << "/ms, young size "
+             << PrettySize(old_young_size) << " -> " << PrettySize(young_size_);
+}
 
 void Heap::ClampGrowthLimit() {
   // Use heap bitmap lock to guard against races with BindLiveToMarkBitmap.
@@ -4130,8 +4561,11 @@ class Heap::HeapTrimTask : public HeapTask {
   explicit HeapTrimTask(uint64_t delta_time) : HeapTask(NanoTime() + delta_time) { }
   virtual void Run(Thread* self) OVERRIDE {
     gc::Heap* heap = Runtime::Current()->GetHeap();
-    heap->Trim(self);
-    heap->ClearPendingTrim(self);
+    if (heap->Trim(self, NanoTime() + kHeapTrimSliceDuration)) {
+      heap->ClearPendingTrim(self);
+    } else {
+      heap->ResumeTrim(self);
+    }
   }
 };
 
@@ -4140,6 +4574,21 @@ void Heap::ClearPendingTrim(Thread* self) {
   pending_heap_trim_ = nullptr;
 }
 
+void Heap::ResumeTrim(Thread* self) {
+  if (!CanAddHeapTask(self)) {
+    // The next trim resumes this one.
+    ClearPendingTrim(self);
+    return;
+  }
+  // Leave the CPU to the other threads for a while, and to the GCs the trim blocks.
+  HeapTrimTask* added_task = new HeapTrimTask(kHeapTrimSliceInterval);
+  {
+    MutexLock mu(self, *pending_task_lock_);
+    pending_heap_trim_ = added_task;
+  }
+  task_processor_->AddTask(self, added_task);
+}
+
 void Heap::RequestTrim(Thread* self) {
   if (!CanAddHeapTask(self)) {
     return;
@@ -4380,6 +4829,16 @@ void Heap::SweepAllocationRecords(IsMarkedVisitor* visitor) const {
   }
 }
 
+void Heap::SamplePretenureAllocation(Thread* self, ObjPtr<mirror::Class> klass, size_t bytes) {
+  pretenure_table_->SampleAllocation(self, klass.Ptr(), bytes);
+}
+
+void Heap::SweepPretenureTable(IsMarkedVisitor* visitor) {
+  if (pretenure_table_ != nullptr) {
+    pretenure_table_->Sweep(visitor);
+  }
+}
+
 void Heap::AllowNewAllocationRecords() const {
   CHECK(!kUseReadBarrier);
   MutexLock mu(Thread::Current(), *Locks::alloc_tracker_lock_);
@@ -4511,6 +4970,16 @@ void Heap::GCProfileEnableSuccAllocProfile(bool enable) {
   gc_profiler->EnableSuccAllocProfile(enable);
 }
 
+void Heap::GCProfileEnableStreaming(size_t file_size) {
+  GcProfiler *gc_profiler = GcProfiler::GetInstance();
+  gc_profiler->EnableStreaming(file_size);
+}
+
+void Heap::GCProfileSetAllocSampleInterval(size_t interval) {
+  GcProfiler *gc_profiler = GcProfiler::GetInstance();
+  gc_profiler->SetAllocSampleInterval(interval);
+}
+
 bool Heap::GCProfileRunning() {
   GcProfiler *gc_profiler = GcProfiler::GetInstance();
   return gc_profiler->IsRunning();
@@ -4611,14 +5080,13 @@ mirror::Object* Heap::AllocWithNewTLAB(Thread* self,
   } else {
     DCHECK(allocator_type == kAllocatorTypeRegionTLAB);
     DCHECK(region_space_ != nullptr);
-    if (space::RegionSpace::kRegionSize >= alloc_size) {
+    const size_t region_size = region_space_->GetRegionSize();
+    if (region_size >= alloc_size) {
       // Non-large. Check OOME for a tlab.
-      if (LIKELY(!IsOutOfMemoryOnAllocation(allocator_type,
-                                            space::RegionSpace::kRegionSize,
-                                            grow))) {
+      if (LIKELY(!IsOutOfMemoryOnAllocation(allocator_type, region_size, grow))) {
         const size_t new_tlab_size = kUsePartialTlabs
             ? std::max(alloc_size, kPartialTlabSize)
-            : gc::space::RegionSpace::kRegionSize;
+            : region_size;
         // Try to allocate a tlab.
         if (!region_space_->AllocNewTlab(self, new_tlab_size)) {
           // Failed to allocate a tlab. Try non-tlab.
@@ -18,6 +18,7 @@
 #define ART_RUNTIME_GC_HEAP_H_
 
 #include <iosfwd>
+#include <limits>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -61,6 +62,7 @@ namespace gc {
 
 class AllocationListener;
 class AllocRecordObjectMap;
+class PretenureTable;
 class GcPauseListener;
 class ReferenceProcessor;
 class TaskProcessor;
@@ -138,6 +140,10 @@ class Heap {
   static constexpr size_t kDefaultTLABAllocThreshold = kDefaultTLABSize / 2;
   static constexpr size_t kDefaultTenureThreshold = 6;
   static constexpr size_t kDefaultGSSBumpPointerSpaceCapacity = 32 * MB;
+  // The bounds of the region size of the CC region space, a power of two.
+  static constexpr size_t kDefaultRegionSize = 256 * KB;
+  static constexpr size_t kMaxRegionSize = 4 * MB;
+  static constexpr unsigned int kDefaultRegionEvacuateLivePercent = 75U;
   static constexpr double kDefaultTargetUtilization = 0.5;
   static constexpr double kDefaultHeapGrowthMultiplier = 2.0;
   // Primitive arrays larger than this size are put in the large object space.
@@ -158,6 +164,10 @@ class Heap {
 
   // How often we allow heap trimming to happen (nanoseconds).
   static constexpr uint64_t kHeapTrimWait = MsToNs(5000);
+  // How long a slice of a heap trim releases pages for, and how long it waits for the next slice
+  // (nanoseconds).
+  static constexpr uint64_t kHeapTrimSliceDuration = MsToNs(4);
+  static constexpr uint64_t kHeapTrimSliceInterval = MsToNs(20);
   // How long we wait after a transition request to perform a collector transition (nanoseconds).
   static constexpr uint64_t kCollectorTransitionWait = MsToNs(5000);
 
@@ -200,6 +210,11 @@ class Heap {
        size_t tlab_alloc_threshold,
        size_t tenure_threshold,
        size_t bump_space_capacity,
+       unsigned int gen_copying_pause_goal_ms,
+       bool use_generational_cc,
+       size_t region_size,
+       unsigned int region_evacuate_live_percent,
+       bool use_huge_pages,
        bool measure_gc_performance,
        bool use_homogeneous_space_compaction,
        uint64_t min_interval_homogeneous_space_compaction_by_oom,
@@ -328,6 +343,12 @@ class Heap {
   void IncrementDisableMovingGC(Thread* self) REQUIRES(!*gc_complete_lock_);
   void DecrementDisableMovingGC(Thread* self) REQUIRES(!*gc_complete_lock_);
 
+  // Pin the region of the concurrent copying collector holding obj, so that obj does not move
+  // until it is unpinned, for the JNI array accesses. Unlike disabling the thread flip, this does
+  // not hold back the collections. Returns false if obj is not in a region that can be pinned.
+  bool PinObjectRegion(ObjPtr<mirror::Object> obj) REQUIRES_SHARED(Locks::mutator_lock_);
+  bool UnpinObjectRegion(ObjPtr<mirror::Object> obj) REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Temporarily disable thread flip for JNI critical calls.
   void IncrementDisableThreadFlip(Thread* self) REQUIRES(!*thread_flip_lock_);
   void DecrementDisableThreadFlip(Thread* self) REQUIRES(!*thread_flip_lock_);
@@ -590,8 +611,10 @@ class Heap {
   // Do a pending collector transition.
   void DoPendingCollectorTransition() REQUIRES(!*gc_complete_lock_, !*pending_task_lock_);
 
-  // Deflate monitors, ... and trim the spaces.
-  void Trim(Thread* self) REQUIRES(!*gc_complete_lock_);
+  // Deflate monitors, ... and trim the spaces. Stops releasing the pages of the spaces once
+  // NanoTime() passes deadline_ns and returns false, the next call resumes the trim then.
+  bool Trim(Thread* self, uint64_t deadline_ns = std::numeric_limits<uint64_t>::max())
+      REQUIRES(!*gc_complete_lock_);
 
   void RevokeThreadLocalBuffers(Thread* thread, bool record_free = true)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -717,10 +740,17 @@ class Heap {
   void DumpGcPerformanceInfo(std::ostream& os)
       REQUIRES(!*gc_complete_lock_);
   void ResetGcPerformanceInfo() REQUIRES(!*gc_complete_lock_);
+  const std::vector<collector::GarbageCollector*>& GetGarbageCollectors() const {
+    return garbage_collectors_;
+  }
 
   // Thread pool.
   void CreateThreadPool();
   void DeleteThreadPool();
+  // Restrict the threads of the pool created by CreateThreadPool to the given CPUs.
+  void SetThreadPoolCpus(const std::vector<uint32_t>& cpus) {
+    thread_pool_cpus_ = cpus;
+  }
   ThreadPool* GetThreadPool() {
     return thread_pool_.get();
   }
@@ -730,6 +760,14 @@ class Heap {
   size_t GetConcGCThreadCount() const {
     return conc_gc_threads_;
   }
+  unsigned int GetRegionEvacuateLivePercent() const {
+    return region_evacuate_live_percent_;
+  }
+
+  // The bytes of the heap spaces and the card table advised to be backed by huge pages, with
+  // -XX:UseHugePages, and how many of them the kernel backs by huge pages. This is slow. No lock
+  // since the spaces backed by huge pages are created along with the heap.
+  void GetHugePageCoverage(size_t* advised_bytes, size_t* backed_bytes) NO_THREAD_SAFETY_ANALYSIS;
 
   accounting::ModUnionTable* FindModUnionTableFromSpace(space::Space* space);
   void AddModUnionTable(accounting::ModUnionTable* mod_union_table);
@@ -755,8 +793,10 @@ class Heap {
     return zygote_space_ != nullptr;
   }
 
+  // The collector of the current or the last CC collection, which is the young one or the full one
+  // with -XX:GenerationalCC.
   collector::ConcurrentCopying* ConcurrentCopyingCollector() {
-    return concurrent_copying_collector_;
+    return active_concurrent_copying_collector_;
   }
 
   CollectorType CurrentCollectorType() {
@@ -801,8 +841,12 @@ class Heap {
   uint64_t GetGcTime() const;
   uint64_t GetBlockingGcCount() const;
   uint64_t GetBlockingGcTime() const;
+  uint64_t GetBlockingGcAvoidedCount() const;
   void DumpGcCountRateHistogram(std::ostream& os) const REQUIRES(!*gc_complete_lock_);
   void DumpBlockingGcCountRateHistogram(std::ostream& os) const REQUIRES(!*gc_complete_lock_);
+  // Write the metrics of the GCs run so far as "<name> <value>" lines, for the monitoring tools
+  // polling them. Takes no lock: a GC finishing meanwhile may show in some of the values only.
+  void DumpGcMetrics(std::ostream& os) const;
 
   // Allocation tracking support
   // Callers to this function use double-checked locking to ensure safety on allocation_records_
@@ -830,6 +874,18 @@ class Heap {
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!Locks::alloc_tracker_lock_);
 
+  // The survival of the instances of each class, only kept by the GenCopying collector.
+  PretenureTable* GetPretenureTable() const {
+    return pretenure_table_.get();
+  }
+
+  // Account the bytes of a thread-local buffer refilled to allocate an instance of klass.
+  void SamplePretenureAllocation(Thread* self, ObjPtr<mirror::Class> klass, size_t bytes)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void SweepPretenureTable(IsMarkedVisitor* visitor)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   void DisallowNewAllocationRecords() const
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!Locks::alloc_tracker_lock_);
@@ -849,10 +905,18 @@ class Heap {
 
   size_t GetThresholdAge();
   void SetThresholdAge(size_t age);
+  // The threshold age given by -XX:TenureThreshold, which the collectors adapt the
+  // threshold age under.
+  size_t GetMaxThresholdAge() const {
+    return max_threshold_age_;
+  }
   void GCProfileSetDir(const std::string& dir);
   void GCProfileStart();
   void GCProfileEnd(bool drop_result);
   void GCProfileEnableSuccAllocProfile(bool enable);
+  void GCProfileEnableStreaming(size_t file_size);
+  // Sample the allocation sites every interval bytes allocated by a thread, 0 to disable.
+  void GCProfileSetAllocSampleInterval(size_t interval);
   bool GCProfileRunning();
 
   void BlockGC(Thread* self, GcCause cause, CollectorType collector_type)
@@ -897,6 +961,8 @@ class Heap {
 
 
   void LogGC(GcCause gc_cause, collector::GarbageCollector* collector);
+  // Update the allocation and promotion rates of the GC metrics at the end of a GC.
+  void UpdateGcMetricsRates(uint64_t bytes_promoted);
   void StartGC(Thread* self, GcCause cause, CollectorType collector_type)
       REQUIRES(!*gc_complete_lock_);
   void FinishGC(Thread* self, collector::GcType gc_type) REQUIRES(!*gc_complete_lock_);
@@ -906,6 +972,9 @@ class Heap {
   static MemMap* MapAnonymousPreferredAddress(const char* name, uint8_t* request_begin,
                                               size_t capacity, std::string* out_error_str);
 
+  // Advise the kernel to back the mem map of a space by huge pages, with -XX:UseHugePages.
+  void AdviseHugePages(MemMap* mem_map);
+
   bool SupportHSpaceCompaction() const {
     // Returns true if we can do hspace compaction
     return main_space_backup_ != nullptr;
@@ -938,6 +1007,9 @@ class Heap {
         collector_type == kCollectorTypeHomogeneousSpaceCompact ||
         collector_type == kCollectorTypeGenCopying;
   }
+  // Is obj in a region that PinObjectRegion() can pin?
+  bool IsInPinnableRegion(ObjPtr<mirror::Object> obj) const
+      REQUIRES_SHARED(Locks::mutator_lock_);
   bool ShouldAllocLargeObject(ObjPtr<mirror::Class> c, size_t byte_count) const
       REQUIRES_SHARED(Locks::mutator_lock_);
   ALWAYS_INLINE void CheckConcurrentGC(Thread* self,
@@ -1070,6 +1142,14 @@ class Heap {
                                                   bool can_move_objects);
 
   void GrowForUtilizationGenCopying(collector::GarbageCollector* collector_ran);
+  // Resize the bump pointer spaces after a young collection, so that the next one copies its
+  // survivors within the pause goal at the copy rate measured.
+  void ResizeYoungSpacesForPauseGoal();
+  // Measure the allocation rate and the concurrent GC duration after a GC cycle.
+  void UpdateConcurrentGcPrediction(uint64_t bytes_allocated_before_gc);
+  // Start the next concurrent GC earlier than concurrent_start_bytes_ if, at the measured
+  // allocation rate, the heap would reach the growth limit before the cycle finishes.
+  void ApplyConcurrentGcPrediction(uint64_t bytes_allocated);
   // Given the current contents of the alloc space, increase the allowed heap footprint to match
   // the target utilization ratio.  This should only be called immediately after a full garbage
   // collection. bytes_allocated_before_gc is used to measure bytes / second for the period which
@@ -1115,8 +1195,11 @@ class Heap {
         collector_type_ == kCollectorTypeGenCopying;
   }
 
-  // Trim the managed and native spaces by releasing unused memory back to the OS.
-  void TrimSpaces(Thread* self) REQUIRES(!*gc_complete_lock_);
+  // Trim the managed and native spaces by releasing unused memory back to the OS. Returns false
+  // if the deadline passed before the trim finished.
+  bool TrimSpaces(Thread* self, uint64_t deadline_ns) REQUIRES(!*gc_complete_lock_);
+  // Schedule the next slice of a heap trim.
+  void ResumeTrim(Thread* self) REQUIRES(!*pending_task_lock_);
 
   // Trim 0 pages at the end of reference tables.
   void TrimIndirectReferenceTables(Thread* self);
@@ -1390,10 +1473,26 @@ class Heap {
 
   // Parallel GC data structures.
   std::unique_ptr<ThreadPool> thread_pool_;
+  // The CPUs the threads of thread_pool_ may run on, all of them if empty.
+  std::vector<uint32_t> thread_pool_cpus_;
 
   // Estimated allocation rate (bytes / second). Computed between the time of the last GC cycle
-  // and the start of the current one.
+  // and the start of the current one, and smoothed over the cycles.
   uint64_t allocation_rate_;
+  // Duration of the concurrent GC cycles, smoothed over the cycles.
+  uint64_t concurrent_gc_duration_ns_;
+  // When the last GC cycle finished and how many bytes were allocated then, to measure
+  // allocation_rate_.
+  uint64_t last_gc_end_time_ns_;
+  uint64_t bytes_allocated_after_last_gc_;
+  // The concurrent_start_bytes_ computed from the heap growth alone, when the predicted
+  // allocations of the next concurrent GC cycle made it start earlier. Zero otherwise.
+  size_t unpredicted_concurrent_start_bytes_;
+  // How many times the prediction made the next concurrent GC start earlier.
+  uint64_t predicted_concurrent_gc_count_;
+  // How many of these concurrent GCs would have made an allocation block on the growth limit,
+  // had they started from the heap growth alone.
+  uint64_t blocking_gc_avoided_count_;
 
   // For a GC cycle, a bitmap that is set corresponding to the
   std::unique_ptr<accounting::HeapBitmap> live_bitmap_ GUARDED_BY(Locks::heap_bitmap_lock_);
@@ -1455,6 +1554,12 @@ class Heap {
   // Bump Pointer Space Capacity.
   size_t bump_space_capacity_;
 
+  // The young pause time given by -XX:GenCopyingPauseGoalMs, or 0 to size the young spaces by
+  // their capacity.
+  const unsigned int gen_copying_pause_goal_ms_;
+  // The growth limit of the bump pointer spaces, with a pause goal.
+  size_t young_size_;
+
   // Accumulative count increase on both begin and finish of a moving gc
   // if it is odd, means a moving gc is going on.
   Atomic<size_t> moving_gc_count_;
@@ -1463,6 +1568,17 @@ class Heap {
   collector::SemiSpace* semi_space_collector_;
   collector::MarkCompact* mark_compact_collector_;
   collector::ConcurrentCopying* concurrent_copying_collector_;
+  // The collector of the sticky CC collections, with -XX:GenerationalCC.
+  collector::ConcurrentCopying* young_concurrent_copying_collector_;
+  collector::ConcurrentCopying* active_concurrent_copying_collector_;
+  // Whether the CC collections are generational, which requires the Baker read barrier.
+  const bool use_generational_cc_;
+  // The CC collections evacuate the regions whose live percentage is below this, given by
+  // -XX:RegionEvacuateLivePercent.
+  const unsigned int region_evacuate_live_percent_;
+  // Whether the heap spaces and the card table are backed by transparent huge pages, given by
+  // -XX:UseHugePages.
+  const bool use_huge_pages_;
 
   const bool is_running_on_memory_tool_;
   const bool use_tlab_;
@@ -1495,10 +1611,15 @@ class Heap {
   // Active tasks which we can modify (change target time, desired collector type, etc..).
   CollectorTransitionTask* pending_collector_transition_ GUARDED_BY(pending_task_lock_);
   HeapTrimTask* pending_heap_trim_ GUARDED_BY(pending_task_lock_);
+  // Where the trim stopped by its deadline resumes: the space, or null if there is none, and the
+  // page map index. Only used by TrimSpaces() while it blocks the GCs.
+  space::MallocSpace* trim_resume_space_;
+  size_t trim_resume_page_idx_;
 
   // Threshold for promoting old enough objects to old generation space.
   // This is for Generational Copying collector.
   Atomic<size_t> threshold_age_;
+  size_t max_threshold_age_;
   // Whether or not we use homogeneous space compaction to avoid OOM errors.
   bool use_homogeneous_space_compaction_for_oom_;
 
@@ -1523,11 +1644,21 @@ class Heap {
   Histogram<uint64_t> gc_count_rate_histogram_ GUARDED_BY(gc_complete_lock_);
   // The histogram of the number of blocking GC invocations per window duration.
   Histogram<uint64_t> blocking_gc_count_rate_histogram_ GUARDED_BY(gc_complete_lock_);
+  // The end of the last GC and the bytes allocated ever then, for the rates of the GC metrics.
+  uint64_t last_gc_metrics_time_;
+  uint64_t last_gc_metrics_bytes_allocated_;
+  // The bytes allocated and promoted per second between the ends of the last two GCs. The
+  // allocation rate of the concurrent GC prediction, allocation_rate_, is an average instead.
+  Atomic<uint64_t> metrics_allocation_rate_;
+  Atomic<uint64_t> promotion_rate_;
 
   // Allocation tracking support
   Atomic<bool> alloc_tracking_enabled_;
   std::unique_ptr<AllocRecordObjectMap> allocation_records_;
 
+  // The classes whose instances get allocated in the old generation, null if not generational.
+  std::unique_ptr<PretenureTable> pretenure_table_;
+
   // GC stress related data structures.
   Mutex* backtrace_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   // Debugging variables, seen backtraces vs unique backtraces.
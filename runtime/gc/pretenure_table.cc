@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pretenure_table.h"
+
+#include "base/logging.h"
+#include "mirror/class-inl.h"
+#include "object_callbacks.h"
+#include "thread-inl.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+
+PretenureTable::PretenureTable() : lock_("Pretenure table lock", kPretenureTableLock) {}
+
+// Only the classes of a fixed size are pretenured, as the fast paths of the allocation of the
+// arrays and strings do not look at their class.
+static bool CanPretenure(mirror::Class* klass) REQUIRES_SHARED(Locks::mutator_lock_) {
+  return !klass->IsVariableSize<kVerifyNone, kWithoutReadBarrier>() && !klass->IsPretenured();
+}
+
+void PretenureTable::SampleAllocation(Thread* self, mirror::Class* klass, size_t bytes) {
+  if (!CanPretenure(klass)) {
+    return;
+  }
+  MutexLock mu(self, lock_);
+  ClassSurvival& survival = classes_[klass];
+  survival.allocated_bytes += bytes;
+}
+
+void PretenureTable::RecordPromotion(mirror::Class* klass, size_t bytes) {
+  if (!CanPretenure(klass)) {
+    return;
+  }
+  MutexLock mu(Thread::Current(), lock_);
+  auto it = classes_.find(klass);
+  if (it == classes_.end()) {
+    // Allocated before the table was swept of its class the last time, or never sampled.
+    return;
+  }
+  ClassSurvival& survival = it->second;
+  survival.promoted_bytes += bytes;
+  if (survival.allocated_bytes >= kMinAllocatedBytes &&
+      survival.promoted_bytes >= survival.allocated_bytes / 100 * kPretenurePercent) {
+    VLOG(heap) << "Pretenuring " << klass->PrettyDescriptor() << ": "
+               << PrettySize(survival.promoted_bytes) << " promoted out of about "
+               << PrettySize(survival.allocated_bytes) << " allocated";
+    klass->SetPretenured();
+    classes_.erase(it);
+  }
+}
+
+void PretenureTable::Sweep(IsMarkedVisitor* visitor) {
+  MutexLock mu(Thread::Current(), lock_);
+  std::unordered_map<mirror::Class*, ClassSurvival> swept;
+  for (const auto& pair : classes_) {
+    mirror::Object* klass = visitor->IsMarked(pair.first);
+    if (klass != nullptr) {
+      swept.emplace(klass->AsClass<kVerifyNone, kWithoutReadBarrier>(), pair.second);
+    }
+  }
+  classes_.swap(swept);
+}
+
+}  // namespace gc
+}  // namespace art
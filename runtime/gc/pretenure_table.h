@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_PRETENURE_TABLE_H_
+#define ART_RUNTIME_GC_PRETENURE_TABLE_H_
+
+#include <stdint.h>
+
+#include <unordered_map>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+
+namespace art {
+
+class IsMarkedVisitor;
+class Thread;
+
+namespace mirror {
+class Class;
+}  // namespace mirror
+
+namespace gc {
+
+// The survival of the instances of each class under the generational semi-space collector. The
+// classes whose instances mostly live until they are promoted because of their age are flagged
+// as pretenured: their instances are then allocated in the old generation directly, instead of
+// being copied there over several young collections. The classes are weak, swept by every GC.
+class PretenureTable {
+ public:
+  // The bytes promoted out of the bytes allocated that get a class pretenured.
+  static constexpr size_t kPretenurePercent = 70;
+  // The class needs about this many bytes allocated before its promotions are looked at.
+  static constexpr uint64_t kMinAllocatedBytes = 4 * MB;
+
+  PretenureTable();
+
+  // Account bytes allocated by the allocation of an instance of klass. Only the allocations which
+  // refill a thread-local buffer come here, accounting the whole buffer to their class: a class
+  // gets its share of the bytes allocated, give or take.
+  void SampleAllocation(Thread* self, mirror::Class* klass, size_t bytes)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!lock_);
+
+  // Account bytes of instances of klass promoted because of their age, in a GC pause. Flag klass
+  // as pretenured once enough of its bytes get promoted.
+  void RecordPromotion(mirror::Class* klass, size_t bytes)
+      REQUIRES(Locks::mutator_lock_)
+      REQUIRES(!lock_);
+
+  void Sweep(IsMarkedVisitor* visitor) REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!lock_);
+
+ private:
+  struct ClassSurvival {
+    uint64_t allocated_bytes;
+    uint64_t promoted_bytes;
+  };
+
+  Mutex lock_;
+  std::unordered_map<mirror::Class*, ClassSurvival> classes_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(PretenureTable);
+};
+
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_PRETENURE_TABLE_H_
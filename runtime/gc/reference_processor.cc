@@ -16,8 +16,11 @@
 
 #include "reference_processor.h"
 
+#include <sstream>
+
 #include "base/time_utils.h"
 #include "collector/garbage_collector.h"
+#include "heap.h"
 #include "java_vm_ext.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
@@ -28,6 +31,7 @@
 #include "reflection.h"
 #include "scoped_thread_state_change-inl.h"
 #include "task_processor.h"
+#include "thread_pool.h"
 #include "utils.h"
 #include "well_known_classes.h"
 
@@ -124,6 +128,37 @@ void ReferenceProcessor::StopPreservingReferences(Thread* self) {
   condition_.Broadcast(self);
 }
 
+const char* ReferenceProcessor::GetQueueKindName(QueueKind kind) {
+  switch (kind) {
+    case kSoftReferences: return "soft";
+    case kWeakReferences: return "weak";
+    case kFinalizerReferences: return "finalizer";
+    case kPhantomReferences: return "phantom";
+    case kNumQueueKinds: break;
+  }
+  LOG(FATAL) << "Unexpected queue kind " << static_cast<int>(kind);
+  UNREACHABLE();
+}
+
+size_t ReferenceProcessor::GetThreadCount(bool concurrent) {
+  Heap* heap = Runtime::Current()->GetHeap();
+  // Use the calling thread only in a background state, like the parallel marking does.
+  if (heap->GetThreadPool() == nullptr || !Runtime::Current()->InJankPerceptibleProcessState()) {
+    return 1;
+  }
+  return (concurrent ? heap->GetConcGCThreadCount() : heap->GetParallelGCThreadCount()) + 1;
+}
+
+void ReferenceProcessor::ClearWhiteReferences(ReferenceQueue* queue,
+                                              collector::GarbageCollector* collector,
+                                              size_t thread_count,
+                                              QueueStats* stats) {
+  const uint64_t start_time = NanoTime();
+  ReferenceCounts counts = queue->ClearWhiteReferences(&cleared_references_, collector,
+                                                       thread_count);
+  stats->Add(counts, NanoTime() - start_time);
+}
+
 // Process reference class instances and schedule finalizations.
 void ReferenceProcessor::ProcessReferences(bool concurrent,
                                            TimingLogger* timings,
@@ -149,6 +184,10 @@ void ReferenceProcessor::ProcessReferences(bool concurrent,
     DCHECK(finalizer_reference_queue_.IsEmpty());
     DCHECK(phantom_reference_queue_.IsEmpty());
   }
+  // The order of the processing of the queues stays the same, only the references of a queue are
+  // cleared in parallel.
+  const size_t thread_count = GetThreadCount(concurrent);
+  QueueStats stats[kNumQueueKinds];
   // Unless required to clear soft references with white references, preserve some white referents.
   if (!clear_soft_references) {
     TimingLogger::ScopedTiming split(concurrent ? "ForwardSoftReferences" :
@@ -165,8 +204,14 @@ void ReferenceProcessor::ProcessReferences(bool concurrent,
     }
   }
   // Clear all remaining soft and weak references with white referents.
-  soft_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
-  weak_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  {
+    TimingLogger::ScopedTiming t2(concurrent ? "ClearWhiteReferences" :
+        "(Paused)ClearWhiteReferences", timings);
+    ClearWhiteReferences(&soft_reference_queue_, collector, thread_count,
+                         &stats[kSoftReferences]);
+    ClearWhiteReferences(&weak_reference_queue_, collector, thread_count,
+                         &stats[kWeakReferences]);
+  }
   {
     TimingLogger::ScopedTiming t2(concurrent ? "EnqueueFinalizerReferences" :
         "(Paused)EnqueueFinalizerReferences", timings);
@@ -174,17 +219,27 @@ void ReferenceProcessor::ProcessReferences(bool concurrent,
       StartPreservingReferences(self);
     }
     // Preserve all white objects with finalize methods and schedule them for finalization.
-    finalizer_reference_queue_.EnqueueFinalizerReferences(&cleared_references_, collector);
+    const uint64_t start_time = NanoTime();
+    ReferenceCounts counts =
+        finalizer_reference_queue_.EnqueueFinalizerReferences(&cleared_references_, collector);
+    stats[kFinalizerReferences].Add(counts, NanoTime() - start_time);
     collector->ProcessMarkStack();
     if (concurrent) {
       StopPreservingReferences(self);
     }
   }
-  // Clear all finalizer referent reachable soft and weak references with white referents.
-  soft_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
-  weak_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
-  // Clear all phantom references with white referents.
-  phantom_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  {
+    TimingLogger::ScopedTiming t2(concurrent ? "ClearFinalizerReachableReferences" :
+        "(Paused)ClearFinalizerReachableReferences", timings);
+    // Clear all finalizer referent reachable soft and weak references with white referents.
+    ClearWhiteReferences(&soft_reference_queue_, collector, thread_count,
+                         &stats[kSoftReferences]);
+    ClearWhiteReferences(&weak_reference_queue_, collector, thread_count,
+                         &stats[kWeakReferences]);
+    // Clear all phantom references with white referents.
+    ClearWhiteReferences(&phantom_reference_queue_, collector, thread_count,
+                         &stats[kPhantomReferences]);
+  }
   // At this point all reference queues other than the cleared references should be empty.
   DCHECK(soft_reference_queue_.IsEmpty());
   DCHECK(weak_reference_queue_.IsEmpty());
@@ -201,6 +256,36 @@ void ReferenceProcessor::ProcessReferences(bool concurrent,
       // Done processing, disable the slow path and broadcast to the waiters.
       DisableSlowPath(self);
     }
+    for (size_t i = 0; i < kNumQueueKinds; ++i) {
+      cumulative_stats_[i].processed += stats[i].processed;
+      cumulative_stats_[i].cleared += stats[i].cleared;
+      cumulative_stats_[i].time_ns += stats[i].time_ns;
+    }
+  }
+  if (VLOG_IS_ON(gc)) {
+    std::ostringstream oss;
+    for (size_t i = 0; i < kNumQueueKinds; ++i) {
+      oss << " " << GetQueueKindName(static_cast<QueueKind>(i)) << " " << stats[i].processed
+          << " (" << stats[i].cleared << " cleared) " << PrettyDuration(stats[i].time_ns);
+    }
+    LOG(INFO) << "Processed references with " << thread_count << " threads:" << oss.str();
+  }
+}
+
+void ReferenceProcessor::DumpPerformanceInfo(std::ostream& os) {
+  MutexLock mu(Thread::Current(), *Locks::reference_processor_lock_);
+  for (size_t i = 0; i < kNumQueueKinds; ++i) {
+    const QueueStats& stats = cumulative_stats_[i];
+    os << "Processed " << GetQueueKindName(static_cast<QueueKind>(i)) << " references: "
+       << stats.processed << ", cleared: " << stats.cleared
+       << ", time: " << PrettyDuration(stats.time_ns) << "\n";
+  }
+}
+
+void ReferenceProcessor::ResetPerformanceInfo() {
+  MutexLock mu(Thread::Current(), *Locks::reference_processor_lock_);
+  for (size_t i = 0; i < kNumQueueKinds; ++i) {
+    cumulative_stats_[i] = QueueStats();
   }
 }
 
@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_GC_REFERENCE_PROCESSOR_H_
 #define ART_RUNTIME_GC_REFERENCE_PROCESSOR_H_
 
+#include <iosfwd>
+
 #include "base/mutex.h"
 #include "globals.h"
 #include "jni.h"
@@ -76,8 +78,38 @@ class ReferenceProcessor {
   void ClearReferent(ObjPtr<mirror::Reference> ref)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!Locks::reference_processor_lock_);
+  // Dump the cumulative counts and times of the processing of each reference queue.
+  void DumpPerformanceInfo(std::ostream& os) REQUIRES(!Locks::reference_processor_lock_);
+  void ResetPerformanceInfo() REQUIRES(!Locks::reference_processor_lock_);
 
  private:
+  enum QueueKind {
+    kSoftReferences,
+    kWeakReferences,
+    kFinalizerReferences,
+    kPhantomReferences,
+    kNumQueueKinds,
+  };
+  // The references a queue had and the ones cleared, and the time spent processing them.
+  struct QueueStats {
+    uint64_t processed = 0;
+    uint64_t cleared = 0;
+    uint64_t time_ns = 0;
+
+    void Add(const ReferenceCounts& counts, uint64_t duration_ns) {
+      processed += counts.processed;
+      cleared += counts.cleared;
+      time_ns += duration_ns;
+    }
+  };
+  static const char* GetQueueKindName(QueueKind kind);
+  // The number of threads that clear the white references, the calling thread included.
+  static size_t GetThreadCount(bool concurrent);
+  void ClearWhiteReferences(ReferenceQueue* queue,
+                            collector::GarbageCollector* collector,
+                            size_t thread_count,
+                            QueueStats* stats)
+      REQUIRES_SHARED(Locks::mutator_lock_);
   bool SlowPathEnabled() REQUIRES_SHARED(Locks::mutator_lock_);
   // Called by ProcessReferences.
   void DisableSlowPath(Thread* self) REQUIRES(Locks::reference_processor_lock_)
@@ -106,6 +138,8 @@ class ReferenceProcessor {
   ReferenceQueue finalizer_reference_queue_;
   ReferenceQueue phantom_reference_queue_;
   ReferenceQueue cleared_references_;
+  // Cumulative for all the GCs, reported with the GC performance info.
+  QueueStats cumulative_stats_[kNumQueueKinds] GUARDED_BY(Locks::reference_processor_lock_);
 
   DISALLOW_COPY_AND_ASSIGN(ReferenceProcessor);
 };
@@ -16,6 +16,10 @@
 
 #include "reference_queue.h"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "accounting/card_table-inl.h"
 #include "collector/concurrent_copying.h"
 #include "heap.h"
@@ -23,6 +27,7 @@
 #include "mirror/object-inl.h"
 #include "mirror/reference-inl.h"
 #include "object_callbacks.h"
+#include "thread_pool.h"
 
 namespace art {
 namespace gc {
@@ -55,6 +60,24 @@ void ReferenceQueue::EnqueueReference(ObjPtr<mirror::Reference> ref) {
   list_->SetPendingNext(ref);
 }
 
+void ReferenceQueue::EnqueueReferences(ReferenceQueue* other) {
+  if (other->IsEmpty()) {
+    return;
+  }
+  if (IsEmpty()) {
+    list_ = other->list_;
+  } else {
+    // Join the two cycles by exchanging the references that follow their list_.
+    ObjPtr<mirror::Reference> head = list_->GetPendingNext<kWithoutReadBarrier>();
+    ObjPtr<mirror::Reference> other_head = other->list_->GetPendingNext<kWithoutReadBarrier>();
+    DCHECK(head != nullptr);
+    DCHECK(other_head != nullptr);
+    list_->SetPendingNext(other_head);
+    other->list_->SetPendingNext(head);
+  }
+  other->list_ = nullptr;
+}
+
 ObjPtr<mirror::Reference> ReferenceQueue::DequeuePendingReference() {
   DCHECK(!IsEmpty());
   ObjPtr<mirror::Reference> ref = list_->GetPendingNext<kWithoutReadBarrier>();
@@ -129,32 +152,121 @@ size_t ReferenceQueue::GetLength() const {
   return count;
 }
 
-void ReferenceQueue::ClearWhiteReferences(ReferenceQueue* cleared_references,
-                                          collector::GarbageCollector* collector) {
+bool ReferenceQueue::ClearWhiteReference(ObjPtr<mirror::Reference> ref,
+                                         ReferenceQueue* cleared_references,
+                                         collector::GarbageCollector* collector) {
+  bool cleared = false;
+  mirror::HeapReference<mirror::Object>* referent_addr = ref->GetReferentReferenceAddr();
+  // do_atomic_update is false because this happens during the reference processing phase where
+  // Reference.clear() would block.
+  if (!collector->IsNullOrMarkedHeapReference(referent_addr, /*do_atomic_update*/false)) {
+    // Referent is white, clear it.
+    if (Runtime::Current()->IsActiveTransaction()) {
+      ref->ClearReferent<true>();
+    } else {
+      ref->ClearReferent<false>();
+    }
+    cleared_references->EnqueueReference(ref);
+    cleared = true;
+  }
+  // Delay disabling the read barrier until here so that the ClearReferent call above in
+  // transaction mode will trigger the read barrier.
+  DisableReadBarrierForReference(ref);
+  return cleared;
+}
+
+// Clears the white referents of a chunk of the references taken from a queue, gathering the
+// cleared references into its own queue.
+class ReferenceQueue::ClearWhiteReferencesTask : public Task {
+ public:
+  ClearWhiteReferencesTask(collector::GarbageCollector* collector,
+                           mirror::Reference* const* begin,
+                           mirror::Reference* const* end)
+      : collector_(collector), begin_(begin), end_(end), cleared_references_(nullptr) {}
+
+  void Run(Thread* self ATTRIBUTE_UNUSED) OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    for (mirror::Reference* const* it = begin_; it != end_; ++it) {
+      if (ClearWhiteReference(*it, &cleared_references_, collector_)) {
+        ++num_cleared_;
+      }
+    }
+  }
+
+  ReferenceQueue* GetClearedReferences() {
+    return &cleared_references_;
+  }
+
+  size_t GetNumCleared() const {
+    return num_cleared_;
+  }
+
+ private:
+  collector::GarbageCollector* const collector_;
+  mirror::Reference* const* const begin_;
+  mirror::Reference* const* const end_;
+  // Only enqueued by this task, it does not need a lock.
+  ReferenceQueue cleared_references_;
+  size_t num_cleared_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ClearWhiteReferencesTask);
+};
+
+ReferenceCounts ReferenceQueue::ClearWhiteReferences(ReferenceQueue* cleared_references,
+                                                     collector::GarbageCollector* collector,
+                                                     size_t thread_count) {
+  ReferenceCounts counts;
+  ThreadPool* thread_pool = Runtime::Current()->GetHeap()->GetThreadPool();
+  // The transaction log is not thread safe.
+  if (thread_count <= 1 || thread_pool == nullptr || Runtime::Current()->IsActiveTransaction()) {
+    while (!IsEmpty()) {
+      ObjPtr<mirror::Reference> ref = DequeuePendingReference();
+      ++counts.processed;
+      if (ClearWhiteReference(ref, cleared_references, collector)) {
+        ++counts.cleared;
+      }
+    }
+    return counts;
+  }
+  // Unlink the references first, the list cannot be split without walking it.
+  std::vector<mirror::Reference*> refs;
   while (!IsEmpty()) {
-    ObjPtr<mirror::Reference> ref = DequeuePendingReference();
-    mirror::HeapReference<mirror::Object>* referent_addr = ref->GetReferentReferenceAddr();
-    // do_atomic_update is false because this happens during the reference processing phase where
-    // Reference.clear() would block.
-    if (!collector->IsNullOrMarkedHeapReference(referent_addr, /*do_atomic_update*/false)) {
-      // Referent is white, clear it.
-      if (Runtime::Current()->IsActiveTransaction()) {
-        ref->ClearReferent<true>();
-      } else {
-        ref->ClearReferent<false>();
+    refs.push_back(DequeuePendingReference().Ptr());
+  }
+  counts.processed = refs.size();
+  if (refs.size() < kReferencesPerChunk * 2) {
+    for (mirror::Reference* ref : refs) {
+      if (ClearWhiteReference(ref, cleared_references, collector)) {
+        ++counts.cleared;
       }
-      cleared_references->EnqueueReference(ref);
     }
-    // Delay disabling the read barrier until here so that the ClearReferent call above in
-    // transaction mode will trigger the read barrier.
-    DisableReadBarrierForReference(ref);
+    return counts;
+  }
+  Thread* self = Thread::Current();
+  std::vector<std::unique_ptr<ClearWhiteReferencesTask>> tasks;
+  for (size_t begin = 0; begin < refs.size(); begin += kReferencesPerChunk) {
+    const size_t end = std::min(begin + kReferencesPerChunk, refs.size());
+    tasks.emplace_back(
+        new ClearWhiteReferencesTask(collector, refs.data() + begin, refs.data() + end));
+    thread_pool->AddTask(self, tasks.back().get());
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+  for (const std::unique_ptr<ClearWhiteReferencesTask>& task : tasks) {
+    cleared_references->EnqueueReferences(task->GetClearedReferences());
+    counts.cleared += task->GetNumCleared();
   }
+  return counts;
 }
 
-void ReferenceQueue::EnqueueFinalizerReferences(ReferenceQueue* cleared_references,
-                                                collector::GarbageCollector* collector) {
+ReferenceCounts ReferenceQueue::EnqueueFinalizerReferences(
+    ReferenceQueue* cleared_references,
+    collector::GarbageCollector* collector) {
+  ReferenceCounts counts;
   while (!IsEmpty()) {
     ObjPtr<mirror::FinalizerReference> ref = DequeuePendingReference()->AsFinalizerReference();
+    ++counts.processed;
     mirror::HeapReference<mirror::Object>* referent_addr = ref->GetReferentReferenceAddr();
     // do_atomic_update is false because this happens during the reference processing phase where
     // Reference.clear() would block.
@@ -169,11 +281,13 @@ void ReferenceQueue::EnqueueFinalizerReferences(ReferenceQueue* cleared_referenc
         ref->ClearReferent<false>();
       }
       cleared_references->EnqueueReference(ref);
+      ++counts.cleared;
     }
     // Delay disabling the read barrier until here so that the ClearReferent call above in
     // transaction mode will trigger the read barrier.
     DisableReadBarrierForReference(ref->AsReference());
   }
+  return counts;
 }
 
 void ReferenceQueue::ForwardSoftReferences(MarkObjectVisitor* visitor) {
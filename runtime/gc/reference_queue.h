@@ -46,6 +46,12 @@ class GarbageCollector;
 
 class Heap;
 
+// The number of references that a processing of a queue took from it, and cleared.
+struct ReferenceCounts {
+  size_t processed = 0;
+  size_t cleared = 0;
+};
+
 // Used to temporarily store java.lang.ref.Reference(s) during GC and prior to queueing on the
 // appropriate java.lang.ref.ReferenceQueue. The linked list is maintained as an unordered,
 // circular, and singly-linked list using the pendingNext fields of the java.lang.ref.Reference
@@ -64,6 +70,9 @@ class ReferenceQueue {
   // Not thread safe, used when mutators are paused to minimize lock overhead.
   void EnqueueReference(ObjPtr<mirror::Reference> ref) REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Move all the references of another queue to this one. Not thread safe.
+  void EnqueueReferences(ReferenceQueue* other) REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Dequeue a reference from the queue and return that dequeued reference.
   // Call DisableReadBarrierForReference for the reference that's returned from this function.
   ObjPtr<mirror::Reference> DequeuePendingReference() REQUIRES_SHARED(Locks::mutator_lock_);
@@ -76,8 +85,8 @@ class ReferenceQueue {
 
   // Enqueues finalizer references with white referents.  White referents are blackened, moved to
   // the zombie field, and the referent field is cleared.
-  void EnqueueFinalizerReferences(ReferenceQueue* cleared_references,
-                                  collector::GarbageCollector* collector)
+  ReferenceCounts EnqueueFinalizerReferences(ReferenceQueue* cleared_references,
+                                             collector::GarbageCollector* collector)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Walks the reference list marking any references subject to the reference clearing policy.
@@ -88,8 +97,11 @@ class ReferenceQueue {
 
   // Unlink the reference list clearing references objects with white referents. Cleared references
   // registered to a reference queue are scheduled for appending by the heap worker thread.
-  void ClearWhiteReferences(ReferenceQueue* cleared_references,
-                            collector::GarbageCollector* collector)
+  // With more than one thread, a long list is split into chunks processed by the threads of the
+  // heap thread pool and the calling thread, which must not be running other tasks.
+  ReferenceCounts ClearWhiteReferences(ReferenceQueue* cleared_references,
+                                       collector::GarbageCollector* collector,
+                                       size_t thread_count = 1)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   void Dump(std::ostream& os) const REQUIRES_SHARED(Locks::mutator_lock_);
@@ -110,6 +122,19 @@ class ReferenceQueue {
       REQUIRES_SHARED(Locks::mutator_lock_);
 
  private:
+  class ClearWhiteReferencesTask;
+
+  // The number of references below which the list is not split between threads, and the number
+  // of references of a chunk.
+  static constexpr size_t kReferencesPerChunk = 1024;
+
+  // Clear the referent of a dequeued reference if it is white, adding the reference to
+  // cleared_references. Returns whether it was cleared.
+  static bool ClearWhiteReference(ObjPtr<mirror::Reference> ref,
+                                  ReferenceQueue* cleared_references,
+                                  collector::GarbageCollector* collector)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Lock, used for parallel GC reference enqueuing. It allows for multiple threads simultaneously
   // calling AtomicEnqueueIfNotEnqueued.
   Mutex* const lock_;
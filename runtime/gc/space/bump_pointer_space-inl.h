@@ -36,7 +36,7 @@ inline mirror::Object* BumpPointerSpace::AllocNonvirtualWithoutAccounting(size_t
     old_end = end_.LoadRelaxed();
     new_end = old_end + num_bytes;
     // If there is no more room in the region, we are out of memory.
-    if (UNLIKELY(new_end > growth_end_)) {
+    if (UNLIKELY(new_end > growth_end_.LoadRelaxed())) {
       return nullptr;
     }
   } while (!end_.CompareExchangeWeakSequentiallyConsistent(old_end, new_end));
@@ -76,7 +76,7 @@ inline mirror::Object* BumpPointerSpace::AllocThreadUnsafe(Thread* self, size_t
   num_bytes = RoundUp(num_bytes, kAlignment);
 
   uint8_t* end = end_.LoadRelaxed();
-  if (end + num_bytes > growth_end_) {
+  if (end + num_bytes > growth_end_.LoadRelaxed()) {
     return nullptr;
   }
   mirror::Object* obj = reinterpret_cast<mirror::Object*>(end);
@@ -96,6 +96,17 @@ inline void BumpPointerSpace::AccountAllocation(size_t num_objects) {
   objects_allocated_.FetchAndAddSequentiallyConsistent(num_objects);
 }
 
+inline bool BumpPointerSpace::FreeLastAllocation(mirror::Object* obj, size_t num_bytes) {
+  DCHECK_ALIGNED(num_bytes, kAlignment);
+  uint8_t* begin = reinterpret_cast<uint8_t*>(obj);
+  if (!end_.CompareExchangeStrongSequentiallyConsistent(begin + num_bytes, begin)) {
+    return false;
+  }
+  objects_allocated_.FetchAndSubSequentiallyConsistent(1);
+  bytes_allocated_.FetchAndSubSequentiallyConsistent(num_bytes);
+  return true;
+}
+
 // Fill the given memory block with a dummy object.
 // Use to fill in a copy of object that was lost in race.
 inline void BumpPointerSpace::FillWithDummyObject(mirror::Object* dummy_obj, size_t byte_size) {
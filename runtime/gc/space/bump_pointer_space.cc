@@ -71,12 +71,21 @@ void BumpPointerSpace::Clear() {
     memset(Begin(), 0, Limit() - Begin());
   }
   CHECK_NE(madvise(Begin(), Limit() - Begin(), MADV_DONTNEED), -1) << "madvise failed";
+  // Only the objects below the end may have an age.
+  if (aging_table_ != nullptr) {
+    aging_table_->Reset(End());
+  }
   // Reset the end of the space back to the beginning, we move the end forward as we allocate
   // objects.
   SetEnd(Begin());
   objects_allocated_.StoreRelaxed(0);
   bytes_allocated_.StoreRelaxed(0);
-  growth_end_ = Limit();
+  growth_end_.StoreRelaxed(Limit());
+}
+
+void BumpPointerSpace::SetGrowthLimit(size_t growth_limit) {
+  growth_limit = std::min(RoundUp(growth_limit, kPageSize), static_cast<size_t>(Limit() - Begin()));
+  growth_end_.StoreRelaxed(std::max(Begin() + growth_limit, End()));
 }
 
 void BumpPointerSpace::Dump(std::ostream& os) const {
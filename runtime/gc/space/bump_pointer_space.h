@@ -71,6 +71,10 @@ class BumpPointerSpace FINAL : public ContinuousMemMapAllocSpace {
   // Account allocations, used by Parallel copying collector.
   void AccountAllocation(size_t num_objects);
 
+  // Free an object allocated by AllocNonvirtual() if it is still the last one allocated,
+  // used by Parallel copying collector. Returns false otherwise. Its memory must be zero.
+  bool FreeLastAllocation(mirror::Object* obj, size_t num_bytes);
+
   // NOPS unless we support free lists.
   size_t Free(Thread*, mirror::Object*) OVERRIDE {
     return 0;
@@ -86,12 +90,17 @@ class BumpPointerSpace FINAL : public ContinuousMemMapAllocSpace {
   // Removes the fork time growth limit on capacity, allowing the application to allocate up to the
   // maximum reserved size of the heap.
   void ClearGrowthLimit() {
-    growth_end_ = Limit();
+    growth_end_.StoreRelaxed(Limit());
   }
 
+  // Limit the capacity of the space, rounded up to pages, while the mutators may allocate. The
+  // limit does not go below the objects already allocated, nor above the reserved size. Clear()
+  // removes it.
+  void SetGrowthLimit(size_t growth_limit);
+
   // Override capacity so that we only return the possibly limited capacity
   size_t Capacity() const {
-    return growth_end_ - begin_;
+    return growth_end_.LoadRelaxed() - begin_;
   }
 
   // The total amount of memory reserved for the space.
@@ -188,7 +197,7 @@ class BumpPointerSpace FINAL : public ContinuousMemMapAllocSpace {
   ALWAYS_INLINE void FillWithDummyObject(mirror::Object* dummy_obj, size_t byte_size)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
-  uint8_t* growth_end_;
+  Atomic<uint8_t*> growth_end_;
   AtomicInteger objects_allocated_;  // Accumulated from revoked thread local regions.
   AtomicInteger bytes_allocated_;    // Accumulated from revoked thread local regions.
   AtomicInteger tlabs_alive_;        // Number of currently allocated TLABs
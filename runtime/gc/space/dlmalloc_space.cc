@@ -57,9 +57,10 @@ DlMallocSpace* DlMallocSpace::CreateFromMemMap(MemMap* mem_map, const std::strin
     return nullptr;
   }
 
-  // Protect memory beyond the starting size. morecore will add r/w permissions when necessory
+  // Protect memory beyond the starting size. morecore will add r/w permissions when necessory.
+  // The space backed by huge pages is not, as protecting a part of a huge page splits it.
   uint8_t* end = mem_map->Begin() + starting_size;
-  if (capacity - starting_size > 0) {
+  if (capacity - starting_size > 0 && !mem_map->UsesHugePages()) {
     CHECK_MEMORY_CALL(mprotect, (end, capacity - starting_size, PROT_NONE), name);
   }
 
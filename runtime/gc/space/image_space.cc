@@ -1138,6 +1138,86 @@ class ImageSpaceLoader {
     }
   };
 
+  // Fix up the ArtMethods, and with fixup_heap_objects the ArtFields, IMTs and IMT conflict
+  // tables of an image. Only this fixup reads and writes them: the fixup of the objects and
+  // dex caches only forwards pointers to them. It can therefore run on its own thread, not
+  // attached to the runtime, while the objects are fixed up.
+  class FixupNativeSections {
+   public:
+    FixupNativeSections(const ImageHeader& image_header,
+                        uint8_t* target_base,
+                        PointerSize pointer_size,
+                        bool fixup_heap_objects,
+                        const RelocationRange& boot_image,
+                        const RelocationRange& boot_oat,
+                        const RelocationRange& app_image,
+                        const RelocationRange& app_oat)
+        : image_header_(image_header),
+          target_base_(target_base),
+          pointer_size_(pointer_size),
+          fixup_heap_objects_(fixup_heap_objects),
+          boot_image_(boot_image),
+          boot_oat_(boot_oat),
+          app_image_(app_image),
+          app_oat_(app_oat),
+          started_(false) {}
+
+    // Start the fixup on a new thread. If the thread cannot be created, Finish() does the
+    // fixup on the calling thread.
+    void Start() {
+      int rc = pthread_create(&thread_, nullptr, &FixupNativeSections::Callback, this);
+      if (rc != 0) {
+        errno = rc;
+        PLOG(WARNING) << "Failed to create the image native sections fixup thread";
+      } else {
+        started_ = true;
+      }
+    }
+
+    void Finish() {
+      if (started_) {
+        CHECK_PTHREAD_CALL(pthread_join, (thread_, nullptr), "image native sections fixup");
+        started_ = false;
+      } else {
+        Run();
+      }
+    }
+
+   private:
+    static void* Callback(void* arg) {
+      reinterpret_cast<FixupNativeSections*>(arg)->Run();
+      return nullptr;
+    }
+
+    void Run() {
+      FixupArtMethodVisitor method_visitor(fixup_heap_objects_,
+                                           pointer_size_,
+                                           boot_image_,
+                                           boot_oat_,
+                                           app_image_,
+                                           app_oat_);
+      image_header_.VisitPackedArtMethods(&method_visitor, target_base_, pointer_size_);
+      if (fixup_heap_objects_) {
+        FixupArtFieldVisitor field_visitor(boot_image_, boot_oat_, app_image_, app_oat_);
+        image_header_.VisitPackedArtFields(&field_visitor, target_base_);
+        FixupObjectAdapter fixup_adapter(boot_image_, boot_oat_, app_image_, app_oat_);
+        image_header_.VisitPackedImTables(fixup_adapter, target_base_, pointer_size_);
+        image_header_.VisitPackedImtConflictTables(fixup_adapter, target_base_, pointer_size_);
+      }
+    }
+
+    const ImageHeader& image_header_;
+    uint8_t* const target_base_;
+    const PointerSize pointer_size_;
+    const bool fixup_heap_objects_;
+    const RelocationRange boot_image_;
+    const RelocationRange boot_oat_;
+    const RelocationRange app_image_;
+    const RelocationRange app_oat_;
+    pthread_t thread_;
+    bool started_;
+  };
+
   // Relocate an image space mapped at target_base which possibly used to be at a different base
   // address. Only needs a single image space, not one for both source and destination.
   // In place means modifying a single ImageSpace in place rather than relocating from one ImageSpace
@@ -1222,7 +1302,17 @@ class ImageSpaceLoader {
     uintptr_t objects_begin = reinterpret_cast<uintptr_t>(target_base + objects_section.Offset());
     uintptr_t objects_end = reinterpret_cast<uintptr_t>(target_base + objects_section.End());
     FixupObjectAdapter fixup_adapter(boot_image, boot_oat, app_image, app_oat);
+    FixupNativeSections fixup_native_sections(image_header,
+                                              target_base,
+                                              pointer_size,
+                                              fixup_image,
+                                              boot_image,
+                                              boot_oat,
+                                              app_image,
+                                              app_oat);
     if (fixup_image) {
+      // Overlap the fixup of the native sections with the fixup of the objects.
+      fixup_native_sections.Start();
       // Two pass approach, fix up all classes first, then fix up non class-objects.
       // The visited bitmap is used to ensure that pointer arrays are not forwarded twice.
       std::unique_ptr<gc::accounting::ContinuousSpaceBitmap> visited_bitmap(
@@ -1320,31 +1410,11 @@ class ImageSpaceLoader {
       }
     }
     {
-      // Only touches objects in the app image, no need for mutator lock.
-      TimingLogger::ScopedTiming timing("Fixup methods", &logger);
-      FixupArtMethodVisitor method_visitor(fixup_image,
-                                           pointer_size,
-                                           boot_image,
-                                           boot_oat,
-                                           app_image,
-                                           app_oat);
-      image_header.VisitPackedArtMethods(&method_visitor, target_base, pointer_size);
+      // Only touches native data in the app image, no need for mutator lock.
+      TimingLogger::ScopedTiming timing("Fixup native sections", &logger);
+      fixup_native_sections.Finish();
     }
     if (fixup_image) {
-      {
-        // Only touches objects in the app image, no need for mutator lock.
-        TimingLogger::ScopedTiming timing("Fixup fields", &logger);
-        FixupArtFieldVisitor field_visitor(boot_image, boot_oat, app_image, app_oat);
-        image_header.VisitPackedArtFields(&field_visitor, target_base);
-      }
-      {
-        TimingLogger::ScopedTiming timing("Fixup imt", &logger);
-        image_header.VisitPackedImTables(fixup_adapter, target_base, pointer_size);
-      }
-      {
-        TimingLogger::ScopedTiming timing("Fixup conflict tables", &logger);
-        image_header.VisitPackedImtConflictTables(fixup_adapter, target_base, pointer_size);
-      }
       // In the app image case, the image methods are actually in the boot image.
       image_header.RelocateImageMethods(boot_image.Delta());
       const auto& class_table_section = image_header.GetImageSection(ImageHeader::kSectionClassTable);
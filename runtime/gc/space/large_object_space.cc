@@ -18,8 +18,11 @@
 
 #include <sys/mman.h>
 
+#include <algorithm>
 #include <memory>
 
+#include "android-base/stringprintf.h"
+
 #include "base/logging.h"
 #include "base/memory_tool.h"
 #include "base/mutex-inl.h"
@@ -37,6 +40,8 @@ namespace art {
 namespace gc {
 namespace space {
 
+using android::base::StringPrintf;
+
 class MemoryToolLargeObjectMapSpace FINAL : public LargeObjectMapSpace {
  public:
   explicit MemoryToolLargeObjectMapSpace(const std::string& name) : LargeObjectMapSpace(name) {
@@ -159,10 +164,10 @@ mirror::Object* LargeObjectMapSpace::Alloc(Thread* self, size_t num_bytes,
   }
   DCHECK(bytes_tl_bulk_allocated != nullptr);
   *bytes_tl_bulk_allocated = allocation_size;
-  num_bytes_allocated_ += allocation_size;
-  total_bytes_allocated_ += allocation_size;
-  ++num_objects_allocated_;
-  ++total_objects_allocated_;
+  num_bytes_allocated_.FetchAndAddRelaxed(allocation_size);
+  total_bytes_allocated_.FetchAndAddRelaxed(allocation_size);
+  num_objects_allocated_.FetchAndAddRelaxed(1);
+  total_objects_allocated_.FetchAndAddRelaxed(1);
   return obj;
 }
 
@@ -190,10 +195,10 @@ size_t LargeObjectMapSpace::Free(Thread* self, mirror::Object* ptr) {
   }
   MemMap* mem_map = it->second.mem_map;
   const size_t map_size = mem_map->BaseSize();
-  DCHECK_GE(num_bytes_allocated_, map_size);
+  DCHECK_GE(num_bytes_allocated_.LoadRelaxed(), map_size);
   size_t allocation_size = map_size;
-  num_bytes_allocated_ -= allocation_size;
-  --num_objects_allocated_;
+  num_bytes_allocated_.FetchAndSubRelaxed(allocation_size);
+  num_objects_allocated_.FetchAndSubRelaxed(1);
   delete mem_map;
   large_objects_.erase(it);
   return allocation_size;
@@ -248,7 +253,7 @@ bool LargeObjectMapSpace::Contains(const mirror::Object* obj) const {
 // allocation info pointer.
 class AllocationInfo {
  public:
-  AllocationInfo() : prev_free_(0), alloc_size_(0) {
+  AllocationInfo() : next_free_(0), alloc_size_(0) {
   }
   // Return the number of pages that the allocation info covers.
   size_t AlignSize() const {
@@ -276,47 +281,30 @@ class AllocationInfo {
   void SetZygoteObject() {
     alloc_size_ |= kFlagZygote;
   }
-  // Return true if this is a zygote large object.
-  // Finds and returns the next non free allocation info after ourself.
+  // Finds and returns the next allocation info after ourself, free or not.
   AllocationInfo* GetNextInfo() {
     return this + AlignSize();
   }
   const AllocationInfo* GetNextInfo() const {
     return this + AlignSize();
   }
-  // Returns the previous free allocation info by using the prev_free_ member to figure out
-  // where it is. This is only used for coalescing so we only need to be able to do it if the
-  // previous allocation info is free.
-  AllocationInfo* GetPrevFreeInfo() {
-    DCHECK_NE(prev_free_, 0U);
-    return this - prev_free_;
-  }
-  // Returns the address of the object associated with this allocation info.
-  mirror::Object* GetObjectAddress() {
-    return reinterpret_cast<mirror::Object*>(reinterpret_cast<uintptr_t>(this) + sizeof(*this));
-  }
-  // Return how many kAlignment units there are before the free block.
-  size_t GetPrevFree() const {
-    return prev_free_;
+  // Returns the block after this free block in its free list, or null at the end of the list.
+  // first_info is the allocation info of the first page of the space.
+  AllocationInfo* GetNextFree(AllocationInfo* first_info) const {
+    return next_free_ != 0 ? first_info + (next_free_ - 1) : nullptr;
   }
-  // Returns how many free bytes there is before the block.
-  size_t GetPrevFreeBytes() const {
-    return GetPrevFree() * FreeListSpace::kAlignment;
-  }
-  // Update the size of the free block prior to the allocation.
-  void SetPrevFreeBytes(size_t bytes) {
-    DCHECK_ALIGNED(bytes, FreeListSpace::kAlignment);
-    prev_free_ = bytes / FreeListSpace::kAlignment;
+  void SetNextFree(AllocationInfo* first_info, AllocationInfo* next) {
+    next_free_ = next != nullptr ? static_cast<uint32_t>(next - first_info) + 1 : 0;
   }
 
  private:
   static constexpr uint32_t kFlagFree = 0x80000000;  // If block is free.
   static constexpr uint32_t kFlagZygote = 0x40000000;  // If the large object is a zygote object.
   static constexpr uint32_t kFlagsMask = ~(kFlagFree | kFlagZygote);  // Combined flags for masking.
-  // Contains the size of the previous free block with kAlignment as the unit. If 0 then the
-  // allocation before us is not free.
+  // For a free block, one plus the slot index of the next block of its free list, or 0 at the
+  // end of the list.
   // These variables are undefined in the middle of allocations / free blocks.
-  uint32_t prev_free_;
+  uint32_t next_free_;
   // Allocation size of this object in kAlignment as the unit.
   uint32_t alloc_size_;
 };
@@ -335,15 +323,6 @@ const AllocationInfo* FreeListSpace::GetAllocationInfoForAddress(uintptr_t addre
   return &allocation_info_[GetSlotIndexForAddress(address)];
 }
 
-inline bool FreeListSpace::SortByPrevFree::operator()(const AllocationInfo* a,
-                                                      const AllocationInfo* b) const {
-  if (a->GetPrevFree() < b->GetPrevFree()) return true;
-  if (a->GetPrevFree() > b->GetPrevFree()) return false;
-  if (a->AlignSize() < b->AlignSize()) return true;
-  if (a->AlignSize() > b->AlignSize()) return false;
-  return reinterpret_cast<uintptr_t>(a) < reinterpret_cast<uintptr_t>(b);
-}
-
 FreeListSpace* FreeListSpace::Create(const std::string& name, uint8_t* requested_begin, size_t size) {
   CHECK_EQ(size % kAlignment, 0U);
   std::string error_msg;
@@ -356,9 +335,10 @@ FreeListSpace* FreeListSpace::Create(const std::string& name, uint8_t* requested
 FreeListSpace::FreeListSpace(const std::string& name, MemMap* mem_map, uint8_t* begin, uint8_t* end)
     : LargeObjectSpace(name, begin, end),
       mem_map_(mem_map),
-      lock_("free list space lock", kAllocSpaceLock) {
+      lock_("free list space lock", kAllocSpaceLock),
+      free_end_(static_cast<size_t>(end - begin)),
+      non_empty_size_classes_(0) {
   const size_t space_capacity = end - begin;
-  free_end_ = space_capacity;
   CHECK_ALIGNED(space_capacity, kAlignment);
   const size_t alloc_info_size = sizeof(AllocationInfo) * (space_capacity / kAlignment);
   std::string error_msg;
@@ -369,13 +349,23 @@ FreeListSpace::FreeListSpace(const std::string& name, MemMap* mem_map, uint8_t*
   CHECK(allocation_info_map_.get() != nullptr) << "Failed to allocate allocation info map"
       << error_msg;
   allocation_info_ = reinterpret_cast<AllocationInfo*>(allocation_info_map_->Begin());
+  for (size_t i = 0; i < kNumSizeClasses; ++i) {
+    size_class_lock_names_[i] =
+        StringPrintf("a free list space size class %zu lock", static_cast<size_t>(1) << i);
+    size_class_locks_[i] = new Mutex(size_class_lock_names_[i].c_str(), kLargeObjectFreeListLock);
+    free_lists_[i] = nullptr;
+  }
 }
 
-FreeListSpace::~FreeListSpace() {}
+FreeListSpace::~FreeListSpace() {
+  for (size_t i = 0; i < kNumSizeClasses; ++i) {
+    delete size_class_locks_[i];
+  }
+}
 
 void FreeListSpace::Walk(DlMallocSpace::WalkCallback callback, void* arg) {
-  MutexLock mu(Thread::Current(), lock_);
-  const uintptr_t free_end_start = reinterpret_cast<uintptr_t>(end_) - free_end_;
+  WriterMutexLock mu(Thread::Current(), lock_);
+  const uintptr_t free_end_start = reinterpret_cast<uintptr_t>(end_) - free_end_.LoadRelaxed();
   AllocationInfo* cur_info = &allocation_info_[0];
   const AllocationInfo* end_info = GetAllocationInfoForAddress(free_end_start);
   while (cur_info < end_info) {
@@ -391,16 +381,134 @@ void FreeListSpace::Walk(DlMallocSpace::WalkCallback callback, void* arg) {
   CHECK_EQ(cur_info, end_info);
 }
 
-void FreeListSpace::RemoveFreePrev(AllocationInfo* info) {
-  CHECK_GT(info->GetPrevFree(), 0U);
-  auto it = free_blocks_.lower_bound(info);
-  CHECK(it != free_blocks_.end());
-  CHECK_EQ(*it, info);
-  free_blocks_.erase(it);
+void FreeListSpace::PushFreeBlock(Thread* self, AllocationInfo* info) {
+  DCHECK(info->IsFree());
+  const size_t size_class = SizeClassForPages(info->AlignSize());
+  MutexLock mu(self, *size_class_locks_[size_class]);
+  if (free_lists_[size_class] == nullptr) {
+    non_empty_size_classes_.FetchAndOrSequentiallyConsistent(1u << size_class);
+  }
+  info->SetNextFree(allocation_info_, free_lists_[size_class]);
+  free_lists_[size_class] = info;
+}
+
+AllocationInfo* FreeListSpace::TakeFreeBlock(Thread* self,
+                                             size_t size_class,
+                                             size_t num_pages,
+                                             size_t max_scanned_blocks) {
+  MutexLock mu(self, *size_class_locks_[size_class]);
+  AllocationInfo* prev_info = nullptr;
+  AllocationInfo* info = free_lists_[size_class];
+  for (size_t i = 0; info != nullptr && i < max_scanned_blocks; ++i) {
+    AllocationInfo* next_info = info->GetNextFree(allocation_info_);
+    if (info->AlignSize() >= num_pages) {
+      if (prev_info != nullptr) {
+        prev_info->SetNextFree(allocation_info_, next_info);
+      } else {
+        free_lists_[size_class] = next_info;
+        if (next_info == nullptr) {
+          non_empty_size_classes_.FetchAndAndSequentiallyConsistent(~(1u << size_class));
+        }
+      }
+      return info;
+    }
+    prev_info = info;
+    info = next_info;
+  }
+  return nullptr;
+}
+
+AllocationInfo* FreeListSpace::AllocFromFreeLists(Thread* self, size_t num_pages) {
+  const size_t size_class = SizeClassForPages(num_pages);
+  AllocationInfo* info = nullptr;
+  if ((non_empty_size_classes_.LoadRelaxed() & (1u << size_class)) != 0) {
+    // Only some of the blocks of the size class of the allocation fit it, look at the first ones.
+    info = TakeFreeBlock(self, size_class, num_pages, kMaxScannedFreeBlocks);
+  }
+  // Any block of a larger size class fits, take one of the smallest non-empty class. Look at the
+  // bitmap again if another thread emptied the class meanwhile.
+  const uint32_t larger_size_classes = ~((2u << size_class) - 1u);
+  for (uint32_t classes = non_empty_size_classes_.LoadRelaxed() & larger_size_classes;
+       info == nullptr && classes != 0;
+       classes = non_empty_size_classes_.LoadRelaxed() & larger_size_classes) {
+    info = TakeFreeBlock(self, static_cast<size_t>(CTZ(classes)), num_pages, 1u);
+  }
+  if (info == nullptr) {
+    return nullptr;
+  }
+  const size_t remaining_pages = info->AlignSize() - num_pages;
+  if (remaining_pages != 0) {
+    AllocationInfo* remaining_info = info + num_pages;
+    remaining_info->SetByteSize(remaining_pages * kAlignment, true);
+    PushFreeBlock(self, remaining_info);
+  }
+  info->SetByteSize(num_pages * kAlignment, false);
+  return info;
+}
+
+AllocationInfo* FreeListSpace::AllocFromFreeEnd(size_t num_pages) {
+  const size_t allocation_size = num_pages * kAlignment;
+  size_t free_end;
+  do {
+    free_end = free_end_.LoadRelaxed();
+    if (free_end < allocation_size) {
+      return nullptr;
+    }
+  } while (!free_end_.CompareExchangeWeakRelaxed(free_end, free_end - allocation_size));
+  // Fit our object at the start of the end free block.
+  AllocationInfo* info = GetAllocationInfoForAddress(reinterpret_cast<uintptr_t>(End()) - free_end);
+  info->SetByteSize(allocation_size, false);
+  return info;
+}
+
+AllocationInfo* FreeListSpace::AllocPages(Thread* self, size_t num_pages) {
+  AllocationInfo* info = AllocFromFreeLists(self, num_pages);
+  if (info == nullptr) {
+    info = AllocFromFreeEnd(num_pages);
+  }
+  return info;
+}
+
+void FreeListSpace::CoalesceFreeBlocks() {
+  // No other thread uses the free lists while the lock is held exclusively. Rebuild them in
+  // address order, so that the allocations reuse the lowest blocks first.
+  AllocationInfo* tails[kNumSizeClasses] = {};
+  uint32_t non_empty_size_classes = 0u;
+  std::fill_n(free_lists_, kNumSizeClasses, nullptr);
+  size_t free_end = free_end_.LoadRelaxed();
+  AllocationInfo* cur_info = &allocation_info_[0];
+  AllocationInfo* end_info = &allocation_info_[(Size() - free_end) / kAlignment];
+  while (cur_info < end_info) {
+    AllocationInfo* next_info = cur_info->GetNextInfo();
+    if (cur_info->IsFree()) {
+      while (next_info < end_info && next_info->IsFree()) {
+        next_info = next_info->GetNextInfo();
+      }
+      const size_t free_size = (next_info - cur_info) * kAlignment;
+      if (next_info == end_info) {
+        // The last free blocks go back to the end free region.
+        free_end += free_size;
+      } else {
+        cur_info->SetByteSize(free_size, true);
+        cur_info->SetNextFree(allocation_info_, nullptr);
+        const size_t size_class = SizeClassForPages(cur_info->AlignSize());
+        if (tails[size_class] != nullptr) {
+          tails[size_class]->SetNextFree(allocation_info_, cur_info);
+        } else {
+          free_lists_[size_class] = cur_info;
+          non_empty_size_classes |= 1u << size_class;
+        }
+        tails[size_class] = cur_info;
+      }
+    }
+    cur_info = next_info;
+  }
+  CHECK_EQ(cur_info, end_info);
+  free_end_.StoreRelaxed(free_end);
+  non_empty_size_classes_.StoreRelaxed(non_empty_size_classes);
 }
 
 size_t FreeListSpace::Free(Thread* self, mirror::Object* obj) {
-  MutexLock mu(self, lock_);
   DCHECK(Contains(obj)) << reinterpret_cast<void*>(Begin()) << " " << obj << " "
                         << reinterpret_cast<void*>(End());
   DCHECK_ALIGNED(obj, kAlignment);
@@ -409,52 +517,18 @@ size_t FreeListSpace::Free(Thread* self, mirror::Object* obj) {
   const size_t allocation_size = info->ByteSize();
   DCHECK_GT(allocation_size, 0U);
   DCHECK_ALIGNED(allocation_size, kAlignment);
-  info->SetByteSize(allocation_size, true);  // Mark as free.
-  // Look at the next chunk.
-  AllocationInfo* next_info = info->GetNextInfo();
-  // Calculate the start of the end free block.
-  uintptr_t free_end_start = reinterpret_cast<uintptr_t>(end_) - free_end_;
-  size_t prev_free_bytes = info->GetPrevFreeBytes();
-  size_t new_free_size = allocation_size;
-  if (prev_free_bytes != 0) {
-    // Coalesce with previous free chunk.
-    new_free_size += prev_free_bytes;
-    RemoveFreePrev(info);
-    info = info->GetPrevFreeInfo();
-    // The previous allocation info must not be free since we are supposed to always coalesce.
-    DCHECK_EQ(info->GetPrevFreeBytes(), 0U) << "Previous allocation was free";
-  }
-  uintptr_t next_addr = GetAddressForAllocationInfo(next_info);
-  if (next_addr >= free_end_start) {
-    // Easy case, the next chunk is the end free region.
-    CHECK_EQ(next_addr, free_end_start);
-    free_end_ += new_free_size;
-  } else {
-    AllocationInfo* new_free_info;
-    if (next_info->IsFree()) {
-      AllocationInfo* next_next_info = next_info->GetNextInfo();
-      // Next next info can't be free since we always coalesce.
-      DCHECK(!next_next_info->IsFree());
-      DCHECK_ALIGNED(next_next_info->ByteSize(), kAlignment);
-      new_free_info = next_next_info;
-      new_free_size += next_next_info->GetPrevFreeBytes();
-      RemoveFreePrev(next_next_info);
-    } else {
-      new_free_info = next_info;
-    }
-    new_free_info->SetPrevFreeBytes(new_free_size);
-    free_blocks_.insert(new_free_info);
-    info->SetByteSize(new_free_size, true);
-    DCHECK_EQ(info->GetNextInfo(), new_free_info);
-  }
-  --num_objects_allocated_;
-  DCHECK_LE(allocation_size, num_bytes_allocated_);
-  num_bytes_allocated_ -= allocation_size;
+  DCHECK_LE(allocation_size, num_bytes_allocated_.LoadRelaxed());
+  num_objects_allocated_.FetchAndSubRelaxed(1);
+  num_bytes_allocated_.FetchAndSubRelaxed(allocation_size);
+  // Release the pages before the block can be allocated again, without holding any lock.
   madvise(obj, allocation_size, MADV_DONTNEED);
   if (kIsDebugBuild) {
-    // Can't disallow reads since we use them to find next chunks during coalescing.
     mprotect(obj, allocation_size, PROT_READ);
   }
+  ReaderMutexLock mu(self, lock_);
+  // The adjacent free blocks are only merged when an allocation does not fit in the free lists.
+  info->SetByteSize(allocation_size, true);  // Mark as free.
+  PushFreeBlock(self, info);
   return allocation_size;
 }
 
@@ -471,35 +545,19 @@ size_t FreeListSpace::AllocationSize(mirror::Object* obj, size_t* usable_size) {
 
 mirror::Object* FreeListSpace::Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated,
                                      size_t* usable_size, size_t* bytes_tl_bulk_allocated) {
-  MutexLock mu(self, lock_);
-  const size_t allocation_size = RoundUp(num_bytes, kAlignment);
-  AllocationInfo temp_info;
-  temp_info.SetPrevFreeBytes(allocation_size);
-  temp_info.SetByteSize(0, false);
+  const size_t allocation_size = RoundUp(std::max<size_t>(num_bytes, 1u), kAlignment);
+  const size_t num_pages = allocation_size / kAlignment;
   AllocationInfo* new_info;
-  // Find the smallest chunk at least num_bytes in size.
-  auto it = free_blocks_.lower_bound(&temp_info);
-  if (it != free_blocks_.end()) {
-    AllocationInfo* info = *it;
-    free_blocks_.erase(it);
-    // Fit our object in the previous allocation info free space.
-    new_info = info->GetPrevFreeInfo();
-    // Remove the newly allocated block from the info and update the prev_free_.
-    info->SetPrevFreeBytes(info->GetPrevFreeBytes() - allocation_size);
-    if (info->GetPrevFreeBytes() > 0) {
-      AllocationInfo* new_free = info - info->GetPrevFree();
-      new_free->SetPrevFreeBytes(0);
-      new_free->SetByteSize(info->GetPrevFreeBytes(), true);
-      // If there is remaining space, insert back into the free set.
-      free_blocks_.insert(info);
-    }
-  } else {
-    // Try to steal some memory from the free space at the end of the space.
-    if (LIKELY(free_end_ >= allocation_size)) {
-      // Fit our object at the start of the end free block.
-      new_info = GetAllocationInfoForAddress(reinterpret_cast<uintptr_t>(End()) - free_end_);
-      free_end_ -= allocation_size;
-    } else {
+  {
+    ReaderMutexLock mu(self, lock_);
+    new_info = AllocPages(self, num_pages);
+  }
+  if (UNLIKELY(new_info == nullptr)) {
+    WriterMutexLock mu(self, lock_);
+    // The free blocks were not merged when they were freed, merge them and try again.
+    CoalesceFreeBlocks();
+    new_info = AllocPages(self, num_pages);
+    if (new_info == nullptr) {
       return nullptr;
     }
   }
@@ -510,28 +568,24 @@ mirror::Object* FreeListSpace::Alloc(Thread* self, size_t num_bytes, size_t* byt
   }
   DCHECK(bytes_tl_bulk_allocated != nullptr);
   *bytes_tl_bulk_allocated = allocation_size;
-  // Need to do these inside of the lock.
-  ++num_objects_allocated_;
-  ++total_objects_allocated_;
-  num_bytes_allocated_ += allocation_size;
-  total_bytes_allocated_ += allocation_size;
+  num_objects_allocated_.FetchAndAddRelaxed(1);
+  total_objects_allocated_.FetchAndAddRelaxed(1);
+  num_bytes_allocated_.FetchAndAddRelaxed(allocation_size);
+  total_bytes_allocated_.FetchAndAddRelaxed(allocation_size);
   mirror::Object* obj = reinterpret_cast<mirror::Object*>(GetAddressForAllocationInfo(new_info));
-  // We always put our object at the start of the free block, there cannot be another free block
-  // before it.
   if (kIsDebugBuild) {
     mprotect(obj, allocation_size, PROT_READ | PROT_WRITE);
   }
-  new_info->SetPrevFreeBytes(0);
-  new_info->SetByteSize(allocation_size, false);
   return obj;
 }
 
 void FreeListSpace::Dump(std::ostream& os) const {
-  MutexLock mu(Thread::Current(), lock_);
+  WriterMutexLock mu(Thread::Current(), lock_);
+  const size_t free_end = free_end_.LoadRelaxed();
   os << GetName() << " -"
      << " begin: " << reinterpret_cast<void*>(Begin())
      << " end: " << reinterpret_cast<void*>(End()) << "\n";
-  uintptr_t free_end_start = reinterpret_cast<uintptr_t>(end_) - free_end_;
+  uintptr_t free_end_start = reinterpret_cast<uintptr_t>(end_) - free_end;
   const AllocationInfo* cur_info =
       GetAllocationInfoForAddress(reinterpret_cast<uintptr_t>(Begin()));
   const AllocationInfo* end_info = GetAllocationInfoForAddress(free_end_start);
@@ -547,9 +601,9 @@ void FreeListSpace::Dump(std::ostream& os) const {
     }
     cur_info = cur_info->GetNextInfo();
   }
-  if (free_end_) {
+  if (free_end) {
     os << "Free block at address: " << reinterpret_cast<const void*>(free_end_start)
-       << " of length " << free_end_ << " bytes\n";
+       << " of length " << free_end << " bytes\n";
   }
 }
 
@@ -560,8 +614,8 @@ bool FreeListSpace::IsZygoteLargeObject(Thread* self ATTRIBUTE_UNUSED, mirror::O
 }
 
 void FreeListSpace::SetAllLargeObjectsAsZygoteObjects(Thread* self) {
-  MutexLock mu(self, lock_);
-  uintptr_t free_end_start = reinterpret_cast<uintptr_t>(end_) - free_end_;
+  WriterMutexLock mu(self, lock_);
+  uintptr_t free_end_start = reinterpret_cast<uintptr_t>(end_) - free_end_.LoadRelaxed();
   for (AllocationInfo* cur_info = GetAllocationInfoForAddress(reinterpret_cast<uintptr_t>(Begin())),
       *end_info = GetAllocationInfoForAddress(free_end_start); cur_info < end_info;
       cur_info = cur_info->GetNextInfo()) {
@@ -618,7 +672,7 @@ std::pair<uint8_t*, uint8_t*> LargeObjectMapSpace::GetBeginEndAtomic() const {
 }
 
 std::pair<uint8_t*, uint8_t*> FreeListSpace::GetBeginEndAtomic() const {
-  MutexLock mu(Thread::Current(), lock_);
+  ReaderMutexLock mu(Thread::Current(), lock_);
   return std::make_pair(Begin(), End());
 }
 
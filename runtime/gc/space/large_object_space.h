@@ -17,12 +17,13 @@
 #ifndef ART_RUNTIME_GC_SPACE_LARGE_OBJECT_SPACE_H_
 #define ART_RUNTIME_GC_SPACE_LARGE_OBJECT_SPACE_H_
 
+#include "atomic.h"
 #include "base/allocator.h"
+#include "base/bit_utils.h"
 #include "dlmalloc_space.h"
 #include "safe_map.h"
 #include "space.h"
 
-#include <set>
 #include <vector>
 
 namespace art {
@@ -49,16 +50,16 @@ class LargeObjectSpace : public DiscontinuousSpace, public AllocSpace {
   virtual ~LargeObjectSpace() {}
 
   uint64_t GetBytesAllocated() OVERRIDE {
-    return num_bytes_allocated_;
+    return num_bytes_allocated_.LoadRelaxed();
   }
   uint64_t GetObjectsAllocated() OVERRIDE {
-    return num_objects_allocated_;
+    return num_objects_allocated_.LoadRelaxed();
   }
   uint64_t GetTotalBytesAllocated() const {
-    return total_bytes_allocated_;
+    return total_bytes_allocated_.LoadRelaxed();
   }
   uint64_t GetTotalObjectsAllocated() const {
-    return total_objects_allocated_;
+    return total_objects_allocated_.LoadRelaxed();
   }
   size_t FreeList(Thread* self, size_t num_ptrs, mirror::Object** ptrs) OVERRIDE;
   // LargeObjectSpaces don't have thread local state.
@@ -112,11 +113,12 @@ class LargeObjectSpace : public DiscontinuousSpace, public AllocSpace {
   explicit LargeObjectSpace(const std::string& name, uint8_t* begin, uint8_t* end);
   static void SweepCallback(size_t num_ptrs, mirror::Object** ptrs, void* arg);
 
-  // Approximate number of bytes which have been allocated into the space.
-  uint64_t num_bytes_allocated_;
-  uint64_t num_objects_allocated_;
-  uint64_t total_bytes_allocated_;
-  uint64_t total_objects_allocated_;
+  // Approximate number of bytes which have been allocated into the space. Atomic since the
+  // FreeListSpace updates them without an exclusive lock.
+  Atomic<uint64_t> num_bytes_allocated_;
+  Atomic<uint64_t> num_objects_allocated_;
+  Atomic<uint64_t> total_bytes_allocated_;
+  Atomic<uint64_t> total_objects_allocated_;
   // Begin and end, may change as more large objects are allocated.
   uint8_t* begin_;
   uint8_t* end_;
@@ -162,10 +164,18 @@ class LargeObjectMapSpace : public LargeObjectSpace {
       GUARDED_BY(lock_);
 };
 
-// A continuous large object space with a free-list to handle holes.
+// A continuous large object space with a free-list to handle holes. The free blocks are kept in
+// segregated lists of power of two size classes, each with its own lock, and a bitmap of the
+// non-empty classes finds the smallest class that fits an allocation in constant time. Freeing
+// does not coalesce; the adjacent free blocks are merged when an allocation does not fit.
 class FreeListSpace FINAL : public LargeObjectSpace {
  public:
   static constexpr size_t kAlignment = kPageSize;
+  // Class i holds the free blocks of [2^i, 2^(i+1)) pages.
+  static constexpr size_t kNumSizeClasses = 32;
+  // How many blocks of the size class of an allocation are looked at before taking a block of a
+  // larger class.
+  static constexpr size_t kMaxScannedFreeBlocks = 8;
 
   virtual ~FreeListSpace();
   static FreeListSpace* Create(const std::string& name, uint8_t* requested_begin, size_t capacity);
@@ -195,29 +205,44 @@ class FreeListSpace FINAL : public LargeObjectSpace {
   uintptr_t GetAddressForAllocationInfo(const AllocationInfo* info) const {
     return GetAllocationAddressForSlot(GetSlotIndexForAllocationInfo(info));
   }
-  // Removes header from the free blocks set by finding the corresponding iterator and erasing it.
-  void RemoveFreePrev(AllocationInfo* info) REQUIRES(lock_);
+  static size_t SizeClassForPages(size_t num_pages) {
+    DCHECK_NE(num_pages, 0U);
+    return static_cast<size_t>(MostSignificantBit(num_pages));
+  }
+  // Allocates a block of num_pages from the free lists, then from the end of the space.
+  AllocationInfo* AllocPages(Thread* self, size_t num_pages) REQUIRES_SHARED(lock_);
+  AllocationInfo* AllocFromFreeLists(Thread* self, size_t num_pages) REQUIRES_SHARED(lock_);
+  AllocationInfo* AllocFromFreeEnd(size_t num_pages) REQUIRES_SHARED(lock_);
+  // Adds a free block to the list of its size class.
+  void PushFreeBlock(Thread* self, AllocationInfo* info) REQUIRES_SHARED(lock_);
+  // Removes and returns the first of the first max_scanned_blocks blocks of a free list that
+  // has at least num_pages, or null if there is none.
+  AllocationInfo* TakeFreeBlock(Thread* self,
+                                size_t size_class,
+                                size_t num_pages,
+                                size_t max_scanned_blocks) REQUIRES_SHARED(lock_);
+  // Merges the adjacent free blocks, returning the ones at the end of the space to free_end_,
+  // and rebuilds the free lists.
+  void CoalesceFreeBlocks() REQUIRES(lock_);
   bool IsZygoteLargeObject(Thread* self, mirror::Object* obj) const OVERRIDE;
   void SetAllLargeObjectsAsZygoteObjects(Thread* self) OVERRIDE REQUIRES(!lock_);
 
-  class SortByPrevFree {
-   public:
-    bool operator()(const AllocationInfo* a, const AllocationInfo* b) const;
-  };
-  typedef std::set<AllocationInfo*, SortByPrevFree,
-                   TrackingAllocator<AllocationInfo*, kAllocatorTagLOSFreeList>> FreeBlocks;
-
-  // There is not footer for any allocations at the end of the space, so we keep track of how much
-  // free space there is at the end manually.
   std::unique_ptr<MemMap> mem_map_;
   // Side table for allocation info, one per page.
   std::unique_ptr<MemMap> allocation_info_map_;
   AllocationInfo* allocation_info_;
 
-  mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
-  // Free bytes at the end of the space.
-  size_t free_end_ GUARDED_BY(lock_);
-  FreeBlocks free_blocks_ GUARDED_BY(lock_);
+  // Held shared to allocate and free, and exclusively to walk the blocks or coalesce them.
+  mutable ReaderWriterMutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // There is not footer for any allocations at the end of the space, so we keep track of how much
+  // free space there is at the end manually. Taken by the allocations with a CAS.
+  Atomic<size_t> free_end_;
+  // Bit i is set if free_lists_[i] is not empty. Only changed with size_class_locks_[i] held.
+  Atomic<uint32_t> non_empty_size_classes_;
+  // The singly linked lists of free blocks. free_lists_[i] is guarded by size_class_locks_[i].
+  AllocationInfo* free_lists_[kNumSizeClasses];
+  Mutex* size_class_locks_[kNumSizeClasses];
+  std::string size_class_lock_names_[kNumSizeClasses];
 };
 
 }  // namespace space
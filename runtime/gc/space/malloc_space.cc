@@ -141,7 +141,9 @@ void* MallocSpace::MoreCore(intptr_t increment) {
       // Should never be asked to increase the allocation beyond the capacity of the space. Enforced
       // by mspace_set_footprint_limit.
       CHECK_LE(new_end, Begin() + Capacity());
-      CHECK_MEMORY_CALL(mprotect, (original_end, increment, PROT_READ | PROT_WRITE), GetName());
+      if (!GetMemMap()->UsesHugePages()) {
+        CHECK_MEMORY_CALL(mprotect, (original_end, increment, PROT_READ | PROT_WRITE), GetName());
+      }
     } else {
       // Should never be asked for negative footprint (ie before begin). Zero footprint is ok.
       CHECK_GE(original_end + increment, Begin());
@@ -152,8 +154,14 @@ void* MallocSpace::MoreCore(intptr_t increment) {
       // removing ignoring the memory protection change here and in Space::CreateAllocSpace. It's
       // likely just a useful debug feature.
       size_t size = -increment;
-      CHECK_MEMORY_CALL(madvise, (new_end, size, MADV_DONTNEED), GetName());
-      CHECK_MEMORY_CALL(mprotect, (new_end, size, PROT_NONE), GetName());
+      if (GetMemMap()->UsesHugePages()) {
+        // The space backed by huge pages is not protected. Only release the whole huge pages, not
+        // to split them.
+        ZeroAndReleasePages(new_end, size, MemMap::kHugePageSize);
+      } else {
+        CHECK_MEMORY_CALL(madvise, (new_end, size, MADV_DONTNEED), GetName());
+        CHECK_MEMORY_CALL(mprotect, (new_end, size, PROT_NONE), GetName());
+      }
     }
     // Update end_.
     SetEnd(new_end);
@@ -200,7 +208,7 @@ ZygoteSpace* MallocSpace::CreateZygoteSpace(const char* alloc_space_name, bool l
                                     low_memory_mode);
   // Protect memory beyond the initial size.
   uint8_t* end = mem_map->Begin() + starting_size_;
-  if (capacity > initial_size_) {
+  if (capacity > initial_size_ && !mem_map->UsesHugePages()) {
     CHECK_MEMORY_CALL(mprotect, (end, capacity - initial_size_, PROT_NONE), alloc_space_name);
   }
   *out_malloc_space = CreateInstance(mem_map.release(), alloc_space_name, allocator, End(), end,
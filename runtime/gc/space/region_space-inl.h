@@ -46,7 +46,7 @@ inline mirror::Object* RegionSpace::AllocNonvirtual(size_t num_bytes, size_t* by
                                                     size_t* bytes_tl_bulk_allocated) {
   DCHECK_ALIGNED(num_bytes, kAlignment);
   mirror::Object* obj;
-  if (LIKELY(num_bytes <= kRegionSize)) {
+  if (LIKELY(num_bytes <= region_size_)) {
     // Non-large object.
     obj = (kForEvac ? evac_region_ : current_region_)->Alloc(num_bytes,
                                                              bytes_allocated,
@@ -241,11 +241,11 @@ mirror::Object* RegionSpace::AllocLarge(size_t num_bytes, size_t* bytes_allocate
                                         size_t* usable_size,
                                         size_t* bytes_tl_bulk_allocated) {
   DCHECK_ALIGNED(num_bytes, kAlignment);
-  DCHECK_GT(num_bytes, kRegionSize);
-  size_t num_regs = RoundUp(num_bytes, kRegionSize) / kRegionSize;
+  DCHECK_GT(num_bytes, region_size_);
+  size_t num_regs = RoundUp(num_bytes, region_size_) >> region_size_shift_;
   DCHECK_GT(num_regs, 0U);
-  DCHECK_LT((num_regs - 1) * kRegionSize, num_bytes);
-  DCHECK_LE(num_bytes, num_regs * kRegionSize);
+  DCHECK_LT((num_regs - 1) * region_size_, num_bytes);
+  DCHECK_LE(num_bytes, num_regs * region_size_);
   MutexLock mu(Thread::Current(), region_lock_);
   if (!kForEvac) {
     // Retain sufficient free regions for full evacuation.
@@ -274,8 +274,11 @@ mirror::Object* RegionSpace::AllocLarge(size_t num_bytes, size_t* bytes_allocate
       Region* first_reg = &regions_[left];
       DCHECK(first_reg->IsFree());
       first_reg->UnfreeLarge(this, time_);
+      if (kForEvac) {
+        first_reg->SetAge(kOldRegionAge);
+      }
       ++num_non_free_regions_;
-      size_t allocated = num_regs * kRegionSize;
+      size_t allocated = num_regs * region_size_;
       // We make 'top' all usable bytes, as the caller of this
       // allocation may use all of 'usable_size' (see mirror::Array::Alloc).
       first_reg->SetTop(first_reg->Begin() + allocated);
@@ -283,6 +286,9 @@ mirror::Object* RegionSpace::AllocLarge(size_t num_bytes, size_t* bytes_allocate
         DCHECK_LT(p, num_regions_);
         DCHECK(regions_[p].IsFree());
         regions_[p].UnfreeLargeTail(this, time_);
+        if (kForEvac) {
+          regions_[p].SetAge(kOldRegionAge);
+        }
         ++num_non_free_regions_;
       }
       *bytes_allocated = allocated;
@@ -301,7 +307,7 @@ mirror::Object* RegionSpace::AllocLarge(size_t num_bytes, size_t* bytes_allocate
 
 inline size_t RegionSpace::Region::BytesAllocated() const {
   if (IsLarge()) {
-    DCHECK_LT(begin_ + kRegionSize, Top());
+    DCHECK_LT(end_, Top());
     return static_cast<size_t>(Top() - begin_);
   } else if (IsLargeTail()) {
     DCHECK_EQ(begin_, Top());
@@ -315,7 +321,7 @@ inline size_t RegionSpace::Region::BytesAllocated() const {
     } else {
       bytes = static_cast<size_t>(Top() - begin_);
     }
-    DCHECK_LE(bytes, kRegionSize);
+    DCHECK_LE(bytes, static_cast<size_t>(end_ - begin_));
     return bytes;
   }
 }
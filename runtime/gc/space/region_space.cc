@@ -27,23 +27,24 @@ namespace space {
 
 // If a region has live objects whose size is less than this percent
 // value of the region size, evaculate the region.
-static constexpr uint kEvaculateLivePercentThreshold = 75U;
-
 // If we protect the cleared regions.
 // Only protect for target builds to prevent flaky test failures (b/63131961).
 static constexpr bool kProtectClearedRegions = kIsTargetBuild;
 
-MemMap* RegionSpace::CreateMemMap(const std::string& name, size_t capacity,
-                                  uint8_t* requested_begin) {
-  CHECK_ALIGNED(capacity, kRegionSize);
+MemMap* RegionSpace::CreateMemMap(const std::string& name,
+                                  size_t capacity,
+                                  uint8_t* requested_begin,
+                                  size_t alignment) {
+  CHECK_ALIGNED_PARAM(alignment, kRegionSize);
+  CHECK_ALIGNED_PARAM(capacity, alignment);
   std::string error_msg;
-  // Ask for the capacity of an additional kRegionSize so that we can align the map by kRegionSize
+  // Ask for the capacity of an additional alignment so that we can align the map by alignment
   // even if we get unaligned base address. This is necessary for the ReadBarrierTable to work.
   std::unique_ptr<MemMap> mem_map;
   while (true) {
     mem_map.reset(MemMap::MapAnonymous(name.c_str(),
                                        requested_begin,
-                                       capacity + kRegionSize,
+                                       capacity + alignment,
                                        PROT_READ | PROT_WRITE,
                                        true,
                                        false,
@@ -60,42 +61,51 @@ MemMap* RegionSpace::CreateMemMap(const std::string& name, size_t capacity,
     MemMap::DumpMaps(LOG_STREAM(ERROR));
     return nullptr;
   }
-  CHECK_EQ(mem_map->Size(), capacity + kRegionSize);
+  CHECK_EQ(mem_map->Size(), capacity + alignment);
   CHECK_EQ(mem_map->Begin(), mem_map->BaseBegin());
   CHECK_EQ(mem_map->Size(), mem_map->BaseSize());
-  if (IsAlignedParam(mem_map->Begin(), kRegionSize)) {
-    // Got an aligned map. Since we requested a map that's kRegionSize larger. Shrink by
-    // kRegionSize at the end.
+  if (IsAlignedParam(mem_map->Begin(), alignment)) {
+    // Got an aligned map. Since we requested a map that's alignment larger. Shrink by
+    // alignment at the end.
     mem_map->SetSize(capacity);
   } else {
     // Got an unaligned map. Align the both ends.
-    mem_map->AlignBy(kRegionSize);
+    mem_map->AlignBy(alignment);
   }
-  CHECK_ALIGNED(mem_map->Begin(), kRegionSize);
-  CHECK_ALIGNED(mem_map->End(), kRegionSize);
+  CHECK_ALIGNED_PARAM(mem_map->Begin(), alignment);
+  CHECK_ALIGNED_PARAM(mem_map->End(), alignment);
   CHECK_EQ(mem_map->Size(), capacity);
   return mem_map.release();
 }
 
-RegionSpace* RegionSpace::Create(const std::string& name, MemMap* mem_map) {
-  return new RegionSpace(name, mem_map);
+RegionSpace* RegionSpace::Create(const std::string& name, MemMap* mem_map, size_t region_size) {
+  return new RegionSpace(name, mem_map, region_size);
 }
 
-RegionSpace::RegionSpace(const std::string& name, MemMap* mem_map)
+RegionSpace::RegionSpace(const std::string& name, MemMap* mem_map, size_t region_size)
     : ContinuousMemMapAllocSpace(name, mem_map, mem_map->Begin(), mem_map->End(), mem_map->End(),
                                  kGcRetentionPolicyAlwaysCollect),
-      region_lock_("Region lock", kRegionSpaceRegionLock), time_(1U) {
+      region_lock_("Region lock", kRegionSpaceRegionLock),
+      region_size_(region_size),
+      region_size_shift_(WhichPowerOf2(region_size)),
+      release_alignment_(mem_map->UsesHugePages() ? MemMap::kHugePageSize : kPageSize),
+      time_(1U),
+      num_evacuated_regions_(0U),
+      num_unevacuated_regions_(0U) {
+  CHECK(IsPowerOfTwo(region_size_)) << region_size_;
+  CHECK_GE(region_size_, kRegionSize);
+  CHECK_LE(region_size_, kMaxRegionSize);
   size_t mem_map_size = mem_map->Size();
-  CHECK_ALIGNED(mem_map_size, kRegionSize);
+  CHECK_ALIGNED_PARAM(mem_map_size, region_size_);
   CHECK_ALIGNED(mem_map->Begin(), kRegionSize);
-  num_regions_ = mem_map_size / kRegionSize;
+  num_regions_ = mem_map_size / region_size_;
   num_non_free_regions_ = 0U;
   DCHECK_GT(num_regions_, 0U);
   non_free_region_index_limit_ = 0U;
   regions_.reset(new Region[num_regions_]);
   uint8_t* region_addr = mem_map->Begin();
-  for (size_t i = 0; i < num_regions_; ++i, region_addr += kRegionSize) {
-    regions_[i].Init(i, region_addr, region_addr + kRegionSize);
+  for (size_t i = 0; i < num_regions_; ++i, region_addr += region_size_) {
+    regions_[i].Init(i, region_addr, region_addr + region_size_);
   }
   mark_bitmap_.reset(
       accounting::ContinuousSpaceBitmap::Create("region space live bitmap", Begin(), Capacity()));
@@ -103,7 +113,7 @@ RegionSpace::RegionSpace(const std::string& name, MemMap* mem_map)
     CHECK_EQ(regions_[0].Begin(), Begin());
     for (size_t i = 0; i < num_regions_; ++i) {
       CHECK(regions_[i].IsFree());
-      CHECK_EQ(static_cast<size_t>(regions_[i].End() - regions_[i].Begin()), kRegionSize);
+      CHECK_EQ(static_cast<size_t>(regions_[i].End() - regions_[i].Begin()), region_size_);
       if (i + 1 < num_regions_) {
         CHECK_EQ(regions_[i].End(), regions_[i + 1].Begin());
       }
@@ -127,7 +137,7 @@ size_t RegionSpace::FromSpaceSize() {
       ++num_regions;
     }
   }
-  return num_regions * kRegionSize;
+  return num_regions * region_size_;
 }
 
 size_t RegionSpace::UnevacFromSpaceSize() {
@@ -139,7 +149,7 @@ size_t RegionSpace::UnevacFromSpaceSize() {
       ++num_regions;
     }
   }
-  return num_regions * kRegionSize;
+  return num_regions * region_size_;
 }
 
 size_t RegionSpace::ToSpaceSize() {
@@ -151,10 +161,10 @@ size_t RegionSpace::ToSpaceSize() {
       ++num_regions;
     }
   }
-  return num_regions * kRegionSize;
+  return num_regions * region_size_;
 }
 
-inline bool RegionSpace::Region::ShouldBeEvacuated() {
+inline bool RegionSpace::Region::ShouldBeEvacuated(size_t evacuate_live_percent_threshold) {
   DCHECK((IsAllocated() || IsLarge()) && IsInToSpace());
   // if the region was allocated after the start of the
   // previous GC or the live ratio is below threshold, evacuate
@@ -169,13 +179,14 @@ inline bool RegionSpace::Region::ShouldBeEvacuated() {
       DCHECK(!IsLargeTail());
       DCHECK_NE(live_bytes_, static_cast<size_t>(-1));
       DCHECK_LE(live_bytes_, BytesAllocated());
-      const size_t bytes_allocated = RoundUp(BytesAllocated(), kRegionSize);
+      const size_t bytes_allocated = RoundUp(BytesAllocated(),
+                                             static_cast<size_t>(end_ - begin_));
       DCHECK_LE(live_bytes_, bytes_allocated);
       if (IsAllocated()) {
         // Side node: live_percent == 0 does not necessarily mean
         // there's no live objects due to rounding (there may be a
         // few).
-        result = live_bytes_ * 100U < kEvaculateLivePercentThreshold * bytes_allocated;
+        result = live_bytes_ * 100U < evacuate_live_percent_threshold * bytes_allocated;
       } else {
         DCHECK(IsLarge());
         result = live_bytes_ == 0U;
@@ -188,8 +199,12 @@ inline bool RegionSpace::Region::ShouldBeEvacuated() {
 }
 
 // Determine which regions to evacuate and mark them as
-// from-space. Mark the rest as unevacuated from-space.
-void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool force_evacuate_all) {
+// from-space. Mark the rest as unevacuated from-space, but the old
+// regions of a young collection, which stay in the to-space.
+void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table,
+                               bool force_evacuate_all,
+                               bool young_gen,
+                               size_t evacuate_live_percent_threshold) {
   ++time_;
   if (kUseTableLookupReadBarrier) {
     DCHECK(rb_table->IsAllCleared());
@@ -197,7 +212,9 @@ void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool forc
   }
   MutexLock mu(Thread::Current(), region_lock_);
   size_t num_expected_large_tails = 0;
-  bool prev_large_evacuated = false;
+  RegionType prev_large_type = RegionType::kRegionTypeToSpace;
+  num_evacuated_regions_ = 0U;
+  num_unevacuated_regions_ = 0U;
   VerifyNonFreeRegionLimit();
   const size_t iter_limit = kUseTableLookupReadBarrier
       ? num_regions_
@@ -212,29 +229,39 @@ void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool forc
         DCHECK((state == RegionState::kRegionStateAllocated ||
                 state == RegionState::kRegionStateLarge) &&
                type == RegionType::kRegionTypeToSpace);
-        bool should_evacuate = force_evacuate_all || r->ShouldBeEvacuated();
-        if (should_evacuate) {
+        if (young_gen && r->IsOld()) {
+          // Not collected, its objects are all considered live.
+        } else if (!r->IsPinned() &&
+                   (force_evacuate_all ||
+                    r->ShouldBeEvacuated(evacuate_live_percent_threshold))) {
           r->SetAsFromSpace();
           DCHECK(r->IsInFromSpace());
+          ++num_evacuated_regions_;
         } else {
           r->SetAsUnevacFromSpace();
           DCHECK(r->IsInUnevacFromSpace());
+          ++num_unevacuated_regions_;
         }
         if (UNLIKELY(state == RegionState::kRegionStateLarge &&
                      type == RegionType::kRegionTypeToSpace)) {
-          prev_large_evacuated = should_evacuate;
-          num_expected_large_tails = RoundUp(r->BytesAllocated(), kRegionSize) / kRegionSize - 1;
+          prev_large_type = r->Type();
+          num_expected_large_tails =
+              (RoundUp(r->BytesAllocated(), region_size_) >> region_size_shift_) - 1;
           DCHECK_GT(num_expected_large_tails, 0U);
         }
       } else {
         DCHECK(state == RegionState::kRegionStateLargeTail &&
                type == RegionType::kRegionTypeToSpace);
-        if (prev_large_evacuated) {
+        if (prev_large_type == RegionType::kRegionTypeFromSpace) {
           r->SetAsFromSpace();
           DCHECK(r->IsInFromSpace());
-        } else {
+          ++num_evacuated_regions_;
+        } else if (prev_large_type == RegionType::kRegionTypeUnevacFromSpace) {
           r->SetAsUnevacFromSpace();
           DCHECK(r->IsInUnevacFromSpace());
+          ++num_unevacuated_regions_;
+        } else {
+          DCHECK(young_gen && r->IsOld());
         }
         --num_expected_large_tails;
       }
@@ -251,14 +278,19 @@ void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool forc
   evac_region_ = &full_region_;
 }
 
-static void ZeroAndProtectRegion(uint8_t* begin, uint8_t* end) {
-  ZeroAndReleasePages(begin, end - begin);
-  if (kProtectClearedRegions) {
+static void ZeroAndProtectRegion(uint8_t* begin,
+                                 uint8_t* end,
+                                 size_t release_alignment = kPageSize) {
+  ZeroAndReleasePages(begin, end - begin, release_alignment);
+  // Protecting a part of a huge page would split it.
+  if (kProtectClearedRegions && release_alignment == kPageSize) {
     mprotect(begin, end - begin, PROT_NONE);
   }
 }
 
-void RegionSpace::ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_objects) {
+void RegionSpace::ClearFromSpace(uint64_t* cleared_bytes,
+                                 uint64_t* cleared_objects,
+                                 bool keep_bitmap) {
   DCHECK(cleared_bytes != nullptr);
   DCHECK(cleared_objects != nullptr);
   *cleared_bytes = 0;
@@ -273,10 +305,10 @@ void RegionSpace::ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_obje
   // clear block is zeroed, released, and a new block begins.
   uint8_t* clear_block_begin = nullptr;
   uint8_t* clear_block_end = nullptr;
-  auto clear_region = [&clear_block_begin, &clear_block_end](Region* r) {
+  auto clear_region = [this, &clear_block_begin, &clear_block_end](Region* r) {
     r->Clear(/*zero_and_release_pages*/false);
     if (clear_block_end != r->Begin()) {
-      ZeroAndProtectRegion(clear_block_begin, clear_block_end);
+      ZeroAndProtectRegion(clear_block_begin, clear_block_end, release_alignment_);
       clear_block_begin = r->Begin();
     }
     clear_block_end = r->End();
@@ -310,11 +342,11 @@ void RegionSpace::ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_obje
         clear_region(r);
         GetLiveBitmap()->ClearRange(
             reinterpret_cast<mirror::Object*>(r->Begin()),
-            reinterpret_cast<mirror::Object*>(r->Begin() + free_regions * kRegionSize));
+            reinterpret_cast<mirror::Object*>(r->Begin() + free_regions * region_size_));
         continue;
       }
       r->SetUnevacFromSpaceAsToSpace();
-      if (r->AllAllocatedBytesAreLive()) {
+      if (r->AllAllocatedBytesAreLive() && !keep_bitmap) {
         // Try to optimize the number of ClearRange calls by checking whether the next regions
         // can also be cleared.
         size_t regions_to_clear_bitmap = 1;
@@ -331,7 +363,7 @@ void RegionSpace::ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_obje
 
         GetLiveBitmap()->ClearRange(
             reinterpret_cast<mirror::Object*>(r->Begin()),
-            reinterpret_cast<mirror::Object*>(r->Begin() + regions_to_clear_bitmap * kRegionSize));
+            reinterpret_cast<mirror::Object*>(r->Begin() + regions_to_clear_bitmap * region_size_));
         // Skip over extra regions we cleared the bitmaps: we don't need to clear them, as they
         // are unevac region sthat are live.
         // Subtract one for the for loop.
@@ -346,7 +378,7 @@ void RegionSpace::ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_obje
     }
   }
   // Clear pages for the last block since clearing happens when a new block opens.
-  ZeroAndReleasePages(clear_block_begin, clear_block_end - clear_block_begin);
+  ZeroAndReleasePages(clear_block_begin, clear_block_end - clear_block_begin, release_alignment_);
   // Update non_free_region_index_limit_.
   SetNonFreeRegionLimit(new_non_free_region_index_limit);
   evac_region_ = nullptr;
@@ -385,7 +417,7 @@ void RegionSpace::LogFragmentationAllocFailure(std::ostream& os,
       }
     }
     max_contiguous_allocation = std::max(max_contiguous_allocation,
-                                         max_contiguous_free_regions * kRegionSize);
+                                         max_contiguous_free_regions * region_size_);
   }
   os << "; failed due to fragmentation (largest possible contiguous allocation "
      <<  max_contiguous_allocation << " bytes)";
@@ -399,8 +431,11 @@ void RegionSpace::Clear() {
     if (!r->IsFree()) {
       --num_non_free_regions_;
     }
-    r->Clear(/*zero_and_release_pages*/true);
+    r->Clear(/*zero_and_release_pages*/false);
   }
+  ZeroAndProtectRegion(Begin(), Limit(), release_alignment_);
+  // The bits of the old regions may be kept across the collections.
+  GetLiveBitmap()->Clear();
   SetNonFreeRegionLimit(0);
   current_region_ = &full_region_;
   evac_region_ = &full_region_;
@@ -416,18 +451,19 @@ void RegionSpace::FreeLarge(mirror::Object* large_obj, size_t bytes_allocated) {
   DCHECK_ALIGNED(large_obj, kRegionSize);
   MutexLock mu(Thread::Current(), region_lock_);
   uint8_t* begin_addr = reinterpret_cast<uint8_t*>(large_obj);
-  uint8_t* end_addr = AlignUp(reinterpret_cast<uint8_t*>(large_obj) + bytes_allocated, kRegionSize);
+  uint8_t* end_addr = begin_addr + RoundUp(bytes_allocated, region_size_);
   CHECK_LT(begin_addr, end_addr);
-  for (uint8_t* addr = begin_addr; addr < end_addr; addr += kRegionSize) {
+  for (uint8_t* addr = begin_addr; addr < end_addr; addr += region_size_) {
     Region* reg = RefToRegionLocked(reinterpret_cast<mirror::Object*>(addr));
     if (addr == begin_addr) {
       DCHECK(reg->IsLarge());
     } else {
       DCHECK(reg->IsLargeTail());
     }
-    reg->Clear(/*zero_and_release_pages*/true);
+    reg->Clear(/*zero_and_release_pages*/false);
     --num_non_free_regions_;
   }
+  ZeroAndProtectRegion(begin_addr, end_addr, release_alignment_);
   if (end_addr < Limit()) {
     // If we aren't at the end of the space, check that the next region is not a large tail.
     Region* following_reg = RefToRegionLocked(reinterpret_cast<mirror::Object*>(end_addr));
@@ -474,6 +510,21 @@ bool RegionSpace::AllocNewTlab(Thread* self, size_t min_bytes) {
   return false;
 }
 
+void RegionSpace::PinRegion(mirror::Object* obj) {
+  MutexLock mu(Thread::Current(), region_lock_);
+  Region* r = RefToRegionLocked(obj);
+  // Large objects start at their first region, which the large tails follow in SetFromSpace().
+  DCHECK(!r->IsFree() && !r->IsLargeTail());
+  ++r->pin_count_;
+}
+
+void RegionSpace::UnpinRegion(mirror::Object* obj) {
+  MutexLock mu(Thread::Current(), region_lock_);
+  Region* r = RefToRegionLocked(obj);
+  CHECK(r->IsPinned());
+  --r->pin_count_;
+}
+
 size_t RegionSpace::RevokeThreadLocalBuffers(Thread* thread) {
   MutexLock mu(Thread::Current(), region_lock_);
   RevokeThreadLocalBuffersLocked(thread);
@@ -487,7 +538,7 @@ void RegionSpace::RevokeThreadLocalBuffersLocked(Thread* thread) {
     DCHECK_ALIGNED(tlab_start, kRegionSize);
     Region* r = RefToRegionLocked(reinterpret_cast<mirror::Object*>(tlab_start));
     DCHECK(r->IsAllocated());
-    DCHECK_LE(thread->GetThreadLocalBytesAllocated(), kRegionSize);
+    DCHECK_LE(thread->GetThreadLocalBytesAllocated(), region_size_);
     r->RecordThreadLocalAllocations(thread->GetThreadLocalObjectsAllocated(),
                                     thread->GetThreadLocalBytesAllocated());
     r->is_a_tlab_ = false;
@@ -532,18 +583,19 @@ void RegionSpace::Region::Dump(std::ostream& os) const {
      << " state=" << static_cast<uint>(state_) << " type=" << static_cast<uint>(type_)
      << " objects_allocated=" << objects_allocated_
      << " alloc_time=" << alloc_time_ << " live_bytes=" << live_bytes_
-     << " is_newly_allocated=" << is_newly_allocated_ << " is_a_tlab=" << is_a_tlab_ << " thread=" << thread_ << "\n";
+     << " is_newly_allocated=" << is_newly_allocated_ << " is_a_tlab=" << is_a_tlab_
+     << " age=" << static_cast<uint>(age_) << " thread=" << thread_ << "\n";
 }
 
 size_t RegionSpace::AllocationSizeNonvirtual(mirror::Object* obj, size_t* usable_size) {
   size_t num_bytes = obj->SizeOf();
   if (usable_size != nullptr) {
-    if (LIKELY(num_bytes <= kRegionSize)) {
+    if (LIKELY(num_bytes <= region_size_)) {
       DCHECK(RefToRegion(obj)->IsAllocated());
       *usable_size = RoundUp(num_bytes, kAlignment);
     } else {
       DCHECK(RefToRegion(obj)->IsLarge());
-      *usable_size = RoundUp(num_bytes, kRegionSize);
+      *usable_size = RoundUp(num_bytes, region_size_);
     }
   }
   return num_bytes;
@@ -561,6 +613,8 @@ void RegionSpace::Region::Clear(bool zero_and_release_pages) {
   }
   is_newly_allocated_ = false;
   is_a_tlab_ = false;
+  age_ = 0;
+  DCHECK_EQ(pin_count_, 0u);
   thread_ = nullptr;
 }
 
@@ -576,6 +630,8 @@ RegionSpace::Region* RegionSpace::AllocateRegion(bool for_evac) {
       if (!for_evac) {
         // Evac doesn't count as newly allocated.
         r->SetNewlyAllocated();
+      } else {
+        r->SetAge(kOldRegionAge);
       }
       return r;
     }
@@ -588,8 +644,8 @@ void RegionSpace::Region::MarkAsAllocated(RegionSpace* region_space, uint32_t al
   alloc_time_ = alloc_time;
   region_space->AdjustNonFreeRegionLimit(idx_);
   type_ = RegionType::kRegionTypeToSpace;
-  if (kProtectClearedRegions) {
-    mprotect(Begin(), kRegionSize, PROT_READ | PROT_WRITE);
+  if (kProtectClearedRegions && region_space->release_alignment_ == kPageSize) {
+    mprotect(Begin(), End() - Begin(), PROT_READ | PROT_WRITE);
   }
 }
 
@@ -42,9 +42,16 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
 
   // Create a region space mem map with the requested sizes. The requested base address is not
   // guaranteed to be granted, if it is required, the caller should call Begin on the returned
-  // space to confirm the request was granted.
-  static MemMap* CreateMemMap(const std::string& name, size_t capacity, uint8_t* requested_begin);
-  static RegionSpace* Create(const std::string& name, MemMap* mem_map);
+  // space to confirm the request was granted. The map is aligned by alignment, a multiple of
+  // kRegionSize such as the huge page size.
+  static MemMap* CreateMemMap(const std::string& name,
+                              size_t capacity,
+                              uint8_t* requested_begin,
+                              size_t alignment = kRegionSize);
+  // The region size must be a power of two between kRegionSize and kMaxRegionSize, and the
+  // capacity of the mem map a multiple of it.
+  static RegionSpace* Create(const std::string& name, MemMap* mem_map,
+                             size_t region_size = kRegionSize);
 
   // Allocate num_bytes, returns null if the space is full.
   mirror::Object* Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated,
@@ -138,6 +145,12 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
   uint64_t GetObjectsAllocatedInUnevacFromSpace() REQUIRES(!region_lock_) {
     return GetObjectsAllocatedInternal<RegionType::kRegionTypeUnevacFromSpace>();
   }
+  uint64_t GetBytesAllocatedInToSpace() REQUIRES(!region_lock_) {
+    return GetBytesAllocatedInternal<RegionType::kRegionTypeToSpace>();
+  }
+  uint64_t GetObjectsAllocatedInToSpace() REQUIRES(!region_lock_) {
+    return GetObjectsAllocatedInternal<RegionType::kRegionTypeToSpace>();
+  }
 
   bool CanMoveObjects() const OVERRIDE {
     return true;
@@ -166,13 +179,29 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
   accounting::ContinuousSpaceBitmap::SweepCallback* GetSweepCallback() OVERRIDE {
     return nullptr;
   }
+
+  // Pin the region of obj: the collections leave the region in place until it is unpinned, so
+  // that a pointer into obj stays valid without disabling the moving collections. The pins of a
+  // region are counted, each PinRegion() needs a matching UnpinRegion().
+  void PinRegion(mirror::Object* obj) REQUIRES(!region_lock_);
+  void UnpinRegion(mirror::Object* obj) REQUIRES(!region_lock_);
   void LogFragmentationAllocFailure(std::ostream& os, size_t failed_alloc_bytes) OVERRIDE
       REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!region_lock_);
 
   // Object alignment within the space.
   static constexpr size_t kAlignment = kObjectAlignment;
-  // The region size.
+  // The default and smallest region size. The space is aligned by it, which is the granularity of
+  // the ReadBarrierTable.
   static constexpr size_t kRegionSize = 256 * KB;
+  // The largest region size.
+  static constexpr size_t kMaxRegionSize = 4 * MB;
+  // The live percentage below which a region is evacuated by default.
+  static constexpr size_t kDefaultEvacuateLivePercentThreshold = 75U;
+  // The age from which the young collections leave a region alone. The regions the collections
+  // evacuate to start old, and the unevacuated regions age when a collection leaves them in place.
+  // The collections only update references to old objects, so that the cards dirtied by the
+  // mutators are enough to find the references from the old objects to the young ones.
+  static constexpr uint8_t kOldRegionAge = 1;
 
   bool IsInFromSpace(mirror::Object* ref) {
     if (HasAddress(ref)) {
@@ -198,6 +227,14 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
     return false;
   }
 
+  bool IsInOldRegion(mirror::Object* ref) {
+    if (HasAddress(ref)) {
+      Region* r = RefToRegionUnlocked(ref);
+      return r->IsOld();
+    }
+    return false;
+  }
+
   bool IsInToSpace(mirror::Object* ref) {
     if (HasAddress(ref)) {
       Region* r = RefToRegionUnlocked(ref);
@@ -214,17 +251,40 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
     return RegionType::kRegionTypeNone;
   }
 
-  void SetFromSpace(accounting::ReadBarrierTable* rb_table, bool force_evacuate_all)
+  // With young_gen, the old regions are left in the to-space. The regions whose live percentage
+  // at the previous collection is below evacuate_live_percent_threshold are evacuated, the others
+  // are kept in place.
+  void SetFromSpace(accounting::ReadBarrierTable* rb_table,
+                    bool force_evacuate_all,
+                    bool young_gen,
+                    size_t evacuate_live_percent_threshold = kDefaultEvacuateLivePercentThreshold)
       REQUIRES(!region_lock_);
 
+  // The regions the last SetFromSpace() set to evacuate, and to keep in place.
+  size_t GetNumEvacuatedRegions() const {
+    return num_evacuated_regions_;
+  }
+  size_t GetNumUnevacuatedRegions() const {
+    return num_unevacuated_regions_;
+  }
+
+  size_t GetRegionSize() const {
+    return region_size_;
+  }
+
   size_t FromSpaceSize() REQUIRES(!region_lock_);
   size_t UnevacFromSpaceSize() REQUIRES(!region_lock_);
   size_t ToSpaceSize() REQUIRES(!region_lock_);
-  void ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_objects) REQUIRES(!region_lock_);
+  // With keep_bitmap, the bitmap bits of the unevacuated regions whose objects are all live are
+  // kept, so that the bitmap still has all the objects of the old regions.
+  void ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_objects, bool keep_bitmap)
+      REQUIRES(!region_lock_);
 
+  // kAtomic is true if several threads may add the live bytes of a region at the same time.
+  template <bool kAtomic = false>
   void AddLiveBytes(mirror::Object* ref, size_t alloc_size) {
     Region* reg = RefToRegionUnlocked(ref);
-    reg->AddLiveBytes(alloc_size);
+    reg->AddLiveBytes<kAtomic>(alloc_size);
   }
 
   void AssertAllRegionLiveBytesZeroOrCleared() REQUIRES(!region_lock_) {
@@ -246,7 +306,7 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
   }
 
  private:
-  RegionSpace(const std::string& name, MemMap* mem_map);
+  RegionSpace(const std::string& name, MemMap* mem_map, size_t region_size);
 
   template<bool kToSpaceOnly, typename Visitor>
   ALWAYS_INLINE void WalkInternal(Visitor&& visitor) NO_THREAD_SAFETY_ANALYSIS;
@@ -258,7 +318,8 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
           begin_(nullptr), top_(nullptr), end_(nullptr),
           state_(RegionState::kRegionStateAllocated), type_(RegionType::kRegionTypeToSpace),
           objects_allocated_(0), alloc_time_(0), live_bytes_(static_cast<size_t>(-1)),
-          is_newly_allocated_(false), is_a_tlab_(false), thread_(nullptr) {}
+          is_newly_allocated_(false), is_a_tlab_(false), age_(0), pin_count_(0),
+          thread_(nullptr) {}
 
     void Init(size_t idx, uint8_t* begin, uint8_t* end) {
       idx_ = idx;
@@ -272,9 +333,10 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
       live_bytes_ = static_cast<size_t>(-1);
       is_newly_allocated_ = false;
       is_a_tlab_ = false;
+      age_ = 0;
+      pin_count_ = 0;
       thread_ = nullptr;
       DCHECK_LT(begin, end);
-      DCHECK_EQ(static_cast<size_t>(end - begin), kRegionSize);
     }
 
     RegionState State() const {
@@ -327,7 +389,7 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
     bool IsLarge() const {
       bool is_large = state_ == RegionState::kRegionStateLarge;
       if (is_large) {
-        DCHECK_LT(begin_ + kRegionSize, Top());
+        DCHECK_LT(end_, Top());
       }
       return is_large;
     }
@@ -349,6 +411,22 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
       return is_newly_allocated_;
     }
 
+    uint8_t Age() const {
+      return age_;
+    }
+
+    void SetAge(uint8_t age) {
+      age_ = age;
+    }
+
+    bool IsOld() const {
+      return age_ >= kOldRegionAge;
+    }
+
+    bool IsPinned() const {
+      return pin_count_ != 0;
+    }
+
     bool IsInFromSpace() const {
       return type_ == RegionType::kRegionTypeFromSpace;
     }
@@ -380,18 +458,28 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
     void SetUnevacFromSpaceAsToSpace() {
       DCHECK(!IsFree() && IsInUnevacFromSpace());
       type_ = RegionType::kRegionTypeToSpace;
+      // The region survived the collection in place.
+      if (age_ < kOldRegionAge) {
+        ++age_;
+      }
     }
 
-    ALWAYS_INLINE bool ShouldBeEvacuated();
+    ALWAYS_INLINE bool ShouldBeEvacuated(size_t evacuate_live_percent_threshold);
 
+    template <bool kAtomic>
     void AddLiveBytes(size_t live_bytes) {
       DCHECK(IsInUnevacFromSpace());
       DCHECK(!IsLargeTail());
       DCHECK_NE(live_bytes_, static_cast<size_t>(-1));
       // For large allocations, we always consider all bytes in the
       // regions live.
-      live_bytes_ += IsLarge() ? Top() - begin_ : live_bytes;
-      DCHECK_LE(live_bytes_, BytesAllocated());
+      size_t bytes = IsLarge() ? Top() - begin_ : live_bytes;
+      if (kAtomic) {
+        reinterpret_cast<Atomic<size_t>*>(&live_bytes_)->FetchAndAddRelaxed(bytes);
+      } else {
+        live_bytes_ += bytes;
+        DCHECK_LE(live_bytes_, BytesAllocated());
+      }
     }
 
     bool AllAllocatedBytesAreLive() const {
@@ -406,7 +494,7 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
 
     size_t ObjectsAllocated() const {
       if (IsLarge()) {
-        DCHECK_LT(begin_ + kRegionSize, Top());
+        DCHECK_LT(end_, Top());
         DCHECK_EQ(objects_allocated_.LoadRelaxed(), 0U);
         return 1;
       } else if (IsLargeTail()) {
@@ -462,6 +550,8 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
     size_t live_bytes_;                 // The live bytes. Used to compute the live percent.
     bool is_newly_allocated_;           // True if it's allocated after the last collection.
     bool is_a_tlab_;                    // True if it's a tlab.
+    uint8_t age_;                       // The number of collections the region survived.
+    size_t pin_count_;                  // The number of pins, the region is not evacuated if any.
     Thread* thread_;                    // The owning thread if it's a tlab.
 
     friend class RegionSpace;
@@ -486,7 +576,7 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
   Region* RefToRegionLocked(mirror::Object* ref) REQUIRES(region_lock_) {
     DCHECK(HasAddress(ref));
     uintptr_t offset = reinterpret_cast<uintptr_t>(ref) - reinterpret_cast<uintptr_t>(Begin());
-    size_t reg_idx = offset / kRegionSize;
+    size_t reg_idx = offset >> region_size_shift_;
     DCHECK_LT(reg_idx, num_regions_);
     Region* reg = &regions_[reg_idx];
     DCHECK_EQ(reg->Idx(), reg_idx);
@@ -522,6 +612,11 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
 
   Mutex region_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
 
+  const size_t region_size_;       // The size of a region, a power of two.
+  const size_t region_size_shift_;  // The log2 of region_size_.
+  // The cleared regions are released by whole blocks of this size, such as the huge pages
+  // backing the space, which releasing a part of would split.
+  const size_t release_alignment_;
   uint32_t time_;                  // The time as the number of collections since the startup.
   size_t num_regions_;             // The number of regions in this space.
   size_t num_non_free_regions_;    // The number of non-free regions in this space.
@@ -534,6 +629,9 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
   Region* current_region_;         // The region that's being allocated currently.
   Region* evac_region_;            // The region that's being evacuated to currently.
   Region full_region_;             // The dummy/sentinel region that looks full.
+  // The regions the last SetFromSpace() set to evacuate, and to keep in place.
+  size_t num_evacuated_regions_;
+  size_t num_unevacuated_regions_;
 
   // Mark bitmap used by the GC.
   std::unique_ptr<accounting::ContinuousSpaceBitmap> mark_bitmap_;
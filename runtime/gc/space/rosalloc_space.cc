@@ -62,15 +62,17 @@ RosAllocSpace* RosAllocSpace::CreateFromMemMap(MemMap* mem_map, const std::strin
   bool running_on_memory_tool = Runtime::Current()->IsRunningOnMemoryTool();
 
   allocator::RosAlloc* rosalloc = CreateRosAlloc(mem_map->Begin(), starting_size, initial_size,
-                                                 capacity, low_memory_mode, running_on_memory_tool);
+                                                 capacity, low_memory_mode, running_on_memory_tool,
+                                                 GetPageReleaseAlignment(mem_map));
   if (rosalloc == nullptr) {
     LOG(ERROR) << "Failed to initialize rosalloc for alloc space (" << name << ")";
     return nullptr;
   }
 
-  // Protect memory beyond the starting size. MoreCore will add r/w permissions when necessory
+  // Protect memory beyond the starting size. MoreCore will add r/w permissions when necessory.
+  // The space backed by huge pages is not, as protecting a part of a huge page splits it.
   uint8_t* end = mem_map->Begin() + starting_size;
-  if (capacity - starting_size > 0) {
+  if (capacity - starting_size > 0 && !mem_map->UsesHugePages()) {
     CHECK_MEMORY_CALL(mprotect, (end, capacity - starting_size, PROT_NONE), name);
   }
 
@@ -132,7 +134,8 @@ RosAllocSpace* RosAllocSpace::Create(const std::string& name, size_t initial_siz
 allocator::RosAlloc* RosAllocSpace::CreateRosAlloc(void* begin, size_t morecore_start,
                                                    size_t initial_size,
                                                    size_t maximum_size, bool low_memory_mode,
-                                                   bool running_on_memory_tool) {
+                                                   bool running_on_memory_tool,
+                                                   size_t page_release_alignment) {
   // clear errno to allow PLOG on error
   errno = 0;
   // create rosalloc using our backing storage starting at begin and
@@ -143,7 +146,9 @@ allocator::RosAlloc* RosAllocSpace::CreateRosAlloc(void* begin, size_t morecore_
       low_memory_mode ?
           art::gc::allocator::RosAlloc::kPageReleaseModeAll :
           art::gc::allocator::RosAlloc::kPageReleaseModeSizeAndEnd,
-      running_on_memory_tool);
+      running_on_memory_tool,
+      art::gc::allocator::RosAlloc::kDefaultPageReleaseSizeThreshold,
+      page_release_alignment);
   if (rosalloc != nullptr) {
     rosalloc->SetFootprintLimit(initial_size);
   } else {
@@ -267,6 +272,26 @@ size_t RosAllocSpace::Trim() {
   return 0;
 }
 
+bool RosAllocSpace::TrimIncrementally(size_t* resume_idx,
+                                      uint64_t deadline_ns,
+                                      uint64_t* reclaimed_bytes) {
+  if (*resume_idx == 0) {
+    Thread* const self = Thread::Current();
+    // SOA required for Rosalloc::Trim() -> ArtRosAllocMoreCore() -> Heap::GetRosAllocSpace.
+    ScopedObjectAccess soa(self);
+    MutexLock mu(self, lock_);
+    // Trim to release memory at the end of the space.
+    rosalloc_->Trim();
+  }
+  if (rosalloc_->DoesReleaseAllPages()) {
+    return true;
+  }
+  size_t released_bytes = 0;
+  bool finished = rosalloc_->ReleasePages(resume_idx, deadline_ns, &released_bytes);
+  *reclaimed_bytes += released_bytes;
+  return finished;
+}
+
 void RosAllocSpace::Walk(void(*callback)(void *start, void *end, size_t num_bytes, void* callback_arg),
                          void* arg) {
   InspectAllRosAlloc(callback, arg, true);
@@ -373,7 +398,8 @@ void RosAllocSpace::Clear() {
   delete rosalloc_;
   rosalloc_ = CreateRosAlloc(mem_map_->Begin(), starting_size_, initial_size_,
                              NonGrowthLimitCapacity(), low_memory_mode_,
-                             Runtime::Current()->IsRunningOnMemoryTool());
+                             Runtime::Current()->IsRunningOnMemoryTool(),
+                             GetPageReleaseAlignment(mem_map_.get()));
   SetFootprintLimit(footprint_limit);
 }
 
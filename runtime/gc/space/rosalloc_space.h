@@ -113,6 +113,10 @@ class RosAllocSpace : public MallocSpace {
   }
 
   size_t Trim() OVERRIDE;
+  // Like Trim(), but stops releasing the pages once NanoTime() passes deadline_ns, and resumes
+  // from *resume_idx, the page map index set by the previous call or 0 for a new trim. Returns
+  // whether the trim finished. Adds the bytes released to *reclaimed_bytes.
+  bool TrimIncrementally(size_t* resume_idx, uint64_t deadline_ns, uint64_t* reclaimed_bytes);
   void Walk(WalkCallback callback, void* arg) OVERRIDE REQUIRES(!lock_);
   size_t GetFootprint() OVERRIDE;
   size_t GetFootprintLimit() OVERRIDE;
@@ -169,11 +173,17 @@ class RosAllocSpace : public MallocSpace {
   void* CreateAllocator(void* base, size_t morecore_start, size_t initial_size,
                         size_t maximum_size, bool low_memory_mode) OVERRIDE {
     return CreateRosAlloc(base, morecore_start, initial_size, maximum_size, low_memory_mode,
-                          RUNNING_ON_MEMORY_TOOL != 0);
+                          RUNNING_ON_MEMORY_TOOL != 0, GetPageReleaseAlignment(GetMemMap()));
   }
   static allocator::RosAlloc* CreateRosAlloc(void* base, size_t morecore_start, size_t initial_size,
                                              size_t maximum_size, bool low_memory_mode,
-                                             bool running_on_memory_tool);
+                                             bool running_on_memory_tool,
+                                             size_t page_release_alignment);
+
+  // The space backed by huge pages releases them whole, not to split them.
+  static size_t GetPageReleaseAlignment(const MemMap* mem_map) {
+    return mem_map->UsesHugePages() ? MemMap::kHugePageSize : kPageSize;
+  }
 
   void InspectAllRosAlloc(void (*callback)(void *start, void *end, size_t num_bytes, void* callback_arg),
                           void* arg, bool do_null_callback_at_end)
@@ -27,13 +27,16 @@
 #include <cutils/open_memstream.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/time.h>
 #include <sys/uio.h>
+#include <sys/wait.h>
 #include <time.h>
 #include <time.h>
 #include <unistd.h>
+#include <algorithm>
 #include <set>
 
 #include "android-base/stringprintf.h"
@@ -77,6 +80,23 @@ static constexpr uint32_t kHprofNullThread = 0;
 static constexpr size_t kMaxObjectsPerSegment = 128;
 static constexpr size_t kMaxBytesPerSegment = 4096;
 
+// The index written along the heap dump with -XX:+HprofIndex. It lets the analyzers memory-map
+// the index and seek to the records of the objects, without parsing the whole dump first.
+// U1*: NUL-terminated magic string.
+// U4:  number of classes.
+// U4:  number of objects.
+// The classes, in increasing ids:
+//   ID:  class object ID.
+//   U4:  length of the name.
+//   U1*: modified UTF-8 name of the class (NOT null terminated).
+// The objects, classes included, in increasing ids, kHprofIndexObjectSize bytes each:
+//   ID:  object ID.
+//   ID:  class object ID of the object.
+//   U8:  offset in the heap dump of the heap dump sub-record of the object.
+//   U4:  shallow size of the object.
+static constexpr const char kHprofIndexMagic[] = "ART HPROF INDEX 1";
+static constexpr size_t kHprofIndexObjectSize = 20;
+
 // The static field-name for the synthetic object generated to account for class static overhead.
 static constexpr const char* kClassOverheadName = "$classOverhead";
 
@@ -435,14 +455,17 @@ class NetStateEndianOutput FINAL : public EndianOutputBuffered {
 
 class Hprof : public SingleRootVisitor {
  public:
-  Hprof(const char* output_filename, int fd, bool direct_to_ddms)
+  // A forked dump does not log nor throw, see LogWarning().
+  Hprof(const char* output_filename, int fd, bool direct_to_ddms, bool forked = false)
       : filename_(output_filename),
         fd_(fd),
-        direct_to_ddms_(direct_to_ddms) {
-    LOG(INFO) << "hprof: heap dump \"" << filename_ << "\" starting...";
+        direct_to_ddms_(direct_to_ddms),
+        forked_(forked) {
+    LogInfo("hprof: heap dump \"" + filename_ + "\" starting...");
   }
 
-  void Dump()
+  // Returns false if the dump could not be written.
+  bool Dump()
     REQUIRES(Locks::mutator_lock_)
     REQUIRES(!Locks::heap_bitmap_lock_, !Locks::alloc_tracker_lock_) {
     {
@@ -478,14 +501,50 @@ class Hprof : public SingleRootVisitor {
 
     if (okay) {
       const uint64_t duration = NanoTime() - start_ns_;
-      LOG(INFO) << "hprof: heap dump completed (" << PrettySize(RoundUp(overall_size, KB))
-                << ") in " << PrettyDuration(duration)
-                << " objects " << total_objects_
-                << " objects with stack traces " << total_objects_with_stack_trace_;
+      LogInfo(android::base::StringPrintf(
+          "hprof: heap dump completed (%s) in %s objects %zu objects with stack traces %zu",
+          PrettySize(RoundUp(overall_size, KB)).c_str(),
+          PrettyDuration(duration).c_str(),
+          total_objects_,
+          total_objects_with_stack_trace_));
     }
+    return okay;
   }
 
  private:
+  // Another thread of the parent of a forked dump may have held the logging lock or a lock of
+  // the exception allocation at the fork. The forked dump writes its messages to stderr with
+  // write(2) instead, and its failure is thrown by the parent.
+  void WriteToStderr(const std::string& message) {
+    DCHECK(forked_);
+    std::string line = message + "\n";
+    UNUSED(TEMP_FAILURE_RETRY(write(STDERR_FILENO, line.data(), line.size())));
+  }
+
+  void LogInfo(const std::string& message) {
+    if (forked_) {
+      WriteToStderr(message);
+    } else {
+      LOG(INFO) << message;
+    }
+  }
+
+  void LogWarning(const std::string& message) {
+    if (forked_) {
+      WriteToStderr(message);
+    } else {
+      LOG(WARNING) << message;
+    }
+  }
+
+  void ThrowDumpFailure(const std::string& message) REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (forked_) {
+      WriteToStderr(message);
+    } else {
+      ThrowRuntimeException("%s", message.c_str());
+    }
+  }
+
   void DumpHeapObject(mirror::Object* obj)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -505,6 +564,69 @@ class Hprof : public SingleRootVisitor {
 
   bool AddRuntimeInternalObjectsField(mirror::Class* klass) REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Record for the index the offset of the sub-record of obj that is about to be written.
+  void IndexObject(mirror::Object* obj, mirror::Class* klass)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (index_objects_) {
+      indexed_objects_.push_back({ PointerToLowMemUInt32(obj),
+                                   PointerToLowMemUInt32(klass),
+                                   output_->SumLength() + output_->Length(),
+                                   static_cast<uint32_t>(obj->SizeOf()) });
+    }
+  }
+
+  // Write the index of the objects recorded while writing the dump, see kHprofIndexMagic.
+  void WriteIndex(const std::string& index_filename) REQUIRES_SHARED(Locks::mutator_lock_) {
+    std::unique_ptr<File> file(OS::CreateEmptyFileWriteOnly(index_filename.c_str()));
+    if (file == nullptr) {
+      LogWarning("hprof: couldn't create the heap dump index " + index_filename + ": " +
+                 strerror(errno));
+      return;
+    }
+    std::sort(indexed_objects_.begin(),
+              indexed_objects_.end(),
+              [](const IndexedObject& a, const IndexedObject& b) { return a.id < b.id; });
+    constexpr size_t kFlushSize = 64 * KB;
+    bool okay;
+    {
+      FileEndianOutput index_output(file.get(), kFlushSize + KB);
+      index_output.AddU1List(reinterpret_cast<const uint8_t*>(kHprofIndexMagic),
+                             sizeof(kHprofIndexMagic));
+      index_output.AddU4(classes_.size());
+      index_output.AddU4(indexed_objects_.size());
+      // The classes are ordered by address, that is by id.
+      for (const auto& p : classes_) {
+        std::string name = p.first->PrettyDescriptor();
+        index_output.AddObjectId(p.first);
+        index_output.AddU4(name.size());
+        index_output.AddUtf8String(name.c_str());
+        if (index_output.Length() >= kFlushSize) {
+          index_output.EndRecord();
+        }
+      }
+      for (const IndexedObject& object : indexed_objects_) {
+        index_output.AddU4(object.id);
+        index_output.AddU4(object.class_id);
+        index_output.AddU8(object.offset);
+        index_output.AddU4(object.size);
+        if (index_output.Length() >= kFlushSize) {
+          index_output.EndRecord();
+        }
+      }
+      index_output.EndRecord();
+      okay = !index_output.Errors();
+    }
+    if (!okay || file->FlushCloseOrErase() != 0) {
+      LogWarning("hprof: couldn't write the heap dump index " + index_filename + ": " +
+                 strerror(errno));
+      file->Erase();
+      return;
+    }
+    LogInfo(android::base::StringPrintf("hprof: wrote the index of %zu objects to %s",
+                                        indexed_objects_.size(),
+                                        index_filename.c_str()));
+  }
+
   void ProcessHeap(bool header_first)
       REQUIRES(Locks::mutator_lock_) {
     // Reset current heap and object count.
@@ -764,24 +886,31 @@ class Hprof : public SingleRootVisitor {
     if (fd_ >= 0) {
       out_fd = dup(fd_);
       if (out_fd < 0) {
-        ThrowRuntimeException("Couldn't dump heap; dup(%d) failed: %s", fd_, strerror(errno));
+        ThrowDumpFailure(android::base::StringPrintf("Couldn't dump heap; dup(%d) failed: %s",
+                                                     fd_,
+                                                     strerror(errno)));
         return false;
       }
     } else {
       out_fd = open(filename_.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
       if (out_fd < 0) {
-        ThrowRuntimeException("Couldn't dump heap; open(\"%s\") failed: %s", filename_.c_str(),
-                              strerror(errno));
+        ThrowDumpFailure(android::base::StringPrintf("Couldn't dump heap; open(\"%s\") failed: %s",
+                                                     filename_.c_str(),
+                                                     strerror(errno)));
         return false;
       }
     }
 
+    // The index needs the path of the dump, it is not written for the dumps to a descriptor.
+    const bool write_index = fd_ < 0 && Runtime::Current()->ShouldWriteHprofIndex();
     std::unique_ptr<File> file(new File(out_fd, filename_, true));
     bool okay;
     {
       FileEndianOutput file_output(file.get(), max_length);
       output_ = &file_output;
+      index_objects_ = write_index;
       ProcessHeap(true);
+      index_objects_ = false;
       okay = !file_output.Errors();
 
       if (okay) {
@@ -801,9 +930,14 @@ class Hprof : public SingleRootVisitor {
       std::string msg(android::base::StringPrintf("Couldn't dump heap; writing \"%s\" failed: %s",
                                                   filename_.c_str(),
                                                   strerror(errno)));
-      ThrowRuntimeException("%s", msg.c_str());
-      LOG(ERROR) << msg;
+      ThrowDumpFailure(msg);
+      if (!forked_) {
+        LOG(ERROR) << msg;
+      }
+    } else if (write_index) {
+      WriteIndex(filename_ + ".index");
     }
+    indexed_objects_.clear();
 
     return okay;
   }
@@ -885,11 +1019,26 @@ class Hprof : public SingleRootVisitor {
   std::string filename_;
   int fd_;
   bool direct_to_ddms_;
+  // Whether this dump runs in a child forked by ForkAndDumpHeap().
+  const bool forked_;
 
   uint64_t start_ns_ = NanoTime();
 
   EndianOutput* output_ = nullptr;
 
+  // An object of the heap dump index.
+  struct IndexedObject {
+    uint32_t id;
+    uint32_t class_id;
+    uint64_t offset;
+    uint32_t size;
+  };
+  static_assert(kHprofIndexObjectSize == 5 * sizeof(uint32_t), "Unexpected index object size");
+
+  // Whether the objects written are recorded in indexed_objects_.
+  bool index_objects_ = false;
+  std::vector<IndexedObject> indexed_objects_;
+
   HprofHeapId current_heap_ = HPROF_HEAP_DEFAULT;  // Which heap we're currently dumping.
   size_t objects_in_segment_ = 0;
 
@@ -1257,6 +1406,7 @@ void Hprof::DumpHeapClass(mirror::Class* klass) {
                                                     ? (java_heap_overhead_size == 3 ? 2u : 1u)
                                                     : 0;
 
+  IndexObject(klass, klass->GetClass());
   __ AddU1(HPROF_CLASS_DUMP);
   __ AddClassId(LookupClassId(klass));
   __ AddStackTraceSerialNumber(LookupStackTraceSerialNumber(klass));
@@ -1437,6 +1587,7 @@ void Hprof::DumpFakeObjectArray(mirror::Object* obj, const std::set<mirror::Obje
 void Hprof::DumpHeapArray(mirror::Array* obj, mirror::Class* klass) {
   uint32_t length = obj->GetLength();
 
+  IndexObject(obj, klass);
   if (obj->IsObjectArray()) {
     // obj is an object array.
     __ AddU1(HPROF_OBJECT_ARRAY_DUMP);
@@ -1478,6 +1629,7 @@ void Hprof::DumpHeapInstanceObject(mirror::Object* obj,
                                    mirror::Class* klass,
                                    const std::set<mirror::Object*>& fake_roots) {
   // obj is an instance object.
+  IndexObject(obj, klass);
   __ AddU1(HPROF_INSTANCE_DUMP);
   __ AddObjectId(obj);
   __ AddStackTraceSerialNumber(LookupStackTraceSerialNumber(obj));
@@ -1603,12 +1755,72 @@ void Hprof::VisitRoot(mirror::Object* obj, const RootInfo& info) {
   MarkRootObject(obj, 0, xlate[info.GetType()], info.GetThreadId());
 }
 
+// A forked dump still running after this long is assumed stuck and killed.
+static constexpr uint64_t kForkedDumpTimeoutMs = 10 * 60 * 1000;
+
+// Dump the heap to a file from a child forked while the threads are suspended, so that the
+// threads only pause for the fork. The child inherits a copy of the heap as it was at the fork,
+// its only thread is the dumping one. Returns false if the fork failed, for the caller to dump
+// in this process. Throws a RuntimeException if the child failed or was killed.
+static bool ForkAndDumpHeap(const char* filename, int fd) {
+  Thread* self = Thread::Current();
+  pid_t pid;
+  {
+    gc::ScopedGCCriticalSection gcs(self,
+                                    gc::kGcCauseHprof,
+                                    gc::kCollectorTypeHprof);
+    ScopedSuspendAll ssa(__FUNCTION__, true /* long suspend */);
+    // A thread attaching or detaching may hold the thread list lock without the mutator lock.
+    // Hold it across the fork, for the child not to wait on a thread it does not have.
+    Locks::thread_list_lock_->ExclusiveLock(self);
+    pid = fork();
+    Locks::thread_list_lock_->ExclusiveUnlock(self);
+    if (pid == 0) {
+      // _exit() rather than exit(), the exit handlers and static destructors are the parent's.
+      Hprof hprof(filename, fd, /* direct_to_ddms */ false, /* forked */ true);
+      _exit(hprof.Dump() ? 0 : 1);
+    }
+  }
+  if (pid < 0) {
+    PLOG(WARNING) << "hprof: fork failed, dumping the heap in this process";
+    return false;
+  }
+
+  int status = 0;
+  const uint64_t deadline_ms = MilliTime() + kForkedDumpTimeoutMs;
+  pid_t result;
+  while ((result = TEMP_FAILURE_RETRY(waitpid(pid, &status, WNOHANG))) == 0) {
+    if (MilliTime() > deadline_ms) {
+      LOG(ERROR) << "hprof: killing the heap dump process " << pid << " after "
+                 << PrettyDuration(MsToNs(kForkedDumpTimeoutMs));
+      kill(pid, SIGKILL);
+      result = TEMP_FAILURE_RETRY(waitpid(pid, &status, 0));
+      break;
+    }
+    usleep(10 * 1000);
+  }
+  if (result != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    ScopedObjectAccess soa(self);
+    ThrowRuntimeException("Couldn't dump heap; the heap dump process %d failed", pid);
+  } else {
+    LOG(INFO) << "hprof: heap dump \"" << filename << "\" completed by process " << pid;
+  }
+  return true;
+}
+
 // If "direct_to_ddms" is true, the other arguments are ignored, and data is
 // sent directly to DDMS.
 // If "fd" is >= 0, the output will be written to that file descriptor.
 // Otherwise, "filename" is used to create an output file.
+// With -XX:+ForkHeapDump, the dumps to files are written by a forked child.
+// With -XX:+HprofIndex, the dumps to "filename" are indexed in "filename".index.
 void DumpHeap(const char* filename, int fd, bool direct_to_ddms) {
   CHECK(filename != nullptr);
+  if (!direct_to_ddms &&
+      Runtime::Current()->ShouldForkHeapDump() &&
+      ForkAndDumpHeap(filename, fd)) {
+    return;
+  }
   Thread* self = Thread::Current();
   // Need to take a heap dump while GC isn't running. See the comment in Heap::VisitObjects().
   // Also we need the critical section to avoid visiting the same object twice. See b/34967844
@@ -27,6 +27,7 @@
 #include "thread.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <cstdlib>
 
 namespace art {
@@ -77,18 +78,11 @@ IndirectReferenceTable::IndirectReferenceTable(size_t max_count,
   // Overflow and maximum check.
   CHECK_LE(max_count, kMaxTableSizeInBytes / sizeof(IrtEntry));
 
-  const size_t table_bytes = max_count * sizeof(IrtEntry);
-  table_mem_map_.reset(MemMap::MapAnonymous("indirect ref table", nullptr, table_bytes,
-                                            PROT_READ | PROT_WRITE, false, false, error_msg));
-  if (table_mem_map_.get() == nullptr && error_msg->empty()) {
-    *error_msg = "Unable to map memory for indirect ref table";
-  }
-
-  if (table_mem_map_.get() != nullptr) {
-    table_ = reinterpret_cast<IrtEntry*>(table_mem_map_->Begin());
-  } else {
-    table_ = nullptr;
+  if (resizable_ == ResizableCapacity::kNo) {
+    chunks_.reserve(RoundUp(max_count, kIrtChunkEntries) / kIrtChunkEntries);
   }
+  // Only the first chunk is allocated up front, the others as the table grows.
+  AllocateChunks(1u);
   segment_state_ = kIRTFirstSegment;
   last_known_previous_state_ = kIRTFirstSegment;
 }
@@ -125,16 +119,26 @@ void IndirectReferenceTable::ConstexprChecks() {
 }
 
 bool IndirectReferenceTable::IsValid() const {
-  return table_mem_map_.get() != nullptr;
+  return !chunks_.empty();
+}
+
+void IndirectReferenceTable::AllocateChunks(size_t top_index) {
+  while (chunks_.size() * kIrtChunkEntries < top_index) {
+    // The entries are value-initialized: null references with serial 0.
+    DCHECK(resizable_ == ResizableCapacity::kYes || chunks_.size() < chunks_.capacity());
+    chunks_.emplace_back(new IrtEntry[kIrtChunkEntries]());
+  }
 }
 
 // Holes:
 //
 // To keep the IRT compact, we want to fill "holes" created by non-stack-discipline Add & Remove
-// operation sequences. For simplicity and lower memory overhead, we do not use a free list or
-// similar. Instead, we scan for holes, with the expectation that we will find holes fast as they
-// are usually near the end of the table (see the header, TODO: verify this assumption). To avoid
-// scans when there are no holes, the number of known holes should be tracked.
+// operation sequences. Remove records the index of each hole it makes in hole_indices_, and Add
+// takes the most recent one. A recorded index is only a hint: the hole may have been filled or
+// popped with its segment since, so Add checks it is still a null entry of the current segment,
+// and otherwise drops it. When no recorded index is usable, we scan for holes down from the top,
+// with the expectation that we will find holes fast as they are usually near the end of the
+// table. To avoid scans when there are no holes, the number of known holes should be tracked.
 //
 // A previous implementation stored the top index and the number of holes as the segment state.
 // This constraints the maximum number of references to 16-bit. We want to relax this, as it
@@ -163,10 +167,10 @@ bool IndirectReferenceTable::IsValid() const {
 // equal to the current previous state, and smaller than the current state (top index). The
 // condition is conservative as it adds O(1) overhead to operations on an empty segment.
 
-static size_t CountNullEntries(const IrtEntry* table, size_t from, size_t to) {
+size_t IndirectReferenceTable::CountNullEntries(size_t from, size_t to) const {
   size_t count = 0;
   for (size_t index = from; index != to; ++index) {
-    if (table[index].GetReference()->IsNull()) {
+    if (GetEntry(index)->GetReference()->IsNull()) {
       count++;
     }
   }
@@ -177,7 +181,7 @@ void IndirectReferenceTable::RecoverHoles(IRTSegmentState prev_state) {
   if (last_known_previous_state_.top_index >= segment_state_.top_index ||
       last_known_previous_state_.top_index < prev_state.top_index) {
     const size_t top_index = segment_state_.top_index;
-    size_t count = CountNullEntries(table_, prev_state.top_index, top_index);
+    size_t count = CountNullEntries(prev_state.top_index, top_index);
 
     if (kDebugIRT) {
       LOG(INFO) << "+++ Recovered holes: "
@@ -188,6 +192,9 @@ void IndirectReferenceTable::RecoverHoles(IRTSegmentState prev_state) {
     }
 
     current_num_holes_ = count;
+    if (count == 0) {
+      hole_indices_.clear();
+    }
     last_known_previous_state_ = prev_state;
   } else if (kDebugIRT) {
     LOG(INFO) << "No need to recover holes";
@@ -195,12 +202,11 @@ void IndirectReferenceTable::RecoverHoles(IRTSegmentState prev_state) {
 }
 
 ALWAYS_INLINE
-static inline void CheckHoleCount(IrtEntry* table,
-                                  size_t exp_num_holes,
-                                  IRTSegmentState prev_state,
-                                  IRTSegmentState cur_state) {
+inline void IndirectReferenceTable::CheckHoleCount(size_t exp_num_holes,
+                                                   IRTSegmentState prev_state,
+                                                   IRTSegmentState cur_state) const {
   if (kIsDebugBuild) {
-    size_t count = CountNullEntries(table, prev_state.top_index, cur_state.top_index);
+    size_t count = CountNullEntries(prev_state.top_index, cur_state.top_index);
     CHECK_EQ(exp_num_holes, count) << "prevState=" << prev_state.top_index
                                    << " topIndex=" << cur_state.top_index;
   }
@@ -216,26 +222,34 @@ bool IndirectReferenceTable::Resize(size_t new_size, std::string* error_msg) {
   }
   // Note: the above check also ensures that there is no overflow below.
 
-  const size_t table_bytes = new_size * sizeof(IrtEntry);
-  std::unique_ptr<MemMap> new_map(MemMap::MapAnonymous("indirect ref table",
-                                                       nullptr,
-                                                       table_bytes,
-                                                       PROT_READ | PROT_WRITE,
-                                                       false,
-                                                       false,
-                                                       error_msg));
-  if (new_map == nullptr) {
-    return false;
-  }
-
-  memcpy(new_map->Begin(), table_mem_map_->Begin(), table_mem_map_->Size());
-  table_mem_map_ = std::move(new_map);
-  table_ = reinterpret_cast<IrtEntry*>(table_mem_map_->Begin());
+  // The entries are not moved, the chunks past the current ones are allocated as they are used.
   max_entries_ = new_size;
 
   return true;
 }
 
+size_t IndirectReferenceTable::FindHole(size_t bottom_index, size_t top_index) {
+  // Take the most recently made hole that is still one.
+  while (!hole_indices_.empty()) {
+    const size_t index = hole_indices_.back();
+    hole_indices_.pop_back();
+    if (index >= bottom_index && index < top_index &&
+        GetEntry(index)->GetReference()->IsNull()) {
+      return index;
+    }
+  }
+  // Find the first hole; likely to be near the end of the list.
+  DCHECK_GT(top_index, 1U);
+  size_t index = top_index - 1;
+  DCHECK(!GetEntry(index)->GetReference()->IsNull());
+  --index;
+  while (!GetEntry(index)->GetReference()->IsNull()) {
+    DCHECK_GT(index, bottom_index);
+    --index;
+  }
+  return index;
+}
+
 IndirectRef IndirectReferenceTable::Add(IRTSegmentState previous_state,
                                         ObjPtr<mirror::Object> obj) {
   if (kDebugIRT) {
@@ -249,7 +263,7 @@ IndirectRef IndirectReferenceTable::Add(IRTSegmentState previous_state,
 
   CHECK(obj != nullptr);
   VerifyObject(obj);
-  DCHECK(table_ != nullptr);
+  DCHECK(IsValid());
 
   if (top_index == max_entries_) {
     if (resizable_ == ResizableCapacity::kNo) {
@@ -279,7 +293,7 @@ IndirectRef IndirectReferenceTable::Add(IRTSegmentState previous_state,
   }
 
   RecoverHoles(previous_state);
-  CheckHoleCount(table_, current_num_holes_, previous_state, segment_state_);
+  CheckHoleCount(current_num_holes_, previous_state, segment_state_);
 
   // We know there's enough room in the table.  Now we just need to find
   // the right spot.  If there's a hole, find it and fill it; otherwise,
@@ -287,23 +301,18 @@ IndirectRef IndirectReferenceTable::Add(IRTSegmentState previous_state,
   IndirectRef result;
   size_t index;
   if (current_num_holes_ > 0) {
-    DCHECK_GT(top_index, 1U);
-    // Find the first hole; likely to be near the end of the list.
-    IrtEntry* p_scan = &table_[top_index - 1];
-    DCHECK(!p_scan->GetReference()->IsNull());
-    --p_scan;
-    while (!p_scan->GetReference()->IsNull()) {
-      DCHECK_GE(p_scan, table_ + previous_state.top_index);
-      --p_scan;
-    }
-    index = p_scan - table_;
+    index = FindHole(previous_state.top_index, top_index);
     current_num_holes_--;
+    if (current_num_holes_ == 0) {
+      hole_indices_.clear();
+    }
   } else {
     // Add to the end.
     index = top_index++;
+    AllocateChunks(top_index);
     segment_state_.top_index = top_index;
   }
-  table_[index].Add(obj);
+  GetEntry(index)->Add(obj);
   result = ToIndirectRef(index);
   if (kDebugIRT) {
     LOG(INFO) << "+++ added at " << ExtractIndex(result) << " top=" << segment_state_.top_index
@@ -316,7 +325,7 @@ IndirectRef IndirectReferenceTable::Add(IRTSegmentState previous_state,
 
 void IndirectReferenceTable::AssertEmpty() {
   for (size_t i = 0; i < Capacity(); ++i) {
-    if (!table_[i].GetReference()->IsNull()) {
+    if (!GetEntry(i)->GetReference()->IsNull()) {
       LOG(FATAL) << "Internal Error: non-empty local reference table\n"
                  << MutatorLockedDumpable<IndirectReferenceTable>(*this);
       UNREACHABLE();
@@ -343,7 +352,7 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
   const uint32_t top_index = segment_state_.top_index;
   const uint32_t bottom_index = previous_state.top_index;
 
-  DCHECK(table_ != nullptr);
+  DCHECK(IsValid());
 
   if (GetIndirectRefKind(iref) == kHandleScopeOrInvalid) {
     auto* self = Thread::Current();
@@ -375,7 +384,7 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
   }
 
   RecoverHoles(previous_state);
-  CheckHoleCount(table_, current_num_holes_, previous_state, segment_state_);
+  CheckHoleCount(current_num_holes_, previous_state, segment_state_);
 
   if (idx == top_index - 1) {
     // Top-most entry.  Scan up and consume holes.
@@ -384,7 +393,7 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
       return false;
     }
 
-    *table_[idx].GetReference() = GcRoot<mirror::Object>(nullptr);
+    *GetEntry(idx)->GetReference() = GcRoot<mirror::Object>(nullptr);
     if (current_num_holes_ != 0) {
       uint32_t collapse_top_index = top_index;
       while (--collapse_top_index > bottom_index && current_num_holes_ != 0) {
@@ -392,9 +401,10 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
           ScopedObjectAccess soa(Thread::Current());
           LOG(INFO) << "+++ checking for hole at " << collapse_top_index - 1
                     << " (previous_state=" << bottom_index << ") val="
-                    << table_[collapse_top_index - 1].GetReference()->Read<kWithoutReadBarrier>();
+                    << GetEntry(collapse_top_index - 1)->GetReference()
+                           ->Read<kWithoutReadBarrier>();
         }
-        if (!table_[collapse_top_index - 1].GetReference()->IsNull()) {
+        if (!GetEntry(collapse_top_index - 1)->GetReference()->IsNull()) {
           break;
         }
         if (kDebugIRT) {
@@ -403,8 +413,11 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
         current_num_holes_--;
       }
       segment_state_.top_index = collapse_top_index;
+      if (current_num_holes_ == 0) {
+        hole_indices_.clear();
+      }
 
-      CheckHoleCount(table_, current_num_holes_, previous_state, segment_state_);
+      CheckHoleCount(current_num_holes_, previous_state, segment_state_);
     } else {
       segment_state_.top_index = top_index - 1;
       if (kDebugIRT) {
@@ -414,7 +427,7 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
   } else {
     // Not the top-most entry.  This creates a hole.  We null out the entry to prevent somebody
     // from deleting it twice and screwing up the hole count.
-    if (table_[idx].GetReference()->IsNull()) {
+    if (GetEntry(idx)->GetReference()->IsNull()) {
       LOG(INFO) << "--- WEIRD: removing null entry " << idx;
       return false;
     }
@@ -422,9 +435,14 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
       return false;
     }
 
-    *table_[idx].GetReference() = GcRoot<mirror::Object>(nullptr);
+    *GetEntry(idx)->GetReference() = GcRoot<mirror::Object>(nullptr);
     current_num_holes_++;
-    CheckHoleCount(table_, current_num_holes_, previous_state, segment_state_);
+    if (hole_indices_.size() >= top_index) {
+      // Most of the recorded holes are stale, start over rather than growing without bound.
+      hole_indices_.clear();
+    }
+    hole_indices_.push_back(idx);
+    CheckHoleCount(current_num_holes_, previous_state, segment_state_);
     if (kDebugIRT) {
       LOG(INFO) << "+++ left hole at " << idx << ", holes=" << current_num_holes_;
     }
@@ -436,9 +454,13 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
 void IndirectReferenceTable::Trim() {
   ScopedTrace trace(__PRETTY_FUNCTION__);
   const size_t top_index = Capacity();
-  auto* release_start = AlignUp(reinterpret_cast<uint8_t*>(&table_[top_index]), kPageSize);
-  uint8_t* release_end = table_mem_map_->End();
-  madvise(release_start, release_end - release_start, MADV_DONTNEED);
+  // Keep the first chunk, so that the table stays valid.
+  const size_t num_chunks =
+      std::max<size_t>(RoundUp(top_index, kIrtChunkEntries) / kIrtChunkEntries, 1u);
+  if (num_chunks < chunks_.size()) {
+    // Shrinking does not reallocate the array of chunks.
+    chunks_.resize(num_chunks);
+  }
 }
 
 void IndirectReferenceTable::VisitRoots(RootVisitor* visitor, const RootInfo& root_info) {
@@ -455,9 +477,9 @@ void IndirectReferenceTable::Dump(std::ostream& os) const {
   os << kind_ << " table dump:\n";
   ReferenceTable::Table entries;
   for (size_t i = 0; i < Capacity(); ++i) {
-    ObjPtr<mirror::Object> obj = table_[i].GetReference()->Read<kWithoutReadBarrier>();
+    ObjPtr<mirror::Object> obj = GetEntry(i)->GetReference()->Read<kWithoutReadBarrier>();
     if (obj != nullptr) {
-      obj = table_[i].GetReference()->Read();
+      obj = GetEntry(i)->GetReference()->Read();
       entries.push_back(GcRoot<mirror::Object>(obj));
     }
   }
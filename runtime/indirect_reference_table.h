@@ -21,12 +21,15 @@
 
 #include <iosfwd>
 #include <limits>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "base/bit_utils.h"
 #include "base/logging.h"
 #include "base/mutex.h"
 #include "gc_root.h"
+#include "globals.h"
 #include "obj_ptr.h"
 #include "offsets.h"
 #include "read_barrier_option.h"
@@ -39,8 +42,6 @@ namespace mirror {
 class Object;
 }  // namespace mirror
 
-class MemMap;
-
 // Maintain a table of indirect references.  Used for local/global JNI references.
 //
 // The table contains object references, where the strong (local/global) references are part of the
@@ -132,8 +133,13 @@ const char* GetIndirectRefKindString(const IndirectRefKind& kind);
 // detect stale references aren't possible (though we may be able to get similar benefits with other
 // approaches).
 //
-// TODO: consider a "lastDeleteIndex" for quick hole-filling when an add immediately follows a
-// delete; must invalidate after segment pop might be worth only using it for JNI globals.
+// The indices of the holes are also recorded as they are made, so that adding an entry usually
+// fills a hole without scanning for it. The record is only a hint: a hole may have been consumed
+// or popped with its segment since, which Add checks before using it.
+//
+// The table is stored in chunks of a page, allocated as the table grows, so that the memory used
+// follows the number of references rather than the maximum. An index maps to its entry through
+// the array of chunks, and the chunks are never moved.
 //
 // TODO: may want completely different add/remove algorithms for global and local refs to improve
 // performance.  A large circular buffer might reduce the amortized cost of adding global
@@ -181,10 +187,16 @@ static_assert(sizeof(IrtEntry) == (1 + kIRTPrevCount) * sizeof(uint32_t),
               "Unexpected sizeof(IrtEntry)");
 static_assert(IsPowerOfTwo(sizeof(IrtEntry)), "Unexpected sizeof(IrtEntry)");
 
+// Number of entries in a chunk of the table.
+static constexpr size_t kIrtChunkEntries = kPageSize / sizeof(IrtEntry);
+static constexpr size_t kIrtChunkShift = WhichPowerOf2(kIrtChunkEntries);
+static constexpr size_t kIrtChunkMask = kIrtChunkEntries - 1;
+
 class IrtIterator {
  public:
-  IrtIterator(IrtEntry* table, size_t i, size_t capacity) REQUIRES_SHARED(Locks::mutator_lock_)
-      : table_(table), i_(i), capacity_(capacity) {
+  IrtIterator(const std::unique_ptr<IrtEntry[]>* chunks, size_t i, size_t capacity)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      : chunks_(chunks), i_(i), capacity_(capacity) {
   }
 
   IrtIterator& operator++() REQUIRES_SHARED(Locks::mutator_lock_) {
@@ -194,15 +206,15 @@ class IrtIterator {
 
   GcRoot<mirror::Object>* operator*() REQUIRES_SHARED(Locks::mutator_lock_) {
     // This does not have a read barrier as this is used to visit roots.
-    return table_[i_].GetReference();
+    return chunks_[i_ >> kIrtChunkShift][i_ & kIrtChunkMask].GetReference();
   }
 
   bool equals(const IrtIterator& rhs) const {
-    return (i_ == rhs.i_ && table_ == rhs.table_);
+    return (i_ == rhs.i_ && chunks_ == rhs.chunks_);
   }
 
  private:
-  IrtEntry* const table_;
+  const std::unique_ptr<IrtEntry[]>* const chunks_;
   size_t i_;
   const size_t capacity_;
 };
@@ -293,11 +305,11 @@ class IndirectReferenceTable {
 
   // Note IrtIterator does not have a read barrier as it's used to visit roots.
   IrtIterator begin() {
-    return IrtIterator(table_, 0, Capacity());
+    return IrtIterator(chunks_.data(), 0, Capacity());
   }
 
   IrtIterator end() {
-    return IrtIterator(table_, Capacity(), Capacity());
+    return IrtIterator(chunks_.data(), Capacity(), Capacity());
   }
 
   void VisitRoots(RootVisitor* visitor, const RootInfo& root_info)
@@ -316,7 +328,7 @@ class IndirectReferenceTable {
     return Offset(0);
   }
 
-  // Release pages past the end of the table that may have previously held references.
+  // Release the chunks past the end of the table that may have previously held references.
   void Trim() REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Determine what kind of indirect reference this is. Opposite of EncodeIndirectRefKind.
@@ -370,15 +382,34 @@ class IndirectReferenceTable {
 
   IndirectRef ToIndirectRef(uint32_t table_index) const {
     DCHECK_LT(table_index, max_entries_);
-    uint32_t serial = table_[table_index].GetSerial();
+    uint32_t serial = GetEntry(table_index)->GetSerial();
     return reinterpret_cast<IndirectRef>(EncodeIndirectRef(table_index, serial));
   }
 
-  // Resize the backing table. Currently must be larger than the current size.
+  IrtEntry* GetEntry(size_t table_index) {
+    return &chunks_[table_index >> kIrtChunkShift][table_index & kIrtChunkMask];
+  }
+
+  const IrtEntry* GetEntry(size_t table_index) const {
+    return &chunks_[table_index >> kIrtChunkShift][table_index & kIrtChunkMask];
+  }
+
+  // Raise the maximum number of entries. Currently must be larger than the current maximum.
   bool Resize(size_t new_size, std::string* error_msg);
 
+  // Allocate the chunks holding the entries below top_index.
+  void AllocateChunks(size_t top_index);
+
   void RecoverHoles(IRTSegmentState from);
 
+  size_t CountNullEntries(size_t from, size_t to) const;
+  void CheckHoleCount(size_t exp_num_holes,
+                      IRTSegmentState prev_state,
+                      IRTSegmentState cur_state) const;
+
+  // Return the index of a hole between bottom_index and top_index, there must be one.
+  size_t FindHole(size_t bottom_index, size_t top_index);
+
   // Abort if check_jni is not enabled. Otherwise, just log as an error.
   static void AbortIfNoCheckJNI(const std::string& msg);
 
@@ -389,11 +420,11 @@ class IndirectReferenceTable {
   /// semi-public - read/write by jni down calls.
   IRTSegmentState segment_state_;
 
-  // Mem map where we store the indirect refs.
-  std::unique_ptr<MemMap> table_mem_map_;
-  // bottom of the stack. Do not directly access the object references
-  // in this as they are roots. Use Get() that has a read barrier.
-  IrtEntry* table_;
+  // The chunks where we store the indirect refs, bottom of the stack first. Do not directly
+  // access the object references in these as they are roots. Use Get() that has a read barrier.
+  // Non-resizable tables reserve the array for all their chunks up front, so that it is not
+  // reallocated under SynchronizedGet().
+  std::vector<std::unique_ptr<IrtEntry[]>> chunks_;
   // bit mask, ORed into all irefs.
   const IndirectRefKind kind_;
 
@@ -402,10 +433,12 @@ class IndirectReferenceTable {
 
   // Some values to retain old behavior with holes. Description of the algorithm is in the .cc
   // file.
-  // TODO: Consider other data structures for compact tables, e.g., free lists.
   size_t current_num_holes_;
   IRTSegmentState last_known_previous_state_;
 
+  // The indices of the holes made by Remove, most recent last. Stale indices are skipped by Add.
+  std::vector<uint32_t> hole_indices_;
+
   // Whether the table's capacity may be resized. As there are no locks used, it is the caller's
   // responsibility to ensure thread-safety.
   ResizableCapacity resizable_;
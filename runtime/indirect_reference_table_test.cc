@@ -510,4 +510,60 @@ TEST_F(IndirectReferenceTableTest, Resize) {
   EXPECT_EQ(irt.Capacity(), kTableMax + 1);
 }
 
+TEST_F(IndirectReferenceTableTest, ChunksAndHoles) {
+  ScopedObjectAccess soa(Thread::Current());
+  static const size_t kTableMax = 4 * kIrtChunkEntries;
+
+  mirror::Class* c = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  StackHandleScope<2> hs(soa.Self());
+  ASSERT_TRUE(c != nullptr);
+  Handle<mirror::Object> obj0 = hs.NewHandle(c->AllocObject(soa.Self()));
+  ASSERT_TRUE(obj0 != nullptr);
+  Handle<mirror::Object> obj1 = hs.NewHandle(c->AllocObject(soa.Self()));
+  ASSERT_TRUE(obj1 != nullptr);
+
+  std::string error_msg;
+  IndirectReferenceTable irt(kTableMax,
+                             kGlobal,
+                             IndirectReferenceTable::ResizableCapacity::kNo,
+                             &error_msg);
+  ASSERT_TRUE(irt.IsValid()) << error_msg;
+  const IRTSegmentState cookie = kIRTFirstSegment;
+
+  // Fill the table past its first chunks.
+  std::vector<IndirectRef> irefs;
+  for (size_t i = 0; i != 3 * kIrtChunkEntries; ++i) {
+    irefs.push_back(irt.Add(cookie, obj0.Get()));
+  }
+  EXPECT_EQ(3 * kIrtChunkEntries, irt.Capacity());
+
+  // Holes in different chunks are filled, the most recent first, without growing the table.
+  const size_t hole0 = kIrtChunkEntries / 2;
+  const size_t hole1 = 2 * kIrtChunkEntries + 1;
+  ASSERT_TRUE(irt.Remove(cookie, irefs[hole0]));
+  ASSERT_TRUE(irt.Remove(cookie, irefs[hole1]));
+  EXPECT_TRUE(irt.Get(irefs[hole0]) == nullptr);
+  irefs[hole1] = irt.Add(cookie, obj1.Get());
+  irefs[hole0] = irt.Add(cookie, obj1.Get());
+  EXPECT_EQ(3 * kIrtChunkEntries, irt.Capacity());
+  EXPECT_OBJ_PTR_EQ(obj1.Get(), irt.Get(irefs[hole0]));
+  EXPECT_OBJ_PTR_EQ(obj1.Get(), irt.Get(irefs[hole1]));
+
+  // Pop to the middle of the first chunk and release the chunks above.
+  while (irt.Capacity() > hole0 + 1) {
+    ASSERT_TRUE(irt.Remove(cookie, irefs.back()));
+    irefs.pop_back();
+  }
+  irt.Trim();
+  EXPECT_OBJ_PTR_EQ(obj1.Get(), irt.Get(irefs[hole0]));
+  EXPECT_OBJ_PTR_EQ(obj0.Get(), irt.Get(irefs[0]));
+
+  // The released chunks are allocated again as the table grows.
+  for (size_t i = irt.Capacity(); i != kTableMax; ++i) {
+    irefs.push_back(irt.Add(cookie, obj0.Get()));
+  }
+  EXPECT_EQ(kTableMax, irt.Capacity());
+  EXPECT_OBJ_PTR_EQ(obj0.Get(), irt.Get(irefs.back()));
+}
+
 }  // namespace art
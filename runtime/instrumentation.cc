@@ -40,6 +40,7 @@
 #include "mirror/object-inl.h"
 #include "nth_caller_visitor.h"
 #include "oat_quick_method_header.h"
+#include "stack_map.h"
 #include "thread.h"
 #include "thread_list.h"
 
@@ -139,6 +140,28 @@ bool Instrumentation::NeedDebugVersionFor(ArtMethod* method) const REQUIRES_SHAR
          !method->IsProxyMethod();
 }
 
+// Does the compiled code of method contain methods it inlined? Their entries and exits do not go
+// through the instrumentation stubs: with the stubs only, the method is interpreted, the other
+// methods keep their compiled code.
+static bool CodeInlinesMethods(ArtMethod* method) REQUIRES_SHARED(Locks::mutator_lock_) {
+  if (method->IsNative()) {
+    return false;
+  }
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  const void* quick_code = class_linker->GetQuickOatCodeFor(method);
+  if (class_linker->IsQuickToInterpreterBridge(quick_code) ||
+      class_linker->IsQuickResolutionStub(quick_code) ||
+      class_linker->IsQuickGenericJniStub(quick_code)) {
+    return false;
+  }
+  const OatQuickMethodHeader* method_header = OatQuickMethodHeader::FromEntryPoint(quick_code);
+  if (!method_header->IsOptimized()) {
+    return false;
+  }
+  CodeInfo code_info = method_header->GetOptimizedCodeInfo();
+  return code_info.HasInlineInfo(code_info.ExtractEncoding());
+}
+
 void Instrumentation::InstallStubsForMethod(ArtMethod* method) {
   if (!method->IsInvokable() || method->IsProxyMethod()) {
     // Do not change stubs for these methods.
@@ -179,6 +202,8 @@ void Instrumentation::InstallStubsForMethod(ArtMethod* method) {
           // Oat code should not be used. Don't install instrumentation stub and
           // use interpreter for instrumentation.
           new_quick_code = GetQuickToInterpreterBridge();
+        } else if (entry_exit_stubs_installed_ && CodeInlinesMethods(method)) {
+          new_quick_code = GetQuickToInterpreterBridge();
         } else if (entry_exit_stubs_installed_) {
           new_quick_code = GetQuickInstrumentationEntryPoint();
         } else {
@@ -739,6 +764,9 @@ void Instrumentation::UpdateMethodsCodeImpl(ArtMethod* method, const void* quick
       if (class_linker->IsQuickResolutionStub(quick_code) ||
           class_linker->IsQuickToInterpreterBridge(quick_code)) {
         new_quick_code = quick_code;
+      } else if (entry_exit_stubs_installed_ && CodeInlinesMethods(method)) {
+        // The instrumentation entry point runs the oat code, not quick_code.
+        new_quick_code = GetQuickToInterpreterBridge();
       } else if (entry_exit_stubs_installed_) {
         new_quick_code = GetQuickInstrumentationEntryPoint();
       } else {
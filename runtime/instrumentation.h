@@ -52,7 +52,8 @@ enum InterpreterHandlerTable {
 
 // Do we want to deoptimize for method entry and exit listeners or just try to intercept
 // invocations? Deoptimization forces all code to run in the interpreter and considerably hurts the
-// application's performance.
+// application's performance. The stubs only interpret the methods whose compiled code inlined
+// other methods, but still miss the recursive calls and intrinsics of non-debuggable code.
 static constexpr bool kDeoptimizeForAccurateMethodEntryExitListeners = true;
 
 // Instrumentation event listener API. Registered listeners will get the appropriate call back for
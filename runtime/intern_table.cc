@@ -37,7 +37,8 @@ namespace art {
 InternTable::InternTable()
     : log_new_roots_(false),
       weak_intern_condition_("New intern condition", *Locks::intern_table_lock_),
-      weak_root_state_(gc::kWeakRootStateNormal) {
+      weak_root_state_(gc::kWeakRootStateNormal),
+      strong_tables_from_memory_(nullptr) {
 }
 
 size_t InternTable::Size() const {
@@ -93,7 +94,25 @@ ObjPtr<mirror::String> InternTable::LookupWeak(Thread* self, ObjPtr<mirror::Stri
   return LookupWeakLocked(s);
 }
 
+template <typename Key>
+ObjPtr<mirror::String> InternTable::LookupStrongInTablesFromMemory(const Key& key) {
+  const std::vector<Table::UnorderedSet>* tables = strong_tables_from_memory_.LoadAcquire();
+  if (tables != nullptr) {
+    for (const Table::UnorderedSet& table : *tables) {
+      auto it = table.Find(key);
+      if (it != table.end()) {
+        return it->Read();
+      }
+    }
+  }
+  return nullptr;
+}
+
 ObjPtr<mirror::String> InternTable::LookupStrong(Thread* self, ObjPtr<mirror::String> s) {
+  ObjPtr<mirror::String> strong = LookupStrongInTablesFromMemory(GcRoot<mirror::String>(s));
+  if (strong != nullptr) {
+    return strong;
+  }
   MutexLock mu(self, *Locks::intern_table_lock_);
   return LookupStrongLocked(s);
 }
@@ -105,6 +124,10 @@ ObjPtr<mirror::String> InternTable::LookupStrong(Thread* self,
   Utf8String string(utf16_length,
                     utf8_data,
                     ComputeUtf16HashFromModifiedUtf8(utf8_data, utf16_length));
+  ObjPtr<mirror::String> strong = LookupStrongInTablesFromMemory(string);
+  if (strong != nullptr) {
+    return strong;
+  }
   MutexLock mu(self, *Locks::intern_table_lock_);
   return strong_interns_.Find(string);
 }
@@ -214,6 +237,11 @@ ObjPtr<mirror::String> InternTable::Insert(ObjPtr<mirror::String> s,
   if (s == nullptr) {
     return nullptr;
   }
+  // The strings of the images are the most common interns, find them without the lock.
+  ObjPtr<mirror::String> image_strong = LookupStrongInTablesFromMemory(GcRoot<mirror::String>(s));
+  if (image_strong != nullptr) {
+    return image_strong;
+  }
   Thread* const self = Thread::Current();
   MutexLock mu(self, *Locks::intern_table_lock_);
   if (kDebugLocking && !holding_locks) {
@@ -309,7 +337,23 @@ size_t InternTable::AddTableFromMemory(const uint8_t* ptr) {
 }
 
 size_t InternTable::AddTableFromMemoryLocked(const uint8_t* ptr) {
-  return strong_interns_.AddTableFromMemory(ptr);
+  size_t read_count = strong_interns_.AddTableFromMemory(ptr);
+  // Publish the tables read so far, including the new one, for the lookups without the lock.
+  // The sets do not copy the data in memory, so they are cheap to recreate.
+  strong_table_from_memory_ptrs_.push_back(ptr);
+  std::unique_ptr<std::vector<Table::UnorderedSet>> tables(
+      new std::vector<Table::UnorderedSet>());
+  tables->reserve(strong_table_from_memory_ptrs_.size());
+  for (const uint8_t* table_ptr : strong_table_from_memory_ptrs_) {
+    size_t table_read_count = 0;
+    Table::UnorderedSet table(table_ptr, /*make copy*/false, &table_read_count);
+    if (!table.Empty()) {
+      tables->push_back(std::move(table));
+    }
+  }
+  strong_tables_from_memory_.StoreRelease(tables.get());
+  strong_tables_from_memory_arrays_.push_back(std::move(tables));
+  return read_count;
 }
 
 size_t InternTable::WriteToMemory(uint8_t* ptr) {
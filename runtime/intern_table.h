@@ -17,7 +17,9 @@
 #ifndef ART_RUNTIME_INTERN_TABLE_H_
 #define ART_RUNTIME_INTERN_TABLE_H_
 
+#include <memory>
 #include <unordered_set>
+#include <vector>
 
 #include "atomic.h"
 #include "base/allocator.h"
@@ -186,6 +188,9 @@ class InternTable {
   // weak interns and strong interns.
   class Table {
    public:
+    typedef HashSet<GcRoot<mirror::String>, GcRootEmptyFn, StringHashEquals, StringHashEquals,
+        TrackingAllocator<GcRoot<mirror::String>, kAllocatorTagInternTable>> UnorderedSet;
+
     Table();
     ObjPtr<mirror::String> Find(ObjPtr<mirror::String> s) REQUIRES_SHARED(Locks::mutator_lock_)
         REQUIRES(Locks::intern_table_lock_);
@@ -213,9 +218,6 @@ class InternTable {
         REQUIRES(Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
 
    private:
-    typedef HashSet<GcRoot<mirror::String>, GcRootEmptyFn, StringHashEquals, StringHashEquals,
-        TrackingAllocator<GcRoot<mirror::String>, kAllocatorTagInternTable>> UnorderedSet;
-
     void SweepWeaks(UnorderedSet* set, IsMarkedVisitor* visitor)
         REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
 
@@ -232,6 +234,12 @@ class InternTable {
   ObjPtr<mirror::String> Insert(ObjPtr<mirror::String> s, bool is_strong, bool holding_locks)
       REQUIRES(!Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Lookup a strong intern in the tables read from memory, without the intern table lock.
+  // Returns null if not found, the string may still be in the other strong tables.
+  template <typename Key>
+  ObjPtr<mirror::String> LookupStrongInTablesFromMemory(const Key& key)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   ObjPtr<mirror::String> LookupStrongLocked(ObjPtr<mirror::String> s)
       REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
   ObjPtr<mirror::String> LookupWeakLocked(ObjPtr<mirror::String> s)
@@ -281,6 +289,15 @@ class InternTable {
   Table weak_interns_ GUARDED_BY(Locks::intern_table_lock_);
   // Weak root state, used for concurrent system weak processing and more.
   gc::WeakRootState weak_root_state_ GUARDED_BY(Locks::intern_table_lock_);
+  // The strong tables read from memory, that is the intern tables of the images. They are never
+  // modified once read, so the lookups first search them without the intern table lock, in the
+  // array published last. Each added table publishes a new array, the previous arrays are kept
+  // for the readers still searching them.
+  Atomic<const std::vector<Table::UnorderedSet>*> strong_tables_from_memory_;
+  std::vector<const uint8_t*> strong_table_from_memory_ptrs_
+      GUARDED_BY(Locks::intern_table_lock_);
+  std::vector<std::unique_ptr<std::vector<Table::UnorderedSet>>> strong_tables_from_memory_arrays_
+      GUARDED_BY(Locks::intern_table_lock_);
 
   friend class Transaction;
   ART_FRIEND_TEST(InternTableTest, CrossHash);
@@ -16,6 +16,8 @@
 
 #include "intern_table.h"
 
+#include <vector>
+
 #include "base/hash_set.h"
 #include "common_runtime_test.h"
 #include "gc_root-inl.h"
@@ -234,4 +236,32 @@ TEST_F(InternTableTest, LookupStrong) {
   EXPECT_TRUE(lookup_foobbS == nullptr);
 }
 
+TEST_F(InternTableTest, LookupStrongFromMemory) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<3> hs(soa.Self());
+  InternTable image_intern_table;
+  Handle<mirror::String> foo(hs.NewHandle(image_intern_table.InternStrong(3, "foo")));
+  Handle<mirror::String> bar(hs.NewHandle(image_intern_table.InternStrong(3, "bar")));
+  ASSERT_TRUE(foo != nullptr);
+  ASSERT_TRUE(bar != nullptr);
+  // Read the table back from memory, as for an image.
+  std::vector<uint64_t> memory(RoundUp(image_intern_table.WriteToMemory(nullptr),
+                                       sizeof(uint64_t)) / sizeof(uint64_t));
+  image_intern_table.WriteToMemory(reinterpret_cast<uint8_t*>(memory.data()));
+  InternTable intern_table;
+  intern_table.AddTableFromMemory(reinterpret_cast<const uint8_t*>(memory.data()));
+  EXPECT_EQ(2u, intern_table.StrongSize());
+
+  EXPECT_OBJ_PTR_EQ(intern_table.LookupStrong(soa.Self(), 3, "foo"), foo.Get());
+  EXPECT_OBJ_PTR_EQ(intern_table.LookupStrong(soa.Self(), bar.Get()), bar.Get());
+  EXPECT_OBJ_PTR_EQ(intern_table.InternStrong(3, "bar"), bar.Get());
+  EXPECT_TRUE(intern_table.LookupStrong(soa.Self(), 6, "foobar") == nullptr);
+
+  // Strings interned later are still found, under the lock.
+  Handle<mirror::String> foobar(hs.NewHandle(intern_table.InternStrong(6, "foobar")));
+  ASSERT_TRUE(foobar != nullptr);
+  EXPECT_OBJ_PTR_EQ(intern_table.LookupStrong(soa.Self(), 6, "foobar"), foobar.Get());
+  EXPECT_EQ(3u, intern_table.StrongSize());
+}
+
 }  // namespace art
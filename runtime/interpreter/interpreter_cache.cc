@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2015 Intel Corporation
+ * Copyright (C) 2018 The Android Open Source Project
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -12,27 +12,22 @@
  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
  * See the License for the specific language governing permissions and
  * limitations under the License.
- *
  */
 
-#ifndef ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_GVN_AFTER_PEELING_H_
-#define ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_GVN_AFTER_PEELING_H_
-
-#include "nodes.h"
-#include "optimization_x86.h"
+#include "interpreter_cache.h"
 
 namespace art {
 
-class GVNAfterPeeling : public HOptimization_X86 {
- public:
-  explicit GVNAfterPeeling(HGraph* graph)
-    : HOptimization_X86(graph, kGVNAfterPeelingPassName) {}
+Atomic<uint32_t> InterpreterCache::generation_(0u);
 
-  static constexpr const char* kGVNAfterPeelingPassName = "GVN_after_peeling";
+InterpreterCache::InterpreterCache() : cached_generation_(generation_.LoadRelaxed()) {
+  Clear();
+}
 
-  void Run() OVERRIDE;
-};
+void InterpreterCache::Clear() {
+  for (Entry& entry : entries_) {
+    entry = Entry { nullptr, 0u };
+  }
+}
 
 }  // namespace art
-
-#endif  // ART_COMPILER_OPTIMIZING_EXTENSIONS_PASSES_GVN_PEELING_H_
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_INTERPRETER_INTERPRETER_CACHE_H_
+#define ART_RUNTIME_INTERPRETER_INTERPRETER_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "atomic.h"
+#include "base/bit_utils.h"
+#include "base/macros.h"
+
+namespace art {
+
+// A small direct-mapped cache of the values the interpreter resolved for an instruction, keyed
+// by the address of the instruction, e.g. the ArtField of a field access. A hit replaces the
+// dex cache lookup and the checks of the resolution, which dominate the cost of the field
+// accesses of cold code.
+//
+// Each thread has its own cache, only used by the thread itself, so no synchronization is needed.
+// The entries may refer to the fields of unloaded class loaders, and the keys to the instructions
+// of their unmapped dex files. The unloading of class loaders therefore moves to a new
+// generation, and a cache of an older generation is cleared before its next use.
+class InterpreterCache {
+ public:
+  // Number of entries, must be a power of 2.
+  static constexpr size_t kSize = 256;
+
+  InterpreterCache();
+
+  // Look up the value of key, returns false on a miss.
+  ALWAYS_INLINE bool Get(const void* key, size_t* value) {
+    uint32_t generation = generation_.LoadRelaxed();
+    if (UNLIKELY(generation != cached_generation_)) {
+      Clear();
+      cached_generation_ = generation;
+      return false;
+    }
+    const Entry& entry = entries_[IndexOf(key)];
+    if (entry.key == key) {
+      *value = entry.value;
+      return true;
+    }
+    return false;
+  }
+
+  ALWAYS_INLINE void Set(const void* key, size_t value) {
+    entries_[IndexOf(key)] = Entry { key, value };
+  }
+
+  void Clear();
+
+  // Called before the data of unloaded class loaders is freed.
+  static void NotifyClassLoadersUnloaded() {
+    generation_.FetchAndAddSequentiallyConsistent(1u);
+  }
+
+ private:
+  struct Entry {
+    const void* key;
+    size_t value;
+  };
+
+  static size_t IndexOf(const void* key) {
+    static_assert(IsPowerOfTwo(kSize), "Interpreter cache size is not a power of 2");
+    // Instructions are at least 2 bytes.
+    return (reinterpret_cast<uintptr_t>(key) >> 1) & (kSize - 1u);
+  }
+
+  Entry entries_[kSize];
+  uint32_t cached_generation_;
+
+  static Atomic<uint32_t> generation_;
+
+  DISALLOW_COPY_AND_ASSIGN(InterpreterCache);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_INTERPRETER_INTERPRETER_CACHE_H_
@@ -21,6 +21,7 @@
 #include "base/enums.h"
 #include "debugger.h"
 #include "entrypoints/runtime_asm_entrypoints.h"
+#include "interpreter_cache.h"
 #include "jit/jit.h"
 #include "jvalue.h"
 #include "method_handles.h"
@@ -578,15 +579,20 @@ bool DoInvokePolymorphic(Thread* self,
   // signature polymorphic call site.
   const uint32_t callsite_proto_id = (is_range) ? inst->VRegH_4rcc() : inst->VRegH_45cc();
 
-  // Call through to the classlinker and ask it to resolve the static type associated
-  // with the callsite. This information is stored in the dex cache so it's
-  // guaranteed to be fast after the first resolution.
+  // The static type associated with the callsite is stored in the dex cache after its first
+  // resolution. Only call through to the classlinker to resolve it on a miss, which needs
+  // handles to the dex cache and class loader of the caller.
   ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
-  Handle<mirror::Class> caller_class(hs.NewHandle(shadow_frame.GetMethod()->GetDeclaringClass()));
-  Handle<mirror::MethodType> callsite_type(hs.NewHandle(class_linker->ResolveMethodType(
-      caller_class->GetDexFile(), callsite_proto_id,
-      hs.NewHandle<mirror::DexCache>(caller_class->GetDexCache()),
-      hs.NewHandle<mirror::ClassLoader>(caller_class->GetClassLoader()))));
+  ObjPtr<mirror::Class> caller_class = shadow_frame.GetMethod()->GetDeclaringClass();
+  MutableHandle<mirror::MethodType> callsite_type(hs.NewHandle(
+      caller_class->GetDexCache()->GetResolvedMethodType(callsite_proto_id)));
+  if (UNLIKELY(callsite_type == nullptr)) {
+    Handle<mirror::Class> h_caller_class(hs.NewHandle(caller_class));
+    callsite_type.Assign(class_linker->ResolveMethodType(
+        h_caller_class->GetDexFile(), callsite_proto_id,
+        hs.NewHandle<mirror::DexCache>(h_caller_class->GetDexCache()),
+        hs.NewHandle<mirror::ClassLoader>(h_caller_class->GetClassLoader())));
+  }
 
   // This implies we couldn't resolve one or more types in this method handle.
   if (UNLIKELY(callsite_type == nullptr)) {
@@ -594,9 +600,20 @@ bool DoInvokePolymorphic(Thread* self,
     return false;
   }
 
-  ArtMethod* invoke_method =
-      class_linker->ResolveMethod<ClassLinker::ResolveMode::kCheckICCEAndIAE>(
-          self, invoke_method_idx, shadow_frame.GetMethod(), kVirtual);
+  // The method symbolically invoked is MethodHandle.invoke() or MethodHandle.invokeExact() of
+  // the boot class path, cache it for the instruction rather than resolving it at every call.
+  InterpreterCache* interpreter_cache = self->GetOrCreateInterpreterCache();
+  ArtMethod* invoke_method;
+  size_t cached_method;
+  if (LIKELY(interpreter_cache->Get(inst, &cached_method))) {
+    invoke_method = reinterpret_cast<ArtMethod*>(cached_method);
+  } else {
+    invoke_method = class_linker->ResolveMethod<ClassLinker::ResolveMode::kCheckICCEAndIAE>(
+        self, invoke_method_idx, shadow_frame.GetMethod(), kVirtual);
+    if (invoke_method != nullptr) {
+      interpreter_cache->Set(inst, reinterpret_cast<size_t>(invoke_method));
+    }
+  }
 
   // There is a common dispatch method for method handles that takes
   // arguments either from a range or an array of arguments depending
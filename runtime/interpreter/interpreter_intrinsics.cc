@@ -16,6 +16,8 @@
 
 #include "interpreter/interpreter_intrinsics.h"
 
+#include <zlib.h>
+
 #include "compiler/intrinsics_enum.h"
 #include "dex_instruction.h"
 #include "interpreter/interpreter_common.h"
@@ -323,6 +325,57 @@ static ALWAYS_INLINE bool MterpStringEquals(ShadowFrame* shadow_frame,
   return true;
 }
 
+// java.util.zip.CRC32.update(II)I
+static ALWAYS_INLINE bool MterpCRC32Update(ShadowFrame* shadow_frame,
+                                           const Instruction* inst,
+                                           uint16_t inst_data,
+                                           JValue* result_register)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  uint32_t arg[Instruction::kMaxVarArgRegs] = {};
+  inst->GetVarArgs(arg, inst_data);
+  uint32_t crc = shadow_frame->GetVReg(arg[0]);
+  Bytef b = static_cast<Bytef>(shadow_frame->GetVReg(arg[1]));
+  result_register->SetI(static_cast<int32_t>(crc32(crc, &b, 1)));
+  return true;
+}
+
+// java.util.zip.CRC32.updateBytes(I[BII)I
+static ALWAYS_INLINE bool MterpCRC32UpdateBytes(ShadowFrame* shadow_frame,
+                                                const Instruction* inst,
+                                                uint16_t inst_data,
+                                                JValue* result_register)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  uint32_t arg[Instruction::kMaxVarArgRegs] = {};
+  inst->GetVarArgs(arg, inst_data);
+  uint32_t crc = shadow_frame->GetVReg(arg[0]);
+  mirror::Object* obj = shadow_frame->GetVRegReference(arg[1]);
+  int32_t offset = shadow_frame->GetVReg(arg[2]);
+  int32_t length = shadow_frame->GetVReg(arg[3]);
+  if (obj == nullptr) {
+    return false;
+  }
+  mirror::ByteArray* array = obj->AsByteArray();
+  if (offset < 0 || length < 0 || offset > array->GetLength() - length) {
+    return false;  // Punt and let non-intrinsic version deal with the throw.
+  }
+  const Bytef* data = reinterpret_cast<const Bytef*>(array->GetData()) + offset;
+  result_register->SetI(static_cast<int32_t>(crc32(crc, data, length)));
+  return true;
+}
+
+// java.lang.System.identityHashCode(Ljava/lang/Object;)I
+static ALWAYS_INLINE bool MterpSystemIdentityHashCode(ShadowFrame* shadow_frame,
+                                                      const Instruction* inst,
+                                                      uint16_t inst_data,
+                                                      JValue* result_register)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  uint32_t arg[Instruction::kMaxVarArgRegs] = {};
+  inst->GetVarArgs(arg, inst_data);
+  mirror::Object* obj = shadow_frame->GetVRegReference(arg[0]);
+  result_register->SetI(obj != nullptr ? obj->IdentityHashCode() : 0);
+  return true;
+}
+
 // Macro to help keep track of what's left to implement.
 #define UNIMPLEMENTED_CASE(name)    \
     case Intrinsics::k##name:       \
@@ -412,6 +465,9 @@ bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
     UNIMPLEMENTED_CASE(MathRoundDouble /* (D)J */)
     UNIMPLEMENTED_CASE(MathRoundFloat /* (F)I */)
     UNIMPLEMENTED_CASE(SystemArrayCopyChar /* ([CI[CII)V */)
+    UNIMPLEMENTED_CASE(SystemArrayCopyByte /* ([BI[BII)V */)
+    UNIMPLEMENTED_CASE(SystemArrayCopyInt /* ([II[III)V */)
+    UNIMPLEMENTED_CASE(SystemArrayCopyLong /* ([JI[JII)V */)
     UNIMPLEMENTED_CASE(SystemArrayCopy /* (Ljava/lang/Object;ILjava/lang/Object;II)V */)
     UNIMPLEMENTED_CASE(ThreadCurrentThread /* ()Ljava/lang/Thread; */)
     UNIMPLEMENTED_CASE(MemoryPeekByte /* (J)B */)
@@ -470,6 +526,10 @@ bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
     UNIMPLEMENTED_CASE(ReferenceGetReferent /* ()Ljava/lang/Object; */)
     UNIMPLEMENTED_CASE(IntegerValueOf /* (I)Ljava/lang/Integer; */)
     UNIMPLEMENTED_CASE(ThreadInterrupted /* ()Z */)
+    UNIMPLEMENTED_CASE(ArraysEqualsByte /* ([B[B)Z */)
+    INTRINSIC_CASE(CRC32Update)
+    INTRINSIC_CASE(CRC32UpdateBytes)
+    INTRINSIC_CASE(SystemIdentityHashCode)
     case Intrinsics::kNone:
       res = false;
       break;
@@ -1281,7 +1281,10 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IGET_OBJECT_QUICK: {
+      case Instruction::IGET_OBJECT_QUICK:
+      case Instruction::IGET_OBJECT_QUICK_IF_EQZ:
+      case Instruction::IGET_OBJECT_QUICK_IF_NEZ: {
+        // The fused branch is the next instruction, it is executed on its own.
         PREAMBLE();
         bool success = DoIGetQuick<Primitive::kPrimNot>(shadow_frame, inst, inst_data);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
@@ -2400,7 +2403,7 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         inst = inst->Next_2xx();
         break;
       case Instruction::UNUSED_3E ... Instruction::UNUSED_43:
-      case Instruction::UNUSED_F3 ... Instruction::UNUSED_F9:
+      case Instruction::UNUSED_F5 ... Instruction::UNUSED_F9:
       case Instruction::UNUSED_FE ... Instruction::UNUSED_FF:
       case Instruction::UNUSED_79:
       case Instruction::UNUSED_7A:
@@ -17,6 +17,7 @@
 /*
  * Mterp entry point and support functions.
  */
+#include "interpreter/interpreter_cache.h"
 #include "interpreter/interpreter_common.h"
 #include "interpreter/interpreter_intrinsics.h"
 #include "entrypoints/entrypoint_utils-inl.h"
@@ -606,12 +607,67 @@ extern "C" size_t MterpSuspendCheck(Thread* self)
   return MterpShouldSwitchInterpreters();
 }
 
+// Returns the field cached for the field access instruction of referrer at the dex pc it exported,
+// or null. Sets *dex_pc_ptr to the key to cache the field to, or null if it cannot be cached.
+static ALWAYS_INLINE ArtField* GetCachedField(uint32_t field_idx,
+                                              ArtMethod* referrer,
+                                              Thread* self,
+                                              const uint16_t** dex_pc_ptr)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  // Mterp runs the top shadow frame, and exports its dex pc before calling the field helpers.
+  ShadowFrame* shadow_frame = self->GetManagedStack()->GetTopShadowFrame();
+  if (UNLIKELY(shadow_frame == nullptr || shadow_frame->GetMethod() != referrer)) {
+    *dex_pc_ptr = nullptr;
+    return nullptr;
+  }
+  *dex_pc_ptr = shadow_frame->GetDexPCPtr();
+  // Check the field index of the 21c and 22c formats, in case the dex pc is not the current one.
+  if (UNLIKELY(*dex_pc_ptr == nullptr || static_cast<uint32_t>((*dex_pc_ptr)[1]) != field_idx)) {
+    *dex_pc_ptr = nullptr;
+    return nullptr;
+  }
+  size_t value;
+  if (self->GetOrCreateInterpreterCache()->Get(*dex_pc_ptr, &value)) {
+    return reinterpret_cast<ArtField*>(value);
+  }
+  return nullptr;
+}
+
+static ALWAYS_INLINE void CacheField(const uint16_t* dex_pc_ptr, ArtField* field, Thread* self)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  // Static fields are only cached once their class is initialized, so that a failed
+  // initialization in progress on this thread is still seen by the later accesses.
+  if (dex_pc_ptr != nullptr &&
+      (!field->IsStatic() || field->GetDeclaringClass()->IsInitialized())) {
+    self->GetOrCreateInterpreterCache()->Set(dex_pc_ptr, reinterpret_cast<size_t>(field));
+  }
+}
+
+// Fast path of the instance field writes: the field cached for the instruction, or FindFieldFast.
+static ALWAYS_INLINE ArtField* MterpFindFieldFast(uint32_t field_idx,
+                                                  ArtMethod* referrer,
+                                                  FindFieldType type,
+                                                  size_t expected_size)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  Thread* self = Thread::Current();
+  const uint16_t* dex_pc_ptr;
+  ArtField* field = GetCachedField(field_idx, referrer, self, &dex_pc_ptr);
+  if (LIKELY(field != nullptr)) {
+    return field;
+  }
+  field = FindFieldFast(field_idx, referrer, type, expected_size);
+  if (field != nullptr) {
+    CacheField(dex_pc_ptr, field, self);
+  }
+  return field;
+}
+
 extern "C" ssize_t artSet8InstanceFromMterp(uint32_t field_idx,
                                             mirror::Object* obj,
                                             uint8_t new_value,
                                             ArtMethod* referrer)
     REQUIRES_SHARED(Locks::mutator_lock_) {
-  ArtField* field = FindFieldFast(field_idx, referrer, InstancePrimitiveWrite, sizeof(int8_t));
+  ArtField* field = MterpFindFieldFast(field_idx, referrer, InstancePrimitiveWrite, sizeof(int8_t));
   if (LIKELY(field != nullptr && obj != nullptr)) {
     Primitive::Type type = field->GetTypeAsPrimitiveType();
     if (type == Primitive::kPrimBoolean) {
@@ -630,8 +686,8 @@ extern "C" ssize_t artSet16InstanceFromMterp(uint32_t field_idx,
                                              uint16_t new_value,
                                              ArtMethod* referrer)
     REQUIRES_SHARED(Locks::mutator_lock_) {
-  ArtField* field = FindFieldFast(field_idx, referrer, InstancePrimitiveWrite,
-                                          sizeof(int16_t));
+  ArtField* field = MterpFindFieldFast(field_idx, referrer, InstancePrimitiveWrite,
+                                               sizeof(int16_t));
   if (LIKELY(field != nullptr && obj != nullptr)) {
     Primitive::Type type = field->GetTypeAsPrimitiveType();
     if (type == Primitive::kPrimChar) {
@@ -650,8 +706,8 @@ extern "C" ssize_t artSet32InstanceFromMterp(uint32_t field_idx,
                                              uint32_t new_value,
                                              ArtMethod* referrer)
     REQUIRES_SHARED(Locks::mutator_lock_) {
-  ArtField* field = FindFieldFast(field_idx, referrer, InstancePrimitiveWrite,
-                                          sizeof(int32_t));
+  ArtField* field = MterpFindFieldFast(field_idx, referrer, InstancePrimitiveWrite,
+                                               sizeof(int32_t));
   if (LIKELY(field != nullptr && obj != nullptr)) {
     field->Set32<false>(obj, new_value);
     return 0;  // success
@@ -664,8 +720,8 @@ extern "C" ssize_t artSet64InstanceFromMterp(uint32_t field_idx,
                                              uint64_t* new_value,
                                              ArtMethod* referrer)
     REQUIRES_SHARED(Locks::mutator_lock_) {
-  ArtField* field = FindFieldFast(field_idx, referrer, InstancePrimitiveWrite,
-                                          sizeof(int64_t));
+  ArtField* field = MterpFindFieldFast(field_idx, referrer, InstancePrimitiveWrite,
+                                               sizeof(int64_t));
   if (LIKELY(field != nullptr  && obj != nullptr)) {
     field->Set64<false>(obj, *new_value);
     return 0;  // success
@@ -678,8 +734,8 @@ extern "C" ssize_t artSetObjInstanceFromMterp(uint32_t field_idx,
                                               mirror::Object* new_value,
                                               ArtMethod* referrer)
     REQUIRES_SHARED(Locks::mutator_lock_) {
-  ArtField* field = FindFieldFast(field_idx, referrer, InstanceObjectWrite,
-                                          sizeof(mirror::HeapReference<mirror::Object>));
+  ArtField* field = MterpFindFieldFast(field_idx, referrer, InstanceObjectWrite,
+                                               sizeof(mirror::HeapReference<mirror::Object>));
   if (LIKELY(field != nullptr && obj != nullptr)) {
     field->SetObj<false>(obj, new_value);
     return 0;  // success
@@ -694,11 +750,17 @@ ALWAYS_INLINE return_type MterpGetStatic(uint32_t field_idx,
                                          return_type (ArtField::*func)(ObjPtr<mirror::Object>))
     REQUIRES_SHARED(Locks::mutator_lock_) {
   return_type res = 0;  // On exception, the result will be ignored.
-  ArtField* f =
-      FindFieldFromCode<StaticPrimitiveRead, false>(field_idx,
-                                                    referrer,
-                                                    self,
-                                                    primitive_type);
+  const uint16_t* dex_pc_ptr;
+  ArtField* f = GetCachedField(field_idx, referrer, self, &dex_pc_ptr);
+  if (UNLIKELY(f == nullptr)) {
+    f = FindFieldFromCode<StaticPrimitiveRead, false>(field_idx,
+                                                      referrer,
+                                                      self,
+                                                      primitive_type);
+    if (f != nullptr) {
+      CacheField(dex_pc_ptr, f, self);
+    }
+  }
   if (LIKELY(f != nullptr)) {
     ObjPtr<mirror::Object> obj = f->GetDeclaringClass();
     res = (f->*func)(obj);
@@ -783,8 +845,14 @@ int MterpSetStatic(uint32_t field_idx,
                    void (ArtField::*func)(ObjPtr<mirror::Object>, field_type val))
     REQUIRES_SHARED(Locks::mutator_lock_) {
   int res = 0;  // Assume success (following quick_field_entrypoints conventions)
-  ArtField* f =
-      FindFieldFromCode<StaticPrimitiveWrite, false>(field_idx, referrer, self, primitive_type);
+  const uint16_t* dex_pc_ptr;
+  ArtField* f = GetCachedField(field_idx, referrer, self, &dex_pc_ptr);
+  if (UNLIKELY(f == nullptr)) {
+    f = FindFieldFromCode<StaticPrimitiveWrite, false>(field_idx, referrer, self, primitive_type);
+    if (f != nullptr) {
+      CacheField(dex_pc_ptr, f, self);
+    }
+  }
   if (LIKELY(f != nullptr)) {
     ObjPtr<mirror::Object> obj = f->GetDeclaringClass();
     (f->*func)(obj, new_value);
@@ -25,6 +25,9 @@
 #include "base/mutex-inl.h"
 #include "base/stl_util.h"
 #include "base/systrace.h"
+#ifdef CAPSTONE
+#include "binary_analyzer/binary_analyzer_x86.h"
+#endif
 #include "check_jni.h"
 #include "dex_file-inl.h"
 #include "fault_handler.h"
@@ -338,6 +341,12 @@ class Libraries {
       }
       delete library;
     }
+#ifdef CAPSTONE
+    if (!unload_libraries.empty()) {
+      // The functions analyzed for the auto fast JNI detection may have been unloaded.
+      x86::FunctionSummaries::Get()->Clear();
+    }
+#endif
   }
 
  private:
@@ -143,10 +143,9 @@ static bool NeedsFullDeoptimization(JdwpEventKind eventKind) {
     // We don't need deoptimization for debugging.
     return false;
   }
+  // The method entry and exit events need the instrumentation stubs only, installed when the
+  // debugger registers for them.
   switch (eventKind) {
-      case EK_METHOD_ENTRY:
-      case EK_METHOD_EXIT:
-      case EK_METHOD_EXIT_WITH_RETURN_VALUE:
       case EK_FIELD_ACCESS:
       case EK_FIELD_MODIFICATION:
         return true;
@@ -0,0 +1,502 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flat_profile.h"
+
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+
+#include "android-base/file.h"
+
+#include "base/bit_utils.h"
+#include "base/logging.h"
+#include "base/stringpiece.h"
+#include "base/systrace.h"
+#include "dex_file.h"
+
+namespace art {
+
+const uint8_t FlatProfile::kFlatProfileMagic[] = { 'p', 'f', 'l', '\0' };
+const uint8_t FlatProfile::kFlatProfileVersion[] = { '0', '0', '1', '\0' };
+
+struct FlatProfile::Header {
+  uint8_t magic[4];
+  uint8_t version[4];
+  uint32_t number_of_dex_files;
+  uint32_t file_size;
+};
+
+struct FlatProfile::DexSection {
+  uint32_t key_offset;
+  uint32_t key_size;
+  uint32_t checksum;
+  uint32_t num_method_ids;
+  uint32_t hot_methods_offset;
+  uint32_t number_of_hot_methods;
+  uint32_t bitmap_offset;
+  uint32_t classes_offset;
+  uint32_t number_of_classes;
+};
+
+static_assert(sizeof(FlatProfile::kFlatProfileMagic) == 4, "Unexpected magic size");
+static_assert(sizeof(FlatProfile::kFlatProfileVersion) == 4, "Unexpected version size");
+
+// Buffers the data written to the file, whose header and dex sections are only
+// written at the end, once the offsets are known.
+class FlatProfile::Writer {
+ public:
+  explicit Writer(int fd) : fd_(fd), offset_(0), success_(true) {}
+
+  void Write(const void* data, size_t size) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    buffer_.insert(buffer_.end(), bytes, bytes + size);
+    offset_ += size;
+    if (buffer_.size() >= kBufferSize) {
+      Flush();
+    }
+  }
+
+  // Leave room for data written by Finish().
+  void Skip(size_t size) {
+    buffer_.resize(buffer_.size() + size, 0u);
+    offset_ += size;
+  }
+
+  void WriteIndex(uint16_t index) {
+    Write(&index, sizeof(index));
+  }
+
+  void Align(size_t alignment) {
+    static constexpr uint8_t kZeros[sizeof(uint32_t)] = {};
+    DCHECK_LE(alignment, sizeof(kZeros));
+    Write(kZeros, RoundUp(offset_, alignment) - offset_);
+  }
+
+  uint32_t GetOffset() const {
+    return static_cast<uint32_t>(offset_);
+  }
+
+  bool Finish(const std::vector<DexSection>& sections) {
+    Flush();
+    if (!success_ || offset_ > std::numeric_limits<uint32_t>::max()) {
+      return false;
+    }
+    Header header = {};
+    memcpy(header.magic, kFlatProfileMagic, sizeof(header.magic));
+    memcpy(header.version, kFlatProfileVersion, sizeof(header.version));
+    header.number_of_dex_files = sections.size();
+    header.file_size = GetOffset();
+    return WriteAt(&header, sizeof(header), 0) &&
+           WriteAt(sections.data(), sections.size() * sizeof(DexSection), sizeof(header));
+  }
+
+ private:
+  void Flush() {
+    if (success_ && !buffer_.empty()) {
+      success_ = android::base::WriteFully(fd_, buffer_.data(), buffer_.size());
+    }
+    buffer_.clear();
+  }
+
+  bool WriteAt(const void* data, size_t size, off_t offset) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    while (size > 0) {
+      ssize_t bytes_written = TEMP_FAILURE_RETRY(pwrite(fd_, bytes, size, offset));
+      if (bytes_written <= 0) {
+        return false;
+      }
+      bytes += bytes_written;
+      size -= bytes_written;
+      offset += bytes_written;
+    }
+    return true;
+  }
+
+  static constexpr size_t kBufferSize = 64 * KB;
+
+  const int fd_;
+  size_t offset_;
+  bool success_;
+  std::vector<uint8_t> buffer_;
+};
+
+static bool IsInFile(uint64_t offset, uint64_t size, uint64_t file_size) {
+  return offset <= file_size && size <= file_size - offset;
+}
+
+bool FlatProfile::IsFlatProfile(int fd) {
+  uint8_t magic[sizeof(kFlatProfileMagic)];
+  return TEMP_FAILURE_RETRY(pread(fd, magic, sizeof(magic), 0)) == sizeof(magic) &&
+         memcmp(magic, kFlatProfileMagic, sizeof(magic)) == 0;
+}
+
+std::unique_ptr<FlatProfile> FlatProfile::Open(int fd, std::string* error) {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  struct stat stat_buffer;
+  if (fstat(fd, &stat_buffer) != 0) {
+    *error = "Could not stat the flat profile";
+    return nullptr;
+  }
+  size_t file_size = stat_buffer.st_size;
+  if (file_size < sizeof(Header)) {
+    *error = "Flat profile too small";
+    return nullptr;
+  }
+  std::unique_ptr<MemMap> map(MemMap::MapFile(file_size,
+                                              PROT_READ,
+                                              MAP_PRIVATE,
+                                              fd,
+                                              /* start */ 0,
+                                              /* low_4gb */ false,
+                                              "flat profile",
+                                              error));
+  if (map == nullptr) {
+    return nullptr;
+  }
+  std::unique_ptr<FlatProfile> profile(new FlatProfile(map.release()));
+
+  const Header* header = profile->GetHeader();
+  if (memcmp(header->magic, kFlatProfileMagic, sizeof(header->magic)) != 0) {
+    *error = "Not a flat profile";
+    return nullptr;
+  }
+  if (memcmp(header->version, kFlatProfileVersion, sizeof(header->version)) != 0) {
+    *error = "Flat profile version mismatch";
+    return nullptr;
+  }
+  if (header->file_size != file_size ||
+      !IsInFile(sizeof(Header),
+                static_cast<uint64_t>(header->number_of_dex_files) * sizeof(DexSection),
+                file_size)) {
+    *error = "Truncated flat profile";
+    return nullptr;
+  }
+  // Only check the bounds, so that the lookups do not touch the arrays they do not need.
+  for (uint32_t i = 0; i < header->number_of_dex_files; ++i) {
+    const DexSection& section = *profile->GetDexSection(i);
+    if (!IsInFile(section.key_offset, section.key_size, file_size) ||
+        !IsAligned<alignof(uint16_t)>(section.hot_methods_offset) ||
+        !IsInFile(section.hot_methods_offset,
+                  static_cast<uint64_t>(section.number_of_hot_methods) * sizeof(uint16_t),
+                  file_size) ||
+        !IsAligned<alignof(uint16_t)>(section.classes_offset) ||
+        !IsInFile(section.classes_offset,
+                  static_cast<uint64_t>(section.number_of_classes) * sizeof(uint16_t),
+                  file_size) ||
+        !IsInFile(section.bitmap_offset, GetBitmapSize(section.num_method_ids), file_size)) {
+      *error = "Bad dex section in the flat profile";
+      return nullptr;
+    }
+    if (i != 0 &&
+        profile->GetProfileKey(*profile->GetDexSection(i - 1)) >= profile->GetProfileKey(section)) {
+      *error = "Unsorted dex sections in the flat profile";
+      return nullptr;
+    }
+  }
+  return profile;
+}
+
+bool FlatProfile::Write(const ProfileCompilationInfo& info, int fd) {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  std::vector<const ProfileCompilationInfo::DexFileData*> dex_data(info.info_.begin(),
+                                                                   info.info_.end());
+  std::sort(dex_data.begin(),
+            dex_data.end(),
+            [](const ProfileCompilationInfo::DexFileData* lhs,
+               const ProfileCompilationInfo::DexFileData* rhs) {
+              return lhs->profile_key < rhs->profile_key;
+            });
+
+  Writer writer(fd);
+  std::vector<DexSection> sections(dex_data.size());
+  writer.Skip(sizeof(Header) + sections.size() * sizeof(DexSection));
+  for (size_t i = 0; i < dex_data.size(); ++i) {
+    const ProfileCompilationInfo::DexFileData& data = *dex_data[i];
+    DexSection& section = sections[i];
+    section.checksum = data.checksum;
+    section.num_method_ids = data.num_method_ids;
+
+    section.key_offset = writer.GetOffset();
+    section.key_size = data.profile_key.size();
+    writer.Write(data.profile_key.data(), data.profile_key.size());
+    writer.Align(alignof(uint16_t));
+
+    section.hot_methods_offset = writer.GetOffset();
+    section.number_of_hot_methods = data.method_map.size();
+    for (const auto& method : data.method_map) {
+      writer.WriteIndex(method.first);
+    }
+
+    section.classes_offset = writer.GetOffset();
+    section.number_of_classes = data.class_set.size();
+    for (dex::TypeIndex type_idx : data.class_set) {
+      writer.WriteIndex(type_idx.index_);
+    }
+
+    DCHECK_EQ(data.bitmap_storage.size(), GetBitmapSize(data.num_method_ids));
+    section.bitmap_offset = writer.GetOffset();
+    writer.Write(data.bitmap_storage.data(), data.bitmap_storage.size());
+    writer.Align(sizeof(uint32_t));
+  }
+  return writer.Finish(sections);
+}
+
+uint32_t FlatProfile::MergeIndexes(
+    const std::vector<std::pair<const uint16_t*, const uint16_t*>>& inputs,
+    Writer* writer) {
+  // The next index of each input, smallest first.
+  using Entry = std::pair<uint16_t, size_t>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heads;
+  std::vector<const uint16_t*> positions;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    positions.push_back(inputs[i].first);
+    if (inputs[i].first != inputs[i].second) {
+      heads.emplace(*inputs[i].first, i);
+    }
+  }
+  uint32_t count = 0;
+  uint16_t last = 0;
+  while (!heads.empty()) {
+    Entry head = heads.top();
+    heads.pop();
+    if (count == 0 || head.first != last) {
+      writer->WriteIndex(head.first);
+      last = head.first;
+      ++count;
+    }
+    size_t input = head.second;
+    ++positions[input];
+    if (positions[input] != inputs[input].second) {
+      heads.emplace(*positions[input], input);
+    }
+  }
+  return count;
+}
+
+bool FlatProfile::Merge(const std::vector<const FlatProfile*>& profiles,
+                        int fd,
+                        std::string* error) {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  // The sections of each profile key, in the order of the keys.
+  std::map<std::string, std::vector<std::pair<const FlatProfile*, const DexSection*>>> inputs;
+  for (const FlatProfile* profile : profiles) {
+    for (uint32_t i = 0; i < profile->GetNumberOfDexFiles(); ++i) {
+      const DexSection* section = profile->GetDexSection(i);
+      inputs[profile->GetProfileKey(*section)].emplace_back(profile, section);
+    }
+  }
+
+  Writer writer(fd);
+  std::vector<DexSection> sections(inputs.size());
+  writer.Skip(sizeof(Header) + sections.size() * sizeof(DexSection));
+  size_t i = 0;
+  for (const auto& entry : inputs) {
+    const std::string& profile_key = entry.first;
+    const DexSection& first = *entry.second[0].second;
+    std::vector<std::pair<const uint16_t*, const uint16_t*>> hot_methods;
+    std::vector<std::pair<const uint16_t*, const uint16_t*>> classes;
+    std::vector<const uint8_t*> bitmaps;
+    for (const auto& input : entry.second) {
+      const FlatProfile* profile = input.first;
+      const DexSection& section = *input.second;
+      if (section.checksum != first.checksum || section.num_method_ids != first.num_method_ids) {
+        *error = "Checksum mismatch for dex " + profile_key;
+        return false;
+      }
+      const uint16_t* methods = profile->GetHotMethods(section);
+      hot_methods.emplace_back(methods, methods + section.number_of_hot_methods);
+      const uint16_t* types = profile->GetClasses(section);
+      classes.emplace_back(types, types + section.number_of_classes);
+      bitmaps.push_back(profile->GetBitmap(section));
+    }
+
+    DexSection& section = sections[i++];
+    section.checksum = first.checksum;
+    section.num_method_ids = first.num_method_ids;
+
+    section.key_offset = writer.GetOffset();
+    section.key_size = profile_key.size();
+    writer.Write(profile_key.data(), profile_key.size());
+    writer.Align(alignof(uint16_t));
+
+    section.hot_methods_offset = writer.GetOffset();
+    section.number_of_hot_methods = MergeIndexes(hot_methods, &writer);
+
+    section.classes_offset = writer.GetOffset();
+    section.number_of_classes = MergeIndexes(classes, &writer);
+
+    section.bitmap_offset = writer.GetOffset();
+    for (size_t j = 0, size = GetBitmapSize(first.num_method_ids); j < size; ++j) {
+      uint8_t bits = 0;
+      for (const uint8_t* bitmap : bitmaps) {
+        bits |= bitmap[j];
+      }
+      writer.Write(&bits, sizeof(bits));
+    }
+    writer.Align(sizeof(uint32_t));
+  }
+  if (!writer.Finish(sections)) {
+    *error = "Could not write the flat profile";
+    return false;
+  }
+  return true;
+}
+
+uint32_t FlatProfile::GetNumberOfDexFiles() const {
+  return GetHeader()->number_of_dex_files;
+}
+
+bool FlatProfile::ContainsHotMethod(const std::string& profile_key,
+                                    uint32_t checksum,
+                                    uint16_t dex_method_index) const {
+  const DexSection* section = FindDexSection(profile_key, checksum);
+  if (section == nullptr) {
+    return false;
+  }
+  const uint16_t* methods = GetHotMethods(*section);
+  return std::binary_search(methods, methods + section->number_of_hot_methods, dex_method_index);
+}
+
+ProfileCompilationInfo::MethodHotness FlatProfile::GetMethodHotness(
+    const MethodReference& method_ref) const {
+  using MethodHotness = ProfileCompilationInfo::MethodHotness;
+  MethodHotness hotness;
+  const DexSection* section = FindDexSection(
+      ProfileCompilationInfo::GetProfileDexFileKey(method_ref.dex_file->GetLocation()),
+      method_ref.dex_file->GetLocationChecksum());
+  if (section == nullptr || method_ref.dex_method_index >= section->num_method_ids) {
+    return hotness;
+  }
+  const uint16_t* methods = GetHotMethods(*section);
+  if (std::binary_search(methods,
+                         methods + section->number_of_hot_methods,
+                         method_ref.dex_method_index)) {
+    hotness.AddFlag(MethodHotness::kFlagHot);
+  }
+  // The bitmap is [startup bitmap][post startup bitmap], as in ProfileCompilationInfo.
+  const uint8_t* bitmap = GetBitmap(*section);
+  auto is_bit_set = [bitmap](size_t bit) {
+    return (bitmap[bit / kBitsPerByte] & (1u << (bit % kBitsPerByte))) != 0;
+  };
+  if (is_bit_set(method_ref.dex_method_index)) {
+    hotness.AddFlag(MethodHotness::kFlagStartup);
+  }
+  if (is_bit_set(section->num_method_ids + method_ref.dex_method_index)) {
+    hotness.AddFlag(MethodHotness::kFlagPostStartup);
+  }
+  return hotness;
+}
+
+bool FlatProfile::ContainsClass(const DexFile& dex_file, dex::TypeIndex type_idx) const {
+  const DexSection* section = FindDexSection(
+      ProfileCompilationInfo::GetProfileDexFileKey(dex_file.GetLocation()),
+      dex_file.GetLocationChecksum());
+  if (section == nullptr) {
+    return false;
+  }
+  const uint16_t* classes = GetClasses(*section);
+  return std::binary_search(classes, classes + section->number_of_classes, type_idx.index_);
+}
+
+bool FlatProfile::AddTo(ProfileCompilationInfo* info) const {
+  using MethodHotness = ProfileCompilationInfo::MethodHotness;
+  for (uint32_t i = 0; i < GetNumberOfDexFiles(); ++i) {
+    const DexSection& section = *GetDexSection(i);
+    ProfileCompilationInfo::DexFileData* data =
+        info->GetOrAddDexFileData(GetProfileKey(section), section.checksum, section.num_method_ids);
+    if (data == nullptr) {
+      return false;
+    }
+    const uint16_t* methods = GetHotMethods(section);
+    for (uint32_t j = 0; j < section.number_of_hot_methods; ++j) {
+      if (!data->AddMethod(MethodHotness::kFlagHot, methods[j])) {
+        return false;
+      }
+    }
+    const uint16_t* classes = GetClasses(section);
+    for (uint32_t j = 0; j < section.number_of_classes; ++j) {
+      data->class_set.insert(dex::TypeIndex(classes[j]));
+    }
+    const uint8_t* bitmap = GetBitmap(section);
+    DCHECK_EQ(data->bitmap_storage.size(), GetBitmapSize(section.num_method_ids));
+    for (size_t j = 0; j < data->bitmap_storage.size(); ++j) {
+      data->bitmap_storage[j] |= bitmap[j];
+    }
+  }
+  return true;
+}
+
+const FlatProfile::Header* FlatProfile::GetHeader() const {
+  return reinterpret_cast<const Header*>(map_->Begin());
+}
+
+const FlatProfile::DexSection* FlatProfile::GetDexSection(uint32_t index) const {
+  DCHECK_LT(index, GetHeader()->number_of_dex_files);
+  return reinterpret_cast<const DexSection*>(map_->Begin() + sizeof(Header)) + index;
+}
+
+std::string FlatProfile::GetProfileKey(const DexSection& section) const {
+  return std::string(reinterpret_cast<const char*>(map_->Begin() + section.key_offset),
+                     section.key_size);
+}
+
+const FlatProfile::DexSection* FlatProfile::FindDexSection(const std::string& profile_key,
+                                                           uint32_t checksum) const {
+  uint32_t low = 0;
+  uint32_t high = GetNumberOfDexFiles();
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    const DexSection* section = GetDexSection(mid);
+    StringPiece key(reinterpret_cast<const char*>(map_->Begin() + section->key_offset),
+                    section->key_size);
+    int compare = key.compare(profile_key);
+    if (compare == 0) {
+      return section->checksum == checksum ? section : nullptr;
+    } else if (compare < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return nullptr;
+}
+
+const uint16_t* FlatProfile::GetHotMethods(const DexSection& section) const {
+  return reinterpret_cast<const uint16_t*>(map_->Begin() + section.hot_methods_offset);
+}
+
+const uint16_t* FlatProfile::GetClasses(const DexSection& section) const {
+  return reinterpret_cast<const uint16_t*>(map_->Begin() + section.classes_offset);
+}
+
+const uint8_t* FlatProfile::GetBitmap(const DexSection& section) const {
+  return map_->Begin() + section.bitmap_offset;
+}
+
+size_t FlatProfile::GetBitmapSize(uint32_t num_method_ids) {
+  // Two bits per method, as ProfileCompilationInfo::DexFileData.
+  return RoundUp(static_cast<size_t>(num_method_ids) * 2u, kBitsPerByte) / kBitsPerByte;
+}
+
+}  // namespace art
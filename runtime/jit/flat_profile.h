@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_FLAT_PROFILE_H_
+#define ART_RUNTIME_JIT_FLAT_PROFILE_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "dex_file_types.h"
+#include "jit/profile_compilation_info.h"
+#include "mem_map.h"
+#include "method_reference.h"
+
+namespace art {
+
+class DexFile;
+
+/**
+ * A profile in a flat format, mapped and queried in place.
+ *
+ * The format is made of sorted, offset-based arrays, in the byte order of the
+ * writer:
+ *    header: magic, version, number_of_dex_files, file_size
+ *    dex sections sorted by profile key:
+ *       key_offset, key_size, checksum, num_method_ids,
+ *       hot_methods_offset, number_of_hot_methods,
+ *       bitmap_offset,
+ *       classes_offset, number_of_classes
+ *    data: the keys, the sorted uint16_t method and class indexes, and the
+ *       [startup bitmap][post startup bitmap] of each dex file.
+ *
+ * Unlike ProfileCompilationInfo, the inline caches are not kept: a method is
+ * only recorded as hot, startup or post startup.
+ */
+class FlatProfile {
+ public:
+  static const uint8_t kFlatProfileMagic[];
+  static const uint8_t kFlatProfileVersion[];
+
+  // Return whether the file of fd starts with the flat profile magic. The file
+  // offset is not changed.
+  static bool IsFlatProfile(int fd);
+
+  // Map the flat profile of fd. Returns null and sets error if the file is not
+  // a valid flat profile.
+  static std::unique_ptr<FlatProfile> Open(int fd, std::string* error);
+
+  // Write the methods and classes of info to the empty file of fd.
+  static bool Write(const ProfileCompilationInfo& info, int fd);
+
+  // Write the union of profiles to the empty file of fd. The method and class
+  // indexes are merged as they are read, without building any intermediate set.
+  static bool Merge(const std::vector<const FlatProfile*>& profiles,
+                    int fd,
+                    std::string* error);
+
+  uint32_t GetNumberOfDexFiles() const;
+
+  bool ContainsHotMethod(const std::string& profile_key,
+                         uint32_t checksum,
+                         uint16_t dex_method_index) const;
+
+  ProfileCompilationInfo::MethodHotness GetMethodHotness(const MethodReference& method_ref) const;
+
+  bool ContainsClass(const DexFile& dex_file, dex::TypeIndex type_idx) const;
+
+  // Add the methods and classes of this profile to info, for the users of
+  // ProfileCompilationInfo. Returns false if info has a dex file with another checksum.
+  bool AddTo(ProfileCompilationInfo* info) const;
+
+ private:
+  struct Header;
+  struct DexSection;
+  class Writer;
+
+  explicit FlatProfile(MemMap* map) : map_(map) {}
+
+  const Header* GetHeader() const;
+  const DexSection* GetDexSection(uint32_t index) const;
+  std::string GetProfileKey(const DexSection& section) const;
+
+  // Binary search of the section of profile_key, null if missing or if the checksum
+  // does not match.
+  const DexSection* FindDexSection(const std::string& profile_key, uint32_t checksum) const;
+
+  const uint16_t* GetHotMethods(const DexSection& section) const;
+  const uint16_t* GetClasses(const DexSection& section) const;
+  const uint8_t* GetBitmap(const DexSection& section) const;
+
+  static size_t GetBitmapSize(uint32_t num_method_ids);
+
+  // K-way merge of sorted index arrays into writer, dropping the duplicates.
+  // Returns the number of indexes written.
+  static uint32_t MergeIndexes(
+      const std::vector<std::pair<const uint16_t*, const uint16_t*>>& inputs,
+      Writer* writer);
+
+  std::unique_ptr<MemMap> map_;
+
+  DISALLOW_COPY_AND_ASSIGN(FlatProfile);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_FLAT_PROFILE_H_
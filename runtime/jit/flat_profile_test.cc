@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "common_runtime_test.h"
+#include "dex_cache_resolved_classes.h"
+#include "jit/flat_profile.h"
+#include "jit/profile_compilation_info.h"
+
+namespace art {
+
+using Hotness = ProfileCompilationInfo::MethodHotness;
+
+static constexpr uint32_t kMaxMethodIds = 65535;
+
+class FlatProfileTest : public CommonRuntimeTest {
+ protected:
+  static bool AddMethod(const std::string& dex_location,
+                        uint32_t checksum,
+                        uint16_t method_index,
+                        Hotness::Flag flags,
+                        ProfileCompilationInfo* info) {
+    return info->AddMethodIndex(flags, dex_location, checksum, method_index, kMaxMethodIds);
+  }
+
+  static bool AddClass(const std::string& dex_location,
+                       uint32_t checksum,
+                       dex::TypeIndex type_index,
+                       ProfileCompilationInfo* info) {
+    DexCacheResolvedClasses classes(dex_location, dex_location, checksum, kMaxMethodIds);
+    classes.AddClass(type_index);
+    return info->AddClasses({classes});
+  }
+
+  static std::unique_ptr<FlatProfile> WriteAndOpen(const ProfileCompilationInfo& info,
+                                                   const ScratchFile& file) {
+    if (!FlatProfile::Write(info, file.GetFd())) {
+      return nullptr;
+    }
+    std::string error;
+    std::unique_ptr<FlatProfile> profile = FlatProfile::Open(file.GetFd(), &error);
+    EXPECT_TRUE(profile != nullptr) << error;
+    return profile;
+  }
+};
+
+TEST_F(FlatProfileTest, WriteAndQuery) {
+  ProfileCompilationInfo info;
+  for (uint16_t i = 0; i < 10; i += 3) {
+    ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, i, Hotness::kFlagHot, &info));
+  }
+  ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, 4, Hotness::kFlagStartup, &info));
+  ASSERT_TRUE(AddMethod("dex_location2", /* checksum */ 2, 1, Hotness::kFlagPostStartup, &info));
+  ASSERT_TRUE(AddClass("dex_location2", /* checksum */ 2, dex::TypeIndex(7), &info));
+
+  ScratchFile file;
+  std::unique_ptr<FlatProfile> profile = WriteAndOpen(info, file);
+  ASSERT_TRUE(profile != nullptr);
+  EXPECT_EQ(2u, profile->GetNumberOfDexFiles());
+  EXPECT_TRUE(profile->ContainsHotMethod("dex_location1", 1, 0));
+  EXPECT_TRUE(profile->ContainsHotMethod("dex_location1", 1, 9));
+  EXPECT_FALSE(profile->ContainsHotMethod("dex_location1", 1, 4));
+  EXPECT_FALSE(profile->ContainsHotMethod("dex_location1", /* checksum */ 2, 0));
+  EXPECT_FALSE(profile->ContainsHotMethod("dex_location2", 2, 1));
+  EXPECT_FALSE(profile->ContainsHotMethod("dex_location3", 1, 0));
+
+  // A ProfileCompilationInfo loads the flat profile as it was written.
+  ProfileCompilationInfo loaded_info;
+  ASSERT_TRUE(FlatProfile::IsFlatProfile(file.GetFd()));
+  ASSERT_TRUE(loaded_info.Load(file.GetFd()));
+  EXPECT_TRUE(loaded_info.Equals(info));
+  EXPECT_EQ(1u, loaded_info.GetNumberOfResolvedClasses());
+  EXPECT_TRUE(loaded_info.GetMethodHotness("dex_location1", 1, 4).IsStartup());
+  EXPECT_FALSE(loaded_info.GetMethodHotness("dex_location1", 1, 3).IsStartup());
+  EXPECT_TRUE(loaded_info.GetMethodHotness("dex_location2", 2, 1).IsPostStartup());
+}
+
+TEST_F(FlatProfileTest, Merge) {
+  ProfileCompilationInfo info1;
+  ProfileCompilationInfo info2;
+  ProfileCompilationInfo expected;
+  for (uint16_t i = 0; i < 20; ++i) {
+    ProfileCompilationInfo* info = (i % 2 == 0) ? &info1 : &info2;
+    ASSERT_TRUE(AddMethod("dex_location1", 1, i, Hotness::kFlagHot, info));
+    ASSERT_TRUE(AddMethod("dex_location1", 1, i, Hotness::kFlagHot, &expected));
+    if (i % 5 == 0) {
+      // Also in the other profile, only merged once.
+      ProfileCompilationInfo* other = (info == &info1) ? &info2 : &info1;
+      ASSERT_TRUE(AddMethod("dex_location1", 1, i, Hotness::kFlagHot, other));
+    }
+  }
+  ASSERT_TRUE(AddMethod("dex_location2", 2, 3, Hotness::kFlagHot, &info2));
+  ASSERT_TRUE(AddMethod("dex_location2", 2, 3, Hotness::kFlagHot, &expected));
+  ASSERT_TRUE(AddMethod("dex_location1", 1, 30, Hotness::kFlagStartup, &info1));
+  ASSERT_TRUE(AddMethod("dex_location1", 1, 30, Hotness::kFlagStartup, &expected));
+
+  ScratchFile file1;
+  ScratchFile file2;
+  std::unique_ptr<FlatProfile> profile1 = WriteAndOpen(info1, file1);
+  std::unique_ptr<FlatProfile> profile2 = WriteAndOpen(info2, file2);
+  ASSERT_TRUE(profile1 != nullptr);
+  ASSERT_TRUE(profile2 != nullptr);
+
+  ScratchFile merged_file;
+  std::string error;
+  ASSERT_TRUE(FlatProfile::Merge({ profile1.get(), profile2.get() }, merged_file.GetFd(), &error))
+      << error;
+  ProfileCompilationInfo merged_info;
+  ASSERT_TRUE(merged_info.Load(merged_file.GetFd()));
+  EXPECT_TRUE(merged_info.Equals(expected));
+  EXPECT_EQ(expected.GetNumberOfMethods(), merged_info.GetNumberOfMethods());
+  EXPECT_TRUE(merged_info.GetMethodHotness("dex_location1", 1, 30).IsStartup());
+}
+
+TEST_F(FlatProfileTest, MergeChecksumMismatch) {
+  ProfileCompilationInfo info1;
+  ProfileCompilationInfo info2;
+  ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, 0, Hotness::kFlagHot, &info1));
+  ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 2, 0, Hotness::kFlagHot, &info2));
+
+  ScratchFile file1;
+  ScratchFile file2;
+  std::unique_ptr<FlatProfile> profile1 = WriteAndOpen(info1, file1);
+  std::unique_ptr<FlatProfile> profile2 = WriteAndOpen(info2, file2);
+  ASSERT_TRUE(profile1 != nullptr);
+  ASSERT_TRUE(profile2 != nullptr);
+
+  ScratchFile merged_file;
+  std::string error;
+  EXPECT_FALSE(FlatProfile::Merge({ profile1.get(), profile2.get() }, merged_file.GetFd(), &error));
+}
+
+TEST_F(FlatProfileTest, RejectRegularProfile) {
+  ProfileCompilationInfo info;
+  ASSERT_TRUE(AddMethod("dex_location1", 1, 0, Hotness::kFlagHot, &info));
+  ScratchFile file;
+  ASSERT_TRUE(info.Save(file.GetFd()));
+
+  EXPECT_FALSE(FlatProfile::IsFlatProfile(file.GetFd()));
+  std::string error;
+  EXPECT_TRUE(FlatProfile::Open(file.GetFd(), &error) == nullptr);
+}
+
+}  // namespace art
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_HOT_METHOD_BUFFER_H_
+#define ART_RUNTIME_JIT_HOT_METHOD_BUFFER_H_
+
+#include <stddef.h>
+
+#include "atomic.h"
+#include "base/macros.h"
+
+namespace art {
+
+class ArtMethod;
+
+namespace jit {
+
+// The methods a thread saw getting their first samples or their ProfilingInfo, for the
+// profile saver to record without visiting all the classes. The thread pushes and the
+// saver drains, without any lock: this is a single producer, single consumer ring.
+class HotMethodBuffer {
+ public:
+  static constexpr size_t kCapacity = 256;
+
+  HotMethodBuffer() : head_(0), tail_(0), overflowed_(false) {}
+
+  // Owner thread only. Drops the method if the buffer is full.
+  void Push(ArtMethod* method) {
+    size_t head = head_.LoadRelaxed();
+    if (UNLIKELY(head - tail_.LoadAcquire() == kCapacity)) {
+      overflowed_.StoreRelaxed(true);
+      return;
+    }
+    methods_[head % kCapacity] = method;
+    // Publish the method before the saver can see the new head.
+    head_.StoreRelease(head + 1);
+  }
+
+  // Saver only. Visits and removes the methods pushed so far. Returns false if some
+  // methods were dropped since the last drain.
+  template <typename Visitor>
+  bool Drain(const Visitor& visitor) {
+    size_t tail = tail_.LoadRelaxed();
+    size_t head = head_.LoadAcquire();
+    for (; tail != head; ++tail) {
+      visitor(methods_[tail % kCapacity]);
+    }
+    // Let the owner reuse the slots once they are read.
+    tail_.StoreRelease(tail);
+    return !overflowed_.ExchangeRelaxed(false);
+  }
+
+ private:
+  // The number of methods pushed and drained. They only increase.
+  Atomic<size_t> head_;
+  Atomic<size_t> tail_;
+  Atomic<bool> overflowed_;
+  ArtMethod* methods_[kCapacity];
+
+  DISALLOW_COPY_AND_ASSIGN(HotMethodBuffer);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_HOT_METHOD_BUFFER_H_
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hot_method_buffer.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace art {
+namespace jit {
+
+static ArtMethod* FakeMethod(size_t i) {
+  return reinterpret_cast<ArtMethod*>((i + 1) * sizeof(void*));
+}
+
+TEST(HotMethodBufferTest, PushDrain) {
+  HotMethodBuffer buffer;
+  std::vector<ArtMethod*> drained;
+  auto visitor = [&](ArtMethod* method) { drained.push_back(method); };
+  EXPECT_TRUE(buffer.Drain(visitor));
+  EXPECT_TRUE(drained.empty());
+
+  buffer.Push(FakeMethod(0));
+  buffer.Push(FakeMethod(1));
+  EXPECT_TRUE(buffer.Drain(visitor));
+  ASSERT_EQ(2u, drained.size());
+  EXPECT_EQ(FakeMethod(0), drained[0]);
+  EXPECT_EQ(FakeMethod(1), drained[1]);
+
+  // The methods are only visited once.
+  drained.clear();
+  EXPECT_TRUE(buffer.Drain(visitor));
+  EXPECT_TRUE(drained.empty());
+}
+
+TEST(HotMethodBufferTest, Overflow) {
+  HotMethodBuffer buffer;
+  std::vector<ArtMethod*> drained;
+  auto visitor = [&](ArtMethod* method) { drained.push_back(method); };
+  for (size_t i = 0; i < HotMethodBuffer::kCapacity + 1; ++i) {
+    buffer.Push(FakeMethod(i));
+  }
+  // The last method was dropped.
+  EXPECT_FALSE(buffer.Drain(visitor));
+  ASSERT_EQ(HotMethodBuffer::kCapacity, drained.size());
+  EXPECT_EQ(FakeMethod(HotMethodBuffer::kCapacity - 1), drained.back());
+
+  // The slots are reused after the drain, and the overflow is only reported once.
+  drained.clear();
+  buffer.Push(FakeMethod(0));
+  EXPECT_TRUE(buffer.Drain(visitor));
+  ASSERT_EQ(1u, drained.size());
+  EXPECT_EQ(FakeMethod(0), drained[0]);
+}
+
+}  // namespace jit
+}  // namespace art
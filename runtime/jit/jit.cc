@@ -19,14 +19,17 @@
 #include <dlfcn.h>
 
 #include "art_method-inl.h"
+#include "base/arena_allocator.h"
 #include "base/enums.h"
 #include "base/logging.h"
 #include "base/memory_tool.h"
+#include "class_linker.h"
 #include "debugger.h"
 #include "entrypoints/runtime_asm_entrypoints.h"
 #include "interpreter/interpreter.h"
 #include "java_vm_ext.h"
 #include "jit_code_cache.h"
+#include "jit_loop_counters.h"
 #include "oat_file_manager.h"
 #include "oat_quick_method_header.h"
 #include "profile_compilation_info.h"
@@ -45,6 +48,8 @@ namespace jit {
 static constexpr bool kEnableOnStackReplacement = true;
 // At what priority to schedule jit threads. 9 is the lowest foreground priority on device.
 static constexpr int kJitPoolThreadPthreadPriority = 9;
+// At what priority to schedule the thread analyzing native methods, behind the compilations.
+static constexpr int kJniPoolThreadPthreadPriority = 19;
 
 // Different compilation threshold constants. These can be overridden on the command line.
 static constexpr size_t kJitDefaultCompileThreshold           = 10000;  // Non-debug default.
@@ -56,7 +61,7 @@ void* Jit::jit_library_handle_= nullptr;
 void* Jit::jit_compiler_handle_ = nullptr;
 void* (*Jit::jit_load_)(bool*) = nullptr;
 void (*Jit::jit_unload_)(void*) = nullptr;
-bool (*Jit::jit_compile_method_)(void*, ArtMethod*, Thread*, bool) = nullptr;
+bool (*Jit::jit_compile_method_)(void*, ArtMethod*, Thread*, bool, bool) = nullptr;
 void (*Jit::jit_types_loaded_)(void*, mirror::Class**, size_t count) = nullptr;
 bool Jit::generate_debug_info_ = false;
 
@@ -140,6 +145,17 @@ JitOptions* JitOptions::CreateFromRuntimeArguments(const RuntimeArgumentMap& opt
         jit_options->warmup_threshold_ / Jit::kDefaultInvokeTransitionWeightRatio,
         static_cast<size_t>(1));
   }
+  jit_options->thread_count_ =
+      std::max(options.GetOrDefault(RuntimeArgumentMap::JITThreadCount), 1u);
+  jit_options->tiered_compilation_ = options.Exists(RuntimeArgumentMap::JITTieredCompilation);
+  jit_options->generational_code_cache_ =
+      options.Exists(RuntimeArgumentMap::JITGenerationalCodeCache);
+  jit_options->precompile_ = options.Exists(RuntimeArgumentMap::JITPrecompile);
+  jit_options->count_loops_ = options.Exists(RuntimeArgumentMap::JITCountLoops);
+  // Precompiling the hot methods of the profile needs the profile of warm start.
+  jit_options->warm_start_ =
+      options.Exists(RuntimeArgumentMap::JITWarmStart) || jit_options->precompile_;
+  jit_options->perf_dump_ = options.Exists(RuntimeArgumentMap::JITPerfDump);
 
   return jit_options;
 }
@@ -152,6 +168,17 @@ bool Jit::ShouldUsePriorityThreadWeight() {
 void Jit::DumpInfo(std::ostream& os) {
   code_cache_->Dump(os);
   cumulative_timings_.Dump(os);
+  ArenaPool* arena_pool = Runtime::Current()->GetJitArenaPool();
+  if (arena_pool != nullptr) {
+    os << "JIT arena pool: " << PrettySize(arena_pool->GetBytesInUse()) << " in use, peak "
+       << PrettySize(arena_pool->GetPeakBytesInUse()) << "\n";
+  }
+  if (thread_pool_ != nullptr) {
+    thread_pool_->DumpQueueingLatency(os);
+  }
+  if (jni_thread_pool_ != nullptr) {
+    jni_thread_pool_->DumpQueueingLatency(os);
+  }
   MutexLock mu(Thread::Current(), lock_);
   memory_use_.PrintMemoryUse(os);
 }
@@ -159,6 +186,9 @@ void Jit::DumpInfo(std::ostream& os) {
 void Jit::DumpForSigQuit(std::ostream& os) {
   DumpInfo(os);
   ProfileSaver::DumpInstanceInfo(os);
+  if (loop_counters_ != nullptr) {
+    loop_counters_->Dump(os);
+  }
 }
 
 void Jit::AddTimingLogger(const TimingLogger& logger) {
@@ -174,7 +204,13 @@ Jit::Jit() : dump_info_on_shutdown_(false),
              warm_method_threshold_(0),
              osr_method_threshold_(0),
              priority_thread_weight_(0),
-             invoke_transition_weight_(0) {}
+             invoke_transition_weight_(0),
+             tiered_compilation_(false),
+             thread_count_(1),
+             compile_queue_lock_("JIT compile queue lock"),
+             warm_start_(false),
+             warm_start_lock_("JIT warm start lock"),
+             precompile_(false) {}
 
 Jit* Jit::Create(JitOptions* options, std::string* error_msg) {
   DCHECK(options->UseJitCompilation() || options->GetProfileSaverOptions().IsEnabled());
@@ -187,6 +223,7 @@ Jit* Jit::Create(JitOptions* options, std::string* error_msg) {
       options->GetCodeCacheInitialCapacity(),
       options->GetCodeCacheMaxCapacity(),
       jit->generate_debug_info_,
+      options->UseGenerationalCodeCache(),
       error_msg));
   if (jit->GetCodeCache() == nullptr) {
     return nullptr;
@@ -197,6 +234,13 @@ Jit* Jit::Create(JitOptions* options, std::string* error_msg) {
       << PrettySize(options->GetCodeCacheInitialCapacity())
       << ", max_capacity=" << PrettySize(options->GetCodeCacheMaxCapacity())
       << ", compile_threshold=" << options->GetCompileThreshold()
+      << ", thread_count=" << options->GetThreadCount()
+      << ", tiered_compilation=" << options->UseTieredCompilation()
+      << ", generational_code_cache=" << options->UseGenerationalCodeCache()
+      << ", warm_start=" << options->UseWarmStart()
+      << ", precompile=" << options->UsePrecompile()
+      << ", count_loops=" << options->CountLoops()
+      << ", perf_dump=" << options->UsePerfDump()
       << ", profile_saver_options=" << options->GetProfileSaverOptions();
 
 
@@ -205,6 +249,13 @@ Jit* Jit::Create(JitOptions* options, std::string* error_msg) {
   jit->osr_method_threshold_ = options->GetOsrThreshold();
   jit->priority_thread_weight_ = options->GetPriorityThreadWeight();
   jit->invoke_transition_weight_ = options->GetInvokeTransitionWeight();
+  jit->thread_count_ = options->GetThreadCount();
+  jit->tiered_compilation_ = options->UseTieredCompilation();
+  jit->warm_start_ = options->UseWarmStart();
+  jit->precompile_ = options->UsePrecompile();
+  if (options->CountLoops()) {
+    jit->loop_counters_.reset(new JitLoopCounters());
+  }
 
   jit->CreateThreadPool();
 
@@ -235,7 +286,7 @@ bool Jit::LoadCompilerLibrary(std::string* error_msg) {
     *error_msg = "JIT couldn't find jit_unload entry point";
     return false;
   }
-  jit_compile_method_ = reinterpret_cast<bool (*)(void*, ArtMethod*, Thread*, bool)>(
+  jit_compile_method_ = reinterpret_cast<bool (*)(void*, ArtMethod*, Thread*, bool, bool)>(
       dlsym(jit_library_handle_, "jit_compile_method"));
   if (jit_compile_method_ == nullptr) {
     dlclose(jit_library_handle_);
@@ -269,7 +320,7 @@ bool Jit::LoadCompiler(std::string* error_msg) {
   return true;
 }
 
-bool Jit::CompileMethod(ArtMethod* method, Thread* self, bool osr) {
+bool Jit::CompileMethod(ArtMethod* method, Thread* self, bool osr, bool baseline) {
   DCHECK(Runtime::Current()->UseJitCompilation());
   DCHECK(!method->IsRuntimeMethod());
 
@@ -286,22 +337,51 @@ bool Jit::CompileMethod(ArtMethod* method, Thread* self, bool osr) {
     return false;
   }
 
+  if (method->IsNative()) {
+    // The JNI stubs are shared by the native methods of the same kind, and need no
+    // profiling info.
+    if (!Runtime::Current()->GetClassLinker()->IsQuickGenericJniStub(
+            method->GetEntryPointFromQuickCompiledCode())) {
+      return false;
+    }
+    if (code_cache_->UseJniStub(method, JitCodeCache::GetJniStubKey(method))) {
+      return true;
+    }
+    VLOG(jit) << "Compiling JNI stub of " << ArtMethod::PrettyMethod(method);
+    bool success = jit_compile_method_(
+        jit_compiler_handle_, method, self, /* osr */ false, /* baseline */ false);
+    if (!success) {
+      VLOG(jit) << "Failed to compile JNI stub of " << ArtMethod::PrettyMethod(method);
+    }
+    return success;
+  }
+
   // If we get a request to compile a proxy method, we pass the actual Java method
   // of that proxy method, as the compiler does not expect a proxy method.
   ArtMethod* method_to_compile = method->GetInterfaceMethodIfProxy(kRuntimePointerSize);
-  if (!code_cache_->NotifyCompilationOf(method_to_compile, self, osr)) {
+  if (!code_cache_->NotifyCompilationOf(method_to_compile, self, osr, baseline)) {
     return false;
   }
 
   VLOG(jit) << "Compiling method "
             << ArtMethod::PrettyMethod(method_to_compile)
-            << " osr=" << std::boolalpha << osr;
-  bool success = jit_compile_method_(jit_compiler_handle_, method_to_compile, self, osr);
+            << " osr=" << std::boolalpha << osr
+            << " baseline=" << std::boolalpha << baseline;
+  bool success =
+      jit_compile_method_(jit_compiler_handle_, method_to_compile, self, osr, baseline);
   code_cache_->DoneCompiling(method_to_compile, self, osr);
   if (!success) {
     VLOG(jit) << "Failed to compile method "
               << ArtMethod::PrettyMethod(method_to_compile)
-              << " osr=" << std::boolalpha << osr;
+              << " osr=" << std::boolalpha << osr
+              << " baseline=" << std::boolalpha << baseline;
+  } else if (!osr) {
+    code_cache_->SetHasBaselineCode(method_to_compile, self, baseline);
+    if (baseline && thread_pool_ != nullptr) {
+      // The baseline code does not count its calls, queue the optimized compilation now, it
+      // runs once no method is waiting for its first compilation.
+      EnqueueCompilation(self, method, CompilationKind::kOptimized);
+    }
   }
   if (kIsDebugBuild) {
     if (self->IsExceptionPending()) {
@@ -321,9 +401,12 @@ void Jit::CreateThreadPool() {
 
   // We need peers as we may report the JIT thread, e.g., in the debugger.
   constexpr bool kJitPoolNeedsPeers = true;
-  thread_pool_.reset(new ThreadPool("Jit thread pool", 1, kJitPoolNeedsPeers));
+  thread_pool_.reset(new ThreadPool("Jit thread pool", thread_count_, kJitPoolNeedsPeers));
 
   thread_pool_->SetPthreadPriority(kJitPoolThreadPthreadPriority);
+  // A burst of native method registrations should not delay the compilation of hot methods.
+  jni_thread_pool_.reset(new ThreadPool("Jit JNI thread pool", 1, kJitPoolNeedsPeers));
+  jni_thread_pool_->SetPthreadPriority(kJniPoolThreadPthreadPriority);
   Start();
 }
 
@@ -332,27 +415,47 @@ void Jit::DeleteThreadPool() {
   DCHECK(Runtime::Current()->IsShuttingDown(self));
   if (thread_pool_ != nullptr) {
     std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<ThreadPool> jni_pool;
     {
       ScopedSuspendAll ssa(__FUNCTION__);
       // Clear thread_pool_ field while the threads are suspended.
       // A mutator in the 'AddSamples' method will check against it.
       pool = std::move(thread_pool_);
+      jni_pool = std::move(jni_thread_pool_);
     }
 
     // When running sanitized, let all tasks finish to not leak. Otherwise just clear the queue.
     if (!RUNNING_ON_MEMORY_TOOL) {
       pool->StopWorkers(self);
       pool->RemoveAllTasks(self);
+      jni_pool->StopWorkers(self);
+      jni_pool->RemoveAllTasks(self);
     }
     // We could just suspend all threads, but we know those threads
     // will finish in a short period, so it's not worth adding a suspend logic
     // here. Besides, this is only done for shutdown.
     pool->Wait(self, false, false);
+    jni_pool->Wait(self, false, false);
   }
 }
 
 void Jit::StartProfileSaver(const std::string& filename,
                             const std::vector<std::string>& code_paths) {
+  if (warm_start_ && use_jit_compilation_) {
+    std::unique_ptr<ProfileCompilationInfo> profile(new ProfileCompilationInfo());
+    if (profile->Load(filename, /* clear_if_invalid */ false)) {
+      VLOG(jit) << "Warm start with the " << profile->GetNumberOfMethods()
+                << " methods of " << filename;
+      {
+        MutexLock mu(Thread::Current(), warm_start_lock_);
+        warm_start_profile_ = std::move(profile);
+      }
+      if (precompile_) {
+        // The classes loaded from now on are precompiled as they are loaded.
+        EnqueueLoadedClassesPrecompilation(Thread::Current());
+      }
+    }
+  }
   if (profile_saver_options_.IsEnabled()) {
     ProfileSaver::Start(profile_saver_options_,
                         filename,
@@ -402,6 +505,9 @@ void Jit::NewTypeLoadedIfUsingJit(mirror::Class* type) {
     DCHECK(jit->jit_types_loaded_ != nullptr);
     jit->jit_types_loaded_(jit->jit_compiler_handle_, &type, 1);
   }
+  if (jit->precompile_) {
+    jit->EnqueuePrecompilations(Thread::Current(), type);
+  }
 }
 
 void Jit::DumpTypeInfoForLoadedTypes(ClassLinker* linker) {
@@ -592,9 +698,24 @@ class JitCompileTask FINAL : public Task {
   enum TaskKind {
     kAllocateProfile,
     kCompile,
-    kCompileOsr
+    kCompileBaseline,
+    kCompileOsr,
+    kPrecompile
   };
 
+  static TaskKind GetTaskKind(CompilationKind kind) {
+    switch (kind) {
+      case CompilationKind::kBaseline:
+        return kCompileBaseline;
+      case CompilationKind::kOptimized:
+        return kCompile;
+      case CompilationKind::kOsr:
+        return kCompileOsr;
+    }
+    LOG(FATAL) << "Unreachable";
+    UNREACHABLE();
+  }
+
   JitCompileTask(ArtMethod* method, TaskKind kind) : method_(method), kind_(kind) {
     ScopedObjectAccess soa(Thread::Current());
     // Add a global ref to the class to prevent class unloading until compilation is done.
@@ -611,8 +732,13 @@ class JitCompileTask FINAL : public Task {
     ScopedObjectAccess soa(self);
     if (kind_ == kCompile) {
       Runtime::Current()->GetJit()->CompileMethod(method_, self, /* osr */ false);
+    } else if (kind_ == kCompileBaseline) {
+      Runtime::Current()->GetJit()->CompileMethod(
+          method_, self, /* osr */ false, /* baseline */ true);
     } else if (kind_ == kCompileOsr) {
       Runtime::Current()->GetJit()->CompileMethod(method_, self, /* osr */ true);
+    } else if (kind_ == kPrecompile) {
+      Runtime::Current()->GetJit()->Precompile(self, method_);
     } else {
       DCHECK(kind_ == kAllocateProfile);
       if (ProfilingInfo::Create(self, method_, /* retry_allocation */ true)) {
@@ -626,6 +752,14 @@ class JitCompileTask FINAL : public Task {
     delete this;
   }
 
+  ArtMethod* GetMethod() const {
+    return method_;
+  }
+
+  TaskKind GetKind() const {
+    return kind_;
+  }
+
  private:
   ArtMethod* const method_;
   const TaskKind kind_;
@@ -634,6 +768,197 @@ class JitCompileTask FINAL : public Task {
   DISALLOW_IMPLICIT_CONSTRUCTORS(JitCompileTask);
 };
 
+// Runs the hottest compilation of the queue, which is not necessarily the one queued along with
+// this task.
+class JitCompileQueueTask FINAL : public SelfDeletingTask {
+ public:
+  void Run(Thread* self) OVERRIDE {
+    Runtime::Current()->GetJit()->RunHottestCompilation(self);
+  }
+};
+
+void Jit::EnqueueCompilation(Thread* self, ArtMethod* method, CompilationKind kind) {
+  {
+    MutexLock mu(self, compile_queue_lock_);
+    if (IsCompilationQueued(method, kind)) {
+      return;
+    }
+  }
+  // Creating the task adds a global reference, do it without holding the lock.
+  JitCompileTask* task = new JitCompileTask(method, JitCompileTask::GetTaskKind(kind));
+  {
+    MutexLock mu(self, compile_queue_lock_);
+    if (!IsCompilationQueued(method, kind)) {
+      compile_queue_.push_back(task);
+      task = nullptr;
+    }
+  }
+  if (task != nullptr) {
+    // Another thread queued the method meanwhile.
+    task->Finalize();
+    return;
+  }
+  thread_pool_->AddTask(self, new JitCompileQueueTask());
+}
+
+bool Jit::IsCompilationQueued(ArtMethod* method, CompilationKind kind) {
+  for (JitCompileTask* task : compile_queue_) {
+    if (task->GetMethod() == method && task->GetKind() == JitCompileTask::GetTaskKind(kind)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+JitCompileTask* Jit::TakeHottestCompilation(Thread* self) {
+  MutexLock mu(self, compile_queue_lock_);
+  if (compile_queue_.empty()) {
+    return nullptr;
+  }
+  const bool tiered_compilation = tiered_compilation_;
+  auto priority = [tiered_compilation](JitCompileTask* task)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    // With tiered compilation, the optimized compilations replace baseline code and wait for the
+    // methods still interpreted.
+    int rank = 1;
+    if (task->GetKind() == JitCompileTask::kCompileOsr) {
+      rank = 2;
+    } else if (tiered_compilation &&
+               task->GetKind() == JitCompileTask::kCompile &&
+               !task->GetMethod()->IsNative()) {
+      rank = 0;
+    }
+    // The hotness counters are read now rather than when the methods were queued, they all
+    // crossed the same threshold then.
+    return std::make_pair(rank, task->GetMethod()->GetCounter());
+  };
+  auto hottest = compile_queue_.begin();
+  for (auto it = hottest + 1; it != compile_queue_.end(); ++it) {
+    if (priority(*it) > priority(*hottest)) {
+      hottest = it;
+    }
+  }
+  JitCompileTask* task = *hottest;
+  compile_queue_.erase(hottest);
+  return task;
+}
+
+void Jit::RunHottestCompilation(Thread* self) {
+  JitCompileTask* task;
+  bool is_stale;
+  {
+    ScopedObjectAccess soa(self);
+    task = TakeHottestCompilation(self);
+    if (task == nullptr) {
+      // The queue was cleared.
+      return;
+    }
+    // Drop the compilations done since the method was queued, by a compilation at first use or
+    // an OSR compilation of the method.
+    ArtMethod* method = task->GetMethod();
+    if (task->GetKind() == JitCompileTask::kCompileOsr) {
+      is_stale = code_cache_->IsOsrCompiled(method);
+    } else if (method->IsNative()) {
+      is_stale = !Runtime::Current()->GetClassLinker()->IsQuickGenericJniStub(
+          method->GetEntryPointFromQuickCompiledCode());
+    } else if (task->GetKind() == JitCompileTask::kCompile && tiered_compilation_) {
+      // The optimized code replaces the baseline code, NotifyCompilationOf() checks it is.
+      is_stale = false;
+    } else {
+      is_stale = code_cache_->ContainsPc(method->GetEntryPointFromQuickCompiledCode());
+    }
+    if (is_stale) {
+      VLOG(jit) << "Dropping the stale compilation of " << method->PrettyMethod();
+    }
+  }
+  if (!is_stale) {
+    task->Run(self);
+  }
+  task->Finalize();
+}
+
+// The precompilations run after the other tasks of the thread pool, which have the default
+// priority: a worker only takes them when it has no method of this run to compile.
+static constexpr int32_t kJitPrecompilePriority = -1;
+
+// Enqueues the precompilations of the classes loaded before the profile of warm start.
+class JitPrecompileLoadedClassesTask FINAL : public SelfDeletingTask {
+ public:
+  void Run(Thread* self) OVERRIDE {
+    struct CollectClasses : public ClassVisitor {
+      bool operator()(ObjPtr<mirror::Class> klass) OVERRIDE
+          REQUIRES_SHARED(Locks::mutator_lock_) {
+        // The boot classes are in the boot image, or loaded before the app.
+        if (klass->GetClassLoader() != nullptr) {
+          classes_.push_back(klass.Ptr());
+        }
+        return true;
+      }
+      std::vector<mirror::Class*> classes_;
+    };
+
+    ScopedObjectAccess soa(self);
+    CollectClasses visitor;
+    Runtime::Current()->GetClassLinker()->VisitClasses(&visitor);
+    Jit* jit = Runtime::Current()->GetJit();
+    for (mirror::Class* klass : visitor.classes_) {
+      jit->EnqueuePrecompilations(self, klass);
+    }
+  }
+};
+
+void Jit::EnqueueLoadedClassesPrecompilation(Thread* self) {
+  thread_pool_->AddTask(self, new JitPrecompileLoadedClassesTask(), kJitPrecompilePriority);
+}
+
+void Jit::EnqueuePrecompilations(Thread* self, mirror::Class* klass) {
+  if (thread_pool_ == nullptr) {
+    // Should only see this when shutting down.
+    DCHECK(Runtime::Current()->IsShuttingDown(self));
+    return;
+  }
+  if (klass->GetClassLoader() == nullptr || klass->IsProxyClass() || !klass->IsResolved()) {
+    return;
+  }
+  for (ArtMethod& method : klass->GetDeclaredMethods(kRuntimePointerSize)) {
+    if (method.IsNative() ||
+        method.IsAbstract() ||
+        method.IsClassInitializer() ||
+        !method.IsCompilable() ||
+        // Compiled ahead of time.
+        method.GetOatMethodQuickCode(kRuntimePointerSize) != nullptr ||
+        !IsWarmStartMethod(self, &method)) {
+      continue;
+    }
+    thread_pool_->AddTask(
+        self, new JitCompileTask(&method, JitCompileTask::kPrecompile), kJitPrecompilePriority);
+  }
+}
+
+void Jit::Precompile(Thread* self, ArtMethod* method) {
+  if (code_cache_->ContainsPc(method->GetEntryPointFromQuickCompiledCode()) ||
+      method->GetCounter() >= hot_method_threshold_) {
+    // Compiled meanwhile, or about to be from its samples.
+    return;
+  }
+  if (method->GetProfilingInfo(kRuntimePointerSize) == nullptr &&
+      !ProfilingInfo::Create(self, method, /* retry_allocation */ true)) {
+    return;
+  }
+  VLOG(jit) << "Precompiling " << method->PrettyMethod();
+  CompileMethod(method, self, /* osr */ false, /* baseline */ tiered_compilation_);
+}
+
+bool Jit::IsWarmStartMethod(Thread* self, ArtMethod* method) {
+  if (!warm_start_) {
+    return false;
+  }
+  MutexLock mu(self, warm_start_lock_);
+  return warm_start_profile_ != nullptr &&
+      warm_start_profile_->GetMethodHotness(
+          MethodReference(method->GetDexFile(), method->GetDexMethodIndex())).IsHot();
+}
+
 void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_backedges) {
   if (thread_pool_ == nullptr) {
     // Should only see this when shutting down.
@@ -641,10 +966,14 @@ void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_
     return;
   }
 
-  if (method->IsClassInitializer() || method->IsNative() || !method->IsCompilable()) {
+  if (method->IsClassInitializer() || !method->IsCompilable()) {
     // We do not want to compile such methods.
     return;
   }
+  if (method->IsNative()) {
+    AddNativeSamples(self, method, count);
+    return;
+  }
   DCHECK(thread_pool_ != nullptr);
   DCHECK_GT(warm_method_threshold_, 0);
   DCHECK_GT(hot_method_threshold_, warm_method_threshold_);
@@ -653,6 +982,10 @@ void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_
   DCHECK_LE(priority_thread_weight_, hot_method_threshold_);
 
   int32_t starting_count = method->GetCounter();
+  if (starting_count == 0) {
+    // The first samples of the method, record it for the next profile save.
+    ProfileSaver::NotifyMethodSampled(self, method);
+  }
   if (Jit::ShouldUsePriorityThreadWeight()) {
     count *= priority_thread_weight_;
   }
@@ -663,6 +996,8 @@ void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_
       bool success = ProfilingInfo::Create(self, method, /* retry_allocation */ false);
       if (success) {
         VLOG(jit) << "Start profiling " << method->PrettyMethod();
+        // Now hot for the profile.
+        ProfileSaver::NotifyMethodSampled(self, method);
       }
 
       if (thread_pool_ == nullptr) {
@@ -676,6 +1011,9 @@ void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_
         // We failed allocating. Instead of doing the collection on the Java thread, we push
         // an allocation to a compiler thread, that will do the collection.
         thread_pool_->AddTask(self, new JitCompileTask(method, JitCompileTask::kAllocateProfile));
+      } else if (IsWarmStartMethod(self, method)) {
+        // Hot in the previous runs, compile it on the next samples.
+        new_count = hot_method_threshold_ - 1;
       }
     }
     // Avoid jumping more than one state at a time.
@@ -685,7 +1023,10 @@ void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_
       if ((new_count >= hot_method_threshold_) &&
           !code_cache_->ContainsPc(method->GetEntryPointFromQuickCompiledCode())) {
         DCHECK(thread_pool_ != nullptr);
-        thread_pool_->AddTask(self, new JitCompileTask(method, JitCompileTask::kCompile));
+        EnqueueCompilation(self,
+                           method,
+                           tiered_compilation_ ? CompilationKind::kBaseline
+                                               : CompilationKind::kOptimized);
       }
       // Avoid jumping more than one state at a time.
       new_count = std::min(new_count, osr_method_threshold_ - 1);
@@ -696,7 +1037,7 @@ void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_
       }
       if ((new_count >= osr_method_threshold_) &&  !code_cache_->IsOsrCompiled(method)) {
         DCHECK(thread_pool_ != nullptr);
-        thread_pool_->AddTask(self, new JitCompileTask(method, JitCompileTask::kCompileOsr));
+        EnqueueCompilation(self, method, CompilationKind::kOsr);
       }
     }
   }
@@ -704,6 +1045,30 @@ void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_
   method->SetCounter(new_count);
 }
 
+void Jit::AddNativeSamples(Thread* self, ArtMethod* method, uint16_t count) {
+  if (!use_jit_compilation_) {
+    return;
+  }
+  // A native method has no profiling info, its data is the JNI entry point. It only
+  // goes through the hot state, and is compiled once it uses the generic JNI.
+  int32_t starting_count = method->GetCounter();
+  if (starting_count >= hot_method_threshold_) {
+    return;
+  }
+  if (Jit::ShouldUsePriorityThreadWeight()) {
+    count *= priority_thread_weight_;
+  }
+  int32_t new_count = starting_count + count;   // int32 here to avoid wrap-around;
+  if ((new_count >= hot_method_threshold_) &&
+      Runtime::Current()->GetClassLinker()->IsQuickGenericJniStub(
+          method->GetEntryPointFromQuickCompiledCode())) {
+    DCHECK(thread_pool_ != nullptr);
+    // The JNI stubs have a single tier.
+    EnqueueCompilation(self, method, CompilationKind::kOptimized);
+  }
+  method->SetCounter(std::min(new_count, static_cast<int32_t>(hot_method_threshold_)));
+}
+
 void Jit::MethodEntered(Thread* thread, ArtMethod* method) {
   Runtime* runtime = Runtime::Current();
   if (UNLIKELY(runtime->UseJitCompilation() && runtime->GetJit()->JitAtFirstUse())) {
@@ -726,10 +1091,10 @@ void Jit::MethodEntered(Thread* thread, ArtMethod* method) {
 }
 
 bool Jit::AddJniTask(Thread* self, JniTask* task) {
-  if (thread_pool_ == nullptr) {
+  if (jni_thread_pool_ == nullptr) {
     return false;
   }
-  thread_pool_->AddTask(self, task);
+  jni_thread_pool_->AddTask(self, task);
   return true;
 }
 
@@ -757,10 +1122,13 @@ void Jit::Stop() {
   WaitForCompilationToFinish(self);
   GetThreadPool()->StopWorkers(self);
   WaitForCompilationToFinish(self);
+  jni_thread_pool_->StopWorkers(self);
+  jni_thread_pool_->Wait(self, false, false);
 }
 
 void Jit::Start() {
   GetThreadPool()->StartWorkers(Thread::Current());
+  jni_thread_pool_->StartWorkers(Thread::Current());
 }
 
 ScopedJitSuspend::ScopedJitSuspend() {
@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_JIT_JIT_H_
 #define ART_RUNTIME_JIT_JIT_H_
 
+#include <vector>
+
 #include "base/histogram-inl.h"
 #include "base/macros.h"
 #include "base/mutex.h"
@@ -41,7 +43,17 @@ class Class;
 namespace jit {
 
 class JitCodeCache;
+class JitLoopCounters;
+class JitCompileTask;
 class JitOptions;
+
+// The kinds of compilation of a method. With tiered compilation, a hot method is first compiled
+// quickly, without inlining nor loop optimizations, and then recompiled with all optimizations.
+enum class CompilationKind {
+  kBaseline,
+  kOptimized,
+  kOsr,
+};
 class JniTask : public Task { };
 
 static constexpr int16_t kJitCheckForOSR = -1;
@@ -57,7 +69,7 @@ class Jit {
 
   virtual ~Jit();
   static Jit* Create(JitOptions* options, std::string* error_msg);
-  bool CompileMethod(ArtMethod* method, Thread* self, bool osr)
+  bool CompileMethod(ArtMethod* method, Thread* self, bool osr, bool baseline = false)
       REQUIRES_SHARED(Locks::mutator_lock_);
   void CreateThreadPool();
 
@@ -69,6 +81,11 @@ class Jit {
     return code_cache_.get();
   }
 
+  // The counters of the loops transformed by the compiler, null without -Xjitcountloops.
+  JitLoopCounters* GetLoopCounters() const {
+    return loop_counters_.get();
+  }
+
   void DeleteThreadPool();
   // Dump interesting info: #methods compiled, code vs data size, compile / verify cumulative
   // loggers.
@@ -134,8 +151,11 @@ class Jit {
   // Starts the profile saver if the config options allow profile recording.
   // The profile will be stored in the specified `filename` and will contain
   // information collected from the given `code_paths` (a set of dex locations).
+  // With warm start, the profile the previous runs stored there is loaded first. With
+  // precompilation, its hot methods are then compiled without waiting for their samples.
   void StartProfileSaver(const std::string& filename,
-                         const std::vector<std::string>& code_paths);
+                         const std::vector<std::string>& code_paths)
+      REQUIRES(!warm_start_lock_);
   void StopProfileSaver();
 
   void DumpForSigQuit(std::ostream& os) REQUIRES(!lock_);
@@ -178,6 +198,8 @@ class Jit {
 
   // Start JIT threads.
   void Start();
+  // Queue a task on the thread pool analyzing the native methods, which runs at a lower
+  // priority than the compilations. Return false if there is no such thread pool.
   bool AddJniTask(Thread* self, JniTask* task);
 
  private:
@@ -185,12 +207,49 @@ class Jit {
 
   static bool LoadCompiler(std::string* error_msg);
 
+  // Queue the compilation of a method that became hot, unless it is already queued.
+  void EnqueueCompilation(Thread* self, ArtMethod* method, CompilationKind kind)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!compile_queue_lock_);
+
+  bool IsCompilationQueued(ArtMethod* method, CompilationKind kind)
+      REQUIRES(compile_queue_lock_);
+
+  // Run the queued compilation of the highest priority, see TakeHottestCompilation(). This is
+  // what the tasks added to the thread pool by EnqueueCompilation() do.
+  void RunHottestCompilation(Thread* self) REQUIRES(!compile_queue_lock_);
+
+  // Remove the queued compilation of the highest priority from the queue: the OSR compilations
+  // first, since their methods are stuck in a loop, then by hotness counter. With tiered
+  // compilation, the optimized compilations come last.
+  JitCompileTask* TakeHottestCompilation(Thread* self)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!compile_queue_lock_);
+
+  // Count the calls of a native method through the generic JNI, see AddSamples().
+  void AddNativeSamples(Thread* self, ArtMethod* method, uint16_t count)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Return whether the profile loaded for warm start has `method` hot. Such a method is
+  // compiled as soon as it becomes warm, instead of waiting to become hot again.
+  bool IsWarmStartMethod(Thread* self, ArtMethod* method)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!warm_start_lock_);
+
+  // Queue the precompilation of the methods of `klass` that the profile of warm start has hot,
+  // unless they have AOT code. The thread pool only runs them when it has nothing else to do.
+  void EnqueuePrecompilations(Thread* self, mirror::Class* klass)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!warm_start_lock_);
+
+  // Queue a task doing EnqueuePrecompilations() for each of the classes already loaded.
+  void EnqueueLoadedClassesPrecompilation(Thread* self);
+
+  // Compile `method` for its precompilation task, unless its samples did meanwhile.
+  void Precompile(Thread* self, ArtMethod* method) REQUIRES_SHARED(Locks::mutator_lock_);
+
   // JIT compiler
   static void* jit_library_handle_;
   static void* jit_compiler_handle_;
   static void* (*jit_load_)(bool*);
   static void (*jit_unload_)(void*);
-  static bool (*jit_compile_method_)(void*, ArtMethod*, Thread*, bool);
+  static bool (*jit_compile_method_)(void*, ArtMethod*, Thread*, bool, bool);
   static void (*jit_types_loaded_)(void*, mirror::Class**, size_t count);
 
   // Performance monitoring.
@@ -209,7 +268,30 @@ class Jit {
   uint16_t osr_method_threshold_;
   uint16_t priority_thread_weight_;
   uint16_t invoke_transition_weight_;
+  bool tiered_compilation_;
+  size_t thread_count_;
   std::unique_ptr<ThreadPool> thread_pool_;
+  std::unique_ptr<ThreadPool> jni_thread_pool_;
+
+  // The compilations of the hot methods waiting for a thread of thread_pool_, which has one task
+  // running the hottest of them for each.
+  Mutex compile_queue_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::vector<JitCompileTask*> compile_queue_ GUARDED_BY(compile_queue_lock_);
+
+  // The profile of the previous runs, with warm start. Its methods are matched against the
+  // loaded dex files by location and checksum.
+  bool warm_start_;
+  Mutex warm_start_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::unique_ptr<ProfileCompilationInfo> warm_start_profile_ GUARDED_BY(warm_start_lock_);
+
+  // Whether the hot methods of the warm start profile are compiled before they are run.
+  bool precompile_;
+
+  std::unique_ptr<JitLoopCounters> loop_counters_;
+
+  friend class JitCompileQueueTask;
+  friend class JitCompileTask;
+  friend class JitPrecompileLoadedClassesTask;
 
   DISALLOW_COPY_AND_ASSIGN(Jit);
 };
@@ -232,6 +314,27 @@ class JitOptions {
   size_t GetInvokeTransitionWeight() const {
     return invoke_transition_weight_;
   }
+  size_t GetThreadCount() const {
+    return thread_count_;
+  }
+  bool UseTieredCompilation() const {
+    return tiered_compilation_;
+  }
+  bool UseGenerationalCodeCache() const {
+    return generational_code_cache_;
+  }
+  bool UseWarmStart() const {
+    return warm_start_;
+  }
+  bool UsePrecompile() const {
+    return precompile_;
+  }
+  bool CountLoops() const {
+    return count_loops_;
+  }
+  bool UsePerfDump() const {
+    return perf_dump_;
+  }
   size_t GetCodeCacheInitialCapacity() const {
     return code_cache_initial_capacity_;
   }
@@ -270,6 +373,13 @@ class JitOptions {
   size_t osr_threshold_;
   uint16_t priority_thread_weight_;
   size_t invoke_transition_weight_;
+  size_t thread_count_;
+  bool tiered_compilation_;
+  bool generational_code_cache_;
+  bool warm_start_;
+  bool precompile_;
+  bool count_loops_;
+  bool perf_dump_;
   bool dump_info_on_shutdown_;
   ProfileSaverOptions profile_saver_options_;
 
@@ -282,6 +392,13 @@ class JitOptions {
         osr_threshold_(0),
         priority_thread_weight_(0),
         invoke_transition_weight_(0),
+        thread_count_(1),
+        tiered_compilation_(false),
+        generational_code_cache_(false),
+        warm_start_(false),
+        precompile_(false),
+        count_loops_(false),
+        perf_dump_(false),
         dump_info_on_shutdown_(false) {}
 
   DISALLOW_COPY_AND_ASSIGN(JitOptions);
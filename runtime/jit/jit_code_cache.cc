@@ -16,6 +16,7 @@
 
 #include "jit_code_cache.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include "arch/context.h"
@@ -34,6 +35,7 @@
 #include "jit/profiling_info.h"
 #include "linear_alloc.h"
 #include "mem_map.h"
+#include "method_header_cache.h"
 #include "oat_file-inl.h"
 #include "oat_quick_method_header.h"
 #include "object_callbacks.h"
@@ -63,6 +65,7 @@ static constexpr size_t kStackMapSizeLogThreshold = 50 * KB;
 JitCodeCache* JitCodeCache::Create(size_t initial_capacity,
                                    size_t max_capacity,
                                    bool generate_debug_info,
+                                   bool generational_collection,
                                    std::string* error_msg) {
   ScopedTrace trace(__PRETTY_FUNCTION__);
   CHECK_GE(max_capacity, initial_capacity);
@@ -130,8 +133,13 @@ JitCodeCache* JitCodeCache::Create(size_t initial_capacity,
   data_size = initial_capacity / 2;
   code_size = initial_capacity - data_size;
   DCHECK_EQ(code_size + data_size, initial_capacity);
-  return new JitCodeCache(
-      code_map, data_map.release(), code_size, data_size, max_capacity, garbage_collect_code);
+  return new JitCodeCache(code_map,
+                          data_map.release(),
+                          code_size,
+                          data_size,
+                          max_capacity,
+                          garbage_collect_code,
+                          generational_collection);
 }
 
 JitCodeCache::JitCodeCache(MemMap* code_map,
@@ -139,12 +147,17 @@ JitCodeCache::JitCodeCache(MemMap* code_map,
                            size_t initial_code_capacity,
                            size_t initial_data_capacity,
                            size_t max_capacity,
-                           bool garbage_collect_code)
+                           bool garbage_collect_code,
+                           bool generational_collection)
     : lock_("Jit code cache", kJitCodeCacheLock),
       lock_cond_("Jit code cache condition variable", lock_),
       collection_in_progress_(false),
+      young_collection_in_progress_(false),
       code_map_(code_map),
       data_map_(data_map),
+      code_index_(nullptr),
+      code_index_epoch_(0u),
+      unpublished_code_count_(0u),
       max_capacity_(max_capacity),
       current_capacity_(initial_code_capacity + initial_data_capacity),
       code_end_(initial_code_capacity),
@@ -152,11 +165,14 @@ JitCodeCache::JitCodeCache(MemMap* code_map,
       last_collection_increased_code_cache_(false),
       last_update_time_ns_(0),
       garbage_collect_code_(garbage_collect_code),
+      generational_collection_(generational_collection),
+      young_collections_in_a_row_(0),
       used_memory_for_data_(0),
       used_memory_for_code_(0),
       number_of_compilations_(0),
       number_of_osr_compilations_(0),
       number_of_collections_(0),
+      number_of_young_collections_(0),
       histogram_stack_map_memory_use_("Memory used for stack maps", 16),
       histogram_code_memory_use_("Memory used for compiled code", 16),
       histogram_profiling_info_memory_use_("Memory used for profiling info", 16),
@@ -182,6 +198,11 @@ JitCodeCache::JitCodeCache(MemMap* code_map,
             << PrettySize(initial_code_capacity);
 }
 
+JitCodeCache::~JitCodeCache() {
+  delete code_index_.LoadRelaxed();
+  STLDeleteElements(&retired_code_indexes_);
+}
+
 bool JitCodeCache::ContainsPc(const void* ptr) const {
   return code_map_->Begin() <= ptr && ptr < code_map_->End();
 }
@@ -270,9 +291,99 @@ uint8_t* JitCodeCache::CommitCode(Thread* self,
                                 has_should_deoptimize_flag,
                                 cha_single_implementation_list);
   }
+  ReclaimRetiredCodeIndexes(self);
   return result;
 }
 
+std::string JitCodeCache::GetJniStubKey(ArtMethod* method) {
+  DCHECK(method->IsNative());
+  std::string key(method->GetShorty());
+  key += method->IsStatic() ? 'S' : 'V';
+  key += method->IsSynchronized() ? 'Y' : 'N';
+  // The stubs of the other native methods check kAccFastNative when they are called, and
+  // follow the automatic fast JNI detection.
+  if (method->IsAnnotatedWithFastNative()) {
+    key += 'F';
+  } else if (method->IsAnnotatedWithCriticalNative()) {
+    key += 'C';
+  } else {
+    key += 'R';
+  }
+  return key;
+}
+
+bool JitCodeCache::UseJniStub(ArtMethod* method, const std::string& key) {
+  const void* entry_point = nullptr;
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    auto it = jni_stubs_map_.find(key);
+    if (it == jni_stubs_map_.end()) {
+      return false;
+    }
+    entry_point = OatQuickMethodHeader::FromCodePointer(it->second)->GetEntryPoint();
+  }
+  Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(method, entry_point);
+  return true;
+}
+
+uint8_t* JitCodeCache::CommitJniStub(Thread* self,
+                                     ArtMethod* method,
+                                     const std::string& key,
+                                     size_t frame_size_in_bytes,
+                                     size_t core_spill_mask,
+                                     size_t fp_spill_mask,
+                                     const uint8_t* code,
+                                     size_t code_size) {
+  size_t alignment = GetInstructionSetAlignment(kRuntimeISA);
+  // Ensure the header ends up at expected instruction alignment.
+  size_t header_size = RoundUp(sizeof(OatQuickMethodHeader), alignment);
+  size_t total_size = header_size + code_size;
+
+  OatQuickMethodHeader* method_header = nullptr;
+  {
+    ScopedThreadSuspension sts(self, kSuspended);
+    MutexLock mu(self, lock_);
+    WaitForCollectionBlockingAllocationsToComplete(self);
+    auto it = jni_stubs_map_.find(key);
+    if (it != jni_stubs_map_.end()) {
+      // Compiled concurrently for another method of the same kind.
+      method_header = OatQuickMethodHeader::FromCodePointer(it->second);
+    } else {
+      ScopedCodeCacheWrite scc(code_map_.get());
+      uint8_t* memory = AllocateCode(total_size);
+      if (memory == nullptr) {
+        return nullptr;
+      }
+      uint8_t* code_ptr = memory + header_size;
+
+      std::copy(code, code + code_size, code_ptr);
+      method_header = OatQuickMethodHeader::FromCodePointer(code_ptr);
+      // The JNI stubs have neither stack maps nor method info.
+      new (method_header) OatQuickMethodHeader(
+          /* vmap_table_offset */ 0u,
+          /* method_info_offset */ 0u,
+          frame_size_in_bytes,
+          core_spill_mask,
+          fp_spill_mask,
+          code_size);
+      // Flush caches before we remove write permission, see CommitCodeInternal().
+      FlushInstructionCache(reinterpret_cast<char*>(code_ptr),
+                            reinterpret_cast<char*>(code_ptr + code_size));
+      jni_stubs_map_.Put(key, code_ptr);
+      ++unpublished_code_count_;
+      MaybePublishCodeIndexLocked();
+      number_of_compilations_++;
+      histogram_code_memory_use_.AddValue(code_size);
+      VLOG(jit) << "JIT added JNI stub " << key << " for " << ArtMethod::PrettyMethod(method)
+                << " ccache_size=" << PrettySize(CodeCacheSizeLocked());
+    }
+  }
+  Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(
+      method, method_header->GetEntryPoint());
+  ReclaimRetiredCodeIndexes(self);
+  return reinterpret_cast<uint8_t*>(method_header);
+}
+
 bool JitCodeCache::WaitForPotentialCollectionToComplete(Thread* self) {
   bool in_collection = false;
   while (collection_in_progress_) {
@@ -282,6 +393,12 @@ bool JitCodeCache::WaitForPotentialCollectionToComplete(Thread* self) {
   return in_collection;
 }
 
+void JitCodeCache::WaitForCollectionBlockingAllocationsToComplete(Thread* self) {
+  while (collection_in_progress_ && !young_collection_in_progress_) {
+    lock_cond_.Wait(self);
+  }
+}
+
 static uintptr_t FromCodeToAllocation(const void* code) {
   size_t alignment = GetInstructionSetAlignment(kRuntimeISA);
   return reinterpret_cast<uintptr_t>(code) - RoundUp(sizeof(OatQuickMethodHeader), alignment);
@@ -410,6 +527,10 @@ void JitCodeCache::SweepRootTables(IsMarkedVisitor* visitor) {
 }
 
 void JitCodeCache::FreeCode(const void* code_ptr) {
+  InvalidateCodeIndexLocked();
+  // The stack walks may have cached the header of the code.
+  MethodHeaderCache::InvalidateAll();
+  young_code_.erase(code_ptr);
   uintptr_t allocation = FromCodeToAllocation(code_ptr);
   // Notify native debugger that we are about to remove the code.
   // It does nothing if we are not using native debugger.
@@ -454,6 +575,7 @@ void JitCodeCache::RemoveMethodsIn(Thread* self, const LinearAlloc& alloc) {
       for (auto it = method_code_map_.begin(); it != method_code_map_.end();) {
         if (alloc.ContainsUnsafe(it->second)) {
           method_headers.insert(OatQuickMethodHeader::FromCodePointer(it->first));
+          InvalidateCodeIndexLocked();
           it = method_code_map_.erase(it);
         } else {
           ++it;
@@ -534,7 +656,7 @@ void JitCodeCache::CopyInlineCacheInto(const InlineCache& ic,
 
 static void ClearMethodCounter(ArtMethod* method, bool was_warm) {
   if (was_warm) {
-    method->AddAccessFlags(kAccPreviouslyWarm);
+    method->SetPreviouslyWarm();
   }
   // We reset the counter to 1 so that the profile knows that the method was executed at least once.
   // This is required for layout purposes.
@@ -572,7 +694,7 @@ uint8_t* JitCodeCache::CommitCodeInternal(Thread* self,
   {
     ScopedThreadSuspension sts(self, kSuspended);
     MutexLock mu(self, lock_);
-    WaitForPotentialCollectionToComplete(self);
+    WaitForCollectionBlockingAllocationsToComplete(self);
     {
       ScopedCodeCacheWrite scc(code_map_.get());
       memory = AllocateCode(total_size);
@@ -652,6 +774,11 @@ uint8_t* JitCodeCache::CommitCodeInternal(Thread* self,
                      reinterpret_cast<char*>(roots_data + data_size));
     }
     method_code_map_.Put(code_ptr, method);
+    if (generational_collection_) {
+      young_code_.insert(code_ptr);
+    }
+    ++unpublished_code_count_;
+    MaybePublishCodeIndexLocked();
     if (osr) {
       number_of_osr_compilations_++;
       osr_code_map_.Put(method, code_ptr);
@@ -704,6 +831,7 @@ bool JitCodeCache::RemoveMethod(ArtMethod* method, bool release_memory) {
         if (release_memory) {
           FreeCode(code_iter->first);
         }
+        InvalidateCodeIndexLocked();
         code_iter = method_code_map_.erase(code_iter);
         in_cache = true;
         continue;
@@ -797,6 +925,7 @@ void JitCodeCache::MoveObsoleteMethod(ArtMethod* old_method, ArtMethod* new_meth
   // Update method_code_map_ to point to the new method.
   for (auto& it : method_code_map_) {
     if (it.second == old_method) {
+      InvalidateCodeIndexLocked();
       it.second = new_method;
     }
   }
@@ -844,7 +973,7 @@ size_t JitCodeCache::ReserveData(Thread* self,
   {
     ScopedThreadSuspension sts(self, kSuspended);
     MutexLock mu(self, lock_);
-    WaitForPotentialCollectionToComplete(self);
+    WaitForCollectionBlockingAllocationsToComplete(self);
     result = AllocateData(size);
   }
 
@@ -853,7 +982,7 @@ size_t JitCodeCache::ReserveData(Thread* self,
     GarbageCollectCache(self);
     ScopedThreadSuspension sts(self, kSuspended);
     MutexLock mu(self, lock_);
-    WaitForPotentialCollectionToComplete(self);
+    WaitForCollectionBlockingAllocationsToComplete(self);
     result = AllocateData(size);
   }
 
@@ -1010,6 +1139,16 @@ bool JitCodeCache::ShouldDoFullCollection() {
   }
 }
 
+bool JitCodeCache::ShouldDoYoungCollection() {
+  // Below the max capacity, the partial collections grow the code cache instead. Most of the
+  // young code should be dead for the young collections to be worth it, the code that dies
+  // after surviving one is left to the regular collections.
+  return generational_collection_ &&
+      current_capacity_ == max_capacity_ &&
+      !young_code_.empty() &&
+      young_collections_in_a_row_ < kMaxYoungCollectionsInARow;
+}
+
 void JitCodeCache::GarbageCollectCache(Thread* self) {
   ScopedTrace trace(__FUNCTION__);
   if (!garbage_collect_code_) {
@@ -1019,6 +1158,7 @@ void JitCodeCache::GarbageCollectCache(Thread* self) {
   }
 
   // Wait for an existing collection, or let everyone know we are starting one.
+  bool young_collection = false;
   {
     ScopedThreadSuspension sts(self, kSuspended);
     MutexLock mu(self, lock_);
@@ -1026,11 +1166,16 @@ void JitCodeCache::GarbageCollectCache(Thread* self) {
       return;
     } else {
       number_of_collections_++;
+      young_collection = ShouldDoYoungCollection();
+      if (young_collection) {
+        number_of_young_collections_++;
+      }
       live_bitmap_.reset(CodeCacheBitmap::Create(
           "code-cache-bitmap",
           reinterpret_cast<uintptr_t>(code_map_->Begin()),
           reinterpret_cast<uintptr_t>(code_map_->Begin() + current_capacity_ / 2)));
       collection_in_progress_ = true;
+      young_collection_in_progress_ = young_collection;
     }
   }
 
@@ -1039,20 +1184,20 @@ void JitCodeCache::GarbageCollectCache(Thread* self) {
     TimingLogger::ScopedTiming st("Code cache collection", &logger);
 
     bool do_full_collection = false;
-    {
+    if (!young_collection) {
       MutexLock mu(self, lock_);
       do_full_collection = ShouldDoFullCollection();
     }
 
     if (!kIsDebugBuild || VLOG_IS_ON(jit)) {
       LOG(INFO) << "Do "
-                << (do_full_collection ? "full" : "partial")
+                << (young_collection ? "young" : (do_full_collection ? "full" : "partial"))
                 << " code cache collection, code="
                 << PrettySize(CodeCacheSize())
                 << ", data=" << PrettySize(DataCacheSize());
     }
 
-    DoCollection(self, /* collect_profiling_info */ do_full_collection);
+    DoCollection(self, /* collect_profiling_info */ do_full_collection, young_collection);
 
     if (!kIsDebugBuild || VLOG_IS_ON(jit)) {
       LOG(INFO) << "After code cache collection, code="
@@ -1062,36 +1207,43 @@ void JitCodeCache::GarbageCollectCache(Thread* self) {
 
     {
       MutexLock mu(self, lock_);
-
-      // Increase the code cache only when we do partial collections.
-      // TODO: base this strategy on how full the code cache is?
-      if (do_full_collection) {
-        last_collection_increased_code_cache_ = false;
+      if (young_collection) {
+        // Leave the code cache capacity and the polling for the next full collection to the
+        // regular collections.
+        young_collections_in_a_row_++;
       } else {
-        last_collection_increased_code_cache_ = true;
-        IncreaseCodeCacheCapacity();
-      }
+        young_collections_in_a_row_ = 0;
 
-      bool next_collection_will_be_full = ShouldDoFullCollection();
-
-      // Start polling the liveness of compiled code to prepare for the next full collection.
-      if (next_collection_will_be_full) {
-        // Save the entry point of methods we have compiled, and update the entry
-        // point of those methods to the interpreter. If the method is invoked, the
-        // interpreter will update its entry point to the compiled code and call it.
-        for (ProfilingInfo* info : profiling_infos_) {
-          const void* entry_point = info->GetMethod()->GetEntryPointFromQuickCompiledCode();
-          if (ContainsPc(entry_point)) {
-            info->SetSavedEntryPoint(entry_point);
-            // Don't call Instrumentation::UpdateMethods, as it can check the declaring
-            // class of the method. We may be concurrently running a GC which makes accessing
-            // the class unsafe. We know it is OK to bypass the instrumentation as we've just
-            // checked that the current entry point is JIT compiled code.
-            info->GetMethod()->SetEntryPointFromQuickCompiledCode(GetQuickToInterpreterBridge());
-          }
+        // Increase the code cache only when we do partial collections.
+        // TODO: base this strategy on how full the code cache is?
+        if (do_full_collection) {
+          last_collection_increased_code_cache_ = false;
+        } else {
+          last_collection_increased_code_cache_ = true;
+          IncreaseCodeCacheCapacity();
         }
 
-        DCHECK(CheckLiveCompiledCodeHasProfilingInfo());
+        bool next_collection_will_be_full = ShouldDoFullCollection();
+
+        // Start polling the liveness of compiled code to prepare for the next full collection.
+        if (next_collection_will_be_full) {
+          // Save the entry point of methods we have compiled, and update the entry
+          // point of those methods to the interpreter. If the method is invoked, the
+          // interpreter will update its entry point to the compiled code and call it.
+          for (ProfilingInfo* info : profiling_infos_) {
+            const void* entry_point = info->GetMethod()->GetEntryPointFromQuickCompiledCode();
+            if (ContainsPc(entry_point)) {
+              info->SetSavedEntryPoint(entry_point);
+              // Don't call Instrumentation::UpdateMethods, as it can check the declaring
+              // class of the method. We may be concurrently running a GC which makes accessing
+              // the class unsafe. We know it is OK to bypass the instrumentation as we've just
+              // checked that the current entry point is JIT compiled code.
+              info->GetMethod()->SetEntryPointFromQuickCompiledCode(GetQuickToInterpreterBridge());
+            }
+          }
+
+          DCHECK(CheckLiveCompiledCodeHasProfilingInfo());
+        }
       }
       live_bitmap_.reset(nullptr);
       NotifyCollectionDone(self);
@@ -1100,31 +1252,58 @@ void JitCodeCache::GarbageCollectCache(Thread* self) {
   Runtime::Current()->GetJit()->AddTimingLogger(logger);
 }
 
-void JitCodeCache::RemoveUnmarkedCode(Thread* self) {
+void JitCodeCache::RemoveUnmarkedCode(Thread* self,
+                                      const std::unordered_set<const void*>* young_code) {
   ScopedTrace trace(__FUNCTION__);
   std::unordered_set<OatQuickMethodHeader*> method_headers;
   {
     MutexLock mu(self, lock_);
     ScopedCodeCacheWrite scc(code_map_.get());
-    // Iterate over all compiled code and remove entries that are not marked.
-    for (auto it = method_code_map_.begin(); it != method_code_map_.end();) {
-      const void* code_ptr = it->first;
-      uintptr_t allocation = FromCodeToAllocation(code_ptr);
-      if (GetLiveBitmap()->Test(allocation)) {
-        ++it;
-      } else {
-        method_headers.insert(OatQuickMethodHeader::FromCodePointer(it->first));
-        it = method_code_map_.erase(it);
+    if (young_code != nullptr) {
+      // Only remove the young code that is not marked.
+      for (const void* code_ptr : *young_code) {
+        auto it = method_code_map_.find(code_ptr);
+        if (it != method_code_map_.end() &&
+            !GetLiveBitmap()->Test(FromCodeToAllocation(code_ptr))) {
+          method_headers.insert(OatQuickMethodHeader::FromCodePointer(code_ptr));
+          InvalidateCodeIndexLocked();
+          method_code_map_.erase(it);
+        }
+      }
+      if (method_headers.size() * 4 < young_code->size()) {
+        // Most of the young code survived, collect the whole code cache next time.
+        young_collections_in_a_row_ = kMaxYoungCollectionsInARow;
+      }
+    } else {
+      // Iterate over all compiled code and remove entries that are not marked.
+      for (auto it = method_code_map_.begin(); it != method_code_map_.end();) {
+        const void* code_ptr = it->first;
+        uintptr_t allocation = FromCodeToAllocation(code_ptr);
+        if (GetLiveBitmap()->Test(allocation)) {
+          ++it;
+        } else {
+          method_headers.insert(OatQuickMethodHeader::FromCodePointer(it->first));
+          InvalidateCodeIndexLocked();
+          it = method_code_map_.erase(it);
+        }
       }
     }
   }
   FreeAllMethodHeaders(method_headers);
 }
 
-void JitCodeCache::DoCollection(Thread* self, bool collect_profiling_info) {
+void JitCodeCache::DoCollection(Thread* self, bool collect_profiling_info, bool young_collection) {
   ScopedTrace trace(__FUNCTION__);
+  // The code indexes replaced so far. They are deleted once all threads went through the
+  // checkpoint below, since no thread can be in the middle of a LookupCodeIndex() then.
+  std::vector<CodeIndex*> retired_code_indexes;
+  // The code a young collection may remove. The code committed from now on is left to the
+  // next collection.
+  std::unordered_set<const void*> young_code;
   {
     MutexLock mu(self, lock_);
+    retired_code_indexes.swap(retired_code_indexes_);
+    young_code.swap(young_code_);
     if (collect_profiling_info) {
       // Clear the profiling info of methods that do not have compiled code as entrypoint.
       // Also remove the saved entry point from the ProfilingInfo objects.
@@ -1141,6 +1320,17 @@ void JitCodeCache::DoCollection(Thread* self, bool collect_profiling_info) {
           ClearMethodCounter(info->GetMethod(), /*was_warm*/ true);
         }
       }
+    } else if (young_collection) {
+      // The young collections happen between the polling started by a regular collection
+      // and the full collection it prepares. Keep the code the interpreter may revive.
+      for (ProfilingInfo* info : profiling_infos_) {
+        const void* saved_entry_point = info->GetSavedEntryPoint();
+        if (saved_entry_point != nullptr) {
+          const void* code_ptr =
+              OatQuickMethodHeader::FromEntryPoint(saved_entry_point)->GetCode();
+          GetLiveBitmap()->AtomicTestAndSet(FromCodeToAllocation(code_ptr));
+        }
+      }
     } else if (kIsDebugBuild) {
       // Sanity check that the profiling infos do not have a dangling entry point.
       for (ProfilingInfo* info : profiling_infos_) {
@@ -1152,27 +1342,48 @@ void JitCodeCache::DoCollection(Thread* self, bool collect_profiling_info) {
     // an entry point is either:
     // - an osr compiled code, that will be removed if not in a thread call stack.
     // - discarded compiled code, that will be removed if not in a thread call stack.
-    for (const auto& it : method_code_map_) {
-      ArtMethod* method = it.second;
-      const void* code_ptr = it.first;
+    // A young collection only needs to mark its young code.
+    auto mark_entry_point = [this] (const void* code_ptr, ArtMethod* method)
+        NO_THREAD_SAFETY_ANALYSIS {
       const OatQuickMethodHeader* method_header = OatQuickMethodHeader::FromCodePointer(code_ptr);
       if (method_header->GetEntryPoint() == method->GetEntryPointFromQuickCompiledCode()) {
         GetLiveBitmap()->AtomicTestAndSet(FromCodeToAllocation(code_ptr));
       }
-    }
+    };
+    if (young_collection) {
+      for (const void* code_ptr : young_code) {
+        auto it = method_code_map_.find(code_ptr);
+        if (it != method_code_map_.end()) {
+          mark_entry_point(it->first, it->second);
+        }
+      }
+      // Only the young osr compiled code will be deleted (except the ones on thread stacks).
+      for (auto it = osr_code_map_.begin(); it != osr_code_map_.end();) {
+        if (young_code.find(it->second) != young_code.end()) {
+          it = osr_code_map_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    } else {
+      for (const auto& it : method_code_map_) {
+        mark_entry_point(it.first, it.second);
+      }
 
-    // Empty osr method map, as osr compiled code will be deleted (except the ones
-    // on thread stacks).
-    osr_code_map_.clear();
+      // Empty osr method map, as osr compiled code will be deleted (except the ones
+      // on thread stacks).
+      osr_code_map_.clear();
+    }
   }
 
   // Run a checkpoint on all threads to mark the JIT compiled code they are running.
   MarkCompiledCodeOnThreadStacks(self);
+  STLDeleteElements(&retired_code_indexes);
 
   // At this point, mutator threads are still running, and entrypoints of methods can
   // change. We do know they cannot change to a code cache entry that is not marked,
   // therefore we can safely remove those entries.
-  RemoveUnmarkedCode(self);
+  RemoveUnmarkedCode(self, young_collection ? &young_code : nullptr);
 
   if (collect_profiling_info) {
     ScopedThreadSuspension sts(self, kSuspended);
@@ -1232,7 +1443,22 @@ OatQuickMethodHeader* JitCodeCache::LookupMethodHeader(uintptr_t pc, ArtMethod*
     return nullptr;
   }
 
+  OatQuickMethodHeader* indexed_header = LookupCodeIndex(pc, method);
+  if (indexed_header != nullptr) {
+    return indexed_header;
+  }
+
   MutexLock mu(Thread::Current(), lock_);
+  // Publish the code this lookup may have missed in the index, for the next ones.
+  MaybePublishCodeIndexLocked();
+  if (method == nullptr || method->IsNative()) {
+    for (const auto& entry : jni_stubs_map_) {
+      OatQuickMethodHeader* method_header = OatQuickMethodHeader::FromCodePointer(entry.second);
+      if (method_header->Contains(pc)) {
+        return method_header;
+      }
+    }
+  }
   if (method_code_map_.empty()) {
     return nullptr;
   }
@@ -1261,6 +1487,94 @@ OatQuickMethodHeader* JitCodeCache::LookupMethodHeader(uintptr_t pc, ArtMethod*
   return method_header;
 }
 
+OatQuickMethodHeader* JitCodeCache::LookupCodeIndex(uintptr_t pc, ArtMethod* method) {
+  const CodeIndex* index = code_index_.LoadAcquire();
+  if (index == nullptr || index->epoch != code_index_epoch_.LoadAcquire()) {
+    return nullptr;
+  }
+  const void* key = reinterpret_cast<const void*>(pc);
+  auto it = std::upper_bound(
+      index->entries.begin(),
+      index->entries.end(),
+      key,
+      [](const void* ptr, const std::pair<const void*, ArtMethod*>& entry) {
+        return ptr < entry.first;
+      });
+  if (it == index->entries.begin()) {
+    return nullptr;
+  }
+  --it;
+  ArtMethod* indexed_method = it->second;
+  if (indexed_method == nullptr && method != nullptr && !method->IsNative()) {
+    // A JNI stub, which the locked lookup does not consider either for this method.
+    return nullptr;
+  }
+  OatQuickMethodHeader* method_header = OatQuickMethodHeader::FromCodePointer(it->first);
+  bool contains = method_header->Contains(pc);
+  // The code may have been freed while we read its header, in which case the epoch changed.
+  QuasiAtomic::ThreadFenceAcquire();
+  if (!contains || index->epoch != code_index_epoch_.LoadRelaxed()) {
+    return nullptr;
+  }
+  if (kIsDebugBuild && method != nullptr && indexed_method != nullptr) {
+    // See LookupMethodHeader() for why the non-obsolete methods are compared.
+    DCHECK_EQ(indexed_method->GetNonObsoleteMethod(), method->GetNonObsoleteMethod())
+        << ArtMethod::PrettyMethod(method->GetNonObsoleteMethod()) << " "
+        << ArtMethod::PrettyMethod(indexed_method->GetNonObsoleteMethod()) << " "
+        << std::hex << pc;
+  }
+  return method_header;
+}
+
+void JitCodeCache::InvalidateCodeIndexLocked() {
+  code_index_epoch_.FetchAndAddSequentiallyConsistent(1u);
+  // Order the new epoch before the changes to the code, for the readers checking it after.
+  QuasiAtomic::ThreadFenceRelease();
+}
+
+void JitCodeCache::MaybePublishCodeIndexLocked() {
+  // Rebuilding the index costs a copy of the maps, so new code is published by batches,
+  // the lookups of the code committed since the last batch take lock_.
+  static constexpr size_t kMinCodeIndexBatch = 16;
+  CodeIndex* index = code_index_.LoadRelaxed();
+  uint64_t epoch = code_index_epoch_.LoadRelaxed();
+  if (index != nullptr &&
+      index->epoch == epoch &&
+      unpublished_code_count_ < std::max(kMinCodeIndexBatch, index->entries.size() / 4)) {
+    return;
+  }
+  CodeIndex* new_index = new CodeIndex();
+  new_index->epoch = epoch;
+  new_index->entries.reserve(method_code_map_.size() + jni_stubs_map_.size());
+  for (const auto& entry : method_code_map_) {
+    new_index->entries.emplace_back(entry.first, entry.second);
+  }
+  for (const auto& entry : jni_stubs_map_) {
+    new_index->entries.emplace_back(entry.second, nullptr);
+  }
+  std::sort(new_index->entries.begin(), new_index->entries.end());
+  code_index_.StoreRelease(new_index);
+  if (index != nullptr) {
+    retired_code_indexes_.push_back(index);
+  }
+  unpublished_code_count_ = 0u;
+}
+
+void JitCodeCache::ReclaimRetiredCodeIndexes(Thread* self) {
+  std::vector<CodeIndex*> retired_code_indexes;
+  {
+    MutexLock mu(self, lock_);
+    if (retired_code_indexes_.size() < kMaxRetiredCodeIndexes) {
+      return;
+    }
+    retired_code_indexes.swap(retired_code_indexes_);
+  }
+  // The readers hold the mutator lock and do not suspend within a LookupCodeIndex(), none of
+  // them reads a retired index anymore once they all went through a checkpoint.
+  Runtime::Current()->GetThreadList()->RunEmptyCheckpoint();
+  STLDeleteElements(&retired_code_indexes);
+}
+
 OatQuickMethodHeader* JitCodeCache::LookupOsrMethodHeader(ArtMethod* method) {
   MutexLock mu(Thread::Current(), lock_);
   auto it = osr_code_map_.find(method);
@@ -1432,10 +1746,8 @@ bool JitCodeCache::IsOsrCompiled(ArtMethod* method) {
   return osr_code_map_.find(method) != osr_code_map_.end();
 }
 
-bool JitCodeCache::NotifyCompilationOf(ArtMethod* method, Thread* self, bool osr) {
-  if (!osr && ContainsPc(method->GetEntryPointFromQuickCompiledCode())) {
-    return false;
-  }
+bool JitCodeCache::NotifyCompilationOf(ArtMethod* method, Thread* self, bool osr, bool baseline) {
+  const bool replaces_code = !osr && ContainsPc(method->GetEntryPointFromQuickCompiledCode());
 
   MutexLock mu(self, lock_);
   if (osr && (osr_code_map_.find(method) != osr_code_map_.end())) {
@@ -1443,6 +1755,9 @@ bool JitCodeCache::NotifyCompilationOf(ArtMethod* method, Thread* self, bool osr
   }
 
   ProfilingInfo* info = method->GetProfilingInfo(kRuntimePointerSize);
+  if (replaces_code && (baseline || info == nullptr || !info->HasBaselineCode())) {
+    return false;
+  }
   if (info == nullptr) {
     VLOG(jit) << method->PrettyMethod() << " needs a ProfilingInfo to be compiled";
     // Because the counter is not atomic, there are some rare cases where we may not hit the
@@ -1484,6 +1799,14 @@ void JitCodeCache::DoneCompiling(ArtMethod* method, Thread* self ATTRIBUTE_UNUSE
   info->SetIsMethodBeingCompiled(false, osr);
 }
 
+void JitCodeCache::SetHasBaselineCode(ArtMethod* method, Thread* self, bool value) {
+  MutexLock mu(self, lock_);
+  ProfilingInfo* info = method->GetProfilingInfo(kRuntimePointerSize);
+  if (info != nullptr) {
+    info->SetHasBaselineCode(value);
+  }
+}
+
 size_t JitCodeCache::GetMemorySizeOfCodePointer(const void* ptr) {
   MutexLock mu(Thread::Current(), lock_);
   return mspace_usable_size(reinterpret_cast<const void*>(FromCodeToAllocation(ptr)));
@@ -1550,7 +1873,9 @@ void JitCodeCache::Dump(std::ostream& os) {
      << "Total number of JIT compilations: " << number_of_compilations_ << "\n"
      << "Total number of JIT compilations for on stack replacement: "
         << number_of_osr_compilations_ << "\n"
-     << "Total number of JIT code cache collections: " << number_of_collections_ << std::endl;
+     << "Total number of JIT code cache collections: " << number_of_collections_ << "\n"
+     << "Total number of young JIT code cache collections: " << number_of_young_collections_
+        << std::endl;
   histogram_stack_map_memory_use_.PrintMemoryUse(os);
   histogram_code_memory_use_.PrintMemoryUse(os);
   histogram_profiling_info_memory_use_.PrintMemoryUse(os);
@@ -60,20 +60,34 @@ class JitCodeCache {
   // By default, do not GC until reaching 256KB.
   static constexpr size_t kReservedCapacity = kInitialCapacity * 4;
 
+  // With generational collection, the number of young collections done before collecting the
+  // whole code cache again.
+  static constexpr size_t kMaxYoungCollectionsInARow = 4;
+
+  // The number of replaced code indexes kept before the commits reclaim them.
+  static constexpr size_t kMaxRetiredCodeIndexes = 8;
+
   // Create the code cache with a code + data capacity equal to "capacity", error message is passed
-  // in the out arg error_msg.
+  // in the out arg error_msg. With `generational_collection`, the collections of a full code
+  // cache only consider the code committed since the previous one most of the time, see
+  // ShouldDoYoungCollection().
   static JitCodeCache* Create(size_t initial_capacity,
                               size_t max_capacity,
                               bool generate_debug_info,
+                              bool generational_collection,
                               std::string* error_msg);
 
+  ~JitCodeCache();
+
   // Number of bytes allocated in the code cache.
   size_t CodeCacheSize() REQUIRES(!lock_);
 
   // Number of bytes allocated in the data cache.
   size_t DataCacheSize() REQUIRES(!lock_);
 
-  bool NotifyCompilationOf(ArtMethod* method, Thread* self, bool osr)
+  // Returns whether the compiler may compile `method`. A non-OSR compilation of a method with
+  // compiled code is allowed if it replaces baseline code with optimized code.
+  bool NotifyCompilationOf(ArtMethod* method, Thread* self, bool osr, bool baseline = false)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!lock_);
 
@@ -93,6 +107,11 @@ class JitCodeCache {
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!lock_);
 
+  // Record whether the code a compilation just committed for `method` is baseline code.
+  void SetHasBaselineCode(ArtMethod* method, Thread* self, bool value)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!lock_);
+
   void DoneCompilerUse(ArtMethod* method, Thread* self)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!lock_);
@@ -121,6 +140,30 @@ class JitCodeCache {
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!lock_);
 
+  // Return the key of the JNI stubs shared by the native methods with the same shorty,
+  // static and synchronized modifiers, and @FastNative or @CriticalNative annotation.
+  static std::string GetJniStubKey(ArtMethod* method) REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Use the JNI stub compiled for the methods with key `key` as the entry point of the
+  // native method `method`. Return false if there is no such stub.
+  bool UseJniStub(ArtMethod* method, const std::string& key)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!lock_);
+
+  // Write the JNI stub of the methods with key `key` to the code cache, and use it as the
+  // entry point of `method`. The stubs are never collected: they do not depend on the
+  // methods using them, and there are few of them. Return null if there is no more room.
+  uint8_t* CommitJniStub(Thread* self,
+                         ArtMethod* method,
+                         const std::string& key,
+                         size_t frame_size_in_bytes,
+                         size_t core_spill_mask,
+                         size_t fp_spill_mask,
+                         const uint8_t* code,
+                         size_t code_size)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!lock_);
+
   // Return true if the code cache contains this pc.
   bool ContainsPc(const void* pc) const;
 
@@ -155,6 +198,10 @@ class JitCodeCache {
       REQUIRES(lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Return whether we should only collect the code committed since the previous collection.
+  // The compiler threads keep committing code during such a young collection.
+  bool ShouldDoYoungCollection() REQUIRES(lock_);
+
   // Perform a collection on the code cache.
   void GarbageCollectCache(Thread* self)
       REQUIRES(!lock_)
@@ -162,7 +209,8 @@ class JitCodeCache {
 
   // Given the 'pc', try to find the JIT compiled code associated with it.
   // Return null if 'pc' is not in the code cache. 'method' is passed for
-  // sanity check.
+  // sanity check. Only takes lock_ if the code is not in the published code
+  // index yet, see LookupCodeIndex().
   OatQuickMethodHeader* LookupMethodHeader(uintptr_t pc, ArtMethod* method)
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -247,13 +295,45 @@ class JitCodeCache {
   }
 
  private:
+  // A snapshot of the compiled code of the cache and of the JNI stubs, sorted by code pointer.
+  // The JNI stubs have no method.
+  struct CodeIndex {
+    // The value of code_index_epoch_ the snapshot is valid for.
+    uint64_t epoch;
+    std::vector<std::pair<const void*, ArtMethod*>> entries;
+  };
+
   // Take ownership of maps.
   JitCodeCache(MemMap* code_map,
                MemMap* data_map,
                size_t initial_code_capacity,
                size_t initial_data_capacity,
                size_t max_capacity,
-               bool garbage_collect_code);
+               bool garbage_collect_code,
+               bool generational_collection);
+
+  // Search the published code index for the code containing `pc`, without taking lock_.
+  // Returns null if the code is not there, or if the index is stale because code was removed
+  // from the cache since it was published.
+  OatQuickMethodHeader* LookupCodeIndex(uintptr_t pc, ArtMethod* method)
+      REQUIRES(!lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Make the published code index stale, before code is removed from the cache.
+  void InvalidateCodeIndexLocked() REQUIRES(lock_);
+
+  // Publish a new code index if the published one is stale, or if enough code was committed
+  // since it was. The replaced index is deleted by the next collection, see DoCollection(),
+  // or by ReclaimRetiredCodeIndexes() once enough of them are retired.
+  void MaybePublishCodeIndexLocked() REQUIRES(lock_);
+
+  // Delete the retired code indexes if there are kMaxRetiredCodeIndexes of them, after all
+  // threads went through an empty checkpoint. The collections do not reclaim them when the
+  // code is not garbage collected, or not often enough when the code index is republished
+  // by many commits between two collections.
+  void ReclaimRetiredCodeIndexes(Thread* self)
+      REQUIRES(!lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Internal version of 'CommitCode' that will not retry if the
   // allocation fails. Return null if the allocation fails.
@@ -286,6 +366,11 @@ class JitCodeCache {
   bool WaitForPotentialCollectionToComplete(Thread* self)
       REQUIRES(lock_) REQUIRES(!Locks::mutator_lock_);
 
+  // If a collection that allocations must wait for is in progress, wait for it to finish.
+  // Unlike the others, a young collection lets the compiler threads allocate and commit.
+  void WaitForCollectionBlockingAllocationsToComplete(Thread* self)
+      REQUIRES(lock_) REQUIRES(!Locks::mutator_lock_);
+
   // Remove CHA dependents and underlying allocations for entries in `method_headers`.
   void FreeAllMethodHeaders(const std::unordered_set<OatQuickMethodHeader*>& method_headers)
       REQUIRES(!lock_)
@@ -310,11 +395,13 @@ class JitCodeCache {
   // Set the footprint limit of the code cache.
   void SetFootprintLimit(size_t new_footprint) REQUIRES(lock_);
 
-  void DoCollection(Thread* self, bool collect_profiling_info)
+  // With `young_collection`, only the code committed since the previous collection is freed.
+  void DoCollection(Thread* self, bool collect_profiling_info, bool young_collection)
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
-  void RemoveUnmarkedCode(Thread* self)
+  // Remove the unmarked code, only among `young_code` if not null.
+  void RemoveUnmarkedCode(Thread* self, const std::unordered_set<const void*>* young_code)
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -341,6 +428,8 @@ class JitCodeCache {
   ConditionVariable lock_cond_ GUARDED_BY(lock_);
   // Whether there is a code cache collection in progress.
   bool collection_in_progress_ GUARDED_BY(lock_);
+  // Whether the collection in progress is a young collection.
+  bool young_collection_in_progress_ GUARDED_BY(lock_);
   // Mem map which holds code.
   std::unique_ptr<MemMap> code_map_;
   // Mem map which holds data (stack maps and profiling info).
@@ -355,6 +444,16 @@ class JitCodeCache {
   SafeMap<const void*, ArtMethod*> method_code_map_ GUARDED_BY(lock_);
   // Holds osr compiled code associated to the ArtMethod.
   SafeMap<ArtMethod*, const void*> osr_code_map_ GUARDED_BY(lock_);
+  // Holds the JNI stubs, by their key (see GetJniStubKey()).
+  SafeMap<std::string, const void*> jni_stubs_map_ GUARDED_BY(lock_);
+  // The published code index, read without taking lock_.
+  Atomic<CodeIndex*> code_index_;
+  // Incremented whenever code is removed from the cache.
+  Atomic<uint64_t> code_index_epoch_;
+  // The number of code commits since the code index was published.
+  size_t unpublished_code_count_ GUARDED_BY(lock_);
+  // The replaced code indexes, which threads may still be reading.
+  std::vector<CodeIndex*> retired_code_indexes_ GUARDED_BY(lock_);
   // ProfilingInfo objects we have allocated.
   std::vector<ProfilingInfo*> profiling_infos_ GUARDED_BY(lock_);
 
@@ -380,6 +479,15 @@ class JitCodeCache {
   // Whether we can do garbage collection. Not 'const' as tests may override this.
   bool garbage_collect_code_;
 
+  // Whether the collections of a full code cache are mostly young collections.
+  const bool generational_collection_;
+
+  // With generational collection, the code committed since the last collection started.
+  std::unordered_set<const void*> young_code_ GUARDED_BY(lock_);
+
+  // The number of young collections since the last collection of the whole code cache.
+  size_t young_collections_in_a_row_ GUARDED_BY(lock_);
+
   // The size in bytes of used memory for the data portion of the code cache.
   size_t used_memory_for_data_ GUARDED_BY(lock_);
 
@@ -395,6 +503,9 @@ class JitCodeCache {
   // Number of code cache collections done throughout the lifetime of the JIT.
   size_t number_of_collections_ GUARDED_BY(lock_);
 
+  // Number of young code cache collections, among the collections above.
+  size_t number_of_young_collections_ GUARDED_BY(lock_);
+
   // Histograms for keeping track of stack map size statistics.
   Histogram<uint64_t> histogram_stack_map_memory_use_ GUARDED_BY(lock_);
 
@@ -412,6 +523,8 @@ class JitCodeCache {
   // Condition to wait on for accessing inline caches.
   ConditionVariable inline_cache_cond_ GUARDED_BY(lock_);
 
+  friend class JitCodeCacheTest;
+
   DISALLOW_IMPLICIT_CONSTRUCTORS(JitCodeCache);
 };
 
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_code_cache.h"
+
+#include <memory>
+
+#include "base/mutex.h"
+#include "common_runtime_test.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+namespace jit {
+
+class JitCodeCacheTest : public CommonRuntimeTest {
+ protected:
+  // Replace the published code index, as a commit or a removal of code would.
+  static void Republish(JitCodeCache* code_cache) NO_THREAD_SAFETY_ANALYSIS {
+    MutexLock mu(Thread::Current(), code_cache->lock_);
+    code_cache->InvalidateCodeIndexLocked();
+    code_cache->MaybePublishCodeIndexLocked();
+  }
+
+  static size_t GetRetiredCodeIndexCount(JitCodeCache* code_cache) NO_THREAD_SAFETY_ANALYSIS {
+    MutexLock mu(Thread::Current(), code_cache->lock_);
+    return code_cache->retired_code_indexes_.size();
+  }
+
+  static void Reclaim(JitCodeCache* code_cache) NO_THREAD_SAFETY_ANALYSIS {
+    code_cache->ReclaimRetiredCodeIndexes(Thread::Current());
+  }
+};
+
+TEST_F(JitCodeCacheTest, RetiredCodeIndexesReclaimedWithoutCollections) {
+  std::string error_msg;
+  std::unique_ptr<JitCodeCache> code_cache(JitCodeCache::Create(JitCodeCache::kInitialCapacity,
+                                                                JitCodeCache::kMaxCapacity,
+                                                                /* generate_debug_info */ true,
+                                                                /* generational */ false,
+                                                                &error_msg));
+  ASSERT_TRUE(code_cache != nullptr) << error_msg;
+  // As with a debuggable runtime, the collections would not reclaim the retired indexes.
+  code_cache->SetGarbageCollectCode(false);
+
+  ScopedObjectAccess soa(Thread::Current());
+  for (size_t i = 0; i != 100 * JitCodeCache::kMaxRetiredCodeIndexes; ++i) {
+    Republish(code_cache.get());
+    Reclaim(code_cache.get());
+    EXPECT_LT(GetRetiredCodeIndexCount(code_cache.get()), JitCodeCache::kMaxRetiredCodeIndexes);
+  }
+}
+
+TEST_F(JitCodeCacheTest, RetiredCodeIndexesKeptUntilTheCap) {
+  std::string error_msg;
+  std::unique_ptr<JitCodeCache> code_cache(JitCodeCache::Create(JitCodeCache::kInitialCapacity,
+                                                                JitCodeCache::kMaxCapacity,
+                                                                /* generate_debug_info */ true,
+                                                                /* generational */ false,
+                                                                &error_msg));
+  ASSERT_TRUE(code_cache != nullptr) << error_msg;
+
+  ScopedObjectAccess soa(Thread::Current());
+  // The first publication retires nothing.
+  Republish(code_cache.get());
+  for (size_t i = 1; i != JitCodeCache::kMaxRetiredCodeIndexes; ++i) {
+    Republish(code_cache.get());
+    Reclaim(code_cache.get());
+    EXPECT_EQ(i, GetRetiredCodeIndexCount(code_cache.get()));
+  }
+  Republish(code_cache.get());
+  Reclaim(code_cache.get());
+  EXPECT_EQ(0u, GetRetiredCodeIndexCount(code_cache.get()));
+}
+
+}  // namespace jit
+}  // namespace art
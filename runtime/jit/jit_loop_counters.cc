@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_loop_counters.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "thread-current-inl.h"
+
+namespace art {
+namespace jit {
+
+JitLoopCounters::Counters* JitLoopCounters::GetCounters(const std::string& method,
+                                                        uint32_t dex_pc,
+                                                        const std::string& passes) {
+  MutexLock mu(Thread::Current(), lock_);
+  auto it = counters_.emplace(Key(method, dex_pc, passes), Counters{0u, 0u}).first;
+  return &it->second;
+}
+
+void JitLoopCounters::Dump(std::ostream& os) {
+  std::vector<std::pair<Key, Counters>> loops;
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    for (const auto& entry : counters_) {
+      if (entry.second.entries != 0u || entry.second.iterations != 0u) {
+        loops.push_back(entry);
+      }
+    }
+  }
+  std::sort(loops.begin(),
+            loops.end(),
+            [](const std::pair<Key, Counters>& a, const std::pair<Key, Counters>& b) {
+              return a.second.iterations > b.second.iterations;
+            });
+  os << "JIT loop counters: " << loops.size() << " loops ran\n";
+  for (const auto& loop : loops) {
+    const Counters& counters = loop.second;
+    os << "  " << std::get<0>(loop.first) << " loop@0x" << std::hex << std::get<1>(loop.first)
+       << std::dec << " [" << std::get<2>(loop.first) << "]: entries=" << counters.entries
+       << " iterations=" << counters.iterations;
+    if (counters.entries != 0u) {
+      os << " average_trips=" << counters.iterations / counters.entries;
+    }
+    os << "\n";
+  }
+}
+
+}  // namespace jit
+}  // namespace art
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_JIT_LOOP_COUNTERS_H_
+#define ART_RUNTIME_JIT_JIT_LOOP_COUNTERS_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <tuple>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+namespace jit {
+
+// The counters of the loops that compiler passes transformed, with -Xjitcountloops. The JIT code
+// of the loops increments them in place, without synchronization: a count may miss the
+// increments of racing threads, which is fine to tell the hot loops from the cold ones.
+//
+// The counters are not freed with the code, they stay for the lifetime of the JIT. The code
+// compiled again for a loop, after a collection or for OSR, adds to the same counters.
+class JitLoopCounters {
+ public:
+  struct Counters {
+    uint64_t entries;     // Times the loop was entered from its pre-header.
+    uint64_t iterations;  // Times the header of the loop ran.
+  };
+
+  JitLoopCounters() : lock_("JIT loop counters lock") {}
+
+  // Return the counters of the loop whose header is at `dex_pc` in `method`, transformed by
+  // `passes`. The address stays valid for the lifetime of the JIT.
+  Counters* GetCounters(const std::string& method, uint32_t dex_pc, const std::string& passes)
+      REQUIRES(!lock_);
+
+  // Dump the counters of the loops that ran, by decreasing number of iterations.
+  void Dump(std::ostream& os) REQUIRES(!lock_);
+
+ private:
+  using Key = std::tuple<std::string, uint32_t, std::string>;
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // The nodes of a std::map do not move, their counters can be referenced by the code.
+  std::map<Key, Counters> counters_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(JitLoopCounters);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_JIT_LOOP_COUNTERS_H_
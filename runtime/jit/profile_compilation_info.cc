@@ -38,6 +38,7 @@
 #include "base/stl_util.h"
 #include "base/systrace.h"
 #include "base/unix_file/fd_file.h"
+#include "jit/flat_profile.h"
 #include "jit/profiling_info.h"
 #include "os.h"
 #include "safe_map.h"
@@ -1025,6 +1026,18 @@ ProfileCompilationInfo::ProfileLoadSatus ProfileCompilationInfo::LoadInternal(
   if (stat_buffer.st_size == 0) {
     return kProfileLoadSuccess;
   }
+  // Flat profiles are mapped and copied, their inline caches are not recorded.
+  if (FlatProfile::IsFlatProfile(fd)) {
+    std::unique_ptr<FlatProfile> flat_profile = FlatProfile::Open(fd, error);
+    if (flat_profile == nullptr) {
+      return kProfileLoadBadData;
+    }
+    if (!flat_profile->AddTo(this)) {
+      *error += "Could not add the flat profile data";
+      return kProfileLoadBadData;
+    }
+    return kProfileLoadSuccess;
+  }
   // Read profile header: magic + version + number_of_dex_files.
   uint8_t number_of_dex_files;
   uint32_t uncompressed_data_size;
@@ -35,18 +35,26 @@
 #include "gc/collector_type.h"
 #include "gc/gc_cause.h"
 #include "gc/scoped_gc_critical_section.h"
+#include "jit/hot_method_buffer.h"
 #include "jit/profile_compilation_info.h"
 #include "oat_file_manager.h"
 #include "scoped_thread_state_change-inl.h"
+#include "thread_list.h"
 
 namespace art {
 
 ProfileSaver* ProfileSaver::instance_ = nullptr;
+Atomic<bool> ProfileSaver::record_methods_(false);
+Atomic<uint32_t> ProfileSaver::class_loader_unloads_(0);
 pthread_t ProfileSaver::profiler_pthread_ = 0U;
 
 // At what priority to schedule the saver threads. 9 is the lowest foreground priority on device.
 static constexpr int kProfileSaverPthreadPriority = 9;
 
+// The methods of the threads which exited, and the methods which got hot without going
+// through Jit::AddSamples, are only found by visiting all the classes.
+static constexpr uint32_t kMaxSavesBetweenFullSamplings = 8;
+
 static void SetProfileSaverThreadPriority(pthread_t thread, int priority) {
 #if defined(ART_TARGET_ANDROID)
   int result = setpriority(PRIO_PROCESS, pthread_gettid_np(thread), priority);
@@ -91,6 +99,11 @@ ProfileSaver::ProfileSaver(const ProfileSaverOptions& options,
       max_number_of_profile_entries_cached_(0),
       total_number_of_hot_spikes_(0),
       total_number_of_wake_ups_(0),
+      total_ns_of_cpu_work_(0),
+      total_number_of_recorded_methods_(0),
+      total_number_of_full_samplings_(0),
+      last_class_loader_unloads_(0),
+      saves_since_full_sampling_(0),
       options_(options) {
   DCHECK(options_.IsEnabled());
   AddTrackedLocations(output_filename, code_paths);
@@ -122,7 +135,11 @@ void ProfileSaver::Run() {
     }
     total_ms_of_sleep_ += options_.GetSaveResolvedClassesDelayMs();
   }
+  uint64_t start_cpu_work = ThreadCpuNanoTime();
   FetchAndCacheResolvedClassesAndMethods(/*startup*/ true);
+  total_ns_of_cpu_work_ += ThreadCpuNanoTime() - start_cpu_work;
+  // Startup is over, record the pages it touched for the next launch to prefetch.
+  Runtime::Current()->RecordStartupPageTrace();
 
   // Loop for the profiled methods.
   while (!ShuttingDown(self)) {
@@ -164,6 +181,7 @@ void ProfileSaver::Run() {
 
     uint16_t number_of_new_methods = 0;
     uint64_t start_work = NanoTime();
+    start_cpu_work = ThreadCpuNanoTime();
     bool profile_saved_to_disk = ProcessProfilingInfo(/*force_save*/false, &number_of_new_methods);
     // Update the notification counter based on result. Note that there might be contention on this
     // but we don't care about to be 100% precise.
@@ -174,6 +192,7 @@ void ProfileSaver::Run() {
       jit_activity_notifications_ = number_of_new_methods;
     }
     total_ns_of_work_ += NanoTime() - start_work;
+    total_ns_of_cpu_work_ += ThreadCpuNanoTime() - start_cpu_work;
   }
 }
 
@@ -277,6 +296,40 @@ using MethodReferenceCollection = DexReferenceCollection<uint16_t, ScopedArenaAl
 using TypeReferenceCollection = DexReferenceCollection<dex::TypeIndex,
                                                        ScopedArenaAllocatorAdapter>;
 
+// Add method to hot_methods if it has a ProfilingInfo, was warm or has at least
+// hot_method_sample_threshold samples, to sampled_methods if it has at least one sample.
+static void AddExecutedMethod(ArtMethod* method,
+                              uint32_t hot_method_sample_threshold,
+                              MethodReferenceCollection* hot_methods,
+                              MethodReferenceCollection* sampled_methods)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  const uint16_t counter = method->GetCounter();
+  if (method->GetProfilingInfo(kRuntimePointerSize) != nullptr ||
+      method->PreviouslyWarm() ||
+      counter >= hot_method_sample_threshold) {
+    hot_methods->AddReference(method->GetDexFile(), method->GetDexMethodIndex());
+  } else if (counter != 0) {
+    sampled_methods->AddReference(method->GetDexFile(), method->GetDexMethodIndex());
+  }
+}
+
+// Visit and remove the methods recorded by the threads. Returns false if some threads dropped
+// methods since the last drain.
+template <typename Visitor>
+static bool DrainHotMethodBuffers(Thread* self, const Visitor& visitor)
+    REQUIRES(!Locks::thread_list_lock_) {
+  bool complete = true;
+  // Holding the lock keeps the threads, and their buffers, from being deleted.
+  MutexLock mu(self, *Locks::thread_list_lock_);
+  for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+    jit::HotMethodBuffer* buffer = thread->GetHotMethodBuffer();
+    if (buffer != nullptr && !buffer->Drain(visitor)) {
+      complete = false;
+    }
+  }
+  return complete;
+}
+
 // Iterate over all of the loaded classes and visit each one. For each class, add it to the
 // resolved_classes out argument if startup is true.
 // Add methods to the hot_methods out argument if the number of samples is greater or equal to
@@ -345,16 +398,9 @@ static void SampleClassesAndExecutedMethods(pthread_t profiler_pthread,
       for (ArtMethod& method : klass->GetMethods(kRuntimePointerSize)) {
         if (!method.IsNative()) {
           DCHECK(!method.IsProxyMethod());
-          const uint16_t counter = method.GetCounter();
           // Mark startup methods as hot if they have more than hot_method_sample_threshold
           // samples. This means they will get compiled by the compiler driver.
-          if (method.GetProfilingInfo(kRuntimePointerSize) != nullptr ||
-              (method.GetAccessFlags() & kAccPreviouslyWarm) != 0 ||
-              counter >= hot_method_sample_threshold) {
-            hot_methods->AddReference(method.GetDexFile(), method.GetDexMethodIndex());
-          } else if (counter != 0) {
-            sampled_methods->AddReference(method.GetDexFile(), method.GetDexMethodIndex());
-          }
+          AddExecutedMethod(&method, hot_method_sample_threshold, hot_methods, sampled_methods);
         } else {
           CHECK_EQ(method.GetCounter(), 0u) << method.PrettyMethod()
               << " access_flags=" << method.GetAccessFlags();
@@ -365,38 +411,11 @@ static void SampleClassesAndExecutedMethods(pthread_t profiler_pthread,
   }
 }
 
-void ProfileSaver::FetchAndCacheResolvedClassesAndMethods(bool startup) {
-  ScopedTrace trace(__PRETTY_FUNCTION__);
-  const uint64_t start_time = NanoTime();
-
-  // Resolve any new registered locations.
-  ResolveTrackedLocations();
-
-  Thread* const self = Thread::Current();
-  Runtime* const runtime = Runtime::Current();
-  ArenaStack stack(runtime->GetArenaPool());
-  ScopedArenaAllocator allocator(&stack);
-  MethodReferenceCollection hot_methods(allocator.Adapter(), allocator.Adapter());
-  MethodReferenceCollection sampled_methods(allocator.Adapter(), allocator.Adapter());
-  TypeReferenceCollection resolved_classes(allocator.Adapter(), allocator.Adapter());
-  const bool is_low_ram = Runtime::Current()->GetHeap()->IsLowMemoryMode();
-  pthread_t profiler_pthread;
-  {
-    MutexLock mu(self, *Locks::profiler_lock_);
-    profiler_pthread = profiler_pthread_;
-  }
-  const uint32_t hot_method_sample_threshold = startup ?
-      options_.GetHotStartupMethodSamples(is_low_ram) :
-      std::numeric_limits<uint32_t>::max();
-  SampleClassesAndExecutedMethods(profiler_pthread,
-                                  options_.GetProfileBootClassPath(),
-                                  &allocator,
-                                  hot_method_sample_threshold,
-                                  startup,
-                                  &resolved_classes,
-                                  &hot_methods,
-                                  &sampled_methods);
-  MutexLock mu(self, *Locks::profiler_lock_);
+template <typename MethodCollection, typename TypeCollection>
+void ProfileSaver::CacheMethodsAndClasses(bool startup,
+                                          const MethodCollection& hot_methods,
+                                          const MethodCollection& sampled_methods,
+                                          const TypeCollection& resolved_classes) {
   uint64_t total_number_of_profile_entries_cached = 0;
   using Hotness = ProfileCompilationInfo::MethodHotness;
 
@@ -453,12 +472,110 @@ void ProfileSaver::FetchAndCacheResolvedClassesAndMethods(bool startup) {
   max_number_of_profile_entries_cached_ = std::max(
       max_number_of_profile_entries_cached_,
       total_number_of_profile_entries_cached);
+}
+
+void ProfileSaver::FetchAndCacheResolvedClassesAndMethods(bool startup) {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  const uint64_t start_time = NanoTime();
+
+  // Resolve any new registered locations.
+  ResolveTrackedLocations();
+
+  Thread* const self = Thread::Current();
+  // Everything recorded so far is found by the sampling. The methods are not visited: they
+  // may have been freed with their class loader.
+  last_class_loader_unloads_ = class_loader_unloads_.LoadRelaxed();
+  DrainHotMethodBuffers(self, [](ArtMethod* method ATTRIBUTE_UNUSED) {});
+  saves_since_full_sampling_ = 0;
+  ++total_number_of_full_samplings_;
+
+  Runtime* const runtime = Runtime::Current();
+  ArenaStack stack(runtime->GetArenaPool());
+  ScopedArenaAllocator allocator(&stack);
+  MethodReferenceCollection hot_methods(allocator.Adapter(), allocator.Adapter());
+  MethodReferenceCollection sampled_methods(allocator.Adapter(), allocator.Adapter());
+  TypeReferenceCollection resolved_classes(allocator.Adapter(), allocator.Adapter());
+  const bool is_low_ram = Runtime::Current()->GetHeap()->IsLowMemoryMode();
+  pthread_t profiler_pthread;
+  {
+    MutexLock mu(self, *Locks::profiler_lock_);
+    profiler_pthread = profiler_pthread_;
+  }
+  const uint32_t hot_method_sample_threshold = startup ?
+      options_.GetHotStartupMethodSamples(is_low_ram) :
+      std::numeric_limits<uint32_t>::max();
+  SampleClassesAndExecutedMethods(profiler_pthread,
+                                  options_.GetProfileBootClassPath(),
+                                  &allocator,
+                                  hot_method_sample_threshold,
+                                  startup,
+                                  &resolved_classes,
+                                  &hot_methods,
+                                  &sampled_methods);
+  MutexLock mu(self, *Locks::profiler_lock_);
+  CacheMethodsAndClasses(startup, hot_methods, sampled_methods, resolved_classes);
   VLOG(profiler) << "Profile saver recorded " << hot_methods.NumReferences() << " hot methods and "
                  << sampled_methods.NumReferences() << " sampled methods with threshold "
                  << hot_method_sample_threshold << " in "
                  << PrettyDuration(NanoTime() - start_time);
 }
 
+void ProfileSaver::FetchAndCacheRecordedMethods() {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  if (saves_since_full_sampling_ >= kMaxSavesBetweenFullSamplings) {
+    FetchAndCacheResolvedClassesAndMethods(/*startup*/ false);
+    return;
+  }
+  const uint64_t start_time = NanoTime();
+
+  // Resolve any new registered locations.
+  ResolveTrackedLocations();
+
+  Thread* const self = Thread::Current();
+  ArenaStack stack(Runtime::Current()->GetArenaPool());
+  ScopedArenaAllocator allocator(&stack);
+  MethodReferenceCollection hot_methods(allocator.Adapter(), allocator.Adapter());
+  MethodReferenceCollection sampled_methods(allocator.Adapter(), allocator.Adapter());
+  TypeReferenceCollection resolved_classes(allocator.Adapter(), allocator.Adapter());
+  bool complete = false;
+  {
+    ScopedObjectAccess soa(self);
+    // Class loaders are only unloaded by the GC: the methods cannot be freed while we visit them.
+    gc::ScopedGCCriticalSection sgcs(self,
+                                     gc::kGcCauseProfileSaver,
+                                     gc::kCollectorTypeCriticalSection);
+    if (class_loader_unloads_.LoadRelaxed() == last_class_loader_unloads_) {
+      const bool profile_boot_class_path = options_.GetProfileBootClassPath();
+      auto visitor = [&](ArtMethod* method) NO_THREAD_SAFETY_ANALYSIS {
+        // The methods GetClassesVisitor would have skipped.
+        ObjPtr<mirror::Class> klass = method->GetDeclaringClass();
+        if (!method->IsProxyMethod() &&
+            !klass->IsErroneousResolved() &&
+            (profile_boot_class_path || !klass->IsBootStrapClassLoaded())) {
+          AddExecutedMethod(method,
+                            std::numeric_limits<uint32_t>::max(),
+                            &hot_methods,
+                            &sampled_methods);
+        }
+      };
+      complete = DrainHotMethodBuffers(self, visitor);
+    }
+  }
+  if (!complete) {
+    // Some methods were dropped or may have been freed.
+    FetchAndCacheResolvedClassesAndMethods(/*startup*/ false);
+    return;
+  }
+  ++saves_since_full_sampling_;
+  total_number_of_recorded_methods_ +=
+      hot_methods.NumReferences() + sampled_methods.NumReferences();
+  MutexLock mu(self, *Locks::profiler_lock_);
+  CacheMethodsAndClasses(/*startup*/ false, hot_methods, sampled_methods, resolved_classes);
+  VLOG(profiler) << "Profile saver recorded " << hot_methods.NumReferences() << " hot methods and "
+                 << sampled_methods.NumReferences() << " sampled methods from the threads in "
+                 << PrettyDuration(NanoTime() - start_time);
+}
+
 bool ProfileSaver::ProcessProfilingInfo(bool force_save, /*out*/uint16_t* number_of_new_methods) {
   ScopedTrace trace(__PRETTY_FUNCTION__);
 
@@ -478,8 +595,7 @@ bool ProfileSaver::ProcessProfilingInfo(bool force_save, /*out*/uint16_t* number
   }
 
   // We only need to do this once, not once per dex location.
-  // TODO: Figure out a way to only do it when stuff has changed? It takes 30-50ms.
-  FetchAndCacheResolvedClassesAndMethods(/*startup*/ false);
+  FetchAndCacheRecordedMethods();
 
   for (const auto& it : tracked_locations) {
     if (!force_save && ShuttingDown(Thread::Current())) {
@@ -671,6 +787,7 @@ void ProfileSaver::Start(const ProfileSaverOptions& options,
                                output_filename,
                                jit_code_cache,
                                code_paths_to_profile);
+  record_methods_.StoreRelaxed(true);
 
   // Create a new thread which does the saving.
   CHECK_PTHREAD_CALL(
@@ -700,6 +817,7 @@ void ProfileSaver::Stop(bool dump_info) {
     }
     instance_->shutting_down_ = true;
   }
+  record_methods_.StoreRelaxed(false);
 
   {
     // Wake up the saver thread if it is sleeping to allow for a clean exit.
@@ -779,6 +897,10 @@ void ProfileSaver::DumpInfo(std::ostream& os) {
      << "ProfileSaver total_number_of_failed_writes=" << total_number_of_failed_writes_ << '\n'
      << "ProfileSaver total_ms_of_sleep=" << total_ms_of_sleep_ << '\n'
      << "ProfileSaver total_ms_of_work=" << NsToMs(total_ns_of_work_) << '\n'
+     << "ProfileSaver total_ms_of_cpu_work=" << NsToMs(total_ns_of_cpu_work_) << '\n'
+     << "ProfileSaver total_number_of_recorded_methods="
+     << total_number_of_recorded_methods_ << '\n'
+     << "ProfileSaver total_number_of_full_samplings=" << total_number_of_full_samplings_ << '\n'
      << "ProfileSaver max_number_profile_entries_cached="
      << max_number_of_profile_entries_cached_ << '\n'
      << "ProfileSaver total_number_of_hot_spikes=" << total_number_of_hot_spikes_ << '\n'
@@ -786,6 +908,16 @@ void ProfileSaver::DumpInfo(std::ostream& os) {
 }
 
 
+void ProfileSaver::NotifyMethodSampled(Thread* self, ArtMethod* method) {
+  if (record_methods_.LoadRelaxed()) {
+    self->GetOrCreateHotMethodBuffer()->Push(method);
+  }
+}
+
+void ProfileSaver::NotifyClassLoadersUnloaded() {
+  class_loader_unloads_.FetchAndAddSequentiallyConsistent(1);
+}
+
 void ProfileSaver::ForceProcessProfiles() {
   ProfileSaver* saver = nullptr;
   {
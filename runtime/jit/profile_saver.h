@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_JIT_PROFILE_SAVER_H_
 #define ART_RUNTIME_JIT_PROFILE_SAVER_H_
 
+#include "atomic.h"
 #include "base/mutex.h"
 #include "jit_code_cache.h"
 #include "method_reference.h"
@@ -56,6 +57,14 @@ class ProfileSaver {
   // For testing or manual purposes (SIGUSR1).
   static void ForceProcessProfiles();
 
+  // Records that method got its first samples or its ProfilingInfo, so that the next save
+  // does not need to visit all the classes to find it. Called by the thread sampling method.
+  static void NotifyMethodSampled(Thread* self, ArtMethod* method)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Called when class loaders are unloaded: the methods recorded so far may be freed.
+  static void NotifyClassLoadersUnloaded();
+
   // Just for testing purposes.
   static bool HasSeenMethod(const std::string& profile, bool hot, MethodReference ref);
 
@@ -98,6 +107,19 @@ class ProfileSaver {
   // profile_cache_ for later save.
   void FetchAndCacheResolvedClassesAndMethods(bool startup);
 
+  // Caches the methods recorded by the threads since the last save. Falls back to
+  // FetchAndCacheResolvedClassesAndMethods when some of them may be lost or freed, and
+  // every kMaxSavesBetweenFullSamplings saves.
+  void FetchAndCacheRecordedMethods();
+
+  // Adds the methods and classes to the profile_cache_ of their tracked locations.
+  template <typename MethodCollection, typename TypeCollection>
+  void CacheMethodsAndClasses(bool startup,
+                              const MethodCollection& hot_methods,
+                              const MethodCollection& sampled_methods,
+                              const TypeCollection& resolved_classes)
+      REQUIRES(Locks::profiler_lock_);
+
   void DumpInfo(std::ostream& os);
 
   // Resolve the realpath of the locations stored in tracked_dex_base_locations_to_be_resolved_
@@ -108,6 +130,10 @@ class ProfileSaver {
   static ProfileSaver* instance_ GUARDED_BY(Locks::profiler_lock_);
   // Profile saver thread.
   static pthread_t profiler_pthread_ GUARDED_BY(Locks::profiler_lock_);
+  // Whether the threads record their sampled methods, while the saver is started.
+  static Atomic<bool> record_methods_;
+  // The number of times class loaders were unloaded.
+  static Atomic<uint32_t> class_loader_unloads_;
 
   jit::JitCodeCache* jit_code_cache_;
 
@@ -148,6 +174,13 @@ class ProfileSaver {
   uint64_t max_number_of_profile_entries_cached_;
   uint64_t total_number_of_hot_spikes_;
   uint64_t total_number_of_wake_ups_;
+  uint64_t total_ns_of_cpu_work_;
+  uint64_t total_number_of_recorded_methods_;
+  uint64_t total_number_of_full_samplings_;
+
+  // The value of class_loader_unloads_ when the recorded methods were last discarded.
+  uint32_t last_class_loader_unloads_;
+  uint32_t saves_since_full_sampling_;
 
   const ProfileSaverOptions options_;
   DISALLOW_COPY_AND_ASSIGN(ProfileSaver);
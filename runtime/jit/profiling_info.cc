@@ -30,6 +30,7 @@ ProfilingInfo::ProfilingInfo(ArtMethod* method, const std::vector<uint32_t>& ent
         method_(method),
         is_method_being_compiled_(false),
         is_osr_method_being_compiled_(false),
+        has_baseline_code_(false),
         current_inline_uses_(0),
         saved_entry_point_(nullptr) {
   memset(&cache_, 0, number_of_inline_caches_ * sizeof(InlineCache));
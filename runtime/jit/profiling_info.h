@@ -91,6 +91,14 @@ class ProfilingInfo {
     }
   }
 
+  bool HasBaselineCode() const {
+    return has_baseline_code_;
+  }
+
+  void SetHasBaselineCode(bool value) {
+    has_baseline_code_ = value;
+  }
+
   void SetSavedEntryPoint(const void* entry_point) {
     saved_entry_point_ = entry_point;
   }
@@ -146,6 +154,10 @@ class ProfilingInfo {
   bool is_method_being_compiled_;
   bool is_osr_method_being_compiled_;
 
+  // Whether the compiled code of the ArtMethod is baseline code, which an optimized compilation
+  // replaces. Also implicitly guarded by the JIT code cache lock.
+  bool has_baseline_code_;
+
   // When the compiler inlines the method associated to this ProfilingInfo,
   // it updates this counter so that the GC does not try to clear the inline caches.
   uint16_t current_inline_uses_;
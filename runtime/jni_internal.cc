@@ -2146,15 +2146,19 @@ static jsize GetArrayLength(JNIEnv* env, jarray java_array)
     gc::Heap* heap = Runtime::Current()->GetHeap();
     if (heap->IsMovableObject(array)) {
       if (heap->CurrentCollectorType() != gc::kCollectorTypeGenCopying) {
-        if (!kUseReadBarrier) {
-          heap->IncrementDisableMovingGC(soa.Self());
-        } else {
-          // For the CC collector, we only need to wait for the thread flip rather than the whole GC
-          // to occur thanks to the to-space invariant.
-          heap->IncrementDisableThreadFlip(soa.Self());
+        // For the CC collector, pinning the region of the array keeps it in place without
+        // holding back the thread flip of the other threads.
+        if (!heap->PinObjectRegion(array)) {
+          if (!kUseReadBarrier) {
+            heap->IncrementDisableMovingGC(soa.Self());
+          } else {
+            // For the CC collector, we only need to wait for the thread flip rather than the
+            // whole GC to occur thanks to the to-space invariant.
+            heap->IncrementDisableThreadFlip(soa.Self());
+          }
+          // Re-decode in case the object moved since IncrementDisableGC waits for GC to complete.
+          array = soa.Decode<mirror::Array>(java_array);
         }
-        // Re-decode in case the object moved since IncrementDisableGC waits for GC to complete.
-        array = soa.Decode<mirror::Array>(java_array);
       } else {
         if (is_copy != nullptr) {
           *is_copy = JNI_TRUE;
@@ -2654,8 +2658,9 @@ static jsize GetArrayLength(JNIEnv* env, jarray java_array)
     if (UNLIKELY(array == nullptr)) {
       return nullptr;
     }
-    // Only make a copy if necessary.
-    if (Runtime::Current()->GetHeap()->IsMovableObject(array)) {
+    // Only make a copy if necessary, the region of the array is pinned instead when it can be.
+    gc::Heap* heap = Runtime::Current()->GetHeap();
+    if (heap->IsMovableObject(array) && !heap->PinObjectRegion(array)) {
       if (is_copy != nullptr) {
         *is_copy = JNI_TRUE;
       }
@@ -2714,11 +2719,14 @@ static jsize GetArrayLength(JNIEnv* env, jarray java_array)
       if (is_copy) {
         delete[] reinterpret_cast<uint64_t*>(elements);
       } else if (heap->IsMovableObject(array)) {
-        // Non copy to a movable object must means that we had disabled the moving GC.
-        if (!kUseReadBarrier) {
-          heap->DecrementDisableMovingGC(soa.Self());
-        } else {
-          heap->DecrementDisableThreadFlip(soa.Self());
+        // Non copy to a movable object must means that we had pinned its region or disabled the
+        // moving GC.
+        if (!heap->UnpinObjectRegion(array)) {
+          if (!kUseReadBarrier) {
+            heap->DecrementDisableMovingGC(soa.Self());
+          } else {
+            heap->DecrementDisableThreadFlip(soa.Self());
+          }
         }
       }
     }
@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_LEB128_H_
 #define ART_RUNTIME_LEB128_H_
 
+#include <string.h>
+
 #include <vector>
 
 #include "base/bit_utils.h"
@@ -53,10 +55,50 @@ static inline uint32_t DecodeUnsignedLeb128(const uint8_t** data) {
   return static_cast<uint32_t>(result);
 }
 
+// The number of bytes read at once by the word decoders below, from the start of the value.
+static constexpr size_t kLeb128WordSize = sizeof(uint64_t);
+
+// Returns the bytes of the LEB128 value at ptr, read as a little-endian word, with the bytes
+// after the value cleared, and the length of the value in length.
+static inline uint64_t ReadLeb128Word(const uint8_t* ptr, uint32_t* length) {
+  uint64_t word;
+  memcpy(&word, ptr, sizeof(word));
+  // The value ends at the first byte without the continuation bit, or at the fifth byte.
+  const uint64_t end_bits = (~word & UINT64_C(0x80808080)) | UINT64_C(0x8000000000);
+  *length = static_cast<uint32_t>((CTZ(end_bits) + 1) / kBitsPerByte);
+  // Keep the bits up to the end bit.
+  return word & (end_bits ^ (end_bits - 1u));
+}
+
+// Packs the 7-bit groups of the bytes of an LEB128 value, dropping the continuation bits and
+// the four high-order bits of the fifth byte.
+static inline uint32_t PackLeb128Word(uint64_t bytes) {
+  return static_cast<uint32_t>((bytes & UINT64_C(0x7f)) |
+                               ((bytes >> 1) & (UINT64_C(0x7f) << 7)) |
+                               ((bytes >> 2) & (UINT64_C(0x7f) << 14)) |
+                               ((bytes >> 3) & (UINT64_C(0x7f) << 21)) |
+                               ((bytes >> 4) & (UINT64_C(0xf) << 28)));
+}
+
+// Reads an unsigned LEB128 value like DecodeUnsignedLeb128, but a whole word at a time and
+// without branching on the length of the value. There must be at least kLeb128WordSize bytes
+// readable at *data, e.g. when the value is not at the end of its buffer.
+static inline uint32_t DecodeUnsignedLeb128Word(const uint8_t** data) {
+  uint32_t length;
+  const uint32_t result = PackLeb128Word(ReadLeb128Word(*data, &length));
+  *data += length;
+  return result;
+}
+
 static inline bool DecodeUnsignedLeb128Checked(const uint8_t** data,
                                                const void* end,
                                                uint32_t* out) {
   const uint8_t* ptr = *data;
+  const uint8_t* limit = reinterpret_cast<const uint8_t*>(end);
+  if (LIKELY(limit - ptr >= static_cast<ptrdiff_t>(kLeb128WordSize))) {
+    *out = DecodeUnsignedLeb128Word(data);
+    return true;
+  }
   if (ptr >= end) {
     return false;
   }
@@ -140,10 +182,26 @@ static inline int32_t DecodeSignedLeb128(const uint8_t** data) {
   return result;
 }
 
+// Reads a signed LEB128 value like DecodeSignedLeb128, with the requirements of
+// DecodeUnsignedLeb128Word.
+static inline int32_t DecodeSignedLeb128Word(const uint8_t** data) {
+  uint32_t length;
+  const uint32_t value = PackLeb128Word(ReadLeb128Word(*data, &length));
+  *data += length;
+  // Sign extend from the last of the 7 * length bits read, a fifth byte fills the 32 bits.
+  const uint32_t shift = (length < 5u) ? 32u - 7u * length : 0u;
+  return static_cast<int32_t>(value << shift) >> shift;
+}
+
 static inline bool DecodeSignedLeb128Checked(const uint8_t** data,
                                              const void* end,
                                              int32_t* out) {
   const uint8_t* ptr = *data;
+  const uint8_t* limit = reinterpret_cast<const uint8_t*>(end);
+  if (LIKELY(limit - ptr >= static_cast<ptrdiff_t>(kLeb128WordSize))) {
+    *out = DecodeSignedLeb128Word(data);
+    return true;
+  }
   if (ptr >= end) {
     return false;
   }
@@ -191,6 +249,22 @@ static inline bool DecodeSignedLeb128Checked(const uint8_t** data,
   return true;
 }
 
+// Reads an unsigned LEB128 value like DecodeUnsignedLeb128, a word at a time unless within
+// kLeb128WordSize bytes of end, the end of the readable data, e.g. of the dex file.
+static inline uint32_t DecodeUnsignedLeb128Fast(const uint8_t** data, const uint8_t* end) {
+  return LIKELY(end - *data >= static_cast<ptrdiff_t>(kLeb128WordSize))
+      ? DecodeUnsignedLeb128Word(data)
+      : DecodeUnsignedLeb128(data);
+}
+
+// Reads a signed LEB128 value like DecodeSignedLeb128, with the fast path of
+// DecodeUnsignedLeb128Fast.
+static inline int32_t DecodeSignedLeb128Fast(const uint8_t** data, const uint8_t* end) {
+  return LIKELY(end - *data >= static_cast<ptrdiff_t>(kLeb128WordSize))
+      ? DecodeSignedLeb128Word(data)
+      : DecodeSignedLeb128(data);
+}
+
 // Returns the number of bytes needed to encode the value in unsigned LEB128.
 static inline uint32_t UnsignedLeb128Size(uint32_t data) {
   // bits_to_encode = (data != 0) ? 32 - CLZ(x) : 1  // 32 - CLZ(data | 1)
@@ -253,6 +253,53 @@ TEST(Leb128Test, SignedStream) {
   EXPECT_EQ(data_size, static_cast<size_t>(encoded_data_ptr - encoded_data));
 }
 
+TEST(Leb128Test, UnsignedWordSingles) {
+  for (size_t i = 0; i < arraysize(uleb128_tests); ++i) {
+    // The bytes after the value must not change it.
+    uint8_t encoded_data[kLeb128WordSize];
+    memset(encoded_data, 0xff, sizeof(encoded_data));
+    uint8_t* end = EncodeUnsignedLeb128(encoded_data, uleb128_tests[i].decoded);
+    const uint8_t* data_ptr = encoded_data;
+    EXPECT_EQ(DecodeUnsignedLeb128Word(&data_ptr), uleb128_tests[i].decoded) << " i = " << i;
+    EXPECT_EQ(end, data_ptr) << " i = " << i;
+  }
+}
+
+TEST(Leb128Test, SignedWordSingles) {
+  for (size_t i = 0; i < arraysize(sleb128_tests); ++i) {
+    uint8_t encoded_data[kLeb128WordSize];
+    memset(encoded_data, 0xff, sizeof(encoded_data));
+    uint8_t* end = EncodeSignedLeb128(encoded_data, sleb128_tests[i].decoded);
+    const uint8_t* data_ptr = encoded_data;
+    EXPECT_EQ(DecodeSignedLeb128Word(&data_ptr), sleb128_tests[i].decoded) << " i = " << i;
+    EXPECT_EQ(end, data_ptr) << " i = " << i;
+  }
+}
+
+TEST(Leb128Test, CheckedNearEnd) {
+  // The values near the end of the data are decoded byte by byte, and fail past the end.
+  for (size_t i = 0; i < arraysize(uleb128_tests); ++i) {
+    uint8_t encoded_data[kLeb128WordSize];
+    uint8_t* end = EncodeUnsignedLeb128(encoded_data, uleb128_tests[i].decoded);
+    const uint8_t* data_ptr = encoded_data;
+    uint32_t value;
+    EXPECT_FALSE(DecodeUnsignedLeb128Checked(&data_ptr, end - 1, &value)) << " i = " << i;
+    EXPECT_TRUE(DecodeUnsignedLeb128Checked(&data_ptr, end, &value)) << " i = " << i;
+    EXPECT_EQ(uleb128_tests[i].decoded, value) << " i = " << i;
+    EXPECT_EQ(end, data_ptr) << " i = " << i;
+  }
+  for (size_t i = 0; i < arraysize(sleb128_tests); ++i) {
+    uint8_t encoded_data[kLeb128WordSize];
+    uint8_t* end = EncodeSignedLeb128(encoded_data, sleb128_tests[i].decoded);
+    const uint8_t* data_ptr = encoded_data;
+    int32_t value;
+    EXPECT_FALSE(DecodeSignedLeb128Checked(&data_ptr, end - 1, &value)) << " i = " << i;
+    EXPECT_TRUE(DecodeSignedLeb128Checked(&data_ptr, end, &value)) << " i = " << i;
+    EXPECT_EQ(sleb128_tests[i].decoded, value) << " i = " << i;
+    EXPECT_EQ(end, data_ptr) << " i = " << i;
+  }
+}
+
 TEST(Leb128Test, UnsignedUpdate) {
   for (size_t i = 0; i < arraysize(uleb128_tests); ++i) {
     for (size_t j = 0; j < arraysize(uleb128_tests); ++j) {
@@ -307,4 +354,45 @@ TEST(Leb128Test, Speed) {
   dec_hist->PrintConfidenceIntervals(std::cout, 0.99, dec_data);
 }
 
+TEST(Leb128Test, WordDecodeSpeed) {
+  std::unique_ptr<Histogram<uint64_t>> byte_hist(
+      new Histogram<uint64_t>("Leb128ByteDecodeSpeedTest", 5));
+  std::unique_ptr<Histogram<uint64_t>> word_hist(
+      new Histogram<uint64_t>("Leb128WordDecodeSpeedTest", 5));
+  // Mostly the one and two byte values of the dex files, with some longer ones.
+  Leb128EncodingVector<> builder;
+  for (size_t i = 0; i < 1024; i++) {
+    for (size_t j = 0; j < 1024; j++) {
+      builder.PushBackUnsigned(((j & 15) == 0) ? (i * 1024) + j : j);
+    }
+  }
+  const uint8_t* end = &builder.GetData()[0] + builder.GetData().size();
+  const uint8_t* byte_ptr = &builder.GetData()[0];
+  const uint8_t* word_ptr = &builder.GetData()[0];
+  for (size_t i = 0; i < 1024; i++) {
+    uint32_t byte_sum = 0;
+    uint64_t start_time = NanoTime();
+    for (size_t j = 0; j < 1024; j++) {
+      byte_sum += DecodeUnsignedLeb128(&byte_ptr);
+    }
+    byte_hist->AddValue(NanoTime() - start_time);
+    uint32_t word_sum = 0;
+    start_time = NanoTime();
+    for (size_t j = 0; j < 1024; j++) {
+      word_sum += DecodeUnsignedLeb128Fast(&word_ptr, end);
+    }
+    word_hist->AddValue(NanoTime() - start_time);
+    EXPECT_EQ(byte_sum, word_sum) << " i = " << i;
+  }
+  EXPECT_EQ(byte_ptr, word_ptr);
+
+  Histogram<uint64_t>::CumulativeData byte_data;
+  byte_hist->CreateHistogram(&byte_data);
+  byte_hist->PrintConfidenceIntervals(std::cout, 0.99, byte_data);
+
+  Histogram<uint64_t>::CumulativeData word_data;
+  word_hist->CreateHistogram(&word_data);
+  word_hist->PrintConfidenceIntervals(std::cout, 0.99, word_data);
+}
+
 }  // namespace art
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "line_table.h"
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#include "art_method-inl.h"
+#include "class_linker.h"
+#include "class_table.h"
+#include "dex_file.h"
+#include "linear_alloc.h"
+#include "mirror/class-inl.h"
+#include "runtime.h"
+#include "thread-current-inl.h"
+
+namespace art {
+
+static bool CollectEntries(void* raw_context, const DexFile::PositionInfo& entry) {
+  std::vector<LineTable::Entry>* entries =
+      reinterpret_cast<std::vector<LineTable::Entry>*>(raw_context);
+  entries->push_back({entry.address_, entry.line_});
+  return false;  // Collect all, no early exit.
+}
+
+const LineTable* LineTable::ForMethod(ArtMethod* method) {
+  DCHECK(!method->IsProxyMethod());
+  const DexFile::CodeItem* code_item = method->GetCodeItem();
+  if (code_item == nullptr) {
+    return nullptr;
+  }
+  const DexFile* dex_file = method->GetDexFile();
+  if (dex_file->GetDebugInfoStream(code_item) == nullptr) {
+    return nullptr;
+  }
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  ObjPtr<mirror::ClassLoader> class_loader = method->GetDeclaringClass()->GetClassLoader();
+  ClassTable* class_table = class_linker->ClassTableForClassLoader(class_loader);
+  if (class_table == nullptr) {
+    return nullptr;
+  }
+  const LineTable* line_table = class_table->LookupLineTable(code_item);
+  if (line_table != nullptr) {
+    return line_table;
+  }
+
+  std::vector<Entry> entries;
+  dex_file->DecodeDebugPositionInfo(code_item, CollectEntries, &entries);
+  LinearAlloc* linear_alloc = class_linker->GetAllocatorForClassLoader(class_loader);
+  void* memory =
+      linear_alloc->Alloc(Thread::Current(), sizeof(LineTable) + entries.size() * sizeof(Entry));
+  LineTable* new_table = new (memory) LineTable(entries.size());
+  std::copy(entries.begin(), entries.end(), new_table->entries_);
+  // Another thread may have built the table meanwhile, its memory is then wasted until unloading.
+  return class_table->InsertLineTable(code_item, new_table);
+}
+
+int32_t LineTable::GetLineNumber(uint32_t dex_pc) const {
+  const Entry* begin = entries_;
+  const Entry* end = entries_ + size_;
+  const Entry* it = std::lower_bound(
+      begin, end, dex_pc, [](const Entry& entry, uint32_t pc) { return entry.dex_pc < pc; });
+  if (it != end && it->dex_pc == dex_pc) {
+    // The first position at dex_pc.
+    return static_cast<int32_t>(it->line);
+  }
+  return (it == begin) ? -1 : static_cast<int32_t>((it - 1)->line);
+}
+
+}  // namespace art
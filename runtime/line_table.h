@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ART_RUNTIME_LINE_TABLE_H_
+#define ART_RUNTIME_LINE_TABLE_H_
+
+#include <stdint.h>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+
+class ArtMethod;
+
+// The positions of the debug info of a method, sorted by dex pc. Stack traces look up the line
+// of each of their frames, which decoding the debug info stream would do from its start. Built
+// the first time they are needed, and shared by the methods of the same code, in the LinearAlloc
+// of the class loader, which frees them when it is unloaded.
+class LineTable {
+ public:
+  struct Entry {
+    uint32_t dex_pc;
+    uint32_t line;
+  };
+
+  // Returns the line table of method, building it if needed. Returns null if the method has no
+  // debug info.
+  static const LineTable* ForMethod(ArtMethod* method) REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Returns the line at dex_pc, or that of the last position before it, -1 if there is none. The
+  // same as DexFile::LineNumForPcCb.
+  int32_t GetLineNumber(uint32_t dex_pc) const;
+
+  size_t Size() const {
+    return size_;
+  }
+
+  const Entry& GetEntry(size_t index) const {
+    DCHECK_LT(index, size_);
+    return entries_[index];
+  }
+
+ private:
+  explicit LineTable(uint32_t size) : size_(size) {}
+
+  const uint32_t size_;
+  Entry entries_[0];
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(LineTable);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_LINE_TABLE_H_
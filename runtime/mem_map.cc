@@ -17,12 +17,14 @@
 #include "mem_map.h"
 
 #include <inttypes.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <sys/mman.h>  // For the PROT_* and MAP_* constants.
 #ifndef ANDROID_OS
 #include <sys/resource.h>
 #endif
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <sstream>
@@ -32,6 +34,7 @@
 #include "backtrace/BacktraceMap.h"
 #include "cutils/ashmem.h"
 
+#include "atomic.h"
 #include "base/allocator.h"
 #include "base/bit_utils.h"
 #include "base/memory_tool.h"
@@ -519,7 +522,7 @@ MemMap::~MemMap() {
 MemMap::MemMap(const std::string& name, uint8_t* begin, size_t size, void* base_begin,
                size_t base_size, int prot, bool reuse, size_t redzone_size)
     : name_(name), begin_(begin), size_(size), base_begin_(base_begin), base_size_(base_size),
-      prot_(prot), reuse_(reuse), redzone_size_(redzone_size) {
+      prot_(prot), reuse_(reuse), redzone_size_(redzone_size), huge_page_advised_size_(0) {
   if (size_ == 0) {
     CHECK(begin_ == nullptr);
     CHECK(base_begin_ == nullptr);
@@ -604,7 +607,60 @@ MemMap* MemMap::RemapAtEnd(uint8_t* new_end, const char* tail_name, int tail_pro
                               fd.get());
     return nullptr;
   }
-  return new MemMap(tail_name, actual, tail_size, actual, tail_base_size, tail_prot, false);
+  MemMap* tail = new MemMap(tail_name, actual, tail_size, actual, tail_base_size, tail_prot, false);
+  if (UsesHugePages()) {
+    // The tail is a new mapping, which is not advised. Keep all of the old range advised.
+    huge_page_advised_size_ = 0;
+    MadviseHugePages();
+    tail->MadviseHugePages();
+  }
+  return tail;
+}
+
+bool MemMap::MadviseHugePages() {
+#ifdef MADV_HUGEPAGE
+  uint8_t* begin = AlignUp(reinterpret_cast<uint8_t*>(BaseBegin()), kHugePageSize);
+  uint8_t* end = AlignDown(reinterpret_cast<uint8_t*>(BaseEnd()), kHugePageSize);
+  if (begin >= end) {
+    return false;
+  }
+  if (madvise(begin, end - begin, MADV_HUGEPAGE) != 0) {
+    PLOG(WARNING) << "madvise(MADV_HUGEPAGE) failed for " << name_;
+    return false;
+  }
+  huge_page_advised_size_ = end - begin;
+  return true;
+#else
+  return false;
+#endif
+}
+
+size_t MemMap::GetHugePageBackedSize() const {
+  if (!UsesHugePages()) {
+    return 0;
+  }
+  std::string smaps;
+  if (!ReadFileToString("/proc/self/smaps", &smaps)) {
+    return 0;
+  }
+  // The kernel may have split the map into several entries, such as by mprotect().
+  const uintptr_t map_begin = reinterpret_cast<uintptr_t>(BaseBegin());
+  const uintptr_t map_end = reinterpret_cast<uintptr_t>(BaseEnd());
+  size_t backed_size = 0;
+  bool in_map = false;
+  std::istringstream stream(smaps);
+  std::string line;
+  while (std::getline(stream, line)) {
+    uintptr_t entry_begin;
+    uintptr_t entry_end;
+    size_t huge_kb;
+    if (sscanf(line.c_str(), "%" SCNxPTR "-%" SCNxPTR " ", &entry_begin, &entry_end) == 2) {
+      in_map = entry_begin < map_end && map_begin < entry_end;
+    } else if (in_map && sscanf(line.c_str(), "AnonHugePages: %zu kB", &huge_kb) == 1) {
+      backed_size += huge_kb * KB;
+    }
+  }
+  return backed_size;
 }
 
 void MemMap::MadviseDontNeedAndZero() {
@@ -995,14 +1051,15 @@ void MemMap::TryReadable() {
   }
 }
 
-void ZeroAndReleasePages(void* address, size_t length) {
+void ZeroAndReleasePages(void* address, size_t length, size_t release_alignment) {
+  DCHECK_ALIGNED_PARAM(release_alignment, kPageSize);
   if (length == 0) {
     return;
   }
   uint8_t* const mem_begin = reinterpret_cast<uint8_t*>(address);
   uint8_t* const mem_end = mem_begin + length;
-  uint8_t* const page_begin = AlignUp(mem_begin, kPageSize);
-  uint8_t* const page_end = AlignDown(mem_end, kPageSize);
+  uint8_t* const page_begin = AlignUp(mem_begin, release_alignment);
+  uint8_t* const page_end = AlignDown(mem_end, release_alignment);
   if (!kMadviseZeroes || page_begin >= page_end) {
     // No possible area to madvise.
     std::fill(mem_begin, mem_end, 0);
@@ -1017,6 +1074,26 @@ void ZeroAndReleasePages(void* address, size_t length) {
   }
 }
 
+void ReleaseZeroedPages(void* address, size_t length) {
+  DCHECK_ALIGNED(address, kPageSize);
+  DCHECK_ALIGNED(length, kPageSize);
+  if (length == 0) {
+    return;
+  }
+#if defined(__linux__) && defined(MADV_FREE)
+  // Kernels before 4.5 fail with EINVAL, stop trying MADV_FREE then.
+  static Atomic<bool> madv_free_supported(true);
+  if (madv_free_supported.LoadRelaxed()) {
+    if (madvise(address, length, MADV_FREE) == 0) {
+      return;
+    }
+    CHECK_EQ(errno, EINVAL) << "madvise MADV_FREE failed: " << strerror(errno);
+    madv_free_supported.StoreRelaxed(false);
+  }
+#endif
+  CHECK_NE(madvise(address, length, MADV_DONTNEED), -1) << "madvise failed";
+}
+
 void MemMap::AlignBy(size_t size) {
   CHECK_EQ(begin_, base_begin_) << "Unsupported";
   CHECK_EQ(size_, base_size_) << "Unsupported";
@@ -1065,4 +1142,121 @@ void MemMap::AlignBy(size_t size) {
   }
 }
 
+MemMap* MemMap::MapAnonymousAligned(const char* name,
+                                    size_t byte_count,
+                                    int prot,
+                                    bool low_4gb,
+                                    size_t alignment,
+                                    std::string* error_msg) {
+  const size_t aligned_byte_count = RoundUp(byte_count, alignment);
+  // Ask for an additional alignment so that the map can be aligned wherever it is.
+  std::unique_ptr<MemMap> map(MapAnonymous(name,
+                                           nullptr,
+                                           aligned_byte_count + alignment,
+                                           prot,
+                                           low_4gb,
+                                           /* reuse */ false,
+                                           error_msg));
+  if (map == nullptr) {
+    return nullptr;
+  }
+  if (IsAlignedParam(map->Begin(), alignment)) {
+    map->SetSize(aligned_byte_count);
+  } else {
+    map->AlignBy(alignment);
+  }
+  CHECK_ALIGNED_PARAM(map->Begin(), alignment);
+  CHECK_EQ(map->Size(), aligned_byte_count);
+  return map.release();
+}
+
+MemMapReservations::MemMapReservations(const char* name, size_t reservation_size, bool low_4gb)
+    : name_(name),
+      reservation_size_(RoundUp(reservation_size, kPageSize)),
+      low_4gb_(low_4gb),
+      reserved_size_(0u) {
+}
+
+uint8_t* MemMapReservations::Allocate(size_t byte_count, std::string* error_msg) {
+  DCHECK_NE(byte_count, 0u);
+  const size_t size = RoundUp(byte_count, kPageSize);
+  auto it = free_ranges_by_size_.lower_bound(size);
+  if (it == free_ranges_by_size_.end()) {
+    const size_t map_size = std::max(size, reservation_size_);
+    MemMap* map = MemMap::MapAnonymous(name_.c_str(),
+                                       nullptr,
+                                       map_size,
+                                       PROT_READ | PROT_WRITE,
+                                       low_4gb_,
+                                       /* reuse */ false,
+                                       error_msg);
+    if (map == nullptr) {
+      return nullptr;
+    }
+    maps_.emplace_back(map);
+    reserved_size_ += map->BaseSize();
+    AddFreeRange(map->Begin(), map->BaseSize());
+    it = free_ranges_by_size_.lower_bound(size);
+    DCHECK(it != free_ranges_by_size_.end());
+  }
+  const size_t free_size = it->first;
+  uint8_t* const begin = it->second;
+  RemoveFreeRange(begin, free_size);
+  if (free_size != size) {
+    // The rest cannot merge with a neighbour, it was part of the same free range.
+    free_ranges_by_size_.emplace(free_size - size, begin + size);
+    free_ranges_by_address_.emplace(begin + size, free_size - size);
+  }
+  return begin;
+}
+
+void MemMapReservations::Free(uint8_t* begin, size_t byte_count) {
+  DCHECK_ALIGNED(begin, kPageSize);
+  const size_t size = RoundUp(byte_count, kPageSize);
+  ZeroAndReleasePages(begin, size);
+  AddFreeRange(begin, size);
+}
+
+size_t MemMapReservations::GetFreeSize() const {
+  size_t free_size = 0u;
+  for (const auto& range : free_ranges_by_address_) {
+    free_size += range.second;
+  }
+  return free_size;
+}
+
+void MemMapReservations::AddFreeRange(uint8_t* begin, size_t size) {
+  auto next = free_ranges_by_address_.find(begin + size);
+  if (next != free_ranges_by_address_.end()) {
+    const size_t next_size = next->second;
+    RemoveFreeRange(begin + size, next_size);
+    size += next_size;
+  }
+  auto prev = free_ranges_by_address_.lower_bound(begin);
+  if (prev != free_ranges_by_address_.begin()) {
+    --prev;
+    if (prev->first + prev->second == begin) {
+      uint8_t* const prev_begin = prev->first;
+      const size_t prev_size = prev->second;
+      RemoveFreeRange(prev_begin, prev_size);
+      begin = prev_begin;
+      size += prev_size;
+    }
+  }
+  free_ranges_by_size_.emplace(size, begin);
+  free_ranges_by_address_.emplace(begin, size);
+}
+
+void MemMapReservations::RemoveFreeRange(uint8_t* begin, size_t size) {
+  auto range = free_ranges_by_size_.equal_range(size);
+  auto it = std::find_if(range.first,
+                         range.second,
+                         [begin](const std::pair<const size_t, uint8_t*>& entry) {
+                           return entry.second == begin;
+                         });
+  DCHECK(it != range.second);
+  free_ranges_by_size_.erase(it);
+  free_ranges_by_address_.erase(begin);
+}
+
 }  // namespace art
@@ -21,10 +21,14 @@
 #include <sys/types.h>
 
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "android-base/thread_annotations.h"
+#include "base/macros.h"
+#include "globals.h"
 
 namespace art {
 
@@ -52,6 +56,9 @@ static constexpr bool kMadviseZeroes = false;
 // Otherwise, calls might see uninitialized values.
 class MemMap {
  public:
+  // The size of the transparent huge pages the heap spaces may be backed by.
+  static constexpr size_t kHugePageSize = 2 * MB;
+
   // Request an anonymous region of length 'byte_count' and a requested base address.
   // Use null as the requested base address if you don't care.
   // "reuse" allows re-mapping an address range from an existing mapping.
@@ -167,6 +174,22 @@ class MemMap {
     return Begin() <= addr && addr < End();
   }
 
+  // Advise the kernel to back the huge pages entirely within the map by transparent huge pages.
+  // Returns false if there are none or the kernel does not support it.
+  bool MadviseHugePages();
+
+  // The bytes of the map advised to be backed by huge pages.
+  size_t GetHugePageAdvisedSize() const {
+    return huge_page_advised_size_;
+  }
+
+  bool UsesHugePages() const {
+    return huge_page_advised_size_ != 0;
+  }
+
+  // The bytes of the map backed by huge pages, read from /proc/self/smaps. This is slow.
+  size_t GetHugePageBackedSize() const;
+
   // Unmap the pages at end and remap them to create another memory map.
   MemMap* RemapAtEnd(uint8_t* new_end,
                      const char* tail_name,
@@ -193,6 +216,15 @@ class MemMap {
   // Align the map by unmapping the unaligned parts at the lower and the higher ends.
   void AlignBy(size_t size);
 
+  // Map at least byte_count bytes at an address aligned by alignment, such as kHugePageSize. The
+  // size of the map is byte_count rounded up by alignment.
+  static MemMap* MapAnonymousAligned(const char* name,
+                                     size_t byte_count,
+                                     int prot,
+                                     bool low_4gb,
+                                     size_t alignment,
+                                     std::string* error_msg);
+
   // For annotation reasons.
   static std::mutex* GetMemMapsLock() RETURN_CAPABILITY(mem_maps_lock_) {
     return nullptr;
@@ -248,6 +280,9 @@ class MemMap {
 
   const size_t redzone_size_;
 
+  // Set by MadviseHugePages().
+  size_t huge_page_advised_size_;
+
 #if USE_ART_LOW_4G_ALLOCATOR
   static uintptr_t next_mem_pos_;   // Next memory location to check for low_4g extent.
 #endif
@@ -259,8 +294,56 @@ class MemMap {
 
 std::ostream& operator<<(std::ostream& os, const MemMap& mem_map);
 
-// Zero and release pages if possible, no requirements on alignments.
-void ZeroAndReleasePages(void* address, size_t length);
+// Zero and release pages if possible, no requirements on alignments. Only the whole blocks of
+// release_alignment are released, such as the huge pages that releasing a part of would split.
+void ZeroAndReleasePages(void* address, size_t length, size_t release_alignment = kPageSize);
+
+// Release pages that are known to be zero. Uses MADV_FREE where the kernel supports it, which
+// only frees the pages under memory pressure and is cheaper, and MADV_DONTNEED otherwise. The
+// pages read as zero afterwards only because they already were.
+void ReleaseZeroedPages(void* address, size_t length);
+
+// Carves page aligned ranges out of a few large anonymous maps instead of mapping each range on
+// its own. This saves the mmap and ashmem calls of the ranges, and the maps of the ranges no
+// longer split the address space in as many VMAs. The freed ranges are released with madvise and
+// reused by the next allocations, picked best-fit. Not thread safe, the callers serialize the
+// calls.
+class MemMapReservations {
+ public:
+  // Reservations of reservation_size bytes, or of the requested size if larger, are mapped as
+  // the allocations need them.
+  MemMapReservations(const char* name, size_t reservation_size, bool low_4gb);
+
+  // Returns zeroed memory of byte_count bytes rounded up to the page size, or null with the
+  // error in error_msg if a new reservation could not be mapped.
+  uint8_t* Allocate(size_t byte_count, std::string* error_msg);
+
+  // Zero and release the pages of a range returned by Allocate, for the next allocations.
+  void Free(uint8_t* begin, size_t byte_count);
+
+  // The bytes of the reservations mapped.
+  size_t GetReservedSize() const {
+    return reserved_size_;
+  }
+
+  // The bytes of the reservations not allocated.
+  size_t GetFreeSize() const;
+
+ private:
+  void AddFreeRange(uint8_t* begin, size_t size);
+  void RemoveFreeRange(uint8_t* begin, size_t size);
+
+  const std::string name_;
+  const size_t reservation_size_;
+  const bool low_4gb_;
+  size_t reserved_size_;
+  std::vector<std::unique_ptr<MemMap>> maps_;
+  // The free ranges by size for the best-fit search, and by address to merge the neighbours.
+  std::multimap<size_t, uint8_t*> free_ranges_by_size_;
+  std::map<uint8_t*, size_t> free_ranges_by_address_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemMapReservations);
+};
 
 }  // namespace art
 
@@ -537,4 +537,70 @@ TEST_F(MemMapTest, AlignBy) {
   }
 }
 
+TEST_F(MemMapTest, MapAnonymousAligned) {
+  CommonInit();
+  std::string error_msg;
+  const size_t page_size = static_cast<size_t>(kPageSize);
+  std::unique_ptr<MemMap> map(MemMap::MapAnonymousAligned("MemMapTest_MapAnonymousAligned",
+                                                          3 * MemMap::kHugePageSize + page_size,
+                                                          PROT_READ | PROT_WRITE,
+                                                          false,
+                                                          MemMap::kHugePageSize,
+                                                          &error_msg));
+  ASSERT_TRUE(map != nullptr) << error_msg;
+  EXPECT_TRUE(IsAlignedParam(map->Begin(), MemMap::kHugePageSize));
+  EXPECT_EQ(map->Size(), 4 * MemMap::kHugePageSize);
+  EXPECT_EQ(BaseBegin(map.get()), map->Begin());
+  EXPECT_EQ(BaseSize(map.get()), map->Size());
+  // All of the map is advised when the kernel supports huge pages.
+  if (map->MadviseHugePages()) {
+    EXPECT_TRUE(map->UsesHugePages());
+    EXPECT_EQ(map->GetHugePageAdvisedSize(), map->Size());
+    EXPECT_LE(map->GetHugePageBackedSize(), map->Size());
+  }
+  // Only the whole huge pages are released, the rest is zeroed.
+  memset(map->Begin(), 0xff, map->Size());
+  ZeroAndReleasePages(map->Begin() + page_size,
+                      2 * MemMap::kHugePageSize,
+                      MemMap::kHugePageSize);
+  for (size_t i = 0; i < map->Size(); ++i) {
+    bool cleared = i >= page_size && i < page_size + 2 * MemMap::kHugePageSize;
+    ASSERT_EQ(map->Begin()[i], cleared ? 0u : 0xffu) << i;
+  }
+}
+
+TEST_F(MemMapTest, MemMapReservations) {
+  CommonInit();
+  std::string error_msg;
+  const size_t page_size = static_cast<size_t>(kPageSize);
+  MemMapReservations reservations("MemMapTest_MemMapReservations", 8 * page_size, false);
+  uint8_t* first = reservations.Allocate(page_size, &error_msg);
+  ASSERT_TRUE(first != nullptr) << error_msg;
+  uint8_t* second = reservations.Allocate(2 * page_size - 1, &error_msg);
+  ASSERT_TRUE(second != nullptr) << error_msg;
+  uint8_t* third = reservations.Allocate(page_size, &error_msg);
+  ASSERT_TRUE(third != nullptr) << error_msg;
+  // The ranges are carved out of a single reservation.
+  EXPECT_EQ(8 * page_size, reservations.GetReservedSize());
+  EXPECT_EQ(4 * page_size, reservations.GetFreeSize());
+  EXPECT_EQ(first + page_size, second);
+  EXPECT_EQ(second + 2 * page_size, third);
+  // The freed range is zeroed and reused best-fit.
+  memset(first, 0xff, page_size);
+  reservations.Free(first, page_size);
+  uint8_t* fourth = reservations.Allocate(page_size, &error_msg);
+  EXPECT_EQ(first, fourth);
+  for (size_t i = 0; i < page_size; ++i) {
+    ASSERT_EQ(0u, fourth[i]) << i;
+  }
+  // The freed neighbours merge, a larger allocation maps a new reservation.
+  reservations.Free(second, 2 * page_size);
+  reservations.Free(third, page_size);
+  EXPECT_EQ(7 * page_size, reservations.GetFreeSize());
+  uint8_t* large = reservations.Allocate(9 * page_size, &error_msg);
+  ASSERT_TRUE(large != nullptr) << error_msg;
+  EXPECT_EQ(17 * page_size, reservations.GetReservedSize());
+  EXPECT_EQ(7 * page_size, reservations.GetFreeSize());
+}
+
 }  // namespace art
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "method_header_cache.h"
+
+namespace art {
+
+Atomic<uint32_t> MethodHeaderCache::generation_(0u);
+
+MethodHeaderCache::MethodHeaderCache() : cached_generation_(generation_.LoadRelaxed()) {
+  Clear();
+}
+
+void MethodHeaderCache::Clear() {
+  for (Entry& entry : entries_) {
+    entry = Entry { nullptr, 0u, nullptr };
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_METHOD_HEADER_CACHE_H_
+#define ART_RUNTIME_METHOD_HEADER_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "atomic.h"
+#include "base/bit_utils.h"
+#include "base/macros.h"
+
+namespace art {
+
+class ArtMethod;
+class OatQuickMethodHeader;
+
+// A small direct-mapped cache of the method headers found by the stack walks for the frames of
+// compiled code, keyed by the method and the pc in its code. A hit replaces the lookup of the
+// JIT code cache or of the oat file of the method, needed when the pc is not in the code of the
+// current entry point of the method. The frame size and spill masks come from the header.
+//
+// Each thread has its own cache, only used by the thread itself for the stacks it walks, so no
+// synchronization is needed. The headers of the entries may be freed when the JIT code cache
+// frees code or when class loaders are unloaded. Both move to a new generation, and a cache of an
+// older generation is cleared before its next use.
+class MethodHeaderCache {
+ public:
+  // Number of entries, must be a power of 2.
+  static constexpr size_t kSize = 256;
+
+  MethodHeaderCache();
+
+  // Returns the header of the code of method containing pc, or null on a miss.
+  ALWAYS_INLINE const OatQuickMethodHeader* Get(ArtMethod* method, uintptr_t pc) {
+    uint32_t generation = generation_.LoadRelaxed();
+    if (UNLIKELY(generation != cached_generation_)) {
+      Clear();
+      cached_generation_ = generation;
+      return nullptr;
+    }
+    const Entry& entry = entries_[IndexOf(pc)];
+    return (entry.pc == pc && entry.method == method) ? entry.header : nullptr;
+  }
+
+  ALWAYS_INLINE void Set(ArtMethod* method, uintptr_t pc, const OatQuickMethodHeader* header) {
+    entries_[IndexOf(pc)] = Entry { method, pc, header };
+  }
+
+  void Clear();
+
+  // Called before compiled code may be freed.
+  static void InvalidateAll() {
+    generation_.FetchAndAddSequentiallyConsistent(1u);
+  }
+
+ private:
+  struct Entry {
+    ArtMethod* method;
+    uintptr_t pc;
+    const OatQuickMethodHeader* header;
+  };
+
+  static size_t IndexOf(uintptr_t pc) {
+    static_assert(IsPowerOfTwo(kSize), "Method header cache size is not a power of 2");
+    // Return pcs follow call instructions, which are at least 2 bytes.
+    return (pc >> 1) & (kSize - 1u);
+  }
+
+  Entry entries_[kSize];
+  uint32_t cached_generation_;
+
+  static Atomic<uint32_t> generation_;
+
+  DISALLOW_COPY_AND_ASSIGN(MethodHeaderCache);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_METHOD_HEADER_CACHE_H_
@@ -1361,6 +1361,14 @@ void Class::SetObjectSizeAllocFastPath(uint32_t new_object_size) {
   }
 }
 
+void Class::SetPretenured() {
+  DCHECK(IsInitialized());
+  uint32_t flags = GetField32(OFFSET_OF_OBJECT_MEMBER(Class, access_flags_));
+  SetAccessFlags(flags | kAccClassIsPretenured);
+  // Leave the fast paths of the allocation entrypoints, which allocate in the young generation.
+  SetObjectSizeAllocFastPath(std::numeric_limits<uint32_t>::max());
+}
+
 std::string Class::PrettyDescriptor(ObjPtr<mirror::Class> klass) {
   if (klass == nullptr) {
     return "null";
@@ -287,6 +287,14 @@ class MANAGED Class FINAL : public Object {
     SetAccessFlags(flags | kAccClassIsFinalizable);
   }
 
+  ALWAYS_INLINE bool IsPretenured() REQUIRES_SHARED(Locks::mutator_lock_) {
+    return (GetAccessFlags<kVerifyNone>() & kAccClassIsPretenured) != 0;
+  }
+
+  // Set by the GC in a pause. The instances then take the slow path of the allocation, which
+  // allocates them in the old generation.
+  void SetPretenured() REQUIRES(Locks::mutator_lock_);
+
   ALWAYS_INLINE bool IsStringClass() REQUIRES_SHARED(Locks::mutator_lock_) {
     return (GetClassFlags() & kClassFlagString) != 0;
   }
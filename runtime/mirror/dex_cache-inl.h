@@ -55,8 +55,7 @@ inline uint32_t DexCache::ClassSize(PointerSize pointer_size) {
 
 inline uint32_t DexCache::StringSlotIndex(dex::StringIndex string_idx) {
   DCHECK_LT(string_idx.index_, GetDexFile()->NumStringIds());
-  const uint32_t slot_idx = string_idx.index_ % kDexCacheStringCacheSize;
-  DCHECK_LT(slot_idx, NumStrings());
+  const uint32_t slot_idx = SlotIndex(string_idx.index_, NumStrings());
   return slot_idx;
 }
 
@@ -78,6 +77,12 @@ inline void DexCache::SetResolvedString(dex::StringIndex string_idx, ObjPtr<Stri
   runtime->GetHeap()->WriteBarrierEveryFieldOf(this);
 }
 
+inline bool DexCache::IsStringSlotTaken(dex::StringIndex string_idx) {
+  StringDexCachePair pair =
+      GetStrings()[StringSlotIndex(string_idx)].load(std::memory_order_relaxed);
+  return pair.index != string_idx.index_ && !pair.object.IsNull();
+}
+
 inline void DexCache::ClearString(dex::StringIndex string_idx) {
   DCHECK(Runtime::Current()->IsAotCompiler());
   uint32_t slot_idx = StringSlotIndex(string_idx);
@@ -91,8 +96,7 @@ inline void DexCache::ClearString(dex::StringIndex string_idx) {
 
 inline uint32_t DexCache::TypeSlotIndex(dex::TypeIndex type_idx) {
   DCHECK_LT(type_idx.index_, GetDexFile()->NumTypeIds());
-  const uint32_t slot_idx = type_idx.index_ % kDexCacheTypeCacheSize;
-  DCHECK_LT(slot_idx, NumResolvedTypes());
+  const uint32_t slot_idx = SlotIndex(type_idx.index_, NumResolvedTypes());
   return slot_idx;
 }
 
@@ -115,6 +119,12 @@ inline void DexCache::SetResolvedType(dex::TypeIndex type_idx, ObjPtr<Class> res
   Runtime::Current()->GetHeap()->WriteBarrierEveryFieldOf(this);
 }
 
+inline bool DexCache::IsTypeSlotTaken(dex::TypeIndex type_idx) {
+  TypeDexCachePair pair =
+      GetResolvedTypes()[TypeSlotIndex(type_idx)].load(std::memory_order_relaxed);
+  return pair.index != type_idx.index_ && !pair.object.IsNull();
+}
+
 inline void DexCache::ClearResolvedType(dex::TypeIndex type_idx) {
   DCHECK(Runtime::Current()->IsAotCompiler());
   uint32_t slot_idx = TypeSlotIndex(type_idx);
@@ -178,8 +188,7 @@ inline CallSite* DexCache::SetResolvedCallSite(uint32_t call_site_idx, CallSite*
 
 inline uint32_t DexCache::FieldSlotIndex(uint32_t field_idx) {
   DCHECK_LT(field_idx, GetDexFile()->NumFieldIds());
-  const uint32_t slot_idx = field_idx % kDexCacheFieldCacheSize;
-  DCHECK_LT(slot_idx, NumResolvedFields());
+  const uint32_t slot_idx = SlotIndex(field_idx, NumResolvedFields());
   return slot_idx;
 }
 
@@ -196,6 +205,11 @@ inline void DexCache::SetResolvedField(uint32_t field_idx, ArtField* field, Poin
   SetNativePairPtrSize(GetResolvedFields(), FieldSlotIndex(field_idx), pair, ptr_size);
 }
 
+inline bool DexCache::IsFieldSlotTaken(uint32_t field_idx, PointerSize ptr_size) {
+  auto pair = GetNativePairPtrSize(GetResolvedFields(), FieldSlotIndex(field_idx), ptr_size);
+  return pair.index != field_idx && pair.object != nullptr;
+}
+
 inline void DexCache::ClearResolvedField(uint32_t field_idx, PointerSize ptr_size) {
   DCHECK_EQ(Runtime::Current()->GetClassLinker()->GetImagePointerSize(), ptr_size);
   uint32_t slot_idx = FieldSlotIndex(field_idx);
@@ -67,18 +67,9 @@ void DexCache::InitializeDexCache(Thread* self,
   FieldDexCacheType* fields = (dex_file->NumFieldIds() == 0u) ? nullptr :
       reinterpret_cast<FieldDexCacheType*>(raw_arrays + layout.FieldsOffset());
 
-  size_t num_strings = kDexCacheStringCacheSize;
-  if (dex_file->NumStringIds() < num_strings) {
-    num_strings = dex_file->NumStringIds();
-  }
-  size_t num_types = kDexCacheTypeCacheSize;
-  if (dex_file->NumTypeIds() < num_types) {
-    num_types = dex_file->NumTypeIds();
-  }
-  size_t num_fields = kDexCacheFieldCacheSize;
-  if (dex_file->NumFieldIds() < num_fields) {
-    num_fields = dex_file->NumFieldIds();
-  }
+  size_t num_strings = StringCacheSize(dex_file->NumStringIds());
+  size_t num_types = TypeCacheSize(dex_file->NumTypeIds());
+  size_t num_fields = FieldCacheSize(dex_file->NumFieldIds());
   size_t num_methods = kDexCacheMethodCacheSize;
   if (dex_file->NumMethodIds() < num_methods) {
     num_methods = dex_file->NumMethodIds();
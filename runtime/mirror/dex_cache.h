@@ -141,21 +141,28 @@ class MANAGED DexCache FINAL : public Object {
   // Size of java.lang.DexCache.class.
   static uint32_t ClassSize(PointerSize pointer_size);
 
-  // Size of type dex cache. Needs to be a power of 2 for entrypoint assumptions to hold.
+  // Minimum size of type dex cache, see TypeCacheSize(). Needs to be a power of 2.
   static constexpr size_t kDexCacheTypeCacheSize = 1024;
   static_assert(IsPowerOfTwo(kDexCacheTypeCacheSize),
                 "Type dex cache size is not a power of 2.");
 
-  // Size of string dex cache. Needs to be a power of 2 for entrypoint assumptions to hold.
+  // Minimum size of string dex cache, see StringCacheSize(). Needs to be a power of 2.
   static constexpr size_t kDexCacheStringCacheSize = 1024;
   static_assert(IsPowerOfTwo(kDexCacheStringCacheSize),
                 "String dex cache size is not a power of 2.");
 
-  // Size of field dex cache. Needs to be a power of 2 for entrypoint assumptions to hold.
+  // Minimum size of field dex cache, see FieldCacheSize(). Needs to be a power of 2.
   static constexpr size_t kDexCacheFieldCacheSize = 1024;
   static_assert(IsPowerOfTwo(kDexCacheFieldCacheSize),
                 "Field dex cache size is not a power of 2.");
 
+  // Maximum size of the type, string and field dex caches of large dex files.
+  static constexpr size_t kDexCacheMaxCacheSize = 4096;
+  static_assert(IsPowerOfTwo(kDexCacheMaxCacheSize), "Max dex cache size is not a power of 2.");
+
+  // Ids per entry of the type, string and field dex caches of large dex files.
+  static constexpr size_t kDexCacheIdsPerEntry = 8;
+
   // Size of method dex cache. Needs to be a power of 2 for entrypoint assumptions to hold.
   static constexpr size_t kDexCacheMethodCacheSize = 1024;
   static_assert(IsPowerOfTwo(kDexCacheMethodCacheSize),
@@ -187,6 +194,32 @@ class MANAGED DexCache FINAL : public Object {
     return kDexCacheMethodTypeCacheSize;
   }
 
+  // Number of entries of a dex cache for num_ids ids. Small dex files get an entry per id. The
+  // caches of larger dex files grow from min_size with the number of ids, so that the conflict
+  // misses of the dex files with tens of thousands of strings stay low, up to
+  // kDexCacheMaxCacheSize. A size smaller than num_ids is always a power of 2.
+  static constexpr size_t CacheSize(size_t num_ids, size_t min_size) {
+    return (num_ids <= min_size)
+        ? num_ids
+        : (RoundUpToPowerOfTwo(num_ids) / kDexCacheIdsPerEntry <= min_size)
+            ? min_size
+            : (RoundUpToPowerOfTwo(num_ids) / kDexCacheIdsPerEntry >= kDexCacheMaxCacheSize)
+                ? kDexCacheMaxCacheSize
+                : RoundUpToPowerOfTwo(num_ids) / kDexCacheIdsPerEntry;
+  }
+
+  static constexpr size_t TypeCacheSize(size_t num_type_ids) {
+    return CacheSize(num_type_ids, kDexCacheTypeCacheSize);
+  }
+
+  static constexpr size_t StringCacheSize(size_t num_string_ids) {
+    return CacheSize(num_string_ids, kDexCacheStringCacheSize);
+  }
+
+  static constexpr size_t FieldCacheSize(size_t num_field_ids) {
+    return CacheSize(num_field_ids, kDexCacheFieldCacheSize);
+  }
+
   // Size of an instance of java.lang.DexCache not including referenced values.
   static constexpr uint32_t InstanceSize() {
     return sizeof(DexCache);
@@ -437,6 +470,19 @@ class MANAGED DexCache FINAL : public Object {
                                    NativeDexCachePair<T> pair,
                                    PointerSize ptr_size);
 
+  // Slot of index idx in a cache of num_entries, see CacheSize().
+  static uint32_t SlotIndex(uint32_t idx, uint32_t num_entries) {
+    DCHECK(idx < num_entries || IsPowerOfTwo(num_entries));
+    return LIKELY(idx < num_entries) ? idx : (idx & (num_entries - 1u));
+  }
+
+  // Whether the slot of an id holds another resolved id, i.e. whether a miss of the id is a
+  // conflict miss rather than a cold one.
+  bool IsStringSlotTaken(dex::StringIndex string_idx) REQUIRES_SHARED(Locks::mutator_lock_);
+  bool IsTypeSlotTaken(dex::TypeIndex type_idx) REQUIRES_SHARED(Locks::mutator_lock_);
+  bool IsFieldSlotTaken(uint32_t field_idx, PointerSize ptr_size)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   uint32_t StringSlotIndex(dex::StringIndex string_idx) REQUIRES_SHARED(Locks::mutator_lock_);
   uint32_t TypeSlotIndex(dex::TypeIndex type_idx) REQUIRES_SHARED(Locks::mutator_lock_);
   uint32_t FieldSlotIndex(uint32_t field_idx) REQUIRES_SHARED(Locks::mutator_lock_);
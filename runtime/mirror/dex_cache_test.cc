@@ -50,18 +50,34 @@ TEST_F(DexCacheTest, Open) {
           Runtime::Current()->GetLinearAlloc())));
   ASSERT_TRUE(dex_cache != nullptr);
 
-  EXPECT_TRUE(dex_cache->StaticStringSize() == dex_cache->NumStrings()
-      || java_lang_dex_file_->NumStringIds() == dex_cache->NumStrings());
-  EXPECT_TRUE(dex_cache->StaticTypeSize() == dex_cache->NumResolvedTypes()
-      || java_lang_dex_file_->NumTypeIds() == dex_cache->NumResolvedTypes());
+  EXPECT_EQ(DexCache::StringCacheSize(java_lang_dex_file_->NumStringIds()),
+            dex_cache->NumStrings());
+  EXPECT_EQ(DexCache::TypeCacheSize(java_lang_dex_file_->NumTypeIds()),
+            dex_cache->NumResolvedTypes());
   EXPECT_TRUE(dex_cache->StaticMethodSize() == dex_cache->NumResolvedMethods()
       || java_lang_dex_file_->NumMethodIds() == dex_cache->NumResolvedMethods());
-  EXPECT_TRUE(dex_cache->StaticArtFieldSize() == dex_cache->NumResolvedFields()
-      || java_lang_dex_file_->NumFieldIds() ==  dex_cache->NumResolvedFields());
+  EXPECT_EQ(DexCache::FieldCacheSize(java_lang_dex_file_->NumFieldIds()),
+            dex_cache->NumResolvedFields());
   EXPECT_TRUE(dex_cache->StaticMethodTypeSize() == dex_cache->NumResolvedMethodTypes()
       || java_lang_dex_file_->NumProtoIds() == dex_cache->NumResolvedMethodTypes());
 }
 
+TEST_F(DexCacheTest, CacheSize) {
+  // Small dex files get an entry per id.
+  EXPECT_EQ(0u, DexCache::StringCacheSize(0u));
+  EXPECT_EQ(700u, DexCache::StringCacheSize(700u));
+  EXPECT_EQ(DexCache::kDexCacheStringCacheSize,
+            DexCache::StringCacheSize(DexCache::kDexCacheStringCacheSize));
+  // Larger ones keep the minimum size until they have enough ids per entry.
+  EXPECT_EQ(DexCache::kDexCacheStringCacheSize, DexCache::StringCacheSize(5000u));
+  EXPECT_EQ(2048u, DexCache::StringCacheSize(10000u));
+  EXPECT_EQ(4096u, DexCache::StringCacheSize(30000u));
+  EXPECT_EQ(DexCache::kDexCacheMaxCacheSize, DexCache::StringCacheSize(60000u));
+  // The slots of the ids map onto the cache.
+  EXPECT_EQ(5u, DexCache::SlotIndex(5u, 700u));
+  EXPECT_EQ(5u, DexCache::SlotIndex(4096u + 5u, 4096u));
+}
+
 TEST_F(DexCacheMethodHandlesTest, Open) {
   ScopedObjectAccess soa(Thread::Current());
   StackHandleScope<1> hs(soa.Self());
@@ -189,24 +189,34 @@ int32_t Object::IdentityHashCode() {
     LockWord lw = current_this->GetLockWord(false);
     switch (lw.GetState()) {
       case LockWord::kUnlocked: {
-        // Try to compare and swap in a new hash, if we succeed we will return the hash on the next
-        // loop iteration.
-        LockWord hash_word = LockWord::FromHashCode(GenerateIdentityHashCode(), lw.GCState());
-        DCHECK_EQ(hash_word.GetState(), LockWord::kHashCode);
-        if (current_this->CasLockWordWeakRelaxed(lw, hash_word)) {
-          return hash_word.GetHashCode();
+        // Try to compare and swap in a new hash, or the one the object got while thin locked.
+        // May fail spuriously.
+        int32_t hash;
+        if (Runtime::Current()->GetMonitorList()->InstallHashCode(
+                Thread::Current(), current_this.Ptr(), lw, &hash)) {
+          return hash;
         }
         break;
       }
       case LockWord::kThinLocked: {
-        // Inflate the thin lock to a monitor and stick the hash code inside of the monitor. May
-        // fail spuriously.
+        // Keep the hash code in the monitor list rather than inflating the lock, which would make
+        // every later lock of the object slower. Fails if the lock was released or inflated.
         Thread* self = Thread::Current();
-        StackHandleScope<1> hs(self);
-        Handle<mirror::Object> h_this(hs.NewHandle(current_this));
-        Monitor::InflateThinLocked(self, h_this, lw, GenerateIdentityHashCode());
-        // A GC may have occurred when we switched to kBlocked.
-        current_this = h_this.Get();
+        int32_t hash;
+        bool inflate;
+        if (Runtime::Current()->GetMonitorList()->GetThinLockedHashCode(
+                self, current_this.Ptr(), &hash, &inflate)) {
+          return hash;
+        }
+        if (inflate) {
+          // The monitor list cannot keep the hash code during the sweep. Inflate the thin lock
+          // and stick the hash code inside of the monitor. May fail spuriously.
+          StackHandleScope<1> hs(self);
+          Handle<mirror::Object> h_this(hs.NewHandle(current_this));
+          Monitor::InflateThinLocked(self, h_this, lw, hash);
+          // A GC may have occurred when we switched to kBlocked.
+          current_this = h_this.Get();
+        }
         break;
       }
       case LockWord::kFatLocked: {
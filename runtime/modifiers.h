@@ -62,6 +62,7 @@ static constexpr uint32_t kAccMiranda =               0x00200000;  // method (de
 static constexpr uint32_t kAccDefault =               0x00400000;  // method (runtime)
 
 // Set by the JIT when clearing profiling infos to denote that a method was previously warm.
+// Part of the intrinsic ordinal for intrinsic methods, which are not profiled.
 static constexpr uint32_t kAccPreviouslyWarm =        0x00800000;  // method (runtime)
 
 // This is set by the class linker during LinkInterfaceMethods. Prior to that point we do not know
@@ -82,6 +83,9 @@ static constexpr uint32_t kAccSingleImplementation =  0x08000000;  // method (ru
 static constexpr uint32_t kAccIntrinsic  =            0x80000000;  // method (runtime)
 
 // Special runtime-only flags.
+// Set by the generational semi-space collector for a class whose instances mostly get promoted
+// because of their age, they are allocated in the old generation directly.
+static constexpr uint32_t kAccClassIsPretenured         = 0x10000000;
 // Interface and all its super-interfaces with default methods have been recursively initialized.
 static constexpr uint32_t kAccRecursivelyInitialized    = 0x20000000;
 // Interface declares some default method.
@@ -89,8 +93,8 @@ static constexpr uint32_t kAccHasDefaultMethod          = 0x40000000;
 // class/ancestor overrides finalize()
 static constexpr uint32_t kAccClassIsFinalizable        = 0x80000000;
 
-static constexpr uint32_t kAccFlagsNotUsedByIntrinsic   = 0x00FFFFFF;
-static constexpr uint32_t kAccMaxIntrinsic              = 0x7F;
+static constexpr uint32_t kAccFlagsNotUsedByIntrinsic   = 0x007FFFFF;
+static constexpr uint32_t kAccMaxIntrinsic              = 0xFF;
 
 // Valid (meaningful) bits for a field.
 static constexpr uint32_t kAccValidFieldFlags = kAccPublic | kAccPrivate | kAccProtected |
@@ -16,6 +16,9 @@
 
 #include "monitor.h"
 
+#include <sched.h>
+
+#include <algorithm>
 #include <vector>
 
 #include "android-base/stringprintf.h"
@@ -26,8 +29,11 @@
 #include "base/systrace.h"
 #include "base/time_utils.h"
 #include "class_linker.h"
+#include "contention_profiler.h"
 #include "dex_file-inl.h"
 #include "dex_instruction-inl.h"
+#include "gc/collector/concurrent_copying.h"
+#include "gc/heap.h"
 #include "lock_word-inl.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
@@ -45,6 +51,12 @@ using android::base::StringPrintf;
 
 static constexpr uint64_t kLongWaitMs = 100;
 
+// Bounds of Monitor::spin_limit_, in iterations of the spin loop. The upper bound keeps a spin
+// within tens of microseconds, about the cost of blocking and being woken.
+static constexpr size_t kInitialSpinLimit = 128;
+static constexpr size_t kMinSpinLimit = 16;
+static constexpr size_t kMaxSpinLimit = 4096;
+
 /*
  * Every Object has a monitor associated with it, but not every Object is actually locked.  Even
  * the ones that are locked do not need a full-fledged monitor until a) there is actual contention
@@ -56,7 +68,8 @@ static constexpr uint64_t kLongWaitMs = 100;
  *
  * The two states of an Object's lock are referred to as "thin" and "fat".  A lock may transition
  * from the "thin" state to the "fat" state and this transition is referred to as inflation. Once
- * a lock has been inflated it remains in the "fat" state indefinitely.
+ * a lock has been inflated it remains in the "fat" state until it is deflated, with all threads
+ * suspended, by a heap trim.
  *
  * The lock value itself is stored in mirror::Object::monitor_ and the representation is described
  * in the LockWord value type.
@@ -87,6 +100,8 @@ Monitor::Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_
       num_waiters_(0),
       owner_(owner),
       lock_count_(0),
+      spin_limit_(kInitialSpinLimit),
+      locked_since_scan_(true),
       obj_(GcRoot<mirror::Object>(obj)),
       wait_set_(nullptr),
       hash_code_(hash_code),
@@ -110,6 +125,8 @@ Monitor::Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_
       num_waiters_(0),
       owner_(owner),
       lock_count_(0),
+      spin_limit_(kInitialSpinLimit),
+      locked_since_scan_(true),
       obj_(GcRoot<mirror::Object>(obj)),
       wait_set_(nullptr),
       hash_code_(hash_code),
@@ -126,10 +143,8 @@ Monitor::Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_
 }
 
 int32_t Monitor::GetHashCode() {
-  while (!HasHashCode()) {
-    if (hash_code_.CompareExchangeWeakRelaxed(0, mirror::Object::GenerateIdentityHashCode())) {
-      break;
-    }
+  if (!HasHashCode()) {
+    Runtime::Current()->GetMonitorList()->InstallHashCode(Thread::Current(), this);
   }
   DCHECK(HasHashCode());
   return hash_code_.LoadRelaxed();
@@ -137,12 +152,13 @@ int32_t Monitor::GetHashCode() {
 
 bool Monitor::Install(Thread* self) {
   MutexLock mu(self, monitor_lock_);  // Uncontended mutex acquisition as monitor isn't yet public.
-  CHECK(owner_ == nullptr || owner_ == self || owner_->IsSuspended());
+  Thread* owner = owner_.LoadRelaxed();
+  CHECK(owner == nullptr || owner == self || owner->IsSuspended());
   // Propagate the lock state.
   LockWord lw(GetObject()->GetLockWord(false));
   switch (lw.GetState()) {
     case LockWord::kThinLocked: {
-      CHECK_EQ(owner_->GetThreadId(), lw.ThinLockOwner());
+      CHECK_EQ(owner->GetThreadId(), lw.ThinLockOwner());
       lock_count_ = lw.ThinLockCount();
       break;
     }
@@ -167,10 +183,10 @@ bool Monitor::Install(Thread* self) {
   // Publish the updated lock word, which may race with other threads.
   bool success = GetObject()->CasLockWordWeakRelease(lw, fat);
   // Lock profiling.
-  if (success && owner_ != nullptr && lock_profiling_threshold_ != 0) {
+  if (success && owner_.LoadRelaxed() != nullptr && lock_profiling_threshold_ != 0) {
     // Do not abort on dex pc errors. This can easily happen when we want to dump a stack trace on
     // abort.
-    locking_method_ = owner_->GetCurrentMethod(&locking_dex_pc_, false);
+    locking_method_ = owner_.LoadRelaxed()->GetCurrentMethod(&locking_dex_pc_, false);
   }
   return success;
 }
@@ -180,7 +196,7 @@ Monitor::~Monitor() {
 }
 
 void Monitor::AppendToWaitSet(Thread* thread) {
-  DCHECK(owner_ == Thread::Current());
+  DCHECK(owner_.LoadRelaxed() == Thread::Current());
   DCHECK(thread != nullptr);
   DCHECK(thread->GetWaitNext() == nullptr) << thread->GetWaitNext();
   if (wait_set_ == nullptr) {
@@ -197,7 +213,7 @@ void Monitor::AppendToWaitSet(Thread* thread) {
 }
 
 void Monitor::RemoveFromWaitSet(Thread *thread) {
-  DCHECK(owner_ == Thread::Current());
+  DCHECK(owner_.LoadRelaxed() == Thread::Current());
   DCHECK(thread != nullptr);
   if (wait_set_ == nullptr) {
     return;
@@ -324,15 +340,16 @@ std::string Monitor::PrettyContentionInfo(const std::string& owner_name,
 }
 
 bool Monitor::TryLockLocked(Thread* self) {
-  if (owner_ == nullptr) {  // Unowned.
-    owner_ = self;
+  if (owner_.LoadRelaxed() == nullptr) {  // Unowned.
+    owner_.StoreRelaxed(self);
+    locked_since_scan_ = true;
     CHECK_EQ(lock_count_, 0);
     // When debugging, save the current monitor holder for future
     // acquisition failures to use in sampled logging.
     if (lock_profiling_threshold_ != 0) {
       locking_method_ = self->GetCurrentMethod(&locking_dex_pc_);
     }
-  } else if (owner_ == self) {  // Recursive.
+  } else if (owner_.LoadRelaxed() == self) {  // Recursive.
     lock_count_++;
   } else {
     return false;
@@ -346,12 +363,38 @@ bool Monitor::TryLock(Thread* self) {
   return TryLockLocked(self);
 }
 
+bool Monitor::SpinUntilReleased(Thread* self) {
+  const size_t spin_limit = spin_limit_;
+  // The thread stays runnable while spinning, so the monitor cannot be deflated meanwhile.
+  monitor_lock_.Unlock(self);
+  bool released = false;
+  for (size_t i = 0; i != spin_limit; ++i) {
+    if (GetOwner() == nullptr) {
+      released = true;
+      break;
+    }
+    SpinPause();
+  }
+  monitor_lock_.Lock(self);
+  spin_limit_ = released ? std::min(spin_limit_ * 2, kMaxSpinLimit)
+                         : std::max(spin_limit_ / 2, kMinSpinLimit);
+  return released;
+}
+
 void Monitor::Lock(Thread* self) {
   MutexLock mu(self, monitor_lock_);
+  // Spin once before blocking: a spinning thread delays the suspension of all threads.
+  bool spun = false;
   while (true) {
     if (TryLockLocked(self)) {
       return;
     }
+    if (!spun) {
+      spun = true;
+      if (SpinUntilReleased(self)) {
+        continue;
+      }
+    }
     // Contended.
     const bool log_contention = (lock_profiling_threshold_ != 0);
     uint64_t wait_start_ms = log_contention ? MilliTime() : 0;
@@ -365,12 +408,13 @@ void Monitor::Lock(Thread* self) {
     // lock and then re-acquiring the mutator lock can deadlock.
     bool started_trace = false;
     if (ATRACE_ENABLED()) {
-      if (owner_ != nullptr) {  // Did the owner_ give the lock up?
+      Thread* owner = owner_.LoadRelaxed();
+      if (owner != nullptr) {  // Did the owner_ give the lock up?
         std::ostringstream oss;
         std::string name;
-        owner_->GetThreadName(name);
+        owner->GetThreadName(name);
         oss << PrettyContentionInfo(name,
-                                    owner_->GetTid(),
+                                    owner->GetTid(),
                                     owners_method,
                                     owners_dex_pc,
                                     num_waiters);
@@ -388,6 +432,16 @@ void Monitor::Lock(Thread* self) {
       }
     }
 
+    // Find the site of a sampled contention while runnable, to time the wait below.
+    ContentionProfiler::Site* contention_site = nullptr;
+    uint64_t wait_start_ns = 0u;
+    if (ContentionProfiler::SampleMonitorContention()) {
+      uint32_t pc;
+      ArtMethod* m = self->GetCurrentMethod(&pc);
+      contention_site = ContentionProfiler::FindMonitorSite(m, pc, owners_method, owners_dex_pc);
+      wait_start_ns = NanoTime();
+    }
+
     monitor_lock_.Unlock(self);  // Let go of locks in order.
     self->SetMonitorEnterObject(GetObject());
     {
@@ -396,13 +450,17 @@ void Monitor::Lock(Thread* self) {
       {
         // Reacquire monitor_lock_ without mutator_lock_ for Wait.
         MutexLock mu2(self, monitor_lock_);
-        if (owner_ != nullptr) {  // Did the owner_ give the lock up?
-          original_owner_thread_id = owner_->GetThreadId();
+        Thread* owner = owner_.LoadRelaxed();
+        if (owner != nullptr) {  // Did the owner_ give the lock up?
+          original_owner_thread_id = owner->GetThreadId();
           monitor_contenders_.Wait(self);  // Still contended so wait.
         }
       }
       if (original_owner_thread_id != 0u) {
         // Woken from contention.
+        if (contention_site != nullptr) {
+          ContentionProfiler::RecordWait(contention_site, NanoTime() - wait_start_ns);
+        }
         if (log_contention) {
           uint64_t wait_ms = MilliTime() - wait_start_ms;
           uint32_t sample_percent;
@@ -611,7 +669,7 @@ bool Monitor::Unlock(Thread* self) {
   uint32_t owner_thread_id = 0u;
   {
     MutexLock mu(self, monitor_lock_);
-    Thread* owner = owner_;
+    Thread* owner = owner_.LoadRelaxed();
     if (owner != nullptr) {
       owner_thread_id = owner->GetThreadId();
     }
@@ -619,7 +677,7 @@ bool Monitor::Unlock(Thread* self) {
       // We own the monitor, so nobody else can be in here.
       AtraceMonitorUnlock();
       if (lock_count_ == 0) {
-        owner_ = nullptr;
+        owner_.StoreRelaxed(nullptr);
         locking_method_ = nullptr;
         locking_dex_pc_ = 0;
         // Wake a contender.
@@ -644,7 +702,7 @@ void Monitor::Wait(Thread* self, int64_t ms, int32_t ns,
   monitor_lock_.Lock(self);
 
   // Make sure that we hold the lock.
-  if (owner_ != self) {
+  if (owner_.LoadRelaxed() != self) {
     monitor_lock_.Unlock(self);
     ThrowIllegalMonitorStateExceptionF("object not locked by thread before wait()");
     return;
@@ -678,7 +736,7 @@ void Monitor::Wait(Thread* self, int64_t ms, int32_t ns,
   ++num_waiters_;
   int prev_lock_count = lock_count_;
   lock_count_ = 0;
-  owner_ = nullptr;
+  owner_.StoreRelaxed(nullptr);
   ArtMethod* saved_method = locking_method_;
   locking_method_ = nullptr;
   uintptr_t saved_dex_pc = locking_dex_pc_;
@@ -762,7 +820,7 @@ void Monitor::Wait(Thread* self, int64_t ms, int32_t ns,
    * thread owns the monitor. Aside from that, the order of member
    * updates is not order sensitive as we hold the pthread mutex.
    */
-  owner_ = self;
+  owner_.StoreRelaxed(self);
   lock_count_ = prev_lock_count;
   locking_method_ = saved_method;
   locking_dex_pc_ = saved_dex_pc;
@@ -776,7 +834,7 @@ void Monitor::Notify(Thread* self) {
   DCHECK(self != nullptr);
   MutexLock mu(self, monitor_lock_);
   // Make sure that we hold the lock.
-  if (owner_ != self) {
+  if (owner_.LoadRelaxed() != self) {
     ThrowIllegalMonitorStateExceptionF("object not locked by thread before notify()");
     return;
   }
@@ -799,7 +857,7 @@ void Monitor::NotifyAll(Thread* self) {
   DCHECK(self != nullptr);
   MutexLock mu(self, monitor_lock_);
   // Make sure that we hold the lock.
-  if (owner_ != self) {
+  if (owner_.LoadRelaxed() != self) {
     ThrowIllegalMonitorStateExceptionF("object not locked by thread before notifyAll()");
     return;
   }
@@ -825,7 +883,7 @@ bool Monitor::Deflate(Thread* self, mirror::Object* obj) {
     if (monitor->num_waiters_ > 0) {
       return false;
     }
-    Thread* owner = monitor->owner_;
+    Thread* owner = monitor->GetOwner();
     if (owner != nullptr) {
       // Can't deflate if we are locked and have a hash code.
       if (monitor->HasHashCode()) {
@@ -862,6 +920,19 @@ bool Monitor::Deflate(Thread* self, mirror::Object* obj) {
   return true;
 }
 
+bool Monitor::DeflateIfIdle(Thread* self, mirror::Object* obj) {
+  DCHECK(obj != nullptr);
+  LockWord lw(obj->GetLockWord(false));
+  if (lw.GetState() == LockWord::kFatLocked) {
+    Monitor* monitor = lw.FatLockMonitor();
+    MutexLock mu(self, monitor->monitor_lock_);
+    if (monitor->locked_since_scan_) {
+      return false;
+    }
+  }
+  return Deflate(self, obj);
+}
+
 void Monitor::Inflate(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_code) {
   DCHECK(self != nullptr);
   DCHECK(obj != nullptr);
@@ -1354,7 +1425,7 @@ bool Monitor::IsValidLockWord(LockWord lock_word) {
 
 bool Monitor::IsLocked() REQUIRES_SHARED(Locks::mutator_lock_) {
   MutexLock mu(Thread::Current(), monitor_lock_);
-  return owner_ != nullptr;
+  return owner_.LoadRelaxed() != nullptr;
 }
 
 void Monitor::TranslateLocation(ArtMethod* method,
@@ -1376,7 +1447,7 @@ void Monitor::TranslateLocation(ArtMethod* method,
 
 uint32_t Monitor::GetOwnerThreadId() {
   MutexLock mu(Thread::Current(), monitor_lock_);
-  Thread* owner = owner_;
+  Thread* owner = owner_.LoadRelaxed();
   if (owner != nullptr) {
     return owner->GetThreadId();
   } else {
@@ -1386,7 +1457,12 @@ uint32_t Monitor::GetOwnerThreadId() {
 
 MonitorList::MonitorList()
     : allow_new_monitors_(true), monitor_list_lock_("MonitorList lock", kMonitorListLock),
-      monitor_add_condition_("MonitorList disallow condition", monitor_list_lock_) {
+      monitor_add_condition_("MonitorList disallow condition", monitor_list_lock_),
+      hash_codes_lock_("MonitorList hash codes lock", kMonitorHashCodesLock),
+      allow_hash_codes_(true),
+      hash_codes_updated_(false),
+      num_hash_codes_(0u),
+      num_hashers_(0u) {
 }
 
 MonitorList::~MonitorList() {
@@ -1400,16 +1476,25 @@ MonitorList::~MonitorList() {
 
 void MonitorList::DisallowNewMonitors() {
   CHECK(!kUseReadBarrier);
-  MutexLock mu(Thread::Current(), monitor_list_lock_);
-  allow_new_monitors_ = false;
+  Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, monitor_list_lock_);
+    allow_new_monitors_ = false;
+  }
+  MutexLock mu(self, hash_codes_lock_);
+  allow_hash_codes_ = false;
 }
 
 void MonitorList::AllowNewMonitors() {
   CHECK(!kUseReadBarrier);
   Thread* self = Thread::Current();
-  MutexLock mu(self, monitor_list_lock_);
-  allow_new_monitors_ = true;
-  monitor_add_condition_.Broadcast(self);
+  {
+    MutexLock mu(self, monitor_list_lock_);
+    allow_new_monitors_ = true;
+    monitor_add_condition_.Broadcast(self);
+  }
+  MutexLock mu(self, hash_codes_lock_);
+  allow_hash_codes_ = true;
 }
 
 void MonitorList::BroadcastForNewMonitors() {
@@ -1460,6 +1545,187 @@ size_t MonitorList::Size() {
   return list_.size();
 }
 
+// The threads hashing an object do not look up the table while it is empty. A thread adding the
+// first entries waits for them to finish before checking the object again, so that either it sees
+// the hash code they installed, or they see the entry. The counters are sequentially consistent
+// for this handshake.
+bool MonitorList::BeginHashWithoutTable() {
+  num_hashers_.FetchAndAddSequentiallyConsistent(1u);
+  if (LIKELY(num_hash_codes_.LoadSequentiallyConsistent() == 0u)) {
+    return true;
+  }
+  num_hashers_.FetchAndSubSequentiallyConsistent(1u);
+  return false;
+}
+
+void MonitorList::EndHashWithoutTable() {
+  num_hashers_.FetchAndSubSequentiallyConsistent(1u);
+}
+
+MonitorList::HashCodes::iterator MonitorList::FindHashCode(Thread* self, mirror::Object* obj) {
+  // During the marking of a concurrent copying collection, the mutators see the to-space objects
+  // while the table may still hold their from-space copies.
+  if (kUseReadBarrier && self->GetIsGcMarking() && !hash_codes_updated_) {
+    if (!self->GetWeakRefAccessEnabled()) {
+      // Reading the objects through the read barrier would mark the dead ones. Ask the collector
+      // for the to-space copies instead: the sweeps keep only the thin locked objects, few enough
+      // to scan.
+      gc::collector::ConcurrentCopying* collector =
+          Runtime::Current()->GetHeap()->ConcurrentCopyingCollector();
+      for (auto it = hash_codes_.begin(); it != hash_codes_.end(); ++it) {
+        if (collector->IsMarked(it->first) == obj) {
+          return it;
+        }
+      }
+      return hash_codes_.end();
+    }
+    HashCodes updated;
+    for (const auto& entry : hash_codes_) {
+      updated.emplace(GcRoot<mirror::Object>(entry.first).Read<kWithReadBarrier>(), entry.second);
+    }
+    hash_codes_.swap(updated);
+    hash_codes_updated_ = true;
+  }
+  return hash_codes_.find(obj);
+}
+
+void MonitorList::EraseHashCode(HashCodes::iterator it) {
+  hash_codes_.erase(it);
+  num_hash_codes_.FetchAndSubSequentiallyConsistent(1u);
+}
+
+bool MonitorList::InstallHashCode(Thread* self, mirror::Object* obj, LockWord lw, int32_t* hash) {
+  DCHECK_EQ(lw.GetState(), LockWord::kUnlocked);
+  if (BeginHashWithoutTable()) {
+    LockWord hash_word =
+        LockWord::FromHashCode(mirror::Object::GenerateIdentityHashCode(), lw.GCState());
+    bool installed = obj->CasLockWordWeakRelaxed(lw, hash_word);
+    EndHashWithoutTable();
+    *hash = hash_word.GetHashCode();
+    return installed;
+  }
+  MutexLock mu(self, hash_codes_lock_);
+  auto it = FindHashCode(self, obj);
+  bool found = it != hash_codes_.end();
+  LockWord hash_word = LockWord::FromHashCode(
+      found ? it->second : mirror::Object::GenerateIdentityHashCode(), lw.GCState());
+  if (!obj->CasLockWordWeakRelaxed(lw, hash_word)) {
+    return false;
+  }
+  if (found) {
+    EraseHashCode(it);
+  }
+  *hash = hash_word.GetHashCode();
+  return true;
+}
+
+bool MonitorList::GetThinLockedHashCode(Thread* self,
+                                        mirror::Object* obj,
+                                        int32_t* hash,
+                                        bool* inflate) {
+  *inflate = false;
+  MutexLock mu(self, hash_codes_lock_);
+  auto it = FindHashCode(self, obj);
+  if (it != hash_codes_.end()) {
+    *hash = it->second;
+    return true;
+  }
+  if (obj->GetLockWord(false).GetState() != LockWord::kThinLocked) {
+    return false;
+  }
+  if (UNLIKELY(!CanAddHashCodes())) {
+    *hash = mirror::Object::GenerateIdentityHashCode();
+    *inflate = true;
+    return false;
+  }
+  it = hash_codes_.emplace(obj, mirror::Object::GenerateIdentityHashCode()).first;
+  num_hash_codes_.FetchAndAddSequentiallyConsistent(1u);
+  // The owner may have released the lock and another thread hashed the object without seeing the
+  // entry. The threads hashing without the table are few and quick, wait for them to finish.
+  while (num_hashers_.LoadSequentiallyConsistent() != 0u) {
+    sched_yield();
+  }
+  LockWord lw = obj->GetLockWord(false);
+  switch (lw.GetState()) {
+    case LockWord::kHashCode: {
+      *hash = lw.GetHashCode();
+      EraseHashCode(it);
+      break;
+    }
+    case LockWord::kFatLocked: {
+      Monitor* monitor = lw.FatLockMonitor();
+      monitor->hash_code_.CompareExchangeStrongRelaxed(0, it->second);
+      *hash = monitor->hash_code_.LoadRelaxed();
+      EraseHashCode(it);
+      break;
+    }
+    default: {
+      // Still thin locked, or unlocked with the hash code of the entry to be installed.
+      *hash = it->second;
+      break;
+    }
+  }
+  return true;
+}
+
+void MonitorList::InstallHashCode(Thread* self, Monitor* monitor) {
+  if (BeginHashWithoutTable()) {
+    monitor->hash_code_.CompareExchangeStrongRelaxed(0, mirror::Object::GenerateIdentityHashCode());
+    EndHashWithoutTable();
+    return;
+  }
+  MutexLock mu(self, hash_codes_lock_);
+  auto it = FindHashCode(self, monitor->GetObject());
+  if (it != hash_codes_.end()) {
+    monitor->hash_code_.CompareExchangeStrongRelaxed(0, it->second);
+    EraseHashCode(it);
+  } else {
+    monitor->hash_code_.CompareExchangeStrongRelaxed(0, mirror::Object::GenerateIdentityHashCode());
+  }
+}
+
+void MonitorList::SweepHashCodes(IsMarkedVisitor* visitor) {
+  Thread* self = Thread::Current();
+  MutexLock mu(self, hash_codes_lock_);
+  HashCodes swept;
+  for (const auto& entry : hash_codes_) {
+    mirror::Object* new_obj = visitor->IsMarked(entry.first);
+    if (new_obj == nullptr) {
+      continue;
+    }
+    // Move the hash code out of the table if the lock was released or inflated. The mutators
+    // may change the lock word meanwhile, making the CAS fail and keeping the entry.
+    LockWord lw = new_obj->GetLockWord(false);
+    switch (lw.GetState()) {
+      case LockWord::kUnlocked: {
+        LockWord hash_word = LockWord::FromHashCode(entry.second, lw.GCState());
+        if (new_obj->CasLockWordWeakRelaxed(lw, hash_word)) {
+          continue;
+        }
+        break;
+      }
+      case LockWord::kFatLocked: {
+        Monitor* monitor = lw.FatLockMonitor();
+        monitor->hash_code_.CompareExchangeStrongRelaxed(0, entry.second);
+        continue;
+      }
+      case LockWord::kHashCode:
+        continue;
+      default:
+        break;
+    }
+    swept.emplace(new_obj, entry.second);
+  }
+  hash_codes_.swap(swept);
+  num_hash_codes_.StoreSequentiallyConsistent(hash_codes_.size());
+  hash_codes_updated_ = false;
+}
+
+size_t MonitorList::NumHashCodes() {
+  MutexLock mu(Thread::Current(), hash_codes_lock_);
+  return hash_codes_.size();
+}
+
 class MonitorDeflateVisitor : public IsMarkedVisitor {
  public:
   MonitorDeflateVisitor() : self_(Thread::Current()), deflate_count_(0) {}
@@ -1486,6 +1752,47 @@ size_t MonitorList::DeflateMonitors() {
   return visitor.deflate_count_;
 }
 
+size_t MonitorList::ScanIdleMonitors() {
+  Thread* self = Thread::Current();
+  MutexLock mu(self, monitor_list_lock_);
+  size_t idle_count = 0;
+  for (Monitor* m : list_) {
+    MutexLock mu2(self, m->monitor_lock_);
+    if (m->locked_since_scan_) {
+      m->locked_since_scan_ = false;
+    } else {
+      ++idle_count;
+    }
+  }
+  return idle_count;
+}
+
+class MonitorIdleDeflateVisitor : public IsMarkedVisitor {
+ public:
+  MonitorIdleDeflateVisitor() : self_(Thread::Current()), deflate_count_(0) {}
+
+  virtual mirror::Object* IsMarked(mirror::Object* object) OVERRIDE
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (Monitor::DeflateIfIdle(self_, object)) {
+      DCHECK_NE(object->GetLockWord(true).GetState(), LockWord::kFatLocked);
+      ++deflate_count_;
+      // If we deflated, return null so that the monitor gets removed from the array.
+      return nullptr;
+    }
+    return object;  // Monitor is in use.
+  }
+
+  Thread* const self_;
+  size_t deflate_count_;
+};
+
+size_t MonitorList::DeflateIdleMonitors() {
+  MonitorIdleDeflateVisitor visitor;
+  Locks::mutator_lock_->AssertExclusiveHeld(visitor.self_);
+  SweepMonitorList(&visitor);
+  return visitor.deflate_count_;
+}
+
 MonitorInfo::MonitorInfo(mirror::Object* obj) : owner_(nullptr), entry_count_(0) {
   DCHECK(obj != nullptr);
   LockWord lock_word = obj->GetLockWord(true);
@@ -1503,7 +1810,7 @@ MonitorInfo::MonitorInfo(mirror::Object* obj) : owner_(nullptr), entry_count_(0)
       break;
     case LockWord::kFatLocked: {
       Monitor* mon = lock_word.FatLockMonitor();
-      owner_ = mon->owner_;
+      owner_ = mon->GetOwner();
       entry_count_ = 1 + mon->lock_count_;
       for (Thread* waiter = mon->wait_set_; waiter != nullptr; waiter = waiter->GetWaitNext()) {
         waiters_.push_back(waiter);
@@ -23,6 +23,7 @@
 
 #include <iosfwd>
 #include <list>
+#include <unordered_map>
 #include <vector>
 
 #include "atomic.h"
@@ -114,10 +115,10 @@ class Monitor {
   void SetObject(mirror::Object* object);
 
   Thread* GetOwner() const NO_THREAD_SAFETY_ANALYSIS {
-    return owner_;
+    return owner_.LoadRelaxed();
   }
 
-  int32_t GetHashCode();
+  int32_t GetHashCode() REQUIRES_SHARED(Locks::mutator_lock_);
 
   bool IsLocked() REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!monitor_lock_);
 
@@ -139,6 +140,12 @@ class Monitor {
   static bool Deflate(Thread* self, mirror::Object* obj)
       REQUIRES_SHARED(Locks::mutator_lock_) NO_THREAD_SAFETY_ANALYSIS;
 
+  // Deflate the monitor of obj if it was not locked since the last MonitorList::ScanIdleMonitors().
+  // Returns whether obj has no monitor any more. Mutators must be suspended.
+  // NO_THREAD_SAFETY_ANALYSIS for monitor->monitor_lock_.
+  static bool DeflateIfIdle(Thread* self, mirror::Object* obj)
+      REQUIRES_SHARED(Locks::mutator_lock_) NO_THREAD_SAFETY_ANALYSIS;
+
 #ifndef __LP64__
   void* operator new(size_t size) {
     // Align Monitor* as per the monitor ID field size in the lock word.
@@ -208,6 +215,11 @@ class Monitor {
   void Lock(Thread* self)
       REQUIRES(!monitor_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
+  // Spin with monitor_lock_ released until there is no owner, for up to spin_limit_ iterations,
+  // and adapt spin_limit_ to the outcome. Returns whether the owner released the monitor.
+  bool SpinUntilReleased(Thread* self)
+      REQUIRES(monitor_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
   bool Unlock(Thread* thread)
       REQUIRES(!monitor_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -282,12 +294,20 @@ class Monitor {
   // Number of people waiting on the condition.
   size_t num_waiters_ GUARDED_BY(monitor_lock_);
 
-  // Which thread currently owns the lock?
-  Thread* volatile owner_ GUARDED_BY(monitor_lock_);
+  // Which thread currently owns the lock? Written with monitor_lock_ held, and read without it by
+  // the threads spinning until the lock is released.
+  Atomic<Thread*> owner_;
 
   // Owner's recursive lock depth.
   int lock_count_ GUARDED_BY(monitor_lock_);
 
+  // How long a contender spins before blocking. Grows while spinning sees the owner release the
+  // monitor, that is while the monitor is held for short times, and shrinks otherwise.
+  size_t spin_limit_ GUARDED_BY(monitor_lock_);
+
+  // Whether the monitor was acquired since the last MonitorList::ScanIdleMonitors().
+  bool locked_since_scan_ GUARDED_BY(monitor_lock_);
+
   // What object are we part of. This is a weak root. Do not access
   // this directly, use GetObject() to read it so it will be guarded
   // by a read barrier.
@@ -334,11 +354,70 @@ class MonitorList {
   void BroadcastForNewMonitors() REQUIRES(!monitor_list_lock_);
   // Returns how many monitors were deflated.
   size_t DeflateMonitors() REQUIRES(!monitor_list_lock_) REQUIRES(Locks::mutator_lock_);
+  // Returns how many monitors were not acquired since the previous scan, and starts a new scan.
+  // Does not need the mutators to be suspended.
+  size_t ScanIdleMonitors() REQUIRES(!monitor_list_lock_);
+  // Deflate the monitors that were not acquired since the last scan, leaving the monitors in use
+  // inflated. Returns how many monitors were deflated.
+  size_t DeflateIdleMonitors() REQUIRES(!monitor_list_lock_) REQUIRES(Locks::mutator_lock_);
   size_t Size() REQUIRES(!monitor_list_lock_);
 
+  // The identity hash codes of the objects hashed while thin locked are kept in a table, instead
+  // of inflating the lock to store them in a monitor. The hash code of an object moves from the
+  // table to its lock word or its monitor the next time the object is hashed once unlocked or
+  // inflated, or at the next sweep.
+
+  // Hash the unlocked object obj whose lock word was lw, storing the hash code in the lock word.
+  // Returns false if the lock word changed, for the caller to retry.
+  bool InstallHashCode(Thread* self, mirror::Object* obj, LockWord lw, /* out */ int32_t* hash)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!hash_codes_lock_);
+  // Hash the thin locked object obj, storing the hash code in the table. Returns false if the
+  // lock of obj is no longer thin, for the caller to retry, or if the table cannot take new
+  // entries during the sweep. In that case inflate is set, for the caller to inflate the lock
+  // with the hash code instead of blocking, as the caller may hold a monitor lock.
+  bool GetThinLockedHashCode(Thread* self,
+                             mirror::Object* obj,
+                             /* out */ int32_t* hash,
+                             /* out */ bool* inflate)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!hash_codes_lock_);
+  // Set the hash code of a monitor that has none, moving it from the table if the object of the
+  // monitor was hashed while thin locked.
+  void InstallHashCode(Thread* self, Monitor* monitor)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!hash_codes_lock_);
+  // Sweep the table, also moving the hash codes of the objects no longer thin locked to their
+  // lock word or monitor, so that the table only keeps the objects still thin locked.
+  void SweepHashCodes(IsMarkedVisitor* visitor)
+      REQUIRES(!hash_codes_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
+  size_t NumHashCodes() REQUIRES(!hash_codes_lock_);
+
   typedef std::list<Monitor*, TrackingAllocator<Monitor*, kAllocatorTagMonitorList>> Monitors;
 
  private:
+  typedef std::unordered_map<
+      mirror::Object*,
+      int32_t,
+      std::hash<mirror::Object*>,
+      std::equal_to<mirror::Object*>,
+      TrackingAllocator<std::pair<mirror::Object* const, int32_t>, kAllocatorTagMonitorList>>
+      HashCodes;
+
+  // Whether the hash code of an object with no hash code yet can be installed without looking
+  // up the table, which is the case while it is empty. EndHashWithoutTable() must follow a
+  // successful call.
+  bool BeginHashWithoutTable();
+  void EndHashWithoutTable();
+  // Find the entry of obj, updating the objects of the table to the to-space during a concurrent
+  // copying collection. Does not wait for the weak references to be accessible.
+  HashCodes::iterator FindHashCode(Thread* self, mirror::Object* obj)
+      REQUIRES(hash_codes_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
+  // Whether entries can be added to the table. An object hashed during the sweep of a collector
+  // without read barriers may not be marked, and would lose its entry, as for the monitors added
+  // in Add().
+  bool CanAddHashCodes() REQUIRES(hash_codes_lock_) {
+    return kUseReadBarrier || allow_hash_codes_;
+  }
+  void EraseHashCode(HashCodes::iterator it) REQUIRES(hash_codes_lock_);
+
   // During sweeping we may free an object and on a separate thread have an object created using
   // the newly freed memory. That object may then have its lock-word inflated and a monitor created.
   // If we allow new monitor registration during sweeping this monitor may be incorrectly freed as
@@ -348,6 +427,18 @@ class MonitorList {
   ConditionVariable monitor_add_condition_ GUARDED_BY(monitor_list_lock_);
   Monitors list_ GUARDED_BY(monitor_list_lock_);
 
+  // Separate from monitor_list_lock_, as objects are hashed while holding monitor locks, when
+  // describing the lock a thread waits on for instance.
+  Mutex hash_codes_lock_;
+  bool allow_hash_codes_ GUARDED_BY(hash_codes_lock_);
+  HashCodes hash_codes_ GUARDED_BY(hash_codes_lock_);
+  // Whether the objects of hash_codes_ were updated to the to-space since the last sweep.
+  bool hash_codes_updated_ GUARDED_BY(hash_codes_lock_);
+  // The size of hash_codes_, and the number of threads hashing an object without looking it up,
+  // for the handshake in GetThinLockedHashCode().
+  Atomic<size_t> num_hash_codes_;
+  Atomic<size_t> num_hashers_;
+
   friend class Monitor;
   DISALLOW_COPY_AND_ASSIGN(MonitorList);
 };
@@ -23,11 +23,13 @@
 #include "base/time_utils.h"
 #include "class_linker-inl.h"
 #include "common_runtime_test.h"
+#include "gc/heap.h"
 #include "handle_scope-inl.h"
 #include "mirror/class-inl.h"
 #include "mirror/string-inl.h"  // Strings are easiest to allocate
 #include "object_lock.h"
 #include "scoped_thread_state_change-inl.h"
+#include "thread_list.h"
 #include "thread_pool.h"
 
 namespace art {
@@ -127,8 +129,9 @@ class CreateTask : public Task {
         return;
       }
 
-      // Force a fat lock by running identity hashcode to fill up lock word.
-      monitor_test_->object_.Get()->IdentityHashCode();
+      // Force a fat lock.
+      Monitor::InflateThinLocked(
+          self, Handle<mirror::Object>(monitor_test_->object_), lock_after, 0);
       LockWord lock_after2 = monitor_test_->object_.Get()->GetLockWord(false);
       LockWord::LockState new_state2 = lock_after2.GetState();
 
@@ -427,5 +430,93 @@ TEST_F(MonitorTest, TestTryLock) {
   thread_pool.StopWorkers(self);
 }
 
+TEST_F(MonitorTest, DeflateIdleMonitors) {
+  Thread* const self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  StackHandleScope<1> hs(self);
+  Handle<mirror::Object> obj(
+      hs.NewHandle<mirror::Object>(mirror::String::AllocFromModifiedUtf8(self, "hello, world!")));
+  {
+    // Inflate the lock, and store the hash code in the monitor.
+    ObjectLock<mirror::Object> lock(self, obj);
+    Monitor::InflateThinLocked(self, obj, obj->GetLockWord(true), 0);
+    obj->IdentityHashCode();
+  }
+  ASSERT_EQ(LockWord::kFatLocked, obj->GetLockWord(true).GetState());
+  MonitorList* monitor_list = Runtime::Current()->GetMonitorList();
+
+  // The monitor is acquired again after the scan, it is not idle.
+  monitor_list->ScanIdleMonitors();
+  {
+    ObjectLock<mirror::Object> lock(self, obj);
+  }
+  {
+    ScopedThreadSuspension sts(self, kSuspended);
+    ScopedSuspendAll ssa(__FUNCTION__);
+    monitor_list->DeflateIdleMonitors();
+  }
+  EXPECT_EQ(LockWord::kFatLocked, obj->GetLockWord(true).GetState());
+
+  // The monitor is not acquired after this scan, it is deflated back to its hash code.
+  monitor_list->ScanIdleMonitors();
+  {
+    ScopedThreadSuspension sts(self, kSuspended);
+    ScopedSuspendAll ssa(__FUNCTION__);
+    monitor_list->DeflateIdleMonitors();
+  }
+  EXPECT_EQ(LockWord::kHashCode, obj->GetLockWord(true).GetState());
+}
+
+TEST_F(MonitorTest, HashThinLocked) {
+  Thread* const self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  StackHandleScope<3> hs(self);
+  Handle<mirror::Object> obj(
+      hs.NewHandle<mirror::Object>(mirror::String::AllocFromModifiedUtf8(self, "hello, world!")));
+  Handle<mirror::Object> obj2(
+      hs.NewHandle<mirror::Object>(mirror::String::AllocFromModifiedUtf8(self, "hello, world!")));
+  Handle<mirror::Object> obj3(
+      hs.NewHandle<mirror::Object>(mirror::String::AllocFromModifiedUtf8(self, "hello, world!")));
+  MonitorList* monitor_list = Runtime::Current()->GetMonitorList();
+  int32_t hash;
+  {
+    // Taking the hash code of a thin locked object does not inflate its lock.
+    ObjectLock<mirror::Object> lock(self, obj);
+    hash = obj->IdentityHashCode();
+    EXPECT_EQ(LockWord::kThinLocked, obj->GetLockWord(true).GetState());
+    EXPECT_EQ(1u, monitor_list->NumHashCodes());
+    EXPECT_EQ(hash, obj->IdentityHashCode());
+  }
+  // Once unlocked, the hash code moves to the lock word.
+  EXPECT_EQ(LockWord::kUnlocked, obj->GetLockWord(true).GetState());
+  EXPECT_EQ(hash, obj->IdentityHashCode());
+  EXPECT_EQ(LockWord::kHashCode, obj->GetLockWord(true).GetState());
+  EXPECT_EQ(0u, monitor_list->NumHashCodes());
+
+  int32_t hash2;
+  {
+    // The hash code of a thin locked object survives a collection.
+    ObjectLock<mirror::Object> lock(self, obj2);
+    hash2 = obj2->IdentityHashCode();
+    Runtime::Current()->GetHeap()->CollectGarbage(/* clear_soft_references */ false);
+    EXPECT_EQ(1u, monitor_list->NumHashCodes());
+    EXPECT_EQ(hash2, obj2->IdentityHashCode());
+  }
+  // Once unlocked, a collection moves the hash code to the lock word.
+  Runtime::Current()->GetHeap()->CollectGarbage(/* clear_soft_references */ false);
+  EXPECT_EQ(0u, monitor_list->NumHashCodes());
+  EXPECT_EQ(LockWord::kHashCode, obj2->GetLockWord(true).GetState());
+  EXPECT_EQ(hash2, obj2->IdentityHashCode());
+
+  {
+    // Once inflated, the hash code moves to the monitor.
+    ObjectLock<mirror::Object> lock(self, obj3);
+    int32_t hash3 = obj3->IdentityHashCode();
+    Monitor::InflateThinLocked(self, obj3, obj3->GetLockWord(true), 0);
+    EXPECT_EQ(LockWord::kFatLocked, obj3->GetLockWord(true).GetState());
+    EXPECT_EQ(hash3, obj3->IdentityHashCode());
+    EXPECT_EQ(0u, monitor_list->NumHashCodes());
+  }
+}
 
 }  // namespace art
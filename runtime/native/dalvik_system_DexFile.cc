@@ -203,6 +203,8 @@ static const DexFile* CreateDexFile(JNIEnv* env, std::unique_ptr<MemMap> dex_mem
     return nullptr;
   }
 
+  // There is no oat file for the classes of an in-memory dex file, look them up with a table.
+  dex_file->CreateTypeLookupTable();
   return dex_file.release();
 }
 
@@ -399,6 +399,8 @@ enum class VMDebugRuntimeStatId {
   kArtGcBlockingGcTime,
   kArtGcGcCountRateHistogram,
   kArtGcBlockingGcCountRateHistogram,
+  // "art.gc.metrics", the lines of Heap::DumpGcMetrics().
+  kArtGcMetrics,
   kNumRuntimeStats,
 };
 
@@ -439,6 +441,11 @@ static jobject VMDebug_getRuntimeStatInternal(JNIEnv* env, jclass, jint statId)
       heap->DumpBlockingGcCountRateHistogram(output);
       return env->NewStringUTF(output.str().c_str());
     }
+    case VMDebugRuntimeStatId::kArtGcMetrics: {
+      std::ostringstream output;
+      heap->DumpGcMetrics(output);
+      return env->NewStringUTF(output.str().c_str());
+    }
     default:
       return nullptr;
   }
@@ -505,6 +512,13 @@ static jobjectArray VMDebug_getRuntimeStatsInternal(JNIEnv* env, jclass) {
       return nullptr;
     }
   }
+  {
+    std::ostringstream output;
+    heap->DumpGcMetrics(output);
+    if (!SetRuntimeStatValue(env, result, VMDebugRuntimeStatId::kArtGcMetrics, output.str())) {
+      return nullptr;
+    }
+  }
   return result;
 }
 
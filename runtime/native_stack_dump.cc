@@ -17,10 +17,13 @@
 #include "native_stack_dump.h"
 
 #include <ostream>
+#include <sstream>
 
 #include <stdio.h>
 
 #include "art_method.h"
+#include "base/mutex.h"
+#include "thread-current-inl.h"
 
 // For DumpNativeStack.
 #include <backtrace/Backtrace.h>
@@ -41,17 +44,33 @@
 
 #include "arch/instruction_set.h"
 #include "base/memory_tool.h"
-#include "base/mutex.h"
 #include "base/unix_file/fd_file.h"
 #include "oat_quick_method_header.h"
 #include "os.h"
-#include "thread-current-inl.h"
 #include "utils.h"
 
 #endif
 
 namespace art {
 
+NativeStackSymbolCache::NativeStackSymbolCache()
+    : lock_("native stack symbol cache lock", kNativeStackSymbolCacheLock) {}
+
+bool NativeStackSymbolCache::Lookup(uintptr_t pc, std::string* symbol) {
+  MutexLock mu(Thread::Current(), lock_);
+  auto it = symbols_.find(pc);
+  if (it == symbols_.end()) {
+    return false;
+  }
+  *symbol = it->second;
+  return true;
+}
+
+void NativeStackSymbolCache::Insert(uintptr_t pc, const std::string& symbol) {
+  MutexLock mu(Thread::Current(), lock_);
+  symbols_.emplace(pc, symbol);
+}
+
 #if defined(__linux__)
 
 using android::base::StringPrintf;
@@ -284,7 +303,8 @@ void DumpNativeStack(std::ostream& os,
                      BacktraceMap* existing_map,
                      const char* prefix,
                      ArtMethod* current_method,
-                     void* ucontext_ptr) {
+                     void* ucontext_ptr,
+                     NativeStackSymbolCache* symbol_cache) {
   // b/18119146
   if (RUNNING_ON_MEMORY_TOOL != 0) {
     return;
@@ -329,7 +349,6 @@ void DumpNativeStack(std::ostream& os,
     // after the <RELATIVE_ADDR>. There can be any prefix data before the
     // #XX. <RELATIVE_ADDR> has to be a hex number but with no 0x prefix.
     os << prefix << StringPrintf("#%02zu pc ", it->num);
-    bool try_addr2line = false;
     if (!BacktraceMap::IsValid(it->map)) {
       os << StringPrintf(Is64BitInstructionSet(kRuntimeISA) ? "%016" PRIxPTR "  ???"
                                                             : "%08" PRIxPTR "  ???",
@@ -338,15 +357,30 @@ void DumpNativeStack(std::ostream& os,
       os << StringPrintf(Is64BitInstructionSet(kRuntimeISA) ? "%016" PRIxPTR "  "
                                                             : "%08" PRIxPTR "  ",
                          it->rel_pc);
-      os << it->map.name;
-      os << " (";
       if (!it->func_name.empty()) {
-        os << it->func_name;
-        if (it->func_offset != 0) {
-          os << "+" << it->func_offset;
+        // The text of a frame symbolized by name only depends on its PC.
+        std::string symbol;
+        if (symbol_cache == nullptr || !symbol_cache->Lookup(it->pc, &symbol)) {
+          std::ostringstream symbol_os;
+          symbol_os << it->map.name << " (" << it->func_name;
+          if (it->func_offset != 0) {
+            symbol_os << "+" << it->func_offset;
+          }
+          symbol_os << ")" << std::endl;
+          if (use_addr2line) {
+            Addr2line(it->map.name, it->pc - it->map.start, symbol_os, prefix, &addr2line_state);
+          }
+          symbol = symbol_os.str();
+          if (symbol_cache != nullptr) {
+            symbol_cache->Insert(it->pc, symbol);
+          }
         }
-        try_addr2line = true;
-      } else if (current_method != nullptr &&
+        os << symbol;
+        continue;
+      }
+      os << it->map.name;
+      os << " (";
+      if (current_method != nullptr &&
           Locks::mutator_lock_->IsSharedHeld(Thread::Current()) &&
           PcIsWithinQuickCode(current_method, it->pc)) {
         const void* start_of_code = current_method->GetEntryPointFromQuickCompiledCode();
@@ -358,9 +392,6 @@ void DumpNativeStack(std::ostream& os,
       os << ")";
     }
     os << std::endl;
-    if (try_addr2line && use_addr2line) {
-      Addr2line(it->map.name, it->pc - it->map.start, os, prefix, &addr2line_state);
-    }
   }
 
   if (addr2line_state != nullptr) {
@@ -409,7 +440,8 @@ void DumpNativeStack(std::ostream& os ATTRIBUTE_UNUSED,
                      BacktraceMap* existing_map ATTRIBUTE_UNUSED,
                      const char* prefix ATTRIBUTE_UNUSED,
                      ArtMethod* current_method ATTRIBUTE_UNUSED,
-                     void* ucontext_ptr ATTRIBUTE_UNUSED) {
+                     void* ucontext_ptr ATTRIBUTE_UNUSED,
+                     NativeStackSymbolCache* symbol_cache ATTRIBUTE_UNUSED) {
 }
 
 void DumpKernelStack(std::ostream& os ATTRIBUTE_UNUSED,
@@ -20,8 +20,11 @@
 #include <unistd.h>
 
 #include <iosfwd>
+#include <string>
+#include <unordered_map>
 
 #include "base/macros.h"
+#include "base/mutex.h"
 
 class BacktraceMap;
 
@@ -29,13 +32,34 @@ namespace art {
 
 class ArtMethod;
 
-// Dumps the native stack for thread 'tid' to 'os'.
+// The symbolized native frames of the stacks dumped together with the same prefix, keyed by PC.
+// The threads of a process mostly wait in the same few frames of libc and the runtime, which are
+// then symbolized, e.g. by addr2line, once per dump rather than once per thread.
+class NativeStackSymbolCache {
+ public:
+  NativeStackSymbolCache();
+
+  // Returns whether the frame at pc was symbolized, and if so its text in symbol.
+  bool Lookup(uintptr_t pc, std::string* symbol) REQUIRES(!lock_);
+
+  void Insert(uintptr_t pc, const std::string& symbol) REQUIRES(!lock_);
+
+ private:
+  Mutex lock_ ACQUIRED_AFTER(Locks::abort_lock_);
+  std::unordered_map<uintptr_t, std::string> symbols_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(NativeStackSymbolCache);
+};
+
+// Dumps the native stack for thread 'tid' to 'os'. The frames symbolized by name are looked up
+// in and added to 'symbol_cache', if not null.
 void DumpNativeStack(std::ostream& os,
                      pid_t tid,
                      BacktraceMap* map = nullptr,
                      const char* prefix = "",
                      ArtMethod* current_method = nullptr,
-                     void* ucontext = nullptr)
+                     void* ucontext = nullptr,
+                     NativeStackSymbolCache* symbol_cache = nullptr)
     NO_THREAD_SAFETY_ANALYSIS;
 
 // Dumps the kernel stack for thread 'tid' to 'os'. Note that this is only available on linux-x86.
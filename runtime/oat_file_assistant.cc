@@ -23,6 +23,7 @@
 #include "android-base/stringprintf.h"
 #include "android-base/strings.h"
 
+#include "arch/instruction_set_features.h"
 #include "base/logging.h"
 #include "base/stl_util.h"
 #include "compiler_filter.h"
@@ -448,6 +449,34 @@ bool OatFileAssistant::DexChecksumUpToDate(const OatFile& file, std::string* err
   return true;
 }
 
+// Returns whether the running CPU has the instruction set features the code of `file`
+// was compiled for. Only checked on x86, whose devices mix CPUs with and without
+// SSE4 and AVX, and whose features are reliably found in /proc/cpuinfo.
+//
+// The features of the bitmap are the ones the code generators select instructions on, and
+// only those missing from the CPU reject the file. The features the runtime was built for
+// are taken as present: the boot image and the runtime itself already need them, and a file
+// compiled again would record them again, asking for dexopt on every boot.
+static bool HasInstructionSetFeaturesOf(const OatFile& file) {
+  InstructionSet isa = file.GetOatHeader().GetInstructionSet();
+  if (isa != kRuntimeISA || (isa != kX86 && isa != kX86_64)) {
+    return true;
+  }
+  static const uint32_t available_features_bitmap =
+      InstructionSetFeatures::FromCpuInfo()->AsBitmap() |
+      InstructionSetFeatures::FromCppDefines()->AsBitmap();
+  uint32_t file_features_bitmap = file.GetOatHeader().GetInstructionSetFeaturesBitmap();
+  uint32_t missing_features_bitmap = file_features_bitmap & ~available_features_bitmap;
+  if (missing_features_bitmap != 0) {
+    std::unique_ptr<const InstructionSetFeatures> missing_features(
+        InstructionSetFeatures::FromBitmap(isa, missing_features_bitmap));
+    VLOG(oat) << file.GetLocation() << ": Oat file compiled for instruction set features "
+              << missing_features->GetFeatureString() << " not found in the running CPU";
+    return false;
+  }
+  return true;
+}
+
 OatFileAssistant::OatStatus OatFileAssistant::GivenOatFileStatus(const OatFile& file) {
   // Verify the ART_USE_READ_BARRIER state.
   // TODO: Don't fully reject files due to read barrier state. If they contain
@@ -477,6 +506,13 @@ OatFileAssistant::OatStatus OatFileAssistant::GivenOatFileStatus(const OatFile&
 
   CompilerFilter::Filter current_compiler_filter = file.GetCompilerFilter();
 
+  // Verify the compiled code can run on this CPU. The code compiled for a more capable
+  // CPU than this one would fault on its first unsupported instruction.
+  if (CompilerFilter::IsAotCompilationEnabled(current_compiler_filter) &&
+      !HasInstructionSetFeaturesOf(file)) {
+    return kOatCannotOpen;
+  }
+
   // Verify the image checksum
   if (CompilerFilter::DependsOnImageChecksum(current_compiler_filter)) {
     const ImageInfo* image_info = GetImageInfo();
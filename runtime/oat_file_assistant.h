@@ -232,6 +232,11 @@ class OatFileAssistant {
                            const std::string& dex_location,
                            std::vector<std::unique_ptr<const DexFile>>* out_dex_files);
 
+  // Returns the real path of the dex location, empty if it could not be resolved.
+  const std::string& GetDexLocation() const {
+    return dex_location_;
+  }
+
   // Returns true if there are dex files in the original dex location that can
   // be compiled with dex2oat for this dex location.
   // Returns false if there is no original dex file, or if the original dex
@@ -16,6 +16,8 @@
 
 #include "oat_file_manager.h"
 
+#include <sys/stat.h>
+
 #include <memory>
 #include <queue>
 #include <vector>
@@ -42,6 +44,7 @@
 #include "scoped_thread_state_change-inl.h"
 #include "thread-current-inl.h"
 #include "thread_list.h"
+#include "utils.h"
 #include "well_known_classes.h"
 
 namespace art {
@@ -379,6 +382,68 @@ bool OatFileManager::HasCollisions(const OatFile* oat_file,
   return CollisionCheck(dex_files_loaded, dex_files_unloaded, error_msg);
 }
 
+OatFileManager::FileStat OatFileManager::GetFileStat(const std::string& filename) {
+  FileStat file_stat;
+  struct stat sbuf;
+  if (TEMP_FAILURE_RETRY(stat(filename.c_str(), &sbuf)) == 0) {
+    file_stat.device = static_cast<uint64_t>(sbuf.st_dev);
+    file_stat.inode = static_cast<uint64_t>(sbuf.st_ino);
+    file_stat.size = static_cast<uint64_t>(sbuf.st_size);
+    file_stat.mtime = static_cast<uint64_t>(sbuf.st_mtime);
+  }
+  return file_stat;
+}
+
+std::unique_ptr<const OatFile> OatFileManager::OpenUpToDateOatFile(
+    const std::string& dex_location) {
+  Thread* const self = Thread::Current();
+  UpToDateOatFile up_to_date;
+  {
+    ReaderMutexLock mu(self, *Locks::oat_file_manager_lock_);
+    auto it = up_to_date_oat_files_.find(dex_location);
+    if (it == up_to_date_oat_files_.end()) {
+      return nullptr;
+    }
+    up_to_date = it->second;
+  }
+  std::unique_ptr<const OatFile> oat_file;
+  if (GetFileStat(dex_location) == up_to_date.dex_stat &&
+      GetFileStat(up_to_date.oat_location) == up_to_date.oat_stat &&
+      GetFileStat(GetVdexFilename(up_to_date.oat_location)) == up_to_date.vdex_stat) {
+    std::string error_msg;
+    oat_file.reset(OatFile::Open(up_to_date.oat_location.c_str(),
+                                 up_to_date.oat_location.c_str(),
+                                 nullptr,
+                                 nullptr,
+                                 !Runtime::Current()->IsAotCompiler(),
+                                 /*low_4gb*/false,
+                                 up_to_date.abs_dex_location.c_str(),
+                                 &error_msg));
+    if (oat_file == nullptr) {
+      VLOG(oat) << "Failed to reopen up to date oat file " << up_to_date.oat_location << ": "
+                << error_msg;
+    }
+  }
+  if (oat_file == nullptr) {
+    WriterMutexLock mu(self, *Locks::oat_file_manager_lock_);
+    up_to_date_oat_files_.erase(dex_location);
+  }
+  return oat_file;
+}
+
+void OatFileManager::RecordUpToDateOatFile(const std::string& dex_location,
+                                           const std::string& abs_dex_location,
+                                           const OatFile& oat_file) {
+  UpToDateOatFile up_to_date;
+  up_to_date.abs_dex_location = abs_dex_location;
+  up_to_date.oat_location = oat_file.GetLocation();
+  up_to_date.dex_stat = GetFileStat(dex_location);
+  up_to_date.oat_stat = GetFileStat(up_to_date.oat_location);
+  up_to_date.vdex_stat = GetFileStat(GetVdexFilename(up_to_date.oat_location));
+  WriterMutexLock mu(Thread::Current(), *Locks::oat_file_manager_lock_);
+  up_to_date_oat_files_[dex_location] = std::move(up_to_date);
+}
+
 std::vector<std::unique_ptr<const DexFile>> OatFileManager::OpenDexFilesFromOat(
     const char* dex_location,
     jobject class_loader,
@@ -410,47 +475,56 @@ std::vector<std::unique_ptr<const DexFile>> OatFileManager::OpenDexFilesFromOat(
                                       kRuntimeISA,
                                       !runtime->IsAotCompiler());
 
-  // Lock the target oat location to avoid races generating and loading the
-  // oat file.
+  // Reuse the up to date oat file of a previous load of this dex location if its files did not
+  // change since, rather than checking the dex checksums and the oat files again.
   std::string error_msg;
-  if (!oat_file_assistant.Lock(/*out*/&error_msg)) {
-    // Don't worry too much if this fails. If it does fail, it's unlikely we
-    // can generate an oat file anyway.
-    VLOG(class_linker) << "OatFileAssistant::Lock: " << error_msg;
-  }
+  std::unique_ptr<const OatFile> oat_file = OpenUpToDateOatFile(dex_location);
+  if (oat_file == nullptr) {
+    // Lock the target oat location to avoid races generating and loading the
+    // oat file.
+    if (!oat_file_assistant.Lock(/*out*/&error_msg)) {
+      // Don't worry too much if this fails. If it does fail, it's unlikely we
+      // can generate an oat file anyway.
+      VLOG(class_linker) << "OatFileAssistant::Lock: " << error_msg;
+    }
 
-  const OatFile* source_oat_file = nullptr;
+    if (!oat_file_assistant.IsUpToDate()) {
+      // Update the oat file on disk if we can, based on the --compiler-filter
+      // option derived from the current runtime options.
+      // This may fail, but that's okay. Best effort is all that matters here.
+      // TODO(calin): b/64530081 b/66984396. Pass a null context to verify and compile
+      // secondary dex files in isolation (and avoid to extract/verify the main apk
+      // if it's in the class path). Note this trades correctness for performance
+      // since the resulting slow down is unacceptable in some cases until b/64530081
+      // is fixed.
+      switch (oat_file_assistant.MakeUpToDate(/*profile_changed*/ false,
+                                              /*class_loader_context*/ nullptr,
+                                              /*out*/ &error_msg)) {
+        case OatFileAssistant::kUpdateFailed:
+          LOG(WARNING) << error_msg;
+          break;
 
-  if (!oat_file_assistant.IsUpToDate()) {
-    // Update the oat file on disk if we can, based on the --compiler-filter
-    // option derived from the current runtime options.
-    // This may fail, but that's okay. Best effort is all that matters here.
-    // TODO(calin): b/64530081 b/66984396. Pass a null context to verify and compile
-    // secondary dex files in isolation (and avoid to extract/verify the main apk
-    // if it's in the class path). Note this trades correctness for performance
-    // since the resulting slow down is unacceptable in some cases until b/64530081
-    // is fixed.
-    switch (oat_file_assistant.MakeUpToDate(/*profile_changed*/ false,
-                                            /*class_loader_context*/ nullptr,
-                                            /*out*/ &error_msg)) {
-      case OatFileAssistant::kUpdateFailed:
-        LOG(WARNING) << error_msg;
-        break;
+        case OatFileAssistant::kUpdateNotAttempted:
+          // Avoid spamming the logs if we decided not to attempt making the oat
+          // file up to date.
+          VLOG(oat) << error_msg;
+          break;
 
-      case OatFileAssistant::kUpdateNotAttempted:
-        // Avoid spamming the logs if we decided not to attempt making the oat
-        // file up to date.
-        VLOG(oat) << error_msg;
-        break;
+        case OatFileAssistant::kUpdateSucceeded:
+          // Nothing to do.
+          break;
+      }
+    }
 
-      case OatFileAssistant::kUpdateSucceeded:
-        // Nothing to do.
-        break;
+    // Get the oat file on disk.
+    const bool up_to_date = oat_file_assistant.IsUpToDate();
+    oat_file.reset(oat_file_assistant.GetBestOatFile().release());
+    if (up_to_date && oat_file != nullptr && !oat_file_assistant.GetDexLocation().empty()) {
+      RecordUpToDateOatFile(dex_location, oat_file_assistant.GetDexLocation(), *oat_file);
     }
   }
 
-  // Get the oat file on disk.
-  std::unique_ptr<const OatFile> oat_file(oat_file_assistant.GetBestOatFile().release());
+  const OatFile* source_oat_file = nullptr;
 
   // Prevent oat files from being loaded if no class_loader or dex_elements are provided.
   // This can happen when the deprecated DexFile.<init>(String) is called directly, and it
@@ -590,6 +664,10 @@ std::vector<std::unique_ptr<const DexFile>> OatFileManager::OpenDexFilesFromOat(
           error_msgs->push_back("Failed to open dex files from " + std::string(dex_location)
                                 + " because: " + error_msg);
         }
+        // Without the oat file, build the type lookup tables it would have provided.
+        for (const std::unique_ptr<const DexFile>& dex_file : dex_files) {
+          dex_file->CreateTypeLookupTable();
+        }
       } else {
         error_msgs->push_back("Fallback mode disabled, skipping dex files.");
       }
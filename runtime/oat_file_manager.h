@@ -123,7 +123,49 @@ class OatFileManager {
   const OatFile* FindOpenedOatFileFromOatLocationLocked(const std::string& oat_location) const
       REQUIRES(Locks::oat_file_manager_lock_);
 
+  // The identity of a file on disk, to tell when it is replaced or rewritten. All zero if the
+  // file does not exist.
+  struct FileStat {
+    uint64_t device = 0u;
+    uint64_t inode = 0u;
+    uint64_t size = 0u;
+    uint64_t mtime = 0u;
+
+    bool operator==(const FileStat& other) const {
+      return device == other.device &&
+             inode == other.inode &&
+             size == other.size &&
+             mtime == other.mtime;
+    }
+  };
+
+  static FileStat GetFileStat(const std::string& filename);
+
+  // An oat file that OatFileAssistant found up to date for a dex location, with the files it was
+  // checked against. The oat file stays up to date while none of these files changes.
+  struct UpToDateOatFile {
+    std::string abs_dex_location;
+    std::string oat_location;
+    FileStat dex_stat;
+    FileStat oat_stat;
+    FileStat vdex_stat;
+  };
+
+  // Open again the oat file found up to date for dex_location by a previous load, if its files
+  // did not change since. Returns null otherwise, the caller then asks OatFileAssistant.
+  std::unique_ptr<const OatFile> OpenUpToDateOatFile(const std::string& dex_location)
+      REQUIRES(!Locks::oat_file_manager_lock_);
+
+  void RecordUpToDateOatFile(const std::string& dex_location,
+                             const std::string& abs_dex_location,
+                             const OatFile& oat_file)
+      REQUIRES(!Locks::oat_file_manager_lock_);
+
   std::set<std::unique_ptr<const OatFile>> oat_files_ GUARDED_BY(Locks::oat_file_manager_lock_);
+  // Class loaders are often created over the same paths, each load of a path maps the oat file
+  // again but reuses the up to date decision.
+  std::unordered_map<std::string, UpToDateOatFile> up_to_date_oat_files_
+      GUARDED_BY(Locks::oat_file_manager_lock_);
   bool have_non_pic_oat_file_;
 
   DISALLOW_COPY_AND_ASSIGN(OatFileManager);
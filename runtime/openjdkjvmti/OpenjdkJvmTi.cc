@@ -48,6 +48,7 @@
 #include "scoped_thread_state_change-inl.h"
 #include "thread-current-inl.h"
 #include "thread_list.h"
+#include "ti_allocation_batch.h"
 #include "ti_allocator.h"
 #include "ti_breakpoint.h"
 #include "ti_class.h"
@@ -1184,6 +1185,23 @@ class JvmtiFunctions {
       return error;
     }
 
+    error = add_extension(
+        reinterpret_cast<jvmtiExtensionFunction>(HeapExtensions::GetGcMetrics),
+        "com.android.art.heap.get_gc_metrics",
+        "Retrieve the metrics of the GCs run so far, one \"<name> <value>\" pair per line: the"
+        " pause and duration histograms of each collector and GC cause, the bytes they freed and"
+        " promoted, and the allocation and promotion rates. The metrics are read without"
+        " stopping the GC, and may be polled at any time.",
+        1,
+        {                                                          // NOLINT [whitespace/braces] [4]
+            { "metrics", JVMTI_KIND_ALLOC_BUF, JVMTI_TYPE_CCHAR, false}
+        },
+        1,
+        { JVMTI_ERROR_NULL_POINTER });
+    if (error != ERR(NONE)) {
+      return error;
+    }
+
     error = add_extension(
         reinterpret_cast<jvmtiExtensionFunction>(HeapExtensions::IterateThroughHeapExt),
         "com.android.art.heap.iterate_through_heap_ext",
@@ -1208,6 +1226,31 @@ class JvmtiFunctions {
       return error;
     }
 
+    error = add_extension(
+        reinterpret_cast<jvmtiExtensionFunction>(HeapExtensions::IterateThroughHeapParallel),
+        "com.android.art.heap.iterate_through_heap_parallel",
+        "Iterate through a heap, calling the heap_iteration_callback from several threads at"
+        " once. This is equivalent to the standard IterateThroughHeap function otherwise, except"
+        " that the other callbacks must be null, and that the tags set by the callback are"
+        " visible in the tag table when the function returns. The callback must be thread-safe.",
+        4,
+        {                                                          // NOLINT [whitespace/braces] [4]
+            { "heap_filter", JVMTI_KIND_IN, JVMTI_TYPE_JINT, false},
+            { "klass", JVMTI_KIND_IN, JVMTI_TYPE_JCLASS, true},
+            { "callbacks", JVMTI_KIND_IN_PTR, JVMTI_TYPE_CVOID, false},
+            { "user_data", JVMTI_KIND_IN_PTR, JVMTI_TYPE_CVOID, true}
+        },
+        4,
+        {                                                          // NOLINT [whitespace/braces] [4]
+            JVMTI_ERROR_MUST_POSSESS_CAPABILITY,
+            JVMTI_ERROR_INVALID_CLASS,
+            JVMTI_ERROR_NULL_POINTER,
+            JVMTI_ERROR_ILLEGAL_ARGUMENT
+        });
+    if (error != ERR(NONE)) {
+      return error;
+    }
+
     error = add_extension(
         reinterpret_cast<jvmtiExtensionFunction>(AllocUtil::GetGlobalJvmtiAllocationState),
         "com.android.art.alloc.get_global_jvmti_allocation_state",
@@ -1225,6 +1268,45 @@ class JvmtiFunctions {
       return error;
     }
 
+    error = add_extension(
+        reinterpret_cast<jvmtiExtensionFunction>(
+            AllocationBatchUtil::SetBatchedAllocationCallback),
+        "com.android.art.alloc.set_batched_allocation_callback",
+        "Records the allocations in a buffer of each thread, and calls the callback with the"
+        " classes and sizes of batch_size allocations once a buffer is full. With a positive"
+        " sampling_interval, only the allocations after every sampling_interval bytes allocated by"
+        " a thread are recorded. The callback has the signature void(jvmtiEnv*, JNIEnv*, jint"
+        " count, jclass* classes, jlong* sizes). A null callback stops the batched allocation"
+        " events. Only one environment at a time can have the batched allocation events.",
+        3,
+        {                                                          // NOLINT [whitespace/braces] [4]
+            { "callback", JVMTI_KIND_IN_PTR, JVMTI_TYPE_CVOID, true},
+            { "batch_size", JVMTI_KIND_IN, JVMTI_TYPE_JINT, false},
+            { "sampling_interval", JVMTI_KIND_IN, JVMTI_TYPE_JINT, false}
+        },
+        3,
+        {                                                          // NOLINT [whitespace/braces] [4]
+            JVMTI_ERROR_MUST_POSSESS_CAPABILITY,
+            JVMTI_ERROR_ILLEGAL_ARGUMENT,
+            JVMTI_ERROR_NOT_AVAILABLE
+        });
+    if (error != ERR(NONE)) {
+      return error;
+    }
+
+    error = add_extension(
+        reinterpret_cast<jvmtiExtensionFunction>(AllocationBatchUtil::FlushBatchedAllocations),
+        "com.android.art.alloc.flush_batched_allocations",
+        "Calls the callback of the batched allocation events with the allocations recorded so far"
+        " by all threads, on the calling thread.",
+        0,
+        {},
+        1,
+        { ERR(ILLEGAL_ARGUMENT) });
+    if (error != ERR(NONE)) {
+      return error;
+    }
+
     // Copy into output buffer.
 
     *extension_count_ptr = ext_vector.size();
@@ -1502,6 +1584,7 @@ class JvmtiFunctions {
     gEventHandler.RemoveArtJvmTiEnv(tienv);
     art::Runtime::Current()->RemoveSystemWeakHolder(tienv->object_tag_table.get());
     ThreadUtil::RemoveEnvironment(tienv);
+    AllocationBatchUtil::RemoveEnvironment(tienv);
     delete tienv;
     return OK;
   }
@@ -1722,6 +1805,7 @@ extern "C" bool ArtPlugin_Initialize() {
   MethodUtil::Register(&gEventHandler);
   SearchUtil::Register();
   HeapUtil::Register();
+  AllocationBatchUtil::Register(&gEventHandler);
 
   runtime->GetJavaVM()->AddEnvironmentHook(GetEnvHandler);
 
@@ -1737,6 +1821,7 @@ extern "C" bool ArtPlugin_Deinitialize() {
   MethodUtil::Unregister();
   SearchUtil::Unregister();
   HeapUtil::Unregister();
+  AllocationBatchUtil::Unregister();
 
   return true;
 }
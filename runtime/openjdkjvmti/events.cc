@@ -50,6 +50,7 @@
 #include "scoped_thread_state_change-inl.h"
 #include "thread-inl.h"
 #include "thread_list.h"
+#include "ti_allocation_batch.h"
 #include "ti_phase.h"
 
 namespace openjdkjvmti {
@@ -196,6 +197,10 @@ class JvmtiAllocationListener : public art::gc::AllocationListener {
       OVERRIDE REQUIRES_SHARED(art::Locks::mutator_lock_) {
     DCHECK_EQ(self, art::Thread::Current());
 
+    if (AllocationBatchUtil::IsEnabled()) {
+      AllocationBatchUtil::ObjectAllocated(self, obj, byte_count);
+    }
+
     if (handler_->IsEventEnabledAnywhere(ArtJvmtiEvent::kVmObjectAlloc)) {
       art::StackHandleScope<1> hs(self);
       auto h = hs.NewHandleWrapper(obj);
@@ -588,9 +593,20 @@ static uint32_t GetInstrumentationEventsFor(ArtJvmtiEvent event) {
   }
 }
 
+// The method entry and exit events only need the entry and exit stubs of the instrumentation:
+// compiled code keeps running, and reports them through the stubs. The other events are only
+// reported by the interpreter.
+static constexpr const char* kJvmtiInterpreterKey = "jvmti-tracing";
+static constexpr const char* kJvmtiMethodStubsKey = "jvmti-method-tracing";
+
+static bool NeedsInterpreter(ArtJvmtiEvent event) {
+  return event != ArtJvmtiEvent::kMethodEntry && event != ArtJvmtiEvent::kMethodExit;
+}
+
 static void SetupTraceListener(JvmtiMethodTraceListener* listener,
                                ArtJvmtiEvent event,
-                               bool enable) {
+                               bool enable,
+                               bool last_of_kind) {
   art::ScopedThreadStateChange stsc(art::Thread::Current(), art::ThreadState::kNative);
   uint32_t new_events = GetInstrumentationEventsFor(event);
   art::instrumentation::Instrumentation* instr = art::Runtime::Current()->GetInstrumentation();
@@ -598,23 +614,47 @@ static void SetupTraceListener(JvmtiMethodTraceListener* listener,
                                        art::gc::kGcCauseInstrumentation,
                                        art::gc::kCollectorTypeInstrumentation);
   art::ScopedSuspendAll ssa("jvmti method tracing installation");
+  const bool needs_interpreter = NeedsInterpreter(event);
+  const char* key = needs_interpreter ? kJvmtiInterpreterKey : kJvmtiMethodStubsKey;
   if (enable) {
-    // TODO Depending on the features being used we should be able to avoid deoptimizing everything
-    // like we do here.
-    if (!instr->AreAllMethodsDeoptimized()) {
-      instr->EnableMethodTracing("jvmti-tracing", /*needs_interpreter*/true);
-    }
+    // The level of each key is kept, the highest of them is installed.
+    instr->EnableMethodTracing(key, needs_interpreter);
     instr->AddListener(listener, new_events);
   } else {
     instr->RemoveListener(listener, new_events);
+    if (last_of_kind) {
+      // Give the methods their compiled code back once no event needs the stubs any more.
+      instr->DisableMethodTracing(key);
+    }
+  }
+}
+
+// Are none of the events set up with the same stubs as event enabled?
+bool EventHandler::IsLastTraceEventOfKind(ArtJvmtiEvent event) const {
+  static constexpr ArtJvmtiEvent kTraceEvents[] = {
+      ArtJvmtiEvent::kBreakpoint,
+      ArtJvmtiEvent::kSingleStep,
+      ArtJvmtiEvent::kMethodEntry,
+      ArtJvmtiEvent::kMethodExit,
+      ArtJvmtiEvent::kFieldAccess,
+      ArtJvmtiEvent::kFieldModification,
+  };
+  for (ArtJvmtiEvent other : kTraceEvents) {
+    if (NeedsInterpreter(other) == NeedsInterpreter(event) && IsEventEnabledAnywhere(other)) {
+      return false;
+    }
   }
+  return true;
 }
 
 // Handle special work for the given event type, if necessary.
 void EventHandler::HandleEventType(ArtJvmtiEvent event, bool enable) {
   switch (event) {
     case ArtJvmtiEvent::kVmObjectAlloc:
-      SetupObjectAllocationTracking(alloc_listener_.get(), enable);
+      // The batched allocation events share the allocation listener.
+      if (!AllocationBatchUtil::IsEnabled()) {
+        SetupObjectAllocationTracking(alloc_listener_.get(), enable);
+      }
       return;
 
     case ArtJvmtiEvent::kGarbageCollectionStart:
@@ -629,7 +669,10 @@ void EventHandler::HandleEventType(ArtJvmtiEvent event, bool enable) {
       // We only need to do anything if there isn't already a listener installed/held-on by the
       // other jvmti event that uses DexPcMoved.
       if (!IsEventEnabledAnywhere(other)) {
-        SetupTraceListener(method_trace_listener_.get(), event, enable);
+        SetupTraceListener(method_trace_listener_.get(),
+                           event,
+                           enable,
+                           IsLastTraceEventOfKind(event));
       }
       return;
     }
@@ -637,7 +680,10 @@ void EventHandler::HandleEventType(ArtJvmtiEvent event, bool enable) {
     case ArtJvmtiEvent::kMethodExit:
     case ArtJvmtiEvent::kFieldAccess:
     case ArtJvmtiEvent::kFieldModification:
-      SetupTraceListener(method_trace_listener_.get(), event, enable);
+      SetupTraceListener(method_trace_listener_.get(),
+                         event,
+                         enable,
+                         IsLastTraceEventOfKind(event));
       return;
 
     default:
@@ -753,6 +799,12 @@ jvmtiError EventHandler::SetEvent(ArtJvmTiEnv* env,
   return ERR(NONE);
 }
 
+void EventHandler::HandleBatchedAllocationEvents(bool enable) {
+  if (!IsEventEnabledAnywhere(ArtJvmtiEvent::kVmObjectAlloc)) {
+    SetupObjectAllocationTracking(alloc_listener_.get(), enable);
+  }
+}
+
 void EventHandler::Shutdown() {
   // Need to remove the method_trace_listener_ if it's there.
   art::Thread* self = art::Thread::Current();
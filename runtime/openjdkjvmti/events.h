@@ -148,6 +148,9 @@ class EventHandler {
   // Remove an env.
   void RemoveArtJvmTiEnv(ArtJvmTiEnv* env);
 
+  // Install or remove the allocation listener for the batched allocation events.
+  void HandleBatchedAllocationEvents(bool enable);
+
   bool IsEventEnabledAnywhere(ArtJvmtiEvent event) const {
     if (!EventMask::EventIsInRange(event)) {
       return false;
@@ -210,6 +213,7 @@ class EventHandler {
                                                            unsigned char** new_class_data) const;
 
   void HandleEventType(ArtJvmtiEvent event, bool enable);
+  bool IsLastTraceEventOfKind(ArtJvmtiEvent event) const;
 
   // List of all JvmTiEnv objects that have been created, in their creation order.
   // NB Some elements might be null representing envs that have been deleted. They should be skipped
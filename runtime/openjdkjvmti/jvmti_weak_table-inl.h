@@ -34,7 +34,7 @@
 
 #include "jvmti_weak_table.h"
 
-#include <limits>
+#include <vector>
 
 #include "art_jvmti.h"
 #include "base/logging.h"
@@ -64,7 +64,7 @@ void JvmtiWeakTable<T>::AssertLocked() {
 
 template <typename T>
 void JvmtiWeakTable<T>::UpdateTableWithReadBarrier() {
-  update_since_last_sweep_ = true;
+  update_since_last_sweep_.StoreRelaxed(true);
 
   auto WithReadBarrierUpdater = [&](const art::GcRoot<art::mirror::Object>& original_root,
                                     art::mirror::Object* original_obj ATTRIBUTE_UNUSED)
@@ -88,9 +88,27 @@ bool JvmtiWeakTable<T>::GetTagSlowPath(art::Thread* self, art::mirror::Object* o
 template <typename T>
 bool JvmtiWeakTable<T>::Remove(art::mirror::Object* obj, /* out */ T* tag) {
   art::Thread* self = art::Thread::Current();
+  if (CanUseFastPath(self)) {
+    art::ReaderMutexLock mu(self, table_lock_);
+    Shard& shard = GetShard(obj);
+    art::MutexLock shard_mu(self, shard.lock);
+    auto it = shard.tagged_objects.find(art::GcRoot<art::mirror::Object>(obj));
+    if (it != shard.tagged_objects.end()) {
+      if (tag != nullptr) {
+        *tag = it->second;
+      }
+      shard.tagged_objects.erase(it);
+      return true;
+    }
+    if (!NeedsTableUpdate(self)) {
+      return false;
+    }
+  }
+
   art::MutexLock mu(self, allow_disallow_lock_);
   Wait(self);
 
+  art::WriterMutexLock table_mu(self, table_lock_);
   return RemoveLocked(self, obj, tag);
 }
 template <typename T>
@@ -99,21 +117,23 @@ bool JvmtiWeakTable<T>::RemoveLocked(art::mirror::Object* obj, T* tag) {
   allow_disallow_lock_.AssertHeld(self);
   Wait(self);
 
+  art::WriterMutexLock mu(self, table_lock_);
   return RemoveLocked(self, obj, tag);
 }
 
 template <typename T>
 bool JvmtiWeakTable<T>::RemoveLocked(art::Thread* self, art::mirror::Object* obj, T* tag) {
-  auto it = tagged_objects_.find(art::GcRoot<art::mirror::Object>(obj));
-  if (it != tagged_objects_.end()) {
+  TagMap& tagged_objects = GetShard(obj).tagged_objects;
+  auto it = tagged_objects.find(art::GcRoot<art::mirror::Object>(obj));
+  if (it != tagged_objects.end()) {
     if (tag != nullptr) {
       *tag = it->second;
     }
-    tagged_objects_.erase(it);
+    tagged_objects.erase(it);
     return true;
   }
 
-  if (art::kUseReadBarrier && self->GetIsGcMarking() && !update_since_last_sweep_) {
+  if (NeedsTableUpdate(self)) {
     // Under concurrent GC, there is a window between moving objects and sweeping of system
     // weaks in which mutators are active. We may receive a to-space object pointer in obj,
     // but still have from-space pointers in the table. Explicitly update the table once.
@@ -133,9 +153,25 @@ bool JvmtiWeakTable<T>::RemoveLocked(art::Thread* self, art::mirror::Object* obj
 template <typename T>
 bool JvmtiWeakTable<T>::Set(art::mirror::Object* obj, T new_tag) {
   art::Thread* self = art::Thread::Current();
+  if (CanUseFastPath(self)) {
+    art::ReaderMutexLock mu(self, table_lock_);
+    Shard& shard = GetShard(obj);
+    art::MutexLock shard_mu(self, shard.lock);
+    auto it = shard.tagged_objects.find(art::GcRoot<art::mirror::Object>(obj));
+    if (it != shard.tagged_objects.end()) {
+      it->second = new_tag;
+      return true;
+    }
+    if (!NeedsTableUpdate(self)) {
+      shard.tagged_objects.emplace(art::GcRoot<art::mirror::Object>(obj), new_tag);
+      return false;
+    }
+  }
+
   art::MutexLock mu(self, allow_disallow_lock_);
   Wait(self);
 
+  art::WriterMutexLock table_mu(self, table_lock_);
   return SetLocked(self, obj, new_tag);
 }
 template <typename T>
@@ -144,18 +180,20 @@ bool JvmtiWeakTable<T>::SetLocked(art::mirror::Object* obj, T new_tag) {
   allow_disallow_lock_.AssertHeld(self);
   Wait(self);
 
+  art::WriterMutexLock mu(self, table_lock_);
   return SetLocked(self, obj, new_tag);
 }
 
 template <typename T>
 bool JvmtiWeakTable<T>::SetLocked(art::Thread* self, art::mirror::Object* obj, T new_tag) {
-  auto it = tagged_objects_.find(art::GcRoot<art::mirror::Object>(obj));
-  if (it != tagged_objects_.end()) {
+  TagMap& tagged_objects = GetShard(obj).tagged_objects;
+  auto it = tagged_objects.find(art::GcRoot<art::mirror::Object>(obj));
+  if (it != tagged_objects.end()) {
     it->second = new_tag;
     return true;
   }
 
-  if (art::kUseReadBarrier && self->GetIsGcMarking() && !update_since_last_sweep_) {
+  if (NeedsTableUpdate(self)) {
     // Under concurrent GC, there is a window between moving objects and sweeping of system
     // weaks in which mutators are active. We may receive a to-space object pointer in obj,
     // but still have from-space pointers in the table. Explicitly update the table once.
@@ -169,7 +207,7 @@ bool JvmtiWeakTable<T>::SetLocked(art::Thread* self, art::mirror::Object* obj, T
   }
 
   // New element.
-  auto insert_it = tagged_objects_.emplace(art::GcRoot<art::mirror::Object>(obj), new_tag);
+  auto insert_it = tagged_objects.emplace(art::GcRoot<art::mirror::Object>(obj), new_tag);
   DCHECK(insert_it.second);
   return false;
 }
@@ -188,7 +226,7 @@ void JvmtiWeakTable<T>::Sweep(art::IsMarkedVisitor* visitor) {
   // to ensure we compare against to-space pointers. But we want to do this only once. Once
   // sweeping is done, we know all objects are to-space pointers until the next GC cycle,
   // so we re-enable the explicit update for the next marking.
-  update_since_last_sweep_ = false;
+  update_since_last_sweep_.StoreRelaxed(false);
 }
 
 template <typename T>
@@ -196,6 +234,7 @@ template <bool kHandleNull>
 void JvmtiWeakTable<T>::SweepImpl(art::IsMarkedVisitor* visitor) {
   art::Thread* self = art::Thread::Current();
   art::MutexLock mu(self, allow_disallow_lock_);
+  art::WriterMutexLock table_mu(self, table_lock_);
 
   auto IsMarkedUpdater = [&](const art::GcRoot<art::mirror::Object>& original_root ATTRIBUTE_UNUSED,
                              art::mirror::Object* original_obj) {
@@ -209,38 +248,39 @@ void JvmtiWeakTable<T>::SweepImpl(art::IsMarkedVisitor* visitor) {
 template <typename T>
 template <typename Updater, typename JvmtiWeakTable<T>::TableUpdateNullTarget kTargetNull>
 ALWAYS_INLINE inline void JvmtiWeakTable<T>::UpdateTableWith(Updater& updater) {
-  // We optimistically hope that elements will still be well-distributed when re-inserting them.
-  // So play with the map mechanics, and postpone rehashing. This avoids the need of a side
-  // vector and two passes.
-  float original_max_load_factor = tagged_objects_.max_load_factor();
-  tagged_objects_.max_load_factor(std::numeric_limits<float>::max());
-  // For checking that a max load-factor actually does what we expect.
-  size_t original_bucket_count = tagged_objects_.bucket_count();
-
-  for (auto it = tagged_objects_.begin(); it != tagged_objects_.end();) {
-    DCHECK(!it->first.IsNull());
-    art::mirror::Object* original_obj = it->first.template Read<art::kWithoutReadBarrier>();
-    art::mirror::Object* target_obj = updater(it->first, original_obj);
-    if (original_obj != target_obj) {
-      if (kTargetNull == kIgnoreNull && target_obj == nullptr) {
-        // Ignore null target, don't do anything.
-      } else {
-        T tag = it->second;
-        it = tagged_objects_.erase(it);
-        if (target_obj != nullptr) {
-          tagged_objects_.emplace(art::GcRoot<art::mirror::Object>(target_obj), tag);
-          DCHECK_EQ(original_bucket_count, tagged_objects_.bucket_count());
-        } else if (kTargetNull == kCallHandleNull) {
-          HandleNullSweep(tag);
+  // A moved object usually belongs to another shard. Set the moved objects aside and insert
+  // them once all shards are updated, so that no shard visits the objects it received.
+  std::vector<std::pair<art::mirror::Object*, T>> moved_objects;
+
+  // Walk the shards one at a time, so that the maps updated stay small.
+  for (Shard& shard : shards_) {
+    TagMap& tagged_objects = shard.tagged_objects;
+    for (auto it = tagged_objects.begin(); it != tagged_objects.end();) {
+      DCHECK(!it->first.IsNull());
+      art::mirror::Object* original_obj = it->first.template Read<art::kWithoutReadBarrier>();
+      art::mirror::Object* target_obj = updater(it->first, original_obj);
+      if (original_obj != target_obj) {
+        if (kTargetNull == kIgnoreNull && target_obj == nullptr) {
+          // Ignore null target, don't do anything.
+        } else {
+          T tag = it->second;
+          it = tagged_objects.erase(it);
+          if (target_obj != nullptr) {
+            moved_objects.emplace_back(target_obj, tag);
+          } else if (kTargetNull == kCallHandleNull) {
+            HandleNullSweep(tag);
+          }
+          continue;  // Iterator was implicitly updated by erase.
         }
-        continue;  // Iterator was implicitly updated by erase.
       }
+      it++;
     }
-    it++;
   }
 
-  tagged_objects_.max_load_factor(original_max_load_factor);
-  // TODO: consider rehash here.
+  for (const std::pair<art::mirror::Object*, T>& moved : moved_objects) {
+    GetShard(moved.first).tagged_objects.emplace(art::GcRoot<art::mirror::Object>(moved.first),
+                                                 moved.second);
+  }
 }
 
 template <typename T>
@@ -328,6 +368,7 @@ jvmtiError JvmtiWeakTable<T>::GetTaggedObjects(jvmtiEnv* jvmti_env,
   art::Thread* self = art::Thread::Current();
   art::MutexLock mu(self, allow_disallow_lock_);
   Wait(self);
+  art::WriterMutexLock table_mu(self, table_lock_);
 
   art::JNIEnvExt* jni_env = self->GetJniEnv();
 
@@ -335,8 +376,12 @@ jvmtiError JvmtiWeakTable<T>::GetTaggedObjects(jvmtiEnv* jvmti_env,
   size_t initial_object_size;
   size_t initial_tag_size;
   if (tag_count == 0) {
-    initial_object_size = (object_result_ptr != nullptr) ? tagged_objects_.size() : 0;
-    initial_tag_size = (tag_result_ptr != nullptr) ? tagged_objects_.size() : 0;
+    size_t num_tagged_objects = 0;
+    for (const Shard& shard : shards_) {
+      num_tagged_objects += shard.tagged_objects.size();
+    }
+    initial_object_size = (object_result_ptr != nullptr) ? num_tagged_objects : 0;
+    initial_tag_size = (tag_result_ptr != nullptr) ? num_tagged_objects : 0;
   } else {
     initial_object_size = initial_tag_size = kDefaultSize;
   }
@@ -346,29 +391,31 @@ jvmtiError JvmtiWeakTable<T>::GetTaggedObjects(jvmtiEnv* jvmti_env,
   ReleasableContainer<T, JvmtiAllocator<T>> selected_tags(allocator, initial_tag_size);
 
   size_t count = 0;
-  for (auto& pair : tagged_objects_) {
-    bool select;
-    if (tag_count > 0) {
-      select = false;
-      for (size_t i = 0; i != static_cast<size_t>(tag_count); ++i) {
-        if (tags[i] == pair.second) {
-          select = true;
-          break;
+  for (Shard& shard : shards_) {
+    for (auto& pair : shard.tagged_objects) {
+      bool select;
+      if (tag_count > 0) {
+        select = false;
+        for (size_t i = 0; i != static_cast<size_t>(tag_count); ++i) {
+          if (tags[i] == pair.second) {
+            select = true;
+            break;
+          }
         }
+      } else {
+        select = true;
       }
-    } else {
-      select = true;
-    }
 
-    if (select) {
-      art::mirror::Object* obj = pair.first.template Read<art::kWithReadBarrier>();
-      if (obj != nullptr) {
-        count++;
-        if (object_result_ptr != nullptr) {
-          selected_objects.Pushback(jni_env->AddLocalReference<jobject>(obj));
-        }
-        if (tag_result_ptr != nullptr) {
-          selected_tags.Pushback(pair.second);
+      if (select) {
+        art::mirror::Object* obj = pair.first.template Read<art::kWithReadBarrier>();
+        if (obj != nullptr) {
+          count++;
+          if (object_result_ptr != nullptr) {
+            selected_objects.Pushback(jni_env->AddLocalReference<jobject>(obj));
+          }
+          if (tag_result_ptr != nullptr) {
+            selected_tags.Pushback(pair.second);
+          }
         }
       }
     }
@@ -389,12 +436,15 @@ art::mirror::Object* JvmtiWeakTable<T>::Find(T tag) {
   art::Thread* self = art::Thread::Current();
   art::MutexLock mu(self, allow_disallow_lock_);
   Wait(self);
-
-  for (auto& pair : tagged_objects_) {
-    if (tag == pair.second) {
-      art::mirror::Object* obj = pair.first.template Read<art::kWithReadBarrier>();
-      if (obj != nullptr) {
-        return obj;
+  art::WriterMutexLock table_mu(self, table_lock_);
+
+  for (Shard& shard : shards_) {
+    for (auto& pair : shard.tagged_objects) {
+      if (tag == pair.second) {
+        art::mirror::Object* obj = pair.first.template Read<art::kWithReadBarrier>();
+        if (obj != nullptr) {
+          return obj;
+        }
       }
     }
   }
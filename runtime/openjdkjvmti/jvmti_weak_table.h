@@ -32,8 +32,10 @@
 #ifndef ART_RUNTIME_OPENJDKJVMTI_JVMTI_WEAK_TABLE_H_
 #define ART_RUNTIME_OPENJDKJVMTI_JVMTI_WEAK_TABLE_H_
 
+#include <array>
 #include <unordered_map>
 
+#include "atomic.h"
 #include "base/macros.h"
 #include "base/mutex.h"
 #include "gc/system_weak.h"
@@ -50,11 +52,19 @@ class EventHandler;
 
 // A system-weak container mapping objects to elements of the template type. This corresponds
 // to a weak hash map. For historical reasons the stored value is called "tag."
+//
+// The mappings are split in shards by object address. With the read barrier, while the thread
+// is allowed to access weak references, accessing the mapping of a single object only takes the
+// table lock shared and the lock of its shard, so that threads tagging different objects do not
+// serialize on allow_disallow_lock_. The operations on the whole table (sweeping, updating with
+// read barriers, and the "Locked" coarse-grained accesses) hold allow_disallow_lock_ and the
+// table lock exclusively.
 template <typename T>
 class JvmtiWeakTable : public art::gc::SystemWeakHolder {
  public:
   JvmtiWeakTable()
       : art::gc::SystemWeakHolder(art::kTaggingLockLevel),
+        table_lock_("JVMTI weak table lock", art::kTaggingTableLockLevel),
         update_since_last_sweep_(false) {
   }
 
@@ -62,45 +72,61 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   // value).
   ALWAYS_INLINE bool Remove(art::mirror::Object* obj, /* out */ T* tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(!allow_disallow_lock_);
+      REQUIRES(!allow_disallow_lock_, !table_lock_);
   ALWAYS_INLINE bool RemoveLocked(art::mirror::Object* obj, /* out */ T* tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, !table_lock_);
 
   // Set the mapping for the given object. Returns true if this overwrites an already existing
   // mapping.
   ALWAYS_INLINE virtual bool Set(art::mirror::Object* obj, T tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(!allow_disallow_lock_);
+      REQUIRES(!allow_disallow_lock_, !table_lock_);
   ALWAYS_INLINE virtual bool SetLocked(art::mirror::Object* obj, T tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, !table_lock_);
 
   // Return the value associated with the given object. Returns true if the mapping exists, false
   // otherwise.
   bool GetTag(art::mirror::Object* obj, /* out */ T* result)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(!allow_disallow_lock_) {
+      REQUIRES(!allow_disallow_lock_, !table_lock_) {
     art::Thread* self = art::Thread::Current();
+    if (CanUseFastPath(self)) {
+      art::ReaderMutexLock mu(self, table_lock_);
+      Shard& shard = GetShard(obj);
+      art::MutexLock shard_mu(self, shard.lock);
+      auto it = shard.tagged_objects.find(art::GcRoot<art::mirror::Object>(obj));
+      if (it != shard.tagged_objects.end()) {
+        *result = it->second;
+        return true;
+      }
+      if (!NeedsTableUpdate(self)) {
+        return false;
+      }
+    }
+
     art::MutexLock mu(self, allow_disallow_lock_);
     Wait(self);
 
+    art::WriterMutexLock table_mu(self, table_lock_);
     return GetTagLocked(self, obj, result);
   }
   bool GetTagLocked(art::mirror::Object* obj, /* out */ T* result)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_) {
+      REQUIRES(allow_disallow_lock_, !table_lock_) {
     art::Thread* self = art::Thread::Current();
     allow_disallow_lock_.AssertHeld(self);
     Wait(self);
 
+    art::WriterMutexLock mu(self, table_lock_);
     return GetTagLocked(self, obj, result);
   }
 
   // Sweep the container. DO NOT CALL MANUALLY.
   ALWAYS_INLINE void Sweep(art::IsMarkedVisitor* visitor)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(!allow_disallow_lock_);
+      REQUIRES(!allow_disallow_lock_, !table_lock_);
 
   // Return all objects that have a value mapping in tags.
   ALWAYS_INLINE
@@ -111,7 +137,7 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
                               /* out */ jobject** object_result_ptr,
                               /* out */ T** tag_result_ptr)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(!allow_disallow_lock_);
+      REQUIRES(!allow_disallow_lock_, !table_lock_);
 
   // Locking functions, to allow coarse-grained locking and amortization.
   ALWAYS_INLINE  void Lock() ACQUIRE(allow_disallow_lock_);
@@ -120,7 +146,7 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
 
   ALWAYS_INLINE art::mirror::Object* Find(T tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(!allow_disallow_lock_);
+      REQUIRES(!allow_disallow_lock_, !table_lock_);
 
  protected:
   // Should HandleNullSweep be called when Sweep detects the release of an object?
@@ -131,31 +157,85 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   virtual void HandleNullSweep(T tag ATTRIBUTE_UNUSED) {}
 
  private:
+  // The number of shards of the table. A power of two, to select the shard with a mask.
+  static constexpr size_t kNumShards = 16u;
+
+  struct HashGcRoot {
+    size_t operator()(const art::GcRoot<art::mirror::Object>& r) const
+        REQUIRES_SHARED(art::Locks::mutator_lock_) {
+      return reinterpret_cast<uintptr_t>(r.Read<art::kWithoutReadBarrier>());
+    }
+  };
+
+  struct EqGcRoot {
+    bool operator()(const art::GcRoot<art::mirror::Object>& r1,
+                    const art::GcRoot<art::mirror::Object>& r2) const
+        REQUIRES_SHARED(art::Locks::mutator_lock_) {
+      return r1.Read<art::kWithoutReadBarrier>() == r2.Read<art::kWithoutReadBarrier>();
+    }
+  };
+
+  using TagAllocator = JvmtiAllocator<std::pair<const art::GcRoot<art::mirror::Object>, T>>;
+  using TagMap = std::unordered_map<art::GcRoot<art::mirror::Object>,
+                                    T,
+                                    HashGcRoot,
+                                    EqGcRoot,
+                                    TagAllocator>;
+
+  // The mappings of the objects whose address selects this shard. The map is accessed with the
+  // shard lock held and table_lock_ held shared, or with table_lock_ held exclusively.
+  struct Shard {
+    Shard() : lock("JVMTI weak table shard lock", art::kTaggingShardLockLevel) {}
+
+    art::Mutex lock;
+    TagMap tagged_objects;
+  };
+
+  Shard& GetShard(art::mirror::Object* obj) {
+    // The low bits of an address are the same for all objects, skip them.
+    uintptr_t address = reinterpret_cast<uintptr_t>(obj);
+    return shards_[(address >> art::kObjectAlignmentShift) & (kNumShards - 1u)];
+  }
+
+  // Can the mapping of a single object be accessed without allow_disallow_lock_? With the read
+  // barrier, whether the thread may access weak references only changes at a checkpoint, which
+  // the thread cannot run while it accesses the shard. This is the condition of Wait().
+  ALWAYS_INLINE bool CanUseFastPath(art::Thread* self) const {
+    return art::kUseReadBarrier && self != nullptr && self->GetWeakRefAccessEnabled();
+  }
+
+  // Might the table hold from-space pointers of the objects looked up with to-space pointers?
+  // See the comment on the implementation of GetTagSlowPath.
+  ALWAYS_INLINE bool NeedsTableUpdate(art::Thread* self) const {
+    return art::kUseReadBarrier &&
+           self != nullptr &&
+           self->GetIsGcMarking() &&
+           !update_since_last_sweep_.LoadRelaxed();
+  }
+
   ALWAYS_INLINE
   bool SetLocked(art::Thread* self, art::mirror::Object* obj, T tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, table_lock_);
 
   ALWAYS_INLINE
   bool RemoveLocked(art::Thread* self, art::mirror::Object* obj, /* out */ T* tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, table_lock_);
 
   bool GetTagLocked(art::Thread* self, art::mirror::Object* obj, /* out */ T* result)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_) {
-    auto it = tagged_objects_.find(art::GcRoot<art::mirror::Object>(obj));
-    if (it != tagged_objects_.end()) {
+      REQUIRES(allow_disallow_lock_, table_lock_) {
+    TagMap& tagged_objects = GetShard(obj).tagged_objects;
+    auto it = tagged_objects.find(art::GcRoot<art::mirror::Object>(obj));
+    if (it != tagged_objects.end()) {
       *result = it->second;
       return true;
     }
 
     // Performance optimization: To avoid multiple table updates, ensure that during GC we
     // only update once. See the comment on the implementation of GetTagSlowPath.
-    if (art::kUseReadBarrier &&
-        self != nullptr &&
-        self->GetIsGcMarking() &&
-        !update_since_last_sweep_) {
+    if (NeedsTableUpdate(self)) {
       return GetTagSlowPath(self, obj, result);
     }
 
@@ -167,19 +247,19 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   ALWAYS_INLINE
   bool GetTagSlowPath(art::Thread* self, art::mirror::Object* obj, /* out */ T* result)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, table_lock_);
 
   // Update the table by doing read barriers on each element, ensuring that to-space pointers
   // are stored.
   ALWAYS_INLINE
   void UpdateTableWithReadBarrier()
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, table_lock_);
 
   template <bool kHandleNull>
   void SweepImpl(art::IsMarkedVisitor* visitor)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(!allow_disallow_lock_);
+      REQUIRES(!allow_disallow_lock_, !table_lock_);
 
   enum TableUpdateNullTarget {
     kIgnoreNull,
@@ -190,36 +270,16 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   template <typename Updater, TableUpdateNullTarget kTargetNull>
   void UpdateTableWith(Updater& updater)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, table_lock_);
 
   template <typename Storage, class Allocator = JvmtiAllocator<T>>
   struct ReleasableContainer;
 
-  struct HashGcRoot {
-    size_t operator()(const art::GcRoot<art::mirror::Object>& r) const
-        REQUIRES_SHARED(art::Locks::mutator_lock_) {
-      return reinterpret_cast<uintptr_t>(r.Read<art::kWithoutReadBarrier>());
-    }
-  };
-
-  struct EqGcRoot {
-    bool operator()(const art::GcRoot<art::mirror::Object>& r1,
-                    const art::GcRoot<art::mirror::Object>& r2) const
-        REQUIRES_SHARED(art::Locks::mutator_lock_) {
-      return r1.Read<art::kWithoutReadBarrier>() == r2.Read<art::kWithoutReadBarrier>();
-    }
-  };
-
-  using TagAllocator = JvmtiAllocator<std::pair<const art::GcRoot<art::mirror::Object>, T>>;
-  std::unordered_map<art::GcRoot<art::mirror::Object>,
-                     T,
-                     HashGcRoot,
-                     EqGcRoot,
-                     TagAllocator> tagged_objects_
-      GUARDED_BY(allow_disallow_lock_)
-      GUARDED_BY(art::Locks::mutator_lock_);
+  // Held shared to access the shards of single objects, and exclusively to access the whole table.
+  art::ReaderWriterMutex table_lock_ ACQUIRED_AFTER(allow_disallow_lock_);
+  std::array<Shard, kNumShards> shards_;
   // To avoid repeatedly scanning the whole table, remember if we did that since the last sweep.
-  bool update_since_last_sweep_;
+  art::Atomic<bool> update_since_last_sweep_;
 };
 
 }  // namespace openjdkjvmti
@@ -0,0 +1,409 @@
+/* Copyright (C) 2018 The Android Open Source Project
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This file implements interfaces from the file jvmti.h. This implementation
+ * is licensed under the same terms as the file jvmti.h.  The
+ * copyright and license information for the file jvmti.h follows.
+ *
+ * Copyright (c) 2003, 2011, Oracle and/or its affiliates. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This code is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 only, as
+ * published by the Free Software Foundation.  Oracle designates this
+ * particular file as subject to the "Classpath" exception as provided
+ * by Oracle in the LICENSE file that accompanied this code.
+ *
+ * This code is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * version 2 for more details (a copy is included in the LICENSE file that
+ * accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License version
+ * 2 along with this work; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Please contact Oracle, 500 Oracle Parkway, Redwood Shores, CA 94065 USA
+ * or visit www.oracle.com if you need additional information or have any
+ * questions.
+ */
+
+#include "ti_allocation_batch.h"
+
+#include <pthread.h>
+
+#include <atomic>
+#include <unordered_set>
+#include <vector>
+
+#include "art_jvmti.h"
+#include "base/logging.h"
+#include "events.h"
+#include "gc/system_weak.h"
+#include "gc_root-inl.h"
+#include "handle_scope-inl.h"
+#include "jni_env_ext-inl.h"
+#include "mirror/class.h"
+#include "mirror/object-inl.h"
+#include "nativehelper/ScopedLocalRef.h"
+#include "object_callbacks.h"
+#include "runtime.h"
+#include "runtime_callbacks.h"
+#include "scoped_thread_state_change-inl.h"
+#include "thread-current-inl.h"
+#include "thread_list.h"
+
+namespace openjdkjvmti {
+
+struct AllocationRecord {
+  art::GcRoot<art::mirror::Class> klass;
+  jlong size;
+};
+
+// The allocations recorded by a thread, which only takes the lock of its own buffer to record.
+struct ThreadAllocationBuffer {
+  ThreadAllocationBuffer()
+      : lock("JVMTI allocation buffer lock", art::kAllocationBatchBufferLock),
+        bytes_until_sample(0),
+        flushing(false) {}
+
+  art::Mutex lock;
+  std::vector<AllocationRecord> records GUARDED_BY(lock);
+  // Only accessed by the thread owning the buffer.
+  int64_t bytes_until_sample;
+  bool flushing;
+};
+
+// The buffers of all threads. The classes of the recorded allocations are system weaks: an
+// allocated object may die, and its class be unloaded, before the allocation is delivered.
+class AllocationBatches FINAL : public art::gc::SystemWeakHolder {
+ public:
+  AllocationBatches()
+      : art::gc::SystemWeakHolder(art::kAllocationBatchLock),
+        buffers_lock_("JVMTI allocation buffers lock", art::kAllocationBatchBuffersLock),
+        env_(nullptr),
+        callback_(nullptr),
+        enabled_(false),
+        batch_size_(0u),
+        sampling_interval_(0) {}
+
+  void Register() {
+    CHECK_EQ(pthread_key_create(&buffer_key_, nullptr), 0);
+  }
+
+  void Unregister() REQUIRES(!buffers_lock_) {
+    CHECK_EQ(pthread_key_delete(buffer_key_), 0);
+    art::MutexLock mu(art::Thread::Current(), buffers_lock_);
+    for (ThreadAllocationBuffer* buffer : buffers_) {
+      delete buffer;
+    }
+    buffers_.clear();
+  }
+
+  bool IsEnabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Set the env to deliver the allocations to, or disable the deliveries if env is null.
+  jvmtiError SetTarget(art::Thread* self,
+                       ArtJvmTiEnv* env,
+                       BatchedAllocationCallback callback,
+                       size_t batch_size,
+                       int64_t sampling_interval)
+      REQUIRES(!allow_disallow_lock_, !buffers_lock_) {
+    art::MutexLock mu(self, allow_disallow_lock_);
+    if (env_ != nullptr && env != nullptr && env_ != env) {
+      // Only one env at a time has the batched allocation events.
+      return ERR(NOT_AVAILABLE);
+    }
+    env_ = env;
+    callback_ = callback;
+    batch_size_.store(batch_size, std::memory_order_relaxed);
+    sampling_interval_.store(sampling_interval, std::memory_order_relaxed);
+    enabled_.store(env != nullptr, std::memory_order_relaxed);
+    if (env == nullptr) {
+      // Drop the allocations not delivered yet.
+      art::MutexLock mu2(self, buffers_lock_);
+      for (ThreadAllocationBuffer* buffer : buffers_) {
+        art::MutexLock mu3(self, buffer->lock);
+        buffer->records.clear();
+      }
+    }
+    return OK;
+  }
+
+  bool IsTarget(art::Thread* self, ArtJvmTiEnv* env) REQUIRES(!allow_disallow_lock_) {
+    art::MutexLock mu(self, allow_disallow_lock_);
+    return env_ == env;
+  }
+
+  void ObjectAllocated(art::Thread* self,
+                       art::ObjPtr<art::mirror::Object>* obj,
+                       size_t byte_count)
+      REQUIRES_SHARED(art::Locks::mutator_lock_)
+      REQUIRES(!allow_disallow_lock_, !buffers_lock_) {
+    ThreadAllocationBuffer* buffer = GetBuffer(self);
+    buffer->bytes_until_sample -= static_cast<int64_t>(byte_count);
+    if (buffer->bytes_until_sample > 0) {
+      return;
+    }
+    buffer->bytes_until_sample = sampling_interval_.load(std::memory_order_relaxed);
+
+    bool full;
+    {
+      art::MutexLock mu(self, buffer->lock);
+      buffer->records.push_back(
+          { art::GcRoot<art::mirror::Class>(obj->Ptr()->GetClass()),
+            static_cast<jlong>(byte_count) });
+      full = buffer->records.size() >= batch_size_.load(std::memory_order_relaxed);
+    }
+    // The allocations of the agent during the delivery are recorded for the next batch.
+    if (full && !buffer->flushing) {
+      art::StackHandleScope<1> hs(self);
+      auto h = hs.NewHandleWrapper(obj);
+      buffer->flushing = true;
+      Deliver(self, buffer);
+      buffer->flushing = false;
+    }
+  }
+
+  // Deliver the allocations of buffer, or of all threads if buffer is null.
+  void Deliver(art::Thread* self, ThreadAllocationBuffer* buffer)
+      REQUIRES_SHARED(art::Locks::mutator_lock_)
+      REQUIRES(!allow_disallow_lock_, !buffers_lock_) {
+    art::JNIEnvExt* jni_env = self->GetJniEnv();
+    std::vector<AllocationRecord> records;
+    std::vector<jclass> classes;
+    std::vector<jlong> sizes;
+    ArtJvmTiEnv* env;
+    BatchedAllocationCallback callback;
+    {
+      art::MutexLock mu(self, allow_disallow_lock_);
+      // The classes must not be read while the GC sweeps them.
+      Wait(self);
+      env = env_;
+      callback = callback_;
+      if (env == nullptr) {
+        return;
+      }
+      if (buffer != nullptr) {
+        art::MutexLock mu2(self, buffer->lock);
+        records.swap(buffer->records);
+      } else {
+        art::MutexLock mu2(self, buffers_lock_);
+        for (ThreadAllocationBuffer* thread_buffer : buffers_) {
+          art::MutexLock mu3(self, thread_buffer->lock);
+          records.insert(records.end(),
+                         thread_buffer->records.begin(),
+                         thread_buffer->records.end());
+          thread_buffer->records.clear();
+        }
+      }
+      // Once taken out of the buffers, the classes are only kept by the local references.
+      classes.reserve(records.size());
+      sizes.reserve(records.size());
+      for (const AllocationRecord& record : records) {
+        classes.push_back(jni_env->AddLocalReference<jclass>(record.klass.Read()));
+        sizes.push_back(record.size);
+      }
+    }
+    if (!classes.empty()) {
+      // Like the events with a JNIEnv, stash the pending exception during the callback.
+      ScopedLocalRef<jthrowable> thr(jni_env, jni_env->ExceptionOccurred());
+      jni_env->ExceptionClear();
+      callback(env,
+               jni_env,
+               static_cast<jint>(classes.size()),
+               classes.data(),
+               sizes.data());
+      if (thr.get() != nullptr && !jni_env->ExceptionCheck()) {
+        jni_env->Throw(thr.get());
+      }
+    }
+    for (jclass klass : classes) {
+      if (klass != nullptr) {
+        jni_env->DeleteLocalRef(klass);
+      }
+    }
+  }
+
+  void Sweep(art::IsMarkedVisitor* visitor) OVERRIDE
+      REQUIRES_SHARED(art::Locks::mutator_lock_)
+      REQUIRES(!allow_disallow_lock_, !buffers_lock_) {
+    art::Thread* self = art::Thread::Current();
+    art::MutexLock mu(self, allow_disallow_lock_);
+    art::MutexLock mu2(self, buffers_lock_);
+    for (ThreadAllocationBuffer* buffer : buffers_) {
+      art::MutexLock mu3(self, buffer->lock);
+      SweepRecords(visitor, &buffer->records);
+    }
+  }
+
+  // Deliver the last allocations of a thread, and free its buffer.
+  void ThreadDeath(art::Thread* self)
+      REQUIRES_SHARED(art::Locks::mutator_lock_)
+      REQUIRES(!allow_disallow_lock_, !buffers_lock_) {
+    ThreadAllocationBuffer* buffer =
+        reinterpret_cast<ThreadAllocationBuffer*>(pthread_getspecific(buffer_key_));
+    if (buffer == nullptr) {
+      return;
+    }
+    Deliver(self, buffer);
+    {
+      art::MutexLock mu(self, buffers_lock_);
+      buffers_.erase(buffer);
+    }
+    CHECK_EQ(pthread_setspecific(buffer_key_, nullptr), 0);
+    delete buffer;
+  }
+
+ private:
+  static void SweepRecords(art::IsMarkedVisitor* visitor, std::vector<AllocationRecord>* records)
+      REQUIRES_SHARED(art::Locks::mutator_lock_) {
+    for (AllocationRecord& record : *records) {
+      art::mirror::Class* klass = record.klass.Read<art::kWithoutReadBarrier>();
+      if (klass != nullptr) {
+        art::mirror::Object* marked = visitor->IsMarked(klass);
+        record.klass = art::GcRoot<art::mirror::Class>(
+            marked != nullptr ? marked->AsClass<art::kVerifyNone>() : nullptr);
+      }
+    }
+  }
+
+  ThreadAllocationBuffer* GetBuffer(art::Thread* self) REQUIRES(!buffers_lock_) {
+    ThreadAllocationBuffer* buffer =
+        reinterpret_cast<ThreadAllocationBuffer*>(pthread_getspecific(buffer_key_));
+    if (UNLIKELY(buffer == nullptr)) {
+      buffer = new ThreadAllocationBuffer();
+      buffer->bytes_until_sample = sampling_interval_.load(std::memory_order_relaxed);
+      {
+        art::MutexLock mu(self, buffers_lock_);
+        buffers_.insert(buffer);
+      }
+      CHECK_EQ(pthread_setspecific(buffer_key_, buffer), 0);
+    }
+    return buffer;
+  }
+
+  pthread_key_t buffer_key_;
+
+  // Held after allow_disallow_lock_, and before the locks of the buffers.
+  art::Mutex buffers_lock_ ACQUIRED_AFTER(allow_disallow_lock_);
+  std::unordered_set<ThreadAllocationBuffer*> buffers_ GUARDED_BY(buffers_lock_);
+
+  ArtJvmTiEnv* env_ GUARDED_BY(allow_disallow_lock_);
+  BatchedAllocationCallback callback_ GUARDED_BY(allow_disallow_lock_);
+
+  // Read by the allocating threads without locks.
+  std::atomic<bool> enabled_;
+  std::atomic<size_t> batch_size_;
+  std::atomic<int64_t> sampling_interval_;
+
+  DISALLOW_COPY_AND_ASSIGN(AllocationBatches);
+};
+
+static AllocationBatches gAllocationBatches;
+static EventHandler* gEventHandler = nullptr;
+
+struct AllocationBatchThreadCallback : public art::ThreadLifecycleCallback {
+  void ThreadStart(art::Thread* self ATTRIBUTE_UNUSED) OVERRIDE {}
+
+  void ThreadDeath(art::Thread* self) OVERRIDE REQUIRES_SHARED(art::Locks::mutator_lock_) {
+    gAllocationBatches.ThreadDeath(self);
+  }
+};
+
+static AllocationBatchThreadCallback gAllocationBatchThreadCallback;
+
+void AllocationBatchUtil::Register(EventHandler* event_handler) {
+  art::Runtime* runtime = art::Runtime::Current();
+  gEventHandler = event_handler;
+  gAllocationBatches.Register();
+  runtime->AddSystemWeakHolder(&gAllocationBatches);
+
+  art::ScopedThreadStateChange stsc(art::Thread::Current(),
+                                    art::ThreadState::kWaitingForDebuggerToAttach);
+  art::ScopedSuspendAll ssa("Add allocation batch thread callback");
+  runtime->GetRuntimeCallbacks()->AddThreadLifecycleCallback(&gAllocationBatchThreadCallback);
+}
+
+void AllocationBatchUtil::Unregister() {
+  art::Runtime* runtime = art::Runtime::Current();
+  {
+    art::ScopedThreadStateChange stsc(art::Thread::Current(),
+                                      art::ThreadState::kWaitingForDebuggerToAttach);
+    art::ScopedSuspendAll ssa("Remove allocation batch thread callback");
+    runtime->GetRuntimeCallbacks()->RemoveThreadLifecycleCallback(
+        &gAllocationBatchThreadCallback);
+  }
+  runtime->RemoveSystemWeakHolder(&gAllocationBatches);
+  gAllocationBatches.Unregister();
+  gEventHandler = nullptr;
+}
+
+bool AllocationBatchUtil::IsEnabled() {
+  return gAllocationBatches.IsEnabled();
+}
+
+void AllocationBatchUtil::ObjectAllocated(art::Thread* self,
+                                          art::ObjPtr<art::mirror::Object>* obj,
+                                          size_t byte_count) {
+  gAllocationBatches.ObjectAllocated(self, obj, byte_count);
+}
+
+void AllocationBatchUtil::RemoveEnvironment(ArtJvmTiEnv* env) {
+  art::Thread* self = art::Thread::Current();
+  if (gAllocationBatches.IsTarget(self, env)) {
+    gAllocationBatches.SetTarget(self, nullptr, nullptr, 0u, 0);
+    gEventHandler->HandleBatchedAllocationEvents(false);
+  }
+}
+
+jvmtiError AllocationBatchUtil::SetBatchedAllocationCallback(jvmtiEnv* env,
+                                                             const void* callback,
+                                                             jint batch_size,
+                                                             jint sampling_interval) {
+  ArtJvmTiEnv* art_env = ArtJvmTiEnv::AsArtJvmTiEnv(env);
+  if (art_env->capabilities.can_generate_vm_object_alloc_events != 1) {
+    return ERR(MUST_POSSESS_CAPABILITY);
+  }
+  if (callback != nullptr && (batch_size <= 0 || sampling_interval < 0)) {
+    return ERR(ILLEGAL_ARGUMENT);
+  }
+
+  art::Thread* self = art::Thread::Current();
+  bool was_enabled = gAllocationBatches.IsEnabled();
+  jvmtiError error;
+  if (callback != nullptr) {
+    error = gAllocationBatches.SetTarget(
+        self,
+        art_env,
+        reinterpret_cast<BatchedAllocationCallback>(const_cast<void*>(callback)),
+        static_cast<size_t>(batch_size),
+        static_cast<int64_t>(sampling_interval));
+  } else if (gAllocationBatches.IsTarget(self, art_env)) {
+    error = gAllocationBatches.SetTarget(self, nullptr, nullptr, 0u, 0);
+  } else {
+    error = OK;
+  }
+  if (error != OK) {
+    return error;
+  }
+  if (was_enabled != gAllocationBatches.IsEnabled()) {
+    gEventHandler->HandleBatchedAllocationEvents(!was_enabled);
+  }
+  return OK;
+}
+
+jvmtiError AllocationBatchUtil::FlushBatchedAllocations(jvmtiEnv* env) {
+  art::Thread* self = art::Thread::Current();
+  if (!gAllocationBatches.IsTarget(self, ArtJvmTiEnv::AsArtJvmTiEnv(env))) {
+    return ERR(ILLEGAL_ARGUMENT);
+  }
+  art::ScopedObjectAccess soa(self);
+  gAllocationBatches.Deliver(self, /* buffer */ nullptr);
+  return OK;
+}
+
+}  // namespace openjdkjvmti
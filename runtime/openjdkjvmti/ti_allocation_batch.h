@@ -0,0 +1,94 @@
+/* Copyright (C) 2018 The Android Open Source Project
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This file implements interfaces from the file jvmti.h. This implementation
+ * is licensed under the same terms as the file jvmti.h.  The
+ * copyright and license information for the file jvmti.h follows.
+ *
+ * Copyright (c) 2003, 2011, Oracle and/or its affiliates. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This code is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 only, as
+ * published by the Free Software Foundation.  Oracle designates this
+ * particular file as subject to the "Classpath" exception as provided
+ * by Oracle in the LICENSE file that accompanied this code.
+ *
+ * This code is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * version 2 for more details (a copy is included in the LICENSE file that
+ * accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License version
+ * 2 along with this work; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Please contact Oracle, 500 Oracle Parkway, Redwood Shores, CA 94065 USA
+ * or visit www.oracle.com if you need additional information or have any
+ * questions.
+ */
+
+#ifndef ART_RUNTIME_OPENJDKJVMTI_TI_ALLOCATION_BATCH_H_
+#define ART_RUNTIME_OPENJDKJVMTI_TI_ALLOCATION_BATCH_H_
+
+#include "jni.h"
+#include "jvmti.h"
+
+#include "base/mutex.h"
+#include "obj_ptr.h"
+
+namespace art {
+class Thread;
+namespace mirror {
+class Object;
+}  // namespace mirror
+}  // namespace art
+
+namespace openjdkjvmti {
+
+struct ArtJvmTiEnv;
+class EventHandler;
+
+// The callback of the batched allocation events. The classes and sizes of the count allocations
+// are in classes and sizes. A class unloaded since the allocation is reported as null.
+using BatchedAllocationCallback = void (*)(jvmtiEnv* jvmti_env,
+                                           JNIEnv* jni_env,
+                                           jint count,
+                                           jclass* classes,
+                                           jlong* sizes);
+
+// Batched allocation events. Instead of an event per allocation like VMObjectAlloc, the
+// allocations are recorded in a buffer of the allocating thread, and delivered when the buffer
+// is full or when the agent flushes the buffers.
+class AllocationBatchUtil {
+ public:
+  static void Register(EventHandler* event_handler);
+  static void Unregister();
+
+  // Stop delivering the batched allocation events to the env being disposed.
+  static void RemoveEnvironment(ArtJvmTiEnv* env);
+
+  static bool IsEnabled();
+
+  // Record an allocation, called by the allocation listener of the event handler.
+  static void ObjectAllocated(art::Thread* self,
+                              art::ObjPtr<art::mirror::Object>* obj,
+                              size_t byte_count)
+      REQUIRES_SHARED(art::Locks::mutator_lock_);
+
+  // Deliver the batches of allocations to callback, or stop delivering them if callback is null.
+  // Only the allocations after every sampling_interval bytes of a thread are recorded, all of
+  // them for a sampling interval of 0.
+  static jvmtiError JNICALL SetBatchedAllocationCallback(jvmtiEnv* env,
+                                                         const void* callback,
+                                                         jint batch_size,
+                                                         jint sampling_interval);
+
+  // Deliver the allocations recorded so far by all threads.
+  static jvmtiError JNICALL FlushBatchedAllocations(jvmtiEnv* env);
+};
+
+}  // namespace openjdkjvmti
+
+#endif  // ART_RUNTIME_OPENJDKJVMTI_TI_ALLOCATION_BATCH_H_
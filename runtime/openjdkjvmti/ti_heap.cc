@@ -16,6 +16,9 @@
 
 #include "ti_heap.h"
 
+#include <atomic>
+#include <sstream>
+
 #include "art_field-inl.h"
 #include "art_jvmti.h"
 #include "base/macros.h"
@@ -23,6 +26,7 @@
 #include "class_linker.h"
 #include "gc/heap.h"
 #include "gc/heap-visit-objects-inl.h"
+#include "gc/scoped_gc_critical_section.h"
 #include "gc_root-inl.h"
 #include "java_frame_root_info.h"
 #include "jni_env_ext.h"
@@ -39,6 +43,7 @@
 #include "stack.h"
 #include "thread-inl.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 
 namespace openjdkjvmti {
 
@@ -1487,6 +1492,15 @@ jvmtiError HeapExtensions::GetHeapName(jvmtiEnv* env, jint heap_id, char** heap_
   }
 }
 
+jvmtiError HeapExtensions::GetGcMetrics(jvmtiEnv* env, char** metrics, ...) {
+  if (metrics == nullptr) {
+    return ERR(NULL_POINTER);
+  }
+  std::ostringstream os;
+  art::Runtime::Current()->GetHeap()->DumpGcMetrics(os);
+  return CopyStringAndReturn(env, os.str().c_str(), metrics);
+}
+
 jvmtiError HeapExtensions::IterateThroughHeapExt(jvmtiEnv* env,
                                                  jint heap_filter,
                                                  jclass klass,
@@ -1519,4 +1533,163 @@ jvmtiError HeapExtensions::IterateThroughHeapExt(jvmtiEnv* env,
                               user_data);
 }
 
+namespace {
+
+// An object to report, with the tags it had when the heap was paused.
+struct ParallelHeapObject {
+  art::mirror::Object* obj;
+  jlong tag;
+  jlong class_tag;
+};
+
+// Reports a range of the objects to the heap iteration callback. The tags set by the callback
+// are buffered by the task, and written to the tag table once all the tasks are done.
+class ParallelHeapIterationTask FINAL : public art::Task {
+ public:
+  ParallelHeapIterationTask(const std::vector<ParallelHeapObject>& objects,
+                            size_t begin,
+                            size_t end,
+                            const jvmtiHeapCallbacks* callbacks,
+                            const void* user_data,
+                            std::atomic<bool>* stop_reports)
+      : objects_(objects),
+        begin_(begin),
+        end_(end),
+        callbacks_(callbacks),
+        user_data_(user_data),
+        stop_reports_(stop_reports) {}
+
+  // The world is suspended by the thread which added the task, and which holds the mutator lock
+  // exclusively on behalf of the workers, as during the pauses of the GC.
+  void Run(art::Thread* self ATTRIBUTE_UNUSED) OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    for (size_t i = begin_; i != end_ && !stop_reports_->load(std::memory_order_relaxed); ++i) {
+      const ParallelHeapObject& object = objects_[i];
+      jlong size = object.obj->SizeOf();
+      jint length = -1;
+      if (object.obj->IsArrayInstance()) {
+        length = object.obj->AsArray()->GetLength();
+      }
+      jlong tag = object.tag;
+      jint ret = callbacks_->heap_iteration_callback(object.class_tag,
+                                                     size,
+                                                     &tag,
+                                                     length,
+                                                     const_cast<void*>(user_data_));
+      if (tag != object.tag) {
+        updated_tags_.emplace_back(object.obj, tag);
+      }
+      if ((ret & JVMTI_VISIT_ABORT) != 0) {
+        stop_reports_->store(true, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  const std::vector<std::pair<art::mirror::Object*, jlong>>& GetUpdatedTags() const {
+    return updated_tags_;
+  }
+
+ private:
+  const std::vector<ParallelHeapObject>& objects_;
+  const size_t begin_;
+  const size_t end_;
+  const jvmtiHeapCallbacks* const callbacks_;
+  const void* const user_data_;
+  std::atomic<bool>* const stop_reports_;
+  std::vector<std::pair<art::mirror::Object*, jlong>> updated_tags_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelHeapIterationTask);
+};
+
+}  // namespace
+
+jvmtiError HeapExtensions::IterateThroughHeapParallel(jvmtiEnv* env,
+                                                      jint heap_filter_int,
+                                                      jclass klass,
+                                                      const jvmtiHeapCallbacks* callbacks,
+                                                      const void* user_data) {
+  if (ArtJvmTiEnv::AsArtJvmTiEnv(env)->capabilities.can_tag_objects != 1) {
+    return ERR(MUST_POSSESS_CAPABILITY);
+  }
+  if (callbacks == nullptr) {
+    return ERR(NULL_POINTER);
+  }
+  if (callbacks->heap_iteration_callback == nullptr ||
+      callbacks->string_primitive_value_callback != nullptr ||
+      callbacks->array_primitive_value_callback != nullptr ||
+      callbacks->primitive_field_callback != nullptr) {
+    // The other callbacks would need the tags of the objects they report while the tasks update
+    // them.
+    return ERR(ILLEGAL_ARGUMENT);
+  }
+
+  ObjectTagTable* tag_table = ArtJvmTiEnv::AsArtJvmTiEnv(env)->object_tag_table.get();
+  art::Thread* self = art::Thread::Current();
+  art::gc::Heap* heap = art::Runtime::Current()->GetHeap();
+  // Keep the GC, which shares the thread pool, from running during the iteration.
+  art::gc::ScopedGCCriticalSection gcs(self,
+                                       art::gc::kGcCauseDebugger,
+                                       art::gc::kCollectorTypeDebugger);
+  art::ScopedSuspendAll ssa("IterateThroughHeapParallel", /* long_suspend */ true);
+
+  // Filter the objects and read their tags on this thread, the tag table is not safe to read
+  // while the tags are set. The callbacks are what takes time.
+  const HeapFilter heap_filter(heap_filter_int);
+  art::ObjPtr<art::mirror::Class> filter_klass = klass == nullptr
+      ? nullptr
+      : art::ObjPtr<art::mirror::Class>::DownCast(self->DecodeJObject(klass));
+  std::vector<ParallelHeapObject> objects;
+  auto visitor = [&](art::mirror::Object* obj) REQUIRES(art::Locks::mutator_lock_) {
+    jlong tag = 0;
+    tag_table->GetTag(obj, &tag);
+    jlong class_tag = 0;
+    art::ObjPtr<art::mirror::Class> obj_klass = obj->GetClass();
+    tag_table->GetTag(obj_klass.Ptr(), &class_tag);
+    if (!heap_filter.ShouldReportByHeapFilter(tag, class_tag) ||
+        (filter_klass != nullptr && filter_klass != obj_klass)) {
+      return;
+    }
+    objects.push_back({ obj, tag, class_tag });
+  };
+  heap->VisitObjectsPaused(visitor);
+
+  // Report the objects from the GC thread pool, a few chunks per thread to balance the load.
+  art::ThreadPool* thread_pool = heap->GetThreadPool();
+  const size_t thread_count =
+      (thread_pool == nullptr) ? 1u : heap->GetParallelGCThreadCount() + 1u;
+  static constexpr size_t kMinObjectsPerTask = 1024u;
+  const size_t objects_per_task =
+      std::max(kMinObjectsPerTask, objects.size() / (4u * thread_count) + 1u);
+  std::atomic<bool> stop_reports(false);
+  std::vector<std::unique_ptr<ParallelHeapIterationTask>> tasks;
+  for (size_t begin = 0; begin < objects.size(); begin += objects_per_task) {
+    tasks.emplace_back(new ParallelHeapIterationTask(objects,
+                                                     begin,
+                                                     std::min(begin + objects_per_task,
+                                                              objects.size()),
+                                                     callbacks,
+                                                     user_data,
+                                                     &stop_reports));
+  }
+  if (thread_count > 1u && tasks.size() > 1u) {
+    thread_pool->SetMaxActiveWorkers(thread_count - 1u);
+    for (const std::unique_ptr<ParallelHeapIterationTask>& task : tasks) {
+      thread_pool->AddTask(self, task.get());
+    }
+    thread_pool->StartWorkers(self);
+    thread_pool->Wait(self, /* do_work */ true, /* may_hold_locks */ true);
+    thread_pool->StopWorkers(self);
+  } else {
+    for (const std::unique_ptr<ParallelHeapIterationTask>& task : tasks) {
+      task->Run(self);
+    }
+  }
+
+  for (const std::unique_ptr<ParallelHeapIterationTask>& task : tasks) {
+    for (const std::pair<art::mirror::Object*, jlong>& update : task->GetUpdatedTags()) {
+      tag_table->Set(update.first, update.second);
+    }
+  }
+  return ERR(NONE);
+}
+
 }  // namespace openjdkjvmti
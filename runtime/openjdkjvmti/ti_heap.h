@@ -60,12 +60,19 @@ class HeapExtensions {
  public:
   static jvmtiError JNICALL GetObjectHeapId(jvmtiEnv* env, jlong tag, jint* heap_id, ...);
   static jvmtiError JNICALL GetHeapName(jvmtiEnv* env, jint heap_id, char** heap_name, ...);
+  static jvmtiError JNICALL GetGcMetrics(jvmtiEnv* env, char** metrics, ...);
 
   static jvmtiError JNICALL IterateThroughHeapExt(jvmtiEnv* env,
                                                   jint heap_filter,
                                                   jclass klass,
                                                   const jvmtiHeapCallbacks* callbacks,
                                                   const void* user_data);
+
+  static jvmtiError JNICALL IterateThroughHeapParallel(jvmtiEnv* env,
+                                                       jint heap_filter,
+                                                       jclass klass,
+                                                       const jvmtiHeapCallbacks* callbacks,
+                                                       const void* user_data);
 };
 
 }  // namespace openjdkjvmti
@@ -37,6 +37,7 @@
 #include "dex_file_annotations.h"
 #include "events-inl.h"
 #include "jni_internal.h"
+#include "line_table.h"
 #include "mirror/object_array-inl.h"
 #include "modifiers.h"
 #include "nativehelper/ScopedLocalRef.h"
@@ -327,16 +328,6 @@ jvmtiError MethodUtil::GetMethodModifiers(jvmtiEnv* env ATTRIBUTE_UNUSED,
   return ERR(NONE);
 }
 
-using LineNumberContext = std::vector<jvmtiLineNumberEntry>;
-
-static bool CollectLineNumbers(void* void_context, const art::DexFile::PositionInfo& entry) {
-  LineNumberContext* context = reinterpret_cast<LineNumberContext*>(void_context);
-  jvmtiLineNumberEntry jvmti_entry = { static_cast<jlocation>(entry.address_),
-                                       static_cast<jint>(entry.line_) };
-  context->push_back(jvmti_entry);
-  return false;  // Collect all, no early exit.
-}
-
 jvmtiError MethodUtil::GetLineNumberTable(jvmtiEnv* env,
                                           jmethodID method,
                                           jint* entry_count_ptr,
@@ -347,8 +338,7 @@ jvmtiError MethodUtil::GetLineNumberTable(jvmtiEnv* env,
   art::ArtMethod* art_method = art::jni::DecodeArtMethod(method);
   DCHECK(!art_method->IsRuntimeMethod());
 
-  const art::DexFile::CodeItem* code_item;
-  const art::DexFile* dex_file;
+  const art::LineTable* line_table;
   {
     art::ScopedObjectAccess soa(art::Thread::Current());
 
@@ -362,26 +352,27 @@ jvmtiError MethodUtil::GetLineNumberTable(jvmtiEnv* env,
       return ERR(NULL_POINTER);
     }
 
-    code_item = art_method->GetCodeItem();
-    dex_file = art_method->GetDexFile();
-    DCHECK(code_item != nullptr) << art_method->PrettyMethod() << " " << dex_file->GetLocation();
+    DCHECK(art_method->GetCodeItem() != nullptr)
+        << art_method->PrettyMethod() << " " << art_method->GetDexFile()->GetLocation();
+    // The table built for the stack traces, kept until the class loader is unloaded.
+    line_table = art::LineTable::ForMethod(art_method);
   }
-
-  LineNumberContext context;
-  bool success = dex_file->DecodeDebugPositionInfo(code_item, CollectLineNumbers, &context);
-  if (!success) {
+  if (line_table == nullptr) {
     return ERR(ABSENT_INFORMATION);
   }
 
   unsigned char* data;
-  jlong mem_size = context.size() * sizeof(jvmtiLineNumberEntry);
+  jlong mem_size = line_table->Size() * sizeof(jvmtiLineNumberEntry);
   jvmtiError alloc_error = env->Allocate(mem_size, &data);
   if (alloc_error != ERR(NONE)) {
     return alloc_error;
   }
   *table_ptr = reinterpret_cast<jvmtiLineNumberEntry*>(data);
-  memcpy(*table_ptr, context.data(), mem_size);
-  *entry_count_ptr = static_cast<jint>(context.size());
+  for (size_t i = 0; i != line_table->Size(); ++i) {
+    const art::LineTable::Entry& entry = line_table->GetEntry(i);
+    (*table_ptr)[i] = { static_cast<jlocation>(entry.dex_pc), static_cast<jint>(entry.line) };
+  }
+  *entry_count_ptr = static_cast<jint>(line_table->Size());
 
   return ERR(NONE);
 }
@@ -41,6 +41,7 @@
 #include "base/array_ref.h"
 #include "base/logging.h"
 #include "base/stringpiece.h"
+#include "catch_block_cache.h"
 #include "class_linker-inl.h"
 #include "debugger.h"
 #include "dex_file.h"
@@ -1435,6 +1436,8 @@ void Redefiner::ClassRedefinition::UpdateClass(
   const art::DexFile::ClassDef& class_def = dex_file_->GetClassDef(0);
   UpdateMethods(mclass, new_dex_cache, class_def);
   UpdateFields(mclass);
+  // The catch blocks found in the methods are the ones of their old code.
+  art::CatchBlockCache::InvalidateAll();
 
   // Update the class fields.
   // Need to update class last since the ArtMethod gets its DexFile from the class (which is needed
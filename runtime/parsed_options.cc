@@ -123,6 +123,21 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-XX:TenureThreshold=_")
           .WithType<unsigned int>()
           .IntoKey(M::TenureThreshold)
+      .Define("-XX:GenCopyingPauseGoalMs=_")
+          .WithType<unsigned int>()
+          .IntoKey(M::GenCopyingPauseGoalMs)
+      .Define("-XX:GenerationalCC")
+          .WithValue(true)
+          .IntoKey(M::GenerationalCC)
+      .Define("-XX:RegionSize=_")
+          .WithType<MemoryKiB>()
+          .IntoKey(M::RegionSize)
+      .Define("-XX:RegionEvacuateLivePercent=_")
+          .WithType<unsigned int>().WithRange(0u, 100u)
+          .IntoKey(M::RegionEvacuateLivePercent)
+      .Define("-XX:UseHugePages")
+          .WithValue(true)
+          .IntoKey(M::UseHugePages)
       .Define("-XX:TLABSize=_")
           .WithType<MemoryKiB>()
           .IntoKey(M::TLABSize)
@@ -141,6 +156,9 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-XX:ConcGCThreads=_")
           .WithType<unsigned int>()
           .IntoKey(M::ConcGCThreads)
+      .Define("-XX:GcThreadCpus=_")
+          .WithType<ParseStringList<','>>()  // std::vector<std::string>, split by ,
+          .IntoKey(M::GcThreadCpus)
       .Define("-XX:ConcurrentGCCycleStart=_")
           .WithType<unsigned int>()
           .IntoKey(M::ConcurrentGCCycleStart)
@@ -181,6 +199,12 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
           .WithType<bool>()
           .WithValueMap({{"false", false}, {"true", true}})
           .IntoKey(M::MadviseRandomAccess)
+      .Define("-XX:StartupPageTrace")
+          .WithValue(true)
+          .IntoKey(M::StartupPageTrace)
+      .Define("-XX:DumpStartupTimings")
+          .WithValue(true)
+          .IntoKey(M::DumpStartupTimings)
       .Define("-Xusejit:_")
           .WithType<bool>()
           .WithValueMap({{"false", false}, {"true", true}})
@@ -206,6 +230,21 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-Xjittransitionweight:_")
           .WithType<unsigned int>()
           .IntoKey(M::JITInvokeTransitionWeight)
+      .Define("-Xjitthreads:_")
+          .WithType<unsigned int>()
+          .IntoKey(M::JITThreadCount)
+      .Define("-Xjittiered")
+          .IntoKey(M::JITTieredCompilation)
+      .Define("-Xjitgenerationalcodecache")
+          .IntoKey(M::JITGenerationalCodeCache)
+      .Define("-Xjitwarmstart")
+          .IntoKey(M::JITWarmStart)
+      .Define("-Xjitprecompile")
+          .IntoKey(M::JITPrecompile)
+      .Define("-Xjitcountloops")
+          .IntoKey(M::JITCountLoops)
+      .Define("-Xjitperfdump")
+          .IntoKey(M::JITPerfDump)
       .Define("-Xjitsaveprofilinginfo")
           .WithType<ProfileSaverOptions>()
           .AppendValues()
@@ -255,6 +294,10 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
           .IntoKey(M::BackgroundGc)
       .Define("-XX:+DisableExplicitGC")
           .IntoKey(M::DisableExplicitGC)
+      .Define("-XX:+ForkHeapDump")
+          .IntoKey(M::ForkHeapDump)
+      .Define("-XX:+HprofIndex")
+          .IntoKey(M::HprofIndex)
       .Define("-verbose:_")
           .WithType<LogVerbosity>()
           .IntoKey(M::Verbose)
@@ -339,9 +382,18 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-XX:GcProfAlloc")
           .WithValue(true)
           .IntoKey(M::GcProfAlloc)
+      .Define("-XX:GcProfAllocSampleInterval=_")  // in KB
+          .WithType<unsigned int>()
+          .IntoKey(M::GcProfAllocSampleInterval)
       .Define("-XX:GcProfAtStart")
           .WithValue(true)
           .IntoKey(M::GcProfAtStart)
+      .Define("-XX:GcProfStream")
+          .WithValue(true)
+          .IntoKey(M::GcProfStream)
+      .Define("-XX:GcProfStreamFileSize=_")
+          .WithType<unsigned int>()
+          .IntoKey(M::GcProfStreamFileSize)
       .Define("-Xplugin:_")
           .WithType<std::vector<Plugin>>().AppendValues()
           .IntoKey(M::Plugins)
@@ -544,6 +596,19 @@ bool ParsedOptions::DoParse(const RuntimeOptions& options,
     Exit(0);
   }
 
+  {
+    size_t region_size = args.GetOrDefault(M::RegionSize);
+    if (!IsPowerOfTwo(region_size) ||
+        region_size < gc::Heap::kDefaultRegionSize ||
+        region_size > gc::Heap::kMaxRegionSize) {
+      Usage("-XX:RegionSize=%zu is not a power of two between %zu and %zu",
+            region_size,
+            gc::Heap::kDefaultRegionSize,
+            gc::Heap::kMaxRegionSize);
+      return false;
+    }
+  }
+
   if (args.Exists(M::JitStressMode)) {
     args.Set(M::JITWarmupThreshold, 1U);
     args.Set(M::JITCompileThreshold, 1U);
@@ -760,8 +825,18 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Xbootclasspath-locations:bootclasspath\n"
                        "     (override the dex locations of the -Xbootclasspath files)\n");
   UsageMessage(stream, "  -XX:+DisableExplicitGC\n");
+  UsageMessage(stream, "  -XX:+ForkHeapDump\n");
+  UsageMessage(stream, "  -XX:+HprofIndex\n");
   UsageMessage(stream, "  -XX:ParallelGCThreads=integervalue\n");
+  UsageMessage(stream, "  -Xjitthreads:integervalue\n");
+  UsageMessage(stream, "  -Xjittiered\n");
+  UsageMessage(stream, "  -Xjitgenerationalcodecache\n");
+  UsageMessage(stream, "  -Xjitwarmstart\n");
+  UsageMessage(stream, "  -Xjitprecompile\n");
+  UsageMessage(stream, "  -Xjitcountloops\n");
+  UsageMessage(stream, "  -Xjitperfdump\n");
   UsageMessage(stream, "  -XX:ConcGCThreads=integervalue\n");
+  UsageMessage(stream, "  -XX:GcThreadCpus=cpu,cpu,...\n");
   UsageMessage(stream, "  -XX:MaxSpinsBeforeThinLockInflation=integervalue\n");
   UsageMessage(stream, "  -XX:LongPauseLogThreshold=integervalue\n");
   UsageMessage(stream, "  -XX:LongGCLogThreshold=integervalue\n");
@@ -770,11 +845,17 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -XX:DumpJITInfoOnShutdown\n");
   UsageMessage(stream, "  -XX:IgnoreMaxFootprint\n");
   UsageMessage(stream, "  -XX:UseTLAB\n");
+  UsageMessage(stream, "  -XX:GenerationalCC\n");
+  UsageMessage(stream, "  -XX:RegionSize=N (a power of two between 256K and 4M)\n");
+  UsageMessage(stream, "  -XX:RegionEvacuateLivePercent=integervalue (0 to 100)\n");
+  UsageMessage(stream, "  -XX:UseHugePages\n");
   UsageMessage(stream, "  -XX:BackgroundGC=none\n");
   UsageMessage(stream, "  -XX:LargeObjectSpace={disabled,map,freelist}\n");
   UsageMessage(stream, "  -XX:LargeObjectThreshold=N\n");
   UsageMessage(stream, "  -XX:DumpNativeStackOnSigQuit=booleanvalue\n");
   UsageMessage(stream, "  -XX:MadviseRandomAccess:booleanvalue\n");
+  UsageMessage(stream, "  -XX:StartupPageTrace\n");
+  UsageMessage(stream, "  -XX:DumpStartupTimings\n");
   UsageMessage(stream, "  -XX:SlowDebug={false,true}\n");
   UsageMessage(stream, "  -Xmethod-trace\n");
   UsageMessage(stream, "  -Xmethod-trace-file:filename");
@@ -846,7 +927,10 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -XX:mainThreadStackSize=N\n");
   UsageMessage(stream, "  -XX:GcProfile\n");
   UsageMessage(stream, "  -XGcProfileDir:dirname\n");
+  UsageMessage(stream, "  -XX:GcProfStream\n");
+  UsageMessage(stream, "  -XX:GcProfStreamFileSize=integervalue\n");
   UsageMessage(stream, "  -XX:GcProfAlloc\n");
+  UsageMessage(stream, "  -XX:GcProfAllocSampleInterval=integervalue (in KB)\n");
   UsageMessage(stream, "  -XX:GcProfAtStart\n");
   UsageMessage(stream, "\n");
 
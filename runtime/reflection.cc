@@ -38,6 +38,44 @@ namespace art {
 
 using android::base::StringPrintf;
 
+// Returns the class boxing values of the primitive type, found as the declaring class of its
+// valueOf method. Comparing classes is much cheaper than comparing descriptors, and the boxing
+// classes are final, so that an object is a box of the type if and only if its class is this one.
+static ObjPtr<mirror::Class> GetBoxingClass(Primitive::Type type)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  jmethodID value_of = nullptr;
+  switch (type) {
+    case Primitive::kPrimBoolean:
+      value_of = WellKnownClasses::java_lang_Boolean_valueOf;
+      break;
+    case Primitive::kPrimByte:
+      value_of = WellKnownClasses::java_lang_Byte_valueOf;
+      break;
+    case Primitive::kPrimChar:
+      value_of = WellKnownClasses::java_lang_Character_valueOf;
+      break;
+    case Primitive::kPrimDouble:
+      value_of = WellKnownClasses::java_lang_Double_valueOf;
+      break;
+    case Primitive::kPrimFloat:
+      value_of = WellKnownClasses::java_lang_Float_valueOf;
+      break;
+    case Primitive::kPrimInt:
+      value_of = WellKnownClasses::java_lang_Integer_valueOf;
+      break;
+    case Primitive::kPrimLong:
+      value_of = WellKnownClasses::java_lang_Long_valueOf;
+      break;
+    case Primitive::kPrimShort:
+      value_of = WellKnownClasses::java_lang_Short_valueOf;
+      break;
+    default:
+      LOG(FATAL) << static_cast<int>(type);
+      UNREACHABLE();
+  }
+  return jni::DecodeArtMethod(value_of)->GetDeclaringClass();
+}
+
 class ArgArray {
  public:
   ArgArray(const char* shorty, uint32_t shorty_len)
@@ -255,15 +293,15 @@ class ArgArray {
         }
       }
 
-#define DO_FIRST_ARG(match_descriptor, get_fn, append) { \
+#define DO_FIRST_ARG(boxed_type, get_fn, append) { \
           if (LIKELY(arg != nullptr && \
-              arg->GetClass()->DescriptorEquals(match_descriptor))) { \
+              arg->GetClass() == GetBoxingClass(boxed_type))) { \
             ArtField* primitive_field = arg->GetClass()->GetInstanceField(0); \
             append(primitive_field-> get_fn(arg.Get()));
 
-#define DO_ARG(match_descriptor, get_fn, append) \
+#define DO_ARG(boxed_type, get_fn, append) \
           } else if (LIKELY(arg != nullptr && \
-                            arg->GetClass<>()->DescriptorEquals(match_descriptor))) { \
+                            arg->GetClass<>() == GetBoxingClass(boxed_type))) { \
             ArtField* primitive_field = arg->GetClass()->GetInstanceField(0); \
             append(primitive_field-> get_fn(arg.Get()));
 
@@ -289,54 +327,54 @@ class ArgArray {
           Append(arg.Get());
           break;
         case 'Z':
-          DO_FIRST_ARG("Ljava/lang/Boolean;", GetBoolean, Append)
+          DO_FIRST_ARG(Primitive::kPrimBoolean, GetBoolean, Append)
           DO_FAIL("boolean")
           break;
         case 'B':
-          DO_FIRST_ARG("Ljava/lang/Byte;", GetByte, Append)
+          DO_FIRST_ARG(Primitive::kPrimByte, GetByte, Append)
           DO_FAIL("byte")
           break;
         case 'C':
-          DO_FIRST_ARG("Ljava/lang/Character;", GetChar, Append)
+          DO_FIRST_ARG(Primitive::kPrimChar, GetChar, Append)
           DO_FAIL("char")
           break;
         case 'S':
-          DO_FIRST_ARG("Ljava/lang/Short;", GetShort, Append)
-          DO_ARG("Ljava/lang/Byte;", GetByte, Append)
+          DO_FIRST_ARG(Primitive::kPrimShort, GetShort, Append)
+          DO_ARG(Primitive::kPrimByte, GetByte, Append)
           DO_FAIL("short")
           break;
         case 'I':
-          DO_FIRST_ARG("Ljava/lang/Integer;", GetInt, Append)
-          DO_ARG("Ljava/lang/Character;", GetChar, Append)
-          DO_ARG("Ljava/lang/Short;", GetShort, Append)
-          DO_ARG("Ljava/lang/Byte;", GetByte, Append)
+          DO_FIRST_ARG(Primitive::kPrimInt, GetInt, Append)
+          DO_ARG(Primitive::kPrimChar, GetChar, Append)
+          DO_ARG(Primitive::kPrimShort, GetShort, Append)
+          DO_ARG(Primitive::kPrimByte, GetByte, Append)
           DO_FAIL("int")
           break;
         case 'J':
-          DO_FIRST_ARG("Ljava/lang/Long;", GetLong, AppendWide)
-          DO_ARG("Ljava/lang/Integer;", GetInt, AppendWide)
-          DO_ARG("Ljava/lang/Character;", GetChar, AppendWide)
-          DO_ARG("Ljava/lang/Short;", GetShort, AppendWide)
-          DO_ARG("Ljava/lang/Byte;", GetByte, AppendWide)
+          DO_FIRST_ARG(Primitive::kPrimLong, GetLong, AppendWide)
+          DO_ARG(Primitive::kPrimInt, GetInt, AppendWide)
+          DO_ARG(Primitive::kPrimChar, GetChar, AppendWide)
+          DO_ARG(Primitive::kPrimShort, GetShort, AppendWide)
+          DO_ARG(Primitive::kPrimByte, GetByte, AppendWide)
           DO_FAIL("long")
           break;
         case 'F':
-          DO_FIRST_ARG("Ljava/lang/Float;", GetFloat, AppendFloat)
-          DO_ARG("Ljava/lang/Long;", GetLong, AppendFloat)
-          DO_ARG("Ljava/lang/Integer;", GetInt, AppendFloat)
-          DO_ARG("Ljava/lang/Character;", GetChar, AppendFloat)
-          DO_ARG("Ljava/lang/Short;", GetShort, AppendFloat)
-          DO_ARG("Ljava/lang/Byte;", GetByte, AppendFloat)
+          DO_FIRST_ARG(Primitive::kPrimFloat, GetFloat, AppendFloat)
+          DO_ARG(Primitive::kPrimLong, GetLong, AppendFloat)
+          DO_ARG(Primitive::kPrimInt, GetInt, AppendFloat)
+          DO_ARG(Primitive::kPrimChar, GetChar, AppendFloat)
+          DO_ARG(Primitive::kPrimShort, GetShort, AppendFloat)
+          DO_ARG(Primitive::kPrimByte, GetByte, AppendFloat)
           DO_FAIL("float")
           break;
         case 'D':
-          DO_FIRST_ARG("Ljava/lang/Double;", GetDouble, AppendDouble)
-          DO_ARG("Ljava/lang/Float;", GetFloat, AppendDouble)
-          DO_ARG("Ljava/lang/Long;", GetLong, AppendDouble)
-          DO_ARG("Ljava/lang/Integer;", GetInt, AppendDouble)
-          DO_ARG("Ljava/lang/Character;", GetChar, AppendDouble)
-          DO_ARG("Ljava/lang/Short;", GetShort, AppendDouble)
-          DO_ARG("Ljava/lang/Byte;", GetByte, AppendDouble)
+          DO_FIRST_ARG(Primitive::kPrimDouble, GetDouble, AppendDouble)
+          DO_ARG(Primitive::kPrimFloat, GetFloat, AppendDouble)
+          DO_ARG(Primitive::kPrimLong, GetLong, AppendDouble)
+          DO_ARG(Primitive::kPrimInt, GetInt, AppendDouble)
+          DO_ARG(Primitive::kPrimChar, GetChar, AppendDouble)
+          DO_ARG(Primitive::kPrimShort, GetShort, AppendDouble)
+          DO_ARG(Primitive::kPrimByte, GetByte, AppendDouble)
           DO_FAIL("double")
           break;
 #ifndef NDEBUG
@@ -816,28 +854,28 @@ static bool UnboxPrimitive(ObjPtr<mirror::Object> o,
   ObjPtr<mirror::Class> src_class = nullptr;
   ClassLinker* const class_linker = Runtime::Current()->GetClassLinker();
   ArtField* primitive_field = &klass->GetIFieldsPtr()->At(0);
-  if (klass->DescriptorEquals("Ljava/lang/Boolean;")) {
+  if (klass == GetBoxingClass(Primitive::kPrimBoolean)) {
     src_class = class_linker->FindPrimitiveClass('Z');
     boxed_value.SetZ(primitive_field->GetBoolean(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Byte;")) {
+  } else if (klass == GetBoxingClass(Primitive::kPrimByte)) {
     src_class = class_linker->FindPrimitiveClass('B');
     boxed_value.SetB(primitive_field->GetByte(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Character;")) {
+  } else if (klass == GetBoxingClass(Primitive::kPrimChar)) {
     src_class = class_linker->FindPrimitiveClass('C');
     boxed_value.SetC(primitive_field->GetChar(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Float;")) {
+  } else if (klass == GetBoxingClass(Primitive::kPrimFloat)) {
     src_class = class_linker->FindPrimitiveClass('F');
     boxed_value.SetF(primitive_field->GetFloat(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Double;")) {
+  } else if (klass == GetBoxingClass(Primitive::kPrimDouble)) {
     src_class = class_linker->FindPrimitiveClass('D');
     boxed_value.SetD(primitive_field->GetDouble(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Integer;")) {
+  } else if (klass == GetBoxingClass(Primitive::kPrimInt)) {
     src_class = class_linker->FindPrimitiveClass('I');
     boxed_value.SetI(primitive_field->GetInt(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Long;")) {
+  } else if (klass == GetBoxingClass(Primitive::kPrimLong)) {
     src_class = class_linker->FindPrimitiveClass('J');
     boxed_value.SetJ(primitive_field->GetLong(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Short;")) {
+  } else if (klass == GetBoxingClass(Primitive::kPrimShort)) {
     src_class = class_linker->FindPrimitiveClass('S');
     boxed_value.SetS(primitive_field->GetShort(o));
   } else {
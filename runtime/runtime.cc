@@ -24,6 +24,7 @@
 #endif
 
 #include <signal.h>
+#include <sys/resource.h>
 #include <sys/syscall.h>
 #include "base/memory_tool.h"
 #if defined(__APPLE__)
@@ -63,9 +64,15 @@
 #include "base/enums.h"
 #include "base/stl_util.h"
 #include "base/systrace.h"
+#include "base/timing_logger.h"
 #include "base/unix_file/fd_file.h"
+#ifdef CAPSTONE
+#include "binary_analyzer/autofast_jni_cache.h"
+#include "binary_analyzer/autofast_jni_queue.h"
+#endif
 #include "class_linker-inl.h"
 #include "compiler_callbacks.h"
+#include "contention_profiler.h"
 #ifdef __ANDROID__
 #include "cutils/properties.h"
 #endif
@@ -150,6 +157,7 @@
 #include "sigchain.h"
 #include "signal_catcher.h"
 #include "signal_set.h"
+#include "startup_page_trace.h"
 #include "thread.h"
 #include "thread_list.h"
 #include "ti/agent.h"
@@ -215,6 +223,8 @@ Runtime::Runtime()
       must_relocate_(false),
       is_concurrent_gc_enabled_(true),
       is_explicit_gc_disabled_(false),
+      fork_heap_dump_(false),
+      write_hprof_index_(false),
       dex2oat_enabled_(true),
       image_dex2oat_enabled_(true),
       default_stack_size_(0),
@@ -283,6 +293,10 @@ Runtime::Runtime()
   for (size_t i = 0; i <= static_cast<size_t>(DeoptimizationKind::kLast); ++i) {
     deoptimization_counts_[i] = 0u;
   }
+#ifdef CAPSTONE
+  autofast_jni_cache_.reset(new AutoFastJniCache());
+  autofast_jni_queue_.reset(new AutoFastJniQueue());
+#endif
 }
 
 Runtime::~Runtime() {
@@ -587,8 +601,10 @@ void Runtime::CallExitHook(jint status) {
 void Runtime::SweepSystemWeaks(IsMarkedVisitor* visitor) {
   GetInternTable()->SweepInternTableWeaks(visitor);
   GetMonitorList()->SweepMonitorList(visitor);
+  GetMonitorList()->SweepHashCodes(visitor);
   GetJavaVM()->SweepJniWeakGlobals(visitor);
   GetHeap()->SweepAllocationRecords(visitor);
+  GetHeap()->SweepPretenureTable(visitor);
   if (GetJit() != nullptr) {
     // Visit JIT literal tables. Objects in these tables are classes and strings
     // and only classes can be affected by class unloading. The strings always
@@ -604,6 +620,47 @@ void Runtime::SweepSystemWeaks(IsMarkedVisitor* visitor) {
   }
 }
 
+void Runtime::SweepAndAllowSystemWeaks(IsMarkedVisitor* visitor, TimingLogger* timings) {
+  CHECK(!kUseReadBarrier);
+  {
+    TimingLogger::ScopedTiming t("SweepMonitorList", timings);
+    GetMonitorList()->SweepMonitorList(visitor);
+    GetMonitorList()->SweepHashCodes(visitor);
+    monitor_list_->AllowNewMonitors();
+  }
+  {
+    TimingLogger::ScopedTiming t("SweepJniWeakGlobals", timings);
+    GetJavaVM()->SweepJniWeakGlobals(visitor);
+    java_vm_->AllowNewWeakGlobals();
+  }
+  {
+    TimingLogger::ScopedTiming t("SweepAllocationRecords", timings);
+    GetHeap()->SweepAllocationRecords(visitor);
+    heap_->AllowNewAllocationRecords();
+  }
+  {
+    TimingLogger::ScopedTiming t("SweepPretenureTable", timings);
+    GetHeap()->SweepPretenureTable(visitor);
+  }
+  if (GetJit() != nullptr) {
+    TimingLogger::ScopedTiming t("SweepJitRootTables", timings);
+    GetJit()->GetCodeCache()->SweepRootTables(visitor);
+    GetJit()->GetCodeCache()->AllowInlineCacheAccess();
+  }
+  {
+    TimingLogger::ScopedTiming t("SweepSystemWeakHolders", timings);
+    for (gc::AbstractSystemWeakHolder* holder : system_weak_holders_) {
+      holder->Sweep(visitor);
+      holder->Allow();
+    }
+  }
+  {
+    TimingLogger::ScopedTiming t("SweepInternTableWeaks", timings);
+    GetInternTable()->SweepInternTableWeaks(visitor);
+    intern_table_->ChangeWeakRootState(gc::kWeakRootStateNormal);
+  }
+}
+
 bool Runtime::ParseOptions(const RuntimeOptions& raw_options,
                            bool ignore_unrecognized,
                            RuntimeArgumentMap* runtime_options) {
@@ -624,6 +681,62 @@ static bool IsSafeToCallAbort() NO_THREAD_SAFETY_ANALYSIS {
   return runtime != nullptr && runtime->IsStarted() && !runtime->IsShuttingDownLocked();
 }
 
+class Runtime::ScopedStartupPhase {
+ public:
+  ScopedStartupPhase(Runtime* runtime, const char* name)
+      : runtime_(runtime), name_(name), minor_faults_(0u), major_faults_(0u) {
+    if (runtime_->startup_timings_ != nullptr) {
+      GetFaults(&minor_faults_, &major_faults_);
+      runtime_->startup_timings_->StartTiming(name_);
+    }
+  }
+
+  ~ScopedStartupPhase() {
+    End();
+  }
+
+  // Ends the current phase and starts a new one.
+  void NewPhase(const char* name) {
+    End();
+    name_ = name;
+    if (runtime_->startup_timings_ != nullptr) {
+      GetFaults(&minor_faults_, &major_faults_);
+      runtime_->startup_timings_->StartTiming(name_);
+    }
+  }
+
+  // Ends the current phase, if it was not ended yet.
+  void End() {
+    if (runtime_->startup_timings_ != nullptr && name_ != nullptr) {
+      runtime_->startup_timings_->EndTiming();
+      uint64_t minor_faults;
+      uint64_t major_faults;
+      GetFaults(&minor_faults, &major_faults);
+      runtime_->startup_phase_faults_.push_back(
+          { name_, minor_faults - minor_faults_, major_faults - major_faults_ });
+    }
+    name_ = nullptr;
+  }
+
+ private:
+  static void GetFaults(uint64_t* minor_faults, uint64_t* major_faults) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+      usage.ru_minflt = 0;
+      usage.ru_majflt = 0;
+    }
+    *minor_faults = static_cast<uint64_t>(usage.ru_minflt);
+    *major_faults = static_cast<uint64_t>(usage.ru_majflt);
+  }
+
+  Runtime* const runtime_;
+  const char* name_;
+  uint64_t minor_faults_;
+  uint64_t major_faults_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedStartupPhase);
+};
+
 bool Runtime::Create(RuntimeArgumentMap&& runtime_options) {
   // TODO: acquire a static mutex on Runtime to avoid racing.
   if (Runtime::instance_ != nullptr) {
@@ -730,6 +843,9 @@ bool Runtime::Start() {
 
   started_ = true;
 
+  ScopedStartupPhase start_phase(this, "Runtime::Start");
+  ScopedStartupPhase phase(this, "InitNativeMethods");
+
   if (!IsImageDex2OatEnabled() || !GetHeap()->HasBootImageSpace()) {
     ScopedObjectAccess soa(self);
     StackHandleScope<2> hs(soa.Self());
@@ -750,6 +866,7 @@ bool Runtime::Start() {
   }
 
   // Initialize well known thread group values that may be accessed threads while attaching.
+  phase.NewPhase("FinishStartup");
   InitThreadGroups(self);
 
   Thread::FinishStartup();
@@ -761,6 +878,7 @@ bool Runtime::Start() {
   // TODO(calin): We use the JIT class as a proxy for JIT compilation and for
   // recoding profiles. Maybe we should consider changing the name to be more clear it's
   // not only about compiling. b/28295073.
+  phase.NewPhase("Jit");
   if (jit_options_->UseJitCompilation() || jit_options_->GetSaveProfilingInfo()) {
     std::string error_msg;
     if (!IsZygote()) {
@@ -782,8 +900,10 @@ bool Runtime::Start() {
     callbacks_->NextRuntimePhase(RuntimePhaseCallback::RuntimePhase::kStart);
   }
 
+  phase.NewPhase("SystemClassLoader");
   system_class_loader_ = CreateSystemClassLoader(this);
 
+  phase.NewPhase("InitNonZygoteOrPostFork");
   if (!is_zygote_) {
     if (is_native_bridge_loaded_) {
       PreInitializeNativeBridge(".");
@@ -804,6 +924,7 @@ bool Runtime::Start() {
     callbacks_->NextRuntimePhase(RuntimePhaseCallback::RuntimePhase::kInit);
   }
 
+  phase.NewPhase("StartDaemonThreads");
   StartDaemonThreads();
 
   {
@@ -811,6 +932,10 @@ bool Runtime::Start() {
     self->GetJniEnv()->locals.AssertEmpty();
   }
 
+  // The timeline is complete before finished_starting_ lets DumpForSigQuit() read it.
+  phase.End();
+  start_phase.End();
+
   VLOG(startup) << "Runtime::Start exiting";
   finished_starting_ = true;
 
@@ -1094,6 +1219,11 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   ScopedTrace trace(__FUNCTION__);
   CHECK_EQ(sysconf(_SC_PAGE_SIZE), kPageSize);
 
+  if (runtime_options.GetOrDefault(Opt::DumpStartupTimings)) {
+    startup_timings_.reset(new TimingLogger("Startup", /* precise */ true, /* verbose */ false));
+  }
+  ScopedStartupPhase init_phase(this, "Runtime::Init");
+
   MemMap::Init();
 
   // Try to reserve a dedicated fault page. This is allocated for clobbered registers and sentinels.
@@ -1140,6 +1270,8 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   must_relocate_ = runtime_options.GetOrDefault(Opt::Relocate);
   is_zygote_ = runtime_options.Exists(Opt::Zygote);
   is_explicit_gc_disabled_ = runtime_options.Exists(Opt::DisableExplicitGC);
+  fork_heap_dump_ = runtime_options.Exists(Opt::ForkHeapDump);
+  write_hprof_index_ = runtime_options.Exists(Opt::HprofIndex);
   dex2oat_enabled_ = runtime_options.GetOrDefault(Opt::Dex2Oat);
   image_dex2oat_enabled_ = runtime_options.GetOrDefault(Opt::ImageDex2Oat);
   dump_native_stack_on_sig_quit_ = runtime_options.GetOrDefault(Opt::DumpNativeStackOnSigQuit);
@@ -1195,6 +1327,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   experimental_flags_ = runtime_options.GetOrDefault(Opt::Experimental);
   is_low_memory_mode_ = runtime_options.Exists(Opt::LowMemoryMode);
   madvise_random_access_ = runtime_options.GetOrDefault(Opt::MadviseRandomAccess);
+  startup_page_trace_ = runtime_options.GetOrDefault(Opt::StartupPageTrace);
 
   plugins_ = runtime_options.ReleaseOrDefault(Opt::Plugins);
   agents_ = runtime_options.ReleaseOrDefault(Opt::AgentPath);
@@ -1218,6 +1351,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   enable_succ_alloc_profile_ = runtime_options.GetOrDefault(Opt::GcProfAlloc);
   enable_gcprofile_at_start_ = runtime_options.GetOrDefault(Opt::GcProfAtStart);
 
+  ScopedStartupPhase phase(this, "Heap");
   heap_ = new gc::Heap(runtime_options.GetOrDefault(Opt::MemoryInitialSize),
                        runtime_options.GetOrDefault(Opt::HeapGrowthLimit),
                        runtime_options.GetOrDefault(Opt::HeapMinFree),
@@ -1252,6 +1386,11 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
                        runtime_options.GetOrDefault(Opt::TLABAllocThreshold),
                        runtime_options.GetOrDefault(Opt::TenureThreshold),
                        runtime_options.GetOrDefault(Opt::BumpSpaceCapacity),
+                       runtime_options.GetOrDefault(Opt::GenCopyingPauseGoalMs),
+                       runtime_options.GetOrDefault(Opt::GenerationalCC),
+                       runtime_options.GetOrDefault(Opt::RegionSize),
+                       runtime_options.GetOrDefault(Opt::RegionEvacuateLivePercent),
+                       runtime_options.GetOrDefault(Opt::UseHugePages),
                        xgc_option.measure_,
                        runtime_options.GetOrDefault(Opt::EnableHSpaceCompactForOOM),
                        runtime_options.GetOrDefault(Opt::HSpaceCompactForOOMMinIntervalsMs),
@@ -1263,6 +1402,20 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
     return false;
   }
 
+  if (runtime_options.Exists(Opt::GcThreadCpus)) {
+    std::vector<uint32_t> cpus;
+    std::vector<std::string> cpu_list = runtime_options.GetOrDefault(Opt::GcThreadCpus);
+    for (const std::string& cpu : cpu_list) {
+      uint32_t value;
+      if (ParseUint(cpu.c_str(), &value)) {
+        cpus.push_back(value);
+      } else {
+        LOG(WARNING) << "Ignoring invalid GC thread CPU " << cpu;
+      }
+    }
+    heap_->SetThreadPoolCpus(cpus);
+  }
+
   dump_gc_performance_on_shutdown_ = runtime_options.Exists(Opt::DumpGCPerformanceOnShutdown);
 
   if (runtime_options.Exists(Opt::JdwpOptions)) {
@@ -1297,6 +1450,11 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   if (enable_gcprofile_) {
     GetHeap()->GCProfileSetDir(gcprofile_dir_);
     GetHeap()->GCProfileEnableSuccAllocProfile(enable_succ_alloc_profile_);
+    GetHeap()->GCProfileSetAllocSampleInterval(
+        runtime_options.GetOrDefault(Opt::GcProfAllocSampleInterval) * KB);
+    if (runtime_options.GetOrDefault(Opt::GcProfStream)) {
+      GetHeap()->GCProfileEnableStreaming(runtime_options.GetOrDefault(Opt::GcProfStreamFileSize));
+    }
   } else {
     enable_succ_alloc_profile_ = false;
     enable_gcprofile_at_start_ = false;
@@ -1351,6 +1509,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
     }
   }
 
+  phase.NewPhase("JavaVM");
   std::string error_msg;
   java_vm_ = JavaVMExt::Create(this, runtime_options, &error_msg);
   if (java_vm_.get() == nullptr) {
@@ -1380,6 +1539,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   GetHeap()->EnableObjectValidation();
 
   CHECK_GE(GetHeap()->GetContinuousSpaces().size(), 1U);
+  phase.NewPhase("ClassLinker");
   if (UNLIKELY(IsAotCompiler())) {
     class_linker_ = new AotClassLinker(intern_table_);
   } else {
@@ -1486,6 +1646,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   // Runtime initialization is largely done now.
   // We load plugins first since that can modify the runtime state slightly.
   // Load all plugins
+  phase.NewPhase("Plugins");
   for (auto& plugin : plugins_) {
     std::string err;
     if (!plugin.Load(&err)) {
@@ -1527,6 +1688,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
 
   // Startup agents
   // TODO Maybe we should start a new thread to run these on. Investigate RI behavior more.
+  phase.NewPhase("Agents");
   for (auto& agent : agents_) {
     // TODO Check err
     int res = 0;
@@ -1622,11 +1784,13 @@ void Runtime::InitNativeMethods() {
 
   // Initialize classes used in JNI. The initialization requires runtime native
   // methods to be loaded first.
+  ScopedStartupPhase phase(this, "WellKnownClasses");
   WellKnownClasses::Init(env);
 
   // Then set up libjavacore / libopenjdk, which are just a regular JNI libraries with
   // a regular JNI_OnLoad. Most JNI libraries can just use System.loadLibrary, but
   // libcore can't because it's the library that implements System.loadLibrary!
+  phase.NewPhase("JNI_OnLoad");
   {
     std::string error_msg;
     if (!java_vm_->LoadNativeLibrary(env, "libjavacore.so", nullptr, nullptr, &error_msg)) {
@@ -1644,6 +1808,7 @@ void Runtime::InitNativeMethods() {
   }
 
   // Initialize well known classes that may invoke runtime native methods.
+  phase.NewPhase("WellKnownClasses::LateInit");
   WellKnownClasses::LateInit(env);
 
   VLOG(startup) << "Runtime::InitNativeMethods exiting";
@@ -1732,6 +1897,17 @@ void Runtime::DumpDeoptimizations(std::ostream& os) {
   }
 }
 
+void Runtime::DumpStartupTimings(std::ostream& os) const {
+  if (startup_timings_ == nullptr || !finished_starting_) {
+    return;
+  }
+  startup_timings_->Dump(os);
+  os << "Startup page faults [Minor] [Major]\n";
+  for (const StartupPhaseFaults& faults : startup_phase_faults_) {
+    os << "  " << faults.minor_faults << " " << faults.major_faults << " " << faults.name << "\n";
+  }
+}
+
 void Runtime::DumpForSigQuit(std::ostream& os) {
   GetClassLinker()->DumpForSigQuit(os);
   GetInternTable()->DumpForSigQuit(os);
@@ -1743,16 +1919,22 @@ void Runtime::DumpForSigQuit(std::ostream& os) {
   } else {
     os << "Running non JIT\n";
   }
+#ifdef CAPSTONE
+  autofast_jni_queue_->DumpForSigQuit(os);
+#endif
   DumpDeoptimizations(os);
   TrackedAllocators::Dump(os);
+  DumpStartupTimings(os);
   os << "\n";
 
   thread_list_->DumpForSigQuit(os);
   BaseMutex::DumpAll(os);
+  BaseMutex::DumpLockLevelContention(os);
 
-  // Inform anyone else who is interested in SigQuit.
   {
     ScopedObjectAccess soa(Thread::Current());
+    ContentionProfiler::Dump(os);
+    // Inform anyone else who is interested in SigQuit.
     callbacks_->SigQuit();
   }
 }
@@ -2138,6 +2320,24 @@ void Runtime::ClearCalleeSaveMethods() {
 
 void Runtime::RegisterAppInfo(const std::vector<std::string>& code_paths,
                               const std::string& profile_output_filename) {
+#ifdef CAPSTONE
+  if (IsAutoFastDetect() && !profile_output_filename.empty()) {
+    // Keep the results of the Auto Fast Detection next to the profile.
+    autofast_jni_cache_->Open(profile_output_filename + ".autofast");
+  }
+#endif
+
+  if (startup_page_trace_ && !profile_output_filename.empty()) {
+    // Only the first registration, that of the main profile, prefetches or records the pages.
+    startup_page_trace_ = false;
+    const std::string trace_filename = profile_output_filename + ".pages";
+    if (FileExists(trace_filename)) {
+      StartupPageTrace::Replay(trace_filename);
+    } else {
+      startup_page_trace_filename_ = trace_filename;
+    }
+  }
+
   if (jit_.get() == nullptr) {
     // We are not JITing. Nothing to do.
     return;
@@ -2162,6 +2362,17 @@ void Runtime::RegisterAppInfo(const std::vector<std::string>& code_paths,
   jit_->StartProfileSaver(profile_output_filename, code_paths);
 }
 
+void Runtime::RecordStartupPageTrace() {
+  if (startup_page_trace_filename_.empty()) {
+    return;
+  }
+  std::string error_msg;
+  if (!StartupPageTrace::Record(startup_page_trace_filename_, &error_msg)) {
+    LOG(WARNING) << "Failed to record the startup page trace: " << error_msg;
+  }
+  startup_page_trace_filename_.clear();
+}
+
 // Transaction support.
 void Runtime::EnterTransactionMode(Transaction* transaction) {
   DCHECK(IsAotCompiler());
@@ -2312,6 +2523,15 @@ void Runtime::AddCurrentRuntimeFeaturesAsDex2OatArguments(std::vector<std::strin
   argv->push_back(instruction_set);
 
   std::unique_ptr<const InstructionSetFeatures> features(InstructionSetFeatures::FromCppDefines());
+  if (kRuntimeISA == kX86 || kRuntimeISA == kX86_64) {
+    // Compile for the features of the running CPU, which the oat file assistant checks the
+    // file against, when it has at least the ones the runtime was built for.
+    std::unique_ptr<const InstructionSetFeatures> cpu_features =
+        InstructionSetFeatures::FromCpuInfo();
+    if (cpu_features->HasAtLeast(features.get())) {
+      features = std::move(cpu_features);
+    }
+  }
   std::string feature_string("--instruction-set-features=");
   feature_string += features->GetFeatureString();
   argv->push_back(feature_string);
@@ -71,6 +71,8 @@ namespace verifier {
 }  // namespace verifier
 class ArenaPool;
 class ArtMethod;
+class AutoFastJniCache;
+class AutoFastJniQueue;
 enum class CalleeSaveType: uint32_t;
 class ClassLinker;
 class CompilerCallbacks;
@@ -91,6 +93,7 @@ class SignalCatcher;
 class StackOverflowHandler;
 class SuspensionHandler;
 class ThreadList;
+class TimingLogger;
 class Trace;
 struct TraceConfig;
 class Transaction;
@@ -160,6 +163,16 @@ class Runtime {
     return is_explicit_gc_disabled_;
   }
 
+  // Whether the heap dumps to files are written by a forked child, see hprof::DumpHeap.
+  bool ShouldForkHeapDump() const {
+    return fork_heap_dump_;
+  }
+
+  // Whether the heap dumps to files are indexed, see hprof::DumpHeap.
+  bool ShouldWriteHprofIndex() const {
+    return write_hprof_index_;
+  }
+
   std::string GetCompilerExecutable() const;
   std::string GetPatchoatExecutable() const;
 
@@ -344,6 +357,12 @@ class Runtime {
   void SweepSystemWeaks(IsMarkedVisitor* visitor)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Like SweepSystemWeaks() followed by AllowNewSystemWeaks(), but allows the new system weaks of
+  // each holder as soon as it is swept, so that a mutator waits only for the sweeping of the
+  // system weaks it accesses. The intern table, usually the largest, is swept last.
+  void SweepAndAllowSystemWeaks(IsMarkedVisitor* visitor, TimingLogger* timings)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Returns a special method that calls into a trampoline for runtime method resolution
   ArtMethod* GetResolutionMethod();
 
@@ -663,6 +682,16 @@ class Runtime {
   void SetAutoFastDetect(bool value) {
     auto_fast_detect_ = value;
   }
+
+  // The results of the Auto Fast Detection kept across the runs of the app.
+  AutoFastJniCache* GetAutoFastJniCache() const {
+    return autofast_jni_cache_.get();
+  }
+
+  // The native methods waiting for the Auto Fast Detection.
+  AutoFastJniQueue* GetAutoFastJniQueue() const {
+    return autofast_jni_queue_.get();
+  }
 #endif
 
   void AddSystemWeakHolder(gc::AbstractSystemWeakHolder* holder);
@@ -701,7 +730,26 @@ class Runtime {
     return madvise_random_access_;
   }
 
+  // Record the pages of the image, oat and vdex files touched during startup, if
+  // RegisterAppInfo() found no trace to replay. Called by the profile saver once startup is over.
+  void RecordStartupPageTrace();
+
+  // Dump the durations and page faults of the phases of startup, if -XX:DumpStartupTimings was
+  // given and the runtime finished starting.
+  void DumpStartupTimings(std::ostream& os) const;
+
  private:
+  // Times a phase of the startup timeline and counts the page faults taken during it, when
+  // -XX:DumpStartupTimings is given.
+  class ScopedStartupPhase;
+
+  // The page faults taken during a phase of the startup timeline.
+  struct StartupPhaseFaults {
+    const char* name;
+    uint64_t minor_faults;
+    uint64_t major_faults;
+  };
+
   static void InitPlatformSignalHandlers();
 
   Runtime();
@@ -762,6 +810,8 @@ class Runtime {
   bool must_relocate_;
   bool is_concurrent_gc_enabled_;
   bool is_explicit_gc_disabled_;
+  bool fork_heap_dump_;
+  bool write_hprof_index_;
   bool dex2oat_enabled_;
   bool image_dex2oat_enabled_;
 
@@ -950,6 +1000,19 @@ class Runtime {
   // This is beneficial for low RAM devices since it reduces page cache thrashing.
   bool madvise_random_access_;
 
+  // Whether the pages touched during startup are recorded next to the profile, for the next
+  // launch to prefetch them.
+  bool startup_page_trace_;
+
+  // Where RecordStartupPageTrace() writes the trace, empty if there is nothing to record.
+  std::string startup_page_trace_filename_;
+
+  // The durations of the phases of Init() and Start(), null unless -XX:DumpStartupTimings.
+  std::unique_ptr<TimingLogger> startup_timings_;
+
+  // The page faults of the phases of startup_timings_, in the order the phases ended.
+  std::vector<StartupPhaseFaults> startup_phase_faults_;
+
   // Whether the application should run in safe mode, that is, interpreter only.
   bool safe_mode_;
 
@@ -994,6 +1057,10 @@ class Runtime {
 #ifdef CAPSTONE
   // Auto Fast JNI detection gate.
   bool auto_fast_detect_;
+
+  std::unique_ptr<AutoFastJniCache> autofast_jni_cache_;
+
+  std::unique_ptr<AutoFastJniQueue> autofast_jni_queue_;
 #endif
 
   DISALLOW_COPY_AND_ASSIGN(Runtime);
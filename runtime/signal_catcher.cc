@@ -26,6 +26,7 @@
 #include <unistd.h>
 
 #include <sstream>
+#include <streambuf>
 
 #include "android-base/stringprintf.h"
 #include "arch/instruction_set.h"
@@ -140,18 +141,69 @@ bool SignalCatcher::OpenStackTraceFile(android::base::unique_fd* tombstone_fd,
   return true;
 }
 
-void SignalCatcher::Output(const std::string& s) {
+// Writes a dump to its file as it is produced, through a buffer flushed by std::endl, e.g. after
+// each thread. The threads dumped before tombstoned times out or the process is killed are then
+// not lost along with the others. Drops the output after a failed write.
+class FileStreamBuf FINAL : public std::streambuf {
+ public:
+  explicit FileStreamBuf(File* file) : file_(file), failed_(false) {
+    setp(buffer_, buffer_ + sizeof(buffer_));
+  }
+
+  bool Failed() const {
+    return failed_;
+  }
+
+ private:
+  int_type overflow(int_type c) OVERRIDE {
+    if (!Flush()) {
+      return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  int sync() OVERRIDE {
+    return Flush() ? 0 : -1;
+  }
+
+  bool Flush() {
+    const size_t size = pptr() - pbase();
+    if (size != 0u && !failed_ && !file_->WriteFully(pbase(), size)) {
+      failed_ = true;
+    }
+    setp(buffer_, buffer_ + sizeof(buffer_));
+    return !failed_;
+  }
+
+  File* const file_;
+  bool failed_;
+  char buffer_[4 * KB];
+};
+
+void SignalCatcher::HandleSigQuit() {
   android::base::unique_fd tombstone_fd;
   android::base::unique_fd output_fd;
   if (!OpenStackTraceFile(&tombstone_fd, &output_fd)) {
-    LOG(INFO) << s;
+    std::ostringstream os;
+    DumpForSigQuit(os);
+    LOG(INFO) << os.str();
     return;
   }
 
-  ScopedThreadStateChange tsc(Thread::Current(), kWaitingForSignalCatcherOutput);
-
   std::unique_ptr<File> file(new File(output_fd.release(), true /* check_usage */));
-  bool success = file->WriteFully(s.data(), s.size());
+  bool success;
+  {
+    FileStreamBuf file_buf(file.get());
+    std::ostream os(&file_buf);
+    DumpForSigQuit(os);
+    ScopedThreadStateChange tsc(Thread::Current(), kWaitingForSignalCatcherOutput);
+    os.flush();
+    success = !file_buf.Failed();
+  }
   if (success) {
     success = file->FlushCloseOrErase() == 0;
   } else {
@@ -174,9 +226,8 @@ void SignalCatcher::Output(const std::string& s) {
 #endif
 }
 
-void SignalCatcher::HandleSigQuit() {
+void SignalCatcher::DumpForSigQuit(std::ostream& os) {
   Runtime* runtime = Runtime::Current();
-  std::ostringstream os;
   os << "\n"
       << "----- pid " << getpid() << " at " << GetIsoDate() << " -----\n";
 
@@ -199,7 +250,6 @@ void SignalCatcher::HandleSigQuit() {
     }
   }
   os << "----- end " << getpid() << " -----\n";
-  Output(os.str());
 }
 
 void SignalCatcher::HandleSigUsr1() {
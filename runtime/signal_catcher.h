@@ -58,8 +58,11 @@ class SignalCatcher {
   // interoperability with tombstoned client APIs.
   bool OpenStackTraceFile(android::base::unique_fd* tombstone_fd,
                           android::base::unique_fd* output_fd);
+  // Dumps the state of the process and its threads, streamed into os as they are dumped.
+  void DumpForSigQuit(std::ostream& os) REQUIRES(!Locks::mutator_lock_,
+                                                 !Locks::thread_list_lock_,
+                                                 !Locks::thread_suspend_count_lock_);
   void HandleSigUsr1();
-  void Output(const std::string& s);
   void SetHaltFlag(bool new_value) REQUIRES(!lock_);
   bool ShouldHalt() REQUIRES(!lock_);
   int WaitForSignal(Thread* self, SignalSet& signals) REQUIRES(!lock_);
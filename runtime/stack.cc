@@ -32,6 +32,7 @@
 #include "jit/jit_code_cache.h"
 #include "linear_alloc.h"
 #include "managed_stack.h"
+#include "method_header_cache.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "mirror/object_array-inl.h"
@@ -763,6 +764,9 @@ void StackVisitor::WalkStack(bool include_transitions) {
   bool exit_stubs_installed = Runtime::Current()->GetInstrumentation()->AreExitStubsInstalled();
   uint32_t instrumentation_stack_depth = 0;
   size_t inlined_frames_count = 0;
+  Thread* self = Thread::Current();
+  MethodHeaderCache* header_cache =
+      (self != nullptr) ? self->GetOrCreateMethodHeaderCache() : nullptr;
 
   for (const ManagedStack* current_fragment = thread_->GetManagedStack();
        current_fragment != nullptr; current_fragment = current_fragment->GetLink()) {
@@ -776,7 +780,19 @@ void StackVisitor::WalkStack(bool include_transitions) {
       DCHECK(current_fragment->GetTopShadowFrame() == nullptr);
       ArtMethod* method = *cur_quick_frame_;
       while (method != nullptr) {
-        cur_oat_quick_method_header_ = method->GetOatQuickMethodHeader(cur_quick_frame_pc_);
+        // The top frame of a fragment has no pc, its header depends on the entry point of the
+        // method, which may change.
+        if (header_cache != nullptr && cur_quick_frame_pc_ != 0u) {
+          cur_oat_quick_method_header_ = header_cache->Get(method, cur_quick_frame_pc_);
+          if (cur_oat_quick_method_header_ == nullptr) {
+            cur_oat_quick_method_header_ = method->GetOatQuickMethodHeader(cur_quick_frame_pc_);
+            if (cur_oat_quick_method_header_ != nullptr) {
+              header_cache->Set(method, cur_quick_frame_pc_, cur_oat_quick_method_header_);
+            }
+          }
+        } else {
+          cur_oat_quick_method_header_ = method->GetOatQuickMethodHeader(cur_quick_frame_pc_);
+        }
         SanityCheckFrame();
 
         if ((walk_kind_ == StackWalkKind::kIncludeInlinedFrames)
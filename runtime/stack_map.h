@@ -1273,6 +1273,9 @@ struct CodeInfoEncoding {
   BitEncodingTable<BitRegionEncoding> stack_mask;
   BitEncodingTable<InvokeInfoEncoding> invoke_info;
   BitEncodingTable<InlineInfoEncoding> inline_info;
+  // Number of stack maps at the start of the stack map table sorted by native PC (serialized).
+  // These are the safepoint stack maps; the catch stack maps after them are not sorted.
+  uint32_t number_of_sorted_stack_maps = 0;
 
   CodeInfoEncoding() {}
 
@@ -1281,6 +1284,7 @@ struct CodeInfoEncoding {
     dex_register_map.Decode(&ptr);
     location_catalog.Decode(&ptr);
     stack_map.Decode(&ptr);
+    number_of_sorted_stack_maps = DecodeUnsignedLeb128(&ptr);
     register_mask.Decode(&ptr);
     stack_mask.Decode(&ptr);
     invoke_info.Decode(&ptr);
@@ -1300,6 +1304,7 @@ struct CodeInfoEncoding {
     dex_register_map.Encode(dest);
     location_catalog.Encode(dest);
     stack_map.Encode(dest);
+    EncodeUnsignedLeb128(dest, number_of_sorted_stack_maps);
     register_mask.Encode(dest);
     stack_mask.Encode(dest);
     invoke_info.Encode(dest);
@@ -1352,8 +1357,9 @@ struct CodeInfoEncoding {
  * where CodeInfoEncoding is of the form:
  *
  *   [ByteSizedTable(dex_register_map), ByteSizedTable(location_catalog),
- *    BitEncodingTable<StackMapEncoding>, BitEncodingTable<BitRegionEncoding>,
- *    BitEncodingTable<BitRegionEncoding>, BitEncodingTable<InlineInfoEncoding>]
+ *    BitEncodingTable<StackMapEncoding>, number_of_sorted_stack_maps,
+ *    BitEncodingTable<BitRegionEncoding>, BitEncodingTable<BitRegionEncoding>,
+ *    BitEncodingTable<InvokeInfoEncoding>, BitEncodingTable<InlineInfoEncoding>]
  */
 class CodeInfo {
  public:
@@ -1538,10 +1544,29 @@ class CodeInfo {
 
   StackMap GetStackMapForNativePcOffset(uint32_t native_pc_offset,
                                         const CodeInfoEncoding& encoding) const {
-    // TODO: Safepoint stack maps are sorted by native_pc_offset but catch stack
-    //       maps are not. If we knew that the method does not have try/catch,
-    //       we could do binary search.
-    for (size_t i = 0, e = GetNumberOfStackMaps(encoding); i < e; ++i) {
+    // Binary search the safepoint stack maps, which are sorted by native_pc_offset,
+    // for the first one at `native_pc_offset`.
+    const StackMapEncoding& stack_map_encoding = encoding.stack_map.encoding;
+    size_t number_of_sorted_stack_maps = encoding.number_of_sorted_stack_maps;
+    size_t low = 0;
+    size_t high = number_of_sorted_stack_maps;
+    while (low < high) {
+      size_t mid = low + (high - low) / 2;
+      if (GetStackMapAt(mid, encoding).GetNativePcOffset(stack_map_encoding, kRuntimeISA) <
+          native_pc_offset) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    if (low < number_of_sorted_stack_maps) {
+      StackMap stack_map = GetStackMapAt(low, encoding);
+      if (stack_map.GetNativePcOffset(stack_map_encoding, kRuntimeISA) == native_pc_offset) {
+        return stack_map;
+      }
+    }
+    // The catch stack maps are not sorted, search them linearly.
+    for (size_t i = number_of_sorted_stack_maps, e = GetNumberOfStackMaps(encoding); i < e; ++i) {
       StackMap stack_map = GetStackMapAt(i, encoding);
       if (stack_map.GetNativePcOffset(encoding.stack_map.encoding, kRuntimeISA) ==
           native_pc_offset) {
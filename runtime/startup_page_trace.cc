@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "startup_page_trace.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include "android-base/file.h"
+#include "android-base/strings.h"
+
+#include "base/logging.h"
+#include "base/systrace.h"
+#include "globals.h"
+#include "utils.h"
+
+namespace art {
+
+// Ranges of a file closer than this are read ahead together, reading the gap along.
+static constexpr uint64_t kReplayMaxGap = 64 * kPageSize;
+
+static bool IsTracedFile(const std::string& filename) {
+  return android::base::EndsWith(filename, ".art") ||
+         android::base::EndsWith(filename, ".oat") ||
+         android::base::EndsWith(filename, ".odex") ||
+         android::base::EndsWith(filename, ".vdex");
+}
+
+bool StartupPageTrace::Record(const std::string& trace_filename, std::string* error_msg) {
+  ScopedTrace trace(__FUNCTION__);
+  std::string maps;
+  if (!ReadFileToString("/proc/self/maps", &maps)) {
+    *error_msg = "Failed to read /proc/self/maps";
+    return false;
+  }
+  std::ostringstream os;
+  std::vector<unsigned char> residency;
+  std::istringstream stream(maps);
+  std::string line;
+  while (std::getline(stream, line)) {
+    uintptr_t begin;
+    uintptr_t end;
+    uint64_t offset;
+    int filename_pos = 0;
+    if (sscanf(line.c_str(),
+               "%" SCNxPTR "-%" SCNxPTR " %*s %" SCNx64 " %*s %*s %n",
+               &begin,
+               &end,
+               &offset,
+               &filename_pos) != 3 ||
+        filename_pos == 0) {
+      continue;
+    }
+    const std::string filename = line.substr(filename_pos);
+    if (!IsTracedFile(filename)) {
+      continue;
+    }
+    const size_t num_pages = (end - begin) / kPageSize;
+    residency.resize(num_pages);
+    if (mincore(reinterpret_cast<void*>(begin), end - begin, residency.data()) != 0) {
+      PLOG(WARNING) << "mincore failed for " << filename;
+      continue;
+    }
+    // Record the runs of resident pages as ranges of the file.
+    for (size_t i = 0; i != num_pages;) {
+      if ((residency[i] & 1u) == 0u) {
+        ++i;
+        continue;
+      }
+      const size_t first = i;
+      while (i != num_pages && (residency[i] & 1u) != 0u) {
+        ++i;
+      }
+      os << offset + first * kPageSize << " " << (i - first) * kPageSize << " " << filename
+         << "\n";
+    }
+  }
+  if (!android::base::WriteStringToFile(os.str(), trace_filename)) {
+    *error_msg = "Failed to write " + trace_filename;
+    return false;
+  }
+  return true;
+}
+
+bool StartupPageTrace::ParseTrace(const std::string& trace, std::vector<FileRange>* ranges) {
+  std::istringstream stream(trace);
+  std::string line;
+  while (std::getline(stream, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    FileRange range;
+    int filename_pos = 0;
+    if (sscanf(line.c_str(),
+               "%" SCNu64 " %" SCNu64 " %n",
+               &range.offset,
+               &range.length,
+               &filename_pos) != 2 ||
+        filename_pos == 0 ||
+        static_cast<size_t>(filename_pos) == line.size()) {
+      return false;
+    }
+    range.filename = line.substr(filename_pos);
+    ranges->push_back(std::move(range));
+  }
+  return true;
+}
+
+std::vector<StartupPageTrace::FileRange> StartupPageTrace::MergeRanges(
+    const std::vector<FileRange>& ranges, uint64_t max_gap) {
+  // A file may be mapped several times, group its ranges in the order it first appears.
+  std::vector<std::string> filenames;
+  for (const FileRange& range : ranges) {
+    if (std::find(filenames.begin(), filenames.end(), range.filename) == filenames.end()) {
+      filenames.push_back(range.filename);
+    }
+  }
+  std::vector<FileRange> merged;
+  std::vector<FileRange> file_ranges;
+  for (const std::string& filename : filenames) {
+    file_ranges.clear();
+    for (const FileRange& range : ranges) {
+      if (range.filename == filename) {
+        file_ranges.push_back(range);
+      }
+    }
+    std::sort(file_ranges.begin(),
+              file_ranges.end(),
+              [](const FileRange& a, const FileRange& b) { return a.offset < b.offset; });
+    const size_t first_merged = merged.size();
+    for (const FileRange& range : file_ranges) {
+      if (merged.size() != first_merged &&
+          range.offset <= merged.back().offset + merged.back().length + max_gap) {
+        FileRange& last = merged.back();
+        last.length = std::max(last.offset + last.length, range.offset + range.length) -
+            last.offset;
+      } else {
+        merged.push_back(range);
+      }
+    }
+  }
+  return merged;
+}
+
+size_t StartupPageTrace::Replay(const std::string& trace_filename) {
+  ScopedTrace trace(__FUNCTION__);
+  struct stat trace_stat;
+  std::string contents;
+  std::vector<FileRange> ranges;
+  if (TEMP_FAILURE_RETRY(stat(trace_filename.c_str(), &trace_stat)) != 0 ||
+      !ReadFileToString(trace_filename, &contents)) {
+    return 0u;
+  }
+  if (!ParseTrace(contents, &ranges)) {
+    LOG(WARNING) << "Deleting malformed startup page trace " << trace_filename;
+    unlink(trace_filename.c_str());
+    return 0u;
+  }
+  bool stale = false;
+  size_t requested = 0u;
+  std::string open_filename;
+  int fd = -1;
+  for (const FileRange& range : MergeRanges(ranges, kReplayMaxGap)) {
+    if (range.filename != open_filename) {
+      if (fd != -1) {
+        close(fd);
+      }
+      open_filename = range.filename;
+      fd = TEMP_FAILURE_RETRY(open(open_filename.c_str(), O_RDONLY | O_CLOEXEC));
+      struct stat file_stat;
+      if (fd == -1 ||
+          TEMP_FAILURE_RETRY(fstat(fd, &file_stat)) != 0 ||
+          file_stat.st_mtime > trace_stat.st_mtime) {
+        // The file was deleted or rewritten, its ranges may not be the ones used any more.
+        stale = true;
+      }
+    }
+    if (fd != -1 &&
+        posix_fadvise(fd, range.offset, range.length, POSIX_FADV_WILLNEED) == 0) {
+      requested += range.length;
+    }
+  }
+  if (fd != -1) {
+    close(fd);
+  }
+  VLOG(startup) << "Requested " << requested << " bytes from " << trace_filename;
+  if (stale) {
+    VLOG(startup) << "Deleting stale startup page trace " << trace_filename;
+    unlink(trace_filename.c_str());
+  }
+  return requested;
+}
+
+}  // namespace art
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_STARTUP_PAGE_TRACE_H_
+#define ART_RUNTIME_STARTUP_PAGE_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+
+namespace art {
+
+// Records the pages of the image, oat and vdex files that a launch touched, and prefetches them
+// at the next launch. Without it, a cold launch faults these pages in one at a time, in the
+// order the code touches them, which is slow on storage with poor random reads.
+class StartupPageTrace {
+ public:
+  // A range of a file, in bytes.
+  struct FileRange {
+    std::string filename;
+    uint64_t offset;
+    uint64_t length;
+  };
+
+  // Write to trace_filename the ranges of the image, oat and vdex files mapped by this process
+  // whose pages are resident, as reported by mincore(). Returns false on failure.
+  static bool Record(const std::string& trace_filename, std::string* error_msg);
+
+  // Ask the kernel to read ahead the ranges recorded in trace_filename, without waiting for the
+  // reads. Close ranges of a file are merged into larger sequential reads. Deletes the trace if
+  // one of its files changed since it was recorded, for the next launch to record it again.
+  // Returns the number of bytes requested.
+  static size_t Replay(const std::string& trace_filename);
+
+  // Parse the ranges of a trace. Returns false if the trace is malformed.
+  static bool ParseTrace(const std::string& trace, std::vector<FileRange>* ranges);
+
+  // Merge the ranges of the same file that are less than max_gap apart, in ascending offsets.
+  // The files keep the order in which they first appear.
+  static std::vector<FileRange> MergeRanges(const std::vector<FileRange>& ranges,
+                                            uint64_t max_gap);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(StartupPageTrace);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_STARTUP_PAGE_TRACE_H_
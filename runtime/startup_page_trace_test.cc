@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "startup_page_trace.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+using FileRange = StartupPageTrace::FileRange;
+
+TEST(StartupPageTraceTest, ParseTrace) {
+  std::vector<FileRange> ranges;
+  ASSERT_TRUE(StartupPageTrace::ParseTrace("4096 8192 /a/boot.oat\n0 4096 /b/base.vdex\n",
+                                           &ranges));
+  ASSERT_EQ(2u, ranges.size());
+  EXPECT_EQ("/a/boot.oat", ranges[0].filename);
+  EXPECT_EQ(4096u, ranges[0].offset);
+  EXPECT_EQ(8192u, ranges[0].length);
+  EXPECT_EQ("/b/base.vdex", ranges[1].filename);
+  EXPECT_EQ(0u, ranges[1].offset);
+
+  ranges.clear();
+  EXPECT_FALSE(StartupPageTrace::ParseTrace("4096 /a/boot.oat\n", &ranges));
+  ranges.clear();
+  EXPECT_FALSE(StartupPageTrace::ParseTrace("0 4096 \n", &ranges));
+}
+
+TEST(StartupPageTraceTest, MergeRanges) {
+  std::vector<FileRange> ranges = {
+    { "/a/boot.oat", 40960u, 4096u },
+    { "/b/base.odex", 0u, 4096u },
+    { "/a/boot.oat", 0u, 4096u },
+    { "/a/boot.oat", 8192u, 4096u },
+    { "/a/boot.oat", 8192u, 8192u },
+  };
+  std::vector<FileRange> merged = StartupPageTrace::MergeRanges(ranges, /* max_gap */ 4096u);
+  ASSERT_EQ(3u, merged.size());
+  // The ranges of boot.oat closer than the gap are merged, in ascending offsets.
+  EXPECT_EQ("/a/boot.oat", merged[0].filename);
+  EXPECT_EQ(0u, merged[0].offset);
+  EXPECT_EQ(16384u, merged[0].length);
+  EXPECT_EQ("/a/boot.oat", merged[1].filename);
+  EXPECT_EQ(40960u, merged[1].offset);
+  EXPECT_EQ(4096u, merged[1].length);
+  EXPECT_EQ("/b/base.odex", merged[2].filename);
+}
+
+}  // namespace art
@@ -44,6 +44,7 @@
 #include "base/systrace.h"
 #include "base/timing_logger.h"
 #include "base/to_str.h"
+#include "catch_block_cache.h"
 #include "class_linker-inl.h"
 #include "debugger.h"
 #include "dex_file-inl.h"
@@ -59,10 +60,13 @@
 #include "handle_scope-inl.h"
 #include "indirect_reference_table-inl.h"
 #include "interpreter/interpreter.h"
+#include "interpreter/interpreter_cache.h"
 #include "interpreter/shadow_frame.h"
 #include "java_frame_root_info.h"
 #include "java_vm_ext.h"
+#include "jit/hot_method_buffer.h"
 #include "jni_internal.h"
+#include "method_header_cache.h"
 #include "mirror/class-inl.h"
 #include "mirror/class_loader.h"
 #include "mirror/object_array-inl.h"
@@ -158,6 +162,7 @@ void Thread::ResetQuickAllocEntryPointsForThread(bool is_marking) {
     is_marking = true;
   }
   ResetQuickAllocEntryPoints(&tlsPtr_.quick_entrypoints, is_marking);
+  tlsPtr_.inline_alloc_disabled = AreQuickAllocEntryPointsInstrumented() ? 1u : 0u;
 }
 
 class DeoptimizationContextRecord {
@@ -1146,9 +1151,9 @@ void Thread::ShortDump(std::ostream& os) const {
 }
 
 void Thread::Dump(std::ostream& os, bool dump_native_stack, BacktraceMap* backtrace_map,
-                  bool force_dump_stack) const {
+                  bool force_dump_stack, NativeStackSymbolCache* symbol_cache) const {
   DumpState(os);
-  DumpStack(os, dump_native_stack, backtrace_map, force_dump_stack);
+  DumpStack(os, dump_native_stack, backtrace_map, force_dump_stack, symbol_cache);
 }
 
 mirror::String* Thread::GetThreadName() const {
@@ -1926,7 +1931,8 @@ void Thread::DumpJavaStack(std::ostream& os, bool check_suspended, bool dump_loc
 void Thread::DumpStack(std::ostream& os,
                        bool dump_native_stack,
                        BacktraceMap* backtrace_map,
-                       bool force_dump_stack) const {
+                       bool force_dump_stack,
+                       NativeStackSymbolCache* symbol_cache) const {
   // TODO: we call this code when dying but may not have suspended the thread ourself. The
   //       IsSuspended check is therefore racy with the use for dumping (normally we inhibit
   //       the race with the thread_suspend_count_lock_).
@@ -1945,7 +1951,13 @@ void Thread::DumpStack(std::ostream& os,
           GetCurrentMethod(nullptr,
                            /*check_suspended*/ !force_dump_stack,
                            /*abort_on_error*/ !(dump_for_abort || force_dump_stack));
-      DumpNativeStack(os, GetTid(), backtrace_map, "  native: ", method);
+      DumpNativeStack(os,
+                      GetTid(),
+                      backtrace_map,
+                      "  native: ",
+                      method,
+                      /* ucontext */ nullptr,
+                      symbol_cache);
     }
     DumpJavaStack(os,
                   /*check_suspended*/ !force_dump_stack,
@@ -2041,7 +2053,12 @@ Thread::Thread(bool daemon)
     : tls32_(daemon),
       wait_monitor_(nullptr),
       custom_tls_(nullptr),
-      can_call_into_java_(true) {
+      can_call_into_java_(true),
+      hot_method_buffer_(nullptr),
+      interpreter_cache_(nullptr),
+      catch_block_cache_(nullptr),
+      method_header_cache_(nullptr),
+      stack_trace_frames_(nullptr) {
   wait_mutex_ = new Mutex("a thread wait mutex");
   wait_cond_ = new ConditionVariable("a thread wait condition variable", *wait_mutex_);
   tlsPtr_.instrumentation_stack = new std::deque<instrumentation::InstrumentationStackFrame>;
@@ -2214,6 +2231,11 @@ Thread::~Thread() {
 
   delete wait_cond_;
   delete wait_mutex_;
+  delete hot_method_buffer_.LoadRelaxed();
+  delete interpreter_cache_;
+  delete catch_block_cache_;
+  delete method_header_cache_;
+  delete[] stack_trace_frames_;
 
   if (tlsPtr_.long_jump_context != nullptr) {
     delete tlsPtr_.long_jump_context;
@@ -2235,6 +2257,41 @@ Thread::~Thread() {
   TearDownAlternateSignalStack();
 }
 
+jit::HotMethodBuffer* Thread::GetOrCreateHotMethodBuffer() {
+  DCHECK_EQ(this, Thread::Current());
+  jit::HotMethodBuffer* buffer = hot_method_buffer_.LoadRelaxed();
+  if (UNLIKELY(buffer == nullptr)) {
+    buffer = new jit::HotMethodBuffer();
+    // The saver may look at the buffer as soon as it is published.
+    hot_method_buffer_.StoreRelease(buffer);
+  }
+  return buffer;
+}
+
+InterpreterCache* Thread::GetOrCreateInterpreterCache() {
+  DCHECK_EQ(this, Thread::Current());
+  if (UNLIKELY(interpreter_cache_ == nullptr)) {
+    interpreter_cache_ = new InterpreterCache();
+  }
+  return interpreter_cache_;
+}
+
+CatchBlockCache* Thread::GetOrCreateCatchBlockCache() {
+  DCHECK_EQ(this, Thread::Current());
+  if (UNLIKELY(catch_block_cache_ == nullptr)) {
+    catch_block_cache_ = new CatchBlockCache();
+  }
+  return catch_block_cache_;
+}
+
+MethodHeaderCache* Thread::GetOrCreateMethodHeaderCache() {
+  DCHECK_EQ(this, Thread::Current());
+  if (UNLIKELY(method_header_cache_ == nullptr)) {
+    method_header_cache_ = new MethodHeaderCache();
+  }
+  return method_header_cache_;
+}
+
 void Thread::HandleUncaughtExceptions(ScopedObjectAccessAlreadyRunnable& soa) {
   if (!IsExceptionPending()) {
     return;
@@ -2544,7 +2601,15 @@ template<bool kTransactionActive>
 jobject Thread::CreateInternalStackTrace(const ScopedObjectAccessAlreadyRunnable& soa) const {
   // Compute depth of stack, save frames if possible to avoid needing to recompute many.
   constexpr size_t kMaxSavedFrames = 256;
-  std::unique_ptr<ArtMethodDexPcPair[]> saved_frames(new ArtMethodDexPcPair[kMaxSavedFrames]);
+  // Most throwables are created and dropped without their stack trace being looked at, reuse the
+  // frames of the calling thread rather than allocating them for every throwable. The frames are
+  // taken from the thread, in case the allocations below create another stack trace.
+  Thread* self = soa.Self();
+  std::unique_ptr<ArtMethodDexPcPair[]> saved_frames(self->stack_trace_frames_);
+  self->stack_trace_frames_ = nullptr;
+  if (saved_frames == nullptr) {
+    saved_frames.reset(new ArtMethodDexPcPair[kMaxSavedFrames]);
+  }
   FetchStackTraceVisitor count_visitor(const_cast<Thread*>(this),
                                        &saved_frames[0],
                                        kMaxSavedFrames);
@@ -2556,16 +2621,21 @@ jobject Thread::CreateInternalStackTrace(const ScopedObjectAccessAlreadyRunnable
   BuildInternalStackTraceVisitor<kTransactionActive> build_trace_visitor(soa.Self(),
                                                                          const_cast<Thread*>(this),
                                                                          skip_depth);
-  if (!build_trace_visitor.Init(depth)) {
-    return nullptr;  // Allocation failed.
-  }
+  const bool initialized = build_trace_visitor.Init(depth);
   // If we saved all of the frames we don't even need to do the actual stack walk. This is faster
   // than doing the stack walk twice.
-  if (depth < kMaxSavedFrames) {
+  if (initialized && depth < kMaxSavedFrames) {
     for (size_t i = 0; i < depth; ++i) {
       build_trace_visitor.AddFrame(saved_frames[i].first, saved_frames[i].second);
     }
-  } else {
+  }
+  if (self->stack_trace_frames_ == nullptr) {
+    self->stack_trace_frames_ = saved_frames.release();
+  }
+  if (!initialized) {
+    return nullptr;  // Allocation failed.
+  }
+  if (depth >= kMaxSavedFrames) {
     build_trace_visitor.WalkStack();
   }
 
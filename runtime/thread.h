@@ -24,6 +24,7 @@
 #include <memory>
 #include <setjmp.h>
 #include <string>
+#include <utility>
 
 #include "arch/context.h"
 #include "arch/instruction_set.h"
@@ -56,6 +57,10 @@ namespace collector {
 }  // namespace collector
 }  // namespace gc
 
+namespace jit {
+  class HotMethodBuffer;
+}  // namespace jit
+
 namespace mirror {
   class Array;
   class Class;
@@ -76,6 +81,7 @@ namespace verifier {
 
 class ArtMethod;
 class BaseMutex;
+class CatchBlockCache;
 class ClassLinker;
 class Closure;
 class Context;
@@ -83,7 +89,10 @@ struct DebugInvokeReq;
 class DeoptimizationContextRecord;
 class DexFile;
 class FrameIdToShadowFrame;
+class InterpreterCache;
 class JavaVMExt;
+class MethodHeaderCache;
+class NativeStackSymbolCache;
 struct JNIEnvExt;
 class Monitor;
 class RootVisitor;
@@ -196,11 +205,13 @@ class Thread {
   // Dumps a one-line summary of thread state (used for operator<<).
   void ShortDump(std::ostream& os) const;
 
-  // Dumps the detailed thread state and the thread stack (used for SIGQUIT).
+  // Dumps the detailed thread state and the thread stack (used for SIGQUIT). The native frames
+  // are symbolized through symbol_cache, if not null, shared by the threads dumped together.
   void Dump(std::ostream& os,
             bool dump_native_stack = true,
             BacktraceMap* backtrace_map = nullptr,
-            bool force_dump_stack = false) const
+            bool force_dump_stack = false,
+            NativeStackSymbolCache* symbol_cache = nullptr) const
       REQUIRES(!Locks::thread_suspend_count_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -735,6 +746,12 @@ class Thread {
                                                                 thread_local_objects));
   }
 
+  template<PointerSize pointer_size>
+  static ThreadOffset<pointer_size> InlineAllocDisabledOffset() {
+    return ThreadOffsetFromTlsPtr<pointer_size>(OFFSETOF_MEMBER(tls_ptr_sized_values,
+                                                                inline_alloc_disabled));
+  }
+
   template<PointerSize pointer_size>
   static ThreadOffset<pointer_size> RosAllocRunsOffset() {
     return ThreadOffsetFromTlsPtr<pointer_size>(OFFSETOF_MEMBER(tls_ptr_sized_values,
@@ -927,6 +944,35 @@ class Thread {
     can_call_into_java_ = can_call_into_java;
   }
 
+  size_t GetAllocSampleBytesLeft() const {
+    return alloc_sample_bytes_left_;
+  }
+
+  void SetAllocSampleBytesLeft(size_t bytes) {
+    alloc_sample_bytes_left_ = bytes;
+  }
+
+  // Returns the buffer of the methods recorded for the profile saver, null if the thread has
+  // not recorded any yet.
+  jit::HotMethodBuffer* GetHotMethodBuffer() const {
+    return hot_method_buffer_.LoadAcquire();
+  }
+
+  // Only called by the thread itself.
+  jit::HotMethodBuffer* GetOrCreateHotMethodBuffer();
+
+  // Returns the cache of the values resolved by the interpreter, created on the first use. Only
+  // called by the thread itself.
+  InterpreterCache* GetOrCreateInterpreterCache();
+
+  // Returns the cache of the catch blocks found for the exceptions thrown, created on the first
+  // use. Only called by the thread itself.
+  CatchBlockCache* GetOrCreateCatchBlockCache();
+
+  // Returns the cache of the method headers found by the stack walks of the thread, created on
+  // the first use. Only called by the thread itself.
+  MethodHeaderCache* GetOrCreateMethodHeaderCache();
+
   // Activates single step control for debugging. The thread takes the
   // ownership of the given SingleStepControl*. It is deleted by a call
   // to DeactivateSingleStepControl or upon thread destruction.
@@ -1262,7 +1308,8 @@ class Thread {
   void DumpStack(std::ostream& os,
                  bool dump_native_stack = true,
                  BacktraceMap* backtrace_map = nullptr,
-                 bool force_dump_stack = false) const
+                 bool force_dump_stack = false,
+                 NativeStackSymbolCache* symbol_cache = nullptr) const
       REQUIRES(!Locks::thread_suspend_count_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -1509,7 +1556,8 @@ class Thread {
       thread_local_objects(0), mterp_current_ibase(nullptr), mterp_default_ibase(nullptr),
       mterp_alt_ibase(nullptr), thread_local_alloc_stack_top(nullptr),
       thread_local_alloc_stack_end(nullptr),
-      flip_function(nullptr), method_verifier(nullptr), thread_local_mark_stack(nullptr) {
+      flip_function(nullptr), method_verifier(nullptr), thread_local_mark_stack(nullptr),
+      inline_alloc_disabled(0) {
       std::fill(held_mutexes, held_mutexes + kLockLevelCount, nullptr);
     }
 
@@ -1666,6 +1714,10 @@ class Thread {
 
     // Thread-local mark stack for the concurrent copying collector.
     gc::accounting::AtomicStack<mirror::Object>* thread_local_mark_stack;
+
+    // Non-zero while the allocation entrypoints are instrumented. The compiled code bumps the TLAB
+    // inline only otherwise, leaving the instrumented allocations to the entrypoints.
+    size_t inline_alloc_disabled;
   } tlsPtr_;
 
   // Guards the 'wait_monitor_' members.
@@ -1693,6 +1745,26 @@ class Thread {
   // By default this is true.
   bool can_call_into_java_;
 
+  // Bytes left to allocate before the next allocation site sample of the GC profiler, or 0 if
+  // the thread has not started counting.
+  size_t alloc_sample_bytes_left_ = 0;
+
+  // The methods recorded for the profile saver, created on the first record.
+  Atomic<jit::HotMethodBuffer*> hot_method_buffer_;
+
+  // The values resolved by the interpreter, created on the first use.
+  InterpreterCache* interpreter_cache_;
+
+  // The catch blocks found for the exceptions thrown, created on the first use.
+  CatchBlockCache* catch_block_cache_;
+
+  // The method headers found by the stack walks, created on the first use.
+  MethodHeaderCache* method_header_cache_;
+
+  // The frames saved by CreateInternalStackTrace, kept between the calls of the thread to save
+  // their allocation. Null while a call uses them.
+  std::pair<ArtMethod*, uint32_t>* stack_trace_frames_;
+
   friend class Dbg;  // For SetStateUnsafe.
   friend class gc::collector::SemiSpace;  // For getting stack traces.
   friend class Runtime;  // For CreatePeer.
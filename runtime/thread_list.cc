@@ -23,6 +23,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <sstream>
 
 #include "android-base/stringprintf.h"
@@ -45,6 +46,7 @@
 #include "native_stack_dump.h"
 #include "scoped_thread_state_change-inl.h"
 #include "thread.h"
+#include "thread_pool.h"
 #include "trace.h"
 #include "well_known_classes.h"
 
@@ -65,6 +67,8 @@ static constexpr uint64_t kLongThreadSuspendThreshold = MsToNs(5);
 static constexpr useconds_t kThreadSuspendInitialSleepUs = 0;
 static constexpr useconds_t kThreadSuspendMaxYieldUs = 3000;
 static constexpr useconds_t kThreadSuspendMaxSleepUs = 5000;
+// The threads still runnable this long into a suspend all are recorded as holding it up.
+static constexpr uint64_t kSuspendAllStragglerThreshold = MsToNs(1);
 
 // Whether we should try to dump the native stack of unattached threads. See commit ed8b723 for
 // some history.
@@ -76,6 +80,9 @@ ThreadList::ThreadList(uint64_t thread_suspend_timeout_ns)
       debug_suspend_all_count_(0),
       unregistering_count_(0),
       suspend_all_historam_("suspend all histogram", 16, 64),
+      suspend_all_request_histogram_("suspend all request histogram", 16, 64),
+      suspend_all_wait_histogram_("suspend all wait histogram", 16, 64),
+      longest_suspend_all_wait_ns_(0),
       long_suspend_(false),
       shut_down_(false),
       thread_suspend_timeout_ns_(thread_suspend_timeout_ns),
@@ -152,6 +159,23 @@ void ThreadList::DumpForSigQuit(std::ostream& os) {
       suspend_all_historam_.PrintConfidenceIntervals(os, 0.99, data);  // Dump time to suspend.
     }
   }
+  {
+    // The phases of the time to suspend: requesting the suspension and waiting for the threads.
+    MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+    if (suspend_all_wait_histogram_.SampleSize() > 0) {
+      Histogram<uint64_t>::CumulativeData data;
+      suspend_all_request_histogram_.CreateHistogram(&data);
+      suspend_all_request_histogram_.PrintConfidenceIntervals(os, 0.99, data);
+      suspend_all_wait_histogram_.CreateHistogram(&data);
+      suspend_all_wait_histogram_.PrintConfidenceIntervals(os, 0.99, data);
+      os << "Longest wait for threads to suspend " << PrettyDuration(longest_suspend_all_wait_ns_);
+      if (!longest_suspend_all_wait_stragglers_.empty()) {
+        os << ", still runnable after " << PrettyDuration(kSuspendAllStragglerThreshold) << ": "
+           << longest_suspend_all_wait_stragglers_;
+      }
+      os << "\n";
+    }
+  }
   bool dump_native_stack = Runtime::Current()->GetDumpNativeStackOnSigQuit();
   // TODO: (Lin & Lei) Workaround as a temporary fix for ThreadStressLight test fail.
   // Need deep investigation why GenCopy can not work without blocking GC here.
@@ -204,31 +228,59 @@ void ThreadList::DumpUnattachedThreads(std::ostream& os, bool dump_native_stack)
 // overloaded with ANR dumps.
 static constexpr uint32_t kDumpWaitTimeout = kIsTargetBuild ? 100000 : 20000;
 
+// The most threads helping the requester of a dump with the stacks of the suspended threads.
+static constexpr size_t kDumpThreadPoolSize = 3;
+
 // A closure used by Thread::Dump.
 class DumpCheckpoint FINAL : public Closure {
  public:
-  DumpCheckpoint(std::ostream* os, bool dump_native_stack)
+  DumpCheckpoint(std::ostream* os, bool dump_native_stack, bool dump_in_parallel)
       : os_(os),
         barrier_(0),
         backtrace_map_(dump_native_stack ? BacktraceMap::Create(getpid()) : nullptr),
-        dump_native_stack_(dump_native_stack) {}
+        dump_native_stack_(dump_native_stack),
+        dump_in_parallel_(dump_in_parallel) {}
 
   void Run(Thread* thread) OVERRIDE {
     // Note thread and self may not be equal if thread was already suspended at the point of the
     // request.
     Thread* self = Thread::Current();
     CHECK(self != nullptr);
-    std::ostringstream local_os;
-    {
-      ScopedObjectAccess soa(self);
-      thread->Dump(local_os, dump_native_stack_, backtrace_map_.get());
+    if (dump_in_parallel_ && thread != self) {
+      // The requester runs the checkpoints of the suspended threads one after the other. Keep the
+      // thread suspended instead, for DumpSuspendedThreads to dump it along with the others.
+      MutexLock mu(self, *Locks::thread_suspend_count_lock_);
+      bool updated = thread->ModifySuspendCount(self, +1, nullptr, SuspendReason::kInternal);
+      DCHECK(updated);
+      suspended_threads_.push_back(thread);
+      return;
     }
-    {
-      // Use the logging lock to ensure serialization when writing to the common ostream.
-      MutexLock mu(self, *Locks::logging_lock_);
-      *os_ << local_os.str() << std::endl;
+    DumpThread(self, thread);
+  }
+
+  // Dump the threads kept suspended by Run, on a pool of threads attached for the dump. The
+  // caller resumes them afterwards.
+  void DumpSuspendedThreads(Thread* self) {
+    // The workers could not attach while a runnable requester held up a suspend all.
+    Locks::mutator_lock_->AssertNotHeld(self);
+    if (suspended_threads_.size() <= 1u) {
+      for (Thread* thread : suspended_threads_) {
+        DumpThread(self, thread);
+      }
+      return;
     }
-    barrier_.Pass(self);
+    // The workers attach after the checkpoint was requested, they do not have to run it.
+    ThreadPool thread_pool("Thread dump thread pool",
+                           std::min(kDumpThreadPoolSize, suspended_threads_.size() - 1u));
+    for (Thread* thread : suspended_threads_) {
+      thread_pool.AddTask(self, new DumpThreadTask(this, thread));
+    }
+    thread_pool.StartWorkers(self);
+    thread_pool.Wait(self, /* do_work */ true, /* may_hold_locks */ false);
+  }
+
+  const std::vector<Thread*>& GetSuspendedThreads() const {
+    return suspended_threads_;
   }
 
   void WaitForThreadsToRunThroughCheckpoint(size_t threads_running_checkpoint) {
@@ -243,14 +295,52 @@ class DumpCheckpoint FINAL : public Closure {
   }
 
  private:
+  class DumpThreadTask FINAL : public SelfDeletingTask {
+   public:
+    DumpThreadTask(DumpCheckpoint* checkpoint, Thread* thread)
+        : checkpoint_(checkpoint), thread_(thread) {}
+
+    void Run(Thread* self) OVERRIDE {
+      checkpoint_->DumpThread(self, thread_);
+    }
+
+   private:
+    DumpCheckpoint* const checkpoint_;
+    Thread* const thread_;
+  };
+
+  void DumpThread(Thread* self, Thread* thread) {
+    std::ostringstream local_os;
+    {
+      ScopedObjectAccess soa(self);
+      thread->Dump(local_os,
+                   dump_native_stack_,
+                   backtrace_map_.get(),
+                   /* force_dump_stack */ false,
+                   &symbol_cache_);
+    }
+    {
+      // Use the logging lock to ensure serialization when writing to the common ostream.
+      MutexLock mu(self, *Locks::logging_lock_);
+      *os_ << local_os.str() << std::endl;
+    }
+    barrier_.Pass(self);
+  }
+
   // The common stream that will accumulate all the dumps.
   std::ostream* const os_;
   // The barrier to be passed through and for the requestor to wait upon.
   Barrier barrier_;
   // A backtrace map, so that all threads use a shared info and don't reacquire/parse separately.
   std::unique_ptr<BacktraceMap> backtrace_map_;
+  // The native frames symbolized so far, most threads share some.
+  NativeStackSymbolCache symbol_cache_;
   // Whether we should dump the native stack.
   const bool dump_native_stack_;
+  // Whether the suspended threads are dumped in parallel by DumpSuspendedThreads.
+  const bool dump_in_parallel_;
+  // The threads kept suspended by Run, only accessed by the requester.
+  std::vector<Thread*> suspended_threads_;
 };
 
 void ThreadList::Dump(std::ostream& os, bool dump_native_stack) {
@@ -260,13 +350,29 @@ void ThreadList::Dump(std::ostream& os, bool dump_native_stack) {
     os << "DALVIK THREADS (" << list_.size() << "):\n";
   }
   if (self != nullptr) {
-    DumpCheckpoint checkpoint(&os, dump_native_stack);
+    // Unwinding the native stacks dominates the dump, the stacks of the threads found suspended
+    // are dumped in parallel. Not when aborting or shutting down, when no thread may attach to
+    // help, nor when holding the mutator lock, which a thread attaching may wait for.
+    const bool dump_in_parallel = dump_native_stack &&
+                                  gAborting == 0 &&
+                                  !Locks::mutator_lock_->IsSharedHeld(self) &&
+                                  !Runtime::Current()->IsShuttingDown(self);
+    DumpCheckpoint checkpoint(&os, dump_native_stack, dump_in_parallel);
     size_t threads_running_checkpoint;
     {
       // Use SOA to prevent deadlocks if multiple threads are calling Dump() at the same time.
       ScopedObjectAccess soa(self);
       threads_running_checkpoint = RunCheckpoint(&checkpoint);
     }
+    if (!checkpoint.GetSuspendedThreads().empty()) {
+      checkpoint.DumpSuspendedThreads(self);
+      MutexLock mu(self, *Locks::thread_suspend_count_lock_);
+      for (Thread* thread : checkpoint.GetSuspendedThreads()) {
+        bool updated = thread->ModifySuspendCount(self, -1, nullptr, SuspendReason::kInternal);
+        DCHECK(updated);
+      }
+      Thread::resume_cond_->Broadcast(self);
+    }
     if (threads_running_checkpoint != 0) {
       checkpoint.WaitForThreadsToRunThroughCheckpoint(threads_running_checkpoint);
     }
@@ -356,36 +462,49 @@ size_t ThreadList::RunCheckpoint(Closure* checkpoint_function, Closure* callback
   // Run the checkpoint on ourself while we wait for threads to suspend.
   checkpoint_function->Run(self);
 
-  // Run the checkpoint on the suspended threads.
-  for (const auto& thread : suspended_count_modified_threads) {
-    if (!thread->IsSuspended()) {
-      if (ATRACE_ENABLED()) {
-        std::ostringstream oss;
-        thread->ShortDump(oss);
-        ATRACE_BEGIN((std::string("Waiting for suspension of thread ") + oss.str()).c_str());
+  // Run the checkpoint on the suspended threads. The threads that are not suspended yet are
+  // revisited after the others, so that a slow thread does not hold up the checkpoints of the
+  // threads behind it.
+  const uint64_t start_time = NanoTime();
+  bool started_trace = false;
+  bool waited = false;
+  while (!suspended_count_modified_threads.empty()) {
+    size_t num_not_suspended = 0;
+    for (Thread* thread : suspended_count_modified_threads) {
+      if (!thread->IsSuspended()) {
+        suspended_count_modified_threads[num_not_suspended++] = thread;
+        continue;
       }
-      // Busy wait until the thread is suspended.
-      const uint64_t start_time = NanoTime();
-      do {
-        ThreadSuspendSleep(kThreadSuspendInitialSleepUs);
-      } while (!thread->IsSuspended());
-      const uint64_t total_delay = NanoTime() - start_time;
+      const uint64_t total_delay = waited ? NanoTime() - start_time : 0u;
       // Shouldn't need to wait for longer than 1000 microseconds.
       constexpr uint64_t kLongWaitThreshold = MsToNs(1);
-      ATRACE_END();
       if (UNLIKELY(total_delay > kLongWaitThreshold)) {
         LOG(WARNING) << "Long wait of " << PrettyDuration(total_delay) << " for "
             << *thread << " suspension!";
       }
+      // We know for sure that the thread is suspended at this point.
+      checkpoint_function->Run(thread);
+      {
+        MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
+        bool updated = thread->ModifySuspendCount(self, -1, nullptr, SuspendReason::kInternal);
+        DCHECK(updated);
+      }
     }
-    // We know for sure that the thread is suspended at this point.
-    checkpoint_function->Run(thread);
-    {
-      MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
-      bool updated = thread->ModifySuspendCount(self, -1, nullptr, SuspendReason::kInternal);
-      DCHECK(updated);
+    suspended_count_modified_threads.resize(num_not_suspended);
+    if (num_not_suspended != 0) {
+      if (!started_trace && ATRACE_ENABLED()) {
+        ATRACE_BEGIN(StringPrintf("Waiting for suspension of %zu threads",
+                                  num_not_suspended).c_str());
+        started_trace = true;
+      }
+      // Busy wait until the threads are suspended.
+      ThreadSuspendSleep(kThreadSuspendInitialSleepUs);
+      waited = true;
     }
   }
+  if (started_trace) {
+    ATRACE_END();
+  }
 
   {
     // Imitate ResumeAll, threads may be waiting on Thread::resume_cond_ since we raised their
@@ -713,6 +832,7 @@ void ThreadList::SuspendAllInternal(Thread* self,
 
   // The atomic counter for number of threads that need to pass the barrier.
   AtomicInteger pending_threads;
+  const uint64_t request_start_time = NanoTime();
   uint32_t num_ignored = 0;
   if (ignore1 != nullptr) {
     ++num_ignored;
@@ -750,20 +870,30 @@ void ThreadList::SuspendAllInternal(Thread* self,
   }
 
   // Wait for the barrier to be passed by all runnable threads. This wait
-  // is done with a timeout so that we can detect problems.
+  // is done with a timeout so that we can detect problems. A first shorter
+  // timeout finds the threads holding up the suspension.
 #if ART_USE_FUTEXES
   timespec wait_timeout;
   InitTimeSpec(false, CLOCK_MONOTONIC, NsToMs(thread_suspend_timeout_ns_), 0, &wait_timeout);
+  timespec straggler_timeout;
+  InitTimeSpec(
+      false, CLOCK_MONOTONIC, NsToMs(kSuspendAllStragglerThreshold), 0, &straggler_timeout);
 #endif
+  std::string stragglers;
+  bool looked_for_stragglers = false;
   const uint64_t start_time = NanoTime();
   while (true) {
     int32_t cur_val = pending_threads.LoadRelaxed();
     if (LIKELY(cur_val > 0)) {
 #if ART_USE_FUTEXES
-      if (futex(pending_threads.Address(), FUTEX_WAIT, cur_val, &wait_timeout, nullptr, 0) != 0) {
+      timespec* timeout = looked_for_stragglers ? &wait_timeout : &straggler_timeout;
+      if (futex(pending_threads.Address(), FUTEX_WAIT, cur_val, timeout, nullptr, 0) != 0) {
         // EAGAIN and EINTR both indicate a spurious failure, try again from the beginning.
         if ((errno != EAGAIN) && (errno != EINTR)) {
-          if (errno == ETIMEDOUT) {
+          if (errno == ETIMEDOUT && !looked_for_stragglers) {
+            looked_for_stragglers = true;
+            stragglers = FindRunnableThreads(self, ignore1, ignore2);
+          } else if (errno == ETIMEDOUT) {
             LOG(kIsDebugBuild ? ::android::base::FATAL : ::android::base::ERROR)
                 << "Timed out waiting for threads to suspend, waited for "
                 << PrettyDuration(NanoTime() - start_time);
@@ -781,6 +911,28 @@ void ThreadList::SuspendAllInternal(Thread* self,
       break;
     }
   }
+
+  const uint64_t end_time = NanoTime();
+  MutexLock mu(self, *Locks::thread_list_lock_);
+  suspend_all_request_histogram_.AdjustAndAddValue(start_time - request_start_time);
+  suspend_all_wait_histogram_.AdjustAndAddValue(end_time - start_time);
+  if (end_time - start_time > longest_suspend_all_wait_ns_) {
+    longest_suspend_all_wait_ns_ = end_time - start_time;
+    longest_suspend_all_wait_stragglers_ = stragglers;
+  }
+}
+
+std::string ThreadList::FindRunnableThreads(Thread* self, Thread* ignore1, Thread* ignore2) {
+  std::ostringstream oss;
+  MutexLock mu(self, *Locks::thread_list_lock_);
+  for (const auto& thread : list_) {
+    if (thread != ignore1 && thread != ignore2 && thread->GetState() == kRunnable) {
+      std::string name;
+      thread->GetThreadName(name);
+      oss << (oss.tellp() == 0 ? "" : ", ") << "\"" << name << "\" tid=" << thread->GetTid();
+    }
+  }
+  return oss.str();
 }
 
 void ThreadList::ResumeAll() {
@@ -27,6 +27,7 @@
 
 #include <bitset>
 #include <list>
+#include <string>
 #include <vector>
 
 namespace art {
@@ -207,6 +208,10 @@ class ThreadList {
   void AssertThreadsAreSuspended(Thread* self, Thread* ignore1, Thread* ignore2 = nullptr)
       REQUIRES(!Locks::thread_list_lock_, !Locks::thread_suspend_count_lock_);
 
+  // Describe the threads that are runnable, other than ignore1 and ignore2.
+  std::string FindRunnableThreads(Thread* self, Thread* ignore1, Thread* ignore2)
+      REQUIRES(!Locks::thread_list_lock_);
+
   std::bitset<kMaxThreadId> allocated_ids_ GUARDED_BY(Locks::allocated_thread_ids_lock_);
 
   // The actual list of all threads.
@@ -223,6 +228,16 @@ class ThreadList {
   // by mutator lock ensures no thread can read when another thread is modifying it.
   Histogram<uint64_t> suspend_all_historam_ GUARDED_BY(Locks::mutator_lock_);
 
+  // The phases of SuspendAllInternal(): raising the suspend counts, then waiting for the threads
+  // to pass the suspend barrier.
+  Histogram<uint64_t> suspend_all_request_histogram_ GUARDED_BY(Locks::thread_list_lock_);
+  Histogram<uint64_t> suspend_all_wait_histogram_ GUARDED_BY(Locks::thread_list_lock_);
+
+  // The longest wait for the threads to suspend, and the threads that were still runnable
+  // kSuspendAllStragglerThreshold into it.
+  uint64_t longest_suspend_all_wait_ns_ GUARDED_BY(Locks::thread_list_lock_);
+  std::string longest_suspend_all_wait_stragglers_ GUARDED_BY(Locks::thread_list_lock_);
+
   // Whether or not the current thread suspension is long.
   bool long_suspend_;
 
@@ -17,11 +17,15 @@
 #include "thread_pool.h"
 
 #include <pthread.h>
+#include <sched.h>
 
 #include <sys/mman.h>
 #include <sys/time.h>
 #include <sys/resource.h>
 
+#include <iterator>
+#include <ostream>
+
 #include "android-base/stringprintf.h"
 
 #include "base/bit_utils.h"
@@ -76,6 +80,23 @@ void ThreadPoolWorker::SetPthreadPriority(int priority) {
 #endif
 }
 
+void ThreadPoolWorker::SetCpuAffinity(const std::vector<uint32_t>& cpus) {
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (uint32_t cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  if (sched_setaffinity(thread_->GetTid(), sizeof(cpu_set), &cpu_set) != 0) {
+    PLOG(WARNING) << "Failed to set the CPU affinity of " << name_;
+  }
+#else
+  UNUSED(cpus);
+#endif
+}
+
 void ThreadPoolWorker::Run() {
   Thread* self = Thread::Current();
   Task* task = nullptr;
@@ -102,9 +123,14 @@ void* ThreadPoolWorker::Callback(void* arg) {
   return nullptr;
 }
 
-void ThreadPool::AddTask(Thread* self, Task* task) {
+void ThreadPool::AddTask(Thread* self, Task* task, int32_t priority) {
   MutexLock mu(self, task_queue_lock_);
-  tasks_.push_back(task);
+  // Most tasks have the default priority, look for the position from the back.
+  auto it = tasks_.end();
+  while (it != tasks_.begin() && std::prev(it)->priority < priority) {
+    --it;
+  }
+  tasks_.insert(it, QueuedTask { task, priority, NanoTime() });
   // If we have any waiters, signal one.
   if (started_ && waiting_count_ != 0) {
     task_queue_condition_.Signal(self);
@@ -126,6 +152,9 @@ ThreadPool::ThreadPool(const char* name, size_t num_threads, bool create_peers)
     waiting_count_(0),
     start_time_(0),
     total_wait_time_(0),
+    taken_task_count_(0u),
+    total_queueing_time_ns_(0u),
+    max_queueing_time_ns_(0u),
     // Add one since the caller of constructor waits on the barrier too.
     creation_barier_(num_threads + 1),
     max_active_workers_(num_threads),
@@ -213,7 +242,12 @@ Task* ThreadPool::TryGetTask(Thread* self) {
 
 Task* ThreadPool::TryGetTaskLocked() {
   if (HasOutstandingTasks()) {
-    Task* task = tasks_.front();
+    const QueuedTask& queued = tasks_.front();
+    Task* task = queued.task;
+    const uint64_t queueing_time_ns = NanoTime() - queued.queued_time_ns;
+    ++taken_task_count_;
+    total_queueing_time_ns_ += queueing_time_ns;
+    max_queueing_time_ns_ = std::max(max_queueing_time_ns_, queueing_time_ns);
     tasks_.pop_front();
     return task;
   }
@@ -251,4 +285,23 @@ void ThreadPool::SetPthreadPriority(int priority) {
   }
 }
 
+void ThreadPool::SetCpuAffinity(const std::vector<uint32_t>& cpus) {
+  if (cpus.empty()) {
+    return;
+  }
+  for (ThreadPoolWorker* worker : threads_) {
+    worker->SetCpuAffinity(cpus);
+  }
+}
+
+void ThreadPool::DumpQueueingLatency(std::ostream& os) {
+  MutexLock mu(Thread::Current(), task_queue_lock_);
+  if (taken_task_count_ == 0u) {
+    return;
+  }
+  os << name_ << " tasks: " << taken_task_count_
+     << " mean queueing time: " << PrettyDuration(total_queueing_time_ns_ / taken_task_count_)
+     << " max queueing time: " << PrettyDuration(max_queueing_time_ns_) << "\n";
+}
+
 }  // namespace art
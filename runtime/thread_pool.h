@@ -18,6 +18,7 @@
 #define ART_RUNTIME_THREAD_POOL_H_
 
 #include <deque>
+#include <iosfwd>
 #include <vector>
 
 #include "barrier.h"
@@ -62,6 +63,9 @@ class ThreadPoolWorker {
   // Set the "nice" priorty for this worker.
   void SetPthreadPriority(int priority);
 
+  // Restrict this worker to run on the given CPUs.
+  void SetCpuAffinity(const std::vector<uint32_t>& cpus);
+
   Thread* GetThread() const { return thread_; }
 
  protected:
@@ -99,8 +103,9 @@ class ThreadPool {
   void StopWorkers(Thread* self) REQUIRES(!task_queue_lock_);
 
   // Add a new task, the first available started worker will process it. Does not delete the task
-  // after running it, it is the caller's responsibility.
-  void AddTask(Thread* self, Task* task) REQUIRES(!task_queue_lock_);
+  // after running it, it is the caller's responsibility. Tasks of a higher priority are taken
+  // first, tasks of the same priority in the order they were added.
+  void AddTask(Thread* self, Task* task, int32_t priority = 0) REQUIRES(!task_queue_lock_);
 
   // Remove all tasks in the queue.
   void RemoveAllTasks(Thread* self) REQUIRES(!task_queue_lock_);
@@ -132,7 +137,20 @@ class ThreadPool {
   // Set the "nice" priorty for threads in the pool.
   void SetPthreadPriority(int priority);
 
+  // Restrict the threads of the pool to run on the given CPUs, e.g. to keep them off the cores
+  // of latency sensitive threads. An empty list leaves the affinity unchanged.
+  void SetCpuAffinity(const std::vector<uint32_t>& cpus);
+
+  // Dump how long the tasks waited in the queue before a worker took them.
+  void DumpQueueingLatency(std::ostream& os) REQUIRES(!task_queue_lock_);
+
  protected:
+  struct QueuedTask {
+    Task* task;
+    int32_t priority;
+    uint64_t queued_time_ns;
+  };
+
   // get a task to run, blocks if there are no tasks left
   virtual Task* GetTask(Thread* self) REQUIRES(!task_queue_lock_);
 
@@ -157,12 +175,17 @@ class ThreadPool {
   volatile bool shutting_down_ GUARDED_BY(task_queue_lock_);
   // How many worker threads are waiting on the condition.
   volatile size_t waiting_count_ GUARDED_BY(task_queue_lock_);
-  std::deque<Task*> tasks_ GUARDED_BY(task_queue_lock_);
+  // Sorted by decreasing priority.
+  std::deque<QueuedTask> tasks_ GUARDED_BY(task_queue_lock_);
   // TODO: make this immutable/const?
   std::vector<ThreadPoolWorker*> threads_;
   // Work balance detection.
   uint64_t start_time_ GUARDED_BY(task_queue_lock_);
   uint64_t total_wait_time_;
+  // Queueing latency of the tasks taken from the queue.
+  uint64_t taken_task_count_ GUARDED_BY(task_queue_lock_);
+  uint64_t total_queueing_time_ns_ GUARDED_BY(task_queue_lock_);
+  uint64_t max_queueing_time_ns_ GUARDED_BY(task_queue_lock_);
   Barrier creation_barier_;
   size_t max_active_workers_ GUARDED_BY(task_queue_lock_);
   const bool create_peers_;
@@ -17,6 +17,7 @@
 #include "thread_pool.h"
 
 #include <string>
+#include <vector>
 
 #include "atomic.h"
 #include "common_runtime_test.h"
@@ -160,6 +161,38 @@ TEST_F(ThreadPoolTest, RecursiveTest) {
   EXPECT_EQ((1 << depth) - 1, count.LoadSequentiallyConsistent());
 }
 
+class OrderTask : public Task {
+ public:
+  OrderTask(std::vector<int>* order, int id) : order_(order), id_(id) {}
+
+  void Run(Thread* self ATTRIBUTE_UNUSED) {
+    order_->push_back(id_);
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  std::vector<int>* const order_;
+  const int id_;
+};
+
+// Test that the tasks of a higher priority run first, and in order within a priority.
+TEST_F(ThreadPoolTest, PriorityTest) {
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Thread pool test thread pool", 1);
+  std::vector<int> order;
+  thread_pool.AddTask(self, new OrderTask(&order, 0));
+  thread_pool.AddTask(self, new OrderTask(&order, 1), /* priority */ 2);
+  thread_pool.AddTask(self, new OrderTask(&order, 2), /* priority */ -1);
+  thread_pool.AddTask(self, new OrderTask(&order, 3), /* priority */ 2);
+  thread_pool.AddTask(self, new OrderTask(&order, 4));
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, false, false);
+  EXPECT_EQ(std::vector<int>({ 1, 3, 0, 4, 2 }), order);
+}
+
 class PeerTask : public Task {
  public:
   PeerTask() {}
@@ -22,6 +22,7 @@
 #include "android-base/stringprintf.h"
 
 #include "art_method-inl.h"
+#include "barrier.h"
 #include "base/casts.h"
 #include "base/enums.h"
 #include "base/stl_util.h"
@@ -95,7 +96,7 @@ TraceClockSource Trace::default_clock_source_ = kDefaultTraceClockSource;
 
 Trace* volatile Trace::the_trace_ = nullptr;
 pthread_t Trace::sampling_pthread_ = 0U;
-std::unique_ptr<std::vector<ArtMethod*>> Trace::temp_stack_trace_;
+std::atomic<std::vector<ArtMethod*>*> Trace::temp_stack_trace_(nullptr);
 
 // The key identifying the tracer to update instrumentation.
 static constexpr const char* kTracerInstrumentationKey = "Tracer";
@@ -132,13 +133,13 @@ uint32_t Trace::EncodeTraceMethodAndAction(ArtMethod* method, TraceAction action
 }
 
 std::vector<ArtMethod*>* Trace::AllocStackTrace() {
-  return (temp_stack_trace_.get() != nullptr)  ? temp_stack_trace_.release() :
-      new std::vector<ArtMethod*>();
+  std::vector<ArtMethod*>* stack_trace = temp_stack_trace_.exchange(nullptr);
+  return (stack_trace != nullptr) ? stack_trace : new std::vector<ArtMethod*>();
 }
 
 void Trace::FreeStackTrace(std::vector<ArtMethod*>* stack_trace) {
   stack_trace->clear();
-  temp_stack_trace_.reset(stack_trace);
+  delete temp_stack_trace_.exchange(stack_trace);
 }
 
 void Trace::SetDefaultClockSource(TraceClockSource clock_source) {
@@ -234,6 +235,34 @@ static void GetSample(Thread* thread, void* arg) REQUIRES_SHARED(Locks::mutator_
   the_trace->CompareAndUpdateStackTrace(thread, stack_trace);
 }
 
+// Samples the threads without suspending all of them: the runnable threads sample their own
+// stack at their next suspend point, the sampling thread samples the suspended ones.
+class SampleCheckpoint FINAL : public Closure {
+ public:
+  explicit SampleCheckpoint(Trace* trace) : trace_(trace), barrier_(0) {}
+
+  void Run(Thread* thread) OVERRIDE {
+    // Note thread and self may not be equal if thread was already suspended at the point of the
+    // request.
+    Thread* self = Thread::Current();
+    {
+      ScopedObjectAccess soa(self);
+      GetSample(thread, trace_);
+    }
+    barrier_.Pass(self);
+  }
+
+  void WaitForThreadsToRunThroughCheckpoint(size_t threads_running_checkpoint) {
+    Thread* self = Thread::Current();
+    ScopedThreadStateChange tsc(self, kWaitingForCheckPointsToRun);
+    barrier_.Increment(self, threads_running_checkpoint);
+  }
+
+ private:
+  Trace* const trace_;
+  Barrier barrier_;
+};
+
 static void ClearThreadStackTraceAndClockBase(Thread* thread, void* arg ATTRIBUTE_UNUSED) {
   thread->SetTraceClockBase(0);
   std::vector<ArtMethod*>* stack_trace = thread->GetStackTraceSample();
@@ -243,7 +272,6 @@ static void ClearThreadStackTraceAndClockBase(Thread* thread, void* arg ATTRIBUT
 
 void Trace::CompareAndUpdateStackTrace(Thread* thread,
                                        std::vector<ArtMethod*>* stack_trace) {
-  CHECK_EQ(pthread_self(), sampling_pthread_);
   std::vector<ArtMethod*>* old_stack_trace = thread->GetStackTraceSample();
   // Update the thread's stack trace sample.
   thread->SetStackTraceSample(stack_trace);
@@ -301,10 +329,10 @@ void* Trace::RunSamplingThread(void* arg) {
         break;
       }
     }
-    {
-      ScopedSuspendAll ssa(__FUNCTION__);
-      MutexLock mu(self, *Locks::thread_list_lock_);
-      runtime->GetThreadList()->ForEach(GetSample, the_trace);
+    SampleCheckpoint checkpoint(the_trace);
+    size_t threads_running_checkpoint = runtime->GetThreadList()->RunCheckpoint(&checkpoint);
+    if (threads_running_checkpoint != 0) {
+      checkpoint.WaitForThreadsToRunThroughCheckpoint(threads_running_checkpoint);
     }
   }
 
@@ -271,8 +271,9 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   // Sampling thread, non-zero when sampling.
   static pthread_t sampling_pthread_;
 
-  // Used to remember an unused stack trace to avoid re-allocation during sampling.
-  static std::unique_ptr<std::vector<ArtMethod*>> temp_stack_trace_;
+  // Used to remember an unused stack trace to avoid re-allocation during sampling. The threads
+  // sample themselves concurrently, it is exchanged atomically.
+  static std::atomic<std::vector<ArtMethod*>*> temp_stack_trace_;
 
   // File to write trace data out to, null if direct to ddms.
   std::unique_ptr<File> trace_file_;
@@ -19,6 +19,7 @@
 
 #include "common_runtime_test.h"
 #include "dex_file-inl.h"
+#include "oat_file.h"
 #include "scoped_thread_state_change-inl.h"
 #include "type_lookup_table.h"
 #include "utf-inl.h"
@@ -39,6 +40,21 @@ TEST_F(TypeLookupTableTest, CreateLookupTable) {
   ASSERT_EQ(32U, table->RawDataLength());
 }
 
+TEST_F(TypeLookupTableTest, DexFileWithoutOatFile) {
+  ScopedObjectAccess soa(Thread::Current());
+  std::unique_ptr<const DexFile> dex_file(OpenTestDexFile("Lookup"));
+  ASSERT_TRUE(dex_file->GetOatDexFile() == nullptr);
+  dex_file->CreateTypeLookupTable();
+  ASSERT_NE(nullptr, dex_file->GetTypeLookupTable());
+  const char* descriptor = "LAB;";
+  const DexFile::ClassDef* class_def =
+      OatDexFile::FindClassDef(*dex_file, descriptor, ComputeModifiedUtf8Hash(descriptor));
+  ASSERT_EQ(&dex_file->GetClassDef(1U), class_def);
+  descriptor = "LDA;";
+  EXPECT_EQ(nullptr,
+            OatDexFile::FindClassDef(*dex_file, descriptor, ComputeModifiedUtf8Hash(descriptor)));
+}
+
 TEST_P(TypeLookupTableTest, Find) {
   ScopedObjectAccess soa(Thread::Current());
   std::unique_ptr<const DexFile> dex_file(OpenTestDexFile("Lookup"));
@@ -16,6 +16,11 @@
 
 #include "utf.h"
 
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "base/logging.h"
 #include "mirror/array.h"
 #include "mirror/object-inl.h"
@@ -23,6 +28,53 @@
 
 namespace art {
 
+// The number of bytes checked and converted at once by the ASCII fast paths.
+static constexpr size_t kAsciiBlockSize = 16u;
+
+// Returns whether the kAsciiBlockSize bytes at `utf8` are all ASCII.
+ALWAYS_INLINE static inline bool IsAsciiBlock(const char* utf8) {
+#if defined(__SSE2__)
+  __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8));
+  return _mm_movemask_epi8(block) == 0;
+#else
+  uint64_t words[2];
+  static_assert(sizeof(words) == kAsciiBlockSize, "Unexpected block size");
+  memcpy(words, utf8, sizeof(words));
+  return ((words[0] | words[1]) & UINT64_C(0x8080808080808080)) == 0u;
+#endif
+}
+
+// Converts the kAsciiBlockSize ASCII bytes at `utf8` to as many UTF-16 chars.
+ALWAYS_INLINE static inline void ConvertAsciiBlock(uint16_t* utf16_out, const char* utf8) {
+#if defined(__SSE2__)
+  __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8));
+  __m128i zero = _mm_setzero_si128();
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(utf16_out), _mm_unpacklo_epi8(block, zero));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(utf16_out + 8), _mm_unpackhi_epi8(block, zero));
+#else
+  for (size_t i = 0; i != kAsciiBlockSize; ++i) {
+    utf16_out[i] = static_cast<uint8_t>(utf8[i]);
+  }
+#endif
+}
+
+// Returns whether the four bytes at `utf8` are all ASCII.
+ALWAYS_INLINE static inline bool AreFourAsciiChars(const char* utf8) {
+  uint32_t word;
+  memcpy(&word, utf8, sizeof(word));
+  return (word & 0x80808080u) == 0u;
+}
+
+// Returns `hash` updated with the four chars at `chars`, as four steps of hash * 31 + c would.
+// The multiplications do not depend on each other, unlike the steps.
+ALWAYS_INLINE static inline uint32_t HashFourChars(uint32_t hash, const char* chars) {
+  return hash * (31u * 31u * 31u * 31u) +
+         static_cast<uint32_t>(chars[0]) * (31u * 31u * 31u) +
+         static_cast<uint32_t>(chars[1]) * (31u * 31u) +
+         static_cast<uint32_t>(chars[2]) * 31u +
+         static_cast<uint32_t>(chars[3]);
+}
+
 // This is used only from debugger and test code.
 size_t CountModifiedUtf8Chars(const char* utf8) {
   return CountModifiedUtf8Chars(utf8, strlen(utf8));
@@ -47,8 +99,14 @@ size_t CountModifiedUtf8Chars(const char* utf8, size_t byte_count) {
   DCHECK_LE(byte_count, strlen(utf8));
   size_t len = 0;
   const char* end = utf8 + byte_count;
-  for (; utf8 < end; ++utf8) {
-    int ic = *utf8;
+  while (utf8 < end) {
+    if (static_cast<size_t>(end - utf8) >= kAsciiBlockSize && IsAsciiBlock(utf8)) {
+      // A block of one-byte encodings.
+      utf8 += kAsciiBlockSize;
+      len += kAsciiBlockSize;
+      continue;
+    }
+    int ic = *utf8++;
     len++;
     if (LIKELY((ic & 0x80) == 0)) {
       // One-byte encoding.
@@ -96,7 +154,12 @@ void ConvertModifiedUtf8ToUtf16(uint16_t* utf16_data_out, size_t out_chars,
 
   if (LIKELY(out_chars == in_bytes)) {
     // Common case where all characters are ASCII.
-    for (const char *p = in_start; p < in_end;) {
+    const char *p = in_start;
+    for (; static_cast<size_t>(in_end - p) >= kAsciiBlockSize; p += kAsciiBlockSize) {
+      ConvertAsciiBlock(out_p, p);
+      out_p += kAsciiBlockSize;
+    }
+    while (p < in_end) {
       // Safe even if char is signed because ASCII characters always have
       // the high bit cleared.
       *out_p++ = dchecked_integral_cast<uint16_t>(*p++);
@@ -106,6 +169,12 @@ void ConvertModifiedUtf8ToUtf16(uint16_t* utf16_data_out, size_t out_chars,
 
   // String contains non-ASCII characters.
   for (const char *p = in_start; p < in_end;) {
+    if (static_cast<size_t>(in_end - p) >= kAsciiBlockSize && IsAsciiBlock(p)) {
+      ConvertAsciiBlock(out_p, p);
+      p += kAsciiBlockSize;
+      out_p += kAsciiBlockSize;
+      continue;
+    }
     const uint32_t ch = GetUtf16FromUtf8(&p);
     const uint16_t leading = GetLeadingUtf16Char(ch);
     const uint16_t trailing = GetTrailingUtf16Char(ch);
@@ -173,6 +242,13 @@ void ConvertUtf16ToModifiedUtf8(char* utf8_out, size_t byte_count,
 int32_t ComputeUtf16HashFromModifiedUtf8(const char* utf8, size_t utf16_length) {
   uint32_t hash = 0;
   while (utf16_length != 0u) {
+    if (utf16_length >= 4u && AreFourAsciiChars(utf8)) {
+      // Each byte is a UTF-16 char. There is no null before the end of the string.
+      hash = HashFourChars(hash, utf8);
+      utf8 += 4u;
+      utf16_length -= 4u;
+      continue;
+    }
     const uint32_t pair = GetUtf16FromUtf8(&utf8);
     const uint16_t first = GetLeadingUtf16Char(pair);
     hash = hash * 31 + first;
@@ -189,6 +265,10 @@ int32_t ComputeUtf16HashFromModifiedUtf8(const char* utf8, size_t utf16_length)
 
 uint32_t ComputeModifiedUtf8Hash(const char* chars) {
   uint32_t hash = 0;
+  while (chars[0] != '\0' && chars[1] != '\0' && chars[2] != '\0' && chars[3] != '\0') {
+    hash = HashFourChars(hash, chars);
+    chars += 4u;
+  }
   while (*chars != '\0') {
     hash = hash * 31 + *chars++;
   }
@@ -20,6 +20,7 @@
 #include "utf-inl.h"
 
 #include <map>
+#include <string>
 #include <vector>
 
 namespace art {
@@ -113,6 +114,54 @@ TEST_F(UtfTest, CountModifiedUtf8Chars) {
   EXPECT_EQ(2u, CountModifiedUtf8Chars(reinterpret_cast<const char *>(kSurrogateEncoding)));
 }
 
+// Strings long enough for the ASCII fast paths, with non-ASCII chars at every position of
+// their blocks.
+TEST_F(UtfTest, AsciiFastPaths) {
+  static const char kTwoBytes[] = "\xc3\xa9";       // U+00E9.
+  static const char kFourBytes[] = "\xf0\x90\x90\x80";  // U+10400, a surrogate pair.
+  for (size_t length = 0; length != 70; ++length) {
+    for (size_t position = 0; position <= length; ++position) {
+      for (const char* special : { "", kTwoBytes, kFourBytes }) {
+        std::string utf8;
+        std::vector<uint16_t> expected;
+        for (size_t i = 0; i != length; ++i) {
+          if (i == position) {
+            utf8 += special;
+            const char* ptr = special;
+            while (*ptr != '\0') {
+              const uint32_t pair = GetUtf16FromUtf8(&ptr);
+              expected.push_back(GetLeadingUtf16Char(pair));
+              if (GetTrailingUtf16Char(pair) != 0) {
+                expected.push_back(GetTrailingUtf16Char(pair));
+              }
+            }
+          }
+          char c = static_cast<char>('a' + i % 26);
+          utf8 += c;
+          expected.push_back(c);
+        }
+        ASSERT_EQ(expected.size(), CountModifiedUtf8Chars(utf8.c_str(), utf8.size()));
+
+        std::vector<uint16_t> utf16(expected.size());
+        ConvertModifiedUtf8ToUtf16(utf16.data(), utf16.size(), utf8.c_str(), utf8.size());
+        EXPECT_EQ(expected, utf16);
+
+        uint32_t utf8_hash = 0;
+        for (char c : utf8) {
+          utf8_hash = utf8_hash * 31 + c;
+        }
+        EXPECT_EQ(utf8_hash, ComputeModifiedUtf8Hash(utf8.c_str()));
+        uint32_t utf16_hash = 0;
+        for (uint16_t c : expected) {
+          utf16_hash = utf16_hash * 31 + c;
+        }
+        EXPECT_EQ(static_cast<int32_t>(utf16_hash),
+                  ComputeUtf16HashFromModifiedUtf8(utf8.c_str(), expected.size()));
+      }
+    }
+  }
+}
+
 static void AssertConversion(const std::vector<uint16_t>& input,
                              const std::vector<uint8_t>& expected) {
   ASSERT_EQ(expected.size(), CountUtf8Bytes(&input[0], input.size()));
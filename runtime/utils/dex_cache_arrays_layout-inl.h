@@ -32,6 +32,9 @@ inline DexCacheArraysLayout::DexCacheArraysLayout(PointerSize pointer_size,
                                                   const DexFile::Header& header,
                                                   uint32_t num_call_sites)
     : pointer_size_(pointer_size),
+      num_type_ids_(header.type_ids_size_),
+      num_string_ids_(header.string_ids_size_),
+      num_field_ids_(header.field_ids_size_),
       /* types_offset_ is always 0u, so it's constexpr */
       methods_offset_(
           RoundUp(types_offset_ + TypesSize(header.type_ids_size_), MethodsAlignment())),
@@ -75,15 +78,13 @@ constexpr PointerSize GcRootAsPointerSize() {
 }
 
 inline size_t DexCacheArraysLayout::TypeOffset(dex::TypeIndex type_idx) const {
+  const size_t cache_size = mirror::DexCache::TypeCacheSize(num_type_ids_);
   return types_offset_ + ElementOffset(PointerSize::k64,
-                                       type_idx.index_ % mirror::DexCache::kDexCacheTypeCacheSize);
+                                       mirror::DexCache::SlotIndex(type_idx.index_, cache_size));
 }
 
 inline size_t DexCacheArraysLayout::TypesSize(size_t num_elements) const {
-  size_t cache_size = mirror::DexCache::kDexCacheTypeCacheSize;
-  if (num_elements < cache_size) {
-    cache_size = num_elements;
-  }
+  size_t cache_size = mirror::DexCache::TypeCacheSize(num_elements);
   return PairArraySize(GcRootAsPointerSize<mirror::Class>(), cache_size);
 }
 
@@ -108,15 +109,13 @@ inline size_t DexCacheArraysLayout::MethodsAlignment() const {
 }
 
 inline size_t DexCacheArraysLayout::StringOffset(uint32_t string_idx) const {
-  uint32_t string_hash = string_idx % mirror::DexCache::kDexCacheStringCacheSize;
+  const size_t cache_size = mirror::DexCache::StringCacheSize(num_string_ids_);
+  uint32_t string_hash = mirror::DexCache::SlotIndex(string_idx, cache_size);
   return strings_offset_ + ElementOffset(PointerSize::k64, string_hash);
 }
 
 inline size_t DexCacheArraysLayout::StringsSize(size_t num_elements) const {
-  size_t cache_size = mirror::DexCache::kDexCacheStringCacheSize;
-  if (num_elements < cache_size) {
-    cache_size = num_elements;
-  }
+  size_t cache_size = mirror::DexCache::StringCacheSize(num_elements);
   return PairArraySize(GcRootAsPointerSize<mirror::String>(), cache_size);
 }
 
@@ -127,15 +126,13 @@ inline size_t DexCacheArraysLayout::StringsAlignment() const {
 }
 
 inline size_t DexCacheArraysLayout::FieldOffset(uint32_t field_idx) const {
-  uint32_t field_hash = field_idx % mirror::DexCache::kDexCacheFieldCacheSize;
+  const size_t cache_size = mirror::DexCache::FieldCacheSize(num_field_ids_);
+  uint32_t field_hash = mirror::DexCache::SlotIndex(field_idx, cache_size);
   return fields_offset_ + 2u * static_cast<size_t>(pointer_size_) * field_hash;
 }
 
 inline size_t DexCacheArraysLayout::FieldsSize(size_t num_elements) const {
-  size_t cache_size = mirror::DexCache::kDexCacheFieldCacheSize;
-  if (num_elements < cache_size) {
-    cache_size = num_elements;
-  }
+  size_t cache_size = mirror::DexCache::FieldCacheSize(num_elements);
   return PairArraySize(pointer_size_, cache_size);
 }
 
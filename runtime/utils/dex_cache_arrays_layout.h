@@ -33,6 +33,9 @@ class DexCacheArraysLayout {
   DexCacheArraysLayout()
       : /* types_offset_ is always 0u */
         pointer_size_(kRuntimePointerSize),
+        num_type_ids_(0u),
+        num_string_ids_(0u),
+        num_field_ids_(0u),
         methods_offset_(0u),
         strings_offset_(0u),
         fields_offset_(0u),
@@ -120,6 +123,10 @@ class DexCacheArraysLayout {
  private:
   static constexpr size_t types_offset_ = 0u;
   const PointerSize pointer_size_;  // Must be first for construction initialization order.
+  // The numbers of ids, which the sizes of the hashed caches depend on.
+  const size_t num_type_ids_;
+  const size_t num_string_ids_;
+  const size_t num_field_ids_;
   const size_t methods_offset_;
   const size_t strings_offset_;
   const size_t fields_offset_;
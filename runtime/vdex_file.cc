@@ -18,6 +18,7 @@
 
 #include <sys/mman.h>  // For the PROT_* and MAP_* constants.
 
+#include <algorithm>
 #include <memory>
 
 #include "base/bit_utils.h"
@@ -26,6 +27,8 @@
 #include "base/unix_file/fd_file.h"
 #include "dex_file.h"
 #include "dex_to_dex_decompiler.h"
+#include "thread-current-inl.h"
+#include "thread_pool.h"
 
 namespace art {
 
@@ -168,74 +171,139 @@ bool VdexFile::OpenAllDexFiles(std::vector<std::unique_ptr<const DexFile>>* dex_
   return true;
 }
 
-// Utility class to easily iterate over the quickening data.
-class QuickeningInfoIterator {
+// The quickening info table of a dex file, sorted by code item offset.
+class QuickeningInfoTable {
  public:
-  QuickeningInfoIterator(uint32_t dex_file_index,
-                         uint32_t number_of_dex_files,
-                         const ArrayRef<const uint8_t>& quickening_info)
+  QuickeningInfoTable(uint32_t dex_file_index,
+                      uint32_t number_of_dex_files,
+                      const ArrayRef<const uint8_t>& quickening_info)
       : quickening_info_(quickening_info) {
     const unaligned_uint32_t* dex_file_indices = reinterpret_cast<const unaligned_uint32_t*>(
             quickening_info.data() +
             quickening_info.size() -
             number_of_dex_files * sizeof(uint32_t));
-    current_code_item_end_ = (dex_file_index == number_of_dex_files - 1)
+    const unaligned_uint32_t* end = (dex_file_index == number_of_dex_files - 1)
         ? dex_file_indices
         : reinterpret_cast<const unaligned_uint32_t*>(
               quickening_info_.data() + dex_file_indices[dex_file_index + 1]);
-    current_code_item_ptr_ = reinterpret_cast<const uint32_t*>(
+    entries_ = reinterpret_cast<const unaligned_uint32_t*>(
         quickening_info_.data() + dex_file_indices[dex_file_index]);
+    size_ = (end - entries_) / 2u;
   }
 
-  bool Done() const {
-    return current_code_item_ptr_ == current_code_item_end_;
+  size_t Size() const {
+    return size_;
   }
 
-  void Advance() {
-    current_code_item_ptr_ += 2;
+  uint32_t GetCodeItemOffset(size_t index) const {
+    DCHECK_LT(index, size_);
+    return entries_[2u * index];
   }
 
-  uint32_t GetCurrentCodeItemOffset() const {
-    return current_code_item_ptr_[0];
-  }
-
-  const ArrayRef<const uint8_t> GetCurrentQuickeningInfo() const {
+  const ArrayRef<const uint8_t> GetQuickeningInfo(size_t index) const {
+    DCHECK_LT(index, size_);
+    uint32_t info_offset = entries_[2u * index + 1u];
     return ArrayRef<const uint8_t>(
         // Add sizeof(uint32_t) to remove the length from the data pointer.
-        quickening_info_.data() + current_code_item_ptr_[1] + sizeof(uint32_t),
-        *reinterpret_cast<const unaligned_uint32_t*>(
-            quickening_info_.data() + current_code_item_ptr_[1]));
+        quickening_info_.data() + info_offset + sizeof(uint32_t),
+        *reinterpret_cast<const unaligned_uint32_t*>(quickening_info_.data() + info_offset));
+  }
+
+  // Binary search of the code item, returns Size() if it has no quickening info.
+  size_t Find(uint32_t code_item_offset) const {
+    size_t low = 0u;
+    size_t high = size_;
+    while (low != high) {
+      size_t mid = low + (high - low) / 2u;
+      if (GetCodeItemOffset(mid) < code_item_offset) {
+        low = mid + 1u;
+      } else {
+        high = mid;
+      }
+    }
+    return (low != size_ && GetCodeItemOffset(low) == code_item_offset) ? low : size_;
   }
 
  private:
   typedef __attribute__((__aligned__(1))) uint32_t unaligned_uint32_t;
   const ArrayRef<const uint8_t>& quickening_info_;
-  const unaligned_uint32_t* current_code_item_ptr_;
-  const unaligned_uint32_t* current_code_item_end_;
+  const unaligned_uint32_t* entries_;
+  size_t size_;
 
-  DISALLOW_COPY_AND_ASSIGN(QuickeningInfoIterator);
+  DISALLOW_COPY_AND_ASSIGN(QuickeningInfoTable);
+};
+
+// We do not decompile a RETURN_VOID_NO_BARRIER into a RETURN_VOID, as the quickening
+// optimization does not depend on the boot image (the optimization relies on not
+// having final fields in a class, which does not change for an app).
+static constexpr bool kUnquickenReturnInstruction = false;
+
+// The number of code items a task of a parallel unquickening decompiles.
+static constexpr size_t kUnquickenTaskSize = 256u;
+
+class UnquickenTask : public SelfDeletingTask {
+ public:
+  UnquickenTask(const DexFile& dex_file,
+                uint32_t dex_file_index,
+                uint32_t number_of_dex_files,
+                const ArrayRef<const uint8_t>& quickening_info,
+                size_t begin,
+                size_t end)
+      : dex_file_(dex_file),
+        dex_file_index_(dex_file_index),
+        number_of_dex_files_(number_of_dex_files),
+        quickening_info_(quickening_info),
+        begin_(begin),
+        end_(end) {}
+
+  void Run(Thread* self ATTRIBUTE_UNUSED) OVERRIDE {
+    QuickeningInfoTable table(dex_file_index_, number_of_dex_files_, quickening_info_);
+    for (size_t i = begin_; i != end_; ++i) {
+      optimizer::ArtDecompileDEX(*dex_file_.GetCodeItem(table.GetCodeItemOffset(i)),
+                                 table.GetQuickeningInfo(i),
+                                 kUnquickenReturnInstruction);
+    }
+  }
+
+ private:
+  const DexFile& dex_file_;
+  const uint32_t dex_file_index_;
+  const uint32_t number_of_dex_files_;
+  const ArrayRef<const uint8_t> quickening_info_;
+  const size_t begin_;
+  const size_t end_;
+
+  DISALLOW_COPY_AND_ASSIGN(UnquickenTask);
 };
 
 void VdexFile::Unquicken(const std::vector<const DexFile*>& dex_files,
-                         const ArrayRef<const uint8_t>& quickening_info) {
+                         const ArrayRef<const uint8_t>& quickening_info,
+                         ThreadPool* thread_pool) {
   if (quickening_info.size() == 0) {
     // Bail early if there is no quickening info.
     return;
   }
-  // We do not decompile a RETURN_VOID_NO_BARRIER into a RETURN_VOID, as the quickening
-  // optimization does not depend on the boot image (the optimization relies on not
-  // having final fields in a class, which does not change for an app).
-  constexpr bool kDecompileReturnInstruction = false;
+  Thread* self = Thread::Current();
   for (uint32_t i = 0; i < dex_files.size(); ++i) {
-    for (QuickeningInfoIterator it(i, dex_files.size(), quickening_info);
-         !it.Done();
-         it.Advance()) {
-      optimizer::ArtDecompileDEX(
-          *dex_files[i]->GetCodeItem(it.GetCurrentCodeItemOffset()),
-          it.GetCurrentQuickeningInfo(),
-          kDecompileReturnInstruction);
+    QuickeningInfoTable table(i, dex_files.size(), quickening_info);
+    // The table has one entry per code item, the tasks never decompile the same code item.
+    for (size_t begin = 0u; begin < table.Size(); begin += kUnquickenTaskSize) {
+      size_t end = std::min(begin + kUnquickenTaskSize, table.Size());
+      UnquickenTask* task =
+          new UnquickenTask(*dex_files[i], i, dex_files.size(), quickening_info, begin, end);
+      if (thread_pool != nullptr) {
+        thread_pool->AddTask(self, task);
+      } else {
+        task->Run(self);
+        task->Finalize();
+      }
     }
   }
+  if (thread_pool != nullptr) {
+    thread_pool->StartWorkers(self);
+    thread_pool->Wait(self, /* do_work */ true, /* may_hold_locks */ false);
+    thread_pool->StopWorkers(self);
+  }
 }
 
 static constexpr uint32_t kNoDexFile = -1;
@@ -261,7 +329,7 @@ void VdexFile::FullyUnquickenDexFile(const DexFile& target_dex_file,
   }
 
   constexpr bool kDecompileReturnInstruction = true;
-  QuickeningInfoIterator it(dex_index, GetHeader().GetNumberOfDexFiles(), GetQuickeningInfo());
+  QuickeningInfoTable table(dex_index, GetHeader().GetNumberOfDexFiles(), GetQuickeningInfo());
   // Iterate over the class definitions. Even if there is no quickening info,
   // we want to unquicken RETURN_VOID_NO_BARRIER instruction.
   for (uint32_t i = 0; i < target_dex_file.NumClassDefs(); ++i) {
@@ -272,13 +340,12 @@ void VdexFile::FullyUnquickenDexFile(const DexFile& target_dex_file,
            class_it.HasNext();
            class_it.Next()) {
         if (class_it.IsAtMethod() && class_it.GetMethodCodeItem() != nullptr) {
-          uint32_t offset = class_it.GetMethodCodeItemOffset();
-          if (!it.Done() && offset == it.GetCurrentCodeItemOffset()) {
+          size_t index = table.Find(class_it.GetMethodCodeItemOffset());
+          if (index != table.Size()) {
             optimizer::ArtDecompileDEX(
                 *class_it.GetMethodCodeItem(),
-                it.GetCurrentQuickeningInfo(),
+                table.GetQuickeningInfo(index),
                 kDecompileReturnInstruction);
-            it.Advance();
           } else {
             optimizer::ArtDecompileDEX(*class_it.GetMethodCodeItem(),
                                        ArrayRef<const uint8_t>(nullptr, 0),
@@ -302,14 +369,9 @@ const uint8_t* VdexFile::GetQuickenedInfoOf(const DexFile& dex_file,
     return nullptr;
   }
 
-  for (QuickeningInfoIterator it(dex_index, GetHeader().GetNumberOfDexFiles(), GetQuickeningInfo());
-       !it.Done();
-       it.Advance()) {
-    if (code_item_offset == it.GetCurrentCodeItemOffset()) {
-      return it.GetCurrentQuickeningInfo().data();
-    }
-  }
-  return nullptr;
+  QuickeningInfoTable table(dex_index, GetHeader().GetNumberOfDexFiles(), GetQuickeningInfo());
+  size_t index = table.Find(code_item_offset);
+  return (index != table.Size()) ? table.GetQuickeningInfo(index).data() : nullptr;
 }
 
 }  // namespace art
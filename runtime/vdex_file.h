@@ -28,6 +28,7 @@
 namespace art {
 
 class DexFile;
+class ThreadPool;
 
 // VDEX files contain extracted DEX files. The VdexFile class maps the file to
 // memory and provides tools for accessing its individual sections.
@@ -41,7 +42,8 @@ class DexFile;
 //   DEX[D]
 //   QuickeningInfo
 //     uint8[]                     quickening data
-//     unaligned_uint32_t[2][]     table of offsets pair:
+//     unaligned_uint32_t[2][]     table of offsets pair, sorted by code_item_offset for each
+//                                 dex file, with one pair per code item:
 //                                    uint32_t[0] contains code_item_offset
 //                                    uint32_t[1] contains quickening data offset from the start
 //                                                of QuickeningInfo
@@ -72,8 +74,8 @@ class VdexFile {
 
    private:
     static constexpr uint8_t kVdexMagic[] = { 'v', 'd', 'e', 'x' };
-    // Last update: Use set for unverified_classes_.
-    static constexpr uint8_t kVdexVersion[] = { '0', '1', '0', '\0' };
+    // Last update: Sort the quickening info table by code item offset.
+    static constexpr uint8_t kVdexVersion[] = { '0', '1', '3', '\0' };
 
     uint8_t magic_[4];
     uint8_t version_[4];
@@ -142,9 +144,11 @@ class VdexFile {
   bool OpenAllDexFiles(std::vector<std::unique_ptr<const DexFile>>* dex_files,
                        std::string* error_msg);
 
-  // In-place unquicken the given `dex_files` based on `quickening_info`.
+  // In-place unquicken the given `dex_files` based on `quickening_info`. The code items are
+  // split between the workers of `thread_pool` if there is one.
   static void Unquicken(const std::vector<const DexFile*>& dex_files,
-                        const ArrayRef<const uint8_t>& quickening_info);
+                        const ArrayRef<const uint8_t>& quickening_info,
+                        ThreadPool* thread_pool = nullptr);
 
   // Fully unquicken `target_dex_file` based on quickening info stored
   // in this vdex file for `original_dex_file`.
@@ -23,6 +23,7 @@
 #include "base/stl_util.h"
 #include "compiler_callbacks.h"
 #include "dex_file-inl.h"
+#include "dex_instruction-inl.h"
 #include "indenter.h"
 #include "leb128.h"
 #include "mirror/class-inl.h"
@@ -663,6 +664,28 @@ static inline void DecodeUint16Vector(const uint8_t** in,
   }
 }
 
+static inline void EncodeUint64Vector(std::vector<uint8_t>* out,
+                                      const std::vector<uint64_t>& vector) {
+  EncodeUnsignedLeb128(out, vector.size());
+  for (uint64_t entry : vector) {
+    EncodeUnsignedLeb128(out, Low32Bits(entry));
+    EncodeUnsignedLeb128(out, High32Bits(entry));
+  }
+}
+
+static inline void DecodeUint64Vector(const uint8_t** in,
+                                      const uint8_t* end,
+                                      std::vector<uint64_t>* vector) {
+  DCHECK(vector->empty());
+  size_t num_entries = DecodeUint32WithOverflowCheck(in, end);
+  vector->reserve(num_entries);
+  for (size_t i = 0; i < num_entries; ++i) {
+    uint64_t low = DecodeUint32WithOverflowCheck(in, end);
+    uint64_t high = DecodeUint32WithOverflowCheck(in, end);
+    vector->push_back((high << 32) | low);
+  }
+}
+
 static inline void EncodeStringVector(std::vector<uint8_t>* out,
                                       const std::vector<std::string>& strings) {
   EncodeUnsignedLeb128(out, strings.size());
@@ -701,6 +724,7 @@ void VerifierDeps::Encode(const std::vector<const DexFile*>& dex_files,
     EncodeSet(buffer, deps.fields_);
     EncodeSet(buffer, deps.methods_);
     EncodeSet(buffer, deps.unverified_classes_);
+    EncodeUint64Vector(buffer, deps.class_fingerprints_);
   }
 }
 
@@ -724,6 +748,7 @@ VerifierDeps::VerifierDeps(const std::vector<const DexFile*>& dex_files,
     DecodeSet(&data_start, data_end, &deps->fields_);
     DecodeSet(&data_start, data_end, &deps->methods_);
     DecodeSet(&data_start, data_end, &deps->unverified_classes_);
+    DecodeUint64Vector(&data_start, data_end, &deps->class_fingerprints_);
   }
   CHECK_LE(data_start, data_end);
 }
@@ -761,7 +786,8 @@ bool VerifierDeps::DexFileDeps::Equals(const VerifierDeps::DexFileDeps& rhs) con
          (classes_ == rhs.classes_) &&
          (fields_ == rhs.fields_) &&
          (methods_ == rhs.methods_) &&
-         (unverified_classes_ == rhs.unverified_classes_);
+         (unverified_classes_ == rhs.unverified_classes_) &&
+         (class_fingerprints_ == rhs.class_fingerprints_);
 }
 
 void VerifierDeps::Dump(VariableIndentationOutputStream* vios) const {
@@ -1100,5 +1126,508 @@ bool VerifierDeps::VerifyDexFile(Handle<mirror::ClassLoader> class_loader,
   return result;
 }
 
+namespace {
+
+// 64-bit FNV-1a. The fingerprints are kept in the vdex file, they must not depend on the
+// process computing them.
+class FingerprintHasher {
+ public:
+  void Add(uint32_t value) {
+    for (size_t i = 0; i != sizeof(value); ++i) {
+      AddByte(static_cast<uint8_t>(value >> (i * kBitsPerByte)));
+    }
+  }
+
+  void Add(const char* str) {
+    for (; *str != '\0'; ++str) {
+      AddByte(static_cast<uint8_t>(*str));
+    }
+    AddByte(0u);
+  }
+
+  uint64_t Get() const {
+    return hash_;
+  }
+
+ private:
+  void AddByte(uint8_t value) {
+    hash_ = (hash_ ^ value) * UINT64_C(1099511628211);
+  }
+
+  uint64_t hash_ = UINT64_C(14695981039346656037);
+};
+
+// Computes the fingerprints of the classes of a set of dex files. The fingerprint of a class
+// covers its declaration and code, with the symbols its code refers to rather than their
+// indices, which change with any update of the dex file. It also covers the declarations of
+// the classes of the dex files it refers to, and those of their super types: these are the
+// only things in the dex files the verification of the class looked at, the classpath ones
+// being recorded in the VerifierDeps.
+class ClassFingerprints {
+ public:
+  explicit ClassFingerprints(const std::vector<const DexFile*>& dex_files) {
+    for (const DexFile* dex_file : dex_files) {
+      for (uint32_t i = 0; i < dex_file->NumClassDefs(); ++i) {
+        const DexFile::ClassDef& class_def = dex_file->GetClassDef(i);
+        // The first definition of a class is the one loaded.
+        classes_.emplace(dex_file->GetClassDescriptor(class_def),
+                         std::make_pair(dex_file, &class_def));
+      }
+    }
+  }
+
+  // Returns the definition of the class `descriptor` in the dex files, or null.
+  const DexFile::ClassDef* FindClass(const std::string& descriptor,
+                                     const DexFile** dex_file) const {
+    auto it = classes_.find(descriptor);
+    if (it == classes_.end()) {
+      return nullptr;
+    }
+    *dex_file = it->second.first;
+    return it->second.second;
+  }
+
+  // A class with this fingerprint is never reused.
+  static constexpr uint64_t kNoFingerprint = 0u;
+
+  uint64_t GetFingerprint(const DexFile& dex_file, const DexFile::ClassDef& class_def) {
+    bool covered = true;
+    FingerprintHasher hasher;
+    std::set<std::string> referenced;
+    referenced.insert(dex_file.GetClassDescriptor(class_def));
+    AddDeclaration(&hasher, dex_file, class_def, &referenced);
+    const uint8_t* class_data = dex_file.GetClassData(class_def);
+    if (class_data != nullptr) {
+      ClassDataItemIterator it(dex_file, class_data);
+      it.SkipAllFields();
+      for (; it.HasNextDirectMethod() || it.HasNextVirtualMethod(); it.Next()) {
+        const DexFile::CodeItem* code_item = it.GetMethodCodeItem();
+        if (code_item != nullptr) {
+          covered = AddCode(&hasher, dex_file, *code_item, &referenced) && covered;
+        }
+      }
+    }
+    for (const std::string& descriptor : referenced) {
+      hasher.Add(descriptor.c_str());
+      uint64_t fingerprint = GetHierarchyFingerprint(descriptor);
+      hasher.Add(Low32Bits(fingerprint));
+      hasher.Add(High32Bits(fingerprint));
+    }
+    if (!covered) {
+      return kNoFingerprint;
+    }
+    return (hasher.Get() == kNoFingerprint) ? kNoFingerprint + 1u : hasher.Get();
+  }
+
+ private:
+  static void AddType(FingerprintHasher* hasher,
+                      const char* descriptor,
+                      std::set<std::string>* referenced) {
+    hasher->Add(descriptor);
+    if (referenced != nullptr) {
+      while (*descriptor == '[') {
+        ++descriptor;
+      }
+      if (*descriptor == 'L') {
+        referenced->insert(descriptor);
+      }
+    }
+  }
+
+  static void AddType(FingerprintHasher* hasher,
+                      const DexFile& dex_file,
+                      dex::TypeIndex type_idx,
+                      std::set<std::string>* referenced) {
+    AddType(hasher, dex_file.StringByTypeIdx(type_idx), referenced);
+  }
+
+  static void AddProto(FingerprintHasher* hasher,
+                       const DexFile& dex_file,
+                       const DexFile::ProtoId& proto_id,
+                       std::set<std::string>* referenced) {
+    AddType(hasher, dex_file, proto_id.return_type_idx_, referenced);
+    const DexFile::TypeList* parameters = dex_file.GetProtoParameters(proto_id);
+    uint32_t size = (parameters == nullptr) ? 0u : parameters->Size();
+    hasher->Add(size);
+    for (uint32_t i = 0; i < size; ++i) {
+      AddType(hasher, dex_file, parameters->GetTypeItem(i).type_idx_, referenced);
+    }
+  }
+
+  static void AddField(FingerprintHasher* hasher,
+                       const DexFile& dex_file,
+                       uint32_t field_idx,
+                       std::set<std::string>* referenced) {
+    const DexFile::FieldId& field_id = dex_file.GetFieldId(field_idx);
+    AddType(hasher, dex_file, field_id.class_idx_, referenced);
+    hasher->Add(dex_file.GetFieldName(field_id));
+    AddType(hasher, dex_file, field_id.type_idx_, referenced);
+  }
+
+  static void AddMethod(FingerprintHasher* hasher,
+                        const DexFile& dex_file,
+                        uint32_t method_idx,
+                        std::set<std::string>* referenced) {
+    const DexFile::MethodId& method_id = dex_file.GetMethodId(method_idx);
+    AddType(hasher, dex_file, method_id.class_idx_, referenced);
+    hasher->Add(dex_file.GetMethodName(method_id));
+    AddProto(hasher, dex_file, dex_file.GetMethodPrototype(method_id), referenced);
+  }
+
+  // Add the access flags, super types and members of the class.
+  static void AddDeclaration(FingerprintHasher* hasher,
+                             const DexFile& dex_file,
+                             const DexFile::ClassDef& class_def,
+                             std::set<std::string>* referenced) {
+    hasher->Add(dex_file.GetClassDescriptor(class_def));
+    hasher->Add(class_def.access_flags_);
+    if (class_def.superclass_idx_.IsValid()) {
+      AddType(hasher, dex_file, class_def.superclass_idx_, referenced);
+    }
+    const DexFile::TypeList* interfaces = dex_file.GetInterfacesList(class_def);
+    uint32_t num_interfaces = (interfaces == nullptr) ? 0u : interfaces->Size();
+    hasher->Add(num_interfaces);
+    for (uint32_t i = 0; i < num_interfaces; ++i) {
+      AddType(hasher, dex_file, interfaces->GetTypeItem(i).type_idx_, referenced);
+    }
+    const uint8_t* class_data = dex_file.GetClassData(class_def);
+    if (class_data == nullptr) {
+      return;
+    }
+    for (ClassDataItemIterator it(dex_file, class_data); it.HasNext(); it.Next()) {
+      hasher->Add(it.GetRawMemberAccessFlags());
+      if (it.IsAtMethod()) {
+        AddMethod(hasher, dex_file, it.GetMemberIndex(), referenced);
+      } else {
+        AddField(hasher, dex_file, it.GetMemberIndex(), referenced);
+      }
+    }
+  }
+
+  // Returns false if the fingerprint does not cover all the code.
+  static bool AddCode(FingerprintHasher* hasher,
+                      const DexFile& dex_file,
+                      const DexFile::CodeItem& code_item,
+                      std::set<std::string>* referenced) {
+    bool covered = true;
+    hasher->Add(code_item.registers_size_);
+    hasher->Add(code_item.ins_size_);
+    hasher->Add(code_item.outs_size_);
+    hasher->Add(code_item.insns_size_in_code_units_);
+    for (uint32_t dex_pc = 0; dex_pc < code_item.insns_size_in_code_units_;) {
+      const Instruction* inst = Instruction::At(code_item.insns_ + dex_pc);
+      const size_t size = inst->SizeInCodeUnits();
+      // The code units holding the indices: the second one, or the second and third for
+      // the 32-bit indices, and the fourth for the proto of the polymorphic invokes.
+      uint32_t index_units = 0u;
+      switch (Instruction::IndexTypeOf(inst->Opcode())) {
+        case Instruction::kIndexTypeRef:
+        case Instruction::kIndexStringRef:
+        case Instruction::kIndexMethodRef:
+        case Instruction::kIndexFieldRef:
+        case Instruction::kIndexMethodAndProtoRef:
+        case Instruction::kIndexCallSiteRef:
+          index_units = (Instruction::FormatOf(inst->Opcode()) == Instruction::k31c)
+              ? 0x6u
+              : (inst->HasVRegH() ? 0xau : 0x2u);
+          break;
+        default:
+          break;
+      }
+      for (size_t i = 0; i != size; ++i) {
+        hasher->Add(((index_units >> i) & 1u) != 0u ? 0u : code_item.insns_[dex_pc + i]);
+      }
+      switch (Instruction::IndexTypeOf(inst->Opcode())) {
+        case Instruction::kIndexTypeRef:
+          AddType(hasher, dex_file, dex::TypeIndex(GetIndex(inst)), referenced);
+          break;
+        case Instruction::kIndexStringRef:
+          hasher->Add(dex_file.StringDataByIdx(dex::StringIndex(GetIndex(inst))));
+          break;
+        case Instruction::kIndexMethodRef:
+          AddMethod(hasher, dex_file, GetIndex(inst), referenced);
+          break;
+        case Instruction::kIndexFieldRef:
+          AddField(hasher, dex_file, GetIndex(inst), referenced);
+          break;
+        case Instruction::kIndexMethodAndProtoRef:
+          AddMethod(hasher, dex_file, GetIndex(inst), referenced);
+          AddProto(hasher,
+                   dex_file,
+                   dex_file.GetProtoId(dchecked_integral_cast<uint16_t>(inst->VRegH())),
+                   referenced);
+          break;
+        case Instruction::kIndexCallSiteRef:
+          // The call sites are not covered, the class is verified again every time.
+          covered = false;
+          break;
+        default:
+          break;
+      }
+      dex_pc += size;
+    }
+    hasher->Add(code_item.tries_size_);
+    for (uint32_t i = 0; i < code_item.tries_size_; ++i) {
+      const DexFile::TryItem* try_item = DexFile::GetTryItems(code_item, i);
+      hasher->Add(try_item->start_addr_);
+      hasher->Add(try_item->insn_count_);
+      for (CatchHandlerIterator it(code_item, *try_item); it.HasNext(); it.Next()) {
+        if (it.GetHandlerTypeIndex().IsValid()) {
+          AddType(hasher, dex_file, it.GetHandlerTypeIndex(), referenced);
+        } else {
+          hasher->Add("");
+        }
+        hasher->Add(it.GetHandlerAddress());
+      }
+    }
+    return covered;
+  }
+
+  static uint32_t GetIndex(const Instruction* inst) {
+    return static_cast<uint32_t>((Instruction::FormatOf(inst->Opcode()) == Instruction::k22c)
+        ? inst->VRegC()
+        : inst->VRegB());
+  }
+
+  // Returns the fingerprint of the declarations of the class `descriptor` and of its super
+  // types in the dex files, or 0 if the class is not in the dex files.
+  uint64_t GetHierarchyFingerprint(const std::string& descriptor) {
+    auto it = hierarchy_fingerprints_.find(descriptor);
+    if (it != hierarchy_fingerprints_.end()) {
+      return it->second;
+    }
+    const DexFile* dex_file = nullptr;
+    const DexFile::ClassDef* class_def = FindClass(descriptor, &dex_file);
+    if (class_def == nullptr) {
+      hierarchy_fingerprints_.emplace(descriptor, 0u);
+      return 0u;
+    }
+    // A circular hierarchy, which the class linker rejects, only needs a deterministic value.
+    hierarchy_fingerprints_.emplace(descriptor, 0u);
+    FingerprintHasher hasher;
+    std::set<std::string> super_types;
+    AddDeclaration(&hasher, *dex_file, *class_def, /* referenced */ nullptr);
+    if (class_def->superclass_idx_.IsValid()) {
+      super_types.insert(dex_file->StringByTypeIdx(class_def->superclass_idx_));
+    }
+    const DexFile::TypeList* interfaces = dex_file->GetInterfacesList(*class_def);
+    for (uint32_t i = 0; interfaces != nullptr && i < interfaces->Size(); ++i) {
+      super_types.insert(dex_file->StringByTypeIdx(interfaces->GetTypeItem(i).type_idx_));
+    }
+    for (const std::string& super_type : super_types) {
+      uint64_t fingerprint = GetHierarchyFingerprint(super_type);
+      hasher.Add(Low32Bits(fingerprint));
+      hasher.Add(High32Bits(fingerprint));
+    }
+    hierarchy_fingerprints_[descriptor] = hasher.Get();
+    return hasher.Get();
+  }
+
+  std::map<std::string, std::pair<const DexFile*, const DexFile::ClassDef*>> classes_;
+  std::map<std::string, uint64_t> hierarchy_fingerprints_;
+};
+
+}  // namespace
+
+void VerifierDeps::RecordClassFingerprints(const std::vector<const DexFile*>& dex_files) {
+  ClassFingerprints fingerprints(dex_files);
+  for (const DexFile* dex_file : dex_files) {
+    DexFileDeps* deps = GetDexFileDeps(*dex_file);
+    DCHECK(deps != nullptr);
+    deps->class_fingerprints_.clear();
+    deps->class_fingerprints_.reserve(dex_file->NumClassDefs());
+    for (uint32_t i = 0; i < dex_file->NumClassDefs(); ++i) {
+      deps->class_fingerprints_.push_back(
+          fingerprints.GetFingerprint(*dex_file, dex_file->GetClassDef(i)));
+    }
+  }
+}
+
+bool VerifierDeps::FindUnchangedClasses(Handle<mirror::ClassLoader> class_loader,
+                                        const std::vector<const DexFile*>& old_dex_files,
+                                        const std::vector<const DexFile*>& new_dex_files,
+                                        std::vector<std::map<uint32_t, bool>>* unchanged_classes,
+                                        Thread* self) const {
+  unchanged_classes->clear();
+  if (old_dex_files.size() != new_dex_files.size()) {
+    return false;
+  }
+  for (const DexFile* dex_file : old_dex_files) {
+    const DexFileDeps* deps = GetDexFileDeps(*dex_file);
+    if (deps == nullptr || deps->class_fingerprints_.size() != dex_file->NumClassDefs()) {
+      return false;
+    }
+  }
+  if (!ValidateDependencies(class_loader, self)) {
+    return false;
+  }
+
+  // The classes only keep their verification in the same dex file.
+  std::map<std::string, std::pair<size_t, uint32_t>> old_classes;
+  for (size_t i = 0; i != old_dex_files.size(); ++i) {
+    for (uint32_t j = 0; j < old_dex_files[i]->NumClassDefs(); ++j) {
+      const DexFile::ClassDef& class_def = old_dex_files[i]->GetClassDef(j);
+      old_classes.emplace(old_dex_files[i]->GetClassDescriptor(class_def), std::make_pair(i, j));
+    }
+  }
+  ClassFingerprints fingerprints(new_dex_files);
+  unchanged_classes->resize(new_dex_files.size());
+  for (size_t i = 0; i != new_dex_files.size(); ++i) {
+    const DexFile& dex_file = *new_dex_files[i];
+    for (uint32_t j = 0; j < dex_file.NumClassDefs(); ++j) {
+      const DexFile::ClassDef& class_def = dex_file.GetClassDef(j);
+      const char* descriptor = dex_file.GetClassDescriptor(class_def);
+      const DexFile* defining_dex_file = nullptr;
+      auto it = old_classes.find(descriptor);
+      if (fingerprints.FindClass(descriptor, &defining_dex_file) != &class_def ||
+          it == old_classes.end() ||
+          it->second.first != i) {
+        continue;
+      }
+      const DexFile& old_dex_file = *old_dex_files[i];
+      const DexFileDeps& old_deps = *GetDexFileDeps(old_dex_file);
+      uint64_t old_fingerprint = old_deps.class_fingerprints_[it->second.second];
+      if (old_fingerprint != ClassFingerprints::kNoFingerprint &&
+          old_fingerprint == fingerprints.GetFingerprint(dex_file, class_def)) {
+        dex::TypeIndex old_type_idx = old_dex_file.GetClassDef(it->second.second).class_idx_;
+        bool verified = (old_deps.unverified_classes_.find(old_type_idx) ==
+                         old_deps.unverified_classes_.end());
+        (*unchanged_classes)[i].emplace(j, verified);
+      }
+    }
+  }
+
+  // A class is verified after its super types, which must not be verified again either.
+  std::map<const DexFile*, size_t> dex_file_indices;
+  for (size_t i = 0; i != new_dex_files.size(); ++i) {
+    dex_file_indices.emplace(new_dex_files[i], i);
+  }
+  auto is_unchanged = [&](const DexFile& dex_file, dex::TypeIndex type_idx) {
+    const DexFile* defining_dex_file = nullptr;
+    const DexFile::ClassDef* class_def =
+        fingerprints.FindClass(dex_file.StringByTypeIdx(type_idx), &defining_dex_file);
+    if (class_def == nullptr) {
+      // In the classpath.
+      return true;
+    }
+    const std::map<uint32_t, bool>& classes =
+        (*unchanged_classes)[dex_file_indices[defining_dex_file]];
+    return classes.find(defining_dex_file->GetIndexForClassDef(*class_def)) != classes.end();
+  };
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (size_t i = 0; i != new_dex_files.size(); ++i) {
+      const DexFile& dex_file = *new_dex_files[i];
+      std::map<uint32_t, bool>& classes = (*unchanged_classes)[i];
+      for (auto it = classes.begin(); it != classes.end();) {
+        const DexFile::ClassDef& class_def = dex_file.GetClassDef(it->first);
+        bool super_types_unchanged =
+            !class_def.superclass_idx_.IsValid() ||
+            is_unchanged(dex_file, class_def.superclass_idx_);
+        const DexFile::TypeList* interfaces = dex_file.GetInterfacesList(class_def);
+        for (uint32_t j = 0; super_types_unchanged && interfaces != nullptr &&
+                             j < interfaces->Size(); ++j) {
+          super_types_unchanged = is_unchanged(dex_file, interfaces->GetTypeItem(j).type_idx_);
+        }
+        if (super_types_unchanged) {
+          ++it;
+        } else {
+          it = classes.erase(it);
+          changed = true;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Returns the id in `new_dex_file` of the type `type_idx` of `old_dex_file`, or null.
+static const DexFile::TypeId* FindTypeId(const DexFile& new_dex_file,
+                                         const DexFile& old_dex_file,
+                                         dex::TypeIndex type_idx) {
+  return new_dex_file.FindTypeId(old_dex_file.StringByTypeIdx(type_idx));
+}
+
+void VerifierDeps::MergeUnchangedDependencies(const VerifierDeps& reference,
+                                              const std::vector<const DexFile*>& old_dex_files,
+                                              const std::vector<const DexFile*>& new_dex_files) {
+  DCHECK_EQ(old_dex_files.size(), new_dex_files.size());
+  for (size_t i = 0; i != new_dex_files.size(); ++i) {
+    const DexFile& old_dex_file = *old_dex_files[i];
+    const DexFile& new_dex_file = *new_dex_files[i];
+    const DexFileDeps& old_deps = *reference.GetDexFileDeps(old_dex_file);
+    DexFileDeps* deps = GetDexFileDeps(new_dex_file);
+    DCHECK(deps != nullptr);
+    auto translate_string = [&](dex::StringIndex string_idx) {
+      return GetIdFromString(new_dex_file, reference.GetStringFromId(old_dex_file, string_idx));
+    };
+    auto translate_declaring_class = [&](dex::StringIndex string_idx) {
+      return (string_idx.index_ == kUnresolvedMarker) ? string_idx : translate_string(string_idx);
+    };
+
+    for (const TypeAssignability& entry : old_deps.assignable_types_) {
+      deps->assignable_types_.emplace(translate_string(entry.GetDestination()),
+                                      translate_string(entry.GetSource()));
+    }
+    for (const TypeAssignability& entry : old_deps.unassignable_types_) {
+      deps->unassignable_types_.emplace(translate_string(entry.GetDestination()),
+                                        translate_string(entry.GetSource()));
+    }
+    for (const ClassResolution& entry : old_deps.classes_) {
+      const DexFile::TypeId* type_id =
+          FindTypeId(new_dex_file, old_dex_file, entry.GetDexTypeIndex());
+      if (type_id != nullptr) {
+        deps->classes_.emplace(new_dex_file.GetIndexForTypeId(*type_id), entry.GetAccessFlags());
+      }
+    }
+    for (const FieldResolution& entry : old_deps.fields_) {
+      const DexFile::FieldId& old_field_id = old_dex_file.GetFieldId(entry.GetDexFieldIndex());
+      const DexFile::TypeId* class_id =
+          FindTypeId(new_dex_file, old_dex_file, old_field_id.class_idx_);
+      const DexFile::StringId* name_id =
+          new_dex_file.FindStringId(old_dex_file.GetFieldName(old_field_id));
+      const DexFile::TypeId* type_id =
+          FindTypeId(new_dex_file, old_dex_file, old_field_id.type_idx_);
+      const DexFile::FieldId* field_id = (class_id == nullptr || name_id == nullptr ||
+                                          type_id == nullptr)
+          ? nullptr
+          : new_dex_file.FindFieldId(*class_id, *name_id, *type_id);
+      if (field_id != nullptr) {
+        deps->fields_.emplace(new_dex_file.GetIndexForFieldId(*field_id),
+                              entry.GetAccessFlags(),
+                              translate_declaring_class(entry.GetDeclaringClassIndex()));
+      }
+    }
+    for (const MethodResolution& entry : old_deps.methods_) {
+      const DexFile::MethodId& old_method_id =
+          old_dex_file.GetMethodId(entry.GetDexMethodIndex());
+      const DexFile::TypeId* class_id =
+          FindTypeId(new_dex_file, old_dex_file, old_method_id.class_idx_);
+      const DexFile::StringId* name_id =
+          new_dex_file.FindStringId(old_dex_file.GetMethodName(old_method_id));
+      dex::TypeIndex return_type_idx;
+      std::vector<dex::TypeIndex> parameter_type_idxs;
+      if (class_id == nullptr ||
+          name_id == nullptr ||
+          !new_dex_file.CreateTypeList(
+              old_dex_file.GetMethodSignature(old_method_id).ToString(),
+              &return_type_idx,
+              &parameter_type_idxs)) {
+        continue;
+      }
+      const DexFile::ProtoId* proto_id = new_dex_file.FindProtoId(
+          return_type_idx, parameter_type_idxs.data(), parameter_type_idxs.size());
+      const DexFile::MethodId* method_id = (proto_id == nullptr)
+          ? nullptr
+          : new_dex_file.FindMethodId(*class_id, *name_id, *proto_id);
+      if (method_id != nullptr) {
+        deps->methods_.emplace(new_dex_file.GetIndexForMethodId(*method_id),
+                               entry.GetAccessFlags(),
+                               translate_declaring_class(entry.GetDeclaringClassIndex()));
+      }
+    }
+  }
+}
+
 }  // namespace verifier
 }  // namespace art
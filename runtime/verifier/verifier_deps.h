@@ -125,6 +125,32 @@ class VerifierDeps {
     return output_only_;
   }
 
+  // Record the fingerprints of the classes of `dex_files`, which cover the code of each class
+  // and the declarations of the classes of `dex_files` its verification depends on. They let
+  // a later version of the dex files reuse the verification of the classes that did not change.
+  void RecordClassFingerprints(const std::vector<const DexFile*>& dex_files);
+
+  // Find the classes of `new_dex_files`, an update of the `old_dex_files` this `VerifierDeps`
+  // was decoded for, whose fingerprint did not change, and whose super types did not change
+  // either. `unchanged_classes` maps the class def indices of each of `new_dex_files` to
+  // whether the class was verified, rather than left to verify at runtime. Returns false if the
+  // classpath dependencies no longer hold, in which case no class can be reused.
+  bool FindUnchangedClasses(Handle<mirror::ClassLoader> class_loader,
+                            const std::vector<const DexFile*>& old_dex_files,
+                            const std::vector<const DexFile*>& new_dex_files,
+                            std::vector<std::map<uint32_t, bool>>* unchanged_classes,
+                            Thread* self) const
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Add the classpath dependencies of `reference`, decoded for `old_dex_files`, to the ones
+  // of `new_dex_files`, for the classes reused with FindUnchangedClasses. A dependency that
+  // cannot be expressed in the new dex files is dropped: the unchanged classes still refer
+  // to everything they depend on, so it was recorded for a class that changed.
+  void MergeUnchangedDependencies(const VerifierDeps& reference,
+                                  const std::vector<const DexFile*>& old_dex_files,
+                                  const std::vector<const DexFile*>& new_dex_files)
+      REQUIRES(!Locks::verifier_deps_lock_);
+
  private:
   static constexpr uint16_t kUnresolvedMarker = static_cast<uint16_t>(-1);
 
@@ -199,6 +225,9 @@ class VerifierDeps {
     // List of classes that were not fully verified in that dex file.
     std::set<dex::TypeIndex> unverified_classes_;
 
+    // Fingerprint of each class def of the dex file, or nothing if they were not recorded.
+    std::vector<uint64_t> class_fingerprints_;
+
     bool Equals(const DexFileDeps& rhs) const;
   };
 
@@ -334,6 +363,7 @@ class VerifierDeps {
   ART_FRIEND_TEST(VerifierDepsTest, StringToId);
   ART_FRIEND_TEST(VerifierDepsTest, EncodeDecode);
   ART_FRIEND_TEST(VerifierDepsTest, EncodeDecodeMulti);
+  ART_FRIEND_TEST(VerifierDepsTest, UnchangedClasses);
   ART_FRIEND_TEST(VerifierDepsTest, VerifyDeps);
   ART_FRIEND_TEST(VerifierDepsTest, CompilerDriver);
 };
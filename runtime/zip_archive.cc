@@ -18,11 +18,13 @@
 
 #include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/mman.h>  // For the PROT_* and MAP_* constants.
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <vector>
+#include <zlib.h>
 
 #include "android-base/stringprintf.h"
 #include "ziparchive/zip_archive.h"
@@ -58,7 +60,51 @@ ZipEntry::~ZipEntry() {
   delete zip_entry_;
 }
 
+bool ZipEntry::CopyStoredToFile(File& file, std::string* error_msg) {
+  const int zip_fd = GetFileDescriptor(handle_);
+  const off_t start_offset = lseek(file.Fd(), 0, SEEK_CUR);
+  if (zip_fd < 0 || start_offset == static_cast<off_t>(-1)) {
+    return false;
+  }
+  std::string map_error_msg;
+  std::unique_ptr<MemMap> map(MapDirectlyFromFile(entry_name_.c_str(), &map_error_msg));
+  if (map == nullptr) {
+    return false;
+  }
+  const uint32_t crc = crc32(crc32(0L, Z_NULL, 0), map->Begin(), map->Size());
+  if (crc != GetCrc32()) {
+    *error_msg = StringPrintf("Entry '%s' has a bad CRC (0x%08x != 0x%08x)",
+                              entry_name_.c_str(),
+                              crc,
+                              GetCrc32());
+    return false;
+  }
+  File zip_file(zip_fd, /* check_usage */ false);
+  bool copied = file.Copy(&zip_file, zip_entry_->offset, GetUncompressedLength());
+  zip_file.Release();  // The descriptor belongs to the archive.
+  if (!copied) {
+    if (file.SetLength(start_offset) != 0 || lseek(file.Fd(), start_offset, SEEK_SET) == -1) {
+      *error_msg = StringPrintf("Failed to undo the partial copy of '%s': %s",
+                                entry_name_.c_str(),
+                                strerror(errno));
+    }
+    return false;
+  }
+  return true;
+}
+
 bool ZipEntry::ExtractToFile(File& file, std::string* error_msg) {
+  if (IsUncompressed() && zip_entry_->uncompressed_length == zip_entry_->compressed_length) {
+    std::string copy_error_msg;
+    if (CopyStoredToFile(file, &copy_error_msg)) {
+      return true;
+    }
+    if (!copy_error_msg.empty()) {
+      *error_msg = copy_error_msg;
+      return false;
+    }
+    // Fall back to extracting through a buffer.
+  }
   const int32_t error = ExtractEntryToFile(handle_, zip_entry_, file.Fd());
   if (error) {
     *error_msg = std::string(ErrorCodeString(error));
@@ -61,6 +61,11 @@ class ZipEntry {
   bool IsAlignedTo(size_t alignment);
 
  private:
+  // Copy a stored entry to `file` in the kernel, checking its CRC on a mapping of the archive
+  // instead of reading it through a buffer. Returns false and leaves `file` unchanged if the
+  // copy cannot be done this way, or sets `error_msg` if the entry is corrupted.
+  bool CopyStoredToFile(File& file, std::string* error_msg);
+
   ZipEntry(ZipArchiveHandle handle,
            ::ZipEntry* zip_entry,
            const std::string& entry_name)
@@ -16,6 +16,7 @@
 
 import junit.framework.Assert;
 import java.util.Arrays;
+import java.util.zip.CRC32;
 import java.lang.reflect.Method;
 
 public class Main {
@@ -69,6 +70,11 @@ public class Main {
     test_StrictMath_round_F();
     test_String_charAt();
     test_String_compareTo();
+    test_String_compareTo_lengths();
+    test_Arrays_equals();
+    test_System_arraycopy();
+    test_CRC32();
+    test_System_identityHashCode();
     test_String_indexOf();
     test_String_isEmpty();
     test_String_length();
@@ -460,6 +466,135 @@ public class Main {
     Assert.assertEquals("this is a path", test.replace("/", " "));
   }
 
+  // Compare strings differing at each position, around the sizes of the vector blocks.
+  public static void test_String_compareTo_lengths() {
+    for (char base : new char[] { 'a', '\u0101' }) {   // Compressed and uncompressed.
+      for (int length = 0; length <= 70; length++) {
+        char[] chars = new char[length];
+        Arrays.fill(chars, base);
+        String str = new String(chars);
+        String same = new String(chars);
+        Assert.assertTrue(str.equals(same));
+        Assert.assertEquals(str.compareTo(same), 0);
+        String longer = str + base;
+        Assert.assertFalse(str.equals(longer));
+        Assert.assertEquals(str.compareTo(longer), -1);
+        Assert.assertEquals(longer.compareTo(str), 1);
+        for (int diff = 0; diff < length; diff++) {
+          chars[diff] = (char) (base + 3);
+          String other = new String(chars);
+          chars[diff] = base;
+          Assert.assertFalse(str.equals(other));
+          Assert.assertFalse(other.equals(str));
+          Assert.assertEquals(str.compareTo(other), -3);
+          Assert.assertEquals(other.compareTo(str), 3);
+          Assert.assertEquals(other.compareTo(longer), 3);
+        }
+      }
+    }
+    // Different compressions.
+    Assert.assertTrue("abc".compareTo("ab\u0101") < 0);
+    Assert.assertTrue("ab\u0101".compareTo("abc") > 0);
+    Assert.assertFalse("abc".equals("ab\u0101"));
+  }
+
+  public static void test_Arrays_equals() {
+    byte[] nullArray = null;
+    Assert.assertTrue(Arrays.equals(nullArray, nullArray));
+    Assert.assertFalse(Arrays.equals(new byte[0], nullArray));
+    Assert.assertFalse(Arrays.equals(nullArray, new byte[0]));
+    Assert.assertTrue(Arrays.equals(new byte[0], new byte[0]));
+    for (int length = 1; length <= 70; length++) {
+      byte[] array = new byte[length];
+      for (int i = 0; i < length; i++) {
+        array[i] = (byte) (i * 7);
+      }
+      byte[] same = array.clone();
+      Assert.assertTrue(Arrays.equals(array, array));
+      Assert.assertTrue(Arrays.equals(array, same));
+      Assert.assertFalse(Arrays.equals(array, new byte[length + 1]));
+      for (int diff = 0; diff < length; diff++) {
+        same[diff]++;
+        Assert.assertFalse(Arrays.equals(array, same));
+        Assert.assertFalse(Arrays.equals(same, array));
+        same[diff]--;
+      }
+    }
+  }
+
+  public static void test_CRC32() {
+    CRC32 crc = new CRC32();
+    crc.update("123456789".getBytes());
+    Assert.assertEquals(crc.getValue(), 0xcbf43926L);
+    // The lengths cover the byte, word, block and 4 block loops of the folding.
+    byte[] bytes = new byte[1000];
+    for (int i = 0; i < bytes.length; i++) {
+      bytes[i] = (byte) (i * 31 + 7);
+    }
+    for (int length = 0; length <= 300; length++) {
+      CRC32 whole = new CRC32();
+      whole.update(bytes, 3, length);
+      CRC32 split = new CRC32();
+      split.update(bytes, 3, length / 3);
+      split.update(bytes, 3 + length / 3, length - length / 3);
+      CRC32 single = new CRC32();
+      for (int i = 0; i < length; i++) {
+        single.update(bytes[3 + i]);
+      }
+      Assert.assertEquals(whole.getValue(), split.getValue());
+      Assert.assertEquals(whole.getValue(), single.getValue());
+      if (length == 300) {
+        Assert.assertEquals(whole.getValue(), 0x478cb815L);
+      }
+    }
+    crc.reset();
+    crc.update(bytes);
+    Assert.assertEquals(crc.getValue(), 0x8902161eL);
+  }
+
+  public static void test_System_identityHashCode() {
+    Assert.assertEquals(System.identityHashCode(null), 0);
+    Object unlocked = new Object();
+    int hash = System.identityHashCode(unlocked);
+    Assert.assertEquals(System.identityHashCode(unlocked), hash);
+    // The hash code of an object first hashed while locked stays the same once it is unlocked.
+    Object locked = new Object();
+    int lockedHash;
+    synchronized (locked) {
+      lockedHash = System.identityHashCode(locked);
+      Assert.assertEquals(System.identityHashCode(locked), lockedHash);
+    }
+    Assert.assertEquals(System.identityHashCode(locked), lockedHash);
+    Assert.assertEquals(locked.hashCode(), lockedHash);
+  }
+
+  public static void test_System_arraycopy() {
+    // The lengths cover the inline, REP MOVS and non-temporal copies.
+    int[] lengths = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 100, 1000, 1 << 20 };
+    for (int length : lengths) {
+      byte[] bytes = new byte[length + 2];
+      int[] ints = new int[length + 2];
+      long[] longs = new long[length + 2];
+      for (int i = 0; i < length + 2; i++) {
+        bytes[i] = (byte) (i * 3);
+        ints[i] = i * 5;
+        longs[i] = i * 7L;
+      }
+      byte[] bytesCopy = new byte[length + 2];
+      int[] intsCopy = new int[length + 2];
+      long[] longsCopy = new long[length + 2];
+      System.arraycopy(bytes, 1, bytesCopy, 1, length);
+      System.arraycopy(ints, 1, intsCopy, 1, length);
+      System.arraycopy(longs, 1, longsCopy, 1, length);
+      for (int i = 0; i < length + 2; i++) {
+        boolean copied = i != 0 && i != length + 1;
+        Assert.assertEquals(bytesCopy[i], copied ? bytes[i] : 0);
+        Assert.assertEquals(intsCopy[i], copied ? ints[i] : 0);
+        Assert.assertEquals(longsCopy[i], copied ? longs[i] : 0L);
+      }
+    }
+  }
+
   public static void test_Math_abs_I() {
     Math.abs(-1);
     Assert.assertEquals(Math.abs(0), 0);
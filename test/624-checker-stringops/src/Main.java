@@ -91,7 +91,7 @@ public class Main {
   /// CHECK-DAG: <<String:l\d+>> NullCheck                                        loop:<<Loop:B\d+>> outer_loop:none
   /// CHECK-DAG:                 InvokeVirtual [<<String>>,{{l\d+}}] intrinsic:StringStringIndexOf loop:<<Loop>> outer_loop:none
 
-  /// CHECK-START: int Main.indexOfExceptions(java.lang.String, java.lang.String) GVN_after_peeling (after)
+  /// CHECK-START: int Main.indexOfExceptions(java.lang.String, java.lang.String) partial_redundancy_elimination (after)
   /// CHECK-DAG: <<String:l\d+>> NullCheck     loop:none
   /// CHECK-DAG:                 InvokeVirtual [<<String>>,{{l\d+}}] intrinsic:StringStringIndexOf loop:none 
 
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+*
+* Expected result: sinking of exact floating-point sums, of affine recurrences, and of
+* accumulators summing another accumulator, for trip counts beyond the threshold
+*
+**/
+
+public class Main {
+    final int iterations = 100000;
+
+    public double testDoubleSum() {
+        double testVar = 2.0d;
+        for (int i = 0; i < iterations; i++) {
+            testVar += 3.0d;
+        }
+        return testVar;
+    }
+
+    public float testFloatSub() {
+        float testVar = 1000.0f;
+        for (int i = 0; i < iterations; i++) {
+            testVar -= 7.0f;
+        }
+        return testVar;
+    }
+
+    public int testIntAffine() {
+        int testVar = 1;
+        for (int i = 0; i < iterations; i++) {
+            testVar = testVar * 3 + 1;
+        }
+        return testVar;
+    }
+
+    public long testLongAffine() {
+        long testVar = 7L;
+        for (int i = 0; i < iterations; i++) {
+            testVar = testVar * 5L - 3L;
+        }
+        return testVar;
+    }
+
+    public int testSumOfIV() {
+        int testVar = 0;
+        for (int i = 0; i < iterations; i++) {
+            testVar += i;
+        }
+        return testVar;
+    }
+
+    public long testSumOfAccumulator(long n) {
+        long testVar = n;
+        long step = 3L;
+        for (int i = 0; i < iterations; i++) {
+            step += 2L;
+            testVar -= step;
+        }
+        return testVar + step;
+    }
+
+    public static void main(String[] args) {
+        Main test = new Main();
+        System.out.println(test.testDoubleSum());
+        System.out.println(test.testFloatSub());
+        System.out.println(test.testIntAffine());
+        System.out.println(test.testLongAffine());
+        System.out.println(test.testSumOfIV());
+        System.out.println(test.testSumOfAccumulator(10L));
+    }
+}
@@ -0,0 +1,65 @@
+
+public class Main
+{
+    public class A
+    {
+        public int value;
+        public long total;
+    }
+
+    // The field accumulated into by the inner loop is moved out of the whole nest.
+    public int testNestedLoop()
+    {
+        A x;
+        x = new A();
+
+        for (int i = 0; i < 10; i++)
+        {
+            for (int j = 0; j < 10; j++)
+            {
+                x.value += i * j;
+            }
+        }
+        return x.value;
+    }
+
+    // The intrinsics neither throw nor access the field.
+    public int testIntrinsic(int[] array)
+    {
+        A x;
+        x = new A();
+
+        for (int i = 0; i < array.length; i++)
+        {
+            x.value += Integer.bitCount(array[i]) + Math.abs(array[i]);
+        }
+        return x.value;
+    }
+
+    public long testNestedIntrinsic()
+    {
+        A x;
+        x = new A();
+
+        for (int i = 0; i < 8; i++)
+        {
+            for (int j = 0; j < 8; j++)
+            {
+                x.total += Long.bitCount(i * 8 + j);
+            }
+        }
+        return x.total;
+    }
+
+    public void test()
+    {
+        System.out.println(testNestedLoop());
+        System.out.println(testIntrinsic(new int[] {1, -2, 3, -4, 255}));
+        System.out.println(testNestedIntrinsic());
+    }
+
+    public static void main(String[] args)
+    {
+        new Main().test();
+    }
+}
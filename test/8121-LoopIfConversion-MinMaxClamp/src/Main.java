@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+*
+* Expected result: the data-dependent branches of the loops are converted to selects,
+* the results are the same as with the branches
+*
+**/
+
+public class Main {
+    static final int N = 1000;
+
+    static int[] makeData() {
+        int[] data = new int[N];
+        int seed = 12345;
+        for (int i = 0; i < N; i++) {
+            seed = seed * 1103515245 + 12345;
+            data[i] = (seed >> 16) % 1000;
+        }
+        return data;
+    }
+
+    static void clamp(int[] a, int lo, int hi) {
+        for (int i = 0; i < a.length; i++) {
+            int v = a[i];
+            if (v > hi) {
+                v = hi;
+            } else if (v < lo) {
+                v = lo;
+            }
+            a[i] = v;
+        }
+    }
+
+    static int max(int[] a) {
+        int m = Integer.MIN_VALUE;
+        for (int i = 0; i < a.length; i++) {
+            if (a[i] > m) {
+                m = a[i];
+            }
+        }
+        return m;
+    }
+
+    static long min(int[] a) {
+        long m = Long.MAX_VALUE;
+        for (int i = 0; i < a.length; i++) {
+            long v = a[i];
+            if (v < m) {
+                m = v;
+            }
+        }
+        return m;
+    }
+
+    static void minMax(int[] a, int[] b, int[] lo, int[] hi) {
+        for (int i = 0; i < a.length; i++) {
+            int x = a[i];
+            int y = b[i];
+            int l;
+            int h;
+            if (x < y) {
+                l = x;
+                h = y;
+            } else {
+                l = y;
+                h = x;
+            }
+            lo[i] = l;
+            hi[i] = h;
+        }
+    }
+
+    static int countAbove(int[] a, int threshold) {
+        int count = 0;
+        int sum = 0;
+        for (int i = 0; i < a.length; i++) {
+            int v = a[i];
+            if (v > threshold) {
+                count++;
+                sum += v * 3 + 1;
+            } else {
+                sum -= v << 1;
+            }
+        }
+        return count * 100000 + sum;
+    }
+
+    static int checksum(int[] a) {
+        int sum = 0;
+        for (int i = 0; i < a.length; i++) {
+            sum = sum * 31 + a[i];
+        }
+        return sum;
+    }
+
+    public static void main(String[] args) {
+        int[] data = makeData();
+        int[] other = new int[N];
+        for (int i = 0; i < N; i++) {
+            other[i] = data[N - 1 - i] / 2;
+        }
+        System.out.println(max(data));
+        System.out.println(min(data));
+        System.out.println(countAbove(data, 100));
+
+        int[] lo = new int[N];
+        int[] hi = new int[N];
+        minMax(data, other, lo, hi);
+        System.out.println(checksum(lo));
+        System.out.println(checksum(hi));
+
+        clamp(data, -200, 300);
+        System.out.println(checksum(data));
+        System.out.println(max(data));
+        System.out.println(min(data));
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+*
+* Expected result: when JIT compiled, the loops bounded by the final static fields of the
+* initialized class Config get a known trip count, the results are the same as interpreted
+*
+**/
+
+class Config {
+    // Not compile-time constants, the loops only see them once Config is initialized.
+    static final int COUNT = Integer.parseInt("10");
+    static final int[] TABLE = new int[COUNT * 2];
+}
+
+public class Main {
+    static int limit = 5;
+
+    static int sumCount() {
+        int sum = 0;
+        for (int i = 0; i < Config.COUNT; i++) {
+            sum += i;
+        }
+        return sum;
+    }
+
+    static int sumTable() {
+        int[] table = Config.TABLE;
+        for (int i = 0; i < Config.TABLE.length; i++) {
+            table[i] = i * 3;
+        }
+        int sum = 0;
+        for (int i = 0; i < table.length; i++) {
+            sum += table[i];
+        }
+        return sum;
+    }
+
+    // The bound is not final, it is not speculated upon.
+    static int sumLimit() {
+        int sum = 0;
+        for (int i = 0; i < limit; i++) {
+            sum += i;
+        }
+        return sum;
+    }
+
+    public static void main(String[] args) {
+        int count = 0;
+        int table = 0;
+        int below = 0;
+        for (int i = 0; i < 100000; i++) {
+            count = sumCount();
+            table = sumTable();
+            below = sumLimit();
+        }
+        System.out.println(count);
+        System.out.println(table);
+        System.out.println(below);
+        limit = 8;
+        System.out.println(sumLimit());
+    }
+}
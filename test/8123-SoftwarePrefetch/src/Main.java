@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+*
+* Expected result: the prefetches inserted in the strided walks of primitive arrays and in
+* the walks of Object[] reading fields do not change the results, including when the walks
+* prefetch past the ends of the arrays
+*
+**/
+
+public class Main {
+    static final int N = 100000;
+
+    static class Node {
+        int value;
+        long weight;
+
+        Node(int value) {
+            this.value = value;
+            this.weight = value * 3L;
+        }
+    }
+
+    static long sumStrided(long[] a, int stride) {
+        long sum = 0;
+        for (int i = 0; i < a.length; i += 8) {
+            sum += a[i] * stride;
+        }
+        return sum;
+    }
+
+    static int sumBackwards(int[] a) {
+        int sum = 0;
+        for (int i = a.length - 1; i >= 0; i -= 16) {
+            sum += a[i];
+        }
+        return sum;
+    }
+
+    static void scale(double[] a) {
+        for (int i = 0; i < a.length; i += 4) {
+            a[i] = a[i] * 2.0;
+        }
+    }
+
+    static long sumNodes(Node[] nodes) {
+        long sum = 0;
+        for (int i = 0; i < nodes.length; i++) {
+            sum += nodes[i].value + nodes[i].weight;
+        }
+        return sum;
+    }
+
+    public static void main(String[] args) {
+        long[] longs = new long[N];
+        int[] ints = new int[N];
+        double[] doubles = new double[N];
+        Node[] nodes = new Node[N];
+        for (int i = 0; i < N; i++) {
+            longs[i] = i;
+            ints[i] = i % 1000;
+            doubles[i] = i;
+            nodes[i] = new Node(i % 777);
+        }
+
+        long strided = 0;
+        int backwards = 0;
+        long weights = 0;
+        for (int i = 0; i < 10; i++) {
+            strided = sumStrided(longs, 3);
+            backwards = sumBackwards(ints);
+            weights = sumNodes(nodes);
+        }
+        scale(doubles);
+        System.out.println(strided);
+        System.out.println(backwards);
+        System.out.println(weights);
+        System.out.println(doubles[4] + " " + doubles[5] + " " + doubles[N - 4]);
+        // A short array, the prefetches go past its end.
+        System.out.println(sumNodes(new Node[] { new Node(1), new Node(2) }));
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+*
+* Expected result: the loops versioned on the GC marking flag load the same references
+* as the original loops, including when a collection starts while they run
+*
+**/
+
+public class Main {
+    static final int N = 100000;
+    static final int ITERATIONS = 200;
+
+    static volatile boolean done = false;
+
+    static class Value {
+        int x;
+
+        Value(int x) {
+            this.x = x;
+        }
+    }
+
+    static class Holder {
+        Value value;
+
+        Holder(int x) {
+            this.value = new Value(x);
+        }
+    }
+
+    static class Node {
+        Node next;
+        Value item;
+
+        Node(Node next, int x) {
+            this.next = next;
+            this.item = new Value(x);
+        }
+    }
+
+    static long sumValues(Holder[] holders) {
+        long sum = 0;
+        for (int i = 0; i < holders.length; i++) {
+            sum += holders[i].value.x;
+        }
+        return sum;
+    }
+
+    static long sumList(Node head) {
+        long sum = 0;
+        for (Node n = head; n != null; n = n.next) {
+            sum += n.item.x;
+        }
+        return sum;
+    }
+
+    public static void main(String[] args) throws Exception {
+        Holder[] holders = new Holder[N];
+        for (int i = 0; i < N; i++) {
+            holders[i] = new Holder(i % 1000);
+        }
+        Node head = null;
+        for (int i = 0; i < 1000; i++) {
+            head = new Node(head, i);
+        }
+
+        // Keep the collector busy, to start marking while the loops run.
+        Thread allocator = new Thread(new Runnable() {
+            public void run() {
+                Object[] garbage = new Object[1024];
+                int i = 0;
+                while (!done) {
+                    garbage[i++ % garbage.length] = new int[256];
+                    if (i % 100000 == 0) {
+                        Runtime.getRuntime().gc();
+                    }
+                }
+            }
+        });
+        allocator.start();
+
+        long values = 0;
+        long total = 0;
+        long list = 0;
+        long list_total = 0;
+        for (int i = 0; i < ITERATIONS; i++) {
+            values = sumValues(holders);
+            total += values;
+            list = sumList(head);
+            list_total += list;
+        }
+        done = true;
+        allocator.join();
+
+        System.out.println(values);
+        System.out.println(total);
+        System.out.println(list);
+        System.out.println(list_total);
+    }
+}
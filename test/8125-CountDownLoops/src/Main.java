@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+*
+* Expected result: the loops whose bounds are now computed for the loop passes
+* compute the same values as the original loops
+*
+**/
+
+public class Main {
+    static int sumDown() {
+        int sum = 0;
+        for (int i = 10; i > 0; i--) {
+            sum += i;
+        }
+        return sum;
+    }
+
+    static long sumDownLong() {
+        long sum = 0;
+        for (long i = 100; i > 0; i -= 3) {
+            sum += i;
+        }
+        return sum;
+    }
+
+    static int sumSquaresNotEqual() {
+        int sum = 0;
+        for (int i = 0; i != 30; i += 3) {
+            sum += i * i;
+        }
+        return sum;
+    }
+
+    static int sumDownNotEqual() {
+        int sum = 0;
+        for (int i = 40; i != 0; i -= 4) {
+            sum += i;
+        }
+        return sum;
+    }
+
+    static int countFromMinLong() {
+        int count = 0;
+        for (long i = Long.MIN_VALUE; i < Long.MIN_VALUE + 5; i++) {
+            count++;
+        }
+        return count;
+    }
+
+    static int fillBackwards() {
+        int[] a = new int[16];
+        for (int i = 15; i >= 0; i--) {
+            a[i] = 15 - i;
+        }
+        int sum = 0;
+        for (int i = 0; i < a.length; i++) {
+            sum += a[i] * i;
+        }
+        return sum;
+    }
+
+    static long mixDownLong() {
+        long sum = 0;
+        for (long i = 1000; i >= 1; i--) {
+            sum += i ^ (i >> 3);
+        }
+        return sum;
+    }
+
+    static long sumDownFromMaxInt() {
+        long sum = 0;
+        for (int i = Integer.MAX_VALUE; i > Integer.MAX_VALUE - 20; i--) {
+            sum += i;
+        }
+        return sum;
+    }
+
+    public static void main(String[] args) {
+        System.out.println(sumDown());
+        System.out.println(sumDownLong());
+        System.out.println(sumSquaresNotEqual());
+        System.out.println(sumDownNotEqual());
+        System.out.println(countFromMinLong());
+        System.out.println(fillBackwards());
+        System.out.println(mixDownLong());
+        System.out.println(sumDownFromMaxInt());
+    }
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sstream>
+
+#include "jni.h"
+
+#include "jit/jit.h"
+#include "jit/jit_loop_counters.h"
+#include "runtime.h"
+
+namespace art {
+
+// The counters as dumped on SIGQUIT, null without the JIT or -Xjitcountloops.
+extern "C" JNIEXPORT jstring JNICALL Java_Main_dumpLoopCounters(JNIEnv* env, jclass) {
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  if (jit == nullptr || jit->GetLoopCounters() == nullptr) {
+    return nullptr;
+  }
+  std::ostringstream os;
+  jit->GetLoopCounters()->Dump(os);
+  return env->NewStringUTF(os.str().c_str());
+}
+
+}  // namespace art
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+*
+* Expected result: the loops counted with -Xjitcountloops, peeled, unrolled or storing
+* non-temporally, compute the same values as without the counters, and the counters of
+* the peeled loop are dumped with its entries and iterations
+*
+**/
+
+public class Main {
+    static class Holder {
+        int value;
+    }
+
+    static int sumArray(int[] a) {
+        int sum = 0;
+        for (int i = 0; i < a.length; i++) {
+            sum += a[i];
+        }
+        return sum;
+    }
+
+    static int fill(int[] a, int v) {
+        for (int i = 0; i < a.length; i++) {
+            a[i] = v + i;
+        }
+        return a[0] + a[a.length - 1];
+    }
+
+    /// CHECK-START-X86_64: int Main.sumScaled(Main$Holder, int) loop_counters (before)
+    /// CHECK-NOT: X86IncrementCounter
+
+    /// CHECK-START-X86_64: int Main.sumScaled(Main$Holder, int) loop_counters (after)
+    /// CHECK-DAG: X86IncrementCounter loop:none
+    /// CHECK-DAG: X86IncrementCounter loop:{{B\d+}}
+    /// CHECK-DAG: InstanceFieldGet    loop:{{B\d+}}
+    static int sumScaled(Holder holder, int n) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum += holder.value * i;
+        }
+        return sum;
+    }
+
+    // Checks the dumped counters of the peeled loop of sumScaled. Each entry runs at most the
+    // n iterations and the exit test, fewer once peeled or unrolled.
+    static void checkLoopCounters(int n) {
+        String dump = dumpLoopCounters();
+        if (dump == null) {
+            // Not compiled by the JIT, or without -Xjitcountloops.
+            System.out.println("sumScaled: counted");
+            return;
+        }
+        String line = null;
+        for (String candidate : dump.split("\n")) {
+            if (candidate.contains("Main.sumScaled(") && candidate.contains("loop_peeling")) {
+                line = candidate;
+                break;
+            }
+        }
+        if (line == null) {
+            throw new Error("Not counted: " + dump);
+        }
+        long entries = getCounter(line, "entries=");
+        long iterations = getCounter(line, "iterations=");
+        if (entries <= 0 || iterations < entries || iterations > entries * (n + 1)) {
+            throw new Error("Wrong counters: " + line);
+        }
+        System.out.println("sumScaled: counted");
+    }
+
+    static long getCounter(String line, String name) {
+        int start = line.indexOf(name) + name.length();
+        int end = line.indexOf(' ', start);
+        return Long.parseLong(end < 0 ? line.substring(start) : line.substring(start, end));
+    }
+
+    public static void main(String[] args) {
+        System.loadLibrary(args[0]);
+        if (hasJit()) {
+            ensureJitCompiled(Main.class, "sumArray");
+            ensureJitCompiled(Main.class, "fill");
+            ensureJitCompiled(Main.class, "sumScaled");
+        }
+
+        int[] a = new int[1000];
+        for (int i = 0; i < a.length; i++) {
+            a[i] = i;
+        }
+        int[] b = new int[1000];
+        Holder holder = new Holder();
+        holder.value = 3;
+
+        // Run the loops long enough for the JIT to compile them.
+        int sum = 0;
+        int ends = 0;
+        int scaled = 0;
+        for (int i = 0; i < 20000; i++) {
+            sum = sumArray(a);
+            ends = fill(b, 7);
+            scaled = sumScaled(holder, 100);
+        }
+        System.out.println(sum);
+        System.out.println(ends);
+        System.out.println(scaled);
+        checkLoopCounters(100);
+    }
+
+    private static native boolean hasJit();
+    private static native void ensureJitCompiled(Class<?> cls, String methodName);
+    private static native String dumpLoopCounters();
+}
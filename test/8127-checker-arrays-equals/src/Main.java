@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+
+public class Main {
+
+  /// CHECK-START: boolean Main.$noinline$equals(byte[], byte[]) intrinsics_recognition (after)
+  /// CHECK-DAG:     <<Result:z\d+>>  InvokeStaticOrDirect intrinsic:ArraysEqualsByte
+  /// CHECK-DAG:                      Return [<<Result>>]
+  private static boolean $noinline$equals(byte[] a, byte[] b) {
+    if (doThrow) { throw new Error(); }  // Try defeating inlining.
+    return Arrays.equals(a, b);
+  }
+
+  public static void main(String[] args) {
+    byte[] a = new byte[100];
+    byte[] b = new byte[100];
+    for (int i = 0; i < a.length; i++) {
+      a[i] = (byte) i;
+      b[i] = (byte) i;
+    }
+    expectEquals(true, $noinline$equals(a, a));
+    expectEquals(true, $noinline$equals(a, b));
+    expectEquals(false, $noinline$equals(a, null));
+    expectEquals(true, $noinline$equals(null, null));
+    expectEquals(false, $noinline$equals(a, Arrays.copyOf(b, 99)));
+    // A difference in each position, including the blocks compared last.
+    for (int i = 0; i < b.length; i++) {
+      b[i]++;
+      expectEquals(false, $noinline$equals(a, b));
+      b[i]--;
+    }
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(boolean expected, boolean result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  private static boolean doThrow = false;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.zip.CRC32;
+
+public class Main {
+
+  // The native methods are private, they are reached by inlining the public ones.
+
+  /// CHECK-START: long Main.$noinline$updateByte(java.util.zip.CRC32, int) inliner (after)
+  /// CHECK-DAG:                      InvokeStaticOrDirect intrinsic:CRC32Update
+  private static long $noinline$updateByte(CRC32 crc, int b) {
+    if (doThrow) { throw new Error(); }  // Try defeating inlining.
+    crc.update(b);
+    return crc.getValue();
+  }
+
+  /// CHECK-START: long Main.$noinline$updateBytes(java.util.zip.CRC32, byte[], int, int) inliner (after)
+  /// CHECK-DAG:                      InvokeStaticOrDirect intrinsic:CRC32UpdateBytes
+  private static long $noinline$updateBytes(CRC32 crc, byte[] bytes, int off, int len) {
+    if (doThrow) { throw new Error(); }  // Try defeating inlining.
+    crc.update(bytes, off, len);
+    return crc.getValue();
+  }
+
+  public static void main(String[] args) {
+    expectEquals(0xd3d99e8bL, $noinline$updateByte(new CRC32(), 0x41));
+    byte[] digits = "123456789".getBytes();
+    expectEquals(0xcbf43926L, $noinline$updateBytes(new CRC32(), digits, 0, digits.length));
+    CRC32 split = new CRC32();
+    $noinline$updateBytes(split, digits, 0, 4);
+    expectEquals(0xcbf43926L, $noinline$updateBytes(split, digits, 4, 5));
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(long expected, long result) {
+    if (expected != result) {
+      throw new Error("Expected: " + Long.toHexString(expected) +
+                      ", found: " + Long.toHexString(result));
+    }
+  }
+
+  private static boolean doThrow = false;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+
+  /// CHECK-START: int Main.$noinline$hash(java.lang.Object) intrinsics_recognition (after)
+  /// CHECK-DAG:     <<Result:i\d+>>  InvokeStaticOrDirect intrinsic:SystemIdentityHashCode
+  /// CHECK-DAG:                      Return [<<Result>>]
+  private static int $noinline$hash(Object o) {
+    if (doThrow) { throw new Error(); }  // Try defeating inlining.
+    return System.identityHashCode(o);
+  }
+
+  public static void main(String[] args) {
+    Object o = new Object();
+    int hash = $noinline$hash(o);
+    expectEquals(hash, $noinline$hash(o));
+    expectEquals(0, $noinline$hash(null));
+    // The hash code of a locked object stays the same.
+    synchronized (o) {
+      expectEquals(hash, $noinline$hash(o));
+    }
+    Object locked = new Object();
+    synchronized (locked) {
+      int lockedHash = $noinline$hash(locked);
+      expectEquals(lockedHash, $noinline$hash(locked));
+      expectEquals(lockedHash, locked.hashCode());
+    }
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  private static boolean doThrow = false;
+}
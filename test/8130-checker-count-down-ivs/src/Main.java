@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+
+  // The xor of the iterations keeps the common loop optimization from replacing
+  // the loops by the last value of their IV.
+
+  /// CHECK-START-X86_64: int Main.$noinline$xorDown() loop_full_unrolling (before)
+  /// CHECK-DAG:                      Phi
+  /// CHECK-DAG:                      Xor
+
+  /// CHECK-START-X86_64: int Main.$noinline$xorDown() loop_full_unrolling (after)
+  /// CHECK-NOT:                      Phi
+
+  /// CHECK-START-X86_64: int Main.$noinline$xorDown() loop_full_unrolling (after)
+  /// CHECK-DAG:                      Xor
+  /// CHECK-DAG:                      Xor
+  /// CHECK-DAG:                      Xor
+  /// CHECK-DAG:                      Xor
+  private static int $noinline$xorDown() {
+    int x = 0;
+    for (int i = 4; i > 0; i--) {
+      x ^= i * 5;
+    }
+    return x;
+  }
+
+  /// CHECK-START-X86_64: int Main.$noinline$xorDownLong() trivial_loop_evaluator (before)
+  /// CHECK-DAG:                      Phi
+  /// CHECK-DAG:                      Xor
+
+  /// CHECK-START-X86_64: int Main.$noinline$xorDownLong() trivial_loop_evaluator (after)
+  /// CHECK-NOT:                      Phi
+
+  /// CHECK-START-X86_64: int Main.$noinline$xorDownLong() trivial_loop_evaluator (after)
+  /// CHECK-DAG:     <<Value:i\d+>>   IntConstant 216
+  /// CHECK-DAG:                      Return [<<Value>>]
+  private static int $noinline$xorDownLong() {
+    int x = 0;
+    for (int i = 200; i > 0; i--) {
+      x ^= i * 5;
+    }
+    return x;
+  }
+
+  // i != 12 is reached exactly, the loop is the same as i < 12.
+
+  /// CHECK-START-X86_64: int Main.$noinline$notEqualReached() loop_full_unrolling (before)
+  /// CHECK-DAG:                      Phi
+
+  /// CHECK-START-X86_64: int Main.$noinline$notEqualReached() loop_full_unrolling (after)
+  /// CHECK-NOT:                      Phi
+  private static int $noinline$notEqualReached() {
+    int x = 0;
+    for (int i = 0; i != 12; i += 3) {
+      x ^= i * 5;
+    }
+    return x;
+  }
+
+  // i != 10 is stepped over, the IV wraps around before the loop stops: the loop has
+  // no trip count and must be left alone. It is never run.
+
+  /// CHECK-START-X86_64: int Main.$noinline$notEqualNotReached() loop_full_unrolling (after)
+  /// CHECK-DAG:                      Phi
+  /// CHECK-DAG:                      Xor
+
+  /// CHECK-START-X86_64: int Main.$noinline$notEqualNotReached() trivial_loop_evaluator (after)
+  /// CHECK-DAG:                      Phi
+  /// CHECK-DAG:                      Xor
+  private static int $noinline$notEqualNotReached() {
+    int x = 0;
+    for (int i = 0; i != 10; i += 3) {
+      x ^= i * 5;
+    }
+    return x;
+  }
+
+  /// CHECK-START-X86_64: void Main.$noinline$addDown(int[], int[]) array_alias_versioning (before)
+  /// CHECK:                          ArraySet
+  /// CHECK-NOT:                      ArraySet
+
+  /// CHECK-START-X86_64: void Main.$noinline$addDown(int[], int[]) array_alias_versioning (after)
+  /// CHECK-DAG:     <<A:l\d+>>       ParameterValue
+  /// CHECK-DAG:     <<B:l\d+>>       ParameterValue
+  /// CHECK-DAG:                      NotEqual [<<A>>,<<B>>]
+  /// CHECK-DAG:                      ArraySet
+  /// CHECK-DAG:                      ArraySet
+  private static void $noinline$addDown(int[] a, int[] b) {
+    for (int i = 99; i >= 0; i--) {
+      a[i] = b[i] + 1;
+    }
+  }
+
+  public static void main(String[] args) {
+    System.out.println($noinline$xorDown());
+    System.out.println($noinline$xorDownLong());
+    System.out.println($noinline$notEqualReached());
+
+    int[] a = new int[100];
+    int[] b = new int[100];
+    for (int i = 0; i < b.length; i++) {
+      b[i] = i;
+    }
+    $noinline$addDown(a, b);
+    // Both versions run: the arrays are distinct, then the same.
+    $noinline$addDown(b, b);
+    System.out.println(a[99] + " " + b[99] + " " + a[0]);
+    if (doThrow) {
+      System.out.println($noinline$notEqualNotReached());
+    }
+    System.out.println("passed");
+  }
+
+  private static boolean doThrow = false;
+}
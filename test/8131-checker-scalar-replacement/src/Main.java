@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+
+  static class Point {
+    int x;
+    int y;
+  }
+
+  static Point sLast;
+
+  // The stores of the two branches reach the load through a join, which the load store
+  // elimination does not merge: the allocation is only replaced by scalar_replacement.
+
+  /// CHECK-START-X86_64: int Main.$noinline$merged(int) scalar_replacement (before)
+  /// CHECK-DAG:                      NewInstance
+  /// CHECK-DAG:                      InstanceFieldSet
+  /// CHECK-DAG:                      InstanceFieldSet
+  /// CHECK-DAG:                      InstanceFieldGet
+
+  /// CHECK-START-X86_64: int Main.$noinline$merged(int) scalar_replacement (after)
+  /// CHECK-NOT:                      NewInstance
+  /// CHECK-NOT:                      InstanceFieldSet
+  /// CHECK-NOT:                      InstanceFieldGet
+  /// CHECK-NOT:                      ConstructorFence
+  private static int $noinline$merged(int n) {
+    int sum = 0;
+    for (int i = 0; i < n; i++) {
+      Point p = new Point();
+      if ((i & 1) == 0) {
+        p.x = i;
+      } else {
+        p.x = -i;
+      }
+      sum += p.x;
+    }
+    return sum;
+  }
+
+  // The object escapes to a static field, its allocation and store must be kept.
+
+  /// CHECK-START-X86_64: int Main.$noinline$escaping(int) scalar_replacement (after)
+  /// CHECK-DAG:     <<New:l\d+>>     NewInstance
+  /// CHECK-DAG:                      InstanceFieldSet [<<New>>,{{i\d+}}]
+  /// CHECK-DAG:                      StaticFieldSet [{{l\d+}},<<New>>]
+  private static int $noinline$escaping(int n) {
+    int sum = 0;
+    for (int i = 0; i < n; i++) {
+      Point p = new Point();
+      p.x = i;
+      sLast = p;
+      sum += p.x;
+    }
+    return sum;
+  }
+
+  public static void main(String[] args) {
+    System.out.println($noinline$merged(10));
+    System.out.println($noinline$escaping(10) + " " + sLast.x);
+    System.out.println("passed");
+  }
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+
+  // The stores keep the branches from being turned into selects.
+  static int sSide;
+
+  // x * b is a * b coming from the then branch, where it is computed already. It is only
+  // computed in the else branch, as c * b, and merged by a phi.
+
+  /// CHECK-START-X86_64: int Main.$noinline$hoisted(boolean, int, int, int) partial_redundancy_elimination (before)
+  /// CHECK-DAG:     <<A:i\d+>>       ParameterValue
+  /// CHECK-DAG:     <<B:i\d+>>       ParameterValue
+  /// CHECK-DAG:     <<C:i\d+>>       ParameterValue
+  /// CHECK-DAG:                      Mul [<<A>>,<<B>>]
+  /// CHECK-DAG:     <<X:i\d+>>       Phi [<<A>>,<<C>>]
+  /// CHECK-DAG:                      Mul [<<X>>,<<B>>]
+
+  /// CHECK-START-X86_64: int Main.$noinline$hoisted(boolean, int, int, int) partial_redundancy_elimination (after)
+  /// CHECK-DAG:     <<A:i\d+>>       ParameterValue
+  /// CHECK-DAG:     <<B:i\d+>>       ParameterValue
+  /// CHECK-DAG:     <<C:i\d+>>       ParameterValue
+  /// CHECK-DAG:     <<AB:i\d+>>      Mul [<<A>>,<<B>>]
+  /// CHECK-DAG:     <<CB:i\d+>>      Mul [<<C>>,<<B>>]
+  /// CHECK-DAG:                      Phi [<<AB>>,<<CB>>]
+
+  /// CHECK-START-X86_64: int Main.$noinline$hoisted(boolean, int, int, int) partial_redundancy_elimination (after)
+  /// CHECK:                          Mul
+  /// CHECK:                          Mul
+  /// CHECK-NOT:                      Mul
+  private static int $noinline$hoisted(boolean flag, int a, int b, int c) {
+    int x;
+    int y;
+    if (flag) {
+      x = a;
+      y = a * b;
+      sSide = 1;
+    } else {
+      x = c;
+      y = 0;
+      sSide = 2;
+    }
+    return y + x * b;
+  }
+
+  // array[x] is array[a] coming from the then branch, but the store in between may have
+  // changed it: the load reads the heap and stays in the merge block.
+
+  /// CHECK-START-X86_64: int Main.$noinline$sideEffect(int[], boolean, int, int) partial_redundancy_elimination (after)
+  /// CHECK:                          ArrayGet
+  /// CHECK:                          ArrayGet
+  /// CHECK-NOT:                      ArrayGet
+  private static int $noinline$sideEffect(int[] array, boolean flag, int a, int c) {
+    int x;
+    int y;
+    if (flag) {
+      x = a;
+      y = array[a];
+      array[c] = 7;
+    } else {
+      x = c;
+      y = 0;
+      sSide = 2;
+    }
+    return y + array[x];
+  }
+
+  public static void main(String[] args) {
+    System.out.println($noinline$hoisted(true, 3, 5, 7) + " " + $noinline$hoisted(false, 3, 5, 7));
+    System.out.println($noinline$sideEffect(new int[] { 1, 2, 3, 4 }, true, 1, 1) + " " +
+                       $noinline$sideEffect(new int[] { 1, 2, 3, 4 }, false, 1, 1));
+    System.out.println("passed");
+  }
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+
+  static int sSum;
+
+  // The access is conditional, the common bounds check elimination leaves its check to
+  // the dominator-based elimination, which needs several checks. The extension pass
+  // replaces it by deoptimizations in the pre-header.
+
+  /// CHECK-START-X86_64: void Main.$noinline$sumUp(int[], int, int, int) loop_bounds_check_elimination (before)
+  /// CHECK-DAG:                      BoundsCheck loop:{{B\d+}}
+
+  /// CHECK-START-X86_64: void Main.$noinline$sumUp(int[], int, int, int) loop_bounds_check_elimination (after)
+  /// CHECK-NOT:                      BoundsCheck
+
+  /// CHECK-START-X86_64: void Main.$noinline$sumUp(int[], int, int, int) loop_bounds_check_elimination (after)
+  /// CHECK-DAG:                      Deoptimize kind:loop bounds check elimination loop:none
+  /// CHECK-DAG:                      ArrayGet loop:{{B\d+}}
+
+  // The deoptimizations are skipped when the loop is not entered.
+
+  /// CHECK-START-X86_64: void Main.$noinline$sumUp(int[], int, int, int) loop_bounds_check_elimination (after)
+  /// CHECK:                          ParameterValue
+  /// CHECK:          <<Start:i\d+>>  ParameterValue
+  /// CHECK:          <<End:i\d+>>    ParameterValue
+  /// CHECK:          <<Taken:z\d+>>  LessThan [<<Start>>,<<End>>] loop:none
+  /// CHECK-NEXT:                     If [<<Taken>>] loop:none
+  /// CHECK:                          Deoptimize kind:loop bounds check elimination loop:none
+  private static void $noinline$sumUp(int[] a, int start, int end, int skip) {
+    for (int i = start; i < end; i++) {
+      if (i != skip) {
+        sSum += a[i];
+      }
+    }
+  }
+
+  /// CHECK-START-X86_64: void Main.$noinline$sumUpInclusive(int[], int, int, int) loop_bounds_check_elimination (after)
+  /// CHECK-NOT:                      BoundsCheck
+
+  /// CHECK-START-X86_64: void Main.$noinline$sumUpInclusive(int[], int, int, int) loop_bounds_check_elimination (after)
+  /// CHECK:                          ParameterValue
+  /// CHECK:          <<Start:i\d+>>  ParameterValue
+  /// CHECK:          <<Last:i\d+>>   ParameterValue
+  /// CHECK:          <<Taken:z\d+>>  LessThanOrEqual [<<Start>>,<<Last>>] loop:none
+  /// CHECK-NEXT:                     If [<<Taken>>] loop:none
+  /// CHECK:                          Deoptimize kind:loop bounds check elimination loop:none
+  private static void $noinline$sumUpInclusive(int[] a, int start, int last, int skip) {
+    for (int i = start; i <= last; i++) {
+      if (i != skip) {
+        sSum += a[i];
+      }
+    }
+  }
+
+  // The pass only handles the IVs counting up, the check of a count-down loop stays.
+
+  /// CHECK-START-X86_64: void Main.$noinline$sumDown(int[], int, int) loop_bounds_check_elimination (after)
+  /// CHECK-DAG:                      BoundsCheck loop:{{B\d+}}
+  private static void $noinline$sumDown(int[] a, int start, int skip) {
+    for (int i = start; i >= 0; i--) {
+      if (i != skip) {
+        sSum += a[i];
+      }
+    }
+  }
+
+  public static void main(String[] args) {
+    int[] a = new int[10];
+    for (int i = 0; i < a.length; i++) {
+      a[i] = 1 << i;
+    }
+    $noinline$sumUp(a, 0, a.length, 3);
+    expectEquals(1023 - 8, sSum);
+    sSum = 0;
+    $noinline$sumUpInclusive(a, 1, a.length - 1, -1);
+    expectEquals(1022, sSum);
+    sSum = 0;
+    $noinline$sumDown(a, a.length - 1, 0);
+    expectEquals(1022, sSum);
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+*
+* Expected result: the loops whose bounds checks are replaced by deoptimizations before
+* them compute the same sums, and throw at the same iteration, as the original loops
+* when their start or bound is out of the array: the deoptimization resumes them in the
+* interpreter at their first iteration.
+*
+**/
+
+public class Main {
+  static int sSum;
+
+  static void $noinline$sumUp(int[] a, int start, int end, int skip) {
+    for (int i = start; i < end; i++) {
+      if (i != skip) {
+        sSum += a[i];
+      }
+    }
+  }
+
+  static void $noinline$sumUpInclusive(int[] a, int start, int last, int skip) {
+    for (int i = start; i <= last; i++) {
+      if (i != skip) {
+        sSum += a[i];
+      }
+    }
+  }
+
+  static void $noinline$sumUpOffset(int[] a, int start, int end, int skip) {
+    for (int i = start; i < end; i++) {
+      if (i != skip) {
+        sSum += a[i + 1];
+      }
+    }
+  }
+
+  // Not handled by the pass, for comparison.
+  static void $noinline$sumDown(int[] a, int start, int skip) {
+    for (int i = start; i >= 0; i--) {
+      if (i != skip) {
+        sSum += a[i];
+      }
+    }
+  }
+
+  static void run(String label, int kind, int[] a, int x, int y, int skip) {
+    sSum = 0;
+    String result = "";
+    try {
+      switch (kind) {
+        case 0:
+          $noinline$sumUp(a, x, y, skip);
+          break;
+        case 1:
+          $noinline$sumUpInclusive(a, x, y, skip);
+          break;
+        case 2:
+          $noinline$sumUpOffset(a, x, y, skip);
+          break;
+        default:
+          $noinline$sumDown(a, x, skip);
+          break;
+      }
+    } catch (ArrayIndexOutOfBoundsException e) {
+      result = "ArrayIndexOutOfBoundsException, ";
+    } catch (NullPointerException e) {
+      result = "NullPointerException, ";
+    }
+    System.out.println(label + ": " + result + sSum);
+  }
+
+  public static void main(String[] args) {
+    int max = Integer.MAX_VALUE;
+    int[] a = new int[10];
+    for (int i = 0; i < a.length; i++) {
+      a[i] = 1 << i;
+    }
+    run("up whole array", 0, a, 0, 10, -1);
+    run("up part with a skip", 0, a, 2, 5, 3);
+    run("up from -2", 0, a, -2, 3, -1);
+    run("up from -1 skipped", 0, a, -1, 3, -1);
+    run("up past the end", 0, a, 5, 12, -1);
+    run("up past the end skipped", 0, a, 5, 11, 10);
+    run("up not entered", 0, a, 7, 3, -1);
+    run("up near max int", 0, a, max - 1, max, -1);
+    run("up near max int skipped", 0, a, max - 1, max, max - 1);
+    run("up null", 0, null, 0, 3, -1);
+    run("up null not entered", 0, null, 0, 0, -1);
+    run("inclusive whole array", 1, a, 0, 9, -1);
+    run("inclusive past the end", 1, a, 0, 10, -1);
+    run("inclusive past the end skipped", 1, a, 8, 10, 10);
+    run("inclusive to max int", 1, a, max - 2, max, max - 2);
+    run("offset whole array", 2, a, -1, 9, -2);
+    run("offset past the end", 2, a, 0, 10, -1);
+    run("offset from -2 skipped", 2, a, -2, 3, -2);
+    run("offset from -2", 2, a, -2, 3, -1);
+    run("down whole array", 3, a, 9, 0, -1);
+    run("down from the end", 3, a, 10, 0, -1);
+    run("down from the end skipped", 3, a, 10, 0, 10);
+  }
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+
+public class Main {
+
+  // The outer loop runs an even number of times and the inner body cannot throw: the inner
+  // body is jammed with a copy for the next outer iteration. The inner loop is then
+  // partially unrolled, with the IVs found again after the outer one was scaled.
+
+  /// CHECK-START-X86_64: long[] Main.$noinline$jam(long) loop_unroll_and_jam (before)
+  /// CHECK:                          ArraySet
+  /// CHECK-NOT:                      ArraySet
+
+  /// CHECK-START-X86_64: long[] Main.$noinline$jam(long) loop_unroll_and_jam (after)
+  /// CHECK-DAG:                      ArraySet loop:<<Inner:B\d+>>
+  /// CHECK-DAG:                      ArraySet loop:<<Inner>>
+
+  /// CHECK-START-X86_64: long[] Main.$noinline$jam(long) loop_unroll_and_jam (after)
+  /// CHECK:                          ArraySet
+  /// CHECK:                          ArraySet
+  /// CHECK-NOT:                      ArraySet
+
+  /// CHECK-START-X86_64: long[] Main.$noinline$jam(long) loop_partial_unrolling (after)
+  /// CHECK-DAG:                      ArraySet loop:<<Inner:B\d+>>
+  /// CHECK-DAG:                      ArraySet loop:<<Inner>>
+  /// CHECK-DAG:                      ArraySet loop:<<Inner>>
+  /// CHECK-DAG:                      ArraySet loop:<<Inner>>
+  private static long[] $noinline$jam(long x) {
+    long[] a = new long[32];
+    for (int i = 0; i < 8; i++) {
+      long y = x * i;
+      for (int j = 0; j < 32; j++) {
+        a[j] = a[j] * 3 + y + j;
+      }
+    }
+    return a;
+  }
+
+  // An odd outer trip count is not jammed, the inner loop is still partially unrolled.
+
+  /// CHECK-START-X86_64: long[] Main.$noinline$jamOdd(long) loop_unroll_and_jam (after)
+  /// CHECK:                          ArraySet
+  /// CHECK-NOT:                      ArraySet
+
+  /// CHECK-START-X86_64: long[] Main.$noinline$jamOdd(long) loop_partial_unrolling (after)
+  /// CHECK-DAG:                      ArraySet loop:<<Inner:B\d+>>
+  /// CHECK-DAG:                      ArraySet loop:<<Inner>>
+  private static long[] $noinline$jamOdd(long x) {
+    long[] a = new long[32];
+    for (int i = 0; i < 7; i++) {
+      long y = x * i;
+      for (int j = 0; j < 32; j++) {
+        a[j] = a[j] * 3 + y + j;
+      }
+    }
+    return a;
+  }
+
+  // An unknown inner trip count keeps the bounds check: neither pass applies.
+
+  /// CHECK-START-X86_64: long[] Main.$noinline$jamUnknown(long, int) loop_partial_unrolling (after)
+  /// CHECK-DAG:                      BoundsCheck loop:{{B\d+}}
+
+  /// CHECK-START-X86_64: long[] Main.$noinline$jamUnknown(long, int) loop_partial_unrolling (after)
+  /// CHECK:                          ArraySet
+  /// CHECK-NOT:                      ArraySet
+  private static long[] $noinline$jamUnknown(long x, int n) {
+    long[] a = new long[32];
+    for (int i = 0; i < 8; i++) {
+      long y = x * i;
+      for (int j = 0; j < n; j++) {
+        a[j] = a[j] * 3 + y + j;
+      }
+    }
+    return a;
+  }
+
+  // The same nest with unknown trip counts, left as is.
+  private static long[] $noinline$reference(long x, int outer, int inner) {
+    long[] a = new long[32];
+    for (int i = 0; i < outer; i++) {
+      long y = x * i;
+      for (int j = 0; j < inner; j++) {
+        a[j] = a[j] * 3 + y + j;
+      }
+    }
+    return a;
+  }
+
+  private static void expectEquals(String label, long[] expected, long[] result) {
+    if (!Arrays.equals(expected, result)) {
+      throw new Error(label + ": expected " + Arrays.toString(expected) +
+                      ", got " + Arrays.toString(result));
+    }
+    System.out.println(label + ": passed");
+  }
+
+  public static void main(String[] args) {
+    expectEquals("jam", $noinline$reference(5, 8, 32), $noinline$jam(5));
+    expectEquals("odd outer", $noinline$reference(5, 7, 32), $noinline$jamOdd(5));
+    expectEquals("unknown inner", $noinline$reference(5, 8, 20), $noinline$jamUnknown(5, 20));
+  }
+}
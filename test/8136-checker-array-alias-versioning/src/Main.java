@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+
+public class Main {
+
+  // The store may only alias the load when a and b are the same array. The loop is
+  // duplicated, the copy running when they are not.
+
+  /// CHECK-START-X86_64: void Main.$noinline$shift(int[], int[], int) array_alias_versioning (before)
+  /// CHECK:                          ArraySet
+  /// CHECK-NOT:                      ArraySet
+
+  /// CHECK-START-X86_64: void Main.$noinline$shift(int[], int[], int) array_alias_versioning (after)
+  /// CHECK-DAG:     <<A:l\d+>>       ParameterValue
+  /// CHECK-DAG:     <<B:l\d+>>       ParameterValue
+  /// CHECK-DAG:     <<Ne:z\d+>>      NotEqual [<<A>>,<<B>>] loop:none
+  /// CHECK-DAG:                      If [<<Ne>>] loop:none
+  /// CHECK-DAG:                      ArraySet loop:<<Fast:B\d+>>
+  /// CHECK-DAG:                      ArraySet loop:<<Slow:B\d+>>
+  private static void $noinline$shift(int[] a, int[] b, int n) {
+    for (int i = 0; i < n; i++) {
+      a[i + 1] = b[i] * 3;
+    }
+  }
+
+  // The callee may write any array: the loop is left as is.
+
+  /// CHECK-START-X86_64: void Main.$noinline$shiftWithCall(int[], int[], int) array_alias_versioning (after)
+  /// CHECK-NOT:                      NotEqual
+
+  /// CHECK-START-X86_64: void Main.$noinline$shiftWithCall(int[], int[], int) array_alias_versioning (after)
+  /// CHECK:                          ArraySet
+  /// CHECK-NOT:                      ArraySet
+  private static void $noinline$shiftWithCall(int[] a, int[] b, int n) {
+    for (int i = 0; i < n; i++) {
+      a[i + 1] = b[i] * $noinline$three();
+    }
+  }
+
+  private static int $noinline$three() {
+    return 3;
+  }
+
+  private static int[] newArray(int length) {
+    int[] a = new int[length];
+    for (int i = 0; i < length; i++) {
+      a[i] = i + 1;
+    }
+    return a;
+  }
+
+  private static void expectEquals(String label, int[] expected, int[] result) {
+    if (!Arrays.equals(expected, result)) {
+      throw new Error(label + ": expected " + Arrays.toString(expected) +
+                      ", got " + Arrays.toString(result));
+    }
+    System.out.println(label + ": passed");
+  }
+
+  public static void main(String[] args) {
+    // Disjoint arrays run the versioned copy.
+    int[] a = newArray(10);
+    int[] b = newArray(10);
+    int[] expected_a = newArray(10);
+    int[] expected_b = newArray(10);
+    $noinline$shift(a, b, 9);
+    $noinline$shiftWithCall(expected_a, expected_b, 9);
+    expectEquals("disjoint", expected_a, a);
+
+    // The same array carries each store to the next load, in the original loop.
+    a = newArray(10);
+    expected_a = newArray(10);
+    $noinline$shift(a, a, 9);
+    $noinline$shiftWithCall(expected_a, expected_a, 9);
+    expectEquals("same array", expected_a, a);
+
+    // The versioned copy keeps its bounds checks and stops at the same store.
+    a = newArray(10);
+    b = newArray(10);
+    expected_a = newArray(10);
+    expected_b = newArray(10);
+    try {
+      $noinline$shift(a, b, 10);
+      throw new Error("Expected ArrayIndexOutOfBoundsException");
+    } catch (ArrayIndexOutOfBoundsException e) {
+    }
+    try {
+      $noinline$shiftWithCall(expected_a, expected_b, 10);
+      throw new Error("Expected ArrayIndexOutOfBoundsException");
+    } catch (ArrayIndexOutOfBoundsException e) {
+    }
+    expectEquals("out of range", expected_a, a);
+
+    // The loop that is not versioned.
+    a = newArray(10);
+    b = newArray(10);
+    $noinline$shiftWithCall(a, b, 9);
+    expectEquals("call", new int[] { 1, 3, 6, 9, 12, 15, 18, 21, 24, 27 }, a);
+  }
+}
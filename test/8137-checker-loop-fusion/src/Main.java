@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+
+public class Main {
+
+  // Both loops run the same iterations and the second one only reads the element the first
+  // one wrote in the same iteration: they are fused.
+
+  /// CHECK-START-X86_64: long[] Main.$noinline$fuse(long) loop_fusion (before)
+  /// CHECK:                          ArraySet loop:<<Loop:B\d+>>
+  /// CHECK-NOT:                      ArraySet loop:<<Loop>>
+
+  /// CHECK-START-X86_64: long[] Main.$noinline$fuse(long) loop_fusion (after)
+  /// CHECK-DAG:                      ArraySet loop:<<Loop:B\d+>>
+  /// CHECK-DAG:                      ArraySet loop:<<Loop>>
+  /// CHECK-DAG:                      ArrayGet loop:<<Loop>>
+  private static long[] $noinline$fuse(long x) {
+    long[] a = new long[1024];
+    long[] b = new long[1024];
+    for (int i = 0; i < 1024; i++) {
+      a[i] = x * i;
+    }
+    for (int i = 0; i < 1024; i++) {
+      b[i] = a[i] * 3;
+    }
+    return b;
+  }
+
+  // The second loop reads the element the first one writes in the next iteration.
+
+  /// CHECK-START-X86_64: long[] Main.$noinline$fuseNext(long) loop_fusion (after)
+  /// CHECK:                          ArraySet loop:<<Loop:B\d+>>
+  /// CHECK-NOT:                      ArraySet loop:<<Loop>>
+  private static long[] $noinline$fuseNext(long x) {
+    long[] a = new long[1025];
+    long[] b = new long[1024];
+    for (int i = 0; i < 1024; i++) {
+      a[i] = x * i;
+    }
+    for (int i = 0; i < 1024; i++) {
+      b[i] = a[i + 1] * 3;
+    }
+    return b;
+  }
+
+  // The loops do not test the same bound.
+
+  /// CHECK-START-X86_64: long[] Main.$noinline$fuseShorter(long) loop_fusion (after)
+  /// CHECK:                          ArraySet loop:<<Loop:B\d+>>
+  /// CHECK-NOT:                      ArraySet loop:<<Loop>>
+  private static long[] $noinline$fuseShorter(long x) {
+    long[] a = new long[1024];
+    long[] b = new long[1024];
+    for (int i = 0; i < 1024; i++) {
+      a[i] = x * i;
+    }
+    for (int i = 0; i < 1000; i++) {
+      b[i] = a[i] * 3;
+    }
+    return b;
+  }
+
+  private static void expectEquals(String label, long[] expected, long[] result) {
+    if (!Arrays.equals(expected, result)) {
+      throw new Error(label + ": expected " + Arrays.toString(expected) +
+                      ", got " + Arrays.toString(result));
+    }
+    System.out.println(label + ": passed");
+  }
+
+  public static void main(String[] args) {
+    long x = 7;
+    long[] expected = new long[1024];
+    long[] expected_next = new long[1024];
+    long[] expected_shorter = new long[1024];
+    for (int i = 0; i < 1024; i++) {
+      expected[i] = x * i * 3;
+      // The last element reads the one the first loop did not write.
+      expected_next[i] = (i + 1 < 1024) ? x * (i + 1) * 3 : 0;
+      expected_shorter[i] = (i < 1000) ? x * i * 3 : 0;
+    }
+    expectEquals("fuse", expected, $noinline$fuse(x));
+    expectEquals("next element", expected_next, $noinline$fuseNext(x));
+    expectEquals("shorter", expected_shorter, $noinline$fuseShorter(x));
+  }
+}
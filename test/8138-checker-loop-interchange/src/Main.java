@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+
+public class Main {
+
+  // The inner loop walks a column. The nest is versioned on the rows being non-null and
+  // long enough, and the fast version is interchanged to walk the rows instead.
+
+  /// CHECK-START-X86_64: void Main.$noinline$addColumns(int[][], int) loop_interchange (before)
+  /// CHECK-DAG:     <<I:i\d+>>       Phi loop:<<Outer:B\d+>> outer_loop:none
+  /// CHECK-DAG:     <<J:i\d+>>       Phi loop:<<Inner:B\d+>> outer_loop:<<Outer>>
+  /// CHECK-DAG:     <<Check:i\d+>>   BoundsCheck [<<I>>,{{i\d+}}] loop:<<Inner>>
+  /// CHECK-DAG:                      ArraySet [{{l\d+}},<<Check>>,{{i\d+}}] loop:<<Inner>>
+
+  /// CHECK-START-X86_64: void Main.$noinline$addColumns(int[][], int) loop_interchange (after)
+  /// CHECK-DAG:     <<I:i\d+>>       Phi loop:<<Outer:B\d+>> outer_loop:none
+  /// CHECK-DAG:     <<J:i\d+>>       Phi loop:<<Inner:B\d+>> outer_loop:<<Outer>>
+  /// CHECK-DAG:                      ArraySet [{{l\d+}},<<J>>,{{i\d+}}] loop:<<Inner>>
+  /// CHECK-DAG:     <<Check:i\d+>>   BoundsCheck
+  /// CHECK-DAG:                      ArraySet [{{l\d+}},<<Check>>,{{i\d+}}]
+  private static void $noinline$addColumns(int[][] a, int x) {
+    for (int i = 0; i < 64; i++) {
+      for (int j = 0; j < 64; j++) {
+        a[j][i] += x * i + j;
+      }
+    }
+  }
+
+  // The inner loop already walks a row: the nest is left as is.
+
+  /// CHECK-START-X86_64: void Main.$noinline$addRows(int[][], int) loop_interchange (after)
+  /// CHECK:                          ArraySet
+  /// CHECK-NOT:                      ArraySet
+  private static void $noinline$addRows(int[][] a, int x) {
+    for (int i = 0; i < 64; i++) {
+      for (int j = 0; j < 64; j++) {
+        a[i][j] += x * j + i;
+      }
+    }
+  }
+
+  // The same nest as addColumns, not interchanged because of its unknown start.
+  private static void $noinline$addColumnsFrom(int[][] a, int x, int start) {
+    for (int i = start; i < 64; i++) {
+      for (int j = 0; j < 64; j++) {
+        a[j][i] += x * i + j;
+      }
+    }
+  }
+
+  private static int[][] newArray() {
+    int[][] a = new int[64][];
+    for (int i = 0; i < 64; i++) {
+      a[i] = new int[64];
+    }
+    return a;
+  }
+
+  private static void expectEquals(String label, int[][] expected, int[][] result) {
+    if (!Arrays.deepEquals(expected, result)) {
+      throw new Error(label + ": expected " + Arrays.deepToString(expected) +
+                      ", got " + Arrays.deepToString(result));
+    }
+    System.out.println(label + ": passed");
+  }
+
+  private static void run(String label, int[][] a, int[][] expected) {
+    Throwable thrown = null;
+    try {
+      $noinline$addColumns(a, 3);
+    } catch (ArrayIndexOutOfBoundsException | NullPointerException e) {
+      thrown = e;
+    }
+    Throwable expected_thrown = null;
+    try {
+      $noinline$addColumnsFrom(expected, 3, 0);
+    } catch (ArrayIndexOutOfBoundsException | NullPointerException e) {
+      expected_thrown = e;
+    }
+    if ((thrown == null) != (expected_thrown == null) ||
+        (thrown != null && thrown.getClass() != expected_thrown.getClass())) {
+      throw new Error(label + ": expected " + expected_thrown + ", got " + thrown);
+    }
+    // The elements updated before the exception are the same.
+    expectEquals(label, expected, a);
+  }
+
+  public static void main(String[] args) {
+    run("columns", newArray(), newArray());
+
+    // The rows check fails, the original nest throws after updating the first columns.
+    int[][] a = newArray();
+    int[][] expected = newArray();
+    a[40] = new int[10];
+    expected[40] = new int[10];
+    run("short row", a, expected);
+
+    a = newArray();
+    expected = newArray();
+    a[50] = null;
+    expected[50] = null;
+    run("null row", a, expected);
+
+    a = newArray();
+    $noinline$addRows(a, 3);
+    expected = newArray();
+    for (int i = 0; i < 64; i++) {
+      for (int j = 0; j < 64; j++) {
+        expected[i][j] = 3 * j + i;
+      }
+    }
+    expectEquals("rows", expected, a);
+  }
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+
+public class Main {
+
+  static int[] sArray;
+  static int sDivisor = 1;
+
+  // The loop only fills a fresh small array: its contents are stored before it and it is removed.
+
+  /// CHECK-START-X86_64: int[] Main.$noinline$squares() trivial_loop_evaluator (before)
+  /// CHECK:                          ArraySet loop:{{B\d+}}
+
+  /// CHECK-START-X86_64: int[] Main.$noinline$squares() trivial_loop_evaluator (after)
+  /// CHECK-DAG:      <<Last:i\d+>>   IntConstant 9802
+  /// CHECK-DAG:                      ArraySet [{{l\d+}},{{i\d+}},<<Last>>] loop:none
+
+  /// CHECK-START-X86_64: int[] Main.$noinline$squares() trivial_loop_evaluator (after)
+  /// CHECK-NOT:                      ArraySet loop:{{B\d+}}
+  private static int[] $noinline$squares() {
+    int[] a = new int[100];
+    for (int i = 0; i < 100; i++) {
+      a[i] = i * i + 1;
+    }
+    return a;
+  }
+
+  // The array is visible to others before the loop fills it.
+
+  /// CHECK-START-X86_64: int[] Main.$noinline$squaresPublished() trivial_loop_evaluator (after)
+  /// CHECK:                          ArraySet loop:{{B\d+}}
+  private static int[] $noinline$squaresPublished() {
+    int[] a = new int[100];
+    sArray = a;
+    for (int i = 0; i < 100; i++) {
+      a[i] = i * i + 1;
+    }
+    return a;
+  }
+
+  // The array is too large to be stored element by element.
+
+  /// CHECK-START-X86_64: int[] Main.$noinline$squaresLarge() trivial_loop_evaluator (after)
+  /// CHECK:                          ArraySet loop:{{B\d+}}
+  private static int[] $noinline$squaresLarge() {
+    int[] a = new int[2000];
+    for (int i = 0; i < 100; i++) {
+      a[i] = i * i + 1;
+    }
+    return a;
+  }
+
+  // The number of iterations is not known.
+
+  /// CHECK-START-X86_64: int[] Main.$noinline$squaresUpTo(int) trivial_loop_evaluator (after)
+  /// CHECK:                          ArraySet loop:{{B\d+}}
+  private static int[] $noinline$squaresUpTo(int n) {
+    int[] a = new int[100];
+    for (int i = 0; i < n; i++) {
+      a[i] = i * i + 1;
+    }
+    return a;
+  }
+
+  // The array is allocated outside the outer loop, so it is not zero-filled when the inner loop
+  // starts again.
+
+  /// CHECK-START-X86_64: int[] Main.$noinline$countOuter(int) trivial_loop_evaluator (after)
+  /// CHECK:                          ArraySet loop:{{B\d+}}
+  private static int[] $noinline$countOuter(int n) {
+    int[] a = new int[4];
+    for (int j = 0; j < n; j++) {
+      for (int i = 0; i < 4; i++) {
+        a[i] += 1;
+      }
+    }
+    return a;
+  }
+
+  // The loop is too long to be evaluated iteration by iteration, but both reductions have a
+  // closed form. The try block keeps the common loop optimization from folding them first.
+
+  /// CHECK-START-X86_64: int Main.$noinline$closedForm() trivial_loop_evaluator (before)
+  /// CHECK:                          Phi loop:{{B\d+}}
+
+  /// CHECK-START-X86_64: int Main.$noinline$closedForm() trivial_loop_evaluator (after)
+  /// CHECK-DAG:                      IntConstant 49975007
+  /// CHECK-DAG:                      IntConstant -62492500
+
+  /// CHECK-START-X86_64: int Main.$noinline$closedForm() trivial_loop_evaluator (after)
+  /// CHECK-NOT:                      Phi loop:{{B\d+}}
+  private static int $noinline$closedForm() {
+    int s = 7;
+    int t = 0;
+    for (int i = 0; i < 5000; i++) {
+      s += (i << 2) - 3;
+      t -= 5 * i + 1;
+    }
+    try {
+      return (s + t) / sDivisor;
+    } catch (ArithmeticException e) {
+      return -1;
+    }
+  }
+
+  private static int $noinline$closedFormUpTo(int n) {
+    int s = 7;
+    int t = 0;
+    for (int i = 0; i < n; i++) {
+      s += (i << 2) - 3;
+      t -= 5 * i + 1;
+    }
+    return s + t;
+  }
+
+  // The reduction is not affine in the IV.
+
+  /// CHECK-START-X86_64: int Main.$noinline$squareSum() trivial_loop_evaluator (after)
+  /// CHECK:                          Mul loop:{{B\d+}}
+  private static int $noinline$squareSum() {
+    int s = 0;
+    for (int i = 0; i < 5000; i++) {
+      s += i * i;
+    }
+    try {
+      return s / sDivisor;
+    } catch (ArithmeticException e) {
+      return -1;
+    }
+  }
+
+  private static int $noinline$squareSumUpTo(int n) {
+    int s = 0;
+    for (int i = 0; i < n; i++) {
+      s += i * i;
+    }
+    return s;
+  }
+
+  private static void expectEquals(String label, int[] expected, int[] result) {
+    if (!Arrays.equals(expected, result)) {
+      throw new Error(label + ": expected " + Arrays.toString(expected) +
+                      ", got " + Arrays.toString(result));
+    }
+    System.out.println(label + ": passed");
+  }
+
+  private static void expectEquals(String label, int expected, int result) {
+    if (expected != result) {
+      throw new Error(label + ": expected " + expected + ", got " + result);
+    }
+    System.out.println(label + ": passed");
+  }
+
+  public static void main(String[] args) {
+    int[] expected = new int[100];
+    int[] expected_large = new int[2000];
+    for (int i = 0; i < 100; i++) {
+      expected[i] = i * i + 1;
+      expected_large[i] = i * i + 1;
+    }
+    expectEquals("squares", expected, $noinline$squares());
+    expectEquals("published", expected, $noinline$squaresPublished());
+    if (sArray[99] != expected[99]) {
+      throw new Error("published: the array seen by others differs");
+    }
+    expectEquals("large array", expected_large, $noinline$squaresLarge());
+    expectEquals("unknown count", expected, $noinline$squaresUpTo(100));
+    expectEquals("outer allocation", new int[] { 5, 5, 5, 5 }, $noinline$countOuter(5));
+    expectEquals("closed form", $noinline$closedFormUpTo(5000), $noinline$closedForm());
+    expectEquals("square sum", $noinline$squareSumUpTo(5000), $noinline$squareSum());
+  }
+}
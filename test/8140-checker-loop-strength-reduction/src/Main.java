@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+
+public class Main {
+
+  // The product of the IV by the invariant becomes an IV of its own.
+
+  /// CHECK-START-X86_64: void Main.$noinline$scale(int[], int) loop_strength_reduction (before)
+  /// CHECK:                          Mul loop:{{B\d+}}
+
+  /// CHECK-START-X86_64: void Main.$noinline$scale(int[], int) loop_strength_reduction (after)
+  /// CHECK-NOT:                      Mul loop:{{B\d+}}
+  private static void $noinline$scale(int[] a, int x) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] = i * x;
+    }
+  }
+
+  // The loop count is odd, so that the loop is not unrolled. The test moves to the reduced IV
+  // against the scaled bound.
+
+  /// CHECK-START-X86_64: void Main.$noinline$stride(int[]) loop_strength_reduction (before)
+  /// CHECK:                          Mul loop:{{B\d+}}
+
+  /// CHECK-START-X86_64: void Main.$noinline$stride(int[]) loop_strength_reduction (after)
+  /// CHECK-DAG:      <<Bound:i\d+>>  IntConstant 606
+  /// CHECK-DAG:      <<Cond:z\d+>>   {{[A-Za-z]+}} [{{i\d+}},<<Bound>>] loop:<<Loop:B\d+>>
+  /// CHECK-DAG:                      If [<<Cond>>] loop:<<Loop>>
+
+  /// CHECK-START-X86_64: void Main.$noinline$stride(int[]) loop_strength_reduction (after)
+  /// CHECK-NOT:                      Mul loop:{{B\d+}}
+  private static void $noinline$stride(int[] a) {
+    for (int i = 0; i < 101; i++) {
+      a[i * 6] += 1;
+    }
+  }
+
+  // The scaled bound would overflow: the product is reduced but the test is kept.
+
+  /// CHECK-START-X86_64: void Main.$noinline$wrapping(int[]) loop_strength_reduction (after)
+  /// CHECK-DAG:      <<Bound:i\d+>>  IntConstant 101
+  /// CHECK-DAG:      <<Cond:z\d+>>   {{[A-Za-z]+}} [{{i\d+}},<<Bound>>] loop:<<Loop:B\d+>>
+  /// CHECK-DAG:                      If [<<Cond>>] loop:<<Loop>>
+
+  /// CHECK-START-X86_64: void Main.$noinline$wrapping(int[]) loop_strength_reduction (after)
+  /// CHECK-NOT:                      Mul loop:{{B\d+}}
+  private static void $noinline$wrapping(int[] a) {
+    for (int i = 0; i < 101; i++) {
+      a[(i * 100000000) & 1023] += 1;
+    }
+  }
+
+  // The IV is not multiplied by an invariant.
+
+  /// CHECK-START-X86_64: void Main.$noinline$squares(int[]) loop_strength_reduction (after)
+  /// CHECK:                          Mul loop:{{B\d+}}
+  private static void $noinline$squares(int[] a) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] = i * i;
+    }
+  }
+
+  private static void expectEquals(String label, int[] expected, int[] result) {
+    if (!Arrays.equals(expected, result)) {
+      throw new Error(label + ": expected " + Arrays.toString(expected) +
+                      ", got " + Arrays.toString(result));
+    }
+    System.out.println(label + ": passed");
+  }
+
+  public static void main(String[] args) {
+    // The expected values are built by additions only.
+    int[] expected_scale = new int[1000];
+    int[] expected_squares = new int[1000];
+    for (int i = 0, product = 0, square = 0; i < 1000; i++, product += 7, square += 2 * i - 1) {
+      expected_scale[i] = product;
+      expected_squares[i] = square;
+    }
+    int[] expected_stride = new int[606];
+    for (int k = 0; k < 606; k += 6) {
+      expected_stride[k] = 1;
+    }
+    int[] expected_wrapping = new int[1024];
+    long product = 0;
+    for (int i = 0; i < 101; i++, product += 100000000) {
+      expected_wrapping[(int) product & 1023] += 1;
+    }
+
+    int[] a = new int[1000];
+    $noinline$scale(a, 7);
+    expectEquals("scale", expected_scale, a);
+    a = new int[606];
+    $noinline$stride(a);
+    expectEquals("stride", expected_stride, a);
+    a = new int[1024];
+    $noinline$wrapping(a);
+    expectEquals("wrapping", expected_wrapping, a);
+    a = new int[1000];
+    $noinline$squares(a);
+    expectEquals("squares", expected_squares, a);
+  }
+}
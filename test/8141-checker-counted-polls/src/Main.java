@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+
+  // The number of iterations is not known: the suspend check stays, but the thread flags are
+  // only tested when the counter in the header reaches zero.
+
+  /// CHECK-START-X86_64: int Main.$noinline$hash(int) remove_loop_suspend_checks (before)
+  /// CHECK:                          SuspendCheck loop:{{B\d+}}
+
+  /// CHECK-START-X86_64: int Main.$noinline$hash(int) remove_loop_suspend_checks (after)
+  /// CHECK-DAG:      <<Counter:i\d+>> Phi loop:<<Loop:B\d+>>
+  /// CHECK-DAG:      <<Next:i\d+>>   Sub [<<Counter>>,{{i\d+}}] loop:<<Loop>>
+  /// CHECK-DAG:      <<Zero:z\d+>>   Equal [<<Next>>,{{i\d+}}] loop:<<Loop>>
+  /// CHECK-DAG:                      If [<<Zero>>] loop:<<Loop>>
+  /// CHECK-DAG:                      TestSuspend loop:<<Loop>>
+  /// CHECK-DAG:                      Suspend loop:<<Loop>>
+
+  /// CHECK-START-X86_64: int Main.$noinline$hash(int) remove_loop_suspend_checks (after)
+  /// CHECK-NOT:                      SuspendCheck loop:{{B\d+}}
+  private static int $noinline$hash(int n) {
+    int x = 0;
+    for (int i = 0; i < n; i++) {
+      x = x * 31 + i;
+    }
+    return x;
+  }
+
+  // The loop is short enough to run without suspend check.
+
+  /// CHECK-START-X86_64: int Main.$noinline$shortHash() remove_loop_suspend_checks (after)
+  /// CHECK-NOT:                      SuspendCheck loop:{{B\d+}}
+  /// CHECK-NOT:                      TestSuspend
+  private static int $noinline$shortHash() {
+    int x = 0;
+    for (int i = 0; i < 100; i++) {
+      x = x * 31 + i;
+    }
+    return x;
+  }
+
+  // The call is a suspend point: the loop keeps its suspend check.
+
+  /// CHECK-START-X86_64: int Main.$noinline$hashWithCall(int) remove_loop_suspend_checks (after)
+  /// CHECK:                          SuspendCheck loop:{{B\d+}}
+  /// CHECK-NOT:                      TestSuspend
+  private static int $noinline$hashWithCall(int n) {
+    int x = 0;
+    for (int i = 0; i < n; i++) {
+      x = x * 31 + $noinline$identity(i);
+    }
+    return x;
+  }
+
+  private static int $noinline$identity(int i) {
+    return i;
+  }
+
+  private static void expectEquals(String label, int expected, int result) {
+    if (expected != result) {
+      throw new Error(label + ": expected " + expected + ", got " + result);
+    }
+    System.out.println(label + ": passed");
+  }
+
+  public static void main(String[] args) {
+    // Enough iterations to reach the test of the flags many times, and some more.
+    int n = 100000 + 3;
+    expectEquals("counted", $noinline$hashWithCall(n), $noinline$hash(n));
+    expectEquals("removed", $noinline$hashWithCall(100), $noinline$shortHash());
+    expectEquals("call", 30849, $noinline$hashWithCall(5));
+  }
+}
@@ -18,6 +18,7 @@ package com.android.ahat;
 
 import com.android.ahat.heapdump.AhatSnapshot;
 import com.android.ahat.heapdump.Diff;
+import com.android.ahat.heapdump.HprofIndex;
 import com.android.tools.perflib.heap.ProguardMap;
 import com.sun.net.httpserver.HttpServer;
 import java.io.File;
@@ -26,6 +27,7 @@ import java.io.PrintStream;
 import java.net.InetAddress;
 import java.net.InetSocketAddress;
 import java.text.ParseException;
+import java.util.List;
 import java.util.concurrent.Executors;
 
 public class Main {
@@ -43,6 +45,9 @@ public class Main {
     out.println("     Diff the heap dump against the given baseline heap dump FILE.");
     out.println("  --baseline-proguard-map FILE");
     out.println("     Use the proguard map FILE to deobfuscate the baseline heap dump.");
+    out.println("  --histogram");
+    out.println("     Print the number and size of the instances of each class from the");
+    out.println("     index FILE.index written with the heap dump, without parsing FILE.");
     out.println("");
   }
 
@@ -59,6 +64,7 @@ public class Main {
     File hprofbase = null;
     ProguardMap map = new ProguardMap();
     ProguardMap mapbase = new ProguardMap();
+    boolean histogram = false;
     for (int i = 0; i < args.length; i++) {
       if ("-p".equals(args[i]) && i + 1 < args.length) {
         i++;
@@ -87,6 +93,8 @@ public class Main {
           return;
         }
         hprofbase = new File(args[i]);
+      } else if ("--histogram".equals(args[i])) {
+        histogram = true;
       } else {
         if (hprof != null) {
           System.err.println("multiple input files.");
@@ -103,6 +111,11 @@ public class Main {
       return;
     }
 
+    if (histogram) {
+      printHistogram(HprofIndex.open(HprofIndex.getIndexFile(hprof)), System.out);
+      return;
+    }
+
     // Launch the server before parsing the hprof file so we get
     // BindExceptions quickly.
     InetAddress loopback = InetAddress.getLoopbackAddress();
@@ -132,5 +145,13 @@ public class Main {
 
     server.start();
   }
+
+  private static void printHistogram(HprofIndex index, PrintStream out) {
+    List<HprofIndex.ClassStats> histogram = index.getClassHistogram();
+    out.println(String.format("%12s %14s  %s", "Count", "Size", "Class"));
+    for (HprofIndex.ClassStats stats : histogram) {
+      out.println(String.format("%12d %14d  %s", stats.count, stats.size, stats.name));
+    }
+  }
 }
 
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package com.android.ahat.heapdump;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.BufferUnderflowException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.channels.FileChannel;
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.Comparator;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * The index the runtime writes along a heap dump with -XX:+HprofIndex.
+ * The objects of the index are memory-mapped and looked up in place, so
+ * that the records of a heap dump too large to be loaded can be found
+ * without parsing the heap dump.
+ */
+public class HprofIndex {
+  private static final String MAGIC = "ART HPROF INDEX 1";
+
+  // Size of an object of the index: id, class id, offset and size.
+  private static final int OBJECT_SIZE = 20;
+
+  private final Map<Long, String> mClassNames = new HashMap<Long, String>();
+  private final ByteBuffer mObjects;
+  private final int mNumObjects;
+
+  /**
+   * The number and total shallow size of the instances of a class.
+   */
+  public static class ClassStats {
+    public final String name;
+    public long count;
+    public long size;
+
+    ClassStats(String name) {
+      this.name = name;
+    }
+  }
+
+  /**
+   * Returns the file of the index of the given heap dump.
+   */
+  public static File getIndexFile(File hprof) {
+    return new File(hprof.getPath() + ".index");
+  }
+
+  /**
+   * Memory-maps the given index file.
+   */
+  public static HprofIndex open(File index) throws IOException {
+    try (RandomAccessFile file = new RandomAccessFile(index, "r")) {
+      FileChannel channel = file.getChannel();
+      return new HprofIndex(channel.map(FileChannel.MapMode.READ_ONLY, 0, channel.size()));
+    }
+  }
+
+  /**
+   * Reads the index in the given buffer. The classes are read, the objects
+   * stay in the buffer.
+   */
+  public HprofIndex(ByteBuffer buffer) throws IOException {
+    try {
+      buffer.order(ByteOrder.BIG_ENDIAN);
+      byte[] magic = new byte[MAGIC.length() + 1];
+      buffer.get(magic);
+      if (magic[MAGIC.length()] != 0
+          || !MAGIC.equals(new String(magic, 0, MAGIC.length(), StandardCharsets.UTF_8))) {
+        throw new IOException("Not a heap dump index");
+      }
+      int numClasses = buffer.getInt();
+      mNumObjects = buffer.getInt();
+      for (int i = 0; i < numClasses; i++) {
+        long id = toUnsigned(buffer.getInt());
+        byte[] name = new byte[buffer.getInt()];
+        buffer.get(name);
+        mClassNames.put(id, new String(name, StandardCharsets.UTF_8));
+      }
+    } catch (BufferUnderflowException e) {
+      throw new IOException("Truncated heap dump index", e);
+    }
+    if (mNumObjects < 0 || buffer.remaining() < (long)mNumObjects * OBJECT_SIZE) {
+      throw new IOException("Truncated heap dump index");
+    }
+    mObjects = buffer.slice();
+  }
+
+  private static long toUnsigned(int value) {
+    return value & 0xFFFFFFFFL;
+  }
+
+  /**
+   * Returns the number of objects in the index.
+   */
+  public int getNumObjects() {
+    return mNumObjects;
+  }
+
+  /**
+   * Returns the id of the object at the given index, the objects are in
+   * increasing ids.
+   */
+  public long getObjectId(int index) {
+    return toUnsigned(mObjects.getInt(index * OBJECT_SIZE));
+  }
+
+  /**
+   * Returns the id of the class object of the object at the given index.
+   */
+  public long getClassId(int index) {
+    return toUnsigned(mObjects.getInt(index * OBJECT_SIZE + 4));
+  }
+
+  /**
+   * Returns the offset in the heap dump of the heap dump record of the
+   * object at the given index.
+   */
+  public long getOffset(int index) {
+    return mObjects.getLong(index * OBJECT_SIZE + 8);
+  }
+
+  /**
+   * Returns the shallow size of the object at the given index.
+   */
+  public long getSize(int index) {
+    return toUnsigned(mObjects.getInt(index * OBJECT_SIZE + 16));
+  }
+
+  /**
+   * Returns the index of the object with the given id.
+   * Returns -1 if no object with the given id is in the index.
+   */
+  public int findObject(long id) {
+    int start = 0;
+    int end = mNumObjects;
+    while (start < end) {
+      int mid = start + ((end - start) / 2);
+      long midId = getObjectId(mid);
+      if (id == midId) {
+        return mid;
+      } else if (id < midId) {
+        end = mid;
+      } else {
+        start = mid + 1;
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * Returns the name of the class with the given class object id.
+   * Returns null if no class with the given id is in the index.
+   */
+  public String getClassName(long classId) {
+    return mClassNames.get(classId);
+  }
+
+  /**
+   * Returns the number and shallow size of the instances of each class, in
+   * decreasing total shallow sizes.
+   */
+  public List<ClassStats> getClassHistogram() {
+    Map<Long, ClassStats> stats = new HashMap<Long, ClassStats>();
+    for (int i = 0; i < mNumObjects; i++) {
+      long classId = getClassId(i);
+      ClassStats classStats = stats.get(classId);
+      if (classStats == null) {
+        String name = getClassName(classId);
+        classStats = new ClassStats(name == null ? "<unknown class>" : name);
+        stats.put(classId, classStats);
+      }
+      classStats.count++;
+      classStats.size += getSize(i);
+    }
+    List<ClassStats> histogram = new ArrayList<ClassStats>(stats.values());
+    Collections.sort(histogram, new Comparator<ClassStats>() {
+      @Override
+      public int compare(ClassStats a, ClassStats b) {
+        return Long.compare(b.size, a.size);
+      }
+    });
+    return histogram;
+  }
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package com.android.ahat;
+
+import com.android.ahat.heapdump.HprofIndex;
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.util.List;
+import org.junit.Test;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNull;
+
+public class HprofIndexTest {
+  private static void putClass(ByteBuffer buffer, int id, String name) {
+    byte[] bytes = name.getBytes(StandardCharsets.UTF_8);
+    buffer.putInt(id);
+    buffer.putInt(bytes.length);
+    buffer.put(bytes);
+  }
+
+  private static void putObject(ByteBuffer buffer, int id, int classId, long offset, int size) {
+    buffer.putInt(id);
+    buffer.putInt(classId);
+    buffer.putLong(offset);
+    buffer.putInt(size);
+  }
+
+  private static HprofIndex getTestIndex() throws IOException {
+    ByteBuffer buffer = ByteBuffer.allocate(1024);
+    buffer.put("ART HPROF INDEX 1\0".getBytes(StandardCharsets.UTF_8));
+    buffer.putInt(2);
+    buffer.putInt(4);
+    putClass(buffer, 0x10, "java.lang.String");
+    putClass(buffer, 0x20, "char[]");
+    putObject(buffer, 0x100, 0x10, 40, 24);
+    putObject(buffer, 0x200, 0x20, 80, 64);
+    putObject(buffer, 0x300, 0x10, 160, 24);
+    putObject(buffer, 0xF00000A0, 0x20, 200, 16);
+    buffer.flip();
+    return new HprofIndex(buffer);
+  }
+
+  @Test
+  public void objects() throws IOException {
+    HprofIndex index = getTestIndex();
+    assertEquals(4, index.getNumObjects());
+    assertEquals(0x200, index.getObjectId(1));
+    assertEquals(0x20, index.getClassId(1));
+    assertEquals(80, index.getOffset(1));
+    assertEquals(64, index.getSize(1));
+    assertEquals("java.lang.String", index.getClassName(0x10));
+    assertNull(index.getClassName(0x30));
+
+    // Ids are unsigned.
+    assertEquals(0xF00000A0L, index.getObjectId(3));
+  }
+
+  @Test
+  public void findObject() throws IOException {
+    HprofIndex index = getTestIndex();
+    assertEquals(0, index.findObject(0x100));
+    assertEquals(2, index.findObject(0x300));
+    assertEquals(3, index.findObject(0xF00000A0L));
+    assertEquals(-1, index.findObject(0x250));
+    assertEquals(-1, index.findObject(0x50));
+  }
+
+  @Test
+  public void histogram() throws IOException {
+    List<HprofIndex.ClassStats> histogram = getTestIndex().getClassHistogram();
+    assertEquals(2, histogram.size());
+    assertEquals("char[]", histogram.get(0).name);
+    assertEquals(2, histogram.get(0).count);
+    assertEquals(80, histogram.get(0).size);
+    assertEquals("java.lang.String", histogram.get(1).name);
+    assertEquals(48, histogram.get(1).size);
+  }
+
+  @Test(expected = IOException.class)
+  public void badMagic() throws IOException {
+    ByteBuffer buffer = ByteBuffer.allocate(64);
+    buffer.put("NOT AN INDEX".getBytes(StandardCharsets.UTF_8));
+    buffer.flip();
+    new HprofIndex(buffer);
+  }
+}
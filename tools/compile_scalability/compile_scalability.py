@@ -0,0 +1,203 @@
+#!/usr/bin/env python3.4
+#
+# Copyright (C) 2018 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Measures how the compile time of the optimizing passes scales with the method size.
+
+See README.md.
+
+Example usage:
+./compile_scalability.py --sizes 100,200,400,600 --max-exponent 1.5
+"""
+
+import argparse
+import math
+import os
+import re
+import sys
+
+sys.path.append(os.path.dirname(os.path.dirname(
+        os.path.realpath(__file__))))
+
+from common.common import FatalError
+from common.common import GetEnvVariableOrError
+from common.common import HostTestEnv
+from common.common import LogSeverity
+from common.common import RetCode
+
+# A line of the pass telemetry dumped by dex2oat --dump-passes.
+PASS_LINE_RE = re.compile(
+    r'^\s+(?P<name>[^\s:]+): \d+ \d+ [\d.]+% (?P<time>[\d.]+)(?P<unit>s|ms|us|ns) ')
+# The peak arena memory of a method, dumped by dex2oat --dump-stats.
+ARENA_PEAK_RE = re.compile(r'ArenaKBytesPeak: (?P<kbytes>\d+)')
+UNIT_NS = {'s': 1e9, 'ms': 1e6, 'us': 1e3, 'ns': 1.0}
+
+
+def GenerateSource(size, depth):
+  """Returns the source of a class with a method of size blocks.
+
+  Each block is a loop nest of the given depth reading and writing arrays, so that the
+  instructions, blocks, loops and live ranges of the method all grow with size.
+
+  Args:
+    size: int, number of loop nests of the method.
+    depth: int, depth of each loop nest.
+
+  Returns:
+    string, the source of class Test.
+  """
+  lines = ['public class Test {',
+           '  static int huge(int[] a, int[] b, int n) {',
+           '    int s0 = 0, s1 = 1, s2 = 2, s3 = 3;']
+  for block in range(size):
+    indent = '    '
+    for level in range(depth):
+      lines.append('{0}for (int i{1}_{2} = 0; i{1}_{2} < n; i{1}_{2}++) {{'.format(
+          indent, block, level))
+      indent += '  '
+    i = 'i{0}_{1}'.format(block, depth - 1)
+    lines.append('{0}s{1} += a[{2}] * {3} + b[({2} + s{4}) & 15];'.format(
+        indent, block % 4, i, block + 2, (block + 1) % 4))
+    lines.append('{0}a[{1}] = s{2} ^ {3};'.format(indent, i, (block + 2) % 4, block))
+    for level in range(depth):
+      indent = indent[:-2]
+      lines.append(indent + '}')
+  lines += ['    return s0 + s1 + s2 + s3;',
+            '  }',
+            '}']
+  return '\n'.join(lines) + '\n'
+
+
+def ParseDuration(time, unit):
+  return float(time) * UNIT_NS[unit]
+
+
+def CompileAndMeasure(env, dex2oat, size, depth, extra_args):
+  """Compiles a method of the given size and returns its pass times and arena peak.
+
+  Args:
+    env: HostTestEnv, the environment to compile in.
+    dex2oat: string, the dex2oat binary.
+    size: int, number of loop nests of the method.
+    depth: int, depth of each loop nest.
+    extra_args: list of strings, additional dex2oat arguments.
+
+  Returns:
+    tuple of a dictionary of pass names to ns and the arena peak in KB.
+
+  Raises:
+    FatalError: if the method fails to compile.
+  """
+  source = env.CreateFile('Test.java')
+  with open(source, 'w') as f:
+    f.write(GenerateSource(size, depth))
+  directory = os.path.dirname(source)
+  dex = os.path.join(directory, 'classes.dex')
+  for cmd in (['javac', '-d', directory, source],
+              ['dx', '--dex', '--output=' + dex, os.path.join(directory, 'Test.class')]):
+    (output, retcode) = env.RunCommand(cmd)
+    if retcode != RetCode.SUCCESS:
+      raise FatalError('{0} failed:\n{1}'.format(cmd[0], output))
+  android_host_out = GetEnvVariableOrError('ANDROID_HOST_OUT')
+  cmd = [dex2oat,
+         '--dex-file=' + dex,
+         '--oat-file=' + os.path.join(directory, 'classes.oat'),
+         '--boot-image=' + os.path.join(android_host_out, 'framework', 'core.art'),
+         '--compiler-filter=speed',
+         '--huge-method-max=1000000',
+         '--large-method-max=1000000',
+         '--dump-passes',
+         '--dump-stats',
+         '-j1'] + extra_args
+  (output, retcode) = env.RunCommand(cmd, LogSeverity.INFO)
+  if retcode != RetCode.SUCCESS:
+    raise FatalError('dex2oat failed:\n' + output)
+  times = {}
+  arena_peak_kb = 0
+  for line in output.splitlines():
+    # Drop the log prefix before the message.
+    message = line.split('] ', 1)[-1]
+    match = PASS_LINE_RE.match(message)
+    if match:
+      times[match.group('name')] = ParseDuration(match.group('time'), match.group('unit'))
+      continue
+    match = ARENA_PEAK_RE.search(message)
+    if match:
+      arena_peak_kb = int(match.group('kbytes'))
+  if not times:
+    raise FatalError('No pass timings in the dex2oat output, is the telemetry enabled?')
+  return (times, arena_peak_kb)
+
+
+def ScalingExponent(small_size, small_ns, large_size, large_ns):
+  """Returns k such that the time grows as size^k between the two points."""
+  if small_ns <= 0 or large_ns <= 0:
+    return 0.0
+  return math.log(large_ns / small_ns) / math.log(large_size / small_size)
+
+
+def ParseArgs():
+  parser = argparse.ArgumentParser(
+      description='Measure how the compile time of each pass scales with the method size.')
+  parser.add_argument('--sizes', default='100,200,400,600',
+                      help='comma-separated number of loop nests of the generated methods')
+  parser.add_argument('--depth', type=int, default=3, help='depth of the loop nests')
+  parser.add_argument('--max-exponent', type=float, default=1.5,
+                      help='fail if the time of a pass grows faster than size^max-exponent')
+  parser.add_argument('--min-time-ms', type=float, default=5.0,
+                      help='ignore the passes faster than this at the largest size')
+  parser.add_argument('--dex2oat', default='dex2oatd',
+                      help='dex2oat binary, a debug build also reports the arena peak')
+  parser.add_argument('--dex2oat-args', default='',
+                      help='additional space-separated dex2oat arguments')
+  parser.add_argument('--x64', action='store_true', help='compile for x86-64')
+  return parser.parse_args()
+
+
+def main():
+  args = ParseArgs()
+  sizes = sorted(int(size) for size in args.sizes.split(','))
+  if len(sizes) < 2:
+    raise FatalError('At least two sizes are needed to measure the scaling.')
+  env = HostTestEnv('compile_scalability_', x64=args.x64)
+  extra_args = args.dex2oat_args.split()
+  results = []
+  for size in sizes:
+    (times, arena_peak_kb) = CompileAndMeasure(env, args.dex2oat, size, args.depth, extra_args)
+    print('size {0}: total {1:.1f}ms, arena peak {2}KB'.format(
+        size, sum(times.values()) / 1e6, arena_peak_kb))
+    results.append((size, times))
+
+  (small_size, small_times) = results[0]
+  (large_size, large_times) = results[-1]
+  regressions = []
+  print('{0:>40} {1:>12} {2:>12} {3:>9}'.format(
+      'pass', 'small ms', 'large ms', 'exponent'))
+  for name in sorted(large_times, key=large_times.get, reverse=True):
+    exponent = ScalingExponent(small_size, small_times.get(name, 0.0),
+                               large_size, large_times[name])
+    print('{0:>40} {1:>12.2f} {2:>12.2f} {3:>9.2f}'.format(
+        name, small_times.get(name, 0.0) / 1e6, large_times[name] / 1e6, exponent))
+    if large_times[name] >= args.min_time_ms * 1e6 and exponent > args.max_exponent:
+      regressions.append(name)
+  if regressions:
+    print('Passes scaling worse than size^{0}: {1}'.format(
+        args.max_exponent, ', '.join(regressions)))
+    return 1
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
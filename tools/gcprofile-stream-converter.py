@@ -0,0 +1,171 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2018 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Script that converts the files the GcProfiler writes in streaming mode
+   (-XX:GcProfStream) to the .csv file it dumps otherwise. The files of a process,
+   alloc_free_log_<pid>_<index>.gcps, are given in the order of their index."""
+
+from __future__ import print_function
+
+import struct
+import sys
+
+FILE_MAGIC = 0x53504347
+FILE_VERSION = 1
+
+RECORD_TYPE_GC = 0
+RECORD_TYPE_SUCC = 1
+RECORD_TYPE_FAIL = 2
+RECORD_TYPE_LARGE = 3
+RECORD_TYPE_ALLOC = 4
+RECORD_TYPE_ALLOC_SITE = 5
+
+MB = 1024 * 1024
+
+HEADERS = {
+  RECORD_TYPE_GC:
+    "GC Message, ID, Timestamp, reason, max pausetime, mark time, sweep time, "
+    "GC duration, number objects freed, freed bytes, number large obj freed, "
+    "large obj freed bytes, max wait time, GC type, max allowed footprint, "
+    "concurrent start bytes, blocking time, allocated size before gc, "
+    "allocated size after gc, alloc stack size after gc, GC throughput, "
+    "GC throughput, footprint before gc, footprint after gc, main space size before gc, "
+    "main space size after gc, los space size before gc, los space size after gc",
+  RECORD_TYPE_SUCC:
+    "Succeeded Allocation Messages,GC_Id, total_size, [1-16], [17-32],"
+    " [33-64], [65-128], [129-256], [257-512], [513-1024], [1025-2048], [2049-4096],"
+    " [4097-8192], [8193-12288], [12288-]",
+  RECORD_TYPE_FAIL: "Failed Allocation Messages, GC_Id, size, phase, last_gc_type, type",
+  RECORD_TYPE_LARGE: "Large Object Messages, GC_Id, size, type",
+  RECORD_TYPE_ALLOC:
+    "Allocation Info, duration(ms), total_bytes_allocated, "
+    "total_objects_allocated, Alloc_ThroughPut, Alloc_ThroughPut",
+  RECORD_TYPE_ALLOC_SITE: "Allocation Sites, method, dex_pc, type, samples, estimated_bytes",
+}
+
+class MyException(Exception):
+  pass
+
+class Decoder(object):
+  """Reads the fields of a record, in the byte order of the device."""
+
+  def __init__(self, data):
+    self.data = data
+    self.offset = 0
+
+  def Get(self, fmt):
+    value = struct.unpack_from("<" + fmt, self.data, self.offset)[0]
+    self.offset += struct.calcsize(fmt)
+    return value
+
+  def GetString(self):
+    length = self.Get("H")
+    value = self.data[self.offset:self.offset + length].decode("utf-8", "replace")
+    self.offset += length
+    return value
+
+def Ms(ns):
+  return ns // 1000 // 1000
+
+def Mb(size):
+  return size // MB
+
+def Throughput(per_ns):
+  return "%g" % (per_ns * 1000 * 1000)
+
+def ConvertGc(d):
+  fields = [d.Get("I"), Ms(d.Get("Q")), d.GetString(), Ms(d.Get("Q")), Ms(d.Get("Q")),
+            Ms(d.Get("Q")), Ms(d.Get("Q")), d.Get("I"), Mb(d.Get("I")), d.Get("I"),
+            Mb(d.Get("I")), Ms(d.Get("Q")), d.GetString(), Mb(d.Get("I")), Mb(d.Get("I")),
+            Ms(d.Get("Q")), Mb(d.Get("I")), Mb(d.Get("I")), d.Get("I"),
+            Throughput(d.Get("d")), Throughput(d.Get("d"))]
+  fields += [Mb(d.Get("I")) for i in range(6)]
+  return "".join("," + str(field) for field in fields)
+
+def ConvertSucc(d):
+  fields = [d.Get("I"), Mb(d.Get("I"))] + [d.Get("I") for i in range(12)]
+  return "".join(" ," + str(field) for field in fields)
+
+def ConvertFail(d):
+  fields = [d.Get("I"), Mb(d.Get("I")), d.GetString(), d.GetString(), d.GetString()]
+  return "".join(", " + str(field) for field in fields)
+
+def ConvertLarge(d):
+  fields = [d.Get("I"), Mb(d.Get("I")), d.GetString()]
+  return "".join(" ," + str(field) for field in fields)
+
+def ConvertAlloc(d):
+  duration = d.Get("Q")
+  # Rounded as AllocInfoRecord::ConvertDataUnits() does.
+  size = Mb(d.Get("I"))
+  size = (size + MB - 1) // MB * MB
+  fields = [duration, size, d.Get("I"), Throughput(d.Get("d")), Throughput(d.Get("d"))]
+  return "".join(", " + str(field) for field in fields)
+
+def ConvertAllocSite(d):
+  fields = [d.GetString(), d.Get("I"), d.GetString(), d.Get("I"), Mb(d.Get("Q"))]
+  return "".join(", " + str(field) for field in fields)
+
+CONVERTERS = {
+  RECORD_TYPE_GC: ConvertGc,
+  RECORD_TYPE_SUCC: ConvertSucc,
+  RECORD_TYPE_FAIL: ConvertFail,
+  RECORD_TYPE_LARGE: ConvertLarge,
+  RECORD_TYPE_ALLOC: ConvertAlloc,
+  RECORD_TYPE_ALLOC_SITE: ConvertAllocSite,
+}
+
+def ReadFile(filename, lines):
+  with open(filename, "rb") as f:
+    data = f.read()
+  if len(data) < 8:
+    raise MyException("%s: missing header" % filename)
+  magic, version, header_size = struct.unpack_from("<IHH", data, 0)
+  if magic != FILE_MAGIC:
+    raise MyException("%s: not a GcProfiler stream file" % filename)
+  if version != FILE_VERSION:
+    raise MyException("%s: unsupported version %d" % (filename, version))
+  offset = header_size
+  while offset + 4 <= len(data):
+    record_type, _, size = struct.unpack_from("<BBH", data, offset)
+    offset += 4
+    if offset + size > len(data):
+      # The process was killed while the record was written.
+      print("%s: truncated record at %d" % (filename, offset), file=sys.stderr)
+      break
+    if record_type in CONVERTERS:
+      lines[record_type].append(CONVERTERS[record_type](Decoder(data[offset:offset + size])))
+    else:
+      print("%s: unknown record type %d" % (filename, record_type), file=sys.stderr)
+    offset += size
+
+def main():
+  if len(sys.argv) < 3:
+    print("Usage: %s output.csv input.gcps..." % sys.argv[0], file=sys.stderr)
+    sys.exit(1)
+  lines = dict((record_type, []) for record_type in CONVERTERS)
+  for filename in sys.argv[2:]:
+    ReadFile(filename, lines)
+  with open(sys.argv[1], "w") as out:
+    out.write("GcProfile Data, Unit: Time(milliseconds) Size (mega-bytes) Throughput "
+              "(bytes/milliseconds ; count/milliseconds)\n")
+    for record_type in sorted(CONVERTERS):
+      out.write(HEADERS[record_type] + "\n")
+      for line in lines[record_type]:
+        out.write(line + "\n")
+
+if __name__ == '__main__':
+  main()